@@ -650,12 +650,34 @@ static bool TF_Run_Inputs(TF_Tensor* const* c_inputs,
   return true;
 }
 
+// Copies "src" into "dst" and returns true if they have the same dtype and
+// shape, and their dtype is stored the same way in TF_Tensor and Tensor.
+static bool CopyToPreallocatedTensor(const Tensor& src, TF_Tensor* dst) {
+  if (!src.IsInitialized() ||
+      static_cast<TF_DataType>(src.dtype()) != dst->dtype ||
+      src.dtype() == tensorflow::DT_STRING ||
+      src.dtype() == tensorflow::DT_RESOURCE ||
+      !tensorflow::DataTypeCanUseMemcpy(src.dtype()) ||
+      src.shape() != dst->shape) {
+    return false;
+  }
+  const tensorflow::StringPiece data = src.tensor_data();
+  if (data.size() != TF_TensorByteSize(dst)) return false;
+  // The output may be the preallocated tensor itself, e.g. when it is fed.
+  if (data.size() > 0 && data.data() != TF_TensorData(dst)) {
+    std::memcpy(TF_TensorData(dst), data.data(), data.size());
+  }
+  return true;
+}
+
 static void TF_Run_Helper(
     Session* session, const char* handle, const TF_Buffer* run_options,
     // Input tensors
     const std::vector<std::pair<string, Tensor>>& input_pairs,
     // Output tensors
     const std::vector<string>& output_tensor_names, TF_Tensor** c_outputs,
+    // The tensors to write the outputs into, or nullptr
+    TF_Tensor* const* preallocated_outputs,
     // Target nodes
     const std::vector<string>& target_oper_names, TF_Buffer* run_metadata,
     TF_Status* status) {
@@ -697,6 +719,12 @@ static void TF_Run_Helper(
   // Store results in c_outputs[]
   for (int i = 0; i < noutputs; ++i) {
     const Tensor& src = outputs[i];
+    if (preallocated_outputs != nullptr &&
+        preallocated_outputs[i] != nullptr &&
+        CopyToPreallocatedTensor(src, preallocated_outputs[i])) {
+      c_outputs[i] = preallocated_outputs[i];
+      continue;
+    }
     if (!src.IsInitialized() || src.NumElements() == 0) {
       c_outputs[i] =
           EmptyTensor(static_cast<TF_DataType>(src.dtype()), src.shape());
@@ -732,7 +760,7 @@ void TF_Run(TF_DeprecatedSession* s, const TF_Buffer* run_options,
     target_oper_names[i] = c_target_oper_names[i];
   }
   TF_Run_Helper(s->session, nullptr, run_options, input_pairs, output_names,
-                c_outputs, target_oper_names, run_metadata, status);
+                c_outputs, nullptr, target_oper_names, run_metadata, status);
 }
 
 void TF_PRunSetup(TF_DeprecatedSession* s,
@@ -791,7 +819,7 @@ void TF_PRun(TF_DeprecatedSession* s, const char* handle,
     target_oper_names[i] = c_target_oper_names[i];
   }
   TF_Run_Helper(s->session, handle, nullptr, input_pairs, output_names,
-                c_outputs, target_oper_names, nullptr, status);
+                c_outputs, nullptr, target_oper_names, nullptr, status);
 }
 
 TF_Library* TF_LoadLibrary(const char* library_filename, TF_Status* status) {
@@ -2458,12 +2486,13 @@ static bool ExtendSessionGraphHelper(TF_Session* session, TF_Status* status) {
   return true;
 }
 
-void TF_SessionRun(TF_Session* session, const TF_Buffer* run_options,
-                   const TF_Output* inputs, TF_Tensor* const* input_values,
-                   int ninputs, const TF_Output* outputs,
-                   TF_Tensor** output_values, int noutputs,
-                   const TF_Operation* const* target_opers, int ntargets,
-                   TF_Buffer* run_metadata, TF_Status* status) {
+static void TF_SessionRun_Helper(
+    TF_Session* session, const TF_Buffer* run_options,
+    const TF_Output* inputs, TF_Tensor* const* input_values, int ninputs,
+    const TF_Output* outputs, TF_Tensor** output_values,
+    TF_Tensor* const* preallocated_outputs, int noutputs,
+    const TF_Operation* const* target_opers, int ntargets,
+    TF_Buffer* run_metadata, TF_Status* status) {
   // TODO(josh11b,mrry): Change Session to be able to use a Graph*
   // directly, instead of requiring us to serialize to a GraphDef and
   // call Session::Extend().
@@ -2494,8 +2523,34 @@ void TF_SessionRun(TF_Session* session, const TF_Buffer* run_options,
 
   // Actually run.
   TF_Run_Helper(session->session, nullptr, run_options, input_pairs,
-                output_names, output_values, target_names, run_metadata,
-                status);
+                output_names, output_values, preallocated_outputs,
+                target_names, run_metadata, status);
+}
+
+void TF_SessionRun(TF_Session* session, const TF_Buffer* run_options,
+                   const TF_Output* inputs, TF_Tensor* const* input_values,
+                   int ninputs, const TF_Output* outputs,
+                   TF_Tensor** output_values, int noutputs,
+                   const TF_Operation* const* target_opers, int ntargets,
+                   TF_Buffer* run_metadata, TF_Status* status) {
+  TF_SessionRun_Helper(session, run_options, inputs, input_values, ninputs,
+                       outputs, output_values, nullptr, noutputs, target_opers,
+                       ntargets, run_metadata, status);
+}
+
+void TF_SessionRunWithPreallocatedOutputs(
+    TF_Session* session, const TF_Buffer* run_options, const TF_Output* inputs,
+    TF_Tensor* const* input_values, int ninputs, const TF_Output* outputs,
+    TF_Tensor** output_values, int noutputs,
+    const TF_Operation* const* target_opers, int ntargets,
+    TF_Buffer* run_metadata, TF_Status* status) {
+  const std::vector<TF_Tensor*> preallocated_outputs(
+      output_values, output_values + noutputs);
+  TF_SessionRun_Helper(session, run_options, inputs, input_values, ninputs,
+                       outputs, output_values, preallocated_outputs.data(),
+                       noutputs, target_opers, ntargets, run_metadata, status);  if (!status->status.ok()) {
+    std::fill(output_values, output_values + noutputs, nullptr);
+  }
 }
 
 void TF_SessionPRunSetup(TF_Session* session, const TF_Output* inputs,
@@ -2573,7 +2628,7 @@ void TF_SessionPRun(TF_Session* session, const char* handle,
   }
 
   TF_Run_Helper(session->session, handle, nullptr, input_pairs, output_names,
-                output_values, target_names, nullptr, status);
+                output_values, nullptr, target_names, nullptr, status);
 }
 
 }  // end extern "C"
@@ -226,6 +226,12 @@ typedef struct TF_Tensor TF_Tensor;
 //      (*deallocator)(data, len, deallocator_arg)
 // Clients must provide a custom deallocator function so they can pass in
 // memory managed by something like numpy.
+//
+// Except for TF_STRING and TF_RESOURCE tensors, the data is not copied if it
+// is aligned as TensorFlow requires (as is the memory of TF_AllocateTensor):
+// the tensor, and the inputs of the sessions that are fed it, use the data in
+// place, and the deallocator is called once none of them does.  Otherwise the
+// data is copied into an aligned buffer and deallocated right away.
 TF_CAPI_EXPORT extern TF_Tensor* TF_NewTensor(
     TF_DataType, const int64_t* dims, int num_dims, void* data, size_t len,
     void (*deallocator)(void* data, size_t len, void* arg),
@@ -1313,6 +1319,9 @@ TF_CAPI_EXPORT extern void TF_DeleteSession(TF_Session*, TF_Status* status);
 // to the caller, which must eventually call TF_DeleteTensor on them.
 //
 // On failure, output_values[] contains NULLs.
+//
+// The output tensors other than the TF_STRING and TF_RESOURCE ones share the
+// buffers of the session's outputs, without copying them.
 TF_CAPI_EXPORT extern void TF_SessionRun(
     TF_Session* session,
     // RunOptions
@@ -1328,6 +1337,33 @@ TF_CAPI_EXPORT extern void TF_SessionRun(
     // Output status
     TF_Status*);
 
+// Like TF_SessionRun, but output_values[] may hold tensors allocated by the
+// caller (or NULLs), so that the outputs are written into their buffers
+// rather than into new tensors.
+//
+// On success, output_values[i] is unchanged if it was a tensor of the dtype
+// and the shape of outputs[i], other than a TF_STRING or TF_RESOURCE one, and
+// it then holds the value of outputs[i].  Otherwise output_values[i] is set
+// to a new tensor, as by TF_SessionRun.  The caller retains ownership of the
+// tensors it passed in, and takes ownership of the new ones.
+//
+// On failure, output_values[] contains NULLs, and the tensors passed in are
+// still owned by the caller.
+TF_CAPI_EXPORT extern void TF_SessionRunWithPreallocatedOutputs(
+    TF_Session* session,
+    // RunOptions
+    const TF_Buffer* run_options,
+    // Input tensors
+    const TF_Output* inputs, TF_Tensor* const* input_values, int ninputs,
+    // Output tensors
+    const TF_Output* outputs, TF_Tensor** output_values, int noutputs,
+    // Target operations
+    const TF_Operation* const* target_opers, int ntargets,
+    // RunMetadata
+    TF_Buffer* run_metadata,
+    // Output status
+    TF_Status*);
+
 // Set up the graph with the intended feeds (inputs) and fetches (outputs) for a
 // sequence of partial run calls.
 //
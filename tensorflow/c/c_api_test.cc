@@ -869,6 +869,65 @@ TEST(CAPI, Session) {
   TF_DeleteStatus(s);
 }
 
+TEST(CAPI, SessionRunWithPreallocatedOutputs) {
+  TF_Status* s = TF_NewStatus();
+  TF_Graph* graph = TF_NewGraph();
+
+  TF_Operation* feed = Placeholder(graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* two = ScalarConst(2, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* add = Add(feed, two, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  TF_SessionOptions* opts = TF_NewSessionOptions();
+  TF_Session* session = TF_NewSession(graph, opts, s);
+  TF_DeleteSessionOptions(opts);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  TF_Output input = {feed, 0};
+  TF_Output output = {add, 0};
+
+  // A preallocated tensor of the right dtype and shape is filled in place.
+  TF_Tensor* input_value = Int32Tensor(3);
+  TF_Tensor* preallocated = TF_AllocateTensor(TF_INT32, nullptr, 0,
+                                              sizeof(int32));
+  TF_Tensor* output_value = preallocated;
+  TF_SessionRunWithPreallocatedOutputs(session, nullptr, &input, &input_value,
+                                       1, &output, &output_value, 1, nullptr,
+                                       0, nullptr, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  EXPECT_EQ(preallocated, output_value);
+  EXPECT_EQ(3 + 2, *static_cast<int32*>(TF_TensorData(output_value)));
+  TF_DeleteTensor(input_value);
+
+  // A tensor with a different shape is left alone and a new one returned.
+  const int64_t dims[] = {2};
+  TF_Tensor* mismatched =
+      TF_AllocateTensor(TF_INT32, dims, 1, 2 * sizeof(int32));
+  input_value = Int32Tensor(7);
+  output_value = mismatched;
+  TF_SessionRunWithPreallocatedOutputs(session, nullptr, &input, &input_value,
+                                       1, &output, &output_value, 1, nullptr,
+                                       0, nullptr, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  ASSERT_TRUE(output_value != nullptr);
+  EXPECT_NE(mismatched, output_value);
+  EXPECT_EQ(0, TF_NumDims(output_value));
+  EXPECT_EQ(7 + 2, *static_cast<int32*>(TF_TensorData(output_value)));
+  TF_DeleteTensor(input_value);
+  TF_DeleteTensor(output_value);
+  TF_DeleteTensor(mismatched);
+  TF_DeleteTensor(preallocated);
+
+  TF_CloseSession(session, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteSession(session, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteGraph(graph);
+  TF_DeleteStatus(s);
+}
+
 TEST(CAPI, SessionPRun) {
   TF_Status* s = TF_NewStatus();
   TF_Graph* graph = TF_NewGraph();
@@ -97,7 +97,10 @@ TFE_Context* TFE_NewContext(const TFE_ContextOptions* opts, TF_Status* status) {
 
 void TFE_DeleteContext(TFE_Context* ctx, TF_Status* status) {
   status->status = tensorflow::Status::OK();
-  tensorflow::gtl::STLDeleteValues(&ctx->kernel_cache);
+  {
+    tensorflow::mutex_lock ml(ctx->cache_mu);
+    tensorflow::gtl::STLDeleteValues(&ctx->kernel_cache);
+  }
   TF_Graph* graph = ctx->session->graph;
   TF_DeleteSession(ctx->session, status);
   TF_DeleteGraph(graph);
@@ -271,7 +274,11 @@ void TFE_OpAddInput(TFE_Op* op, TFE_TensorHandle* h, TF_Status* status) {
   if (!status->status.ok()) return;
   op->inputs.push_back(h->t);
   op->input_devices.push_back(h->d);
-  op->attrs.NumInputs(op->inputs.size());
+}
+
+void TFE_OpClearInputs(TFE_Op* op) {
+  op->inputs.clear();
+  op->input_devices.clear();
 }
 
 TF_AttrType TFE_OpGetAttrType(TFE_Op* op, const char* attr_name,
@@ -303,7 +310,7 @@ TF_AttrType TFE_OpNameGetAttrType(TFE_Context* ctx,
 }
 
 void TFE_OpSetAttrString(TFE_Op* op, const char* attr_name, const char* value) {
-  op->attrs.Set(attr_name, value);
+  op->attrs.Set(attr_name, tensorflow::StringPiece(value));
 }
 
 void TFE_OpSetAttrInt(TFE_Op* op, const char* attr_name, int64_t value) {
@@ -311,7 +318,7 @@ void TFE_OpSetAttrInt(TFE_Op* op, const char* attr_name, int64_t value) {
 }
 
 void TFE_OpSetAttrFloat(TFE_Op* op, const char* attr_name, float value) {
-  op->attrs.Set(attr_name, value);
+  op->attrs.Set(attr_name, static_cast<float>(value));
 }
 
 void TFE_OpSetAttrBool(TFE_Op* op, const char* attr_name, unsigned char value) {
@@ -504,9 +511,18 @@ void TFE_Execute(TFE_Op* op, TFE_TensorHandle** retvals, int* num_retvals,
       (op->device == nullptr) ? ctx->devices()[0] : op->device;
   std::vector<tensorflow::Tensor> outputs(1);
   const tensorflow::MemoryTypeVector* output_memory_types = nullptr;
+  // The number of inputs is part of the kernel's identity, so it is fixed by
+  // the first successful execution. Re-executions with a different number of
+  // inputs are rejected by ValidateInputTypeAndPlacement.
+  if (op->kernel == nullptr) op->attrs.NumInputs(op->inputs.size());
   tensorflow::Fprint128 cache_key = op->attrs.CacheKey(device->name());
-  tensorflow::KernelAndDevice* kernel =
-      tensorflow::gtl::FindPtrOrNull(ctx->kernel_cache, cache_key);
+  tensorflow::KernelAndDevice* kernel = nullptr;
+  if (op->kernel != nullptr && op->kernel_cache_key == cache_key) {
+    kernel = op->kernel;
+  } else {
+    tensorflow::mutex_lock ml(ctx->cache_mu);
+    kernel = tensorflow::gtl::FindPtrOrNull(ctx->kernel_cache, cache_key);
+  }
   if (kernel == nullptr) {
     const tensorflow::NodeDef& ndef = op->attrs.BuildNodeDef();
     kernel = new tensorflow::KernelAndDevice(ctx->rendezvous);
@@ -522,8 +538,20 @@ void TFE_Execute(TFE_Op* op, TFE_TensorHandle** retvals, int* num_retvals,
       delete kernel;
       return;
     }
-    tensorflow::gtl::InsertOrUpdate(&(ctx->kernel_cache), cache_key, kernel);
+    tensorflow::mutex_lock ml(ctx->cache_mu);
+    // Another thread may have instantiated the same kernel concurrently; keep
+    // the one already in the cache since other ops may be using it.
+    tensorflow::KernelAndDevice* existing =
+        tensorflow::gtl::FindPtrOrNull(ctx->kernel_cache, cache_key);
+    if (existing != nullptr) {
+      delete kernel;
+      kernel = existing;
+    } else {
+      ctx->kernel_cache[cache_key] = kernel;
+    }
   }
+  op->kernel = kernel;
+  op->kernel_cache_key = cache_key;
   std::vector<TFE_TensorHandle*> copied_tensors;
   status->status = ValidateInputTypeAndPlacement(
       ctx, ctx->devices()[0], device, op, kernel->kernel(), &copied_tensors);
@@ -137,6 +137,13 @@ TF_CAPI_EXPORT extern void TFE_OpSetDevice(TFE_Op* op, const char* device_name,
 
 TF_CAPI_EXPORT extern void TFE_OpAddInput(TFE_Op* op, TFE_TensorHandle* h, TF_Status* status);
 
+// Removes all inputs added to 'op' so that it can be executed again with new
+// inputs. The attributes and the kernel instantiated by a previous TFE_Execute
+// are retained, so an op can be prepared once and executed many times, as
+// long as the same number of inputs is added before each TFE_Execute.
+// Attributes must not be changed after the first TFE_Execute.
+TF_CAPI_EXPORT extern void TFE_OpClearInputs(TFE_Op* op);
+
 TF_CAPI_EXPORT extern TF_AttrType TFE_OpGetAttrType(TFE_Op* op, const char* attr_name,
                                                     unsigned char* is_list, TF_Status* status);
 // Get an attribute type given an op name; a fusion of TFE_NewOp and
@@ -58,9 +58,10 @@ struct TFE_Context {
   // session->devices[i].
   std::unique_ptr<tensorflow::ProcessFunctionLibraryRuntime> pflr;
 
+  tensorflow::mutex cache_mu;
   std::unordered_map<tensorflow::Fprint128, tensorflow::KernelAndDevice*,
                      tensorflow::Fprint128Hasher>
-      kernel_cache;
+      kernel_cache GUARDED_BY(cache_mu);
 
   tensorflow::FunctionLibraryRuntime* func_lib(tensorflow::Device* d) {
     return pflr->GetFLR(d->name());
@@ -87,7 +88,12 @@ struct TFE_TensorHandle {
 
 struct TFE_Op {
   TFE_Op(TFE_Context* ctx, const char* op, const tensorflow::AttrTypeMap* t)
-      : ctx(ctx), name(op), attrs(op), attr_types(t), device(nullptr) {}
+      : ctx(ctx),
+        name(op),
+        attrs(op),
+        attr_types(t),
+        device(nullptr),
+        kernel(nullptr) {}
 
   bool const is_function() const { return attr_types == nullptr; }
 
@@ -98,6 +104,12 @@ struct TFE_Op {
   std::vector<tensorflow::Tensor> inputs;
   std::vector<tensorflow::Device*> input_devices;
   tensorflow::Device* device;
+
+  // The kernel used by the last successful TFE_Execute and the cache key it
+  // was looked up with, so that re-executing a prepared op skips the lookup
+  // in ctx->kernel_cache (which owns the kernel).
+  tensorflow::KernelAndDevice* kernel;
+  tensorflow::Fprint128 kernel_cache_key;
 };
 
 #endif  // TENSORFLOW_C_EAGER_C_API_INTERNAL_H_
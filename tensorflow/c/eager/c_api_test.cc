@@ -295,6 +295,61 @@ TEST(CAPI, Execute) {
   TF_DeleteStatus(status);
 }
 
+TEST(CAPI, ExecutePreparedOpRepeatedly) {
+  TF_Status* status = TF_NewStatus();
+  TFE_ContextOptions* opts = TFE_NewContextOptions();
+  TFE_Context* ctx = TFE_NewContext(opts, status);
+  CHECK_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_DeleteContextOptions(opts);
+
+  TFE_TensorHandle* m = TestMatrixTensorHandle();
+  TFE_Op* matmul = MatMulOp(ctx, m, m);
+  TFE_TensorHandle* product = nullptr;
+  int num_retvals = 1;
+  TFE_Execute(matmul, &product, &num_retvals, status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+
+  // Re-execute the same op, reusing its kernel, with new inputs.
+  TFE_OpClearInputs(matmul);
+  TFE_OpAddInput(matmul, product, status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_OpAddInput(matmul, m, status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_TensorHandle* retval = nullptr;
+  num_retvals = 1;
+  TFE_Execute(matmul, &retval, &num_retvals, status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  ASSERT_EQ(1, num_retvals);
+
+  // A prepared op must be fed the same number of inputs.
+  TFE_OpClearInputs(matmul);
+  TFE_OpAddInput(matmul, m, status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TFE_TensorHandle* unused = nullptr;
+  num_retvals = 1;
+  TFE_Execute(matmul, &unused, &num_retvals, status);
+  EXPECT_EQ(TF_INVALID_ARGUMENT, TF_GetCode(status)) << TF_Message(status);
+
+  TFE_DeleteOp(matmul);
+  TFE_DeleteTensorHandle(product);
+  TFE_DeleteTensorHandle(m);
+
+  TF_Tensor* t = TFE_TensorHandleResolve(retval, status);
+  TFE_DeleteTensorHandle(retval);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  float result[4] = {0};
+  EXPECT_EQ(sizeof(result), TF_TensorByteSize(t));
+  memcpy(&result[0], TF_TensorData(t), TF_TensorByteSize(t));
+  TF_DeleteTensor(t);
+  EXPECT_EQ(37, result[0]);
+  EXPECT_EQ(54, result[1]);
+  EXPECT_EQ(81, result[2]);
+  EXPECT_EQ(118, result[3]);
+  TFE_DeleteContext(ctx, status);
+  ASSERT_EQ(TF_OK, TF_GetCode(status)) << TF_Message(status);
+  TF_DeleteStatus(status);
+}
+
 string MatMulFunction() {
   tensorflow::FunctionDef def;
   CHECK(tensorflow::protobuf::TextFormat::ParseFromString(
@@ -106,21 +106,34 @@ Status AttrTypeByName(const AttrTypeMap* m, const string& attr_name,
 #define DEFINE_SET_ATTR(value_type, value_field)                             \
   template <>                                                                \
   AttrBuilder& AttrBuilder::Set(StringPiece attr_name, value_type&& value) { \
-    value_field.push_back(std::make_pair(attr_name, value));                 \
+    DCHECK(!node_def_finalized_) << "Calling Set after BuildNodeDef.";      \
+    value_field.emplace_back(attr_name.ToString(), value);                   \
+    cached_cache_key_valid_ = false;                                         \
     return *this;                                                            \
   }
 
-DEFINE_SET_ATTR(StringPiece, string_attrs_);
 DEFINE_SET_ATTR(float, float_attrs_);
-DEFINE_SET_ATTR(int, int_attrs_);
+DEFINE_SET_ATTR(int64, int_attrs_);
 DEFINE_SET_ATTR(bool, bool_attrs_);
 DEFINE_SET_ATTR(tensorflow::DataType, type_attrs_);
 
 #undef DEFINE_SET_ATTR
 
+// The value is copied, since callers (such as TFE_OpSetAttrString) need not
+// keep it alive until BuildNodeDef.
+template <>
+AttrBuilder& AttrBuilder::Set(StringPiece attr_name, StringPiece&& value) {
+  DCHECK(!node_def_finalized_) << "Calling Set after BuildNodeDef.";
+  string_attrs_.emplace_back(attr_name.ToString(), value.ToString());
+  cached_cache_key_valid_ = false;
+  return *this;
+}
+
 AttrBuilder& AttrBuilder::NumInputs(int n) {
+  if (n == num_inputs_) return *this;
   DCHECK(!node_def_finalized_) << "Calling NumInputs after BuildNodeDef.";
   num_inputs_ = n;
+  cached_cache_key_valid_ = false;
   return *this;
 }
 
@@ -164,7 +177,7 @@ namespace {
 inline tensorflow::Fprint128 FingerprintCat128(const tensorflow::Fprint128& a,
                                                const tensorflow::Fprint128& b) {
   return {tensorflow::FingerprintCat64(a.low64, b.low64),
-          tensorflow::FingerprintCat64(a.low64, b.low64)};
+          tensorflow::FingerprintCat64(a.high64, b.high64)};
 }
 
 void CombineUnordered(const tensorflow::Fprint128& a,
@@ -187,6 +200,15 @@ inline tensorflow::Fprint128 CacheKeyHelper(const StringPiece& s, uint64 b) {
 }  // namespace
 
 tensorflow::Fprint128 AttrBuilder::CacheKey(const string& device) const {
+  if (!cached_cache_key_valid_ || device != device_for_cached_cache_key_) {
+    cached_cache_key_ = BuildCacheKey(device);
+    device_for_cached_cache_key_ = device;
+    cached_cache_key_valid_ = true;
+  }
+  return cached_cache_key_;
+}
+
+tensorflow::Fprint128 AttrBuilder::BuildCacheKey(const string& device) const {
   tensorflow::Fprint128 f = tensorflow::Fingerprint128(op_name_);
   f = tensorflow::FingerprintCat128(f, tensorflow::Fingerprint128(device));
   if (node_def_ != nullptr) {
@@ -204,10 +226,8 @@ tensorflow::Fprint128 AttrBuilder::CacheKey(const string& device) const {
     if (node_def_finalized_) return f;
   }
   for (const auto& p : string_attrs_) {
-    // TODO(agarwal): avoid ToString().
-    CombineUnordered(CacheKeyHelper(p.first, tensorflow::Fingerprint128(
-                                                 p.second.ToString())),
-                     &f);
+    CombineUnordered(
+        CacheKeyHelper(p.first, tensorflow::Fingerprint128(p.second)), &f);
   }
   for (const auto& p : int_attrs_) {
     CombineUnordered(CacheKeyHelper(p.first, static_cast<uint64>(p.second)),
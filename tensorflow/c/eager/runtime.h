@@ -68,7 +68,9 @@ Status AttrTypeByName(const AttrTypeMap* m, const string& attr_name,
 //
 // Note that all calls to Set and NumInputs should happen before calling
 // BuildNodeDef. Also, calls to NumInputs or Set between multiple invocations
-// to CacheKey may cause different values to be returned by CacheKey.
+// to CacheKey may cause different values to be returned by CacheKey. The key
+// is memoized, so repeated calls to CacheKey with the same device and no
+// intervening mutations are cheap.
 //
 // For performance reasons, the class internally delays the actual construction
 // of the NodeDef till BuildNodeDef is called, or Set is called with certain
@@ -80,7 +82,8 @@ class AttrBuilder {
       : op_name_(op),
         num_inputs_(0),
         node_def_(nullptr),
-        node_def_finalized_(false) {}
+        node_def_finalized_(false),
+        cached_cache_key_valid_(false) {}
 
   // Needed to work around call to ValidateNodeDef in CreateOpKernel.
   AttrBuilder& NumInputs(int n);
@@ -89,6 +92,7 @@ class AttrBuilder {
   AttrBuilder& Set(StringPiece attr_name, T&& value) {
     MayBeInitializeNodeDef();
     SetInAttrValueMap(node_def_->mutable_attr(), attr_name, value);
+    cached_cache_key_valid_ = false;
     return *this;
   }
 
@@ -99,9 +103,10 @@ class AttrBuilder {
 
  private:
   template <class T>
-  using AttrVec = tensorflow::gtl::InlinedVector<std::pair<StringPiece, T>, 2>;
+  using AttrVec = tensorflow::gtl::InlinedVector<std::pair<string, T>, 2>;
 
   void MayBeInitializeNodeDef();
+  tensorflow::Fprint128 BuildCacheKey(const string& device) const;
   void FillAttrValueMap(AttrValueMap* m, bool include_those_in_node_def) const;
 
   template <class T>
@@ -123,8 +128,8 @@ class AttrBuilder {
     }
   }
 
-  AttrVec<StringPiece> string_attrs_;
-  AttrVec<int> int_attrs_;
+  AttrVec<string> string_attrs_;
+  AttrVec<int64> int_attrs_;
   AttrVec<float> float_attrs_;
   AttrVec<bool> bool_attrs_;
   AttrVec<tensorflow::DataType> type_attrs_;
@@ -132,12 +137,17 @@ class AttrBuilder {
   int num_inputs_;
   std::unique_ptr<NodeDef> node_def_;
   bool node_def_finalized_;
+
+  // Memoized result of the last call to CacheKey.
+  mutable tensorflow::Fprint128 cached_cache_key_;
+  mutable string device_for_cached_cache_key_;
+  mutable bool cached_cache_key_valid_;
 };  // namespace tensorflow
 
 template <>
 AttrBuilder& AttrBuilder::Set(StringPiece attr_name, StringPiece&& value);
 template <>
-AttrBuilder& AttrBuilder::Set(StringPiece attr_name, int&& value);
+AttrBuilder& AttrBuilder::Set(StringPiece attr_name, int64&& value);
 template <>
 AttrBuilder& AttrBuilder::Set(StringPiece attr_name, float&& value);
 template <>
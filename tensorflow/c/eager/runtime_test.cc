@@ -79,6 +79,36 @@ TEST(AttrTypeMap, Lookup) {
   EXPECT_NE(is_list, 0);
 }
 
+TEST(AttrBuilder, CacheKey) {
+  AttrBuilder a("MatMul");
+  a.Set("T", DT_FLOAT).Set("transpose_a", false).NumInputs(2);
+  const Fprint128 cpu_key = a.CacheKey("cpu:0");
+  EXPECT_EQ(cpu_key, a.CacheKey("cpu:0"));
+  EXPECT_FALSE(cpu_key == a.CacheKey("gpu:0"));
+  EXPECT_EQ(cpu_key, a.CacheKey("cpu:0"));
+
+  // Mutations invalidate the memoized key.
+  a.Set("transpose_b", true);
+  const Fprint128 transposed_key = a.CacheKey("cpu:0");
+  EXPECT_FALSE(cpu_key == transposed_key);
+  EXPECT_EQ(transposed_key, a.CacheKey("cpu:0"));
+
+  // Attributes that arrive on different paths hash the same way.
+  AttrBuilder b("MatMul");
+  b.NumInputs(2).Set("transpose_a", false).Set("T", DT_FLOAT);
+  EXPECT_EQ(cpu_key, b.CacheKey("cpu:0"));
+}
+
+TEST(AttrBuilder, StringAttrIsCopied) {
+  string value = "foo";
+  AttrBuilder a("Fake");
+  a.Set("s", StringPiece(value));
+  value = "bar";
+  AttrValueMap m;
+  a.FillAttrValueMap(&m);
+  EXPECT_EQ("foo", m["s"].s());
+}
+
 TEST(KernelAndDevice, Run) {
   Tensor t(Input({{1.0f, 2.0f}, {3.0f, 4.0f}}).tensor());
   std::vector<Tensor> inputs;
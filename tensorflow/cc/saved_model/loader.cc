@@ -16,9 +16,12 @@ limitations under the License.
 #include "tensorflow/cc/saved_model/loader.h"
 
 #include <unordered_set>
+#include <vector>
 
 #include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
@@ -89,6 +92,43 @@ Status FindMetaGraphDefToLoad(const SavedModel& saved_model_proto,
                     "use the SavedModel CLI: `saved_model_cli`");
 }
 
+// Sets the attributes of the RestoreV2 ops of the saver whose restore op is
+// "restore_op_name" as asked by "load_options": whether they return tensors
+// backed by the memory-mapped variables file, which of them have all their
+// pages read, and how many variables they read at once.
+void ConfigureRestoreOps(const StringPiece restore_op_name,
+                         const LoadSavedModelOptions& load_options,
+                         GraphDef* graph_def) {
+  if (!load_options.memory_map_variables &&
+      load_options.max_parallel_restore_reads == 0) {
+    return;
+  }
+  StringPiece scope = restore_op_name;
+  const size_t slash = scope.rfind('/');
+  scope = slash == StringPiece::npos ? StringPiece()
+                                     : scope.substr(0, slash + 1);
+  for (NodeDef& node : *graph_def->mutable_node()) {
+    if (node.op() != "RestoreV2" ||
+        !StringPiece(node.name()).starts_with(scope)) {
+      continue;
+    }
+    if (load_options.max_parallel_restore_reads > 0) {
+      (*node.mutable_attr())["max_parallel_reads"].set_i(
+          load_options.max_parallel_restore_reads);
+    }
+    if (load_options.memory_map_variables) {
+      (*node.mutable_attr())["memory_map"].set_b(true);
+      if (!load_options.warm_up_variables.empty()) {
+        AttrValue::ListValue* warm_up =
+            (*node.mutable_attr())["warm_up_tensors"].mutable_list();
+        for (const string& name : load_options.warm_up_variables) {
+          warm_up->add_s(name);
+        }
+      }
+    }
+  }
+}
+
 Status LoadMetaGraphIntoSession(const MetaGraphDef& meta_graph_def,
                                 const SessionOptions& session_options,
                                 std::unique_ptr<Session>* session) {
@@ -207,6 +247,75 @@ Status RunLegacyInitOp(const RunOptions& run_options, const string& export_dir,
   return Status::OK();
 }
 
+// Runs the warm-up requests of the SavedModel in "export_dir", if it has any,
+// through the signatures of "meta_graph_def".
+Status RunWarmupRequests(const RunOptions& run_options,
+                         const string& export_dir,
+                         const MetaGraphDef& meta_graph_def,
+                         Session* session) {
+  const string warmup_path =
+      io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory,
+                   kSavedModelWarmupRequestsFilename);
+  if (!Env::Default()->FileExists(warmup_path).ok()) {
+    return Status::OK();
+  }
+  LOG(INFO) << "Running the warm-up requests of SavedModel bundle.";
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(Env::Default()->NewRandomAccessFile(warmup_path, &file));
+  io::RecordReader reader(file.get());
+  uint64 offset = 0;
+  string record;
+  int num_requests = 0;
+  while (true) {
+    const Status s = reader.ReadRecord(&offset, &record);
+    if (errors::IsOutOfRange(s)) break;
+    TF_RETURN_IF_ERROR(s);
+    SavedModelWarmupRequest request;
+    if (!request.ParseFromString(record)) {
+      return errors::DataLoss("Could not parse warm-up request ",
+                              num_requests, " in ", warmup_path);
+    }
+    const auto signature_it =
+        meta_graph_def.signature_def().find(request.signature_name());
+    if (signature_it == meta_graph_def.signature_def().end()) {
+      return errors::InvalidArgument("Warm-up request ", num_requests,
+                                     " in ", warmup_path,
+                                     " has an unknown signature: ",
+                                     request.signature_name());
+    }
+    const SignatureDef& signature = signature_it->second;
+    std::vector<std::pair<string, Tensor>> inputs;
+    for (const auto& key_and_value : request.inputs()) {
+      const auto input_it = signature.inputs().find(key_and_value.first);
+      if (input_it == signature.inputs().end()) {
+        return errors::InvalidArgument(
+            "Warm-up request ", num_requests, " in ", warmup_path,
+            " has an unknown input of signature ", request.signature_name(),
+            ": ", key_and_value.first);
+      }
+      Tensor value;
+      if (!value.FromProto(key_and_value.second)) {
+        return errors::InvalidArgument("Warm-up request ", num_requests,
+                                       " in ", warmup_path,
+                                       " has an invalid value of input ",
+                                       key_and_value.first);
+      }
+      inputs.emplace_back(input_it->second.name(), value);
+    }
+    std::vector<string> output_names;
+    for (const auto& key_and_info : signature.outputs()) {
+      output_names.push_back(key_and_info.second.name());
+    }
+    std::vector<Tensor> outputs;
+    RunMetadata run_metadata;
+    TF_RETURN_IF_ERROR(session->Run(run_options, inputs, output_names, {},
+                                    &outputs, &run_metadata));
+    ++num_requests;
+  }
+  LOG(INFO) << "Ran " << num_requests << " warm-up requests.";
+  return Status::OK();
+}
+
 Status GetAssetFileDefs(const MetaGraphDef& meta_graph_def,
                         std::vector<AssetFileDef>* asset_file_defs) {
   const auto& collection_def_map = meta_graph_def.collection_def();
@@ -228,6 +337,7 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                               const RunOptions& run_options,
                               const string& export_dir,
                               const std::unordered_set<string>& tags,
+                              const LoadSavedModelOptions& load_options,
                               SavedModelBundle* const bundle) {
   if (!MaybeSavedModelDirectory(export_dir)) {
     return Status(error::Code::NOT_FOUND,
@@ -241,6 +351,9 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
   TF_RETURN_IF_ERROR(
       FindMetaGraphDefToLoad(saved_model_proto, tags, &bundle->meta_graph_def));
 
+  ConfigureRestoreOps(bundle->meta_graph_def.saver_def().restore_op_name(),
+                      load_options, bundle->meta_graph_def.mutable_graph_def());
+
   TF_RETURN_IF_ERROR(LoadMetaGraphIntoSession(
       bundle->meta_graph_def, session_options, &bundle->session));
 
@@ -261,6 +374,11 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                                        bundle->meta_graph_def, asset_file_defs,
                                        bundle->session.get()));
   }
+  if (load_options.run_warmup_requests) {
+    TF_RETURN_IF_ERROR(RunWarmupRequests(run_options, export_dir,
+                                         bundle->meta_graph_def,
+                                         bundle->session.get()));
+  }
   return Status::OK();
 }
 
@@ -270,10 +388,20 @@ Status LoadSavedModel(const SessionOptions& session_options,
                       const RunOptions& run_options, const string& export_dir,
                       const std::unordered_set<string>& tags,
                       SavedModelBundle* const bundle) {
+  return LoadSavedModel(session_options, run_options, export_dir, tags,
+                        LoadSavedModelOptions(), bundle);
+}
+
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options, const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      const LoadSavedModelOptions& load_options,
+                      SavedModelBundle* const bundle) {
   // TODO(robson): Add tests for the counters.
   const uint64 start_microseconds = Env::Default()->NowMicros();
-  const Status status = LoadSavedModelInternal(session_options, run_options,
-                                               export_dir, tags, bundle);
+  const Status status =
+      LoadSavedModelInternal(session_options, run_options, export_dir, tags,
+                             load_options, bundle);
   const uint64 load_latency_microsecs = [&]() -> uint64 {
     const uint64 end_microseconds = Env::Default()->NowMicros();
     // Avoid clock skew.
@@ -20,6 +20,7 @@ limitations under the License.
 
 #include <string>
 #include <unordered_set>
+#include <vector>
 
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
@@ -43,6 +44,32 @@ struct SavedModelBundle {
   SavedModelBundle() = default;
 };
 
+/// Options for loading a SavedModel.
+struct LoadSavedModelOptions {
+  /// If true, variables whose data is suitably aligned in the variables file
+  /// (see RewriteBundle() in tensor_bundle.h) are not read, but point straight
+  /// at the pages of the memory-mapped file.  Loading then takes little time,
+  /// and all sessions that load the model share one physical copy of these
+  /// variables through the page cache.  Such variables are read-only.
+  bool memory_map_variables = false;
+
+  /// With memory_map_variables, the names in the checkpoint of the variables
+  /// whose pages are all read while loading, e.g. the hot embeddings.  The
+  /// other variables are read from the file system when first accessed.
+  std::vector<string> warm_up_variables;
+
+  /// The maximum number of variables that are read at once while restoring
+  /// them, each range of them with its own reader of the variables file.  If
+  /// 0, as many as the data files of the variables.
+  int max_parallel_restore_reads = 0;
+
+  /// If true, the recorded requests of the SavedModel (see
+  /// SavedModelWarmupRequest in saved_model.proto) are run through their
+  /// signatures before the loading returns, so that the sessions are warm
+  /// when they serve their first requests.
+  bool run_warmup_requests = false;
+};
+
 /// Loads a SavedModel from the specified export directory. The meta graph def
 /// to be loaded is identified by the supplied tags, corresponding exactly to
 /// the set of tags used at SavedModel build time. Returns a SavedModel bundle
@@ -52,6 +79,13 @@ Status LoadSavedModel(const SessionOptions& session_options,
                       const std::unordered_set<string>& tags,
                       SavedModelBundle* const bundle);
 
+/// Like the above, with the options of `load_options`.
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options, const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      const LoadSavedModelOptions& load_options,
+                      SavedModelBundle* const bundle);
+
 /// Checks whether the provided directory could contain a SavedModel. Note that
 /// the method does not load any data by itself. If the method returns `false`,
 /// the export directory definitely does not contain a SavedModel. If the method
@@ -24,7 +24,10 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/saved_model.pb.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace {
@@ -179,6 +182,136 @@ TEST_F(LoaderTest, MainOpFormat) {
   CheckSavedModelBundle(export_dir, bundle);
 }
 
+TEST_F(LoaderTest, MemoryMapVariables) {
+  SessionOptions session_options;
+  RunOptions run_options;
+  LoadSavedModelOptions load_options;
+  load_options.memory_map_variables = true;
+
+  // Unaligned variables are read as usual.
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  {
+    SavedModelBundle bundle;
+    TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                                {kSavedModelTagServe}, load_options, &bundle));
+    CheckSavedModelBundle(export_dir, bundle);
+  }
+
+  // A copy of the model whose variables can be mapped.
+  Env* env = Env::Default();
+  const string aligned_dir =
+      io::JoinPath(testing::TmpDir(), "half_plus_two_aligned");
+  TF_ASSERT_OK(env->RecursivelyCreateDir(
+      io::JoinPath(aligned_dir, kSavedModelAssetsDirectory)));
+  for (const string& file :
+       {string(kSavedModelFilenamePb),
+        io::JoinPath(kSavedModelAssetsDirectory, "foo.txt")}) {
+    string contents;
+    TF_ASSERT_OK(
+        ReadFileToString(env, io::JoinPath(export_dir, file), &contents));
+    TF_ASSERT_OK(
+        WriteStringToFile(env, io::JoinPath(aligned_dir, file), contents));
+  }
+  BundleWriter::Options options;
+  options.data_alignment = 4096;
+  TF_ASSERT_OK(RewriteBundle(
+      env,
+      io::JoinPath(export_dir, kSavedModelVariablesDirectory,
+                   kSavedModelVariablesFilename),
+      io::JoinPath(aligned_dir, kSavedModelVariablesDirectory,
+                   kSavedModelVariablesFilename),
+      options));
+
+  {
+    SavedModelBundle bundle;
+    TF_ASSERT_OK(LoadSavedModel(session_options, run_options, aligned_dir,
+                                {kSavedModelTagServe}, load_options, &bundle));
+    CheckSavedModelBundle(aligned_dir, bundle);
+  }
+
+  // Reads the pages of one variable while loading.
+  load_options.warm_up_variables = {"a"};
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(LoadSavedModel(session_options, run_options, aligned_dir,
+                              {kSavedModelTagServe}, load_options, &bundle));
+  CheckSavedModelBundle(aligned_dir, bundle);
+}
+
+// Writes "requests" as the warm-up requests of the SavedModel in "export_dir".
+Status WriteWarmupRequests(
+    const string& export_dir,
+    const std::vector<SavedModelWarmupRequest>& requests) {
+  Env* env = Env::Default();
+  const string directory =
+      io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory);
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(directory));
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(
+      io::JoinPath(directory, kSavedModelWarmupRequestsFilename), &file));
+  io::RecordWriter writer(file.get());
+  for (const SavedModelWarmupRequest& request : requests) {
+    TF_RETURN_IF_ERROR(writer.WriteRecord(request.SerializeAsString()));
+  }
+  return file->Close();
+}
+
+TEST_F(LoaderTest, ParallelRestoreAndWarmupRequests) {
+  SessionOptions session_options;
+  RunOptions run_options;
+  LoadSavedModelOptions load_options;
+  load_options.max_parallel_restore_reads = 2;
+  load_options.run_warmup_requests = true;
+
+  // A copy of the model with warm-up requests.
+  Env* env = Env::Default();
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  const string warmup_dir =
+      io::JoinPath(testing::TmpDir(), "half_plus_two_warmup");
+  for (const char* directory :
+       {kSavedModelAssetsDirectory, kSavedModelVariablesDirectory}) {
+    TF_ASSERT_OK(
+        env->RecursivelyCreateDir(io::JoinPath(warmup_dir, directory)));
+  }
+  for (const string& file :
+       {string(kSavedModelFilenamePb),
+        io::JoinPath(kSavedModelAssetsDirectory, "foo.txt"),
+        io::JoinPath(kSavedModelVariablesDirectory, "variables.index"),
+        io::JoinPath(kSavedModelVariablesDirectory,
+                     "variables.data-00000-of-00001")}) {
+    string contents;
+    TF_ASSERT_OK(
+        ReadFileToString(env, io::JoinPath(export_dir, file), &contents));
+    TF_ASSERT_OK(
+        WriteStringToFile(env, io::JoinPath(warmup_dir, file), contents));
+  }
+  SavedModelWarmupRequest request;
+  request.set_signature_name("regress_x_to_y");
+  test::AsTensor<string>({MakeSerializedExample(1)}, TensorShape({1}))
+      .AsProtoTensorContent(&(*request.mutable_inputs())[kRegressInputs]);
+  TF_ASSERT_OK(WriteWarmupRequests(warmup_dir, {request, request}));
+  {
+    SavedModelBundle bundle;
+    TF_ASSERT_OK(LoadSavedModel(session_options, run_options, warmup_dir,
+                                {kSavedModelTagServe}, load_options, &bundle));
+    CheckSavedModelBundle(warmup_dir, bundle);
+  }
+
+  // A request for a signature that the MetaGraph does not have fails the
+  // loading.
+  SavedModelWarmupRequest unknown_signature = request;
+  unknown_signature.set_signature_name("unknown");
+  TF_ASSERT_OK(WriteWarmupRequests(warmup_dir, {request, unknown_signature}));
+  SavedModelBundle bundle;
+  const Status st =
+      LoadSavedModel(session_options, run_options, warmup_dir,
+                     {kSavedModelTagServe}, load_options, &bundle);
+  EXPECT_EQ(error::INVALID_ARGUMENT, st.code());
+  EXPECT_TRUE(StringPiece(st.error_message()).contains("unknown signature"))
+      << st.error_message();
+}
+
 TEST_F(LoaderTest, InvalidExportPath) {
   SavedModelBundle bundle;
   RunOptions run_options;
@@ -435,6 +435,11 @@ extern "C" void {{ENTRY}}(
 // buffers, and outputs written to result buffers. Each Run call may also use
 // a set of temporary buffers for the computation.
 //
+// If the computation was compiled with --max_parallelism above 1, Run
+// partitions large operations over the threads of the Eigen::ThreadPoolDevice
+// passed to set_thread_pool. Without a thread pool the partitions run one after
+// the other on the calling thread.
+//
 // By default each instance of this class manages its own arg, result and temp
 // buffers. The AllocMode constructor parameter may be used to modify the
 // buffer allocation strategy.
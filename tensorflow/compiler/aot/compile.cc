@@ -111,6 +111,7 @@ Status CompileGraph(const GraphDef& graph_def, const tf2xla::Config& config,
       flags.target_triple, flags.target_cpu, flags.target_features,
       flags.entry_point,
       xla::cpu::CpuAotCompilationOptions::RelocationModel::BigPic);
+  aot_opts.set_max_parallelism(flags.max_parallelism);
   return CompileXla(client, computation, aot_opts, compile_result);
 }
 
@@ -52,6 +52,10 @@ void AppendMainFlags(std::vector<Flag>* flag_list, MainFlags* flags) {
        "Name of the generated function.  If multiple generated object files "
        "will be linked into the same binary, each will need a unique entry "
        "point."},
+      {"max_parallelism", &flags->max_parallelism,
+       "Maximum number of parallel tasks into which the generated code may "
+       "partition each operation.  Above 1, the tasks run on the thread pool "
+       "passed to the set_thread_pool method of the generated class."},
       {"cpp_class", &flags->cpp_class,
        "Name of the generated C++ class, wrapping the generated function.  The "
        "syntax of this flag is [[<optional_namespace>::],...]<class_name>.  "
@@ -96,6 +96,12 @@ def tfmatmulandadd(_):
   math_ops.add(x, y, name='x_y_sum')
 
 
+def tfaddexp(_):
+  # Large enough to be partitioned into parallel tasks.
+  x = array_ops.placeholder(dtypes.float32, name='x_hold')
+  math_ops.add(x, math_ops.exp(x), name='x_exp_sum')
+
+
 def tffunction(_):
 
   @function.Defun(dtypes.int32, dtypes.int32)
@@ -138,6 +144,7 @@ def main(_):
   write_graph(tfadd, FLAGS.out_dir)
   write_graph(tfadd_with_ckpt, FLAGS.out_dir)
   write_graph(tfadd_with_ckpt_saver, FLAGS.out_dir)
+  write_graph(tfaddexp, FLAGS.out_dir)
   write_graph(tfgather, FLAGS.out_dir)
   write_graph(tfmatmul, FLAGS.out_dir)
   write_graph(tfmatmulandadd, FLAGS.out_dir)
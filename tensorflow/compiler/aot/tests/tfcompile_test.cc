@@ -16,10 +16,13 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 #define EIGEN_USE_CUSTOM_THREAD_POOL
 
+#include <cmath>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/compiler/aot/tests/test_graph_tfadd.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfadd_with_ckpt.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfadd_with_ckpt_saver.h"
+#include "tensorflow/compiler/aot/tests/test_graph_tfaddexp.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tffunction.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfgather.h"
 #include "tensorflow/compiler/aot/tests/test_graph_tfmatmul.h"
@@ -142,6 +145,27 @@ TEST(TFCompileTest, AddWithCkptSaver) {
   EXPECT_EQ(add_const.result0_data(), add_const.results()[0]);
 }
 
+TEST(TFCompileTest, AddExpParallel) {
+  Eigen::ThreadPool tp(4);
+  Eigen::ThreadPoolDevice device(&tp, tp.NumThreads());
+
+  // Without a thread pool the parallel tasks run on the calling thread.
+  for (const Eigen::ThreadPoolDevice* pool : {&device, nullptr}) {
+    AddExpComp add_exp;
+    add_exp.set_thread_pool(pool);
+    const int size = 256 * 1024;
+    for (int i = 0; i < size; ++i) {
+      add_exp.arg0_data()[i] = (i % 100) / 50.0f;
+    }
+    EXPECT_TRUE(add_exp.Run());
+    EXPECT_EQ(add_exp.error_msg(), "");
+    for (int i = 0; i < size; ++i) {
+      const float x = (i % 100) / 50.0f;
+      EXPECT_NEAR(add_exp.result0_data()[i], x + std::exp(x), 1e-4) << i;
+    }
+  }
+}
+
 TEST(TFCompileTest, Gather) {
   GatherComp gather;
   EXPECT_EQ(gather.arg0_data(), gather.args()[0]);
@@ -197,6 +197,8 @@ def tf_library(name, graph, config,
   # kernel implementations.
   need_xla_data_proto = (tfcompile_flags and
                          tfcompile_flags.find("--gen_program_shape") != -1)
+  need_fork_join = (tfcompile_flags and
+                    tfcompile_flags.find("--max_parallelism") != -1)
   native.cc_library(
       name=name,
       srcs=[object_file],
@@ -212,6 +214,9 @@ def tf_library(name, graph, config,
       ] + (need_xla_data_proto and [
           # If we're generating the program shape, we must depend on the proto.
           "@org_tensorflow//tensorflow/compiler/xla:xla_data_proto",
+      ] or []) + (need_fork_join and [
+          # Parallel code calls the fork/join runtime.
+          "@org_tensorflow//tensorflow/compiler/xla/service/cpu:runtime_fork_join",
       ] or []) + (include_standard_runtime_deps and [
           # TODO(cwhipkey): only depend on kernel code that the model actually needed.
           "@org_tensorflow//tensorflow/compiler/tf2xla/kernels:index_ops_kernel_argmax_float_1d",
@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/public/version.h"
 
 namespace tensorflow {
@@ -37,7 +38,7 @@ static Status BuildLaunchNode(
     const AttrValueMap& function_attr, const string& device_name,
     const DataTypeVector& constant_dtypes, int num_resources,
     const DataTypeVector& arg_dtypes, const DataTypeVector& result_dtypes,
-    Graph* graph, Node** node) {
+    const OptimizerOptions& optimizer_options, Graph* graph, Node** node) {
   NodeDef def;
   def.set_name(graph->NewName(nodename));
   def.set_op("_XlaLaunch");
@@ -50,13 +51,21 @@ static Status BuildLaunchNode(
   function.set_name(function_name);
   *function.mutable_attr() = function_attr;
   AddNodeAttr("function", function, &def);
+  AddNodeAttr("async_compilation", optimizer_options.jit_async_compilation(),
+              &def);
+  AddNodeAttr("shape_bucketing", optimizer_options.jit_shape_bucketing(), &def);
+  std::vector<int64> bucket_boundaries(
+      optimizer_options.jit_bucket_boundaries().begin(),
+      optimizer_options.jit_bucket_boundaries().end());
+  AddNodeAttr("bucket_boundaries", bucket_boundaries, &def);
 
   Status status;
   *node = graph->AddNode(def, &status);
   return status;
 }
 
-static Status ReplaceNodeWithXlaLaunch(Graph* graph, Node* node) {
+static Status ReplaceNodeWithXlaLaunch(
+    const OptimizerOptions& optimizer_options, Graph* graph, Node* node) {
   VLOG(2) << "Replacing " << node->name() << " with XlaLaunch";
 
   int num_constant_args, num_resource_args;
@@ -84,7 +93,7 @@ static Status ReplaceNodeWithXlaLaunch(Graph* graph, Node* node) {
   TF_RETURN_IF_ERROR(BuildLaunchNode(
       graph->NewName(node->name()), node->type_string(), node->def().attr(),
       node->requested_device(), const_dtypes, num_resource_args, arg_dtypes,
-      node->output_types(), graph, &launch_node));
+      node->output_types(), optimizer_options, graph, &launch_node));
   launch_node->set_assigned_device_name(node->assigned_device_name());
 
   // Copy incoming edges to the launch node.
@@ -119,6 +128,10 @@ static Status ReplaceNodeWithXlaLaunch(Graph* graph, Node* node) {
 
 Status BuildXlaLaunchOpsPass::Run(const GraphOptimizationPassOptions& options) {
   Graph* graph = options.graph->get();
+  const OptimizerOptions& optimizer_options =
+      options.session_options != nullptr
+          ? options.session_options->config.graph_options().optimizer_options()
+          : OptimizerOptions::default_instance();
 
   for (Node* n : graph->op_nodes()) {
     // In all cases, only try to compile computational nodes.
@@ -129,7 +142,7 @@ Status BuildXlaLaunchOpsPass::Run(const GraphOptimizationPassOptions& options) {
     // Only compile nodes that are marked for compilation by the
     // compilation-marking pass (via 'attr_name').
     if (IsXlaCompiledKernel(*n)) {
-      TF_RETURN_IF_ERROR(ReplaceNodeWithXlaLaunch(graph, n));
+      TF_RETURN_IF_ERROR(ReplaceNodeWithXlaLaunch(optimizer_options, graph, n));
     }
   }
 
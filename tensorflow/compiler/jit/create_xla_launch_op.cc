@@ -79,6 +79,8 @@ Status CreateXlaLaunchOp(FunctionLibraryRuntime* flr, const NodeDef& ndef,
   func.set_name(ndef.op());
   *(func.mutable_attr()) = ndef.attr();
   AddNodeAttr("function", func, &launch_def);
+  AddNodeAttr("async_compilation", false, &launch_def);
+  AddNodeAttr("shape_bucketing", false, &launch_def);
 
   // TODO(b/32387911): Handles the host memory types across function
   // calls properly. For now, we assume all inputs and outputs are on
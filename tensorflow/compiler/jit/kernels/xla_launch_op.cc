@@ -15,7 +15,11 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/kernels/xla_launch_op.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "tensorflow/compiler/jit/defs.h"
+#include "tensorflow/compiler/jit/shape_bucketing.h"
 #include "tensorflow/compiler/jit/xla_device.h"
 #include "tensorflow/compiler/tf2xla/shape_util.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
@@ -23,16 +27,21 @@ limitations under the License.
 #include "tensorflow/compiler/tf2xla/xla_op_registry.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
+#include "tensorflow/compiler/xla/service/hlo_execution_profile.h"
 #include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/variable_ops.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
 #include "tensorflow/core/util/stream_executor_util.h"
@@ -148,7 +157,7 @@ Status XlaAllocator::MakeTensorFromBuffer(gpu::DeviceMemoryBase buffer,
 }
 
 XlaLocalLaunchOp::XlaLocalLaunchOp(OpKernelConstruction* ctx)
-    : OpKernel(ctx), device_type_(ctx->device_type()) {
+    : AsyncOpKernel(ctx), device_type_(ctx->device_type()) {
   const NameAttrList* func;
   OP_REQUIRES_OK(ctx, ctx->GetAttr("function", &func));
   function_ = *func;
@@ -163,15 +172,42 @@ XlaLocalLaunchOp::XlaLocalLaunchOp(OpKernelConstruction* ctx)
   } else {
     platform_id_ = nullptr;
   }
+
+  // The TensorFlow kernels only run on CPU and GPU devices, and get the
+  // arguments of the function in the memory types of its _Arg and _Retval
+  // nodes: host memory for int32 on GPU, device memory otherwise.
+  bool async_compilation;
+  OP_REQUIRES_OK(ctx, ctx->GetAttr("async_compilation", &async_compilation));
+  async_compilation_ = async_compilation && platform_id_ != nullptr;
+  if (async_compilation_ && device_type_ == DeviceType(DEVICE_GPU)) {
+    DataTypeVector arg_types, result_types;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("Targs", &arg_types));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("Tresults", &result_types));
+    const auto is_int32 = [](DataType dtype) { return dtype == DT_INT32; };
+    if (!std::all_of(constant_types.begin(), constant_types.end(),
+                     is_int32) ||
+        std::any_of(arg_types.begin(), arg_types.end(), is_int32) ||
+        std::any_of(result_types.begin(), result_types.end(), is_int32)) {
+      VLOG(1) << "Compiling " << function_.name()
+              << " synchronously, since its memory types differ from those "
+              << "of its function";
+      async_compilation_ = false;
+    }
+  }
+
+  OP_REQUIRES_OK(ctx, ctx->GetAttr("shape_bucketing", &shape_bucketing_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr("bucket_boundaries", &bucket_boundaries_));
+  std::sort(bucket_boundaries_.begin(), bucket_boundaries_.end());
 }
 
 Status XlaLocalLaunchOp::BuildCompilationCache(OpKernelContext* ctx,
+                                               bool hlo_profile,
                                                XlaCompilationCache** cache) {
   const XlaDevice::Metadata* metadata;
   Status s = XlaDevice::GetMetadata(ctx, &metadata);
   if (s.ok()) {
-    *cache = new XlaCompilationCache(metadata->client(),
-                                     metadata->jit_device_type());
+    *cache = new XlaCompilationCache(
+        metadata->client(), metadata->jit_device_type(), hlo_profile);
     return Status::OK();
   }
 
@@ -194,7 +230,8 @@ Status XlaLocalLaunchOp::BuildCompilationCache(OpKernelContext* ctx,
                                    device_type_.type());
   }
   *cache = new XlaCompilationCache(
-      client.ValueOrDie(), DeviceType(registration->compilation_device_name));
+      client.ValueOrDie(), DeviceType(registration->compilation_device_name),
+      hlo_profile);
   return Status::OK();
 }
 
@@ -215,23 +252,139 @@ std::vector<OptionalTensor> SnapshotResourceVariables(OpKernelContext* ctx,
   return snapshot;
 }
 
-void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
+namespace {
+
+// Sets `*padded` to a copy of `input` whose leading dimension is padded with
+// zeros to `rows`.
+Status PadRows(OpKernelContext* ctx, const Tensor& input, int64 rows,
+               Tensor* padded) {
+  TensorShape shape = input.shape();
+  shape.set_dim(0, rows);
+  TF_RETURN_IF_ERROR(ctx->allocate_temp(input.dtype(), shape, padded));
+  const uint64 size = input.TotalBytes();
+  const uint64 padding_size = padded->TotalBytes() - size;
+  const char* src = input.tensor_data().data();
+  char* dst = const_cast<char*>(padded->tensor_data().data());
+
+  gpu::Stream* stream =
+      ctx->op_device_context() ? ctx->op_device_context()->stream() : nullptr;
+  if (stream == nullptr) {
+    std::memcpy(dst, src, size);
+    std::memset(dst + size, 0, padding_size);
+    return Status::OK();
+  }
+  gpu::DeviceMemoryBase src_mem(const_cast<char*>(src), size);
+  gpu::DeviceMemoryBase dst_mem(dst, size);
+  gpu::DeviceMemoryBase padding_mem(dst + size, padding_size);
+  stream->ThenMemcpyD2D(&dst_mem, src_mem, size)
+      .ThenMemZero(&padding_mem, padding_size);
+  if (!stream->ok()) {
+    return errors::Internal("Failed to pad an argument of an XLA launch");
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+Status XlaLocalLaunchOp::BucketInputs(OpKernelContext* ctx,
+                                      BucketedInputs* bucketed) {
+  const int num_inputs = ctx->num_inputs();
+  bucketed->inputs.resize(num_inputs);
+  for (int i = 0; i < num_inputs; ++i) {
+    bucketed->inputs[i] = &ctx->input(i);
+  }
+  if (!shape_bucketing_) {
+    return Status::OK();
+  }
+
+  // Pads the leading dimension of the non-constant arguments that are not
+  // bucket sizes. The arguments of the same size form a padding group.
+  const int first_variable_arg = num_inputs - num_resource_args_;
+  std::vector<int> arg_groups(num_inputs, -1);
+  std::vector<TensorShape> arg_shapes(num_inputs);
+  string key;
+  for (int i = 0; i < num_inputs; ++i) {
+    const Tensor& input = ctx->input(i);
+    arg_shapes[i] = input.shape();
+    if (i >= num_constant_args_ && i < first_variable_arg &&
+        input.dims() > 0 && input.NumElements() > 0 &&
+        DataTypeCanUseMemcpy(input.dtype())) {
+      const int64 rows = input.dim_size(0);
+      const int64 bucket = BucketedSize(rows, bucket_boundaries_);
+      if (bucket != rows) {
+        auto it = std::find(bucketed->group_rows.begin(),
+                            bucketed->group_rows.end(), rows);
+        arg_groups[i] = it - bucketed->group_rows.begin();
+        if (it == bucketed->group_rows.end()) {
+          bucketed->group_rows.push_back(rows);
+        }
+        arg_shapes[i].set_dim(0, bucket);
+      }
+    }
+    strings::StrAppend(&key, arg_groups[i], arg_shapes[i].DebugString());
+  }
+  if (bucketed->group_rows.empty()) {
+    return Status::OK();
+  }
+
+  RowPadding padding;
+  {
+    mutex_lock lock(mu_);
+    auto it = row_paddings_.find(key);
+    if (it == row_paddings_.end()) {
+      FunctionLibraryRuntime* lib = ctx->function_library();
+      FunctionLibraryRuntime::Handle handle;
+      TF_RETURN_IF_ERROR(lib->Instantiate(
+          function_.name(), AttrSlice(&function_.attr()), &handle));
+      RowPadding& analysis = row_paddings_[key];
+      analysis.status = AnalyzeRowPadding(
+          *lib->GetFunctionBody(handle)->graph, lib->graph_def_version(),
+          arg_shapes, arg_groups, &analysis.result_groups);
+      VLOG(1) << "Padding the arguments of " << function_.name() << " to "
+              << key << ": " << analysis.status;
+      it = row_paddings_.find(key);
+    }
+    padding = it->second;
+  }
+  if (!padding.status.ok()) {
+    bucketed->group_rows.clear();
+    return Status::OK();
+  }
+
+  bucketed->padded.resize(num_inputs);
+  for (int i = 0; i < num_inputs; ++i) {
+    if (arg_groups[i] >= 0) {
+      TF_RETURN_IF_ERROR(PadRows(ctx, ctx->input(i), arg_shapes[i].dim_size(0),
+                                 &bucketed->padded[i]));
+      bucketed->inputs[i] = &bucketed->padded[i];
+    }
+  }
+  bucketed->result_groups = std::move(padding.result_groups);
+  return Status::OK();
+}
+
+void XlaLocalLaunchOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
   VLOG(1) << "XlaLocalLaunchOp::Compute "
           << Canonicalize(function_.name(), AttrSlice(&function_.attr()));
   // We store information about the JIT-compiled XLA computation
   // in the ResourceMgr.
   ResourceMgr* rm = ctx->resource_manager();
-  OP_REQUIRES(ctx, rm, errors::Internal("No resource manager."));
-
-  gpu::Stream* stream =
-      ctx->op_device_context() ? ctx->op_device_context()->stream() : nullptr;
+  OP_REQUIRES_ASYNC(ctx, rm, errors::Internal("No resource manager."), done);
 
+  // The steps that collect step stats, e.g. because their RunOptions set a
+  // trace_level, run executables instrumented for HLO profiling, which are
+  // kept in a cache of their own so that the other steps do not pay for the
+  // instrumentation.
+  const bool hlo_profile = ctx->stats_collector() != nullptr;
   XlaCompilationCache* cache;
-  OP_REQUIRES_OK(ctx, rm->LookupOrCreate<XlaCompilationCache>(
-                          rm->default_container(), "xla_cache", &cache,
-                          [this, ctx](XlaCompilationCache** cache) {
-                            return BuildCompilationCache(ctx, cache);
-                          }));
+  OP_REQUIRES_OK_ASYNC(
+      ctx, rm->LookupOrCreate<XlaCompilationCache>(
+               rm->default_container(),
+               hlo_profile ? "xla_profiled_cache" : "xla_cache", &cache,
+               [this, ctx, hlo_profile](XlaCompilationCache** cache) {
+                 return BuildCompilationCache(ctx, hlo_profile, cache);
+               }),
+      done);
   // Hold the reference to the JIT during evaluation. (We could probably
   // free it sooner because the ResourceMgr will retain a reference, but
   // this is more obviously correct.)
@@ -259,10 +412,121 @@ void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
   options.allow_cpu_custom_calls = (platform_id_ == gpu::host::kHostPlatformId);
   options.local_executable_has_hybrid_result = true;
 
+  BucketedInputs bucketed;
+  OP_REQUIRES_OK_ASYNC(ctx, BucketInputs(ctx, &bucketed), done);
+
   const XlaCompiler::CompilationResult* kernel;
   xla::LocalExecutable* executable;
-  OP_REQUIRES_OK(ctx, cache->Compile(options, function_, num_constant_args_,
-                                     variables, ctx, &kernel, &executable));
+  if (async_compilation_) {
+    OP_REQUIRES_OK_ASYNC(
+        ctx, cache->CompileAsync(options, function_, num_constant_args_,
+                                 variables, bucketed.inputs, &kernel,
+                                 &executable),
+        done);
+    if (kernel == nullptr) {
+      VLOG(1) << "Running the TensorFlow kernels while compiling";
+      RunFunction(ctx, std::move(done));
+      return;
+    }
+  } else {
+    OP_REQUIRES_OK_ASYNC(
+        ctx, cache->Compile(options, function_, num_constant_args_, variables,
+                            bucketed.inputs, &kernel, &executable),
+        done);
+  }
+  RunExecutable(ctx, client, kernel, executable, bucketed, variables);
+  done();
+}
+
+void XlaLocalLaunchOp::RunFunction(OpKernelContext* ctx, DoneCallback done) {
+  FunctionLibraryRuntime* lib = ctx->function_library();
+  OP_REQUIRES_ASYNC(ctx, lib != nullptr,
+                    errors::Internal("No function library is provided."),
+                    done);
+  FunctionLibraryRuntime::Handle handle;
+  OP_REQUIRES_OK_ASYNC(ctx,
+                       lib->Instantiate(function_.name(),
+                                        AttrSlice(&function_.attr()), &handle),
+                       done);
+  FunctionLibraryRuntime::Options opts;
+  opts.step_id = ctx->step_id();
+  opts.rendezvous = ctx->rendezvous();
+  opts.cancellation_manager = ctx->cancellation_manager();
+  opts.step_container = ctx->step_container();
+  opts.stats_collector = ctx->stats_collector();
+  opts.runner = ctx->runner();
+  std::vector<Tensor> args;
+  args.reserve(ctx->num_inputs());
+  for (int i = 0; i < ctx->num_inputs(); ++i) {
+    args.push_back(ctx->input(i));
+  }
+  std::vector<Tensor>* rets = new std::vector<Tensor>;
+  lib->Run(opts, handle, args, rets, [ctx, done, rets](const Status& status) {
+    if (!status.ok()) {
+      ctx->SetStatus(status);
+    } else {
+      const int ret_size = static_cast<int>(rets->size());
+      CHECK_EQ(ret_size, ctx->num_outputs());
+      for (int i = 0; i < ret_size; ++i) {
+        ctx->set_output(i, (*rets)[i]);
+      }
+    }
+    delete rets;
+    done();
+  });
+}
+
+namespace {
+
+// Saves the cycles taken by each HLO instruction of the entry computation of
+// `executable`, e.g. a fusion, to the step stats of `ctx`, as a pseudo-node
+// named after the launch op and the instruction.  The HLO profile only has
+// durations, so the pseudo-nodes all start when the launch does.
+void SaveHloExecutionProfile(OpKernelContext* ctx, xla::LocalClient* client,
+                             const xla::LocalExecutable& executable,
+                             const xla::HloExecutionProfile& profile,
+                             int64 start_micros) {
+  const gpu::DeviceDescription& device_description =
+      client->backend().default_stream_executor()->GetDeviceDescription();
+  const double cycles_per_micro = device_description.clock_rate_ghz() * 1e3;
+  if (cycles_per_micro <= 0) return;
+  const xla::HloComputation& computation =
+      *executable.executable()->module().entry_computation();
+  for (const xla::HloInstruction* instruction : computation.instructions()) {
+    const uint64 cycles = profile.GetProfileResult(*instruction);
+    if (cycles == 0) continue;
+    const int64 micros = static_cast<int64>(cycles / cycles_per_micro);
+    NodeExecStats* stats = new NodeExecStats;
+    stats->set_node_name(
+        strings::StrCat(ctx->op_kernel().name(), "/", instruction->name()));
+    stats->set_timeline_label(strings::StrCat(
+        instruction->name(), " = ", instruction->ToCategory(), " (", cycles,
+        " cycles)"));
+    stats->set_all_start_micros(start_micros);
+    stats->set_op_start_rel_micros(0);
+    stats->set_op_end_rel_micros(micros);
+    stats->set_all_end_rel_micros(micros);
+    ctx->stats_collector()->Save(ctx->device()->name(), stats);
+  }
+
+  if (VLOG_IS_ON(1)) {
+    std::unique_ptr<xla::HloCostAnalysis> cost_analysis =
+        executable.executable()->CreateCostAnalysis();
+    XLA_LOG_LINES(tensorflow::INFO,
+                  profile.ToString(computation, device_description,
+                                   cost_analysis.get()));
+  }
+}
+
+}  // namespace
+
+void XlaLocalLaunchOp::RunExecutable(
+    OpKernelContext* ctx, xla::LocalClient* client,
+    const XlaCompiler::CompilationResult* kernel,
+    xla::LocalExecutable* executable, const BucketedInputs& bucketed,
+    const std::vector<OptionalTensor>& variables) {
+  gpu::Stream* stream =
+      ctx->op_device_context() ? ctx->op_device_context()->stream() : nullptr;
 
   VLOG(1) << "Executing XLA Computation...";
 
@@ -286,7 +550,7 @@ void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
     if (arg_num >= first_variable_arg) {
       t = &(variables[arg_num - first_variable_arg].value);
     } else {
-      t = &(ctx->input(arg_num));
+      t = bucketed.inputs[arg_num];
     }
 
     gpu::DeviceMemoryBase dmem = gpu::DeviceMemoryBase(
@@ -319,6 +583,10 @@ void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
   run_options.set_stream(stream);
   run_options.set_allocator(&xla_allocator);
   run_options.set_intra_op_thread_pool(&ctx->eigen_cpu_device());
+  xla::HloExecutionProfile hlo_execution_profile;
+  if (ctx->stats_collector() != nullptr) {
+    run_options.set_hlo_execution_profile(&hlo_execution_profile);
+  }
   Env* env = Env::Default();
   auto start_time = env->NowMicros();
   auto run_result = executable->Run(arg_ptrs, run_options);
@@ -333,6 +601,10 @@ void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
   output = run_result.ConsumeValueOrDie()->release();
   auto elapsed = env->NowMicros() - start_time;
   VLOG(2) << "Elapsed time: " << elapsed << "us";
+  if (ctx->stats_collector() != nullptr) {
+    SaveHloExecutionProfile(ctx, client, *executable, hlo_execution_profile,
+                            start_time);
+  }
 
   // Computation output should always be a tuple.
   if (VLOG_IS_ON(2)) {
@@ -343,9 +615,15 @@ void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
   // Copy XLA results to the OpOutputList.
   int output_num = 0;
   for (int i = 0; i < ctx->num_outputs(); ++i) {
+    // The padded rows of the results are removed from the outputs.
+    const int group =
+        bucketed.result_groups.empty() ? -1 : bucketed.result_groups[i];
     if (kernel->outputs[i].is_constant) {
       // Output is a constant.
-      const Tensor& const_tensor = kernel->outputs[i].constant_value;
+      Tensor const_tensor = kernel->outputs[i].constant_value;
+      if (group >= 0) {
+        const_tensor = const_tensor.Slice(0, bucketed.group_rows[group]);
+      }
       const size_t total_bytes = const_tensor.TotalBytes();
       if (stream && total_bytes > 0) {
         // Copy host -> device. (Empty tensors don't have backing buffers.)
@@ -372,6 +650,9 @@ void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
       OP_REQUIRES_OK(ctx, xla_allocator.MakeTensorFromBuffer(
                               buffer, ctx->expected_output_dtype(i), shape,
                               &output_tensor));
+      if (group >= 0) {
+        output_tensor = output_tensor.Slice(0, bucketed.group_rows[group]);
+      }
       ctx->set_output(i, output_tensor);
       ++output_num;
     }
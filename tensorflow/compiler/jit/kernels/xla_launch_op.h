@@ -16,12 +16,17 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_JIT_KERNELS_XLA_LOCAL_LAUNCH_OP_H_
 #define TENSORFLOW_COMPILER_JIT_KERNELS_XLA_LOCAL_LAUNCH_OP_H_
 
+#include <unordered_map>
+#include <vector>
+
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/util/stream_executor_util.h"
 
 namespace tensorflow {
@@ -43,23 +48,76 @@ std::vector<OptionalTensor> SnapshotResourceVariables(OpKernelContext* ctx,
 // XlaLocalLaunchOp uses xla::LocalClient::Compile() and
 // xla::LocalExecutable::Run(), and passes arguments into/out of XLA in device
 // memory.
-class XlaLocalLaunchOp : public OpKernel {
+// If the `async_compilation` attr is true, the op does not wait for the
+// compilation of a new signature: it runs the function with its TensorFlow
+// kernels until the compilation, which runs in the background, is done.
+// If the `shape_bucketing` attr is true, the op pads the leading dimension of
+// its arguments to a bucket size when the function computes the rows of its
+// results separately, and compiles and runs the function for the padded
+// shapes.
+class XlaLocalLaunchOp : public AsyncOpKernel {
  public:
   explicit XlaLocalLaunchOp(OpKernelConstruction* ctx);
   ~XlaLocalLaunchOp() override;
 
-  void Compute(OpKernelContext* ctx) override;
+  void ComputeAsync(OpKernelContext* ctx, DoneCallback done) override;
 
  private:
-  // Builds a XlaCompilationCache class suitable for the current device.
-  Status BuildCompilationCache(OpKernelContext* ctx,
+  // Builds a XlaCompilationCache class suitable for the current device, whose
+  // executables are instrumented for HLO profiling if `hlo_profile` is true.
+  Status BuildCompilationCache(OpKernelContext* ctx, bool hlo_profile,
                                XlaCompilationCache** compiler);
 
+  // Runs the function with its TensorFlow kernels.
+  void RunFunction(OpKernelContext* ctx, DoneCallback done);
+
+  // The inputs of a launch, whose leading dimensions may be padded.
+  struct BucketedInputs {
+    // The padded inputs.
+    std::vector<Tensor> padded;
+    // The inputs to compile and run the function with.
+    std::vector<const Tensor*> inputs;
+    // The leading dimension of each padding group before padding.
+    std::vector<int64> group_rows;
+    // The padding group of each result, or -1 if it is not padded. Empty if
+    // no input is padded.
+    std::vector<int> result_groups;
+  };
+
+  // Sets `*bucketed` to the inputs of `ctx`, padded if `shape_bucketing_` is
+  // true and the function allows it.
+  Status BucketInputs(OpKernelContext* ctx, BucketedInputs* bucketed);
+
+  // Runs the compiled `executable` of `kernel` on the `bucketed` inputs of
+  // `ctx` and the snapshot of its resource `variables`. If `ctx` collects
+  // step stats, the executable must be instrumented for HLO profiling, and
+  // the cycles taken by its HLO instructions are saved as pseudo-nodes.
+  void RunExecutable(OpKernelContext* ctx, xla::LocalClient* client,
+                     const XlaCompiler::CompilationResult* kernel,
+                     xla::LocalExecutable* executable,
+                     const BucketedInputs& bucketed,
+                     const std::vector<OptionalTensor>& variables);
+
   DeviceType device_type_;
   NameAttrList function_;
   int num_constant_args_;
   // Number of resource variable arguments.
   int num_resource_args_;
+  // Whether the function runs with its TensorFlow kernels while it is
+  // compiled.
+  bool async_compilation_;
+  // Whether the leading dimension of the arguments is padded to the sorted
+  // `bucket_boundaries_`, or to a power of two if it is empty.
+  bool shape_bucketing_;
+  std::vector<int64> bucket_boundaries_;
+
+  // The results of AnalyzeRowPadding, by the padded shapes of the arguments.
+  struct RowPadding {
+    Status status;
+    std::vector<int> result_groups;
+  };
+  mutex mu_;
+  std::unordered_map<string, RowPadding> row_paddings_ GUARDED_BY(mu_);
 
   perftools::gputools::Platform::Id platform_id_;
 
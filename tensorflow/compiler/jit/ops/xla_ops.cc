@@ -27,6 +27,14 @@ REGISTER_OP("_XlaLaunch")
     .Output("results: Tresults")
     .Attr("Tresults: list(type) >= 0")
     .Attr("function: func")
+    // If true, runs `function` with its TensorFlow kernels while it is
+    // compiled in the background for a new signature.
+    .Attr("async_compilation: bool = false")
+    // If true, pads the leading dimension of the arguments to the smallest of
+    // `bucket_boundaries`, or power of two if it is empty, that holds it,
+    // when `function` computes the rows of its results separately.
+    .Attr("shape_bucketing: bool = false")
+    .Attr("bucket_boundaries: list(int) = []")
     // XLA random-number generation ops are stateful.
     // TODO(phawkins): create stateful and non-stateful variants of _XlaLaunch.
     .SetIsStateful()
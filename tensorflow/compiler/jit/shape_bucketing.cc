@@ -0,0 +1,360 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/compiler/jit/shape_bucketing.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "tensorflow/core/common_runtime/shape_refiner.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+namespace {
+
+using shape_inference::InferenceContext;
+using shape_inference::ShapeHandle;
+
+// Ops whose rows of the output each depend only on the same row of their
+// first input, and on their other inputs as a whole.
+const std::unordered_set<string>* LeadingOperandOps() {
+  static const std::unordered_set<string>* ops = new std::unordered_set<string>(
+      {"Abs", "AvgPool", "AvgPool3D", "BiasAdd", "BiasAddV1", "Cast", "Ceil",
+       "Conv2D", "Conv3D", "Cos", "DepthwiseConv2dNative", "Elu", "Erf", "Erfc",
+       "Exp", "Expm1", "Floor", "Identity", "IsFinite", "IsInf", "IsNan", "Log",
+       "Log1p", "LogicalNot", "MatMul", "MaxPool", "MaxPool3D", "Neg",
+       "OnesLike", "PreventGradient", "Reciprocal", "Relu", "Relu6", "Rint",
+       "Round", "Rsqrt", "Selu", "Sigmoid", "Sign", "Sin", "Snapshot",
+       "Softplus", "Softsign", "Sqrt", "Square", "StopGradient", "Tan", "Tanh",
+       "ZerosLike"});
+  return ops;
+}
+
+// Ops whose elements of the output each depend only on the same element of
+// each of their inputs, after broadcasting.
+const std::unordered_set<string>* ElementwiseOps() {
+  static const std::unordered_set<string>* ops = new std::unordered_set<string>(
+      {"Add", "Atan2", "Div", "EluGrad", "Equal", "FloorDiv", "FloorMod",
+       "Greater", "GreaterEqual", "Less", "LessEqual", "LogicalAnd",
+       "LogicalOr", "Maximum", "Minimum", "Mul", "NotEqual", "Pow", "RealDiv",
+       "ReciprocalGrad", "Relu6Grad", "ReluGrad", "RsqrtGrad", "Select",
+       "SeluGrad", "SigmoidGrad", "SoftplusGrad", "SqrtGrad",
+       "SquaredDifference", "Sub", "TanhGrad", "TruncateDiv"});
+  return ops;
+}
+
+// Ops whose rows of the outputs each depend only on the same rows of all of
+// their inputs, which must all be padded.
+const std::unordered_set<string>* RowwiseOps() {
+  static const std::unordered_set<string>* ops = new std::unordered_set<string>(
+      {"AddN", "SoftmaxCrossEntropyWithLogits",
+       "SparseSoftmaxCrossEntropyWithLogits"});
+  return ops;
+}
+
+// Reductions over the axes of their second input.
+const std::unordered_set<string>* ReductionOps() {
+  static const std::unordered_set<string>* ops = new std::unordered_set<string>(
+      {"All", "Any", "ArgMax", "ArgMin", "Max", "Mean", "Min", "Prod", "Sum"});
+  return ops;
+}
+
+Status Unsupported(const Node& node) {
+  return errors::Unimplemented("Padded rows reach ", node.type_string(),
+                               " node ", node.name(),
+                               ", which may not compute them separately");
+}
+
+// Returns the elements of input `index` of `node`, which must be a constant
+// vector of integers.
+Status GetConstantVector(const Node& node, int index,
+                         std::vector<int64>* elements) {
+  const Edge* edge;
+  TF_RETURN_IF_ERROR(node.input_edge(index, &edge));
+  const Node* src = edge->src();
+  if (src->type_string() != "Const") {
+    return Unsupported(node);
+  }
+  const TensorProto* proto;
+  TF_RETURN_IF_ERROR(GetNodeAttr(src->attrs(), "value", &proto));
+  Tensor value;
+  if (!value.FromProto(*proto) || value.dims() > 1 ||
+      (value.dtype() != DT_INT32 && value.dtype() != DT_INT64)) {
+    return Unsupported(node);
+  }
+  for (int64 i = 0; i < value.NumElements(); ++i) {
+    elements->push_back(value.dtype() == DT_INT32 ? value.flat<int32>()(i)
+                                                  : value.flat<int64>()(i));
+  }
+  return Status::OK();
+}
+
+// Returns the axes of the constant input `index` of `node`. Negative axes
+// are counted from `rank`, which must then be known.
+Status GetConstantAxes(const Node& node, int index, int64 rank,
+                       std::vector<int64>* axes) {
+  TF_RETURN_IF_ERROR(GetConstantVector(node, index, axes));
+  for (int64& axis : *axes) {
+    if (axis < 0) {
+      if (rank < 0) {
+        return Unsupported(node);
+      }
+      axis += rank;
+    }
+  }
+  return Status::OK();
+}
+
+int64 Rank(InferenceContext* c, ShapeHandle shape) {
+  return c->RankKnown(shape) ? c->Rank(shape) : -1;
+}
+
+bool IsPadded(int group) { return group >= 0; }
+
+// Returns OK if each row of the outputs of `node` depends only on the same
+// rows of its padded inputs, whose padding groups are `groups`, and sets
+// `*group` to the group of its outputs.
+Status AnalyzeNode(const Node& node, InferenceContext* c,
+                   const std::vector<int>& groups, int* group) {
+  // Rows padded from different sizes do not match.
+  *group = -1;
+  for (int input_group : groups) {
+    if (IsPadded(input_group)) {
+      if (IsPadded(*group) && *group != input_group) {
+        return Unsupported(node);
+      }
+      *group = input_group;
+    }
+  }
+  const string& op = node.type_string();
+  const bool only_first_padded =
+      std::none_of(groups.begin() + 1, groups.end(), IsPadded);
+
+  if (LeadingOperandOps()->count(op) > 0) {
+    if (!only_first_padded) {
+      return Unsupported(node);
+    }
+    if (op == "MatMul") {
+      bool transpose_a;
+      TF_RETURN_IF_ERROR(
+          GetNodeAttr(node.attrs(), "transpose_a", &transpose_a));
+      if (transpose_a) {
+        return Unsupported(node);
+      }
+    }
+    return Status::OK();
+  }
+
+  if (op == "Softmax" || op == "LogSoftmax") {
+    // They normalize the last dimension.
+    return Rank(c, c->input(0)) >= 2 ? Status::OK() : Unsupported(node);
+  }
+
+  if (ElementwiseOps()->count(op) > 0) {
+    // Padded inputs must not broadcast their rows into other dimensions of
+    // the output, nor the other inputs add rows of their own.
+    const int64 rank = Rank(c, c->output(0));
+    if (rank < 1) {
+      return Unsupported(node);
+    }
+    for (int i = 0; i < c->num_inputs(); ++i) {
+      ShapeHandle input = c->input(i);
+      const int64 input_rank = Rank(c, input);
+      if (IsPadded(groups[i]) ? input_rank != rank
+                    : input_rank < 0 ||
+                          (input_rank == rank &&
+                           c->Value(c->Dim(input, 0)) != 1)) {
+        return Unsupported(node);
+      }
+    }
+    return Status::OK();
+  }
+
+  if (RowwiseOps()->count(op) > 0) {
+    return std::all_of(groups.begin(), groups.end(), IsPadded)
+               ? Status::OK()
+               : Unsupported(node);
+  }
+
+  if (!only_first_padded) {
+    if (op != "ConcatV2") {
+      return Unsupported(node);
+    }
+    // The values must all be padded, and joined along another axis.
+    const int values = groups.size() - 1;
+    if (IsPadded(groups[values]) ||
+        !std::all_of(groups.begin(), groups.begin() + values, IsPadded)) {
+      return Unsupported(node);
+    }
+    std::vector<int64> axes;
+    TF_RETURN_IF_ERROR(
+        GetConstantAxes(node, values, Rank(c, c->input(0)), &axes));
+    return axes.size() == 1 && axes[0] != 0 ? Status::OK()
+                                            : Unsupported(node);
+  }
+
+  const int64 rank = Rank(c, c->input(0));
+  std::vector<int64> axes;
+  if (ReductionOps()->count(op) > 0) {
+    TF_RETURN_IF_ERROR(GetConstantAxes(node, 1, rank, &axes));
+    return std::find(axes.begin(), axes.end(), 0) == axes.end()
+               ? Status::OK()
+               : Unsupported(node);
+  }
+  if (op == "Transpose") {
+    TF_RETURN_IF_ERROR(GetConstantAxes(node, 1, rank, &axes));
+    return !axes.empty() && axes[0] == 0 ? Status::OK() : Unsupported(node);
+  }
+  if (op == "ExpandDims") {
+    TF_RETURN_IF_ERROR(
+        GetConstantAxes(node, 1, rank < 0 ? -1 : rank + 1, &axes));
+    return axes.size() == 1 && axes[0] != 0 ? Status::OK()
+                                            : Unsupported(node);
+  }
+  if (op == "Squeeze") {
+    // Without axes, it would also squeeze padded rows of size 1.
+    std::vector<int32> squeeze_dims;
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(node.attrs(), "squeeze_dims", &squeeze_dims));
+    for (int32 axis : squeeze_dims) {
+      if (axis == 0 || (axis < 0 && (rank < 0 || axis == -rank))) {
+        return Unsupported(node);
+      }
+    }
+    return squeeze_dims.empty() ? Unsupported(node) : Status::OK();
+  }
+  if (op == "Reshape") {
+    // Handles reshapes to [-1, ...] that keep the size of each row.
+    std::vector<int64> dims;
+    TF_RETURN_IF_ERROR(GetConstantVector(node, 1, &dims));
+    if (dims.empty() || dims[0] != -1 || rank < 1) {
+      return Unsupported(node);
+    }
+    ShapeHandle input = c->input(0);
+    int64 input_row_size = 1;
+    for (int64 d = 1; d < rank; ++d) {
+      const int64 size = c->Value(c->Dim(input, d));
+      if (size < 0) {
+        return Unsupported(node);
+      }
+      input_row_size *= size;
+    }
+    int64 output_row_size = 1;
+    for (size_t d = 1; d < dims.size(); ++d) {
+      if (dims[d] < 0) {
+        return Unsupported(node);
+      }
+      output_row_size *= dims[d];
+    }
+    return input_row_size == output_row_size ? Status::OK()
+                                             : Unsupported(node);
+  }
+  return Unsupported(node);
+}
+
+}  // namespace
+
+int64 BucketedSize(int64 size, const std::vector<int64>& boundaries) {
+  if (boundaries.empty()) {
+    int64 bucket = 1;
+    while (bucket < size) {
+      bucket *= 2;
+    }
+    return bucket;
+  }
+  auto it = std::lower_bound(boundaries.begin(), boundaries.end(), size);
+  return it == boundaries.end() ? size : *it;
+}
+
+Status AnalyzeRowPadding(const Graph& graph, int graph_def_version,
+                         const std::vector<TensorShape>& arg_shapes,
+                         const std::vector<int>& arg_groups,
+                         std::vector<int>* result_groups) {
+  if (arg_shapes.size() != arg_groups.size()) {
+    return errors::InvalidArgument("Got ", arg_shapes.size(),
+                                   " argument shapes for ", arg_groups.size(),
+                                   " arguments");
+  }
+  int num_results = 0;
+  for (const Node* node : graph.op_nodes()) {
+    if (node->type_string() == "_Retval") {
+      ++num_results;
+    }
+  }
+  result_groups->assign(num_results, -1);
+
+  ShapeRefiner refiner(graph_def_version, graph.op_registry());
+  // The padding group of each output of each node.
+  std::vector<std::vector<int>> groups(graph.num_node_ids());
+  std::vector<Node*> order;
+  GetReversePostOrder(graph, &order);
+  for (const Node* node : order) {
+    if (!node->IsOp()) {
+      continue;
+    }
+    TF_RETURN_IF_ERROR(refiner.AddNode(node));
+    groups[node->id()].resize(node->num_outputs(), -1);
+
+    if (node->type_string() == "_Arg") {
+      int index;
+      TF_RETURN_IF_ERROR(GetNodeAttr(node->attrs(), "index", &index));
+      if (index < 0 || index >= static_cast<int>(arg_shapes.size())) {
+        return errors::InvalidArgument("Invalid argument index ", index);
+      }
+      InferenceContext* c = refiner.GetContext(node);
+      ShapeHandle shape;
+      TF_RETURN_IF_ERROR(
+          c->MakeShapeFromTensorShape(arg_shapes[index], &shape));
+      TF_RETURN_IF_ERROR(refiner.SetShape(node, 0, shape));
+      groups[node->id()][0] = arg_groups[index];
+      continue;
+    }
+
+    std::vector<int> input_groups(node->num_inputs(), -1);
+    for (const Edge* edge : node->in_edges()) {
+      if (!edge->IsControlEdge()) {
+        input_groups[edge->dst_input()] =
+            groups[edge->src()->id()][edge->src_output()];
+      }
+    }
+    if (std::none_of(input_groups.begin(), input_groups.end(), IsPadded)) {
+      continue;
+    }
+
+    if (node->type_string() == "_Retval") {
+      int index;
+      TF_RETURN_IF_ERROR(GetNodeAttr(node->attrs(), "index", &index));
+      if (index < 0 || index >= num_results) {
+        return errors::InvalidArgument("Invalid result index ", index);
+      }
+      (*result_groups)[index] = input_groups[0];
+      continue;
+    }
+
+    int group;
+    TF_RETURN_IF_ERROR(
+        AnalyzeNode(*node, refiner.GetContext(node), input_groups, &group));
+    groups[node->id()].assign(node->num_outputs(), group);
+  }
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,66 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+// Padding of the leading dimension of the inputs of compiled clusters to a
+// few bucket sizes, so that clusters that run on inputs of many sizes, e.g.
+// sequences of variable lengths, are compiled for a bounded number of shapes.
+
+#ifndef TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
+#define TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
+
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Returns the size to which a leading dimension of `size` is padded: the
+// smallest of the sorted `boundaries` that is at least `size`, or the
+// smallest power of two that is if `boundaries` is empty. Sizes above the
+// largest boundary are not padded.
+int64 BucketedSize(int64 size, const std::vector<int64>& boundaries);
+
+// Determines whether the function `graph`, with its _Arg and _Retval nodes,
+// computes the same values when the leading dimension of some of its
+// arguments is padded with rows that it does not use, i.e. whether each row
+// of its results depends only on the same rows of those arguments.
+// `arg_shapes` are the shapes of the padded arguments, and `arg_groups` the
+// padding group of each argument, or -1 if it is not padded: the arguments
+// of a group have the same leading dimension before and after padding.
+//
+// The analysis follows the padded rows through the ops that compute each
+// row independently: elementwise ops, when the other operands do not have
+// rows of their own; matrix multiplications, convolutions and pooling over
+// the rows of the left operand or batch; reductions, transposes and
+// reshapes that keep the leading dimension; and so on. Any other use of a
+// padded value, e.g. by a reduction over its rows, an assignment to a
+// variable or an op that combines rows of different groups, returns an
+// Unimplemented error that names it.
+//
+// On success, sets `*result_groups` to the padding group of each result, or
+// -1 if it is not padded. The caller must slice the padded results back to
+// the leading dimension of their group before padding.
+Status AnalyzeRowPadding(const Graph& graph, int graph_def_version,
+                         const std::vector<TensorShape>& arg_shapes,
+                         const std::vector<int>& arg_groups,
+                         std::vector<int>* result_groups);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_H_
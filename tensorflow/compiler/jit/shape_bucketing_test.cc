@@ -0,0 +1,156 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/compiler/jit/shape_bucketing.h"
+
+#include "tensorflow/cc/framework/ops.h"
+#include "tensorflow/cc/ops/function_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(BucketedSizeTest, PowersOfTwo) {
+  EXPECT_EQ(1, BucketedSize(1, {}));
+  EXPECT_EQ(8, BucketedSize(5, {}));
+  EXPECT_EQ(8, BucketedSize(8, {}));
+  EXPECT_EQ(1024, BucketedSize(513, {}));
+}
+
+TEST(BucketedSizeTest, Boundaries) {
+  const std::vector<int64> boundaries = {10, 50, 100};
+  EXPECT_EQ(10, BucketedSize(1, boundaries));
+  EXPECT_EQ(50, BucketedSize(10 + 1, boundaries));
+  EXPECT_EQ(100, BucketedSize(100, boundaries));
+  EXPECT_EQ(101, BucketedSize(101, boundaries));
+}
+
+class AnalyzeRowPaddingTest : public ::testing::Test {
+ protected:
+  // Analyzes the function of `root` for the arguments `x`, of shape [8, 16],
+  // and `w`, of shape [16, 4], padding `x`.
+  Status Analyze(const Scope& root, std::vector<int>* result_groups) {
+    std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
+    TF_RETURN_IF_ERROR(root.ToGraph(graph.get()));
+    return AnalyzeRowPadding(*graph, TF_GRAPH_DEF_VERSION,
+                             {TensorShape({8, 16}), TensorShape({16, 4})},
+                             {0, -1}, result_groups);
+  }
+};
+
+TEST_F(AnalyzeRowPaddingTest, RowwiseOps) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::_Arg(root.WithOpName("x"), DT_FLOAT, 0);
+  auto w = ops::_Arg(root.WithOpName("w"), DT_FLOAT, 1);
+  auto matmul = ops::MatMul(root.WithOpName("matmul"), x, w);
+  auto bias = ops::Const(root.WithOpName("bias"), {1.0f, 2.0f, 3.0f, 4.0f});
+  auto add = ops::BiasAdd(root.WithOpName("add"), matmul, bias);
+  auto relu = ops::Relu(root.WithOpName("relu"), add);
+  auto sum = ops::Sum(root.WithOpName("sum"), relu, 1);
+  auto mul = ops::Mul(root.WithOpName("mul"), relu, relu);
+  ops::_Retval(root.WithOpName("r0"), sum, 0);
+  ops::_Retval(root.WithOpName("r1"), mul, 1);
+  ops::_Retval(root.WithOpName("r2"), w, 2);
+
+  std::vector<int> result_groups;
+  TF_ASSERT_OK(Analyze(root, &result_groups));
+  EXPECT_EQ(std::vector<int>({0, 0, -1}), result_groups);
+}
+
+TEST_F(AnalyzeRowPaddingTest, ReshapeThatKeepsRows) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::_Arg(root.WithOpName("x"), DT_FLOAT, 0);
+  ops::_Arg(root.WithOpName("w"), DT_FLOAT, 1);
+  auto reshape = ops::Reshape(root.WithOpName("reshape"), x, {-1, 4, 4});
+  ops::_Retval(root.WithOpName("r0"), reshape, 0);
+
+  std::vector<int> result_groups;
+  TF_ASSERT_OK(Analyze(root, &result_groups));
+  EXPECT_EQ(std::vector<int>({0}), result_groups);
+}
+
+TEST_F(AnalyzeRowPaddingTest, ReductionOverRows) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::_Arg(root.WithOpName("x"), DT_FLOAT, 0);
+  ops::_Arg(root.WithOpName("w"), DT_FLOAT, 1);
+  auto mean = ops::Mean(root.WithOpName("mean"), x, 0);
+  ops::_Retval(root.WithOpName("r0"), mean, 0);
+
+  std::vector<int> result_groups;
+  EXPECT_TRUE(errors::IsUnimplemented(Analyze(root, &result_groups)));
+}
+
+TEST_F(AnalyzeRowPaddingTest, TransposedMatMul) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::_Arg(root.WithOpName("x"), DT_FLOAT, 0);
+  auto w = ops::_Arg(root.WithOpName("w"), DT_FLOAT, 1);
+  auto matmul = ops::MatMul(root.WithOpName("matmul"), w, x,
+                            ops::MatMul::TransposeA(true).TransposeB(true));
+  ops::_Retval(root.WithOpName("r0"), matmul, 0);
+
+  std::vector<int> result_groups;
+  EXPECT_TRUE(errors::IsUnimplemented(Analyze(root, &result_groups)));
+}
+
+TEST_F(AnalyzeRowPaddingTest, BroadcastOfRows) {
+  // [8, 16] + [64, 1, 1] broadcasts the rows of "x" into the second
+  // dimension of the sum.
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::_Arg(root.WithOpName("x"), DT_FLOAT, 0);
+  auto w = ops::_Arg(root.WithOpName("w"), DT_FLOAT, 1);
+  auto y = ops::Reshape(root.WithOpName("y"), w, {64, 1, 1});
+  auto add = ops::Add(root.WithOpName("add"), x, y);
+  ops::_Retval(root.WithOpName("r0"), add, 0);
+
+  std::vector<int> result_groups;
+  EXPECT_TRUE(errors::IsUnimplemented(Analyze(root, &result_groups)));
+}
+
+TEST_F(AnalyzeRowPaddingTest, RowsOfDifferentGroups) {
+  // The rows of "x" and "w" are both padded to 8, from different sizes.
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::_Arg(root.WithOpName("x"), DT_FLOAT, 0);
+  auto w = ops::_Arg(root.WithOpName("w"), DT_FLOAT, 1);
+  auto x_rows = ops::Sum(root.WithOpName("x_rows"), x, 1);
+  auto w_rows = ops::Sum(root.WithOpName("w_rows"), w, 1);
+  auto add = ops::Add(root.WithOpName("add"), x_rows, w_rows);
+  ops::_Retval(root.WithOpName("r0"), add, 0);
+  std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
+  TF_ASSERT_OK(root.ToGraph(graph.get()));
+
+  std::vector<int> result_groups;
+  EXPECT_TRUE(errors::IsUnimplemented(AnalyzeRowPadding(
+      *graph, TF_GRAPH_DEF_VERSION, {TensorShape({8, 16}), TensorShape({8, 4})},
+      {0, 1}, &result_groups)));
+}
+
+TEST_F(AnalyzeRowPaddingTest, ShapeOfPaddedValue) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::_Arg(root.WithOpName("x"), DT_FLOAT, 0);
+  ops::_Arg(root.WithOpName("w"), DT_FLOAT, 1);
+  auto shape = ops::Shape(root.WithOpName("shape"), x);
+  ops::_Retval(root.WithOpName("r0"), shape, 0);
+
+  std::vector<int> result_groups;
+  EXPECT_TRUE(errors::IsUnimplemented(Analyze(root, &result_groups)));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 
+#include <algorithm>
+#include <memory>
 #include <numeric>
 
 #include "tensorflow/compiler/tf2xla/dump_graph.h"
@@ -31,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/kernels/variable_ops.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/public/version.h"
@@ -38,8 +41,11 @@ limitations under the License.
 namespace tensorflow {
 
 XlaCompilationCache::XlaCompilationCache(xla::LocalClient* client,
-                                         DeviceType device_type)
-    : client_(client), device_type_(std::move(device_type)) {}
+                                         DeviceType device_type,
+                                         bool hlo_profile)
+    : client_(client),
+      device_type_(std::move(device_type)),
+      hlo_profile_(hlo_profile) {}
 XlaCompilationCache::~XlaCompilationCache() = default;
 
 string XlaCompilationCache::DebugString() {
@@ -93,30 +99,30 @@ uint64 XlaCompilationCache::Signature::Hash::operator()(
 
 Status XlaCompilationCache::BuildSignature(
     const NameAttrList& function, int num_constant_args,
-    const std::vector<OptionalTensor>& variable_args, OpKernelContext* ctx,
-    Signature* signature) {
+    const std::vector<OptionalTensor>& variable_args,
+    const std::vector<const Tensor*>& inputs, Signature* signature) {
   signature->name = Canonicalize(function.name(), AttrSlice(&function.attr()));
   signature->arg_values.resize(num_constant_args);
 
-  signature->arg_types.reserve(ctx->num_inputs() - num_constant_args);
+  signature->arg_types.reserve(inputs.size() - num_constant_args);
 
   // Inputs are in the order: constants, non-constants, resource variables.
   int input_num = 0;
   // Use the values of compile time constants in the signature->
   while (input_num < num_constant_args) {
-    signature->arg_values[input_num] = ctx->input(input_num);
+    signature->arg_values[input_num] = *inputs[input_num];
     ++input_num;
   }
   // Add the types and shapes of the remaining arguments.
-  while (input_num < ctx->num_inputs() - variable_args.size()) {
-    signature->arg_types.emplace_back(ctx->input_dtype(input_num),
-                                      ctx->input(input_num).shape());
+  while (input_num < inputs.size() - variable_args.size()) {
+    signature->arg_types.emplace_back(inputs[input_num]->dtype(),
+                                      inputs[input_num]->shape());
     ++input_num;
   }
   // For variable signatures, use the type and shape of the variable's
   // current value.
   for (const OptionalTensor& variable : variable_args) {
-    TF_RET_CHECK(input_num < ctx->num_inputs());
+    TF_RET_CHECK(input_num < inputs.size());
     if (variable.present) {
       signature->arg_types.emplace_back(variable.value.dtype(),
                                         variable.value.shape());
@@ -134,16 +140,17 @@ namespace {
 // op. The first `num_constant_args` arguments must be host-memory Tensors.
 Status BuildArguments(int num_constant_args,
                       const std::vector<OptionalTensor>& variable_args,
-                      OpKernelContext* ctx,
+                      const std::vector<const Tensor*>& inputs,
                       std::vector<XlaCompiler::Argument>* args) {
-  args->resize(ctx->num_inputs());
+  const int num_inputs = inputs.size();
+  args->resize(num_inputs);
 
   int input_num = 0;
 
   // Handles compile-time constants.
-  TF_RET_CHECK(num_constant_args <= ctx->num_inputs());
+  TF_RET_CHECK(num_constant_args <= num_inputs);
   while (input_num < num_constant_args) {
-    const Tensor& input = ctx->input(input_num);
+    const Tensor& input = *inputs[input_num];
     TF_RET_CHECK(input.dtype() != DT_RESOURCE);
     XlaCompiler::Argument& arg = (*args)[input_num];
     arg.kind = XlaCompiler::Argument::kConstant;
@@ -156,11 +163,10 @@ Status BuildArguments(int num_constant_args,
 
   // Handles the non-constant arguments.
   int num_variable_args = variable_args.size();
-  int num_nonconst_args =
-      ctx->num_inputs() - num_variable_args - num_constant_args;
+  int num_nonconst_args = num_inputs - num_variable_args - num_constant_args;
   TF_RET_CHECK(num_nonconst_args >= 0);
   while (input_num < num_constant_args + num_nonconst_args) {
-    const Tensor& input = ctx->input(input_num);
+    const Tensor& input = *inputs[input_num];
     TF_RET_CHECK(input.dtype() != DT_RESOURCE);
     XlaCompiler::Argument& arg = (*args)[input_num];
     if (input.NumElements() > 0) {
@@ -176,9 +182,9 @@ Status BuildArguments(int num_constant_args,
   }
 
   // Handles resource variables.
-  TF_RET_CHECK(input_num + num_variable_args == ctx->num_inputs());
+  TF_RET_CHECK(input_num + num_variable_args == num_inputs);
   for (int variable_id = 0; variable_id < num_variable_args; ++variable_id) {
-    const Tensor& input = ctx->input(input_num);
+    const Tensor& input = *inputs[input_num];
     TF_RET_CHECK(input.dtype() == DT_RESOURCE);
 
     XlaCompiler::Argument& arg = (*args)[input_num];
@@ -231,6 +237,7 @@ Status XlaCompilationCache::BuildExecutable(
   build_options.set_result_layout(result.xla_output_shape);
   build_options.set_has_hybrid_result(
       options.local_executable_has_hybrid_result);
+  build_options.set_hlo_profile(hlo_profile_);
 
   auto compile_result =
       client_->Compile(*result.computation, argument_layouts, build_options);
@@ -241,59 +248,57 @@ Status XlaCompilationCache::BuildExecutable(
   return Status::OK();
 }
 
+XlaCompilationCache::Entry* XlaCompilationCache::LookupOrCreateEntry(
+    const Signature& signature) {
+  // The outer lock protects the existence of the cache entry. It does not
+  // protect the contents of the cache entry.
+  mutex_lock lock(mu_);
+  std::unique_ptr<Entry>& e = cache_[signature];
+  if (!e) {
+    e.reset(new Entry);
+  }
+  return e.get();
+}
+
 Status XlaCompilationCache::Compile(
     const XlaCompiler::Options& options, const NameAttrList& function,
     int num_constant_args, const std::vector<OptionalTensor>& variable_args,
-    OpKernelContext* ctx,
+    const std::vector<const Tensor*>& inputs,
     const XlaCompiler::CompilationResult** compilation_result,
     xla::LocalExecutable** executable) {
   VLOG(1) << "XlaCompilationCache::Compile " << DebugString();
 
   if (VLOG_IS_ON(2)) {
-    VLOG(2) << "num_inputs=" << ctx->num_inputs()
+    VLOG(2) << "num_inputs=" << inputs.size()
             << " num_constant_args=" << num_constant_args
             << " num_variable_args=" << variable_args.size();
-    for (int i = 0; i < ctx->num_inputs(); i++) {
-      TensorShape shape = ctx->input(i).shape();
-      VLOG(2) << i << ": dtype=" << DataTypeString(ctx->input_dtype(i))
-              << " present=" << ctx->has_input(i)
-              << " shape=" << shape.DebugString();
+    for (int i = 0; i < inputs.size(); i++) {
+      VLOG(2) << i << ": dtype=" << DataTypeString(inputs[i]->dtype())
+              << " shape=" << inputs[i]->shape().DebugString();
     }
     for (const OptionalTensor& variable : variable_args) {
       VLOG(2) << "variable present=" << variable.present
               << " type=" << DataTypeString(variable.value.dtype())
               << " shape=" << variable.value.shape().DebugString();
     }
-    VLOG(2) << "num_outputs = " << ctx->num_outputs();
-    for (int i = 0; i < ctx->num_outputs(); i++) {
-      VLOG(2) << i << ": dtype=" << ctx->expected_output_dtype(i);
-    }
   }
 
-  TF_RET_CHECK(num_constant_args + variable_args.size() <= ctx->num_inputs());
+  TF_RET_CHECK(num_constant_args + variable_args.size() <= inputs.size());
 
   Signature signature;
   TF_RETURN_IF_ERROR(BuildSignature(function, num_constant_args, variable_args,
-                                    ctx, &signature));
+                                    inputs, &signature));
 
   VLOG(2) << "Signature: " << SignatureDebugString(signature);
-  // The outer lock protects the existence of the cache entry. It does not
-  // protect the contents of the cache entry.
-  Entry* entry;
-  {
-    mutex_lock lock(mu_);
-    // Find or create a cache entry.
-    std::unique_ptr<Entry>& e = cache_[signature];
-    if (!e) {
-      e.reset(new Entry);
-    }
-    entry = e.get();
-  }
+  Entry* entry = LookupOrCreateEntry(signature);
 
   // Acquire the cache entry lock and compile, if necessary.
   // TODO(phawkins): this locking will need to be restructured when we implement
   // cache eviction.
   mutex_lock entry_lock(entry->mu);
+  while (entry->compiling) {
+    entry->cv.wait(entry_lock);
+  }
   if (!entry->compiled) {
     VLOG(1) << "Compilation cache miss for signature: "
             << SignatureDebugString(signature);
@@ -301,7 +306,7 @@ Status XlaCompilationCache::Compile(
     // a long time.)
     std::vector<XlaCompiler::Argument> args;
     TF_RETURN_IF_ERROR(
-        BuildArguments(num_constant_args, variable_args, ctx, &args));
+        BuildArguments(num_constant_args, variable_args, inputs, &args));
 
     XlaCompiler compiler(options);
     entry->compiled = true;
@@ -322,4 +327,97 @@ Status XlaCompilationCache::Compile(
   return status;
 }
 
+namespace {
+
+// The threads that run the compilations of CompileAsync, which are shared by
+// all the caches. They are few, so that the compilations do not slow down
+// the steps that run meanwhile.
+thread::ThreadPool* AsyncCompilationThreadPool() {
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "xla_async_compilation",
+      std::max(1, std::min(4, port::NumSchedulableCPUs() / 4)));
+  return pool;
+}
+
+}  // namespace
+
+Status XlaCompilationCache::CompileAsync(
+    const XlaCompiler::Options& options, const NameAttrList& function,
+    int num_constant_args, const std::vector<OptionalTensor>& variable_args,
+    const std::vector<const Tensor*>& inputs,
+    const XlaCompiler::CompilationResult** compilation_result,
+    xla::LocalExecutable** executable) {
+  TF_RET_CHECK(num_constant_args + variable_args.size() <= inputs.size());
+
+  Signature signature;
+  TF_RETURN_IF_ERROR(BuildSignature(function, num_constant_args, variable_args,
+                                    inputs, &signature));
+  Entry* entry = LookupOrCreateEntry(signature);
+
+  *compilation_result = nullptr;
+  *executable = nullptr;
+  {
+    mutex_lock entry_lock(entry->mu);
+    if (entry->compiled) {
+      // Compile may have compiled the entry without building its executable.
+      if (entry->compilation_status.ok() && entry->executable == nullptr) {
+        entry->compilation_status = BuildExecutable(
+            options, entry->compilation_result, &entry->executable);
+      }
+      *compilation_result = &entry->compilation_result;
+      *executable = entry->executable.get();
+      return entry->compilation_status;
+    }
+    if (entry->compiling) {
+      return Status::OK();
+    }
+    entry->compiling = true;
+  }
+
+  std::vector<XlaCompiler::Argument> args;
+  Status status =
+      BuildArguments(num_constant_args, variable_args, inputs, &args);
+  if (!status.ok()) {
+    {
+      mutex_lock entry_lock(entry->mu);
+      entry->compiling = false;
+    }
+    entry->cv.notify_all();
+    return status;
+  }
+  VLOG(1) << "Compiling in the background for signature: "
+          << SignatureDebugString(signature);
+
+  // The compilation may outlive the function library of `options`, so it uses
+  // a copy of it, and holds a reference to the cache.
+  std::shared_ptr<FunctionLibraryDefinition> flib_def(
+      new FunctionLibraryDefinition(*options.flib_def));
+  XlaCompiler::Options background_options = options;
+  background_options.flib_def = flib_def.get();
+  Ref();
+  AsyncCompilationThreadPool()->Schedule([this, entry, background_options,
+                                          flib_def, function, args]() {
+    XlaCompiler::CompilationResult result;
+    std::unique_ptr<xla::LocalExecutable> executable;
+    XlaCompiler compiler(background_options);
+    Status status = compiler.CompileFunction(XlaCompiler::CompileOptions(),
+                                             function, args, &result);
+    if (status.ok()) {
+      status = BuildExecutable(background_options, result, &executable);
+    }
+    VLOG(1) << "Background compilation done: " << status;
+    {
+      mutex_lock entry_lock(entry->mu);
+      entry->compilation_status = status;
+      entry->compilation_result = std::move(result);
+      entry->executable = std::move(executable);
+      entry->compiled = true;
+      entry->compiling = false;
+    }
+    entry->cv.notify_all();
+    Unref();
+  });
+  return Status::OK();
+}
+
 }  // namespace tensorflow
@@ -46,7 +46,10 @@ struct OptionalTensor {
 // bound.
 class XlaCompilationCache : public ResourceBase {
  public:
-  XlaCompilationCache(xla::LocalClient* client, DeviceType device_type);
+  // If `hlo_profile` is true, the executables are instrumented to count the
+  // cycles taken by each of their HLO instructions.
+  XlaCompilationCache(xla::LocalClient* client, DeviceType device_type,
+                      bool hlo_profile = false);
   ~XlaCompilationCache() override;
 
   // Compiles a function into a XlaCompiler::CompilationResult that can be used
@@ -55,7 +58,8 @@ class XlaCompilationCache : public ResourceBase {
   // `num_constant_args` is the number of compile-time constant arguments to
   // `function`. `variable_args` is a snapshot of the current values of the
   // resource variable arguments to `function`; uninitialized variables are
-  // represented by an absent OptionalTensor.
+  // represented by an absent OptionalTensor. `inputs` are the inputs of the
+  // _XlaLaunch op, whose leading dimensions may have been padded.
   // The result of compilation is written to `*compilation_result`, which must
   // be non-null. If `executable` is non-null, also builds an
   // xla::LocalExecutable and sets `executable to point to it. The resulting
@@ -64,10 +68,24 @@ class XlaCompilationCache : public ResourceBase {
   Status Compile(const XlaCompiler::Options& options,
                  const NameAttrList& function, int num_constant_args,
                  const std::vector<OptionalTensor>& variable_args,
-                 OpKernelContext* ctx,
+                 const std::vector<const Tensor*>& inputs,
                  const XlaCompiler::CompilationResult** compilation_result,
                  xla::LocalExecutable** executable);
 
+  // Like Compile, but does not block on the compilation of a new signature:
+  // the first call for it starts compiling `function` and building its
+  // executable on a background thread, and returns with
+  // `*compilation_result` and `*executable` set to null, as do the calls
+  // while the compilation is in progress. The later calls return its result.
+  // Synchronous calls to Compile for the signature wait for the background
+  // compilation, rather than compiling it again.
+  Status CompileAsync(const XlaCompiler::Options& options,
+                      const NameAttrList& function, int num_constant_args,
+                      const std::vector<OptionalTensor>& variable_args,
+                      const std::vector<const Tensor*>& inputs,
+                      const XlaCompiler::CompilationResult** compilation_result,
+                      xla::LocalExecutable** executable);
+
   xla::LocalClient* client() const { return client_; }
   const DeviceType& device_type() const { return device_type_; }
 
@@ -82,6 +100,7 @@ class XlaCompilationCache : public ResourceBase {
 
   xla::LocalClient* const client_;
   const DeviceType device_type_;
+  const bool hlo_profile_;
 
   // Describes the types, shapes and any compile-time constant arguments
   // to a kernel. Key that uniquely identifies a compilation output.
@@ -105,7 +124,8 @@ class XlaCompilationCache : public ResourceBase {
   // Builds the signature for a compilation.
   Status BuildSignature(const NameAttrList& function, int num_constant_args,
                         const std::vector<OptionalTensor>& variable_args,
-                        OpKernelContext* ctx, Signature* signature);
+                        const std::vector<const Tensor*>& inputs,
+                        Signature* signature);
 
   // The value associated with a cache entry.
   struct Entry {
@@ -114,6 +134,11 @@ class XlaCompilationCache : public ResourceBase {
     // Have we tried compiling this entry?
     bool compiled = false;
 
+    // Is the entry being compiled by CompileAsync? `cv` is notified once it
+    // is compiled.
+    bool compiling GUARDED_BY(mu) = false;
+    condition_variable cv;
+
     // Did compilation succeed?
     Status compilation_status GUARDED_BY(mu);
 
@@ -125,6 +150,9 @@ class XlaCompilationCache : public ResourceBase {
     std::unique_ptr<xla::LocalExecutable> executable GUARDED_BY(mu);
   };
 
+  // Returns the cache entry of `signature`, which is created if needed.
+  Entry* LookupOrCreateEntry(const Signature& signature);
+
   mutex mu_;
   std::unordered_map<Signature, std::unique_ptr<Entry>, Signature::Hash> cache_
       GUARDED_BY(mu_);
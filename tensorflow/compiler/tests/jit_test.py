@@ -18,6 +18,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import time
+
 import numpy as np
 
 from tensorflow.contrib.compiler import jit
@@ -435,6 +437,90 @@ class XlaCompilationTest(test.TestCase):
     self.assertFalse(InLabels(labels, "Mul"))
     self.assertTrue(InLabels(labels, "_XlaLaunch"))
 
+  def testAsyncCompilation(self):
+    """Tests that the kernels run while the cluster compiles."""
+
+    g = ops.Graph()
+    with g.as_default():
+      x = array_ops.placeholder(dtypes.float32)
+      with jit_scope():
+        y = math_ops.tanh(x) * 2.0
+
+    cfg = config_pb2.ConfigProto(graph_options=config_pb2.GraphOptions(
+        optimizer_options=config_pb2.OptimizerOptions(
+            jit_async_compilation=True)))
+    with session_lib.Session(graph=g, config=cfg) as sess:
+
+      def _Run():
+        run_metadata = config_pb2.RunMetadata()
+        result = sess.run(y, {x: np.float32(0.5)},
+                          run_metadata=run_metadata,
+                          options=config_pb2.RunOptions(
+                              trace_level=config_pb2.RunOptions.FULL_TRACE))
+        self.assertAllClose(result, np.float32(2 * np.tanh(0.5)))
+        return RunMetadataLabels(run_metadata)
+
+      # The first run starts the compilation and runs the TensorFlow kernels.
+      labels = _Run()
+      self.assertTrue(InLabels(labels, "_XlaLaunch"))
+      self.assertTrue(InLabels(labels, "Tanh"))
+
+      # The later runs use the compiled kernel once it is ready.
+      for _ in range(100):
+        labels = _Run()
+        if not InLabels(labels, "Tanh"):
+          break
+        time.sleep(0.1)
+      self.assertTrue(InLabels(labels, "_XlaLaunch"))
+      self.assertFalse(InLabels(labels, "Tanh"))
+
+  def testHloProfile(self):
+    """Tests that traced runs report the cycles of the HLO instructions."""
+
+    g = ops.Graph()
+    with g.as_default():
+      x = array_ops.placeholder(dtypes.float32)
+      with jit_scope():
+        y = math_ops.tanh(x) * 2.0
+
+    with session_lib.Session(graph=g) as sess:
+      value = np.ones([64, 64], dtype=np.float32)
+      run_metadata = config_pb2.RunMetadata()
+      result = sess.run(y, {x: value},
+                        run_metadata=run_metadata,
+                        options=config_pb2.RunOptions(
+                            trace_level=config_pb2.RunOptions.FULL_TRACE))
+      self.assertAllClose(result, 2 * np.tanh(value))
+      labels = RunMetadataLabels(run_metadata)
+      self.assertTrue(InLabels(labels, "_XlaLaunch"))
+      self.assertTrue(InLabels(labels, " cycles)"))
+
+      # The untraced runs use executables without the instrumentation.
+      result = sess.run(y, {x: value})
+      self.assertAllClose(result, 2 * np.tanh(value))
+
+  def testShapeBucketing(self):
+    """Tests that the padded rows are removed from the results."""
+
+    g = ops.Graph()
+    with g.as_default():
+      x = array_ops.placeholder(dtypes.float32, shape=[None, 4])
+      w = constant_op.constant(np.ones([4, 3], dtype=np.float32))
+      with jit_scope():
+        y = math_ops.tanh(math_ops.matmul(x, w)) * 2.0
+
+    cfg = config_pb2.ConfigProto(graph_options=config_pb2.GraphOptions(
+        optimizer_options=config_pb2.OptimizerOptions(
+            jit_shape_bucketing=True, jit_bucket_boundaries=[4, 16])))
+    with session_lib.Session(graph=g, config=cfg) as sess:
+      # 3 rows are padded to 4 and 11 rows to 16, and 20 rows, which are
+      # above the largest bucket, are not padded.
+      for rows in [3, 4, 11, 20]:
+        value = np.arange(rows * 4, dtype=np.float32).reshape([rows, 4]) / 50
+        result = sess.run(y, {x: value})
+        self.assertAllClose(result, 2 * np.tanh(np.matmul(value, np.ones(
+            [4, 3], dtype=np.float32))))
+
 
 if __name__ == "__main__":
   test.main()
@@ -66,6 +66,14 @@ bool ExecutableBuildOptions::has_hybrid_result() const {
   return has_hybrid_result_;
 }
 
+ExecutableBuildOptions& ExecutableBuildOptions::set_hlo_profile(
+    bool hlo_profile) {
+  hlo_profile_ = hlo_profile;
+  return *this;
+}
+
+bool ExecutableBuildOptions::hlo_profile() const { return hlo_profile_; }
+
 namespace {
 StatusOr<Backend::StreamPtr> BorrowStreamForDevice(int device_ordinal,
                                                    Backend* backend) {
@@ -291,7 +299,8 @@ StatusOr<std::unique_ptr<LocalExecutable>> LocalClient::Compile(
   TF_ASSIGN_OR_RETURN(std::unique_ptr<Executable> executable,
                       local_service_->CompileExecutable(
                           computation.handle(), argument_layouts,
-                          options.result_layout(), device_ordinal));
+                          options.result_layout(), device_ordinal,
+                          options.hlo_profile()));
   return WrapUnique(new LocalExecutable(std::move(executable),
                                         local_service_->mutable_backend(),
                                         device_ordinal, options));
@@ -67,12 +67,20 @@ class ExecutableBuildOptions {
   ExecutableBuildOptions& set_has_hybrid_result(bool has_hybrid_result);
   bool has_hybrid_result() const;
 
+  // If set, the executable is instrumented to count the cycles taken by each
+  // HLO instruction, whether or not the xla_hlo_profile flag is set.  The
+  // counts of a run are returned through
+  // ExecutableRunOptions::set_hlo_execution_profile.
+  ExecutableBuildOptions& set_hlo_profile(bool hlo_profile);
+  bool hlo_profile() const;
+
  private:
   perftools::gputools::Platform* platform_ = nullptr;
   int device_ordinal_ = -1;
   Shape result_layout_;
   bool result_layout_set_ = false;
   bool has_hybrid_result_ = true;
+  bool hlo_profile_ = false;
 };
 
 class LocalExecutable {
@@ -77,6 +77,16 @@ ExecutionProfile* ExecutableRunOptions::execution_profile() const {
   return execution_profile_;
 }
 
+ExecutableRunOptions& ExecutableRunOptions::set_hlo_execution_profile(
+    HloExecutionProfile* profile) {
+  hlo_execution_profile_ = profile;
+  return *this;
+}
+
+HloExecutionProfile* ExecutableRunOptions::hlo_execution_profile() const {
+  return hlo_execution_profile_;
+}
+
 ExecutableRunOptions& ExecutableRunOptions::set_device_assignment(
     DeviceAssignment* device_assignment) {
   device_assignment_ = device_assignment;
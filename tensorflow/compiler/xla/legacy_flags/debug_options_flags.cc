@@ -184,6 +184,16 @@ void AllocateFlags() {
            "Eliminate implicit broadcasts when lowering user "
            "computations to HLO instructions; use explicit "
            "broadcast instead."),
+       tensorflow::Flag("xla_compilation_cache_dir",
+                        flag_values->mutable_xla_compilation_cache_dir(),
+                        "Cache the code generated by the CPU and GPU backends "
+                        "in this directory; empty disables the cache."),
+       tensorflow::Flag(
+           "xla_scheduler_search_budget",
+           int32_setter_for(&DebugOptions::set_xla_scheduler_search_budget),
+           flag_values->xla_scheduler_search_budget(),
+           "Number of additional instruction orderings the memory-minimizing "
+           "scheduler may simulate per computation; 0 disables the search."),
        tensorflow::Flag(
            "xla_cpu_multi_thread_eigen",
            bool_setter_for(&DebugOptions::set_xla_cpu_multi_thread_eigen),
@@ -205,6 +215,13 @@ void AllocateFlags() {
            bool_setter_for(&DebugOptions::set_xla_gpu_disable_multi_streaming),
            flag_values->xla_gpu_disable_multi_streaming(),
            "If true, multi-streaming in the GPU backend is disabled."),
+       tensorflow::Flag(
+           "xla_gpu_minimize_memory_across_streams",
+           bool_setter_for(
+               &DebugOptions::set_xla_gpu_minimize_memory_across_streams),
+           flag_values->xla_gpu_minimize_memory_across_streams(),
+           "If true, the GPU backend orders the kernel launches on several "
+           "streams to minimize memory rather than to increase concurrency."),
        tensorflow::Flag(
            "xla_dump_hlo_proto_to",
            flag_values->mutable_xla_dump_hlo_proto_to(),
@@ -25,11 +25,13 @@ limitations under the License.
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/ExecutionEngine/ObjectMemoryBuffer.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/MC/MCContext.h"
 #include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/Error.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/IPO.h"
@@ -107,6 +109,31 @@ class FilteredPassManager : public llvm::legacy::PassManager {
 
 llvm::object::OwningBinary<llvm::object::ObjectFile> CompilerFunctor::
 operator()(llvm::Module& module) const {
+  // The hooks must see the IR of every compilation, so they bypass the cache.
+  const bool use_cache = (cache_ != nullptr || memory_cache_ != nullptr) &&
+                         !pre_optimization_hook_ && !post_optimization_hook_;
+  string cache_key;
+  if (use_cache) {
+    cache_key = CacheKey(module);
+    string cached_object;
+    if (LookupCachedObject(cache_key, &cached_object)) {
+      std::unique_ptr<llvm::MemoryBuffer> memory_buffer(
+          new llvm::ObjectMemoryBuffer(llvm::SmallVector<char, 0>(
+              cached_object.begin(), cached_object.end())));
+      llvm::Expected<std::unique_ptr<llvm::object::ObjectFile>>
+          object_file_or_error = llvm::object::ObjectFile::createObjectFile(
+              memory_buffer->getMemBufferRef());
+      if (object_file_or_error) {
+        VLOG(1) << "Using cached object file of " << module.getName().str();
+        return llvm::object::OwningBinary<llvm::object::ObjectFile>(
+            std::move(object_file_or_error.get()), std::move(memory_buffer));
+      }
+      llvm::consumeError(object_file_or_error.takeError());
+      LOG(WARNING) << "Ignoring cached object file of "
+                   << module.getName().str() << ", which failed to parse";
+    }
+  }
+
   FilteredPassManager module_passes(disable_expensive_passes_);
   FilteredFunctionPassManager function_passes(&module,
                                               disable_expensive_passes_);
@@ -168,6 +195,16 @@ operator()(llvm::Module& module) const {
   target_machine_->addPassesToEmitMC(codegen_passes, mc_context, ostream);
   codegen_passes.run(module);
 
+  if (use_cache) {
+    const string object(stream_buffer.data(), stream_buffer.size());
+    if (memory_cache_ != nullptr) {
+      memory_cache_->Store(cache_key, object);
+    }
+    if (cache_ != nullptr) {
+      cache_->Store(cache_key, object);
+    }
+  }
+
   // Construct ObjectFile from machine code buffer.
   std::unique_ptr<llvm::MemoryBuffer> memory_buffer(
       new llvm::ObjectMemoryBuffer(std::move(stream_buffer)));
@@ -192,6 +229,37 @@ operator()(llvm::Module& module) const {
       std::move(object_file), std::move(memory_buffer));
 }
 
+string CompilerFunctor::CacheKey(const llvm::Module& module) const {
+  // The bitcode records the version of LLVM that produced it, and the
+  // version of this key format is bumped whenever the code generation
+  // changes outside of LLVM.
+  string key = "xla_cpu_object_v1";
+  llvm::raw_string_ostream stream(key);
+  stream << '\0' << target_machine_->getTargetTriple().str() << '\0'
+         << target_machine_->getTargetCPU() << '\0'
+         << target_machine_->getTargetFeatureString() << '\0' << opt_level_
+         << optimize_for_size_ << enable_fast_math_ << disable_expensive_passes_
+         << available_intrinsics_.sse_intrinsics
+         << available_intrinsics_.avx_intrinsics
+         << available_intrinsics_.neon_intrinsics << '\0';
+  llvm::WriteBitcodeToFile(&module, stream);
+  return stream.str();
+}
+
+bool CompilerFunctor::LookupCachedObject(const string& key,
+                                         string* object) const {
+  if (memory_cache_ != nullptr && memory_cache_->Lookup(key, object)) {
+    return true;
+  }
+  if (cache_ != nullptr && cache_->Lookup(key, object)) {
+    if (memory_cache_ != nullptr) {
+      memory_cache_->Store(key, *object);
+    }
+    return true;
+  }
+  return false;
+}
+
 namespace {
 // Returns the set of vectorized library functions supported for the target.
 std::vector<llvm::VecDesc> VectorFunctionsForTargetLibraryInfoImpl(
@@ -21,7 +21,10 @@ limitations under the License.
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Target/TargetMachine.h"
 #include "tensorflow/compiler/xla/service/cpu/disassembler.h"
+#include "tensorflow/compiler/xla/service/disk_compilation_cache.h"
 #include "tensorflow/compiler/xla/service/llvm_compiler.h"
+#include "tensorflow/compiler/xla/service/memory_compilation_cache.h"
+#include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -41,13 +44,19 @@ class CompilerFunctor {
   // Returns a VectorIntrinsics where all intrinsics are available.
   static VectorIntrinsics AllIntrinsics();
 
+  // If |memory_cache| or |cache| is not null, the object files are looked up
+  // in and stored to them, unless there are module hooks, which must see the
+  // IR of every compilation. The object files found in |cache| are also
+  // stored to |memory_cache|.
   explicit CompilerFunctor(
       llvm::TargetMachine* target_machine, const Disassembler* disassembler,
       int opt_level, bool optimize_for_size, bool enable_fast_math,
       bool disable_expensive_passes,
       const VectorIntrinsics& available_intrinsics,
       LLVMCompiler::ModuleHook pre_optimization_hook = nullptr,
-      LLVMCompiler::ModuleHook post_optimization_hook = nullptr)
+      LLVMCompiler::ModuleHook post_optimization_hook = nullptr,
+      const DiskCompilationCache* cache = nullptr,
+      MemoryCompilationCache* memory_cache = nullptr)
       : target_machine_(target_machine),
         disassembler_(CHECK_NOTNULL(disassembler)),
         opt_level_(opt_level),
@@ -56,7 +65,9 @@ class CompilerFunctor {
         disable_expensive_passes_(disable_expensive_passes),
         available_intrinsics_(available_intrinsics),
         pre_optimization_hook_(pre_optimization_hook),
-        post_optimization_hook_(post_optimization_hook) {}
+        post_optimization_hook_(post_optimization_hook),
+        cache_(cache),
+        memory_cache_(memory_cache) {}
 
   // Compile a Module to an ObjectFile.
   llvm::object::OwningBinary<llvm::object::ObjectFile> operator()(
@@ -72,6 +83,14 @@ class CompilerFunctor {
                              llvm::legacy::FunctionPassManager* function_passes,
                              unsigned opt_level, unsigned size_level) const;
 
+  // Returns the key of the object file of the unoptimized |module| in the
+  // cache, which covers the module and every option of its compilation.
+  string CacheKey(const llvm::Module& module) const;
+
+  // Returns true and sets |object| to the object file stored for |key| in
+  // the memory cache or on disk.
+  bool LookupCachedObject(const string& key, string* object) const;
+
   llvm::TargetMachine* target_machine_;
   const Disassembler* disassembler_;
   const unsigned opt_level_;
@@ -81,6 +100,8 @@ class CompilerFunctor {
   const VectorIntrinsics available_intrinsics_;
   LLVMCompiler::ModuleHook pre_optimization_hook_;
   LLVMCompiler::ModuleHook post_optimization_hook_;
+  const DiskCompilationCache* cache_;
+  MemoryCompilationCache* memory_cache_;
 };
 
 }  // namespace cpu
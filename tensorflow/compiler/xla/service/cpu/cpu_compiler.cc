@@ -244,7 +244,8 @@ class CollectProfileCandidates : public DfsHloVisitorWithDefault {
 };
 }  // namespace
 
-Status CpuCompiler::RunHloPasses(HloModule* module, bool is_aot_compile) {
+Status CpuCompiler::RunHloPasses(HloModule* module, bool is_aot_compile,
+                                 int64 aot_max_parallelism) {
   // Optimization pipeline.
   HloPassPipeline pipeline("CPU");
   pipeline.AddInvariantChecker<HloVerifier>(ShapeSizeBytesFunction());
@@ -306,19 +307,24 @@ Status CpuCompiler::RunHloPasses(HloModule* module, bool is_aot_compile) {
       /*enable_dot_simplification=*/false);
   pipeline.AddPass<HloCSE>(/*is_layout_sensitive=*/true);
   // Outline ops in the entry computation into calls to subcomputations.
-  const int max_parallelism =
+  int max_parallelism =
       module->config().intra_op_parallelism_threads() > 0
           ? module->config().intra_op_parallelism_threads()
           : tensorflow::port::NumSchedulableCPUs();
+  if (is_aot_compile) {
+    // The machine that runs AOT compiled code is not known, so its parallelism
+    // is given by the AOT compilation options.
+    max_parallelism = aot_max_parallelism;
+  }
   if (options::CpuParallelBackendRequested(module->config())) {
     pipeline.AddPass<ParallelizationPreparation>(max_parallelism,
                                                  ShapeSizeBytesFunction());
-  } else if (!is_aot_compile) {
+  } else if (max_parallelism > 1) {
     // Run ParallelTaskAssigner to assign parallel tasks to HLOs in module.
-    // Note this is not run for AOT because it would bring in thread pool
-    // and thread synchronization dependencies which would likely increase
-    // binary size (and most AOT applications are single-threaded).
-    // TODO(29630486) Support multi-threaded AOT.
+    // AOT compiles only run it when asked to, because the calls to the
+    // fork/join runtime it introduces bring in thread pool and thread
+    // synchronization dependencies which increase binary size (and most AOT
+    // applications are single-threaded).
     pipeline.AddPass<ParallelTaskAssigner>(max_parallelism,
                                            ShapeSizeBytesFunction(), module);
   }
@@ -445,17 +451,25 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::Compile(
   auto llvm_module =
       MakeUnique<llvm::Module>("__compute_module", *llvm_context);
 
+  ExternalConstantPool::Options constant_pool_options;
+  constant_pool_options.use_huge_pages =
+      options::ConstantsInHugePagesRequested(module->config());
+  constant_pool_options.replicate_per_numa_node =
+      options::ReplicateConstantsPerNumaNodeRequested(module->config());
   auto jit = MakeUnique<SimpleOrcJIT>(
       CompilerTargetOptions(module->config()),
       CodeGenOptLevel(module->config()),
       options::OptimizeForSizeRequested(module->config()),
       module->config().debug_options().xla_enable_fast_math(),
       module->config().debug_options().xla_llvm_disable_expensive_passes(),
-      pre_optimization_ir_hook, post_optimization_ir_hook);
+      pre_optimization_ir_hook, post_optimization_ir_hook,
+      module->config().debug_options().xla_compilation_cache_dir(),
+      constant_pool_options);
   llvm_module->setDataLayout(jit->data_layout());
   llvm_module->setTargetTriple(jit->target_triple().getTriple());
 
-  TF_RETURN_IF_ERROR(RunHloPasses(module.get(), /*is_aot_compile=*/false));
+  TF_RETURN_IF_ERROR(RunHloPasses(module.get(), /*is_aot_compile=*/false,
+                                  /*aot_max_parallelism=*/0));
 
   HloComputation* computation = module->entry_computation();
   std::unordered_map<const HloInstruction*, size_t> hlo_to_profile_idx;
@@ -756,7 +770,8 @@ CpuCompiler::CompileAheadOfTime(std::vector<std::unique_ptr<HloModule>> modules,
     VLOG(2) << "Before optimization:";
     XLA_VLOG_LINES(2, module->ToString());
 
-    TF_RETURN_IF_ERROR(RunHloPasses(module, /*is_aot_compile=*/true));
+    TF_RETURN_IF_ERROR(RunHloPasses(module, /*is_aot_compile=*/true,
+                                    options.max_parallelism()));
 
     VLOG(2) << "After optimization:";
     XLA_VLOG_LINES(2, module->ToString());
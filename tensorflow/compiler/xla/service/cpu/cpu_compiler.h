@@ -66,12 +66,21 @@ class CpuAotCompilationOptions : public AotCompilationOptions {
   // The relocation model used for compilation.
   RelocationModel relocation_model() const { return relocation_model_; }
 
+  // The maximum number of parallel tasks into which the compiled code may
+  // partition an HLO. Above 1, the partitions run on the intra-op thread pool
+  // of the ExecutableRunOptions, or one after the other if it has none.
+  int64 max_parallelism() const { return max_parallelism_; }
+  void set_max_parallelism(int64 max_parallelism) {
+    max_parallelism_ = max_parallelism;
+  }
+
  private:
   const string triple_;
   const string cpu_name_;
   const string features_;
   const string entry_point_name_;
   const RelocationModel relocation_model_;
+  int64 max_parallelism_ = 1;
 };
 
 class CpuAotCompilationResult : public AotCompilationResult {
@@ -132,7 +141,10 @@ class CpuCompiler : public LLVMCompiler {
 
   // Runs the HLO passes which are necessary for both optimizations and
   // correctness.
-  Status RunHloPasses(HloModule* module, bool is_aot_compile);
+  // Runs the HLO passes of "module". The HLOs of an ahead-of-time compiled
+  // module are assigned at most "aot_max_parallelism" parallel tasks.
+  Status RunHloPasses(HloModule* module, bool is_aot_compile,
+                      int64 aot_max_parallelism);
 
   TF_DISALLOW_COPY_AND_ASSIGN(CpuCompiler);
 };
@@ -20,6 +20,10 @@ namespace {
 const char* const kXlaParallelCpuOption = "xla_cpu_parallel";
 const char* const kXlaOptimizeForSizeCpuOption = "xla_cpu_optimize_for_size";
 const char* const kXlaDisableVectorizedReduce = "xla_disable_vectorized_reduce";
+const char* const kXlaDisableTiledGemm = "xla_cpu_disable_tiled_gemm";
+const char* const kXlaConstantsInHugePages = "xla_cpu_constants_in_huge_pages";
+const char* const kXlaReplicateConstantsPerNumaNode =
+    "xla_cpu_replicate_constants_per_numa_node";
 
 }  // namespace
 
@@ -45,6 +49,24 @@ bool VectorizedReduceDisabled(const HloModuleConfig& config) {
   return extra_options_map.count(kXlaOptimizeForSizeCpuOption) > 0;
 }
 
+bool TiledGemmDisabled(const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  return extra_options_map.count(kXlaDisableTiledGemm) > 0;
+}
+
+bool ConstantsInHugePagesRequested(const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  return extra_options_map.count(kXlaConstantsInHugePages) > 0;
+}
+
+bool ReplicateConstantsPerNumaNodeRequested(const HloModuleConfig& config) {
+  const auto& extra_options_map =
+      config.debug_options().xla_backend_extra_options();
+  return extra_options_map.count(kXlaReplicateConstantsPerNumaNode) > 0;
+}
+
 }  // namespace options
 }  // namespace cpu
 }  // namespace xla
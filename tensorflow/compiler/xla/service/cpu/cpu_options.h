@@ -27,6 +27,9 @@ namespace options {
 bool CpuParallelBackendRequested(const HloModuleConfig& config);
 bool OptimizeForSizeRequested(const HloModuleConfig& config);
 bool VectorizedReduceDisabled(const HloModuleConfig& config);
+bool TiledGemmDisabled(const HloModuleConfig& config);
+bool ConstantsInHugePagesRequested(const HloModuleConfig& config);
+bool ReplicateConstantsPerNumaNodeRequested(const HloModuleConfig& config);
 
 }  // namespace options
 }  // namespace cpu
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace xla {
@@ -53,6 +54,7 @@ extern const char* const kReleaseOutfeedBufferAfterPopulationSymbolName =
     "__xla_cpu_runtime_ReleaseOutfeedBufferAfterPopulation";
 extern const char* const kParallelForkJoinSymbolName =
     "__xla_cpu_runtime_ParallelForkJoin";
+extern const char* const kNUMANodeSymbolName = "__xla_cpu_runtime_NUMANode";
 
 extern const char* const kXlaCpuRuntimeSymbolNamePrefix = "__xla_cpu_runtime_";
 }  // namespace runtime
@@ -136,3 +138,8 @@ void __xla_cpu_runtime_ReleaseOutfeedBufferAfterPopulation(
   xfeed->outfeed()->ReleaseCurrentBuffer(buffer_length, buffer_ptr,
                                          std::move(shape));
 }
+
+xla::int32 __xla_cpu_runtime_NUMANode(xla::int32 num_nodes) {
+  const int node = tensorflow::port::NUMAGetThreadNodeAffinity();
+  return node >= 0 && node < num_nodes ? node : 0;
+}
@@ -52,6 +52,7 @@ extern const char* const kReleaseInfeedBufferAfterDequeueSymbolName;
 extern const char* const kAcquireOutfeedBufferForPopulationSymbolName;
 extern const char* const kReleaseOutfeedBufferAfterPopulationSymbolName;
 extern const char* const kParallelForkJoinSymbolName;
+extern const char* const kNUMANodeSymbolName;
 
 // All symbol names for XLA CPU runtime functions need to start with this
 // prefix.
@@ -114,6 +115,11 @@ extern void __xla_cpu_runtime_ReleaseOutfeedBufferAfterPopulation(
     xla::int32 buffer_length, void* buffer_ptr, const void* shape_ptr,
     xla::int32 shape_length);
 
+// Returns the NUMA node the calling thread is bound to, if it is one of the
+// first num_nodes nodes, and 0 otherwise.  Used to pick the copy of a constant
+// replicated per NUMA node.
+extern xla::int32 __xla_cpu_runtime_NUMANode(xla::int32 num_nodes);
+
 }  // extern "C"
 
 #endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CPU_RUNTIME_H_
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -22,6 +23,7 @@ limitations under the License.
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Value.h"
+#include "tensorflow/compiler/xla/service/cpu/cpu_options.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
@@ -38,6 +40,25 @@ using llvm_ir::SetToFirstInsertPoint;
 
 namespace cpu {
 
+namespace {
+
+// The tile computed by each iteration of the tiled matrix multiply: 4 rows of
+// 2 vectors, whose 8 accumulators and the 2 vectors of the RHS fit in the 16
+// vector registers of SSE and AVX.
+const int64 kTileRows = 4;
+const int64 kTileVectors = 2;
+
+// Unlike Eigen, the tiled matrix multiply does not pack its operands, and reads
+// the whole RHS once per row tile.  So we only use it when the RHS fits in a
+// typical L2 cache.
+const int64 kMaxTiledGemmRhsBytes = 512 * 1024;
+
+// Products that are larger than this are sharded across threads by Eigen if it
+// is allowed to use several threads, which pays for the call into the runtime.
+const int64 kMaxTiledGemmMultiThreadedMacs = 16 * 1024 * 1024;
+
+}  // namespace
+
 DotOpEmitter::DotOpEmitter(const HloInstruction& dot, bool transpose_lhs,
                            bool transpose_rhs,
                            const llvm_ir::IrArray& target_array,
@@ -45,7 +66,8 @@ DotOpEmitter::DotOpEmitter(const HloInstruction& dot, bool transpose_lhs,
                            const llvm_ir::IrArray& rhs_array,
                            llvm::Value* executable_run_options_value,
                            llvm::IRBuilder<>* ir_builder,
-                           const HloModuleConfig& hlo_module_config)
+                           const HloModuleConfig& hlo_module_config,
+                           int vector_register_byte_size)
     : dot_(dot),
       transpose_lhs_(transpose_lhs),
       transpose_rhs_(transpose_rhs),
@@ -54,19 +76,21 @@ DotOpEmitter::DotOpEmitter(const HloInstruction& dot, bool transpose_lhs,
       rhs_array_(rhs_array),
       executable_run_options_value_(executable_run_options_value),
       ir_builder_(ir_builder),
-      hlo_module_config_(hlo_module_config) {}
+      hlo_module_config_(hlo_module_config),
+      vector_register_byte_size_(vector_register_byte_size) {}
 
 /* static */ tensorflow::Status DotOpEmitter::EmitDotOperation(
     const HloInstruction& dot, bool transpose_lhs, bool transpose_rhs,
     const llvm_ir::IrArray& target_array, const llvm_ir::IrArray& lhs_array,
     const llvm_ir::IrArray& rhs_array,
     llvm::Value* executable_run_options_value, llvm::IRBuilder<>* ir_builder,
-    const HloModuleConfig& hlo_module_config) {
+    const HloModuleConfig& hlo_module_config, int vector_register_byte_size) {
   PrimitiveType type = target_array.GetShape().element_type();
   TF_RET_CHECK(F32 == type || F64 == type || C64 == type);
   DotOpEmitter dot_emitter(dot, transpose_lhs, transpose_rhs, target_array,
                            lhs_array, rhs_array, executable_run_options_value,
-                           ir_builder, hlo_module_config);
+                           ir_builder, hlo_module_config,
+                           vector_register_byte_size);
   return dot_emitter.Emit();
 }
 
@@ -105,6 +129,10 @@ tensorflow::Status DotOpEmitter::Emit() {
     return EmitScalarDot();
   }
 
+  if (EmitTiledGemm()) {
+    return tensorflow::Status::OK();
+  }
+
   if (PotentiallyImplementedAsEigenDot(dot_)) {
     return EmitCallToRuntime();
   }
@@ -248,6 +276,188 @@ tensorflow::Status DotOpEmitter::Emit() {
   return tensorflow::Status::OK();
 }
 
+bool DotOpEmitter::MatrixOperand::RowsAreContiguous() const {
+  return LayoutUtil::Minor(array->GetShape().layout(), 0) ==
+         (transposed ? 0 : 1);
+}
+
+llvm::Value* DotOpEmitter::MatrixOperand::EmitElementAddress(
+    llvm::Value* row, llvm::Value* column,
+    llvm::IRBuilder<>* ir_builder) const {
+  llvm_ir::IrArray::Index index(2);
+  index[transposed ? 1 : 0] = row;
+  index[transposed ? 0 : 1] = column;
+  return array->EmitArrayElementAddress(index, ir_builder);
+}
+
+bool DotOpEmitter::EmitTiledGemm() {
+  const Shape& lhs_shape = lhs_array_.GetShape();
+  const Shape& rhs_shape = rhs_array_.GetShape();
+  if (options::TiledGemmDisabled(hlo_module_config_) ||
+      ShapeUtil::Rank(lhs_shape) != 2 || ShapeUtil::Rank(rhs_shape) != 2 ||
+      ShapeUtil::ElementIsComplex(lhs_shape)) {
+    return false;
+  }
+
+  int64 m = lhs_shape.dimensions(transpose_lhs_ ? 1 : 0);
+  int64 k = lhs_shape.dimensions(transpose_lhs_ ? 0 : 1);
+  int64 n = rhs_shape.dimensions(transpose_rhs_ ? 0 : 1);
+
+  // Matrix-vector products are left to the reduction loop below, which LLVM
+  // vectorizes well.
+  if (m <= 1 || n <= 1) {
+    return false;
+  }
+
+  const PrimitiveType type = target_array_.GetShape().element_type();
+  const int64 element_size = ShapeUtil::ByteSizeOfPrimitiveType(type);
+  const bool multi_threaded_eigen =
+      hlo_module_config_.debug_options().xla_cpu_multi_thread_eigen();
+  if (k * n * element_size > kMaxTiledGemmRhsBytes ||
+      (multi_threaded_eigen && m * n * k > kMaxTiledGemmMultiThreadedMacs)) {
+    return false;
+  }
+
+  // The tiles are vectorized along the rows of the RHS and the target.  If the
+  // columns of the target are contiguous instead, we compute its transpose:
+  //
+  //   (A x B)^T = B^T x A^T
+  MatrixOperand lhs = {&lhs_array_, transpose_lhs_};
+  MatrixOperand rhs = {&rhs_array_, transpose_rhs_};
+  MatrixOperand target = {&target_array_, /*transposed=*/false};
+  if (!target.RowsAreContiguous()) {
+    std::swap(lhs, rhs);
+    std::swap(m, n);
+    lhs.transposed = !lhs.transposed;
+    rhs.transposed = !rhs.transposed;
+    target.transposed = true;
+  }
+  if (!target.RowsAreContiguous() || !rhs.RowsAreContiguous()) {
+    return false;
+  }
+
+  VLOG(2) << "Emitting tiled matrix multiply for " << dot_.ToString();
+  const int64 vector_width =
+      std::max<int64>(1, vector_register_byte_size_ / element_size);
+  const int64 tile_columns = kTileVectors * vector_width;
+  const int64 m_tiles_end = m / kTileRows * kTileRows;
+  const int64 n_tiles_end = n / tile_columns * tile_columns;
+  const int64 n_vectors_end = n / vector_width * vector_width;
+
+  // The rows and columns that are left over by the full tiles are computed by
+  // progressively smaller tiles, down to single elements.
+  for (int64 rows : {kTileRows, int64{1}}) {
+    const int64 m_begin = rows == kTileRows ? 0 : m_tiles_end;
+    const int64 m_end = rows == kTileRows ? m_tiles_end : m;
+    EmitGemmTiles(lhs, rhs, target, k, m_begin, m_end, rows, 0, n_tiles_end,
+                  vector_width, kTileVectors);
+    EmitGemmTiles(lhs, rhs, target, k, m_begin, m_end, rows, n_tiles_end,
+                  n_vectors_end, vector_width, 1);
+    EmitGemmTiles(lhs, rhs, target, k, m_begin, m_end, rows, n_vectors_end, n,
+                  1, 1);
+  }
+  return true;
+}
+
+void DotOpEmitter::EmitGemmTiles(const MatrixOperand& lhs,
+                                 const MatrixOperand& rhs,
+                                 const MatrixOperand& target, int64 k,
+                                 int64 m_begin, int64 m_end, int64 tile_rows,
+                                 int64 n_begin, int64 n_end, int64 vector_width,
+                                 int64 tile_vectors) {
+  if (m_begin >= m_end || n_begin >= n_end) {
+    return;
+  }
+
+  llvm::Type* element_type = target_array_.GetElementLlvmType();
+  llvm::Type* vector_type =
+      vector_width == 1 ? element_type
+                        : llvm::VectorType::get(element_type, vector_width);
+  llvm::Type* vector_pointer_type = vector_type->getPointerTo();
+  const unsigned alignment = ShapeUtil::ByteSizeOfPrimitiveType(
+      target_array_.GetShape().element_type());
+
+  llvm_ir::ForLoopNest loop_nest(llvm_ir::IrName(&dot_, "tiled"), ir_builder_);
+  std::unique_ptr<llvm_ir::ForLoop> m_loop =
+      loop_nest.AddLoop(m_begin, m_end, tile_rows, "m");
+  std::unique_ptr<llvm_ir::ForLoop> n_loop =
+      loop_nest.AddLoop(n_begin, n_end, vector_width * tile_vectors, "n");
+  std::unique_ptr<llvm_ir::ForLoop> k_loop = loop_nest.AddLoop(0, k, "k");
+
+  auto row = [&](int64 i) {
+    return ir_builder_->CreateAdd(m_loop->GetIndVarValue(),
+                                  ir_builder_->getInt64(i));
+  };
+  auto column = [&](int64 j) {
+    return ir_builder_->CreateAdd(n_loop->GetIndVarValue(),
+                                  ir_builder_->getInt64(j * vector_width));
+  };
+  auto vector_address = [&](const MatrixOperand& operand, llvm::Value* i,
+                            llvm::Value* j) {
+    return ir_builder_->CreateBitCast(
+        operand.EmitElementAddress(i, j, ir_builder_), vector_pointer_type);
+  };
+
+  // Preheader basic block of the reduction loop:
+  // - Initialize the accumulators of the tile to zero.  LLVM promotes them to
+  //   registers.
+  ir_builder_->SetInsertPoint(
+      k_loop->GetPreheaderBasicBlock()->getTerminator());
+  std::vector<llvm::Value*> accumulators;
+  for (int64 i = 0; i < tile_rows * tile_vectors; ++i) {
+    llvm::Value* accumulator = llvm_ir::EmitAllocaAtFunctionEntry(
+        vector_type, "accumulator", ir_builder_);
+    ir_builder_->CreateStore(llvm::Constant::getNullValue(vector_type),
+                             accumulator);
+    accumulators.push_back(accumulator);
+  }
+
+  // Body basic block of the reduction loop:
+  // - Load the vectors of the row of the RHS.
+  // - Multiply them with each element of the column of the LHS, and add the
+  //   products to the accumulators.
+  SetToFirstInsertPoint(k_loop->GetBodyBasicBlock(), ir_builder_);
+  llvm::Value* k_index = k_loop->GetIndVarValue();
+  std::vector<llvm::Value*> rhs_vectors;
+  for (int64 j = 0; j < tile_vectors; ++j) {
+    llvm::LoadInst* rhs_vector = ir_builder_->CreateAlignedLoad(
+        vector_address(rhs, k_index, column(j)), alignment);
+    rhs.array->AnnotateLoadStoreInstructionWithMetadata(rhs_vector);
+    rhs_vectors.push_back(rhs_vector);
+  }
+  for (int64 i = 0; i < tile_rows; ++i) {
+    llvm::LoadInst* lhs_element = ir_builder_->CreateAlignedLoad(
+        lhs.EmitElementAddress(row(i), k_index, ir_builder_), alignment);
+    lhs.array->AnnotateLoadStoreInstructionWithMetadata(lhs_element);
+    llvm::Value* lhs_vector =
+        vector_width == 1
+            ? lhs_element
+            : ir_builder_->CreateVectorSplat(vector_width, lhs_element);
+    for (int64 j = 0; j < tile_vectors; ++j) {
+      llvm::Value* accumulator = accumulators[i * tile_vectors + j];
+      ir_builder_->CreateStore(
+          ir_builder_->CreateFAdd(
+              ir_builder_->CreateLoad(accumulator),
+              ir_builder_->CreateFMul(lhs_vector, rhs_vectors[j])),
+          accumulator);
+    }
+  }
+
+  // Exit basic block of the reduction loop:
+  // - Store the accumulators into the tile of the target.
+  SetToFirstInsertPoint(k_loop->GetExitBasicBlock(), ir_builder_);
+  for (int64 i = 0; i < tile_rows; ++i) {
+    for (int64 j = 0; j < tile_vectors; ++j) {
+      llvm::StoreInst* store = ir_builder_->CreateAlignedStore(
+          ir_builder_->CreateLoad(accumulators[i * tile_vectors + j]),
+          vector_address(target, row(i), column(j)), alignment);
+      target.array->AnnotateLoadStoreInstructionWithMetadata(store);
+    }
+  }
+
+  ir_builder_->SetInsertPoint(loop_nest.GetOuterLoopExitBasicBlock());
+}
+
 tensorflow::Status DotOpEmitter::EmitScalarDot() {
   // A scalar dot is just a scalar multiply.
   llvm::Value* result;
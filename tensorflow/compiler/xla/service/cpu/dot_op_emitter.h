@@ -36,12 +36,14 @@ class DotOpEmitter {
   // place the result in target_array. IR is emitted at current insert point of
   // the builder. Upon completion of the method, the insert point is set to the
   // end of all instructions emitted for this operation.
+  // vector_register_byte_size is the size of the vector registers of the
+  // target, which the IR emitted for matrix multiplies is tiled for.
   static tensorflow::Status EmitDotOperation(
       const HloInstruction& dot, bool transpose_lhs, bool transpose_rhs,
       const llvm_ir::IrArray& target_array, const llvm_ir::IrArray& lhs_array,
       const llvm_ir::IrArray& rhs_array,
       llvm::Value* executable_run_options_value, llvm::IRBuilder<>* ir_builder,
-      const HloModuleConfig& hlo_module_config);
+      const HloModuleConfig& hlo_module_config, int vector_register_byte_size);
 
  private:
   DotOpEmitter(const HloInstruction& dot, bool transpose_lhs,
@@ -50,7 +52,23 @@ class DotOpEmitter {
                const llvm_ir::IrArray& rhs_array,
                llvm::Value* executable_run_options_value,
                llvm::IRBuilder<>* ir_builder,
-               const HloModuleConfig& hlo_module_config);
+               const HloModuleConfig& hlo_module_config,
+               int vector_register_byte_size);
+
+  // A rank two operand of a matrix multiply.  The logical element (i, j) of the
+  // matrix is the element (i, j) of "array", or the element (j, i) if
+  // "transposed" is true.
+  struct MatrixOperand {
+    const llvm_ir::IrArray* array;
+    bool transposed;
+
+    // Returns true if the logical rows of the matrix are contiguous in memory.
+    bool RowsAreContiguous() const;
+
+    // Emits the address of the logical element (row, column).
+    llvm::Value* EmitElementAddress(llvm::Value* row, llvm::Value* column,
+                                    llvm::IRBuilder<>* ir_builder) const;
+  };
 
   // Emits the IR to perform the dot operation.
   tensorflow::Status Emit();
@@ -62,6 +80,23 @@ class DotOpEmitter {
   // Emits a call to the CPU runtime to perform the matrix multiply.
   tensorflow::Status EmitCallToRuntime();
 
+  // Tries to emit the matrix multiply as register-blocked loops in LLVM IR,
+  // which avoids the overhead of calling into the runtime for small and
+  // medium sized matrices.  Returns false, without emitting any IR, if the dot
+  // is not such a matrix multiply or its layouts do not allow vectorizing it.
+  bool EmitTiledGemm();
+
+  // Emits the loops computing the elements [m_begin, m_end) x [n_begin, n_end)
+  // of "target" = "lhs" x "rhs", whose reduction dimension has size "k".  Each
+  // iteration computes a tile of "tile_rows" rows and "tile_vectors" vectors
+  // of "vector_width" elements per row, whose sums of products are kept in
+  // registers across the reduction loop.  The sizes of the ranges must be
+  // multiples of the sizes of the tile.
+  void EmitGemmTiles(const MatrixOperand& lhs, const MatrixOperand& rhs,
+                     const MatrixOperand& target, int64 k, int64 m_begin,
+                     int64 m_end, int64 tile_rows, int64 n_begin, int64 n_end,
+                     int64 vector_width, int64 tile_vectors);
+
   // Emits a series of nested loops for iterating over an operand array in the
   // dot operation. Loops are constructed in major to minor dimension layout
   // order. No loop is emitted for the given reduction_dimension. The function
@@ -86,6 +121,7 @@ class DotOpEmitter {
   llvm::Value* executable_run_options_value_;
   llvm::IRBuilder<>* ir_builder_;
   const HloModuleConfig& hlo_module_config_;
+  const int vector_register_byte_size_;
 };
 
 }  // namespace cpu
@@ -22,10 +22,74 @@ limitations under the License.
 #include "tensorflow/compiler/xla/map_util.h"
 #include "tensorflow/compiler/xla/ptr_util.h"
 #include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
+#include "tensorflow/core/platform/numa.h"
 
 namespace xla {
 namespace cpu {
+namespace {
+// The size of the huge pages the constants are placed in, and thus the
+// granularity of the chunks they are carved from.
+const int64 kHugePageSize = 2 * 1024 * 1024;
+}  // namespace
+
+ExternalConstantPool::ExternalConstantPool(const Options& options)
+    : options_(options),
+      num_replicas_(options.replicate_per_numa_node
+                        ? tensorflow::port::NUMANumNodes()
+                        : 1),
+      chunks_(num_replicas_) {}
+
+ExternalConstantPool::~ExternalConstantPool() {
+  for (const auto& replica_chunks : chunks_) {
+    for (const HugePageChunk& chunk : replica_chunks) {
+      tensorflow::port::NUMAHugePageFree(chunk.data, chunk.size);
+    }
+  }
+  for (const auto& buffer : buffers_) {
+    tensorflow::port::NUMAFree(buffer.first, buffer.second);
+  }
+}
+
+int ExternalConstantPool::ReplicaNode(int replica) const {
+  return num_replicas_ > 1 ? replica : tensorflow::port::kNUMANoAffinity;
+}
+
+uint8* ExternalConstantPool::Allocate(int replica, int64 size,
+                                      int64 alignment) {
+  if (options_.use_huge_pages) {
+    std::vector<HugePageChunk>& replica_chunks = chunks_[replica];
+    if (!replica_chunks.empty()) {
+      HugePageChunk& chunk = replica_chunks.back();
+      const int64 offset = RoundUpToNearest(chunk.used, alignment);
+      if (offset + size <= chunk.size) {
+        chunk.used = offset + size;
+        return chunk.data + offset;
+      }
+    }
+    // Constants larger than a huge page get a chunk of their own.  Chunks are
+    // aligned to kHugePageSize, so `alignment` needs no extra space.
+    const int64 chunk_size = RoundUpToNearest(size, kHugePageSize);
+    if (void* data = tensorflow::port::NUMAHugePageMalloc(
+            ReplicaNode(replica), chunk_size, kHugePageSize)) {
+      replica_chunks.push_back(
+          HugePageChunk{static_cast<uint8*>(data), chunk_size, size});
+      return replica_chunks.back().data;
+    }
+    VLOG(1) << "failed to allocate " << chunk_size
+            << " bytes in huge pages; falling back to regular pages";
+  }
+
+  void* data = tensorflow::port::NUMAMalloc(
+      ReplicaNode(replica), size,
+      std::max<int64>(alignment, sizeof(void*)));
+  CHECK(data != nullptr) << "failed to allocate " << size
+                         << " bytes with alignment of " << alignment;
+  buffers_.emplace_back(data, size);
+  return static_cast<uint8*>(data);
+}
+
 void ExternalConstantPool::Insert(string name, const Literal& literal,
                                   int64 alignment) {
   CHECK(!ShapeUtil::IsTuple(literal.shape()));
@@ -33,21 +97,33 @@ void ExternalConstantPool::Insert(string name, const Literal& literal,
   CHECK(entries_.find(name) == entries_.end());
 
   int64 literal_size = ShapeUtil::ByteSizeOf(literal.shape());
-  void* raw_pointer;
-  CHECK_EQ(
-      posix_memalign(&raw_pointer, std::max<size_t>(alignment, sizeof(void*)),
-                     literal_size),
-      0)
-      << "failed to allocate " << literal_size << " bytes with alignment of "
-      << alignment;
-
-  std::memcpy(raw_pointer, literal.InternalData(), literal_size);
-  entries_.emplace(std::move(name), static_cast<uint8*>(raw_pointer));
+  auto replicas = MakeUnique<std::vector<const uint8*>>();
+  for (int replica = 0; replica < num_replicas_; ++replica) {
+    // The copy is written after the buffer is bound to the node, so that its
+    // pages are first touched, and thus placed, there.
+    uint8* data = Allocate(replica, std::max<int64>(literal_size, 1),
+                           alignment);
+    std::memcpy(data, literal.InternalData(), literal_size);
+    replicas->push_back(data);
+  }
+  entries_.emplace(std::move(name), std::move(replicas));
 }
 
 const uint8* ExternalConstantPool::Find(const string& name) {
   auto it = entries_.find(name);
-  return it == entries_.end() ? nullptr : it->second.get();
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  const std::vector<const uint8*>& replicas = *it->second;
+  return num_replicas_ > 1 ? reinterpret_cast<const uint8*>(replicas.data())
+                           : replicas[0];
+}
+
+const uint8* ExternalConstantPool::FindReplica(const string& name,
+                                               int replica) {
+  CHECK(replica >= 0 && replica < num_replicas_);
+  auto it = entries_.find(name);
+  return it == entries_.end() ? nullptr : (*it->second)[replica];
 }
 }  // namespace cpu
 }  // namespace xla
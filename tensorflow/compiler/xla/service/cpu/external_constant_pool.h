@@ -17,6 +17,8 @@ limitations under the License.
 #define THIRD_PARTY_TENSORFLOW_COMPILER_XLA_SERVICE_CPU_EXTERNAL_CONSTANT_POOL_H_
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "tensorflow/compiler/xla/literal_util.h"
 #include "tensorflow/core/lib/gtl/flatmap.h"
@@ -32,8 +34,31 @@ namespace cpu {
 // buffers.  This simply implementation works in a JIT scenario.  This class
 // will have to become smarter if we decide to support external constant pools
 // on AOT compiles in the future.
+//
+// The buffers can be placed in huge pages, which saves TLB misses when the
+// constants are large, and replicated once per NUMA node, so that code running
+// on a node reads its constants from local memory.
 class ExternalConstantPool {
  public:
+  struct Options {
+    // Allocate the buffers in huge pages where possible.
+    bool use_huge_pages = false;
+
+    // Keep a copy of each constant on every NUMA node of the machine.  Has no
+    // effect on machines with a single node.
+    bool replicate_per_numa_node = false;
+  };
+
+  ExternalConstantPool() : ExternalConstantPool(Options()) {}
+  explicit ExternalConstantPool(const Options& options);
+  ~ExternalConstantPool();
+
+  // The number of copies of each constant.  If it is greater than 1, the
+  // address returned by `Find` is that of an array of `num_replicas()`
+  // pointers, the i-th of which points to the copy on NUMA node i, and the
+  // generated code must pick one of them.
+  int num_replicas() const { return num_replicas_; }
+
   // Inserts a buffer with the contents of `literal` into the constant pool with
   // the name `name`.  It is an error to try to insert two constants with the
   // same `name` into the same constant pool.  The buffer for literal is aligned
@@ -45,18 +70,42 @@ class ExternalConstantPool {
   void Insert(string name, const Literal& literal, int64 alignment);
 
   // Find the constant with name `name` in this constant pool.  If there isn't
-  // such constant, return nullptr.
+  // such constant, return nullptr.  See `num_replicas` for the meaning of the
+  // returned address when the constants are replicated.
   const uint8* Find(const string& name);
 
+  // Returns the copy on NUMA node `replica` of the constant with name `name`,
+  // or nullptr if there isn't such constant.
+  const uint8* FindReplica(const string& name, int replica);
+
  private:
-  // We need to `free()` pointers allocated into `entries_` since we allocate
-  // them with `posix_memalign`.
-  struct FreeDeleter {
-    void operator()(void* ptr) { free(ptr); }
+  // A huge-page region from which the buffers of one replica are carved.
+  struct HugePageChunk {
+    uint8* data;
+    int64 size;
+    int64 used;
   };
 
-  tensorflow::gtl::FlatMap<string, std::unique_ptr<uint8, FreeDeleter>>
+  // Allocates `size` bytes aligned to `alignment` for replica `replica`.
+  uint8* Allocate(int replica, int64 size, int64 alignment);
+
+  // The NUMA node of replica `replica`, or tensorflow::port::kNUMANoAffinity
+  // if the constants are not replicated.
+  int ReplicaNode(int replica) const;
+
+  const Options options_;
+  const int num_replicas_;
+
+  // The copies of each constant, indexed by replica.  The tables are held by
+  // pointer so that their addresses, which are handed out by `Find`, do not
+  // change when the map grows.
+  tensorflow::gtl::FlatMap<string, std::unique_ptr<std::vector<const uint8*>>>
       entries_;
+
+  // The memory backing the copies: huge-page chunks, indexed by replica, and
+  // the buffers allocated individually, with their sizes.
+  std::vector<std::vector<HugePageChunk>> chunks_;
+  std::vector<std::pair<void*, int64>> buffers_;
 };
 }  // namespace cpu
 }  // namespace xla
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/external_constant_pool.h"
 #include "tensorflow/compiler/xla/layout_util.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace xla {
@@ -77,6 +78,63 @@ TEST(ExternalConstantPoolTest, Alignment) {
   }
 }
 
+TEST(ExternalConstantPoolTest, HugePages) {
+  ExternalConstantPool::Options options;
+  options.use_huge_pages = true;
+  ExternalConstantPool constant_pool(options);
+  EXPECT_EQ(constant_pool.num_replicas(), 1);
+
+  // Small constants share a huge page, and large ones get their own.
+  std::vector<int32> large(1 << 20, 7);
+  for (int i = 0; i < 8; i++) {
+    string name = tensorflow::strings::StrCat("name-", i);
+    const auto literal = i % 4 == 3 ? Literal::CreateR1<int32>(large)
+                                    : Literal::CreateR2({{i, 2}, {3, 4}});
+    int64 alignment = 1 << i;
+    constant_pool.Insert(name, *literal, alignment);
+  }
+  for (int i = 0; i < 8; i++) {
+    string name = tensorflow::strings::StrCat("name-", i);
+    const uint8* constant = constant_pool.Find(name);
+    ASSERT_NE(constant, nullptr);
+    EXPECT_EQ(reinterpret_cast<intptr_t>(constant) % (1 << i), 0);
+    if (i % 4 == 3) {
+      EXPECT_EQ(GetFromBuffer<int32>(constant, 0), 7);
+      EXPECT_EQ(GetFromBuffer<int32>(constant, large.size() - 1), 7);
+    } else {
+      EXPECT_EQ(GetFromBuffer<int32>(constant, 0), i);
+      EXPECT_EQ(GetFromBuffer<int32>(constant, 3), 4);
+    }
+  }
+}
+
+TEST(ExternalConstantPoolTest, ReplicatePerNumaNode) {
+  ExternalConstantPool::Options options;
+  options.replicate_per_numa_node = true;
+  ExternalConstantPool constant_pool(options);
+  const int num_replicas = constant_pool.num_replicas();
+  EXPECT_EQ(num_replicas, tensorflow::port::NUMANumNodes());
+
+  const auto literal = Literal::CreateR2({{1, 2}, {3, 4}});
+  constant_pool.Insert("name-0", *literal, 16);
+  const uint8* table = constant_pool.Find("name-0");
+  ASSERT_NE(table, nullptr);
+  for (int replica = 0; replica < num_replicas; replica++) {
+    const uint8* constant = constant_pool.FindReplica("name-0", replica);
+    ASSERT_NE(constant, nullptr);
+    EXPECT_EQ(reinterpret_cast<intptr_t>(constant) % 16, 0);
+    EXPECT_EQ(GetFromBuffer<int32>(constant, 0), 1);
+    EXPECT_EQ(GetFromBuffer<int32>(constant, 3), 4);
+    if (num_replicas > 1) {
+      // Find returns the table of the copies.
+      EXPECT_EQ(GetFromBuffer<const uint8*>(table, replica), constant);
+    } else {
+      EXPECT_EQ(table, constant);
+    }
+  }
+  EXPECT_EQ(constant_pool.FindReplica("name-1", 0), nullptr);
+}
+
 }  // namespace
 }  // namespace cpu
 }  // namespace xla
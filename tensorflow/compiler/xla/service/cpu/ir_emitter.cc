@@ -266,6 +266,7 @@ Status IrEmitter::HandleConstant(HloInstruction* constant) {
   VLOG(2) << "HandleConstant: " << constant->ToString();
   const Literal& literal = constant->literal();
   llvm::GlobalVariable* global_for_const;
+  llvm::Value* emitted_value;
 
   // We avoid creating large constants in the LLVM IR since LLVM is not
   // efficient for large constant arrays.  We still emit "small enough" constant
@@ -276,14 +277,46 @@ Status IrEmitter::HandleConstant(HloInstruction* constant) {
       ByteSizeOf(literal.shape()) >= kMaxInternalConstantSizeInBytes) {
     string global_name = tensorflow::strings::StrCat(
         "constant_global_", external_global_constant_counter_++);
-    global_for_const = new llvm::GlobalVariable(
-        /*Module=*/*module_,
-        /*Type=*/IrShapeType(literal.shape()),
-        /*isConstant=*/true,
-        /*Linkage=*/llvm::GlobalValue::ExternalLinkage,
-        /*Initializer=*/nullptr,
-        /*Name=*/AsStringRef(global_name));
-    global_for_const->setAlignment(MinimumAlignmentForShape(literal.shape()));
+    const int num_replicas = external_constant_pool_->num_replicas();
+    if (num_replicas > 1) {
+      // The global is the table of the per-NUMA-node copies of the constant,
+      // and the code reads the copy of the node it runs on.
+      llvm::Type* i8_ptr_type = ir_builder_.getInt8PtrTy();
+      global_for_const = new llvm::GlobalVariable(
+          /*Module=*/*module_,
+          /*Type=*/llvm::ArrayType::get(i8_ptr_type, num_replicas),
+          /*isConstant=*/true,
+          /*Linkage=*/llvm::GlobalValue::ExternalLinkage,
+          /*Initializer=*/nullptr,
+          /*Name=*/AsStringRef(global_name));
+      llvm::Function* numa_node_func =
+          llvm::cast<llvm::Function>(module_->getOrInsertFunction(
+              runtime::kNUMANodeSymbolName,
+              llvm::FunctionType::get(ir_builder_.getInt32Ty(),
+                                      {ir_builder_.getInt32Ty()},
+                                      /*isVarArg=*/false)));
+      numa_node_func->setCallingConv(llvm::CallingConv::C);
+      numa_node_func->setDoesNotThrow();
+      numa_node_func->setDoesNotAccessMemory();
+      llvm::Value* node = ir_builder_.CreateCall(
+          numa_node_func, {ir_builder_.getInt32(num_replicas)});
+      llvm::Value* replica = ir_builder_.CreateLoad(
+          ir_builder_.CreateInBoundsGEP(global_for_const,
+                                        {ir_builder_.getInt32(0), node}));
+      emitted_value = ir_builder_.CreateBitCast(
+          replica, IrShapeType(literal.shape())->getPointerTo(),
+          AsStringRef(IrName(constant)));
+    } else {
+      global_for_const = new llvm::GlobalVariable(
+          /*Module=*/*module_,
+          /*Type=*/IrShapeType(literal.shape()),
+          /*isConstant=*/true,
+          /*Linkage=*/llvm::GlobalValue::ExternalLinkage,
+          /*Initializer=*/nullptr,
+          /*Name=*/AsStringRef(global_name));
+      global_for_const->setAlignment(MinimumAlignmentForShape(literal.shape()));
+      emitted_value = global_for_const;
+    }
     external_constant_pool_->Insert(global_name, literal,
                                     MinimumAlignmentForShape(literal.shape()));
   } else {
@@ -297,11 +330,12 @@ Status IrEmitter::HandleConstant(HloInstruction* constant) {
         /*Initializer=*/initializer,
         /*Name=*/"");
     global_for_const->setAlignment(MinimumAlignmentForShape(literal.shape()));
+    emitted_value = global_for_const;
   }
-  emitted_value_[constant] = global_for_const;
-  VLOG(2) << "  emitted value: " << llvm_ir::DumpToString(*global_for_const);
+  emitted_value_[constant] = emitted_value;
+  VLOG(2) << "  emitted value: " << llvm_ir::DumpToString(*emitted_value);
   VLOG(2) << "  its type: "
-          << llvm_ir::DumpToString(*global_for_const->getType());
+          << llvm_ir::DumpToString(*emitted_value->getType());
   return Status::OK();
 }
 
@@ -915,7 +949,9 @@ Status IrEmitter::HandleDot(HloInstruction* dot) {
   return DotOpEmitter::EmitDotOperation(
       *dot, /*transpose_lhs=*/false, /*transpose_rhs=*/false, target_array,
       lhs_array, rhs_array, GetExecutableRunOptionsArgument(), &ir_builder_,
-      hlo_module_config_);
+      hlo_module_config_,
+      target_machine_features_.largest_register_size_in_bytes(
+          compute_function_));
 }
 
 Status IrEmitter::HandleConvolution(HloInstruction* convolution) {
@@ -1758,6 +1794,193 @@ uint32 GCD(uint32 x, uint32 y) {
 }
 }  // namespace
 
+llvm::Value* IrEmitter::EmitHorizontalReduction(
+    const ReductionGenerator& reduction_generator, llvm::Value* vector) {
+  // Each step reduces the upper half of the remaining lanes into the lower
+  // half, so the reduced value ends up in lane 0.
+  const unsigned lanes = vector->getType()->getVectorNumElements();
+  for (unsigned width = lanes / 2; width > 0; width /= 2) {
+    std::vector<llvm::Constant*> mask;
+    for (unsigned i = 0; i < lanes; ++i) {
+      mask.push_back(ir_builder_.getInt32((i + width) % lanes));
+    }
+    llvm::Value* upper_half = ir_builder_.CreateShuffleVector(
+        vector, llvm::UndefValue::get(vector->getType()),
+        llvm::ConstantVector::get(mask));
+    vector = reduction_generator(&ir_builder_, vector, upper_half);
+  }
+  return ir_builder_.CreateExtractElement(vector, ir_builder_.getInt32(0));
+}
+
+StatusOr<bool> IrEmitter::EmitVectorizedReduceOverMinorDimensions(
+    HloInstruction* reduce, HloInstruction* arg, HloInstruction* init_value,
+    tensorflow::gtl::ArraySlice<int64> dimensions,
+    const ReductionGenerator& reduction_generator, int vectorization_factor,
+    unsigned element_alignment, string* failure_reason) {
+  const Shape& arg_shape = arg->shape();
+
+  // The elements reduced into each output element are contiguous in memory
+  // only if the reduced dimensions are the most minor ones.
+  int64 reduced_elements = 1;
+  for (int64 i = 0; i < dimensions.size(); ++i) {
+    int64 dimension = LayoutUtil::Minor(arg_shape.layout(), i);
+    if (std::find(dimensions.begin(), dimensions.end(), dimension) ==
+        dimensions.end()) {
+      *failure_reason =
+          "reduction over the minor dimension and a non-minor dimension";
+      return false;
+    }
+    reduced_elements *= arg_shape.dimensions(dimension);
+  }
+
+  if (LayoutUtil::IsPadded(arg_shape)) {
+    *failure_reason = "reduction over the minor dimension of a padded array";
+    return false;
+  }
+
+  if (vectorization_factor < 2 ||
+      (vectorization_factor & (vectorization_factor - 1)) != 0) {
+    *failure_reason = "vectorization factor is not a power of two";
+    return false;
+  }
+
+  if (reduced_elements < vectorization_factor) {
+    *failure_reason = "reduction over fewer elements than a vector";
+    return false;
+  }
+
+  // With a single accumulator every vector reduction would depend on the
+  // previous one, so we keep up to kMaxAccumulators independent accumulators
+  // and combine them at the end.
+  const int64 kMaxAccumulators = 4;
+  const int64 num_accumulators =
+      std::min(kMaxAccumulators, reduced_elements / vectorization_factor);
+  const int64 block_size = num_accumulators * vectorization_factor;
+  const int64 blocks_end = reduced_elements / block_size * block_size;
+  const int64 vectors_end =
+      reduced_elements / vectorization_factor * vectorization_factor;
+
+  llvm::Type* element_ir_type =
+      llvm_ir::PrimitiveTypeToIrType(reduce->shape().element_type(), module_);
+  llvm::VectorType* vector_type =
+      llvm::VectorType::get(element_ir_type, vectorization_factor);
+
+  // We lower the reduction as:
+  //
+  //  1. R is the number of reduced elements of each output element, which are
+  //     contiguous in the input.
+  //  2. VS is the vectorization stride and K the number of accumulators.
+  //
+  //  for (each output element o) {
+  //    acc[k] = input[o, k * VS:(k + 1) * VS] for k in [0, K)
+  //    for (r in [K * VS, R / (K * VS) * (K * VS)) with stride K * VS) {
+  //      acc[k] = elementwise_reduce(acc[k],
+  //                                  input[o, r + k * VS:r + (k + 1) * VS])
+  //    }
+  //    (the remaining full vectors and elements of o, without a loop)
+  //    output[o] = reduce(init, horizontal_reduce(acc[0], ..., acc[K - 1]))
+  //  }
+  CHECK(!ShapeUtil::IsTuple(reduce->shape()));
+  return EmitTargetElementLoop(
+      reduce,
+      [&](const llvm_ir::IrArray::Index& index) -> StatusOr<llvm::Value*> {
+        llvm_ir::IrArray arg_array(GetIrArrayFor(arg));
+        llvm_ir::IrArray::Index input_index(arg_shape.dimensions_size());
+        llvm_ir::IrArray::Index::const_iterator it = index.begin();
+        for (int64 i = 0; i < input_index.size(); ++i) {
+          if (std::find(dimensions.begin(), dimensions.end(), i) !=
+              dimensions.end()) {
+            input_index[i] = ir_builder_.getInt64(0);
+          } else {
+            input_index[i] = *it++;
+          }
+        }
+        CHECK(index.end() == it);
+
+        // The address of the first element reduced into "index".
+        llvm::Value* input_address = ir_builder_.CreateBitCast(
+            arg_array.EmitArrayElementAddress(input_index, &ir_builder_),
+            element_ir_type->getPointerTo());
+        auto load_vector = [&](llvm::Value* offset) {
+          llvm::Value* address = ir_builder_.CreateBitCast(
+              ir_builder_.CreateInBoundsGEP(input_address, offset),
+              vector_type->getPointerTo());
+          llvm::LoadInst* load =
+              ir_builder_.CreateAlignedLoad(address, element_alignment);
+          arg_array.AnnotateLoadStoreInstructionWithMetadata(load);
+          return load;
+        };
+        auto accumulate = [&](llvm::Value* accumulator, llvm::Value* value) {
+          llvm::Value* reduced_result = reduction_generator(
+              &ir_builder_,
+              ir_builder_.CreateAlignedLoad(accumulator, element_alignment),
+              value);
+          ir_builder_.CreateAlignedStore(reduced_result, accumulator,
+                                         element_alignment);
+        };
+
+        // The accumulators start with the first vectors rather than with
+        // init_value, which is combined into the result exactly once.
+        std::vector<llvm::Value*> accumulators;
+        for (int64 i = 0; i < num_accumulators; ++i) {
+          llvm::Value* accumulator = llvm_ir::EmitAllocaAtFunctionEntry(
+              vector_type, "accumulator", &ir_builder_, 0);
+          ir_builder_.CreateAlignedStore(
+              load_vector(ir_builder_.getInt64(i * vectorization_factor)),
+              accumulator, element_alignment);
+          accumulators.push_back(accumulator);
+        }
+
+        if (blocks_end > block_size) {
+          llvm_ir::ForLoopNest loop_nest(IrName(arg, "vectorized_inner"),
+                                         &ir_builder_);
+          std::unique_ptr<llvm_ir::ForLoop> loop = loop_nest.AddLoop(
+              block_size, blocks_end, block_size, "reduction_block");
+          SetToFirstInsertPoint(loop->GetBodyBasicBlock(), &ir_builder_);
+          for (int64 i = 0; i < num_accumulators; ++i) {
+            accumulate(accumulators[i],
+                       load_vector(ir_builder_.CreateAdd(
+                           loop->GetIndVarValue(),
+                           ir_builder_.getInt64(i * vectorization_factor))));
+          }
+          SetToFirstInsertPoint(loop_nest.GetOuterLoopExitBasicBlock(),
+                                &ir_builder_);
+        }
+
+        // There are fewer remaining full vectors than accumulators.
+        for (int64 offset = blocks_end; offset < vectors_end;
+             offset += vectorization_factor) {
+          accumulate(
+              accumulators[(offset - blocks_end) / vectorization_factor],
+              load_vector(ir_builder_.getInt64(offset)));
+        }
+
+        llvm::Value* vector_result =
+            ir_builder_.CreateAlignedLoad(accumulators[0], element_alignment);
+        for (int64 i = 1; i < num_accumulators; ++i) {
+          vector_result = reduction_generator(
+              &ir_builder_, vector_result,
+              ir_builder_.CreateAlignedLoad(accumulators[i],
+                                            element_alignment));
+        }
+        llvm::Value* result =
+            EmitHorizontalReduction(reduction_generator, vector_result);
+
+        for (int64 offset = vectors_end; offset < reduced_elements; ++offset) {
+          llvm::LoadInst* element = ir_builder_.CreateAlignedLoad(
+              ir_builder_.CreateInBoundsGEP(input_address,
+                                            ir_builder_.getInt64(offset)),
+              element_alignment);
+          arg_array.AnnotateLoadStoreInstructionWithMetadata(element);
+          result = reduction_generator(&ir_builder_, result, element);
+        }
+
+        return reduction_generator(
+            &ir_builder_,
+            ir_builder_.CreateLoad(GetEmittedValueFor(init_value)), result);
+      });
+}
+
 StatusOr<bool> IrEmitter::EmitVectorizedReduce(
     HloInstruction* reduce, HloInstruction* arg, HloInstruction* init_value,
     tensorflow::gtl::ArraySlice<int64> dimensions, HloComputation* function,
@@ -1785,9 +2008,9 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
           MinimumAlignmentForPrimitiveType(reduce->shape().element_type()));
 
   if (is_reduction_over_minor_dimension) {
-    // TODO(sanjoy): Implement vectorized reduction over the minor dimension.
-    *failure_reason = "reduction over minor dimension not implemented";
-    return false;
+    return EmitVectorizedReduceOverMinorDimensions(
+        reduce, arg, init_value, dimensions, reduction_generator,
+        vectorization_factor, element_alignment, failure_reason);
   }
 
   CHECK(!ShapeUtil::IsTuple(reduce->shape()));
@@ -2251,7 +2474,9 @@ Status IrEmitter::HandleFusion(HloInstruction* fusion) {
         *root, root->operand(0)->IsRank2Transpose(),
         root->operand(1)->IsRank2Transpose(), target_array, lhs_array,
         rhs_array, GetExecutableRunOptionsArgument(), &ir_builder_,
-        hlo_module_config_));
+        hlo_module_config_,
+        target_machine_features_.largest_register_size_in_bytes(
+            compute_function_)));
     return Status::OK();
   } else if (llvm_ir::CanEmitFusedDynamicUpdateSliceInPlace(fusion,
                                                             assignment_)) {
@@ -429,6 +429,20 @@ class IrEmitter : public DfsHloVisitorWithDefault {
       HloInstruction* arg, tensorflow::gtl::ArraySlice<int64> dimensions,
       unsigned element_alignment);
 
+  // Emits a vectorized reduction over the most minor dimensions of "arg",
+  // whose reduced elements are contiguous for each output element.  Helper
+  // function for EmitVectorizedReduce, with the same contract.
+  StatusOr<bool> EmitVectorizedReduceOverMinorDimensions(
+      HloInstruction* reduce, HloInstruction* arg, HloInstruction* init_value,
+      tensorflow::gtl::ArraySlice<int64> dimensions,
+      const ReductionGenerator& reduction_generator, int vectorization_factor,
+      unsigned element_alignment, string* failure_reason);
+
+  // Emits the reduction of the lanes of "vector", whose number of lanes is a
+  // power of two, into a scalar.
+  llvm::Value* EmitHorizontalReduction(
+      const ReductionGenerator& reduction_generator, llvm::Value* vector);
+
   // Tries to emit a fast concatenate operation using memcpy.  Returns true if
   // successful, and false on failure.  On failure, sets "failure_reason" to a
   // string describing why it could not emit a fast concatenate.
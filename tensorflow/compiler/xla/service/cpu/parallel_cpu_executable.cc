@@ -17,9 +17,10 @@ limitations under the License.
 
 #include <stdint.h>
 #include <algorithm>
-#include <deque>
 #include <iterator>
 #include <list>
+#include <memory>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -29,6 +30,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
 #include "tensorflow/compiler/xla/service/cpu/shape_partition.h"
+#include "tensorflow/compiler/xla/service/cpu/task_graph.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
@@ -40,6 +42,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/gtl/flatset.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
@@ -121,25 +124,16 @@ class Executor {
   Status Run();
 
  private:
-  // Schedules a parallel invocation of compute function for 'instruction' on
-  // 'thread_pool_', storing result in 'result_buffer'.
-  // If 'partition_buffers' is non-null, parallel task will be invoked on
-  // per-dimension partition [start, limit) values stored in
-  // 'partition_buffers'.
-  void Schedule(HloInstruction* instruction, int64* partition_buffers,
-                void* result_buffer);
-
   // Returns true if 'instruction' has been assigned parallel tasks (returns
   // false otherwise).
   bool HasParallelTasks(HloInstruction* instruction);
 
-  // Returns in 'partition_buffers' the partition [size, limit) for each
-  // dimension.
-  int64* GetPartitionBuffers(
-      const std::vector<std::pair<int64, int64>>& partition);
-
-  // Returns array of result buffers for all operands in 'instruction'.
-  const void** GetOperandBuffers(HloInstruction* instruction);
+  // Returns the partition [start, limit) for each dimension of each partition
+  // of 'instruction', in the layout of the 'partitions' array of
+  // runtime_fork_join.cc. Stores the number of partitions in
+  // 'partition_count'.
+  std::vector<int64> GetPartitionBuffers(HloInstruction* instruction,
+                                         int64* partition_count);
 
   // Arguments passed into Executor.
   const std::map<HloInstruction*, ComputeFunctionType>& functions_;
@@ -150,149 +144,88 @@ class Executor {
   uint64* profile_counters_array_;
   tensorflow::thread::ThreadPool* thread_pool_;
   const BufferAssignment* assignment_;
-
-  // Members used to manage instruction execution.
-  tensorflow::mutex completion_queue_lock_;
-  tensorflow::condition_variable completion_queue_cv_;
-  std::deque<HloInstruction*> completion_queue_;
-  int64 instructions_in_flight_ = 0;
-  std::unordered_map<const HloInstruction*, int64> tasks_in_flight_;
 };
 
 Status Executor::Run() {
-  while (!pending_->empty() || instructions_in_flight_ > 0) {
-    auto pending_it = pending_->begin();
-    while (pending_it != pending_->end()) {
-      HloInstruction* instruction = *pending_it;
-      // Skip pending instructions whose operands aren't ready.
-      if (std::any_of(instruction->operands().begin(),
-                      instruction->operands().end(),
-                      [&](HloInstruction* operand) {
-                        return !ContainsKey(*results_, operand);
-                      })) {
-        ++pending_it;
-        continue;
-      }
-
-      // Get 'result_buffer' reference to result buffer for 'instruction'.
-      TF_ASSIGN_OR_RETURN(const BufferAllocation::Slice result_slice,
-                          assignment_->GetUniqueTopLevelSlice(instruction));
-      void* result_buffer =
-          static_cast<char*>(temps_array_[result_slice.index()]) +
-          result_slice.offset();
-
-      if (HasParallelTasks(instruction)) {
-        // 'instruction' has been assigned parallel task partitions.
-        CHECK_EQ(HloOpcode::kCall, instruction->opcode());
-        HloInstruction* root = instruction->to_apply()->root_instruction();
-
-        // Create ShapePartitionIterator to iterate through all outer dimension
-        // partitions of 'instruction'.
-        ShapePartitionIterator partition_iterator(
-            root->shape(), root->outer_dimension_partitions());
-
-        const int64 partition_count =
-            partition_iterator.GetTotalPartitionCount();
-
-        // Record total parallel task count for 'instruction' before dispatch.
-        {
-          tensorflow::mutex_lock l(completion_queue_lock_);
-          tasks_in_flight_.insert(std::make_pair(instruction, partition_count));
-          VLOG(2) << "Schedule PARALLEL"
-                  << " instruction: " << instruction->name()
-                  << " instruction.callee: "
-                  << instruction->to_apply()->root_instruction()->name()
-                  << " partition_count: " << partition_count;
-        }
-
-        for (int64 i = 0; i < partition_count; ++i) {
-          // Get partition [start, limit) for each dimension.
-          auto partition_buffers =
-              GetPartitionBuffers(partition_iterator.GetPartition(i));
-          Schedule(instruction, partition_buffers, result_buffer);
-        }
-
-      } else {
-        // Set tasks in-flight to '1' for sequential instruction execution.
-        {
-          tensorflow::mutex_lock l(completion_queue_lock_);
-          tasks_in_flight_.insert(std::make_pair(instruction, 1));
-          VLOG(2) << "Schedule SEQUENTIAL"
-                  << " instruction: " << instruction->name()
-                  << " instruction.callee: "
-                  << instruction->to_apply()->root_instruction()->name();
-        }
-        Schedule(instruction, nullptr, result_buffer);
-      }
-
-      ++instructions_in_flight_;
-      pending_it = pending_->erase(pending_it);
-    }
-    // Wait for a completed HLO instruction to be present in the queue.  We will
-    // pop it out of the queue and make the result available to its users.
-    HloInstruction* instruction;
-    do {
-      tensorflow::mutex_lock l(completion_queue_lock_);
-      if (completion_queue_.empty()) {
-        completion_queue_cv_.wait(l);
-      }
-      if (!completion_queue_.empty()) {
-        instruction = completion_queue_.front();
-        completion_queue_.pop_front();
-        break;
-      }
-    } while (true);
+  // Each pending instruction becomes a node of a task graph, with a task for
+  // each of its partitions, which starts once the nodes of its operands have
+  // finished. The result buffers are known ahead of time from the buffer
+  // assignment, so the tasks need no coordination beyond the dependencies.
+  TaskGraph graph;
+  std::unordered_map<const HloInstruction*, TaskGraph::NodeId> nodes;
+  const auto* exec_run_options = &run_options_->run_options();
+  for (HloInstruction* instruction : *pending_) {
+    // Get 'result_buffer' reference to result buffer for 'instruction'.
     TF_ASSIGN_OR_RETURN(const BufferAllocation::Slice result_slice,
                         assignment_->GetUniqueTopLevelSlice(instruction));
     void* result_buffer =
         static_cast<char*>(temps_array_[result_slice.index()]) +
         result_slice.offset();
-    InsertOrDie(results_, instruction, result_buffer);
-    --instructions_in_flight_;
-  }
-  return Status::OK();
-}
 
-void Executor::Schedule(HloInstruction* instruction, int64* partition_buffers,
-                        void* result_buffer) {
-  // The thread pool entry takes ownership of |operand_buffers|.
-  auto operand_buffers = GetOperandBuffers(instruction);
+    // The pending instructions are in post order, so the results of their
+    // operands are known.
+    std::vector<const void*> operand_buffers;
+    for (HloInstruction* operand : instruction->operands()) {
+      operand_buffers.push_back(FindOrDie(*results_, operand));
+    }
+    InsertOrDie(results_, instruction, result_buffer);
 
-  auto function = FindOrDie(functions_, instruction);
-  const auto* exec_run_options = &run_options_->run_options();
-  thread_pool_->Schedule([this, instruction, result_buffer, operand_buffers,
-                          partition_buffers, exec_run_options, function]() {
-    function(result_buffer, exec_run_options, operand_buffers, temps_array_,
-             partition_buffers, profile_counters_array_);
-
-    delete[] operand_buffers;
-    delete[] partition_buffers;
-    // Push the completed HLO instruction on the queue, the main
-    // thread will pop it off and potentially launch more work which
-    // uses the result.
-    // TODO(b/27458679) Consider alternative task scheduling and synchronization
-    // schemes. For example, we could avoid the overhead associate with the
-    // condvar here if the thread just dequed the next instruction to execute
-    // on completion.
-    {
-      tensorflow::mutex_lock l(completion_queue_lock_);
-      // Decrement in-flight task count for this completion.
-      if (--FindOrDie(tasks_in_flight_, instruction) == 0) {
-        completion_queue_.push_back(instruction);
-        completion_queue_cv_.notify_all();
-        tasks_in_flight_.erase(instruction);
+    int64 partition_count = 1;
+    std::shared_ptr<std::vector<int64>> partition_buffers;
+    if (HasParallelTasks(instruction)) {
+      // 'instruction' has been assigned parallel task partitions.
+      CHECK_EQ(HloOpcode::kCall, instruction->opcode());
+      partition_buffers = std::make_shared<std::vector<int64>>(
+          GetPartitionBuffers(instruction, &partition_count));
+    }
+    VLOG(2) << "Schedule"
+            << " instruction: " << instruction->name()
+            << " instruction.callee: "
+            << instruction->to_apply()->root_instruction()->name()
+            << " partition_count: " << partition_count;
+
+    auto function = FindOrDie(functions_, instruction);
+    const TaskGraph::NodeId node = graph.AddNode(
+        partition_count,
+        [this, function, result_buffer, exec_run_options, operand_buffers,
+         partition_buffers, partition_count](int64 partition) {
+          int64* partition_buffer = nullptr;
+          if (partition_buffers != nullptr) {
+            partition_buffer =
+                partition_buffers->data() +
+                partition * (partition_buffers->size() / partition_count);
+          }
+          function(result_buffer, exec_run_options, operand_buffers.data(),
+                   temps_array_, partition_buffer, profile_counters_array_);
+        });
+    tensorflow::gtl::FlatSet<const HloInstruction*> unique_operands(
+        instruction->operands().begin(), instruction->operands().end());
+    for (const HloInstruction* operand : unique_operands) {
+      auto it = nodes.find(operand);
+      if (it != nodes.end()) {
+        graph.AddDependency(it->second, node);
       }
     }
-  });
+    nodes[instruction] = node;
+  }
+  graph.Run(thread_pool_);
+  return Status::OK();
 }
 
-int64* Executor::GetPartitionBuffers(
-    const std::vector<std::pair<int64, int64>>& partition) {
-  // Return in 'partition_buffers' partition [size, limit) for each dimension.
-  auto partition_buffers = new int64[partition.size() * 2];
-  for (int i = 0; i < partition.size(); ++i) {
-    partition_buffers[2 * i + 0] = partition[i].first;
-    partition_buffers[2 * i + 1] = partition[i].first + partition[i].second;
+std::vector<int64> Executor::GetPartitionBuffers(HloInstruction* instruction,
+                                                 int64* partition_count) {
+  // Create ShapePartitionIterator to iterate through all outer dimension
+  // partitions of 'instruction'.
+  HloInstruction* root = instruction->to_apply()->root_instruction();
+  ShapePartitionIterator partition_iterator(root->shape(),
+                                            root->outer_dimension_partitions());
+  *partition_count = partition_iterator.GetTotalPartitionCount();
+  std::vector<int64> partition_buffers;
+  for (int64 i = 0; i < *partition_count; ++i) {
+    for (const auto& dim_partition : partition_iterator.GetPartition(i)) {
+      partition_buffers.push_back(dim_partition.first);
+      partition_buffers.push_back(dim_partition.first + dim_partition.second);
+    }
   }
   return partition_buffers;
 }
@@ -305,21 +238,6 @@ bool Executor::HasParallelTasks(HloInstruction* instruction) {
               .empty();
 }
 
-const void** Executor::GetOperandBuffers(HloInstruction* instruction) {
-  // We cannot use a move-only RAII type like std::unique_ptr because the
-  // list of operands is allocated on the main thread and transferred to the
-  // worker via the lambda passed to enqueue_function.  In order for the
-  // lambda to take ownership, we would need to use generalized lambda
-  // capture which is a feature new to C++14.
-  // TODO(b/27458679) Avoid dynamic allocations in Executor.
-  auto operand_buffers = new const void*[instruction->operand_count()];
-  std::transform(instruction->operands().begin(), instruction->operands().end(),
-                 operand_buffers, [this](HloInstruction* operand) {
-                   return FindOrDie(*results_, operand);
-                 });
-  return operand_buffers;
-}
-
 }  // namespace
 
 Status ParallelCpuExecutable::AllocateBuffers(
@@ -17,6 +17,9 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <atomic>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/compiler/xla/executable_run_options.h"
 #include "tensorflow/core/lib/core/blocking_counter.h"
@@ -30,8 +33,11 @@ using tensorflow::uint64;
 using ComputeFunctionType = void (*)(void*, const void*, const void**, void**,
                                      int64*, uint64*);
 
-// Dispatches 'num_partitions - 1' calls to 'function_ptr' in parallel.
-// Calls 'function_ptr' for first partition inline.
+// Calls 'function_ptr' for each of 'num_partitions' partitions, on the calling
+// thread and on up to 'num_partitions - 1' threads of the intra-op thread
+// pool. The threads claim the partitions one at a time from an atomic counter,
+// so that threads which finish early take over the remaining partitions when
+// the partitions are imbalanced.
 // Uses blocking counter to synchonize threads after parallel calls complete.
 //
 // The 'partitions' array has a total number of elements equal to
@@ -74,24 +80,35 @@ void __xla_cpu_runtime_ParallelForkJoin(
   // Compute partition stride in 'partitions' array.
   const int64 stride = 2 * num_partitioned_dims;
 
-  // Dispatch 'num_partitions - 1' compute functions to run in parallel.
-  tensorflow::BlockingCounter bc(num_partitions - 1);
-  for (int32 i = 1; i < num_partitions; ++i) {
-    const int64 offset = i * stride;
-    run_options->intra_op_thread_pool()->enqueueNoNotification(
-        [i, function, result_ptr, run_options_ptr, params, temps, prof_counters,
-         partitions, offset, &bc]() {
-          function(result_ptr, run_options_ptr, params, temps,
-                   &partitions[offset], prof_counters);
+  std::atomic<int32> next_partition(0);
+  auto run_partitions = [&]() {
+    for (int32 i = next_partition++; i < num_partitions;
+         i = next_partition++) {
+      function(result_ptr, run_options_ptr, params, temps,
+               &partitions[i * stride], prof_counters);
+      VLOG(3) << "ParallelForkJoin partition " << i << " done.";
+    }
+  };
+
+  // Dispatch up to 'num_partitions - 1' helpers to run in parallel with the
+  // calling thread. Code compiled ahead-of-time may run without an intra-op
+  // thread pool, in which case the calling thread runs all partitions.
+  const Eigen::ThreadPoolDevice* thread_pool =
+      run_options->intra_op_thread_pool();
+  const int32 helpers =
+      thread_pool == nullptr
+          ? 0
+          : std::min<int32>(num_partitions - 1, thread_pool->numThreads());
+  tensorflow::BlockingCounter bc(helpers);
+  for (int32 i = 0; i < helpers; ++i) {
+    thread_pool->enqueueNoNotification(
+        [&run_partitions, &bc]() {
+          run_partitions();
           bc.DecrementCount();
-          VLOG(3) << "ParallelForkJoin partition " << i << " done.";
         });
   }
 
-  // Call first compute function inline.
-  function(result_ptr, run_options_ptr, params, temps, &partitions[0],
-           prof_counters);
-  VLOG(3) << "ParallelForkJoin partition 0 done.";
+  run_partitions();
   bc.Wait();
   VLOG(2) << "ParallelForkJoin EXIT";
 }
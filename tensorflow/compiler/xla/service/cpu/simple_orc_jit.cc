@@ -37,6 +37,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/runtime_matmul.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_single_threaded_conv2d.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_single_threaded_matmul.h"
+#include "tensorflow/compiler/xla/service/memory_compilation_cache.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/core/platform/logging.h"
 
@@ -107,6 +108,15 @@ CompilerFunctor::VectorIntrinsics GetAvailableIntrinsics() {
   return intrinsics;
 }
 
+// Returns the cache of the object files compiled by the JITs of this
+// process, so that compiling an identical module again, e.g. the same
+// cluster in another session, skips the LLVM optimizations and codegen.
+MemoryCompilationCache* GetObjectCache() {
+  static MemoryCompilationCache* cache =
+      new MemoryCompilationCache(/*capacity_bytes=*/256 << 20);
+  return cache;
+}
+
 }  // namespace
 
 SimpleOrcJIT::SimpleOrcJIT(const llvm::TargetOptions& target_options,
@@ -114,7 +124,10 @@ SimpleOrcJIT::SimpleOrcJIT(const llvm::TargetOptions& target_options,
                            bool optimize_for_size, bool enable_fast_math,
                            bool disable_expensive_passes,
                            LLVMCompiler::ModuleHook pre_optimization_hook,
-                           LLVMCompiler::ModuleHook post_optimization_hook)
+                           LLVMCompiler::ModuleHook post_optimization_hook,
+                           const string& compilation_cache_dir,
+                           const ExternalConstantPool::Options&
+                               constant_pool_options)
     : target_machine_(
           CHECK_NOTNULL(llvm::EngineBuilder()
                             .setTargetOptions(target_options)
@@ -127,13 +140,19 @@ SimpleOrcJIT::SimpleOrcJIT(const llvm::TargetOptions& target_options,
       data_layout_(target_machine_->createDataLayout()),
       object_layer_(
           [] { return std::make_shared<llvm::SectionMemoryManager>(); }),
+      compilation_cache_(
+          compilation_cache_dir.empty()
+              ? nullptr
+              : MakeUnique<DiskCompilationCache>(compilation_cache_dir)),
       compile_layer_(
           object_layer_,
           CompilerFunctor(target_machine_.get(), &disassembler_, opt_level,
                           optimize_for_size, enable_fast_math,
                           disable_expensive_passes, GetAvailableIntrinsics(),
                           std::move(pre_optimization_hook),
-                          std::move(post_optimization_hook))) {
+                          std::move(post_optimization_hook),
+                          compilation_cache_.get(), GetObjectCache())),
+      external_constant_pool_(constant_pool_options) {
   VLOG(1) << "CPU target: " << target_machine_->getTargetCPU().str()
           << " features: " << target_machine_->getTargetFeatureString().str();
 }
@@ -204,6 +223,7 @@ bool RegisterKnownJITSymbols() {
   REGISTER_CPU_RUNTIME_SYMBOL(LogV4F32NEON);
   REGISTER_CPU_RUNTIME_SYMBOL(LogV4F32SSE);
   REGISTER_CPU_RUNTIME_SYMBOL(LogV8F32AVX);
+  REGISTER_CPU_RUNTIME_SYMBOL(NUMANode);
   REGISTER_CPU_RUNTIME_SYMBOL(ParallelForkJoin);
   REGISTER_CPU_RUNTIME_SYMBOL(ReleaseInfeedBufferAfterDequeue);
   REGISTER_CPU_RUNTIME_SYMBOL(ReleaseOutfeedBufferAfterPopulation);
@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/compiler_functor.h"
 #include "tensorflow/compiler/xla/service/cpu/disassembler.h"
 #include "tensorflow/compiler/xla/service/cpu/external_constant_pool.h"
+#include "tensorflow/compiler/xla/service/disk_compilation_cache.h"
 #include "tensorflow/compiler/xla/types.h"
 
 namespace xla {
@@ -64,11 +65,18 @@ class SimpleOrcJIT {
   // level optimizations are applied.
   // The |post_optimization_hook| is invoked on the module after all IR
   // level optimizations are applied.
+  // The |compilation_cache_dir| parameter, if not empty, is the directory of
+  // the persistent cache of the object files.
+  // The |constant_pool_options| parameter controls the placement of the
+  // constants kept outside of the generated code.
   SimpleOrcJIT(const llvm::TargetOptions& target_options,
                llvm::CodeGenOpt::Level opt_level, bool optimize_for_size,
                bool enable_fast_math, bool disable_expensive_passes,
                LLVMCompiler::ModuleHook pre_optimization_hook,
-               LLVMCompiler::ModuleHook post_optimization_hook);
+               LLVMCompiler::ModuleHook post_optimization_hook,
+               const string& compilation_cache_dir = "",
+               const ExternalConstantPool::Options& constant_pool_options =
+                   ExternalConstantPool::Options());
 
   // Data layout this JIT was created with.
   const llvm::DataLayout& data_layout() const { return data_layout_; }
@@ -101,6 +109,7 @@ class SimpleOrcJIT {
   const Disassembler disassembler_;
   const llvm::DataLayout data_layout_;
   ObjLayerT object_layer_;
+  const std::unique_ptr<DiskCompilationCache> compilation_cache_;
   CompileLayerT compile_layer_;
   ExternalConstantPool external_constant_pool_;
 };
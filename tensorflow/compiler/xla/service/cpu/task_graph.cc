@@ -0,0 +1,137 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/compiler/xla/service/cpu/task_graph.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace cpu {
+
+TaskGraph::NodeId TaskGraph::AddNode(int64 task_count,
+                                     std::function<void(int64)> fn) {
+  CHECK_GT(task_count, 0);
+  nodes_.emplace_back(new Node);
+  nodes_.back()->task_count = task_count;
+  nodes_.back()->fn = std::move(fn);
+  return nodes_.size() - 1;
+}
+
+void TaskGraph::AddDependency(NodeId predecessor, NodeId successor) {
+  CHECK_NE(predecessor, successor);
+  nodes_.at(predecessor)->successors.push_back(nodes_.at(successor).get());
+  ++nodes_.at(successor)->predecessor_count;
+}
+
+void TaskGraph::Run(tensorflow::thread::ThreadPool* thread_pool) {
+  thread_pool_ = thread_pool;
+  std::vector<Node*> ready;
+  for (const auto& node : nodes_) {
+    node->unfinished_predecessors = node->predecessor_count;
+    node->next_task = 0;
+    node->unfinished_tasks = node->task_count;
+    if (node->predecessor_count == 0) {
+      ready.push_back(node.get());
+    }
+  }
+  unfinished_nodes_ = nodes_.size();
+  for (Node* node : ready) {
+    ScheduleNode(node);
+  }
+
+  // Every node is started by a closure that is scheduled before the closure
+  // which finishes its last predecessor returns, so there are closures left
+  // until all nodes have finished.
+  tensorflow::mutex_lock l(mu_);
+  while (closures_ > 0) {
+    closures_done_.wait(l);
+  }
+  CHECK_EQ(0, unfinished_nodes_.load()) << "The task graph has a cycle";
+}
+
+void TaskGraph::ScheduleHelpers(Node* node) {
+  const int64 helpers =
+      std::min<int64>(node->task_count, thread_pool_->NumThreads()) - 1;
+  for (int64 i = 0; i < helpers; ++i) {
+    AddClosure();
+    thread_pool_->Schedule([this, node]() {
+      RunTasks(node);
+      ReleaseClosure();
+    });
+  }
+}
+
+void TaskGraph::ScheduleNode(Node* node) {
+  AddClosure();
+  thread_pool_->Schedule([this, node]() {
+    ScheduleHelpers(node);
+    RunTasks(node);
+    ReleaseClosure();
+  });
+}
+
+void TaskGraph::RunTasks(Node* node) {
+  while (node != nullptr) {
+    int64 finished = 0;
+    for (int64 task = node->next_task++; task < node->task_count;
+         task = node->next_task++) {
+      node->fn(task);
+      ++finished;
+    }
+    // Only the thread which finishes the last task finishes the node.
+    if (finished == 0 ||
+        node->unfinished_tasks.fetch_sub(finished) != finished) {
+      return;
+    }
+    node = FinishNode(node);
+    if (node != nullptr) {
+      ScheduleHelpers(node);
+    }
+  }
+}
+
+TaskGraph::Node* TaskGraph::FinishNode(Node* node) {
+  --unfinished_nodes_;
+  Node* next = nullptr;
+  for (Node* successor : node->successors) {
+    if (successor->unfinished_predecessors.fetch_sub(1) != 1) {
+      continue;
+    }
+    if (next != nullptr) {
+      ScheduleNode(next);
+    }
+    next = successor;
+  }
+  return next;
+}
+
+void TaskGraph::AddClosure() {
+  tensorflow::mutex_lock l(mu_);
+  ++closures_;
+}
+
+void TaskGraph::ReleaseClosure() {
+  tensorflow::mutex_lock l(mu_);
+  if (--closures_ == 0) {
+    closures_done_.notify_all();
+  }
+}
+
+}  // namespace cpu
+}  // namespace xla
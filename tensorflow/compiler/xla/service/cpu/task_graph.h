@@ -0,0 +1,111 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_TASK_GRAPH_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_TASK_GRAPH_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace xla {
+namespace cpu {
+
+// TaskGraph runs a directed acyclic graph of nodes on a thread pool. Each
+// node runs a function on each index of a range of tasks, e.g. the partitions
+// of an HLO instruction, once all of its predecessors have finished.
+//
+// Dependencies are tracked by atomic counters of unfinished predecessors,
+// rather than by a central scheduler: the thread that finishes the last task
+// of a node starts the successors which become ready, and runs one of them
+// itself. The tasks of a node are claimed one at a time from an atomic
+// counter by up to as many threads as the pool has, so that threads which
+// finish their tasks early take over the remaining ones. The closures that a
+// worker schedules go to its own queue of the pool, from which idle workers
+// steal them.
+//
+// A TaskGraph may be run more than once, but not concurrently.
+class TaskGraph {
+ public:
+  using NodeId = int64;
+
+  TaskGraph() {}
+
+  // Adds a node which calls "fn" once for each task index in
+  // [0, task_count), and returns its id. "task_count" must be positive.
+  NodeId AddNode(int64 task_count, std::function<void(int64)> fn);
+
+  // Makes "successor" start after "predecessor" has finished.
+  void AddDependency(NodeId predecessor, NodeId successor);
+
+  // Runs all nodes on "thread_pool" and returns once they have finished.
+  void Run(tensorflow::thread::ThreadPool* thread_pool);
+
+ private:
+  struct Node {
+    int64 task_count;
+    std::function<void(int64)> fn;
+    std::vector<Node*> successors;
+    int64 predecessor_count = 0;
+
+    // The state of a run.
+    std::atomic<int64> unfinished_predecessors{0};
+    std::atomic<int64> next_task{0};
+    std::atomic<int64> unfinished_tasks{0};
+  };
+
+  // Schedules the closures which help the calling thread run the tasks of
+  // "node".
+  void ScheduleHelpers(Node* node);
+
+  // Schedules a closure which starts "node" on the thread pool.
+  void ScheduleNode(Node* node);
+
+  // Runs tasks of "node" until none are left, then the successors that the
+  // calling thread is the one to start.
+  void RunTasks(Node* node);
+
+  // Called once all tasks of "node" have finished. Schedules all but one of
+  // the successors that became ready, and returns the remaining one, or
+  // nullptr if there is none.
+  Node* FinishNode(Node* node);
+
+  // Counts the closures scheduled on the thread pool which have not returned
+  // yet, so that Run returns only once none of them accesses the graph.
+  void AddClosure();
+  void ReleaseClosure();
+
+  std::vector<std::unique_ptr<Node>> nodes_;
+  std::atomic<int64> unfinished_nodes_{0};
+
+  tensorflow::thread::ThreadPool* thread_pool_ = nullptr;
+  tensorflow::mutex mu_;
+  tensorflow::condition_variable closures_done_;
+  int64 closures_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(TaskGraph);
+};
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_TASK_GRAPH_H_
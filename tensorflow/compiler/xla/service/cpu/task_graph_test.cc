@@ -0,0 +1,103 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/compiler/xla/service/cpu/task_graph.h"
+
+#include <atomic>
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+class TaskGraphTest : public ::testing::Test {
+ protected:
+  TaskGraphTest()
+      : thread_pool_(tensorflow::Env::Default(), "task_graph_test", 4) {}
+
+  tensorflow::thread::ThreadPool thread_pool_;
+};
+
+TEST_F(TaskGraphTest, RunsEachTaskOnce) {
+  TaskGraph graph;
+  std::vector<std::atomic<int>> runs(1000);
+  for (auto& count : runs) {
+    count = 0;
+  }
+  graph.AddNode(runs.size(), [&runs](int64 task) { ++runs[task]; });
+  graph.Run(&thread_pool_);
+  for (const auto& count : runs) {
+    EXPECT_EQ(1, count);
+  }
+}
+
+TEST_F(TaskGraphTest, RunsNodesAfterPredecessors) {
+  // A diamond of nodes, each of which records the order in which their last
+  // task finished.
+  TaskGraph graph;
+  tensorflow::mutex mu;
+  std::vector<int> order;
+  std::vector<std::atomic<int>> unfinished(4);
+  const int64 task_counts[] = {1, 3, 17, 2};
+  std::vector<TaskGraph::NodeId> nodes;
+  for (int i = 0; i < 4; ++i) {
+    unfinished[i] = task_counts[i];
+    nodes.push_back(graph.AddNode(task_counts[i], [&, i](int64 task) {
+      if (--unfinished[i] == 0) {
+        tensorflow::mutex_lock l(mu);
+        order.push_back(i);
+      }
+    }));
+  }
+  graph.AddDependency(nodes[0], nodes[1]);
+  graph.AddDependency(nodes[0], nodes[2]);
+  graph.AddDependency(nodes[1], nodes[3]);
+  graph.AddDependency(nodes[2], nodes[3]);
+  graph.Run(&thread_pool_);
+
+  ASSERT_EQ(4, order.size());
+  EXPECT_EQ(0, order[0]);
+  EXPECT_EQ(3, order[3]);
+}
+
+TEST_F(TaskGraphTest, RunsIndependentChainsAndReruns) {
+  TaskGraph graph;
+  std::atomic<int> total(0);
+  for (int chain = 0; chain < 8; ++chain) {
+    TaskGraph::NodeId previous = -1;
+    for (int i = 0; i < 10; ++i) {
+      const TaskGraph::NodeId node =
+          graph.AddNode(5, [&total](int64 task) { ++total; });
+      if (previous >= 0) {
+        graph.AddDependency(previous, node);
+      }
+      previous = node;
+    }
+  }
+  graph.Run(&thread_pool_);
+  EXPECT_EQ(8 * 10 * 5, total);
+  graph.Run(&thread_pool_);
+  EXPECT_EQ(2 * 8 * 10 * 5, total);
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,124 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/compiler/xla/service/disk_compilation_cache.h"
+
+#include <utility>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+
+namespace {
+
+// An entry is a header of kHeaderSize bytes followed by the value. The header
+// holds the magic, the fingerprint of the key, the size of the value and its
+// checksum.
+const char kMagic[] = "XLACACH1";
+const size_t kMagicSize = sizeof(kMagic) - 1;
+const size_t kHeaderSize = kMagicSize + 4 * sizeof(uint64);
+
+string EntryName(const tensorflow::Fprint128& fingerprint) {
+  return tensorflow::strings::Printf(
+      "%016llx%016llx", static_cast<unsigned long long>(fingerprint.high64),
+      static_cast<unsigned long long>(fingerprint.low64));
+}
+
+}  // namespace
+
+bool DiskCompilationCache::Lookup(const string& key, string* value) const {
+  const tensorflow::Fprint128 fingerprint = tensorflow::Fingerprint128(key);
+  const string path =
+      tensorflow::io::JoinPath(directory_, EntryName(fingerprint));
+  string contents;
+  tensorflow::Status status =
+      tensorflow::ReadFileToString(env_, path, &contents);
+  if (!status.ok()) {
+    if (!tensorflow::errors::IsNotFound(status)) {
+      LOG(WARNING) << "Failed to read compilation cache entry " << path << ": "
+                   << status;
+    }
+    return false;
+  }
+
+  const char* header = contents.data();
+  if (contents.size() < kHeaderSize ||
+      contents.compare(0, kMagicSize, kMagic) != 0 ||
+      tensorflow::core::DecodeFixed64(header + kMagicSize) !=
+          fingerprint.low64 ||
+      tensorflow::core::DecodeFixed64(header + kMagicSize + 8) !=
+          fingerprint.high64 ||
+      tensorflow::core::DecodeFixed64(header + kMagicSize + 16) !=
+          contents.size() - kHeaderSize) {
+    LOG(WARNING) << "Ignoring invalid compilation cache entry " << path;
+    return false;
+  }
+  const uint64 checksum =
+      tensorflow::core::DecodeFixed64(header + kMagicSize + 24);
+  string entry_value = contents.substr(kHeaderSize);
+  if (tensorflow::Fingerprint64(entry_value) != checksum) {
+    LOG(WARNING) << "Ignoring corrupted compilation cache entry " << path;
+    return false;
+  }
+  VLOG(1) << "Compilation cache hit for " << path;
+  *value = std::move(entry_value);
+  return true;
+}
+
+void DiskCompilationCache::Store(const string& key,
+                                 const string& value) const {
+  tensorflow::Status status = env_->RecursivelyCreateDir(directory_);
+  if (!status.ok() && !tensorflow::errors::IsAlreadyExists(status)) {
+    LOG(WARNING) << "Failed to create compilation cache directory "
+                 << directory_ << ": " << status;
+    return;
+  }
+
+  const tensorflow::Fprint128 fingerprint = tensorflow::Fingerprint128(key);
+  string contents(kMagic, kMagicSize);
+  tensorflow::core::PutFixed64(&contents, fingerprint.low64);
+  tensorflow::core::PutFixed64(&contents, fingerprint.high64);
+  tensorflow::core::PutFixed64(&contents, value.size());
+  tensorflow::core::PutFixed64(&contents, tensorflow::Fingerprint64(value));
+  contents.append(value);
+
+  // Writes to a file of its own and renames it, so that the processes that
+  // share the directory see either no entry or a complete one.
+  const string path =
+      tensorflow::io::JoinPath(directory_, EntryName(fingerprint));
+  const string temp_path = tensorflow::strings::Printf(
+      "%s.tmp.%016llx", path.c_str(),
+      static_cast<unsigned long long>(tensorflow::random::New64()));
+  status = tensorflow::WriteStringToFile(env_, temp_path, contents);
+  if (status.ok()) {
+    status = env_->RenameFile(temp_path, path);
+  }
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to write compilation cache entry " << path << ": "
+                 << status;
+    env_->DeleteFile(temp_path).IgnoreError();
+    return;
+  }
+  VLOG(1) << "Stored compilation cache entry " << path;
+}
+
+}  // namespace xla
@@ -0,0 +1,61 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_DISK_COMPILATION_CACHE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_DISK_COMPILATION_CACHE_H_
+
+#include <string>
+
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace xla {
+
+// A cache of compilation results, e.g. object files, that persists across
+// processes as the files of a directory, which may be on a filesystem shared
+// by several hosts.
+//
+// The entries are named after a 128-bit fingerprint of their key, which must
+// cover everything the result depends on: the compiled IR, the target, and
+// the compiler version and options. Each entry also records the fingerprint
+// of its key and a checksum of its value, so that truncated, corrupted or
+// colliding files are ignored. Entries are written to a temporary file and
+// renamed, so concurrent readers never see partial entries.
+class DiskCompilationCache {
+ public:
+  explicit DiskCompilationCache(
+      const string& directory,
+      tensorflow::Env* env = tensorflow::Env::Default())
+      : directory_(directory), env_(env) {}
+
+  // Returns true and sets "*value" to the value stored for "key", if the
+  // directory has a valid entry for it.
+  bool Lookup(const string& key, string* value) const;
+
+  // Stores "value" for "key", replacing any previous entry. Failures are
+  // only logged, since the cache is an optimization.
+  void Store(const string& key, const string& value) const;
+
+ private:
+  const string directory_;
+  tensorflow::Env* const env_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(DiskCompilationCache);
+};
+
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_DISK_COMPILATION_CACHE_H_
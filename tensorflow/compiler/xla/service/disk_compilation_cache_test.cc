@@ -0,0 +1,116 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/compiler/xla/service/disk_compilation_cache.h"
+
+#include <vector>
+
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace xla {
+namespace {
+
+class DiskCompilationCacheTest : public ::testing::Test {
+ protected:
+  DiskCompilationCacheTest()
+      : directory_(tensorflow::io::JoinPath(
+            tensorflow::testing::TmpDir(),
+            ::testing::UnitTest::GetInstance()->current_test_info()->name())),
+        cache_(directory_) {}
+
+  // Returns the paths of the files of the cache directory.
+  std::vector<string> Entries() {
+    std::vector<string> children;
+    TF_CHECK_OK(tensorflow::Env::Default()->GetChildren(directory_, &children));
+    std::vector<string> paths;
+    for (const string& child : children) {
+      paths.push_back(tensorflow::io::JoinPath(directory_, child));
+    }
+    return paths;
+  }
+
+  const string directory_;
+  DiskCompilationCache cache_;
+};
+
+TEST_F(DiskCompilationCacheTest, StoresAndLooksUpValues) {
+  string value;
+  EXPECT_FALSE(cache_.Lookup("key", &value));
+
+  cache_.Store("key", string("object\0code", 11));
+  cache_.Store("other key", "");
+  ASSERT_TRUE(cache_.Lookup("key", &value));
+  EXPECT_EQ(string("object\0code", 11), value);
+  ASSERT_TRUE(cache_.Lookup("other key", &value));
+  EXPECT_EQ("", value);
+  EXPECT_FALSE(cache_.Lookup("missing key", &value));
+  EXPECT_EQ(2, Entries().size());
+
+  // A second cache of the same directory, e.g. in another process, sees the
+  // same entries.
+  DiskCompilationCache other_cache(directory_);
+  ASSERT_TRUE(other_cache.Lookup("key", &value));
+  EXPECT_EQ(string("object\0code", 11), value);
+}
+
+TEST_F(DiskCompilationCacheTest, ReplacesValues) {
+  cache_.Store("key", "first");
+  cache_.Store("key", "second");
+  string value;
+  ASSERT_TRUE(cache_.Lookup("key", &value));
+  EXPECT_EQ("second", value);
+  EXPECT_EQ(1, Entries().size());
+}
+
+TEST_F(DiskCompilationCacheTest, IgnoresInvalidEntries) {
+  cache_.Store("key", "value");
+  const std::vector<string> entries = Entries();
+  ASSERT_EQ(1, entries.size());
+  string contents;
+  TF_ASSERT_OK(tensorflow::ReadFileToString(tensorflow::Env::Default(),
+                                            entries[0], &contents));
+
+  string value;
+  // A truncated entry.
+  TF_ASSERT_OK(tensorflow::WriteStringToFile(
+      tensorflow::Env::Default(), entries[0],
+      contents.substr(0, contents.size() - 1)));
+  EXPECT_FALSE(cache_.Lookup("key", &value));
+
+  // An entry whose value does not match its checksum.
+  string corrupted = contents;
+  corrupted.back() = 'X';
+  TF_ASSERT_OK(tensorflow::WriteStringToFile(tensorflow::Env::Default(),
+                                             entries[0], corrupted));
+  EXPECT_FALSE(cache_.Lookup("key", &value));
+
+  // Not an entry at all.
+  TF_ASSERT_OK(tensorflow::WriteStringToFile(tensorflow::Env::Default(),
+                                             entries[0], "value"));
+  EXPECT_FALSE(cache_.Lookup("key", &value));
+
+  // Storing the key again repairs the entry.
+  cache_.Store("key", "value");
+  ASSERT_TRUE(cache_.Lookup("key", &value));
+  EXPECT_EQ("value", value);
+}
+
+}  // namespace
+}  // namespace xla
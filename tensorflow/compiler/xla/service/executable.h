@@ -185,14 +185,19 @@ StatusOr<ReturnT> Executable::ExecuteOnStreamWrapper(
   }
 
   VLOG(1) << "enqueueing executable on stream...";
-  // If the profiling flag isn't enabled, we pass nullptr as the profile to
-  // indicate profiling is not requested.
-  HloExecutionProfile hlo_execution_profile;
-  HloExecutionProfile* profile_ptr =
+  // If neither the caller nor the profiling flag asks for an HLO profile, we
+  // pass nullptr as the profile to indicate profiling is not requested.
+  const bool log_hlo_profile =
       module_config().debug_options().xla_hlo_profile() &&
-              hlo_profiling_enabled()
-          ? &hlo_execution_profile
-          : nullptr;
+      hlo_profiling_enabled();
+  HloExecutionProfile hlo_execution_profile;
+  HloExecutionProfile* profile_ptr = nullptr;
+  if (hlo_profiling_enabled() &&
+      run_options->run_options().hlo_execution_profile() != nullptr) {
+    profile_ptr = run_options->run_options().hlo_execution_profile();
+  } else if (log_hlo_profile) {
+    profile_ptr = &hlo_execution_profile;
+  }
 
   auto return_value = ExecuteOnStream(run_options, arguments, profile_ptr);
 
@@ -221,7 +226,7 @@ StatusOr<ReturnT> Executable::ExecuteOnStreamWrapper(
     }
   }
 
-  if (profile_ptr != nullptr) {
+  if (log_hlo_profile) {
     std::unordered_set<const xla::HloComputation*> profiled_computations =
         profile_ptr->profiled_computations();
     // To ensure we have print the profiles in a stable order, iterate over the
@@ -19,9 +19,11 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
+#include "tensorflow/core/util/autotune_cache.h"
 
 namespace se = ::perftools::gputools;
 
@@ -287,6 +289,29 @@ tensorflow::Status ConvolutionThunk::ConvolveWithTune(
     se::DeviceMemory<float> output_data,
     const ConvolutionDescriptor& convolution_descriptor,
     const BufferAllocations& buffer_allocations, se::Stream* stream) {
+  // The algorithms chosen by earlier processes for the same convolution on
+  // the same kind of device, if TF_AUTOTUNE_CACHE_FILE names a file.
+  tensorflow::AutotuneCache* cache = nullptr;
+  string cache_key;
+  if (best_algorithm_.algorithm().is_default()) {
+    cache = tensorflow::AutotuneCache::Global();
+    if (cache != nullptr) {
+      cache_key = tensorflow::strings::StrCat(
+          tensorflow::AutotuneDeviceKey(stream->parent()), "/xla_",
+          ConvolutionKindToString(convolution_kind_), "/",
+          input_descriptor.ToShortString(), "/",
+          filter_descriptor.ToShortString(), "/",
+          output_descriptor.ToShortString(), "/",
+          convolution_descriptor.ToShortString());
+      std::vector<int64> values;
+      if (cache->Find(cache_key, &values) &&
+          tensorflow::AutotuneConfigFromValues(values, &best_algorithm_)) {
+        VLOG(2) << "Loaded the convolution algorithm of ConvolutionThunk "
+                << this << " from the autotune cache";
+      }
+    }
+  }
+
   // TODO(b/29126320): Try cudnn v5's new auto-tuner when it's rolled out.
   if (best_algorithm_.algorithm().is_default()) {
     // Auto-tuning either is disabled or only happens in the first run of this
@@ -339,6 +364,14 @@ tensorflow::Status ConvolutionThunk::ConvolveWithTune(
                     "to the default algorithm.";
       best_algorithm_.set_algorithm_no_scratch(AlgorithmDesc());
     }
+
+    if (cache != nullptr && best_result.is_valid()) {
+      tensorflow::Status s = cache->Insert(
+          cache_key, tensorflow::AutotuneConfigToValues(best_algorithm_));
+      if (!s.ok()) {
+        LOG(WARNING) << "Failed to store the convolution algorithm: " << s;
+      }
+    }
   }
 
   {
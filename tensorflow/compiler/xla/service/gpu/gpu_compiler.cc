@@ -19,10 +19,12 @@ limitations under the License.
 #include <functional>
 #include <utility>
 
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/DiagnosticPrinter.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
 #include "tensorflow/compiler/xla/protobuf_util.h"
 #include "tensorflow/compiler/xla/ptr_util.h"
 #include "tensorflow/compiler/xla/service/algebraic_simplifier.h"
@@ -30,6 +32,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
 #include "tensorflow/compiler/xla/service/buffer_liveness.h"
 #include "tensorflow/compiler/xla/service/call_inliner.h"
+#include "tensorflow/compiler/xla/service/disk_compilation_cache.h"
 #include "tensorflow/compiler/xla/service/flatten_call_graph.h"
 #include "tensorflow/compiler/xla/service/gpu/convolution_folding.h"
 #include "tensorflow/compiler/xla/service/gpu/copy_insertion.h"
@@ -42,6 +45,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/ir_emitter_context.h"
 #include "tensorflow/compiler/xla/service/gpu/layout_assignment.h"
 #include "tensorflow/compiler/xla/service/gpu/llvm_gpu_backend/gpu_backend_lib.h"
+#include "tensorflow/compiler/xla/service/gpu/multi_output_fusion.h"
 #include "tensorflow/compiler/xla/service/gpu/pad_insertion.h"
 #include "tensorflow/compiler/xla/service/gpu/partition_assignment.h"
 #include "tensorflow/compiler/xla/service/gpu/stream_assignment.h"
@@ -66,6 +70,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cuda_libdevice_path.h"
@@ -173,6 +178,7 @@ tensorflow::Status OptimizeHloModule(
     fusion.AddPass<GpuInstructionFusion>(/*may_duplicate=*/false);
     fusion.AddPass<GpuInstructionFusion>(/*may_duplicate=*/true);
     fusion.AddPass<FusionMerger>();
+    fusion.AddPass<MultiOutputFusion>();
     TF_RETURN_IF_ERROR(fusion.Run(hlo_module).status());
 
     HloPassPipeline reduce_pipeline("reduce-precision");
@@ -268,6 +274,27 @@ void DumpPtxasInfo(const string& ptx, int cc_major, int cc_minor) {
   }
 }
 
+// Returns the key of the PTX of the unoptimized "llvm_module" in the
+// compilation cache, which covers the module and every option of its
+// compilation. The bitcode records the version of LLVM that produced it, and
+// the version of the key format is bumped whenever the PTX generation changes
+// outside of LLVM.
+string PtxCacheKey(const llvm::Module& llvm_module, int cc_major, int cc_minor,
+                   const HloModuleConfig& config,
+                   const string& libdevice_dir) {
+  DebugOptions debug_options = config.debug_options();
+  debug_options.clear_xla_compilation_cache_dir();
+  string serialized_options;
+  CHECK(tensorflow::SerializeToStringDeterministic(debug_options,
+                                                   &serialized_options));
+  string key = StrCat("xla_gpu_ptx_v1", string(1, '\0'), cc_major, ".",
+                      cc_minor, string(1, '\0'), libdevice_dir,
+                      string(1, '\0'), serialized_options, string(1, '\0'));
+  llvm::raw_string_ostream stream(key);
+  llvm::WriteBitcodeToFile(&llvm_module, stream);
+  return stream.str();
+}
+
 }  // namespace
 
 GpuCompiler::GpuCompiler()
@@ -378,8 +405,26 @@ StatusOr<std::unique_ptr<Executable>> GpuCompiler::Compile(
     // Compute libdevice_dir_ just once and cache it in this member.
     libdevice_dir_ = GetLibdeviceDir(module->config());
   }
-  TF_ASSIGN_OR_RETURN(*ptx, CompileToPtx(&llvm_module, {cc_major, cc_minor},
-                                         module->config(), libdevice_dir_));
+  // The dumps and the hook must see the optimized IR, so they bypass the
+  // cache.
+  const string& cache_dir =
+      module->config().debug_options().xla_compilation_cache_dir();
+  std::unique_ptr<DiskCompilationCache> cache;
+  string cache_key;
+  if (!cache_dir.empty() && ir_dump_directory.empty() &&
+      !user_post_optimization_hook_) {
+    cache = MakeUnique<DiskCompilationCache>(cache_dir);
+    cache_key = PtxCacheKey(llvm_module, cc_major, cc_minor, module->config(),
+                            libdevice_dir_);
+  }
+  if (cache == nullptr || !cache->Lookup(cache_key, ptx)) {
+    TF_ASSIGN_OR_RETURN(*ptx,
+                        CompileToPtx(&llvm_module, {cc_major, cc_minor},
+                                     module->config(), libdevice_dir_));
+    if (cache != nullptr) {
+      cache->Store(cache_key, *ptx);
+    }
+  }
 
   if (!ir_dump_directory.empty()) {
     TF_RETURN_IF_ERROR(llvm_ir::DumpIRToDirectory(
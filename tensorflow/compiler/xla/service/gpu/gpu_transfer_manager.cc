@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/gpu/gpu_transfer_manager.h"
 
+#include <cstring>
 #include <string>
 #include <utility>
 #include <vector>
@@ -101,15 +102,14 @@ Status GpuTransferManager::EnqueueBuffersToInfeed(
   gpu::InfeedManager* infeed_manager = gpu::GetOrCreateInfeedManager();
   se::Stream* stream = infeed_manager->GetStream(executor);
 
-  // TODO(b/30467474): Since this stream is shared across different
-  // infeed requests, blocking on the stream might be
-  // heavy-handed. Figure out if finer-grained acknowledgement is
-  // possible.
-  if (!stream->BlockHostUntilDone()) {
+  // The buffers are enqueued while their transfers are in flight; the
+  // runtime waits for their populated() events before reading them, so
+  // the transfers overlap the computation that runs meanwhile.
+  if (!stream->ok()) {
     for (gpu::InfeedBuffer* b : buffers) {
       b->Done();
     }
-    return InternalError("Failed to complete data transfer on stream %p",
+    return InternalError("Failed to initiate data transfer on stream %p",
                          stream);
   }
 
@@ -136,8 +136,12 @@ StatusOr<gpu::InfeedBuffer*> GpuTransferManager::TransferBufferToInfeedInternal(
     return InternalError("Failed to obtain a stream");
   }
 
-  gpu::InfeedBuffer* buffer = new gpu::InfeedBuffer(executor, size);
-  stream->ThenMemcpy(buffer->device_memory(), source, size);
+  // Copies the data to the pinned host memory of the buffer, so that the
+  // caller may reuse "source" while the transfer to the device runs.
+  gpu::InfeedBuffer* buffer = infeed_manager->AcquireBuffer(executor, size);
+  std::memcpy(buffer->host_memory(), source, size);
+  stream->ThenMemcpy(buffer->device_memory(), buffer->host_memory(), size);
+  stream->ThenRecordEvent(buffer->populated());
 
   VLOG(2) << "Queued infeed data on stream " << stream;
 
@@ -43,13 +43,13 @@ class GpuTransferManager : public GenericTransferManager {
 
  private:
   // Initiates the infeed data transfers. InfeedBuffer->Done() must be
-  // called to clean up the memory allocated for InfeedBuffer.
+  // called to return the InfeedBuffer to the infeed manager.
   StatusOr<gpu::InfeedBuffer*> TransferBufferToInfeedInternal(
       perftools::gputools::StreamExecutor* executor, int64 size,
       const void* source);
 
-  // Enqueues infeed data buffers with the infeed manager after their
-  // transfer completes.
+  // Enqueues infeed data buffers with the infeed manager once their
+  // transfers are initiated.
   Status EnqueueBuffersToInfeed(perftools::gputools::StreamExecutor* executor,
                                 std::vector<gpu::InfeedBuffer*> buffers);
 
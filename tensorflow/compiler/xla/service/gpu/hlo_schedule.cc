@@ -193,9 +193,14 @@ StatusOr<std::unique_ptr<HloSchedule>> HloSchedule::Build(
 
   // Initialize thunk_launch_order_, the total order of thunk launches.
   const HloComputation* entry_computation = module.entry_computation();
-  if (stream_assignment.StreamCount() == 1) {
+  if (stream_assignment.StreamCount() == 1 ||
+      module.config()
+          .debug_options()
+          .xla_gpu_minimize_memory_across_streams()) {
     // All kernels are launched on a single stream, so there's no loss of
-    // concurrency by optimizing for minimal memory usage.
+    // concurrency by optimizing for minimal memory usage. Otherwise the launch
+    // order still determines which kernels on different streams may overlap,
+    // and the user asked to give up some of that concurrency for memory.
     TF_ASSIGN_OR_RETURN(
         schedule->thunk_launch_order_,
         CreateMemoryMinimizingSequence(
@@ -24,15 +24,49 @@ namespace se = ::perftools::gputools;
 namespace xla {
 namespace gpu {
 
+namespace {
+
+// The number of released buffers that are kept for reuse. Each infeed
+// of a loop uses a buffer per tuple element, and the client usually
+// enqueues the buffers of the next iterations while the current one
+// runs, so this keeps a few iterations' worth of buffers.
+const int64 kMaxFreeBuffers = 16;
+
+}  // namespace
+
+InfeedBuffer::InfeedBuffer(se::StreamExecutor* executor, int64 length)
+    : executor_(executor), length_(length), populated_(executor) {
+  device_memory_ = executor_->AllocateArray<uint8>(length);
+  CHECK(!device_memory_.is_null());
+  host_memory_ = executor_->HostMemoryAllocate(length);
+  CHECK(host_memory_ != nullptr);
+  CHECK(populated_.Init());
+}
+
+InfeedBuffer::~InfeedBuffer() {
+  executor_->HostMemoryDeallocate(host_memory_);
+  executor_->Deallocate(&device_memory_);
+}
+
+void InfeedBuffer::Done() { GetOrCreateInfeedManager()->ReturnBuffer(this); }
+
 InfeedManager::InfeedManager() : host_to_device_executor_(nullptr) {}
 
 void InfeedManager::Reset() {
-  tensorflow::mutex_lock l(mu_);
-  CHECK(dequeued_buffer_.empty());
-  for (auto buffer : enqueued_buffer_) {
+  std::deque<InfeedBuffer*> buffers;
+  {
+    tensorflow::mutex_lock l(mu_);
+    CHECK(dequeued_buffer_.empty());
+    buffers.swap(enqueued_buffer_);
+  }
+  // The buffers may still be populated by the host to device stream, and
+  // may only be reused once that is done.
+  if (!buffers.empty() && host_to_device_stream_ != nullptr) {
+    host_to_device_stream_->BlockHostUntilDone();
+  }
+  for (auto buffer : buffers) {
     buffer->Done();
   }
-  enqueued_buffer_.clear();
 }
 
 void InfeedManager::EnqueueBuffers(const std::vector<InfeedBuffer*>& buffers) {
@@ -74,6 +108,38 @@ void InfeedManager::ReleaseBuffers(const std::vector<InfeedBuffer*>& buffers) {
   }
 }
 
+InfeedBuffer* InfeedManager::AcquireBuffer(se::StreamExecutor* executor,
+                                           int64 length) {
+  {
+    tensorflow::mutex_lock l(mu_);
+    auto it = free_buffers_.find(length);
+    if (it != free_buffers_.end()) {
+      std::vector<InfeedBuffer*>& buffers = it->second;
+      for (size_t i = 0; i < buffers.size(); ++i) {
+        InfeedBuffer* buffer = buffers[i];
+        if (buffer->executor() != executor) continue;
+        buffers.erase(buffers.begin() + i);
+        if (buffers.empty()) free_buffers_.erase(it);
+        --num_free_buffers_;
+        return buffer;
+      }
+    }
+  }
+  return new InfeedBuffer(executor, length);
+}
+
+void InfeedManager::ReturnBuffer(InfeedBuffer* buffer) {
+  {
+    tensorflow::mutex_lock l(mu_);
+    if (num_free_buffers_ < kMaxFreeBuffers) {
+      free_buffers_[buffer->length()].push_back(buffer);
+      ++num_free_buffers_;
+      return;
+    }
+  }
+  delete buffer;
+}
+
 se::Stream* InfeedManager::GetStream(se::StreamExecutor* executor) {
   if (host_to_device_executor_ == nullptr) {
     host_to_device_executor_ = executor;
@@ -21,6 +21,8 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_INFEED_MANAGER_H_
 
 #include <deque>
+#include <map>
+#include <vector>
 
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
@@ -37,37 +39,47 @@ namespace gpu {
 // Current limitations:
 // * Does not handle multiple devices/replicas.
 //
-// * Buffer space on GPU is allocated on every infeed enqueue request,
-// and it does not handle the case when it runs out of
-// memory. Potential solution is to pre-allocate a fixed amount of
-// memory and block when that memory is full.
+// * Buffers that are enqueued faster than the runtime dequeues them
+// are not bounded, and it does not handle the case when the device
+// runs out of memory. Potential solution is to block the enqueue when
+// a fixed amount of memory is in use.
 
 // Defines an infeed buffer that is passed to the runtime by
 // the client. The client manages the memory of the buffer.
+//
+// Each buffer has device memory and pinned host memory of its length,
+// so that it can be populated asynchronously: the client copies its data
+// to the host memory and enqueues a copy to the device memory on the
+// host-to-device stream of the InfeedManager, and the runtime waits for
+// the populated() event on its own stream before reading the buffer.
 class InfeedBuffer {
  public:
-  InfeedBuffer(perftools::gputools::StreamExecutor* executor, int64 length)
-      : executor_(executor), length_(length) {
-    device_memory_ = executor_->AllocateArray<uint8>(length);
-    CHECK(!device_memory_.is_null());
-  }
-
-  ~InfeedBuffer() { executor_->Deallocate(&device_memory_); }
+  InfeedBuffer(perftools::gputools::StreamExecutor* executor, int64 length);
+  ~InfeedBuffer();
 
   int64 length() const { return length_; }
+  perftools::gputools::StreamExecutor* executor() const { return executor_; }
 
-  // Callback to signal that this buffer is consumed. This helps the
-  // client to manage memory for the infeed buffers.
-  void Done() { delete this; }
+  // Callback to signal that this buffer is consumed. Returns the buffer
+  // to the InfeedManager, which reuses it for a later enqueue of the
+  // same length.
+  void Done();
 
   perftools::gputools::DeviceMemoryBase* device_memory() {
     return &device_memory_;
   }
+  void* host_memory() { return host_memory_; }
+
+  // Recorded on the host-to-device stream after the copy to the device
+  // memory.
+  perftools::gputools::Event* populated() { return &populated_; }
 
  private:
   perftools::gputools::StreamExecutor* executor_;  // Not owned.
   const int64 length_;
   perftools::gputools::DeviceMemoryBase device_memory_;
+  void* host_memory_;
+  perftools::gputools::Event populated_;
 };
 
 // Client-side class used to enqueue infeed buffers.
@@ -96,6 +108,12 @@ class InfeedManager {
   // Releases a set of buffers from the to-be released set.
   void ReleaseBuffers(const std::vector<InfeedBuffer*>& buffers);
 
+  // Returns a buffer of the given length for an enqueue, which is one of
+  // the buffers of that length that were released earlier, if any, and a
+  // new one otherwise. buffer->Done makes it available again.
+  InfeedBuffer* AcquireBuffer(perftools::gputools::StreamExecutor* executor,
+                              int64 length);
+
   // Returns a cached stream associated with an executor. Allocates a
   // new stream on the first invocation. On subsequent invocations, if
   // the cached executor is not the same as the requested executor,
@@ -104,6 +122,12 @@ class InfeedManager {
       perftools::gputools::StreamExecutor* executor);
 
  private:
+  friend class InfeedBuffer;
+
+  // Keeps a buffer that is done for a later AcquireBuffer, or deletes it
+  // if enough buffers are kept already.
+  void ReturnBuffer(InfeedBuffer* buffer);
+
   // TODO(b/30467474): Revisit if this mutex becomes a point of
   // contention.
   tensorflow::mutex mu_;
@@ -120,6 +144,10 @@ class InfeedManager {
   // runtime. Not owned.
   tensorflow::gtl::FlatSet<const InfeedBuffer*> dequeued_buffer_;
 
+  // Buffers that are done and can be reused, by length. Owned.
+  std::map<int64, std::vector<InfeedBuffer*>> free_buffers_;
+  int64 num_free_buffers_ = 0;
+
   // Cached host to device stream for queuing infeed data.
   std::unique_ptr<perftools::gputools::Stream> host_to_device_stream_;
 
@@ -51,6 +51,7 @@ tensorflow::Status InfeedThunk::ExecuteOnStream(
 
       InfeedBuffer* buffer = infeed_manager->BlockingDequeueBuffer();
       infeed_buffers.push_back(buffer);
+      stream->ThenWaitFor(buffer->populated());
       stream->ThenMemcpy(&tuple_element_address, *(buffer->device_memory()),
                          buffer->length());
       tuple_element_addresses.push_back(tuple_element_address.opaque());
@@ -62,6 +63,7 @@ tensorflow::Status InfeedThunk::ExecuteOnStream(
   } else {
     InfeedBuffer* buffer = infeed_manager->BlockingDequeueBuffer();
     infeed_buffers.push_back(buffer);
+    stream->ThenWaitFor(buffer->populated());
     stream->ThenMemcpy(&destination_address, *(buffer->device_memory()),
                        buffer->length());
   }
@@ -0,0 +1,190 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/compiler/xla/service/gpu/multi_output_fusion.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/compiler/xla/service/call_graph.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/service/hlo_reachability.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace gpu {
+
+constexpr int64 MultiOutputFusion::kMaxOutputs;
+
+namespace {
+
+// Returns the shape of the loop that computes "instruction", i.e. the shape of
+// its first output if it is a multi-output fusion.
+const Shape& LoopShape(const HloInstruction& instruction) {
+  return instruction.IsMultiOutputFusion()
+             ? ShapeUtil::GetSubshape(instruction.shape(), {0})
+             : instruction.shape();
+}
+
+int64 OutputCount(const HloInstruction& instruction) {
+  return instruction.IsMultiOutputFusion()
+             ? ShapeUtil::TupleElementCount(instruction.shape())
+             : 1;
+}
+
+// Returns true if the buffer of "instruction" may be an output of its
+// computation, i.e. if it reaches the root only through instructions that
+// forward their operands' buffers.
+bool MayBeLiveOut(const HloInstruction& instruction) {
+  if (&instruction == instruction.parent()->root_instruction()) {
+    return true;
+  }
+  for (const HloInstruction* user : instruction.users()) {
+    if ((user->opcode() == HloOpcode::kTuple ||
+         user->opcode() == HloOpcode::kGetTupleElement ||
+         user->opcode() == HloOpcode::kBitcast) &&
+        MayBeLiveOut(*user)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns true if "instruction" is a loop fusion or an elementwise instruction
+// that can be an output of a multi-output fusion.
+bool IsCandidate(const HloInstruction& instruction) {
+  if (instruction.opcode() == HloOpcode::kFusion) {
+    // Fusions whose root is a dynamic-update-slice are emitted in place.
+    if (instruction.fusion_kind() != HloInstruction::FusionKind::kLoop ||
+        instruction.fused_expression_root()->opcode() ==
+            HloOpcode::kDynamicUpdateSlice) {
+      return false;
+    }
+  } else if (!instruction.IsElementwise() || !instruction.IsFusable() ||
+             instruction.operand_count() == 0 ||
+             ShapeUtil::IsTuple(instruction.shape())) {
+    return false;
+  }
+  return instruction.user_count() > 0 && !MayBeLiveOut(instruction);
+}
+
+bool CanFuseOutputs(const HloInstruction& a, const HloInstruction& b) {
+  return ShapeUtil::SameDimensions(LoopShape(a), LoopShape(b)) &&
+         OutputCount(a) + OutputCount(b) <= MultiOutputFusion::kMaxOutputs;
+}
+
+// Returns true if "producer" can be fused into its user "consumer", while
+// keeping its output for its other users.
+bool CanFuseProducer(const HloReachabilityMap& reachability,
+                     const HloInstruction& producer,
+                     const HloInstruction& consumer) {
+  if (producer.user_count() < 2 || !IsCandidate(producer) ||
+      !CanFuseOutputs(producer, consumer)) {
+    return false;
+  }
+  // The fusion would be both an operand and a user of the other users of the
+  // producer that depend on "consumer".
+  for (const HloInstruction* user : producer.users()) {
+    if (user != &consumer && reachability.IsReachable(user, &consumer)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if "sibling", which shares an operand with "consumer", can be
+// fused into it.
+bool CanFuseSibling(const HloReachabilityMap& reachability,
+                    const HloInstruction& sibling,
+                    const HloInstruction& consumer) {
+  return &sibling != &consumer && IsCandidate(sibling) &&
+         CanFuseOutputs(sibling, consumer) &&
+         !reachability.IsConnected(&sibling, &consumer);
+}
+
+// Fuses "instruction" into "consumer" as a new output.
+void Fuse(HloInstruction* instruction, HloInstruction* consumer) {
+  VLOG(2) << "Fusing " << instruction->ToShortString() << " into "
+          << consumer->ToShortString();
+  HloComputation* computation = consumer->parent();
+  HloInstruction* fusion = consumer;
+  if (fusion->opcode() != HloOpcode::kFusion) {
+    fusion = computation->CreateFusionInstruction(
+        {consumer}, HloInstruction::FusionKind::kLoop);
+  }
+  if (instruction->opcode() == HloOpcode::kFusion) {
+    fusion->MergeFusionInstructionIntoMultiOutput(instruction);
+  } else {
+    fusion->FuseInstructionIntoMultiOutput(instruction);
+    TF_CHECK_OK(computation->RemoveInstruction(instruction));
+  }
+}
+
+// Fuses one pair of instructions of "computation", and returns whether it
+// found one.
+bool FuseOnePair(HloComputation* computation) {
+  std::unique_ptr<HloReachabilityMap> reachability =
+      computation->ComputeReachability();
+  for (HloInstruction* consumer : computation->MakeInstructionPostOrder()) {
+    if (!IsCandidate(*consumer)) {
+      continue;
+    }
+    for (HloInstruction* operand : consumer->operands()) {
+      if (CanFuseProducer(*reachability, *operand, *consumer)) {
+        Fuse(operand, consumer);
+        return true;
+      }
+    }
+    for (HloInstruction* operand : consumer->operands()) {
+      // Sharing a scalar does not save any memory traffic.
+      if (ShapeUtil::IsScalar(operand->shape())) {
+        continue;
+      }
+      for (HloInstruction* sibling : operand->users()) {
+        if (CanFuseSibling(*reachability, *sibling, *consumer)) {
+          Fuse(sibling, consumer);
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+StatusOr<bool> MultiOutputFusion::Run(HloModule* module) {
+  std::unique_ptr<CallGraph> call_graph = CallGraph::Build(module);
+  bool changed = false;
+  for (HloComputation* computation : module->MakeNonfusionComputations()) {
+    // Computations that are applied to each element of an array, e.g. by a
+    // map or a reduce, are emitted as nested scalar functions.
+    if (call_graph->GetNode(computation).context() !=
+        CallContext::kSequential) {
+      continue;
+    }
+    while (FuseOnePair(computation)) {
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+}  // namespace gpu
+}  // namespace xla
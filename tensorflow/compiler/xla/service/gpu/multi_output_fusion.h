@@ -0,0 +1,56 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_MULTI_OUTPUT_FUSION_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_MULTI_OUTPUT_FUSION_H_
+
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+
+namespace xla {
+namespace gpu {
+
+// An HLO pass that fuses loop fusions and elementwise instructions into
+// fusion instructions with several outputs, so that the inputs they share are
+// read from memory once and their outputs are computed by a single kernel.
+//
+// Two kinds of instructions are fused:
+//
+// 1) Siblings: two instructions that read the same operand and that do not
+//    depend on each other.
+// 2) A producer and one of its consumers, if the producer has other users that
+//    still need its output.
+//
+// The fused instructions must compute outputs with the same dimensions, which
+// are all written by the same loop. Instructions whose outputs may be outputs
+// of their computation are not fused, since kernels can not write the elements
+// of a tuple output to output buffers.
+class MultiOutputFusion : public HloPassInterface {
+ public:
+  tensorflow::StringPiece name() const override {
+    return "multi-output fusion";
+  }
+
+  StatusOr<bool> Run(HloModule* module) override;
+
+  // The maximum number of outputs of a multi-output fusion instruction.
+  static constexpr int64 kMaxOutputs = 8;
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_MULTI_OUTPUT_FUSION_H_
@@ -0,0 +1,158 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/compiler/xla/service/gpu/multi_output_fusion.h"
+
+#include "tensorflow/compiler/xla/service/hlo_matchers.h"
+#include "tensorflow/compiler/xla/test_helpers.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+
+namespace op = xla::testing::opcode_matchers;
+
+namespace xla {
+namespace gpu {
+namespace {
+
+class MultiOutputFusionTest : public HloTestBase {
+ protected:
+  HloInstruction* AddUnary(HloComputation::Builder* builder, HloOpcode opcode,
+                           HloInstruction* operand) {
+    return builder->AddInstruction(
+        HloInstruction::CreateUnary(shape_, opcode, operand));
+  }
+
+  HloInstruction* AddBinary(HloComputation::Builder* builder, HloOpcode opcode,
+                            HloInstruction* lhs, HloInstruction* rhs) {
+    return builder->AddInstruction(
+        HloInstruction::CreateBinary(shape_, opcode, lhs, rhs));
+  }
+
+  const Shape shape_ = ShapeUtil::MakeShape(F32, {16, 32});
+};
+
+TEST_F(MultiOutputFusionTest, FusesSiblings) {
+  auto builder = HloComputation::Builder(TestName());
+  auto param =
+      builder.AddInstruction(HloInstruction::CreateParameter(0, shape_, "p"));
+  auto exp = AddUnary(&builder, HloOpcode::kExp, param);
+  auto negate = AddUnary(&builder, HloOpcode::kNegate, param);
+  AddBinary(&builder, HloOpcode::kAdd, exp, negate);
+
+  auto module = CreateNewModule();
+  auto computation = module->AddEntryComputation(builder.Build());
+  EXPECT_TRUE(MultiOutputFusion().Run(module.get()).ValueOrDie());
+
+  HloInstruction* root = computation->root_instruction();
+  EXPECT_THAT(root, op::Add(op::GetTupleElement(op::Fusion()),
+                            op::GetTupleElement(op::Fusion())));
+  HloInstruction* fusion = root->mutable_operand(0)->mutable_operand(0);
+  EXPECT_EQ(fusion, root->operand(1)->operand(0));
+  EXPECT_NE(root->operand(0)->tuple_index(), root->operand(1)->tuple_index());
+  EXPECT_THAT(fusion->operands(), ::testing::ElementsAre(param));
+  EXPECT_THAT(fusion->fused_expression_root(),
+              op::Tuple(::testing::AnyOf(op::Exp(), op::Negate()),
+                        ::testing::AnyOf(op::Exp(), op::Negate())));
+}
+
+TEST_F(MultiOutputFusionTest, FusesProducerWithOtherUsers) {
+  auto builder = HloComputation::Builder(TestName());
+  auto param =
+      builder.AddInstruction(HloInstruction::CreateParameter(0, shape_, "p"));
+  auto exp = AddUnary(&builder, HloOpcode::kExp, param);
+  auto negate = AddUnary(&builder, HloOpcode::kNegate, exp);
+  AddBinary(&builder, HloOpcode::kAdd, exp, negate);
+
+  auto module = CreateNewModule();
+  auto computation = module->AddEntryComputation(builder.Build());
+  EXPECT_TRUE(MultiOutputFusion().Run(module.get()).ValueOrDie());
+
+  HloInstruction* root = computation->root_instruction();
+  EXPECT_THAT(root, op::Add(op::GetTupleElement(op::Fusion()),
+                            op::GetTupleElement(op::Fusion())));
+  HloInstruction* fusion = root->mutable_operand(0)->mutable_operand(0);
+  EXPECT_EQ(fusion, root->operand(1)->operand(0));
+  EXPECT_THAT(fusion->operands(), ::testing::ElementsAre(param));
+  EXPECT_THAT(fusion->fused_expression_root(),
+              op::Tuple(op::Negate(op::Exp()), op::Exp()));
+}
+
+TEST_F(MultiOutputFusionTest, DoesNotFuseDependentSiblings) {
+  // "exp" and "add" share "param", but "add" also uses "exp", which has no
+  // other user.
+  auto builder = HloComputation::Builder(TestName());
+  auto param =
+      builder.AddInstruction(HloInstruction::CreateParameter(0, shape_, "p"));
+  auto exp = AddUnary(&builder, HloOpcode::kExp, param);
+  auto add = AddBinary(&builder, HloOpcode::kAdd, param, exp);
+  AddUnary(&builder, HloOpcode::kNegate, add);
+
+  auto module = CreateNewModule();
+  module->AddEntryComputation(builder.Build());
+  EXPECT_FALSE(MultiOutputFusion().Run(module.get()).ValueOrDie());
+}
+
+TEST_F(MultiOutputFusionTest, DoesNotFuseProducerIfCycle) {
+  // Fusing "exp" into "add" would make the fusion both an operand and a user
+  // of "negate".
+  auto builder = HloComputation::Builder(TestName());
+  auto param =
+      builder.AddInstruction(HloInstruction::CreateParameter(0, shape_, "p"));
+  auto exp = AddUnary(&builder, HloOpcode::kExp, param);
+  auto negate = AddUnary(&builder, HloOpcode::kNegate, exp);
+  auto add = AddBinary(&builder, HloOpcode::kAdd, exp, negate);
+  AddUnary(&builder, HloOpcode::kTanh, add);
+
+  auto module = CreateNewModule();
+  auto computation = module->AddEntryComputation(builder.Build());
+  MultiOutputFusion().Run(module.get()).ValueOrDie();
+  // "exp" may still be fused into "negate", whose output "add" also needs.
+  EXPECT_THAT(computation->root_instruction(), op::Tanh(op::Add()));
+}
+
+TEST_F(MultiOutputFusionTest, DoesNotFuseOutputsOfComputation) {
+  auto builder = HloComputation::Builder(TestName());
+  auto param =
+      builder.AddInstruction(HloInstruction::CreateParameter(0, shape_, "p"));
+  auto exp = AddUnary(&builder, HloOpcode::kExp, param);
+  auto negate = AddUnary(&builder, HloOpcode::kNegate, param);
+  builder.AddInstruction(HloInstruction::CreateTuple({exp, negate}));
+
+  auto module = CreateNewModule();
+  module->AddEntryComputation(builder.Build());
+  EXPECT_FALSE(MultiOutputFusion().Run(module.get()).ValueOrDie());
+}
+
+TEST_F(MultiOutputFusionTest, DoesNotFuseDifferentShapes) {
+  auto builder = HloComputation::Builder(TestName());
+  auto param =
+      builder.AddInstruction(HloInstruction::CreateParameter(0, shape_, "p"));
+  auto exp = AddUnary(&builder, HloOpcode::kExp, param);
+  auto transpose = builder.AddInstruction(HloInstruction::CreateTranspose(
+      ShapeUtil::MakeShape(F32, {32, 16}), param, {1, 0}));
+  auto negate = builder.AddInstruction(HloInstruction::CreateUnary(
+      transpose->shape(), HloOpcode::kNegate, transpose));
+  auto reshape = builder.AddInstruction(
+      HloInstruction::CreateReshape(shape_, negate));
+  AddBinary(&builder, HloOpcode::kAdd, exp, reshape);
+
+  auto module = CreateNewModule();
+  module->AddEntryComputation(builder.Build());
+  EXPECT_FALSE(MultiOutputFusion().Run(module.get()).ValueOrDie());
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
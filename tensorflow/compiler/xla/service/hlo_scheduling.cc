@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/hlo_scheduling.h"
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -364,6 +365,80 @@ StatusOr<int64> MinimumMemoryForComputation(
   return result.heap_size;
 }
 
+// Lowers the peak memory "*memory" of "*sequence", an ordering of
+// "computation", by local search: each instruction in turn is moved as early
+// as its operands allow, or as late as its users allow, and the move is kept
+// if the heap simulator finds that it lowers the peak memory. The search
+// stops when a pass over the instructions keeps no move, or after "budget"
+// simulations.
+Status SearchMemoryMinimizingSequence(
+    const HloComputation& computation,
+    const TuplePointsToAnalysis& points_to_analysis,
+    const LogicalBuffer::SizeFunction& size_function, int64 budget,
+    std::vector<const HloInstruction*>* sequence, int64* memory) {
+  tensorflow::gtl::FlatMap<const HloInstruction*, int64> positions;
+  auto update_positions = [&positions, sequence]() {
+    for (int64 i = 0; i < sequence->size(); ++i) {
+      positions[(*sequence)[i]] = i;
+    }
+  };
+  update_positions();
+
+  int64 simulations = 0;
+  bool improved = true;
+  while (improved && simulations < budget) {
+    improved = false;
+    const std::vector<const HloInstruction*> instructions = *sequence;
+    for (const HloInstruction* hlo : instructions) {
+      if (simulations >= budget) {
+        break;
+      }
+      if (ListScheduler::IgnoreInstruction(*hlo)) {
+        continue;
+      }
+      const int64 position = positions.at(hlo);
+      int64 earliest = 0;
+      for (const HloInstruction* pred : hlo->operands()) {
+        earliest = std::max(earliest, positions.at(pred) + 1);
+      }
+      for (const HloInstruction* pred : hlo->control_predecessors()) {
+        earliest = std::max(earliest, positions.at(pred) + 1);
+      }
+      int64 latest = sequence->size() - 1;
+      for (const HloInstruction* succ : hlo->users()) {
+        latest = std::min(latest, positions.at(succ) - 1);
+      }
+      for (const HloInstruction* succ : hlo->control_successors()) {
+        latest = std::min(latest, positions.at(succ) - 1);
+      }
+
+      for (const int64 target : {earliest, latest}) {
+        if (target == position || simulations >= budget) {
+          continue;
+        }
+        std::vector<const HloInstruction*> candidate(*sequence);
+        candidate.erase(candidate.begin() + position);
+        candidate.insert(candidate.begin() + target, hlo);
+        ++simulations;
+        TF_ASSIGN_OR_RETURN(
+            const int64 candidate_memory,
+            MinimumMemoryForComputation(computation, candidate,
+                                        points_to_analysis, size_function));
+        if (candidate_memory < *memory) {
+          *sequence = std::move(candidate);
+          *memory = candidate_memory;
+          update_positions();
+          improved = true;
+          break;
+        }
+      }
+    }
+  }
+  VLOG(2) << "Min-memory search: " << *memory << " bytes after "
+          << simulations << " simulations";
+  return Status::OK();
+}
+
 StatusOr<std::vector<const HloInstruction*>> CreateMemoryMinimizingSequence(
     const HloComputation& computation,
     const TuplePointsToAnalysis& points_to_analysis,
@@ -393,13 +468,30 @@ StatusOr<std::vector<const HloInstruction*>> CreateMemoryMinimizingSequence(
                                   size_function));
   VLOG(2) << "Min-memory dfs sequence: " << dfs_memory << " bytes";
 
+  std::vector<const HloInstruction*> sequence;
+  int64 memory;
   if (list_memory <= dfs_memory) {
     VLOG(2) << "Chose min-memory list sequence: " << list_memory << " bytes";
-    return list_sequence;
+    sequence = std::move(list_sequence);
+    memory = list_memory;
   } else {
     VLOG(2) << "Chose min-memory dfs sequence: " << dfs_memory << " bytes";
-    return dfs_sequence;
+    sequence = std::move(dfs_sequence);
+    memory = dfs_memory;
   }
+
+  // The search evaluates many orderings, so it is only run when a budget of
+  // simulations is given for it.
+  const int64 budget = computation.parent()
+                           ->config()
+                           .debug_options()
+                           .xla_scheduler_search_budget();
+  if (budget > 0) {
+    TF_RETURN_IF_ERROR(SearchMemoryMinimizingSequence(
+        computation, points_to_analysis, size_function, budget, &sequence,
+        &memory));
+  }
+  return sequence;
 }
 
 }  // namespace
@@ -17,14 +17,19 @@ limitations under the License.
 
 #include <memory>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
+#include "tensorflow/compiler/xla/legacy_flags/debug_options_flags.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
 #include "tensorflow/compiler/xla/service/hlo_ordering.h"
+#include "tensorflow/compiler/xla/service/hlo_module_config.h"
 #include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/tests/hlo_test_base.h"
 #include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
 
 namespace xla {
@@ -89,5 +94,74 @@ TEST_F(MinimumMemoryForSequenceTest, MultiComputation) {
             MinimumMemoryForSequence(module_sequence, size_fn).ValueOrDie());
 }
 
+class SchedulingSearchTest : public HloTestBase {
+ protected:
+  // Returns a module whose memory-minimizing scheduler may run "budget"
+  // simulations in its search.
+  std::unique_ptr<HloModule> CreateModule(int32 budget) {
+    HloModuleConfig config;
+    DebugOptions debug_options = legacy_flags::GetDebugOptionsFromFlags();
+    debug_options.set_xla_scheduler_search_budget(budget);
+    config.set_debug_options(debug_options);
+    auto module = MakeUnique<HloModule>(TestName(), config);
+
+    // Several chains of elementwise operations of a parameter, each of which
+    // defines large buffers, which are summed pairwise at the end.
+    const Shape vector_shape = ShapeUtil::MakeShape(F32, {1024});
+    auto builder = HloComputation::Builder(TestName());
+    HloInstruction* param = builder.AddInstruction(
+        HloInstruction::CreateParameter(0, vector_shape, "param"));
+    std::vector<HloInstruction*> chains;
+    for (int i = 0; i < 4; ++i) {
+      HloInstruction* value = param;
+      for (int j = 0; j <= i; ++j) {
+        HloInstruction* exp = builder.AddInstruction(
+            HloInstruction::CreateUnary(vector_shape, HloOpcode::kExp, value));
+        value = builder.AddInstruction(HloInstruction::CreateBinary(
+            vector_shape, HloOpcode::kAdd, exp, value));
+      }
+      chains.push_back(value);
+    }
+    HloInstruction* left = builder.AddInstruction(HloInstruction::CreateBinary(
+        vector_shape, HloOpcode::kMultiply, chains[0], chains[3]));
+    HloInstruction* right = builder.AddInstruction(
+        HloInstruction::CreateBinary(vector_shape, HloOpcode::kMultiply,
+                                     chains[1], chains[2]));
+    builder.AddInstruction(HloInstruction::CreateBinary(
+        vector_shape, HloOpcode::kAdd, left, right));
+    module->AddEntryComputation(builder.Build());
+    return module;
+  }
+
+  static int64 SizeOf(const LogicalBuffer& buffer) {
+    return ShapeUtil::ByteSizeOf(buffer.shape(), /*pointer_size=*/8);
+  }
+
+  // Returns the peak memory of the sequence chosen for "module", after
+  // checking that it orders each instruction after its operands.
+  static int64 ScheduledMemory(const HloModule& module) {
+    SequentialHloOrdering::HloModuleSequence sequence =
+        CreateMemoryMinimizingSequence(module, SizeOf).ConsumeValueOrDie();
+    const std::vector<const HloInstruction*>& entry_sequence =
+        sequence.at(module.entry_computation());
+    EXPECT_EQ(module.entry_computation()->instruction_count(),
+              entry_sequence.size());
+    std::unordered_set<const HloInstruction*> scheduled;
+    for (const HloInstruction* hlo : entry_sequence) {
+      for (const HloInstruction* operand : hlo->operands()) {
+        EXPECT_EQ(1, scheduled.count(operand)) << hlo->name();
+      }
+      scheduled.insert(hlo);
+    }
+    return MinimumMemoryForSequence(sequence, SizeOf).ValueOrDie();
+  }
+};
+
+TEST_F(SchedulingSearchTest, SearchDoesNotIncreaseMemory) {
+  auto module = CreateModule(/*budget=*/0);
+  auto searched_module = CreateModule(/*budget=*/1000);
+  EXPECT_LE(ScheduledMemory(*searched_module), ScheduledMemory(*module));
+}
+
 }  // namespace
 }  // namespace xla
@@ -41,11 +41,13 @@ class LocalService : public Service {
 
   // Builds an Executable with the given argument layouts and options. If
   // result_layout is non-null, then the executable is compiled to produce a
-  // result of the given layout.
+  // result of the given layout. If hlo_profile is true, the executable is
+  // instrumented for HLO profiling even if the xla_hlo_profile flag is unset.
   StatusOr<std::unique_ptr<Executable>> CompileExecutable(
       const ComputationHandle& computation,
       const tensorflow::gtl::ArraySlice<const Shape*> argument_layouts,
-      const Shape* result_layout, int device_ordinal);
+      const Shape* result_layout, int device_ordinal,
+      bool hlo_profile = false);
 
  private:
   explicit LocalService(const ServiceOptions& options,
@@ -0,0 +1,73 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/compiler/xla/service/memory_compilation_cache.h"
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+
+MemoryCompilationCache::MemoryCompilationCache(int64 capacity_bytes)
+    : capacity_bytes_(capacity_bytes) {}
+
+bool MemoryCompilationCache::Lookup(const string& key, string* value) {
+  const tensorflow::Fprint128 fingerprint = tensorflow::Fingerprint128(key);
+  tensorflow::mutex_lock lock(mu_);
+  auto it = index_.find(fingerprint);
+  if (it == index_.end()) {
+    return false;
+  }
+  entries_.splice(entries_.begin(), entries_, it->second);
+  *value = it->second->value;
+  return true;
+}
+
+void MemoryCompilationCache::Store(const string& key, const string& value) {
+  const int64 size = value.size();
+  if (size > capacity_bytes_) {
+    VLOG(1) << "Not caching a compilation result of " << size
+            << " bytes, which exceeds the capacity of " << capacity_bytes_;
+    return;
+  }
+  const tensorflow::Fprint128 fingerprint = tensorflow::Fingerprint128(key);
+  tensorflow::mutex_lock lock(mu_);
+  auto it = index_.find(fingerprint);
+  if (it != index_.end()) {
+    size_bytes_ -= it->second->value.size();
+    entries_.erase(it->second);
+    index_.erase(it);
+  }
+  entries_.push_front(Entry{fingerprint, value});
+  index_[fingerprint] = entries_.begin();
+  size_bytes_ += size;
+  EvictLocked();
+}
+
+int64 MemoryCompilationCache::size_bytes() const {
+  tensorflow::mutex_lock lock(mu_);
+  return size_bytes_;
+}
+
+void MemoryCompilationCache::EvictLocked() {
+  while (size_bytes_ > capacity_bytes_) {
+    const Entry& entry = entries_.back();
+    size_bytes_ -= entry.value.size();
+    index_.erase(entry.fingerprint);
+    entries_.pop_back();
+  }
+}
+
+}  // namespace xla
@@ -0,0 +1,82 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_MEMORY_COMPILATION_CACHE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_MEMORY_COMPILATION_CACHE_H_
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace xla {
+
+// A cache of compilation results, e.g. object files, that is kept in memory
+// for the lifetime of the process, so that compiling the same IR again skips
+// the backend. It is the in-memory counterpart of DiskCompilationCache, with
+// the same requirements on the keys.
+//
+// The entries are indexed by a 128-bit fingerprint of their key, and the
+// least recently used ones are evicted when their values exceed the
+// capacity.
+//
+// This class is thread-safe.
+class MemoryCompilationCache {
+ public:
+  explicit MemoryCompilationCache(int64 capacity_bytes);
+
+  // Returns true and sets "*value" to the value stored for "key", if the
+  // cache has an entry for it.
+  bool Lookup(const string& key, string* value);
+
+  // Stores "value" for "key", replacing any previous entry. Values larger
+  // than the capacity are not stored.
+  void Store(const string& key, const string& value);
+
+  // The total size of the values of the entries.
+  int64 size_bytes() const;
+
+ private:
+  struct Entry {
+    tensorflow::Fprint128 fingerprint;
+    string value;
+  };
+
+  // Removes the least recently used entries until the values fit in
+  // "capacity_bytes_".
+  void EvictLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int64 capacity_bytes_;
+
+  mutable tensorflow::mutex mu_;
+  // The entries, the most recently used first.
+  std::list<Entry> entries_ GUARDED_BY(mu_);
+  std::unordered_map<tensorflow::Fprint128, std::list<Entry>::iterator,
+                     tensorflow::Fprint128Hasher>
+      index_ GUARDED_BY(mu_);
+  int64 size_bytes_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryCompilationCache);
+};
+
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_MEMORY_COMPILATION_CACHE_H_
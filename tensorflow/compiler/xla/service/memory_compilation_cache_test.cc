@@ -0,0 +1,71 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/compiler/xla/service/memory_compilation_cache.h"
+
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/types.h"
+
+namespace xla {
+namespace {
+
+TEST(MemoryCompilationCacheTest, StoresAndLooksUpValues) {
+  MemoryCompilationCache cache(1024);
+  string value;
+  EXPECT_FALSE(cache.Lookup("key", &value));
+
+  cache.Store("key", string("object\0code", 11));
+  cache.Store("other key", "");
+  ASSERT_TRUE(cache.Lookup("key", &value));
+  EXPECT_EQ(string("object\0code", 11), value);
+  ASSERT_TRUE(cache.Lookup("other key", &value));
+  EXPECT_EQ("", value);
+  EXPECT_FALSE(cache.Lookup("missing key", &value));
+  EXPECT_EQ(11, cache.size_bytes());
+}
+
+TEST(MemoryCompilationCacheTest, ReplacesValues) {
+  MemoryCompilationCache cache(1024);
+  cache.Store("key", "first");
+  cache.Store("key", "second");
+  string value;
+  ASSERT_TRUE(cache.Lookup("key", &value));
+  EXPECT_EQ("second", value);
+  EXPECT_EQ(6, cache.size_bytes());
+}
+
+TEST(MemoryCompilationCacheTest, EvictsLeastRecentlyUsedValues) {
+  MemoryCompilationCache cache(10);
+  cache.Store("a", "aaaa");
+  cache.Store("b", "bbbb");
+  string value;
+  // Makes "b" the least recently used entry.
+  ASSERT_TRUE(cache.Lookup("a", &value));
+  cache.Store("c", "cccc");
+  EXPECT_TRUE(cache.Lookup("a", &value));
+  EXPECT_FALSE(cache.Lookup("b", &value));
+  EXPECT_TRUE(cache.Lookup("c", &value));
+  EXPECT_EQ(8, cache.size_bytes());
+
+  // A value larger than the capacity is not stored, and evicts nothing.
+  cache.Store("d", string(11, 'd'));
+  EXPECT_FALSE(cache.Lookup("d", &value));
+  EXPECT_TRUE(cache.Lookup("a", &value));
+  EXPECT_TRUE(cache.Lookup("c", &value));
+}
+
+}  // namespace
+}  // namespace xla
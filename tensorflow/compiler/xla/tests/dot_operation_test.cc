@@ -245,6 +245,38 @@ XLA_TEST_F(DotOperationTest, MatrixDotF32_12_117_7_MinorToMajorFF) {
   TestMatrixDot(12, 117, 7, false, false);
 }
 
+XLA_TEST_F(DotOperationTest, MatrixDotF32_37_61_83_MinorToMajorTT) {
+  TestMatrixDot(37, 61, 83, true, true);
+}
+
+XLA_TEST_F(DotOperationTest, MatrixDotF32_37_61_83_MinorToMajorTF) {
+  TestMatrixDot(37, 61, 83, true, false);
+}
+
+XLA_TEST_F(DotOperationTest, MatrixDotF32_37_61_83_MinorToMajorFT) {
+  TestMatrixDot(37, 61, 83, false, true);
+}
+
+XLA_TEST_F(DotOperationTest, MatrixDotF32_37_61_83_MinorToMajorFF) {
+  TestMatrixDot(37, 61, 83, false, false);
+}
+
+XLA_TEST_F(DotOperationTest, MatrixDotF32_128_256_512_MinorToMajorTT) {
+  TestMatrixDot(128, 256, 512, true, true);
+}
+
+XLA_TEST_F(DotOperationTest, MatrixDotF32_128_256_512_MinorToMajorTF) {
+  TestMatrixDot(128, 256, 512, true, false);
+}
+
+XLA_TEST_F(DotOperationTest, MatrixDotF32_128_256_512_MinorToMajorFT) {
+  TestMatrixDot(128, 256, 512, false, true);
+}
+
+XLA_TEST_F(DotOperationTest, MatrixDotF32_128_256_512_MinorToMajorFF) {
+  TestMatrixDot(128, 256, 512, false, false);
+}
+
 XLA_TEST_F(DotOperationTest, MatrixDotF32_270_270_520_MinorToMajorTT) {
   TestMatrixDot(270, 270, 520, true, true);
 }
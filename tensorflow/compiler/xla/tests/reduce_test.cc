@@ -226,8 +226,8 @@ class ReduceTest : public ClientLibraryTestBase {
           reduction_function_generator,
       const std::function<NativeT(NativeT, NativeT)>&
           reference_reduction_function,
-      const NativeT& initial_value) {
-    const int rows = 64, cols = 128;
+      const NativeT& initial_value, int64 rows = 64, int64 cols = 128,
+      int64 dimension_to_reduce = 0) {
     const int minor = 1, major = 0;
     ComputationBuilder builder(client_, TestName());
     Computation reduction_function = reduction_function_generator(&builder);
@@ -236,7 +236,7 @@ class ReduceTest : public ClientLibraryTestBase {
     auto input = builder.Parameter(0, input_shape, "input");
     auto zero = builder.ConstantR0<NativeT>(initial_value);
     builder.Reduce(input, zero, reduction_function,
-                   /*dimensions_to_reduce=*/{0});
+                   /*dimensions_to_reduce=*/{dimension_to_reduce});
 
     Array2D<NativeT> input_data(rows, cols);
     input_data.FillUnique(initial_value);
@@ -249,18 +249,21 @@ class ReduceTest : public ClientLibraryTestBase {
 
     // NativeT can be bool, and std::vector<bool> does not convert to
     // ArraySlice.
-    std::unique_ptr<NativeT[]> expected(new NativeT[cols]);
-    for (int64 colno = 0; colno < cols; ++colno) {
-      NativeT column_result = initial_value;
-      for (int64 rowno = 0; rowno < rows; ++rowno) {
-        column_result = reference_reduction_function(column_result,
-                                                     input_data(rowno, colno));
+    const int64 outputs = dimension_to_reduce == 0 ? cols : rows;
+    const int64 reduced = dimension_to_reduce == 0 ? rows : cols;
+    std::unique_ptr<NativeT[]> expected(new NativeT[outputs]);
+    for (int64 i = 0; i < outputs; ++i) {
+      NativeT result = initial_value;
+      for (int64 j = 0; j < reduced; ++j) {
+        result = reference_reduction_function(
+            result, dimension_to_reduce == 0 ? input_data(j, i)
+                                             : input_data(i, j));
       }
-      expected[colno] = column_result;
+      expected[i] = result;
     }
 
     ComputeAndCompareGeneric<NativeT>(
-        &builder, tensorflow::gtl::ArraySlice<NativeT>(expected.get(), cols),
+        &builder, tensorflow::gtl::ArraySlice<NativeT>(expected.get(), outputs),
         {input_global_data.get()});
   }
 
@@ -274,27 +277,31 @@ class ReduceTest : public ClientLibraryTestBase {
       const std::function<uint32(uint32, uint32)>&
           reference_reduction_function_for_uints,
       float floating_point_identity, int32 signed_int_identity,
-      uint32 unsigned_int_identity) {
+      uint32 unsigned_int_identity, int64 rows = 64, int64 cols = 128,
+      int64 dimension_to_reduce = 0) {
     // Float version
     RunVectorizedReduceTestForType<float>(
         [&](ComputationBuilder* builder) {
           return reduction_function_generator_for_type(F32, builder);
         },
-        reference_reduction_function_for_floats, floating_point_identity);
+        reference_reduction_function_for_floats, floating_point_identity, rows,
+        cols, dimension_to_reduce);
 
     // Signed int version
     RunVectorizedReduceTestForType<int32>(
         [&](ComputationBuilder* builder) {
           return reduction_function_generator_for_type(S32, builder);
         },
-        reference_reduction_function_for_ints, signed_int_identity);
+        reference_reduction_function_for_ints, signed_int_identity, rows,
+        cols, dimension_to_reduce);
 
     // Unsigned int version
     RunVectorizedReduceTestForType<uint32>(
         [&](ComputationBuilder* builder) {
           return reduction_function_generator_for_type(U32, builder);
         },
-        reference_reduction_function_for_uints, unsigned_int_identity);
+        reference_reduction_function_for_uints, unsigned_int_identity, rows,
+        cols, dimension_to_reduce);
   }
 
   std::unique_ptr<Literal> literal_2d_;
@@ -739,6 +746,50 @@ XLA_TEST_F(ReduceTest, VectorizedReduce_BooleanOr) {
       CreateScalarOrComputation, [](bool a, bool b) { return a || b; }, false);
 }
 
+// The reductions over the minor dimension reduce rows whose size is not a
+// multiple of the vector size.
+XLA_TEST_F(ReduceTest, VectorizedReduceMinor_Add) {
+  RunVectorizedReduceTest(CreateScalarAddComputation,
+                          [](float a, float b) { return a + b; },
+                          [](int32 a, int32 b) {
+                            return static_cast<int32>(static_cast<uint32>(a) +
+                                                      static_cast<uint32>(b));
+                          },
+                          [](uint32 a, uint32 b) { return a + b; }, 0.0, 0, 0,
+                          /*rows=*/37, /*cols=*/203,
+                          /*dimension_to_reduce=*/1);
+}
+
+XLA_TEST_F(ReduceTest, VectorizedReduceMinor_Max) {
+  RunVectorizedReduceTest(CreateScalarMaxComputation,
+                          [](float a, float b) { return std::max(a, b); },
+                          [](int32 a, int32 b) { return std::max(a, b); },
+                          [](uint32 a, uint32 b) { return std::max(a, b); },
+                          std::numeric_limits<float>::min(),
+                          std::numeric_limits<int32>::min(),
+                          std::numeric_limits<uint32>::min(),
+                          /*rows=*/37, /*cols=*/203,
+                          /*dimension_to_reduce=*/1);
+}
+
+XLA_TEST_F(ReduceTest, VectorizedReduceMinor_Min) {
+  RunVectorizedReduceTest(CreateScalarMinComputation,
+                          [](float a, float b) { return std::min(a, b); },
+                          [](int32 a, int32 b) { return std::min(a, b); },
+                          [](uint32 a, uint32 b) { return std::min(a, b); },
+                          std::numeric_limits<float>::max(),
+                          std::numeric_limits<int32>::max(),
+                          std::numeric_limits<uint32>::max(),
+                          /*rows=*/37, /*cols=*/203,
+                          /*dimension_to_reduce=*/1);
+}
+
+XLA_TEST_F(ReduceTest, VectorizedReduceMinor_BooleanAnd) {
+  RunVectorizedReduceTestForType<bool>(
+      CreateScalarAndComputation, [](bool a, bool b) { return a && b; }, true,
+      /*rows=*/37, /*cols=*/203, /*dimension_to_reduce=*/1);
+}
+
 class ReduceR3ToR2Test : public ReduceTest,
                          public ::testing::WithParamInterface<BoundsLayout> {};
 
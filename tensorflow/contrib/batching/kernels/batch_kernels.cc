@@ -13,6 +13,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <deque>
+#include <unordered_map>
+
+#include "tensorflow/contrib/batching/latency_slo_batch_tuner.h"
 #include "tensorflow/contrib/batching/shared_batch_scheduler.h"
 #include "tensorflow/contrib/batching/util/periodic_function.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -203,11 +207,76 @@ Status Split(OpKernelContext* context, const Tensor& input,
   return SplitCPU<T>(context, input, sizes, outputs);
 }
 
+// Measures the processing time of batches emitted by Batch ops that have a
+// latency target, i.e. the time from when the Batch op emits a batch until an
+// Unbatch op receives the result of processing it, and reports it to the
+// batch's LatencySloBatchTuner. Batches are identified by the id of their first
+// invocation, which is the first batch key in the batch index tensor.
+class BatchProcessingTimeTracker {
+ public:
+  static BatchProcessingTimeTracker* Global() {
+    static BatchProcessingTimeTracker* tracker = new BatchProcessingTimeTracker;
+    return tracker;
+  }
+
+  void Start(int64 batch_key, size_t batch_size,
+             std::weak_ptr<serving::LatencySloBatchTuner> tuner) {
+    mutex_lock l(mu_);
+    if (!pending_
+             .emplace(batch_key, PendingBatch{batch_size,
+                                              Env::Default()->NowMicros(),
+                                              std::move(tuner)})
+             .second) {
+      return;
+    }
+    order_.push_back(batch_key);
+    // Batches whose results never reach an Unbatch op would otherwise linger
+    // forever; forget the oldest ones.
+    while (pending_.size() > kMaxPendingBatches) {
+      pending_.erase(order_.front());
+      order_.pop_front();
+    }
+    while (!order_.empty() && pending_.count(order_.front()) == 0) {
+      order_.pop_front();
+    }
+  }
+
+  void Finish(int64 batch_key) {
+    PendingBatch batch;
+    {
+      mutex_lock l(mu_);
+      auto it = pending_.find(batch_key);
+      if (it == pending_.end()) return;
+      batch = std::move(it->second);
+      pending_.erase(it);
+    }
+    std::shared_ptr<serving::LatencySloBatchTuner> tuner = batch.tuner.lock();
+    if (tuner != nullptr) {
+      tuner->RecordBatchProcessingTime(
+          batch.batch_size, Env::Default()->NowMicros() - batch.start_micros);
+    }
+  }
+
+ private:
+  static constexpr size_t kMaxPendingBatches = 1024;
+
+  struct PendingBatch {
+    size_t batch_size;
+    uint64 start_micros;
+    std::weak_ptr<serving::LatencySloBatchTuner> tuner;
+  };
+
+  mutex mu_;
+  std::unordered_map<int64, PendingBatch> pending_ GUARDED_BY(mu_);
+  // Keys of 'pending_' (and of some finished batches) in insertion order.
+  std::deque<int64> order_ GUARDED_BY(mu_);
+};
+
 // A class encapsulating the state and logic for batching tensors.
 class BatchResource : public ResourceBase {
  public:
   static Status Create(int32 num_batch_threads, int32 max_batch_size,
-                       int32 batch_timeout_micros,
+                       int32 batch_timeout_micros, int64 target_latency_micros,
                        const std::vector<int32>& allowed_batch_sizes,
                        std::unique_ptr<BatchResource>* resource) {
     std::unique_ptr<BatchResource> new_resource(new BatchResource);
@@ -220,6 +289,20 @@ class BatchResource : public ResourceBase {
     new_resource->batcher_queue_options_.max_batch_size = max_batch_size;
     new_resource->batcher_queue_options_.batch_timeout_micros =
         batch_timeout_micros;
+    if (target_latency_micros > 0) {
+      serving::LatencySloBatchTuner::Options tuner_options;
+      tuner_options.target_latency_micros = target_latency_micros;
+      tuner_options.max_batch_size = max_batch_size;
+      tuner_options.max_batch_timeout_micros = batch_timeout_micros;
+      TF_RETURN_IF_ERROR(serving::LatencySloBatchTuner::Create(
+          tuner_options, &new_resource->tuner_));
+      new_resource->batcher_queue_options_.latency_slo_tuner =
+          new_resource->tuner_;
+      // ProcessBatch only assembles the batch; the processing itself happens
+      // downstream, and is timed by the Unbatch op.
+      new_resource->batcher_queue_options_.external_batch_processing_time =
+          true;
+    }
 
     new_resource->allowed_batch_sizes_ = allowed_batch_sizes;
 
@@ -429,6 +512,11 @@ class BatchResource : public ResourceBase {
         EmitIndexTensor(last_task_context, *batch, num_input_edges),
         last_task_callback);
 
+    if (tuner_ != nullptr) {
+      BatchProcessingTimeTracker::Global()->Start(batch->task(0).guid,
+                                                  padded_batch_size, tuner_);
+    }
+
     // Signal done for each element of the batch. (At this point, the contexts
     // are no longer guaranteed to remain live.)
     for (int task_idx = 0; task_idx < batch->num_tasks(); ++task_idx) {
@@ -496,6 +584,9 @@ class BatchResource : public ResourceBase {
       GUARDED_BY(batcher_queues_mu_);
 
   std::vector<int32> allowed_batch_sizes_;
+
+  // Set iff the op has a latency target.
+  std::shared_ptr<serving::LatencySloBatchTuner> tuner_;
 };
 
 class BatchKernel : public AsyncOpKernel {
@@ -515,6 +606,8 @@ class BatchKernel : public AsyncOpKernel {
                    c->GetAttr("batch_timeout_micros", &batch_timeout_micros_));
     OP_REQUIRES_OK(c, c->GetAttr("allowed_batch_sizes", &allowed_batch_sizes_));
     OP_REQUIRES_OK(c, ValidateAllowedBatchSizes());
+    OP_REQUIRES_OK(
+        c, c->GetAttr("target_latency_micros", &target_latency_micros_));
   }
 
   void ComputeAsync(OpKernelContext* c, DoneCallback done) final {
@@ -524,7 +617,7 @@ class BatchKernel : public AsyncOpKernel {
           std::unique_ptr<BatchResource> new_resource;
           TF_RETURN_IF_ERROR(BatchResource::Create(
               num_batch_threads_, max_batch_size_, batch_timeout_micros_,
-              allowed_batch_sizes_, &new_resource));
+              target_latency_micros_, allowed_batch_sizes_, &new_resource));
           *r = new_resource.release();
           return Status::OK();
         };
@@ -570,6 +663,7 @@ class BatchKernel : public AsyncOpKernel {
   int32 num_batch_threads_;
   int32 max_batch_size_;
   int32 batch_timeout_micros_;
+  int64 target_latency_micros_;
   std::vector<int32> allowed_batch_sizes_;
 };
 
@@ -632,6 +726,9 @@ class UnbatchResource : public ResourceBase {
         sizes.push_back(batch_indices(i, 2) - batch_indices(i, 1));
         batch_keys.push_back(batch_indices(i, 0));
       }
+      // The batch has been processed; report it if its Batch op has a latency
+      // target.
+      BatchProcessingTimeTracker::Global()->Finish(batch_keys[0]);
 
       const DataType type = data_t.dtype();
       switch (type) {
@@ -0,0 +1,192 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/batching/latency_slo_batch_tuner.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+// The 99th percentile of the standard normal distribution, used to turn the
+// spread of processing times into a tail allowance.
+constexpr double kP99StandardScore = 2.326;
+
+}  // namespace
+
+Status LatencySloBatchTuner::Create(
+    const Options& options, std::shared_ptr<LatencySloBatchTuner>* tuner) {
+  if (options.target_latency_micros <= 0) {
+    return errors::InvalidArgument(
+        "target_latency_micros must be positive; was ",
+        options.target_latency_micros);
+  }
+  if (options.max_batch_size <= 0) {
+    return errors::InvalidArgument("max_batch_size must be positive; was ",
+                                   options.max_batch_size);
+  }
+  if (options.max_batch_timeout_micros < 0) {
+    return errors::InvalidArgument(
+        "max_batch_timeout_micros must be non-negative; was ",
+        options.max_batch_timeout_micros);
+  }
+  if (options.smoothing_samples <= 0) {
+    return errors::InvalidArgument("smoothing_samples must be positive; was ",
+                                   options.smoothing_samples);
+  }
+  if (options.warmup_batches < 0) {
+    return errors::InvalidArgument(
+        "warmup_batches must be non-negative; was ", options.warmup_batches);
+  }
+  tuner->reset(new LatencySloBatchTuner(options));
+  return Status::OK();
+}
+
+LatencySloBatchTuner::LatencySloBatchTuner(const Options& options)
+    : options_(options),
+      decay_(1.0 - 1.0 / options.smoothing_samples),
+      batch_size_(options.max_batch_size),
+      batch_timeout_micros_(std::min(options.max_batch_timeout_micros,
+                                     options.target_latency_micros)) {}
+
+void LatencySloBatchTuner::RecordTaskArrival(size_t task_size,
+                                             uint64 now_micros) {
+  mutex_lock l(mu_);
+  if (have_arrival_ && task_size > 0 && now_micros >= last_arrival_micros_) {
+    const double micros_per_item =
+        static_cast<double>(now_micros - last_arrival_micros_) / task_size;
+    if (micros_per_arriving_item_ < 0) {
+      micros_per_arriving_item_ = micros_per_item;
+    } else {
+      micros_per_arriving_item_ = decay_ * micros_per_arriving_item_ +
+                                  (1 - decay_) * micros_per_item;
+    }
+  }
+  last_arrival_micros_ = now_micros;
+  have_arrival_ = true;
+}
+
+void LatencySloBatchTuner::RecordBatchProcessingTime(size_t batch_size,
+                                                     int64 processing_micros) {
+  if (batch_size == 0) return;
+  const double x = batch_size;
+  const double y = processing_micros;
+  mutex_lock l(mu_);
+  sum_weights_ = decay_ * sum_weights_ + 1;
+  sum_x_ = decay_ * sum_x_ + x;
+  sum_y_ = decay_ * sum_y_ + y;
+  sum_xx_ = decay_ * sum_xx_ + x * x;
+  sum_xy_ = decay_ * sum_xy_ + x * y;
+  sum_yy_ = decay_ * sum_yy_ + y * y;
+  ++num_batches_;
+  UpdateLocked();
+}
+
+void LatencySloBatchTuner::UpdateLocked() {
+  const double mean_x = sum_x_ / sum_weights_;
+  const double mean_y = sum_y_ / sum_weights_;
+  const double var_x = sum_xx_ / sum_weights_ - mean_x * mean_x;
+  const double cov_xy = sum_xy_ / sum_weights_ - mean_x * mean_y;
+  // With too little variety in the observed batch sizes the slope cannot be
+  // identified; fall back to a processing time proportional to batch size,
+  // which errs towards smaller batches.
+  if (var_x > 1e-6 * std::max(1.0, mean_x * mean_x)) {
+    per_item_micros_ = cov_xy / var_x;
+    fixed_micros_ = mean_y - per_item_micros_ * mean_x;
+  } else {
+    per_item_micros_ = mean_y / mean_x;
+    fixed_micros_ = 0;
+  }
+  if (per_item_micros_ < 0) {
+    per_item_micros_ = 0;
+    fixed_micros_ = mean_y;
+  } else if (fixed_micros_ < 0) {
+    per_item_micros_ = mean_y / mean_x;
+    fixed_micros_ = 0;
+  }
+  // The weighted mean of (y - a - b * x)^2 over the samples, expanded in terms
+  // of the sums.
+  const double a = fixed_micros_;
+  const double b = per_item_micros_;
+  const double mean_squared_residual =
+      sum_yy_ / sum_weights_ + a * a + b * b * sum_xx_ / sum_weights_ -
+      2 * a * mean_y - 2 * b * sum_xy_ / sum_weights_ + 2 * a * b * mean_x;
+  residual_stddev_micros_ = std::sqrt(std::max(0.0, mean_squared_residual));
+
+  if (num_batches_ < options_.warmup_batches) return;
+
+  const double budget_micros = options_.target_latency_micros -
+                               fixed_micros_ -
+                               kP99StandardScore * residual_stddev_micros_;
+  const double fill_micros_per_item = std::max(0.0, micros_per_arriving_item_);
+  const double micros_per_item = per_item_micros_ + fill_micros_per_item;
+  double batch_size = options_.max_batch_size;
+  if (budget_micros <= 0) {
+    // The target cannot be met; minimize latency instead.
+    batch_size = 1;
+  } else if (micros_per_item > 0) {
+    batch_size = std::min(batch_size, std::floor(budget_micros /
+                                                 micros_per_item));
+  }
+  batch_size_ = std::max(1, static_cast<int>(batch_size));
+
+  const double timeout_micros =
+      options_.target_latency_micros -
+      PredictedTailProcessingMicrosLocked(batch_size_);
+  batch_timeout_micros_ = std::min<int64>(
+      options_.max_batch_timeout_micros,
+      std::max<int64>(0, static_cast<int64>(timeout_micros)));
+}
+
+int LatencySloBatchTuner::batch_size() const {
+  mutex_lock l(mu_);
+  return batch_size_;
+}
+
+int64 LatencySloBatchTuner::batch_timeout_micros() const {
+  mutex_lock l(mu_);
+  return batch_timeout_micros_;
+}
+
+double LatencySloBatchTuner::PredictedProcessingMicros(
+    size_t batch_size) const {
+  mutex_lock l(mu_);
+  return PredictedProcessingMicrosLocked(batch_size);
+}
+
+double LatencySloBatchTuner::PredictedTailProcessingMicros(
+    size_t batch_size) const {
+  mutex_lock l(mu_);
+  return PredictedTailProcessingMicrosLocked(batch_size);
+}
+
+double LatencySloBatchTuner::PredictedProcessingMicrosLocked(
+    size_t batch_size) const {
+  return fixed_micros_ + per_item_micros_ * batch_size;
+}
+
+double LatencySloBatchTuner::PredictedTailProcessingMicrosLocked(
+    size_t batch_size) const {
+  return PredictedProcessingMicrosLocked(batch_size) +
+         kP99StandardScore * residual_stddev_micros_;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
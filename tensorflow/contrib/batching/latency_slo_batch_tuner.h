@@ -0,0 +1,145 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_BATCHING_LATENCY_SLO_BATCH_TUNER_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_BATCHING_LATENCY_SLO_BATCH_TUNER_H_
+
+#include <memory>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Chooses the batch size and batch timeout of a batching queue so as to
+// maximize throughput while keeping the 99th percentile latency of its tasks
+// (the time a task waits for its batch to be formed plus the time to process
+// the batch) under a target. See SharedBatchScheduler::QueueOptions for how to
+// attach a tuner to a queue.
+//
+// The tuner fits an online model of batch processing time as a function of
+// batch size,
+//   processing_micros(b) = fixed_micros + per_item_micros * b,
+// by exponentially weighted least squares, together with the spread of the
+// observations around that line, and estimates the task arrival rate. A batch
+// of size b takes about b / arrival_rate to fill, so the largest batch that can
+// be both filled and processed within the target is
+//   b = (target - fixed_micros - tail_micros) / (per_item_micros +
+//                                                1 / arrival_rate)
+// where tail_micros is the allowance for the 99th percentile of processing time
+// over its mean. The batch timeout is set to whatever is left of the target
+// after the tail processing time of such a batch. Both values are limited by
+// the configured maxima. Under high load this picks the largest batches that
+// meet the target, and under low load it bounds how long a task can wait for
+// company.
+//
+// Until enough batches have been observed, the configured maximum batch size
+// is used, and the maximum timeout capped at the target.
+//
+// This object is thread-safe.
+class LatencySloBatchTuner {
+ public:
+  struct Options {
+    // The target for the 99th percentile of task latency, in microseconds.
+    // Must be positive.
+    int64 target_latency_micros = 0;
+
+    // The largest batch size the tuner will choose.
+    int max_batch_size = 1000;
+
+    // The longest batch timeout, in microseconds, the tuner will choose.
+    int64 max_batch_timeout_micros = 0;
+
+    // Observations are weighted with a decay of 1 - 1 / smoothing_samples, so
+    // that the models track roughly the last 'smoothing_samples' batches (for
+    // processing time) and tasks (for the arrival rate). Must be positive.
+    int64 smoothing_samples = 100;
+
+    // The number of batches to observe before adapting to the model.
+    int64 warmup_batches = 10;
+  };
+
+  static Status Create(const Options& options,
+                       std::shared_ptr<LatencySloBatchTuner>* tuner);
+
+  // Records that a task of size 'task_size' arrived at 'now_micros'.
+  void RecordTaskArrival(size_t task_size, uint64 now_micros);
+
+  // Records that a batch of size 'batch_size' took 'processing_micros' to
+  // process, and updates the chosen batch size and timeout.
+  void RecordBatchProcessingTime(size_t batch_size, int64 processing_micros);
+
+  // The batch size and timeout chosen from the observations so far.
+  int batch_size() const;
+  int64 batch_timeout_micros() const;
+
+  // The mean and 99th percentile processing time predicted for a batch of size
+  // 'batch_size'.
+  double PredictedProcessingMicros(size_t batch_size) const;
+  double PredictedTailProcessingMicros(size_t batch_size) const;
+
+  const Options& options() const { return options_; }
+
+ private:
+  explicit LatencySloBatchTuner(const Options& options);
+
+  double PredictedProcessingMicrosLocked(size_t batch_size) const
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  double PredictedTailProcessingMicrosLocked(size_t batch_size) const
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Refits the processing time model and re-derives the batch size and timeout.
+  void UpdateLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const Options options_;
+  const double decay_;
+
+  mutable mutex mu_;
+
+  // Exponentially weighted sums over (batch size, processing time) samples.
+  double sum_weights_ GUARDED_BY(mu_) = 0;
+  double sum_x_ GUARDED_BY(mu_) = 0;
+  double sum_y_ GUARDED_BY(mu_) = 0;
+  double sum_xx_ GUARDED_BY(mu_) = 0;
+  double sum_xy_ GUARDED_BY(mu_) = 0;
+  double sum_yy_ GUARDED_BY(mu_) = 0;
+  int64 num_batches_ GUARDED_BY(mu_) = 0;
+
+  // The fitted model, and the weighted standard deviation of the samples
+  // around it.
+  double fixed_micros_ GUARDED_BY(mu_) = 0;
+  double per_item_micros_ GUARDED_BY(mu_) = 0;
+  double residual_stddev_micros_ GUARDED_BY(mu_) = 0;
+
+  // Exponentially weighted mean time between arrivals of unit-size tasks, or a
+  // negative value until two tasks have arrived.
+  double micros_per_arriving_item_ GUARDED_BY(mu_) = -1;
+  uint64 last_arrival_micros_ GUARDED_BY(mu_) = 0;
+  bool have_arrival_ GUARDED_BY(mu_) = false;
+
+  int batch_size_ GUARDED_BY(mu_);
+  int64 batch_timeout_micros_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(LatencySloBatchTuner);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_BATCHING_LATENCY_SLO_BATCH_TUNER_H_
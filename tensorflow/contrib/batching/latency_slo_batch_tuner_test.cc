@@ -0,0 +1,135 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/batching/latency_slo_batch_tuner.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+LatencySloBatchTuner::Options DefaultOptions() {
+  LatencySloBatchTuner::Options options;
+  options.target_latency_micros = 5000;
+  options.max_batch_size = 1000;
+  options.max_batch_timeout_micros = 10000;
+  options.warmup_batches = 10;
+  return options;
+}
+
+// Feeds 'tuner' batches of sizes 1..100 whose processing time is
+// 'fixed_micros' + 'per_item_micros' * size, alternately offset by
+// +/-'noise_micros'.
+void FeedLinearModel(double fixed_micros, double per_item_micros,
+                     double noise_micros, LatencySloBatchTuner* tuner) {
+  for (int i = 0; i < 300; ++i) {
+    const int size = 1 + i % 100;
+    const double noise = (i % 2 == 0) ? noise_micros : -noise_micros;
+    tuner->RecordBatchProcessingTime(
+        size, static_cast<int64>(fixed_micros + per_item_micros * size +
+                                 noise));
+  }
+}
+
+TEST(LatencySloBatchTunerTest, InvalidOptions) {
+  std::shared_ptr<LatencySloBatchTuner> tuner;
+  LatencySloBatchTuner::Options options = DefaultOptions();
+  options.target_latency_micros = 0;
+  EXPECT_FALSE(LatencySloBatchTuner::Create(options, &tuner).ok());
+  options = DefaultOptions();
+  options.max_batch_size = 0;
+  EXPECT_FALSE(LatencySloBatchTuner::Create(options, &tuner).ok());
+  options = DefaultOptions();
+  options.max_batch_timeout_micros = -1;
+  EXPECT_FALSE(LatencySloBatchTuner::Create(options, &tuner).ok());
+  options = DefaultOptions();
+  options.smoothing_samples = 0;
+  EXPECT_FALSE(LatencySloBatchTuner::Create(options, &tuner).ok());
+}
+
+TEST(LatencySloBatchTunerTest, UsesMaximaDuringWarmup) {
+  std::shared_ptr<LatencySloBatchTuner> tuner;
+  TF_ASSERT_OK(LatencySloBatchTuner::Create(DefaultOptions(), &tuner));
+  EXPECT_EQ(1000, tuner->batch_size());
+  // The timeout is capped at the latency target.
+  EXPECT_EQ(5000, tuner->batch_timeout_micros());
+  for (int i = 0; i < 9; ++i) {
+    tuner->RecordBatchProcessingTime(10, 100000);
+  }
+  EXPECT_EQ(1000, tuner->batch_size());
+  EXPECT_EQ(5000, tuner->batch_timeout_micros());
+}
+
+TEST(LatencySloBatchTunerTest, LearnsLinearProcessingTime) {
+  std::shared_ptr<LatencySloBatchTuner> tuner;
+  TF_ASSERT_OK(LatencySloBatchTuner::Create(DefaultOptions(), &tuner));
+  FeedLinearModel(1000, 10, 0, tuner.get());
+  EXPECT_NEAR(1500, tuner->PredictedProcessingMicros(50), 1);
+  EXPECT_NEAR(1500, tuner->PredictedTailProcessingMicros(50), 1);
+  // With no arrival rate information, the largest batch that can be processed
+  // within the target is chosen, leaving no time to wait for it to fill.
+  EXPECT_NEAR(400, tuner->batch_size(), 1);
+  EXPECT_NEAR(0, tuner->batch_timeout_micros(), 10);
+}
+
+TEST(LatencySloBatchTunerTest, AccountsForArrivalRate) {
+  std::shared_ptr<LatencySloBatchTuner> tuner;
+  TF_ASSERT_OK(LatencySloBatchTuner::Create(DefaultOptions(), &tuner));
+  // One unit-size task every 10 microseconds.
+  for (int i = 0; i < 100; ++i) {
+    tuner->RecordTaskArrival(1, 10 * i);
+  }
+  FeedLinearModel(1000, 10, 0, tuner.get());
+  // A batch of 200 takes 2000us to fill and 3000us to process.
+  EXPECT_NEAR(200, tuner->batch_size(), 1);
+  EXPECT_NEAR(2000, tuner->batch_timeout_micros(), 20);
+}
+
+TEST(LatencySloBatchTunerTest, NoiseShrinksBatches) {
+  std::shared_ptr<LatencySloBatchTuner> quiet_tuner;
+  TF_ASSERT_OK(LatencySloBatchTuner::Create(DefaultOptions(), &quiet_tuner));
+  FeedLinearModel(1000, 10, 0, quiet_tuner.get());
+  std::shared_ptr<LatencySloBatchTuner> noisy_tuner;
+  TF_ASSERT_OK(LatencySloBatchTuner::Create(DefaultOptions(), &noisy_tuner));
+  FeedLinearModel(1000, 10, 200, noisy_tuner.get());
+  EXPECT_LT(noisy_tuner->batch_size(), quiet_tuner->batch_size() - 20);
+  EXPECT_GT(noisy_tuner->PredictedTailProcessingMicros(50),
+            noisy_tuner->PredictedProcessingMicros(50) + 300);
+}
+
+TEST(LatencySloBatchTunerTest, UnattainableTarget) {
+  std::shared_ptr<LatencySloBatchTuner> tuner;
+  TF_ASSERT_OK(LatencySloBatchTuner::Create(DefaultOptions(), &tuner));
+  FeedLinearModel(10000, 10, 0, tuner.get());
+  EXPECT_EQ(1, tuner->batch_size());
+  EXPECT_EQ(0, tuner->batch_timeout_micros());
+}
+
+TEST(LatencySloBatchTunerTest, RespectsMaxima) {
+  LatencySloBatchTuner::Options options = DefaultOptions();
+  options.max_batch_size = 50;
+  options.max_batch_timeout_micros = 100;
+  std::shared_ptr<LatencySloBatchTuner> tuner;
+  TF_ASSERT_OK(LatencySloBatchTuner::Create(options, &tuner));
+  FeedLinearModel(100, 1, 0, tuner.get());
+  EXPECT_EQ(50, tuner->batch_size());
+  EXPECT_EQ(100, tuner->batch_timeout_micros());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -32,6 +32,7 @@ REGISTER_OP("Batch")
     .Attr("container: string = ''")
     .Attr("shared_name: string = ''")
     .Attr("batching_queue: string = ''")
+    .Attr("target_latency_micros: int = 0")
     .Attr("T: list(type)")
     .SetShapeFn([](shape_inference::InferenceContext* c) {
       std::vector<shape_inference::ShapeHandle> in_shapes;
@@ -87,6 +88,11 @@ id: always contains a scalar with a unique ID for this invocation of Batch.
 shared_name: Concurrently running instances of batch in the same device with the
  same container and shared_name will batch their elements together. If left
  empty, the op name will be used as the shared name.
+target_latency_micros: If positive, a target for the 99th percentile latency
+ of each invocation, from entering Batch to its batch reaching Unbatch. The
+ batch size and timeout are then picked online, up to max_batch_size and
+ batch_timeout_micros, to maximize throughput while meeting the target, based
+ on the processing times observed by the matching Unbatch ops.
 T: the types of tensors to be batched.
 )doc");
 
@@ -62,7 +62,8 @@ def _UnbatchGrad(op, grad):   # pylint: disable=invalid-name
 def batch_function(num_batch_threads, max_batch_size, batch_timeout_micros,
                    allowed_batch_sizes=None,
                    grad_timeout_micros=60 * 1000 * 1000,
-                   unbatch_timeout_micros=60 * 1000 * 1000):
+                   unbatch_timeout_micros=60 * 1000 * 1000,
+                   target_latency_micros=0):
   """Batches the computation done by the decorated function.
 
   So, for example, in the following code
@@ -100,6 +101,10 @@ def batch_function(num_batch_threads, max_batch_size, batch_timeout_micros,
      documentation of the unbatch op for more details. Defaults to 60s.
     unbatch_timeout_micros: The timeout to use for unbatching. See the
      documentation of the unbatch op for more details. Defaults to 60s.
+    target_latency_micros: If positive, a 99th percentile latency target for
+     batched calls. The batch size and timeout are then adapted online, up to
+     max_batch_size and batch_timeout_micros, to maximize throughput while
+     meeting the target. Defaults to 0, which uses the fixed settings.
 
   Returns:
     The decorated function will return the unbatched computation output Tensors.
@@ -119,6 +124,7 @@ def batch_function(num_batch_threads, max_batch_size, batch_timeout_micros,
             batch_timeout_micros=batch_timeout_micros,
             allowed_batch_sizes=allowed_batch_sizes,
             grad_timeout_micros=grad_timeout_micros,
+            target_latency_micros=target_latency_micros,
             shared_name=name)
         outputs = f(*batched_tensors)
         if isinstance(outputs, ops.Tensor):
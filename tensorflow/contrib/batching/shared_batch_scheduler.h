@@ -17,6 +17,7 @@ limitations under the License.
 #define THIRD_PARTY_TENSORFLOW_CONTRIB_BATCHING_SHARED_BATCH_SCHEDULER_H_
 
 #include <stddef.h>
+#include <algorithm>
 #include <deque>
 #include <functional>
 #include <list>
@@ -26,6 +27,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/contrib/batching/batch_scheduler.h"
+#include "tensorflow/contrib/batching/latency_slo_batch_tuner.h"
 #include "tensorflow/contrib/batching/util/periodic_function.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -157,6 +159,18 @@ class SharedBatchScheduler
     // See the class documentation above for guidelines on how to tune this
     // parameter.
     int max_enqueued_batches = 10;
+
+    // If set, the queue forms batches of the size and with the timeout chosen
+    // by 'latency_slo_tuner' (limited by 'max_batch_size' and
+    // 'batch_timeout_micros' above), which adapts them online to maximize
+    // throughput while meeting a latency target. The queue reports task
+    // arrivals to the tuner, and the duration of each call to the process-batch
+    // callback as the batch's processing time. If the callback merely hands the
+    // batch off to be processed asynchronously, set
+    // 'external_batch_processing_time' and report processing times to the tuner
+    // directly instead.
+    std::shared_ptr<LatencySloBatchTuner> latency_slo_tuner;
+    bool external_batch_processing_time = false;
   };
   Status AddQueue(const QueueOptions& options,
                   std::function<void(std::unique_ptr<Batch<TaskType>>)>
@@ -281,6 +295,11 @@ class Queue {
   // currently schedulable.
   bool IsOpenBatchSchedulable() const EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // The batch size and timeout currently in effect: those chosen by
+  // 'options_.latency_slo_tuner' if set, else the configured ones.
+  int CurrentMaxBatchSize() const;
+  int64 CurrentBatchTimeoutMicros() const;
+
   const typename SharedBatchScheduler<TaskType>::QueueOptions options_;
 
   // The environment to use.
@@ -532,7 +551,12 @@ Status Queue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
 
     DCHECK(!closed_);
 
-    if (batches_.back()->size() + (*task)->size() > options_.max_batch_size) {
+    if (options_.latency_slo_tuner != nullptr) {
+      options_.latency_slo_tuner->RecordTaskArrival((*task)->size(),
+                                                    env_->NowMicros());
+    }
+    if (!batches_.back()->empty() &&
+        batches_.back()->size() + (*task)->size() > CurrentMaxBatchSize()) {
       if (batches_.size() >= options_.max_enqueued_batches) {
         return errors::Unavailable(
             "The batch scheduling queue to which this task was submitted is "
@@ -573,12 +597,12 @@ size_t Queue<TaskType>::NumEnqueuedTasks() const {
 template <typename TaskType>
 size_t Queue<TaskType>::SchedulingCapacity() const {
   mutex_lock l(mu_);
+  const int max_batch_size = CurrentMaxBatchSize();
   const int num_new_batches_schedulable =
       options_.max_enqueued_batches - batches_.size();
   const int open_batch_capacity =
-      options_.max_batch_size - batches_.back()->size();
-  return (num_new_batches_schedulable * options_.max_batch_size) +
-         open_batch_capacity;
+      std::max<int>(0, max_batch_size - batches_.back()->size());
+  return (num_new_batches_schedulable * max_batch_size) + open_batch_capacity;
 }
 
 template <typename TaskType>
@@ -610,7 +634,16 @@ std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch() {
 
 template <typename TaskType>
 void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch) {
+  LatencySloBatchTuner* tuner = options_.external_batch_processing_time
+                                    ? nullptr
+                                    : options_.latency_slo_tuner.get();
+  const size_t batch_size = batch->size();
+  const uint64 start_time_micros = tuner != nullptr ? env_->NowMicros() : 0;
   process_batch_callback_(std::move(batch));
+  if (tuner != nullptr) {
+    tuner->RecordBatchProcessingTime(batch_size,
+                                     env_->NowMicros() - start_time_micros);
+  }
 
   {
     mutex_lock l(mu_);
@@ -661,9 +694,25 @@ bool Queue<TaskType>::IsOpenBatchSchedulable() const {
   if (open_batch->empty()) {
     return false;
   }
-  return closed_ || open_batch->size() >= options_.max_batch_size ||
+  return closed_ || open_batch->size() >= CurrentMaxBatchSize() ||
          env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+             open_batch_start_time_micros_ + CurrentBatchTimeoutMicros();
+}
+
+template <typename TaskType>
+int Queue<TaskType>::CurrentMaxBatchSize() const {
+  if (options_.latency_slo_tuner == nullptr) return options_.max_batch_size;
+  return std::min(options_.max_batch_size,
+                  options_.latency_slo_tuner->batch_size());
+}
+
+template <typename TaskType>
+int64 Queue<TaskType>::CurrentBatchTimeoutMicros() const {
+  if (options_.latency_slo_tuner == nullptr) {
+    return options_.batch_timeout_micros;
+  }
+  return std::min(options_.batch_timeout_micros,
+                  options_.latency_slo_tuner->batch_timeout_micros());
 }
 
 template <typename TaskType>
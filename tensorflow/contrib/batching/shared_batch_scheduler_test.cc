@@ -187,6 +187,55 @@ TEST(SharedBatchSchedulerTest, ObeyBatchSizeConstraint) {
   EXPECT_EQ((std::vector<size_t>{3, 1, 6}), callback_data_b);
 }
 
+TEST(SharedBatchSchedulerTest, ObeysLatencySloTuner) {
+  // A tuner that has learnt that batches take 200 + 200 * size microseconds,
+  // so that batches of at most 4 meet a 1.1 ms target.
+  LatencySloBatchTuner::Options tuner_options;
+  tuner_options.target_latency_micros = 1100;
+  tuner_options.max_batch_size = 10;
+  tuner_options.max_batch_timeout_micros = 10 * 1000 * 1000;
+  tuner_options.warmup_batches = 0;
+  std::shared_ptr<LatencySloBatchTuner> tuner;
+  TF_ASSERT_OK(LatencySloBatchTuner::Create(tuner_options, &tuner));
+  for (int size = 1; size <= 10; ++size) {
+    tuner->RecordBatchProcessingTime(size, 200 + 200 * size);
+  }
+  ASSERT_EQ(4, tuner->batch_size());
+
+  mutex mu;
+  std::vector<size_t> batch_sizes;
+  auto callback = [&mu, &batch_sizes](std::unique_ptr<Batch<FakeTask>> batch) {
+    ASSERT_TRUE(batch->IsClosed());
+    mutex_lock l(mu);
+    batch_sizes.push_back(batch->size());
+  };
+  {
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.max_batch_size = 10;
+    queue_options.batch_timeout_micros = 10 * 1000 * 1000;  // 10 seconds
+    queue_options.max_enqueued_batches = 20;
+    queue_options.latency_slo_tuner = tuner;
+    // Keep the tuner's model fixed for the test.
+    queue_options.external_batch_processing_time = true;
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+    for (int i = 0; i < 12; ++i) {
+      TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    }
+  }
+
+  size_t total_size = 0;
+  for (const size_t size : batch_sizes) {
+    EXPECT_LE(size, 4);
+    total_size += size;
+  }
+  EXPECT_EQ(12, total_size);
+}
+
 TEST(SharedBatchSchedulerTest, ObeysTimeout) {
   // Set up a fake clock, which only advances when we explicitly tell it to.
   test_util::FakeClockEnv env(Env::Default());
@@ -13,7 +13,12 @@
 // limitations under the License.
 // =============================================================================
 #include "tensorflow/contrib/boosted_trees/lib/models/multiple_additive_trees.h"
+
+#include <algorithm>
+#include <vector>
+
 #include "tensorflow/contrib/boosted_trees/lib/trees/decision_tree.h"
+#include "tensorflow/contrib/boosted_trees/lib/trees/flat_tree_ensemble.h"
 #include "tensorflow/contrib/boosted_trees/lib/utils/batch_features.h"
 #include "tensorflow/contrib/boosted_trees/lib/utils/parallel_for.h"
 
@@ -21,6 +26,14 @@ namespace tensorflow {
 namespace boosted_trees {
 namespace models {
 
+namespace {
+
+// The number of examples that are traversed together through each tree of a
+// flattened ensemble.
+constexpr int64 kFlatTreesBlockSize = 64;
+
+}  // namespace
+
 void MultipleAdditiveTrees::Predict(
     const boosted_trees::trees::DecisionTreeEnsembleConfig& config,
     const std::vector<int32>& trees_to_include,
@@ -71,10 +84,46 @@ void MultipleAdditiveTrees::Predict(
     }
   };
 
-  // TODO(salehay): parallelize this for low latency in serving path where
-  // batch size tends to be small but ensemble size tends to be large.
+  // Flattening the trees touches all of their nodes, while traversing them
+  // touches a path per example, so it only pays off for the batches that
+  // have at least as many examples as the trees have nodes on average.
+  int64 num_nodes = 0;
+  for (const int32 tree_idx : trees_to_include) {
+    num_nodes += config.trees(tree_idx).nodes_size();
+  }
+  if (batch_size * static_cast<int64>(trees_to_include.size()) < num_nodes) {
+    // TODO(salehay): parallelize this for low latency in serving path where
+    // batch size tends to be small but ensemble size tends to be large.
+    boosted_trees::utils::ParallelFor(batch_size, worker_threads->NumThreads(),
+                                      worker_threads, update_predictions);
+    return;
+  }
+
+  const boosted_trees::trees::FlatTreeEnsemble flat_ensemble(config,
+                                                             trees_to_include);
+  auto update_flat_predictions = [&flat_ensemble, &features,
+                                  &output_predictions](int64 start,
+                                                       int64 end) {
+    std::vector<boosted_trees::utils::Example> examples(
+        std::min(end - start, kFlatTreesBlockSize));
+    size_t num_examples = 0;
+    auto examples_iterable = features.examples_iterable(start, end);
+    for (const auto& example : examples_iterable) {
+      examples[num_examples++] = example;
+      if (num_examples == examples.size()) {
+        flat_ensemble.AddPredictions(examples, output_predictions);
+        num_examples = 0;
+      }
+    }
+    if (num_examples > 0) {
+      flat_ensemble.AddPredictions(
+          gtl::ArraySlice<boosted_trees::utils::Example>(examples.data(),
+                                                         num_examples),
+          output_predictions);
+    }
+  };
   boosted_trees::utils::ParallelFor(batch_size, worker_threads->NumThreads(),
-                                    worker_threads, update_predictions);
+                                    worker_threads, update_flat_predictions);
 }
 
 }  // namespace models
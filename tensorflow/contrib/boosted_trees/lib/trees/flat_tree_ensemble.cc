@@ -0,0 +1,139 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/boosted_trees/lib/trees/flat_tree_ensemble.h"
+
+#include <algorithm>
+
+#include "tensorflow/contrib/boosted_trees/lib/trees/decision_tree.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace trees {
+
+constexpr int32 FlatTreeEnsemble::kLeaf;
+constexpr int32 FlatTreeEnsemble::kProtoSplit;
+
+FlatTreeEnsemble::FlatTreeEnsemble(const DecisionTreeEnsembleConfig& config,
+                                   const std::vector<int32>& trees_to_include) {
+  int64 num_nodes = 0;
+  for (const int32 tree_idx : trees_to_include) {
+    num_nodes += config.trees(tree_idx).nodes_size();
+  }
+  tree_roots_.reserve(trees_to_include.size());
+  tree_configs_.reserve(trees_to_include.size());
+  feature_columns_.reserve(num_nodes);
+  thresholds_.reserve(num_nodes);
+  left_ids_.reserve(num_nodes);
+  right_ids_.reserve(num_nodes);
+
+  for (const int32 tree_idx : trees_to_include) {
+    const DecisionTreeConfig& tree = config.trees(tree_idx);
+    const float tree_weight = config.tree_weights(tree_idx);
+    QCHECK_GT(tree.nodes_size(), 0) << "Invalid tree: " << tree.DebugString();
+    const int32 root = feature_columns_.size();
+    tree_roots_.push_back(root);
+    tree_configs_.push_back(&tree);
+    for (const TreeNode& node : tree.nodes()) {
+      switch (node.node_case()) {
+        case TreeNode::kLeaf: {
+          feature_columns_.push_back(kLeaf);
+          thresholds_.push_back(0);
+          left_ids_.push_back(logit_indices_.size());
+          if (node.leaf().has_sparse_vector()) {
+            const auto& leaf = node.leaf().sparse_vector();
+            QCHECK_EQ(leaf.index_size(), leaf.value_size());
+            for (int i = 0; i < leaf.index_size(); ++i) {
+              logit_indices_.push_back(leaf.index(i));
+              logit_values_.push_back(tree_weight * leaf.value(i));
+            }
+          } else {
+            QCHECK(node.leaf().has_vector()) << "Unknown leaf type";
+            const auto& leaf = node.leaf().vector();
+            for (int i = 0; i < leaf.value_size(); ++i) {
+              logit_indices_.push_back(i);
+              logit_values_.push_back(tree_weight * leaf.value(i));
+            }
+          }
+          right_ids_.push_back(logit_indices_.size());
+          break;
+        }
+        case TreeNode::kDenseFloatBinarySplit: {
+          const auto& split = node.dense_float_binary_split();
+          QCHECK(split.left_id() > 0 && split.left_id() < tree.nodes_size() &&
+                 split.right_id() > 0 && split.right_id() < tree.nodes_size())
+              << "Invalid node in tree: " << node.DebugString();
+          feature_columns_.push_back(split.feature_column());
+          thresholds_.push_back(split.threshold());
+          left_ids_.push_back(root + split.left_id());
+          right_ids_.push_back(root + split.right_id());
+          break;
+        }
+        default: {
+          feature_columns_.push_back(kProtoSplit);
+          thresholds_.push_back(0);
+          left_ids_.push_back(-1);
+          right_ids_.push_back(-1);
+          break;
+        }
+      }
+    }
+  }
+}
+
+void FlatTreeEnsemble::AddPredictions(
+    gtl::ArraySlice<utils::Example> examples,
+    TTypes<float>::Matrix output_predictions) const {
+  const int64 num_examples = examples.size();
+  std::vector<int32> node_ids(num_examples);
+  for (int32 tree = 0; tree < num_trees(); ++tree) {
+    const int32 root = tree_roots_[tree];
+    std::fill(node_ids.begin(), node_ids.end(), root);
+    // Moves all the examples down one level of the tree at a time, until
+    // they have all reached a leaf.
+    bool moved = true;
+    while (moved) {
+      moved = false;
+      for (int64 i = 0; i < num_examples; ++i) {
+        const int32 node_id = node_ids[i];
+        const int32 feature_column = feature_columns_[node_id];
+        if (feature_column >= 0) {
+          node_ids[i] = examples[i].dense_float_features[feature_column] <=
+                                thresholds_[node_id]
+                            ? left_ids_[node_id]
+                            : right_ids_[node_id];
+          moved = true;
+        } else if (feature_column == kProtoSplit) {
+          // Finishes the traversal of the example on the proto.
+          node_ids[i] = root + DecisionTree::Traverse(*tree_configs_[tree],
+                                                      node_id - root,
+                                                      examples[i]);
+        }
+      }
+    }
+    for (int64 i = 0; i < num_examples; ++i) {
+      const int32 leaf_id = node_ids[i];
+      const int64 example_idx = examples[i].example_idx;
+      for (int32 j = left_ids_[leaf_id]; j < right_ids_[leaf_id]; ++j) {
+        output_predictions(example_idx, logit_indices_[j]) += logit_values_[j];
+      }
+    }
+  }
+}
+
+}  // namespace trees
+}  // namespace boosted_trees
+}  // namespace tensorflow
@@ -0,0 +1,81 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_TREES_FLAT_TREE_ENSEMBLE_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_TREES_FLAT_TREE_ENSEMBLE_H_
+
+#include <vector>
+
+#include "tensorflow/contrib/boosted_trees/lib/utils/example.h"
+#include "tensorflow/contrib/boosted_trees/proto/tree_config.pb.h"  // NOLINT
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace trees {
+
+// A tree ensemble compiled for prediction: the nodes of the trees are
+// flattened into contiguous arrays of feature columns, thresholds and child
+// ids, and the leaves into arrays of weighted logits, so that traversing a
+// tree does not go through the protos. Dense float splits are evaluated from
+// the arrays; the other splits fall back to DecisionTree::Traverse on the
+// proto of their tree, which must outlive the ensemble.
+// This class is immutable once built and is thread safe.
+class FlatTreeEnsemble {
+ public:
+  // Flattens the trees of "config" listed in "trees_to_include", with their
+  // weights.
+  FlatTreeEnsemble(const DecisionTreeEnsembleConfig& config,
+                   const std::vector<int32>& trees_to_include);
+
+  int32 num_trees() const { return tree_roots_.size(); }
+
+  // Adds the predictions of the ensemble for "examples" to the rows of
+  // "output_predictions" given by their example indices. The examples are
+  // traversed together through one tree at a time, so that the nodes of the
+  // tree stay in cache.
+  void AddPredictions(gtl::ArraySlice<utils::Example> examples,
+                      TTypes<float>::Matrix output_predictions) const;
+
+ private:
+  // Values of feature_columns_ for the nodes that are not dense float splits.
+  static constexpr int32 kLeaf = -1;
+  static constexpr int32 kProtoSplit = -2;
+
+  // The index of the first node of each tree, whose nodes keep the order of
+  // the proto, and the proto of the tree.
+  std::vector<int32> tree_roots_;
+  std::vector<const DecisionTreeConfig*> tree_configs_;
+
+  // Per node. The child ids are indices of nodes; for a leaf, they are the
+  // range of its logits instead.
+  std::vector<int32> feature_columns_;
+  std::vector<float> thresholds_;
+  std::vector<int32> left_ids_;
+  std::vector<int32> right_ids_;
+
+  // Per leaf logit, its index in the prediction vector and its value
+  // multiplied by the weight of the tree.
+  std::vector<int32> logit_indices_;
+  std::vector<float> logit_values_;
+};
+
+}  // namespace trees
+}  // namespace boosted_trees
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_TREES_FLAT_TREE_ENSEMBLE_H_
@@ -0,0 +1,140 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/boosted_trees/lib/trees/flat_tree_ensemble.h"
+
+#include <vector>
+
+#include "tensorflow/contrib/boosted_trees/lib/testutil/batch_features_testutil.h"
+#include "tensorflow/contrib/boosted_trees/lib/testutil/random_tree_gen.h"
+#include "tensorflow/contrib/boosted_trees/lib/trees/decision_tree.h"
+#include "tensorflow/contrib/boosted_trees/lib/utils/batch_features.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace trees {
+namespace {
+
+std::vector<utils::Example> GetExamples(
+    const utils::BatchFeatures& batch_features) {
+  std::vector<utils::Example> examples;
+  for (const auto& example :
+       batch_features.examples_iterable(0, batch_features.batch_size())) {
+    examples.push_back(example);
+  }
+  return examples;
+}
+
+TEST(FlatTreeEnsembleTest, MatchesTraverse) {
+  random::PhiloxRandom philox(7, 11);
+  random::SimplePhilox rng(&philox);
+  testutil::RandomTreeGen tree_gen(&rng, 5, 5);
+  DecisionTreeEnsembleConfig config = tree_gen.GenerateEnsemble(6, 10);
+  for (int i = 0; i < config.tree_weights_size(); ++i) {
+    config.set_tree_weights(i, 0.5f + i);
+  }
+  const std::vector<int32> trees_to_include = {0, 2, 3, 7, 9};
+
+  const int64 batch_size = 100;
+  utils::BatchFeatures batch_features(batch_size);
+  testutil::RandomlyInitializeBatchFeatures(&rng, 5, 5, 0.2, 0.8,
+                                            &batch_features);
+  const std::vector<utils::Example> examples = GetExamples(batch_features);
+
+  Tensor expected(DT_FLOAT, {batch_size, 1});
+  expected.matrix<float>().setZero();
+  for (const auto& example : examples) {
+    for (const int32 tree_idx : trees_to_include) {
+      const DecisionTreeConfig& tree = config.trees(tree_idx);
+      const int leaf_id = DecisionTree::Traverse(tree, 0, example);
+      expected.matrix<float>()(example.example_idx, 0) +=
+          config.tree_weights(tree_idx) *
+          tree.nodes(leaf_id).leaf().sparse_vector().value(0);
+    }
+  }
+
+  const FlatTreeEnsemble flat_ensemble(config, trees_to_include);
+  EXPECT_EQ(5, flat_ensemble.num_trees());
+  Tensor output(DT_FLOAT, {batch_size, 1});
+  output.matrix<float>().setZero();
+  flat_ensemble.AddPredictions(examples, output.matrix<float>());
+  test::ExpectTensorEqual<float>(expected, output);
+}
+
+TEST(FlatTreeEnsembleTest, MixedSplitsAndLeaves) {
+  // Two examples with one dense float and one sparse int feature:
+  // Instance | DenseF1 | SparseI1
+  // 0        |   7     |    3
+  // 1        |  -2     |
+  auto dense_float_matrix = test::AsTensor<float>({7.0f, -2.0f}, {2, 1});
+  auto sparse_int_indices = test::AsTensor<int64>({0, 0}, {1, 2});
+  auto sparse_int_values = test::AsTensor<int64>({3});
+  auto sparse_int_shape = test::AsTensor<int64>({2, 1});
+  utils::BatchFeatures batch_features(2);
+  TF_EXPECT_OK(batch_features.Initialize({dense_float_matrix}, {}, {}, {},
+                                         {sparse_int_indices},
+                                         {sparse_int_values},
+                                         {sparse_int_shape}));
+
+  DecisionTreeEnsembleConfig config;
+  // A bias tree with a dense leaf of two logits.
+  auto* bias =
+      config.add_trees()->add_nodes()->mutable_leaf()->mutable_vector();
+  bias->add_value(1.0f);
+  bias->add_value(2.0f);
+  config.add_tree_weights(1.0f);
+  // A dense float split followed by a categorical split on its right.
+  auto* tree = config.add_trees();
+  auto* dense_split = tree->add_nodes()->mutable_dense_float_binary_split();
+  dense_split->set_feature_column(0);
+  dense_split->set_threshold(0.0f);
+  dense_split->set_left_id(1);
+  dense_split->set_right_id(2);
+  auto* left = tree->add_nodes()->mutable_leaf()->mutable_sparse_vector();
+  left->add_index(1);
+  left->add_value(0.5f);
+  auto* categorical_split =
+      tree->add_nodes()->mutable_categorical_id_binary_split();
+  categorical_split->set_feature_column(0);
+  categorical_split->set_feature_id(3);
+  categorical_split->set_left_id(3);
+  categorical_split->set_right_id(4);
+  auto* right_left = tree->add_nodes()->mutable_leaf()->mutable_sparse_vector();
+  right_left->add_index(0);
+  right_left->add_value(0.25f);
+  tree->add_nodes()->mutable_leaf()->mutable_sparse_vector();
+  config.add_tree_weights(2.0f);
+
+  const FlatTreeEnsemble flat_ensemble(config, {0, 1});
+  Tensor output(DT_FLOAT, {2, 2});
+  output.matrix<float>().setZero();
+  flat_ensemble.AddPredictions(GetExamples(batch_features),
+                               output.matrix<float>());
+  // Example 0 goes right, then left on the categorical split, and example 1
+  // goes left.
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1.5f, 2.0f, 1.0f, 3.0f}, {2, 2}), output);
+}
+
+}  // namespace
+}  // namespace trees
+}  // namespace boosted_trees
+}  // namespace tensorflow
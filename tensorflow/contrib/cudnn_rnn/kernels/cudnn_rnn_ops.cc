@@ -19,7 +19,9 @@ limitations under the License.
 #include <cmath>
 #include <functional>
 #include <limits>
+#include <map>
 #include <string>
+#include <utility>
 #include <unordered_set>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -103,6 +105,7 @@ namespace {
 using perftools::gputools::DeviceMemory;
 using perftools::gputools::DeviceMemoryBase;
 using perftools::gputools::ScratchAllocator;
+using perftools::gputools::dnn::RnnAlgorithm;
 using perftools::gputools::dnn::RnnDirectionMode;
 using perftools::gputools::dnn::RnnInputMode;
 using perftools::gputools::dnn::RnnMode;
@@ -225,40 +228,6 @@ inline perftools::gputools::port::Status ToExecutorStatus(const Status& s) {
                       s.error_message());
 }
 
-// A helper to allocate temporary scratch memory for Cudnn RNN models. It takes
-// the ownership of the underlying memory. The expectation is that the memory
-// should be alive for the span of the Cudnn RNN itself.
-class CudnnRNNWorkspaceAllocator : public ScratchAllocator {
- public:
-  ~CudnnRNNWorkspaceAllocator() override {}
-  explicit CudnnRNNWorkspaceAllocator(OpKernelContext* context)
-      : context_(context) {}
-  int64 GetMemoryLimitInBytes(perftools::gputools::Stream* stream) override {
-    return std::numeric_limits<int64>::max();
-  }
-  StatusOr<DeviceMemory<uint8>> AllocateBytes(
-      perftools::gputools::Stream* stream, int64 byte_size) override {
-    Tensor temporary_memory;
-    Status allocation_status(context_->allocate_temp(
-        DT_UINT8, TensorShape({byte_size}), &temporary_memory));
-    if (!allocation_status.ok()) {
-      return ToExecutorStatus(allocation_status);
-    }
-    // Hold the reference of the allocated tensors until the end of the
-    // allocator.
-    allocated_tensors_.push_back(temporary_memory);
-    total_byte_size_ += byte_size;
-    return StatusOr<DeviceMemory<uint8>>(
-        AsDeviceMemory<uint8>(&temporary_memory));
-  }
-  int64 TotalByteSize() { return total_byte_size_; }
-
- private:
-  int64 total_byte_size_ = 0;
-  OpKernelContext* context_;  // not owned
-  std::vector<Tensor> allocated_tensors_;
-};
-
 // A helper to allocate reserve-space memory for Cudnn RNN models. The tensors
 // are allocated as a kernel output, and will be fed into the backward pass.
 // The memory is expected to live long enough after the backward pass is
@@ -336,6 +305,46 @@ class CudnnRNNPersistentSpaceAllocator : public ScratchAllocator {
   OpKernelContext* context_;  // not owned
 };
 
+// A helper to allocate temporary scratch memory for Cudnn RNN models from a
+// buffer kept by the kernel across invocations, which only grows when a larger
+// workspace is needed. The memory is reused by the kernel invocations in the
+// order of the stream that they run on, like any temporary memory.
+// This class is not thread-safe, nor is the buffer.
+class CudnnRNNPooledWorkspaceAllocator : public ScratchAllocator {
+ public:
+  CudnnRNNPooledWorkspaceAllocator(OpKernelContext* context,
+                                   PersistentTensor* workspace)
+      : context_(context), workspace_(workspace) {}
+
+  ~CudnnRNNPooledWorkspaceAllocator() override {}
+
+  int64 GetMemoryLimitInBytes(perftools::gputools::Stream* stream) override {
+    return std::numeric_limits<int64>::max();
+  }
+
+  StatusOr<DeviceMemory<uint8>> AllocateBytes(
+      perftools::gputools::Stream* stream, int64 byte_size) override {
+    if (workspace_->IsInitialized()) {
+      Tensor* workspace = workspace_->AccessTensor(context_);
+      if (workspace->NumElements() >= byte_size) {
+        return StatusOr<DeviceMemory<uint8>>(DeviceMemory<uint8>(
+            SliceDeviceMemory(AsDeviceMemory<uint8>(workspace), 0, byte_size)));
+      }
+    }
+    Status allocation_status = context_->allocate_persistent(
+        DT_UINT8, TensorShape({byte_size}), workspace_, nullptr);
+    if (!allocation_status.ok()) {
+      return ToExecutorStatus(allocation_status);
+    }
+    return StatusOr<DeviceMemory<uint8>>(
+        AsDeviceMemory<uint8>(workspace_->AccessTensor(context_)));
+  }
+
+ private:
+  OpKernelContext* context_;     // not owned
+  PersistentTensor* workspace_;  // not owned
+};
+
 struct CudnnModelTypes {
   RnnMode rnn_mode;
   TFRNNInputMode rnn_input_mode;
@@ -424,6 +433,70 @@ Status ExtractForwardInput(OpKernelContext* context,
 }
 
 using perftools::gputools::dnn::RnnDescriptor;
+using perftools::gputools::dnn::RnnSequenceTensorDescriptor;
+using perftools::gputools::dnn::RnnStateTensorDescriptor;
+
+// The descriptors of the input, hidden state and output tensors of a RNN
+// model for one sequence length and batch size.
+struct CudnnRnnTensorDescriptors {
+  std::unique_ptr<RnnSequenceTensorDescriptor> input_desc;
+  std::unique_ptr<RnnStateTensorDescriptor> hidden_state_desc;
+  std::unique_ptr<RnnSequenceTensorDescriptor> output_desc;
+};
+
+// Creates the tensor descriptors of a RNN model once for each sequence length
+// and batch size, since the other dimensions of the model are fixed. The
+// cache is emptied when it holds too many of them, e.g. for inputs of many
+// lengths.
+// This class is not thread-safe.
+class CudnnRnnTensorDescriptorCache {
+ public:
+  template <typename T>
+  Status Get(perftools::gputools::StreamExecutor* executor,
+             const CudnnModelShapes& model_shapes,
+             const CudnnRnnTensorDescriptors** descriptors) {
+    const std::pair<int, int> key(model_shapes.seq_length,
+                                  model_shapes.batch_size);
+    auto it = cache_.find(key);
+    if (it == cache_.end()) {
+      if (cache_.size() >= kMaxSize) cache_.clear();
+      const auto data_type = ToDataType<T>::value;
+      const TensorShape& input_shape = model_shapes.input_shape;
+      const TensorShape& hidden_state_shape = model_shapes.hidden_state_shape;
+      const TensorShape& output_shape = model_shapes.output_shape;
+      std::unique_ptr<CudnnRnnTensorDescriptors> entry(
+          new CudnnRnnTensorDescriptors);
+
+      auto input_desc_s = executor->createRnnSequenceTensorDescriptor(
+          input_shape.dim_size(0), input_shape.dim_size(1),
+          input_shape.dim_size(2), data_type);
+      TF_RETURN_IF_ERROR(FromExecutorStatus(input_desc_s));
+      entry->input_desc = input_desc_s.ConsumeValueOrDie();
+
+      auto hidden_state_desc_s = executor->createRnnStateTensorDescriptor(
+          hidden_state_shape.dim_size(0), hidden_state_shape.dim_size(1),
+          hidden_state_shape.dim_size(2), data_type);
+      TF_RETURN_IF_ERROR(FromExecutorStatus(hidden_state_desc_s));
+      entry->hidden_state_desc = hidden_state_desc_s.ConsumeValueOrDie();
+
+      auto output_desc_s = executor->createRnnSequenceTensorDescriptor(
+          output_shape.dim_size(0), output_shape.dim_size(1),
+          output_shape.dim_size(2), data_type);
+      TF_RETURN_IF_ERROR(FromExecutorStatus(output_desc_s));
+      entry->output_desc = output_desc_s.ConsumeValueOrDie();
+
+      it = cache_.emplace(key, std::move(entry)).first;
+    }
+    *descriptors = it->second.get();
+    return Status::OK();
+  }
+
+ private:
+  static const size_t kMaxSize = 64;
+
+  std::map<std::pair<int, int>, std::unique_ptr<CudnnRnnTensorDescriptors>>
+      cache_;
+};
 
 template <typename T>
 void RestoreParams(const OpInputList params_input,
@@ -480,6 +553,16 @@ class CudnnRNNKernelCommon : public OpKernel {
     // every Compute() call.
     OP_REQUIRES_OK(context, ReadBoolFromEnvVar("TF_CUDNN_RESET_RND_GEN_STATE",
                                                false, &reset_rnd_gen_state_));
+    // Use the persistent kernels of Cudnn, which are faster for small batches,
+    // e.g. in inference. All of the kernels of a model must use the same
+    // algorithm.
+    bool use_persistent_kernels = false;
+    OP_REQUIRES_OK(context,
+                   ReadBoolFromEnvVar("TF_CUDNN_RNN_USE_PERSISTENT_KERNELS",
+                                      false, &use_persistent_kernels));
+    rnn_algorithm_ = use_persistent_kernels
+                         ? RnnAlgorithm::kRnnAlgoPersistStatic
+                         : RnnAlgorithm::kRnnAlgoStandard;
   }
 
   bool HasInputC() const { return model_types_.HasInputC(); }
@@ -488,6 +571,7 @@ class CudnnRNNKernelCommon : public OpKernel {
   RnnDirectionMode rnn_direction_mode() const {
     return model_types_.rnn_direction_mode;
   }
+  RnnAlgorithm rnn_algorithm() const { return rnn_algorithm_; }
   CudnnModelTypes model_types() const { return model_types_; }
   float dropout() const { return dropout_; }
   uint64 seed() { return (static_cast<uint64>(seed_) << 32) | seed2_; }
@@ -524,7 +608,7 @@ class CudnnRNNKernelCommon : public OpKernel {
     // random number generator, therefore set state_allocator to nullptr.
     auto rnn_desc_s = stream->parent()->createRnnDescriptor(
         num_layers, num_units, input_size, input_mode, rnn_direction_mode(),
-        rnn_mode(), ToDataType<T>::value, dropout(), seed(),
+        rnn_mode(), rnn_algorithm(), ToDataType<T>::value, dropout(), seed(),
         nullptr /* state_allocator */);
     if (!rnn_desc_s.ok()) {
       return FromExecutorStatus(rnn_desc_s);
@@ -538,6 +622,7 @@ class CudnnRNNKernelCommon : public OpKernel {
   int seed2_;
   float dropout_;
   bool reset_rnd_gen_state_;
+  RnnAlgorithm rnn_algorithm_;
 
   CudnnModelTypes model_types_;
 };
@@ -779,7 +864,6 @@ class CudnnRNNForwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
     OP_REQUIRES_OK(context,
                    ExtractForwardInput(context, model_types(), &input, &input_h,
                                        &input_c, &params, &model_shapes));
-    const auto& input_shape = model_shapes.input_shape;
     const auto& hidden_state_shape = model_shapes.hidden_state_shape;
     const auto& output_shape = model_shapes.output_shape;
 
@@ -804,8 +888,6 @@ class CudnnRNNForwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
     OP_REQUIRES_OK(context,
                    ToRNNInputMode(rnn_input_mode(), model_shapes.num_units,
                                   model_shapes.input_size, &input_mode));
-    // TODO(zhengxq): cache the descriptor so we don't have to create them all
-    // the time.
     auto data_type = ToDataType<T>::value;
     {
       mutex_lock l(mu_);
@@ -824,31 +906,13 @@ class CudnnRNNForwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
         auto rnn_desc_s = executor->createRnnDescriptor(
             model_shapes_->num_layers, model_shapes_->num_units,
             model_shapes_->input_size, input_mode, rnn_direction_mode(),
-            rnn_mode(), data_type, dropout(), seed(),
+            rnn_mode(), rnn_algorithm(), data_type, dropout(), seed(),
             dropout_state_allocator_.get());
         OP_REQUIRES_OK(context, FromExecutorStatus(rnn_desc_s));
         rnn_desc_ = std::move(rnn_desc_s.ConsumeValueOrDie());
       }
     }
 
-    auto input_desc_s = executor->createRnnSequenceTensorDescriptor(
-        input_shape.dim_size(0), input_shape.dim_size(1),
-        input_shape.dim_size(2), data_type);
-    OP_REQUIRES_OK(context, FromExecutorStatus(input_desc_s));
-    auto input_desc = input_desc_s.ConsumeValueOrDie();
-
-    auto hidden_state_desc_s = executor->createRnnStateTensorDescriptor(
-        hidden_state_shape.dim_size(0), hidden_state_shape.dim_size(1),
-        hidden_state_shape.dim_size(2), data_type);
-    OP_REQUIRES_OK(context, FromExecutorStatus(hidden_state_desc_s));
-    auto hidden_state_desc = hidden_state_desc_s.ConsumeValueOrDie();
-
-    auto output_desc_s = executor->createRnnSequenceTensorDescriptor(
-        output_shape.dim_size(0), output_shape.dim_size(1),
-        output_shape.dim_size(2), data_type);
-    OP_REQUIRES_OK(context, FromExecutorStatus(output_desc_s));
-    auto output_desc = output_desc_s.ConsumeValueOrDie();
-
     auto input_data = AsDeviceMemory<T>(input);
     auto input_h_data = AsDeviceMemory<T>(input_h);
     DeviceMemory<T> input_c_data;
@@ -872,19 +936,24 @@ class CudnnRNNForwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
       OP_REQUIRES_OK(context,
                      context->allocate_output(3, {}, &dummy_reserve_space));
     }
-    // Creates a memory callback for the workspace. The memory lives to the end
-    // of this kernel calls.
-    CudnnRNNWorkspaceAllocator workspace_allocator(context);
     bool launch_status = false;
     {
       mutex_lock l(mu_);
+      const CudnnRnnTensorDescriptors* descs = nullptr;
+      OP_REQUIRES_OK(context, tensor_descriptors_.Get<T>(executor, model_shapes,
+                                                         &descs));
+      // Creates a memory callback for the workspace. The memory is kept by this
+      // kernel for its next calls.
+      CudnnRNNPooledWorkspaceAllocator workspace_allocator(context,
+                                                           &workspace_);
       launch_status =
           stream
               ->ThenRnnForward(
-                  *rnn_desc_, *input_desc, input_data, *hidden_state_desc,
-                  input_h_data, *hidden_state_desc, input_c_data, params_data,
-                  *output_desc, &output_data, *hidden_state_desc,
-                  &output_h_data, *hidden_state_desc, &output_c_data,
+                  *rnn_desc_, *descs->input_desc, input_data,
+                  *descs->hidden_state_desc, input_h_data,
+                  *descs->hidden_state_desc, input_c_data, params_data,
+                  *descs->output_desc, &output_data, *descs->hidden_state_desc,
+                  &output_h_data, *descs->hidden_state_desc, &output_c_data,
                   is_training_, &reserve_space_allocator, &workspace_allocator)
               .ok();
     }
@@ -899,6 +968,8 @@ class CudnnRNNForwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
   std::unique_ptr<RnnDescriptor> rnn_desc_ GUARDED_BY(mu_);
   std::unique_ptr<CudnnRNNPersistentSpaceAllocator> dropout_state_allocator_
       GUARDED_BY(mu_);
+  CudnnRnnTensorDescriptorCache tensor_descriptors_ GUARDED_BY(mu_);
+  PersistentTensor workspace_ GUARDED_BY(mu_);
 };
 
 #define REGISTER_GPU(T)                                           \
@@ -929,7 +1000,6 @@ class CudnnRNNBackwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
                    ExtractForwardInput(context, model_types(), &input, &input_h,
                                        &input_c, &params, &model_shapes));
 
-    const auto& input_shape = model_shapes.input_shape;
     const auto& hidden_state_shape = model_shapes.hidden_state_shape;
     const auto& output_shape = model_shapes.output_shape;
 
@@ -1017,8 +1087,6 @@ class CudnnRNNBackwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
     OP_REQUIRES_OK(context,
                    ToRNNInputMode(rnn_input_mode(), model_shapes.num_units,
                                   model_shapes.input_size, &input_mode));
-    // TODO(zhengxq): cache the descriptor so we don't have to create them all
-    // the time.
     {
       mutex_lock l(mu_);
       if (model_shapes_ == nullptr) {
@@ -1037,31 +1105,13 @@ class CudnnRNNBackwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
         auto rnn_desc_s = executor->createRnnDescriptor(
             model_shapes.num_layers, model_shapes.num_units,
             model_shapes.input_size, input_mode, rnn_direction_mode(),
-            rnn_mode(), data_type, dropout(), seed(),
+            rnn_mode(), rnn_algorithm(), data_type, dropout(), seed(),
             dropout_state_allocator_.get());
         OP_REQUIRES_OK(context, FromExecutorStatus(rnn_desc_s));
         rnn_desc_ = std::move(rnn_desc_s.ConsumeValueOrDie());
       }
     }
 
-    auto input_desc_s = executor->createRnnSequenceTensorDescriptor(
-        input_shape.dim_size(0), input_shape.dim_size(1),
-        input_shape.dim_size(2), data_type);
-    OP_REQUIRES_OK(context, FromExecutorStatus(input_desc_s));
-    auto input_desc = input_desc_s.ConsumeValueOrDie();
-
-    auto hidden_state_desc_s = executor->createRnnStateTensorDescriptor(
-        hidden_state_shape.dim_size(0), hidden_state_shape.dim_size(1),
-        hidden_state_shape.dim_size(2), data_type);
-    OP_REQUIRES_OK(context, FromExecutorStatus(hidden_state_desc_s));
-    auto hidden_state_desc = hidden_state_desc_s.ConsumeValueOrDie();
-
-    auto output_desc_s = executor->createRnnSequenceTensorDescriptor(
-        output_shape.dim_size(0), output_shape.dim_size(1),
-        output_shape.dim_size(2), data_type);
-    OP_REQUIRES_OK(context, FromExecutorStatus(output_desc_s));
-    auto output_desc = output_desc_s.ConsumeValueOrDie();
-
     auto input_data = AsDeviceMemory<T>(input);
     auto input_h_data = AsDeviceMemory<T>(input_h);
     DeviceMemory<T> input_c_data;
@@ -1089,23 +1139,29 @@ class CudnnRNNBackwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
     }
     auto params_backprop_data = AsDeviceMemory<T>(params_backprop);
     auto reserve_space_uint8 = CastDeviceMemory<uint8, T>(reserve_space);
-    // Creates a memory callback for the workspace. The memory lives to the end
-    // of this kernel calls.
-    CudnnRNNWorkspaceAllocator workspace_allocator(context);
     bool launch_status = false;
     {
       mutex_lock l(mu_);
+      const CudnnRnnTensorDescriptors* descs = nullptr;
+      OP_REQUIRES_OK(context, tensor_descriptors_.Get<T>(executor, model_shapes,
+                                                         &descs));
+      // Creates a memory callback for the workspace. The memory is kept by this
+      // kernel for its next calls.
+      CudnnRNNPooledWorkspaceAllocator workspace_allocator(context,
+                                                           &workspace_);
       launch_status =
           stream
               ->ThenRnnBackward(
-                  *rnn_desc_, *input_desc, input_data, *hidden_state_desc,
-                  input_h_data, *hidden_state_desc, input_c_data, params_data,
-                  *output_desc, output_data, *hidden_state_desc, output_h_data,
-                  *hidden_state_desc, output_c_data, output_backprop_data,
-                  output_h_backprop_data, output_c_backprop_data,
-                  &input_backprop_data, &input_h_backprop_data,
-                  &input_c_backprop_data, &params_backprop_data,
-                  &reserve_space_uint8, &workspace_allocator)
+                  *rnn_desc_, *descs->input_desc, input_data,
+                  *descs->hidden_state_desc, input_h_data,
+                  *descs->hidden_state_desc, input_c_data, params_data,
+                  *descs->output_desc, output_data, *descs->hidden_state_desc,
+                  output_h_data, *descs->hidden_state_desc, output_c_data,
+                  output_backprop_data, output_h_backprop_data,
+                  output_c_backprop_data, &input_backprop_data,
+                  &input_h_backprop_data, &input_c_backprop_data,
+                  &params_backprop_data, &reserve_space_uint8,
+                  &workspace_allocator)
               .ok();
     }
     OP_REQUIRES(context, launch_status,
@@ -1118,6 +1174,8 @@ class CudnnRNNBackwardOp<GPUDevice, T> : public CudnnRNNKernelCommon {
   std::unique_ptr<RnnDescriptor> rnn_desc_ GUARDED_BY(mu_);
   std::unique_ptr<CudnnRNNPersistentSpaceAllocator> dropout_state_allocator_
       GUARDED_BY(mu_);
+  CudnnRnnTensorDescriptorCache tensor_descriptors_ GUARDED_BY(mu_);
+  PersistentTensor workspace_ GUARDED_BY(mu_);
 };
 
 #define REGISTER_GPU(T)                                                   \
@@ -193,12 +193,13 @@ class FunctionBufferingResource : public ResourceBase {
                   BufferElement buffer_element;
                   buffer_element.status = status;
                   if (!status.ok()) {
+                    // The error ends the sequence. A request that is already
+                    // waiting must still be served, because no further
+                    // function call will be made to fulfill it.
                     end_of_sequence_ = true;
-                    is_buffering_ = false;
-                    buffer_.push_back(std::move(buffer_element));
-                    return;
+                  } else {
+                    buffer_element.value.swap(*rets);
                   }
-                  buffer_element.value.swap(*rets);
                   buffer_.push_back(std::move(buffer_element));
                   if (!requests_.empty()) {
                     buffer_front = std::move(buffer_.front());
@@ -206,7 +207,7 @@ class FunctionBufferingResource : public ResourceBase {
                     callback = std::move(requests_.front());
                     requests_.pop_front();
                   }
-                  if (buffer_.size() < buffer_size_) {
+                  if (status.ok() && buffer_.size() < buffer_size_) {
                     restart_buffering = true;
                   } else {
                     is_buffering_ = false;
@@ -239,6 +240,39 @@ class FunctionBufferingResource : public ResourceBase {
   condition_variable cond_var_;
 };
 
+namespace {
+
+// Canonicalizes `target`. A target that omits the job, replica or task (e.g.
+// "/cpu:0") is taken to be on the same task as `source_device`.
+Status ResolveTargetDevice(const string& target, const string& source_device,
+                           string* resolved) {
+  const string canonical_target =
+      DeviceNameUtils::CanonicalizeDeviceName(target);
+  DeviceNameUtils::ParsedName parsed_target;
+  DeviceNameUtils::ParsedName parsed_source;
+  if (canonical_target.empty() ||
+      !DeviceNameUtils::ParseFullName(canonical_target, &parsed_target) ||
+      !DeviceNameUtils::ParseFullName(source_device, &parsed_source)) {
+    return errors::InvalidArgument("Could not parse target device: ", target);
+  }
+  if (!parsed_target.has_job) {
+    parsed_target.has_job = parsed_source.has_job;
+    parsed_target.job = parsed_source.job;
+  }
+  if (!parsed_target.has_replica) {
+    parsed_target.has_replica = parsed_source.has_replica;
+    parsed_target.replica = parsed_source.replica;
+  }
+  if (!parsed_target.has_task) {
+    parsed_target.has_task = parsed_source.has_task;
+    parsed_target.task = parsed_source.task;
+  }
+  *resolved = DeviceNameUtils::ParsedNameToString(parsed_target);
+  return Status::OK();
+}
+
+}  // namespace
+
 class FunctionBufferResourceHandleOp : public OpKernel {
  public:
   explicit FunctionBufferResourceHandleOp(OpKernelConstruction* ctx)
@@ -256,18 +290,19 @@ class FunctionBufferResourceHandleOp : public OpKernel {
     std::vector<Tensor> func_args;
     func_args.push_back(*string_arg);
 
+    const string& source_device = ctx->device()->name();
+
     // Obtain and canonicalize target_device.
     const Tensor* target_arg;
     OP_REQUIRES_OK(ctx, ctx->input("target_device", &target_arg));
-    const string& target_device =
-        DeviceNameUtils::CanonicalizeDeviceName(target_arg->scalar<string>()());
+    string target_device;
+    OP_REQUIRES_OK(ctx, ResolveTargetDevice(target_arg->scalar<string>()(),
+                                            source_device, &target_device));
 
     FunctionLibraryRuntime* lib = ctx->function_library();
     OP_REQUIRES(ctx, lib != nullptr,
                 errors::Internal("No function library is provided."));
 
-    const string& source_device = ctx->device()->name();
-
     ContainerInfo cinfo;
     OP_REQUIRES_OK(ctx, cinfo.Init(ctx->resource_manager(), def()));
     // Create the resource.
@@ -375,4 +410,312 @@ REGISTER_KERNEL_BUILDER(Name("FunctionBufferingResourceGetNext")
                         FunctionBufferingResourceGetNextOp);
 #endif  // TENSORFLOW_USE_SYCL
 
+// Reads from several FunctionBufferingResources, typically one per remote
+// worker, and hands out their elements in round-robin or first-come order.
+//
+// At most one request is outstanding on each buffer at a time, and at most one
+// element per buffer is held here, so the read-ahead is bounded by the
+// `buffer_size` of the underlying buffers. A buffer that returns an error
+// (including the `OutOfRange` error that ends the remote sequence) is not read
+// from again; the sequence ends once every buffer has ended.
+class MultiTargetFunctionBufferingResource : public ResourceBase {
+ public:
+  enum class Order { kRoundRobin, kFirstCome };
+
+  // Takes ownership of one reference on each of `buffers`.
+  MultiTargetFunctionBufferingResource(
+      std::vector<FunctionBufferingResource*> buffers, Order order)
+      : buffers_(std::move(buffers)),
+        order_(order),
+        states_(buffers_.size()),
+        next_(0) {}
+
+  ~MultiTargetFunctionBufferingResource() override {
+    for (FunctionBufferingResource* buffer : buffers_) {
+      buffer->Unref();
+    }
+  }
+
+  string DebugString() override {
+    return strings::StrCat("MultiTargetFunctionBufferingResource. Targets: ",
+                           buffers_.size());
+  }
+
+  Status Instantiate() {
+    for (FunctionBufferingResource* buffer : buffers_) {
+      TF_RETURN_IF_ERROR(buffer->Instantiate());
+    }
+    return Status::OK();
+  }
+
+  // Runs `callback` on the next element, as soon as it is available.
+  void MaybeGet(FunctionBufferCallback callback) LOCKS_EXCLUDED(mu_) {
+    {
+      mutex_lock l(mu_);
+      requests_.push_back(std::move(callback));
+    }
+    Dispatch();
+  }
+
+ private:
+  struct BufferState {
+    // The elements received from the buffer but not yet handed out.
+    std::deque<BufferElement> ready;
+    // True if a request to the buffer is outstanding.
+    bool fetching = false;
+    // True once the buffer has returned an error.
+    bool finished = false;
+  };
+
+  // Serves as many pending requests as possible, then issues a request to each
+  // buffer that has nothing ready and nothing outstanding.
+  void Dispatch() LOCKS_EXCLUDED(mu_) {
+    std::vector<FunctionBufferCallback> callbacks;
+    std::vector<BufferElement> elements;
+    std::vector<size_t> to_fetch;
+    {
+      mutex_lock l(mu_);
+      while (!requests_.empty()) {
+        BufferElement element;
+        if (!NextElementLocked(&element)) {
+          break;
+        }
+        callbacks.push_back(std::move(requests_.front()));
+        requests_.pop_front();
+        elements.push_back(std::move(element));
+      }
+      for (size_t i = 0; i < states_.size(); ++i) {
+        BufferState& state = states_[i];
+        if (!state.fetching && !state.finished && state.ready.empty()) {
+          state.fetching = true;
+          to_fetch.push_back(i);
+        }
+      }
+    }
+    for (size_t i = 0; i < callbacks.size(); ++i) {
+      callbacks[i](elements[i]);
+    }
+    for (size_t i : to_fetch) {
+      buffers_[i]->MaybeGet([this, i](const BufferElement& buffer_element) {
+        OnElement(i, buffer_element);
+      });
+    }
+  }
+
+  void OnElement(size_t i, const BufferElement& buffer_element)
+      LOCKS_EXCLUDED(mu_) {
+    {
+      mutex_lock l(mu_);
+      BufferState& state = states_[i];
+      state.fetching = false;
+      if (!buffer_element.status.ok()) {
+        state.finished = true;
+      }
+      // The end of one buffer's sequence is not the end of ours, so it is not
+      // passed on.
+      if (!errors::IsOutOfRange(buffer_element.status)) {
+        state.ready.push_back(buffer_element);
+        if (order_ == Order::kFirstCome) {
+          arrivals_.push_back(i);
+        }
+      }
+    }
+    Dispatch();
+  }
+
+  // Moves the next element, in the order given by `order_`, into `element` and
+  // returns true, or returns false if the next element is not yet available.
+  // After every buffer has ended, the element is an `OutOfRange` error.
+  bool NextElementLocked(BufferElement* element) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (order_ == Order::kFirstCome) {
+      if (!arrivals_.empty()) {
+        BufferState& state = states_[arrivals_.front()];
+        arrivals_.pop_front();
+        std::swap(*element, state.ready.front());
+        state.ready.pop_front();
+        return true;
+      }
+    } else {
+      // Buffers that have ended are skipped, but the next buffer in turn is
+      // waited for even if another one has an element ready.
+      for (size_t j = 0; j < states_.size(); ++j) {
+        BufferState& state = states_[next_];
+        if (!state.ready.empty()) {
+          std::swap(*element, state.ready.front());
+          state.ready.pop_front();
+          next_ = (next_ + 1) % states_.size();
+          return true;
+        }
+        if (!state.finished) {
+          return false;
+        }
+        next_ = (next_ + 1) % states_.size();
+      }
+    }
+    for (const BufferState& state : states_) {
+      if (!state.finished || !state.ready.empty()) {
+        return false;
+      }
+    }
+    element->status = errors::OutOfRange("end_of_sequence");
+    return true;
+  }
+
+  mutex mu_;
+  const std::vector<FunctionBufferingResource*> buffers_;
+  const Order order_;
+  std::vector<BufferState> states_ GUARDED_BY(mu_);
+  // The indices of the buffers that produced the ready elements, in the order
+  // in which the elements arrived. Only used for `Order::kFirstCome`.
+  std::deque<size_t> arrivals_ GUARDED_BY(mu_);
+  // The buffer whose turn it is. Only used for `Order::kRoundRobin`.
+  size_t next_ GUARDED_BY(mu_);
+  std::deque<FunctionBufferCallback> requests_ GUARDED_BY(mu_);
+};
+
+class MultiTargetFunctionBufferingResourceHandleOp : public OpKernel {
+ public:
+  explicit MultiTargetFunctionBufferingResourceHandleOp(
+      OpKernelConstruction* ctx)
+      : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("f", &func_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("buffer_size", &buffer_size_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("container", &container_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("shared_name", &name_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("thread_pool_size", &thread_pool_size_));
+    string order;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("order", &order));
+    if (order == "round_robin") {
+      order_ = MultiTargetFunctionBufferingResource::Order::kRoundRobin;
+    } else if (order == "first_come") {
+      order_ = MultiTargetFunctionBufferingResource::Order::kFirstCome;
+    } else {
+      ctx->CtxFailure(errors::InvalidArgument(
+          "order must be \"round_robin\" or \"first_come\", but is: ", order));
+    }
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor* string_args;
+    OP_REQUIRES_OK(ctx, ctx->input("string_args", &string_args));
+    const Tensor* target_devices;
+    OP_REQUIRES_OK(ctx, ctx->input("target_devices", &target_devices));
+    OP_REQUIRES(
+        ctx, TensorShapeUtils::IsVector(string_args->shape()) &&
+                 string_args->shape() == target_devices->shape(),
+        errors::InvalidArgument(
+            "string_args and target_devices must be vectors of the same "
+            "length, but have shapes ",
+            string_args->shape().DebugString(), " and ",
+            target_devices->shape().DebugString()));
+    OP_REQUIRES(ctx, string_args->NumElements() > 0,
+                errors::InvalidArgument("At least one target is required."));
+
+    const string& source_device = ctx->device()->name();
+    std::vector<string> resolved_targets(target_devices->NumElements());
+    for (int64 i = 0; i < target_devices->NumElements(); ++i) {
+      OP_REQUIRES_OK(ctx, ResolveTargetDevice(
+                              target_devices->vec<string>()(i), source_device,
+                              &resolved_targets[i]));
+    }
+
+    FunctionLibraryRuntime* lib = ctx->function_library();
+    OP_REQUIRES(ctx, lib != nullptr,
+                errors::Internal("No function library is provided."));
+
+    ContainerInfo cinfo;
+    OP_REQUIRES_OK(ctx, cinfo.Init(ctx->resource_manager(), def()));
+    MultiTargetFunctionBufferingResource* buffer;
+    OP_REQUIRES_OK(
+        ctx,
+        ctx->resource_manager()
+            ->LookupOrCreate<MultiTargetFunctionBufferingResource>(
+                cinfo.container(), cinfo.name(), &buffer,
+                [lib, &source_device, &resolved_targets, string_args,
+                 this](MultiTargetFunctionBufferingResource** ptr) {
+                  std::vector<FunctionBufferingResource*> buffers;
+                  for (size_t i = 0; i < resolved_targets.size(); ++i) {
+                    std::vector<Tensor> func_args;
+                    func_args.push_back(Tensor(DT_STRING, TensorShape({})));
+                    func_args.back().scalar<string>()() =
+                        string_args->vec<string>()(i);
+                    buffers.push_back(new FunctionBufferingResource(
+                        lib, func_, buffer_size_, source_device,
+                        resolved_targets[i], func_args, thread_pool_size_));
+                  }
+                  *ptr = new MultiTargetFunctionBufferingResource(
+                      std::move(buffers), order_);
+                  return Status::OK();
+                }));
+    core::ScopedUnref s(buffer);
+    OP_REQUIRES_OK(ctx, buffer->Instantiate());
+
+    OP_REQUIRES_OK(ctx,
+                   MakeResourceHandleToOutput(
+                       ctx, 0, cinfo.container(), cinfo.name(),
+                       MakeTypeIndex<MultiTargetFunctionBufferingResource>()));
+  }
+
+ private:
+  NameAttrList func_;
+  int64 buffer_size_;
+  string container_;
+  string name_;
+  int64 thread_pool_size_;
+  MultiTargetFunctionBufferingResource::Order order_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("MultiTargetFunctionBufferingResource")
+                            .Device(DEVICE_CPU)
+                            .HostMemory("resource")
+                            .HostMemory("string_args")
+                            .HostMemory("target_devices"),
+                        MultiTargetFunctionBufferingResourceHandleOp);
+REGISTER_KERNEL_BUILDER(Name("MultiTargetFunctionBufferingResource")
+                            .Device(DEVICE_GPU)
+                            .HostMemory("resource")
+                            .HostMemory("string_args")
+                            .HostMemory("target_devices"),
+                        MultiTargetFunctionBufferingResourceHandleOp);
+
+class MultiTargetFunctionBufferingResourceGetNextOp : public AsyncOpKernel {
+ public:
+  explicit MultiTargetFunctionBufferingResourceGetNextOp(
+      OpKernelConstruction* ctx)
+      : AsyncOpKernel(ctx) {}
+
+  void ComputeAsync(OpKernelContext* ctx, DoneCallback done) override {
+    ResourceHandle handle;
+    OP_REQUIRES_OK_ASYNC(ctx, HandleFromInput(ctx, "resource", &handle), done);
+    MultiTargetFunctionBufferingResource* buffer = nullptr;
+    OP_REQUIRES_OK_ASYNC(
+        ctx,
+        LookupResource<MultiTargetFunctionBufferingResource>(ctx, handle,
+                                                             &buffer),
+        done);
+    core::ScopedUnref s(buffer);
+
+    buffer->MaybeGet([ctx, done](const BufferElement& buffer_element) {
+      if (!buffer_element.status.ok()) {
+        ctx->SetStatus(buffer_element.status);
+        done();
+        return;
+      }
+      for (size_t i = 0; i < buffer_element.value.size(); ++i) {
+        ctx->set_output(i, buffer_element.value[i]);
+      }
+      done();
+    });
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("MultiTargetFunctionBufferingResourceGetNext")
+                            .Device(DEVICE_CPU)
+                            .HostMemory("resource"),
+                        MultiTargetFunctionBufferingResourceGetNextOp);
+REGISTER_KERNEL_BUILDER(Name("MultiTargetFunctionBufferingResourceGetNext")
+                            .Device(DEVICE_GPU)
+                            .HostMemory("resource"),
+                        MultiTargetFunctionBufferingResourceGetNextOp);
+
 }  // namespace tensorflow
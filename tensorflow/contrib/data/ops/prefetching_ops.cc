@@ -55,4 +55,54 @@ output: A list of return values.
 output_types: The type list for the return values.
 )doc");
 
+REGISTER_OP("MultiTargetFunctionBufferingResource")
+    .Input("string_args: string")
+    .Input("target_devices: string")
+    .Output("resource: resource")
+    .Attr("shared_name: string")
+    .Attr("container: string")
+    .Attr("f: func")
+    .Attr("buffer_size: int")
+    .Attr("thread_pool_size: int")
+    .Attr("order: {'round_robin', 'first_come'} = 'round_robin'")
+    .SetShapeFn(shape_inference::UnknownShape)
+    .Doc(R"doc(
+Creates a resource that buffers the results of function calls on several
+devices.
+
+`f` is called on `target_devices[i]` with `string_args[i]`, and up to
+`buffer_size` of its results are buffered for each target. The elements of all
+targets are returned by MultiTargetFunctionBufferingResourceGetNext; a target
+whose function call fails with `OutOfRange` is not called again, and the
+sequence ends when every target has ended.
+
+string_args: A vector of string arguments, one for each function call target.
+target_devices: A vector of the devices to execute the function on.
+resource: Handle to the resource created.
+f: Function to be executed.
+buffer_size: Size of the buffer for each target.
+thread_pool_size: Size of the threadpool doing the prefetching for each target.
+order: If "round_robin", the elements are taken from the targets in turn, and
+  the next target in turn is waited for even if another one has an element
+  ready. If "first_come", the elements are returned in the order in which they
+  arrive from the targets.
+container: If non-empty, this resource is placed in the given container.
+  Otherwise, a default container is used.
+shared_name: If non-empty, this resource will be shared under the given name
+  across multiple sessions.
+)doc");
+
+REGISTER_OP("MultiTargetFunctionBufferingResourceGetNext")
+    .Input("resource: resource")
+    .Attr("output_types: list(type)")
+    .Output("output: output_types")
+    .SetShapeFn(shape_inference::UnknownShape)
+    .Doc(R"doc(
+Gets the next element from a MultiTargetFunctionBufferingResource.
+
+resource: The MultiTargetFunctionBufferingResource handle.
+output: A list of return values.
+output_types: The type list for the return values.
+)doc");
+
 }  // namespace tensorflow
@@ -23,6 +23,8 @@ import numpy as np
 
 from tensorflow.contrib.data.python.ops import batching
 from tensorflow.contrib.data.python.ops import dataset_ops
+from tensorflow.core.example import example_pb2
+from tensorflow.core.example import feature_pb2
 from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import errors
@@ -30,6 +32,7 @@ from tensorflow.python.framework import sparse_tensor
 from tensorflow.python.framework import tensor_shape
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import math_ops
+from tensorflow.python.ops import parsing_ops
 from tensorflow.python.ops import string_ops
 from tensorflow.python.platform import test
 from tensorflow.python.util import compat
@@ -523,5 +526,65 @@ class BatchDatasetTest(test.TestCase):
                                    "number of elements does not match"):
         sess.run(get_next)
 
+  def _makeExample(self, i):
+    features = {
+        "label": feature_pb2.Feature(
+            int64_list=feature_pb2.Int64List(value=[i])),
+        "weights": feature_pb2.Feature(
+            float_list=feature_pb2.FloatList(value=[i * 0.5, i * 1.5])),
+        "keywords": feature_pb2.Feature(
+            bytes_list=feature_pb2.BytesList(
+                value=[compat.as_bytes("kw%d" % j) for j in range(i % 3)])),
+    }
+    if i % 2 == 0:
+      features["score"] = feature_pb2.Feature(
+          float_list=feature_pb2.FloatList(value=[float(i)]))
+    return example_pb2.Example(features=feature_pb2.Features(
+        feature=features)).SerializeToString()
+
+  def testParseExampleBatch(self):
+    features = {
+        "label": parsing_ops.FixedLenFeature([], dtypes.int64),
+        "weights": parsing_ops.FixedLenFeature([2], dtypes.float32),
+        "score": parsing_ops.FixedLenFeature(
+            [], dtypes.float32, default_value=-1.0),
+        "keywords": parsing_ops.VarLenFeature(dtypes.string),
+    }
+    serialized = [self._makeExample(i) for i in range(7)]
+    dataset = dataset_ops.Dataset.from_tensor_slices(serialized).apply(
+        batching.parse_example_batch(features, 4))
+    self.assertEqual(dtypes.int64, dataset.output_types["label"])
+    self.assertEqual([None, 2], dataset.output_shapes["weights"].as_list())
+    self.assertEqual((dtypes.int64, dtypes.string, dtypes.int64),
+                     dataset.output_types["keywords"])
+    iterator = dataset.make_one_shot_iterator()
+    get_next = iterator.get_next()
+
+    serialized_batch = array_ops.placeholder(dtypes.string, shape=[None])
+    expected_op = parsing_ops.parse_example(serialized_batch, features)
+    with self.test_session() as sess:
+      for start in [0, 4]:
+        expected = sess.run(
+            expected_op,
+            feed_dict={serialized_batch: serialized[start:start + 4]})
+        result = sess.run(get_next)
+        for key in ["label", "weights", "score"]:
+          self.assertAllEqual(expected[key], result[key])
+        indices, values, dense_shape = result["keywords"]
+        self.assertAllEqual(expected["keywords"].indices, indices)
+        self.assertAllEqual(expected["keywords"].values, values)
+        self.assertAllEqual(expected["keywords"].dense_shape, dense_shape)
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testParseExampleBatchMissingRequiredFeature(self):
+    features = {"missing": parsing_ops.FixedLenFeature([], dtypes.int64)}
+    dataset = dataset_ops.Dataset.from_tensors(self._makeExample(0)).apply(
+        batching.parse_example_batch(features, 4))
+    get_next = dataset.make_one_shot_iterator().get_next()
+    with self.test_session() as sess:
+      with self.assertRaisesRegexp(errors.InvalidArgumentError, "missing"):
+        sess.run(get_next)
+
 if __name__ == "__main__":
   test.main()
@@ -101,6 +101,26 @@ class GroupByWindowTest(test.TestCase):
       self.assertAllEqual([0, 0, 0], sess.run(get_next))
       self.assertAllEqual([1], sess.run(get_next))
 
+  def testMaxBufferedBytes(self):
+    components = np.array([0, 2, 4, 1, 6, 3], dtype=np.int64)
+    iterator = (
+        dataset_ops.Dataset.from_tensor_slices(components).apply(
+            grouping.group_by_window(
+                lambda x: x % 2, lambda _, xs: xs.batch(10), 10,
+                max_buffered_bytes=24)).make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      # The fourth element takes the four buffered int64 scalars over the
+      # budget, so the window that holds the most bytes is flushed early.
+      self.assertAllEqual([0, 2, 4], sess.run(get_next))
+      self.assertAllEqual([6], sess.run(get_next))
+      self.assertAllEqual([1, 3], sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
   def testReduceFuncError(self):
     components = np.random.randint(100, size=(200,)).astype(np.int64)
 
@@ -347,5 +367,64 @@ class BucketTest(test.TestCase):
       self.assertEqual(batches, 15)
 
 
+
+class BucketBySequenceLengthTest(test.TestCase):
+
+  def _sequences(self, num_elements):
+    # Element `i` is a vector of length `i`, filled with `i`.
+    return dataset_ops.Dataset.range(num_elements).map(
+        lambda x: array_ops.fill([math_ops.cast(x, dtypes.int32)], x))
+
+  def _batchShapes(self, dataset):
+    iterator = dataset.make_one_shot_iterator()
+    get_next = iterator.get_next()
+    shapes = []
+    with self.test_session() as sess:
+      with self.assertRaises(errors.OutOfRangeError):
+        while True:
+          batch = sess.run(get_next)
+          # Each batch holds elements of a single bucket, with zero padding.
+          for row in batch:
+            length = np.count_nonzero(row) or 1
+            self.assertTrue(all(x == row[0] for x in row[:length]))
+          shapes.append(batch.shape)
+    return shapes
+
+  def testBucketsByLength(self):
+    dataset = self._sequences(8).apply(
+        grouping.bucket_by_sequence_length(
+            lambda x: array_ops.shape(x)[0], [3, 6], [2, 2, 2]))
+    self.assertEqual([None, None], dataset.output_shapes.as_list())
+    # Each batch is padded to its longest element.
+    self.assertEqual([(2, 1), (2, 4), (2, 7), (1, 2), (1, 5)],
+                     self._batchShapes(dataset))
+
+  def testPadToBucketBoundary(self):
+    dataset = self._sequences(6).apply(
+        grouping.bucket_by_sequence_length(
+            lambda x: array_ops.shape(x)[0], [3, 6], [2, 2, 2],
+            pad_to_bucket_boundary=True))
+    # Each batch is padded to the longest length of its bucket.
+    self.assertEqual([(2, 2), (2, 5), (1, 2), (1, 5)],
+                     self._batchShapes(dataset))
+
+  def testMaxBufferedBytes(self):
+    # The elements of lengths 0 to 5 take 120 bytes, so the budget is hit by
+    # the element of length 5, which flushes the bucket for lengths [3, 6).
+    dataset = self._sequences(6).apply(
+        grouping.bucket_by_sequence_length(
+            lambda x: array_ops.shape(x)[0], [3, 6], [10, 10, 10],
+            max_buffered_bytes=100))
+    self.assertEqual([(3, 5), (3, 2)], self._batchShapes(dataset))
+
+  def testInvalidArguments(self):
+    with self.assertRaises(ValueError):
+      grouping.bucket_by_sequence_length(lambda x: x, [], [1])
+    with self.assertRaises(ValueError):
+      grouping.bucket_by_sequence_length(lambda x: x, [3, 3], [1, 1, 1])
+    with self.assertRaises(ValueError):
+      grouping.bucket_by_sequence_length(lambda x: x, [3, 6], [1, 1])
+
+
 if __name__ == "__main__":
   test.main()
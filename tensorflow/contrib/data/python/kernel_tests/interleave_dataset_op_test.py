@@ -26,6 +26,7 @@ from six.moves import zip_longest
 
 from tensorflow.contrib.data.python.ops import dataset_ops
 from tensorflow.contrib.data.python.ops import interleave_ops
+from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import errors
 from tensorflow.python.ops import array_ops
@@ -547,5 +548,88 @@ class ParallelInterleaveDatasetTest(test.TestCase):
   def testTooManyReadersSloppy(self):
     self._testTooManyReaders(sloppy=True)
 
+  def _testPrefetchOutputElements(self, max_buffered_bytes=None):
+
+    def interleave_fn(x):
+      return dataset_ops.Dataset.from_tensors(x).repeat(x)
+
+    dataset = dataset_ops.Dataset.from_tensor_slices([4, 5, 6])
+    dataset = dataset.repeat(self.repeat_count)
+    dataset = dataset.apply(
+        interleave_ops.parallel_interleave(
+            interleave_fn,
+            cycle_length=2,
+            block_length=3,
+            buffer_output_elements=4,
+            max_buffered_bytes=max_buffered_bytes))
+    iterator = dataset.make_one_shot_iterator()
+    next_element = iterator.get_next()
+
+    with self.test_session() as sess:
+      # The prefetching must not change the deterministic order.
+      for expected_element in self._interleave(
+          [[4] * 4, [5] * 5, [6] * 6] * self.repeat_count, 2, 3):
+        self.assertEqual(expected_element, sess.run(next_element))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(next_element)
+
+  def testPrefetchOutputElements(self):
+    self._testPrefetchOutputElements()
+
+  def testPrefetchOutputElementsWithMemoryBudget(self):
+    # The budget admits only one int64 element across all of the inputs.
+    self._testPrefetchOutputElements(max_buffered_bytes=8)
+
+  def testElasticCycleLengthSloppy(self):
+    fives_produced = threading.Event()
+    waited = []
+
+    def produce_py_fn(x):
+      if x == 4:
+        # Returns false on timeout, if the 5s were never read concurrently.
+        waited.append(fives_produced.wait(10))
+      elif x == 5:
+        fives_produced.set()
+      return x
+
+    def interleave_fn(x):
+      dataset = dataset_ops.Dataset.from_tensors(x).repeat(x)
+      return dataset.map(lambda y: script_ops.py_func(produce_py_fn, [y],
+                                                      y.dtype))
+
+    dataset = dataset_ops.Dataset.from_tensor_slices(
+        constant_op.constant([4, 5], dtype=dtypes.int64))
+    dataset = dataset.apply(
+        interleave_ops.parallel_interleave(
+            interleave_fn, cycle_length=1, sloppy=True, max_cycle_length=2))
+    iterator = dataset.make_one_shot_iterator()
+    next_element = iterator.get_next()
+
+    with self.test_session() as sess:
+      output_values = []
+      for _ in range(9):
+        output_values.append(sess.run(next_element))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(next_element)
+
+    # The slow input at the head of the cycle did not stop the 5s from being
+    # read on the widened cycle.
+    self.assertItemsEqual([4] * 4 + [5] * 5, output_values)
+    self.assertTrue(all(waited))
+
+  def testInvalidMaxCycleLength(self):
+    dataset = dataset_ops.Dataset.range(10).apply(
+        interleave_ops.parallel_interleave(
+            dataset_ops.Dataset.from_tensors,
+            cycle_length=4,
+            sloppy=True,
+            max_cycle_length=2))
+    iterator = dataset.make_initializable_iterator()
+
+    with self.test_session() as sess:
+      with self.assertRaisesRegexp(errors.InvalidArgumentError,
+                                   "max_cycle_length"):
+        sess.run(iterator.initializer)
+
 if __name__ == "__main__":
   test.main()
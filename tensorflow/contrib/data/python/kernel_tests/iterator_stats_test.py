@@ -0,0 +1,80 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the per-stage input pipeline statistics."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.contrib.data.python.ops import dataset_ops
+from tensorflow.contrib.data.python.ops import iterator_ops
+from tensorflow.core.framework import summary_pb2
+from tensorflow.python.framework import errors
+from tensorflow.python.platform import test
+
+
+class IteratorStatsTest(test.TestCase):
+
+  def _getStats(self, sess, stats_op):
+    summary = summary_pb2.Summary()
+    summary.ParseFromString(sess.run(stats_op))
+    return {value.tag: value.simple_value for value in summary.value}
+
+  def testStatsPerStage(self):
+    iterator = (dataset_ops.Dataset.range(100).map(lambda x: x * 2)
+                .prefetch(4).make_one_shot_iterator())
+    next_element = iterator.get_next()
+    stats_op = iterator_ops.get_iterator_stats(iterator)
+
+    with self.test_session() as sess:
+      self.assertEqual({}, self._getStats(sess, stats_op))
+      for i in range(10):
+        self.assertEqual(i * 2, sess.run(next_element))
+      stats = self._getStats(sess, stats_op)
+
+    self.assertEqual(10, stats["Iterator::Prefetch/elements"])
+    self.assertEqual(80, stats["Iterator::Prefetch/bytes"])
+    self.assertGreaterEqual(stats["Iterator::Prefetch/self_time_us"], 0)
+    self.assertEqual(4, stats["Iterator::Prefetch/buffer_capacity"])
+    self.assertLessEqual(stats["Iterator::Prefetch/buffer_occupancy"], 4)
+
+    # The prefetch thread may have read ahead of the consumer, but by no more
+    # than the buffer size and the element it is working on.
+    map_elements = stats["Iterator::Prefetch::Map/elements"]
+    self.assertGreaterEqual(map_elements, 10)
+    self.assertLessEqual(map_elements, 15)
+    self.assertEqual(8 * map_elements, stats["Iterator::Prefetch::Map/bytes"])
+    self.assertEqual(map_elements,
+                     stats["Iterator::Prefetch::Map::Range/elements"])
+    self.assertNotIn("Iterator::Prefetch::Map/buffer_capacity", stats)
+
+  def testStatsAreCollectedAfterTheFirstRequest(self):
+    iterator = dataset_ops.Dataset.range(5).make_one_shot_iterator()
+    next_element = iterator.get_next()
+    stats_op = iterator_ops.get_iterator_stats(iterator)
+
+    with self.test_session() as sess:
+      sess.run(next_element)
+      self.assertEqual({}, self._getStats(sess, stats_op))
+      for _ in range(4):
+        sess.run(next_element)
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(next_element)
+      stats = self._getStats(sess, stats_op)
+      self.assertEqual(4, stats["Iterator::Range/elements"])
+      self.assertEqual(32, stats["Iterator::Range/bytes"])
+
+
+if __name__ == "__main__":
+  test.main()
@@ -22,13 +22,17 @@ import threading
 
 from tensorflow.contrib.data.python.ops import prefetching_ops
 from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.client import session
 from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.data.ops import iterator_ops
 from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
 from tensorflow.python.framework import function
 from tensorflow.python.framework import ops
 from tensorflow.python.framework import test_util
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
 from tensorflow.python.platform import test
 
 
@@ -104,5 +108,147 @@ class StagingAreaOpsTest(test.TestCase):
                              "/job:localhost/replica:0/task:0/gpu:0")
 
 
+class PrefetchToDeviceTest(test.TestCase):
+
+  def testPrefetchToDevice(self):
+    host_dataset = dataset_ops.Dataset.range(10)
+    device_dataset = host_dataset.apply(
+        prefetching_ops.prefetch_to_device("/cpu:1"))
+
+    self.assertEqual(host_dataset.output_types, device_dataset.output_types)
+    self.assertEqual(host_dataset.output_shapes, device_dataset.output_shapes)
+
+    iterator = device_dataset.make_one_shot_iterator()
+    next_element = iterator.get_next()
+    self.assertEqual(dtypes.int64, next_element.dtype)
+    self.assertEqual([], next_element.shape)
+
+    worker_config = config_pb2.ConfigProto()
+    worker_config.device_count["CPU"] = 2
+    with self.test_session(config=worker_config) as sess:
+      for i in range(10):
+        self.assertEqual(i, sess.run(next_element))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(next_element)
+
+  def testPrefetchDictToDevice(self):
+    host_dataset = dataset_ops.Dataset.range(10).map(lambda x: {"a": x})
+    device_dataset = host_dataset.apply(
+        prefetching_ops.prefetch_to_device("/cpu:1", buffer_size=3))
+
+    iterator = device_dataset.make_one_shot_iterator()
+    next_element = iterator.get_next()
+    self.assertEqual(dtypes.int64, next_element["a"].dtype)
+
+    worker_config = config_pb2.ConfigProto()
+    worker_config.device_count["CPU"] = 2
+    with self.test_session(config=worker_config) as sess:
+      for i in range(10):
+        self.assertEqual({"a": i}, sess.run(next_element))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(next_element)
+
+  def testPrefetchToDeviceGpu(self):
+    if not test_util.is_gpu_available():
+      self.skipTest("No GPU available")
+
+    host_dataset = dataset_ops.Dataset.range(10).map(
+        lambda x: math_ops.cast(x, dtypes.float32))
+    device_dataset = host_dataset.apply(
+        prefetching_ops.prefetch_to_device("/gpu:0"))
+
+    iterator = device_dataset.make_one_shot_iterator()
+    next_element = iterator.get_next()
+
+    with self.test_session() as sess:
+      for i in range(10):
+        self.assertEqual(float(i), sess.run(next_element))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(next_element)
+
+  def testInitializableIteratorNotSupported(self):
+    device_dataset = dataset_ops.Dataset.range(10).apply(
+        prefetching_ops.prefetch_to_device("/cpu:1"))
+    with self.assertRaises(NotImplementedError):
+      device_dataset.make_initializable_iterator()
+
+
+class MultiWorkerIteratorTest(test.TestCase):
+
+  def _dataset_fn(self, worker_index):
+    # Worker 0 produces [0, 1, 2] and worker 1 produces [10, 11, 12, 13].
+    return dataset_ops.Dataset.range(worker_index * 10,
+                                     worker_index * 11 + 3)
+
+  def _worker_devices(self, num_workers):
+    return ["/job:worker/replica:0/task:%d/cpu:0" % (i + 1)
+            for i in range(num_workers)]
+
+  def testRoundRobin(self):
+    workers, _ = test_util.create_local_cluster(3, 1)
+    with ops.device("/job:worker/replica:0/task:0/cpu:0"):
+      iterator = prefetching_ops.make_multi_worker_iterator(
+          self._dataset_fn, self._worker_devices(2), buffer_size=2)
+      next_element = iterator.get_next()
+    self.assertEqual(dtypes.int64, next_element.dtype)
+    self.assertEqual([], next_element.shape)
+
+    with session.Session(workers[0].target) as sess:
+      for expected in [0, 10, 1, 11, 2, 12, 13]:
+        self.assertEqual(expected, sess.run(next_element))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(next_element)
+
+  def testFirstCome(self):
+    workers, _ = test_util.create_local_cluster(3, 1)
+    with ops.device("/job:worker/replica:0/task:0/cpu:0"):
+      iterator = prefetching_ops.make_multi_worker_iterator(
+          self._dataset_fn, self._worker_devices(2), order="first_come")
+      next_element = iterator.get_next()
+
+    with session.Session(workers[0].target) as sess:
+      results = [sess.run(next_element) for _ in range(7)]
+      self.assertEqual([0, 1, 2, 10, 11, 12, 13], sorted(results))
+      # Each worker's elements arrive in order.
+      self.assertEqual([0, 1, 2], [x for x in results if x < 10])
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(next_element)
+
+  def testErrorOnWorker(self):
+    workers, _ = test_util.create_local_cluster(3, 1)
+
+    def dataset_fn(unused_worker_index):
+      return dataset_ops.Dataset.from_tensor_slices([1.0, 0.0]).map(
+          lambda x: array_ops.check_numerics(1.0 / x, "x"))
+
+    with ops.device("/job:worker/replica:0/task:0/cpu:0"):
+      iterator = prefetching_ops.make_multi_worker_iterator(
+          dataset_fn, self._worker_devices(2))
+      next_element = iterator.get_next()
+
+    with session.Session(workers[0].target) as sess:
+      self.assertEqual(1.0, sess.run(next_element))
+      self.assertEqual(1.0, sess.run(next_element))
+      with self.assertRaises(errors.InvalidArgumentError):
+        sess.run(next_element)
+
+  def testMismatchedTypes(self):
+
+    def dataset_fn(worker_index):
+      dataset = dataset_ops.Dataset.range(10)
+      if worker_index == 1:
+        dataset = dataset.map(lambda x: math_ops.cast(x, dtypes.int32))
+      return dataset
+
+    with self.assertRaises(TypeError):
+      prefetching_ops.make_multi_worker_iterator(
+          dataset_fn, self._worker_devices(2))
+
+  def testInvalidOrder(self):
+    with self.assertRaises(ValueError):
+      prefetching_ops.make_multi_worker_iterator(
+          self._dataset_fn, self._worker_devices(2), order="random")
+
+
 if __name__ == "__main__":
   test.main()
@@ -1000,6 +1000,55 @@ class TFRecordDatasetTest(test.TestCase):
       with self.assertRaises(errors.OutOfRangeError):
         sess.run(iterator.get_next())
 
+  def _readShuffled(self, sess, get_next):
+    records = []
+    while True:
+      try:
+        records.append(sess.run(get_next))
+      except errors.OutOfRangeError:
+        return records
+
+  def testShuffledReadContainsEveryRecord(self):
+    expected = sorted(
+        self._record(f, r)
+        for f in range(self._num_files) for r in range(self._num_records))
+    d = readers.ShuffledTFRecordDataset(self.test_filenames, seed=37)
+    iterator = d.make_initializable_iterator()
+    get_next = iterator.get_next()
+    with self.test_session() as sess:
+      sess.run(iterator.initializer)
+      first = self._readShuffled(sess, get_next)
+      self.assertEqual(expected, sorted(first))
+      # The order mixes records from different files.
+      self.assertNotEqual(expected, first)
+
+      # Each iteration uses a different permutation by default.
+      sess.run(iterator.initializer)
+      second = self._readShuffled(sess, get_next)
+      self.assertEqual(expected, sorted(second))
+      self.assertNotEqual(first, second)
+
+  def testShuffledReadFixedSeed(self):
+    d = readers.ShuffledTFRecordDataset(
+        self.test_filenames, seed=37, reshuffle_each_iteration=False,
+        buffer_size=5)
+    iterator = d.make_initializable_iterator()
+    get_next = iterator.get_next()
+    with self.test_session() as sess:
+      sess.run(iterator.initializer)
+      first = self._readShuffled(sess, get_next)
+      sess.run(iterator.initializer)
+      self.assertEqual(first, self._readShuffled(sess, get_next))
+
+  def testShuffledReadEmptyFile(self):
+    fn = os.path.join(self.get_temp_dir(), "empty.tfrecord")
+    python_io.TFRecordWriter(fn).close()
+    d = readers.ShuffledTFRecordDataset([fn] + self.test_filenames)
+    iterator = d.make_one_shot_iterator()
+    with self.test_session() as sess:
+      self.assertEqual(self._num_files * self._num_records,
+                       len(self._readShuffled(sess, iterator.get_next())))
+
 
 class ReadBatchFeaturesTest(test.TestCase):
 
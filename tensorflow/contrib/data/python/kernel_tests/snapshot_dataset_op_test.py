@@ -0,0 +1,134 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the experimental input pipeline ops."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import glob
+import os
+import shutil
+import tempfile
+
+import numpy as np
+
+from tensorflow.contrib.data.python.ops import dataset_ops
+from tensorflow.contrib.data.python.ops import snapshot_ops
+from tensorflow.python.framework import errors
+from tensorflow.python.platform import test
+
+
+class SnapshotDatasetTest(test.TestCase):
+
+  def setUp(self):
+    self.tmp_dir = tempfile.mkdtemp()
+
+  def tearDown(self):
+    if self.tmp_dir:
+      shutil.rmtree(self.tmp_dir, ignore_errors=True)
+
+  def _snapshotDataset(self, compression_type="ZLIB", num_shards=3):
+    components = (np.arange(10), np.array(["a%d" % i for i in range(10)]),
+                  np.arange(20.0).reshape(10, 2))
+    return dataset_ops.Dataset.from_tensor_slices(components).repeat(2).apply(
+        snapshot_ops.snapshot(self.tmp_dir, compression_type, num_shards))
+
+  def _readAll(self, sess, iterator):
+    sess.run(iterator.initializer)
+    get_next = iterator.get_next()
+    elements = []
+    while True:
+      try:
+        elements.append(sess.run(get_next))
+      except errors.OutOfRangeError:
+        return elements
+
+  def _metadataFiles(self):
+    return glob.glob(os.path.join(self.tmp_dir, "*", "snapshot.metadata"))
+
+  def _assertElementsEqual(self, expected, actual):
+    self.assertEqual(len(expected), len(actual))
+    for expected_element, actual_element in zip(expected, actual):
+      for expected_component, actual_component in zip(expected_element,
+                                                      actual_element):
+        self.assertAllEqual(expected_component, actual_component)
+
+  def testWriteThenRead(self):
+    for compression_type in ["", "ZLIB", "GZIP"]:
+      for num_shards in [1, 3]:
+        shutil.rmtree(self.tmp_dir)
+        os.mkdir(self.tmp_dir)
+        iterator = self._snapshotDataset(
+            compression_type, num_shards).make_initializable_iterator()
+        with self.test_session() as sess:
+          written = self._readAll(sess, iterator)
+          self.assertEqual(20, len(written))
+          for i, (index, name, values) in enumerate(written):
+            self.assertEqual(i % 10, index)
+            self.assertEqual(("a%d" % (i % 10)).encode(), name)
+            self.assertAllEqual([2.0 * (i % 10), 2.0 * (i % 10) + 1], values)
+          self.assertEqual(1, len(self._metadataFiles()))
+
+          read = self._readAll(sess, iterator)
+          self._assertElementsEqual(written, read)
+
+  def testReadsFromSnapshot(self):
+    iterator = self._snapshotDataset("", 1).make_initializable_iterator()
+    with self.test_session() as sess:
+      self._readAll(sess, iterator)
+      # Corrupting the only shard makes the next iteration fail, which shows
+      # that the elements are read back from the snapshot.
+      shards = glob.glob(os.path.join(self.tmp_dir, "*", "run_*", "shard_*"))
+      self.assertEqual(1, len(shards))
+      with open(shards[0], "wb") as f:
+        f.write(b"corrupt" * 16)
+      with self.assertRaises(errors.DataLossError):
+        self._readAll(sess, iterator)
+
+  def testDifferentInputTakesNewSnapshot(self):
+    with self.test_session() as sess:
+      self._readAll(
+          sess, self._snapshotDataset().make_initializable_iterator())
+      other = dataset_ops.Dataset.range(5).apply(
+          snapshot_ops.snapshot(self.tmp_dir))
+      self.assertEqual(
+          list(range(5)),
+          self._readAll(sess, other.make_initializable_iterator()))
+      self.assertEqual(2, len(self._metadataFiles()))
+
+  def testPartialIterationDoesNotCompleteSnapshot(self):
+    iterator = self._snapshotDataset().make_initializable_iterator()
+    get_next = iterator.get_next()
+    with self.test_session() as sess:
+      sess.run(iterator.initializer)
+      for _ in range(5):
+        sess.run(get_next)
+      self.assertEqual([], self._metadataFiles())
+
+      # Re-initializing the iterator writes a snapshot from the start.
+      self.assertEqual(20, len(self._readAll(sess, iterator)))
+      self.assertEqual(1, len(self._metadataFiles()))
+
+  def testUnserializableInput(self):
+    dataset = dataset_ops.Dataset.range(5).map(lambda x: x * 2).apply(
+        snapshot_ops.snapshot(self.tmp_dir))
+    iterator = dataset.make_initializable_iterator()
+    with self.test_session() as sess:
+      with self.assertRaises(errors.UnimplementedError):
+        sess.run(iterator.initializer)
+
+
+if __name__ == "__main__":
+  test.main()
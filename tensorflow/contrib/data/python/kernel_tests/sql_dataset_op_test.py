@@ -91,6 +91,73 @@ class SqlDatasetTest(test.TestCase):
     conn.commit()
     conn.close()
 
+  # Test that SqlDataset can read batches of rows from a database table.
+  def testReadResultSetInBatches(self):
+    dataset = readers.SqlDataset(
+        self.driver_name,
+        self.data_source_name,
+        self.query, (dtypes.string, dtypes.int64, dtypes.uint16),
+        batch_size=3)
+    self.assertEqual([None], dataset.output_shapes[0].as_list())
+    iterator = dataset.make_initializable_iterator()
+    get_next = iterator.get_next()
+    with self.test_session() as sess:
+      sess.run(
+          iterator.initializer,
+          feed_dict={
+              self.query: "SELECT first_name, favorite_big_number, "
+                          "account_balance FROM students ORDER BY first_name "
+                          "DESC"
+          })
+      first_names, big_numbers, balances = sess.run(get_next)
+      self.assertAllEqual([b"John", b"Jane"], first_names)
+      self.assertAllEqual([9223372036854775807, -9223372036854775808],
+                          big_numbers)
+      self.assertAllEqual([0, 65535], balances)
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  # Test that a batched SqlDataset only returns full batches before the last.
+  def testReadResultSetInPartialBatches(self):
+    dataset = readers.SqlDataset(
+        self.driver_name,
+        self.data_source_name,
+        self.query, (dtypes.string,),
+        batch_size=1)
+    iterator = dataset.make_initializable_iterator()
+    get_next = iterator.get_next()
+    with self.test_session() as sess:
+      sess.run(
+          iterator.initializer,
+          feed_dict={
+              self.query: "SELECT first_name FROM students ORDER BY "
+                          "first_name DESC"
+          })
+      self.assertAllEqual([b"John"], sess.run(get_next)[0])
+      self.assertAllEqual([b"Jane"], sess.run(get_next)[0])
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  # Test that the partitions of a table can be read concurrently.
+  def testReadSqlPartitions(self):
+    dataset = readers.read_sql_partitions(
+        "sqlite", self.data_source_name, [
+            "SELECT first_name, last_name FROM people WHERE id < 2",
+            "SELECT first_name, last_name FROM people WHERE id >= 2"
+        ], (dtypes.string, dtypes.string),
+        batch_size=2)
+    iterator = dataset.make_one_shot_iterator()
+    get_next = iterator.get_next()
+    with self.test_session() as sess:
+      first_names, last_names = sess.run(get_next)
+      self.assertAllEqual([b"Benjamin"], first_names)
+      self.assertAllEqual([b"Franklin"], last_names)
+      first_names, last_names = sess.run(get_next)
+      self.assertAllEqual([b"John"], first_names)
+      self.assertAllEqual([b"Doe"], last_names)
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
   # Test that SqlDataset can read from a database table.
   def testReadResultSet(self):
     init_op, get_next = self._createSqlDataset((dtypes.string, dtypes.string,
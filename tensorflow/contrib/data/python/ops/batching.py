@@ -19,6 +19,7 @@ from __future__ import print_function
 
 from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.data.util import nest
+from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
 from tensorflow.python.framework import tensor_shape
@@ -26,6 +27,7 @@ from tensorflow.python.framework import tensor_util
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import gen_dataset_ops
 from tensorflow.python.ops import math_ops
+from tensorflow.python.ops import parsing_ops
 
 
 def dense_to_sparse_batch(batch_size, row_shape):
@@ -348,3 +350,119 @@ def map_and_batch(map_func, batch_size, num_parallel_batches=1):
                                num_parallel_batches)
 
   return _apply_fn
+
+
+class _ParseExampleBatchDataset(dataset_ops.Dataset):
+  """A `Dataset` that batches and parses serialized `Example` protos.
+
+  Each element is a tuple with the outputs of `gen_parsing_ops._parse_example`
+  as its components: the indices, values and dense shapes of the sparse
+  features, then the values of the dense features, each in sorted key order.
+  """
+
+  def __init__(self, input_dataset, features, batch_size):
+    super(_ParseExampleBatchDataset, self).__init__()
+    if input_dataset.output_types != dtypes.string:
+      raise TypeError("`parse_example_batch` requires a dataset of `tf.string` "
+                      "elements, but got %r." % input_dataset.output_types)
+    self._input_dataset = input_dataset
+    self._batch_size = ops.convert_to_tensor(
+        batch_size, dtype=dtypes.int64, name="batch_size")
+    # pylint: disable=protected-access
+    (self._sparse_keys, self._sparse_types, self._dense_keys,
+     self._dense_types, dense_defaults, dense_shapes) = (
+         parsing_ops._features_to_raw_params(
+             features,
+             [parsing_ops.VarLenFeature, parsing_ops.FixedLenFeature]))
+    # pylint: enable=protected-access
+    if not self._sparse_keys and not self._dense_keys:
+      raise ValueError("Must provide at least one sparse key or dense key")
+    self._dense_shapes = [tensor_shape.as_shape(s) for s in dense_shapes]
+
+    self._dense_defaults = []
+    for key, dtype, shape in zip(self._dense_keys, self._dense_types,
+                                 self._dense_shapes):
+      default_value = dense_defaults.get(key)
+      if default_value is None:
+        default_value = constant_op.constant([], dtype=dtype)
+      else:
+        default_value = array_ops.reshape(
+            ops.convert_to_tensor(default_value, dtype=dtype), shape)
+      self._dense_defaults.append(default_value)
+
+  def components_to_dict(self, *components):
+    """Maps the components of an element to a `dict` keyed by feature."""
+    num_sparse = len(self._sparse_keys)
+    result = {}
+    for i, key in enumerate(self._sparse_keys):
+      result[key] = (components[i], components[num_sparse + i],
+                     components[2 * num_sparse + i])
+    for i, key in enumerate(self._dense_keys):
+      result[key] = components[3 * num_sparse + i]
+    return result
+
+  def _as_variant_tensor(self):
+    # pylint: disable=protected-access
+    input_resource = self._input_dataset._as_variant_tensor()
+    # pylint: enable=protected-access
+    return gen_dataset_ops.parse_example_batch_dataset(
+        input_resource,
+        self._batch_size,
+        sparse_keys=self._sparse_keys,
+        dense_keys=self._dense_keys,
+        dense_defaults=self._dense_defaults,
+        sparse_types=self._sparse_types,
+        dense_shapes=[s.as_proto() for s in self._dense_shapes],
+        output_types=nest.flatten(self.output_types),
+        output_shapes=nest.flatten(self.output_shapes))
+
+  @property
+  def output_shapes(self):
+    num_sparse = len(self._sparse_keys)
+    batch_dim = tensor_shape.vector(
+        tensor_util.constant_value(self._batch_size))
+    return tuple(
+        [tensor_shape.matrix(None, 2)] * num_sparse +
+        [tensor_shape.vector(None)] * num_sparse +
+        [tensor_shape.vector(2)] * num_sparse +
+        [batch_dim.concatenate(s) for s in self._dense_shapes])
+
+  @property
+  def output_types(self):
+    num_sparse = len(self._sparse_keys)
+    return tuple([dtypes.int64] * num_sparse + self._sparse_types +
+                 [dtypes.int64] * num_sparse + self._dense_types)
+
+
+def parse_example_batch(features, batch_size):
+  """Batches serialized `Example` protos and parses each batch.
+
+  Functionally, this is equivalent to `batch` followed by a `map` that applies
+  @{tf.parse_example}. However, by fusing the two transformations, each batch
+  is parsed by a single multi-threaded call, directly into the batched output
+  tensors, without invoking a function per batch.
+
+  Like `batch`, the last batch is smaller if `batch_size` does not evenly
+  divide the number of input elements.
+
+  Args:
+    features: A `dict` mapping feature keys to `FixedLenFeature` or
+      `VarLenFeature` values. See @{tf.parse_example}.
+    batch_size: A `tf.int64` scalar `tf.Tensor`, representing the number of
+      consecutive elements of this dataset to combine in a single batch.
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    @{tf.contrib.data.Dataset.apply}. Its input must be a dataset of scalar
+    `tf.string` elements. Each element of the resulting dataset is a `dict`
+    mapping each key in `features` to a `tf.Tensor` for a `FixedLenFeature`,
+    or to an `(indices, values, dense_shape)` tuple of `tf.Tensor` objects
+    for a `VarLenFeature`.
+  """
+
+  def _apply_fn(dataset):
+    """Function from `Dataset` to `Dataset` that applies the transformation."""
+    parsed = _ParseExampleBatchDataset(dataset, features, batch_size)
+    return parsed.map(parsed.components_to_dict)
+
+  return _apply_fn
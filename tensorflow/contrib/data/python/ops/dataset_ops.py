@@ -242,7 +242,8 @@ class Dataset(dataset_ops.Dataset):
 
     Args:
       buffer_size: A `tf.int64` scalar `tf.Tensor`, representing the
-        maximum number elements that will be buffered when prefetching.
+        maximum number elements that will be buffered when prefetching. If
+        -1, the buffer size is tuned automatically.
 
     Returns:
       A `Dataset`.
@@ -493,7 +494,8 @@ class Dataset(dataset_ops.Dataset):
         buffered.
       num_parallel_calls: (Optional.) A `tf.int32` scalar `tf.Tensor`,
         representing the number elements to process in parallel. If not
-        specified, elements will be processed sequentially.
+        specified, elements will be processed sequentially. If -1, the
+        number is tuned automatically.
 
     Returns:
       A `Dataset`.
@@ -19,16 +19,21 @@ from __future__ import print_function
 
 from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.data.util import nest
+from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import function
 from tensorflow.python.framework import ops
+from tensorflow.python.framework import tensor_shape
+from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import gen_dataset_ops
+from tensorflow.python.ops import math_ops
 
 
 def group_by_window(key_func,
                     reduce_func,
                     window_size=None,
-                    window_size_func=None):
+                    window_size_func=None,
+                    max_buffered_bytes=None):
   """A transformation that groups windows of elements by key and reduces them.
 
   This transformation maps each consecutive element in a dataset to a key
@@ -40,6 +45,11 @@ def group_by_window(key_func,
   You may provide either a constant `window_size` or a window size determined by
   the key through `window_size_func`.
 
+  The open windows hold their elements in memory. If the keys are skewed, so
+  that many windows fill slowly, set `max_buffered_bytes` to bound the memory
+  that they use: whenever the elements in all open windows exceed that size,
+  the window holding the most bytes is passed to `reduce_func` early.
+
   Args:
     key_func: A function mapping a nested structure of tensors
       (having shapes and types defined by `self.output_shapes` and
@@ -54,6 +64,9 @@ def group_by_window(key_func,
       `tf.Tensor`, representing the number of consecutive elements matching
       the same key to combine in a single batch, which will be passed to
       `reduce_func`. Mutually exclusive with `window_size`.
+    max_buffered_bytes: (Optional.) A Python integer. If set, the maximum total
+      size in bytes of the elements buffered in open windows, after which the
+      largest window is reduced before it is full.
 
   Returns:
     A `Dataset` transformation function, which can be passed to
@@ -79,11 +92,129 @@ def group_by_window(key_func,
   def _apply_fn(dataset):
     """Function from `Dataset` to `Dataset` that applies the transformation."""
     return GroupByWindowDataset(dataset, key_func, reduce_func,
-                                window_size_func)
+                                window_size_func, max_buffered_bytes)
+
+  return _apply_fn
+
+
+def bucket_by_sequence_length(element_length_func,
+                              bucket_boundaries,
+                              bucket_batch_sizes,
+                              padded_shapes=None,
+                              padding_values=None,
+                              pad_to_bucket_boundary=False,
+                              max_buffered_bytes=None):
+  """A transformation that batches elements of similar length together.
+
+  Each element is assigned to a bucket by its length: bucket `i` holds the
+  elements whose length is in `[bucket_boundaries[i-1], bucket_boundaries[i])`,
+  with the first bucket starting at 0 and the last extending to infinity.
+  Once bucket `i` holds `bucket_batch_sizes[i]` elements, they are padded and
+  batched together with @{tf.data.Dataset.padded_batch}. Because a batch only
+  contains elements of similar length, it needs much less padding than a batch
+  of consecutive elements.
+
+  Set `max_buffered_bytes` to bound the memory used by buckets that fill
+  slowly, as with a skewed distribution of lengths: whenever the elements in
+  all buckets exceed that size, the bucket holding the most bytes is batched
+  before it is full, as in @{tf.contrib.data.group_by_window}.
+
+  For example, to batch sentences of token IDs:
+
+  ```python
+  dataset = dataset.apply(tf.contrib.data.bucket_by_sequence_length(
+      element_length_func=lambda tokens: tf.shape(tokens)[0],
+      bucket_boundaries=[10, 20, 40],
+      bucket_batch_sizes=[128, 64, 32, 16],
+      max_buffered_bytes=64 * 1024 * 1024))
+  ```
+
+  Args:
+    element_length_func: A function mapping a nested structure of tensors
+      (having shapes and types defined by `self.output_shapes` and
+      `self.output_types`) to a scalar `tf.int32` or `tf.int64` length.
+    bucket_boundaries: A non-empty list of strictly increasing Python integers,
+      the upper length boundaries of the buckets.
+    bucket_batch_sizes: A list of Python integers, the batch size of each
+      bucket. Must have `len(bucket_boundaries) + 1` elements.
+    padded_shapes: (Optional.) A nested structure of `tf.TensorShape`s, as
+      accepted by @{tf.data.Dataset.padded_batch}. Defaults to the shapes of
+      the input elements, in which case each unknown dimension is padded to
+      the largest size in its batch.
+    padding_values: (Optional.) The padding values, as accepted by
+      @{tf.data.Dataset.padded_batch}.
+    pad_to_bucket_boundary: (Optional.) If `True`, the unknown dimensions of
+      `padded_shapes` are padded to `bucket_boundaries[i] - 1` in bucket `i`,
+      i.e. the longest length in the bucket, so that all batches of a bucket
+      have the same shape. The input must then only contain elements shorter
+      than `max(bucket_boundaries)`.
+    max_buffered_bytes: (Optional.) A Python integer. If set, the maximum total
+      size in bytes of the elements buffered in all buckets.
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    @{tf.data.Dataset.apply}.
+
+  Raises:
+    ValueError: If `bucket_boundaries` is empty or not strictly increasing, or
+      if `bucket_batch_sizes` does not have one more element than it.
+  """
+  if not bucket_boundaries:
+    raise ValueError("`bucket_boundaries` must not be empty.")
+  if any(b >= next_b
+         for b, next_b in zip(bucket_boundaries, bucket_boundaries[1:])):
+    raise ValueError("`bucket_boundaries` must be strictly increasing, but "
+                     "are: %s" % (bucket_boundaries,))
+  if len(bucket_batch_sizes) != len(bucket_boundaries) + 1:
+    raise ValueError(
+        "`bucket_batch_sizes` must have len(bucket_boundaries) + 1 = %d "
+        "elements, but has %d." % (len(bucket_boundaries) + 1,
+                                   len(bucket_batch_sizes)))
+
+  def _apply_fn(dataset):
+    """Function from `Dataset` to `Dataset` that applies the transformation."""
+    boundaries = constant_op.constant(bucket_boundaries, dtype=dtypes.int64)
+    batch_sizes = constant_op.constant(bucket_batch_sizes, dtype=dtypes.int64)
+
+    def key_func(*args):
+      length = math_ops.cast(element_length_func(*args), dtypes.int64)
+      return math_ops.reduce_sum(
+          math_ops.cast(math_ops.less_equal(boundaries, length), dtypes.int64))
+
+    def window_size_func(bucket_id):
+      return batch_sizes[bucket_id]
+
+    def reduce_func(bucket_id, window):
+      shapes = padded_shapes
+      if shapes is None:
+        shapes = window.output_shapes
+      if pad_to_bucket_boundary:
+        max_length = boundaries[bucket_id] - 1
+        shapes = nest.map_structure(
+            lambda shape: _fill_unknown_dims(shape, max_length), shapes)
+      return window.padded_batch(
+          batch_sizes[bucket_id], shapes, padding_values=padding_values)
+
+    return GroupByWindowDataset(dataset, key_func, reduce_func,
+                                window_size_func, max_buffered_bytes)
 
   return _apply_fn
 
 
+def _fill_unknown_dims(shape, value):
+  """Returns `shape` as an int64 vector, with `value` for its unknown dims."""
+  shape = tensor_shape.as_shape(shape)
+  if shape.ndims is None:
+    raise ValueError("`pad_to_bucket_boundary` requires padded shapes of "
+                     "known rank.")
+  if shape.ndims == 0:
+    return constant_op.constant([], dtype=dtypes.int64)
+  return array_ops.stack([
+      value if dim.value is None else constant_op.constant(
+          dim.value, dtype=dtypes.int64) for dim in shape.dims
+  ])
+
+
 class _VariantDataset(dataset_ops.Dataset):
   """A Dataset wrapper for a tf.variant-typed function argument."""
 
@@ -108,11 +239,13 @@ class _VariantDataset(dataset_ops.Dataset):
 class GroupByWindowDataset(dataset_ops.Dataset):
   """A `Dataset` that groups its input and performs a windowed reduction."""
 
-  def __init__(self, input_dataset, key_func, reduce_func, window_size_func):
+  def __init__(self, input_dataset, key_func, reduce_func, window_size_func,
+               max_buffered_bytes=None):
     """See `group_by_window()` for details."""
     super(GroupByWindowDataset, self).__init__()
 
     self._input_dataset = input_dataset
+    self._max_buffered_bytes = max_buffered_bytes or 0
 
     self._make_key_func(key_func, input_dataset)
     self._make_reduce_func(reduce_func, input_dataset)
@@ -198,4 +331,5 @@ class GroupByWindowDataset(dataset_ops.Dataset):
         reduce_func=self._reduce_func,
         window_size_func=self._window_size_func,
         output_types=nest.flatten(self.output_types),
-        output_shapes=nest.flatten(self.output_shapes))
+        output_shapes=nest.flatten(self.output_shapes),
+        max_buffered_bytes=self._max_buffered_bytes)
@@ -29,8 +29,15 @@ from tensorflow.python.util import deprecation
 class ParallelInterleaveDataset(dataset_ops.Dataset):
   """A `Dataset` that maps a function over its input and flattens the result."""
 
-  def __init__(self, input_dataset, map_func, cycle_length, block_length,
-               sloppy):
+  def __init__(self,
+               input_dataset,
+               map_func,
+               cycle_length,
+               block_length,
+               sloppy,
+               buffer_output_elements=None,
+               max_cycle_length=None,
+               max_buffered_bytes=None):
     """See `tf.contrib.data.parallel_interleave()` for details."""
     super(ParallelInterleaveDataset, self).__init__()
     self._input_dataset = input_dataset
@@ -66,6 +73,12 @@ class ParallelInterleaveDataset(dataset_ops.Dataset):
         block_length, dtype=dtypes.int64, name="block_length")
     self._sloppy = ops.convert_to_tensor(
         sloppy, dtype=dtypes.bool, name="sloppy")
+    self._buffer_output_elements = (
+        1 if buffer_output_elements is None else buffer_output_elements)
+    self._max_cycle_length = (
+        0 if max_cycle_length is None else max_cycle_length)
+    self._max_buffered_bytes = (
+        0 if max_buffered_bytes is None else max_buffered_bytes)
 
   def _as_variant_tensor(self):
     return gen_dataset_ops.parallel_interleave_dataset(
@@ -76,7 +89,10 @@ class ParallelInterleaveDataset(dataset_ops.Dataset):
         self._sloppy,
         f=self._map_func,
         output_types=nest.flatten(self.output_types),
-        output_shapes=nest.flatten(self.output_shapes))
+        output_shapes=nest.flatten(self.output_shapes),
+        buffer_output_elements=self._buffer_output_elements,
+        max_cycle_length=self._max_cycle_length,
+        max_buffered_bytes=self._max_buffered_bytes)
 
   @property
   def output_shapes(self):
@@ -87,7 +103,13 @@ class ParallelInterleaveDataset(dataset_ops.Dataset):
     return self._output_types
 
 
-def parallel_interleave(map_func, cycle_length, block_length=1, sloppy=False):
+def parallel_interleave(map_func,
+                        cycle_length,
+                        block_length=1,
+                        sloppy=False,
+                        buffer_output_elements=None,
+                        max_cycle_length=None,
+                        max_buffered_bytes=None):
   """A parallel version of the `Dataset.interleave()` transformation.
 
   `parallel_interleave()` maps `map_func` across its input to produce nested
@@ -110,6 +132,13 @@ def parallel_interleave(map_func, cycle_length, block_length=1, sloppy=False):
           cycle_length=4))
   ```
 
+  Each nested dataset produces up to `buffer_output_elements` elements ahead of
+  the consumer, so that a nested dataset on slow storage does not stall the
+  others while it catches up; `max_buffered_bytes` bounds the total memory of
+  those elements. If `sloppy` is `True`, the cycle can also grow up to
+  `max_cycle_length` nested datasets when none of them has an element ready,
+  so that slow storage is read with more parallelism.
+
   WARNING: If `sloppy` is `True`, the order of produced elements is not
   deterministic.
 
@@ -121,6 +150,15 @@ def parallel_interleave(map_func, cycle_length, block_length=1, sloppy=False):
     sloppy: If false, elements are produced in deterministic order. Otherwise,
       the implementation is allowed, for the sake of expediency, to produce
       elements in a non-deterministic order.
+    buffer_output_elements: (Optional.) The number of elements each nested
+      dataset may produce ahead of the consumer. Defaults to 1.
+    max_cycle_length: (Optional.) If `sloppy` is `True`, the number of nested
+      datasets up to which the cycle may grow when they are slower than the
+      consumer. Defaults to `cycle_length`, which disables the growth.
+    max_buffered_bytes: (Optional.) The total size in bytes of the elements
+      that the nested datasets may produce ahead of the consumer. Each nested
+      dataset may always buffer one element. Defaults to 0, which means no
+      limit.
 
   Returns:
     A `Dataset` transformation function, which can be passed to
@@ -128,7 +166,8 @@ def parallel_interleave(map_func, cycle_length, block_length=1, sloppy=False):
   """
   def _apply_fn(dataset):
     return ParallelInterleaveDataset(
-        dataset, map_func, cycle_length, block_length, sloppy)
+        dataset, map_func, cycle_length, block_length, sloppy,
+        buffer_output_elements, max_cycle_length, max_buffered_bytes)
   return _apply_fn
 
 
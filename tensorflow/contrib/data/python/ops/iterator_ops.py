@@ -60,6 +60,56 @@ def make_saveable_from_iterator(iterator):
   return _Saveable(iterator._iterator_resource)  # pylint: disable=protected-access
 
 
+def get_iterator_stats(iterator, name=None):
+  """Returns the per-stage statistics of the input pipeline of `iterator`.
+
+  Use this to find the stage that limits the throughput of an input pipeline.
+  The result is a scalar string containing a serialized `Summary` protocol
+  buffer, e.g. to be written with @{tf.summary.FileWriter.add_summary} or
+  combined with other summaries by @{tf.summary.merge}. Each stage of the
+  pipeline is identified by its prefix, e.g. "Iterator::Prefetch::Map", and
+  reports the following values, each tagged "<prefix>/<statistic>":
+
+  * "elements": The number of elements that the stage produced.
+  * "bytes": The total size of those elements.
+  * "self_time_us": The time spent producing them, excluding the time spent in
+    the stages that it reads from on the same thread. For a stage that reads
+    its input on background threads, such as a prefetch or a parallel map,
+    this is the time that its consumer waited.
+  * "buffer_occupancy" and "buffer_capacity": For prefetch and parallel map
+    stages, the average number of elements that were ready when an element
+    was requested, and the maximum number of elements that can be ready.
+
+  For example:
+
+  ```python
+  iterator = dataset.make_one_shot_iterator()
+  next_element = iterator.get_next()
+  stats = tf.contrib.data.get_iterator_stats(iterator)
+  writer = tf.summary.FileWriter(log_dir)
+  with tf.Session() as sess:
+    sess.run(stats)  # Starts collecting the statistics.
+    for step in range(num_steps):
+      sess.run(train_op)
+    writer.add_summary(sess.run(stats), step)
+  ```
+
+  NOTE: The statistics are only collected once the returned tensor has been
+  evaluated for the first time, so that pipelines that are not inspected pay
+  no overhead. The values are cumulative from that first evaluation.
+
+  Args:
+    iterator: A @{tf.data.Iterator}.
+    name: (Optional.) A name for the created operation.
+
+  Returns:
+    A scalar `tf.string` tensor containing a serialized `Summary`.
+  """
+  iterator_resource = iterator._iterator_resource  # pylint: disable=protected-access
+  with ops.colocate_with(iterator_resource):
+    return gen_dataset_ops.iterator_get_stats(iterator_resource, name=name)
+
+
 class _Saveable(saver.BaseSaverBuilder.SaveableObject):
   """SaveableObject for saving/restoring iterator state."""
 
@@ -19,6 +19,14 @@ from __future__ import print_function
 
 from tensorflow.contrib.data.python.ops import gen_prefetching_ops
 from tensorflow.contrib.util import loader
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.ops import iterator_ops
+from tensorflow.python.data.util import nest
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import function
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
 from tensorflow.python.platform import resource_loader
 
 _prefetching_ops = loader.load_op_library(
@@ -53,3 +61,312 @@ def function_buffering_resource_get_next(function_buffer_resource,
       function_buffer_resource=function_buffer_resource,
       output_types=output_types,
       name=name)
+
+
+def multi_target_function_buffering_resource(string_args,
+                                             target_devices,
+                                             shared_name,
+                                             f,
+                                             buffer_size,
+                                             thread_pool_size=1,
+                                             order="round_robin",
+                                             container="",
+                                             name=None):
+  return gen_prefetching_ops.multi_target_function_buffering_resource(
+      string_args=string_args,
+      target_devices=target_devices,
+      shared_name=shared_name,
+      f=f,
+      buffer_size=buffer_size,
+      thread_pool_size=thread_pool_size,
+      order=order,
+      container=container,
+      name=name)
+
+
+def multi_target_function_buffering_resource_get_next(resource,
+                                                      output_types,
+                                                      name=None):
+  return gen_prefetching_ops.multi_target_function_buffering_resource_get_next(
+      resource=resource, output_types=output_types, name=name)
+
+
+class _PrefetchToDeviceIterator(object):
+  """A replacement for @{tf.data.Iterator} that prefetches to another device.
+
+  The input iterator runs on the CPU, and a `FunctionBufferingResource` placed
+  on `device` keeps up to `buffer_size` of its elements in memory on `device`.
+  Elements are copied ahead of time, so the copy overlaps the computation that
+  consumes the previous element.
+  """
+
+  def __init__(self, input_dataset, device, buffer_size, shared_name=None):
+    with ops.device("/cpu:0"):
+      input_iterator = input_dataset.make_one_shot_iterator()
+      input_iterator_handle = input_iterator.string_handle()
+      target_device = constant_op.constant("/cpu:0")
+
+    @function.Defun(dtypes.string)
+    def _prefetch_fn(handle):
+      remote_iterator = iterator_ops.Iterator.from_string_handle(
+          handle, input_iterator.output_types, input_iterator.output_shapes)
+      return nest.flatten(remote_iterator.get_next())
+
+    with ops.device(device):
+      self._buffering_resource = function_buffering_resource(
+          f=_prefetch_fn,
+          target_device=target_device,
+          string_arg=input_iterator_handle,
+          buffer_size=buffer_size,
+          shared_name=shared_name or ops.get_default_graph().unique_name(
+              "prefetch_to_device"))
+
+    self._device = device
+    self._output_types = input_iterator.output_types
+    self._output_shapes = input_iterator.output_shapes
+
+  def get_next(self, name=None):
+    """Returns a nested structure of `tf.Tensor`s containing the next element.
+
+    Args:
+      name: (Optional.) A name for the created operation.
+
+    Returns:
+      A nested structure of `tf.Tensor` objects, which are resident on the
+      device passed to `prefetch_to_device()`.
+    """
+    with ops.device(self._device):
+      flat_ret = function_buffering_resource_get_next(
+          self._buffering_resource,
+          output_types=nest.flatten(self._output_types),
+          name=name)
+    for tensor, shape in zip(flat_ret, nest.flatten(self._output_shapes)):
+      tensor.set_shape(shape)
+    return nest.pack_sequence_as(self._output_types, flat_ret)
+
+  @property
+  def output_shapes(self):
+    return self._output_shapes
+
+  @property
+  def output_types(self):
+    return self._output_types
+
+
+class _PrefetchToDeviceDataset(dataset_ops.Dataset):
+  """A `Dataset` whose iterator prefetches elements to another device."""
+
+  def __init__(self, input_dataset, device, buffer_size):
+    super(_PrefetchToDeviceDataset, self).__init__()
+    self._input_dataset = input_dataset
+    self._device = device
+    self._buffer_size = buffer_size if buffer_size is not None else 1
+
+  def make_one_shot_iterator(self):
+    return _PrefetchToDeviceIterator(self._input_dataset, self._device,
+                                     self._buffer_size)
+
+  def make_initializable_iterator(self, shared_name=None):
+    raise NotImplementedError("`prefetch_to_device()` is not currently "
+                              "compatible with initializable iterators. Use "
+                              "`make_one_shot_iterator()` instead.")
+
+  def _as_variant_tensor(self):
+    raise NotImplementedError("`prefetch_to_device()` must be the last "
+                              "transformation in a dataset pipeline.")
+
+  @property
+  def output_types(self):
+    return self._input_dataset.output_types
+
+  @property
+  def output_shapes(self):
+    return self._input_dataset.output_shapes
+
+
+def prefetch_to_device(device, buffer_size=None):
+  """A transformation that prefetches dataset values to the given `device`.
+
+  The elements of the input dataset are copied to `device` ahead of the
+  `get_next()` call that consumes them, and `get_next()` returns tensors that
+  are already resident on `device`. On a GPU the copies are issued on the
+  device's host-to-device stream, staged through pinned host memory.
+
+  NOTE: Although the transformation creates a @{tf.data.Dataset}, the
+  transformation must be the final `Dataset` in the input pipeline, it must be
+  applied with @{tf.data.Dataset.apply}, and only `make_one_shot_iterator()`
+  is supported on the result.
+
+  Args:
+    device: A string. The name of a device to which elements will be prefetched.
+    buffer_size: (Optional.) The number of elements to buffer on `device`.
+      Defaults to 1.
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    @{tf.data.Dataset.apply}.
+  """
+  def _apply_fn(dataset):
+    return _PrefetchToDeviceDataset(dataset, device, buffer_size)
+
+  return _apply_fn
+
+
+class _MultiWorkerIterator(object):
+  """An iterator over the elements of datasets that run on remote workers.
+
+  The dataset for each worker is built on that worker's device, so the
+  distributed runtime ships its graph to the worker, where its own iterator
+  runs. A `MultiTargetFunctionBufferingResource` on the local device fetches
+  the elements with remote function calls, keeping up to `buffer_size`
+  elements from each worker in memory.
+  """
+
+  def __init__(self, dataset_fn, worker_devices, buffer_size, order, device,
+               shared_name=None):
+    if not worker_devices:
+      raise ValueError("At least one worker device is required.")
+    iterators = []
+    handles = []
+    for i, worker_device in enumerate(worker_devices):
+      with ops.device(worker_device):
+        iterator = dataset_fn(i).make_one_shot_iterator()
+        iterators.append(iterator)
+        handles.append(iterator.string_handle())
+    input_iterator = iterators[0]
+    for iterator in iterators[1:]:
+      nest.assert_same_structure(input_iterator.output_types,
+                                 iterator.output_types)
+      if (nest.flatten(iterator.output_types) !=
+          nest.flatten(input_iterator.output_types)):
+        raise TypeError(
+            "The datasets must have the same types on all workers, but "
+            "produce %s and %s." % (input_iterator.output_types,
+                                    iterator.output_types))
+
+    @function.Defun(dtypes.string)
+    def _remote_fn(handle):
+      remote_iterator = iterator_ops.Iterator.from_string_handle(
+          handle, input_iterator.output_types, input_iterator.output_shapes)
+      return nest.flatten(remote_iterator.get_next())
+
+    with ops.device(device):
+      self._buffering_resource = multi_target_function_buffering_resource(
+          f=_remote_fn,
+          target_devices=constant_op.constant(list(worker_devices)),
+          string_args=array_ops.stack(handles),
+          buffer_size=buffer_size,
+          order=order,
+          shared_name=shared_name or ops.get_default_graph().unique_name(
+              "multi_worker_iterator"))
+
+    self._device = device
+    self._output_types = input_iterator.output_types
+    # The shapes are only known where they agree on all workers.
+    flat_shapes = nest.flatten(input_iterator.output_shapes)
+    for iterator in iterators[1:]:
+      flat_shapes = [
+          shape.most_specific_compatible_shape(other) for shape, other in zip(
+              flat_shapes, nest.flatten(iterator.output_shapes))
+      ]
+    self._output_shapes = nest.pack_sequence_as(input_iterator.output_shapes,
+                                                flat_shapes)
+
+  def get_next(self, name=None):
+    """Returns a nested structure of `tf.Tensor`s containing the next element.
+
+    Args:
+      name: (Optional.) A name for the created operation.
+
+    Returns:
+      A nested structure of `tf.Tensor` objects, which are resident on the
+      device passed to `make_multi_worker_iterator()`.
+    """
+    with ops.device(self._device):
+      flat_ret = multi_target_function_buffering_resource_get_next(
+          self._buffering_resource,
+          output_types=nest.flatten(self._output_types),
+          name=name)
+    for tensor, shape in zip(flat_ret, nest.flatten(self._output_shapes)):
+      tensor.set_shape(shape)
+    return nest.pack_sequence_as(self._output_types, flat_ret)
+
+  @property
+  def output_shapes(self):
+    return self._output_shapes
+
+  @property
+  def output_types(self):
+    return self._output_types
+
+
+def make_multi_worker_iterator(dataset_fn,
+                               worker_devices,
+                               buffer_size=None,
+                               order="round_robin",
+                               device=None):
+  """Creates an iterator over datasets that run on remote workers.
+
+  `dataset_fn(i)` is called to build the dataset for `worker_devices[i]`, on
+  that device, so the input pipeline runs on the worker and only its output
+  elements are sent to the device that calls `get_next()`. This moves the
+  cost of reading and preprocessing the input off the trainer. Each worker
+  should typically read a different shard of the input, e.g. with
+  @{tf.data.Dataset.shard}.
+
+  Up to `buffer_size` elements are requested ahead of time from each worker,
+  so the transfers overlap the computation that consumes the previous
+  elements, and a slow worker does not accumulate unbounded work.
+
+  For example, to read from two input workers:
+
+  ```python
+  def dataset_fn(worker_index):
+    return (tf.data.TFRecordDataset(filenames)
+            .shard(2, worker_index)
+            .map(parse_fn)
+            .batch(32)
+            .prefetch(1))
+
+  iterator = tf.contrib.data.make_multi_worker_iterator(
+      dataset_fn, ["/job:input/task:0/cpu:0", "/job:input/task:1/cpu:0"])
+  batch = iterator.get_next()
+  ```
+
+  NOTE: The iterator must be used in a session whose target is a distributed
+  master with access to all of `worker_devices`. Like a one-shot iterator, it
+  cannot be re-initialized.
+
+  Args:
+    dataset_fn: A function that takes the index of a worker as a scalar Python
+      integer and returns a @{tf.data.Dataset}. The datasets must have the same
+      types and structure on all workers.
+    worker_devices: A list of fully specified device names, e.g.
+      "/job:input/replica:0/task:0/cpu:0", on which the datasets will run.
+    buffer_size: (Optional.) The number of elements to buffer from each worker.
+      Defaults to 1.
+    order: (Optional.) If "round_robin" (the default), the elements are taken
+      from the workers in turn, so that the order is deterministic. If
+      "first_come", each element is returned as soon as it arrives from any
+      worker, so that a slow worker does not block the others. In both cases,
+      a worker whose dataset ends is skipped, and the sequence ends when the
+      datasets on all workers have ended.
+    device: (Optional.) The name of the device on which the elements are
+      buffered and returned. Defaults to the device of the enclosing scope.
+
+  Returns:
+    An object that provides a `get_next()` method, like @{tf.data.Iterator},
+    and the `output_types` and `output_shapes` of the elements.
+
+  Raises:
+    ValueError: If `worker_devices` is empty, if `order` is not one of the
+      values above, or if the datasets do not have the same structure on all
+      workers.
+    TypeError: If the datasets do not have the same types on all workers.
+  """
+  if order not in ("round_robin", "first_come"):
+    raise ValueError("`order` must be \"round_robin\" or \"first_come\", "
+                     "but is: %s" % order)
+  return _MultiWorkerIterator(dataset_fn, worker_devices,
+                              buffer_size if buffer_size is not None else 1,
+                              order, device if device is not None else "")
@@ -17,12 +17,16 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+from tensorflow.contrib.data.python.ops import batching
 from tensorflow.contrib.data.python.ops import dataset_ops as contrib_dataset_ops
+from tensorflow.contrib.data.python.ops import interleave_ops
 from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.data.ops import readers
 from tensorflow.python.data.util import nest
+from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
+from tensorflow.python.framework import random_seed
 from tensorflow.python.framework import sparse_tensor as sparse_tensor_lib
 from tensorflow.python.framework import tensor_shape
 from tensorflow.python.ops import gen_dataset_ops
@@ -98,6 +102,87 @@ class FixedLengthRecordDataset(contrib_dataset_ops.Dataset):
     super(FixedLengthRecordDataset, self).__init__(dataset)
 
 
+class ShuffledTFRecordDataset(contrib_dataset_ops.Dataset):
+  """A `Dataset` of all records from TFRecord files, in a random order.
+
+  Unlike `TFRecordDataset(filenames).shuffle(buffer_size)`, which can only
+  reorder records within a window of `buffer_size` elements that it holds in
+  memory, this dataset performs a uniform shuffle across every record in every
+  file. Each iterator first indexes the files by reading only the record
+  headers, and then reads each record from its offset when it is produced, so
+  it holds 16 bytes per record in memory rather than the records themselves.
+  The files must be uncompressed, and reading records in a random order is
+  only efficient on file systems that support fast random access.
+  """
+
+  def __init__(self,
+               filenames,
+               seed=None,
+               reshuffle_each_iteration=None,
+               buffer_size=None):
+    """Creates a `ShuffledTFRecordDataset`.
+
+    Args:
+      filenames: A `tf.string` tensor containing one or more filenames.
+      seed: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing the
+        random seed that will be used to create the distribution. See
+        @{tf.set_random_seed} for behavior.
+      reshuffle_each_iteration: (Optional.) A boolean, which if true indicates
+        that the dataset should be pseudorandomly reshuffled each time it is
+        iterated over. (Defaults to `True`.)
+      buffer_size: (Optional.) A `tf.int64` scalar representing the number of
+        bytes to buffer while indexing the files. 0 means the default of
+        256KB.
+    """
+    dataset = _ShuffledTFRecordDataset(filenames, seed,
+                                       reshuffle_each_iteration, buffer_size)
+    super(ShuffledTFRecordDataset, self).__init__(dataset)
+
+
+class _ShuffledTFRecordDataset(dataset_ops.Dataset):
+  """A `Dataset` of all records from TFRecord files, in a random order."""
+
+  def __init__(self, filenames, seed, reshuffle_each_iteration, buffer_size):
+    """See `ShuffledTFRecordDataset.__init__()` for details."""
+    super(_ShuffledTFRecordDataset, self).__init__()
+    self._filenames = ops.convert_to_tensor(
+        filenames, dtypes.string, name="filenames")
+    if buffer_size is None:
+      buffer_size = 0
+    self._buffer_size = ops.convert_to_tensor(
+        buffer_size, dtype=dtypes.int64, name="buffer_size")
+    seed, seed2 = random_seed.get_seed(seed)
+    if seed is None:
+      self._seed = constant_op.constant(0, dtype=dtypes.int64, name="seed")
+    else:
+      self._seed = ops.convert_to_tensor(seed, dtype=dtypes.int64, name="seed")
+    if seed2 is None:
+      self._seed2 = constant_op.constant(0, dtype=dtypes.int64, name="seed2")
+    else:
+      self._seed2 = ops.convert_to_tensor(
+          seed2, dtype=dtypes.int64, name="seed2")
+    if reshuffle_each_iteration is None:
+      self._reshuffle_each_iteration = True
+    else:
+      self._reshuffle_each_iteration = reshuffle_each_iteration
+
+  def _as_variant_tensor(self):
+    return gen_dataset_ops.shuffled_tf_record_dataset(
+        self._filenames,
+        buffer_size=self._buffer_size,
+        seed=self._seed,
+        seed2=self._seed2,
+        reshuffle_each_iteration=self._reshuffle_each_iteration)
+
+  @property
+  def output_shapes(self):
+    return tensor_shape.TensorShape([])
+
+  @property
+  def output_types(self):
+    return dtypes.string
+
+
 def read_batch_features(file_pattern,
                         batch_size,
                         features,
@@ -182,23 +267,17 @@ def read_batch_features(file_pattern,
     dataset = dataset.repeat(num_epochs)
   if randomize_input:
     dataset = dataset.shuffle(capacity)
-  dataset = dataset.batch(batch_size)
-  dataset = dataset.map(lambda x: _parse_example(x, features))
+  dataset = dataset.apply(batching.parse_example_batch(features, batch_size))
   iterator = dataset.make_one_shot_iterator()
   outputs = iterator.get_next()
-  index = 0
   result = {}
-  for key in sorted(features.keys()):
-    feature = features[key]
-    if isinstance(feature, parsing_ops.FixedLenFeature):
-      result[key] = outputs[index]
-      index += 1
+  for key, value in outputs.items():
+    if isinstance(features[key], parsing_ops.FixedLenFeature):
+      result[key] = value
     else:
+      indices, values, dense_shape = value
       result[key] = sparse_tensor_lib.SparseTensor(
-          indices=outputs[index],
-          values=outputs[index + 1],
-          dense_shape=outputs[index + 2])
-      index += 3
+          indices=indices, values=values, dense_shape=dense_shape)
   return result
 
 
@@ -233,29 +312,71 @@ def _get_file_names(file_pattern, randomize_input):
   return file_names
 
 
-def _parse_example(serialized, features):
-  parsed = parsing_ops.parse_example(serialized, features)
-  result = []
-  for key in sorted(features.keys()):
-    val = parsed[key]
-    if isinstance(val, sparse_tensor_lib.SparseTensor):
-      result.extend([val.indices, val.values, val.dense_shape])
-    else:
-      result.append(val)
-  return tuple(result)
-
-
 class SqlDataset(contrib_dataset_ops.Dataset):
 
-  def __init__(self, driver_name, data_source_name, query, output_types):
-    dataset = _SqlDataset(driver_name, data_source_name, query, output_types)
+  def __init__(self, driver_name, data_source_name, query, output_types,
+               batch_size=None):
+    dataset = _SqlDataset(driver_name, data_source_name, query, output_types,
+                          batch_size)
     super(SqlDataset, self).__init__(dataset)
 
 
+def read_sql_partitions(driver_name,
+                        data_source_name,
+                        partition_queries,
+                        output_types,
+                        batch_size=None,
+                        sloppy=False):
+  """Reads the result sets of several SQL queries concurrently.
+
+  Each query is typically a key range of one large table, and is read on its
+  own connection and thread, so that the rows are fetched and decoded in
+  parallel. For example:
+
+  ```python
+  queries = ["SELECT name, age FROM people WHERE id >= %d AND id < %d" %
+             (lo, lo + 100000) for lo in range(0, 1000000, 100000)]
+  dataset = tf.contrib.data.read_sql_partitions(
+      "sqlite", "/foo/bar.sqlite3", queries, (tf.string, tf.int32),
+      batch_size=1024)
+  ```
+
+  Args:
+    driver_name: A 0-D `tf.string` tensor containing the database type.
+      Currently, the only supported value is 'sqlite'.
+    data_source_name: A 0-D `tf.string` tensor containing a connection string
+      to connect to the database.
+    partition_queries: A list of SQL queries, which all return columns of
+      `output_types`. They are all read at the same time.
+    output_types: A tuple of `tf.DType` objects representing the types of the
+      columns returned by the queries.
+    batch_size: (Optional.) If set, each element holds the values of up to
+      this many consecutive rows of one query, with one vector per column.
+    sloppy: (Optional.) If false, the rows (or batches) of the queries are
+      interleaved in a deterministic order. Otherwise, they are produced as
+      soon as they are read.
+
+  Returns:
+    A `Dataset` of the rows (or batches) of all of the queries.
+  """
+  if not partition_queries:
+    raise ValueError("`partition_queries` must not be empty.")
+  queries = dataset_ops.Dataset.from_tensor_slices(
+      ops.convert_to_tensor(partition_queries, dtype=dtypes.string))
+  dataset = queries.apply(
+      interleave_ops.parallel_interleave(
+          lambda query: _SqlDataset(driver_name, data_source_name, query,
+                                    output_types, batch_size),
+          cycle_length=len(partition_queries),
+          sloppy=sloppy))
+  return contrib_dataset_ops.Dataset(dataset)
+
+
 class _SqlDataset(dataset_ops.Dataset):
   """A `Dataset` consisting of the results from a SQL query."""
 
-  def __init__(self, driver_name, data_source_name, query, output_types):
+  def __init__(self, driver_name, data_source_name, query, output_types,
+               batch_size=None):
     """Creates a `SqlDataset`.
 
     `SqlDataset` allows a user to read data from the result set of a SQL query.
@@ -283,6 +404,10 @@ class _SqlDataset(dataset_ops.Dataset):
       query: A 0-D `tf.string` tensor containing the SQL query to execute.
       output_types: A tuple of `tf.DType` objects representing the types of the
         columns returned by `query`.
+      batch_size: (Optional.) A Python integer. If set, each element holds the
+        values of up to this many consecutive rows, with one vector per
+        column, which is much faster than reading the rows one at a time and
+        batching them.
     """
     super(_SqlDataset, self).__init__()
     self._driver_name = ops.convert_to_tensor(
@@ -292,16 +417,19 @@ class _SqlDataset(dataset_ops.Dataset):
     self._query = ops.convert_to_tensor(
         query, dtype=dtypes.string, name="query")
     self._output_types = output_types
+    self._batch_size = 0 if batch_size is None else batch_size
 
   def _as_variant_tensor(self):
     return gen_dataset_ops.sql_dataset(self._driver_name,
                                        self._data_source_name, self._query,
                                        nest.flatten(self.output_types),
-                                       nest.flatten(self.output_shapes))
+                                       nest.flatten(self.output_shapes),
+                                       batch_size=self._batch_size)
 
   @property
   def output_shapes(self):
-    return nest.map_structure(lambda _: tensor_shape.TensorShape([]),
+    shape = [None] if self._batch_size else []
+    return nest.map_structure(lambda _: tensor_shape.TensorShape(shape),
                               self._output_types)
 
   @property
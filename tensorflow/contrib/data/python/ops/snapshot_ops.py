@@ -0,0 +1,99 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Snapshot dataset transformations."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.util import nest
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import gen_dataset_ops
+
+
+def snapshot(path, compression_type="ZLIB", num_shards=8):
+  """Materializes the elements of a `Dataset` on disk, and reads them back.
+
+  Use this transformation to avoid recomputing expensive preprocessing in
+  every epoch and every job that uses the same input pipeline:
+
+  ```python
+  dataset = tf.data.TFRecordDataset(filenames)
+  dataset = dataset.map(decode_and_augment)
+  dataset = dataset.apply(tf.contrib.data.snapshot("/path/to/snapshots"))
+  ```
+
+  The snapshot is identified by a fingerprint of the graph that defines the
+  input dataset. The first iteration over the input writes a snapshot under
+  `path`, with `num_shards` writer threads. Once a complete snapshot exists,
+  later iterations (including those in other jobs) read its elements back with
+  `num_shards` reader threads, and do not evaluate the input at all. A change
+  to the input pipeline changes the fingerprint, so that a new snapshot is
+  taken.
+
+  Every dataset in the input must support serialization, otherwise an
+  `UnimplementedError` is raised when the snapshot is created.
+
+  Args:
+    path: A `tf.string` scalar `tf.Tensor`, representing a directory on the
+      filesystem under which snapshots are written.
+    compression_type: (Optional.) A `tf.string` scalar evaluating to one of
+      `""` (no compression), `"ZLIB"`, or `"GZIP"`.
+    num_shards: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing the
+      number of files that a snapshot is written to, which are written and
+      read back in parallel.
+
+  Returns:
+    A `Dataset` transformation function, which can be passed to
+    @{tf.data.Dataset.apply}.
+  """
+
+  def _apply_fn(dataset):
+    return SnapshotDataset(dataset, path, compression_type, num_shards)
+
+  return _apply_fn
+
+
+class SnapshotDataset(dataset_ops.Dataset):
+  """A `Dataset` that materializes the elements of its input on disk."""
+
+  def __init__(self, input_dataset, path, compression_type, num_shards):
+    """See `snapshot()` for details."""
+    super(SnapshotDataset, self).__init__()
+    self._input_dataset = input_dataset
+    self._path = ops.convert_to_tensor(
+        path, dtype=dtypes.string, name="path")
+    self._compression_type = ops.convert_to_tensor(
+        compression_type, dtype=dtypes.string, name="compression_type")
+    self._num_shards = ops.convert_to_tensor(
+        num_shards, dtype=dtypes.int64, name="num_shards")
+
+  def _as_variant_tensor(self):
+    return gen_dataset_ops.snapshot_dataset(
+        self._input_dataset._as_variant_tensor(),  # pylint: disable=protected-access
+        path=self._path,
+        compression_type=self._compression_type,
+        num_shards=self._num_shards,
+        output_shapes=nest.flatten(self.output_shapes),
+        output_types=nest.flatten(self.output_types))
+
+  @property
+  def output_shapes(self):
+    return self._input_dataset.output_shapes
+
+  @property
+  def output_types(self):
+    return self._input_dataset.output_types
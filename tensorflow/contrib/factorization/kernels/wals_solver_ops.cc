@@ -20,18 +20,14 @@
 #include <numeric>
 #include <vector>
 
-// This is only used for std::this_thread::get_id()
-#include <thread>  // NOLINT
-
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
-#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
-#include "tensorflow/core/lib/core/threadpool.h"
-#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/prefetch.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 using tensorflow::DEVICE_CPU;
 using tensorflow::DT_BOOL;
@@ -101,6 +97,8 @@ class WALSComputePartialLhsAndRhsOp : public OpKernel {
     const int64 factors_size = factors.dim_size(0);
     const int64 num_nonzero_elements = input_indices.dim_size(0);
     const int64 block_size = input_block_size.scalar<int64>()();
+    OP_REQUIRES(context, block_size >= 0,
+                InvalidArgument("Input input_block_size should be >= 0."));
     const auto& factor_weights_vec = factor_weights.vec<float>();
     const auto& input_weights_vec = input_weights.vec<float>();
     const float w_0 = unobserved_weights.scalar<float>()();
@@ -134,129 +132,96 @@ class WALSComputePartialLhsAndRhsOp : public OpKernel {
       return is_transpose ? indices_mat(0, i) : indices_mat(1, i);
     };
 
+    // Group the non-zero elements by input index with a counting sort, which
+    // is stable and so preserves spatial locality: the elements with input
+    // index r are perm[row_starts[r]], ..., perm[row_starts[r + 1] - 1]. The
+    // rows can then be processed in parallel without locking.
     // TODO(rmlarsen): In principle, we should be using the SparseTensor class
     // and machinery for iterating over groups, but the fact that class
     // SparseTensor makes a complete copy of the matrix makes me reluctant to
     // use it.
+    std::vector<int64> row_starts(block_size + 1, 0);
+    for (int64 i = 0; i < num_nonzero_elements; ++i) {
+      const int64 input_index = get_input_index(i);
+      const int64 factor_index = get_factor_index(i);
+      OP_REQUIRES(context, input_index >= 0 && input_index < block_size,
+                  InvalidArgument("Input index ", input_index,
+                                  " is out of range [0, ", block_size, ")."));
+      OP_REQUIRES(context, factor_index >= 0 && factor_index < factors_size,
+                  InvalidArgument("Factor index ", factor_index,
+                                  " is out of range [0, ", factors_size,
+                                  ")."));
+      ++row_starts[input_index + 1];
+    }
+    std::partial_sum(row_starts.begin(), row_starts.end(), row_starts.begin());
     std::vector<int64> perm(num_nonzero_elements);
-    std::iota(perm.begin(), perm.end(), 0);
-
-    typedef std::pair<int64, int64> Shard;
-    std::vector<Shard> shards;
-    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
-    int64 shard_total = 0;
-    // Compute a permutation such that get_input_index(perm[i]) is sorted, use
-    // stable_sort to preserve spatial locality.
-    std::stable_sort(perm.begin(), perm.end(),
-                     [&get_input_index](int64 i, int64 j) {
-                       return get_input_index(i) < get_input_index(j);
-                     });
-
-    // Compute the start and end of runs with identical input_index.
-    // These are the shards of work that can be processed in parallel
-    // without locking.
-    int64 start = 0;
-    int64 end = 0;
-    while (end < num_nonzero_elements) {
-      start = end;
-      while (end < num_nonzero_elements &&
-             get_input_index(perm[start]) == get_input_index(perm[end])) {
-        ++end;
+    {
+      std::vector<int64> next(row_starts.begin(), row_starts.end() - 1);
+      for (int64 i = 0; i < num_nonzero_elements; ++i) {
+        perm[next[get_input_index(i)]++] = i;
       }
-      shards.emplace_back(start, end);
-      shard_total += end - start;
     }
-    CHECK_EQ(shard_total, num_nonzero_elements);
-    CHECK_LE(shards.size(), num_nonzero_elements);
-    CHECK_GT(shards.size(), 0);
 
     // Batch the rank-one updates into a rank-k update to lower memory traffic
     const int kMaxBatchSize = 128;
 
-    // Since we do not have an easy way of generating thread id's within the
-    // range [0,num_threads), we can instead call out to an std::unordered_map
-    // of matrices and initialize the matrix on the first call.
-    // However, this might have a performance penalty, as memory allocation can
-    // cause the OS kernel to enter a critical section and temporarily disable
-    // parallelism, and the unordered_map must be protected with a read/write
-    // mutex.
-    //
-    // TODO(jpoulson): Simplify after the thread rank can be queried
-    std::unordered_map<size_t, Eigen::MatrixXf> factor_batch_map;
-    mutex map_mutex;
-
-    BlockingCounter counter(shards.size());
-    // Lambda encapsulating the per-shard computation.
-    auto work = [&](const Shard& shard) {
-      const std::thread::id thread_id = std::this_thread::get_id();
-      const size_t id_hash = std::hash<std::thread::id>()(thread_id);
-      // If this thread's unique factors_mat.rows() x kMaxBatchSize
-      // batching matrix has not yet been created, then emplace it into the
-      // map using the hash of the thread id as the key.
-      //
-      // TODO(jpoulson): Switch to try_emplace once C++17 is supported
-      map_mutex.lock();
-      const auto key_count = factor_batch_map.count(id_hash);
-      map_mutex.unlock();
-      if (!key_count) {
-        map_mutex.lock();
-        factor_batch_map.emplace(
-            std::piecewise_construct, std::forward_as_tuple(id_hash),
-            std::forward_as_tuple(factors_mat.rows(), kMaxBatchSize));
-        map_mutex.unlock();
-      }
-      map_mutex.lock();
-      auto& factor_batch = factor_batch_map[id_hash];
-      map_mutex.unlock();
-
-      CHECK_GE(shard.first, 0);
-      CHECK_LE(shard.second, perm.size());
-      CHECK_LE(shard.first, shard.second);
-      const int64 input_index = get_input_index(perm[shard.first]);
-      // Accumulate the rhs and lhs terms in the normal equations
-      // for the non-zero elements in the row or column of the sparse matrix
-      // corresponding to input_index.
-      int num_batched = 0;
-      EigenMatrixFloatMap lhs_mat(output_lhs_tensor->flat<float>().data() +
-                                      input_index * factor_dim * factor_dim,
-                                  factor_dim, factor_dim);
-      auto lhs_symm = lhs_mat.selfadjointView<Eigen::Lower>();
-      for (int64 p = shard.first; p < shard.second; ++p) {
-        const int64 i = perm[p];
-        // Check that all entries in the shard have the same input index.
-        CHECK_EQ(input_index, get_input_index(i));
-        const int64 factor_index = get_factor_index(i);
-        const float input_value = input_values_vec(i);
-        const float weight =
-            input_weights_vec(input_index) * factor_weights_vec(factor_index);
-        CHECK_GE(weight, 0);
-        factor_batch.col(num_batched) =
-            factors_mat.col(factor_index) * std::sqrt(weight);
-        ++num_batched;
-        if (num_batched == kMaxBatchSize) {
-          lhs_symm.rankUpdate(factor_batch);
-          num_batched = 0;
+    // Lambda encapsulating the computation for a range of rows.
+    auto work = [&](int64 begin, int64 end) {
+      Eigen::MatrixXf factor_batch(factors_mat.rows(), kMaxBatchSize);
+      for (int64 input_index = begin; input_index < end; ++input_index) {
+        const int64 row_start = row_starts[input_index];
+        const int64 row_end = row_starts[input_index + 1];
+        if (row_start == row_end) continue;
+        // Accumulate the rhs and lhs terms in the normal equations
+        // for the non-zero elements in the row or column of the sparse matrix
+        // corresponding to input_index.
+        int num_batched = 0;
+        EigenMatrixFloatMap lhs_mat(output_lhs_tensor->flat<float>().data() +
+                                        input_index * factor_dim * factor_dim,
+                                    factor_dim, factor_dim);
+        auto lhs_symm = lhs_mat.selfadjointView<Eigen::Lower>();
+        for (int64 p = row_start; p < row_end; ++p) {
+          const int64 i = perm[p];
+          // The factors of the non-zero elements are scattered, so fetch the
+          // next one while this one is accumulated.
+          if (p + 1 < row_end) {
+            port::prefetch<port::PREFETCH_HINT_T0>(
+                factors_mat.col(get_factor_index(perm[p + 1])).data());
+          }
+          const int64 factor_index = get_factor_index(i);
+          const float input_value = input_values_vec(i);
+          const float weight =
+              input_weights_vec(input_index) * factor_weights_vec(factor_index);
+          CHECK_GE(weight, 0);
+          factor_batch.col(num_batched) =
+              factors_mat.col(factor_index) * std::sqrt(weight);
+          ++num_batched;
+          if (num_batched == kMaxBatchSize) {
+            lhs_symm.rankUpdate(factor_batch);
+            num_batched = 0;
+          }
+
+          rhs_mat.col(input_index) +=
+              input_value * (w_0 + weight) * factors_mat.col(factor_index);
         }
-
-        rhs_mat.col(input_index) +=
-            input_value * (w_0 + weight) * factors_mat.col(factor_index);
-      }
-      if (num_batched != 0) {
-        auto factor_block =
-            factor_batch.block(0, 0, factors_mat.rows(), num_batched);
-        lhs_symm.rankUpdate(factor_block);
+        if (num_batched != 0) {
+          auto factor_block =
+              factor_batch.block(0, 0, factors_mat.rows(), num_batched);
+          lhs_symm.rankUpdate(factor_block);
+        }
+        // Copy lower triangular to upper triangular part of normal equation
+        // matrix.
+        lhs_mat = lhs_symm;
       }
-      // Copy lower triangular to upper triangular part of normal equation
-      // matrix.
-      lhs_mat = lhs_symm;
-      counter.DecrementCount();
     };
-    for (size_t i = 1; i < shards.size(); ++i) {
-      worker_threads.workers->Schedule(std::bind(work, shards[i]));
-    }
-    // Inline execute the 1st shard.
-    work(shards[0]);
-    counter.Wait();
+    // The rank updates of a row cost about factor_dim^2 per non-zero element.
+    const int64 nonzeros_per_row =
+        num_nonzero_elements / std::max<int64>(1, block_size);
+    const int64 cost_per_row =
+        std::max<int64>(1, nonzeros_per_row) * factor_dim * factor_dim;
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, block_size,
+          cost_per_row, work);
   }
 };
 
@@ -78,6 +78,38 @@ class WalsSolverOpsTest(test.TestCase):
                                               [0.160400, 0.220000, 0.279600],
                                               [0.492800, 0.563200, 0.633600]])
 
+  def testWalsSolverLhsEmptyRows(self):
+    sparse_block = SparseBlock3x3()
+    row_weights = np.array([0.1, 0.2, 0.3, 0.4, 0.5, 0.6]).astype(np.float32)
+    with self.test_session():
+      [lhs_tensor,
+       rhs_matrix] = gen_factorization_ops.wals_compute_partial_lhs_and_rhs(
+           self._column_factors, self._column_weights, self._unobserved_weights,
+           self._row_weights, sparse_block.indices, sparse_block.values,
+           sparse_block.dense_shape[0], False)
+      [padded_lhs_tensor, padded_rhs_matrix] = (
+          gen_factorization_ops.wals_compute_partial_lhs_and_rhs(
+              self._column_factors, self._column_weights,
+              self._unobserved_weights, row_weights, sparse_block.indices,
+              sparse_block.values, 6, False))
+      lhs, rhs, padded_lhs, padded_rhs = (
+          lhs_tensor.eval(), rhs_matrix.eval(), padded_lhs_tensor.eval(),
+          padded_rhs_matrix.eval())
+      self.assertAllClose(padded_lhs[:4], lhs)
+      self.assertAllClose(padded_rhs[:4], rhs)
+      self.assertAllEqual(padded_lhs[4:], np.zeros([2, 3, 3]))
+      self.assertAllEqual(padded_rhs[4:], np.zeros([2, 3]))
+
+  def testWalsSolverInputIndexOutOfRange(self):
+    sparse_block = SparseBlock3x3()
+    with self.test_session():
+      [lhs_tensor, _] = gen_factorization_ops.wals_compute_partial_lhs_and_rhs(
+          self._column_factors, self._column_weights, self._unobserved_weights,
+          self._row_weights, sparse_block.indices, sparse_block.values, 3,
+          False)
+      with self.assertRaisesOpError("Input index 3 is out of range"):
+        lhs_tensor.eval()
+
 
 if __name__ == "__main__":
   test.main()
@@ -19,10 +19,12 @@ limitations under the License.
 
 #include <atomic>
 #include <cerrno>
+#include <cstring>
 #include <fstream>
 #include <list>
 #include <map>
 #include <set>
+#include <vector>
 
 #include <fcntl.h>
 #include <rdma/rdma_cma.h>
@@ -119,7 +121,7 @@ class GdrMemoryManager : public RemoteMemoryManager {
 
   virtual ~GdrMemoryManager();
 
-  virtual Status Init() override;
+  virtual Status Init(const std::vector<Device*>& devices) override;
 
   virtual void Run() override;
 
@@ -149,6 +151,11 @@ class GdrMemoryManager : public RemoteMemoryManager {
 
   void EvictMemoryRegion(void* addr, size_t length);
 
+  // Registers the regions of `allocator` with the NIC, as they are allocated
+  // and freed, and returns whether it could.
+  bool InstrumentAllocator(Allocator* allocator,
+                           std::set<Allocator*>* instrumented);
+
  private:
   const string host_;
   const string port_;
@@ -177,6 +184,10 @@ class GdrMemoryManager : public RemoteMemoryManager {
   mutex alloc_mu_;
   std::vector<MemoryRegionPtr> mrs_ GUARDED_BY(alloc_mu_);
 
+  // An instrumented host allocator, which stages the host tensors that are
+  // outside of the managed memory regions. Set by Init().
+  Allocator* staging_allocator_ = nullptr;
+
   TF_DISALLOW_COPY_AND_ASSIGN(GdrMemoryManager);
 };
 
@@ -212,7 +223,7 @@ GdrMemoryManager::GdrMemoryManager(const string& host, const string& port)
 
 GdrMemoryManager::~GdrMemoryManager() { close(epfd_); }
 
-Status GdrMemoryManager::Init() {
+Status GdrMemoryManager::Init(const std::vector<Device*>& devices) {
   epfd_ = epoll_create1(0);
   if (epfd_ == -1) {
     return errors::Unavailable(strerror(errno), ": ", "epoll_create");
@@ -279,29 +290,31 @@ Status GdrMemoryManager::Init() {
     cpu_allocator(),
   };
 
-  using namespace std::placeholders;
-  VisitableAllocator::Visitor alloc_visitor =
-      std::bind(&GdrMemoryManager::InsertMemoryRegion, this, _1, _2);
-  VisitableAllocator::Visitor free_visitor =
-      std::bind(&GdrMemoryManager::EvictMemoryRegion, this, _1, _2);
-
-  std::set<Allocator*> instrumented_;
+  std::set<Allocator*> instrumented;
 
   // Host memory allocators
   for (Allocator* allocator : allocators) {
-    auto* visitable_allocator = dynamic_cast<VisitableAllocator*>(allocator);
-    CHECK(visitable_allocator) << "is not visitable for instrumentation"
-                               << allocator->Name();
-    // Make sure we don't instrument the same allocator twice
-    if (instrumented_.find(allocator) == std::end(instrumented_)) {
-      visitable_allocator->AddAllocVisitor(alloc_visitor);
-      visitable_allocator->AddFreeVisitor(free_visitor);
-      instrumented_.insert(allocator);
-      LOG(INFO) << "Instrumenting CPU allocator " << allocator->Name();
+    CHECK(InstrumentAllocator(allocator, &instrumented))
+        << "is not visitable for instrumentation" << allocator->Name();
+  }
+  staging_allocator_ = allocators[0];
+
+  // The allocators of the CPU devices may differ from the ones above, e.g.
+  // with ConfigProto.Experimental.cpu_allocator or use_numa_affinity. Their
+  // tensors are staged in staging_allocator_ if they are not visitable.
+  for (Device* device : devices) {
+    if (device->tensorflow_gpu_device_info() != nullptr) continue;
+    Allocator* allocator = device->GetAllocator(AllocatorAttributes());
+    if (!InstrumentAllocator(allocator, &instrumented)) {
+      LOG(WARNING) << "Allocator " << allocator->Name() << " of "
+                   << device->name() << " is not visitable for "
+                   << "instrumentation, its tensors are copied to and from "
+                   << staging_allocator_->Name() << " for RDMA";
     }
   }
 
 #if GOOGLE_CUDA
+  using namespace std::placeholders;
   VisitableAllocator::Visitor cuda_alloc_visitor =
       std::bind(&GdrMemoryManager::InsertMemoryRegion, this, _1, _2);
   if (IsGDRAvailable()) {
@@ -315,6 +328,22 @@ Status GdrMemoryManager::Init() {
   return Status::OK();
 }
 
+bool GdrMemoryManager::InstrumentAllocator(
+    Allocator* allocator, std::set<Allocator*>* instrumented) {
+  auto* visitable_allocator = dynamic_cast<VisitableAllocator*>(allocator);
+  if (visitable_allocator == nullptr) return false;
+  // Make sure we don't instrument the same allocator twice
+  if (instrumented->insert(allocator).second) {
+    using namespace std::placeholders;
+    visitable_allocator->AddAllocVisitor(
+        std::bind(&GdrMemoryManager::InsertMemoryRegion, this, _1, _2));
+    visitable_allocator->AddFreeVisitor(
+        std::bind(&GdrMemoryManager::EvictMemoryRegion, this, _1, _2));
+    LOG(INFO) << "Instrumenting CPU allocator " << allocator->Name();
+  }
+  return true;
+}
+
 void GdrMemoryManager::Run() {
   stopped_ = false;
   while (!stopped_) {
@@ -478,11 +507,23 @@ void GdrMemoryManager::TransportOptionsFromTensor(
   }
 #endif
 
+  Tensor host_copy;
+  if (mr == nullptr && on_host) {
+    // The tensor is outside of the managed memory regions, e.g. from an
+    // allocator that is not visitable: stages it in one of them.
+    host_copy = Tensor(staging_allocator_, tensor.dtype(), tensor.shape());
+    buffer = DMAHelper::buffer(&host_copy);
+    memcpy(buffer->data(), addr, length);
+    addr = buffer->data();
+    mr = FindMemoryRegion(addr, length);
+  }
+
   if (mr == nullptr) {
     done(errors::Unavailable("Cannot find pinned memory region"));
     return;
   }
 
+  // Keeps the buffer, or its staged copy, until the peer has read it.
   buffer->Ref();
   TensorKey tensor_key = next_key_++;
   {
@@ -529,6 +570,17 @@ void GdrMemoryManager::TensorFromTransportOptions(
   ibv_mr* mr = FindMemoryRegion(addr, length);
 
   Tensor host_copy;
+  // Whether the tensor is read into a staged copy on the host, rather than
+  // into its own buffer.
+  bool staged = false;
+  if (mr == nullptr && on_host) {
+    host_copy = Tensor(staging_allocator_, tensor->dtype(), tensor->shape());
+    buffer = DMAHelper::buffer(&host_copy);
+    addr = buffer->data();
+    length = buffer->size();
+    mr = FindMemoryRegion(addr, length);
+    staged = true;
+  }
 #if GOOGLE_CUDA
   if (mr == nullptr && !on_host) {
     Allocator* alloc = ProcessState::singleton()->GetCUDAHostAllocator(0);
@@ -591,7 +643,7 @@ void GdrMemoryManager::TensorFromTransportOptions(
   }
 
 #if GOOGLE_CUDA
-  if (host_copy.NumElements() > 0) {
+  if (!on_host && host_copy.NumElements() > 0) {
     uint64_t checksum = 0;
     if (VLOG_IS_ON(2)) {
       checksum = GPUUtil::Checksum(host_copy);
@@ -621,6 +673,10 @@ void GdrMemoryManager::TensorFromTransportOptions(
   }
 #endif  // GOOGLE_CUDA
 
+  if (staged) {
+    memcpy(DMAHelper::buffer(tensor)->data(), buffer->data(), buffer->size());
+  }
+
   uint64_t end = Env::Default()->NowMicros();
 
   VLOG(2) << "RDMA from remote memory region " << remote_mr.rkey()
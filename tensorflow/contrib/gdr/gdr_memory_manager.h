@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef GDR_MEMORY_MANAGER_H_
 #define GDR_MEMORY_MANAGER_H_
 
+#include <vector>
+
 #include "google/protobuf/any.pb.h"
 #include "tensorflow/core/lib/core/status.h"
 
@@ -33,7 +35,10 @@ class Tensor;
 class RemoteMemoryManager {
  public:
   virtual ~RemoteMemoryManager() {}
-  virtual Status Init() = 0;
+
+  // Registers the memory of the allocators of `devices`, among others, with
+  // the NIC, so that their tensors are transferred without a copy.
+  virtual Status Init(const std::vector<Device*>& devices) = 0;
   virtual void Run() = 0;
   virtual void Stop() = 0;
 
@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/contrib/gdr/gdr_memory_manager.h"
 #include "tensorflow/contrib/gdr/gdr_rendezvous_mgr.h"
 #include "tensorflow/contrib/gdr/gdr_worker.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
 
 #include "grpc/support/alloc.h"
 
@@ -59,7 +60,7 @@ Status GdrServer::Init() {
   TF_RETURN_IF_ERROR(
       GrpcServer::Init(nullptr, rendezvous_mgr_func, worker_func));
 
-  return remote_memory_manager_->Init();
+  return remote_memory_manager_->Init(worker_env()->device_mgr->ListDevices());
 }
 
 Status GdrServer::Start() {
@@ -692,6 +692,32 @@ class MutableHashTableOpTest(test.TestCase):
       result = output.eval()
       self.assertAllEqual((b"brain", b"salad", b"n/a"), result)
 
+  def testMutableHashTableManyKeys(self):
+    with self.test_session():
+      num_keys = 10000
+      keys = np.arange(num_keys, dtype=np.int64) * 7919
+      table = lookup.MutableHashTable(dtypes.int64, dtypes.int64, -1)
+      table.insert(keys[::2], keys[::2] + 1).run()
+      table.insert(keys[1::2], keys[1::2] + 1).run()
+      self.assertAllEqual(num_keys, table.size().eval())
+      # Overwrites half of the values.
+      table.insert(keys[::2], keys[::2] + 2).run()
+      self.assertAllEqual(num_keys, table.size().eval())
+
+      expected = keys + 1
+      expected[::2] += 1
+      queries = np.concatenate([keys, [-1, 3]])
+      self.assertAllEqual(
+          np.concatenate([expected, [-1, -1]]),
+          table.lookup(constant_op.constant(queries, dtypes.int64)).eval())
+
+      exported_keys, exported_values = table.export()
+      table2 = lookup.MutableHashTable(dtypes.int64, dtypes.int64, -1)
+      table2.insert(exported_keys, exported_values).run()
+      self.assertAllEqual(num_keys, table2.size().eval())
+      self.assertAllEqual(
+          expected, table2.lookup(constant_op.constant(keys)).eval())
+
 
 class MutableDenseHashTableOpTest(test.TestCase):
 
@@ -17,7 +17,9 @@ limitations under the License.
 
 #include "tensorflow/contrib/mpi/mpi_rendezvous_mgr.h"
 
+#include <algorithm>
 #include <chrono>
+#include <climits>
 #include <functional>
 #include <memory>
 #include <string>
@@ -29,9 +31,32 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 #include "tensorflow/core/distributed_runtime/session_mgr.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
+void PostChunkedIsend(const void* data, int64 size, int64 chunk_size, int rank,
+                      std::vector<MPI_Request>* requests) {
+  const char* base = static_cast<const char*>(data);
+  for (int64 offset = 0; offset < size; offset += chunk_size) {
+    const int count = static_cast<int>(std::min(chunk_size, size - offset));
+    requests->emplace_back();
+    MPI_CHECK(MPI_Isend(const_cast<char*>(base + offset), count, MPI_CHAR, rank,
+                        TAG_SENDTENSOR2, MPI_COMM_WORLD, &requests->back()));
+  }
+}
+
+void PostChunkedIrecv(void* data, int64 size, int64 chunk_size, int rank,
+                      std::vector<MPI_Request>* requests) {
+  char* base = static_cast<char*>(data);
+  for (int64 offset = 0; offset < size; offset += chunk_size) {
+    const int count = static_cast<int>(std::min(chunk_size, size - offset));
+    requests->emplace_back();
+    MPI_CHECK(MPI_Irecv(base + offset, count, MPI_CHAR, rank, TAG_SENDTENSOR2,
+                        MPI_COMM_WORLD, &requests->back()));
+  }
+}
+
 MPIRendezvousMgr::MPIRendezvousMgr(const WorkerEnv* env)
     : BaseRendezvousMgr(env), worker_env_2(env), use_optimal_transfer_(false) {
 
@@ -41,6 +66,11 @@ MPIRendezvousMgr::MPIRendezvousMgr(const WorkerEnv* env)
                  "using GPUs)\n";
     use_optimal_transfer_ = true;
   }
+  // The data of large tensors is split into chunks, so that transfers of
+  // any size fit the int counts of MPI, and the library can interleave them
+  // with the other messages.
+  TF_CHECK_OK(ReadInt64FromEnvVar("MPI_CHUNK_SIZE", 4 << 20, &chunk_size_));
+  chunk_size_ = std::min<int64>(std::max<int64>(chunk_size_, 1), INT_MAX);
 
   // extract worker-name
   auto parsed = env->local_devices[0]->parsed_name();
@@ -102,7 +132,7 @@ void MPIRemoteRendezvous::RecvFromRemoteAsync(
   const int64 temp1 = step_id_;
   rendezvous_call->recv_call_ =
       [this, parsed, recv_args, done, dst, temp1, rendezvous_call](
-          MPIRecvTensorResponse mpi_response) {
+          MPIRecvTensorResponse* mpi_response) -> MPIRecvTensorDataCall* {
     Status s;
     Device* dst_device;
     if (s.ok()) {
@@ -112,25 +142,41 @@ void MPIRemoteRendezvous::RecvFromRemoteAsync(
 
     VLOG(3) << "MPI Received tensor " << parsed.FullKey()
             << " @ step: " << temp1
-            << " single-send: " << mpi_response.singlesend();
-
-    Tensor val;
-    if (mpi_response.singlesend()) {
-      dst_device->MakeTensorFromProto(mpi_response.response().tensor(),
-                                      recv_args.alloc_attrs, &val);
-    } else {
-      TensorResponse tr;
-      tr.InitAlloc(dst_device, recv_args.alloc_attrs);
-      tr.InitPartial(mpi_response.response());
-      const size_t nBytes = tr.tensor().TotalBytes();
-      void* data = const_cast<void*>(DMAHelper::base(&tr.tensor()));
-      MPI_Status status;
-      MPI_CHECK(MPI_Recv(data, static_cast<int>(nBytes), MPI_BYTE, dst,
-                         TAG_SENDTENSOR2, MPI_COMM_WORLD, &status));
-      val = std::move(tr.tensor());
+            << " single-send: " << mpi_response->singlesend();
+
+    const bool is_dead = mpi_response->response().is_dead();
+    if (mpi_response->singlesend()) {
+      // Decode the tensor off the MPI thread, so that it keeps servicing
+      // the other transfers.
+      auto response = std::make_shared<MPIRecvTensorResponse>();
+      response->Swap(mpi_response);
+      env_->compute_pool->Schedule(
+          [dst_device, recv_args, done, response, is_dead, s]() {
+            Tensor val;
+            dst_device->MakeTensorFromProto(response->response().tensor(),
+                                            recv_args.alloc_attrs, &val);
+            done(s, Args(), recv_args, val, is_dead);
+          });
+      return nullptr;
     }
 
-    done(s, Args(), recv_args, val, mpi_response.response().is_dead());
+    // Post the receive of all the chunks of the data at once, in the order
+    // in which the sender posted them, and complete the recv once they have
+    // all arrived.
+    auto tr = std::make_shared<TensorResponse>();
+    tr->InitAlloc(dst_device, recv_args.alloc_attrs);
+    tr->InitPartial(mpi_response->response());
+    const int64 nBytes = tr->tensor().TotalBytes();
+    void* data = const_cast<void*>(DMAHelper::base(&tr->tensor()));
+    MPIRecvTensorDataCall* data_call = new MPIRecvTensorDataCall();
+    PostChunkedIrecv(data, nBytes, mpi_response->chunk_size(), dst,
+                     &data_call->data_requests_);
+    data_call->done_ = [this, tr, recv_args, done, is_dead, s]() {
+      env_->compute_pool->Schedule([tr, recv_args, done, is_dead, s]() {
+        done(s, Args(), recv_args, tr->tensor(), is_dead);
+      });
+    };
+    return data_call;
   };
 
   MPIRendezvousMgr* mgr =
@@ -174,17 +220,16 @@ void MPIRendezvousMgr::AddRequest(RecvTensorRequest request,
                        MPI_STATUS_IGNORE));
 
     if (!mpi_send_call->mRes_.singlesend()) {
-      const int tensor_size = static_cast<int>(val.TotalBytes());
-      void* temp = const_cast<void*>(DMAHelper::base(&val));
+      const void* temp = DMAHelper::base(&val);
 
       // If the MPI library is not GPU aware there should be a data transfer
       // here to get the data on the host.
       // if(src_dev->tensorflow_gpu_device_info()) //memcpy to send_buffer2_
 
-      // TODO(jbedorf)  this should be a loop over max size
-      MPI_CHECK(MPI_Isend(temp, tensor_size, MPI_CHAR, mpi_dst, TAG_SENDTENSOR2,
-                          MPI_COMM_WORLD, &mpi_send_call->msg2_));
-      mpi_send_call->done2_ = 0;
+      PostChunkedIsend(temp, val.TotalBytes(),
+                       mpi_send_call->mRes_.chunk_size(), mpi_dst,
+                       &mpi_send_call->data_requests_);
+      mpi_send_call->val_ = val;
     }
     return mpi_send_call;
   };
@@ -227,6 +272,7 @@ void MPIRendezvousMgr::AddRequest(RecvTensorRequest request,
                               ->mutable_tensor()
                               ->mutable_tensor_shape());
       mpi_send_call->mRes_.set_singlesend(false);
+      mpi_send_call->mRes_.set_chunk_size(chunk_size_);
     } else {
       // Send the Tensor description and data in a single transfer
       if (src_dev->tensorflow_gpu_device_info() &&
@@ -251,12 +297,9 @@ void MPIRendezvousMgr::AddRequest(RecvTensorRequest request,
 
     SendQueueEntry req(parsed.FullKey().ToString().c_str(), std::move(res));
 
+    // The send call holds the tensor until its data has been transmitted,
+    // so there is no need to wait for it here.
     this->QueueSendRequest(req);
-
-    // Wait for the notification that indicates the tensor has been
-    // successfully transmitted to the remote process. Only needed if we
-    // have not parsed the tensor to proto
-    if (doOptimalTransfer) mpi_send_call->n_.WaitForNotification();
   };  // done_cb
 
   worker_env_2->compute_pool->Schedule([this, step_id, parsed, done_cb]() {
@@ -266,6 +309,7 @@ void MPIRendezvousMgr::AddRequest(RecvTensorRequest request,
 
 void MPIRendezvousMgr::MPIBackgroundThread() {
   std::list<std::unique_ptr<MPISendTensorCall>> active_sends;
+  std::list<std::unique_ptr<MPIRecvTensorDataCall>> active_recvs;
 
   while (1) {
     MPI_Status status;
@@ -284,7 +328,10 @@ void MPIRendezvousMgr::MPIBackgroundThread() {
 
       std::shared_ptr<MPIRequestTensorCall> call;
       GetRecvCall(step_id, key, &call);
-      call->recv_call_(mRes);
+      MPIRecvTensorDataCall* data_call = call->recv_call_(&mRes);
+      if (data_call != nullptr) {
+        active_recvs.emplace_back(data_call);
+      }
       RemoveRecvCall(step_id, key);
     }
 
@@ -293,13 +340,21 @@ void MPIRendezvousMgr::MPIBackgroundThread() {
       return i->IsFinished();
     });
 
-    // send a Tensor request
+    // Complete the receives whose data has arrived
+    active_recvs.remove_if([](std::unique_ptr<MPIRecvTensorDataCall>& i) {
+      if (!i->IsFinished()) return false;
+      i->done_();
+      return true;
+    });
+
+    // send all the queued Tensor requests
     RequestQueueEntry req;
-    if (GetRequest(&req)) req.second();
+    while (GetRequest(&req)) req.second();
 
-    // Send a Tensor response
+    // Send all the queued Tensor responses, so that small tensors do not
+    // wait behind the chunks of large ones
     SendQueueEntry send;
-    if (GetResponse(&send)) {
+    while (GetResponse(&send)) {
       std::unique_ptr<MPISendTensorCall> p(send.second());
       active_sends.push_back(std::move(p));
     }
@@ -42,24 +42,45 @@ limitations under the License.
 
 namespace tensorflow {
 
+// Posts non-blocking transfers of the `size` bytes at `data` from or to
+// `rank`, in chunks of at most `chunk_size` bytes, and appends their requests
+// to `requests`. The chunks of one tensor are matched in order, since they
+// share a tag.
+void PostChunkedIsend(const void* data, int64 size, int64 chunk_size, int rank,
+                      std::vector<MPI_Request>* requests);
+void PostChunkedIrecv(void* data, int64 size, int64 chunk_size, int rank,
+                      std::vector<MPI_Request>* requests);
+
+// Returns true if all the requests have completed (or there are none).
+inline bool TestAll(std::vector<MPI_Request>* requests) {
+  int flag = 1;
+  if (!requests->empty()) {
+    MPI_CHECK(MPI_Testall(static_cast<int>(requests->size()), requests->data(),
+                          &flag, MPI_STATUSES_IGNORE));
+  }
+  return flag;
+}
+
 class MPISendTensorCall {
  public:
   char* send_buffer_;
   char* send_buffer2_;
 
   MPI_Request msg1_;
-  MPI_Request msg2_;
   int done1_;  // Int instead of bool for simpler IsFinished logic
-  int done2_;
+  // The chunks of the tensor data, when it is sent apart from its
+  // description.
+  std::vector<MPI_Request> data_requests_;
+  // The tensor whose data is being sent, which is held until the transfer
+  // completes.
+  Tensor val_;
   MPIRecvTensorResponse mRes_;
-  Notification n_;
 
   MPISendTensorCall()
-      : send_buffer_(nullptr), send_buffer2_(nullptr), done1_(1), done2_(1) {}
+      : send_buffer_(nullptr), send_buffer2_(nullptr), done1_(1) {}
 
   ~MPISendTensorCall() {
     MPI_CHECK(MPI_Wait(&msg1_, MPI_STATUS_IGNORE));
-    n_.Notify();
     MPI_CHECK(MPI_Free_mem(send_buffer_));
     //    delete[] send_buffer_;
     delete[] send_buffer2_;
@@ -80,11 +101,20 @@ class MPISendTensorCall {
   bool IsFinished() {
     MPI_Status status;
     if (!done1_) MPI_CHECK(MPI_Test(&msg1_, &done1_, &status));
-    if (!done2_) MPI_CHECK(MPI_Test(&msg2_, &done2_, &status));
-    return done1_ && done2_;
+    return done1_ && TestAll(&data_requests_);
   }
 };
 
+// The receive of the data of a tensor that is sent apart from its
+// description. `done_` is called once all the chunks have arrived.
+class MPIRecvTensorDataCall {
+ public:
+  std::vector<MPI_Request> data_requests_;
+  std::function<void()> done_;
+
+  bool IsFinished() { return TestAll(&data_requests_); }
+};
+
 class MPIRequestTensorCall {
  public:
   Rendezvous::DoneCallback done_;
@@ -92,7 +122,11 @@ class MPIRequestTensorCall {
   MPI_Request mpi_request_;
   char* request_buffer_;
   size_t request_buffer_size_;
-  std::function<void(MPIRecvTensorResponse)> recv_call_;
+  // Called on the MPI thread with the description of the tensor. Returns the
+  // receive of the tensor data if it is sent separately, or nullptr.
+  // The description may be swapped out of `mpi_response`.
+  std::function<MPIRecvTensorDataCall*(MPIRecvTensorResponse* mpi_response)>
+      recv_call_;
 
   MPIRequestTensorCall() : request_buffer_(nullptr) {}
   ~MPIRequestTensorCall() {
@@ -168,6 +202,7 @@ class MPIRendezvousMgr : public BaseRendezvousMgr {
   std::thread background_thread_;
   MPIUtils* mpiutils_;
   bool use_optimal_transfer_;
+  int64 chunk_size_;
 
   mutex msq_;
   mutex mrq_;
@@ -14,11 +14,13 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/contrib/nccl/kernels/nccl_manager.h"
 
+#include <stdlib.h>
 #include <utility>
 
 #ifdef GOOGLE_CUDA
 
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/platform/cuda.h"
 #include "tensorflow/core/platform/env.h"
 
@@ -32,9 +34,14 @@ struct NcclManager::NcclStream {
  public:
   NcclStream() {}
   ~NcclStream() {
-    mutex_lock l(mu);
-    shutdown_requested = true;
-    cv.notify_all();
+    {
+      mutex_lock l(mu);
+      shutdown_requested = true;
+      cv.notify_all();
+    }
+    // Waits for the pending launches, which may use the fusion buffer.
+    thread.reset();
+    if (!fusion_buffer.is_null()) executor->Deallocate(&fusion_buffer);
   }
 
   perftools::gputools::StreamExecutor* executor = nullptr;
@@ -50,6 +57,10 @@ struct NcclManager::NcclStream {
   // Has collective,rank pairs.
   std::deque<std::pair<Collective*, int>> pending_launches_ GUARDED_BY(mu);
   bool shutdown_requested GUARDED_BY(mu) = false;
+
+  // The buffer into which fused all-reduces pack their inputs.  It is only
+  // used by the kernels launched on <stream>, which run one at a time.
+  perftools::gputools::DeviceMemory<char> fusion_buffer;
 };
 
 struct NcclManager::CommunicatorMember {
@@ -71,6 +82,17 @@ struct NcclManager::Communicator {
 
   const int num_devices;
   const std::vector<CommunicatorMember> members;  // indexed by rank.
+
+  // The fields below are guarded by NcclManager::launch_mu_.
+
+  // The number of collectives that have been queued for launching and are
+  // not yet done on all ranks.
+  int in_flight = 0;
+
+  // The small all-reduces waiting to be fused, and the size of the input of
+  // each of their participants.
+  std::unique_ptr<Collective> bucket;
+  int64 bucket_bytes = 0;
 };
 
 namespace {
@@ -167,9 +189,27 @@ struct NcclManager::Collective {
   int available_participants = 0;
 
   mutable std::atomic_int_fast32_t remaining_participants;
+
+  // For a fused all-reduce, the all-reduces whose inputs it packs, in the
+  // order of the buffer.  A fused all-reduce has no participants itself.
+  std::vector<std::unique_ptr<Collective>> fused;
 };
 
-NcclManager::NcclManager() {}
+namespace {
+int64 FusionThresholdFromEnv() {
+  const char* value = getenv("TF_NCCL_FUSION_THRESHOLD_BYTES");
+  int64 threshold = 0;
+  if (value != nullptr && !strings::safe_strto64(value, &threshold)) {
+    LOG(ERROR) << "Invalid TF_NCCL_FUSION_THRESHOLD_BYTES: " << value;
+    threshold = 0;
+  }
+  return threshold;
+}
+}  // namespace
+
+NcclManager::NcclManager() : NcclManager(FusionThresholdFromEnv()) {}
+NcclManager::NcclManager(int64 fusion_threshold_bytes)
+    : fusion_threshold_bytes_(std::max<int64>(fusion_threshold_bytes, 0)) {}
 NcclManager::~NcclManager() {}
 NcclManager* NcclManager::instance() {
   static NcclManager* instance = new NcclManager();
@@ -370,8 +410,6 @@ void NcclManager::AddParticipant(int num_devices, const string& key,
 }
 
 void NcclManager::RunCollective(const string& key, Collective* collective) {
-  static mutex collective_mu;
-
   auto* communicator = GetCommunicator(collective);
   collective->communicator = communicator;
   const int size = communicator->num_devices;
@@ -397,20 +435,120 @@ void NcclManager::RunCollective(const string& key, Collective* collective) {
     CHECK_NE(collective->root_rank, -1);
   }
 
-  {
-    // Allow only one collective at a time to queue kernels for launching. This
-    // is to prevent collectives from deadlocking each other.
-    // Note that it would be possible to run multiple collectives at once, if
-    // they have non-intersecting sets of devices.
-    mutex_lock l(collective_mu);
-    for (int rank = 0; rank < size; ++rank) {
-      NcclStream* nccl_stream = communicator->members[rank].nccl_stream;
-      mutex_lock l(nccl_stream->mu);
-      nccl_stream->pending_launches_.push_front(
-          std::make_pair(collective, rank));
-      nccl_stream->cv.notify_all();
+  const int64 bytes = collective->type == kAllReduce
+                          ? collective->participants[0]->in_t->TotalBytes()
+                          : 0;
+  mutex_lock l(launch_mu_);
+  if (collective->type != kAllReduce || bytes >= fusion_threshold_bytes_) {
+    // Keeps the order of the collectives by launching the bucket first.
+    FlushBucket(communicator);
+    LaunchCollective(collective);
+    return;
+  }
+  Collective* bucket = communicator->bucket.get();
+  if (bucket != nullptr &&
+      (bucket->data_type != collective->data_type ||
+       bucket->reduction_op != collective->reduction_op ||
+       communicator->bucket_bytes + bytes > fusion_threshold_bytes_)) {
+    FlushBucket(communicator);
+  }
+  if (communicator->bucket == nullptr) {
+    communicator->bucket.reset(new Collective(collective->data_type,
+                                              kAllReduce,
+                                              collective->reduction_op, size));
+    communicator->bucket->communicator = communicator;
+  }
+  communicator->bucket->fused.emplace_back(collective);
+  communicator->bucket_bytes += bytes;
+  // The bucket waits for the collectives that are running, so the nccl
+  // streams stay busy while it fills.
+  if (communicator->in_flight == 0 ||
+      communicator->bucket_bytes >= fusion_threshold_bytes_) {
+    FlushBucket(communicator);
+  }
+}
+
+void NcclManager::LaunchCollective(Collective* collective) {
+  // Only one collective at a time queues kernels for launching. This is to
+  // prevent collectives from deadlocking each other.
+  // Note that it would be possible to run multiple collectives at once, if
+  // they have non-intersecting sets of devices.
+  Communicator* communicator = collective->communicator;
+  ++communicator->in_flight;
+  for (int rank = 0; rank < communicator->num_devices; ++rank) {
+    NcclStream* nccl_stream = communicator->members[rank].nccl_stream;
+    mutex_lock l(nccl_stream->mu);
+    nccl_stream->pending_launches_.push_front(std::make_pair(collective, rank));
+    nccl_stream->cv.notify_all();
+  }
+}
+
+void NcclManager::FlushBucket(Communicator* communicator) {
+  if (communicator->bucket == nullptr) return;
+  std::unique_ptr<Collective> bucket = std::move(communicator->bucket);
+  communicator->bucket_bytes = 0;
+  if (bucket->fused.size() == 1) {
+    // Nothing to fuse it with, so it does not need the fusion buffer.
+    LaunchCollective(bucket->fused[0].release());
+  } else {
+    LaunchCollective(bucket.release());
+  }
+}
+
+void NcclManager::CollectiveDone(Communicator* communicator) {
+  mutex_lock l(launch_mu_);
+  --communicator->in_flight;
+  FlushBucket(communicator);
+}
+
+Status NcclManager::LaunchFusedAllReduce(const Collective* collective,
+                                         int rank, ncclComm_t nccl_comm,
+                                         NcclStream* nccl_stream,
+                                         ncclResult_t* nccl_result) {
+  perftools::gputools::Stream* comm_stream = nccl_stream->stream.get();
+  if (nccl_stream->fusion_buffer.is_null()) {
+    // Every bucket fits in <fusion_threshold_bytes_>.
+    nccl_stream->fusion_buffer =
+        nccl_stream->executor->AllocateArray<char>(fusion_threshold_bytes_);
+    if (nccl_stream->fusion_buffer.is_null()) {
+      return errors::ResourceExhausted("Failed to allocate ",
+                                       fusion_threshold_bytes_,
+                                       " bytes for fused NCCL all-reduces");
     }
   }
+  char* buffer = static_cast<char*>(nccl_stream->fusion_buffer.opaque());
+  int64 offset = 0;
+  for (const auto& fused : collective->fused) {
+    const Tensor* in_t = fused->participants[rank]->in_t;
+    perftools::gputools::DeviceMemoryBase dst(buffer + offset,
+                                              in_t->TotalBytes());
+    perftools::gputools::DeviceMemoryBase src(
+        const_cast<char*>(in_t->tensor_data().data()), in_t->TotalBytes());
+    comm_stream->ThenMemcpy(&dst, src, in_t->TotalBytes());
+    offset += in_t->TotalBytes();
+  }
+  const cudaStream_t* cu_stream = reinterpret_cast<const cudaStream_t*>(
+      comm_stream->implementation()->CudaStreamMemberHack());
+  *nccl_result = ncclAllReduce(
+      buffer, buffer, offset / DataTypeSize(collective->data_type),
+      ToNcclType(collective->data_type), collective->reduction_op, nccl_comm,
+      *cu_stream);
+  if (*nccl_result != ncclSuccess) return Status::OK();
+  offset = 0;
+  for (const auto& fused : collective->fused) {
+    Tensor* out_t = fused->participants[rank]->out_t;
+    perftools::gputools::DeviceMemoryBase dst(
+        const_cast<char*>(out_t->tensor_data().data()), out_t->TotalBytes());
+    perftools::gputools::DeviceMemoryBase src(buffer + offset,
+                                              out_t->TotalBytes());
+    comm_stream->ThenMemcpy(&dst, src, out_t->TotalBytes());
+    offset += out_t->TotalBytes();
+  }
+  if (!comm_stream->ok()) {
+    return errors::Internal("Failed to copy the tensors of a fused NCCL "
+                            "all-reduce");
+  }
+  return Status::OK();
 }
 
 void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
@@ -439,12 +577,20 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
 
     // Launch the nccl kernel.
     ncclDataType_t data_type = ToNcclType(collective->data_type);
-    Participant* p = collective->participants[rank].get();
+    Participant* p = collective->fused.empty()
+                         ? collective->participants[rank].get()
+                         : collective->fused[0]->participants[rank].get();
 
     auto nccl_comm = collective->communicator->members[rank].nccl_comm;
     ncclResult_t nccl_result = ncclSuccess;
+    Status status;
     switch (collective->type) {
       case kAllReduce: {
+        if (!collective->fused.empty()) {
+          status = LaunchFusedAllReduce(collective, rank, nccl_comm,
+                                        nccl_stream, &nccl_result);
+          break;
+        }
         const void* sendbuff = p->in_t->tensor_data().data();
         void* recvbuff = const_cast<char*>(p->out_t->tensor_data().data());
 
@@ -471,16 +617,26 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
         break;
       }
     }
+    if (nccl_result != ncclSuccess) {
+      // Propagate the error, but note that if other members of the collective
+      // did launch their kernels, then they are hanging.
+      status = errors::Unknown("Error invoking NCCL: ",
+                               ncclGetErrorString(nccl_result));
+    }
 
     // Run the done_callback when the nccl kernel finishes running.
-    auto done_callback = [collective, rank, nccl_result]() {
-      if (nccl_result == ncclSuccess) {
-        collective->participants[rank]->done_callback(Status::OK());
+    auto done_callback = [this, collective, rank, status]() {
+      // The callbacks of this rank, taken before another rank may delete
+      // <collective>.
+      std::vector<DoneCallback> done_callbacks;
+      if (collective->fused.empty()) {
+        done_callbacks.push_back(
+            std::move(collective->participants[rank]->done_callback));
       } else {
-        // Propagate the error, but note that if other members of the collective
-        // did launch their kernels, then they are hanging.
-        collective->participants[rank]->done_callback(errors::Unknown(
-            "Error invoking NCCL: ", ncclGetErrorString(nccl_result)));
+        for (const auto& fused : collective->fused) {
+          done_callbacks.push_back(
+              std::move(fused->participants[rank]->done_callback));
+        }
       }
 
       // TODO(cwhipkey): use RefCounted after figuring out how to use in a
@@ -489,8 +645,10 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
       if (collective->remaining_participants.load(std::memory_order_acquire) ==
               1 ||
           collective->remaining_participants.fetch_sub(1) == 1) {
+        CollectiveDone(collective->communicator);
         delete collective;
       }
+      for (const auto& done : done_callbacks) done(status);
     };
     p->event_mgr->ThenExecute(comm_stream, done_callback);
   }
@@ -33,10 +33,21 @@ namespace tensorflow {
 //
 // See nccl_ops.cc for example usage, including description of memory
 // management and stream synchronization.
+//
+// All-reduces whose input is smaller than <fusion_threshold_bytes> are not
+// run on their own while another collective of the same communicator is
+// running. They are collected in a bucket, in the order in which all their
+// participants arrive, and the bucket is reduced with a single nccl call on
+// a buffer that packs their inputs, as soon as it holds
+// <fusion_threshold_bytes> or the running collective finishes. A
+// <fusion_threshold_bytes> of 0 disables the fusion; the default
+// constructor reads it from the TF_NCCL_FUSION_THRESHOLD_BYTES environment
+// variable.
 class NcclManager {
  public:
   typedef std::function<void(Status)> DoneCallback;
   NcclManager();
+  explicit NcclManager(int64 fusion_threshold_bytes);
   ~NcclManager();
 
   static NcclManager* instance();
@@ -114,8 +125,33 @@ class NcclManager {
   void RunCollective(const string& key, Collective* collective);
   void LoopKernelLaunches(NcclStream* stream);
 
+  // Packs the inputs of the all-reduces fused in <collective> for <rank> into
+  // the fusion buffer of <nccl_stream>, reduces it in place with <nccl_comm>
+  // and unpacks it into their outputs.
+  Status LaunchFusedAllReduce(const Collective* collective, int rank,
+                              ncclComm_t nccl_comm, NcclStream* nccl_stream,
+                              ncclResult_t* nccl_result);
+
+  // Queues the kernels of <collective> for launching on the streams of its
+  // communicator.
+  void LaunchCollective(Collective* collective)
+      EXCLUSIVE_LOCKS_REQUIRED(launch_mu_);
+
+  // Launches the bucket of small all-reduces of <communicator>, if any.
+  void FlushBucket(Communicator* communicator)
+      EXCLUSIVE_LOCKS_REQUIRED(launch_mu_);
+
+  // Called when all the ranks of a collective of <communicator> are done.
+  void CollectiveDone(Communicator* communicator);
+
+  const int64 fusion_threshold_bytes_;
+
   mutex mu_;
 
+  // Allows only one collective at a time to queue kernels for launching, and
+  // guards the buckets of the communicators.
+  mutex launch_mu_;
+
   // Maps key to collectives currently being assembled or run.
   std::unordered_map<string, std::unique_ptr<Collective>> collectives_
       GUARDED_BY(mu_);
@@ -203,6 +203,40 @@ TEST_F(NcclManagerTest, BasicSumReduction) {
   }
 }
 
+// Small all-reduces that arrive while others are running are fused, and a
+// large one launches them first.
+TEST_F(NcclManagerTest, FusedSumReduction) {
+  const int num_ranks = 3;
+  const int num_collectives = 20;
+  // Fits a few of the small all-reduces, but not the last one.
+  NcclManager manager(4 * 100 * 6 * sizeof(float));
+
+  std::vector<std::unique_ptr<TestCase>> test_cases;
+  for (int i = 0; i <= num_collectives; ++i) {
+    const TensorShape shape = i == num_collectives
+                                  ? TensorShape({100, 100})
+                                  : TensorShape({100, i % 3 + 1, 2});
+    test_cases.emplace_back(MakeTestCase(num_ranks, ncclSum, shape, i));
+  }
+  for (int i = 0; i <= num_collectives; ++i) {
+    TestCase* test_case = test_cases[i].get();
+    for (int device_num = 0; device_num < num_ranks; ++device_num) {
+      auto* device = devices->at(device_num % devices->size());
+      auto* event_mgr = device->tensorflow_gpu_device_info()->event_mgr;
+      auto* stream = device->tensorflow_gpu_device_info()->stream;
+      manager.AddToAllReduce(
+          num_ranks, strings::StrCat("fused_allreduce", i), ncclSum,
+          device->executor(), device->gpu_id(), event_mgr, stream,
+          &test_case->ins[device_num], &test_case->outs[device_num],
+          CreateDoneCallback(test_case));
+    }
+  }
+
+  for (int i = 0; i <= num_collectives; ++i) {
+    VerifyResults(strings::StrCat("collective", i), test_cases[i].get());
+  }
+}
+
 // Same as the Basic test, but with multiple threads launching parts of many
 // reductions.
 //
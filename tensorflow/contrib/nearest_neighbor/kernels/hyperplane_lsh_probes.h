@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_NEAREST_NEIGHBOR_KERNELS_HYPERPLANE_LSH_PROBES_H_
 #define THIRD_PARTY_TENSORFLOW_CONTRIB_NEAREST_NEIGHBOR_KERNELS_HYPERPLANE_LSH_PROBES_H_
 
+#include <algorithm>
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 
 #include "tensorflow/contrib/nearest_neighbor/kernels/heap.h"
@@ -66,7 +69,12 @@ class HyperplaneMultiprobe {
   // If num_probes is at most num_tables, it is not necessary to generate an
   // actual multiprobe sequence and the multiprobe object will simply return
   // the "standard" LSH probes without incurring any multiprobe overhead.
-  void SetupProbing(const Vector& hash_vector, int_fast64_t num_probes) {
+  //
+  // hash_vector can be any vector expression, e.g. a row of the matrix of
+  // products for a batch of points, which is copied without a temporary.
+  template <typename Derived>
+  void SetupProbing(const Eigen::MatrixBase<Derived>& hash_vector,
+                    int_fast64_t num_probes) {
     // We accept a copy here for now.
     hash_vector_ = hash_vector;
     num_probes_ = num_probes;
@@ -98,10 +106,19 @@ class HyperplaneMultiprobe {
       }
     }
 
+    // Each probe beyond the main ones extends the prefix of the sorted
+    // hyperplanes of its table that the sequence has used by at most one, so
+    // a sequence of num_probes_ probes only needs the first
+    // num_probes_ - num_tables_ + 1 hyperplanes of each table in order.
+    int_fast64_t num_sorted = num_hyperplanes_per_table_;
+    if (num_probes_ >= 0) {
+      num_sorted = std::min(num_sorted, num_probes_ - num_tables_ + 1);
+    }
     for (int_fast32_t ii = 0; ii < num_tables_; ++ii) {
       HyperplaneComparator comp(hash_vector_, ii * num_hyperplanes_per_table_);
-      std::sort(sorted_hyperplane_indices_[ii].begin(),
-                sorted_hyperplane_indices_[ii].end(), comp);
+      std::partial_sort(sorted_hyperplane_indices_[ii].begin(),
+                        sorted_hyperplane_indices_[ii].begin() + num_sorted,
+                        sorted_hyperplane_indices_[ii].end(), comp);
     }
 
     if (num_probes_ >= 0) {
@@ -210,8 +227,12 @@ class HyperplaneMultiprobe {
     HyperplaneComparator(const Vector& values, int_fast32_t offset)
         : values_(values), offset_(offset) {}
 
+    // Hyperplanes at the same distance are ordered by index, so that the
+    // order does not depend on the sorting algorithm.
     bool operator()(int_fast32_t ii, int_fast32_t jj) const {
-      return std::abs(values_[offset_ + ii]) < std::abs(values_[offset_ + jj]);
+      const CoordinateType abs_ii = std::abs(values_[offset_ + ii]);
+      const CoordinateType abs_jj = std::abs(values_[offset_ + jj]);
+      return abs_ii < abs_jj || (abs_ii == abs_jj && ii < jj);
     }
 
    private:
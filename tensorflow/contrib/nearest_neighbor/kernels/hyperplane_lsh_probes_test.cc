@@ -127,4 +127,44 @@ TEST(HyperplaneMultiprobeTest, ExhaustiveTest1) {
   }
 }
 
+// Checks that a probing sequence of a given length is the beginning of the
+// exhaustive probing sequence, including for hyperplanes at equal distances.
+TEST(HyperplaneMultiprobeTest, PrefixOfExhaustiveSequence) {
+  int dim = 20;
+  int num_tables = 3;
+  Multiprobe multiprobe(dim, num_tables);
+  Multiprobe::Vector hash_vector(dim * num_tables);
+
+  std::mt19937 random_generator(23748123);
+  std::normal_distribution<float> distribution(0.0, 1.0);
+  for (int ii = 0; ii < dim * num_tables; ++ii) {
+    hash_vector[ii] = distribution(random_generator);
+  }
+  for (int ii = 0; ii < dim; ii += 4) {
+    hash_vector[ii + 1] = -hash_vector[ii];
+  }
+
+  const int max_num_probes = 200;
+  std::vector<std::pair<uint32, int_fast32_t>> exhaustive_result;
+  multiprobe.SetupProbing(hash_vector, -1);
+  uint32 cur_probe;
+  int_fast32_t cur_table;
+  for (int ii = 0; ii < max_num_probes; ++ii) {
+    ASSERT_TRUE(multiprobe.GetNextProbe(&cur_probe, &cur_table));
+    exhaustive_result.emplace_back(cur_probe, cur_table);
+  }
+
+  for (int num_probes = 1; num_probes <= max_num_probes; ++num_probes) {
+    // A new object, so that the order of the hyperplanes is not left over
+    // from the exhaustive sequence.
+    Multiprobe prefix_multiprobe(dim, num_tables);
+    prefix_multiprobe.SetupProbing(hash_vector, num_probes);
+    CheckSequenceMultipleTables(
+        &prefix_multiprobe,
+        std::vector<std::pair<uint32, int_fast32_t>>(
+            exhaustive_result.begin(), exhaustive_result.begin() + num_probes));
+    EXPECT_FALSE(prefix_multiprobe.GetNextProbe(&cur_probe, &cur_table));
+  }
+}
+
 }  // namespace
@@ -41,31 +41,17 @@ typedef Eigen::GpuDevice GPUDevice;
 
 namespace functor {
 
+// Computes the gates and the outputs of the cell from icfo = xh * w + b.
 template <typename T>
-void LSTMBlockCellFpropWithEigen(
-    const LSTMBlockCell& cell, OpKernelContext* ctx, const CPUDevice& d,
-    const T forget_bias, const T cell_clip, bool use_peephole,
-    typename TTypes<T>::ConstMatrix x, typename TTypes<T>::ConstMatrix cs_prev,
-    typename TTypes<T>::ConstMatrix h_prev, typename TTypes<T>::ConstMatrix w,
-    typename TTypes<T>::ConstVec wci, typename TTypes<T>::ConstVec wcf,
-    typename TTypes<T>::ConstVec wco, typename TTypes<T>::ConstVec b,
-    typename TTypes<T>::Matrix xh, typename TTypes<T>::Matrix i,
+void LSTMBlockCellFpropGatesWithEigen(
+    const LSTMBlockCell& cell, const CPUDevice& d, const T forget_bias,
+    const T cell_clip, bool use_peephole,
+    typename TTypes<T>::ConstMatrix cs_prev, typename TTypes<T>::ConstVec wci,
+    typename TTypes<T>::ConstVec wcf, typename TTypes<T>::ConstVec wco,
+    typename TTypes<T>::ConstMatrix icfo, typename TTypes<T>::Matrix i,
     typename TTypes<T>::Matrix cs, typename TTypes<T>::Matrix f,
     typename TTypes<T>::Matrix o, typename TTypes<T>::Matrix ci,
-    typename TTypes<T>::Matrix co, typename TTypes<T>::Matrix icfo,
-    typename TTypes<T>::Matrix h) {
-  // Concat xh = [x, h].
-  xh.slice(cell.xh_x_offsets(), cell.xh_x_extents()).device(d) = x;
-  xh.slice(cell.xh_h_offsets(), cell.xh_h_extents()).device(d) = h_prev;
-
-  // states1 = xh * w + b
-  typename TTypes<T>::ConstMatrix const_xh(xh.data(), xh.dimensions());
-  TensorBlasGemm<CPUDevice, T, false /* USE_CUBLAS */>::compute(
-      ctx, d, false, false, T(1), const_xh, w, T(0), icfo);
-  Eigen::array<Eigen::DenseIndex, 2> b_shape({1, b.dimensions()[0]});
-  Eigen::array<Eigen::DenseIndex, 2> broadcast_shape({cell.batch_size(), 1});
-  icfo.device(d) += b.reshape(b_shape).broadcast(broadcast_shape);
-
+    typename TTypes<T>::Matrix co, typename TTypes<T>::Matrix h) {
   Eigen::array<Eigen::DenseIndex, 2> p_shape({1, cell.cell_size()});
   Eigen::array<Eigen::DenseIndex, 2> p_broadcast_shape({cell.batch_size(), 1});
 
@@ -121,6 +107,37 @@ void LSTMBlockCellFpropWithEigen(
   h.device(d) = o * co;
 }
 
+template <typename T>
+void LSTMBlockCellFpropWithEigen(
+    const LSTMBlockCell& cell, OpKernelContext* ctx, const CPUDevice& d,
+    const T forget_bias, const T cell_clip, bool use_peephole,
+    typename TTypes<T>::ConstMatrix x, typename TTypes<T>::ConstMatrix cs_prev,
+    typename TTypes<T>::ConstMatrix h_prev, typename TTypes<T>::ConstMatrix w,
+    typename TTypes<T>::ConstVec wci, typename TTypes<T>::ConstVec wcf,
+    typename TTypes<T>::ConstVec wco, typename TTypes<T>::ConstVec b,
+    typename TTypes<T>::Matrix xh, typename TTypes<T>::Matrix i,
+    typename TTypes<T>::Matrix cs, typename TTypes<T>::Matrix f,
+    typename TTypes<T>::Matrix o, typename TTypes<T>::Matrix ci,
+    typename TTypes<T>::Matrix co, typename TTypes<T>::Matrix icfo,
+    typename TTypes<T>::Matrix h) {
+  // Concat xh = [x, h].
+  xh.slice(cell.xh_x_offsets(), cell.xh_x_extents()).device(d) = x;
+  xh.slice(cell.xh_h_offsets(), cell.xh_h_extents()).device(d) = h_prev;
+
+  // states1 = xh * w + b
+  typename TTypes<T>::ConstMatrix const_xh(xh.data(), xh.dimensions());
+  TensorBlasGemm<CPUDevice, T, false /* USE_CUBLAS */>::compute(
+      ctx, d, false, false, T(1), const_xh, w, T(0), icfo);
+  Eigen::array<Eigen::DenseIndex, 2> b_shape({1, b.dimensions()[0]});
+  Eigen::array<Eigen::DenseIndex, 2> broadcast_shape({cell.batch_size(), 1});
+  icfo.device(d) += b.reshape(b_shape).broadcast(broadcast_shape);
+
+  typename TTypes<T>::ConstMatrix const_icfo(icfo.data(), icfo.dimensions());
+  LSTMBlockCellFpropGatesWithEigen<T>(cell, d, forget_bias, cell_clip,
+                                      use_peephole, cs_prev, wci, wcf, wco,
+                                      const_icfo, i, cs, f, o, ci, co, h);
+}
+
 template <typename Device, typename T, bool USE_CUBLAS>
 void LSTMBlockCellBpropWithEigen(
     const LSTMBlockCell& cell, OpKernelContext* ctx, const Device& d,
@@ -808,6 +825,153 @@ class SliceHelper {
   const Device& device_;
 };
 
+// Runs the cells of BlockLSTM for the time steps [0, seq_len_max), each of
+// which multiplies [x, h_prev] by w.
+template <typename Device, typename T, bool USE_CUBLAS>
+struct BlockLSTMFpropTimeSteps {
+  void operator()(OpKernelContext* ctx, const T forget_bias, const T cell_clip,
+                  bool use_peephole, const int64 seq_len_max, const Tensor& x,
+                  const Tensor& cs_prev, const Tensor& h_prev, const Tensor& w,
+                  const Tensor& wci, const Tensor& wcf, const Tensor& wco,
+                  const Tensor& b, Tensor* i_out, Tensor* cs_out, Tensor* f_out,
+                  Tensor* o_out, Tensor* ci_out, Tensor* co_out,
+                  Tensor* h_out) {
+    const int64 batch_size = x.dim_size(1);
+    const int64 input_size = x.dim_size(2);
+    const int64 cell_size = cs_prev.dim_size(1);
+
+    Tensor xh_tensor;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(
+                            DataTypeToEnum<T>::v(),
+                            TensorShape({batch_size, input_size + cell_size}),
+                            &xh_tensor));
+
+    Tensor icfo_tensor;
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_temp(DataTypeToEnum<T>::v(),
+                                      TensorShape({batch_size, cell_size * 4}),
+                                      &icfo_tensor));
+
+    const Device& device = ctx->eigen_device<Device>();
+
+    SliceHelper<Device, T> slicer(ctx);
+    for (int64 t = 0; t < seq_len_max; ++t) {
+      const Tensor x_tensor = slicer.InputSlice(x, t, "x");
+      const Tensor& cs_prev_tensor =
+          t == 0 ? cs_prev : slicer.OutputSlice(cs_out, t - 1, "cs_prev");
+      const Tensor& h_prev_tensor =
+          t == 0 ? h_prev : slicer.OutputSlice(h_out, t - 1, "h_prev");
+
+      Tensor i_tensor = slicer.OutputSlice(i_out, t, "i_out");
+      Tensor cs_tensor = slicer.OutputSlice(cs_out, t, "cs_out");
+      Tensor f_tensor = slicer.OutputSlice(f_out, t, "f_out");
+      Tensor o_tensor = slicer.OutputSlice(o_out, t, "o_out");
+      Tensor ci_tensor = slicer.OutputSlice(ci_out, t, "ci_out");
+      Tensor co_tensor = slicer.OutputSlice(co_out, t, "co_out");
+      Tensor h_tensor = slicer.OutputSlice(h_out, t, "h_out");
+
+      functor::LSTMBlockCellFprop<Device, T, USE_CUBLAS>(batch_size, input_size,
+                                                         cell_size)(
+          ctx, device, forget_bias, cell_clip, use_peephole,
+          x_tensor.matrix<T>(), cs_prev_tensor.matrix<T>(),
+          h_prev_tensor.matrix<T>(), w.matrix<T>(), wci.vec<T>(),
+          wcf.vec<T>(), wco.vec<T>(), b.vec<T>(), xh_tensor.matrix<T>(),
+          i_tensor.matrix<T>(), cs_tensor.matrix<T>(), f_tensor.matrix<T>(),
+          o_tensor.matrix<T>(), ci_tensor.matrix<T>(), co_tensor.matrix<T>(),
+          icfo_tensor.matrix<T>(), h_tensor.matrix<T>());
+      slicer.FinishTimeStep();
+    }
+  }
+};
+
+// On the CPU, the projections x * w[:input_size] + b of the inputs of all of
+// the time steps are computed in one GEMM before the loop over the time
+// steps, which is much faster than one small GEMM per time step, and each
+// time step only adds h_prev * w[input_size:] to its projection.
+template <typename T>
+struct BlockLSTMFpropTimeSteps<CPUDevice, T, false /* USE_CUBLAS */> {
+  void operator()(OpKernelContext* ctx, const T forget_bias, const T cell_clip,
+                  bool use_peephole, const int64 seq_len_max, const Tensor& x,
+                  const Tensor& cs_prev, const Tensor& h_prev, const Tensor& w,
+                  const Tensor& wci, const Tensor& wcf, const Tensor& wco,
+                  const Tensor& b, Tensor* i_out, Tensor* cs_out, Tensor* f_out,
+                  Tensor* o_out, Tensor* ci_out, Tensor* co_out,
+                  Tensor* h_out) {
+    const int64 batch_size = x.dim_size(1);
+    const int64 input_size = x.dim_size(2);
+    const int64 cell_size = cs_prev.dim_size(1);
+    if (seq_len_max == 0) return;
+
+    const CPUDevice& device = ctx->eigen_device<CPUDevice>();
+
+    // icfo = x * w[:input_size] + b, for all of the time steps.
+    Tensor icfo_all;
+    OP_REQUIRES_OK(
+        ctx, ctx->allocate_temp(
+                 DataTypeToEnum<T>::v(),
+                 TensorShape({seq_len_max, batch_size, cell_size * 4}),
+                 &icfo_all));
+    typename TTypes<T>::Matrix icfo_all_matrix(
+        icfo_all.flat<T>().data(), seq_len_max * batch_size, cell_size * 4);
+    typename TTypes<T>::ConstMatrix x_matrix(
+        x.flat<T>().data(), seq_len_max * batch_size, input_size);
+    // The first rows of w start where w does, so they are aligned.
+    typename TTypes<T>::ConstMatrix w_x(w.flat<T>().data(), input_size,
+                                        cell_size * 4);
+    functor::TensorBlasGemm<CPUDevice, T, false /* USE_CUBLAS */>::compute(
+        ctx, device, false, false, T(1), x_matrix, w_x, T(0), icfo_all_matrix);
+    Eigen::array<Eigen::DenseIndex, 2> b_shape({1, cell_size * 4});
+    Eigen::array<Eigen::DenseIndex, 2> broadcast_shape(
+        {seq_len_max * batch_size, 1});
+    icfo_all_matrix.device(device) +=
+        b.vec<T>().reshape(b_shape).broadcast(broadcast_shape);
+
+    // The rows of w that multiply h_prev, copied if they are not aligned.
+    const Tensor w_h_slice = w.Slice(input_size, input_size + cell_size);
+    Tensor w_h = w_h_slice;
+    if (!w_h_slice.IsAligned()) {
+      OP_REQUIRES_OK(ctx, ctx->allocate_temp(DataTypeToEnum<T>::v(),
+                                             w_h_slice.shape(), &w_h));
+      functor::TensorCopyUnaligned<CPUDevice, T>()(
+          device, w_h_slice.unaligned_flat<T>(), w_h.flat<T>());
+    }
+    const Tensor& const_w_h = w_h;
+
+    const functor::LSTMBlockCell cell(batch_size, input_size, cell_size);
+    SliceHelper<CPUDevice, T> slicer(ctx);
+    for (int64 t = 0; t < seq_len_max; ++t) {
+      const Tensor& cs_prev_tensor =
+          t == 0 ? cs_prev : slicer.OutputSlice(cs_out, t - 1, "cs_prev");
+      const Tensor& h_prev_tensor =
+          t == 0 ? h_prev : slicer.OutputSlice(h_out, t - 1, "h_prev");
+
+      Tensor icfo_tensor = slicer.OutputSlice(&icfo_all, t, "icfo");
+      Tensor i_tensor = slicer.OutputSlice(i_out, t, "i_out");
+      Tensor cs_tensor = slicer.OutputSlice(cs_out, t, "cs_out");
+      Tensor f_tensor = slicer.OutputSlice(f_out, t, "f_out");
+      Tensor o_tensor = slicer.OutputSlice(o_out, t, "o_out");
+      Tensor ci_tensor = slicer.OutputSlice(ci_out, t, "ci_out");
+      Tensor co_tensor = slicer.OutputSlice(co_out, t, "co_out");
+      Tensor h_tensor = slicer.OutputSlice(h_out, t, "h_out");
+
+      // icfo += h_prev * w[input_size:]
+      typename TTypes<T>::Matrix icfo = icfo_tensor.matrix<T>();
+      functor::TensorBlasGemm<CPUDevice, T, false /* USE_CUBLAS */>::compute(
+          ctx, device, false, false, T(1), h_prev_tensor.matrix<T>(),
+          const_w_h.matrix<T>(), T(1), icfo);
+      typename TTypes<T>::ConstMatrix const_icfo(icfo.data(),
+                                                 icfo.dimensions());
+      functor::LSTMBlockCellFpropGatesWithEigen<T>(
+          cell, device, forget_bias, cell_clip, use_peephole,
+          cs_prev_tensor.matrix<T>(), wci.vec<T>(), wcf.vec<T>(), wco.vec<T>(),
+          const_icfo, i_tensor.matrix<T>(), cs_tensor.matrix<T>(),
+          f_tensor.matrix<T>(), o_tensor.matrix<T>(), ci_tensor.matrix<T>(),
+          co_tensor.matrix<T>(), h_tensor.matrix<T>());
+      slicer.FinishTimeStep();
+    }
+  }
+};
+
 }  // namespace
 
 template <typename Device, typename T, bool USE_CUBLAS>
@@ -935,50 +1099,18 @@ class BlockLSTMOp : public OpKernel {
     Tensor* h_out;
     OP_REQUIRES_OK(ctx, ctx->allocate_output("h", batch_cell_shape, &h_out));
 
-    Tensor xh_tensor;
-    OP_REQUIRES_OK(ctx, ctx->allocate_temp(
-                            DataTypeToEnum<T>::v(),
-                            TensorShape({batch_size, input_size + cell_size}),
-                            &xh_tensor));
-
-    Tensor icfo_tensor;
-    OP_REQUIRES_OK(ctx,
-                   ctx->allocate_temp(DataTypeToEnum<T>::v(),
-                                      TensorShape({batch_size, cell_size * 4}),
-                                      &icfo_tensor));
-
     const Device& device = ctx->eigen_device<Device>();
 
     const int64 seq_len_max = seq_len_max_tensor->scalar<int64>()();
-    SliceHelper<Device, T> slicer(ctx);
-    for (int64 t = 0; t < seq_len_max; ++t) {
-      const Tensor x_tensor = slicer.InputSlice(*x, t, "x");
-      const Tensor& cs_prev_tensor2 =
-          t == 0 ? *cs_prev_tensor
-                 : slicer.OutputSlice(cs_out, t - 1, "cs_prev");
-      const Tensor& h_prev_tensor2 =
-          t == 0 ? *h_prev_tensor : slicer.OutputSlice(h_out, t - 1, "h_prev");
-
-      Tensor i_tensor = slicer.OutputSlice(i_out, t, "i_out");
-      Tensor cs_tensor = slicer.OutputSlice(cs_out, t, "cs_out");
-      Tensor f_tensor = slicer.OutputSlice(f_out, t, "f_out");
-      Tensor o_tensor = slicer.OutputSlice(o_out, t, "o_out");
-      Tensor ci_tensor = slicer.OutputSlice(ci_out, t, "ci_out");
-      Tensor co_tensor = slicer.OutputSlice(co_out, t, "co_out");
-      Tensor h_tensor = slicer.OutputSlice(h_out, t, "h_out");
-
-      functor::LSTMBlockCellFprop<Device, T, USE_CUBLAS>(batch_size, input_size,
-                                                         cell_size)(
-          ctx, device, forget_bias_, cell_clip_, use_peephole_,
-          x_tensor.matrix<T>(), cs_prev_tensor2.matrix<T>(),
-          h_prev_tensor2.matrix<T>(), w_tensor->matrix<T>(),
-          wci_tensor->vec<T>(), wcf_tensor->vec<T>(), wco_tensor->vec<T>(),
-          b_tensor->vec<T>(), xh_tensor.matrix<T>(), i_tensor.matrix<T>(),
-          cs_tensor.matrix<T>(), f_tensor.matrix<T>(), o_tensor.matrix<T>(),
-          ci_tensor.matrix<T>(), co_tensor.matrix<T>(), icfo_tensor.matrix<T>(),
-          h_tensor.matrix<T>());
-      slicer.FinishTimeStep();
-    }
+    OP_REQUIRES(ctx, seq_len_max <= timelen,
+                errors::InvalidArgument("seq_len_max must be <= timelen: ",
+                                        seq_len_max, " vs. ", timelen));
+    BlockLSTMFpropTimeSteps<Device, T, USE_CUBLAS>()(
+        ctx, forget_bias_, cell_clip_, use_peephole_, seq_len_max, *x,
+        *cs_prev_tensor, *h_prev_tensor, *w_tensor, *wci_tensor, *wcf_tensor,
+        *wco_tensor, *b_tensor, i_out, cs_out, f_out, o_out, ci_out, co_out,
+        h_out);
+    if (!ctx->status().ok()) return;
 
     if (seq_len_max < timelen) {
       Tensor cs_tensor = cs_out->Slice(seq_len_max, timelen);
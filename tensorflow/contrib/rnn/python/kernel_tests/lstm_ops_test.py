@@ -38,11 +38,12 @@ from tensorflow.python.platform import test
 block_lstm = lstm_ops._block_lstm  # pylint: disable=protected-access
 
 
-def blocks_match(sess, use_peephole):
-  batch_size = 2
-  input_size = 3
-  cell_size = 4
-  sequence_length = 4
+def blocks_match(sess,
+                 use_peephole,
+                 batch_size=2,
+                 input_size=3,
+                 cell_size=4,
+                 sequence_length=4):
 
   inputs = []
   for _ in range(sequence_length):
@@ -366,6 +367,25 @@ class LSTMBlockCellTest(test.TestCase):
       for basic, fused in zip(block_wgrads, fused_wgrads):
         self.assertAllClose(basic, fused, rtol=1e-6, atol=1e-6)
 
+  def testLSTMBasicToBlockOddSizes(self):
+    # The slices of the time steps and the rows of w that multiply h are not
+    # aligned.
+    with self.test_session(use_gpu=True) as sess:
+      (basic_state, fused_state, basic_outputs, block_outputs, fused_outputs,
+       basic_grads, block_grads, fused_grads, _, _, _) = blocks_match(
+           sess,
+           use_peephole=True,
+           batch_size=3,
+           input_size=5,
+           cell_size=7,
+           sequence_length=6)
+
+      self.assertAllClose(basic_outputs, block_outputs)
+      self.assertAllClose(basic_grads, block_grads)
+      self.assertAllClose(basic_outputs, fused_outputs)
+      self.assertAllClose(basic_state, fused_state)
+      self.assertAllClose(basic_grads, fused_grads)
+
   def testLSTMFusedSequenceLengths(self):
     """Verify proper support for sequence lengths in LSTMBlockFusedCell."""
     with self.test_session(use_gpu=True) as sess:
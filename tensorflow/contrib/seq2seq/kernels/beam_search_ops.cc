@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
@@ -112,27 +113,38 @@ struct GatherTree<CPUDevice, int32> {
     const int32 max_time = parent_ids.dimension(0);
     const int32 batch_size = parent_ids.dimension(1);
     const int32 beam_width = parent_ids.dimension(2);
-    beams.setConstant(end_token);
+    // The first invalid parent id, in the order of the batch beams.
+    mutex mu;
+    int32 bad_batch_beam = batch_size * beam_width;
+    Status status;
 
-    auto DoWork = [&, ctx, end_token](int start_batch_beam,
-                                      int limit_batch_beam) {
+    auto DoWork = [&, end_token](int start_batch_beam, int limit_batch_beam) {
       for (int32 i = start_batch_beam; i < limit_batch_beam; ++i) {
         const int32 batch = i / beam_width;
         const int32 beam = i % beam_width;
-        const int32 max_seq_len_b =
-            Eigen::numext::mini(max_time, max_sequence_lengths(batch));
-        if (max_seq_len_b <= 0) {
+        const int32 max_seq_len_b = Eigen::numext::maxi(
+            0, Eigen::numext::mini(max_time, max_sequence_lengths(batch)));
+        // Each batch beam fills its own entries past its sequence length,
+        // so that the output is written in one pass.
+        for (int32 time = max_seq_len_b; time < max_time; ++time) {
+          beams(time, batch, beam) = end_token;
+        }
+        if (max_seq_len_b == 0) {
           continue;
         }
         beams(max_seq_len_b - 1, batch, beam) =
             step_ids(max_seq_len_b - 1, batch, beam);
         int32 parent = parent_ids(max_seq_len_b - 1, batch, beam);
         for (int32 level = max_seq_len_b - 2; level >= 0; --level) {
-          if (parent < 0 || parent > beam_width) {
-            ctx->SetStatus(
-                errors::InvalidArgument("Saw invalid parent id ", parent,
-                                        " at (batch, time, beam) == (", batch,
-                                        ", ", level, ", ", beam, ")"));
+          if (parent < 0 || parent >= beam_width) {
+            mutex_lock l(mu);
+            if (i < bad_batch_beam) {
+              bad_batch_beam = i;
+              status = errors::InvalidArgument(
+                  "Saw invalid parent id ", parent,
+                  " at (batch, time, beam) == (", batch, ", ", level, ", ",
+                  beam, ")");
+            }
             return;
           }
           beams(level, batch, beam) = step_ids(level, batch, parent);
@@ -160,6 +172,9 @@ struct GatherTree<CPUDevice, int32> {
     auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
     Shard(worker_threads.num_threads, worker_threads.workers,
           batch_size * beam_width, batch_beam_cost, DoWork);
+    if (!status.ok()) {
+      ctx->SetStatus(status);
+    }
   }
 };
 
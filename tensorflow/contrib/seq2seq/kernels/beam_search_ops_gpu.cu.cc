@@ -35,14 +35,19 @@ __global__ void GatherTreeOpKernel(const int32 batch_size, const int32 max_time,
     const int32 batch = i / beam_width;
     const int32 beam = i % beam_width;
 
-    const int32 max_seq_len_b =
-        Eigen::numext::mini(max_time, ldg(max_sequence_lengths + batch));
-    if (max_seq_len_b <= 0) {
-      continue;
-    }
+    const int32 max_seq_len_b = Eigen::numext::maxi(
+        0, Eigen::numext::mini(max_time, ldg(max_sequence_lengths + batch)));
 
 #define GET_IX(time_ix, beam_ix) \
   (batch_size * beam_width * (time_ix) + beam_width * batch + (beam_ix))
+    // Each batch beam fills its own entries past its sequence length, so
+    // that the output is written by a single kernel.
+    for (int32 time = max_seq_len_b; time < max_time; ++time) {
+      beams[GET_IX(time, beam)] = end_token;
+    }
+    if (max_seq_len_b == 0) {
+      continue;
+    }
     const int32 initial_beam_ix = GET_IX(max_seq_len_b - 1, beam);
     beams[initial_beam_ix] = ldg(step_ids + initial_beam_ix);
     int32 parent = ldg(parent_ids + initial_beam_ix);
@@ -50,7 +55,7 @@ __global__ void GatherTreeOpKernel(const int32 batch_size, const int32 max_time,
     for (int32 level = max_seq_len_b - 2; level >= 0; --level) {
       const int32 level_beam_ix = GET_IX(level, beam);
       const int32 level_parent_ix = GET_IX(level, parent);
-      if (parent < 0 || parent > beam_width) {
+      if (parent < 0 || parent >= beam_width) {
         beams[level_beam_ix] = -1;
         parent = -1;
         found_bad = true;
@@ -87,9 +92,6 @@ struct GatherTree<GPUDevice, T> {
     const int32 max_time = parent_ids.dimension(0);
     const int32 batch_size = parent_ids.dimension(1);
     const int32 beam_width = parent_ids.dimension(2);
-    // First kernel launch to "zero" things out
-    beams.device(d) = beams.constant(end_token);
-
     CudaLaunchConfig config = GetCudaLaunchConfig(batch_size * beam_width, d);
     // clang-format off
     GatherTreeOpKernel<T>
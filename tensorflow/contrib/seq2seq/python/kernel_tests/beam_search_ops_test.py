@@ -72,6 +72,26 @@ class GatherTreeTest(test.TestCase):
           r"parent id -1 at \(batch, time, beam\) == \(0, 0, 1\)"):
         _ = beams.eval()
 
+  def testParentValueOutOfBeamOnCPU(self):
+    # (batch_size = 1, max_time = 4, beams = 3)
+    # parent in beam 2 time 1 is past the last beam
+    end_token = 10
+    step_ids = _transpose_batch_time(
+        [[[1, 2, 3], [4, 5, 6], [7, 8, 9], [-1, -1, -1]]])
+    parent_ids = _transpose_batch_time(
+        [[[0, 0, 0], [0, 1, 3], [2, 1, 2], [-1, -1, -1]]])
+    max_sequence_lengths = [3]
+    with ops.device("/cpu:0"):
+      beams = beam_search_ops.gather_tree(
+          step_ids=step_ids,
+          parent_ids=parent_ids,
+          max_sequence_lengths=max_sequence_lengths,
+          end_token=end_token)
+    with self.test_session():
+      with self.assertRaisesOpError(
+          r"parent id 3 at \(batch, time, beam\) == \(0, 0, 2\)"):
+        _ = beams.eval()
+
   def testBadParentValuesOnGPU(self):
     # Only want to run this test on CUDA devices, as gather_tree is not
     # registered for SYCL devices.
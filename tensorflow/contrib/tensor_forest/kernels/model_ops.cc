@@ -185,7 +185,7 @@ class TreePredictionsV4Op : public OpKernel {
     DecisionTreeResource* decision_tree_resource;
     OP_REQUIRES_OK(context, LookupResource(context, HandleFromInput(context, 0),
                                            &decision_tree_resource));
-    mutex_lock l(*decision_tree_resource->get_mutex());
+    tf_shared_lock l(*decision_tree_resource->get_mutex());
     core::ScopedUnref unref_me(decision_tree_resource);
 
     const int num_data = data_set->NumItems();
@@ -286,7 +286,7 @@ class TraverseTreeV4Op : public OpKernel {
     DecisionTreeResource* decision_tree_resource;
     OP_REQUIRES_OK(context, LookupResource(context, HandleFromInput(context, 0),
                                            &decision_tree_resource));
-    mutex_lock l(*decision_tree_resource->get_mutex());
+    tf_shared_lock l(*decision_tree_resource->get_mutex());
     core::ScopedUnref unref_me(decision_tree_resource);
 
     const int num_data = data_set->NumItems();
@@ -13,6 +13,7 @@
 // limitations under the License.
 // =============================================================================
 #include "tensorflow/contrib/tensor_forest/kernels/v4/decision-tree-resource.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 
 namespace tensorflow {
 namespace tensorforest {
@@ -33,20 +34,69 @@ int32 DecisionTreeResource::TraverseTree(
   int32 current_id = 0;
   int32 depth = 0;
   while (true) {
-    const TreeNode& current = tree.nodes(current_id);
     if (path != nullptr) {
-      *path->add_nodes_visited() = current;
+      *path->add_nodes_visited() = tree.nodes(current_id);
     }
-    if (current.has_leaf()) {
-      if (leaf_depth != nullptr) {
-        *leaf_depth = depth;
+    const PackedNode& current = packed_nodes_[current_id];
+    int32 next_id;
+    switch (current.type) {
+      case PackedNode::kLeaf: {
+        if (leaf_depth != nullptr) {
+          *leaf_depth = depth;
+        }
+        return current_id;
+      }
+      case PackedNode::kLessThan: {
+        const float val =
+            input_data->GetExampleValue(example, current.feature);
+        next_id = val < current.threshold ? current.left_id : current.right_id;
+        break;
+      }
+      case PackedNode::kLessOrEqual: {
+        const float val =
+            input_data->GetExampleValue(example, current.feature);
+        next_id =
+            val <= current.threshold ? current.left_id : current.right_id;
+        break;
+      }
+      case PackedNode::kEvaluator: {
+        const int32 child_id =
+            node_evaluators_[current_id]->Decide(input_data, example);
+        next_id = tree.nodes(child_id).node_id().value();
+        break;
       }
-      return current_id;
     }
     ++depth;
-    const int32 next_id =
-        node_evaluators_[current_id]->Decide(input_data, example);
-    current_id = tree.nodes(next_id).node_id().value();
+    current_id = next_id;
+  }
+}
+
+void DecisionTreeResource::PackNode(int32 node_id) {
+  const DecisionTree& tree = decision_tree_->decision_tree();
+  if (packed_nodes_.size() < tree.nodes_size()) {
+    packed_nodes_.resize(tree.nodes_size());
+  }
+  const TreeNode& node = tree.nodes(node_id);
+  PackedNode* packed = &packed_nodes_[node_id];
+  *packed = PackedNode();
+  if (node.has_leaf()) {
+    return;
+  }
+  const decision_trees::BinaryNode& bnode = node.binary_node();
+  packed->left_id = tree.nodes(bnode.left_child_id().value()).node_id().value();
+  packed->right_id =
+      tree.nodes(bnode.right_child_id().value()).node_id().value();
+  packed->type = PackedNode::kEvaluator;
+  if (bnode.has_inequality_left_child_test()) {
+    const auto& test = bnode.inequality_left_child_test();
+    if (!test.has_oblique() &&
+        safe_strto32(test.feature_id().id().value(), &packed->feature)) {
+      packed->type =
+          test.type() == decision_trees::InequalityTest::LESS_OR_EQUAL
+              ? PackedNode::kLessOrEqual
+              : PackedNode::kLessThan;
+      packed->threshold = test.threshold().float_value();
+    }
   }
 }
 
@@ -78,12 +128,16 @@ void DecisionTreeResource::SplitNode(int32 node_id, SplitCandidate* best,
     node_evaluators_.emplace_back(nullptr);
   }
   node_evaluators_[node_id] = CreateDecisionNodeEvaluator(*node);
+  PackNode(node_id);
+  PackNode(newid - 1);
+  PackNode(newid);
 }
 
 void DecisionTreeResource::MaybeInitialize() {
   DecisionTree* tree = decision_tree_->mutable_decision_tree();
   if (tree->nodes_size() == 0) {
     model_op_->InitModel(tree->add_nodes()->mutable_leaf());
+    PackNode(0);
   } else if (node_evaluators_.empty()) {  // reconstruct evaluators
     for (const auto& node : tree->nodes()) {
       if (node.has_leaf()) {
@@ -92,6 +146,9 @@ void DecisionTreeResource::MaybeInitialize() {
         node_evaluators_.push_back(CreateDecisionNodeEvaluator(node));
       }
     }
+    for (int32 i = 0; i < tree->nodes_size(); ++i) {
+      PackNode(i);
+    }
   }
 }
 
@@ -61,6 +61,8 @@ class DecisionTreeResource : public ResourceBase {
   // Caller needs to hold the mutex lock while calling this.
   void Reset() {
     decision_tree_.reset(new decision_trees::Model());
+    node_evaluators_.clear();
+    packed_nodes_.clear();
   }
 
   mutex* get_mutex() { return &mu_; }
@@ -77,11 +79,27 @@ class DecisionTreeResource : public ResourceBase {
                  std::vector<int32>* new_children);
 
  private:
+  // A node of the tree packed for traversal. The inequality tests on a single
+  // feature are decided inline, the other tests by the evaluator of the node.
+  struct PackedNode {
+    enum Type { kLeaf, kLessThan, kLessOrEqual, kEvaluator };
+    Type type = kLeaf;
+    int32 feature = 0;
+    float threshold = 0;
+    // The node ids of the children.
+    int32 left_id = 0;
+    int32 right_id = 0;
+  };
+
+  // Packs the node at node_id, whose children must already be in the tree.
+  void PackNode(int32 node_id);
+
   mutex mu_;
   const TensorForestParams params_;
   std::unique_ptr<decision_trees::Model> decision_tree_;
   std::shared_ptr<LeafModelOperator> model_op_;
   std::vector<std::unique_ptr<DecisionNodeEvaluator>> node_evaluators_;
+  std::vector<PackedNode> packed_nodes_;
 };
 
 
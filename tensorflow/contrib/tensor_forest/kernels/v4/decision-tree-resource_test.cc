@@ -0,0 +1,141 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/tensor_forest/kernels/v4/decision-tree-resource.h"
+#include "tensorflow/contrib/decision_trees/proto/generic_tree_model.pb.h"
+#include "tensorflow/contrib/decision_trees/proto/generic_tree_model_extensions.pb.h"
+#include "tensorflow/contrib/tensor_forest/kernels/v4/test_utils.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+using tensorflow::decision_trees::BinaryNode;
+using tensorflow::decision_trees::InequalityTest;
+using tensorflow::decision_trees::MatchingValuesTest;
+using tensorflow::decision_trees::TreeNode;
+using tensorflow::tensorforest::DecisionTreeResource;
+using tensorflow::tensorforest::SplitCandidate;
+using tensorflow::tensorforest::TensorDataSet;
+using tensorflow::tensorforest::TensorForestParams;
+using tensorflow::tensorforest::TestableDataSet;
+using tensorflow::tensorforest::TreePath;
+
+void SetInequalityTest(int32 feature, float threshold,
+                       InequalityTest::Type type, BinaryNode* bnode) {
+  InequalityTest* test = bnode->mutable_inequality_left_child_test();
+  test->mutable_feature_id()->mutable_id()->set_value(
+      strings::StrCat(feature));
+  test->mutable_threshold()->set_float_value(threshold);
+  test->set_type(type);
+}
+
+void SetChildren(int32 left, int32 right, BinaryNode* bnode) {
+  bnode->mutable_left_child_id()->set_value(left);
+  bnode->mutable_right_child_id()->set_value(right);
+}
+
+class DecisionTreeResourceTest : public ::testing::Test {
+ protected:
+  DecisionTreeResourceTest() {
+    params_.set_leaf_type(tensorforest::MODEL_REGRESSION);
+    params_.set_num_outputs(1);
+  }
+
+  TensorForestParams params_;
+};
+
+TEST_F(DecisionTreeResourceTest, TraverseMixedSplits) {
+  // 0: f[0] <= 3 ? 1 : 2
+  // 2: f[1] in {5} ? 3 : 4
+  // 4: f[1] < 7 ? 5 : 6
+  DecisionTreeResource* resource = new DecisionTreeResource(params_);
+  core::ScopedUnref unref_me(resource);
+  auto* tree = resource->mutable_decision_tree()->mutable_decision_tree();
+  for (int32 i = 0; i < 7; ++i) {
+    tree->add_nodes()->mutable_node_id()->set_value(i);
+  }
+  BinaryNode* root = tree->mutable_nodes(0)->mutable_binary_node();
+  SetInequalityTest(0, 3.0, InequalityTest::LESS_OR_EQUAL, root);
+  SetChildren(1, 2, root);
+  BinaryNode* matching = tree->mutable_nodes(2)->mutable_binary_node();
+  MatchingValuesTest matching_test;
+  matching_test.mutable_feature_id()->mutable_id()->set_value("1");
+  matching_test.add_value()->set_float_value(5.0);
+  matching->mutable_custom_left_child_test()->PackFrom(matching_test);
+  SetChildren(3, 4, matching);
+  BinaryNode* strict = tree->mutable_nodes(4)->mutable_binary_node();
+  SetInequalityTest(1, 7.0, InequalityTest::LESS_THAN, strict);
+  SetChildren(5, 6, strict);
+  for (const int32 leaf : {1, 3, 5, 6}) {
+    tree->mutable_nodes(leaf)->mutable_leaf();
+  }
+  resource->MaybeInitialize();
+
+  std::unique_ptr<TensorDataSet> dataset(new TestableDataSet(
+      {3.0, 0.0, 4.0, 5.0, 4.0, 6.0, 4.0, 7.0}, 2));
+  const std::vector<int32> expected_leaves = {1, 3, 5, 6};
+  const std::vector<int32> expected_depths = {1, 2, 3, 3};
+  for (int example = 0; example < 4; ++example) {
+    int32 depth = -1;
+    TreePath path;
+    EXPECT_EQ(expected_leaves[example],
+              resource->TraverseTree(dataset, example, &depth, &path));
+    EXPECT_EQ(expected_depths[example], depth);
+    EXPECT_EQ(depth + 1, path.nodes_visited_size());
+    EXPECT_EQ(expected_leaves[example],
+              path.nodes_visited(depth).node_id().value());
+  }
+}
+
+TEST_F(DecisionTreeResourceTest, TraverseAfterSplitNode) {
+  DecisionTreeResource* resource = new DecisionTreeResource(params_);
+  core::ScopedUnref unref_me(resource);
+  resource->MaybeInitialize();
+  std::unique_ptr<TensorDataSet> dataset(
+      new TestableDataSet({1.0, 2.0, 3.0}, 1));
+  EXPECT_EQ(0, resource->TraverseTree(dataset, 2, nullptr, nullptr));
+
+  SplitCandidate candidate;
+  for (auto* stats :
+       {candidate.mutable_left_stats(), candidate.mutable_right_stats()}) {
+    stats->set_weight_sum(1);
+    stats->mutable_regression()->mutable_mean_output()->add_value();
+  }
+  SetInequalityTest(0, 2.0, InequalityTest::LESS_OR_EQUAL,
+                    candidate.mutable_split());
+  std::vector<int32> new_children;
+  resource->SplitNode(0, &candidate, &new_children);
+  ASSERT_EQ(2, new_children.size());
+  EXPECT_EQ(new_children[0],
+            resource->TraverseTree(dataset, 1, nullptr, nullptr));
+  EXPECT_EQ(new_children[1],
+            resource->TraverseTree(dataset, 2, nullptr, nullptr));
+
+  // Resetting and reloading the tree rebuilds its layout.
+  decision_trees::Model model = resource->decision_tree();
+  resource->Reset();
+  *resource->mutable_decision_tree() = model;
+  resource->MaybeInitialize();
+  EXPECT_EQ(new_children[0],
+            resource->TraverseTree(dataset, 0, nullptr, nullptr));
+  EXPECT_EQ(new_children[1],
+            resource->TraverseTree(dataset, 2, nullptr, nullptr));
+}
+
+}  // namespace
+}  // namespace tensorflow
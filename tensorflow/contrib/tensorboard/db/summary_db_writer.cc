@@ -14,10 +14,16 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/contrib/tensorboard/db/summary_db_writer.h"
 
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
 #include "tensorflow/contrib/tensorboard/db/schema.h"
 #include "tensorflow/core/lib/db/sqlite.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/snappy.h"
 
 namespace tensorflow {
@@ -33,13 +39,43 @@ int64 MakeRandomId() {
 
 class SummaryDbWriter : public SummaryWriterInterface {
  public:
-  SummaryDbWriter(Env* env, std::shared_ptr<Sqlite> db)
-      : SummaryWriterInterface(), env_(env), db_(std::move(db)), run_id_(-1) {}
-  ~SummaryDbWriter() override {}
+  SummaryDbWriter(Env* env, std::shared_ptr<Sqlite> db, int max_queue,
+                  int flush_millis)
+      : SummaryWriterInterface(),
+        env_(env),
+        max_queue_(std::max(max_queue, 1)),
+        flush_millis_(flush_millis),
+        db_(std::move(db)),
+        run_id_(-1) {}
+
+  ~SummaryDbWriter() override {
+    if (thread_ != nullptr) {
+      {
+        mutex_lock ml(mu_);
+        stopping_ = true;
+        queue_cv_.notify_one();
+      }
+      // The background thread commits the remaining tensors before it exits.
+      thread_.reset();
+      mutex_lock ml(mu_);
+      if (!status_.ok()) {
+        LOG(ERROR) << "SummaryDbWriter: " << status_;
+      }
+    }
+  }
 
   Status Initialize(const string& experiment_name, const string& run_name,
                     const string& user_name) {
-    mutex_lock ml(mu_);
+    // Readers of the database no longer block the writer, and the commits
+    // of the periodic transactions below do not wait for an fsync.
+    SqliteStatement journal_mode = db_->Prepare("PRAGMA journal_mode=WAL");
+    bool is_done;
+    TF_RETURN_IF_ERROR(journal_mode.Step(&is_done));
+    SqliteStatement synchronous = db_->Prepare("PRAGMA synchronous=NORMAL");
+    TF_RETURN_IF_ERROR(synchronous.StepAndReset());
+    begin_ = db_->Prepare("BEGIN IMMEDIATE");
+    commit_ = db_->Prepare("COMMIT");
+    rollback_ = db_->Prepare("ROLLBACK");
     insert_tensor_ = db_->Prepare(R"sql(
       INSERT OR REPLACE INTO Tensors (tag_id, step, computed_time, tensor)
       VALUES (?, ?, ?, ?)
@@ -47,46 +83,43 @@ class SummaryDbWriter : public SummaryWriterInterface {
     update_metadata_ = db_->Prepare(R"sql(
       UPDATE Tags SET metadata = ? WHERE tag_id = ?
     )sql");
+    for (const SqliteStatement* stmt : {&begin_, &commit_, &rollback_,
+                                        &insert_tensor_, &update_metadata_}) {
+      TF_RETURN_IF_ERROR(stmt->status());
+    }
     experiment_name_ = experiment_name;
     run_name_ = run_name;
     user_name_ = user_name;
+    thread_.reset(env_->StartThread(ThreadOptions(), "summary_db_writer",
+                                    [this] { WriteQueuedTensors(); }));
     return Status::OK();
   }
 
-  // TODO(@jart): Use transactions that COMMIT on Flush()
   // TODO(@jart): Retry Commit() on SQLITE_BUSY with exponential back-off.
-  Status Flush() override { return Status::OK(); }
+  Status Flush() override {
+    mutex_lock ml(mu_);
+    const int64 request = ++flush_requests_;
+    queue_cv_.notify_one();
+    while (flushes_done_ < request) {
+      done_cv_.wait(ml);
+    }
+    Status s = status_;
+    status_ = Status::OK();
+    return s;
+  }
 
   Status WriteTensor(int64 global_step, Tensor t, const string& tag,
                      const string& serialized_metadata) override {
+    PendingTensor p{global_step, GetWallTime(), tag, serialized_metadata,
+                    std::move(t)};
     mutex_lock ml(mu_);
-    TF_RETURN_IF_ERROR(InitializeParents());
-    // TODO(@jart): Memoize tag_id.
-    int64 tag_id;
-    TF_RETURN_IF_ERROR(GetTagId(run_id_, tag, &tag_id));
-    if (!serialized_metadata.empty()) {
-      // TODO(@jart): Only update metadata for first tensor.
-      update_metadata_.BindBlobUnsafe(1, serialized_metadata);
-      update_metadata_.BindInt(2, tag_id);
-      TF_RETURN_IF_ERROR(update_metadata_.StepAndReset());
+    while (queue_.size() >= max_queue_) {
+      done_cv_.wait(ml);
     }
-    // TODO(@jart): Lease blocks of rowids and *_ids to minimize fragmentation.
-    // TODO(@jart): Check for random ID collisions without needing txn retry.
-    insert_tensor_.BindInt(1, tag_id);
-    insert_tensor_.BindInt(2, global_step);
-    insert_tensor_.BindDouble(3, GetWallTime());
-    switch (t.dtype()) {
-      case DT_INT64:
-        insert_tensor_.BindInt(4, t.scalar<int64>()());
-        break;
-      case DT_DOUBLE:
-        insert_tensor_.BindDouble(4, t.scalar<double>()());
-        break;
-      default:
-        TF_RETURN_IF_ERROR(BindTensor(t));
-        break;
+    queue_.push_back(std::move(p));
+    if (queue_.size() == 1 || queue_.size() >= max_queue_) {
+      queue_cv_.notify_one();
     }
-    TF_RETURN_IF_ERROR(insert_tensor_.StepAndReset());
     return Status::OK();
   }
 
@@ -128,13 +161,113 @@ class SummaryDbWriter : public SummaryWriterInterface {
   string DebugString() override { return "SummaryDbWriter"; }
 
  private:
+  // A tensor that waits to be inserted by the background thread.
+  struct PendingTensor {
+    int64 step;
+    double computed_time;
+    string tag;
+    string serialized_metadata;
+    Tensor tensor;
+  };
+
   double GetWallTime() {
     // TODO(@jart): Follow precise definitions for time laid out in schema.
     // TODO(@jart): Use monotonic clock from gRPC codebase.
     return static_cast<double>(env_->NowMicros()) / 1.0e6;
   }
 
-  Status BindTensor(const Tensor& t) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  // The loop of the background thread. A batch of queued tensors is inserted
+  // in a single transaction once max_queue_ of them are queued, flush_millis_
+  // after the first of them was queued, or when Flush() is called.
+  void WriteQueuedTensors() {
+    std::vector<PendingTensor> batch;
+    for (;;) {
+      int64 request;
+      bool stopping;
+      {
+        mutex_lock ml(mu_);
+        while (!stopping_ && flush_requests_ == flushes_done_ &&
+               queue_.size() < max_queue_) {
+          if (queue_.empty()) {
+            queue_cv_.wait(ml);
+          } else if (WaitForMilliseconds(&ml, &queue_cv_, flush_millis_) ==
+                     kCond_Timeout) {
+            break;
+          }
+        }
+        batch.swap(queue_);
+        request = flush_requests_;
+        stopping = stopping_;
+        done_cv_.notify_all();
+      }
+      const Status s = batch.empty() ? Status::OK() : InsertTensors(batch);
+      batch.clear();
+      {
+        mutex_lock ml(mu_);
+        status_.Update(s);
+        flushes_done_ = request;
+        done_cv_.notify_all();
+      }
+      if (stopping) {
+        return;
+      }
+    }
+  }
+
+  // Inserts 'batch' in a single transaction, reusing the prepared statements.
+  Status InsertTensors(const std::vector<PendingTensor>& batch) {
+    Status s = begin_.StepAndReset();
+    for (const PendingTensor& p : batch) {
+      if (!s.ok()) {
+        break;
+      }
+      s = InsertTensor(p);
+    }
+    if (s.ok()) {
+      s = commit_.StepAndReset();
+    }
+    if (!s.ok()) {
+      // Nothing of the batch was written, including the ids created for it.
+      rollback_.StepAndReset().IgnoreError();
+      run_id_ = -1;
+      tag_ids_.clear();
+    }
+    return s;
+  }
+
+  Status InsertTensor(const PendingTensor& p) {
+    TF_RETURN_IF_ERROR(InitializeParents(p.computed_time));
+    int64 tag_id;
+    TF_RETURN_IF_ERROR(GetTagId(p.tag, p.computed_time, &tag_id));
+    if (!p.serialized_metadata.empty()) {
+      // TODO(@jart): Only update metadata for first tensor.
+      update_metadata_.BindBlobUnsafe(1, p.serialized_metadata);
+      update_metadata_.BindInt(2, tag_id);
+      TF_RETURN_IF_ERROR(update_metadata_.StepAndReset());
+    }
+    // TODO(@jart): Lease blocks of rowids and *_ids to minimize fragmentation.
+    // TODO(@jart): Check for random ID collisions without needing txn retry.
+    insert_tensor_.BindInt(1, tag_id);
+    insert_tensor_.BindInt(2, p.step);
+    insert_tensor_.BindDouble(3, p.computed_time);
+    string compressed;
+    switch (p.tensor.dtype()) {
+      case DT_INT64:
+        insert_tensor_.BindInt(4, p.tensor.scalar<int64>()());
+        break;
+      case DT_DOUBLE:
+        insert_tensor_.BindDouble(4, p.tensor.scalar<double>()());
+        break;
+      default:
+        TF_RETURN_IF_ERROR(BindTensor(p.tensor, &compressed));
+        break;
+    }
+    return insert_tensor_.StepAndReset();
+  }
+
+  // Binds 't' to the tensor column of insert_tensor_. 'compressed' holds the
+  // bound bytes, and must outlive the execution of the statement.
+  Status BindTensor(const Tensor& t, string* compressed) {
     // TODO(@jart): Make portable between little and big endian systems.
     // TODO(@jart): Use TensorChunks with minimal copying for big tensors.
     TensorProto p;
@@ -145,29 +278,27 @@ class SummaryDbWriter : public SummaryWriterInterface {
     }
     // TODO(@jart): Put byte at beginning of blob to indicate encoding.
     // TODO(@jart): Allow crunch tool to re-compress with zlib instead.
-    string compressed;
-    if (!port::Snappy_Compress(encoded.data(), encoded.size(), &compressed)) {
+    if (!port::Snappy_Compress(encoded.data(), encoded.size(), compressed)) {
       return errors::FailedPrecondition("TensorBase needs Snappy");
     }
-    insert_tensor_.BindBlobUnsafe(4, compressed);
+    insert_tensor_.BindBlobUnsafe(4, *compressed);
     return Status::OK();
   }
 
-  Status InitializeParents() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  Status InitializeParents(double now) {
     if (run_id_ >= 0) {
       return Status::OK();
     }
     int64 user_id;
-    TF_RETURN_IF_ERROR(GetUserId(user_name_, &user_id));
+    TF_RETURN_IF_ERROR(GetUserId(user_name_, now, &user_id));
     int64 experiment_id;
     TF_RETURN_IF_ERROR(
-        GetExperimentId(user_id, experiment_name_, &experiment_id));
-    TF_RETURN_IF_ERROR(GetRunId(experiment_id, run_name_, &run_id_));
+        GetExperimentId(user_id, experiment_name_, now, &experiment_id));
+    TF_RETURN_IF_ERROR(GetRunId(experiment_id, run_name_, now, &run_id_));
     return Status::OK();
   }
 
-  Status GetUserId(const string& user_name, int64* user_id)
-      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  Status GetUserId(const string& user_name, double now, int64* user_id) {
     if (user_name.empty()) {
       *user_id = 0LL;
       return Status::OK();
@@ -187,35 +318,41 @@ class SummaryDbWriter : public SummaryWriterInterface {
       )sql");
       insert_user.BindInt(1, *user_id);
       insert_user.BindText(2, user_name);
-      insert_user.BindDouble(3, GetWallTime());
+      insert_user.BindDouble(3, now);
       TF_RETURN_IF_ERROR(insert_user.StepAndReset());
     }
     return Status::OK();
   }
 
   Status GetExperimentId(int64 user_id, const string& experiment_name,
-                         int64* experiment_id) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+                         double now, int64* experiment_id) {
     // TODO(@jart): Compute started_time.
     return GetId("Experiments", "user_id", user_id, "experiment_name",
-                 experiment_name, "experiment_id", experiment_id);
+                 experiment_name, "experiment_id", now, experiment_id);
   }
 
-  Status GetRunId(int64 experiment_id, const string& run_name, int64* run_id)
-      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  Status GetRunId(int64 experiment_id, const string& run_name, double now,
+                  int64* run_id) {
     // TODO(@jart): Compute started_time.
     return GetId("Runs", "experiment_id", experiment_id, "run_name", run_name,
-                 "run_id", run_id);
+                 "run_id", now, run_id);
   }
 
-  Status GetTagId(int64 run_id, const string& tag_name, int64* tag_id)
-      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    return GetId("Tags", "run_id", run_id, "tag_name", tag_name, "tag_id",
-                 tag_id);
+  Status GetTagId(const string& tag_name, double now, int64* tag_id) {
+    auto it = tag_ids_.find(tag_name);
+    if (it != tag_ids_.end()) {
+      *tag_id = it->second;
+      return Status::OK();
+    }
+    TF_RETURN_IF_ERROR(GetId("Tags", "run_id", run_id_, "tag_name", tag_name,
+                             "tag_id", now, tag_id));
+    tag_ids_[tag_name] = *tag_id;
+    return Status::OK();
   }
 
   Status GetId(const char* table, const char* parent_id_field, int64 parent_id,
                const char* name_field, const string& name, const char* id_field,
-               int64* id) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+               double now, int64* id) {
     if (name.empty()) {
       *id = 0LL;
       return Status::OK();
@@ -241,21 +378,47 @@ class SummaryDbWriter : public SummaryWriterInterface {
       }
       insert.BindInt(2, *id);
       insert.BindText(3, name);
-      insert.BindDouble(4, GetWallTime());
+      insert.BindDouble(4, now);
       TF_RETURN_IF_ERROR(insert.StepAndReset());
     }
     return Status::OK();
   }
 
-  mutex mu_;
   Env* env_;
-  std::shared_ptr<Sqlite> db_ GUARDED_BY(mu_);
-  SqliteStatement insert_tensor_ GUARDED_BY(mu_);
-  SqliteStatement update_metadata_ GUARDED_BY(mu_);
-  string user_name_ GUARDED_BY(mu_);
-  string experiment_name_ GUARDED_BY(mu_);
-  string run_name_ GUARDED_BY(mu_);
-  int64 run_id_ GUARDED_BY(mu_);
+  const size_t max_queue_;
+  const int flush_millis_;
+
+  mutex mu_;
+  // Notified when tensors are queued, a flush is requested, or the writer is
+  // destroyed.
+  condition_variable queue_cv_;
+  // Notified when queued tensors are taken for inserting, or a flush
+  // completes.
+  condition_variable done_cv_;
+  std::vector<PendingTensor> queue_ GUARDED_BY(mu_);
+  // The number of calls to Flush(), and the number of them that the
+  // background thread has completed.
+  int64 flush_requests_ GUARDED_BY(mu_) = 0;
+  int64 flushes_done_ GUARDED_BY(mu_) = 0;
+  // The first error of the background thread since the last Flush().
+  Status status_ GUARDED_BY(mu_);
+  bool stopping_ GUARDED_BY(mu_) = false;
+
+  // The database state below is only used by Initialize(), and then by the
+  // background thread.
+  std::shared_ptr<Sqlite> db_;
+  SqliteStatement begin_;
+  SqliteStatement commit_;
+  SqliteStatement rollback_;
+  SqliteStatement insert_tensor_;
+  SqliteStatement update_metadata_;
+  string user_name_;
+  string experiment_name_;
+  string run_name_;
+  int64 run_id_;
+  std::unordered_map<string, int64> tag_ids_;
+
+  std::unique_ptr<Thread> thread_;
 };
 
 }  // namespace
@@ -263,9 +426,11 @@ class SummaryDbWriter : public SummaryWriterInterface {
 Status CreateSummaryDbWriter(std::shared_ptr<Sqlite> db,
                              const string& experiment_name,
                              const string& run_name, const string& user_name,
-                             Env* env, SummaryWriterInterface** result) {
+                             int max_queue, int flush_millis, Env* env,
+                             SummaryWriterInterface** result) {
   TF_RETURN_IF_ERROR(SetupTensorboardSqliteDb(db));
-  SummaryDbWriter* w = new SummaryDbWriter(env, std::move(db));
+  SummaryDbWriter* w =
+      new SummaryDbWriter(env, std::move(db), max_queue, flush_millis);
   const Status s = w->Initialize(experiment_name, run_name, user_name);
   if (!s.ok()) {
     w->Unref();
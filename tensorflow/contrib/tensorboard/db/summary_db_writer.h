@@ -30,12 +30,20 @@ namespace tensorflow {
 /// if necessary. Entries in the Users, Experiments, and Runs tables
 /// will be created automatically if they don't already exist.
 ///
+/// The tensors are queued, and inserted by a background thread in a
+/// single transaction per batch: once `max_queue` of them are queued, at
+/// most `flush_millis` milliseconds after the first of them was queued,
+/// and on Flush(). The database is switched to write-ahead logging
+/// (`PRAGMA journal_mode=WAL`) with `PRAGMA synchronous=NORMAL`. Errors
+/// of the background thread are returned by the next Flush().
+///
 /// Please note that the type signature of this function may change in
 /// the future if support for other DBs is added to core.
 Status CreateSummaryDbWriter(std::shared_ptr<Sqlite> db,
                              const string& experiment_name,
                              const string& run_name, const string& user_name,
-                             Env* env, SummaryWriterInterface** result);
+                             int max_queue, int flush_millis, Env* env,
+                             SummaryWriterInterface** result);
 
 }  // namespace tensorflow
 
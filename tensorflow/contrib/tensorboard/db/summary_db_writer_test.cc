@@ -22,6 +22,10 @@ limitations under the License.
 namespace tensorflow {
 namespace {
 
+const int kMaxQueue = 10;
+// Long enough for the tests not to see a batch that was not flushed.
+const int kFlushMillis = 24 * 3600 * 1000;
+
 Tensor MakeScalarInt64(int64 x) {
   Tensor t(DT_INT64, TensorShape({}));
   t.scalar<int64>()() = x;
@@ -89,8 +93,8 @@ class SummaryDbWriterTest : public ::testing::Test {
 };
 
 TEST_F(SummaryDbWriterTest, NothingWritten_NoRowsCreated) {
-  TF_ASSERT_OK(CreateSummaryDbWriter(db_, "mad-science", "train", "jart", &env_,
-                                     &writer_));
+  TF_ASSERT_OK(CreateSummaryDbWriter(db_, "mad-science", "train", "jart",
+                                     kMaxQueue, kFlushMillis, &env_, &writer_));
   TF_ASSERT_OK(writer_->Flush());
   writer_->Unref();
   writer_ = nullptr;
@@ -102,8 +106,8 @@ TEST_F(SummaryDbWriterTest, NothingWritten_NoRowsCreated) {
 }
 
 TEST_F(SummaryDbWriterTest, TensorsWritten_RowsGetInitialized) {
-  TF_ASSERT_OK(CreateSummaryDbWriter(db_, "mad-science", "train", "jart", &env_,
-                                     &writer_));
+  TF_ASSERT_OK(CreateSummaryDbWriter(db_, "mad-science", "train", "jart",
+                                     kMaxQueue, kFlushMillis, &env_, &writer_));
   env_.AdvanceByMillis(23);
   TF_ASSERT_OK(writer_->WriteTensor(1, MakeScalarInt64(123LL), "taggy",
                                     "this-is-metaaa"));
@@ -158,5 +162,37 @@ TEST_F(SummaryDbWriterTest, TensorsWritten_RowsGetInitialized) {
       QueryString("SELECT tensor FROM Tensors WHERE step = 2").empty());
 }
 
+TEST_F(SummaryDbWriterTest, TensorsQueued_InsertedOnFlush) {
+  TF_ASSERT_OK(CreateSummaryDbWriter(db_, "mad-science", "train", "jart",
+                                     kMaxQueue, kFlushMillis, &env_, &writer_));
+  TF_ASSERT_OK(writer_->WriteTensor(1, MakeScalarInt64(1LL), "a", ""));
+  TF_ASSERT_OK(writer_->WriteTensor(1, MakeScalarInt64(2LL), "b", ""));
+  TF_ASSERT_OK(writer_->WriteTensor(2, MakeScalarInt64(3LL), "a", ""));
+  EXPECT_EQ(0LL, QueryInt("SELECT COUNT(*) FROM Tensors"));
+  TF_ASSERT_OK(writer_->Flush());
+  EXPECT_EQ(1LL, QueryInt("SELECT COUNT(*) FROM Runs"));
+  EXPECT_EQ(2LL, QueryInt("SELECT COUNT(*) FROM Tags"));
+  EXPECT_EQ(3LL, QueryInt("SELECT COUNT(*) FROM Tensors"));
+  EXPECT_EQ(3LL, QueryInt(R"sql(
+    SELECT Tensors.tensor FROM Tensors JOIN Tags USING (tag_id)
+    WHERE Tags.tag_name = 'a' AND Tensors.step = 2
+  )sql"));
+}
+
+TEST_F(SummaryDbWriterTest, QueueFull_InsertedWithoutFlush) {
+  TF_ASSERT_OK(CreateSummaryDbWriter(db_, "mad-science", "train", "jart", 2,
+                                     kFlushMillis, &env_, &writer_));
+  // The writes that do not fit in the queue wait for the batches before them.
+  for (int64 step = 0; step < 5; ++step) {
+    TF_ASSERT_OK(writer_->WriteTensor(step, MakeScalarInt64(step), "a", ""));
+  }
+  EXPECT_LE(2LL, QueryInt("SELECT COUNT(*) FROM Tensors"));
+  writer_->Unref();
+  writer_ = nullptr;
+  // The remaining tensors are inserted when the writer is destroyed.
+  EXPECT_EQ(5LL, QueryInt("SELECT COUNT(*) FROM Tensors"));
+  EXPECT_EQ(1LL, QueryInt("SELECT COUNT(*) FROM Tags"));
+}
+
 }  // namespace
 }  // namespace tensorflow
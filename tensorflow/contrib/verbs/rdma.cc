@@ -16,12 +16,17 @@ limitations under the License.
 #ifdef TENSORFLOW_USE_VERBS
 
 #include "tensorflow/contrib/verbs/rdma.h"
+#include <algorithm>
 #include <cstdlib>
+#include <fstream>
+#include <set>
 #include "tensorflow/contrib/verbs/verbs_util.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 #include "tensorflow/core/common_runtime/gpu/process_state.h"
+#include "tensorflow/core/common_runtime/visitable_allocator.h"
 #include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
 #include "tensorflow/core/distributed_runtime/session_mgr.h"
 #include "tensorflow/core/framework/rendezvous.h"
@@ -30,6 +35,8 @@ limitations under the License.
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -64,8 +71,78 @@ string MessageTypeToString(RdmaMessageType rmt) {
       return "UNKNOWN MESSAGE";
   }
 }
+
+// Whether the kernel module that lets the adapter access GPU memory is
+// loaded.
+bool IsGPUDirectAvailable() {
+  std::ifstream ifs("/proc/modules");
+  string line;
+  while (std::getline(ifs, line)) {
+    if (line.substr(0, line.find(' ')) == "nv_peer_mem") {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns the NUMA node of the adapter, which is 0 if it is not known.
+int NumaNode(ibv_context* context) {
+  std::ifstream ifs(string(context->device->ibdev_path) + "/device/numa_node");
+  string content;
+  int32 value;
+  if (std::getline(ifs, content) &&
+      strings::safe_strto32(content, &value) && value >= 0) {
+    return value;
+  }
+  return 0;
+}
 }  // namespace
 
+ibv_mr* RdmaMemoryMgr::FindMemoryRegion(const void* addr, size_t length) {
+  if (length == 0) return nullptr;
+  mutex_lock l(mu_);
+  auto iter = std::upper_bound(mrs_.begin(), mrs_.end(), addr, &Comparator);
+  if (iter == mrs_.end() || (*iter)->addr > addr ||
+      static_cast<const char*>(addr) + length >
+          static_cast<const char*>((*iter)->addr) + (*iter)->length) {
+    return nullptr;
+  }
+  return *iter;
+}
+
+void RdmaMemoryMgr::InsertMemoryRegion(void* addr, size_t length) {
+  if (length == 0) return;
+  mutex_lock l(mu_);
+  if (pd_ == nullptr) return;
+  ibv_mr* mr = ibv_reg_mr(pd_, addr, length, IBV_ACCESS_LOCAL_WRITE);
+  if (mr == nullptr) {
+    LOG(WARNING) << "Failed to register memory region of " << length
+                 << " bytes";
+    return;
+  }
+  auto iter = std::upper_bound(mrs_.begin(), mrs_.end(), addr, &Comparator);
+  mrs_.insert(iter, mr);
+}
+
+void RdmaMemoryMgr::EvictMemoryRegion(void* addr, size_t length) {
+  if (length == 0) return;
+  mutex_lock l(mu_);
+  auto iter = std::upper_bound(mrs_.begin(), mrs_.end(), addr, &Comparator);
+  if (iter != mrs_.end() && (*iter)->addr == addr) {
+    CHECK(!ibv_dereg_mr(*iter)) << "ibv_dereg_mr failed";
+    mrs_.erase(iter);
+  }
+}
+
+void RdmaMemoryMgr::Stop() {
+  mutex_lock l(mu_);
+  for (ibv_mr* mr : mrs_) {
+    CHECK(!ibv_dereg_mr(mr)) << "ibv_dereg_mr failed";
+  }
+  mrs_.clear();
+  pd_ = nullptr;
+}
+
 ibv_context* open_default_device() {
   ibv_device** dev_list;
   ibv_device* ib_dev;
@@ -87,6 +164,7 @@ ibv_pd* alloc_protection_domain(ibv_context* context) {
 RdmaAdapter::RdmaAdapter(const WorkerEnv* worker_env)
     : context_(open_default_device()),
       pd_(alloc_protection_domain(context_)),
+      memory_mgr_(std::make_shared<RdmaMemoryMgr>(pd_)),
       worker_env_(worker_env) {
   event_channel_ = ibv_create_comp_channel(context_);
   CHECK(event_channel_) << "Failed to create completion channel";
@@ -94,6 +172,52 @@ RdmaAdapter::RdmaAdapter(const WorkerEnv* worker_env)
                       0);
   CHECK(cq_) << "Failed to create completion queue";
   CHECK(!ibv_req_notify_cq(cq_, 0)) << "Failed to request CQ notification";
+  // The visitors share the ownership of the registration cache, since the
+  // allocators can outlive the adapter.
+  std::shared_ptr<RdmaMemoryMgr> memory_mgr = memory_mgr_;
+  VisitableAllocator::Visitor alloc_visitor = [memory_mgr](void* ptr,
+                                                           size_t size) {
+    memory_mgr->InsertMemoryRegion(ptr, size);
+  };
+  VisitableAllocator::Visitor free_visitor = [memory_mgr](void* ptr,
+                                                          size_t size) {
+    memory_mgr->EvictMemoryRegion(ptr, size);
+  };
+  Allocator* allocators[] = {
+#if GOOGLE_CUDA
+    ProcessState::singleton()->GetCUDAHostAllocator(0),
+#endif  // GOOGLE_CUDA
+    ProcessState::singleton()->GetCPUAllocator(0),
+    cpu_allocator(),
+  };
+  std::set<Allocator*> instrumented;
+  for (Allocator* allocator : allocators) {
+    auto* visitable_allocator = dynamic_cast<VisitableAllocator*>(allocator);
+    if (visitable_allocator == nullptr ||
+        !instrumented.insert(allocator).second) {
+      continue;
+    }
+    visitable_allocator->AddAllocVisitor(alloc_visitor);
+    visitable_allocator->AddFreeVisitor(free_visitor);
+    VLOG(2) << "Registering the memory of allocator " << allocator->Name();
+  }
+#if GOOGLE_CUDA
+  bool use_gpu_direct;
+  TF_CHECK_OK(
+      ReadBoolFromEnvVar("TF_VERBS_GPU_DIRECT", false, &use_gpu_direct));
+  if (use_gpu_direct) {
+    if (IsGPUDirectAvailable()) {
+      // GPU memory is never freed, so there is no free visitor. The bus id of
+      // the GPUs is their NUMA node plus one.
+      ProcessState::singleton()->AddGPUAllocVisitor(NumaNode(context_) + 1,
+                                                    alloc_visitor);
+      gpu_direct_ = true;
+    } else {
+      LOG(WARNING) << "TF_VERBS_GPU_DIRECT is set but the nv_peer_mem module "
+                   << "is not loaded; GPU tensors are copied to host memory";
+    }
+  }
+#endif  // GOOGLE_CUDA
   polling_thread_.reset(Env::Default()->StartThread(
       ThreadOptions(), "RdmaAdapterCQThread", [this] { Process_CQ(); }));
   VLOG(2) << "Start RdmaAdapter: " << name();
@@ -101,6 +225,7 @@ RdmaAdapter::RdmaAdapter(const WorkerEnv* worker_env)
 
 RdmaAdapter::~RdmaAdapter() {
   polling_thread_.reset();
+  memory_mgr_->Stop();
   CHECK(!ibv_destroy_cq(cq_)) << "Failed to destroy CQ";
   CHECK(!ibv_destroy_comp_channel(event_channel_))
       << "Failed to destroy channel";
@@ -221,7 +346,7 @@ void RdmaAdapter::Process_CQ() {
         }
       } else if (wc_[i].opcode == IBV_WC_RDMA_WRITE) {
         RdmaBuffer* rb = reinterpret_cast<RdmaBuffer*>(wc_[i].wr_id);
-        rb->SetBufferStatus(local, idle);
+        rb->WriteCompleted();
         RdmaMessage rm;
         RdmaMessage::ParseMessage(rm, rb->buffer_);
         VLOG(2) << "sent RDMA message: " << MessageTypeToString(rm.type_);
@@ -244,7 +369,8 @@ RdmaChannel::RdmaChannel(const RdmaAdapter* adapter, const string local_name,
     attr.recv_cq = adapter_->cq_;
     attr.cap.max_send_wr = RdmaAdapter::MAX_CONCURRENT_WRITES;
     attr.cap.max_recv_wr = RdmaAdapter::MAX_CONCURRENT_WRITES;
-    attr.cap.max_send_sge = 1;
+    // A tensor write gathers the message and the tensor memory.
+    attr.cap.max_send_sge = 2;
     attr.cap.max_recv_sge = 1;
     attr.qp_type = IBV_QPT_RC;
 
@@ -617,6 +743,42 @@ void RdmaBuffer::Write(uint32_t imm_data, size_t buffer_size) {
   CHECK(!ibv_post_send(channel_->qp_, &wr, &bad_wr)) << "Failed to post send";
 }
 
+void RdmaBuffer::Write(uint32_t imm_data, size_t message_size,
+                       const Tensor& tensor, ibv_mr* mr) {
+  {
+    mutex_lock lock{mu_};
+    in_flight_tensor_ = tensor;
+  }
+  StringPiece data = tensor.tensor_data();
+  struct ibv_sge list[2];
+  list[0].addr = (uint64_t)buffer_;
+  list[0].length = message_size;
+  list[0].lkey = self_->lkey;
+  list[1].addr = (uint64_t)data.data();
+  list[1].length = data.size();
+  list[1].lkey = mr->lkey;
+
+  struct ibv_send_wr wr;
+  memset(&wr, 0, sizeof(wr));
+  wr.wr_id = (uint64_t)this;
+  wr.sg_list = list;
+  wr.num_sge = 2;
+  wr.opcode = IBV_WR_RDMA_WRITE_WITH_IMM;
+  wr.send_flags = IBV_SEND_SIGNALED;
+  wr.imm_data = imm_data;
+  wr.wr.rdma.remote_addr = (uint64_t)remote_.remote_addr;
+  wr.wr.rdma.rkey = remote_.rkey;
+
+  struct ibv_send_wr* bad_wr;
+  CHECK(!ibv_post_send(channel_->qp_, &wr, &bad_wr)) << "Failed to post send";
+}
+
+void RdmaBuffer::WriteCompleted() {
+  mutex_lock lock{mu_};
+  in_flight_tensor_ = Tensor();
+  local_status_ = idle;
+}
+
 RdmaAckBuffer::RdmaAckBuffer(RdmaChannel* channel, string name)
     : RdmaBuffer(channel, name) {}
 
@@ -703,7 +865,23 @@ Rendezvous::DoneCallback RdmaTensorBuffer::getRecvTensorCallback(
           << "send dev name: " << src_dev->name()
           << " gpu_info: " << src_dev->tensorflow_gpu_device_info();
 
-      if (can_memcpy) {
+      if (can_memcpy && channel_->adapter_->gpu_direct_ &&
+          channel_->adapter_->memory_mgr_->FindMemoryRegion(
+              in.tensor_data().data(), in.TotalBytes()) != nullptr) {
+        // The tensor is written straight from GPU memory, once the stream
+        // that produces it has caught up.
+        tensor_bytes = in.TotalBytes();
+        buffer_size += tensor_bytes;
+        src_dev->tensorflow_gpu_device_info()->event_mgr->ThenExecute(
+            send_args.device_context->stream(),
+            [this, tensor_bytes, buffer_size, key, in, step_id,
+             key_with_step_id, is_dead, send_args, recv_args]() {
+              StringPiece copy_buf = in.tensor_data();
+              PostCopyOperations(true, buffer_size, tensor_bytes, key, in,
+                                 step_id, is_dead, key_with_step_id, &in, NULL,
+                                 &copy_buf, send_args, recv_args);
+            });
+      } else if (can_memcpy) {
         AllocatorAttributes host_alloc_attrs;
         host_alloc_attrs.set_gpu_compatible(true);
         host_alloc_attrs.set_on_host(true);
@@ -749,8 +927,9 @@ Rendezvous::DoneCallback RdmaTensorBuffer::getRecvTensorCallback(
       }
       buffer_size += tensor_bytes;
       PostCopyOperations(can_memcpy, buffer_size, tensor_bytes, key, in,
-                         step_id, is_dead, key_with_step_id, &copy, &proto,
-                         &copy_buf, send_args, recv_args);
+                         step_id, is_dead, key_with_step_id,
+                         can_memcpy ? &in : &copy, &proto, &copy_buf,
+                         send_args, recv_args);
     }
   };
   return cb;
@@ -883,6 +1062,14 @@ void RdmaTensorBuffer::PostCopyOperations(
         CHECK(copy_buf->size() == tensor_bytes)
             << "unexpected tensor size: " << copy_buf->size()
             << " != " << tensor_bytes;
+        // If the tensor lives in a registered region, it is gathered by the
+        // write itself instead of being copied into the buffer.
+        ibv_mr* mr = channel_->adapter_->memory_mgr_->FindMemoryRegion(
+            copy_buf->data(), tensor_bytes);
+        if (mr != nullptr) {
+          Write(imm_data, message.size(), *copy, mr);
+          return;
+        }
         memcpy(output, copy_buf->data(), tensor_bytes);
       } else {
         CHECK(proto != NULL) << "callback missing pointer to proto tensor";
@@ -62,6 +62,36 @@ enum RdmaMessageType {
   RDMA_MESSAGE_TENSOR_WRITE
 };
 class RdmaBuffer;
+
+// Class that registers the memory regions of the allocators with the
+// protection domain of the adapter, once per region, so that tensors can be
+// written straight from their own memory instead of being copied into a
+// pre-registered buffer first.
+class RdmaMemoryMgr {
+ public:
+  explicit RdmaMemoryMgr(ibv_pd* pd) : pd_(pd) {}
+  ~RdmaMemoryMgr() { Stop(); }
+  // Returns the registered region that contains [addr, addr + length), or
+  // nullptr if there is none.
+  ibv_mr* FindMemoryRegion(const void* addr, size_t length);
+  void InsertMemoryRegion(void* addr, size_t length);
+  void EvictMemoryRegion(void* addr, size_t length);
+  // Deregisters all the regions and ignores the ones allocated afterwards.
+  // The allocators keep their visitors, so this must be called before the
+  // protection domain is deallocated.
+  void Stop();
+
+ private:
+  static bool Comparator(const void* ptr, const ibv_mr* other) {
+    return ptr < static_cast<const char*>(other->addr) + other->length;
+  }
+
+  mutex mu_;
+  ibv_pd* pd_ GUARDED_BY(mu_);
+  // Sorted by address.
+  std::vector<ibv_mr*> mrs_ GUARDED_BY(mu_);
+};
+
 // Class that represents the Rdma Adapter.
 // Responsible for creation of the completion queue, and handling
 // of work completions.
@@ -92,6 +122,11 @@ class RdmaAdapter {
   ibv_cq* cq_;
   // Pre-allocated work completions array used for polling
   ibv_wc wc_[MAX_CONCURRENT_WRITES * 2];
+  // registration cache for the memory of the allocators.
+  std::shared_ptr<RdmaMemoryMgr> memory_mgr_;
+  // whether GPU memory is registered, so that GPU tensors are written
+  // without a copy to host memory (GPUDirect RDMA).
+  bool gpu_direct_ = false;
   // worker env for thread
   const WorkerEnv* worker_env_;
   // thread for cq.
@@ -190,6 +225,13 @@ class RdmaBuffer {
     return const_cast<RdmaChannel*>(channel_)->LookupBufferIndex(buffer_name);
   }
   void Write(uint32_t imm_data, size_t buffer_size);
+  // Writes the message at the start of the buffer followed by `tensor`,
+  // which is read in place from the registered region `mr`. The tensor is
+  // held until the write completes.
+  void Write(uint32_t imm_data, size_t message_size, const Tensor& tensor,
+             ibv_mr* mr);
+  // Marks the local buffer idle once its last write has completed.
+  void WriteCompleted();
 
  protected:
   const RdmaChannel* channel_;
@@ -201,6 +243,7 @@ class RdmaBuffer {
   mutex mu_;
   RemoteMR remote_;
   std::queue<string> queue_ GUARDED_BY(mu_);
+  Tensor in_flight_tensor_ GUARDED_BY(mu_);
   BufferStatus local_status_ GUARDED_BY(mu_) = none;
   BufferStatus remote_status_ GUARDED_BY(mu_) = none;
 };
@@ -0,0 +1,87 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/allocation_timeline_recorder.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+thread_local const string* current_op_name = nullptr;
+thread_local int64 current_step_id = 0;
+
+}  // namespace
+
+ScopedAllocationAnnotation::ScopedAllocationAnnotation(const string* op_name,
+                                                       int64 step_id)
+    : saved_op_name_(current_op_name), saved_step_id_(current_step_id) {
+  current_op_name = op_name;
+  current_step_id = step_id;
+}
+
+ScopedAllocationAnnotation::~ScopedAllocationAnnotation() {
+  current_op_name = saved_op_name_;
+  current_step_id = saved_step_id_;
+}
+
+const string* ScopedAllocationAnnotation::CurrentOpName() {
+  return current_op_name;
+}
+
+int64 ScopedAllocationAnnotation::CurrentStepId() { return current_step_id; }
+
+AllocationTimelineRecorder::AllocationTimelineRecorder(int64 capacity,
+                                                       int64 bytes_in_use)
+    : ring_(capacity), bytes_in_use_(bytes_in_use) {
+  CHECK_GT(capacity, 0);
+}
+
+void AllocationTimelineRecorder::Record(int64 bytes, int bin) {
+  const uint64 micros = Env::Default()->NowMicros();
+  const string* op_name = ScopedAllocationAnnotation::CurrentOpName();
+  mutex_lock l(mu_);
+  bytes_in_use_ += bytes;
+  AllocatorEvent* event = &ring_[num_recorded_ % ring_.size()];
+  event->set_micros(micros);
+  event->set_bytes(bytes);
+  event->set_bytes_in_use(bytes_in_use_);
+  event->set_bin(bin);
+  if (op_name != nullptr) {
+    event->set_op_name(*op_name);
+  } else {
+    event->clear_op_name();
+  }
+  event->set_step_id(ScopedAllocationAnnotation::CurrentStepId());
+  ++num_recorded_;
+}
+
+void AllocationTimelineRecorder::Export(AllocatorTimeline* timeline) {
+  mutex_lock l(mu_);
+  const int64 capacity = ring_.size();
+  const int64 first = std::max(num_exported_, num_recorded_ - capacity);
+  timeline->set_num_dropped_events(timeline->num_dropped_events() + first -
+                                   num_exported_);
+  for (int64 i = first; i < num_recorded_; ++i) {
+    *timeline->add_events() = ring_[i % ring_.size()];
+  }
+  num_exported_ = num_recorded_;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,77 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_ALLOCATION_TIMELINE_RECORDER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_ALLOCATION_TIMELINE_RECORDER_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Names the op and step on whose behalf the calling thread allocates and
+// frees memory, for the allocators that record timelines.  Devices set it
+// next to the tracing ScopedAnnotation of each kernel, whose name cannot be
+// read back.  Annotations nest; 'op_name' must outlive the annotation.
+class ScopedAllocationAnnotation {
+ public:
+  ScopedAllocationAnnotation(const string* op_name, int64 step_id);
+  ~ScopedAllocationAnnotation();
+
+  // The innermost annotation of the calling thread, or nullptr and 0.
+  static const string* CurrentOpName();
+  static int64 CurrentStepId();
+
+ private:
+  const string* const saved_op_name_;
+  const int64 saved_step_id_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedAllocationAnnotation);
+};
+
+// Keeps the last allocation events of an allocator in a ring buffer, to be
+// exported as an AllocatorTimeline.  Thread-safe.
+class AllocationTimelineRecorder {
+ public:
+  // 'bytes_in_use' are the bytes allocated before recording starts.
+  AllocationTimelineRecorder(int64 capacity, int64 bytes_in_use);
+
+  // Records an allocation of 'bytes' from 'bin', or a deallocation if
+  // 'bytes' is negative, for the current ScopedAllocationAnnotation.
+  void Record(int64 bytes, int bin);
+
+  // Moves the events recorded since the previous call to 'timeline'.
+  void Export(AllocatorTimeline* timeline);
+
+ private:
+  mutex mu_;
+  // Event i is at ring_[i % ring_.size()].
+  std::vector<AllocatorEvent> ring_ GUARDED_BY(mu_);
+  int64 num_recorded_ GUARDED_BY(mu_) = 0;
+  int64 num_exported_ GUARDED_BY(mu_) = 0;
+  int64 bytes_in_use_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AllocationTimelineRecorder);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_ALLOCATION_TIMELINE_RECORDER_H_
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/common_runtime/allocator_retry.h"
+#include "tensorflow/core/framework/memory_pressure.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -23,6 +24,9 @@ namespace tensorflow {
 
 AllocatorRetry::AllocatorRetry() : env_(Env::Default()) {}
 
+AllocatorRetry::AllocatorRetry(const string& allocator_name)
+    : env_(Env::Default()), allocator_name_(allocator_name) {}
+
 void* AllocatorRetry::AllocateRaw(
     std::function<void*(size_t alignment, size_t num_bytes,
                         bool verbose_failure)>
@@ -42,6 +46,10 @@ void* AllocatorRetry::AllocateRaw(
       if (first) {
         deadline_micros = now + max_millis_to_wait * 1000;
         first = false;
+        if (MemoryPressureRegistry::Global()->Notify(allocator_name_,
+                                                     num_bytes) > 0) {
+          continue;
+        }
       }
       if (now < deadline_micros) {
         mutex_lock l(mu_);
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_ALLOCATOR_RETRY_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_ALLOCATOR_RETRY_H_
 
+#include <string>
+
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
@@ -27,10 +29,16 @@ class AllocatorRetry {
  public:
   AllocatorRetry();
 
+  // Notifies the MemoryPressureRegistry of failures under
+  // 'allocator_name'.
+  explicit AllocatorRetry(const string& allocator_name);
+
   // Call 'alloc_func' to obtain memory.  On first call,
   // 'verbose_failure' will be false.  If return value is nullptr,
-  // then wait up to 'max_millis_to_wait' milliseconds, retrying each
-  // time a call to DeallocateRaw() is detected, until either a good
+  // then ask the MemoryPressureRegistry's listeners to release memory,
+  // retrying at once if they did, and then wait up to
+  // 'max_millis_to_wait' milliseconds, retrying each time a call to
+  // DeallocateRaw() is detected, until either a good
   // pointer is returned or the deadline is exhausted.  If the
   // deadline is exhausted, try one more time with 'verbose_failure'
   // set to true.  The value returned is either the first good pointer
@@ -45,6 +53,7 @@ class AllocatorRetry {
 
  private:
   Env* env_;
+  const string allocator_name_;
   mutex mu_;
   condition_variable memory_returned_;
 };
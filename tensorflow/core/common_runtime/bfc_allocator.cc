@@ -15,9 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/bfc_allocator.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -27,12 +30,53 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+int64 NextBFCAllocatorId() {
+  static std::atomic<int64> next_id(0);
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+const size_t BFCAllocator::kMaxThreadCachedBytes;
+
+// The freed small chunks of one thread, by rounded size.  The owning thread
+// is the only one to add or take chunks, so 'mu' is only contended by
+// FlushThreadCaches().
+struct BFCAllocator::ThreadCache {
+  struct CachedChunk {
+    void* ptr;
+    size_t allocated_bytes;
+  };
+  static const int kNumClasses = kMaxThreadCachedBytes / kMinAllocationSize;
+
+  mutex mu;
+  // chunks[i] holds chunks of rounded size (i + 1) * kMinAllocationSize,
+  // most recently freed last.
+  std::vector<CachedChunk> chunks[kNumClasses] GUARDED_BY(mu);
+  size_t cached_bytes GUARDED_BY(mu) = 0;
+
+  // Cleared when the thread exits, after which the cache is dropped by the
+  // next flush.
+  std::atomic<bool> thread_alive{true};
+  // Cleared when the allocator is deleted, after which the thread drops the
+  // cache.
+  std::atomic<bool> allocator_alive{true};
+
+  static int ClassFor(size_t rounded_bytes) {
+    return rounded_bytes / kMinAllocationSize - 1;
+  }
+};
+
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                            bool allow_growth, const string& name)
-    : suballocator_(sub_allocator),
+    : retry_helper_(name),
+      suballocator_(sub_allocator),
       name_(name),
       free_chunks_list_(kInvalidChunkHandle),
-      next_allocation_id_(1) {
+      next_allocation_id_(1),
+      allocator_id_(NextBFCAllocatorId()) {
   if (allow_growth) {
     // 1MiB smallest initial allocation, unless total memory available
     // is less.
@@ -65,12 +109,37 @@ BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
   }
 }
 
+BFCAllocator::BFCAllocator(VirtualMemorySubAllocator* sub_allocator,
+                           size_t total_memory, const string& name)
+    : BFCAllocator(static_cast<SubAllocator*>(sub_allocator), total_memory,
+                   true /*allow_growth*/, name) {
+  CHECK_EQ(0, sub_allocator->page_size() % kMinAllocationSize);
+  vm_suballocator_ = sub_allocator;
+}
+
 BFCAllocator::~BFCAllocator() {
+  // The cached chunks are in the regions freed below.
+  {
+    mutex_lock l(thread_caches_mu_);
+    for (const auto& cache : thread_caches_) {
+      cache->allocator_alive.store(false, std::memory_order_relaxed);
+    }
+  }
+
   // Return memory back.
   VLOG(2) << "Number of regions allocated: "
           << region_manager_.regions().size();
-  for (const auto& region : region_manager_.regions()) {
-    suballocator_->Free(region.ptr(), region.memory_size());
+  if (vm_suballocator_ != nullptr) {
+    if (vm_base_ != nullptr) {
+      if (vm_mapped_bytes_ > 0) {
+        vm_suballocator_->Unmap(vm_base_, vm_mapped_bytes_);
+      }
+      vm_suballocator_->Unreserve(vm_base_, vm_reserved_bytes_);
+    }
+  } else {
+    for (const auto& region : region_manager_.regions()) {
+      suballocator_->Free(region.ptr(), region.memory_size());
+    }
   }
 
   for (BinNum b = 0; b < kNumBins; b++) {
@@ -85,6 +154,9 @@ BFCAllocator::Chunk* BFCAllocator::ChunkFromHandle(ChunkHandle h) {
 }
 
 bool BFCAllocator::Extend(size_t rounded_bytes) {
+  if (vm_suballocator_ != nullptr) {
+    return ExtendVirtual(rounded_bytes);
+  }
   size_t available_bytes = memory_limit_ - total_region_allocated_bytes_;
   // Rounds available_bytes down to the nearest multiple of kMinAllocationSize.
   available_bytes = (available_bytes / kMinAllocationSize) * kMinAllocationSize;
@@ -167,6 +239,147 @@ bool BFCAllocator::Extend(size_t rounded_bytes) {
   return true;
 }
 
+bool BFCAllocator::ExtendVirtual(size_t rounded_bytes) {
+  const size_t page_size = vm_suballocator_->page_size();
+  if (vm_base_ == nullptr) {
+    const size_t reserved_bytes = memory_limit_ / page_size * page_size;
+    if (reserved_bytes == 0) {
+      return false;
+    }
+    vm_base_ = vm_suballocator_->Reserve(reserved_bytes);
+    if (vm_base_ == nullptr) {
+      LOG(WARNING) << "Allocator (" << Name() << ") failed to reserve "
+                   << strings::HumanReadableNumBytes(reserved_bytes)
+                   << " of address space.";
+      return false;
+    }
+    vm_reserved_bytes_ = reserved_bytes;
+    region_manager_.AddAllocationRegion(vm_base_, reserved_bytes);
+  }
+
+  // A free chunk at the end of the mapped memory grows into the new pages,
+  // so only the remainder of the request has to be mapped.
+  const ChunkHandle last = LastVirtualChunk();
+  size_t needed_bytes = rounded_bytes;
+  if (last != kInvalidChunkHandle && !ChunkFromHandle(last)->in_use()) {
+    needed_bytes -= std::min(needed_bytes, ChunkFromHandle(last)->size);
+  }
+  needed_bytes = (needed_bytes + page_size - 1) / page_size * page_size;
+  const size_t available_bytes = vm_reserved_bytes_ - vm_mapped_bytes_;
+  if (needed_bytes > available_bytes) {
+    return false;
+  }
+
+  // Grow geometrically, like the regions added by Extend().
+  bool increased_allocation = false;
+  while (needed_bytes > curr_region_allocation_bytes_) {
+    curr_region_allocation_bytes_ *= 2;
+    increased_allocation = true;
+  }
+  size_t bytes = std::min(
+      (curr_region_allocation_bytes_ + page_size - 1) / page_size * page_size,
+      available_bytes);
+  void* mem_addr = static_cast<char*>(vm_base_) + vm_mapped_bytes_;
+  if (!vm_suballocator_->Map(mem_addr, bytes)) {
+    // Try mapping only what this allocation needs.
+    bytes = needed_bytes;
+    if (!vm_suballocator_->Map(mem_addr, bytes)) {
+      return false;
+    }
+  }
+  if (!increased_allocation) {
+    curr_region_allocation_bytes_ *= 2;
+  }
+
+  vm_mapped_bytes_ += bytes;
+  total_region_allocated_bytes_ += bytes;
+  VLOG(1) << "Mapped " << strings::HumanReadableNumBytes(bytes) << " at "
+          << mem_addr << ", total mapped "
+          << strings::HumanReadableNumBytes(vm_mapped_bytes_);
+
+  ChunkHandle h = AllocateChunk();
+  BFCAllocator::Chunk* c = ChunkFromHandle(h);
+  c->ptr = mem_addr;
+  c->size = bytes;
+  c->allocation_id = -1;
+  c->prev = last;
+  c->next = kInvalidChunkHandle;
+  region_manager_.set_handle(c->ptr, h);
+
+  if (last == kInvalidChunkHandle) {
+    InsertFreeChunkIntoBin(h);
+  } else {
+    ChunkFromHandle(last)->next = h;
+    if (ChunkFromHandle(last)->in_use()) {
+      InsertFreeChunkIntoBin(h);
+    } else {
+      RemoveFreeChunkFromBin(last);
+      Merge(last, h);
+      InsertFreeChunkIntoBin(last);
+    }
+  }
+
+  for (const auto& visitor : region_visitors_) {
+    visitor(mem_addr, bytes);
+  }
+  return true;
+}
+
+BFCAllocator::ChunkHandle BFCAllocator::LastVirtualChunk() {
+  if (vm_mapped_bytes_ == 0) {
+    return kInvalidChunkHandle;
+  }
+  ChunkHandle h = region_manager_.get_handle(vm_base_);
+  while (ChunkFromHandle(h)->next != kInvalidChunkHandle) {
+    h = ChunkFromHandle(h)->next;
+  }
+  return h;
+}
+
+size_t BFCAllocator::ReleaseIdleMemory() {
+  if (vm_suballocator_ == nullptr) {
+    return 0;
+  }
+  mutex_lock l(lock_);
+  if (thread_caching_enabled()) {
+    FlushThreadCachesLocked();
+  }
+  const ChunkHandle h = LastVirtualChunk();
+  if (h == kInvalidChunkHandle || ChunkFromHandle(h)->in_use()) {
+    return 0;
+  }
+
+  // Keep the part of the chunk that shares a page with the previous one.
+  Chunk* c = ChunkFromHandle(h);
+  const size_t page_size = vm_suballocator_->page_size();
+  const size_t offset =
+      static_cast<char*>(c->ptr) - static_cast<char*>(vm_base_);
+  const size_t kept_bytes =
+      (offset + page_size - 1) / page_size * page_size - offset;
+  if (kept_bytes >= c->size) {
+    return 0;
+  }
+  const size_t released_bytes = c->size - kept_bytes;
+  RemoveFreeChunkFromBin(h);
+  vm_suballocator_->Unmap(static_cast<char*>(c->ptr) + kept_bytes,
+                          released_bytes);
+  if (kept_bytes == 0) {
+    if (c->prev != kInvalidChunkHandle) {
+      ChunkFromHandle(c->prev)->next = kInvalidChunkHandle;
+    }
+    DeleteChunk(h);
+  } else {
+    c->size = kept_bytes;
+    InsertFreeChunkIntoBin(h);
+  }
+  vm_mapped_bytes_ -= released_bytes;
+  total_region_allocated_bytes_ -= released_bytes;
+  VLOG(1) << "Unmapped " << strings::HumanReadableNumBytes(released_bytes)
+          << ", total mapped "
+          << strings::HumanReadableNumBytes(vm_mapped_bytes_);
+  return released_bytes;
+}
+
 BFCAllocator::ChunkHandle BFCAllocator::AllocateChunk() {
   if (free_chunks_list_ != kInvalidChunkHandle) {
     ChunkHandle h = free_chunks_list_;
@@ -249,21 +462,44 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // so all memory addresses are nicely byte aligned.
   size_t rounded_bytes = RoundedBytes(num_bytes);
 
+  const bool small =
+      rounded_bytes <= kMaxThreadCachedBytes && thread_caching_enabled();
+  if (small) {
+    void* ptr = AllocateFromThreadCache(rounded_bytes, num_bytes);
+    if (ptr != nullptr) {
+      if (timeline_recorder_ != nullptr) {
+        const size_t allocated_bytes = AllocatedSize(ptr);
+        timeline_recorder_->Record(allocated_bytes,
+                                   BinNumForSize(allocated_bytes));
+      }
+      return ptr;
+    }
+  }
+
   // The BFC allocator tries to find the best fit first.
   BinNum bin_num = BinNumForSize(rounded_bytes);
 
   mutex_lock l(lock_);
   void* ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
-  if (ptr != nullptr) {
-    return ptr;
+  if (ptr == nullptr && thread_caching_enabled()) {
+    // Coalesce the cached chunks before growing.
+    FlushThreadCachesLocked();
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
   }
 
   // Try to extend
-  if (Extend(rounded_bytes)) {
+  if (ptr == nullptr && Extend(rounded_bytes)) {
     ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
-    if (ptr != nullptr) {
-      return ptr;
+  }
+  if (ptr != nullptr) {
+    if (small) {
+      RecordSmallAllocation(ptr, rounded_bytes);
+    }
+    if (timeline_recorder_ != nullptr) {
+      const Chunk* c = ChunkFromHandle(region_manager_.get_handle(ptr));
+      timeline_recorder_->Record(c->size, BinNumForSize(c->size));
     }
+    return ptr;
   }
 
   // We searched all bins for an existing free chunk to use and
@@ -378,6 +614,15 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
     LOG(ERROR) << "tried to deallocate nullptr";
     return;
   }
+  if (timeline_recorder_ != nullptr) {
+    const size_t allocated_bytes = AllocatedSize(ptr);
+    timeline_recorder_->Record(-static_cast<int64>(allocated_bytes),
+                               BinNumForSize(allocated_bytes));
+  }
+  if (small_allocations_tracked_.load(std::memory_order_relaxed) &&
+      DeallocateToThreadCache(ptr)) {
+    return;
+  }
   mutex_lock l(lock_);
 
   // Find the chunk from the ptr.
@@ -392,6 +637,206 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
   }
 }
 
+void BFCAllocator::EnableTimeline(int64 max_events) {
+  mutex_lock l(lock_);
+  CHECK_EQ(0, stats_.num_allocs);
+  timeline_recorder_.reset(new AllocationTimelineRecorder(max_events, 0));
+}
+
+bool BFCAllocator::ExportTimeline(AllocatorTimeline* timeline) {
+  if (timeline_recorder_ == nullptr) {
+    return false;
+  }
+  timeline->set_allocator_name(Name());
+  timeline_recorder_->Export(timeline);
+
+  mutex_lock l(lock_);
+  const std::array<BinDebugInfo, kNumBins> bin_infos = get_bin_debug_info();
+  for (BinNum b = 0; b < kNumBins; b++) {
+    const BinDebugInfo& bin_info = bin_infos[b];
+    if (bin_info.total_chunks_in_bin == 0) continue;
+    AllocatorBinStats* bin = timeline->add_bins();
+    bin->set_bin(b);
+    bin->set_bin_size(BinNumToSize(b));
+    bin->set_chunks_in_use(bin_info.total_chunks_in_use);
+    bin->set_bytes_in_use(bin_info.total_bytes_in_use);
+    bin->set_requested_bytes_in_use(bin_info.total_requested_bytes_in_use);
+    bin->set_free_chunks(bin_info.total_chunks_in_bin -
+                         bin_info.total_chunks_in_use);
+    bin->set_free_bytes(bin_info.total_bytes_in_bin -
+                        bin_info.total_bytes_in_use);
+  }
+  return true;
+}
+
+void BFCAllocator::SetThreadCacheBytes(size_t max_bytes_per_thread) {
+  if (max_bytes_per_thread > 0) {
+    small_allocations_tracked_.store(true, std::memory_order_relaxed);
+  }
+  max_thread_cache_bytes_.store(max_bytes_per_thread,
+                                std::memory_order_relaxed);
+  if (max_bytes_per_thread == 0) {
+    FlushThreadCaches();
+  }
+}
+
+BFCAllocator::ThreadCache* BFCAllocator::GetThreadCache() {
+  // The caches of the calling thread, one per allocator that it used.
+  struct ThreadCaches {
+    ~ThreadCaches() {
+      for (const auto& cache : caches) {
+        cache.second->thread_alive.store(false, std::memory_order_relaxed);
+      }
+    }
+    std::vector<std::pair<int64, std::shared_ptr<ThreadCache>>> caches;
+  };
+  static thread_local ThreadCaches thread_caches;
+  std::vector<std::pair<int64, std::shared_ptr<ThreadCache>>>& caches =
+      thread_caches.caches;
+  for (const auto& cache : caches) {
+    if (cache.first == allocator_id_) return cache.second.get();
+  }
+
+  // Drop the caches of deleted allocators.
+  caches.erase(
+      std::remove_if(
+          caches.begin(), caches.end(),
+          [](const std::pair<int64, std::shared_ptr<ThreadCache>>& cache) {
+            return !cache.second->allocator_alive.load(
+                std::memory_order_relaxed);
+          }),
+      caches.end());
+  std::shared_ptr<ThreadCache> cache(new ThreadCache);
+  {
+    mutex_lock l(thread_caches_mu_);
+    thread_caches_.push_back(cache);
+  }
+  caches.emplace_back(allocator_id_, cache);
+  return cache.get();
+}
+
+BFCAllocator::SmallAllocationShard* BFCAllocator::ShardFor(const void* ptr) {
+  const uint64 h = Hash64(reinterpret_cast<const char*>(&ptr), sizeof(ptr));
+  return &small_allocation_shards_[h % kNumSmallAllocationShards];
+}
+
+bool BFCAllocator::FindSmallAllocation(const void* ptr,
+                                       SmallAllocation* allocation) {
+  if (!small_allocations_tracked_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  SmallAllocationShard* shard = ShardFor(ptr);
+  mutex_lock l(shard->mu);
+  auto it = shard->allocations.find(ptr);
+  if (it == shard->allocations.end()) return false;
+  *allocation = it->second;
+  return true;
+}
+
+void BFCAllocator::RecordSmallAllocation(void* ptr, size_t rounded_bytes) {
+  const Chunk* c = ChunkFromHandle(region_manager_.get_handle(ptr));
+  SmallAllocation allocation;
+  allocation.rounded_bytes = rounded_bytes;
+  allocation.allocated_bytes = c->size;
+  allocation.requested_bytes = c->requested_size;
+  allocation.allocation_id = c->allocation_id;
+  SmallAllocationShard* shard = ShardFor(ptr);
+  {
+    mutex_lock shard_lock(shard->mu);
+    shard->allocations[ptr] = allocation;
+  }
+  num_thread_cache_misses_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* BFCAllocator::AllocateFromThreadCache(size_t rounded_bytes,
+                                            size_t num_bytes) {
+  ThreadCache* cache = GetThreadCache();
+  ThreadCache::CachedChunk chunk;
+  {
+    mutex_lock l(cache->mu);
+    std::vector<ThreadCache::CachedChunk>& chunks =
+        cache->chunks[ThreadCache::ClassFor(rounded_bytes)];
+    if (chunks.empty()) {
+      return nullptr;
+    }
+    chunk = chunks.back();
+    chunks.pop_back();
+    cache->cached_bytes -= chunk.allocated_bytes;
+  }
+  thread_cached_bytes_.fetch_sub(chunk.allocated_bytes,
+                                 std::memory_order_relaxed);
+  num_thread_cache_hits_.fetch_add(1, std::memory_order_relaxed);
+
+  SmallAllocation allocation;
+  allocation.rounded_bytes = rounded_bytes;
+  allocation.allocated_bytes = chunk.allocated_bytes;
+  allocation.requested_bytes = num_bytes;
+  allocation.allocation_id = next_allocation_id_.fetch_add(1);
+  SmallAllocationShard* shard = ShardFor(chunk.ptr);
+  mutex_lock l(shard->mu);
+  shard->allocations[chunk.ptr] = allocation;
+  return chunk.ptr;
+}
+
+bool BFCAllocator::DeallocateToThreadCache(void* ptr) {
+  SmallAllocation allocation;
+  {
+    SmallAllocationShard* shard = ShardFor(ptr);
+    mutex_lock l(shard->mu);
+    auto it = shard->allocations.find(ptr);
+    if (it == shard->allocations.end()) {
+      return false;
+    }
+    allocation = it->second;
+    shard->allocations.erase(it);
+  }
+
+  ThreadCache* cache = GetThreadCache();
+  const size_t max_bytes =
+      max_thread_cache_bytes_.load(std::memory_order_relaxed);
+  mutex_lock l(cache->mu);
+  if (cache->cached_bytes + allocation.allocated_bytes > max_bytes) {
+    // The cache is full, so the chunk goes back to the bins.
+    return false;
+  }
+  cache->chunks[ThreadCache::ClassFor(allocation.rounded_bytes)].push_back(
+      {ptr, allocation.allocated_bytes});
+  cache->cached_bytes += allocation.allocated_bytes;
+  thread_cached_bytes_.fetch_add(allocation.allocated_bytes,
+                                 std::memory_order_relaxed);
+  return true;
+}
+
+void BFCAllocator::FlushThreadCaches() {
+  mutex_lock l(lock_);
+  FlushThreadCachesLocked();
+}
+
+void BFCAllocator::FlushThreadCachesLocked() {
+  mutex_lock l(thread_caches_mu_);
+  for (const auto& cache : thread_caches_) {
+    mutex_lock cache_lock(cache->mu);
+    for (std::vector<ThreadCache::CachedChunk>& chunks : cache->chunks) {
+      for (const ThreadCache::CachedChunk& chunk : chunks) {
+        ChunkHandle h = region_manager_.get_handle(chunk.ptr);
+        CHECK(h != kInvalidChunkHandle);
+        FreeAndMaybeCoalesce(h);
+      }
+      chunks.clear();
+    }
+    thread_cached_bytes_.fetch_sub(cache->cached_bytes,
+                                   std::memory_order_relaxed);
+    cache->cached_bytes = 0;
+  }
+  thread_caches_.erase(
+      std::remove_if(thread_caches_.begin(), thread_caches_.end(),
+                     [](const std::shared_ptr<ThreadCache>& cache) {
+                       return !cache->thread_alive.load(
+                           std::memory_order_relaxed);
+                     }),
+      thread_caches_.end());
+}
+
 // Merges h1 and h2 when Chunk(h1)->next is h2 and Chunk(h2)->prev is c1.
 // We merge Chunk(h2) into Chunk(h1).
 void BFCAllocator::Merge(BFCAllocator::ChunkHandle h1,
@@ -511,6 +956,13 @@ void BFCAllocator::AddAllocVisitor(Visitor visitor) {
   VLOG(1) << "AddVisitor";
   mutex_lock l(lock_);
   region_visitors_.push_back(visitor);
+  if (vm_suballocator_ != nullptr) {
+    // Only the mapped part of the region holds memory.
+    if (vm_mapped_bytes_ > 0) {
+      visitor(vm_base_, vm_mapped_bytes_);
+    }
+    return;
+  }
   for (const auto& region : region_manager_.regions()) {
     visitor(region.ptr(), region.memory_size());
   }
@@ -519,6 +971,10 @@ void BFCAllocator::AddAllocVisitor(Visitor visitor) {
 bool BFCAllocator::TracksAllocationSizes() { return true; }
 
 size_t BFCAllocator::RequestedSize(void* ptr) {
+  SmallAllocation allocation;
+  if (FindSmallAllocation(ptr, &allocation)) {
+    return allocation.requested_bytes;
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -528,6 +984,10 @@ size_t BFCAllocator::RequestedSize(void* ptr) {
 }
 
 size_t BFCAllocator::AllocatedSize(void* ptr) {
+  SmallAllocation allocation;
+  if (FindSmallAllocation(ptr, &allocation)) {
+    return allocation.allocated_bytes;
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -537,6 +997,10 @@ size_t BFCAllocator::AllocatedSize(void* ptr) {
 }
 
 int64 BFCAllocator::AllocationId(void* ptr) {
+  SmallAllocation allocation;
+  if (FindSmallAllocation(ptr, &allocation)) {
+    return allocation.allocation_id;
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -688,6 +1152,14 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
 void BFCAllocator::GetStats(AllocatorStats* stats) {
   mutex_lock l(lock_);
   *stats = stats_;
+  // The chunks in the thread caches are in use as far as the bins are
+  // concerned.
+  const int64 hits = num_thread_cache_hits_.load(std::memory_order_relaxed);
+  stats->num_allocs += hits;
+  stats->bytes_in_use -= thread_cached_bytes_.load(std::memory_order_relaxed);
+  stats->num_thread_cache_hits = hits;
+  stats->num_thread_cache_misses =
+      num_thread_cache_misses_.load(std::memory_order_relaxed);
 }
 
 std::array<BFCAllocator::BinDebugInfo, BFCAllocator::kNumBins>
@@ -17,11 +17,13 @@ limitations under the License.
 #define TENSORFLOW_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 
 #include <array>
+#include <atomic>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "tensorflow/core/common_runtime/allocation_timeline_recorder.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/common_runtime/visitable_allocator.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
@@ -47,6 +49,13 @@ class BFCAllocator : public VisitableAllocator {
   // Takes ownership of sub_allocator.
   BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                bool allow_growth, const string& name);
+
+  // Reserves 'total_memory' of address space from 'sub_allocator' the first
+  // time memory is needed, and grows a single region within it by mapping
+  // pages on demand.  Unlike the disjoint regions added by allow_growth,
+  // all free chunks can coalesce.  Takes ownership of sub_allocator.
+  BFCAllocator(VirtualMemorySubAllocator* sub_allocator, size_t total_memory,
+               const string& name);
   ~BFCAllocator() override;
 
   string Name() override { return name_; }
@@ -70,13 +79,59 @@ class BFCAllocator : public VisitableAllocator {
 
   void GetStats(AllocatorStats* stats) override;
 
+  // If 'max_bytes_per_thread' is positive, chunks of up to
+  // kMaxThreadCachedBytes that are freed by a thread are kept in a cache of
+  // that thread, which holds at most 'max_bytes_per_thread' bytes.  Later
+  // allocations of the same rounded size by the thread reuse them without
+  // taking the allocator lock.
+  void SetThreadCacheBytes(size_t max_bytes_per_thread);
+
+  // Returns the chunks cached by all threads to the bins, coalescing them
+  // with their free neighbors.  This also happens whenever the bins cannot
+  // satisfy an allocation.
+  void FlushThreadCaches();
+
+  static const size_t kMaxThreadCachedBytes = 16 << 10;
+
+  // Unmaps the whole free pages at the end of the region of a virtual
+  // memory BFCAllocator, and returns their number of bytes.  Returns 0 for
+  // other BFCAllocators.
+  size_t ReleaseIdleMemory();
+
+  // Records the last 'max_events' allocations and deallocations, to be
+  // returned by ExportTimeline().  Must be called before the first
+  // allocation.
+  void EnableTimeline(int64 max_events);
+
+  // Also exports a snapshot of the bins.  Chunks in thread caches count as
+  // in use.
+  bool ExportTimeline(AllocatorTimeline* timeline) override;
+
  private:
   struct Bin;
+  struct ThreadCache;
 
   void* AllocateRawInternal(size_t alignment, size_t num_bytes,
                             bool dump_log_on_failure);
   void DeallocateRawInternal(void* ptr);
 
+  // Returns the cache of the calling thread.
+  ThreadCache* GetThreadCache();
+
+  bool thread_caching_enabled() const {
+    return max_thread_cache_bytes_.load(std::memory_order_relaxed) > 0;
+  }
+
+  // Returns a chunk of 'rounded_bytes' from the cache of the calling thread,
+  // or nullptr if there is none.
+  void* AllocateFromThreadCache(size_t rounded_bytes, size_t num_bytes);
+
+  // Puts 'ptr' in the cache of the calling thread, if it was allocated while
+  // thread caching was enabled and the cache has room for it.
+  bool DeallocateToThreadCache(void* ptr);
+
+  void FlushThreadCachesLocked() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // A ChunkHandle is an index into the chunks_ vector in BFCAllocator
   // kInvalidChunkHandle means an invalid chunk
   typedef size_t ChunkHandle;
@@ -305,6 +360,14 @@ class BFCAllocator : public VisitableAllocator {
   // failure.
   bool Extend(size_t rounded_bytes) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Extend() for a virtual memory BFCAllocator: maps more pages at the end
+  // of the region, merging them with the last chunk if it is free.
+  bool ExtendVirtual(size_t rounded_bytes) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns the chunk at the end of the mapped memory of a virtual memory
+  // BFCAllocator, or kInvalidChunkHandle if none is mapped.
+  ChunkHandle LastVirtualChunk() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Returns a pointer to an underlying allocated chunk of size
   // 'rounded_bytes'.
   void* FindChunkPtr(BinNum bin_num, size_t rounded_bytes, size_t num_bytes)
@@ -337,6 +400,11 @@ class BFCAllocator : public VisitableAllocator {
   // Removes the chunk metadata represented by 'h'.
   void DeleteChunk(ChunkHandle h) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Records the small allocation 'ptr', which was just returned by
+  // FindChunkPtr().
+  void RecordSmallAllocation(void* ptr, size_t rounded_bytes)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   string RenderOccupancy() EXCLUSIVE_LOCKS_REQUIRED(lock_);
   void DumpMemoryLog(size_t num_bytes) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
@@ -412,6 +480,14 @@ class BFCAllocator : public VisitableAllocator {
   bool started_backpedal_ = false;
 
   std::unique_ptr<SubAllocator> suballocator_;
+
+  // Set for a virtual memory BFCAllocator, aliasing suballocator_.  The
+  // region is reserved at vm_base_, and its first vm_mapped_bytes_ are
+  // mapped.
+  VirtualMemorySubAllocator* vm_suballocator_ = nullptr;
+  void* vm_base_ GUARDED_BY(lock_) = nullptr;
+  size_t vm_reserved_bytes_ GUARDED_BY(lock_) = 0;
+  size_t vm_mapped_bytes_ GUARDED_BY(lock_) = 0;
   string name_;
 
   // Structures mutable after construction
@@ -425,12 +501,47 @@ class BFCAllocator : public VisitableAllocator {
   std::vector<Visitor> region_visitors_;
 
   // Counter containing the next unique identifier to assign to a
-  // newly-created chunk.
-  int64 next_allocation_id_ GUARDED_BY(lock_);
+  // newly-created chunk.  Cache hits also take identifiers without the lock.
+  std::atomic<int64> next_allocation_id_;
 
   // Stats.
   AllocatorStats stats_ GUARDED_BY(lock_);
 
+  // Set by EnableTimeline().
+  std::unique_ptr<AllocationTimelineRecorder> timeline_recorder_;
+
+  // The allocations of at most kMaxThreadCachedBytes made while thread
+  // caching is enabled, sharded by address.  Unlike the chunks, they can be
+  // looked up without taking 'lock_'.  The BFC chunks of these allocations,
+  // and of the chunks in the thread caches, stay in use.
+  struct SmallAllocation {
+    size_t rounded_bytes = 0;
+    size_t allocated_bytes = 0;
+    size_t requested_bytes = 0;
+    int64 allocation_id = 0;
+  };
+  struct SmallAllocationShard {
+    mutex mu;
+    std::unordered_map<const void*, SmallAllocation> allocations GUARDED_BY(mu);
+  };
+  static const int kNumSmallAllocationShards = 16;
+  SmallAllocationShard* ShardFor(const void* ptr);
+  bool FindSmallAllocation(const void* ptr, SmallAllocation* allocation);
+  SmallAllocationShard small_allocation_shards_[kNumSmallAllocationShards];
+
+  // Distinguishes this allocator in the thread-local lists of caches.
+  const int64 allocator_id_;
+  std::atomic<size_t> max_thread_cache_bytes_{0};
+  // Set once thread caching is first enabled, after which deallocations
+  // look up the small allocations even if it was disabled again.
+  std::atomic<bool> small_allocations_tracked_{false};
+  mutex thread_caches_mu_ ACQUIRED_AFTER(lock_);
+  std::vector<std::shared_ptr<ThreadCache>> thread_caches_
+      GUARDED_BY(thread_caches_mu_);
+  std::atomic<int64> thread_cached_bytes_{0};
+  std::atomic<int64> num_thread_cache_hits_{0};
+  std::atomic<int64> num_thread_cache_misses_{0};
+
   friend class GPUBFCAllocatorPrivateMethodsTest;
   TF_DISALLOW_COPY_AND_ASSIGN(BFCAllocator);
 };
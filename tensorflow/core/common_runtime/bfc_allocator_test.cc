@@ -0,0 +1,361 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class HostSubAllocator : public SubAllocator {
+ public:
+  void* Alloc(size_t alignment, size_t num_bytes) override {
+    return port::AlignedMalloc(num_bytes, alignment);
+  }
+  void Free(void* ptr, size_t num_bytes) override { port::AlignedFree(ptr); }
+};
+
+std::unique_ptr<BFCAllocator> MakeAllocator(size_t total_memory,
+                                            size_t thread_cache_bytes) {
+  std::unique_ptr<BFCAllocator> a(new BFCAllocator(
+      new HostSubAllocator, total_memory, false /*allow_growth*/, "test"));
+  a->SetThreadCacheBytes(thread_cache_bytes);
+  return a;
+}
+
+TEST(BFCAllocatorThreadCacheTest, ReusesFreedChunks) {
+  std::unique_ptr<BFCAllocator> a = MakeAllocator(1 << 20, 4096);
+  void* p = a->AllocateRaw(4, 1000);
+  const int64 p_id = a->AllocationId(p);
+  a->DeallocateRaw(p);
+
+  void* q = a->AllocateRaw(4, 1000);
+  EXPECT_EQ(p, q);
+  EXPECT_EQ(1000, a->RequestedSize(q));
+  EXPECT_EQ(1024, a->AllocatedSize(q));
+  EXPECT_NE(p_id, a->AllocationId(q));
+
+  AllocatorStats stats;
+  a->GetStats(&stats);
+  EXPECT_EQ(2, stats.num_allocs);
+  EXPECT_EQ(1024, stats.bytes_in_use);
+  EXPECT_EQ(1, stats.num_thread_cache_hits);
+  EXPECT_EQ(1, stats.num_thread_cache_misses);
+
+  // Cached chunks are not in use.
+  a->DeallocateRaw(q);
+  a->GetStats(&stats);
+  EXPECT_EQ(0, stats.bytes_in_use);
+}
+
+TEST(BFCAllocatorThreadCacheTest, CacheLimit) {
+  std::unique_ptr<BFCAllocator> a = MakeAllocator(1 << 20, 1024);
+  void* p = a->AllocateRaw(4, 1024);
+  void* q = a->AllocateRaw(4, 1024);
+  a->DeallocateRaw(p);
+  // The cache is full, so 'q' goes back to the bins and coalesces with the
+  // rest of the region.
+  a->DeallocateRaw(q);
+
+  void* large = a->AllocateRaw(4, 4096);
+  EXPECT_EQ(q, large);
+  EXPECT_EQ(p, a->AllocateRaw(4, 1024));
+  a->DeallocateRaw(p);
+  a->DeallocateRaw(large);
+}
+
+TEST(BFCAllocatorThreadCacheTest, FlushCoalesces) {
+  std::unique_ptr<BFCAllocator> a = MakeAllocator(1 << 20, 4096);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 4; ++i) ptrs.push_back(a->AllocateRaw(4, 256));
+  for (void* p : ptrs) a->DeallocateRaw(p);
+
+  // The cached chunks stay allocated in the bins.
+  void* p = a->AllocateRaw(4, 1024);
+  EXPECT_NE(ptrs[0], p);
+  a->DeallocateRaw(p);
+
+  a->FlushThreadCaches();
+  p = a->AllocateRaw(4, 1024);
+  EXPECT_EQ(ptrs[0], p);
+  a->DeallocateRaw(p);
+}
+
+TEST(BFCAllocatorThreadCacheTest, FlushesUnderMemoryPressure) {
+  std::unique_ptr<BFCAllocator> a = MakeAllocator(16 << 10, 16 << 10);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 64; ++i) ptrs.push_back(a->AllocateRaw(4, 256));
+  for (void* p : ptrs) a->DeallocateRaw(p);
+
+  // Only possible once the cached chunks are coalesced.
+  void* p = a->AllocateRaw(4, 16 << 10);
+  EXPECT_NE(nullptr, p);
+  a->DeallocateRaw(p);
+}
+
+TEST(BFCAllocatorThreadCacheTest, Disable) {
+  std::unique_ptr<BFCAllocator> a = MakeAllocator(1 << 20, 4096);
+  void* p = a->AllocateRaw(4, 256);
+  void* q = a->AllocateRaw(4, 256);
+  a->DeallocateRaw(p);
+  a->SetThreadCacheBytes(0);
+  // 'q' was allocated while caching was enabled, but is not cached.
+  a->DeallocateRaw(q);
+
+  AllocatorStats stats;
+  a->GetStats(&stats);
+  EXPECT_EQ(0, stats.bytes_in_use);
+}
+
+TEST(BFCAllocatorThreadCacheTest, Threads) {
+  std::unique_ptr<BFCAllocator> a = MakeAllocator(64 << 20, 8192);
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back(Env::Default()->StartThread(
+          ThreadOptions(), "bfc_test", [&a, t]() {
+            std::vector<void*> live;
+            for (int i = 0; i < 1000; ++i) {
+              live.push_back(a->AllocateRaw(4, 64 + (i * (t + 1)) % 8192));
+              if (live.size() > 8) {
+                a->DeallocateRaw(live.front());
+                live.erase(live.begin());
+              }
+            }
+            for (void* p : live) a->DeallocateRaw(p);
+          }));
+    }
+  }
+  // Chunks freed by a thread other than the one that allocated them.
+  void* p = a->AllocateRaw(4, 512);
+  std::unique_ptr<Thread>(Env::Default()->StartThread(
+      ThreadOptions(), "bfc_free", [&a, p]() { a->DeallocateRaw(p); }));
+
+  a->FlushThreadCaches();
+  AllocatorStats stats;
+  a->GetStats(&stats);
+  EXPECT_EQ(0, stats.bytes_in_use);
+  EXPECT_EQ(4001, stats.num_allocs);
+  EXPECT_GT(stats.num_thread_cache_hits, 0);
+}
+
+TEST(BFCAllocatorTimelineTest, Disabled) {
+  BFCAllocator a(new HostSubAllocator, 1 << 20, false /*allow_growth*/,
+                 "test");
+  AllocatorTimeline timeline;
+  EXPECT_FALSE(a.ExportTimeline(&timeline));
+}
+
+TEST(BFCAllocatorTimelineTest, RingBuffer) {
+  BFCAllocator a(new HostSubAllocator, 1 << 20, false /*allow_growth*/,
+                 "test");
+  a.EnableTimeline(3);
+  const string op_name = "matmul";
+  void* p;
+  {
+    ScopedAllocationAnnotation annotation(&op_name, 42);
+    p = a.AllocateRaw(4, 1000);
+  }
+  void* q = a.AllocateRaw(4, 4096);
+  a.DeallocateRaw(p);
+
+  AllocatorTimeline timeline;
+  EXPECT_TRUE(a.ExportTimeline(&timeline));
+  EXPECT_EQ("test", timeline.allocator_name());
+  EXPECT_EQ(0, timeline.num_dropped_events());
+  ASSERT_EQ(3, timeline.events_size());
+  EXPECT_EQ(1024, timeline.events(0).bytes());
+  EXPECT_EQ("matmul", timeline.events(0).op_name());
+  EXPECT_EQ(42, timeline.events(0).step_id());
+  EXPECT_EQ(4096, timeline.events(1).bytes());
+  EXPECT_EQ("", timeline.events(1).op_name());
+  EXPECT_EQ(5120, timeline.events(1).bytes_in_use());
+  EXPECT_EQ(-1024, timeline.events(2).bytes());
+  EXPECT_EQ(4096, timeline.events(2).bytes_in_use());
+  int64 bytes_in_use = 0;
+  for (const AllocatorBinStats& bin : timeline.bins()) {
+    bytes_in_use += bin.bytes_in_use();
+  }
+  EXPECT_EQ(4096, bytes_in_use);
+
+  // Only the last 3 events are kept.
+  for (int i = 0; i < 5; ++i) {
+    a.DeallocateRaw(a.AllocateRaw(4, 256));
+  }
+  a.DeallocateRaw(q);
+  timeline.Clear();
+  a.ExportTimeline(&timeline);
+  EXPECT_EQ(8, timeline.num_dropped_events());
+  ASSERT_EQ(3, timeline.events_size());
+  EXPECT_EQ(-4096, timeline.events(2).bytes());
+  EXPECT_EQ(0, timeline.events(2).bytes_in_use());
+}
+
+// Backs the whole reservation with host memory, and checks and records
+// which pages are mapped.
+class FakeVirtualMemorySubAllocator : public VirtualMemorySubAllocator {
+ public:
+  static const size_t kPageSize = 64 << 10;
+
+  ~FakeVirtualMemorySubAllocator() override { CHECK(base_ == nullptr); }
+
+  size_t page_size() const override { return kPageSize; }
+
+  void* Reserve(size_t num_bytes) override {
+    CHECK(base_ == nullptr);
+    CHECK_EQ(0, num_bytes % kPageSize);
+    base_ = static_cast<char*>(port::AlignedMalloc(num_bytes, kPageSize));
+    mapped_.assign(num_bytes / kPageSize, false);
+    return base_;
+  }
+
+  void Unreserve(void* ptr, size_t num_bytes) override {
+    CHECK_EQ(base_, ptr);
+    CHECK_EQ(0, mapped_bytes());
+    port::AlignedFree(base_);
+    base_ = nullptr;
+  }
+
+  bool Map(void* ptr, size_t num_bytes) override {
+    if (mapped_bytes() + num_bytes > max_mapped_bytes_) return false;
+    SetMapped(ptr, num_bytes, true);
+    return true;
+  }
+
+  void Unmap(void* ptr, size_t num_bytes) override {
+    SetMapped(ptr, num_bytes, false);
+  }
+
+  size_t mapped_bytes() const {
+    return std::count(mapped_.begin(), mapped_.end(), true) * kPageSize;
+  }
+
+  void set_max_mapped_bytes(size_t max_bytes) { max_mapped_bytes_ = max_bytes; }
+
+ private:
+  void SetMapped(void* ptr, size_t num_bytes, bool mapped) {
+    const size_t offset = static_cast<char*>(ptr) - base_;
+    CHECK_EQ(0, offset % kPageSize);
+    CHECK_EQ(0, num_bytes % kPageSize);
+    for (size_t i = offset / kPageSize; i < (offset + num_bytes) / kPageSize;
+         ++i) {
+      CHECK_NE(mapped, mapped_[i]);
+      mapped_[i] = mapped;
+    }
+  }
+
+  char* base_ = nullptr;
+  std::vector<bool> mapped_;
+  size_t max_mapped_bytes_ = ~size_t{0};
+};
+
+const size_t FakeVirtualMemorySubAllocator::kPageSize;
+
+class BFCAllocatorVirtualMemoryTest : public ::testing::Test {
+ protected:
+  BFCAllocatorVirtualMemoryTest()
+      : sub_allocator_(new FakeVirtualMemorySubAllocator),
+        allocator_(new BFCAllocator(sub_allocator_, 64 << 20, "test")) {}
+
+  FakeVirtualMemorySubAllocator* sub_allocator_;  // Owned by allocator_.
+  std::unique_ptr<BFCAllocator> allocator_;
+};
+
+TEST_F(BFCAllocatorVirtualMemoryTest, GrowsContiguously) {
+  // The first mapping is 1MiB, and the second 2MiB.
+  void* a = allocator_->AllocateRaw(4, 1 << 20);
+  EXPECT_EQ(1 << 20, sub_allocator_->mapped_bytes());
+  void* b = allocator_->AllocateRaw(4, 1 << 20);
+  EXPECT_EQ(3 << 20, sub_allocator_->mapped_bytes());
+  EXPECT_EQ(static_cast<char*>(a) + (1 << 20), b);
+  allocator_->DeallocateRaw(a);
+  allocator_->DeallocateRaw(b);
+
+  // The chunks of both mappings coalesced.
+  void* c = allocator_->AllocateRaw(4, 3 << 20);
+  EXPECT_EQ(a, c);
+  EXPECT_EQ(3 << 20, sub_allocator_->mapped_bytes());
+  std::memset(c, 0, 3 << 20);
+  allocator_->DeallocateRaw(c);
+}
+
+TEST_F(BFCAllocatorVirtualMemoryTest, ExtendsFreeTail) {
+  void* a = allocator_->AllocateRaw(4, 512 << 10);
+  // Uses the free 512KiB at the end of the first mapping.
+  void* b = allocator_->AllocateRaw(4, 1 << 20);
+  EXPECT_EQ(static_cast<char*>(a) + (512 << 10), b);
+  allocator_->DeallocateRaw(a);
+  allocator_->DeallocateRaw(b);
+}
+
+TEST_F(BFCAllocatorVirtualMemoryTest, MapsOnlyWhatIsNeededUnderPressure) {
+  sub_allocator_->set_max_mapped_bytes(1 << 20);
+  void* a = allocator_->AllocateRaw(4, 512 << 10);
+  void* b = allocator_->AllocateRaw(4, 512 << 10);
+  EXPECT_NE(nullptr, b);
+  allocator_->DeallocateRaw(a);
+  allocator_->DeallocateRaw(b);
+  EXPECT_EQ(1 << 20, sub_allocator_->mapped_bytes());
+
+  // Mapping 2MiB fails, but 64KiB succeeds.
+  sub_allocator_->set_max_mapped_bytes((1 << 20) + (64 << 10));
+  void* c = allocator_->AllocateRaw(4, (1 << 20) + 1000);
+  EXPECT_EQ(a, c);
+  EXPECT_EQ((1 << 20) + (64 << 10), sub_allocator_->mapped_bytes());
+  allocator_->DeallocateRaw(c);
+}
+
+TEST_F(BFCAllocatorVirtualMemoryTest, ReleaseIdleMemory) {
+  void* a = allocator_->AllocateRaw(4, 100 << 10);
+  EXPECT_EQ(1 << 20, sub_allocator_->mapped_bytes());
+  // The page shared with 'a' stays mapped.
+  EXPECT_EQ((1 << 20) - (128 << 10), allocator_->ReleaseIdleMemory());
+  EXPECT_EQ(128 << 10, sub_allocator_->mapped_bytes());
+  EXPECT_EQ(0, allocator_->ReleaseIdleMemory());
+  std::memset(a, 0, 100 << 10);
+
+  void* b = allocator_->AllocateRaw(4, 1 << 20);
+  EXPECT_EQ(static_cast<char*>(a) + (100 << 10), b);
+  allocator_->DeallocateRaw(a);
+  allocator_->DeallocateRaw(b);
+  EXPECT_LT(0, allocator_->ReleaseIdleMemory());
+  EXPECT_EQ(0, sub_allocator_->mapped_bytes());
+
+  // Memory is mapped again on demand.
+  a = allocator_->AllocateRaw(4, 4096);
+  EXPECT_NE(nullptr, a);
+  allocator_->DeallocateRaw(a);
+}
+
+TEST_F(BFCAllocatorVirtualMemoryTest, Limit) {
+  void* a = allocator_->AllocateRaw(4, 60 << 20);
+  EXPECT_NE(nullptr, a);
+  AllocationAttributes no_retry;
+  no_retry.no_retry_on_failure = true;
+  EXPECT_EQ(nullptr, allocator_->AllocateRaw(4, 8 << 20, no_retry));
+  allocator_->DeallocateRaw(a);
+}
+
+}  // namespace
+}  // namespace tensorflow
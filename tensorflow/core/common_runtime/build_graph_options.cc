@@ -32,6 +32,12 @@ string BuildGraphOptions::DebugString() const {
   for (auto& s : target_nodes) {
     strings::StrAppend(&rv, s, ", ");
   }
+  if (!feed_shapes.empty()) {
+    strings::StrAppend(&rv, "\nFeed shapes: ");
+    for (auto& s : feed_shapes) {
+      strings::StrAppend(&rv, s.DebugString(), ", ");
+    }
+  }
   return rv;
 }
 
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <vector>
 
+#include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/protobuf/debug.pb.h"
 
@@ -36,6 +37,10 @@ struct BuildGraphOptions {
   // TODO(mrry): Remove this when the distributed runtime supports Arg/Retval.
   bool use_function_convention = false;
 
+  // If not empty, the shapes of the tensors fed to `feed_endpoints`, in the
+  // same order, to which the graph may be specialized.
+  std::vector<TensorShape> feed_shapes;
+
   DebugOptions debug_options;
 
   string DebugString() const;
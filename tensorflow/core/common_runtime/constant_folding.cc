@@ -33,10 +33,11 @@ limitations under the License.
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/graph/subgraph.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/threadpool.h"
-#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/public/session_options.h"
 
 namespace tensorflow {
@@ -549,6 +550,93 @@ bool ReplaceTensorWithConstant(Graph* graph, Device* partition_device,
   return true;
 }
 
+// Returns true if output 'output' of 'n' is known from opts.shape_map to be
+// larger than opts.max_constant_size_in_bytes, in which case it would not be
+// replaced by a constant anyway.
+bool ExceedsConstantSizeBudget(const Node* n, int output,
+                               const ConstantFoldingOptions& opts) {
+  if (opts.shape_map == nullptr) return false;
+  const auto shapes = opts.shape_map->find(n->name());
+  if (shapes == opts.shape_map->end() || output >= shapes->second.size()) {
+    return false;
+  }
+  const PartialTensorShape& shape = shapes->second[output];
+  const int64 element_size = DataTypeSize(n->output_type(output));
+  if (!shape.IsFullyDefined() || element_size == 0) return false;
+  return shape.num_elements() * element_size > opts.max_constant_size_in_bytes;
+}
+
+// Partitions the constant foldable 'nodes', in topological order, into groups
+// of nodes connected by the data edges of the constant graph. Each group is
+// in topological order, and can be evaluated independently of the others.
+std::vector<std::vector<Node*>> IndependentConstantSubgraphs(
+    const Graph* graph, const std::vector<Node*>& nodes,
+    const std::unordered_map<const Node*, std::vector<Tensor>>&
+        shape_replacement_map) {
+  // A union-find forest over the ids of 'nodes'. -1 marks other nodes.
+  std::vector<int> parent(graph->num_node_ids(), -1);
+  for (Node* n : nodes) parent[n->id()] = n->id();
+  auto find = [&parent](int id) {
+    while (parent[id] != id) {
+      parent[id] = parent[parent[id]];
+      id = parent[id];
+    }
+    return id;
+  };
+  for (Node* n : nodes) {
+    // The inputs of replaced shape nodes are not part of the constant graph.
+    if (shape_replacement_map.count(n) != 0) continue;
+    for (const Edge* in : n->in_edges()) {
+      if (in->IsControlEdge() || parent[in->src()->id()] == -1) continue;
+      parent[find(in->src()->id())] = find(n->id());
+    }
+  }
+  std::vector<std::vector<Node*>> subgraphs;
+  std::unordered_map<int, int> subgraph_index;
+  for (Node* n : nodes) {
+    auto it = subgraph_index.emplace(find(n->id()), subgraphs.size()).first;
+    if (it->second == subgraphs.size()) subgraphs.emplace_back();
+    subgraphs[it->second].push_back(n);
+  }
+  return subgraphs;
+}
+
+// A graph evaluating constant foldable nodes, and the tensors of the
+// original graph to replace by its outputs.
+struct ConstantSubgraph {
+  std::unique_ptr<Graph> graph;
+  std::vector<string> tensors_to_fetch_names;
+  std::vector<NodeAndOutput> tensors_to_replace;
+};
+
+// Builds the constant graph of the constant foldable 'nodes' into
+// 'subgraph'. Tensors that are known to exceed the constant size budget are
+// not fetched, so that the nodes only computing them are not evaluated.
+// Returns false if there is nothing to fetch.
+bool BuildConstantSubgraph(
+    const Graph* graph, const std::vector<Node*>& nodes,
+    const ConstantFoldingOptions& opts,
+    const std::unordered_map<const Node*, std::vector<Tensor>>&
+        shape_replacement_map,
+    ConstantSubgraph* subgraph) {
+  std::map<NodeAndOutput, Node*> tensors_to_fetch;
+  subgraph->graph.reset(GetConstantGraph(graph, nodes, shape_replacement_map,
+                                         &tensors_to_fetch));
+  DumpGraph("Constant graph", subgraph->graph.get());
+  for (auto n : tensors_to_fetch) {
+    if (ExceedsConstantSizeBudget(n.second, n.first.second, opts)) {
+      VLOG(1) << "Not evaluating " << n.second->name() << " :: "
+              << n.first.second << ", which is larger than "
+              << opts.max_constant_size_in_bytes << " bytes";
+      continue;
+    }
+    subgraph->tensors_to_fetch_names.push_back(
+        strings::StrCat(n.first.first->name(), ":", n.first.second));
+    subgraph->tensors_to_replace.push_back({n.second, n.first.second});
+  }
+  return !subgraph->tensors_to_fetch_names.empty();
+}
+
 }  // namespace
 
 Status ConstantFold(const ConstantFoldingOptions& opts,
@@ -568,64 +656,87 @@ Status ConstantFold(const ConstantFoldingOptions& opts,
     return Status::OK();
   }
 
-  std::map<NodeAndOutput, Node*> tensors_to_fetch;
-  std::unique_ptr<Graph> constant_graph(
-      GetConstantGraph(graph, constant_foldable_nodes, shape_replacement_map,
-                       &tensors_to_fetch));
-  DumpGraph("Constant graph", constant_graph.get());
-
-  if (tensors_to_fetch.empty()) {
+  // Without a runner, all the constant foldable nodes are evaluated by a
+  // single graph.
+  std::vector<std::vector<Node*>> node_groups;
+  if (opts.runner) {
+    node_groups = IndependentConstantSubgraphs(graph, constant_foldable_nodes,
+                                               shape_replacement_map);
+  } else {
+    node_groups.push_back(std::move(constant_foldable_nodes));
+  }
+
+  // The constant graphs are all built before any tensor of 'graph' is
+  // replaced.
+  std::vector<ConstantSubgraph> subgraphs(node_groups.size());
+  int num_subgraphs = 0;
+  int num_constant_nodes = 0;
+  for (const std::vector<Node*>& nodes : node_groups) {
+    ConstantSubgraph* subgraph = &subgraphs[num_subgraphs];
+    if (BuildConstantSubgraph(graph, nodes, opts, shape_replacement_map,
+                              subgraph)) {
+      num_constant_nodes += subgraph->graph->num_node_ids();
+      ++num_subgraphs;
+    }
+  }
+  subgraphs.resize(num_subgraphs);
+  if (subgraphs.empty()) {
     VLOG(1) << "No constant nodes found that feed into the original graph.";
     *was_mutated = false;
     // This is not an error, so return the status as OK.
     return Status::OK();
   }
-  VLOG(1) << "Constant foldable " << constant_graph->num_node_ids() << " : "
-          << graph->num_node_ids();
+  VLOG(1) << "Constant foldable " << num_constant_nodes << " : "
+          << graph->num_node_ids() << " in " << subgraphs.size()
+          << " subgraphs";
 
-  std::vector<string> tensors_to_fetch_names;
-  std::vector<NodeAndOutput> tensors_to_replace;
-  for (auto n : tensors_to_fetch) {
-    tensors_to_fetch_names.push_back(
-        strings::StrCat(n.first.first->name(), ":", n.first.second));
-    tensors_to_replace.push_back({n.second, n.first.second});
-  }
-
-  auto graph_runner = std::unique_ptr<GraphRunner>(new GraphRunner(env));
-  // Evaluate the constant foldable nodes.
-  std::vector<Tensor> outputs;
-  auto delete_tensors = gtl::MakeCleanup([&graph_runner, &outputs] {
-    // Output tensors need to be cleared before the GraphRunner is deleted.
-    outputs.clear();
-    graph_runner.reset(nullptr);
-  });
-
-  Status s =
-      graph_runner->Run(constant_graph.get(), function_library, {} /* inputs*/,
-                        tensors_to_fetch_names, &outputs);
-  if (!s.ok()) {
-    VLOG(1) << "Could not fetch constants: " << s;
-    *was_mutated = false;
-    return s;
-  }
-
-  // Fetch the constant tensors and replace the corresponding tensors in the
-  // original graph with those constants.
+  GraphRunner graph_runner(env);
+  mutex mu;
+  Status status;
   int32 num_nodes_replaced = 0;
-  for (size_t c = 0; c < outputs.size(); ++c) {
-    const gtl::FlatSet<Node*>& control_deps =
-        constant_control_deps[tensors_to_replace[c].first];
-    if (ReplaceTensorWithConstant(
-            graph, partition_device, tensors_to_replace[c], outputs[c],
-            control_deps, opts.max_constant_size_in_bytes)) {
-      ++num_nodes_replaced;
+  // Evaluates the constant foldable nodes of 'subgraph', and replaces the
+  // corresponding tensors in the original graph with constants. The
+  // replacements are serialized by 'mu', and each subgraph releases its
+  // outputs once they are replaced.
+  auto fold = [&](const ConstantSubgraph& subgraph) {
+    std::vector<Tensor> outputs;
+    Status s = graph_runner.Run(subgraph.graph.get(), function_library,
+                                {} /* inputs*/, subgraph.tensors_to_fetch_names,
+                                &outputs);
+    mutex_lock l(mu);
+    if (!s.ok()) {
+      VLOG(1) << "Could not fetch constants: " << s;
+      status.Update(s);
+      return;
+    }
+    for (size_t c = 0; c < outputs.size(); ++c) {
+      const NodeAndOutput& tensor = subgraph.tensors_to_replace[c];
+      const gtl::FlatSet<Node*>& control_deps =
+          constant_control_deps[tensor.first];
+      if (ReplaceTensorWithConstant(graph, partition_device, tensor,
+                                    outputs[c], control_deps,
+                                    opts.max_constant_size_in_bytes)) {
+        ++num_nodes_replaced;
+      }
     }
+  };
+  if (subgraphs.size() > 1) {
+    BlockingCounter counter(subgraphs.size());
+    for (const ConstantSubgraph& subgraph : subgraphs) {
+      opts.runner([&fold, &subgraph, &counter]() {
+        fold(subgraph);
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  } else {
+    fold(subgraphs[0]);
   }
 
   DumpGraph("After", graph);
 
   *was_mutated = (num_nodes_replaced > 0);
-  return Status::OK();
+  return status;
 }
 
 }  // namespace tensorflow
@@ -35,8 +35,14 @@ struct ConstantFoldingOptions {
   const std::unordered_map<string, std::vector<PartialTensorShape>>* shape_map =
       nullptr;  // not owned
   // The maximum size of each constant created during constant folding
-  // optimization.
+  // optimization. Tensors that shape_map shows to be larger are not
+  // evaluated at all.
   int64 max_constant_size_in_bytes = 10 * 1024 * 1024;
+  // If "runner" is not nullptr, the constant foldable nodes are split into
+  // independent subgraphs, which are evaluated concurrently by closures
+  // passed to runner. ConstantFold() blocks until they are all done, so
+  // runner must not depend on the calling thread to make progress.
+  std::function<void(std::function<void()>)> runner = nullptr;
 };
 
 // Perform constant folding optimization on "graph".
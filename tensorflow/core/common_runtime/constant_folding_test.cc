@@ -268,6 +268,80 @@ TEST_F(ConstantFoldingTest, TestNoReplaceLargeConstant) {
   EXPECT_TRUE(was_mutated);
 }
 
+TEST_F(ConstantFoldingTest, TestNoEvaluateLargeConstant) {
+  Graph g(OpRegistry::Global());
+  {
+    Scope s = Scope::NewRootScope();
+    auto a = ops::Const<float>(s, {1.0, 2.0}, {2});
+    auto b = ops::Const<float>(s, {3.0, 4.0}, {2});
+    auto small = ops::Add(s.WithOpName("small"), a, b);
+    auto large = ops::Mul(s.WithOpName("large"), a, b);
+    ops::_Send(s.WithOpName("small_send"), small, "small_send", "sender", 0,
+               "receiver");
+    ops::_Send(s.WithOpName("large_send"), large, "large_send", "sender", 0,
+               "receiver");
+    TF_ASSERT_OK(s.ToGraph(&g));
+  }
+  // The shape map claims that "large" has 1M elements, so it is not even
+  // evaluated.
+  std::unordered_map<string, std::vector<PartialTensorShape>> map;
+  map["small"].push_back(PartialTensorShape({2}));
+  map["large"].push_back(PartialTensorShape({1024 * 1024}));
+  ConstantFoldingOptions opts;
+  opts.shape_map = &map;
+  opts.max_constant_size_in_bytes = 1024 * 1024;
+  bool was_mutated;
+  TF_EXPECT_OK(
+      ConstantFold(opts, nullptr, Env::Default(), nullptr, &g, &was_mutated));
+  EXPECT_TRUE(was_mutated);
+
+  std::unordered_map<string, Node*> index = NodeNameIndex(g);
+  Node* small_send = index.at("small_send");
+  ASSERT_EQ(1, small_send->num_inputs());
+  ExpectNodeClose<float>(*(small_send->in_nodes().begin()), {4.0, 6.0}, {2});
+  Node* large_send = index.at("large_send");
+  ASSERT_EQ(1, large_send->num_inputs());
+  EXPECT_EQ(index.at("large"), *(large_send->in_nodes().begin()));
+}
+
+TEST_F(ConstantFoldingTest, Parallel) {
+  Graph g(OpRegistry::Global());
+  const int kNumSubgraphs = 8;
+  {
+    Scope s = Scope::NewRootScope();
+    auto shared = ops::Const<float>(s, {1.0, 2.0}, {2});
+    for (int i = 0; i < kNumSubgraphs; ++i) {
+      auto c = ops::Const<float>(s, {static_cast<float>(i), 1.0}, {2});
+      auto m = ops::Mul(s.WithOpName(strings::StrCat("m", i)), c, c);
+      // Subgraphs 0 and 1 share a constant, so they are evaluated together.
+      Output out = m;
+      if (i < 2) out = ops::Add(s, m, shared);
+      ops::_Send(s.WithOpName(strings::StrCat("send", i)), out,
+                 strings::StrCat("send", i), "sender", 0, "receiver");
+    }
+    TF_ASSERT_OK(s.ToGraph(&g));
+  }
+
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  ConstantFoldingOptions opts;
+  opts.runner = [&pool](std::function<void()> c) { pool.Schedule(c); };
+  bool was_mutated;
+  TF_EXPECT_OK(
+      ConstantFold(opts, nullptr, Env::Default(), nullptr, &g, &was_mutated));
+  EXPECT_TRUE(was_mutated);
+
+  std::unordered_map<string, Node*> index = NodeNameIndex(g);
+  for (int i = 0; i < kNumSubgraphs; ++i) {
+    Node* send = index.at(strings::StrCat("send", i));
+    ASSERT_EQ(1, send->num_inputs());
+    const float shared_value = i < 2 ? 1.0 : 0.0;
+    ExpectNodeClose<float>(*(send->in_nodes().begin()),
+                           {static_cast<float>(i * i) + shared_value,
+                            1.0f + 2 * shared_value},
+                           {2});
+  }
+}
+
 TEST_F(ConstantFoldingTest, TestNoReplaceFunctionCall) {
   FunctionDefLibrary flib;
   *flib.add_function() = test::function::XTimesTwo();
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <atomic>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/constant_folding.h"
@@ -27,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/graph_optimizer.h"
 #include "tensorflow/core/common_runtime/memory_types.h"
 #include "tensorflow/core/common_runtime/optimization_registry.h"
+#include "tensorflow/core/common_runtime/priority_scheduler.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/graph.pb_text.h"
@@ -34,6 +36,7 @@ limitations under the License.
 #include "tensorflow/core/framework/graph_def_util.h"
 #include "tensorflow/core/framework/log_memory.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
@@ -56,6 +59,7 @@ limitations under the License.
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/env_var.h"
@@ -72,6 +76,11 @@ auto* direct_session_runs = monitoring::Counter<0>::New(
     "/tensorflow/core/direct_session_runs",
     "The number of times DirectSession::Run() has been called.");
 
+auto* direct_session_executor_cache = monitoring::Counter<1>::New(
+    "/tensorflow/core/direct_session_executor_cache",
+    "The number of DirectSession executor cache hits, misses and evictions.",
+    "outcome");
+
 int32 NumInterOpThreadsFromSessionOptions(const SessionOptions& options) {
   const int32 t = options.config.inter_op_parallelism_threads();
   if (t != 0) return t;
@@ -136,6 +145,45 @@ thread::ThreadPool* GlobalThreadPool(const SessionOptions& options) {
   return thread_pool;
 }
 
+// Returns true if 'options' asks for one inter-op pool per NUMA node.
+bool UseNUMAThreadPools(const SessionOptions& options) {
+  return options.config.experimental().use_numa_affinity() &&
+         options.config.session_inter_op_thread_pool_size() == 0 &&
+         port::NUMAEnabled();
+}
+
+// Creates one inter-op pool per NUMA node, whose threads are pinned to the
+// node's cores. The inter-op threads are split evenly across the nodes.
+std::vector<thread::ThreadPool*> NewNUMAThreadPoolsFromSessionOptions(
+    const SessionOptions& options) {
+  const int num_nodes = port::NUMANumNodes();
+  std::vector<thread::ThreadPool*> pools;
+  for (int node = 0; node < num_nodes; ++node) {
+    int32 num_threads = options.config.inter_op_parallelism_threads();
+    if (num_threads == 0) {
+      num_threads = port::NUMANumNodeCPUs(node);
+    } else {
+      num_threads = std::max(1, num_threads / num_nodes);
+    }
+    VLOG(1) << "Direct session inter op parallelism threads for NUMA node "
+            << node << ": " << num_threads;
+    ThreadOptions thread_options;
+    thread_options.numa_node = node;
+    pools.push_back(new thread::ThreadPool(
+        options.env, thread_options, strings::StrCat("Compute_numa", node),
+        num_threads));
+  }
+  return pools;
+}
+
+const std::vector<thread::ThreadPool*>& GlobalNUMAThreadPools(
+    const SessionOptions& options) {
+  static const std::vector<thread::ThreadPool*>* const thread_pools =
+      new std::vector<thread::ThreadPool*>(
+          NewNUMAThreadPoolsFromSessionOptions(options));
+  return *thread_pools;
+}
+
 // TODO(vrv): Figure out how to unify the many different functions
 // that generate RendezvousKey, since many of them have to be
 // consistent with each other.
@@ -253,6 +301,21 @@ void DirectSession::SchedClosure(thread::ThreadPool* pool,
 #endif  // __ANDROID__
 }
 
+Executor::Args::Runner DirectSession::MakeRunner(thread::ThreadPool* pool,
+                                                 int priority) {
+#ifndef __ANDROID__
+  if (options_.config.experimental().inter_op_priority_scheduling()) {
+    PriorityScheduler* scheduler = PriorityScheduler::ForPool(pool);
+    return [scheduler, priority](Executor::Args::Closure c) {
+      scheduler->Schedule(priority, std::move(c));
+    };
+  }
+#endif  // __ANDROID__
+  return [this, pool](Executor::Args::Closure c) {
+    SchedClosure(pool, std::move(c));
+  };
+}
+
 DirectSession::DirectSession(const SessionOptions& options,
                              const DeviceMgr* device_mgr,
                              DirectSessionFactory* const factory)
@@ -277,6 +340,26 @@ DirectSession::DirectSession(const SessionOptions& options,
   } else {
     thread_pools_.emplace_back(GlobalThreadPool(options), false /* owned */);
   }
+  if (UseNUMAThreadPools(options_)) {
+    if (options_.config.use_per_session_threads()) {
+      numa_thread_pools_ = NewNUMAThreadPoolsFromSessionOptions(options_);
+      owns_numa_thread_pools_ = true;
+    } else {
+      numa_thread_pools_ = GlobalNUMAThreadPools(options_);
+    }
+  }
+  const int64 spin_wait_micros =
+      options_.config.experimental().inter_op_spin_wait_micros();
+  const bool thread_pool_stats =
+      options_.config.experimental().thread_pool_stats();
+  std::vector<thread::ThreadPool*> pools = numa_thread_pools_;
+  for (const auto& p_and_owned : thread_pools_) {
+    if (p_and_owned.first) pools.push_back(p_and_owned.first);
+  }
+  for (thread::ThreadPool* pool : pools) {
+    if (spin_wait_micros > 0) pool->SetSpinWaitMicros(spin_wait_micros);
+    if (thread_pool_stats) pool->SetCollectStats(true);
+  }
   // The default value of sync_on_finish will be flipped soon and this
   // environment variable will be removed as well.
   const Status status =
@@ -314,6 +397,7 @@ DirectSession::DirectSession(const SessionOptions& options,
 
 DirectSession::~DirectSession() {
   if (!closed_) Close().IgnoreError();
+  callables_.clear();
   for (auto& it : partial_runs_) {
     it.second.reset(nullptr);
   }
@@ -325,7 +409,16 @@ DirectSession::~DirectSession() {
   }
   delete cancellation_manager_;
   for (const auto& p_and_owned : thread_pools_) {
-    if (p_and_owned.second) delete p_and_owned.first;
+    if (p_and_owned.second) {
+      delete p_and_owned.first;
+      PriorityScheduler::RemovePool(p_and_owned.first);
+    }
+  }
+  if (owns_numa_thread_pools_) {
+    for (thread::ThreadPool* pool : numa_thread_pools_) {
+      delete pool;
+      PriorityScheduler::RemovePool(pool);
+    }
   }
 
   execution_state_.reset(nullptr);
@@ -431,29 +524,13 @@ Status DirectSession::DecorateAndPublishGraphForDebug(
   return Status::OK();
 }
 
-Status DirectSession::Run(const RunOptions& run_options,
-                          const NamedTensorList& inputs,
-                          const std::vector<string>& output_names,
-                          const std::vector<string>& target_nodes,
-                          std::vector<Tensor>* outputs,
-                          RunMetadata* run_metadata) {
-  TF_RETURN_IF_ERROR(CheckNotClosed());
-  direct_session_runs->GetCell()->IncrementBy(1);
-  {
-    mutex_lock l(graph_def_lock_);
-    if (!graph_created_) {
-      return errors::InvalidArgument(
-          "Session was not created with a graph before Run()!");
-    }
-  }
-
-  // Extract the inputs names for this run of the session.
-  std::vector<string> input_tensor_names;
-  input_tensor_names.reserve(inputs.size());
-  for (const auto& it : inputs) {
-    input_tensor_names.push_back(it.first);
-  }
-
+Status DirectSession::RunInternal(int64 step_id, const RunOptions& run_options,
+                                  FunctionCallFrame* call_frame,
+                                  ExecutorsAndKeys* executors_and_keys,
+                                  const string& run_state_handle,
+                                  const std::vector<string>& output_names,
+                                  int64 executor_step_count,
+                                  RunMetadata* run_metadata) {
   if (run_options.inter_op_thread_pool() < 0 ||
       run_options.inter_op_thread_pool() >= thread_pools_.size()) {
     return errors::InvalidArgument("Invalid inter_op_thread_pool: ",
@@ -462,53 +539,14 @@ Status DirectSession::Run(const RunOptions& run_options,
   thread::ThreadPool* pool =
       thread_pools_[run_options.inter_op_thread_pool()].first;
 
-  // Check if we already have an executor for these arguments.
-  ExecutorsAndKeys* executors_and_keys;
-  RunStateArgs run_state_args(run_options.debug_options());
-
   Executor::Args args;
-  args.step_id = step_id_counter_.fetch_add(1);
-
-  TF_RETURN_IF_ERROR(
-      GetOrCreateExecutors(input_tensor_names, output_names, target_nodes,
-                           &executors_and_keys, &run_state_args));
-  const int64 executor_step_count = executors_and_keys->step_count.fetch_add(1);
-
-  std::unique_ptr<DebuggerStateInterface> debugger_state;
-  if (!run_options.debug_options().debug_tensor_watch_opts().empty()) {
-    TF_RETURN_IF_ERROR(CreateDebuggerState(
-        run_options.debug_options(), args.step_id, executor_step_count,
-        input_tensor_names, output_names, target_nodes, &debugger_state));
-  }
-
-  // Configure a call frame for the step, which we use to feed and
-  // fetch values to and from the executors.
-  FunctionCallFrame call_frame(executors_and_keys->input_types,
-                               executors_and_keys->output_types);
-  gtl::InlinedVector<Tensor, 4> feed_args(inputs.size());
-  for (const auto& it : inputs) {
-    if (it.second.dtype() == DT_RESOURCE) {
-      Tensor tensor_from_handle;
-      TF_RETURN_IF_ERROR(
-          ResourceHandleToInputTensor(it.second, &tensor_from_handle));
-      feed_args[executors_and_keys->input_name_to_index[it.first]] =
-          tensor_from_handle;
-    } else {
-      feed_args[executors_and_keys->input_name_to_index[it.first]] = it.second;
-    }
-  }
-  const Status s = call_frame.SetArgs(feed_args);
-  if (errors::IsInternal(s)) {
-    return errors::InvalidArgument(s.error_message());
-  } else if (!s.ok()) {
-    return s;
-  }
+  args.step_id = step_id;
 
   // Create a run state and start execution.
   RunState run_state(args.step_id, &devices_);
   run_state.rendez = new IntraProcessRendezvous(device_mgr_.get());
   CancellationManager step_cancellation_manager;
-  args.call_frame = &call_frame;
+  args.call_frame = call_frame;
 
   // Start parallel Executors.
   const size_t num_executors = executors_and_keys->items.size();
@@ -523,14 +561,12 @@ Status DirectSession::Run(const RunOptions& run_options,
 
   args.rendezvous = run_state.rendez;
   args.cancellation_manager = &step_cancellation_manager;
-  args.runner = [this, pool](Executor::Args::Closure c) {
-    SchedClosure(pool, std::move(c));
-  };
+  args.runner = MakeRunner(pool, run_options.priority());
   args.session_state = &session_state_;
   args.tensor_store = &run_state.tensor_store;
   args.step_container = &run_state.step_container;
   if (LogMemory::IsEnabled()) {
-    LogMemory::RecordStep(args.step_id, run_state_args.handle);
+    LogMemory::RecordStep(args.step_id, run_state_handle);
   }
   args.sync_on_finish = sync_on_finish_;
 
@@ -552,6 +588,17 @@ Status DirectSession::Run(const RunOptions& run_options,
     run_state.collector.reset(
         new StepStatsCollector(run_metadata->mutable_step_stats()));
     args.stats_collector = run_state.collector.get();
+  } else {
+    const ConfigProto::Experimental& experimental =
+        options_.config.experimental();
+    if (experimental.sampled_trace_period() > 0 &&
+        executor_step_count % experimental.sampled_trace_period() == 0) {
+      args.sampled_trace_node_fraction =
+          experimental.sampled_trace_node_fraction() > 0
+              ? experimental.sampled_trace_node_fraction()
+              : 1.0f;
+      args.sampled_trace_memory = experimental.sampled_trace_memory();
+    }
   }
 
 #if GOOGLE_CUDA
@@ -581,7 +628,16 @@ Status DirectSession::Run(const RunOptions& run_options,
     return errors::Cancelled("Run call was cancelled");
   }
 
+  // With NUMA pools, each CPU partition runs on the pool of its device's
+  // node, so that a node and its consumers stay on one socket.
+  const bool use_numa_pools =
+      !numa_thread_pools_.empty() && run_options.inter_op_thread_pool() == 0;
   for (const auto& item : executors_and_keys->items) {
+    if (use_numa_pools) {
+      thread::ThreadPool* device_pool =
+          NUMAThreadPoolForDevice(item.flib->device(), pool);
+      args.runner = MakeRunner(device_pool, run_options.priority());
+    }
     item.executor->RunAsync(args, barrier->Get());
   }
 
@@ -610,6 +666,148 @@ Status DirectSession::Run(const RunOptions& run_options,
     TF_RETURN_IF_ERROR(run_state.status);
   }
 
+  // Save the output tensors of this run we choose to keep.
+  TF_RETURN_IF_ERROR(
+      run_state.tensor_store.SaveTensors(output_names, &session_state_));
+  if (args.stats_collector) {
+    args.stats_collector->Finalize();
+  }
+
+  if (run_options.trace_level() >= RunOptions::FULL_TRACE) {
+    // Devices may share an allocator.
+    std::unordered_set<Allocator*> exported;
+    for (Device* device : devices_) {
+      Allocator* allocator = device->GetAllocator(AllocatorAttributes());
+      if (!exported.insert(allocator).second) continue;
+      AllocatorTimeline timeline;
+      if (allocator->ExportTimeline(&timeline)) {
+        run_metadata->mutable_step_stats()->add_allocator_timelines()->Swap(
+            &timeline);
+      }
+    }
+  }
+
+  // Build and return the cost model as instructed.
+  mutex_lock l(executor_lock_);
+  if (update_cost_model) {
+    // Build the cost model
+    std::unordered_map<string, const Graph*> device_to_graph;
+    for (const PerPartitionExecutorsAndLib& partition :
+         executors_and_keys->items) {
+      const Graph* graph = partition.graph;
+      const string device = partition.flib->device()->name();
+      device_to_graph[device] = graph;
+    }
+    args.stats_collector->BuildCostModel(&cost_model_manager_, device_to_graph);
+
+    // annotate stats onto cost graph.
+    CostGraphDef* cost_graph = run_metadata->mutable_cost_graph();
+    for (const auto& item : executors_and_keys->items) {
+      TF_RETURN_IF_ERROR(
+          cost_model_manager_.AddToCostGraphDef(item.graph, cost_graph));
+    }
+  }
+
+  // If requested via RunOptions, output the partition graphs.
+  if (run_options.output_partition_graphs()) {
+    protobuf::RepeatedPtrField<GraphDef>* partition_graph_defs =
+        run_metadata->mutable_partition_graphs();
+    for (const PerPartitionExecutorsAndLib& exec_and_lib :
+         executors_and_keys->items) {
+      GraphDef* partition_graph_def = partition_graph_defs->Add();
+      exec_and_lib.graph->ToGraphDef(partition_graph_def);
+    }
+  }
+
+  return Status::OK();
+}
+
+thread::ThreadPool* DirectSession::NUMAThreadPoolForDevice(
+    const Device* device, thread::ThreadPool* default_pool) const {
+  if (device->device_type() != DEVICE_CPU) return default_pool;
+  const int numa_node = device->attributes().locality().numa_node();
+  if (numa_node < 0 || numa_node >= numa_thread_pools_.size()) {
+    return default_pool;
+  }
+  return numa_thread_pools_[numa_node];
+}
+
+Status DirectSession::Run(const RunOptions& run_options,
+                          const NamedTensorList& inputs,
+                          const std::vector<string>& output_names,
+                          const std::vector<string>& target_nodes,
+                          std::vector<Tensor>* outputs,
+                          RunMetadata* run_metadata) {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  direct_session_runs->GetCell()->IncrementBy(1);
+  {
+    mutex_lock l(graph_def_lock_);
+    if (!graph_created_) {
+      return errors::InvalidArgument(
+          "Session was not created with a graph before Run()!");
+    }
+  }
+
+  // Extract the inputs names for this run of the session.
+  std::vector<string> input_tensor_names;
+  input_tensor_names.reserve(inputs.size());
+  for (const auto& it : inputs) {
+    input_tensor_names.push_back(it.first);
+  }
+
+  // Check if we already have an executor for these arguments.
+  std::shared_ptr<ExecutorsAndKeys> executors_and_keys;
+  RunStateArgs run_state_args(run_options.debug_options());
+
+  const int64 step_id = step_id_counter_.fetch_add(1);
+
+  if (options_.config.experimental().shape_specialization_cache_size() > 0) {
+    for (const auto& it : inputs) {
+      if (it.second.dtype() != DT_RESOURCE) {
+        run_state_args.input_shapes[it.first] = it.second.shape();
+      }
+    }
+  }
+  TF_RETURN_IF_ERROR(
+      GetOrCreateExecutors(input_tensor_names, output_names, target_nodes,
+                           &executors_and_keys, &run_state_args));
+  const int64 executor_step_count = executors_and_keys->step_count.fetch_add(1);
+
+  std::unique_ptr<DebuggerStateInterface> debugger_state;
+  if (!run_options.debug_options().debug_tensor_watch_opts().empty()) {
+    TF_RETURN_IF_ERROR(CreateDebuggerState(
+        run_options.debug_options(), step_id, executor_step_count,
+        input_tensor_names, output_names, target_nodes, &debugger_state));
+  }
+
+  // Configure a call frame for the step, which we use to feed and
+  // fetch values to and from the executors.
+  FunctionCallFrame call_frame(executors_and_keys->input_types,
+                               executors_and_keys->output_types);
+  gtl::InlinedVector<Tensor, 4> feed_args(inputs.size());
+  for (const auto& it : inputs) {
+    if (it.second.dtype() == DT_RESOURCE) {
+      Tensor tensor_from_handle;
+      TF_RETURN_IF_ERROR(
+          ResourceHandleToInputTensor(it.second, &tensor_from_handle));
+      feed_args[executors_and_keys->input_name_to_index[it.first]] =
+          tensor_from_handle;
+    } else {
+      feed_args[executors_and_keys->input_name_to_index[it.first]] = it.second;
+    }
+  }
+  const Status s = call_frame.SetArgs(feed_args);
+  if (errors::IsInternal(s)) {
+    return errors::InvalidArgument(s.error_message());
+  } else if (!s.ok()) {
+    return s;
+  }
+
+  TF_RETURN_IF_ERROR(RunInternal(step_id, run_options, &call_frame,
+                                 executors_and_keys.get(),
+                                 run_state_args.handle, output_names,
+                                 executor_step_count, run_metadata));
+
   // Receive outputs.
   if (outputs) {
     std::vector<Tensor> sorted_outputs;
@@ -649,48 +847,158 @@ Status DirectSession::Run(const RunOptions& run_options,
     }
   }
 
-  // Save the output tensors of this run we choose to keep.
-  TF_RETURN_IF_ERROR(
-      run_state.tensor_store.SaveTensors(output_names, &session_state_));
-  if (args.stats_collector) {
-    args.stats_collector->Finalize();
+
+  return Status::OK();
+}
+
+Status DirectSession::MakeCallable(const CallableOptions& callable_options,
+                                   CallableHandle* out_handle) {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  {
+    mutex_lock l(graph_def_lock_);
+    if (!graph_created_) {
+      return errors::InvalidArgument(
+          "Session was not created with a graph before MakeCallable()!");
+    }
   }
 
-  // Build and return the cost model as instructed.
-  mutex_lock l(executor_lock_);
-  if (update_cost_model) {
-    // Build the cost model
-    std::unordered_map<string, const Graph*> device_to_graph;
-    for (const PerPartitionExecutorsAndLib& partition :
-         executors_and_keys->items) {
-      const Graph* graph = partition.graph;
-      const string device = partition.flib->device()->name();
-      device_to_graph[device] = graph;
+  std::shared_ptr<Callable> callable(new Callable);
+  callable->run_options = callable_options.run_options();
+  callable->feed_names.assign(callable_options.feed().begin(),
+                              callable_options.feed().end());
+  callable->fetch_names.assign(callable_options.fetch().begin(),
+                               callable_options.fetch().end());
+  callable->target_names.assign(callable_options.target().begin(),
+                                callable_options.target().end());
+
+  // Each feed maps to exactly one argument of the call frame, so a repeated
+  // feed would leave the order of `feed_tensors` ambiguous.
+  std::unordered_set<string> unique_feeds;
+  for (const string& feed : callable->feed_names) {
+    if (!unique_feeds.insert(feed).second) {
+      return errors::InvalidArgument("Duplicate feed in CallableOptions: ",
+                                     feed);
     }
-    args.stats_collector->BuildCostModel(&cost_model_manager_, device_to_graph);
+  }
 
-    // annotate stats onto cost graph.
-    CostGraphDef* cost_graph = run_metadata->mutable_cost_graph();
-    for (const auto& item : executors_and_keys->items) {
+  RunStateArgs run_state_args(callable->run_options.debug_options());
+  TF_RETURN_IF_ERROR(GetOrCreateExecutors(
+      callable->feed_names, callable->fetch_names, callable->target_names,
+      &callable->executors_and_keys, &run_state_args));
+  callable->run_state_handle = run_state_args.handle;
+
+  // Resolve the call frame indices once, so that RunCallable() does not have
+  // to look up any names.
+  const ExecutorsAndKeys* ek = callable->executors_and_keys.get();
+  callable->feed_arg_indices.reserve(callable->feed_names.size());
+  for (const string& feed : callable->feed_names) {
+    callable->feed_arg_indices.push_back(ek->input_name_to_index.at(feed));
+  }
+  callable->fetch_retval_indices.reserve(callable->fetch_names.size());
+  for (const string& fetch : callable->fetch_names) {
+    callable->fetch_retval_indices.push_back(
+        ek->output_name_to_index.at(fetch));
+  }
+
+  mutex_lock l(callables_lock_);
+  *out_handle = next_callable_handle_++;
+  callables_[*out_handle] = std::move(callable);
+  return Status::OK();
+}
+
+Status DirectSession::RunCallable(CallableHandle handle,
+                                  const std::vector<Tensor>& feed_tensors,
+                                  std::vector<Tensor>* fetch_tensors,
+                                  RunMetadata* run_metadata) {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  direct_session_runs->GetCell()->IncrementBy(1);
+
+  // Hold a reference to the callable, so that a concurrent ReleaseCallable()
+  // does not destroy its executors while this step is running.
+  std::shared_ptr<const Callable> callable;
+  {
+    mutex_lock l(callables_lock_);
+    if (handle < 0 || handle >= next_callable_handle_) {
+      return errors::InvalidArgument("No such callable handle: ", handle);
+    }
+    auto it = callables_.find(handle);
+    if (it == callables_.end()) {
+      return errors::InvalidArgument(
+          "Attempted to run callable after handle was released: ", handle);
+    }
+    callable = it->second;
+  }
+
+  if (feed_tensors.size() != callable->feed_arg_indices.size()) {
+    return errors::InvalidArgument("Expected ",
+                                   callable->feed_arg_indices.size(),
+                                   " feed tensors, but got ",
+                                   feed_tensors.size());
+  }
+
+  ExecutorsAndKeys* executors_and_keys = callable->executors_and_keys.get();
+  const int64 step_id = step_id_counter_.fetch_add(1);
+  const int64 executor_step_count = executors_and_keys->step_count.fetch_add(1);
+
+  std::unique_ptr<DebuggerStateInterface> debugger_state;
+  const DebugOptions& debug_options = callable->run_options.debug_options();
+  if (!debug_options.debug_tensor_watch_opts().empty()) {
+    TF_RETURN_IF_ERROR(CreateDebuggerState(
+        debug_options, step_id, executor_step_count, callable->feed_names,
+        callable->fetch_names, callable->target_names, &debugger_state));
+  }
+
+  FunctionCallFrame call_frame(executors_and_keys->input_types,
+                               executors_and_keys->output_types);
+  gtl::InlinedVector<Tensor, 4> feed_args(feed_tensors.size());
+  for (size_t i = 0; i < feed_tensors.size(); ++i) {
+    const int arg_index = callable->feed_arg_indices[i];
+    if (feed_tensors[i].dtype() == DT_RESOURCE) {
       TF_RETURN_IF_ERROR(
-          cost_model_manager_.AddToCostGraphDef(item.graph, cost_graph));
+          ResourceHandleToInputTensor(feed_tensors[i], &feed_args[arg_index]));
+    } else {
+      feed_args[arg_index] = feed_tensors[i];
     }
   }
+  const Status s = call_frame.SetArgs(feed_args);
+  if (errors::IsInternal(s)) {
+    return errors::InvalidArgument(s.error_message());
+  } else if (!s.ok()) {
+    return s;
+  }
 
-  // If requested via RunOptions, output the partition graphs.
-  if (run_options.output_partition_graphs()) {
-    protobuf::RepeatedPtrField<GraphDef>* partition_graph_defs =
-        run_metadata->mutable_partition_graphs();
-    for (const PerPartitionExecutorsAndLib& exec_and_lib :
-         executors_and_keys->items) {
-      GraphDef* partition_graph_def = partition_graph_defs->Add();
-      exec_and_lib.graph->ToGraphDef(partition_graph_def);
+  TF_RETURN_IF_ERROR(RunInternal(step_id, callable->run_options, &call_frame,
+                                 executors_and_keys, callable->run_state_handle,
+                                 callable->fetch_names, executor_step_count,
+                                 run_metadata));
+
+  if (fetch_tensors) {
+    std::vector<Tensor> sorted_outputs;
+    const Status s = call_frame.ConsumeRetvals(&sorted_outputs);
+    if (errors::IsInternal(s)) {
+      return errors::InvalidArgument(s.error_message());
+    } else if (!s.ok()) {
+      return s;
+    }
+    fetch_tensors->clear();
+    fetch_tensors->reserve(callable->fetch_retval_indices.size());
+    for (const int retval_index : callable->fetch_retval_indices) {
+      fetch_tensors->push_back(sorted_outputs[retval_index]);
     }
   }
 
   return Status::OK();
 }
 
+Status DirectSession::ReleaseCallable(CallableHandle handle) {
+  mutex_lock l(callables_lock_);
+  if (handle < 0 || handle >= next_callable_handle_) {
+    return errors::InvalidArgument("No such callable handle: ", handle);
+  }
+  callables_.erase(handle);
+  return Status::OK();
+}
+
 Status DirectSession::PRunSetup(const std::vector<string>& input_names,
                                 const std::vector<string>& output_names,
                                 const std::vector<string>& target_nodes,
@@ -708,7 +1016,7 @@ Status DirectSession::PRunSetup(const std::vector<string>& input_names,
   thread::ThreadPool* pool = thread_pools_[0].first;
 
   // Check if we already have an executor for these arguments.
-  ExecutorsAndKeys* executors_and_keys;
+  std::shared_ptr<ExecutorsAndKeys> executors_and_keys;
   // TODO(cais): TFDBG support for partial runs.
   DebugOptions debug_options;
   RunStateArgs run_state_args(debug_options);
@@ -723,6 +1031,7 @@ Status DirectSession::PRunSetup(const std::vector<string>& input_names,
   RunState* run_state =
       new RunState(input_names, output_names, args.step_id, &devices_);
   run_state->rendez = new IntraProcessRendezvous(device_mgr_.get());
+  run_state->executors_and_keys = executors_and_keys;
   {
     mutex_lock l(executor_lock_);
     if (!partial_runs_
@@ -747,9 +1056,7 @@ Status DirectSession::PRunSetup(const std::vector<string>& input_names,
 
   args.rendezvous = run_state->rendez;
   args.cancellation_manager = cancellation_manager_;
-  args.runner = [this, pool](Executor::Args::Closure c) {
-    SchedClosure(pool, std::move(c));
-  };
+  args.runner = MakeRunner(pool, 0 /* priority */);
   args.session_state = &session_state_;
   args.tensor_store = &run_state->tensor_store;
   args.step_container = &run_state->step_container;
@@ -775,26 +1082,18 @@ Status DirectSession::PRun(const string& handle, const NamedTensorList& inputs,
                            const std::vector<string>& output_names,
                            std::vector<Tensor>* outputs) {
   TF_RETURN_IF_ERROR(CheckNotClosed());
-  std::vector<string> parts = str_util::Split(handle, ';');
-  const string& key = parts[0];
   // Get the executors for this partial run.
   ExecutorsAndKeys* executors_and_keys;
   RunState* run_state;
   {
     mutex_lock l(executor_lock_);  // could use reader lock
-    auto exc_it = executors_.find(key);
-    if (exc_it == executors_.end()) {
-      return errors::InvalidArgument(
-          "Must run 'setup' before performing partial runs!");
-    }
-    executors_and_keys = exc_it->second.get();
-
     auto prun_it = partial_runs_.find(handle);
     if (prun_it == partial_runs_.end()) {
       return errors::InvalidArgument(
           "Must run 'setup' before performing partial runs!");
     }
     run_state = prun_it->second.get();
+    executors_and_keys = run_state->executors_and_keys.get();
 
     // Make sure that this is a new set of feeds that are still pending.
     for (const auto& input : inputs) {
@@ -1045,7 +1344,8 @@ Status DirectSession::CheckFetch(const NamedTensorList& feeds,
 
 Status DirectSession::GetOrCreateExecutors(
     gtl::ArraySlice<string> inputs, gtl::ArraySlice<string> outputs,
-    gtl::ArraySlice<string> target_nodes, ExecutorsAndKeys** executors_and_keys,
+    gtl::ArraySlice<string> target_nodes,
+    std::shared_ptr<ExecutorsAndKeys>* executors_and_keys,
     RunStateArgs* run_state_args) {
   int64 handle_name_counter_value = -1;
   if (LogMemory::IsEnabled() || run_state_args->is_partial_run) {
@@ -1058,11 +1358,27 @@ Status DirectSession::GetOrCreateExecutors(
         run_state_args->debug_options.debug_tensor_watch_opts());
   }
 
+  // The signature of the shapes of the inputs, in the order of 'names', if
+  // the graph is specialized to them.
+  const auto shape_signature = [run_state_args](
+                                   gtl::ArraySlice<string> names) -> string {
+    if (run_state_args->input_shapes.empty()) return "";
+    string signature = "/";
+    for (const string& name : names) {
+      auto it = run_state_args->input_shapes.find(name);
+      strings::StrAppend(&signature, it == run_state_args->input_shapes.end()
+                                         ? "?"
+                                         : it->second.DebugString(),
+                         ";");
+    }
+    return signature;
+  };
+
   // Fast lookup path, no sorting.
   const string key = strings::StrCat(
       str_util::Join(inputs, ","), "->", str_util::Join(outputs, ","), "/",
       str_util::Join(target_nodes, ","), "/", run_state_args->is_partial_run,
-      "/", debug_tensor_watches_summary);
+      "/", debug_tensor_watches_summary, shape_signature(inputs));
   // Set the handle, if it's needed to log memory or for partial run.
   if (handle_name_counter_value >= 0) {
     run_state_args->handle =
@@ -1074,7 +1390,9 @@ Status DirectSession::GetOrCreateExecutors(
     mutex_lock l(executor_lock_);  // could use reader lock
     auto it = executors_.find(key);
     if (it != executors_.end()) {
-      *executors_and_keys = it->second.get();
+      *executors_and_keys = it->second;
+      MarkExecutorsUsedLocked(it->second.get());
+      direct_session_executor_cache->GetCell("hit")->IncrementBy(1);
       return Status::OK();
     }
   }
@@ -1092,10 +1410,12 @@ Status DirectSession::GetOrCreateExecutors(
   std::vector<string> tn_sorted(target_nodes.begin(), target_nodes.end());
   std::sort(tn_sorted.begin(), tn_sorted.end());
 
-  const string sorted_key = strings::StrCat(
+  const string unspecialized_sorted_key = strings::StrCat(
       str_util::Join(inputs_sorted, ","), "->",
       str_util::Join(outputs_sorted, ","), "/", str_util::Join(tn_sorted, ","),
       "/", run_state_args->is_partial_run, "/", debug_tensor_watches_summary);
+  const string sorted_key =
+      strings::StrCat(unspecialized_sorted_key, shape_signature(inputs_sorted));
   // Set the handle, if its needed to log memory or for partial run.
   if (handle_name_counter_value >= 0) {
     run_state_args->handle =
@@ -1107,13 +1427,33 @@ Status DirectSession::GetOrCreateExecutors(
     mutex_lock l(executor_lock_);
     auto it = executors_.find(sorted_key);
     if (it != executors_.end()) {
-      *executors_and_keys = it->second.get();
+      *executors_and_keys = it->second;
       // Insert this under the original key.
-      executors_.emplace(key, it->second);
+      AddExecutorsKeyLocked(key, it->second);
+      MarkExecutorsUsedLocked(it->second.get());
+      direct_session_executor_cache->GetCell("hit")->IncrementBy(1);
       return Status::OK();
     }
   }
 
+  // Past the limit of specialized graphs, the new signatures of shapes use
+  // the unspecialized graph.
+  if (!run_state_args->input_shapes.empty()) {
+    bool specialize;
+    {
+      mutex_lock l(executor_lock_);
+      specialize = num_shape_variants_[unspecialized_sorted_key] <
+                   options_.config.experimental()
+                       .shape_specialization_cache_size();
+    }
+    if (!specialize) {
+      run_state_args->input_shapes.clear();
+      return GetOrCreateExecutors(inputs, outputs, target_nodes,
+                                  executors_and_keys, run_state_args);
+    }
+  }
+  direct_session_executor_cache->GetCell("miss")->IncrementBy(1);
+
   // Nothing found, so create the executors and store in the cache.
   BuildGraphOptions options;
   options.feed_endpoints = inputs_sorted;
@@ -1123,8 +1463,19 @@ Status DirectSession::GetOrCreateExecutors(
   if (!run_state_args->debug_options.debug_tensor_watch_opts().empty()) {
     options.debug_options = run_state_args->debug_options;
   }
-
   std::shared_ptr<ExecutorsAndKeys> ek(new ExecutorsAndKeys);
+  if (!run_state_args->input_shapes.empty()) {
+    for (const string& input : inputs_sorted) {
+      auto it = run_state_args->input_shapes.find(input);
+      if (it == run_state_args->input_shapes.end()) {
+        // Only the leading inputs with known shapes are specialized, e.g.
+        // not the resource handles.
+        break;
+      }
+      options.feed_shapes.push_back(it->second);
+    }
+    ek->shape_variants_key = unspecialized_sorted_key;
+  }
 
   // The executor_lock_ is intentionally released while executor is
   // being created.
@@ -1165,6 +1516,11 @@ Status DirectSession::GetOrCreateExecutors(
       optimizer_opts));
 
   GraphOptimizer optimizer(optimizer_opts);
+  if (options_.config.experimental().parallel_constant_folding()) {
+    thread::ThreadPool* pool = thread_pools_[0].first;
+    optimizer.set_constant_folding_runner(
+        [pool](std::function<void()> c) { pool->Schedule(std::move(c)); });
+  }
   for (auto iter = graphs.begin(); iter != graphs.end(); ++iter) {
     const string& partition_name = iter->first;
     std::unique_ptr<Graph>& partition_graph = iter->second;
@@ -1205,7 +1561,22 @@ Status DirectSession::GetOrCreateExecutors(
         delete kernel;
       }
     };
+    if (options_.config.experimental().parallel_kernel_creation()) {
+      thread::ThreadPool* pool = thread_pools_[0].first;
+      params.kernel_creation_runner = [pool](std::function<void()> c) {
+        pool->Schedule(std::move(c));
+      };
+    }
     params.node_outputs_cb = node_outputs_callback_;
+    if (options_.config.experimental().executor_work_stealing()) {
+      params.num_work_stealing_workers = thread_pools_[0].first->NumThreads();
+    }
+    params.use_linear_schedule =
+        options_.config.experimental().executor_linear_schedule();
+    params.use_memory_planning =
+        options_.config.experimental().executor_memory_planning();
+    params.step_arena_bytes =
+        options_.config.experimental().executor_step_arena_bytes();
 
     optimizer.Optimize(lib, options_.env, device, &iter->second,
                        /*shape_map=*/nullptr);
@@ -1267,14 +1638,59 @@ Status DirectSession::GetOrCreateExecutors(
   // Another thread may have created the entry before us, in which case we will
   // reuse the already created one.
   auto insert_result = executors_.emplace(sorted_key, ek);
+  if (insert_result.second) {
+    ek->cache_keys.push_back(sorted_key);
+    executors_lru_.push_front(ek.get());
+    ek->lru_position = executors_lru_.begin();
+    if (!ek->shape_variants_key.empty()) {
+      ++num_shape_variants_[ek->shape_variants_key];
+    }
+  } else {
+    MarkExecutorsUsedLocked(insert_result.first->second.get());
+  }
   // Insert the value under the original key, so the fast path lookup will work
   // if the user uses the same order of inputs, outputs, and targets again.
-  executors_.emplace(key, insert_result.first->second);
-  *executors_and_keys = insert_result.first->second.get();
+  AddExecutorsKeyLocked(key, insert_result.first->second);
+  *executors_and_keys = insert_result.first->second;
+  MaybeEvictExecutorsLocked();
 
   return Status::OK();
 }
 
+void DirectSession::AddExecutorsKeyLocked(
+    const string& key,
+    const std::shared_ptr<ExecutorsAndKeys>& executors_and_keys) {
+  if (executors_.emplace(key, executors_and_keys).second) {
+    executors_and_keys->cache_keys.push_back(key);
+  }
+}
+
+void DirectSession::MarkExecutorsUsedLocked(
+    ExecutorsAndKeys* executors_and_keys) {
+  executors_lru_.splice(executors_lru_.begin(), executors_lru_,
+                        executors_and_keys->lru_position);
+}
+
+void DirectSession::MaybeEvictExecutorsLocked() {
+  const int32 capacity =
+      options_.config.experimental().executor_cache_capacity();
+  if (capacity <= 0) return;
+  while (executors_lru_.size() > static_cast<size_t>(capacity)) {
+    // Steps, callables and partial runs that still use the evicted executors
+    // hold their own references, so erasing the keys only drops the cache's
+    // reference.
+    ExecutorsAndKeys* victim = executors_lru_.back();
+    executors_lru_.pop_back();
+    for (const string& cache_key : victim->cache_keys) {
+      executors_.erase(cache_key);
+    }
+    if (!victim->shape_variants_key.empty()) {
+      --num_shape_variants_[victim->shape_variants_key];
+    }
+    direct_session_executor_cache->GetCell("eviction")->IncrementBy(1);
+  }
+}
+
 Status DirectSession::CreateGraphs(
     const BuildGraphOptions& subgraph_options,
     std::unordered_map<string, std::unique_ptr<Graph>>* outputs,
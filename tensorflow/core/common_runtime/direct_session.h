@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_COMMON_RUNTIME_DIRECT_SESSION_H_
 
 #include <atomic>
+#include <list>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -92,6 +93,15 @@ class DirectSession : public Session {
                             const std::vector<string>& output_names,
                             std::vector<Tensor>* outputs) override;
 
+  // NOTE: Experimental and subject to change.
+  ::tensorflow::Status MakeCallable(const CallableOptions& callable_options,
+                                    CallableHandle* out_handle) override;
+  ::tensorflow::Status RunCallable(CallableHandle handle,
+                                   const std::vector<Tensor>& feed_tensors,
+                                   std::vector<Tensor>* fetch_tensors,
+                                   RunMetadata* run_metadata) override;
+  ::tensorflow::Status ReleaseCallable(CallableHandle handle) override;
+
   // Reset clears 'containers' from the device_mgr of the DirectSession.
   // If 'containers' is empty, then Reset clears the default container.
   ::tensorflow::Status Reset(const std::vector<string>& containers);
@@ -147,6 +157,14 @@ class DirectSession : public Session {
 
     DataTypeVector input_types;
     DataTypeVector output_types;
+
+    // The keys under which this object is stored in 'executors_', and its
+    // position in 'executors_lru_'. Guarded by 'executor_lock_'.
+    std::vector<string> cache_keys;
+    std::list<ExecutorsAndKeys*>::iterator lru_position;
+    // If the graph is specialized to the shapes of its inputs, the key of
+    // 'num_shape_variants_' that counts it.
+    string shape_variants_key;
   };
 
   // For each live partial execution, the session maintains a RunState.
@@ -163,6 +181,9 @@ class DirectSession : public Session {
     std::unordered_map<string, bool> pending_outputs;  // true if fetched
     TensorStore tensor_store;
     ScopedStepContainer step_container;
+    // For partial runs, the executors that run this step. Holding a
+    // reference keeps them alive if they are evicted from 'executors_'.
+    std::shared_ptr<ExecutorsAndKeys> executors_and_keys;
 
     RunState(int64 step_id, const std::vector<Device*>* devices);
 
@@ -176,6 +197,21 @@ class DirectSession : public Session {
     ~RunState();
   };
 
+  // A Callable is created by MakeCallable() for a fixed set of feeds, fetches
+  // and targets. 'feed_arg_indices[i]' is the call frame argument for the
+  // i-th feed, and 'fetch_retval_indices[i]' is the call frame return value
+  // for the i-th fetch, so that RunCallable() needs no name lookups.
+  struct Callable {
+    std::shared_ptr<ExecutorsAndKeys> executors_and_keys;
+    RunOptions run_options;
+    string run_state_handle;
+    std::vector<string> feed_names;
+    std::vector<string> fetch_names;
+    std::vector<string> target_names;
+    std::vector<int> feed_arg_indices;
+    std::vector<int> fetch_retval_indices;
+  };
+
   struct RunStateArgs {
     RunStateArgs(const DebugOptions& options) : debug_options(options) {}
 
@@ -183,6 +219,9 @@ class DirectSession : public Session {
     string handle;
     std::unique_ptr<Graph> graph;
     const DebugOptions& debug_options;
+    // The shapes of the fed tensors by input name, if the graph may be
+    // specialized to them.
+    std::unordered_map<string, TensorShape> input_shapes;
   };
 
   // Initializes the base execution state given the 'graph',
@@ -196,7 +235,34 @@ class DirectSession : public Session {
   ::tensorflow::Status GetOrCreateExecutors(
       gtl::ArraySlice<string> inputs, gtl::ArraySlice<string> outputs,
       gtl::ArraySlice<string> target_nodes,
-      ExecutorsAndKeys** executors_and_keys, RunStateArgs* run_state_args);
+      std::shared_ptr<ExecutorsAndKeys>* executors_and_keys,
+      RunStateArgs* run_state_args);
+
+  // Adds 'executors_and_keys' to 'executors_' under 'key', if 'key' is not
+  // already present.
+  void AddExecutorsKeyLocked(
+      const string& key,
+      const std::shared_ptr<ExecutorsAndKeys>& executors_and_keys)
+      EXCLUSIVE_LOCKS_REQUIRED(executor_lock_);
+
+  // Moves 'executors_and_keys' to the front of 'executors_lru_'.
+  void MarkExecutorsUsedLocked(ExecutorsAndKeys* executors_and_keys)
+      EXCLUSIVE_LOCKS_REQUIRED(executor_lock_);
+
+  // Removes the least recently used executors from 'executors_' until at
+  // most 'executor_cache_capacity' sets remain.
+  void MaybeEvictExecutorsLocked() EXCLUSIVE_LOCKS_REQUIRED(executor_lock_);
+
+  // Runs the executors in 'executors_and_keys' for one step, feeding and
+  // fetching through 'call_frame'. Shared by Run() and RunCallable().
+  ::tensorflow::Status RunInternal(int64 step_id,
+                                   const RunOptions& run_options,
+                                   FunctionCallFrame* call_frame,
+                                   ExecutorsAndKeys* executors_and_keys,
+                                   const string& run_state_handle,
+                                   const std::vector<string>& output_names,
+                                   int64 executor_step_count,
+                                   RunMetadata* run_metadata);
 
   // Creates several graphs given the existing graph_def_ and the
   // input feeds and fetches, given 'devices'. The graphs share a common
@@ -276,6 +342,12 @@ class DirectSession : public Session {
   // is owned.
   std::vector<std::pair<thread::ThreadPool*, bool>> thread_pools_;
 
+  // If ConfigProto.Experimental.use_numa_affinity is set, one inter-op pool
+  // per NUMA node. CPU partitions run on the pool of their device's node
+  // when RunOptions.inter_op_thread_pool is 0.
+  std::vector<thread::ThreadPool*> numa_thread_pools_;
+  bool owns_numa_thread_pools_ = false;
+
   Status init_error_;  // Set to an error if construction failed.
 
   // If true, blocks until device has finished all queued operations in a step.
@@ -283,6 +355,15 @@ class DirectSession : public Session {
   // Schedules 'c' for execution on pool.
   void SchedClosure(thread::ThreadPool* pool, std::function<void()> c);
 
+  // Returns the runner for the closures of a step with "priority" on
+  // "pool".
+  Executor::Args::Runner MakeRunner(thread::ThreadPool* pool, int priority);
+
+  // Returns the NUMA inter-op pool for 'device', or 'default_pool' if
+  // 'device' is not a CPU device bound to a NUMA node.
+  thread::ThreadPool* NUMAThreadPoolForDevice(
+      const Device* device, thread::ThreadPool* default_pool) const;
+
   mutex executor_lock_;  // protects executors_
   // Holds mappings from signature to the executors that process
   // it. The reason for a level of indirection around mapped_type is
@@ -291,6 +372,18 @@ class DirectSession : public Session {
   // same ExecutorsAndKey object.
   std::unordered_map<string, std::shared_ptr<ExecutorsAndKeys>> executors_
       GUARDED_BY(executor_lock_);
+  // Every distinct ExecutorsAndKeys in 'executors_', most recently used
+  // first.
+  std::list<ExecutorsAndKeys*> executors_lru_ GUARDED_BY(executor_lock_);
+  // The number of cached executors specialized to the shapes of their
+  // inputs, by sorted key of their feeds, fetches and targets.
+  std::unordered_map<string, int> num_shape_variants_
+      GUARDED_BY(executor_lock_);
+
+  mutex callables_lock_;  // protects callables_ and next_callable_handle_
+  CallableHandle next_callable_handle_ GUARDED_BY(callables_lock_) = 0;
+  std::unordered_map<CallableHandle, std::shared_ptr<const Callable>>
+      callables_ GUARDED_BY(callables_lock_);
 
   // Holds mappings from handle to partial run state.
   std::unordered_map<string, std::unique_ptr<RunState>> partial_runs_
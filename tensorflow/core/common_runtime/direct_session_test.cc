@@ -110,6 +110,81 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork) {
   EXPECT_FLOAT_EQ(5.0, mat(0, 0));
 }
 
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetwork_Callable) {
+  Initialize({3, 2, -1, 0});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  // Request two targets: one fetch output and one non-fetched output.
+  Session::CallableHandle handle;
+  CallableOptions callable_options;
+  callable_options.add_fetch(y_ + ":0");
+  callable_options.add_target(y_neg_);
+  TF_ASSERT_OK(session->MakeCallable(callable_options, &handle));
+
+  for (int i = 0; i < 2; ++i) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->RunCallable(handle, {}, &outputs, nullptr));
+    ASSERT_EQ(1, outputs.size());
+    auto mat = outputs[0].matrix<float>();
+    ASSERT_TRUE(outputs[0].IsInitialized());
+    EXPECT_FLOAT_EQ(5.0, mat(0, 0));
+  }
+
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+  Status s = session->RunCallable(handle, {}, nullptr, nullptr);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+  EXPECT_TRUE(StringPiece(s.error_message()).contains("released")) << s;
+
+  s = session->RunCallable(handle + 1, {}, nullptr, nullptr);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+  EXPECT_TRUE(StringPiece(s.error_message()).contains("No such callable"))
+      << s;
+}
+
+TEST_F(DirectSessionMinusAXTest, TestFeed_Callable) {
+  Initialize({1, 2, 3, 4});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  // Fetch the same output twice, and check that both copies come back in
+  // the requested order.
+  Session::CallableHandle handle;
+  CallableOptions callable_options;
+  callable_options.add_feed(x_);
+  callable_options.add_fetch(y_ + ":0");
+  callable_options.add_fetch(y_neg_ + ":0");
+  callable_options.add_fetch(y_ + ":0");
+  TF_ASSERT_OK(session->MakeCallable(callable_options, &handle));
+
+  Tensor t(DT_FLOAT, TensorShape({2, 1}));
+  t.matrix<float>()(0, 0) = 5;
+  t.matrix<float>()(1, 0) = 6;
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->RunCallable(handle, {t}, &outputs, nullptr));
+
+  ASSERT_EQ(3, outputs.size());
+  // Expect outputs to be; 1*5 + 2*6, 3*5 + 4*6
+  EXPECT_FLOAT_EQ(17.0, outputs[0].matrix<float>()(0, 0));
+  EXPECT_FLOAT_EQ(39.0, outputs[0].matrix<float>()(1, 0));
+  EXPECT_FLOAT_EQ(-17.0, outputs[1].matrix<float>()(0, 0));
+  EXPECT_FLOAT_EQ(-39.0, outputs[1].matrix<float>()(1, 0));
+  EXPECT_FLOAT_EQ(17.0, outputs[2].matrix<float>()(0, 0));
+  EXPECT_FLOAT_EQ(39.0, outputs[2].matrix<float>()(1, 0));
+
+  // The wrong number of feeds is rejected.
+  Status s = session->RunCallable(handle, {}, &outputs, nullptr);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+
+  // Duplicate feeds are rejected when the callable is made.
+  callable_options.add_feed(x_);
+  s = session->MakeCallable(callable_options, &handle);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+  EXPECT_TRUE(StringPiece(s.error_message()).contains("Duplicate feed")) << s;
+}
+
 TEST_F(DirectSessionMinusAXTest, TestFeed) {
   Initialize({1, 2, 3, 4});
   auto session = CreateSession();
@@ -208,6 +283,118 @@ TEST_F(DirectSessionMinusAXTest, TestPerSessionThreads) {
   delete tp;
 }
 
+TEST_F(DirectSessionMinusAXTest, TestWorkStealingExecutor) {
+  Initialize({1, 2, 3, 4});
+
+  SessionOptions options;
+  options.config.mutable_experimental()->set_executor_work_stealing(true);
+  options.config.set_use_per_session_threads(true);
+  options.config.set_inter_op_parallelism_threads(4);
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  std::unique_ptr<Session> session(NewSession(options));
+
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  std::vector<string> output_names = {y_ + ":0"};
+  for (int i = 0; i < 100; ++i) {
+    std::vector<std::pair<string, Tensor>> inputs;
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run(inputs, output_names, {y_neg_}, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    auto mat = outputs[0].matrix<float>();
+    EXPECT_FLOAT_EQ(3.0, mat(0, 0));
+    EXPECT_FLOAT_EQ(7.0, mat(1, 0));
+  }
+}
+
+TEST_F(DirectSessionMinusAXTest, TestLinearScheduleExecutor) {
+  Initialize({1, 2, 3, 4});
+
+  SessionOptions options;
+  options.config.mutable_experimental()->set_executor_linear_schedule(true);
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  std::unique_ptr<Session> session(NewSession(options));
+
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  // The feed and fetch cross both partitions of the graph.
+  Tensor t(DT_FLOAT, TensorShape({2, 1}));
+  t.matrix<float>()(0, 0) = 5;
+  t.matrix<float>()(1, 0) = 6;
+  std::vector<std::pair<string, Tensor>> inputs = {{x_, t}};
+  std::vector<string> output_names = {y_ + ":0", y_neg_ + ":0"};
+  for (int i = 0; i < 100; ++i) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run(inputs, output_names, {}, &outputs));
+    ASSERT_EQ(2, outputs.size());
+    auto mat = outputs[0].matrix<float>();
+    EXPECT_FLOAT_EQ(17.0, mat(0, 0));
+    EXPECT_FLOAT_EQ(39.0, mat(1, 0));
+    EXPECT_FLOAT_EQ(-17.0, outputs[1].matrix<float>()(0, 0));
+  }
+}
+
+TEST_F(DirectSessionMinusAXTest, TestMemoryPlanning) {
+  Initialize({1, 2, 3, 4});
+
+  SessionOptions options;
+  options.config.mutable_experimental()->set_executor_linear_schedule(true);
+  options.config.mutable_experimental()->set_executor_memory_planning(true);
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  std::unique_ptr<Session> session(NewSession(options));
+
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  // Fetched outputs of earlier steps stay valid while later steps reuse
+  // the planned memory.
+  std::vector<std::vector<Tensor>> all_outputs;
+  for (int i = 0; i < 10; ++i) {
+    Tensor t(DT_FLOAT, TensorShape({2, 1}));
+    t.matrix<float>()(0, 0) = i;
+    t.matrix<float>()(1, 0) = i + 1;
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({{x_, t}}, {y_ + ":0", y_neg_ + ":0"}, {},
+                              &outputs));
+    ASSERT_EQ(2, outputs.size());
+    all_outputs.push_back(outputs);
+  }
+  for (int i = 0; i < 10; ++i) {
+    auto mat = all_outputs[i][0].matrix<float>();
+    EXPECT_FLOAT_EQ(i + 2 * (i + 1), mat(0, 0));
+    EXPECT_FLOAT_EQ(3 * i + 4 * (i + 1), mat(1, 0));
+    EXPECT_FLOAT_EQ(-mat(0, 0), all_outputs[i][1].matrix<float>()(0, 0));
+  }
+}
+
+TEST_F(DirectSessionMinusAXTest, TestPriorityScheduling) {
+  Initialize({3, 2, -1, 0});
+
+  SessionOptions options;
+  options.config.mutable_experimental()->set_inter_op_priority_scheduling(
+      true);
+  options.config.set_use_per_session_threads(true);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  // Steps of different priorities run concurrently.
+  thread::ThreadPool* tp = new thread::ThreadPool(Env::Default(), "test", 4);
+  for (int i = 0; i < 20; ++i) {
+    tp->Schedule([&session, i, this]() {
+      RunOptions run_options;
+      run_options.set_priority(i % 3);
+      std::vector<Tensor> outputs;
+      TF_ASSERT_OK(session->Run(run_options, {}, {y_ + ":0"}, {}, &outputs,
+                                nullptr));
+      EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+    });
+  }
+  delete tp;
+}
+
 TEST_F(DirectSessionMinusAXTest, TwoCreateCallsFails) {
   Initialize({1, 2, 3, 4});
   auto session = CreateSession();
@@ -227,6 +414,40 @@ TEST_F(DirectSessionMinusAXTest, ForgetToCreate) {
   ASSERT_FALSE(session->Run(inputs, {y_ + ":0"}, {y_neg_}, &outputs).ok());
 }
 
+TEST(DirectSessionTest, ParallelKernelCreation) {
+  // Enough stateless nodes for their kernels to be created in several
+  // chunks, and a stateful one.
+  Graph graph(OpRegistry::Global());
+  Tensor one(DT_FLOAT, TensorShape({}));
+  one.scalar<float>()() = 1.0;
+  Node* sum = test::graph::Constant(&graph, one);
+  for (int i = 0; i < 500; ++i) {
+    sum = test::graph::Add(&graph, sum, test::graph::Constant(&graph, one));
+  }
+  Node* var = test::graph::Var(&graph, DT_FLOAT, TensorShape({}));
+  Node* assign = test::graph::Assign(&graph, var, sum);
+  GraphDef def;
+  test::graph::ToGraphDef(&graph, &def);
+
+  SessionOptions options;
+  options.config.mutable_experimental()->set_parallel_kernel_creation(true);
+  options.config.set_use_per_session_threads(true);
+  options.config.set_inter_op_parallelism_threads(4);
+  // Keep the nodes from being constant folded away.
+  options.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_opt_level(OptimizerOptions::L0);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run({}, {}, {assign->name()}, &outputs));
+  TF_ASSERT_OK(session->Run({}, {var->name() + ":0"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_FLOAT_EQ(501.0, outputs[0].scalar<float>()());
+}
+
 TEST_F(DirectSessionMinusAXTest, InvalidDevice) {
   GraphDef def;
   Graph graph(OpRegistry::Global());
@@ -567,6 +788,115 @@ TEST(DirectSessionTest, PartialRunTest) {
   ASSERT_EQ(11.0 + 22.0, outputs[1].flat<float>()(0));
 }
 
+TEST(DirectSessionTest, ExecutorCacheEviction) {
+  GraphDef def;
+  Graph g(OpRegistry::Global());
+
+  Tensor first_value(DT_FLOAT, TensorShape({}));
+  first_value.scalar<float>()() = 1.0;
+  Node* first_const = test::graph::Constant(&g, first_value);
+  Node* first_identity = test::graph::Identity(&g, first_const);
+
+  Tensor second_value(DT_FLOAT, TensorShape({}));
+  second_value.scalar<float>()() = 2.0;
+  Node* second_const = test::graph::Constant(&g, second_value);
+  Node* second_identity = test::graph::Identity(&g, second_const);
+
+  test::graph::ToGraphDef(&g, &def);
+
+  SessionOptions options;
+  options.config.mutable_experimental()->set_executor_cache_capacity(1);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+
+  // A partial run and a callable keep their executors after those have been
+  // evicted by runs with other signatures.
+  string handle;
+  TF_ASSERT_OK(session->PRunSetup({first_const->name()},
+                                  {first_identity->name() + ":0"}, {},
+                                  &handle));
+  Session::CallableHandle callable_handle;
+  CallableOptions callable_options;
+  callable_options.add_fetch(second_identity->name() + ":0");
+  TF_ASSERT_OK(session->MakeCallable(callable_options, &callable_handle));
+
+  std::vector<Tensor> outputs;
+  for (int i = 0; i < 3; ++i) {
+    TF_ASSERT_OK(session->Run({}, {first_identity->name() + ":0"}, {},
+                              &outputs));
+    ASSERT_EQ(1, outputs.size());
+    EXPECT_EQ(1.0, outputs[0].flat<float>()(0));
+    TF_ASSERT_OK(session->Run({}, {second_identity->name() + ":0"}, {},
+                              &outputs));
+    ASSERT_EQ(1, outputs.size());
+    EXPECT_EQ(2.0, outputs[0].flat<float>()(0));
+  }
+
+  TF_ASSERT_OK(session->RunCallable(callable_handle, {}, &outputs, nullptr));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_EQ(2.0, outputs[0].flat<float>()(0));
+  TF_ASSERT_OK(session->ReleaseCallable(callable_handle));
+
+  Tensor value_11(DT_FLOAT, TensorShape({}));
+  value_11.scalar<float>()() = 11.0;
+  TF_ASSERT_OK(session->PRun(handle, {{first_const->name(), value_11}},
+                             {first_identity->name() + ":0"}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_EQ(11.0, outputs[0].flat<float>()(0));
+}
+
+TEST(DirectSessionTest, SpecializesGraphToShapesOfFeeds) {
+  Graph g(OpRegistry::Global());
+  Node* x;
+  TF_ASSERT_OK(NodeBuilder("x", "Placeholder")
+                   .Attr("shape", PartialTensorShape({-1, 2}))
+                   .Attr("dtype", DT_FLOAT)
+                   .Finalize(&g, &x));
+  Node* shape;
+  TF_ASSERT_OK(NodeBuilder("shape", "Shape")
+                   .Input(x)
+                   .Attr("T", DT_FLOAT)
+                   .Attr("out_type", DT_INT32)
+                   .Finalize(&g, &shape));
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  SessionOptions options;
+  options.config.mutable_experimental()->set_shape_specialization_cache_size(1);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+
+  RunOptions run_options;
+  run_options.set_output_partition_graphs(true);
+  // Runs the graph with a feed of "rows" rows, and returns whether it ran
+  // the Shape op rather than a constant.
+  auto run = [&session, &run_options](int64 rows) {
+    Tensor value(DT_FLOAT, TensorShape({rows, 2}));
+    value.flat<float>().setZero();
+    std::vector<Tensor> outputs;
+    RunMetadata run_metadata;
+    TF_CHECK_OK(session->Run(run_options, {{"x:0", value}}, {"shape:0"}, {},
+                             &outputs, &run_metadata));
+    CHECK_EQ(1, outputs.size());
+    test::ExpectTensorEqual<int32>(
+        test::AsTensor<int32>({static_cast<int32>(rows), 2}), outputs[0]);
+    for (const GraphDef& graph : run_metadata.partition_graphs()) {
+      for (const NodeDef& node : graph.node()) {
+        if (node.op() == "Shape") return true;
+      }
+    }
+    return false;
+  };
+
+  // The first signature is specialized, and folds the shape.
+  EXPECT_FALSE(run(3));
+  // The cache is full, so the next one uses the general graph.
+  EXPECT_TRUE(run(4));
+  EXPECT_FALSE(run(3));
+}
+
 TEST(DirectSessionTest, PartialRunMissingFeed) {
   GraphDef def;
   Graph g(OpRegistry::Global());
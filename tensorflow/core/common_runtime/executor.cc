@@ -23,7 +23,10 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
+#include "tensorflow/core/common_runtime/memory_plan.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
+#include "tensorflow/core/common_runtime/sampled_step_tracer.h"
+#include "tensorflow/core/common_runtime/step_arena.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/allocator.h"
@@ -35,11 +38,14 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/op_segment.h"
+#include "tensorflow/core/framework/scoped_allocator.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_reference.h"
+#include "tensorflow/core/framework/tracking_allocator.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/edgeset.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
@@ -52,6 +58,7 @@ limitations under the License.
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -185,6 +192,25 @@ void SetMemory(NodeExecStatsWrapper* stats, OpKernelContext* ctx) {
       ctx->device_persistent_memory_allocated());
 }
 
+// Fills in the memory of a sampled 'event' from 'ctx', and releases the
+// allocators that tracked it.
+void SetSampledMemory(OpKernelContext* ctx, SampledStepTracer::Event* event) {
+  event->has_memory = ctx->track_allocations();
+  if (!event->has_memory) return;
+  event->peak_bytes = 0;
+  event->live_bytes = 0;
+  for (const auto& allocator_pair : ctx->wrapped_allocators()) {
+    auto sizes = allocator_pair.second->GetSizes();
+    event->peak_bytes += std::get<1>(sizes);
+    event->live_bytes += std::get<2>(sizes);
+    allocator_pair.second->GetRecordsAndUnRef();
+  }
+  event->host_temp_bytes = ctx->host_temp_memory_size();
+  event->device_temp_bytes = ctx->device_temp_memory_size();
+  event->host_persistent_bytes = ctx->host_persistent_memory_allocated();
+  event->device_persistent_bytes = ctx->device_persistent_memory_allocated();
+}
+
 void SetReferencedTensors(NodeExecStatsWrapper* stats,
                           const TensorReferenceVector& tensors) {
   if (!stats) return;
@@ -199,7 +225,68 @@ void SetReferencedTensors(NodeExecStatsWrapper* stats,
 
 }  // namespace nodestats
 
+// Returns the threshold below which TraceBucket() values are sampled, for
+// tracing a 'node_fraction' fraction of the nodes of a step.
+uint32 SampledTraceThreshold(float node_fraction) {
+  if (!(node_fraction > 0)) return 0;
+  if (node_fraction >= 1) return 1 << 16;
+  return std::max<uint32>(1, static_cast<uint32>(node_fraction * (1 << 16)));
+}
+
+// Hashes a node and a step into [0, 1 << 16), so that a different subset of
+// nodes is sampled in each step.
+inline uint32 TraceBucket(int node_id, int64 step_id) {
+  return (static_cast<uint32>(node_id) * 2654435761u +
+          static_cast<uint32>(step_id) * 40503u) >>
+         16;
+}
+
+// Registers the node names of an executor's graph with SampledStepTracer the
+// first time one of its steps is sampled, and unregisters them when the
+// executor is destroyed.
+class SampledTraceGraph {
+ public:
+  SampledTraceGraph() {}
+  ~SampledTraceGraph() {
+    if (registered_) SampledStepTracer::Global()->UnregisterGraph(graph_id_);
+  }
+
+  uint32 GetId(const Graph* graph, const Device* device) {
+    mutex_lock l(mu_);
+    if (!registered_) {
+      std::vector<string> node_names(graph->num_node_ids());
+      for (const Node* n : graph->nodes()) {
+        node_names[n->id()] = n->name();
+      }
+      graph_id_ =
+          SampledStepTracer::Global()->RegisterGraph(device->name(), node_names);
+      registered_ = true;
+    }
+    return graph_id_;
+  }
+
+ private:
+  mutex mu_;
+  bool registered_ GUARDED_BY(mu_) = false;
+  uint32 graph_id_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SampledTraceGraph);
+};
+
 class ExecutorImpl;
+
+// Returns the pool of the slabs of the StepArenas of an executor with
+// 'params', or nullptr if its steps do not use StepArenas.
+std::shared_ptr<StepArena::SlabPool> NewStepArenaPool(
+    const LocalExecutorParams& params) {
+  if (params.step_arena_bytes <= 0 ||
+      params.device->device_type() != DEVICE_CPU) {
+    return nullptr;
+  }
+  return std::make_shared<StepArena::SlabPool>(
+      params.device->GetAllocator(AllocatorAttributes()),
+      params.step_arena_bytes);
+}
 class GraphView;
 
 struct EdgeInfo {
@@ -427,11 +514,18 @@ class ExecutorImpl : public Executor {
   // Root nodes (with no in edges) that should form the initial ready queue
   std::vector<const Node*> root_nodes_;
 
+  // Names the nodes of graph_ in sampled traces.
+  mutable SampledTraceGraph sampled_trace_graph_;
+
   // Mapping from frame name to static information about the frame.
   // TODO(yuanbyu): We could cache it along with the graph so to avoid
   // the overhead of constructing it for each executor instance.
   gtl::FlatMap<string, FrameInfo*> frame_info_;
 
+  // The slabs of the StepArena of each step, or nullptr if scratch
+  // allocations use the device's allocator.
+  std::shared_ptr<StepArena::SlabPool> step_arena_pool_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorImpl);
 };
 
@@ -610,6 +704,116 @@ void GetMaxPendingCounts(const Node* n, size_t* max_pending,
   *max_dead_count = num_in_edges;
 }
 
+// The number of stateless nodes whose kernels one closure of
+// CreateKernels() creates at a time.
+constexpr int64 kKernelCreationChunkSize = 64;
+
+// Shared by the closures of CreateKernels(). The closures may outlive the
+// call, and only touch the state after the last chunk has been claimed to
+// find out that there is nothing left to do.
+struct KernelCreationState {
+  std::function<Status(const NodeDef&, OpKernel**)> create_kernel;
+  std::vector<const Node*> nodes;
+  std::vector<OpKernel*> kernels;
+  std::vector<Status> statuses;
+  int64 num_chunks = 0;
+  std::atomic<int64> next_chunk{0};
+
+  mutex mu;
+  condition_variable chunks_done_cv;
+  int64 chunks_done GUARDED_BY(mu) = 0;
+
+  // Creates kernels until all chunks have been claimed.
+  void CreateChunks() {
+    for (;;) {
+      const int64 chunk = next_chunk.fetch_add(1, std::memory_order_relaxed);
+      if (chunk >= num_chunks) return;
+      const int64 end = std::min<int64>(
+          (chunk + 1) * kKernelCreationChunkSize, nodes.size());
+      for (int64 i = chunk * kKernelCreationChunkSize; i < end; ++i) {
+        statuses[i] = create_kernel(nodes[i]->def(), &kernels[i]);
+      }
+      mutex_lock l(mu);
+      if (++chunks_done == num_chunks) chunks_done_cv.notify_all();
+    }
+  }
+};
+
+// Creates the kernels of 'nodes' with params.create_kernel, and stores the
+// kernel of each node in (*kernels)[node->id()], which is sized to
+// graph->num_node_ids().
+//
+// If params.kernel_creation_runner is set, the kernels of the stateless
+// nodes are created concurrently by closures scheduled on the runner and by
+// the calling thread. The kernels of stateful nodes, which may be shared
+// with other executors and depend on the order in which they are created,
+// are created one at a time in the order of 'nodes' on the calling thread.
+//
+// On error, returns the error of the first node in 'nodes' whose kernel
+// could not be created; the other kernels are still stored in *kernels.
+Status CreateKernels(const LocalExecutorParams& params, const Graph* graph,
+                     const std::vector<const Node*>& nodes,
+                     std::vector<OpKernel*>* kernels) {
+  kernels->assign(graph->num_node_ids(), nullptr);
+  std::vector<Status> statuses(graph->num_node_ids());
+
+  std::shared_ptr<KernelCreationState> state;
+  if (params.kernel_creation_runner != nullptr) {
+    state = std::make_shared<KernelCreationState>();
+    for (const Node* n : nodes) {
+      if (!n->op_def().is_stateful()) state->nodes.push_back(n);
+    }
+    state->num_chunks =
+        (state->nodes.size() + kKernelCreationChunkSize - 1) /
+        kKernelCreationChunkSize;
+    if (state->num_chunks < 2) state.reset();
+  }
+  if (state == nullptr) {
+    for (const Node* n : nodes) {
+      statuses[n->id()] = params.create_kernel(n->def(), &(*kernels)[n->id()]);
+      if (!statuses[n->id()].ok()) break;
+    }
+  } else {
+    state->create_kernel = params.create_kernel;
+    state->kernels.resize(state->nodes.size(), nullptr);
+    state->statuses.resize(state->nodes.size());
+    const int64 num_closures = std::min<int64>(state->num_chunks - 1,
+                                               port::NumSchedulableCPUs());
+    for (int64 i = 0; i < num_closures; ++i) {
+      params.kernel_creation_runner([state]() { state->CreateChunks(); });
+    }
+    for (const Node* n : nodes) {
+      if (n->op_def().is_stateful()) {
+        statuses[n->id()] =
+            params.create_kernel(n->def(), &(*kernels)[n->id()]);
+        if (!statuses[n->id()].ok()) break;
+      }
+    }
+    state->CreateChunks();
+    {
+      mutex_lock l(state->mu);
+      while (state->chunks_done < state->num_chunks) {
+        state->chunks_done_cv.wait(l);
+      }
+    }
+    for (size_t i = 0; i < state->nodes.size(); ++i) {
+      const int id = state->nodes[i]->id();
+      (*kernels)[id] = state->kernels[i];
+      statuses[id] = state->statuses[i];
+    }
+  }
+
+  for (const Node* n : nodes) {
+    const Status& s = statuses[n->id()];
+    if (!s.ok()) {
+      (*kernels)[n->id()] = nullptr;
+      return AttachDef(s, *n);
+    }
+    CHECK((*kernels)[n->id()]);
+  }
+  return Status::OK();
+}
+
 Status ExecutorImpl::Initialize() {
   gview_.Initialize(graph_);
 
@@ -626,8 +830,24 @@ Status ExecutorImpl::Initialize() {
     EnsureFrameInfo(it)->nodes = new std::vector<const Node*>;
   }
 
-  // Preprocess every node in the graph to create an instance of op
-  // kernel for each node.
+  // Create an instance of op kernel for each node.
+  {
+    std::vector<const Node*> nodes;
+    nodes.reserve(graph_->num_nodes());
+    for (const Node* n : graph_->nodes()) nodes.push_back(n);
+    std::vector<OpKernel*> kernels;
+    Status s = CreateKernels(params_, graph_, nodes, &kernels);
+    // Hand the kernels that were created to the destructor, even on error.
+    for (const Node* n : nodes) {
+      gview_.node(n->id())->kernel = kernels[n->id()];
+    }
+    if (!s.ok()) {
+      LOG(ERROR) << "Executor failed to create kernel. " << s;
+      return s;
+    }
+  }
+
+  // Preprocess every node in the graph.
   for (const Node* n : graph_->nodes()) {
     const int id = n->id();
     const string& frame_name = cf_info.frame_names[id];
@@ -644,13 +864,6 @@ Status ExecutorImpl::Initialize() {
     item->input_start = frame_info->total_inputs;
     frame_info->total_inputs += n->num_inputs();
 
-    Status s = params_.create_kernel(n->def(), &item->kernel);
-    if (!s.ok()) {
-      item->kernel = nullptr;
-      s = AttachDef(s, *n);
-      LOG(ERROR) << "Executor failed to create kernel. " << s;
-      return s;
-    }
     CHECK(item->kernel);
     item->kernel_is_expensive = item->kernel->IsExpensive();
     item->kernel_is_async = (item->kernel->AsAsync() != nullptr);
@@ -684,6 +897,7 @@ Status ExecutorImpl::Initialize() {
   // all nodes.
   InitializePending(graph_, cf_info);
 
+  step_arena_pool_ = NewStepArenaPool(params_);
   return gview_.SetAllocAttrs(graph_, params_.device);
 }
 
@@ -718,6 +932,19 @@ Status GraphView::SetAllocAttrs(const Graph* g, const Device* device) {
         attrs[out].Merge(h);
       }
     }
+
+    // The outputs to allocate in the fields of a ScopedAllocator, unless they
+    // need memory of a special kind.
+    const AttrValue* scoped = n->attrs().Find(kScopedAllocatorAttrName);
+    if (scoped != nullptr) {
+      const auto& ids = scoped->list().i();
+      for (int i = 0; i + 1 < ids.size(); i += 2) {
+        const int out = ids.Get(i);
+        if (out >= 0 && out < n->num_outputs() && attrs[out].value == 0) {
+          attrs[out].scope_id = ids.Get(i + 1);
+        }
+      }
+    }
   }
   return s;
 }
@@ -887,6 +1114,7 @@ class ExecutorState {
         : input_tensors(new Entry[total_input_tensors]),
           outstanding_ops(0),
           outstanding_frame_count(0),
+          total_input_tensors_(total_input_tensors),
           counts_(*pending_counts) {  // Initialize with copy of *pending_counts
     }
 
@@ -932,9 +1160,24 @@ class ExecutorState {
                                     dead_result);
     }
 
+    // Releases the values left in the input tensors of a done iteration.
+    void ClearInputs() {
+      for (int i = 0; i < total_input_tensors_; ++i) {
+        input_tensors[i] = Entry();
+      }
+    }
+
+    // Prepares the cleared state of a done iteration for a new iteration.
+    void Reset(const PendingCounts* pending_counts) {
+      outstanding_ops = 0;
+      outstanding_frame_count = 0;
+      counts_.CopyFrom(*pending_counts);
+    }
+
     ~IterationState() { delete[] input_tensors; }
 
    private:
+    const int total_input_tensors_;
     PendingCounts counts_;
   };
 
@@ -1007,6 +1250,11 @@ class ExecutorState {
     // The active iteration states of this frame.
     gtl::InlinedVector<IterationState*, 12> iterations;
 
+    // The states of done iterations, reused by new iterations so that
+    // starting an iteration does not allocate. A frame has at most
+    // max_parallel_iterations + 1 iteration states.
+    std::vector<IterationState*> free_iterations GUARDED_BY(mu);
+
     // The NextIteration nodes to enter a new iteration. If the number of
     // outstanding iterations reaches the limit, we will defer the start of
     // the next iteration until the number of outstanding iterations falls
@@ -1048,6 +1296,17 @@ class ExecutorState {
       return iterations[index];
     }
 
+    // Returns the state of a new iteration.
+    IterationState* NewIterationState() EXCLUSIVE_LOCKS_REQUIRED(mu) {
+      if (free_iterations.empty()) {
+        return new IterationState(pending_counts, total_input_tensors);
+      }
+      IterationState* state = free_iterations.back();
+      free_iterations.pop_back();
+      state->Reset(pending_counts);
+      return state;
+    }
+
     inline void SetIteration(int64 iter, IterationState* state)
         EXCLUSIVE_LOCKS_REQUIRED(mu) {
       size_t index = iter % iterations.size();
@@ -1116,6 +1375,9 @@ class ExecutorState {
         delete iterations[i];
         iterations[i] = nullptr;
       }
+      for (IterationState* state : free_iterations) {
+        delete state;
+      }
     }
   };
 
@@ -1170,6 +1432,14 @@ class ExecutorState {
     int front_index_;
   };
 
+  // A per-worker queue of ready nodes used in work-stealing mode. The
+  // owning worker pushes and pops at the back; other workers steal from
+  // the front.
+  struct ReadyDeque {
+    mutex mu;
+    std::deque<std::pair<TaggedNode, int64>> nodes GUARDED_BY(mu);
+  };
+
   struct AsyncState;
 
   const bool vlog_;  // true if VLOG_IS_ON(1). Used to check vlog cheaply.
@@ -1185,15 +1455,35 @@ class ExecutorState {
   // Step-local container.
   ScopedStepContainer* step_container_;
   StepStatsCollector* stats_collector_;
+  // If positive, nodes whose TraceBucket() is below this value are recorded
+  // in SampledStepTracer, under 'sampled_trace_graph_id_'.
+  uint32 sampled_trace_threshold_;
+  uint32 sampled_trace_graph_id_ = 0;
+  // If true, the sampled nodes track their allocations.
+  const bool sampled_trace_memory_;
   // QUESTION: Make it a checkpoint::TensorSliceReaderCacheWrapper
   // instead of a pointer?  (avoids having to delete).
   checkpoint::TensorSliceReaderCacheWrapper* slice_reader_cache_;
+  // Allocates the scratch tensors of this step, if not null. Owns one
+  // reference.
+  StepArena* step_arena_ = nullptr;
   FunctionCallFrame* call_frame_;
   const ExecutorImpl* impl_;
   CancellationManager* cancellation_manager_;
   Executor::Args::Runner runner_;
   bool sync_on_finish_;
 
+  // Work-stealing state. Only used if num_workers_ > 0.
+  const int num_workers_;
+  std::unique_ptr<ReadyDeque[]> ready_deques_;
+  std::atomic<int> next_worker_id_;
+  // The number of workers that are running or looking for nodes.
+  std::atomic<int> num_active_workers_;
+  // One reference for each live worker or thread that is pushing nodes
+  // from outside a worker, plus one that is dropped when the last node of
+  // the step is done. Whoever drops the last reference calls Finish().
+  std::atomic<int> num_worker_refs_;
+
   // Owned.
 
   // A flag that is set on error after the frame state has been
@@ -1237,8 +1527,19 @@ class ExecutorState {
   void CleanupFramesIterations(FrameState* frame, int64 iter,
                                TaggedNodeSeq* ready);
 
-  // Process a ready node in current thread.
-  void Process(TaggedNode node, int64 scheduled_usec);
+  // Process a ready node in current thread. "worker_id" is the
+  // work-stealing worker the current thread runs as, or -1.
+  void Process(TaggedNode node, int64 scheduled_usec, int worker_id);
+
+  // Completes 'event' for node 'node_id' and records it in the calling
+  // thread's SampledStepTracer ring.
+  void RecordSampledTrace(int node_id, SampledStepTracer::Event* event) {
+    event->step_id = step_id_;
+    event->graph_id = sampled_trace_graph_id_;
+    event->node_id = node_id;
+    event->all_end_micros = nodestats::NowInUsec();
+    SampledStepTracer::Global()->Record(*event);
+  }
 
   // Before invoking item->kernel, fills in its "inputs".
   Status PrepareInputs(const NodeItem& item, Entry* first_input,
@@ -1261,12 +1562,37 @@ class ExecutorState {
   // execution has completed.
   bool NodeDone(const Status& s, const Node* node, const TaggedNodeSeq& ready,
                 NodeExecStatsWrapper* stats,
-                TaggedNodeReadyQueue* inline_ready);
+                TaggedNodeReadyQueue* inline_ready, int worker_id);
 
   // Schedule all the expensive nodes in 'ready', and put all the inexpensive
   // nodes in 'ready' into 'inline_ready'.
   void ScheduleReady(const TaggedNodeSeq& ready,
-                     TaggedNodeReadyQueue* inline_ready);
+                     TaggedNodeReadyQueue* inline_ready, int worker_id);
+
+  // Runs 'node' on another thread: through runner_, or in work-stealing
+  // mode by pushing it onto the deque of 'worker_id' (a round-robin deque
+  // if 'worker_id' is -1).
+  void Dispatch(const TaggedNode& node, int64 scheduled_usec, int worker_id);
+
+  // Work-stealing mode only. Pops a node from the back of the deque of
+  // 'worker_id', or steals one from the front of another deque. Returns
+  // false if all deques are empty.
+  bool PopOrStealReady(int worker_id, TaggedNode* node, int64* scheduled_usec);
+
+  // Work-stealing mode only. Starts a new worker through runner_ unless
+  // num_workers_ workers are already active. The caller must hold a
+  // reference in num_worker_refs_.
+  void MaybeStartWorker();
+
+  // Work-stealing mode only. Runs ready nodes until all deques are empty.
+  void WorkerLoop(int worker_id);
+
+  // Called when the last node of the step is done.
+  void StepDone();
+
+  // Drops a reference in num_worker_refs_, calling Finish() if it was the
+  // last one.
+  void ReleaseWorkerRef();
 
   // For debugging/logging only.
   inline void MaybeMarkCompleted(FrameState* frame, int64 iter, int64 id);
@@ -1306,13 +1632,32 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
       tensor_store_(args.tensor_store),
       step_container_(args.step_container),
       stats_collector_(args.stats_collector),
+      sampled_trace_threshold_(
+          args.stats_collector
+              ? 0
+              : SampledTraceThreshold(args.sampled_trace_node_fraction)),
+      sampled_trace_memory_(args.sampled_trace_memory),
       slice_reader_cache_(new checkpoint::TensorSliceReaderCacheWrapper),
       call_frame_(args.call_frame),
       impl_(impl),
       cancellation_manager_(args.cancellation_manager),
       runner_(args.runner),
       sync_on_finish_(args.sync_on_finish),
+      num_workers_(impl->params_.num_work_stealing_workers),
+      next_worker_id_(0),
+      num_active_workers_(0),
+      num_worker_refs_(1),
       num_outstanding_ops_(0) {
+  if (num_workers_ > 0) {
+    ready_deques_.reset(new ReadyDeque[num_workers_]);
+  }
+  if (sampled_trace_threshold_ > 0) {
+    sampled_trace_graph_id_ = impl_->sampled_trace_graph_.GetId(
+        impl_->graph_, impl_->params_.device);
+  }
+  if (impl_->step_arena_pool_ != nullptr) {
+    step_arena_ = new StepArena(impl_->step_arena_pool_);
+  }
   // We start the entire execution in iteration 0 of the root frame
   // so let us create the root frame and the state for iteration 0.
   // We assume root_frame_->frame_name.empty().
@@ -1336,6 +1681,7 @@ ExecutorState::~ExecutorState() {
     it->Unref();
   }
   delete slice_reader_cache_;
+  if (step_arena_ != nullptr) step_arena_->Unref();
 }
 
 Status ExecutorImpl::BuildControlFlowInfo(const Graph* g,
@@ -1445,7 +1791,7 @@ void ExecutorState::RunAsync(Executor::DoneCallback done) {
     root_frame_->iterations[0]->outstanding_ops = ready.size();
     done_cb_ = std::move(done);
     // Schedule to run all the ready ops in thread pool.
-    ScheduleReady(ready, nullptr);
+    ScheduleReady(ready, nullptr, -1);
   }
 }
 
@@ -1484,6 +1830,8 @@ struct ExecutorState::AsyncState {
   Entry* first_input;
   OpKernelContext ctx;
   NodeExecStatsWrapper* stats;
+  bool sample_trace = false;
+  SampledStepTracer::Event trace_event;
 
  private:
   OpKernelContext::Params* ParamsButClearingEigenGPUDevice(
@@ -1495,7 +1843,8 @@ struct ExecutorState::AsyncState {
   }
 };
 
-void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
+void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec,
+                            int worker_id) {
   const GraphView& gview = impl_->gview_;
   TaggedNodeSeq ready;
   TaggedNodeReadyQueue inline_ready;
@@ -1520,6 +1869,8 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
   params.resource_manager = device->resource_manager();
   params.step_container = step_container_;
   params.slice_reader_cache = slice_reader_cache_;
+  params.scratch_allocator =
+      step_arena_ != nullptr ? step_arena_->allocator() : nullptr;
   params.inputs = &inputs;
   params.input_device_contexts = &input_device_contexts;
   params.input_alloc_attrs = &input_alloc_attrs;
@@ -1562,6 +1913,14 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
       nodestats::SetScheduled(stats, scheduled_usec);
       nodestats::SetAllStart(stats);
     }
+    const bool sample_trace =
+        sampled_trace_threshold_ > 0 && !tagged_node.is_dead &&
+        TraceBucket(id, step_id_) < sampled_trace_threshold_;
+    SampledStepTracer::Event trace_event;
+    if (sample_trace) {
+      trace_event.all_start_micros = nodestats::NowInUsec();
+      params.track_allocations = sampled_trace_memory_;
+    }
 
     if (vlog_) {
       VLOG(1) << "Process node: " << id << " step " << params.step_id << " "
@@ -1593,7 +1952,8 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         }
         MaybeMarkCompleted(input_frame, input_iter, id);
         // Continue to process the nodes in 'inline_ready'.
-        completed = NodeDone(s, item.node, ready, stats, &inline_ready);
+        completed =
+            NodeDone(s, item.node, ready, stats, &inline_ready, worker_id);
         continue;
       }
 
@@ -1618,9 +1978,15 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
           Entry* first_input = state->first_input;  // Shorthand
 
           nodestats::SetOpEnd(stats);
+          if (state->sample_trace) {
+            state->trace_event.op_end_micros = nodestats::NowInUsec();
+          }
           EntryVector outputs;
           Status s = ProcessOutputs(*state->item, &state->ctx, &outputs, stats);
           nodestats::SetMemory(stats, &state->ctx);
+          if (state->sample_trace) {
+            nodestats::SetSampledMemory(&state->ctx, &state->trace_event);
+          }
           if (vlog_) {
             VLOG(2) << "Async kernel done: " << state->item->node->id()
                     << " step " << step_id_ << " "
@@ -1651,19 +2017,29 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
             device->ConsumeListOfAccessedTensors(state->ctx.op_device_context(),
                                                  accessed);
           }
+          if (state->sample_trace) {
+            RecordSampledTrace(id, &state->trace_event);
+          }
           const bool completed =
-              NodeDone(s, state->item->node, ready, stats, nullptr);
+              NodeDone(s, state->item->node, ready, stats, nullptr, -1);
           delete state;
-          if (completed) Finish();
+          if (completed) StepDone();
         };
         nodestats::SetOpStart(stats);
+        if (sample_trace) {
+          state->sample_trace = true;
+          state->trace_event = trace_event;
+          state->trace_event.op_start_micros = nodestats::NowInUsec();
+        }
         device->ComputeAsync(async, &state->ctx, done);
       } else {
         // Synchronous computes.
         OpKernelContext ctx(&params, item.num_outputs);
         nodestats::SetOpStart(stats);
+        if (sample_trace) trace_event.op_start_micros = nodestats::NowInUsec();
         device->Compute(CHECK_NOTNULL(op_kernel), &ctx);
         nodestats::SetOpEnd(stats);
+        if (sample_trace) trace_event.op_end_micros = nodestats::NowInUsec();
         s = ProcessOutputs(item, &ctx, &outputs, stats);
         if (s.ok() && impl_->device_record_tensor_accesses_) {
           // Get the list of all tensors accessed during the execution
@@ -1671,6 +2047,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
           device_context = ctx.op_device_context();
         }
         nodestats::SetMemory(stats, &ctx);
+        if (sample_trace) nodestats::SetSampledMemory(&ctx, &trace_event);
       }
     }
 
@@ -1700,13 +2077,15 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
       if (stats) {
         scheduled_usec = nodestats::NowInUsec();
       }
+      if (sample_trace) RecordSampledTrace(id, &trace_event);
       // Postprocess.
-      completed = NodeDone(s, item.node, ready, stats, &inline_ready);
+      completed =
+          NodeDone(s, item.node, ready, stats, &inline_ready, worker_id);
     }
   }  // while !inline_ready.empty()
 
   // This thread of computation is done if completed = true.
-  if (completed) Finish();
+  if (completed) StepDone();
 }
 
 Status ExecutorState::PrepareInputs(const NodeItem& item, Entry* first_input,
@@ -2015,7 +2394,8 @@ void ExecutorState::PropagateOutputs(const TaggedNode& tagged_node,
 bool ExecutorState::NodeDone(const Status& s, const Node* node,
                              const TaggedNodeSeq& ready,
                              NodeExecStatsWrapper* stats,
-                             TaggedNodeReadyQueue* inline_ready) {
+                             TaggedNodeReadyQueue* inline_ready,
+                             int worker_id) {
   nodestats::SetAllEnd(stats);
   if (stats_collector_ != nullptr && !SetTimelineLabel(node, stats)) {
     // Only record non-transfer nodes.
@@ -2054,13 +2434,14 @@ bool ExecutorState::NodeDone(const Status& s, const Node* node,
 
   // Schedule the ready nodes in 'ready'.
   if (s.ok()) {
-    ScheduleReady(ready, inline_ready);
+    ScheduleReady(ready, inline_ready, worker_id);
   }
   return completed;
 }
 
 void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
-                                  TaggedNodeReadyQueue* inline_ready) {
+                                  TaggedNodeReadyQueue* inline_ready,
+                                  int worker_id) {
   if (ready.empty()) return;
 
   int64 scheduled_usec = 0;
@@ -2068,9 +2449,19 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
     scheduled_usec = nodestats::NowInUsec();
   }
   if (inline_ready == nullptr) {
+    if (num_workers_ > 0) {
+      // We are not running as a worker, so hold a reference to keep the
+      // step from finishing (and deleting this) while we push nodes.
+      num_worker_refs_.fetch_add(1);
+      for (auto& tagged_node : ready) {
+        Dispatch(tagged_node, scheduled_usec, -1);
+      }
+      ReleaseWorkerRef();
+      return;
+    }
     // Schedule to run all the ready ops in thread pool.
     for (auto& tagged_node : ready) {
-      runner_([=]() { Process(tagged_node, scheduled_usec); });
+      runner_([=]() { Process(tagged_node, scheduled_usec, -1); });
     }
     return;
   }
@@ -2085,8 +2476,7 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
       if (curr_expensive_node) {
         // Dispatch to another thread since there is plenty of work to
         // do for this thread.
-        runner_(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                          scheduled_usec));
+        Dispatch(*curr_expensive_node, scheduled_usec, worker_id);
       }
       curr_expensive_node = &tagged_node;
     }
@@ -2098,12 +2488,104 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
     } else {
       // There are inline nodes to run already. We dispatch this expensive
       // node to other thread.
-      runner_(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                        scheduled_usec));
+      Dispatch(*curr_expensive_node, scheduled_usec, worker_id);
+    }
+  }
+}
+
+void ExecutorState::Dispatch(const TaggedNode& node, int64 scheduled_usec,
+                             int worker_id) {
+  if (num_workers_ == 0) {
+    runner_(std::bind(&ExecutorState::Process, this, node, scheduled_usec, -1));
+    return;
+  }
+  if (worker_id < 0) {
+    worker_id = next_worker_id_.fetch_add(1, std::memory_order_relaxed) %
+                num_workers_;
+  }
+  ReadyDeque* deque = &ready_deques_[worker_id];
+  {
+    mutex_lock l(deque->mu);
+    deque->nodes.emplace_back(node, scheduled_usec);
+  }
+  // If all workers are active, one of them will find 'node' before it
+  // goes idle (see WorkerLoop).
+  MaybeStartWorker();
+}
+
+bool ExecutorState::PopOrStealReady(int worker_id, TaggedNode* node,
+                                    int64* scheduled_usec) {
+  {
+    ReadyDeque* own = &ready_deques_[worker_id];
+    mutex_lock l(own->mu);
+    if (!own->nodes.empty()) {
+      *node = own->nodes.back().first;
+      *scheduled_usec = own->nodes.back().second;
+      own->nodes.pop_back();
+      return true;
+    }
+  }
+  for (int i = 1; i < num_workers_; ++i) {
+    ReadyDeque* victim = &ready_deques_[(worker_id + i) % num_workers_];
+    mutex_lock l(victim->mu);
+    if (!victim->nodes.empty()) {
+      *node = victim->nodes.front().first;
+      *scheduled_usec = victim->nodes.front().second;
+      victim->nodes.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ExecutorState::MaybeStartWorker() {
+  int active = num_active_workers_.load();
+  while (active < num_workers_) {
+    if (num_active_workers_.compare_exchange_weak(active, active + 1)) {
+      num_worker_refs_.fetch_add(1);
+      const int worker_id =
+          next_worker_id_.fetch_add(1, std::memory_order_relaxed) %
+          num_workers_;
+      runner_([this, worker_id]() { WorkerLoop(worker_id); });
+      return;
     }
   }
 }
 
+void ExecutorState::WorkerLoop(int worker_id) {
+  TaggedNode tagged_node(nullptr, nullptr, -1, false);
+  int64 scheduled_usec = 0;
+  while (true) {
+    if (PopOrStealReady(worker_id, &tagged_node, &scheduled_usec)) {
+      Process(tagged_node, scheduled_usec, worker_id);
+      continue;
+    }
+    // Go idle. A node pushed before the decrement below is found by the
+    // second scan; a node pushed after it starts a new worker.
+    num_active_workers_.fetch_sub(1);
+    if (!PopOrStealReady(worker_id, &tagged_node, &scheduled_usec)) {
+      break;
+    }
+    num_active_workers_.fetch_add(1);
+    Process(tagged_node, scheduled_usec, worker_id);
+  }
+  ReleaseWorkerRef();
+}
+
+void ExecutorState::StepDone() {
+  if (num_workers_ == 0) {
+    Finish();
+  } else {
+    ReleaseWorkerRef();
+  }
+}
+
+void ExecutorState::ReleaseWorkerRef() {
+  if (num_worker_refs_.fetch_sub(1) == 1) {
+    Finish();
+  }
+}
+
 inline void ExecutorState::MaybeMarkCompleted(FrameState* frame, int64 iter,
                                               int64 node_id) {
   // TODO(misard) Replace with a finer-grain enabling flag once we
@@ -2545,8 +3027,7 @@ void ExecutorState::FrameState::IncrementIteration(const GraphView* gview,
   const int64 next_iter = iteration_count;
 
   // Initialize the next iteration.
-  IterationState* iter_state =
-      new IterationState(pending_counts, total_input_tensors);
+  IterationState* iter_state = NewIterationState();
   SetIteration(next_iter, iter_state);
   num_outstanding_iterations++;
   dead_exits.clear();
@@ -2563,8 +3044,10 @@ bool ExecutorState::FrameState::CleanupIterations(const GraphView* gview,
                                                   TaggedNodeSeq* ready) {
   int64 curr_iter = iter;
   while (curr_iter <= iteration_count && IsIterationDone(curr_iter)) {
-    // Delete the iteration curr_iter.
-    delete GetIteration(curr_iter);
+    // Recycle the iteration curr_iter.
+    IterationState* done_state = GetIteration(curr_iter);
+    done_state->ClearInputs();
+    free_iterations.push_back(done_state);
     SetIteration(curr_iter, nullptr);
     --num_outstanding_iterations;
     ++curr_iter;
@@ -2582,10 +3065,911 @@ void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
   (new ExecutorState(args, this))->RunAsync(std::move(done));
 }
 
+// An executor for graphs without control flow, i.e. without Switch,
+// Merge, Enter, Exit or NextIteration nodes. Initialize() computes a
+// topological order of the nodes once and resolves every out edge to a
+// fixed slot in a flat array of input entries. A step then walks that
+// plan: there are no frames, pending counts or ready queues, and at most
+// one kernel of the step runs at a time.
+class LinearExecutorImpl : public Executor {
+ public:
+  LinearExecutorImpl(const LocalExecutorParams& p, const Graph* g)
+      : params_(p), graph_(g) {
+    CHECK(p.create_kernel != nullptr);
+    CHECK(p.delete_kernel != nullptr);
+  }
+
+  ~LinearExecutorImpl() override {
+    for (StepSlab* step_slab : free_step_slabs_) {
+      step_slab->slab->Unref();
+      delete step_slab;
+    }
+    for (int i = 0; i < graph_->num_node_ids(); i++) {
+      NodeItem* item = gview_.node(i);
+      if (item != nullptr) {
+        params_.delete_kernel(item->kernel);
+      }
+    }
+    delete graph_;
+  }
+
+  // Returns true iff "graph" can be run by a LinearExecutorImpl.
+  static bool CanRun(const Graph& graph);
+
+  Status Initialize();
+
+  void RunAsync(const Args& args, DoneCallback done) override;
+
+ private:
+  friend class LinearExecutorState;
+
+  // An out edge of a plan node, resolved at initialization time.
+  struct PlanEdge {
+    // Graph::kControlSlot for control edges.
+    int output_slot;
+    // The index of the destination node in plan_.
+    int dst_index;
+    // The index of the destination input in the step's input entries,
+    // or -1 for control edges.
+    int dst_loc;
+    // True iff this is the last edge out of output_slot, so the output
+    // can be moved instead of copied.
+    bool is_last;
+  };
+
+  struct PlanNode {
+    const NodeItem* item;
+    bool is_transfer;
+    bool is_control_trigger;
+    // The out edges of this node are edges_[edges_start, edges_limit).
+    int edges_start;
+    int edges_limit;
+    // Output i of this node is output (output_start + i) of the plan.
+    int output_start;
+  };
+
+  // The slab of a MemoryPlan used by one step at a time.
+  // output_allocators[i] allocates output i of the plan, if not null.
+  struct StepSlab {
+    MemoryPlanSlab* slab = nullptr;  // Owns one reference.
+    std::vector<Allocator*> output_allocators;
+    // True iff the step must profile its allocations, because the memory
+    // plan is not known yet.
+    bool profile = false;
+  };
+
+  // Sets up profile_plan_ and profile_slots_.
+  void InitializeMemoryPlanning();
+
+  // Returns the slab to use for a new step. REQUIRES: use_memory_planning_.
+  StepSlab* AcquireStepSlab() const;
+  void ReleaseStepSlab(StepSlab* step_slab) const;
+
+  // Sets the memory plan from the 'buffers' of a profiled step, where
+  // output i of the plan was allocated as buffers[output_buffers[i]], or
+  // not planned if output_buffers[i] is -1. The first profiled step wins.
+  void SetMemoryPlan(const std::vector<MemoryPlanBuffer>& buffers,
+                     const std::vector<int>& output_buffers) const;
+
+  LocalExecutorParams params_;
+  const Graph* graph_;
+  GraphView gview_;
+
+  // Names the nodes of graph_ in sampled traces.
+  mutable SampledTraceGraph sampled_trace_graph_;
+
+  // A cached value of params_
+  bool device_record_tensor_accesses_ = false;
+
+  // All nodes of graph_ in topological order.
+  std::vector<PlanNode> plan_;
+  std::vector<PlanEdge> edges_;
+
+  // The total number of inputs of all nodes.
+  int total_inputs_ = 0;
+  // The total number of outputs of all nodes.
+  int total_outputs_ = 0;
+
+  // See LocalExecutorParams::use_memory_planning. Until the memory plan is
+  // known, steps allocate the outputs that may be planned, i.e. those with
+  // profile_slots_[i] >= 0, from a slab of profile_plan_, which records
+  // their sizes but never uses slab memory.
+  bool use_memory_planning_ = false;
+  std::shared_ptr<const MemoryPlan> profile_plan_;
+  std::vector<int> profile_slots_;
+
+  mutable mutex memory_plan_mu_;
+  mutable std::shared_ptr<const MemoryPlan> memory_plan_
+      GUARDED_BY(memory_plan_mu_);
+  // Output i of the plan is buffer memory_plan_slots_[i] of memory_plan_,
+  // or is not planned if it is -1.
+  mutable std::vector<int> memory_plan_slots_ GUARDED_BY(memory_plan_mu_);
+  mutable std::vector<StepSlab*> free_step_slabs_ GUARDED_BY(memory_plan_mu_);
+
+  // See ExecutorImpl::step_arena_pool_.
+  std::shared_ptr<StepArena::SlabPool> step_arena_pool_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(LinearExecutorImpl);
+};
+
+bool LinearExecutorImpl::CanRun(const Graph& graph) {
+  for (const Node* n : graph.nodes()) {
+    if (n->IsControlFlow()) return false;
+  }
+  return true;
+}
+
+Status LinearExecutorImpl::Initialize() {
+  gview_.Initialize(graph_);
+
+  // Cache this value so we make this virtual function call once, rather
+  // that O(# steps * # nodes per step) times.
+  device_record_tensor_accesses_ =
+      params_.device->RequiresRecordingAccessedTensors();
+
+  std::vector<Node*> order;
+  GetReversePostOrder(*graph_, &order);
+  if (order.size() != graph_->num_nodes()) {
+    return errors::Internal("Not all nodes of the graph are reachable from ",
+                            "the source node");
+  }
+
+  {
+    std::vector<const Node*> nodes(order.begin(), order.end());
+    std::vector<OpKernel*> kernels;
+    Status s = CreateKernels(params_, graph_, nodes, &kernels);
+    for (const Node* n : nodes) {
+      gview_.node(n->id())->kernel = kernels[n->id()];
+    }
+    if (!s.ok()) {
+      LOG(ERROR) << "Executor failed to create kernel. " << s;
+      return s;
+    }
+  }
+
+  std::vector<int> plan_index(graph_->num_node_ids(), -1);
+  plan_.reserve(order.size());
+  for (const Node* n : order) {
+    NodeItem* item = gview_.node(n->id());
+    item->node = n;
+    item->input_start = total_inputs_;
+    total_inputs_ += n->num_inputs();
+
+    CHECK(item->kernel);
+    item->kernel_is_expensive = item->kernel->IsExpensive();
+    item->kernel_is_async = (item->kernel->AsAsync() != nullptr);
+    item->is_merge = false;
+    item->is_enter = false;
+    item->is_exit = false;
+    item->is_control_trigger = IsControlTrigger(n);
+    item->is_sink = IsSink(n);
+    item->is_enter_exit_or_next_iter = false;
+
+    plan_index[n->id()] = plan_.size();
+    PlanNode pn;
+    pn.item = item;
+    pn.is_transfer = IsTransferNode(n);
+    pn.is_control_trigger = item->is_control_trigger;
+    pn.output_start = total_outputs_;
+    total_outputs_ += n->num_outputs();
+    plan_.push_back(pn);
+  }
+
+  // Input slots are only known once every node has been numbered.
+  for (PlanNode& pn : plan_) {
+    pn.edges_start = edges_.size();
+    for (size_t i = 0; i < pn.item->num_output_edges; ++i) {
+      const EdgeInfo& e = pn.item->output_edge(i);
+      PlanEdge pe;
+      pe.output_slot = e.output_slot;
+      pe.dst_index = plan_index[e.dst_id];
+      pe.dst_loc = (e.output_slot == Graph::kControlSlot)
+                       ? -1
+                       : gview_.node(e.dst_id)->input_start + e.input_slot;
+      pe.is_last = e.is_last;
+      DCHECK_GT(pe.dst_index, plan_index[pn.item->node->id()]);
+      edges_.push_back(pe);
+    }
+    pn.edges_limit = edges_.size();
+  }
+
+  TF_RETURN_IF_ERROR(gview_.SetAllocAttrs(graph_, params_.device));
+  use_memory_planning_ = params_.use_memory_planning &&
+                         params_.device->device_type() == DEVICE_CPU;
+  if (use_memory_planning_) InitializeMemoryPlanning();
+  step_arena_pool_ = NewStepArenaPool(params_);
+  return Status::OK();
+}
+
+void LinearExecutorImpl::InitializeMemoryPlanning() {
+  std::vector<MemoryPlanBuffer> buffers;
+  profile_slots_.assign(total_outputs_, -1);
+  for (const PlanNode& pn : plan_) {
+    const NodeItem& item = *pn.item;
+    for (int i = 0; i < item.num_outputs; ++i) {
+      const DataType dtype = item.output_type(i);
+      if (IsRefType(dtype) || !DataTypeCanUseMemcpy(dtype) ||
+          item.output_attrs()[i].value != 0 ||
+          item.output_attrs()[i].scope_id != 0) {
+        continue;
+      }
+      profile_slots_[pn.output_start + i] = buffers.size();
+      buffers.push_back(MemoryPlanBuffer());
+    }
+  }
+  profile_plan_.reset(new MemoryPlan(buffers));
+}
+
+LinearExecutorImpl::StepSlab* LinearExecutorImpl::AcquireStepSlab() const {
+  std::shared_ptr<const MemoryPlan> plan;
+  const std::vector<int>* slots;
+  {
+    mutex_lock l(memory_plan_mu_);
+    if (!free_step_slabs_.empty()) {
+      StepSlab* step_slab = free_step_slabs_.back();
+      free_step_slabs_.pop_back();
+      return step_slab;
+    }
+    plan = memory_plan_;
+    // memory_plan_slots_ does not change once memory_plan_ is set.
+    slots = &memory_plan_slots_;
+  }
+  StepSlab* step_slab = new StepSlab;
+  if (plan == nullptr) {
+    step_slab->profile = true;
+    plan = profile_plan_;
+    slots = &profile_slots_;
+  }
+  step_slab->slab = new MemoryPlanSlab(
+      std::move(plan), params_.device->GetAllocator(AllocatorAttributes()));
+  step_slab->output_allocators.resize(total_outputs_, nullptr);
+  for (int i = 0; i < total_outputs_; ++i) {
+    if ((*slots)[i] >= 0) {
+      step_slab->output_allocators[i] =
+          step_slab->slab->slot_allocator((*slots)[i]);
+    }
+  }
+  return step_slab;
+}
+
+void LinearExecutorImpl::ReleaseStepSlab(StepSlab* step_slab) const {
+  if (!step_slab->profile) {
+    mutex_lock l(memory_plan_mu_);
+    free_step_slabs_.push_back(step_slab);
+    return;
+  }
+  step_slab->slab->Unref();
+  delete step_slab;
+}
+
+void LinearExecutorImpl::SetMemoryPlan(
+    const std::vector<MemoryPlanBuffer>& buffers,
+    const std::vector<int>& output_buffers) const {
+  std::shared_ptr<const MemoryPlan> plan(new MemoryPlan(buffers));
+  int64 total_bytes = 0;
+  for (const MemoryPlanBuffer& buffer : buffers) total_bytes += buffer.size;
+  mutex_lock l(memory_plan_mu_);
+  if (memory_plan_ != nullptr) return;
+  VLOG(1) << "Memory plan for " << params_.device->name() << ": "
+          << buffers.size() << " outputs, " << total_bytes << " bytes in a "
+          << plan->slab_size() << " byte slab";
+  memory_plan_ = std::move(plan);
+  memory_plan_slots_ = output_buffers;
+}
+
+// The state associated with one invocation of LinearExecutorImpl::Run.
+// Kernels are run in plan order by whichever thread finished the previous
+// one, so none of the state below needs to be locked.
+class LinearExecutorState {
+ public:
+  LinearExecutorState(const Executor::Args& args, LinearExecutorImpl* impl);
+  ~LinearExecutorState();
+
+  void RunAsync(Executor::DoneCallback done);
+
+ private:
+  typedef LinearExecutorImpl::PlanNode PlanNode;
+
+  // Either a tensor pointer (pass-by-reference) or a tensor (pass-by-value).
+  struct Entry {
+    Tensor val;
+    Tensor* ref = nullptr;    // A tensor reference.
+    mutex* ref_mu = nullptr;  // mutex for *ref if ref is not nullptr.
+
+    // Whether the value exists, either in <val> or <ref>.
+    bool has_value = false;
+
+    // The attributes of the allocator that creates the tensor.
+    AllocatorAttributes alloc_attr;
+
+    // The DeviceContext the tensor was produced in, if any.
+    DeviceContext* device_context = nullptr;
+
+    void Clear() {
+      val = Tensor();
+      ref = nullptr;
+      ref_mu = nullptr;
+      has_value = false;
+    }
+  };
+
+  // Runs plan nodes starting at "index" until the plan is done, a node
+  // fails, or an asynchronous kernel is launched. In the latter case the
+  // kernel's done callback resumes the plan.
+  void RunFrom(size_t index);
+
+  // Before invoking the kernel of "pn", fills in inputs_.
+  Status PrepareInputs(const PlanNode& pn, bool* is_input_dead);
+
+  // After the kernel of "pn" is done, moves its outputs into the input
+  // entries of its consumers. Clears the inputs of "pn".
+  Status ProcessOutputs(size_t index, OpKernelContext* ctx,
+                        NodeExecStatsWrapper* stats);
+
+  // Marks all consumers of plan_[index] dead.
+  void PropagateDeadness(size_t index);
+
+  // While profiling memory, before the inputs of plan_[index] are
+  // cleared, finds the buffers of its outputs: either one allocated from
+  // the profiling slab, or the buffer of a forwarded input.
+  void ProfileOutputs(size_t index, OpKernelContext* ctx);
+
+  // "pn" just finishes with status "s". Takes ownership of "stats".
+  // Returns false if the step must stop.
+  bool NodeDone(const Status& s, const PlanNode& pn,
+                NodeExecStatsWrapper* stats);
+
+  void ClearInputs(const PlanNode& pn);
+
+  // Completes 'event' for node 'node_id' and records it in the calling
+  // thread's SampledStepTracer ring.
+  void RecordSampledTrace(int node_id, SampledStepTracer::Event* event) {
+    event->step_id = params_.step_id;
+    event->graph_id = sampled_trace_graph_id_;
+    event->node_id = node_id;
+    event->all_end_micros = nodestats::NowInUsec();
+    SampledStepTracer::Global()->Record(*event);
+  }
+
+  // Clean up when this executor is done.
+  void Finish();
+
+  const bool log_memory_;
+  Rendezvous* rendezvous_;
+  StepStatsCollector* stats_collector_;
+  // If positive, nodes whose TraceBucket() is below this value are recorded
+  // in SampledStepTracer, under 'sampled_trace_graph_id_'.
+  const uint32 sampled_trace_threshold_;
+  uint32 sampled_trace_graph_id_ = 0;
+  // If true, the sampled nodes track their allocations.
+  const bool sampled_trace_memory_;
+  CancellationManager* cancellation_manager_;
+  Executor::Args::Runner runner_;
+  bool sync_on_finish_;
+  const LinearExecutorImpl* impl_;
+  checkpoint::TensorSliceReaderCacheWrapper slice_reader_cache_;
+
+  // Contains a value for [node->id()] for the device context assigned by
+  // the device at the beginning of a step.
+  DeviceContextMap device_context_map_;
+
+  // Input entries of all nodes, indexed by NodeItem::input_start.
+  std::vector<Entry> entries_;
+  // Deadness of each plan node.
+  std::vector<bool> is_dead_;
+
+  // The slab that allocates planned outputs, or nullptr if memory planning
+  // is off for this step.
+  LinearExecutorImpl::StepSlab* step_slab_ = nullptr;
+  // Only used if step_slab_->profile: the buffers allocated in this step,
+  // and the buffer of each input entry and plan output, or -1.
+  // planned_output_buffers_ only includes the outputs that allocated
+  // their buffer.
+  std::vector<MemoryPlanBuffer> profiled_buffers_;
+  std::vector<int> entry_buffers_;
+  std::vector<int> output_buffers_;
+  std::vector<int> planned_output_buffers_;
+
+  // Allocates the scratch tensors of this step, if not null. Owns one
+  // reference.
+  StepArena* step_arena_ = nullptr;
+
+  // Parameters passed to OpKernel::Compute. Only one kernel runs at a
+  // time, so these are shared by all nodes.
+  TensorValueVec inputs_;
+  DeviceContextVec input_device_contexts_;
+  AllocatorAttributeVec input_alloc_attrs_;
+  OpKernelContext::Params params_;
+
+  Status status_;
+  Executor::DoneCallback done_cb_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(LinearExecutorState);
+};
+
+LinearExecutorState::LinearExecutorState(const Executor::Args& args,
+                                         LinearExecutorImpl* impl)
+    : log_memory_(LogMemory::IsEnabled()),
+      rendezvous_(args.rendezvous),
+      stats_collector_(args.stats_collector),
+      sampled_trace_threshold_(
+          args.stats_collector
+              ? 0
+              : SampledTraceThreshold(args.sampled_trace_node_fraction)),
+      sampled_trace_memory_(args.sampled_trace_memory),
+      cancellation_manager_(args.cancellation_manager),
+      runner_(args.runner),
+      sync_on_finish_(args.sync_on_finish),
+      impl_(impl),
+      entries_(impl->total_inputs_),
+      is_dead_(impl->plan_.size(), false) {
+  Device* device = impl_->params_.device;
+  if (sampled_trace_threshold_ > 0) {
+    sampled_trace_graph_id_ =
+        impl_->sampled_trace_graph_.GetId(impl_->graph_, device);
+  }
+  params_.step_id = args.step_id;
+  params_.device = device;
+  params_.log_memory = log_memory_;
+  params_.record_tensor_accesses = impl_->device_record_tensor_accesses_;
+  params_.rendezvous = rendezvous_;
+  params_.session_state = args.session_state;
+  params_.tensor_store = args.tensor_store;
+  params_.cancellation_manager = cancellation_manager_;
+  params_.call_frame = args.call_frame;
+  params_.function_library = impl_->params_.function_library;
+  params_.resource_manager = device->resource_manager();
+  params_.step_container = args.step_container;
+  params_.slice_reader_cache = &slice_reader_cache_;
+  params_.inputs = &inputs_;
+  params_.input_device_contexts = &input_device_contexts_;
+  params_.input_alloc_attrs = &input_alloc_attrs_;
+  params_.runner = &runner_;
+  params_.stats_collector = stats_collector_;
+  params_.frame_iter = FrameAndIter(0, 0);
+  if (impl_->step_arena_pool_ != nullptr) {
+    step_arena_ = new StepArena(impl_->step_arena_pool_);
+    params_.scratch_allocator = step_arena_->allocator();
+  }
+  // Traced steps keep using the device allocator, so that their memory
+  // stats are meaningful.
+  if (impl_->use_memory_planning_ && stats_collector_ == nullptr) {
+    step_slab_ = impl_->AcquireStepSlab();
+    if (step_slab_->profile) {
+      entry_buffers_.assign(impl_->total_inputs_, -1);
+      output_buffers_.assign(impl_->total_outputs_, -1);
+      planned_output_buffers_.assign(impl_->total_outputs_, -1);
+    }
+  }
+}
+
+LinearExecutorState::~LinearExecutorState() {
+  for (auto it : device_context_map_) {
+    it->Unref();
+  }
+  if (step_slab_ != nullptr) impl_->ReleaseStepSlab(step_slab_);
+  if (step_arena_ != nullptr) step_arena_->Unref();
+}
+
+void LinearExecutorState::RunAsync(Executor::DoneCallback done) {
+  // Ask the device to fill in the device context map.
+  const Status fill_status =
+      impl_->params_.device->FillContextMap(impl_->graph_,
+                                            &device_context_map_);
+  if (!fill_status.ok()) {
+    delete this;
+    done(fill_status);
+    return;
+  }
+  done_cb_ = std::move(done);
+  runner_([this]() { RunFrom(0); });
+}
+
+void LinearExecutorState::RunFrom(size_t index) {
+  const std::vector<PlanNode>& plan = impl_->plan_;
+  Device* device = impl_->params_.device;
+  for (; index < plan.size(); ++index) {
+    const PlanNode& pn = plan[index];
+    const NodeItem& item = *pn.item;
+    const int id = item.node->id();
+
+    const bool is_dead = is_dead_[index] && !pn.is_control_trigger;
+    if (is_dead && !pn.is_transfer) {
+      ClearInputs(pn);
+      PropagateDeadness(index);
+      continue;
+    }
+
+    NodeExecStatsWrapper* stats = nullptr;
+    params_.track_allocations = false;
+    if (stats_collector_ && !is_dead) {
+      // track allocations if and only if we are collecting statistics
+      params_.track_allocations = true;
+      stats = new NodeExecStatsWrapper;
+      stats->stats()->set_node_name(item.node->name());
+      nodestats::SetScheduled(stats, nodestats::NowInUsec());
+      nodestats::SetAllStart(stats);
+    }
+    const bool sample_trace =
+        sampled_trace_threshold_ > 0 && !is_dead &&
+        TraceBucket(id, params_.step_id) < sampled_trace_threshold_;
+    SampledStepTracer::Event trace_event;
+    if (sample_trace) {
+      trace_event.all_start_micros = nodestats::NowInUsec();
+      params_.track_allocations = sampled_trace_memory_;
+    }
+
+    bool is_input_dead = false;
+    Status s = PrepareInputs(pn, &is_input_dead);
+    if (!s.ok()) {
+      ClearInputs(pn);
+      NodeDone(s, pn, stats);
+      Finish();
+      return;
+    }
+
+    params_.op_device_context =
+        (id < device_context_map_.size()) ? device_context_map_[id] : nullptr;
+    params_.op_kernel = item.kernel;
+    params_.is_input_dead = is_input_dead || is_dead;
+    params_.output_attr_array = item.output_attrs();
+    params_.output_allocators =
+        step_slab_ != nullptr
+            ? step_slab_->output_allocators.data() + pn.output_start
+            : nullptr;
+
+    if (item.kernel_is_async) {
+      AsyncOpKernel* async = item.kernel->AsAsync();
+      DCHECK(async != nullptr);
+      OpKernelContext* ctx = new OpKernelContext(&params_, item.num_outputs);
+      if (sample_trace) trace_event.op_start_micros = nodestats::NowInUsec();
+      auto done = [this, index, ctx, stats, sample_trace, trace_event]() {
+        nodestats::SetOpEnd(stats);
+        SampledStepTracer::Event event = trace_event;
+        if (sample_trace) event.op_end_micros = nodestats::NowInUsec();
+        const PlanNode& pn = impl_->plan_[index];
+        Status s = ProcessOutputs(index, ctx, stats);
+        nodestats::SetMemory(stats, ctx);
+        if (sample_trace) nodestats::SetSampledMemory(ctx, &event);
+        delete ctx;
+        if (sample_trace) RecordSampledTrace(pn.item->node->id(), &event);
+        if (!NodeDone(s, pn, stats)) {
+          Finish();
+          return;
+        }
+        // The callback may run on a thread that must not be blocked by
+        // the rest of this step (e.g. inside a Rendezvous::Send()).
+        runner_([this, index]() { RunFrom(index + 1); });
+      };
+      nodestats::SetOpStart(stats);
+      device->ComputeAsync(async, ctx, done);
+      return;
+    }
+
+    OpKernelContext ctx(&params_, item.num_outputs);
+    nodestats::SetOpStart(stats);
+    if (sample_trace) trace_event.op_start_micros = nodestats::NowInUsec();
+    device->Compute(CHECK_NOTNULL(item.kernel), &ctx);
+    nodestats::SetOpEnd(stats);
+    if (sample_trace) trace_event.op_end_micros = nodestats::NowInUsec();
+    s = ProcessOutputs(index, &ctx, stats);
+    nodestats::SetMemory(stats, &ctx);
+    if (sample_trace) nodestats::SetSampledMemory(&ctx, &trace_event);
+    if (sample_trace) RecordSampledTrace(id, &trace_event);
+    if (!NodeDone(s, pn, stats)) {
+      Finish();
+      return;
+    }
+  }
+  Finish();
+}
+
+Status LinearExecutorState::PrepareInputs(const PlanNode& pn,
+                                          bool* is_input_dead) {
+  const NodeItem& item = *pn.item;
+  inputs_.clear();
+  inputs_.resize(item.num_inputs);
+  input_device_contexts_.clear();
+  input_device_contexts_.resize(item.num_inputs);
+  input_alloc_attrs_.clear();
+  input_alloc_attrs_.resize(item.num_inputs);
+
+  *is_input_dead = false;
+  for (int i = 0; i < item.num_inputs; ++i) {
+    const bool expect_ref = IsRefType(item.input_type(i));
+    Entry* entry = &entries_[item.input_start + i];
+    input_device_contexts_[i] = entry->device_context;
+    input_alloc_attrs_[i] = entry->alloc_attr;
+
+    // i-th input.
+    TensorValue* inp = &inputs_[i];
+
+    // Only transfer nodes can have no-value inputs.
+    if (!entry->has_value) {
+      DCHECK(pn.is_transfer) << item.node->name() << " - input " << i;
+      entry->has_value = true;
+      inp->tensor = &entry->val;
+      *is_input_dead = true;
+      continue;
+    }
+    if (entry->ref == nullptr) {
+      if (expect_ref) {
+        return AttachDef(
+            errors::InvalidArgument(i, "-th input expects a ref type"),
+            item.kernel->def());
+      }
+      inp->tensor = &entry->val;
+    } else {
+      {
+        mutex_lock ml(*entry->ref_mu);
+        if (!entry->ref->IsInitialized() && !IsInitializationOp(item.node)) {
+          return AttachDef(errors::FailedPrecondition(
+                               "Attempting to use uninitialized value ",
+                               item.kernel->requested_input(i)),
+                           item.kernel->def());
+        }
+      }
+      if (expect_ref) {
+        inp->mutex_if_ref = entry->ref_mu;
+        inp->tensor = entry->ref;
+      } else {
+        // Automatically deref the tensor ref when the op expects a
+        // tensor but is given a ref to a tensor.  Need to deref it
+        // under the mutex.
+        {
+          mutex_lock l(*(entry->ref_mu));
+          entry->val = *entry->ref;
+        }
+        entry->ref = nullptr;
+        entry->ref_mu = nullptr;
+        inp->tensor = &entry->val;
+      }
+    }
+  }
+  return Status::OK();
+}
+
+Status LinearExecutorState::ProcessOutputs(size_t index, OpKernelContext* ctx,
+                                           NodeExecStatsWrapper* stats) {
+  const PlanNode& pn = impl_->plan_[index];
+  const NodeItem& item = *pn.item;
+  const Node* node = item.node;
+
+  if (impl_->device_record_tensor_accesses_) {
+    // Get the list of all tensors accessed during the execution
+    TensorReferenceVector accessed;
+    ctx->retrieve_accessed_tensors(&accessed);
+    nodestats::SetReferencedTensors(stats, accessed);
+    // callee takes ownership of the vector
+    impl_->params_.device->ConsumeListOfAccessedTensors(
+        ctx->op_device_context(), accessed);
+  }
+  if (step_slab_ != nullptr && step_slab_->profile && ctx->status().ok()) {
+    ProfileOutputs(index, ctx);
+  }
+  ClearInputs(pn);
+
+  Status s = ctx->status();
+  if (!s.ok()) {
+    return AttachDef(s, item.kernel->def());
+  }
+
+  // Experimental: debugger (tfdb) access to intermediate node completion.
+  if (item.num_outputs == 0 && impl_->params_.node_outputs_cb != nullptr) {
+    // If the node has no output, invoke the callback with output slot set to
+    // -1, signifying that this is a no-output node.
+    s.Update(impl_->params_.node_outputs_cb(item.node->name(), -1, nullptr,
+                                            false, ctx));
+  }
+
+  const bool is_output_dead = *ctx->is_output_dead();
+  gtl::InlinedVector<Entry, 4> outputs(item.num_outputs);
+  for (int i = 0; i < item.num_outputs; ++i) {
+    const TensorValue val = ctx->release_output(i);
+    if (is_output_dead || val.tensor == nullptr) {
+      // Unless it's a Recv, the node must produce a tensor value at i-th
+      // output.
+      if (!IsRecv(node)) {
+        s.Update(errors::Internal("Missing ", i, "-th output from ",
+                                  SummarizeNode(*node)));
+      }
+    } else {
+      Entry* out = &outputs[i];
+      out->device_context = params_.op_device_context;
+      out->alloc_attr = ctx->output_alloc_attr(i);
+
+      // Sanity check of output tensor types.
+      DataType dtype;
+      if (val.is_ref()) {
+        mutex_lock ml(*val.mutex_if_ref);
+        dtype = MakeRefType(val->dtype());
+      } else {
+        dtype = val->dtype();
+      }
+      if (dtype == item.output_type(i)) {
+        if (stats && val.tensor->IsInitialized()) {
+          nodestats::SetOutput(stats, i, val.tensor);
+        }
+        out->has_value = true;
+        if (val.is_ref()) {
+          out->ref = val.tensor;
+          out->ref_mu = val.mutex_if_ref;
+          if (log_memory_) {
+            Tensor to_log;
+            {
+              // Dereference the tensor under the lock.
+              mutex_lock l(*out->ref_mu);
+              to_log = *out->ref;
+            }
+            LogMemory::RecordTensorOutput(ctx->op_kernel().name(),
+                                          ctx->step_id(), i, to_log);
+          }
+          if (impl_->params_.node_outputs_cb != nullptr) {
+            s.Update(impl_->params_.node_outputs_cb(item.node->name(), i,
+                                                    out->ref, true, ctx));
+          }
+        } else {
+          out->val = std::move(*val.tensor);
+          if (log_memory_) {
+            LogMemory::RecordTensorOutput(ctx->op_kernel().name(),
+                                          ctx->step_id(), i, out->val);
+          }
+          if (impl_->params_.node_outputs_cb != nullptr) {
+            s.Update(impl_->params_.node_outputs_cb(item.node->name(), i,
+                                                    &out->val, false, ctx));
+          }
+        }
+      } else {
+        s.Update(errors::Internal("Output ", i, " of type ",
+                                  DataTypeString(dtype),
+                                  " does not match declared output type ",
+                                  DataTypeString(item.output_type(i)),
+                                  " for node ", SummarizeNode(*node)));
+      }
+    }
+    if (!val.is_ref()) {
+      // If OpKernelContext returns outputs via pass-by-value, we
+      // don't need this trouble.
+      delete val.tensor;
+    }
+  }
+  if (!s.ok()) return s;
+
+  if (is_output_dead) {
+    PropagateDeadness(index);
+    return s;
+  }
+  for (int i = pn.edges_start; i < pn.edges_limit; ++i) {
+    const LinearExecutorImpl::PlanEdge& e = impl_->edges_[i];
+    if (e.output_slot == Graph::kControlSlot) continue;
+    Entry* src = &outputs[e.output_slot];
+    if (src->has_value && !output_buffers_.empty()) {
+      // The consumer extends the live range of the buffer.
+      const int b = output_buffers_[pn.output_start + e.output_slot];
+      entry_buffers_[e.dst_loc] = b;
+      if (b >= 0) {
+        MemoryPlanBuffer* buffer = &profiled_buffers_[b];
+        buffer->last_use = std::max(buffer->last_use, e.dst_index);
+      }
+    }
+    if (!src->has_value) {
+      is_dead_[e.dst_index] = true;
+    } else if (e.is_last) {
+      entries_[e.dst_loc] = std::move(*src);
+    } else {
+      entries_[e.dst_loc] = *src;
+    }
+  }
+  return s;
+}
+
+void LinearExecutorState::ProfileOutputs(size_t index, OpKernelContext* ctx) {
+  const PlanNode& pn = impl_->plan_[index];
+  const NodeItem& item = *pn.item;
+  for (int i = 0; i < item.num_outputs; ++i) {
+    if (IsRefType(item.output_type(i))) continue;
+    const Tensor* t = ctx->mutable_output(i);
+    if (t == nullptr || !t->IsInitialized()) continue;
+    const int out = pn.output_start + i;
+    const int slot = impl_->profile_slots_[out];
+    const size_t requested_bytes =
+        slot >= 0 ? step_slab_->slab->requested_bytes(slot) : 0;
+    if (requested_bytes > 0) {
+      MemoryPlanBuffer buffer;
+      buffer.size = requested_bytes;
+      buffer.first_use = index;
+      buffer.last_use = index;
+      output_buffers_[out] = profiled_buffers_.size();
+      planned_output_buffers_[out] = profiled_buffers_.size();
+      profiled_buffers_.push_back(buffer);
+      continue;
+    }
+    for (int k = 0; k < item.num_inputs; ++k) {
+      const int b = entry_buffers_[item.input_start + k];
+      const TensorValue& input = inputs_[k];
+      if (b >= 0 && !input.is_ref() && input.tensor != nullptr &&
+          t->SharesBufferWith(*input.tensor)) {
+        output_buffers_[out] = b;
+        break;
+      }
+    }
+  }
+}
+
+void LinearExecutorState::PropagateDeadness(size_t index) {
+  const PlanNode& pn = impl_->plan_[index];
+  for (int i = pn.edges_start; i < pn.edges_limit; ++i) {
+    is_dead_[impl_->edges_[i].dst_index] = true;
+  }
+}
+
+bool LinearExecutorState::NodeDone(const Status& s, const PlanNode& pn,
+                                   NodeExecStatsWrapper* stats) {
+  nodestats::SetAllEnd(stats);
+  if (stats_collector_ != nullptr && !SetTimelineLabel(pn.item->node, stats)) {
+    // Only record non-transfer nodes.
+    // Transfers 'stats' ownership to 'stats_collector_'.
+    stats_collector_->Save(impl_->params_.device->name(), stats);
+  } else if (stats) {
+    delete stats;
+  }
+
+  if (s.ok()) return true;
+  status_ = s;
+  TRACEPRINTF("StartAbort: %s", s.ToString().c_str());
+  if (rendezvous_) {
+    rendezvous_->StartAbort(s);
+  }
+  if (cancellation_manager_) {
+    cancellation_manager_->StartCancel();
+  }
+  return false;
+}
+
+void LinearExecutorState::ClearInputs(const PlanNode& pn) {
+  const NodeItem& item = *pn.item;
+  for (int i = 0; i < item.num_inputs; ++i) {
+    entries_[item.input_start + i].Clear();
+  }
+}
+
+void LinearExecutorState::Finish() {
+  Status status = status_;
+  auto done_cb = std::move(done_cb_);
+  auto runner = std::move(runner_);
+  if (sync_on_finish_ && status.ok()) {
+    // Block until the device has finished all queued operations. For
+    // devices like GPUs that continue to execute Ops after their Compute
+    // methods have completed, this ensures that control is not returned to
+    // the user until the step (and its side-effects) has actually completed.
+    status = impl_->params_.device->Sync();
+  }
+  if (step_slab_ != nullptr && step_slab_->profile && status.ok()) {
+    impl_->SetMemoryPlan(profiled_buffers_, planned_output_buffers_);
+  }
+  delete this;
+  CHECK(done_cb != nullptr);
+  runner([=]() { done_cb(status); });
+}
+
+void LinearExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
+  (new LinearExecutorState(args, this))->RunAsync(std::move(done));
+}
+
 }  // end namespace
 
 Status NewLocalExecutor(const LocalExecutorParams& params, const Graph* graph,
                         Executor** executor) {
+  if (params.use_linear_schedule && LinearExecutorImpl::CanRun(*graph)) {
+    LinearExecutorImpl* impl = new LinearExecutorImpl(params, graph);
+    const Status s = impl->Initialize();
+    if (s.ok()) {
+      *executor = impl;
+    } else {
+      delete impl;
+    }
+    return s;
+  }
   ExecutorImpl* impl = new ExecutorImpl(params, graph);
   const Status s = impl->Initialize();
   if (s.ok()) {
@@ -84,6 +84,11 @@ class Executor {
     int64 step_id = 0;
     Rendezvous* rendezvous = nullptr;
     StepStatsCollector* stats_collector = nullptr;
+    // If positive and 'stats_collector' is null, this fraction of the nodes
+    // of the step record their timings in SampledStepTracer::Global().
+    float sampled_trace_node_fraction = 0.0f;
+    // If true, the sampled nodes also track the memory they allocate.
+    bool sampled_trace_memory = false;
     FunctionCallFrame* call_frame = nullptr;
     CancellationManager* cancellation_manager = nullptr;
     SessionState* session_state = nullptr;
@@ -140,7 +145,45 @@ struct LocalExecutorParams {
   std::function<Status(const NodeDef&, OpKernel**)> create_kernel;
   std::function<void(OpKernel*)> delete_kernel;
 
+  // If set, the executor creates the kernels of stateless nodes concurrently
+  // in closures passed to this runner, so create_kernel must be thread-safe
+  // for them. The kernels of stateful nodes are still created one at a time,
+  // in order, on the thread that creates the executor.
+  std::function<void(std::function<void()>)> kernel_creation_runner;
+
   Executor::Args::NodeOutputsCallback node_outputs_cb;
+
+  // If > 0, ready nodes that are not run inline are kept in this many
+  // per-worker deques instead of being handed to Args::runner one closure
+  // at a time. Each worker runs nodes from its own deque and steals from
+  // the others when it runs dry, so at most this many closures per step
+  // are scheduled on the runner at any time. Typically set to the number
+  // of inter-op threads.
+  int num_work_stealing_workers = 0;
+
+  // If true and the graph has no control flow ops, the executor runs all
+  // nodes of a step one at a time in a topological order computed once at
+  // construction, with every input resolved to a fixed slot. This avoids
+  // most per-node scheduling overhead, at the cost of inter-op
+  // parallelism within the graph. Graphs with control flow ignore this.
+  bool use_linear_schedule = false;
+
+  // If true, use_linear_schedule is in effect and the device is a CPU, the
+  // executor plans the memory of node outputs once for all steps. The first
+  // step records the size and live range of every output allocated with
+  // OpKernelContext::allocate_output(). Later steps allocate those outputs
+  // at fixed offsets of a reused slab, in which outputs that are never live
+  // at the same time share memory. Outputs that grow larger than planned,
+  // or whose memory is still held from an earlier step, fall back to the
+  // device's allocator.
+  bool use_memory_planning = false;
+
+  // If positive and the device is a CPU, each step allocates the scratch
+  // tensors of its kernels, i.e. those from allocate_temp() with
+  // AllocatorAttributes::scratch(), from a StepArena that uses at most
+  // this many bytes of slabs, which are reused by later steps. The rest
+  // come from the device's allocator.
+  int64 step_arena_bytes = 0;
 };
 ::tensorflow::Status NewLocalExecutor(const LocalExecutorParams& params,
                                       const Graph* graph, Executor** executor);
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -29,6 +30,19 @@ GPUBFCAllocator::GPUBFCAllocator(int device_id, size_t total_memory,
           new GPUMemAllocator(
               GPUMachineManager()->ExecutorForDevice(device_id).ValueOrDie()),
           total_memory, gpu_options.allow_growth(),
-          strings::StrCat("GPU_", device_id, "_bfc")) {}
+          strings::StrCat("GPU_", device_id, "_bfc")) {
+  if (gpu_options.allocator_thread_cache_bytes() > 0) {
+    SetThreadCacheBytes(gpu_options.allocator_thread_cache_bytes());
+  }
+  // The number of allocation events to keep for FULL_TRACE run metadata.
+  int64 timeline_events = 0;
+  Status status = ReadInt64FromEnvVar("TF_GPU_ALLOCATOR_TIMELINE_EVENTS", 0,
+                                      &timeline_events);
+  if (!status.ok()) {
+    LOG(ERROR) << "GPUBFCAllocator: " << status.error_message();
+  } else if (timeline_events > 0) {
+    EnableTimeline(timeline_events);
+  }
+}
 
 }  // namespace tensorflow
@@ -30,10 +30,12 @@ limitations under the License.
 #include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/common_runtime/allocation_timeline_recorder.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_stream_util.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_unified_memory_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 #include "tensorflow/core/common_runtime/gpu/process_state.h"
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
@@ -244,6 +246,8 @@ BaseGPUDevice::BaseGPUDevice(const SessionOptions& options, const string& name,
                                                          physical_device_desc)),
       gpu_allocator_(gpu_allocator),
       cpu_allocator_(cpu_allocator),
+      unified_memory_allocator_(
+          dynamic_cast<GPUUnifiedMemoryAllocator*>(gpu_allocator)),
       gpu_id_(gpu_id),
       sync_every_op_(sync_every_op),
       max_streams_(max_streams) {
@@ -351,6 +355,8 @@ Status BaseGPUDevice::FillContextMap(const Graph* graph,
 }
 
 void BaseGPUDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
+  ScopedAllocationAnnotation allocation_annotation(&op_kernel->name(),
+                                                  context->step_id());
   // ScopedActivity is cheap when tracing is not active, but we
   // can avoid computing the Hash64.
   // TODO(pbar) This would no longer be needed if Ops have a unique id.
@@ -389,48 +395,15 @@ void BaseGPUDevice::ComputeHelper(OpKernel* op_kernel,
   gpu::Stream* stream = gpu_device_context->stream();
   const auto stream_id = gpu_device_context->stream_id();
 
-  const bool vlog_1 = VLOG_IS_ON(1);
-  const bool vlog_2 = vlog_1 && VLOG_IS_ON(2);
-
-  if (vlog_1) {
+  if (VLOG_IS_ON(1)) {
     VLOG(1) << "GpuDevice::Compute " << op_kernel->name() << " op "
             << op_kernel->type_string() << " on GPU" << gpu_id_ << " stream["
             << stream_id << "]";
   }
 
-  const auto num_streams = streams_.size();
-  if (num_streams > 1) {
-    // If this op's device context is different from the other contexts,
-    // we must wait on the stream.
-    for (int i = 0; i < context->num_inputs(); ++i) {
-      const GPUDeviceContext* idc =
-          static_cast<GPUDeviceContext*>(context->input_device_context(i));
-      OP_REQUIRES(context, idc != nullptr,
-                  errors::Internal("Input device context ", i,
-                                   " was not set properly."));
-      if (vlog_2) {
-        const void* base;
-        size_t len;
-        if (context->has_input(i)) {
-          if (IsRefType(context->input_dtype(i))) {
-            Tensor tensor = context->mutable_input(i, false);
-            base = DMAHelper::base(&tensor);
-            len = tensor.TotalBytes();
-          } else {
-            const Tensor& tensor = context->input(i);
-            base = DMAHelper::base(&tensor);
-            len = tensor.TotalBytes();
-          }
-          LOG(INFO) << "Input " << i << " " << base << "  " << len;
-          LOG(INFO) << "  stream[" << stream_id << "].ThenWaitFor(stream["
-                    << idc->stream_id() << "])"
-                    << ((idc->stream() == stream) ? " not needed" : "");
-        }
-      }
-      if (idc->stream() != stream) stream->ThenWaitFor(idc->stream());
-    }
-  }
+  OP_REQUIRES_OK(context, WaitForInputStreams(context, stream, stream_id));
   gpu::cuda::ScopedActivateExecutorContext scoped_activation{stream->parent()};
+  MaybePrefetchInputs(context, stream);
   op_kernel->Compute(context);
   if (context->status().ok()) {
     if (sync_every_op_) {
@@ -443,6 +416,52 @@ void BaseGPUDevice::ComputeHelper(OpKernel* op_kernel,
   }
 }
 
+Status BaseGPUDevice::WaitForInputStreams(OpKernelContext* context,
+                                          gpu::Stream* stream, int stream_id) {
+  if (streams_.size() == 1) return Status::OK();
+  const bool vlog_2 = VLOG_IS_ON(2);
+  // If this op's device context is different from the other contexts,
+  // we must wait on the stream.  An op often has several inputs from the
+  // same stream, which then only needs one wait.
+  gtl::InlinedVector<gpu::Stream*, 4> waited_for;
+  for (int i = 0; i < context->num_inputs(); ++i) {
+    const GPUDeviceContext* idc =
+        static_cast<GPUDeviceContext*>(context->input_device_context(i));
+    if (idc == nullptr) {
+      return errors::Internal("Input device context ", i,
+                              " was not set properly.");
+    }
+    if (vlog_2) {
+      const void* base;
+      size_t len;
+      if (context->has_input(i)) {
+        if (IsRefType(context->input_dtype(i))) {
+          Tensor tensor = context->mutable_input(i, false);
+          base = DMAHelper::base(&tensor);
+          len = tensor.TotalBytes();
+        } else {
+          const Tensor& tensor = context->input(i);
+          base = DMAHelper::base(&tensor);
+          len = tensor.TotalBytes();
+        }
+        LOG(INFO) << "Input " << i << " " << base << "  " << len;
+        LOG(INFO) << "  stream[" << stream_id << "].ThenWaitFor(stream["
+                  << idc->stream_id() << "])"
+                  << ((idc->stream() == stream) ? " not needed" : "");
+      }
+    }
+    gpu::Stream* input_stream = idc->stream();
+    if (input_stream == stream ||
+        std::find(waited_for.begin(), waited_for.end(), input_stream) !=
+            waited_for.end()) {
+      continue;
+    }
+    stream->ThenWaitFor(input_stream);
+    waited_for.push_back(input_stream);
+  }
+  return Status::OK();
+}
+
 void BaseGPUDevice::ConsumeListOfAccessedTensors(
     DeviceContext* device_context, const TensorReferenceVector& tensor_refs) {
   GPUDeviceContext* gpu_device_context = device_contexts_[0];
@@ -454,8 +473,13 @@ void BaseGPUDevice::ConsumeListOfAccessedTensors(
 }
 
 // Based on the semantics of Device::Sync this call should wait for
-// all streams not just the current one.
-Status BaseGPUDevice::Sync() { return GPUUtil::SyncAll(this); }
+// all streams not just the current one.  Sync() ends each step, so it is
+// also where the allocator's thread caches are flushed.
+Status BaseGPUDevice::Sync() {
+  Status s = GPUUtil::SyncAll(this);
+  ProcessState::singleton()->FlushGPUAllocatorThreadCaches(gpu_id_);
+  return s;
+}
 
 void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
                                  OpKernelContext* context,
@@ -472,15 +496,38 @@ void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
           << op_kernel->type_string() << " on GPU" << gpu_id_ << " stream["
           << stream_id << "]";
 
+  OP_REQUIRES_OK_ASYNC(context, WaitForInputStreams(context, stream, stream_id),
+                       done);
+
   // When TraceMe profiling is off (which is the default), the
   // following TraceMe constructor is simply a conditional test of
   // false value. Measurements show that its overhead is negligible.
   port::Tracing::TraceMe activity(op_kernel->name(), op_kernel->type_string(),
                                   op_kernel->IsExpensive());
   gpu::cuda::ScopedActivateExecutorContext scoped_activation{stream->parent()};
+  ScopedAllocationAnnotation allocation_annotation(&op_kernel->name(),
+                                                  context->step_id());
+  MaybePrefetchInputs(context, stream);
   op_kernel->ComputeAsync(context, done);
 }
 
+void BaseGPUDevice::MaybePrefetchInputs(OpKernelContext* context,
+                                        gpu::Stream* stream) {
+  if (unified_memory_allocator_ == nullptr) return;
+  for (int i = 0; i < context->num_inputs(); ++i) {
+    if (!context->has_input(i)) continue;
+    if (IsRefType(context->input_dtype(i))) {
+      Tensor tensor = context->mutable_input(i, false);
+      unified_memory_allocator_->Prefetch(DMAHelper::base(&tensor),
+                                          tensor.TotalBytes(), stream);
+    } else {
+      const Tensor& tensor = context->input(i);
+      unified_memory_allocator_->Prefetch(DMAHelper::base(&tensor),
+                                          tensor.TotalBytes(), stream);
+    }
+  }
+}
+
 Status BaseGPUDevice::MaybeCopyTensorToGPU(
     const AllocatorAttributes& alloc_attrs, const Tensor& from, Tensor* to,
     StatusCallback done) {
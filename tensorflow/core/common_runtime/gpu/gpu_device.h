@@ -42,6 +42,8 @@ limitations under the License.
 
 namespace tensorflow {
 
+class GPUUnifiedMemoryAllocator;
+
 class BaseGPUDevice : public LocalDevice {
  public:
   BaseGPUDevice(const SessionOptions& options, const string& name,
@@ -95,6 +97,8 @@ class BaseGPUDevice : public LocalDevice {
  protected:
   Allocator* gpu_allocator_;  // not owned
   Allocator* cpu_allocator_;  // not owned
+  // 'gpu_allocator_', if it allocates large tensors in unified memory.
+  GPUUnifiedMemoryAllocator* unified_memory_allocator_;  // not owned
 
   gpu::StreamExecutor* executor_;  // not owned
 
@@ -122,6 +126,16 @@ class BaseGPUDevice : public LocalDevice {
 
   void ComputeHelper(OpKernel* op_kernel, OpKernelContext* context);
 
+  // Makes 'stream' wait for the work enqueued so far on the compute
+  // streams of the inputs of 'context' that run on other streams, once
+  // per stream.
+  Status WaitForInputStreams(OpKernelContext* context, gpu::Stream* stream,
+                             int stream_id);
+
+  // If the device allocates from unified memory, prefetches the inputs of
+  // 'context' that live in it to the GPU on 'stream'.
+  void MaybePrefetchInputs(OpKernelContext* context, gpu::Stream* stream);
+
   // This method returns an initialization status, in addition to
   // calling the "done" StatusCallback, if there is a failure to
   // allocate memory or if the tensor "from" is not DMA-copyable.
@@ -17,6 +17,8 @@ limitations under the License.
 
 #define EIGEN_USE_GPU
 
+#include <algorithm>
+
 #include "tensorflow/core/common_runtime/gpu/gpu_device.h"
 #include "tensorflow/core/common_runtime/gpu/process_state.h"
 #include "tensorflow/core/common_runtime/threadpool_device.h"
@@ -31,7 +33,8 @@ class GPUDevice : public BaseGPUDevice {
             Allocator* cpu_allocator)
       : BaseGPUDevice(options, name, memory_limit, locality, gpu_id,
                       physical_device_desc, gpu_allocator, cpu_allocator,
-                      false /* sync every op */, 1 /* max_streams */) {
+                      false /* sync every op */, MaxStreams(options)),
+        numa_node_(std::max(locality.bus_id() - 1, 0)) {
     if (options.config.has_gpu_options()) {
       force_gpu_compatible_ =
           options.config.gpu_options().force_gpu_compatible();
@@ -42,7 +45,7 @@ class GPUDevice : public BaseGPUDevice {
     if (attr.on_host()) {
       if (attr.gpu_compatible() || force_gpu_compatible_) {
         ProcessState* ps = ProcessState::singleton();
-        return ps->GetCUDAHostAllocator(0);
+        return ps->GetCUDAHostAllocator(numa_node_);
       } else {
         return cpu_allocator_;
       }
@@ -52,6 +55,13 @@ class GPUDevice : public BaseGPUDevice {
   }
 
  private:
+  static int32 MaxStreams(const SessionOptions& options) {
+    return std::max<int32>(options.config.gpu_options().num_compute_streams(),
+                           1);
+  }
+
+  // The NUMA node local to the GPU, whose pinned host memory it uses.
+  const int numa_node_;
   bool force_gpu_compatible_ = false;
 };
 
@@ -34,17 +34,23 @@ EventMgr::EventMgr(gpu::StreamExecutor* se, const GPUOptions& gpu_options)
           gpu_options.polling_inactive_delay_msecs()
               ? gpu_options.polling_inactive_delay_msecs()
               : 1),
+      use_stream_callbacks_(gpu_options.use_stream_callbacks()),
       accumulated_stream_(nullptr),
       accumulated_tensors_(new TensorReferenceVector),
       accumulated_tensor_bytes_(0),
+      pending_callbacks_(0),
       // threadpool_ has 1 thread for the polling loop, and one to execute
       // event callback functions. Maybe we should have more?
       threadpool_(Env::Default(), "GPU_Event_Manager", 2) {
-  StartPollingLoop();
+  if (!use_stream_callbacks_) StartPollingLoop();
 }
 
 EventMgr::~EventMgr() {
   StopPollingLoop();
+  {
+    mutex_lock l(mu_);
+    while (pending_callbacks_ > 0) callbacks_done_.wait(l);
+  }
 
   // Events are owned by this object.
   for (auto& e : free_events_) {
@@ -149,7 +155,25 @@ void EventMgr::PollLoop() {
 
 void EventMgr::QueueInUse(gpu::Stream* stream, InUse iu) {
   VLOG(2) << "QueueInUse  free_events_ " << free_events_.size()
-          << " used_events_ " << used_events_.size();
+          << " used_events_ " << used_events_.size()
+          << " pending_callbacks_ " << pending_callbacks_;
+  if (use_stream_callbacks_ && stream->ok()) {
+    ++pending_callbacks_;
+    // The callback runs on a thread of the driver, which must not call
+    // back into it, while deallocating a buffer or the last reference to a
+    // tensor may, so the memory is freed on threadpool_.
+    stream->ThenDoHostCallback([this, iu]() {
+      threadpool_.Schedule([this, iu]() {
+        FreeMemory({iu});
+        mutex_lock l(mu_);
+        if (--pending_callbacks_ == 0) callbacks_done_.notify_all();
+      });
+    });
+    if (stream->ok()) return;
+    // The callback could not be enqueued, so falls back to an event like
+    // the polling mode does.
+    --pending_callbacks_;
+  }
   // Events are created on demand, and repeatedly reused.  There is no
   // limit placed here on the number of allocated Events.
   if (free_events_.empty()) {
@@ -95,6 +95,9 @@ class EventMgr {
   const int64 deferred_bytes_threshold_;
   const int32 polling_active_delay_usecs_;
   const int32 polling_inactive_delay_msecs_;
+  // If true, completions are delivered by stream host callbacks instead of
+  // the polling loop.
+  const bool use_stream_callbacks_;
   mutex mu_;
   condition_variable events_pending_ GUARDED_BY(mu_);
 
@@ -132,7 +135,8 @@ class EventMgr {
 
   // Stream-enqueue an unused Event and save with it a collection of
   // Tensors and/or a BufRec to be deleted only after the Event
-  // records.
+  // records.  If use_stream_callbacks_, stream-enqueues a host callback
+  // that frees them instead.
   void QueueInUse(perftools::gputools::Stream* stream, InUse in_use)
       EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
@@ -180,6 +184,12 @@ class EventMgr {
   // A FIFO queue of InUse events and associated tensors.
   std::deque<InUse> used_events_ GUARDED_BY(mu_);
 
+  // The number of host callbacks that have been enqueued on a stream and
+  // have not yet freed their InUse records.  The destructor waits for it
+  // to drop to 0, since the callbacks refer to this object.
+  int64 pending_callbacks_ GUARDED_BY(mu_);
+  condition_variable callbacks_done_;
+
   std::unique_ptr<Notification> stop_polling_;
   std::unique_ptr<Notification> polling_stopped_;
 
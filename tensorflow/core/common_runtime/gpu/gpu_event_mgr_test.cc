@@ -246,6 +246,34 @@ TEST(EventMgr, NonEmptyShutdown) {
   }
 }
 
+// With stream callbacks, the tensors are freed and the functions run without
+// any event being queued or polled.
+TEST(EventMgr, StreamCallbacksFreeWithoutPolling) {
+  auto stream_exec = GPUMachineManager()->ExecutorForDevice(0).ValueOrDie();
+  GPUOptions gpu_options;
+  gpu_options.set_use_stream_callbacks(true);
+  EXPECT_EQ(0, live_tensor_bytes);
+  std::unique_ptr<gpu::Stream> stream(new gpu::Stream(stream_exec));
+  CHECK(stream.get());
+  stream->Init();
+  {
+    EventMgr em(stream_exec, gpu_options);
+    TEST_EventMgrHelper th(&em);
+    for (int i = 0; i < 5; ++i) {
+      TensorReferenceVector v;
+      AddTensorReference(&v, 100 * 1048576);
+      em.ThenDeleteTensors(stream.get(), v);
+    }
+    Notification done;
+    em.ThenExecute(stream.get(), [&done]() { done.Notify(); });
+    done.WaitForNotification();
+    EXPECT_EQ(0, th.queue_size());
+    EXPECT_EQ(0, th.free_size());
+  }
+  // Deleting the EventMgr waits for the callbacks that free the tensors.
+  EXPECT_EQ(0, live_tensor_bytes);
+}
+
 }  // namespace
 }  // namespace tensorflow
 
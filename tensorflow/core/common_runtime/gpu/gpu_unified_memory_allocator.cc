@@ -0,0 +1,166 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifdef GOOGLE_CUDA
+#include "cuda/include/cuda.h"
+#include "tensorflow/stream_executor/cuda/cuda_activation.h"
+#endif  // GOOGLE_CUDA
+
+#include "tensorflow/core/common_runtime/gpu/gpu_unified_memory_allocator.h"
+
+#include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace gpu = ::perftools::gputools;
+
+namespace tensorflow {
+
+GPUUnifiedMemoryAllocator::GPUUnifiedMemoryAllocator(
+    VisitableAllocator* allocator, int device_id, size_t threshold_bytes)
+    : base_allocator_(allocator), threshold_bytes_(threshold_bytes) {
+  stream_exec_ = GPUMachineManager()->ExecutorForDevice(device_id).ValueOrDie();
+}
+
+GPUUnifiedMemoryAllocator::~GPUUnifiedMemoryAllocator() {
+  delete base_allocator_;
+}
+
+void* GPUUnifiedMemoryAllocator::AllocateRaw(size_t alignment,
+                                             size_t num_bytes) {
+#if defined(GOOGLE_CUDA) && CUDA_VERSION >= 8000
+  if (num_bytes >= threshold_bytes_) {
+    gpu::cuda::ScopedActivateExecutorContext scoped_activation{stream_exec_};
+    CUdeviceptr rv = 0;
+    CUdevice device;
+    if (cuMemAllocManaged(&rv, num_bytes, CU_MEM_ATTACH_GLOBAL) ==
+            CUDA_SUCCESS &&
+        cuDeviceGet(&device, stream_exec_->device_ordinal()) == CUDA_SUCCESS) {
+      // Managed memory is aligned to at least 256 bytes.
+      CHECK(!(rv & (alignment - 1)));
+      // Failed advice only costs performance.
+      cuMemAdvise(rv, num_bytes, CU_MEM_ADVISE_SET_PREFERRED_LOCATION, device);
+      cuMemAdvise(rv, num_bytes, CU_MEM_ADVISE_SET_ACCESSED_BY, device);
+      char* ptr = reinterpret_cast<char*>(rv);
+      mutex_lock l(mu_);
+      unified_[ptr] = num_bytes;
+      unified_bytes_in_use_ += num_bytes;
+      return ptr;
+    }
+    if (rv != 0) cuMemFree(rv);
+    LOG(WARNING) << "cuMemAllocManaged failed to allocate " << num_bytes
+                 << " bytes, allocating them on the device instead";
+  }
+#endif  // GOOGLE_CUDA && CUDA_VERSION >= 8000
+  return base_allocator_->AllocateRaw(alignment, num_bytes);
+}
+
+void GPUUnifiedMemoryAllocator::DeallocateRaw(void* ptr) {
+  {
+    mutex_lock l(mu_);
+    auto it = unified_.find(static_cast<const char*>(ptr));
+    if (it != unified_.end()) {
+      unified_bytes_in_use_ -= it->second;
+      unified_.erase(it);
+#ifdef GOOGLE_CUDA
+      CUresult res = cuMemFree(reinterpret_cast<CUdeviceptr>(ptr));
+      if (res != CUDA_SUCCESS) {
+        LOG(ERROR) << "cuMemFree failed to free " << ptr;
+      }
+#endif  // GOOGLE_CUDA
+      return;
+    }
+  }
+  base_allocator_->DeallocateRaw(ptr);
+}
+
+void GPUUnifiedMemoryAllocator::AddAllocVisitor(Visitor visitor) {
+  return base_allocator_->AddAllocVisitor(visitor);
+}
+
+void GPUUnifiedMemoryAllocator::AddFreeVisitor(Visitor visitor) {
+  return base_allocator_->AddFreeVisitor(visitor);
+}
+
+bool GPUUnifiedMemoryAllocator::TracksAllocationSizes() {
+  return base_allocator_->TracksAllocationSizes();
+}
+
+size_t GPUUnifiedMemoryAllocator::RequestedSize(void* ptr) {
+  {
+    mutex_lock l(mu_);
+    auto it = unified_.find(static_cast<const char*>(ptr));
+    if (it != unified_.end()) return it->second;
+  }
+  return base_allocator_->RequestedSize(ptr);
+}
+
+size_t GPUUnifiedMemoryAllocator::AllocatedSize(void* ptr) {
+  {
+    mutex_lock l(mu_);
+    auto it = unified_.find(static_cast<const char*>(ptr));
+    if (it != unified_.end()) return it->second;
+  }
+  return base_allocator_->AllocatedSize(ptr);
+}
+
+int64 GPUUnifiedMemoryAllocator::AllocationId(void* ptr) {
+  {
+    mutex_lock l(mu_);
+    if (unified_.count(static_cast<const char*>(ptr)) > 0) return 0;
+  }
+  return base_allocator_->AllocationId(ptr);
+}
+
+void GPUUnifiedMemoryAllocator::GetStats(AllocatorStats* stats) {
+  base_allocator_->GetStats(stats);
+  mutex_lock l(mu_);
+  stats->bytes_in_use += unified_bytes_in_use_;
+}
+
+std::map<const char*, size_t>::iterator GPUUnifiedMemoryAllocator::FindUnified(
+    const void* ptr) {
+  const char* p = static_cast<const char*>(ptr);
+  auto it = unified_.upper_bound(p);
+  if (it == unified_.begin()) return unified_.end();
+  --it;
+  return p < it->first + it->second ? it : unified_.end();
+}
+
+bool GPUUnifiedMemoryAllocator::IsUnifiedMemory(const void* ptr) {
+  mutex_lock l(mu_);
+  return FindUnified(ptr) != unified_.end();
+}
+
+void GPUUnifiedMemoryAllocator::Prefetch(const void* ptr, size_t num_bytes,
+                                         gpu::Stream* stream) {
+  if (num_bytes == 0) return;
+  {
+    mutex_lock l(mu_);
+    if (FindUnified(ptr) == unified_.end()) return;
+  }
+#if defined(GOOGLE_CUDA) && CUDA_VERSION >= 8000
+  CUdevice device;
+  if (cuDeviceGet(&device, stream_exec_->device_ordinal()) != CUDA_SUCCESS) {
+    return;
+  }
+  CUstream cu_stream = *reinterpret_cast<const CUstream*>(
+      stream->implementation()->CudaStreamMemberHack());
+  // A failed prefetch leaves the pages to migrate on fault.
+  cuMemPrefetchAsync(reinterpret_cast<CUdeviceptr>(ptr), num_bytes, device,
+                     cu_stream);
+#endif  // GOOGLE_CUDA && CUDA_VERSION >= 8000
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,87 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_GPU_GPU_UNIFIED_MEMORY_ALLOCATOR_H_
+#define TENSORFLOW_COMMON_RUNTIME_GPU_GPU_UNIFIED_MEMORY_ALLOCATOR_H_
+
+#include <map>
+
+#include "tensorflow/core/common_runtime/visitable_allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An allocator that wraps a GPU allocator, and allocates requests of at
+// least 'threshold_bytes' in CUDA unified memory instead. Together they can
+// hold more than the memory of the GPU: the driver evicts pages of unified
+// memory to the host when the GPU runs out, and migrates them back when
+// they are used.
+//
+// Unified memory is advised to live on the GPU and to stay mapped there
+// while evicted, so that kernels read evicted pages over the bus instead of
+// faulting. Prefetch() lets the GPU device migrate the inputs of an op
+// ahead of its kernels.
+class GPUUnifiedMemoryAllocator : public VisitableAllocator {
+ public:
+  // Takes ownership of 'allocator'.
+  GPUUnifiedMemoryAllocator(VisitableAllocator* allocator, int device_id,
+                            size_t threshold_bytes);
+  ~GPUUnifiedMemoryAllocator() override;
+
+  string Name() override { return base_allocator_->Name(); }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+  void AddAllocVisitor(Visitor visitor) override;
+  void AddFreeVisitor(Visitor visitor) override;
+  bool TracksAllocationSizes() override;
+  size_t RequestedSize(void* ptr) override;
+  size_t AllocatedSize(void* ptr) override;
+  int64 AllocationId(void* ptr) override;
+  void GetStats(AllocatorStats* stats) override;
+
+  // Enqueues on 'stream' the migration to the GPU of the pages of
+  // [ptr, ptr + num_bytes) that are in unified memory. Does nothing for
+  // other memory.
+  void Prefetch(const void* ptr, size_t num_bytes,
+                perftools::gputools::Stream* stream);
+
+  // Returns true if 'ptr' points into unified memory of this allocator.
+  bool IsUnifiedMemory(const void* ptr);
+
+ private:
+  // Returns the unified allocation that contains 'ptr', or
+  // unified_.end().
+  std::map<const char*, size_t>::iterator FindUnified(const void* ptr)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  VisitableAllocator* base_allocator_;                // owned
+  perftools::gputools::StreamExecutor* stream_exec_;  // not owned
+  const size_t threshold_bytes_;
+
+  mutex mu_;
+  // The size of each unified allocation, by address.
+  std::map<const char*, size_t> unified_ GUARDED_BY(mu_);
+  int64 unified_bytes_in_use_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GPUUnifiedMemoryAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_GPU_GPU_UNIFIED_MEMORY_ALLOCATOR_H_
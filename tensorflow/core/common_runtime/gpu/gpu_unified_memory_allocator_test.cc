@@ -0,0 +1,67 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA
+
+#include "tensorflow/core/common_runtime/gpu/gpu_unified_memory_allocator.h"
+
+#include "tensorflow/core/common_runtime/gpu/gpu_bfc_allocator.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace gpu = ::perftools::gputools;
+
+namespace tensorflow {
+namespace {
+
+TEST(GPUUnifiedMemoryAllocatorTest, LargeAllocationsAreUnified) {
+  GPUUnifiedMemoryAllocator a(new GPUBFCAllocator(0, 1 << 24), 0, 1 << 20);
+  EXPECT_EQ("GPU_0_bfc", a.Name());
+
+  void* small = a.AllocateRaw(Allocator::kAllocatorAlignment, 1024);
+  void* large = a.AllocateRaw(Allocator::kAllocatorAlignment, 1 << 20);
+  ASSERT_NE(nullptr, small);
+  ASSERT_NE(nullptr, large);
+  EXPECT_FALSE(a.IsUnifiedMemory(small));
+  EXPECT_TRUE(a.IsUnifiedMemory(large));
+  EXPECT_TRUE(a.IsUnifiedMemory(static_cast<char*>(large) + 1000));
+  EXPECT_FALSE(a.IsUnifiedMemory(static_cast<char*>(large) + (1 << 20)));
+  EXPECT_EQ(1 << 20, a.RequestedSize(large));
+  EXPECT_EQ(1024, a.RequestedSize(small));
+
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(1024 + (1 << 20), stats.bytes_in_use);
+
+  // Prefetching ignores memory that is not unified.
+  gpu::StreamExecutor* se =
+      GPUMachineManager()->ExecutorForDevice(0).ValueOrDie();
+  gpu::Stream stream(se);
+  stream.Init();
+  a.Prefetch(small, 1024, &stream);
+  a.Prefetch(large, 1 << 20, &stream);
+  EXPECT_TRUE(stream.BlockHostUntilDone());
+
+  a.DeallocateRaw(large);
+  a.DeallocateRaw(small);
+  a.GetStats(&stats);
+  EXPECT_EQ(0, stats.bytes_in_use);
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
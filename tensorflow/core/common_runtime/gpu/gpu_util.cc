@@ -21,12 +21,14 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 #include "tensorflow/core/common_runtime/gpu/process_state.h"
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_reference.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/hash/hash.h"
@@ -113,6 +115,52 @@ void* GetBase(const Tensor* src) {
 
 void* GetBase(Tensor* dst) { return DMAHelper::base(dst); }
 
+// Returns the allocator of pinned memory through which a copy of
+// "cpu_tensor" to "gpu_device" should be staged, or nullptr if the
+// tensor is already in pinned memory or copies are not staged.
+Allocator* GetStagingAllocator(const Tensor& cpu_tensor, Device* gpu_device) {
+  Allocator* alloc = ProcessState::singleton()->GetCUDAHostStagingAllocator(
+      gpu_device->attributes().locality().bus_id() - 1);
+  if (alloc == nullptr) return nullptr;
+  AllocationDescription desc;
+  DMAHelper::buffer(&cpu_tensor)->FillAllocationDescription(&desc);
+  if (StringPiece(desc.allocator_name()).starts_with("cuda_host")) {
+    return nullptr;
+  }
+  return alloc;
+}
+
+// Returns the offsets at which "tensors" are packed into one buffer, each
+// aligned for the kernels that use it, and sets "*total_bytes" to the size
+// of the buffer.
+std::vector<int64> PackedOffsets(const std::vector<Tensor>& tensors,
+                                 int64* total_bytes) {
+  std::vector<int64> offsets(tensors.size());
+  int64 offset = 0;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    offsets[i] = offset;
+    offset += tensors[i].TotalBytes();
+    offset = (offset + Allocator::kAllocatorAlignment - 1) /
+             Allocator::kAllocatorAlignment * Allocator::kAllocatorAlignment;
+  }
+  *total_bytes = offset;
+  return offsets;
+}
+
+// Sets "*views" to tensors shaped like "tensors" that alias "packed" at
+// "offsets".
+void PackedViews(const Tensor& packed, const std::vector<Tensor>& tensors,
+                 const std::vector<int64>& offsets,
+                 std::vector<Tensor>* views) {
+  views->resize(tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    const Tensor slice =
+        packed.Slice(offsets[i], offsets[i] + tensors[i].TotalBytes());
+    (*views)[i].UnsafeCopyFromInternal(slice, tensors[i].dtype(),
+                                       tensors[i].shape());
+  }
+}
+
 /*static*/
 void GPUUtil::SetProtoFromGPU(const Tensor& tensor, Device* dev,
                               const DeviceContext* device_context,
@@ -326,9 +374,21 @@ void GPUUtil::CopyCPUTensorToGPU(const Tensor* cpu_tensor,
   recv_host_to_device_stream->ThenWaitFor(recv_stream);
 
   const int64 total_bytes = cpu_tensor->TotalBytes();
+  Allocator* staging_alloc = nullptr;
+  char* staging_buf = nullptr;
   // Note that 0-size tensors have no backing buffer.
   if (total_bytes > 0) {
     void* src_ptr = GetBase(cpu_tensor);
+    // Pageable memory is first copied to pinned memory on the GPU's NUMA
+    // node, so that the DMA is asynchronous and does not cross sockets.
+    staging_alloc = GetStagingAllocator(*cpu_tensor, gpu_device);
+    if (staging_alloc != nullptr) {
+      staging_buf = staging_alloc->Allocate<char>(total_bytes);
+      if (staging_buf != nullptr) {
+        memcpy(staging_buf, src_ptr, total_bytes);
+        src_ptr = staging_buf;
+      }
+    }
     void* dst_ptr = GetBase(gpu_tensor);
     DeviceMemoryBase gpu_dst_ptr(dst_ptr, total_bytes);
     recv_host_to_device_stream->ThenMemcpy(&gpu_dst_ptr, src_ptr, total_bytes);
@@ -337,8 +397,12 @@ void GPUUtil::CopyCPUTensorToGPU(const Tensor* cpu_tensor,
   TensorReference input_ref(*cpu_tensor);
   dev_info->event_mgr->ThenExecute(
       recv_host_to_device_stream,
-      [recv_host_to_device_stream, done, input_ref]() {
+      [recv_host_to_device_stream, done, input_ref, staging_alloc,
+       staging_buf, total_bytes]() {
         input_ref.Unref();
+        if (staging_buf != nullptr) {
+          staging_alloc->Deallocate<char>(staging_buf, total_bytes);
+        }
         if (!recv_host_to_device_stream->ok()) {
           LOG(FATAL) << "CPU->GPU Memcpy failed";
         }
@@ -346,6 +410,155 @@ void GPUUtil::CopyCPUTensorToGPU(const Tensor* cpu_tensor,
       });
 }
 
+void GPUUtil::CopyCPUTensorsToGPU(const std::vector<Tensor>& cpu_tensors,
+                                  const DeviceContext* device_context,
+                                  Device* gpu_device,
+                                  std::vector<Tensor>* gpu_tensors,
+                                  StatusCallback done) {
+  VLOG(1) << "CopyCPUTensorsToGPU " << cpu_tensors.size();
+  const DeviceBase::GpuDeviceInfo* dev_info = nullptr;
+  gpu::Stream* recv_stream = nullptr;
+  for (const Tensor& cpu_tensor : cpu_tensors) {
+    Status s = PrepareCopy(gpu_device, device_context, cpu_tensor, nullptr,
+                           &dev_info, &recv_stream);
+    if (!s.ok()) {
+      done(s);
+      return;
+    }
+  }
+  if (cpu_tensors.empty()) {
+    gpu_tensors->clear();
+    done(Status::OK());
+    return;
+  }
+
+  auto recv_host_to_device_stream =
+      static_cast<const GPUDeviceContext*>(device_context)
+          ->host_to_device_stream();
+  if (recv_host_to_device_stream == nullptr) {
+    done(errors::Internal("No send gpu copy-out-stream is available."));
+    return;
+  }
+
+  int64 total_bytes;
+  const std::vector<int64> offsets = PackedOffsets(cpu_tensors, &total_bytes);
+  Tensor packed(gpu_device->GetAllocator(AllocatorAttributes()), DT_UINT8,
+                TensorShape({total_bytes}));
+  if (total_bytes > 0 && !packed.IsInitialized()) {
+    done(errors::ResourceExhausted("Failed to allocate ", total_bytes,
+                                   " bytes on the GPU for ",
+                                   cpu_tensors.size(), " tensors"));
+    return;
+  }
+  Allocator* staging_alloc = ProcessState::singleton()->GetCUDAHostAllocator(
+      gpu_device->attributes().locality().bus_id() - 1);
+  char* staging_buf = nullptr;
+  if (total_bytes > 0) {
+    staging_buf = staging_alloc->Allocate<char>(total_bytes);
+    if (staging_buf == nullptr) {
+      done(errors::ResourceExhausted("Failed to allocate ", total_bytes,
+                                     " bytes of pinned memory for ",
+                                     cpu_tensors.size(), " tensors"));
+      return;
+    }
+    // The inputs are copied here, so they need not outlive this call.
+    for (size_t i = 0; i < cpu_tensors.size(); ++i) {
+      memcpy(staging_buf + offsets[i], GetBase(&cpu_tensors[i]),
+             cpu_tensors[i].TotalBytes());
+    }
+  }
+  PackedViews(packed, cpu_tensors, offsets, gpu_tensors);
+
+  // Wait for the recv-stream to make sure the buffer is truly available.
+  recv_host_to_device_stream->ThenWaitFor(recv_stream);
+  if (total_bytes > 0) {
+    DeviceMemoryBase gpu_dst_ptr(GetBase(&packed), total_bytes);
+    recv_host_to_device_stream->ThenMemcpy(&gpu_dst_ptr, staging_buf,
+                                           total_bytes);
+  }
+  dev_info->event_mgr->ThenExecute(
+      recv_host_to_device_stream,
+      [recv_host_to_device_stream, done, staging_alloc, staging_buf,
+       total_bytes]() {
+        if (staging_buf != nullptr) {
+          staging_alloc->Deallocate<char>(staging_buf, total_bytes);
+        }
+        if (!recv_host_to_device_stream->ok()) {
+          LOG(FATAL) << "CPU->GPU Memcpy failed";
+        }
+        done(Status::OK());
+      });
+}
+
+void GPUUtil::CopyGPUTensorsToCPU(Device* gpu_device,
+                                  const DeviceContext* device_context,
+                                  const std::vector<Tensor>& gpu_tensors,
+                                  std::vector<Tensor>* cpu_tensors,
+                                  StatusCallback done) {
+  VLOG(1) << "CopyGPUTensorsToCPU " << gpu_tensors.size();
+  const DeviceBase::GpuDeviceInfo* dev_info = nullptr;
+  gpu::Stream* send_stream = nullptr;
+  for (const Tensor& gpu_tensor : gpu_tensors) {
+    Status s = PrepareCopy(gpu_device, device_context, gpu_tensor, nullptr,
+                           &dev_info, &send_stream);
+    if (!s.ok()) {
+      done(s);
+      return;
+    }
+  }
+  if (gpu_tensors.empty()) {
+    cpu_tensors->clear();
+    done(Status::OK());
+    return;
+  }
+
+  auto send_device_to_host_stream =
+      static_cast<const GPUDeviceContext*>(device_context)
+          ->device_to_host_stream();
+  if (send_device_to_host_stream == nullptr) {
+    done(errors::Internal("No send gpu copy-out-stream is available."));
+    return;
+  }
+
+  int64 total_bytes;
+  const std::vector<int64> offsets = PackedOffsets(gpu_tensors, &total_bytes);
+  Tensor packed(ProcessState::singleton()->GetCUDAHostAllocator(
+                    gpu_device->attributes().locality().bus_id() - 1),
+                DT_UINT8, TensorShape({total_bytes}));
+  if (total_bytes > 0 && !packed.IsInitialized()) {
+    done(errors::ResourceExhausted("Failed to allocate ", total_bytes,
+                                   " bytes of pinned memory for ",
+                                   gpu_tensors.size(), " tensors"));
+    return;
+  }
+  PackedViews(packed, gpu_tensors, offsets, cpu_tensors);
+
+  // Wait for the sender's main stream to make sure the data are available.
+  send_device_to_host_stream->ThenWaitFor(send_stream);
+  char* dst_base = static_cast<char*>(GetBase(&packed));
+  for (size_t i = 0; i < gpu_tensors.size(); ++i) {
+    const int64 bytes = gpu_tensors[i].TotalBytes();
+    if (bytes == 0) continue;
+    DeviceMemoryBase gpu_src_ptr(GetBase(&gpu_tensors[i]), bytes);
+    send_device_to_host_stream->ThenMemcpy(dst_base + offsets[i], gpu_src_ptr,
+                                           bytes);
+  }
+  // Use of the inputs may outlive stack scope, so keep refs.
+  TensorReferenceVector input_refs;
+  for (const Tensor& gpu_tensor : gpu_tensors) {
+    input_refs.emplace_back(gpu_tensor);
+  }
+  dev_info->event_mgr->ThenExecute(
+      send_device_to_host_stream,
+      [send_device_to_host_stream, done, input_refs]() {
+        if (!send_device_to_host_stream->ok()) {
+          LOG(FATAL) << "GPU->CPU Memcpy failed";
+        }
+        for (const TensorReference& ref : input_refs) ref.Unref();
+        done(Status::OK());
+      });
+}
+
 Status GPUUtil::Sync(Device* gpu_device) {
   VLOG(1) << "GPUUtil::Sync";
   auto* dev_info = gpu_device->tensorflow_gpu_device_info();
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_COMMON_RUNTIME_GPU_GPU_UTIL_H_
 #define TENSORFLOW_COMMON_RUNTIME_GPU_GPU_UTIL_H_
 
+#include <vector>
+
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -93,6 +95,26 @@ class GPUUtil {
                                  Device* gpu_device, Tensor* gpu_tensor,
                                  StatusCallback done);
 
+  // Copies the tensors in 'cpu_tensors' to 'gpu_device' with a single
+  // transfer: they are packed into one buffer of pinned memory, which is
+  // copied into one allocation on the GPU.  Sets 'gpu_tensors' to views of
+  // that allocation, which hold the copies once 'done' is called.  This
+  // is cheaper than copying many small tensors one at a time.
+  static void CopyCPUTensorsToGPU(const std::vector<Tensor>& cpu_tensors,
+                                  const DeviceContext* device_context,
+                                  Device* gpu_device,
+                                  std::vector<Tensor>* gpu_tensors,
+                                  StatusCallback done);
+
+  // Copies the tensors in 'gpu_tensors', whose backing memory must be on
+  // 'gpu_device', into views of a single buffer of pinned memory, to which
+  // it sets 'cpu_tensors', and calls 'done' once all the copies are done.
+  static void CopyGPUTensorsToCPU(Device* gpu_device,
+                                  const DeviceContext* device_context,
+                                  const std::vector<Tensor>& gpu_tensors,
+                                  std::vector<Tensor>* cpu_tensors,
+                                  StatusCallback done);
+
   static void DeviceToDeviceCopy(DeviceContext* send_dev_context,
                                  DeviceContext* recv_dev_context, Device* src,
                                  Device* dst,
@@ -21,9 +21,12 @@ limitations under the License.
 #include <sys/mman.h>  // for munmap
 #endif
 
+#include <algorithm>
 #include <map>
 #include <utility>
 
+#include "tensorflow/core/framework/memory_pressure.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -284,4 +287,208 @@ void PoolAllocator::AddFreeVisitor(Visitor visitor) {
   free_visitors_.push_back(visitor);
 }
 
+constexpr size_t SizeClassPoolAllocator::kMinClassBytes;
+constexpr int SizeClassPoolAllocator::kNumClasses;
+constexpr size_t NUMACUDAHostAllocator::kPageBytes;
+
+SizeClassPoolAllocator::SizeClassPoolAllocator(SubAllocator* allocator,
+                                               size_t bytes_limit,
+                                               int64 trim_interval,
+                                               string name)
+    : name_(std::move(name)),
+      bytes_limit_(bytes_limit),
+      trim_interval_(trim_interval),
+      allocator_(allocator),
+      allocation_begun_(false) {
+  stats_.bytes_limit = bytes_limit;
+  // The cached buffers are host memory, which does not help GPU allocators.
+  pressure_handle_ = MemoryPressureRegistry::Global()->Register(
+      MemoryPressureRegistry::kIdleMemoryPriority,
+      [this](const string& allocator_name, size_t num_bytes) -> int64 {
+        if (StringPiece(allocator_name).starts_with("GPU_")) return 0;
+        return ReleaseCached(num_bytes);
+      });
+}
+
+SizeClassPoolAllocator::~SizeClassPoolAllocator() {
+  MemoryPressureRegistry::Global()->Unregister(pressure_handle_);
+  Clear();
+}
+
+void* SizeClassPoolAllocator::AllocateRaw(size_t alignment,
+                                          size_t num_bytes) {
+  if (!allocation_begun_) allocation_begun_ = true;
+  if (num_bytes == 0) return nullptr;
+
+  // As in PoolAllocator, leave room for the ChunkPrefix and for
+  // advancing the user pointer to a larger alignment.
+  size_t chunk_bytes = num_bytes + sizeof(ChunkPrefix);
+  if (alignment > kPoolAlignment) {
+    chunk_bytes += alignment;
+  }
+  const int size_class = Log2Ceiling64(std::max(chunk_bytes, kMinClassBytes));
+  chunk_bytes = size_t{1} << size_class;
+
+  void* chunk = nullptr;
+  BufferList release;
+  {
+    mutex_lock lock(mutex_);
+    std::vector<void*>& free_list = free_lists_[size_class];
+    if (!free_list.empty()) {
+      chunk = free_list.back();
+      free_list.pop_back();
+      cached_bytes_ -= chunk_bytes;
+      ++get_from_pool_count_;
+    } else {
+      if (bytes_limit_ > 0) {
+        const size_t in_use = stats_.bytes_in_use;
+        if (in_use + chunk_bytes > bytes_limit_) {
+          LOG(WARNING) << name_ << " cannot allocate " << chunk_bytes
+                       << " bytes with " << in_use << " of " << bytes_limit_
+                       << " in use";
+          return nullptr;
+        }
+        TrimTo(bytes_limit_ - chunk_bytes, &release);
+      }
+      ++allocated_count_;
+    }
+    ++stats_.num_allocs;
+    stats_.bytes_in_use += chunk_bytes;
+    stats_.max_bytes_in_use =
+        std::max(stats_.max_bytes_in_use, stats_.bytes_in_use);
+    stats_.max_alloc_size =
+        std::max<int64>(stats_.max_alloc_size, chunk_bytes);
+    peak_since_trim_ = std::max<size_t>(peak_since_trim_, stats_.bytes_in_use);
+  }
+  // Deliberately free and allocate without the lock held.
+  Release(release);
+  if (chunk == nullptr) {
+    chunk = allocator_->Alloc(kPoolAlignment, chunk_bytes);
+    if (chunk == nullptr) {
+      mutex_lock lock(mutex_);
+      stats_.bytes_in_use -= chunk_bytes;
+      return nullptr;
+    }
+    for (const auto& v : alloc_visitors_) {
+      v(chunk, chunk_bytes);
+    }
+  }
+  return PrepareChunk(chunk, alignment, chunk_bytes);
+}
+
+void SizeClassPoolAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) return;
+  ChunkPrefix* cp = FindPrefix(ptr);
+  CHECK_LE((void*)cp, (void*)ptr);
+  const size_t chunk_bytes = cp->num_bytes;
+  BufferList release;
+  {
+    mutex_lock lock(mutex_);
+    free_lists_[Log2Ceiling64(chunk_bytes)].push_back(cp);
+    cached_bytes_ += chunk_bytes;
+    stats_.bytes_in_use -= chunk_bytes;
+    if (trim_interval_ > 0 && ++deallocs_since_trim_ >= trim_interval_) {
+      TrimTo(peak_since_trim_, &release);
+      peak_since_trim_ = stats_.bytes_in_use;
+      deallocs_since_trim_ = 0;
+    }
+  }
+  Release(release);
+}
+
+void SizeClassPoolAllocator::TrimTo(size_t target_bytes,
+                                    BufferList* release) {
+  const size_t in_use = stats_.bytes_in_use;
+  for (int c = kNumClasses - 1; c >= 0 && in_use + cached_bytes_ > target_bytes;
+       --c) {
+    std::vector<void*>& free_list = free_lists_[c];
+    const size_t chunk_bytes = size_t{1} << c;
+    while (!free_list.empty() && in_use + cached_bytes_ > target_bytes) {
+      release->emplace_back(free_list.back(), chunk_bytes);
+      free_list.pop_back();
+      cached_bytes_ -= chunk_bytes;
+      ++trimmed_count_;
+    }
+  }
+}
+
+size_t SizeClassPoolAllocator::ReleaseCached(size_t num_bytes) {
+  BufferList release;
+  {
+    mutex_lock lock(mutex_);
+    const size_t target = stats_.bytes_in_use + cached_bytes_ -
+                          std::min(cached_bytes_, num_bytes);
+    TrimTo(target, &release);
+  }
+  Release(release);
+  size_t released = 0;
+  for (const auto& buffer : release) released += buffer.second;
+  return released;
+}
+
+void SizeClassPoolAllocator::Release(const BufferList& release) {
+  for (const auto& buffer : release) {
+    for (const auto& v : free_visitors_) {
+      v(buffer.first, buffer.second);
+    }
+    allocator_->Free(buffer.first, buffer.second);
+  }
+}
+
+void SizeClassPoolAllocator::Clear() {
+  BufferList release;
+  {
+    mutex_lock lock(mutex_);
+    for (int c = 0; c < kNumClasses; ++c) {
+      for (void* chunk : free_lists_[c]) {
+        release.emplace_back(chunk, size_t{1} << c);
+      }
+      free_lists_[c].clear();
+    }
+    cached_bytes_ = 0;
+  }
+  Release(release);
+}
+
+size_t SizeClassPoolAllocator::cached_bytes() {
+  mutex_lock lock(mutex_);
+  return cached_bytes_;
+}
+
+int64 SizeClassPoolAllocator::get_from_pool_count() {
+  mutex_lock lock(mutex_);
+  return get_from_pool_count_;
+}
+
+int64 SizeClassPoolAllocator::allocated_count() {
+  mutex_lock lock(mutex_);
+  return allocated_count_;
+}
+
+int64 SizeClassPoolAllocator::trimmed_count() {
+  mutex_lock lock(mutex_);
+  return trimmed_count_;
+}
+
+void SizeClassPoolAllocator::GetStats(AllocatorStats* stats) {
+  mutex_lock lock(mutex_);
+  *stats = stats_;
+}
+
+void SizeClassPoolAllocator::AddAllocVisitor(Visitor visitor) {
+  mutex_lock lock(mutex_);
+  CHECK(!allocation_begun_)
+      << "AddAllocVisitor may not be called after pool allocation "
+      << "has begun.";
+  alloc_visitors_.push_back(visitor);
+}
+
+void SizeClassPoolAllocator::AddFreeVisitor(Visitor visitor) {
+  mutex_lock lock(mutex_);
+  CHECK(!allocation_begun_)
+      << "AddFreeVisitor may not be called after pool allocation "
+      << "has begun.";
+  free_visitors_.push_back(visitor);
+}
+
 }  // namespace tensorflow
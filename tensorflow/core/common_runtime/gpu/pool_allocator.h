@@ -20,9 +20,11 @@ limitations under the License.
 // implement the VisitableAllocator interface. GPU memory is managed
 // by GPURegionAllocator.
 
+#include <algorithm>
 #include <atomic>
 #include <map>
 #include <memory>
+#include <utility>
 #include <vector>
 #include "tensorflow/core/common_runtime/visitable_allocator.h"
 #include "tensorflow/core/lib/core/bits.h"
@@ -30,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -152,6 +155,102 @@ class PoolAllocator : public VisitableAllocator {
   std::atomic<bool> allocation_begun_;
 };
 
+// Pool of memory buffers obtained from a SubAllocator instance, binned
+// into power-of-two size classes so that requests of varying sizes
+// reuse the same buffers.  Returned buffers are kept on a LIFO free
+// list per class.  Every "trim_interval" deallocations the pool is
+// trimmed to a high-water mark: cached buffers are released, largest
+// first, until the pool holds no more than the peak number of bytes
+// in use since the previous trim.
+class SizeClassPoolAllocator : public VisitableAllocator {
+ public:
+  // The smallest size class, in bytes.
+  static constexpr size_t kMinClassBytes = 256;
+
+  // "allocator" is the object that performs the underlying memory
+  // malloc/free operations.  This object takes ownership of allocator.
+  // "bytes_limit" bounds the bytes in use plus cached; 0 means no
+  // limit.  If "trim_interval" is 0, cached buffers are only released
+  // when the limit is reached or by Clear().
+  SizeClassPoolAllocator(SubAllocator* allocator, size_t bytes_limit,
+                         int64 trim_interval, string name);
+  ~SizeClassPoolAllocator() override;
+
+  string Name() override { return name_; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+
+  void DeallocateRaw(void* ptr) override;
+
+  // REQUIRES: The following functions may only be called prior
+  // to the first Allocate*() call.  Once allocation has begun, it is
+  // illegal to register another visitor.
+
+  void AddAllocVisitor(Visitor visitor) override;
+
+  void AddFreeVisitor(Visitor visitor) override;
+
+  // Releases all cached buffers to the underlying allocator.
+  void Clear();
+
+  // Bytes of returned buffers held by the pool.
+  size_t cached_bytes() LOCKS_EXCLUDED(mutex_);
+
+  // Number of allocations satisfied from the pool.
+  int64 get_from_pool_count() LOCKS_EXCLUDED(mutex_);
+
+  // Number of allocations requiring a fresh buffer.
+  int64 allocated_count() LOCKS_EXCLUDED(mutex_);
+
+  // Number of cached buffers released by trimming.
+  int64 trimmed_count() LOCKS_EXCLUDED(mutex_);
+
+  void GetStats(AllocatorStats* stats) override;
+
+ private:
+  static constexpr int kNumClasses = 64;
+
+  // Buffers and their sizes.
+  typedef std::vector<std::pair<void*, size_t>> BufferList;
+
+  // Moves cached buffers to "release" until bytes in use plus cached
+  // is at most "target_bytes".
+  void TrimTo(size_t target_bytes, BufferList* release)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Calls the free visitors on, and frees, each buffer in "release".
+  void Release(const BufferList& release) LOCKS_EXCLUDED(mutex_);
+
+  // Releases cached buffers, largest first, until at least "num_bytes"
+  // or all of them are released.  Returns the bytes released.
+  size_t ReleaseCached(size_t num_bytes) LOCKS_EXCLUDED(mutex_);
+
+  const string name_;
+  const size_t bytes_limit_;
+  const int64 trim_interval_;
+  std::unique_ptr<SubAllocator> allocator_;
+  mutex mutex_;
+  // free_lists_[c] holds returned buffers of 2^c bytes.
+  std::vector<void*> free_lists_[kNumClasses] GUARDED_BY(mutex_);
+  size_t cached_bytes_ GUARDED_BY(mutex_) = 0;
+  size_t peak_since_trim_ GUARDED_BY(mutex_) = 0;
+  int64 deallocs_since_trim_ GUARDED_BY(mutex_) = 0;
+  int64 get_from_pool_count_ GUARDED_BY(mutex_) = 0;
+  int64 allocated_count_ GUARDED_BY(mutex_) = 0;
+  int64 trimmed_count_ GUARDED_BY(mutex_) = 0;
+  AllocatorStats stats_ GUARDED_BY(mutex_);
+  // Write access to these is guarded by mutex_, but not read
+  // access. They may only be modified prior to the first
+  // allocation.  Later attempts to modify will fail.
+  std::vector<Visitor> alloc_visitors_;
+  std::vector<Visitor> free_visitors_;
+  std::atomic<bool> allocation_begun_;
+  // Of the listener that releases cached buffers under memory pressure.
+  int64 pressure_handle_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SizeClassPoolAllocator);
+};
+
 // Do-nothing rounder. Passes through sizes unchanged.
 class NoopRounder : public RoundUpInterface {
  public:
@@ -211,5 +310,60 @@ class CUDAHostAllocator : public SubAllocator {
   TF_DISALLOW_COPY_AND_ASSIGN(CUDAHostAllocator);
 };
 
+// Allocator for pinned CPU RAM with a preference for pages on a given
+// NUMA node, e.g. the one local to a GPU's PCIe root, so that DMA with
+// the GPU does not cross sockets.  Regions are page aligned and padded
+// to whole pages, since CUDA pins whole pages and will not register a
+// page twice.
+class NUMACUDAHostAllocator : public SubAllocator {
+ public:
+  // Note: stream_exec cannot be null.
+  NUMACUDAHostAllocator(perftools::gputools::StreamExecutor* stream_exec,
+                        int numa_node)
+      : stream_exec_(stream_exec), numa_node_(numa_node) {
+    CHECK(stream_exec_ != nullptr);
+  }
+  ~NUMACUDAHostAllocator() override {}
+
+  void* Alloc(size_t alignment, size_t num_bytes) override {
+    void* ptr = nullptr;
+    if (num_bytes > 0) {
+      const size_t size = RoundToPages(num_bytes);
+      ptr = port::NUMAMalloc(numa_node_, size,
+                             std::max(alignment, kPageBytes));
+      if (ptr != nullptr && !stream_exec_->HostMemoryRegister(ptr, size)) {
+        port::NUMAFree(ptr, size);
+        ptr = nullptr;
+      }
+      if (ptr == nullptr) {
+        LOG(WARNING) << "could not allocate pinned host memory of size: "
+                     << num_bytes << " on NUMA node " << numa_node_;
+      }
+    }
+    return ptr;
+  }
+
+  void Free(void* ptr, size_t num_bytes) override {
+    if (ptr != nullptr) {
+      if (!stream_exec_->HostMemoryUnregister(ptr)) {
+        LOG(WARNING) << "could not unregister pinned host memory at " << ptr;
+      }
+      port::NUMAFree(ptr, RoundToPages(num_bytes));
+    }
+  }
+
+ private:
+  static constexpr size_t kPageBytes = 4096;
+
+  static size_t RoundToPages(size_t num_bytes) {
+    return (num_bytes + kPageBytes - 1) & ~(kPageBytes - 1);
+  }
+
+  perftools::gputools::StreamExecutor* stream_exec_;  // not owned, non-null
+  const int numa_node_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(NUMACUDAHostAllocator);
+};
+
 }  // namespace tensorflow
 #endif  // TENSORFLOW_COMMON_RUNTIME_GPU_POOL_ALLOCATOR_H_
@@ -17,6 +17,9 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/pool_allocator.h"
 
+#include <vector>
+
+#include "tensorflow/core/framework/memory_pressure.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -211,6 +214,113 @@ TEST(PoolAllocatorTest, Name) {
   EXPECT_EQ("pool", pool.Name());
 }
 
+TEST(SizeClassPoolAllocatorTest, ReusesBuffersAcrossSizes) {
+  SizeClassPoolAllocator pool(new BasicCPUAllocator, 0 /*bytes_limit*/,
+                              0 /*trim_interval*/, "size_class_pool");
+  EXPECT_EQ(nullptr, pool.AllocateRaw(4 /*alignment*/, 0 /*num_bytes*/));
+
+  // 1000 and 900 bytes, plus the chunk prefix, share the 1KB class.
+  void* p1 = pool.AllocateRaw(4, 1000);
+  EXPECT_NE(nullptr, p1);
+  pool.DeallocateRaw(p1);
+  EXPECT_EQ(1024, pool.cached_bytes());
+  void* p2 = pool.AllocateRaw(4, 900);
+  EXPECT_EQ(p1, p2);
+  EXPECT_EQ(1, pool.get_from_pool_count());
+  EXPECT_EQ(1, pool.allocated_count());
+
+  // A larger alignment is honored by the same chunk.
+  pool.DeallocateRaw(p2);
+  void* p3 = pool.AllocateRaw(256, 500);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(p3) % 256);
+  EXPECT_EQ(2, pool.get_from_pool_count());
+
+  // 2000 bytes needs the 2KB class.
+  void* p4 = pool.AllocateRaw(4, 2000);
+  EXPECT_NE(p3, p4);
+  EXPECT_EQ(2, pool.allocated_count());
+
+  AllocatorStats stats;
+  pool.GetStats(&stats);
+  EXPECT_EQ(4, stats.num_allocs);
+  EXPECT_EQ(1024 + 2048, stats.bytes_in_use);
+  EXPECT_EQ(2048, stats.max_alloc_size);
+  pool.DeallocateRaw(p3);
+  pool.DeallocateRaw(p4);
+  pool.Clear();
+  EXPECT_EQ(0, pool.cached_bytes());
+}
+
+TEST(SizeClassPoolAllocatorTest, TrimsToHighWaterMark) {
+  SizeClassPoolAllocator pool(new BasicCPUAllocator, 0 /*bytes_limit*/,
+                              2 /*trim_interval*/, "size_class_pool");
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 4; ++i) ptrs.push_back(pool.AllocateRaw(4, 1000));
+
+  // The first trim keeps everything, since 4KB were in use.
+  pool.DeallocateRaw(ptrs[0]);
+  pool.DeallocateRaw(ptrs[1]);
+  EXPECT_EQ(0, pool.trimmed_count());
+  EXPECT_EQ(2048, pool.cached_bytes());
+
+  // At most 2KB were in use since, so the second trim drops 2KB.
+  pool.DeallocateRaw(ptrs[2]);
+  pool.DeallocateRaw(ptrs[3]);
+  EXPECT_EQ(2, pool.trimmed_count());
+  EXPECT_EQ(2048, pool.cached_bytes());
+}
+
+TEST(SizeClassPoolAllocatorTest, BytesLimit) {
+  SizeClassPoolAllocator pool(new BasicCPUAllocator, 4096 /*bytes_limit*/,
+                              0 /*trim_interval*/, "size_class_pool");
+  void* p1 = pool.AllocateRaw(4, 3000);
+  EXPECT_NE(nullptr, p1);
+  EXPECT_EQ(nullptr, pool.AllocateRaw(4, 1000));
+
+  // The cached 4KB buffer is released to make room for a 1KB one.
+  pool.DeallocateRaw(p1);
+  void* p2 = pool.AllocateRaw(4, 1000);
+  EXPECT_NE(nullptr, p2);
+  EXPECT_EQ(0, pool.cached_bytes());
+  EXPECT_EQ(1, pool.trimmed_count());
+  pool.DeallocateRaw(p2);
+}
+
+TEST(SizeClassPoolAllocatorTest, ReleasesCachedBuffersUnderPressure) {
+  SizeClassPoolAllocator pool(new BasicCPUAllocator, 0 /*bytes_limit*/,
+                              0 /*trim_interval*/, "size_class_pool");
+  pool.DeallocateRaw(pool.AllocateRaw(4, 3000));
+  pool.DeallocateRaw(pool.AllocateRaw(4, 1000));
+  EXPECT_EQ(4096 + 1024, pool.cached_bytes());
+
+  // Host buffers do not help GPU allocators.
+  EXPECT_EQ(0,
+            MemoryPressureRegistry::Global()->Notify("GPU_0_bfc", 1 << 20));
+  EXPECT_EQ(4096 + 1024, pool.cached_bytes());
+
+  // The largest buffer suffices.
+  EXPECT_LE(4096, MemoryPressureRegistry::Global()->Notify("cpu", 100));
+  EXPECT_EQ(1024, pool.cached_bytes());
+}
+
+TEST(SizeClassPoolAllocatorTest, NUMACudaHostAllocator) {
+  gpu::Platform* platform =
+      gpu::MultiPlatformManager::PlatformWithName("cuda").ValueOrDie();
+  SizeClassPoolAllocator pool(
+      new NUMACUDAHostAllocator(
+          platform->GetExecutor(gpu::StreamExecutorConfig(/*ordinal=*/0))
+              .ValueOrDie(),
+          0 /*numa_node*/),
+      0 /*bytes_limit*/, 0 /*trim_interval*/, "size_class_pool");
+  char* p1 = static_cast<char*>(pool.AllocateRaw(4, 10000));
+  ASSERT_NE(nullptr, p1);
+  memset(p1, 1, 10000);
+  pool.DeallocateRaw(p1);
+  char* p2 = static_cast<char*>(pool.AllocateRaw(4, 9000));
+  EXPECT_EQ(p1, p2);
+  pool.DeallocateRaw(p2);
+}
+
 }  // namespace
 }  // namespace tensorflow
 
@@ -15,12 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/process_state.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/gpu/gpu_bfc_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_cudamalloc_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_debug_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_unified_memory_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/pool_allocator.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/log_memory.h"
@@ -28,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/env_var.h"
@@ -59,6 +62,21 @@ bool useCudaMallocAllocator() {
     return false;
 }
 
+// Whether pinned host memory comes from a SizeClassPoolAllocator per
+// NUMA node rather than from one BFCAllocator.
+bool UseCUDAHostSizeClassPool() {
+  static const bool use_size_class_pool = [] {
+    bool value = false;
+    Status status = ReadBoolFromEnvVar("TF_CUDA_HOST_USE_SIZE_CLASS_POOL",
+                                       false, &value);
+    if (!status.ok()) {
+      LOG(ERROR) << "UseCUDAHostSizeClassPool: " << status.error_message();
+    }
+    return value;
+  }();
+  return use_size_class_pool;
+}
+
 bool useCudaMemoryGuardAllocator() {
   const char* debug_allocator_str = std::getenv("TF_GPU_ALLOCATOR");
   if (debug_allocator_str != nullptr &&
@@ -120,6 +138,7 @@ Allocator* ProcessState::GetGPUAllocator(const GPUOptions& options, int gpu_id,
 
   if (gpu_id >= static_cast<int64>(gpu_allocators_.size())) {
     gpu_allocators_.resize(gpu_id + 1);
+    gpu_bfc_allocators_.resize(gpu_id + 1);
     if (FLAGS_brain_gpu_record_mem_types) gpu_al_.resize(gpu_id + 1);
   }
 
@@ -132,7 +151,10 @@ Allocator* ProcessState::GetGPUAllocator(const GPUOptions& options, int gpu_id,
       return nullptr;
     }
 
-    gpu_allocator = new GPUBFCAllocator(gpu_id, total_bytes, options);
+    GPUBFCAllocator* bfc_allocator =
+        new GPUBFCAllocator(gpu_id, total_bytes, options);
+    gpu_bfc_allocators_[gpu_id] = bfc_allocator;
+    gpu_allocator = bfc_allocator;
 
     // If true, checks for memory overwrites by writing
     // distinctive patterns on both ends of allocated memory.
@@ -145,6 +167,10 @@ Allocator* ProcessState::GetGPUAllocator(const GPUOptions& options, int gpu_id,
       // **WARNING** probably will not work in a multi-gpu scenario
       gpu_allocator = new GPUcudaMallocAllocator(gpu_allocator, gpu_id);
     }
+    if (options.unified_memory_threshold_bytes() > 0) {
+      gpu_allocator = new GPUUnifiedMemoryAllocator(
+          gpu_allocator, gpu_id, options.unified_memory_threshold_bytes());
+    }
     gpu_allocators_[gpu_id] = gpu_allocator;
 
     // If there are any pending AllocVisitors for this bus, add
@@ -177,6 +203,17 @@ Allocator* ProcessState::GetGPUAllocator(const GPUOptions& options, int gpu_id,
 #endif  // GOOGLE_CUDA
 }
 
+void ProcessState::FlushGPUAllocatorThreadCaches(int gpu_id) {
+  BFCAllocator* allocator = nullptr;
+  {
+    mutex_lock lock(mu_);
+    if (gpu_id < static_cast<int64>(gpu_bfc_allocators_.size())) {
+      allocator = gpu_bfc_allocators_[gpu_id];
+    }
+  }
+  if (allocator != nullptr) allocator->FlushThreadCaches();
+}
+
 Allocator* ProcessState::GetCPUAllocator(int numa_node) {
   // Although we're temporarily ignoring numa_node, check for legality.
   CHECK_GE(numa_node, 0);
@@ -229,31 +266,37 @@ Allocator* ProcessState::GetCUDAHostAllocator(int numa_node) {
   if (!HasGPUDevice() || !FLAGS_brain_mem_reg_cuda_dma) {
     return cpu_allocator();
   }
-  // Although we're temporarily ignoring numa_node, check for legality.
   CHECK_GE(numa_node, 0);
-  // TODO(tucker): actually maintain separate CPUAllocators for
-  // different numa_nodes.  For now, just one.
-  numa_node = 0;
+  const bool use_size_class_pool = UseCUDAHostSizeClassPool();
+  if (!use_size_class_pool || !port::NUMAEnabled() ||
+      numa_node >= port::NUMANumNodes()) {
+    numa_node = 0;
+  }
   mutex_lock lock(mu_);
 
-  // Find the first valid StreamExecutor to request CUDA host memory
-  // through, since any will work.
-  //
-  // This search isn't super clean, and it would be nice to use a
-  // better source of information about which executor to use.  For
-  // example, process_state could maybe save the first stream executor
-  // it knows is valid.
-  gpu::StreamExecutor* se = nullptr;
-  for (int i = 0; i < static_cast<int>(gpu_allocators_.size()); ++i) {
-    if (gpu_allocators_[i] != nullptr) {
-      se = GPUMachineManager()->ExecutorForDevice(i).ValueOrDie();
-      break;
+  while (static_cast<int>(cuda_host_allocators_.size()) <= numa_node) {
+    const int node = cuda_host_allocators_.size();
+    // Find a valid StreamExecutor to request CUDA host memory through.
+    // Any will work, but one on the node is preferred.
+    //
+    // This search isn't super clean, and it would be nice to use a
+    // better source of information about which executor to use.  For
+    // example, process_state could maybe save the first stream executor
+    // it knows is valid.
+    gpu::StreamExecutor* se = nullptr;
+    for (int i = 0; i < static_cast<int>(gpu_allocators_.size()); ++i) {
+      if (gpu_allocators_[i] == nullptr) continue;
+      gpu::StreamExecutor* gpu_se =
+          GPUMachineManager()->ExecutorForDevice(i).ValueOrDie();
+      if (se == nullptr) se = gpu_se;
+      if (gpu_se->GetDeviceDescription().numa_node() == node) {
+        se = gpu_se;
+        break;
+      }
     }
-  }
 
-  CHECK_NE(nullptr, se);
+    CHECK_NE(nullptr, se);
 
-  while (static_cast<int>(cuda_host_allocators_.size()) <= numa_node) {
     // TODO(zheng-xq): evaluate whether 64GB by default is the best choice.
     int64 cuda_host_mem_limit_in_mb = -1;
     Status status = ReadInt64FromEnvVar("TF_CUDA_HOST_MEM_LIMIT_IN_MB",
@@ -263,9 +306,30 @@ Allocator* ProcessState::GetCUDAHostAllocator(int numa_node) {
       LOG(ERROR) << "GetCUDAHostAllocator: " << status.error_message();
     }
     int64 cuda_host_mem_limit = cuda_host_mem_limit_in_mb * (1LL << 20);
-    VisitableAllocator* allocator =
-        new BFCAllocator(new CUDAHostAllocator(se), cuda_host_mem_limit,
-                         true /*allow_growth*/, "cuda_host_bfc" /*name*/);
+    VisitableAllocator* allocator;
+    if (use_size_class_pool) {
+      int64 trim_interval = 0;
+      status = ReadInt64FromEnvVar("TF_CUDA_HOST_POOL_TRIM_INTERVAL", 1000,
+                                   &trim_interval);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetCUDAHostAllocator: " << status.error_message();
+      }
+      SubAllocator* sub_allocator;
+      if (port::NUMAEnabled()) {
+        sub_allocator = new NUMACUDAHostAllocator(se, node);
+      } else {
+        sub_allocator = new CUDAHostAllocator(se);
+      }
+      allocator = new SizeClassPoolAllocator(
+          sub_allocator, cuda_host_mem_limit, trim_interval,
+          strings::StrCat("cuda_host_pool_numa_", node));
+      VLOG(2) << "Using SizeClassPoolAllocator for CUDA host memory on "
+              << "NUMA node " << node;
+    } else {
+      allocator =
+          new BFCAllocator(new CUDAHostAllocator(se), cuda_host_mem_limit,
+                           true /*allow_growth*/, "cuda_host_bfc" /*name*/);
+    }
 
     if (LogMemory::IsEnabled()) {
       // Wrap the allocator to track allocation ids for better logging
@@ -283,8 +347,16 @@ Allocator* ProcessState::GetCUDAHostAllocator(int numa_node) {
           &mem_desc_map_, cuda_host_allocators_.back(), md, &mu_));
     }
   }
-  if (FLAGS_brain_gpu_record_mem_types) return cuda_al_[0];
-  return cuda_host_allocators_[0];
+  if (FLAGS_brain_gpu_record_mem_types) return cuda_al_[numa_node];
+  return cuda_host_allocators_[numa_node];
+}
+
+Allocator* ProcessState::GetCUDAHostStagingAllocator(int numa_node) {
+  if (!HasGPUDevice() || !FLAGS_brain_mem_reg_cuda_dma ||
+      !UseCUDAHostSizeClassPool()) {
+    return nullptr;
+  }
+  return GetCUDAHostAllocator(std::max(numa_node, 0));
 }
 
 void ProcessState::AddGPUAllocVisitor(int bus_id, AllocVisitor visitor) {
@@ -29,6 +29,7 @@ limitations under the License.
 namespace tensorflow {
 
 class Allocator;
+class BFCAllocator;
 class VisitableAllocator;
 class PoolAllocator;
 
@@ -92,8 +93,21 @@ class ProcessState {
   virtual Allocator* GetGPUAllocator(const GPUOptions& options, int gpu_id,
                                      size_t total_bytes);
 
+  // Returns the allocator of pinned CPU RAM, suitable for DMA with the
+  // GPUs, for the given numa_node.  If TF_CUDA_HOST_USE_SIZE_CLASS_POOL
+  // is set, each NUMA node has its own SizeClassPoolAllocator of pages
+  // local to the node; otherwise all nodes share one BFCAllocator.
   virtual Allocator* GetCUDAHostAllocator(int numa_node);
 
+  // Returns the allocator through which copies from pageable CPU RAM
+  // to a GPU on the given numa_node should be staged, or nullptr if
+  // such copies should not be staged.
+  virtual Allocator* GetCUDAHostStagingAllocator(int numa_node);
+
+  // Returns the chunks in the per-thread caches of the allocator of
+  // 'gpu_id' to it, if it has been created.
+  void FlushGPUAllocatorThreadCaches(int gpu_id);
+
   // Registers a function to be called once on every new Region
   // allocated by every GPURegionAllocator proximate to the specified
   // bus.  The AllocVisitor is provided with a memory pointer and the
@@ -119,6 +133,8 @@ class ProcessState {
 
   std::vector<Allocator*> cpu_allocators_ GUARDED_BY(mu_);
   std::vector<VisitableAllocator*> gpu_allocators_ GUARDED_BY(mu_);
+  // The GPUBFCAllocators under the possible wrappers in gpu_allocators_.
+  std::vector<BFCAllocator*> gpu_bfc_allocators_ GUARDED_BY(mu_);
   std::vector<std::vector<AllocVisitor>> gpu_visitors_ GUARDED_BY(mu_);
   std::vector<Allocator*> cuda_host_allocators_ GUARDED_BY(mu_);
 
@@ -15,14 +15,17 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/graph_execution_state.h"
 
+#include <deque>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/optimization_registry.h"
 #include "tensorflow/core/common_runtime/placer.h"
+#include "tensorflow/core/common_runtime/variable_placement.h"
 #include "tensorflow/core/framework/graph.pb_text.h"
 #include "tensorflow/core/framework/graph_def_util.h"
 #include "tensorflow/core/framework/node_def.pb.h"
@@ -34,6 +37,8 @@ limitations under the License.
 #include "tensorflow/core/graph/validate.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
@@ -49,6 +54,31 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// The maximum number of sub-graphs cached by each GraphExecutionState.
+const size_t kSubgraphCacheCapacity = 8;
+
+string SubgraphCacheKey(const BuildGraphOptions& options) {
+  string key = strings::StrCat(
+      str_util::Join(options.feed_endpoints, ","), ";",
+      str_util::Join(options.fetch_endpoints, ","), ";",
+      str_util::Join(options.target_nodes, ","), ";",
+      options.use_function_convention);
+  for (const TensorShape& shape : options.feed_shapes) {
+    strings::StrAppend(&key, ";", shape.DebugString());
+  }
+  return key;
+}
+
+}  // namespace
+
+struct GraphExecutionState::CachedSubgraph {
+  std::unique_ptr<Graph> graph;
+  subgraph::RewriteGraphMetadata metadata;
+  std::list<string>::iterator lru_it;
+};
+
 GraphExecutionState::GraphExecutionState(
     GraphDef* graph_def, const GraphExecutionStateOptions& options)
     : stateful_placements_(options.stateful_placements),
@@ -269,6 +299,15 @@ Status GraphExecutionState::InitBaseGraph(const BuildGraphOptions& options) {
   // TODO(mrry): Consider making the Placer cancelable.
   TF_RETURN_IF_ERROR(placer.Run());
 
+  if (session_options_ != nullptr) {
+    const string& balance_job =
+        session_options_->config.experimental().balance_variables_job();
+    if (!balance_job.empty()) {
+      TF_RETURN_IF_ERROR(BalanceVariablePlacement(
+          balance_job, *device_set_, stateful_placements_, new_graph.get()));
+    }
+  }
+
   TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
       OptimizationPassRegistry::POST_PLACEMENT, optimization_options));
 
@@ -278,7 +317,8 @@ Status GraphExecutionState::InitBaseGraph(const BuildGraphOptions& options) {
 }
 
 Status GraphExecutionState::OptimizeGraph(
-    const BuildGraphOptions& options, std::unique_ptr<Graph>* optimized_graph) {
+    const BuildGraphOptions& options, const Graph& graph,
+    std::unique_ptr<Graph>* optimized_graph) {
 #ifndef IS_MOBILE_PLATFORM
   if (session_options_->config.graph_options().place_pruned_graph()) {
     return errors::InvalidArgument("Can't optimize a pruned graph");
@@ -293,7 +333,7 @@ Status GraphExecutionState::OptimizeGraph(
     // functionality on by default.
     grappler::GrapplerItem item;
     item.id = "tf_graph";
-    graph_->ToGraphDef(&item.graph);
+    graph.ToGraphDef(&item.graph);
 
     item.fetch = options.fetch_endpoints;
     item.fetch.insert(item.fetch.end(), options.target_nodes.begin(),
@@ -301,13 +341,20 @@ Status GraphExecutionState::OptimizeGraph(
 
     if (!options.feed_endpoints.empty()) {
       std::unordered_set<string> feeds;
-      for (const string& feed : options.feed_endpoints) {
+      // The shapes of the fed tensors, by placeholder.
+      std::unordered_map<string, TensorShape> feed_shapes;
+      for (size_t i = 0; i < options.feed_endpoints.size(); ++i) {
+        const string& feed = options.feed_endpoints[i];
         TensorId id = ParseTensorName(feed);
         if (id.second != 0) {
           return errors::InvalidArgument("Unsupported feed: ", feed);
         }
         feeds.insert(id.first.ToString());
+        if (i < options.feed_shapes.size()) {
+          feed_shapes[id.first.ToString()] = options.feed_shapes[i];
+        }
       }
+      std::unordered_map<string, TensorShape> specialized_shapes;
       for (const NodeDef& node : original_graph_def_.node()) {
         if (feeds.find(node.name()) == feeds.end()) {
           continue;
@@ -331,17 +378,38 @@ Status GraphExecutionState::OptimizeGraph(
           }
         }
         TensorShape shape(shape_proto);
+        // A graph specialized to the shape of the fed tensor sees it in the
+        // shape of the placeholder, e.g. to fold the arithmetic on it.
+        auto it = feed_shapes.find(node.name());
+        if (it != feed_shapes.end() &&
+            PartialTensorShape(node.attr().at("shape").shape())
+                .IsCompatibleWith(it->second)) {
+          shape = it->second;
+          specialized_shapes[node.name()] = it->second;
+        }
         DataType type = node.attr().at("dtype").type();
         Tensor fake_input(type, shape);
         item.feed.emplace_back(node.name(), fake_input);
       }
+      for (NodeDef& node : *item.graph.mutable_node()) {
+        auto it = specialized_shapes.find(node.name());
+        if (it != specialized_shapes.end()) {
+          it->second.AsProto((*node.mutable_attr())["shape"].mutable_shape());
+        }
+      }
+      item.static_feed_shapes = specialized_shapes.size() == feeds.size();
     }
 
     std::unordered_map<string, DeviceProperties> device_map;
     Device* cpu_device = nullptr;
     for (const auto& device : device_set_->devices()) {
-      device_map[device->name()] =
-          grappler::GetDeviceInfo(device->parsed_name());
+      DeviceProperties& properties = device_map[device->name()];
+      properties = grappler::GetDeviceInfo(device->parsed_name());
+      // The memory the allocator of the device may use, which is less than
+      // the memory of the hardware.
+      if (device->attributes().memory_limit() > 0) {
+        properties.set_memory_size(device->attributes().memory_limit());
+      }
       if (device->parsed_name().id == 0 &&
           StringPiece(device->parsed_name().type) == "CPU" &&
           device->GetAllocator(AllocatorAttributes()) != nullptr) {
@@ -377,6 +445,123 @@ Status GraphExecutionState::OptimizeGraph(
 #endif  // IS_MOBILE_PLATFORM
 }
 
+void GraphExecutionState::CopyReachableSubgraph(
+    const BuildGraphOptions& options, Graph* out) {
+  if (node_index_.empty()) {
+    for (Node* n : graph_->op_nodes()) node_index_[n->name()] = n;
+  }
+
+  std::vector<bool> reachable(graph_->num_node_ids(), false);
+  std::deque<Node*> queue;
+  auto visit = [this, &reachable, &queue](StringPiece name) {
+    // Unknown names are reported by RewriteGraphForExecution().
+    auto it = node_index_.find(name);
+    if (it != node_index_.end() && !reachable[it->second->id()]) {
+      reachable[it->second->id()] = true;
+      queue.push_back(it->second);
+    }
+  };
+  // Fed nodes may not be needed by the fetches, but the rewrite requires
+  // them to exist.
+  for (const string& feed : options.feed_endpoints) {
+    visit(ParseTensorName(feed).first);
+  }
+  for (const string& fetch : options.fetch_endpoints) {
+    visit(ParseTensorName(fetch).first);
+  }
+  for (const string& target : options.target_nodes) {
+    visit(target);
+  }
+  while (!queue.empty()) {
+    Node* n = queue.front();
+    queue.pop_front();
+    for (const Edge* e : n->in_edges()) {
+      Node* in = e->src();
+      if (in->IsOp() && !reachable[in->id()]) {
+        reachable[in->id()] = true;
+        queue.push_back(in);
+      }
+    }
+  }
+
+  // Copy the nodes in the same order as CopyGraph() would, and all the edges
+  // between them.
+  out->set_versions(graph_->versions());
+  std::vector<Node*> node_map(graph_->num_node_ids(), nullptr);
+  node_map[graph_->source_node()->id()] = out->source_node();
+  node_map[graph_->sink_node()->id()] = out->sink_node();
+  for (Node* n : graph_->op_nodes()) {
+    if (reachable[n->id()]) node_map[n->id()] = out->CopyNode(n);
+  }
+  for (Node* n : graph_->op_nodes()) {
+    if (!reachable[n->id()]) continue;
+    for (const Edge* e : n->in_edges()) {
+      out->AddEdge(node_map[e->src()->id()], e->src_output(),
+                   node_map[n->id()], e->dst_input());
+    }
+  }
+  for (const Edge* e : graph_->sink_node()->in_edges()) {
+    Node* src = node_map[e->src()->id()];
+    if (src != nullptr) {
+      out->AddEdge(src, e->src_output(), out->sink_node(), e->dst_input());
+    }
+  }
+}
+
+Status GraphExecutionState::PruneFullGraph(
+    const BuildGraphOptions& options, std::unique_ptr<Graph>* out,
+    subgraph::RewriteGraphMetadata* out_metadata) {
+  const string cache_key = SubgraphCacheKey(options);
+  mutex_lock l(subgraph_cache_mu_);
+  auto it = subgraph_cache_.find(cache_key);
+  if (it != subgraph_cache_.end()) {
+    VLOG(1) << "Reusing the cached subgraph";
+    CachedSubgraph* cached = it->second.get();
+    subgraph_cache_lru_.splice(subgraph_cache_lru_.begin(),
+                               subgraph_cache_lru_, cached->lru_it);
+    out->reset(new Graph(flib_def_.get()));
+    CopyGraph(*cached->graph, out->get());
+    *out_metadata = cached->metadata;
+    return Status::OK();
+  }
+
+  // The nodes that cannot be reached from the feeds, fetches and targets
+  // would be pruned anyway, so they are neither copied nor optimized.
+  std::unique_ptr<Graph> reachable(new Graph(flib_def_.get()));
+  CopyReachableSubgraph(options, reachable.get());
+  std::unique_ptr<Graph> ng;
+  Status s = OptimizeGraph(options, *reachable, &ng);
+  if (errors::IsResourceExhausted(s)) {
+    // The graph would not fit in the memory of its devices.
+    return s;
+  } else if (!s.ok()) {
+    // Simply use the unoptimized graph if we couldn't optimize it.
+    ng = std::move(reachable);
+  }
+
+  // Extract the subset of the graph that needs to be run, adding feed/fetch
+  // ops as needed.
+  TF_RETURN_IF_ERROR(subgraph::RewriteGraphForExecution(
+      ng.get(), options.feed_endpoints, options.fetch_endpoints,
+      options.target_nodes, device_set_->client_device()->attributes(),
+      options.use_function_convention, out_metadata));
+
+  std::unique_ptr<CachedSubgraph> cached(new CachedSubgraph);
+  cached->graph.reset(new Graph(flib_def_.get()));
+  CopyGraph(*ng, cached->graph.get());
+  cached->metadata = *out_metadata;
+  subgraph_cache_lru_.push_front(cache_key);
+  cached->lru_it = subgraph_cache_lru_.begin();
+  subgraph_cache_[cache_key] = std::move(cached);
+  if (subgraph_cache_lru_.size() > kSubgraphCacheCapacity) {
+    subgraph_cache_.erase(subgraph_cache_lru_.back());
+    subgraph_cache_lru_.pop_back();
+  }
+
+  *out = std::move(ng);
+  return Status::OK();
+}
+
 Status GraphExecutionState::BuildGraph(const BuildGraphOptions& options,
                                        std::unique_ptr<ClientGraph>* out) {
   VLOG(1) << "BuildGraph";
@@ -388,26 +573,16 @@ Status GraphExecutionState::BuildGraph(const BuildGraphOptions& options,
   }
 
   std::unique_ptr<Graph> ng;
-  Status s = OptimizeGraph(options, &ng);
-  if (!s.ok()) {
-    // Simply copy the original graph if we couldn't optimize it.
-    ng.reset(new Graph(flib_def_.get()));
-    CopyGraph(*graph_, ng.get());
-  }
-
   subgraph::RewriteGraphMetadata rewrite_metadata;
   if (session_options_ == nullptr ||
       !session_options_->config.graph_options().place_pruned_graph()) {
-    // Extract the subset of the graph that needs to be run, adding feed/fetch
-    // ops as needed.
-    TF_RETURN_IF_ERROR(subgraph::RewriteGraphForExecution(
-        ng.get(), options.feed_endpoints, options.fetch_endpoints,
-        options.target_nodes, device_set_->client_device()->attributes(),
-        options.use_function_convention, &rewrite_metadata));
+    TF_RETURN_IF_ERROR(PruneFullGraph(options, &ng, &rewrite_metadata));
   } else {
     // This GraphExecutionState represents a graph that was
-    // pruned when this was constructed, so we copy the metadata from
-    // a member variable.
+    // pruned when this was constructed, so we copy the graph and the
+    // metadata from member variables.
+    ng.reset(new Graph(flib_def_.get()));
+    CopyGraph(*graph_, ng.get());
     CHECK(rewrite_metadata_);
     rewrite_metadata = *rewrite_metadata_;
   }
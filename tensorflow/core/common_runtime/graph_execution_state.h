@@ -17,8 +17,10 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_GRAPH_EXECUTION_STATE_H_
 
 #include <functional>
+#include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/build_graph_options.h"
@@ -28,7 +30,9 @@ limitations under the License.
 #include "tensorflow/core/graph/costmodel.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -134,6 +138,11 @@ class GraphExecutionState {
   // the Node set specified in "options").  If successful, returns OK
   // and the caller takes the ownership of "*out". Otherwise, returns
   // an error.
+  //
+  // Unless the graph was pruned before placement, the optimized and
+  // rewritten sub-graphs of the most recently used feeds, fetches and
+  // targets are cached, and only the nodes that these may depend on are
+  // copied from the full graph to build a new one.
   Status BuildGraph(const BuildGraphOptions& options,
                     std::unique_ptr<ClientGraph>* out);
 
@@ -179,9 +188,20 @@ class GraphExecutionState {
   void SaveStatefulNodes(Graph* graph);
   void RestoreStatefulNodes(Graph* graph);
 
-  Status OptimizeGraph(const BuildGraphOptions& options,
+  Status OptimizeGraph(const BuildGraphOptions& options, const Graph& graph,
                        std::unique_ptr<Graph>* optimized_graph);
 
+  // Sets "*out" to the sub-graph of the placed full graph that is needed
+  // to run "options", optimized and rewritten for execution.
+  Status PruneFullGraph(const BuildGraphOptions& options,
+                        std::unique_ptr<Graph>* out,
+                        subgraph::RewriteGraphMetadata* out_metadata);
+
+  // Copies the nodes of the full graph from which the feeds, fetches or
+  // targets of "options" are reachable into "out".
+  void CopyReachableSubgraph(const BuildGraphOptions& options, Graph* out)
+      EXCLUSIVE_LOCKS_REQUIRED(subgraph_cache_mu_);
+
   GraphDef original_graph_def_;            // Immutable after ctor.
   const DeviceSet* device_set_;            // Not owned
   const SessionOptions* session_options_;  // Not owned
@@ -200,6 +220,16 @@ class GraphExecutionState {
   // The dataflow graph owned by this object.
   Graph* graph_;
 
+  // The sub-graphs built by PruneFullGraph(), most recently used first.
+  struct CachedSubgraph;
+  mutex subgraph_cache_mu_;
+  std::list<string> subgraph_cache_lru_ GUARDED_BY(subgraph_cache_mu_);
+  std::unordered_map<string, std::unique_ptr<CachedSubgraph>> subgraph_cache_
+      GUARDED_BY(subgraph_cache_mu_);
+  // Maps node names to the nodes of 'graph_'. Built on first use.
+  std::unordered_map<StringPiece, Node*, StringPiece::Hasher> node_index_
+      GUARDED_BY(subgraph_cache_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(GraphExecutionState);
 };
 
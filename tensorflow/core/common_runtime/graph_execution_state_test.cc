@@ -0,0 +1,150 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/graph_execution_state.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/gtl/stl_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/equal_graph_def.h"
+
+namespace tensorflow {
+namespace {
+
+class GraphExecutionStateTest : public ::testing::Test {
+ protected:
+  GraphExecutionStateTest() {
+    // Disable grappler, so that the built graphs contain the original nodes.
+    RewriterConfig* rewrite_options =
+        session_options_.config.mutable_graph_options()
+            ->mutable_rewrite_options();
+    rewrite_options->set_disable_model_pruning(true);
+    rewrite_options->set_constant_folding(RewriterConfig::OFF);
+    rewrite_options->set_arithmetic_optimization(RewriterConfig::OFF);
+
+    TF_CHECK_OK(DeviceFactory::AddDevices(
+        session_options_, "/job:localhost/replica:0/task:0", &devices_));
+    for (Device* d : devices_) device_set_.AddDevice(d);
+    device_set_.set_client_device(devices_[0]);
+  }
+
+  ~GraphExecutionStateTest() override { gtl::STLDeleteElements(&devices_); }
+
+  // Creates the following graph, plus "c0" ... "c9" computed from "x".
+  /*
+      x -> y = Neg(x)
+      x -> z = Square(x)
+      u -> v = Neg(u)
+      p -> w = Add(p, x)
+  */
+  void Init() {
+    Scope s = Scope::NewRootScope();
+    auto x = ops::Const(s.WithOpName("x"), 1.0f);
+    ops::Neg(s.WithOpName("y"), x);
+    ops::Square(s.WithOpName("z"), x);
+    auto u = ops::Const(s.WithOpName("u"), 2.0f);
+    ops::Neg(s.WithOpName("v"), u);
+    auto p = ops::Placeholder(s.WithOpName("p"), DT_FLOAT);
+    ops::Add(s.WithOpName("w"), p, x);
+    for (int i = 0; i < 10; ++i) {
+      ops::Neg(s.WithOpName(strings::StrCat("c", i)), x);
+    }
+    GraphDef def;
+    TF_CHECK_OK(s.ToGraphDef(&def));
+
+    GraphExecutionStateOptions options;
+    options.device_set = &device_set_;
+    options.session_options = &session_options_;
+    TF_CHECK_OK(GraphExecutionState::MakeForBaseGraph(&def, options, &state_));
+  }
+
+  std::unique_ptr<ClientGraph> Build(const std::vector<string>& feeds,
+                                     const std::vector<string>& fetches) {
+    BuildGraphOptions options;
+    options.feed_endpoints = feeds;
+    options.fetch_endpoints = fetches;
+    std::unique_ptr<ClientGraph> client_graph;
+    TF_CHECK_OK(state_->BuildGraph(options, &client_graph));
+    return client_graph;
+  }
+
+  // The names of the nodes of 'client_graph', except for the feed and fetch
+  // nodes.
+  std::set<string> NodeNames(const ClientGraph& client_graph) {
+    std::set<string> names;
+    for (const Node* n : client_graph.graph.op_nodes()) {
+      if (!n->IsSend() && !n->IsRecv()) names.insert(n->name());
+    }
+    return names;
+  }
+
+  SessionOptions session_options_;
+  std::vector<Device*> devices_;
+  DeviceSet device_set_;
+  std::unique_ptr<GraphExecutionState> state_;
+};
+
+TEST_F(GraphExecutionStateTest, PrunesUnreachableNodes) {
+  Init();
+  std::unique_ptr<ClientGraph> client_graph = Build({}, {"y:0", "v:0"});
+  EXPECT_EQ(std::set<string>({"x", "y", "u", "v"}), NodeNames(*client_graph));
+  EXPECT_EQ(DataTypeVector({DT_FLOAT, DT_FLOAT}), client_graph->fetch_types);
+
+  client_graph = Build({"p:0"}, {"w:0"});
+  EXPECT_EQ(std::set<string>({"x", "w"}), NodeNames(*client_graph));
+  EXPECT_EQ(DataTypeVector({DT_FLOAT}), client_graph->feed_types);
+}
+
+TEST_F(GraphExecutionStateTest, UnknownFetch) {
+  Init();
+  BuildGraphOptions options;
+  options.fetch_endpoints = {"missing:0"};
+  std::unique_ptr<ClientGraph> client_graph;
+  EXPECT_FALSE(state_->BuildGraph(options, &client_graph).ok());
+  // Failures are not cached.
+  EXPECT_FALSE(state_->BuildGraph(options, &client_graph).ok());
+}
+
+TEST_F(GraphExecutionStateTest, ReusesAndEvictsCachedSubgraphs) {
+  Init();
+  GraphDef first;
+  Build({}, {"z:0"})->graph.ToGraphDef(&first);
+
+  // More signatures than the cache holds.
+  for (int i = 0; i < 10; ++i) {
+    const string name = strings::StrCat("c", i);
+    std::unique_ptr<ClientGraph> client_graph = Build({}, {name + ":0"});
+    EXPECT_EQ(std::set<string>({"x", name}), NodeNames(*client_graph));
+    client_graph = Build({}, {name + ":0"});
+    EXPECT_EQ(std::set<string>({"x", name}), NodeNames(*client_graph));
+  }
+
+  GraphDef again;
+  Build({}, {"z:0"})->graph.ToGraphDef(&again);
+  TF_EXPECT_GRAPH_EQ(first, again);
+}
+
+}  // namespace
+}  // namespace tensorflow
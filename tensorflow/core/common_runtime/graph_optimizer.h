@@ -48,8 +48,17 @@ class GraphOptimizer {
       const std::unordered_map<string, std::vector<PartialTensorShape>>*
           shape_map);
 
+  // If 'runner' is not nullptr, constant folding evaluates independent
+  // constant subgraphs concurrently using 'runner'. See
+  // ConstantFoldingOptions::runner.
+  typedef std::function<void(std::function<void()>)> Runner;
+  void set_constant_folding_runner(Runner runner) {
+    constant_folding_runner_ = std::move(runner);
+  }
+
  private:
   OptimizerOptions opts_;
+  Runner constant_folding_runner_ = nullptr;
 
   TF_DISALLOW_COPY_AND_ASSIGN(GraphOptimizer);
 };
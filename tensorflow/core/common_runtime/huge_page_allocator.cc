@@ -0,0 +1,146 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/huge_page_allocator.h"
+
+#include <unistd.h>
+#include <algorithm>
+
+#include "tensorflow/core/framework/allocator_registry.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+namespace {
+
+size_t RoundUp(size_t num_bytes, size_t multiple) {
+  return (num_bytes + multiple - 1) / multiple * multiple;
+}
+
+}  // namespace
+
+HugePageSubAllocator::HugePageSubAllocator(int numa_node,
+                                           size_t huge_page_size)
+    : numa_node_(numa_node), huge_page_size_(huge_page_size) {
+  CHECK_GT(huge_page_size, 0);
+}
+
+HugePageSubAllocator::~HugePageSubAllocator() {
+  for (const Arena& arena : arenas_) {
+    port::NUMAHugePageFree(arena.base, arena.size);
+  }
+}
+
+void* HugePageSubAllocator::Alloc(size_t alignment, size_t num_bytes) {
+  alignment = std::max(alignment, Allocator::kAllocatorAlignment);
+  mutex_lock l(mu_);
+  if (!arenas_.empty()) {
+    Arena& arena = arenas_.back();
+    const size_t offset = RoundUp(arena.used, alignment);
+    if (offset + num_bytes <= arena.size) {
+      arena.used = offset + num_bytes;
+      return arena.base + offset;
+    }
+  }
+  // The rest of the last arena is only used by later, smaller regions.
+  Arena arena;
+  arena.size = RoundUp(std::max<size_t>(num_bytes, 1), huge_page_size_);
+  arena.base = static_cast<char*>(
+      port::NUMAHugePageMalloc(numa_node_, arena.size, huge_page_size_));
+  if (arena.base == nullptr) return nullptr;
+  arena.used = num_bytes;
+  VLOG(1) << "Mapped a huge page arena of " << arena.size << " bytes at "
+          << static_cast<void*>(arena.base) << " on NUMA node " << numa_node_;
+  arenas_.push_back(arena);
+  return arena.base;
+}
+
+void HugePageSubAllocator::Free(void* ptr, size_t num_bytes) {
+  mutex_lock l(mu_);
+  if (arenas_.empty()) return;
+  Arena& arena = arenas_.back();
+  if (static_cast<char*>(ptr) + num_bytes == arena.base + arena.used) {
+    arena.used = static_cast<char*>(ptr) - arena.base;
+  }
+}
+
+size_t HugePageSubAllocator::arena_bytes() {
+  mutex_lock l(mu_);
+  size_t bytes = 0;
+  for (const Arena& arena : arenas_) bytes += arena.size;
+  return bytes;
+}
+
+BFCAllocator* NewHugePageCPUAllocator(int numa_node, size_t huge_page_size,
+                                      size_t memory_limit,
+                                      size_t thread_cache_bytes) {
+  string name = "huge_page_cpu";
+  if (numa_node != port::kNUMANoAffinity) {
+    strings::StrAppend(&name, "_numa_", numa_node);
+  }
+  BFCAllocator* allocator =
+      new BFCAllocator(new HugePageSubAllocator(numa_node, huge_page_size),
+                       memory_limit, true /*allow_growth*/, name);
+  allocator->SetThreadCacheBytes(thread_cache_bytes);
+  return allocator;
+}
+
+namespace {
+
+// Creates the allocators selected with ConfigProto.Experimental.
+// cpu_allocator.  Their limit defaults to the physical memory of the
+// machine, and can be set with TF_CPU_HUGE_PAGE_ALLOCATOR_MAX_BYTES.
+template <size_t kHugePageSize>
+class HugePageCPUAllocatorFactory : public AllocatorFactory {
+ public:
+  Allocator* CreateAllocator(int numa_node) override {
+    int64 default_memory_limit = 64LL << 30;
+#if defined(_SC_PHYS_PAGES) && defined(_SC_PAGESIZE)
+    default_memory_limit =
+        static_cast<int64>(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGESIZE);
+#endif
+    int64 memory_limit;
+    Status s = ReadInt64FromEnvVar("TF_CPU_HUGE_PAGE_ALLOCATOR_MAX_BYTES",
+                                   default_memory_limit, &memory_limit);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return nullptr;
+    }
+    int64 thread_cache_bytes;
+    s = ReadInt64FromEnvVar("TF_CPU_HUGE_PAGE_ALLOCATOR_THREAD_CACHE_BYTES",
+                            256 << 10, &thread_cache_bytes);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return nullptr;
+    }
+    return NewHugePageCPUAllocator(numa_node, kHugePageSize, memory_limit,
+                                   std::max<int64>(0, thread_cache_bytes));
+  }
+};
+
+typedef HugePageCPUAllocatorFactory<size_t{2} << 20>
+    HugePage2MBCPUAllocatorFactory;
+typedef HugePageCPUAllocatorFactory<size_t{1} << 30>
+    HugePage1GBCPUAllocatorFactory;
+
+REGISTER_MEM_ALLOCATOR_FACTORY("huge_page_2mb", HugePage2MBCPUAllocatorFactory);
+REGISTER_MEM_ALLOCATOR_FACTORY("huge_page_1gb", HugePage1GBCPUAllocatorFactory);
+
+}  // namespace
+
+}  // namespace tensorflow
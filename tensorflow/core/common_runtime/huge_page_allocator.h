@@ -0,0 +1,74 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_HUGE_PAGE_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_HUGE_PAGE_ALLOCATOR_H_
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A SubAllocator that carves the regions of a BFCAllocator out of arenas
+// of huge pages, preferably on one NUMA node.  Consecutive regions share
+// an arena while they fit, so that the small first regions of a growing
+// BFCAllocator do not each take a whole huge page.  The arenas are
+// returned to the system when the sub-allocator is destroyed.
+class HugePageSubAllocator : public SubAllocator {
+ public:
+  // 'numa_node' may be port::kNUMANoAffinity.
+  HugePageSubAllocator(int numa_node, size_t huge_page_size);
+  ~HugePageSubAllocator() override;
+
+  void* Alloc(size_t alignment, size_t num_bytes) override;
+
+  // Only rewinds the arena if 'ptr' is the last region carved out of it.
+  void Free(void* ptr, size_t num_bytes) override;
+
+  // The number of bytes of all arenas.
+  size_t arena_bytes();
+
+ private:
+  struct Arena {
+    char* base;
+    size_t size;
+    size_t used;
+  };
+
+  const int numa_node_;
+  const size_t huge_page_size_;
+  mutex mu_;
+  std::vector<Arena> arenas_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(HugePageSubAllocator);
+};
+
+// Returns a BFCAllocator of up to 'memory_limit' bytes whose memory comes
+// from huge pages of 'huge_page_size' bytes on 'numa_node'.  Its bins,
+// together with per-thread caches of up to 'thread_cache_bytes' for small
+// chunks, act as size-class free lists.
+BFCAllocator* NewHugePageCPUAllocator(int numa_node, size_t huge_page_size,
+                                      size_t memory_limit,
+                                      size_t thread_cache_bytes);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_HUGE_PAGE_ALLOCATOR_H_
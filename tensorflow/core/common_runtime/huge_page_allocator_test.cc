@@ -0,0 +1,98 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/huge_page_allocator.h"
+
+#include <string.h>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator_registry.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr size_t kHugePageSize = 2 << 20;
+
+TEST(HugePageSubAllocator, RegionsShareArenas) {
+  HugePageSubAllocator sub_allocator(port::kNUMANoAffinity, kHugePageSize);
+  char* a = static_cast<char*>(sub_allocator.Alloc(32, 1 << 20));
+  ASSERT_NE(nullptr, a);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(a) % kHugePageSize);
+  memset(a, 1, 1 << 20);
+
+  // Fits in the rest of the first arena.
+  char* b = static_cast<char*>(sub_allocator.Alloc(32, 512 << 10));
+  EXPECT_EQ(a + (1 << 20), b);
+  EXPECT_EQ(kHugePageSize, sub_allocator.arena_bytes());
+
+  // Needs a new arena of whole huge pages.
+  char* c = static_cast<char*>(sub_allocator.Alloc(32, 3 << 20));
+  ASSERT_NE(nullptr, c);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(c) % kHugePageSize);
+  memset(c, 1, 3 << 20);
+  EXPECT_EQ(3 * kHugePageSize, sub_allocator.arena_bytes());
+
+  // Freeing the last region of the last arena rewinds it.
+  sub_allocator.Free(c, 3 << 20);
+  EXPECT_EQ(c, sub_allocator.Alloc(32, 1 << 20));
+}
+
+TEST(HugePageCPUAllocator, AllocatesAlignedMemory) {
+  std::unique_ptr<Allocator> allocator(NewHugePageCPUAllocator(
+      port::kNUMANoAffinity, kHugePageSize, 64 << 20, 64 << 10));
+  EXPECT_EQ("huge_page_cpu", allocator->Name());
+  std::vector<void*> ptrs;
+  for (size_t size : {size_t{4}, size_t{1000}, size_t{16} << 10,
+                      size_t{5} << 20}) {
+    void* p = allocator->AllocateRaw(64, size);
+    ASSERT_NE(nullptr, p);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(p) % 64);
+    memset(p, 0, size);
+    ptrs.push_back(p);
+  }
+  for (void* p : ptrs) allocator->DeallocateRaw(p);
+
+  // A small chunk is reused from the thread cache.
+  void* p = allocator->AllocateRaw(64, 1000);
+  allocator->DeallocateRaw(p);
+  EXPECT_EQ(p, allocator->AllocateRaw(64, 1000));
+  allocator->DeallocateRaw(p);
+  AllocatorStats stats;
+  allocator->GetStats(&stats);
+  EXPECT_GT(stats.num_thread_cache_hits, 0);
+}
+
+TEST(HugePageCPUAllocator, Registry) {
+  AllocatorRegistry* registry = AllocatorRegistry::Global();
+  Allocator* allocator =
+      registry->GetAllocator("huge_page_2mb", port::kNUMANoAffinity);
+  ASSERT_NE(nullptr, allocator);
+  EXPECT_EQ("huge_page_cpu", allocator->Name());
+  EXPECT_EQ(allocator,
+            registry->GetAllocator("huge_page_2mb", port::kNUMANoAffinity));
+  EXPECT_EQ(nullptr, registry->GetAllocator("no_such_allocator",
+                                            port::kNUMANoAffinity));
+  if (port::NUMAEnabled()) {
+    Allocator* node_allocator = registry->GetAllocator("huge_page_2mb", 0);
+    ASSERT_NE(nullptr, node_allocator);
+    EXPECT_EQ("huge_page_cpu_numa_0", node_allocator->Name());
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
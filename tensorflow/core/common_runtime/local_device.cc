@@ -18,10 +18,13 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/local_device.h"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/common_runtime/eigen_thread_pool.h"
+#include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/cpu_feature_guard.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session_options.h"
 
@@ -31,17 +34,30 @@ namespace tensorflow {
 bool LocalDevice::use_global_threadpool_ = true;
 
 struct LocalDevice::EigenThreadPoolInfo {
-  explicit EigenThreadPoolInfo(const SessionOptions& options) {
+  // If 'numa_node' is not port::kNUMANoAffinity, the threads are pinned to
+  // that node and share the intra-op threads with the other nodes.
+  EigenThreadPoolInfo(const SessionOptions& options, int numa_node) {
     int32 intra_op_parallelism_threads =
         options.config.intra_op_parallelism_threads();
-    if (intra_op_parallelism_threads == 0) {
+    if (numa_node != port::kNUMANoAffinity) {
+      if (intra_op_parallelism_threads == 0) {
+        intra_op_parallelism_threads = port::NUMANumNodeCPUs(numa_node);
+      } else {
+        intra_op_parallelism_threads = std::max(
+            1, intra_op_parallelism_threads / port::NUMANumNodes());
+      }
+    } else if (intra_op_parallelism_threads == 0) {
       intra_op_parallelism_threads = port::NumSchedulableCPUs();
     }
     VLOG(1) << "Local device intra op parallelism threads: "
-            << intra_op_parallelism_threads;
+            << intra_op_parallelism_threads << " (NUMA node " << numa_node
+            << ")";
+    ThreadOptions thread_options;
+    thread_options.numa_node = numa_node;
     eigen_worker_threads_.num_threads = intra_op_parallelism_threads;
-    eigen_worker_threads_.workers = new thread::ThreadPool(
-        options.env, "Eigen", intra_op_parallelism_threads);
+    eigen_worker_threads_.workers =
+        new thread::ThreadPool(options.env, thread_options, "Eigen",
+                               intra_op_parallelism_threads);
     eigen_threadpool_wrapper_.reset(
         new EigenThreadPoolWrapper(eigen_worker_threads_.workers));
     eigen_device_.reset(new Eigen::ThreadPoolDevice(
@@ -65,19 +81,46 @@ LocalDevice::LocalDevice(const SessionOptions& options,
   // Log info messages if TensorFlow is not compiled with instructions that
   // could speed up performance and are available on the current CPU.
   port::InfoAboutUnusedCPUFeatures();
+  int numa_node = port::kNUMANoAffinity;
+  if (options.config.experimental().use_numa_affinity() &&
+      attributes.device_type() == DEVICE_CPU && port::NUMAEnabled()) {
+    numa_node = attributes.locality().numa_node();
+    if (numa_node < 0 || numa_node >= port::NUMANumNodes()) {
+      numa_node = port::kNUMANoAffinity;
+    }
+  }
+
   LocalDevice::EigenThreadPoolInfo* tp_info;
-  if (use_global_threadpool_) {
+  if (use_global_threadpool_ && numa_node != port::kNUMANoAffinity) {
+    // All ThreadPoolDevices bound to the same NUMA node will use a single
+    // fixed sized threadpool pinned to that node.
+    static mutex* numa_mu = new mutex;
+    static std::vector<LocalDevice::EigenThreadPoolInfo*>* numa_tp_infos =
+        new std::vector<LocalDevice::EigenThreadPoolInfo*>(
+            port::NUMANumNodes(), nullptr);
+    mutex_lock l(*numa_mu);
+    LocalDevice::EigenThreadPoolInfo*& numa_tp_info =
+        (*numa_tp_infos)[numa_node];
+    if (numa_tp_info == nullptr) {
+      numa_tp_info = new LocalDevice::EigenThreadPoolInfo(options, numa_node);
+    }
+    tp_info = numa_tp_info;
+  } else if (use_global_threadpool_) {
     // All ThreadPoolDevices in the process will use this single fixed
     // sized threadpool for numerical computations.
     static LocalDevice::EigenThreadPoolInfo* global_tp_info =
-        new LocalDevice::EigenThreadPoolInfo(options);
+        new LocalDevice::EigenThreadPoolInfo(options, port::kNUMANoAffinity);
     tp_info = global_tp_info;
   } else {
     // Each LocalDevice owns a separate ThreadPoolDevice for numerical
     // computations.
-    owned_tp_info_.reset(new LocalDevice::EigenThreadPoolInfo(options));
+    owned_tp_info_.reset(
+        new LocalDevice::EigenThreadPoolInfo(options, numa_node));
     tp_info = owned_tp_info_.get();
   }
+  if (options.config.experimental().thread_pool_stats()) {
+    tp_info->eigen_worker_threads_.workers->SetCollectStats(true);
+  }
   set_tensorflow_cpu_worker_threads(&tp_info->eigen_worker_threads_);
   set_eigen_cpu_device(tp_info->eigen_device_.get());
 }
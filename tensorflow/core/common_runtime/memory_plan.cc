@@ -0,0 +1,195 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_plan.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+int64 AlignedSize(int64 size) {
+  return (size + MemoryPlan::kAlignment - 1) / MemoryPlan::kAlignment *
+         MemoryPlan::kAlignment;
+}
+
+bool LiveRangesOverlap(const MemoryPlanBuffer& a, const MemoryPlanBuffer& b) {
+  return a.first_use <= b.last_use && b.first_use <= a.last_use;
+}
+
+}  // namespace
+
+constexpr int64 MemoryPlan::kAlignment;
+
+MemoryPlan::MemoryPlan(const std::vector<MemoryPlanBuffer>& buffers)
+    : buffers_(buffers),
+      offsets_(buffers.size(), 0),
+      conflicts_(buffers.size()) {
+  const int n = buffers_.size();
+  std::vector<int> order(n);
+  for (int i = 0; i < n; ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+    return buffers_[a].size > buffers_[b].size;
+  });
+
+  std::vector<int> placed;
+  std::vector<std::pair<int64, int64>> busy;
+  for (int i : order) {
+    const int64 size = AlignedSize(buffers_[i].size);
+    if (size == 0) continue;
+
+    // The memory used by already placed buffers that are live at the same
+    // time as buffer i.
+    busy.clear();
+    for (int p : placed) {
+      if (LiveRangesOverlap(buffers_[i], buffers_[p])) {
+        busy.emplace_back(offsets_[p],
+                          offsets_[p] + AlignedSize(buffers_[p].size));
+      }
+    }
+    std::sort(busy.begin(), busy.end());
+
+    // Best fit among the gaps, or the end of the busy memory.
+    int64 cursor = 0;
+    int64 best_offset = -1;
+    int64 best_gap = std::numeric_limits<int64>::max();
+    for (const auto& range : busy) {
+      const int64 gap = range.first - cursor;
+      if (gap >= size && gap < best_gap) {
+        best_offset = cursor;
+        best_gap = gap;
+      }
+      cursor = std::max(cursor, range.second);
+    }
+    offsets_[i] = best_offset >= 0 ? best_offset : cursor;
+    slab_size_ = std::max(slab_size_, offsets_[i] + size);
+    placed.push_back(i);
+  }
+
+  // Sweep the placed buffers by offset to find those sharing memory.
+  std::sort(placed.begin(), placed.end(),
+            [this](int a, int b) { return offsets_[a] < offsets_[b]; });
+  for (size_t a = 0; a < placed.size(); ++a) {
+    const int i = placed[a];
+    const int64 end = offsets_[i] + AlignedSize(buffers_[i].size);
+    for (size_t b = a + 1; b < placed.size() && offsets_[placed[b]] < end;
+         ++b) {
+      const int j = placed[b];
+      DCHECK(!LiveRangesOverlap(buffers_[i], buffers_[j]));
+      conflicts_[i].push_back(j);
+      conflicts_[j].push_back(i);
+    }
+  }
+}
+
+class MemoryPlanSlab::SlotAllocator : public Allocator {
+ public:
+  SlotAllocator(MemoryPlanSlab* slab, int index)
+      : slab_(slab),
+        index_(index),
+        size_(slab->plan_->buffer(index).size),
+        memory_(slab->memory_ == nullptr || size_ == 0
+                    ? nullptr
+                    : slab->memory_ + slab->plan_->offset(index)) {}
+
+  string Name() override { return "memory_plan_slab"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    requested_bytes_.store(num_bytes, std::memory_order_relaxed);
+    // Every allocation keeps the slab, and thus this allocator, alive.
+    slab_->Ref();
+    void* ptr;
+    if (CanUseSlab(alignment, num_bytes)) {
+      in_use_.store(true, std::memory_order_relaxed);
+      ptr = memory_;
+    } else {
+      ptr = slab_->base_->AllocateRaw(alignment, num_bytes);
+    }
+    // The step using the slab holds a reference, so this is not the last.
+    if (ptr == nullptr) slab_->Unref();
+    return ptr;
+  }
+
+  void DeallocateRaw(void* ptr) override {
+    if (ptr != nullptr && ptr == memory_) {
+      in_use_.store(false, std::memory_order_release);
+    } else {
+      slab_->base_->DeallocateRaw(ptr);
+    }
+    // May delete this allocator.
+    slab_->Unref();
+  }
+
+  bool in_use() const { return in_use_.load(std::memory_order_acquire); }
+
+  size_t requested_bytes() const {
+    return requested_bytes_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  // Only the step using the slab allocates from it, so no other slot can
+  // start using conflicting memory concurrently. Other threads may only
+  // release it.
+  bool CanUseSlab(size_t alignment, size_t num_bytes) const {
+    if (memory_ == nullptr || num_bytes > size_ ||
+        alignment > MemoryPlan::kAlignment || in_use()) {
+      return false;
+    }
+    for (int j : slab_->plan_->conflicts(index_)) {
+      if (slab_->slots_[j]->in_use()) return false;
+    }
+    return true;
+  }
+
+  MemoryPlanSlab* const slab_;
+  const int index_;
+  const size_t size_;
+  char* const memory_;
+  std::atomic<bool> in_use_{false};
+  std::atomic<size_t> requested_bytes_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SlotAllocator);
+};
+
+MemoryPlanSlab::MemoryPlanSlab(std::shared_ptr<const MemoryPlan> plan,
+                               Allocator* base)
+    : plan_(std::move(plan)),
+      base_(base),
+      memory_(plan_->slab_size() > 0
+                  ? static_cast<char*>(base_->AllocateRaw(
+                        MemoryPlan::kAlignment, plan_->slab_size()))
+                  : nullptr) {
+  slots_.reserve(plan_->num_buffers());
+  for (int i = 0; i < plan_->num_buffers(); ++i) {
+    slots_.emplace_back(new SlotAllocator(this, i));
+  }
+}
+
+MemoryPlanSlab::~MemoryPlanSlab() {
+  if (memory_ != nullptr) base_->DeallocateRaw(memory_);
+}
+
+Allocator* MemoryPlanSlab::slot_allocator(int i) { return slots_[i].get(); }
+
+size_t MemoryPlanSlab::requested_bytes(int i) const {
+  return slots_[i]->requested_bytes();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,101 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_PLAN_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_PLAN_H_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A buffer of a MemoryPlan. Its live range [first_use, last_use] is given
+// in terms of the positions of the nodes in a fixed execution order.
+struct MemoryPlanBuffer {
+  int64 size = 0;
+  int first_use = 0;
+  int last_use = 0;
+};
+
+// Assigns offsets in a single slab to buffers whose sizes and live ranges
+// are known in advance, so that buffers with overlapping live ranges never
+// overlap in memory. Buffers are placed in order of decreasing size, each
+// in the smallest gap that fits it, like XLA's heap simulator.
+class MemoryPlan {
+ public:
+  // Offsets are multiples of kAlignment.
+  static constexpr int64 kAlignment = Allocator::kAllocatorAlignment;
+
+  explicit MemoryPlan(const std::vector<MemoryPlanBuffer>& buffers);
+
+  int num_buffers() const { return buffers_.size(); }
+  const MemoryPlanBuffer& buffer(int i) const { return buffers_[i]; }
+  int64 offset(int i) const { return offsets_[i]; }
+
+  // The indices of the buffers whose memory overlaps that of buffer i.
+  const std::vector<int>& conflicts(int i) const { return conflicts_[i]; }
+
+  // The total number of bytes needed by the plan.
+  int64 slab_size() const { return slab_size_; }
+
+ private:
+  std::vector<MemoryPlanBuffer> buffers_;
+  std::vector<int64> offsets_;
+  std::vector<std::vector<int>> conflicts_;
+  int64 slab_size_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryPlan);
+};
+
+// The memory of a MemoryPlan. A slab must be used by at most one step at a
+// time, but tensors allocated from it may outlive the step.
+//
+// slot_allocator(i) allocates buffer i from the slab. An allocation falls
+// back to the base allocator if it is larger than planned, or if the memory
+// of buffer i is still used by a tensor that outlived its planned live
+// range, e.g. a fetched output of a previous step. The slab memory is
+// released once the slab and all tensors allocated from it are gone.
+class MemoryPlanSlab : public core::RefCounted {
+ public:
+  MemoryPlanSlab(std::shared_ptr<const MemoryPlan> plan, Allocator* base);
+
+  Allocator* slot_allocator(int i);
+
+  // The number of bytes last requested from slot_allocator(i), or 0 if it
+  // was never used.
+  size_t requested_bytes(int i) const;
+
+ private:
+  class SlotAllocator;
+
+  ~MemoryPlanSlab() override;
+
+  const std::shared_ptr<const MemoryPlan> plan_;
+  Allocator* const base_;
+  char* const memory_;
+  std::vector<std::unique_ptr<SlotAllocator>> slots_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryPlanSlab);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_MEMORY_PLAN_H_
@@ -0,0 +1,110 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_plan.h"
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+MemoryPlanBuffer Buffer(int64 size, int first_use, int last_use) {
+  MemoryPlanBuffer buffer;
+  buffer.size = size;
+  buffer.first_use = first_use;
+  buffer.last_use = last_use;
+  return buffer;
+}
+
+TEST(MemoryPlan, DisjointLiveRangesShareMemory) {
+  std::shared_ptr<const MemoryPlan> plan(new MemoryPlan(
+      {Buffer(100, 0, 1), Buffer(100, 2, 3), Buffer(10, 1, 2)}));
+  EXPECT_EQ(plan->offset(0), plan->offset(1));
+  EXPECT_NE(plan->offset(0), plan->offset(2));
+  EXPECT_EQ(std::vector<int>({1}), plan->conflicts(0));
+  EXPECT_EQ(std::vector<int>({0}), plan->conflicts(1));
+  EXPECT_TRUE(plan->conflicts(2).empty());
+  EXPECT_EQ(128 + MemoryPlan::kAlignment, plan->slab_size());
+}
+
+TEST(MemoryPlan, BestFit) {
+  // When buffer 5 is live, buffers 1 and 3 are dead and leave gaps of 512
+  // and 256 bytes. Buffer 5 goes in the smaller one.
+  std::shared_ptr<const MemoryPlan> plan(new MemoryPlan(
+      {Buffer(1024, 0, 4), Buffer(512, 0, 1), Buffer(256, 0, 4),
+       Buffer(256, 0, 1), Buffer(128, 0, 4), Buffer(200, 2, 3)}));
+  EXPECT_EQ(plan->offset(3), plan->offset(5));
+  EXPECT_EQ(1024 + 512 + 256 + 256 + 128, plan->slab_size());
+}
+
+TEST(MemoryPlan, RandomBuffersDoNotOverlap) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  std::vector<MemoryPlanBuffer> buffers;
+  for (int i = 0; i < 200; ++i) {
+    const int first_use = rnd.Uniform(100);
+    buffers.push_back(
+        Buffer(rnd.Uniform(4096), first_use, first_use + rnd.Uniform(20)));
+  }
+  MemoryPlan plan(buffers);
+  for (int i = 0; i < plan.num_buffers(); ++i) {
+    EXPECT_EQ(0, plan.offset(i) % MemoryPlan::kAlignment);
+    EXPECT_LE(plan.offset(i) + buffers[i].size, plan.slab_size());
+    for (int j = i + 1; j < plan.num_buffers(); ++j) {
+      const bool live_at_once = buffers[i].first_use <= buffers[j].last_use &&
+                                buffers[j].first_use <= buffers[i].last_use;
+      const bool share_memory =
+          plan.offset(i) < plan.offset(j) + buffers[j].size &&
+          plan.offset(j) < plan.offset(i) + buffers[i].size;
+      EXPECT_FALSE(live_at_once && share_memory) << i << " " << j;
+    }
+  }
+}
+
+TEST(MemoryPlanSlab, AllocatesFromSlab) {
+  std::shared_ptr<const MemoryPlan> plan(
+      new MemoryPlan({Buffer(64, 0, 0), Buffer(64, 1, 1)}));
+  MemoryPlanSlab* slab = new MemoryPlanSlab(plan, cpu_allocator());
+  const void* slab_data;
+  {
+    Tensor a(slab->slot_allocator(0), DT_FLOAT, TensorShape({16}));
+    slab_data = a.tensor_data().data();
+    EXPECT_EQ(64, slab->requested_bytes(0));
+
+    // The memory of slot 0 is still used by 'a'.
+    Tensor b(slab->slot_allocator(1), DT_FLOAT, TensorShape({16}));
+    EXPECT_NE(slab_data, b.tensor_data().data());
+  }
+  {
+    Tensor b(slab->slot_allocator(1), DT_FLOAT, TensorShape({16}));
+    EXPECT_EQ(slab_data, b.tensor_data().data());
+
+    // Larger than planned.
+    Tensor a(slab->slot_allocator(0), DT_FLOAT, TensorShape({32}));
+    EXPECT_NE(slab_data, a.tensor_data().data());
+    EXPECT_EQ(128, slab->requested_bytes(0));
+  }
+
+  // Tensors keep the slab alive.
+  Tensor a(slab->slot_allocator(0), DT_FLOAT, TensorShape({16}));
+  a.flat<float>().setConstant(1.0f);
+  slab->Unref();
+  EXPECT_EQ(1.0f, a.flat<float>()(15));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,83 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/priority_scheduler.h"
+
+#include <unordered_map>
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+mutex* SchedulersMutex() {
+  static mutex* const mu = new mutex;
+  return mu;
+}
+
+std::unordered_map<thread::ThreadPool*, PriorityScheduler*>* Schedulers() {
+  static std::unordered_map<thread::ThreadPool*, PriorityScheduler*>* const
+      schedulers =
+          new std::unordered_map<thread::ThreadPool*, PriorityScheduler*>;
+  return schedulers;
+}
+
+}  // namespace
+
+PriorityScheduler::PriorityScheduler(thread::ThreadPool* pool) : pool_(pool) {}
+
+/* static */
+PriorityScheduler* PriorityScheduler::ForPool(thread::ThreadPool* pool) {
+  mutex_lock l(*SchedulersMutex());
+  PriorityScheduler*& scheduler = (*Schedulers())[pool];
+  if (scheduler == nullptr) scheduler = new PriorityScheduler(pool);
+  return scheduler;
+}
+
+/* static */
+void PriorityScheduler::RemovePool(thread::ThreadPool* pool) {
+  mutex_lock l(*SchedulersMutex());
+  auto it = Schedulers()->find(pool);
+  if (it == Schedulers()->end()) return;
+  delete it->second;
+  Schedulers()->erase(it);
+}
+
+void PriorityScheduler::Schedule(int priority, std::function<void()> fn) {
+  {
+    mutex_lock l(mu_);
+    queues_[priority].push_back(std::move(fn));
+  }
+  // Each closure adds one task to the pool, which runs whichever closure
+  // comes first when the task starts.
+  pool_->Schedule([this]() { RunNext(); });
+}
+
+void PriorityScheduler::RunNext() {
+  std::function<void()> fn;
+  {
+    mutex_lock l(mu_);
+    CHECK(!queues_.empty());
+    auto it = queues_.begin();
+    fn = std::move(it->second.front());
+    it->second.pop_front();
+    if (it->second.empty()) queues_.erase(it);
+  }
+  fn();
+}
+
+}  // namespace tensorflow
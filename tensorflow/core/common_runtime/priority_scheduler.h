@@ -0,0 +1,71 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_PRIORITY_SCHEDULER_H_
+#define TENSORFLOW_COMMON_RUNTIME_PRIORITY_SCHEDULER_H_
+
+#include <deque>
+#include <functional>
+#include <map>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// Runs closures on a thread pool in order of priority: whenever a thread of
+// the pool becomes free, it runs the oldest of the closures with the highest
+// priority.  Running closures are not interrupted, so for executors, steps
+// with a higher priority overtake steps with a lower priority at node
+// boundaries.
+//
+// Closures only overtake those scheduled through the same PriorityScheduler,
+// so all the users of a pool should share one, e.g. with ForPool().
+//
+// This class is thread-safe.
+class PriorityScheduler {
+ public:
+  explicit PriorityScheduler(thread::ThreadPool* pool);
+
+  // Returns the scheduler shared by all users of "pool".
+  static PriorityScheduler* ForPool(thread::ThreadPool* pool);
+
+  // Deletes the scheduler of "pool", if any.  Must be called after the pool
+  // ran all its work, e.g. after it was deleted, and before a new pool that
+  // may have the same address is used.
+  static void RemovePool(thread::ThreadPool* pool);
+
+  // Runs "fn" after the closures with higher priorities, and after those
+  // scheduled earlier with the same priority.
+  void Schedule(int priority, std::function<void()> fn);
+
+ private:
+  // Runs the first closure of the queue with the highest priority.
+  void RunNext();
+
+  thread::ThreadPool* const pool_;
+  mutex mu_;
+  // By decreasing priority.
+  std::map<int, std::deque<std::function<void()>>, std::greater<int>> queues_
+      GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PriorityScheduler);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_PRIORITY_SCHEDULER_H_
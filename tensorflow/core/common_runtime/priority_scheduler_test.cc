@@ -0,0 +1,69 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/priority_scheduler.h"
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(PriorityScheduler, RunsHigherPrioritiesFirst) {
+  thread::ThreadPool pool(Env::Default(), "test", 1);
+  PriorityScheduler scheduler(&pool);
+
+  // Keep the only thread busy while the other closures are queued.
+  Notification start;
+  scheduler.Schedule(0, [&start]() { start.WaitForNotification(); });
+
+  mutex mu;
+  std::vector<int> order;
+  BlockingCounter done(5);
+  auto record = [&mu, &order, &done](int id) {
+    return [&mu, &order, &done, id]() {
+      {
+        mutex_lock l(mu);
+        order.push_back(id);
+      }
+      done.DecrementCount();
+    };
+  };
+  scheduler.Schedule(0, record(1));
+  scheduler.Schedule(0, record(2));
+  scheduler.Schedule(10, record(3));
+  scheduler.Schedule(-1, record(4));
+  scheduler.Schedule(10, record(5));
+  start.Notify();
+  done.Wait();
+  EXPECT_EQ(std::vector<int>({3, 5, 1, 2, 4}), order);
+}
+
+TEST(PriorityScheduler, ForPool) {
+  thread::ThreadPool pool(Env::Default(), "test", 1);
+  PriorityScheduler* scheduler = PriorityScheduler::ForPool(&pool);
+  EXPECT_EQ(scheduler, PriorityScheduler::ForPool(&pool));
+  Notification done;
+  scheduler->Schedule(0, [&done]() { done.Notify(); });
+  done.WaitForNotification();
+  PriorityScheduler::RemovePool(&pool);
+}
+
+}  // namespace
+}  // namespace tensorflow
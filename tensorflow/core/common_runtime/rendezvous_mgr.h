@@ -57,12 +57,10 @@ class IntraProcessRendezvous : public Rendezvous {
 
  private:
   const DeviceMgr* device_mgr_;
-  Rendezvous* local_;  // Owns a Ref on this object.
-
-  mutable mutex mu_;
-
-  // Status given by StartAbort() if any.
-  Status status_ GUARDED_BY(mu_);
+  // Owns a Ref on this object. Aborting this rendezvous aborts local_, so
+  // Send() and RecvAsync() leave checking for aborts to local_ rather
+  // than taking a lock of their own.
+  Rendezvous* local_;
 
   ~IntraProcessRendezvous() override;
 
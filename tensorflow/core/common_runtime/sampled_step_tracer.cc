@@ -0,0 +1,190 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/sampled_step_tracer.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+
+namespace tensorflow {
+
+// A single-producer ring of events. Only the owning thread writes 'events'
+// and 'write_pos'; Drain() reads them and owns 'read_pos'.
+//
+// The reader does not synchronize with the writer on individual slots.
+// Instead it re-reads 'write_pos' after copying and discards the slots that
+// the writer may have overwritten in the meantime, like a seqlock.
+struct SampledStepTracer::Ring {
+  explicit Ring(int thread_index) : thread_index(thread_index) {}
+
+  const int thread_index;
+  std::atomic<uint64> write_pos{0};
+  uint64 read_pos = 0;  // Guarded by drain_mu_.
+  Event events[kRingCapacity];
+};
+
+constexpr int SampledStepTracer::kRingCapacity;
+
+SampledStepTracer::SampledStepTracer() {}
+
+SampledStepTracer::~SampledStepTracer() {}
+
+/* static */
+SampledStepTracer* SampledStepTracer::Global() {
+  static SampledStepTracer* const tracer = new SampledStepTracer;
+  return tracer;
+}
+
+uint32 SampledStepTracer::RegisterGraph(
+    const string& device_name, const std::vector<string>& node_names) {
+  mutex_lock l(mu_);
+  const uint32 graph_id = next_graph_id_++;
+  Graph* graph = &graphs_[graph_id];
+  graph->device_name = device_name;
+  graph->node_names = node_names;
+  return graph_id;
+}
+
+void SampledStepTracer::UnregisterGraph(uint32 graph_id) {
+  mutex_lock l(mu_);
+  auto it = graphs_.find(graph_id);
+  if (it != graphs_.end()) it->second.unregistered = true;
+}
+
+SampledStepTracer::Ring* SampledStepTracer::ThreadRing() {
+  // Returns the ring to the free list when the thread exits, so that
+  // threads that come and go do not grow the number of rings.
+  struct ThreadRingHolder {
+    ~ThreadRingHolder() {
+      if (ring != nullptr) tracer->ReleaseRing(ring);
+    }
+    SampledStepTracer* tracer = nullptr;
+    Ring* ring = nullptr;
+  };
+  static thread_local ThreadRingHolder holder;
+  if (holder.ring == nullptr) {
+    mutex_lock l(mu_);
+    if (!free_rings_.empty()) {
+      holder.ring = free_rings_.back();
+      free_rings_.pop_back();
+    } else {
+      rings_.emplace_back(new Ring(rings_.size()));
+      holder.ring = rings_.back().get();
+    }
+    holder.tracer = this;
+  }
+  return holder.ring;
+}
+
+void SampledStepTracer::ReleaseRing(Ring* ring) {
+  mutex_lock l(mu_);
+  free_rings_.push_back(ring);
+}
+
+void SampledStepTracer::Record(const Event& event) {
+  Ring* ring = ThreadRing();
+  const uint64 pos = ring->write_pos.load(std::memory_order_relaxed);
+  ring->events[pos % kRingCapacity] = event;
+  ring->write_pos.store(pos + 1, std::memory_order_release);
+}
+
+int64 SampledStepTracer::Drain(StepStats* step_stats) {
+  mutex_lock drain_lock(drain_mu_);
+  std::vector<Ring*> rings;
+  std::vector<uint32> unregistered_graphs;
+  {
+    mutex_lock l(mu_);
+    for (const auto& ring : rings_) rings.push_back(ring.get());
+    for (const auto& it : graphs_) {
+      if (it.second.unregistered) unregistered_graphs.push_back(it.first);
+    }
+  }
+
+  std::vector<std::pair<int, Event>> events;
+  int64 num_lost = 0;
+  for (Ring* ring : rings) {
+    const uint64 end = ring->write_pos.load(std::memory_order_acquire);
+    uint64 begin = ring->read_pos;
+    if (end - begin > kRingCapacity) {
+      num_lost += end - begin - kRingCapacity;
+      begin = end - kRingCapacity;
+    }
+    const size_t first = events.size();
+    for (uint64 pos = begin; pos < end; ++pos) {
+      events.emplace_back(ring->thread_index,
+                          ring->events[pos % kRingCapacity]);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // While the slots were copied, the writer may have been writing slot
+    // (after % kRingCapacity), and may have published everything before it.
+    const uint64 after = ring->write_pos.load(std::memory_order_relaxed);
+    uint64 valid_begin = begin;
+    if (after + 1 > begin + kRingCapacity) {
+      valid_begin = std::min(end, after + 1 - kRingCapacity);
+    }
+    num_lost += valid_begin - begin;
+    events.erase(events.begin() + first,
+                 events.begin() + first + (valid_begin - begin));
+    ring->read_pos = end;
+  }
+
+  mutex_lock l(mu_);
+  std::unordered_map<string, DeviceStepStats*> device_stats;
+  for (const auto& thread_and_event : events) {
+    const Event& event = thread_and_event.second;
+    auto graph_it = graphs_.find(event.graph_id);
+    if (graph_it == graphs_.end()) continue;
+    const Graph& graph = graph_it->second;
+    if (event.node_id < 0 || event.node_id >= graph.node_names.size()) {
+      continue;
+    }
+    DeviceStepStats*& dev_stats = device_stats[graph.device_name];
+    if (dev_stats == nullptr) {
+      dev_stats = step_stats->add_dev_stats();
+      dev_stats->set_device(graph.device_name);
+    }
+    NodeExecStats* ns = dev_stats->add_node_stats();
+    const string& node_name = graph.node_names[event.node_id];
+    ns->set_node_name(node_name);
+    ns->set_timeline_label(node_name);
+    ns->set_all_start_micros(event.all_start_micros);
+    ns->set_op_start_rel_micros(event.op_start_micros -
+                                event.all_start_micros);
+    ns->set_op_end_rel_micros(event.op_end_micros - event.all_start_micros);
+    ns->set_all_end_rel_micros(event.all_end_micros - event.all_start_micros);
+    ns->set_thread_id(thread_and_event.first);
+    if (event.has_memory) {
+      AllocatorMemoryUsed* memory = ns->add_memory();
+      memory->set_peak_bytes(event.peak_bytes);
+      memory->set_live_bytes(event.live_bytes);
+      MemoryStats* memory_stats = ns->mutable_memory_stats();
+      memory_stats->set_host_temp_memory_size(event.host_temp_bytes);
+      memory_stats->set_device_temp_memory_size(event.device_temp_bytes);
+      memory_stats->set_host_persistent_memory_size(
+          event.host_persistent_bytes);
+      memory_stats->set_device_persistent_memory_size(
+          event.device_persistent_bytes);
+    }
+  }
+  // Events of graphs unregistered before this call have all been read
+  // above, so their names are no longer needed.
+  for (uint32 graph_id : unregistered_graphs) {
+    graphs_.erase(graph_id);
+  }
+  return num_lost;
+}
+
+}  // namespace tensorflow
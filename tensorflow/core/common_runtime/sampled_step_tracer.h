@@ -0,0 +1,119 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_SAMPLED_STEP_TRACER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_SAMPLED_STEP_TRACER_H_
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+class StepStats;
+
+// SampledStepTracer is a low-overhead alternative to StepStatsCollector for
+// tracing a sample of steps in production.
+//
+// Executors record one fixed-size Event per traced node into a ring buffer
+// owned by the calling thread, without taking locks or allocating. Events
+// are turned into StepStats only when Drain() is called. If nobody drains
+// them, the oldest events of each thread are overwritten.
+//
+// Node and device names are registered once per executor with
+// RegisterGraph(), so that events only carry integer ids.
+class SampledStepTracer {
+ public:
+  struct Event {
+    int64 step_id;
+    int64 all_start_micros;
+    int64 op_start_micros;
+    int64 op_end_micros;
+    int64 all_end_micros;
+    uint32 graph_id;
+    int32 node_id;
+
+    // If true, the node tracked its allocations, and the sizes below are
+    // summed over all allocators it used.
+    bool has_memory;
+    int64 peak_bytes;
+    // The bytes still allocated when the node finished, e.g. its outputs.
+    int64 live_bytes;
+    int64 host_temp_bytes;
+    int64 device_temp_bytes;
+    int64 host_persistent_bytes;
+    int64 device_persistent_bytes;
+  };
+
+  // Number of events kept per thread.
+  static constexpr int kRingCapacity = 4096;
+
+  // Returns the process-wide tracer.
+  static SampledStepTracer* Global();
+
+  // Registers the graph of an executor on 'device_name', whose node with id
+  // i is named 'node_names[i]'. Returns the id to use in Event::graph_id.
+  uint32 RegisterGraph(const string& device_name,
+                       const std::vector<string>& node_names);
+
+  // Marks 'graph_id' as no longer used. Its names are deleted by the next
+  // Drain().
+  void UnregisterGraph(uint32 graph_id);
+
+  // Records 'event' in the calling thread's ring buffer. Lock-free.
+  void Record(const Event& event);
+
+  // Moves all events recorded since the last call into 'step_stats', with
+  // one DeviceStepStats per device. The memory of an event is reported as
+  // one AllocatorMemoryUsed with an empty allocator name, and MemoryStats. Returns the number of events that were
+  // overwritten before they could be drained.
+  int64 Drain(StepStats* step_stats);
+
+ private:
+  struct Ring;
+  struct Graph {
+    string device_name;
+    std::vector<string> node_names;
+    bool unregistered = false;
+  };
+
+  SampledStepTracer();
+  ~SampledStepTracer();
+
+  // Returns the ring of the calling thread, creating it if needed.
+  Ring* ThreadRing();
+  void ReleaseRing(Ring* ring);
+
+  mutex mu_;
+  std::vector<std::unique_ptr<Ring>> rings_ GUARDED_BY(mu_);
+  std::vector<Ring*> free_rings_ GUARDED_BY(mu_);
+  std::unordered_map<uint32, Graph> graphs_ GUARDED_BY(mu_);
+  uint32 next_graph_id_ GUARDED_BY(mu_) = 0;
+
+  // Serializes Drain() calls, which own the rings' read positions.
+  mutex drain_mu_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SampledStepTracer);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_SAMPLED_STEP_TRACER_H_
@@ -0,0 +1,157 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/sampled_step_tracer.h"
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+SampledStepTracer::Event MakeEvent(uint32 graph_id, int node_id,
+                                   int64 start) {
+  SampledStepTracer::Event event;
+  event.step_id = 1;
+  event.graph_id = graph_id;
+  event.node_id = node_id;
+  event.all_start_micros = start;
+  event.op_start_micros = start + 1;
+  event.op_end_micros = start + 3;
+  event.all_end_micros = start + 4;
+  event.has_memory = false;
+  return event;
+}
+
+TEST(SampledStepTracer, RecordAndDrain) {
+  SampledStepTracer* tracer = SampledStepTracer::Global();
+  StepStats discarded;
+  tracer->Drain(&discarded);
+
+  const uint32 graph_id = tracer->RegisterGraph("/cpu:0", {"a", "b"});
+  tracer->Record(MakeEvent(graph_id, 0, 100));
+  tracer->Record(MakeEvent(graph_id, 1, 200));
+  // Events with unknown node ids are dropped.
+  tracer->Record(MakeEvent(graph_id, 2, 300));
+
+  StepStats step_stats;
+  EXPECT_EQ(0, tracer->Drain(&step_stats));
+  ASSERT_EQ(1, step_stats.dev_stats_size());
+  const DeviceStepStats& dev_stats = step_stats.dev_stats(0);
+  EXPECT_EQ("/cpu:0", dev_stats.device());
+  ASSERT_EQ(2, dev_stats.node_stats_size());
+  EXPECT_EQ("a", dev_stats.node_stats(0).node_name());
+  EXPECT_EQ(100, dev_stats.node_stats(0).all_start_micros());
+  EXPECT_EQ(1, dev_stats.node_stats(0).op_start_rel_micros());
+  EXPECT_EQ(3, dev_stats.node_stats(0).op_end_rel_micros());
+  EXPECT_EQ(4, dev_stats.node_stats(0).all_end_rel_micros());
+  EXPECT_EQ("b", dev_stats.node_stats(1).node_name());
+
+  // Drained events are not returned again.
+  step_stats.Clear();
+  EXPECT_EQ(0, tracer->Drain(&step_stats));
+  EXPECT_EQ(0, step_stats.dev_stats_size());
+  tracer->UnregisterGraph(graph_id);
+}
+
+TEST(SampledStepTracer, Memory) {
+  SampledStepTracer* tracer = SampledStepTracer::Global();
+  StepStats discarded;
+  tracer->Drain(&discarded);
+
+  const uint32 graph_id = tracer->RegisterGraph("/cpu:0", {"a", "b"});
+  tracer->Record(MakeEvent(graph_id, 0, 100));
+  SampledStepTracer::Event event = MakeEvent(graph_id, 1, 200);
+  event.has_memory = true;
+  event.peak_bytes = 1024;
+  event.live_bytes = 256;
+  event.host_temp_bytes = 512;
+  event.device_temp_bytes = 0;
+  event.host_persistent_bytes = 64;
+  event.device_persistent_bytes = 0;
+  tracer->Record(event);
+
+  StepStats step_stats;
+  EXPECT_EQ(0, tracer->Drain(&step_stats));
+  ASSERT_EQ(1, step_stats.dev_stats_size());
+  const DeviceStepStats& dev_stats = step_stats.dev_stats(0);
+  ASSERT_EQ(2, dev_stats.node_stats_size());
+  EXPECT_EQ(0, dev_stats.node_stats(0).memory_size());
+  EXPECT_FALSE(dev_stats.node_stats(0).has_memory_stats());
+
+  const NodeExecStats& node_stats = dev_stats.node_stats(1);
+  ASSERT_EQ(1, node_stats.memory_size());
+  EXPECT_EQ(1024, node_stats.memory(0).peak_bytes());
+  EXPECT_EQ(256, node_stats.memory(0).live_bytes());
+  EXPECT_EQ(512, node_stats.memory_stats().host_temp_memory_size());
+  EXPECT_EQ(64, node_stats.memory_stats().host_persistent_memory_size());
+  tracer->UnregisterGraph(graph_id);
+}
+
+TEST(SampledStepTracer, Overwrite) {
+  SampledStepTracer* tracer = SampledStepTracer::Global();
+  StepStats discarded;
+  tracer->Drain(&discarded);
+
+  const uint32 graph_id = tracer->RegisterGraph("/cpu:0", {"a"});
+  const int num_events = SampledStepTracer::kRingCapacity + 10;
+  for (int i = 0; i < num_events; ++i) {
+    tracer->Record(MakeEvent(graph_id, 0, i));
+  }
+  // The oldest 10 events were overwritten. Drain() also drops the oldest
+  // remaining event of a full ring, whose slot a concurrent Record() could
+  // have been overwriting.
+  StepStats step_stats;
+  EXPECT_EQ(11, tracer->Drain(&step_stats));
+  ASSERT_EQ(1, step_stats.dev_stats_size());
+  const DeviceStepStats& dev_stats = step_stats.dev_stats(0);
+  ASSERT_EQ(SampledStepTracer::kRingCapacity - 1,
+            dev_stats.node_stats_size());
+  EXPECT_EQ(11, dev_stats.node_stats(0).all_start_micros());
+  tracer->UnregisterGraph(graph_id);
+}
+
+TEST(SampledStepTracer, ThreadsAndUnregister) {
+  SampledStepTracer* tracer = SampledStepTracer::Global();
+  StepStats discarded;
+  tracer->Drain(&discarded);
+
+  const uint32 graph_id = tracer->RegisterGraph("/cpu:0", {"a"});
+  {
+    std::unique_ptr<Thread> t1(Env::Default()->StartThread(
+        ThreadOptions(), "t1",
+        [tracer, graph_id]() { tracer->Record(MakeEvent(graph_id, 0, 1)); }));
+    std::unique_ptr<Thread> t2(Env::Default()->StartThread(
+        ThreadOptions(), "t2",
+        [tracer, graph_id]() { tracer->Record(MakeEvent(graph_id, 0, 2)); }));
+  }
+  // Events recorded before the graph is unregistered are still drained.
+  tracer->UnregisterGraph(graph_id);
+
+  StepStats step_stats;
+  EXPECT_EQ(0, tracer->Drain(&step_stats));
+  ASSERT_EQ(1, step_stats.dev_stats_size());
+  EXPECT_EQ(2, step_stats.dev_stats(0).node_stats_size());
+
+  // The names of the unregistered graph are gone.
+  tracer->Record(MakeEvent(graph_id, 0, 3));
+  step_stats.Clear();
+  tracer->Drain(&step_stats);
+  EXPECT_EQ(0, step_stats.dev_stats_size());
+}
+
+}  // namespace
+}  // namespace tensorflow
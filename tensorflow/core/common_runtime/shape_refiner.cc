@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/shape_refiner.h"
 
+#include <algorithm>
 #include <deque>
 #include <memory>
 #include <unordered_set>
@@ -29,6 +30,8 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/public/session.h"
 
 namespace tensorflow {
@@ -262,12 +265,54 @@ Status ShapeRefiner::AddNode(const Node* node) {
     return c->construction_status();
   }
 
+  uint64 fingerprint = 0;
+  const bool cacheable = cache_shape_inference_ &&
+                         !op_reg_data->is_function_op &&
+                         ShapeInferenceFingerprint(node, c.get(), &fingerprint);
+  if (cacheable) {
+    auto it = shape_inference_cache_.find(fingerprint);
+    if (it != shape_inference_cache_.end() &&
+        it->second.size() == c->num_outputs()) {
+      for (int i = 0; i < c->num_outputs(); ++i) {
+        ShapeHandle shape;
+        TF_RETURN_IF_ERROR(
+            c->MakeShapeFromPartialTensorShape(it->second[i], &shape));
+        c->set_output(i, shape);
+      }
+      node_to_context_[node].reset(
+          new ExtendedInferenceContext(std::move(c), node));
+      return Status::OK();
+    }
+  }
+
   std::unique_ptr<ExtendedInferenceContext> ec(
       new ExtendedInferenceContext(std::move(c), node));
 
   // Run the shape inference function, and return if there was an error.
   TF_RETURN_IF_ERROR(RunShapeFn(node, op_reg_data, ec.get()));
 
+  // Only cache shapes that the shape function inferred from the input
+  // shapes and attrs alone.
+  InferenceContext* ic = ec->get_context();
+  bool cache_result = cacheable;
+  for (int i = 0; cache_result && i < ic->num_inputs(); ++i) {
+    cache_result = !ic->requested_input_tensor(i) &&
+                   !ic->requested_input_tensor_as_partial_shape(i);
+  }
+  for (int i = 0; cache_result && i < ic->num_outputs(); ++i) {
+    cache_result = ic->output_handle_shapes_and_types(i) == nullptr;
+  }
+  if (cache_result) {
+    std::vector<PartialTensorShape>& shapes =
+        shape_inference_cache_[fingerprint];
+    shapes.resize(ic->num_outputs());
+    for (int i = 0; i < ic->num_outputs(); ++i) {
+      TensorShapeProto proto;
+      ic->ShapeHandleToProto(ic->output(i), &proto);
+      shapes[i] = PartialTensorShape(proto);
+    }
+  }
+
   // Store the resulting context object in the map.
   node_to_context_[node].swap(ec);
 
@@ -861,6 +906,44 @@ Status ShapeRefiner::RunShapeFn(const Node* node,
   return Status::OK();
 }
 
+bool ShapeRefiner::ShapeInferenceFingerprint(const Node* node,
+                                             InferenceContext* c,
+                                             uint64* fingerprint) const {
+  // Nodes without inputs, such as constants, have nothing to share, and their
+  // attrs can be large.
+  if (c->num_inputs() == 0) return false;
+  string key = strings::StrCat(node->type_string(), ";", graph_def_version_);
+  for (int i = 0; i < c->num_inputs(); ++i) {
+    ShapeHandle shape = c->input(i);
+    if (!c->FullyDefined(shape) ||
+        c->input_handle_shapes_and_types(i) != nullptr) {
+      return false;
+    }
+    strings::StrAppend(&key, ";", node->input_type(i), ":");
+    for (int d = 0; d < c->Rank(shape); ++d) {
+      strings::StrAppend(&key, c->Value(c->Dim(shape, d)), ",");
+    }
+  }
+  // Attrs in a deterministic order. Function attrs are left out, since the
+  // serialization of their attr maps is not deterministic.
+  std::vector<std::pair<StringPiece, const AttrValue*>> attrs;
+  for (const auto& attr : node->def().attr()) {
+    if (attr.second.has_func() || attr.second.list().func_size() > 0) {
+      return false;
+    }
+    attrs.emplace_back(attr.first, &attr.second);
+  }
+  std::sort(attrs.begin(), attrs.end());
+  string serialized;
+  for (const auto& attr : attrs) {
+    attr.second->SerializeToString(&serialized);
+    strings::StrAppend(&key, ";", attr.first, "=", serialized.size(), ":",
+                       serialized);
+  }
+  *fingerprint = Fingerprint64(key);
+  return true;
+}
+
 bool ShapeRefiner::SameDefinedShape(InferenceContext* c, ShapeHandle s0,
                                     ShapeHandle s1) {
   if (!c->RankKnown(s0)) {
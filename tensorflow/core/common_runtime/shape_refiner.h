@@ -15,11 +15,13 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CORE_COMMON_RUNTIME_SHAPE_REFINER_H_
 #define THIRD_PARTY_TENSORFLOW_CORE_COMMON_RUNTIME_SHAPE_REFINER_H_
 
+#include <unordered_map>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/graph_runner.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
@@ -154,6 +156,18 @@ class ShapeRefiner {
     disable_constant_propagation_ = disable;
   }
 
+  // If true, AddNode() remembers the output shapes that the shape function of
+  // a node infers from fully defined input shapes, keyed by a fingerprint of
+  // the op, its attrs and its input shapes, and gives later nodes with the
+  // same fingerprint (e.g. in duplicated subgraphs) those shapes without
+  // running their shape functions. Nodes whose shape functions depend on the
+  // values of their inputs, or on resource handle data, are not cached.
+  // Unknown output dimensions of a cached node are not the same handles as
+  // those of the node the shapes were inferred for.
+  void set_cache_shape_inference(bool cache) {
+    cache_shape_inference_ = cache;
+  }
+
   // Set function library to enable function shape inference.
   // Without function library, function inference always yields unknown shapes.
   // With this enabled, shape inference can take more time since it descends
@@ -260,6 +274,13 @@ class ShapeRefiner {
   Status RunShapeFn(const Node* node, const OpRegistrationData* op_reg_data,
                     ExtendedInferenceContext* ec);
 
+  // Sets *fingerprint to the key under which the output shapes of 'node',
+  // whose inputs are described by 'c', are cached. Returns false if they
+  // cannot be cached.
+  bool ShapeInferenceFingerprint(const Node* node,
+                                 shape_inference::InferenceContext* c,
+                                 uint64* fingerprint) const;
+
   // Destructive operation, which steals ownership of inference contexts map.
   std::unordered_map<const Node*, std::unique_ptr<ExtendedInferenceContext>>
   StealInferenceContexts() {
@@ -291,6 +312,12 @@ class ShapeRefiner {
   bool require_shape_inference_fns_ = true;
   bool disable_constant_propagation_ = false;
 
+  // Output shapes inferred by shape functions, keyed by
+  // ShapeInferenceFingerprint(). Only used if cache_shape_inference_ is true.
+  bool cache_shape_inference_ = false;
+  std::unordered_map<uint64, std::vector<PartialTensorShape>>
+      shape_inference_cache_;
+
   // Function library is optional, but has to be set to enable function
   // shape inference.
   const tensorflow::FunctionLibraryDefinition* function_library_ = nullptr;
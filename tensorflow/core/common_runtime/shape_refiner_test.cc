@@ -58,6 +58,10 @@ class ShapeRefinerTest : public ::testing::Test {
     return ShapeRefiner::IsUpdatedShapesOrTypes(c, existing, updated);
   }
 
+  size_t ShapeInferenceCacheSize(const ShapeRefiner& m) {
+    return m.shape_inference_cache_.size();
+  }
+
   static constexpr int64 kMaxTensorSize = ShapeRefiner::kMaxTensorSize;
 };
 
@@ -115,6 +119,62 @@ TEST_F(ShapeRefinerTest, MatMul) {
   EXPECT_SHAPE("[2,2]", m, mm, 0);
 }
 
+TEST_F(ShapeRefinerTest, CachedShapeInference) {
+  ShapeRefiner m(TF_GRAPH_DEF_VERSION, OpRegistry::Global());
+  m.set_cache_shape_inference(true);
+
+  Scope root = Scope::NewRootScope();
+  auto a = ops::Const(root, {{1.0f}, {2.0f}});
+  auto b = ops::Const(root, {{1.0f, 2.0f}});
+  auto mm1 = ops::MatMul(root, a, b);
+  auto mm2 = ops::MatMul(root, a, b);
+  auto mm3 = ops::MatMul(root, b, a);
+  auto mm4 = ops::MatMul(root, a, b,
+                         ops::MatMul::TransposeA(true).TransposeB(true));
+
+  TF_ASSERT_OK(m.AddNode(a.node()));
+  TF_ASSERT_OK(m.AddNode(b.node()));
+  EXPECT_EQ(0, ShapeInferenceCacheSize(m));
+  TF_ASSERT_OK(m.AddNode(mm1.node()));
+  EXPECT_EQ(1, ShapeInferenceCacheSize(m));
+  // Same op, attrs and input shapes.
+  TF_ASSERT_OK(m.AddNode(mm2.node()));
+  EXPECT_EQ(1, ShapeInferenceCacheSize(m));
+  // Different input shapes, or attrs.
+  TF_ASSERT_OK(m.AddNode(mm3.node()));
+  TF_ASSERT_OK(m.AddNode(mm4.node()));
+  EXPECT_EQ(3, ShapeInferenceCacheSize(m));
+
+  EXPECT_SHAPE("[2,2]", m, mm1, 0);
+  EXPECT_SHAPE("[2,2]", m, mm2, 0);
+  EXPECT_SHAPE("[1,1]", m, mm3, 0);
+  EXPECT_SHAPE("[1,1]", m, mm4, 0);
+}
+
+TEST_F(ShapeRefinerTest, CachedShapeInferenceSkipsInputValues) {
+  ShapeRefiner m(TF_GRAPH_DEF_VERSION, OpRegistry::Global());
+  m.set_cache_shape_inference(true);
+
+  // The two reshapes have inputs of the same shapes, but their outputs depend
+  // on the values of the shape inputs.
+  Scope root = Scope::NewRootScope();
+  auto input = ops::Const(root, {1.0f, 2.0f, 3.0f, 4.0f});
+  auto shape1 = ops::Const(root, {2, 2});
+  auto shape2 = ops::Const(root, {1, 4});
+  auto reshape1 = ops::Reshape(root, input, shape1);
+  auto reshape2 = ops::Reshape(root, input, shape2);
+
+  TF_ASSERT_OK(m.AddNode(input.node()));
+  TF_ASSERT_OK(m.AddNode(shape1.node()));
+  TF_ASSERT_OK(m.AddNode(shape2.node()));
+  TF_ASSERT_OK(m.AddNode(reshape1.node()));
+  TF_ASSERT_OK(m.AddNode(reshape2.node()));
+
+  EXPECT_EQ(0, ShapeInferenceCacheSize(m));
+  EXPECT_SHAPE("[2,2]", m, reshape1, 0);
+  EXPECT_SHAPE("[1,4]", m, reshape2, 0);
+}
+
 TEST_F(ShapeRefinerTest, InvalidOrder) {
   ShapeRefiner m(TF_GRAPH_DEF_VERSION, OpRegistry::Global());
   Scope root = Scope::NewRootScope();
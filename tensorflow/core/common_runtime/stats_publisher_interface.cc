@@ -15,7 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/stats_publisher_interface.h"
 
+#include "tensorflow/core/common_runtime/sampled_step_tracer.h"
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/platform/logging.h"
 
 namespace tensorflow {
 namespace {
@@ -47,4 +50,16 @@ std::unique_ptr<StatsPublisherInterface> CreateNoOpStatsPublisher(
   return std::unique_ptr<StatsPublisherInterface>(new NoOpStatsPublisher);
 }
 
+void PublishSampledStepStats(StatsPublisherInterface* publisher) {
+  StepStats step_stats;
+  const int64 num_lost = SampledStepTracer::Global()->Drain(&step_stats);
+  if (num_lost > 0) {
+    VLOG(1) << "Sampled step tracing overwrote " << num_lost
+            << " events before they were drained.";
+  }
+  if (step_stats.dev_stats_size() > 0) {
+    publisher->PublishStatsProto(step_stats);
+  }
+}
+
 }  // namespace tensorflow
@@ -59,6 +59,11 @@ std::unique_ptr<StatsPublisherInterface> CreateNoOpStatsPublisher(
     const string& session, const BuildGraphOptions& bopts,
     const SessionOptions& sopts);
 
+// Drains the events recorded in this process by sampled step tracing (see
+// ConfigProto.Experimental.sampled_trace_period) and, if there are any,
+// publishes them with 'publisher'.
+void PublishSampledStepStats(StatsPublisherInterface* publisher);
+
 }  // namespace tensorflow
 
 #endif  // THIRD_PARTY_TENSORFLOW_CORE_COMMON_RUNTIME_STATS_PUBLISHER_INTERFACE_H_
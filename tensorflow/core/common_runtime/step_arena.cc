@@ -0,0 +1,194 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+constexpr size_t kDefaultSlabSize = 1 << 20;
+
+size_t RoundUp(size_t num_bytes, size_t multiple) {
+  return (num_bytes + multiple - 1) / multiple * multiple;
+}
+
+uint64 NextStepArenaId() {
+  static std::atomic<uint64> next_id(1);
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+// The slab a thread allocates from for one arena. A thread keeps slabs for
+// a few arenas, so that concurrent steps running on the same thread do not
+// keep abandoning each other's slabs.
+struct ThreadSlab {
+  uint64 arena_id = 0;
+  char* next = nullptr;
+  char* end = nullptr;
+};
+
+constexpr int kThreadSlabs = 4;
+
+struct ThreadSlabs {
+  ThreadSlab slabs[kThreadSlabs];
+  int next_victim = 0;
+};
+
+thread_local ThreadSlabs thread_slabs;
+
+}  // namespace
+
+StepArena::SlabPool::SlabPool(Allocator* base, size_t max_arena_bytes)
+    : base_(base),
+      slab_size_(RoundUp(std::min(kDefaultSlabSize, max_arena_bytes),
+                         Allocator::kAllocatorAlignment)),
+      max_slabs_per_arena_(
+          std::max<int>(1, max_arena_bytes / std::max<size_t>(1, slab_size_))) {
+  CHECK_GT(max_arena_bytes, 0);
+}
+
+StepArena::SlabPool::~SlabPool() {
+  for (char* slab : free_slabs_) base_->DeallocateRaw(slab);
+}
+
+char* StepArena::SlabPool::GetSlab() {
+  {
+    mutex_lock l(mu_);
+    if (!free_slabs_.empty()) {
+      char* slab = free_slabs_.back();
+      free_slabs_.pop_back();
+      return slab;
+    }
+  }
+  return static_cast<char*>(
+      base_->AllocateRaw(Allocator::kAllocatorAlignment, slab_size_));
+}
+
+void StepArena::SlabPool::PutSlab(char* slab) {
+  mutex_lock l(mu_);
+  free_slabs_.push_back(slab);
+}
+
+class StepArena::ArenaAllocator : public Allocator {
+ public:
+  explicit ArenaAllocator(StepArena* arena)
+      : arena_(arena), max_bump_bytes_(arena->pool_->slab_size() / 4) {}
+
+  string Name() override { return "step_arena"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    // Every allocation keeps the arena alive.
+    arena_->Ref();
+    if (alignment <= kAllocatorAlignment && num_bytes <= max_bump_bytes_) {
+      void* ptr = BumpAllocate(num_bytes);
+      if (ptr != nullptr) return ptr;
+    }
+    void* ptr = arena_->pool_->base()->AllocateRaw(alignment, num_bytes);
+    if (ptr == nullptr) {
+      // The step holds a reference, so this is not the last.
+      arena_->Unref();
+      return nullptr;
+    }
+    mutex_lock l(arena_->large_mu_);
+    arena_->large_allocations_.insert(ptr);
+    arena_->num_large_allocations_.fetch_add(1, std::memory_order_release);
+    return ptr;
+  }
+
+  void DeallocateRaw(void* ptr) override {
+    if (arena_->num_large_allocations_.load(std::memory_order_acquire) > 0) {
+      bool large;
+      {
+        mutex_lock l(arena_->large_mu_);
+        large = arena_->large_allocations_.erase(ptr) > 0;
+      }
+      if (large) {
+        arena_->num_large_allocations_.fetch_sub(1, std::memory_order_relaxed);
+        arena_->pool_->base()->DeallocateRaw(ptr);
+      }
+    }
+    // May delete this allocator.
+    arena_->Unref();
+  }
+
+ private:
+  void* BumpAllocate(size_t num_bytes) {
+    const size_t bytes = RoundUp(std::max<size_t>(num_bytes, 1),
+                                 Allocator::kAllocatorAlignment);
+    ThreadSlabs* slabs = &thread_slabs;
+    ThreadSlab* slab = nullptr;
+    for (ThreadSlab& s : slabs->slabs) {
+      if (s.arena_id == arena_->id_) {
+        slab = &s;
+        break;
+      }
+    }
+    if (slab != nullptr && slab->next + bytes <= slab->end) {
+      char* ptr = slab->next;
+      slab->next += bytes;
+      return ptr;
+    }
+    // The rest of the current slab stays unused.
+    char* memory = arena_->NewSlab();
+    if (memory == nullptr) return nullptr;
+    if (slab == nullptr) {
+      slab = &slabs->slabs[slabs->next_victim];
+      slabs->next_victim = (slabs->next_victim + 1) % kThreadSlabs;
+      slab->arena_id = arena_->id_;
+    }
+    slab->next = memory + bytes;
+    slab->end = memory + arena_->pool_->slab_size();
+    return memory;
+  }
+
+  StepArena* const arena_;
+  const size_t max_bump_bytes_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ArenaAllocator);
+};
+
+StepArena::StepArena(std::shared_ptr<SlabPool> pool)
+    : pool_(std::move(pool)), id_(NextStepArenaId()) {
+  allocator_.reset(new ArenaAllocator(this));
+}
+
+StepArena::~StepArena() {
+  DCHECK_EQ(0, num_large_allocations_.load());
+  for (char* slab : slabs_) pool_->PutSlab(slab);
+}
+
+Allocator* StepArena::allocator() { return allocator_.get(); }
+
+int StepArena::num_slabs() {
+  mutex_lock l(mu_);
+  return slabs_.size();
+}
+
+char* StepArena::NewSlab() {
+  mutex_lock l(mu_);
+  if (static_cast<int>(slabs_.size()) >= pool_->max_slabs_per_arena()) {
+    return nullptr;
+  }
+  char* slab = pool_->GetSlab();
+  if (slab != nullptr) slabs_.push_back(slab);
+  return slab;
+}
+
+}  // namespace tensorflow
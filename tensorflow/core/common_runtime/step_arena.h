@@ -0,0 +1,104 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_H_
+
+#include <atomic>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A bump allocator for the scratch buffers of one step, i.e. the tensors
+// allocated with AllocatorAttributes::scratch(). Each thread allocates
+// from its own slab without locking, and DeallocateRaw() frees nothing:
+// all slabs are released at once, when the step has dropped its reference
+// and all tensors allocated from the arena are gone.
+//
+// Allocations larger than a quarter of a slab, with an alignment above
+// Allocator::kAllocatorAlignment, or beyond the byte limit of the arena,
+// fall back to the base allocator.
+class StepArena : public core::RefCounted {
+ public:
+  // The slabs shared by consecutive arenas, e.g. those of the steps of an
+  // executor, so that steady-state steps do not allocate slabs.
+  class SlabPool {
+   public:
+    // Each arena uses at most 'max_arena_bytes' of slabs from 'base'.
+    SlabPool(Allocator* base, size_t max_arena_bytes);
+    ~SlabPool();
+
+    Allocator* base() const { return base_; }
+    size_t slab_size() const { return slab_size_; }
+    int max_slabs_per_arena() const { return max_slabs_per_arena_; }
+
+    // Returns nullptr if the base allocator fails.
+    char* GetSlab();
+    void PutSlab(char* slab);
+
+   private:
+    Allocator* const base_;
+    const size_t slab_size_;
+    const int max_slabs_per_arena_;
+    mutex mu_;
+    std::vector<char*> free_slabs_ GUARDED_BY(mu_);
+
+    TF_DISALLOW_COPY_AND_ASSIGN(SlabPool);
+  };
+
+  explicit StepArena(std::shared_ptr<SlabPool> pool);
+
+  Allocator* allocator();
+
+  // The number of slabs used by this arena.
+  int num_slabs();
+
+ private:
+  class ArenaAllocator;
+
+  ~StepArena() override;
+
+  // Returns a new slab for this arena, or nullptr if it has used all its
+  // slabs.
+  char* NewSlab();
+
+  const std::shared_ptr<SlabPool> pool_;
+  // Identifies the arena in the slabs cached by each thread.
+  const uint64 id_;
+  std::unique_ptr<ArenaAllocator> allocator_;
+
+  mutex mu_;
+  std::vector<char*> slabs_ GUARDED_BY(mu_);
+
+  // The live allocations that were passed to the base allocator.
+  mutex large_mu_;
+  std::unordered_set<void*> large_allocations_ GUARDED_BY(large_mu_);
+  std::atomic<int> num_large_allocations_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepArena);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_H_
@@ -0,0 +1,99 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena.h"
+
+#include <string.h>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr size_t kArenaBytes = 4 << 20;
+
+TEST(StepArena, BumpAllocatesFromThreadSlabs) {
+  auto pool = std::make_shared<StepArena::SlabPool>(cpu_allocator(),
+                                                    kArenaBytes);
+  StepArena* arena = new StepArena(pool);
+  Allocator* a = arena->allocator();
+  char* p0 = static_cast<char*>(a->AllocateRaw(32, 10));
+  char* p1 = static_cast<char*>(a->AllocateRaw(64, 100));
+  EXPECT_EQ(p0 + Allocator::kAllocatorAlignment, p1);
+  EXPECT_EQ(1, arena->num_slabs());
+
+  // Another thread uses its own slab.
+  char* other = nullptr;
+  {
+    std::unique_ptr<Thread> thread(Env::Default()->StartThread(
+        ThreadOptions(), "step_arena_test",
+        [a, &other]() { other = static_cast<char*>(a->AllocateRaw(64, 8)); }));
+  }
+  EXPECT_EQ(2, arena->num_slabs());
+  EXPECT_TRUE(other < p0 || other >= p0 + pool->slab_size());
+
+  // Too large for a slab.
+  void* large = a->AllocateRaw(64, pool->slab_size());
+  EXPECT_EQ(2, arena->num_slabs());
+  a->DeallocateRaw(large);
+
+  a->DeallocateRaw(p0);
+  a->DeallocateRaw(p1);
+  a->DeallocateRaw(other);
+  arena->Unref();
+
+  // The slabs are reused by the next arena.
+  arena = new StepArena(pool);
+  void* reused = arena->allocator()->AllocateRaw(64, 10);
+  EXPECT_TRUE(reused == p0 || reused == other);
+  arena->allocator()->DeallocateRaw(reused);
+  arena->Unref();
+}
+
+TEST(StepArena, FallsBackBeyondLimit) {
+  auto pool = std::make_shared<StepArena::SlabPool>(cpu_allocator(), 4096);
+  EXPECT_EQ(4096, pool->slab_size());
+  EXPECT_EQ(1, pool->max_slabs_per_arena());
+  StepArena* arena = new StepArena(pool);
+  Allocator* a = arena->allocator();
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 32; ++i) {
+    void* p = a->AllocateRaw(64, 1000);
+    ASSERT_NE(nullptr, p);
+    memset(p, 0, 1000);
+    ptrs.push_back(p);
+  }
+  EXPECT_EQ(1, arena->num_slabs());
+  for (void* p : ptrs) a->DeallocateRaw(p);
+  arena->Unref();
+}
+
+TEST(StepArena, TensorsKeepArenaAlive) {
+  auto pool = std::make_shared<StepArena::SlabPool>(cpu_allocator(),
+                                                    kArenaBytes);
+  StepArena* arena = new StepArena(pool);
+  Tensor t(arena->allocator(), DT_FLOAT, TensorShape({16}));
+  t.flat<float>().setConstant(1.0f);
+  // The step is done, but 't' still uses the arena.
+  arena->Unref();
+  EXPECT_EQ(1.0f, t.flat<float>()(15));
+}
+
+}  // namespace
+}  // namespace tensorflow
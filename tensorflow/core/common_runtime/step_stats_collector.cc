@@ -14,6 +14,10 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+
+#include <algorithm>
+#include <vector>
+
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/tensor_description.pb.h"
@@ -57,6 +61,50 @@ void NodeExecStatsWrapper::Finalize() {
   allocations_.clear();
 }
 
+namespace {
+
+// Sets live_bytes_at_step_peak of 'memories', which all belong to the same
+// allocator, from their allocation records.
+void SetLiveBytesAtStepPeak(const std::vector<AllocatorMemoryUsed*>& memories) {
+  struct Record {
+    int64 micros;
+    int64 bytes;
+    int memory;
+  };
+  std::vector<Record> records;
+  for (int i = 0; i < memories.size(); ++i) {
+    for (const auto& record : memories[i]->allocation_records()) {
+      records.push_back({record.alloc_micros(), record.alloc_bytes(), i});
+    }
+  }
+  // At equal times deallocations go first, so that memory that is freed
+  // and reused within a microsecond is not counted twice.
+  std::sort(records.begin(), records.end(),
+            [](const Record& a, const Record& b) {
+              return a.micros != b.micros ? a.micros < b.micros
+                                          : a.bytes < b.bytes;
+            });
+  int64 bytes_in_use = 0;
+  int64 peak_bytes = 0;
+  size_t peak_end = 0;
+  for (size_t i = 0; i < records.size(); ++i) {
+    bytes_in_use += records[i].bytes;
+    if (bytes_in_use > peak_bytes) {
+      peak_bytes = bytes_in_use;
+      peak_end = i + 1;
+    }
+  }
+  std::vector<int64> live_bytes(memories.size(), 0);
+  for (size_t i = 0; i < peak_end; ++i) {
+    live_bytes[records[i].memory] += records[i].bytes;
+  }
+  for (int i = 0; i < memories.size(); ++i) {
+    memories[i]->set_live_bytes_at_step_peak(live_bytes[i]);
+  }
+}
+
+}  // namespace
+
 StepStatsCollector::StepStatsCollector(StepStats* ss)
     : finalized_(false), step_stats_(ss) {}
 
@@ -285,6 +333,22 @@ void StepStatsCollector::FinalizeInternal() {
     return;
   }
   finalized_ = true;
+  // Attributes the peak of each allocator during the step to the nodes
+  // that held its memory at that moment.
+  std::unordered_map<string, std::vector<AllocatorMemoryUsed*>>
+      memories_by_allocator;
+  for (const auto& dev_stat : dev_stats_) {
+    for (auto& stats : dev_stat.second) {
+      stats->Finalize();
+      for (auto& memory : *stats->stats()->mutable_memory()) {
+        memories_by_allocator[memory.allocator_name()].push_back(&memory);
+      }
+    }
+  }
+  for (const auto& allocator_and_memories : memories_by_allocator) {
+    SetLiveBytesAtStepPeak(allocator_and_memories.second);
+  }
+
   std::map<string, DeviceStepStats*> dev_stats_pb;
   for (auto& ds : *step_stats_->mutable_dev_stats()) {
     dev_stats_pb[ds.device()] = &ds;
@@ -297,7 +361,6 @@ void StepStatsCollector::FinalizeInternal() {
     }
     DeviceStepStats* dss = dev_stats_pb.at(dev_stat.first);
     for (auto& stats : dev_stat.second) {
-      stats->Finalize();
       stats->stats()->Swap(dss->add_node_stats());
     }
   }
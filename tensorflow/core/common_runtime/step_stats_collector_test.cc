@@ -0,0 +1,84 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_stats_collector.h"
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns stats for node 'name' which allocated from 'allocator_name' at
+// the given (micros, bytes) records.
+NodeExecStats* MakeNodeStats(
+    const string& name, const string& allocator_name,
+    const std::vector<std::pair<int64, int64>>& records) {
+  NodeExecStats* stats = new NodeExecStats;
+  stats->set_node_name(name);
+  AllocatorMemoryUsed* memory = stats->add_memory();
+  memory->set_allocator_name(allocator_name);
+  for (const auto& record : records) {
+    AllocationRecord* r = memory->add_allocation_records();
+    r->set_alloc_micros(record.first);
+    r->set_alloc_bytes(record.second);
+  }
+  return stats;
+}
+
+TEST(StepStatsCollector, LiveBytesAtStepPeak) {
+  StepStats step_stats;
+  StepStatsCollector collector(&step_stats);
+  // The "cpu" allocator peaks at 180 bytes at time 4.
+  collector.Save("/cpu:0", MakeNodeStats("a", "cpu", {{1, 100}, {5, -100}}));
+  collector.Save("/cpu:0", MakeNodeStats("b", "cpu", {{2, 50}, {3, -50}}));
+  collector.Save("/cpu:1", MakeNodeStats("c", "cpu", {{4, 80}}));
+  collector.Save("/cpu:1", MakeNodeStats("d", "other", {{1, 10}}));
+  collector.Finalize();
+
+  std::unordered_map<string, int64> live_bytes_at_step_peak;
+  for (const auto& dev_stats : step_stats.dev_stats()) {
+    for (const auto& node_stats : dev_stats.node_stats()) {
+      ASSERT_EQ(1, node_stats.memory_size());
+      live_bytes_at_step_peak[node_stats.node_name()] =
+          node_stats.memory(0).live_bytes_at_step_peak();
+    }
+  }
+  EXPECT_EQ(100, live_bytes_at_step_peak["a"]);
+  EXPECT_EQ(0, live_bytes_at_step_peak["b"]);
+  EXPECT_EQ(80, live_bytes_at_step_peak["c"]);
+  EXPECT_EQ(10, live_bytes_at_step_peak["d"]);
+}
+
+TEST(StepStatsCollector, ReuseAtSameTimeIsNotCountedTwice) {
+  StepStats step_stats;
+  StepStatsCollector collector(&step_stats);
+  collector.Save("/cpu:0", MakeNodeStats("a", "cpu", {{1, 100}, {2, -100}}));
+  collector.Save("/cpu:0", MakeNodeStats("b", "cpu", {{2, 60}}));
+  collector.Finalize();
+
+  ASSERT_EQ(1, step_stats.dev_stats_size());
+  const DeviceStepStats& dev_stats = step_stats.dev_stats(0);
+  ASSERT_EQ(2, dev_stats.node_stats_size());
+  EXPECT_EQ(100, dev_stats.node_stats(0).memory(0).live_bytes_at_step_peak());
+  EXPECT_EQ(0, dev_stats.node_stats(1).memory(0).live_bytes_at_step_peak());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/threadpool_device.h"
 
+#include <memory>
+
 #include "tensorflow/core/common_runtime/local_device.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/allocator_registry.h"
@@ -24,9 +26,11 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/graph/types.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/parallelism_governor.h"
 
 #ifdef INTEL_MKL
 #include "tensorflow/core/common_runtime/mkl_cpu_allocator.h"
@@ -40,7 +44,11 @@ ThreadPoolDevice::ThreadPoolDevice(const SessionOptions& options,
                                    Allocator* allocator)
     : LocalDevice(options, Device::BuildDeviceAttributes(
                                name, DEVICE_CPU, memory_limit, locality)),
-      allocator_(allocator) {}
+      allocator_(allocator) {
+  if (options.config.experimental().limit_nested_parallelism()) {
+    ParallelismGovernor::Global()->Enable(port::NumSchedulableCPUs());
+  }
+}
 
 ThreadPoolDevice::~ThreadPoolDevice() {}
 
@@ -50,6 +58,11 @@ void ThreadPoolDevice::Compute(OpKernel* op_kernel, OpKernelContext* context) {
   // false value. Measurements show that its overhead is negligible.
   port::Tracing::TraceMe trace_me(op_kernel->name(), op_kernel->type_string(),
                                   op_kernel->IsExpensive());
+  std::unique_ptr<ParallelismGovernor::BusyScope> busy;
+  ParallelismGovernor* governor = ParallelismGovernor::Global();
+  if (governor->enabled()) {
+    busy.reset(new ParallelismGovernor::BusyScope(governor));
+  }
   if (port::Tracing::IsActive()) {
     // TODO(pbar) We really need a useful identifier of the graph node.
     const uint64 id = Hash64(op_kernel->name());
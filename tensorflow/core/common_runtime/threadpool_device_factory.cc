@@ -19,6 +19,10 @@ limitations under the License.
 #include <vector>
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/allocator_registry.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/public/session_options.h"
 
 namespace tensorflow {
@@ -35,10 +39,35 @@ class ThreadPoolDeviceFactory : public DeviceFactory {
     if (iter != options.config.device_count().end()) {
       n = iter->second;
     }
+    const bool use_numa =
+        options.config.experimental().use_numa_affinity() &&
+        port::NUMAEnabled();
+    const string& allocator_name =
+        options.config.experimental().cpu_allocator();
     for (int i = 0; i < n; i++) {
       string name = strings::StrCat(name_prefix, "/device:CPU:", i);
-      devices->push_back(new ThreadPoolDevice(
-          options, name, Bytes(256 << 20), DeviceLocality(), cpu_allocator()));
+      DeviceLocality locality;
+      int numa_node = port::kNUMANoAffinity;
+      if (use_numa) {
+        numa_node = i % port::NUMANumNodes();
+        locality.set_numa_node(numa_node);
+        VLOG(1) << "Binding " << name << " to NUMA node " << numa_node;
+      }
+      Allocator* allocator;
+      if (!allocator_name.empty()) {
+        allocator = AllocatorRegistry::Global()->GetAllocator(allocator_name,
+                                                              numa_node);
+        if (allocator == nullptr) {
+          return errors::InvalidArgument("Cannot create CPU allocator \"",
+                                         allocator_name, "\" for ", name);
+        }
+      } else if (use_numa) {
+        allocator = cpu_allocator(numa_node);
+      } else {
+        allocator = cpu_allocator();
+      }
+      devices->push_back(new ThreadPoolDevice(options, name, Bytes(256 << 20),
+                                              locality, allocator));
     }
 
     return Status::OK();
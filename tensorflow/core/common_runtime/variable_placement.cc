@@ -0,0 +1,258 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/variable_placement.h"
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+// A variable and the nodes that must stay on its device.
+struct Group {
+  std::vector<Node*> nodes;
+  string name;  // The name of its first variable.
+  string device;
+  int64 bytes = 0;
+  int64 accesses = 0;
+  bool has_variable = false;
+  bool fixed = false;
+};
+
+bool IsVariableOp(const Node* node) {
+  return node->IsVariable() || node->type_string() == "VarHandleOp";
+}
+
+// The size of the value of a variable, counting the unknown dimensions of
+// its shape as 1.
+int64 VariableBytes(const Node* node) {
+  DataType dtype;
+  PartialTensorShape shape;
+  if (!GetNodeAttr(node->attrs(), "dtype", &dtype).ok() ||
+      !GetNodeAttr(node->attrs(), "shape", &shape).ok()) {
+    return 0;
+  }
+  int64 elements = 1;
+  for (int d = 0; d < shape.dims(); ++d) {
+    elements *= std::max<int64>(shape.dim_size(d), 1);
+  }
+  return elements * DataTypeSize(dtype);
+}
+
+int Find(std::vector<int>* parents, int id) {
+  while ((*parents)[id] != id) {
+    (*parents)[id] = (*parents)[(*parents)[id]];
+    id = (*parents)[id];
+  }
+  return id;
+}
+
+void Union(std::vector<int>* parents, int a, int b) {
+  a = Find(parents, a);
+  b = Find(parents, b);
+  // Keeps the smaller id as the root, so that the groups do not depend on
+  // the order of the unions.
+  if (a < b) {
+    (*parents)[b] = a;
+  } else if (b < a) {
+    (*parents)[a] = b;
+  }
+}
+
+double Fraction(int64 value, int64 total) {
+  return total > 0 ? static_cast<double>(value) / total : 0;
+}
+
+// Assigns the movable "groups", which are all placed on devices of the same
+// type, to "devices", starting with the heaviest.
+void BalanceGroups(const std::vector<string>& devices,
+                   std::vector<Group*> groups) {
+  int64 total_bytes = 0;
+  int64 total_accesses = 0;
+  for (const Group* group : groups) {
+    total_bytes += group->bytes;
+    total_accesses += group->accesses;
+  }
+  std::vector<int64> bytes(devices.size(), 0);
+  std::vector<int64> accesses(devices.size(), 0);
+  for (const Group* group : groups) {
+    if (!group->fixed) continue;
+    const size_t d =
+        std::lower_bound(devices.begin(), devices.end(), group->device) -
+        devices.begin();
+    bytes[d] += group->bytes;
+    accesses[d] += group->accesses;
+  }
+
+  groups.erase(std::remove_if(groups.begin(), groups.end(),
+                              [](const Group* group) { return group->fixed; }),
+               groups.end());
+  std::vector<double> loads(groups.size());
+  for (size_t i = 0; i < groups.size(); ++i) {
+    loads[i] = std::max(Fraction(groups[i]->bytes, total_bytes),
+                        Fraction(groups[i]->accesses, total_accesses));
+  }
+  std::vector<size_t> order(groups.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&groups, &loads](size_t a, size_t b) {
+    if (loads[a] != loads[b]) return loads[a] > loads[b];
+    return groups[a]->name < groups[b]->name;
+  });
+
+  for (size_t i : order) {
+    Group* group = groups[i];
+    size_t best = 0;
+    double best_load = 0;
+    double best_sum = 0;
+    for (size_t d = 0; d < devices.size(); ++d) {
+      const int64 b = bytes[d] + group->bytes;
+      const int64 a = accesses[d] + group->accesses;
+      const double byte_load = Fraction(b, total_bytes);
+      const double access_load = Fraction(a, total_accesses);
+      // Minimizes the larger of the two loads of the device, and then their
+      // sum.
+      const double load = std::max(byte_load, access_load);
+      const double sum = byte_load + access_load;
+      if (d == 0 || load < best_load ||
+          (load == best_load && sum < best_sum)) {
+        best = d;
+        best_load = load;
+        best_sum = sum;
+      }
+    }
+    bytes[best] += group->bytes;
+    accesses[best] += group->accesses;
+    if (devices[best] == group->device) continue;
+    VLOG(1) << "Moving variable " << group->name << " (" << group->bytes
+            << " bytes, " << group->accesses << " accesses) from "
+            << group->device << " to " << devices[best];
+    for (Node* node : group->nodes) {
+      node->set_assigned_device_name(devices[best]);
+    }
+  }
+}
+
+}  // namespace
+
+Status BalanceVariablePlacement(
+    const string& job, const DeviceSet& devices,
+    const std::unordered_map<string, string>& fixed_placements, Graph* graph) {
+  // The devices of "job", by type and then by name.
+  std::map<string, std::vector<string>> job_devices;
+  std::unordered_map<string, string> device_types;
+  for (const Device* device : devices.devices()) {
+    if (device->parsed_name().job != job) continue;
+    job_devices[device->device_type()].push_back(device->name());
+    device_types[device->name()] = device->device_type();
+  }
+  for (auto& type_and_devices : job_devices) {
+    std::sort(type_and_devices.second.begin(), type_and_devices.second.end());
+  }
+
+  const auto on_job = [&device_types](const Node* node) {
+    return node->IsOp() &&
+           device_types.count(node->assigned_device_name()) > 0;
+  };
+
+  std::vector<int> parents(graph->num_node_ids());
+  std::iota(parents.begin(), parents.end(), 0);
+  std::unordered_map<StringPiece, const Node*, StringPiece::Hasher> by_name;
+  for (const Node* node : graph->op_nodes()) {
+    if (on_job(node)) by_name[node->name()] = node;
+  }
+  for (const Node* node : graph->op_nodes()) {
+    if (!on_job(node)) continue;
+    const AttrValue* classes = node->attrs().Find(kColocationAttrName);
+    if (classes == nullptr) continue;
+    for (const string& spec : classes->list().s()) {
+      StringPiece name(spec);
+      if (!name.Consume(kColocationGroupPrefix)) continue;
+      auto it = by_name.find(name);
+      if (it != by_name.end()) Union(&parents, node->id(), it->second->id());
+    }
+  }
+  // The nodes on "job" that have a reference or resource edge to a node
+  // outside of it.
+  std::unordered_set<int> pinned;
+  for (const Edge* edge : graph->edges()) {
+    if (edge->IsControlEdge()) continue;
+    const DataType dtype = edge->dst()->input_type(edge->dst_input());
+    if (!IsRefType(dtype) && dtype != DT_RESOURCE) continue;
+    const bool src_on_job = on_job(edge->src());
+    const bool dst_on_job = on_job(edge->dst());
+    if (src_on_job && dst_on_job) {
+      Union(&parents, edge->src()->id(), edge->dst()->id());
+    } else if (src_on_job) {
+      pinned.insert(edge->src()->id());
+    } else if (dst_on_job) {
+      pinned.insert(edge->dst()->id());
+    }
+  }
+
+  std::map<int, Group> groups;
+  for (Node* node : graph->op_nodes()) {
+    if (!on_job(node)) continue;
+    Group& group = groups[Find(&parents, node->id())];
+    group.nodes.push_back(node);
+    if (group.device.empty()) {
+      group.device = node->assigned_device_name();
+    } else if (group.device != node->assigned_device_name()) {
+      group.fixed = true;
+    }
+    if (IsVariableOp(node)) {
+      if (!group.has_variable) group.name = node->name();
+      group.has_variable = true;
+      group.bytes += VariableBytes(node);
+    }
+    if (fixed_placements.count(node->name()) > 0) group.fixed = true;
+  }
+  for (int id : pinned) {
+    groups[Find(&parents, id)].fixed = true;
+  }
+  for (const Edge* edge : graph->edges()) {
+    if (edge->IsControlEdge()) continue;
+    const bool src_on_job = on_job(edge->src());
+    const bool dst_on_job = on_job(edge->dst());
+    const int src = src_on_job ? Find(&parents, edge->src()->id()) : -1;
+    const int dst = dst_on_job ? Find(&parents, edge->dst()->id()) : -1;
+    if (src == dst) continue;
+    if (src_on_job) ++groups[src].accesses;
+    if (dst_on_job) ++groups[dst].accesses;
+  }
+
+  std::map<string, std::vector<Group*>> groups_by_type;
+  for (auto& root_and_group : groups) {
+    Group& group = root_and_group.second;
+    if (!group.has_variable) continue;
+    groups_by_type[device_types[group.device]].push_back(&group);
+  }
+  for (const auto& type_and_groups : groups_by_type) {
+    BalanceGroups(job_devices[type_and_groups.first], type_and_groups.second);
+  }
+  return Status::OK();
+}
+
+}  // namespace tensorflow
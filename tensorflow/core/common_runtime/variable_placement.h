@@ -0,0 +1,51 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_VARIABLE_PLACEMENT_H_
+#define TENSORFLOW_COMMON_RUNTIME_VARIABLE_PLACEMENT_H_
+
+#include <string>
+#include <unordered_map>
+
+#include "tensorflow/core/common_runtime/device_set.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Moves the variables of the placed "graph" that are assigned to the devices
+// of "job" (e.g. "ps") between those devices, so as to balance the bytes of
+// the variables and the number of their accesses across them.
+//
+// Each variable moves together with the nodes that are colocated with it,
+// i.e. the nodes of its colocation group and the nodes connected to it by
+// edges of a reference or resource type. The accesses of a variable are the
+// data edges between its nodes and the rest of the graph, which each
+// transfer a tensor in the steps that run them. A variable moves only to a
+// device of the same type, and stays where it is if any of its nodes is in
+// "fixed_placements", e.g. because an earlier version of the graph placed
+// it, or if it is connected by a reference or resource edge to a node
+// outside of "job".
+//
+// The placement is a deterministic function of the graph, so the sessions
+// that build the same graph place its variables the same way.
+Status BalanceVariablePlacement(
+    const string& job, const DeviceSet& devices,
+    const std::unordered_map<string, string>& fixed_placements, Graph* graph);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_VARIABLE_PLACEMENT_H_
@@ -0,0 +1,218 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/variable_placement.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/graph/graph_def_builder.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+const char* const kWorker = "/job:worker/replica:0/task:0/device:CPU:0";
+
+class FakeDevice : public Device {
+ public:
+  explicit FakeDevice(const string& name)
+      : Device(nullptr, Attributes(name)) {}
+
+  Status Sync() override { return errors::Unimplemented("FakeDevice::Sync()"); }
+
+  Allocator* GetAllocator(AllocatorAttributes attr) override { return nullptr; }
+
+ private:
+  static DeviceAttributes Attributes(const string& name) {
+    DeviceAttributes attributes;
+    attributes.set_name(name);
+    attributes.set_device_type("CPU");
+    return attributes;
+  }
+};
+
+class VariablePlacementTest : public ::testing::Test {
+ protected:
+  VariablePlacementTest() {
+    for (int task = 0; task < 3; ++task) {
+      AddDevice(PsDevice(task));
+    }
+    AddDevice(kWorker);
+  }
+
+  static string PsDevice(int task) {
+    return strings::StrCat("/job:ps/replica:0/task:", task, "/device:CPU:0");
+  }
+
+  void AddDevice(const string& name) {
+    devices_.emplace_back(new FakeDevice(name));
+    device_set_.AddDevice(devices_.back().get());
+  }
+
+  // Adds a variable of "num_floats" named "name", and an op on the worker
+  // that reads it.
+  static Node* AddVariable(const string& name, int64 num_floats,
+                           GraphDefBuilder* b) {
+    Node* var = ops::SourceOp(
+        "VariableV2", b->opts()
+                          .WithName(name)
+                          .WithAttr("dtype", DT_FLOAT)
+                          .WithAttr("shape", TensorShape({num_floats})));
+    ops::UnaryOp("Identity", var, b->opts().WithName(name + "/read"));
+    return var;
+  }
+
+  // Converts "b" to a graph whose nodes are all placed on "device", except
+  // for the nodes whose names are in "devices".
+  Status BuildGraph(const GraphDefBuilder& b, const string& device,
+                    const std::map<string, string>& devices = {}) {
+    graph_.reset(new Graph(OpRegistry::Global()));
+    TF_RETURN_IF_ERROR(b.ToGraph(graph_.get()));
+    for (Node* node : graph_->op_nodes()) {
+      auto it = devices.find(node->name());
+      node->set_assigned_device_name(it == devices.end() ? device : it->second);
+    }
+    return Status::OK();
+  }
+
+  string DeviceOf(const string& name) {
+    for (const Node* node : graph_->op_nodes()) {
+      if (node->name() == name) return node->assigned_device_name();
+    }
+    return "";
+  }
+
+  std::vector<std::unique_ptr<Device>> devices_;
+  DeviceSet device_set_;
+  std::unique_ptr<Graph> graph_;
+};
+
+TEST_F(VariablePlacementTest, SpreadsEqualVariables) {
+  GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+  std::map<string, string> devices;
+  for (int i = 0; i < 6; ++i) {
+    const string name = strings::StrCat("var", i);
+    AddVariable(name, 100, &b);
+    devices[name] = PsDevice(0);
+  }
+  TF_ASSERT_OK(BuildGraph(b, kWorker, devices));
+
+  TF_ASSERT_OK(BalanceVariablePlacement("ps", device_set_, {}, graph_.get()));
+  std::map<string, int> variables_per_device;
+  for (int i = 0; i < 6; ++i) {
+    const string name = strings::StrCat("var", i);
+    ++variables_per_device[DeviceOf(name)];
+    EXPECT_EQ(kWorker, DeviceOf(name + "/read"));
+  }
+  EXPECT_EQ(2, variables_per_device[PsDevice(0)]);
+  EXPECT_EQ(2, variables_per_device[PsDevice(1)]);
+  EXPECT_EQ(2, variables_per_device[PsDevice(2)]);
+}
+
+TEST_F(VariablePlacementTest, KeepsBigVariableAlone) {
+  GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+  std::map<string, string> devices;
+  AddVariable("big", 1000, &b);
+  devices["big"] = PsDevice(1);
+  for (int i = 0; i < 3; ++i) {
+    const string name = strings::StrCat("small", i);
+    AddVariable(name, 10, &b);
+    devices[name] = PsDevice(1);
+  }
+  TF_ASSERT_OK(BuildGraph(b, kWorker, devices));
+
+  TF_ASSERT_OK(BalanceVariablePlacement("ps", device_set_, {}, graph_.get()));
+  const string big = DeviceOf("big");
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NE(big, DeviceOf(strings::StrCat("small", i)));
+  }
+}
+
+TEST_F(VariablePlacementTest, MovesColocatedNodes) {
+  GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+  AddVariable("a", 100, &b);
+  Node* var = AddVariable("b", 100, &b);
+  Node* value = ops::SourceOp(
+      "Const", b.opts()
+                   .WithName("value")
+                   .WithAttr("dtype", DT_FLOAT)
+                   .WithAttr("value", Tensor(DT_FLOAT, TensorShape({100}))));
+  ops::BinaryOp("Assign", var, value, b.opts().WithName("b/assign"));
+  // Colocated with both variables, so they stay together.
+  ops::UnaryOp("Identity", var,
+               b.opts().WithName("b/save").WithAttr(
+                   "_class", std::vector<string>({"loc:@a", "loc:@b"})));
+  TF_ASSERT_OK(BuildGraph(
+      b, kWorker,
+      {{"a", PsDevice(0)}, {"b", PsDevice(0)}, {"b/assign", PsDevice(0)},
+       {"b/save", PsDevice(0)}}));
+
+  TF_ASSERT_OK(BalanceVariablePlacement("ps", device_set_, {}, graph_.get()));
+  EXPECT_EQ(DeviceOf("a"), DeviceOf("b"));
+  EXPECT_EQ(DeviceOf("b"), DeviceOf("b/assign"));
+  EXPECT_EQ(DeviceOf("b"), DeviceOf("b/save"));
+  EXPECT_EQ(kWorker, DeviceOf("value"));
+}
+
+TEST_F(VariablePlacementTest, KeepsFixedAndPinnedVariables) {
+  GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+  std::map<string, string> devices;
+  for (int i = 0; i < 3; ++i) {
+    const string name = strings::StrCat("var", i);
+    AddVariable(name, 100, &b);
+    devices[name] = PsDevice(2);
+  }
+  Node* pinned = AddVariable("pinned", 100, &b);
+  devices["pinned"] = PsDevice(2);
+  Node* value = ops::SourceOp(
+      "Const", b.opts()
+                   .WithName("value")
+                   .WithAttr("dtype", DT_FLOAT)
+                   .WithAttr("value", Tensor(DT_FLOAT, TensorShape({100}))));
+  // An update on the worker through a reference to the variable.
+  ops::BinaryOp("Assign", pinned, value, b.opts().WithName("pinned/assign"));
+  TF_ASSERT_OK(BuildGraph(b, kWorker, devices));
+
+  TF_ASSERT_OK(BalanceVariablePlacement(
+      "ps", device_set_, {{"var0", PsDevice(2)}}, graph_.get()));
+  EXPECT_EQ(PsDevice(2), DeviceOf("var0"));
+  EXPECT_EQ(PsDevice(2), DeviceOf("pinned"));
+  // The other two variables are moved away from them.
+  EXPECT_NE(PsDevice(2), DeviceOf("var1"));
+  EXPECT_NE(PsDevice(2), DeviceOf("var2"));
+  EXPECT_NE(DeviceOf("var1"), DeviceOf("var2"));
+}
+
+TEST_F(VariablePlacementTest, IgnoresOtherJobs) {
+  GraphDefBuilder b(GraphDefBuilder::kFailImmediately);
+  AddVariable("a", 100, &b);
+  AddVariable("b", 100, &b);
+  TF_ASSERT_OK(BuildGraph(b, kWorker));
+
+  TF_ASSERT_OK(BalanceVariablePlacement("ps", device_set_, {}, graph_.get()));
+  EXPECT_EQ(kWorker, DeviceOf("a"));
+  EXPECT_EQ(kWorker, DeviceOf("b"));
+}
+
+}  // namespace
+}  // namespace tensorflow
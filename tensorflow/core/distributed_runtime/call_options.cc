@@ -19,7 +19,7 @@ limitations under the License.
 
 namespace tensorflow {
 
-CallOptions::CallOptions() {}
+CallOptions::CallOptions() : timeout_in_ms_(0) {}
 
 void CallOptions::StartCancel() {
   mutex_lock l(mu_);
@@ -60,7 +60,9 @@ class CallOptions {
   void SetCancelCallback(CancelFunction cancel_func);
   void ClearCancelCallback();
 
-  // Get and set operation timeout. Timeout value is in milliseconds.
+  // Get and set operation timeout. Timeout value is in milliseconds, and
+  // a value <= 0, the default, means no timeout. The RPC layer applies it
+  // as the deadline of the call.
   int64 GetTimeout();
   void SetTimeout(int64 ms);
 
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -61,6 +62,8 @@ class ExecutorTest : public ::testing::Test {
     const int version = graph->versions().producer();
     LocalExecutorParams params;
     params.device = device_;
+    params.num_work_stealing_workers = num_work_stealing_workers_;
+    params.use_linear_schedule = use_linear_schedule_;
     params.create_kernel = [this, version](const NodeDef& ndef,
                                            OpKernel** kernel) {
       return CreateNonCachedKernel(device_, nullptr, ndef, version, kernel);
@@ -83,6 +86,8 @@ class ExecutorTest : public ::testing::Test {
   }
 
   thread::ThreadPool* thread_pool_ = nullptr;
+  int num_work_stealing_workers_ = 0;
+  bool use_linear_schedule_ = false;
   Device* device_ = nullptr;
   Executor* exec_ = nullptr;
   StepStatsCollector step_stats_collector_;
@@ -243,6 +248,62 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, RandomTreeWorkStealing) {
+  Graph* g = new Graph(OpRegistry::Global());
+  BuildTree(4096, g);
+  num_work_stealing_workers_ = thread_pool_->NumThreads();
+  Create(g);
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
+TEST_F(ExecutorTest, RandomTreeLinearSchedule) {
+  Graph* g = new Graph(OpRegistry::Global());
+  BuildTree(4096, g);
+  use_linear_schedule_ = true;
+  Create(g);
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
+TEST_F(ExecutorTest, SelfAddLinearScheduleWithStats) {
+  Graph* g = new Graph(OpRegistry::Global());
+  auto v = test::graph::Recv(g, "a", "float", ALICE, 1, BOB);
+  for (int i = 1; i <= 10; ++i) {
+    v = test::graph::Add(g, v, v);
+  }
+  test::graph::Send(g, v, "b", BOB, 1, ALICE);
+  use_linear_schedule_ = true;
+  Create(g);
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(1024.0, V(out));
+  step_stats_collector_.Finalize();
+  ASSERT_EQ(1, step_stats_.dev_stats_size());
+  // The source, sink and 10 Add nodes; transfer nodes are not recorded.
+  EXPECT_EQ(12, step_stats_.dev_stats(0).node_stats_size());
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -278,6 +339,24 @@ TEST_F(ExecutorTest, ConcurrentAddAssign) {
     rendez->Unref();
   }
 }
+
+TEST_F(ExecutorTest, ConcurrentAddAssignWorkStealing) {
+  Graph* g = new Graph(OpRegistry::Global());
+  BuildConcurrentAddAssign(g);
+  num_work_stealing_workers_ = 4;
+  Create(g);
+  for (int iters = 0; iters < 16; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    TF_ASSERT_OK(Run(rendez));
+    Rendezvous::Args args;
+    Tensor out;
+    bool is_dead;
+    TF_ASSERT_OK(rendez->Recv(Key(ALICE, kIncarnation, BOB, "out"), args, &out,
+                              &is_dead));
+    EXPECT_LE(V(out), 1025.0);
+    rendez->Unref();
+  }
+}
 #endif
 
 TEST_F(ExecutorTest, SimpleSwitchLive) {
@@ -317,6 +396,83 @@ TEST_F(ExecutorTest, SimpleSwitchDead) {
   EXPECT_TRUE(is_dead);
 }
 
+// Adds to "g" a loop that counts from 0 to "num_iterations" and returns
+// the Exit node that produces the final count.
+Node* BuildWhileLoop(Graph* g, int num_iterations, int parallel_iterations) {
+  const string frame_name = "while";
+  auto enter = [g, &frame_name, parallel_iterations](Node* input,
+                                                     bool is_constant) {
+    Node* ret;
+    TF_CHECK_OK(NodeBuilder(g->NewName("enter"), "Enter")
+                    .Input(input)
+                    .Attr("frame_name", frame_name)
+                    .Attr("is_constant", is_constant)
+                    .Attr("parallel_iterations", parallel_iterations)
+                    .Finalize(g, &ret));
+    return ret;
+  };
+  Node* start = enter(test::graph::Constant(g, V(0.0)), false);
+  Node* limit = enter(test::graph::Constant(g, V(num_iterations)), true);
+  Node* one = enter(test::graph::Constant(g, V(1.0)), true);
+
+  const string next_name = g->NewName("next");
+  Node* merge;
+  TF_CHECK_OK(NodeBuilder(g->NewName("merge"), "Merge")
+                  .Input({NodeBuilder::NodeOut(start),
+                          NodeBuilder::NodeOut(next_name, 0, DT_FLOAT)})
+                  .Finalize(g, &merge));
+  Node* cond = test::graph::LoopCond(g, test::graph::Less(g, merge, limit));
+  Node* switch_node = test::graph::Switch(g, merge, cond);
+  Node* add;
+  TF_CHECK_OK(NodeBuilder(g->NewName("add"), "Add")
+                  .Input(switch_node, 1)
+                  .Input(one)
+                  .Finalize(g, &add));
+  Node* next;
+  TF_CHECK_OK(
+      NodeBuilder(next_name, "NextIteration").Input(add).Finalize(g, &next));
+  g->AddEdge(next, 0, merge, 1);
+  return test::graph::Exit(g, switch_node);
+}
+
+TEST_F(ExecutorTest, WhileLoop) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* exit = BuildWhileLoop(g, 1000, 2);
+  test::graph::Send(g, exit, "c", BOB, 1, ALICE);
+  Create(g);
+  Rendezvous::Args args;
+  // Iteration states are recycled across the steps' many iterations.
+  for (int i = 0; i < 3; ++i) {
+    TF_ASSERT_OK(Run(rendez_));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(rendez_->Recv(Key(BOB, kIncarnation, ALICE, "c"), args, &out,
+                               &is_dead));
+    EXPECT_EQ(1000.0, V(out));
+    EXPECT_FALSE(is_dead);
+  }
+}
+
+TEST_F(ExecutorTest, SimpleSwitchDeadLinearSchedule) {
+  // Graphs with control flow fall back to the default executor.
+  Graph* g = new Graph(OpRegistry::Global());
+  auto in0 = test::graph::Recv(g, "a", "float", ALICE, 1, BOB);
+  auto in1 = test::graph::Constant(g, VB(true));
+  auto tmp = test::graph::Switch(g, in0, in1);
+  test::graph::Send(g, tmp, "c", BOB, 1, ALICE);
+  use_linear_schedule_ = true;
+  Create(g);
+  Rendezvous::Args args;
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0),
+                             false));  // in0 = 1.0
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "c"), args, &out, &is_dead));
+  EXPECT_TRUE(is_dead);
+}
+
 TEST_F(ExecutorTest, Abort) {
   // e = a + b + c + d
   Graph* g = new Graph(OpRegistry::Global());
@@ -395,6 +551,32 @@ TEST_F(ExecutorTest, RecvInvalidDtype) {
   rendez->Unref();
 }
 
+TEST_F(ExecutorTest, RecvInvalidDtypeLinearSchedule) {
+  Graph* g = new Graph(OpRegistry::Global());
+  // An input vector of type float of size 1.
+  auto one = test::graph::Recv(g, "one", "float", ALICE, 1, BOB);
+  // A floating point variable vector of size 1.
+  auto var = test::graph::Var(g, DT_FLOAT, TensorShape({1}));
+  // Initialize the variable with input.
+  auto init = test::graph::Assign(g, var, one);
+  // Output
+  auto* two = test::graph::Send(g, var, "two", BOB, 1, ALICE);
+  g->AddControlEdge(init, two);  // Ensures run after init.
+  use_linear_schedule_ = true;
+  Create(g);
+  Rendezvous* rendez = NewLocalRendezvous();
+  // Send a double instead of float.
+  TF_ASSERT_OK(rendez->Send(Key(ALICE, 1, BOB, "one"), Rendezvous::Args(),
+                            VD(1.0), false));
+  // Fails due to invalid dtype.
+  EXPECT_TRUE(errors::IsInternal(Run(rendez)));
+  Tensor output;
+  bool is_dead;
+  EXPECT_TRUE(errors::IsInternal(rendez->Recv(
+      Key(BOB, 1, ALICE, "two"), Rendezvous::Args(), &output, &is_dead)));
+  rendez->Unref();
+}
+
 TEST_F(ExecutorTest, RecvInvalidRefDtype) {
   Graph* g = new Graph(OpRegistry::Global());
   // A var that always produces as invalid dtype.
@@ -410,4 +592,20 @@ TEST_F(ExecutorTest, RecvInvalidRefDtype) {
   rendez->Unref();
 }
 
+// Measures loop iterations per second for various parallel_iterations.
+static void BM_WhileLoop(int iters, int num_iterations,
+                         int parallel_iterations) {
+  Graph* g = new Graph(OpRegistry::Global());
+  BuildWhileLoop(g, num_iterations, parallel_iterations);
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_iterations);
+  testing::UseRealTime();
+  test::Benchmark("cpu", g).Run(iters);
+}
+BENCHMARK(BM_WhileLoop)
+    ->ArgPair(1000, 1)
+    ->ArgPair(1000, 10)
+    ->ArgPair(10000, 1)
+    ->ArgPair(10000, 10)
+    ->ArgPair(10000, 32);
+
 }  // namespace tensorflow
@@ -39,6 +39,8 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_partition.h"
 #include "tensorflow/core/graph/validate.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
@@ -49,6 +51,13 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// The session under which the shared graphs hold their stateful kernels.
+const char* const kSharedGraphSession = "/_shared_graphs";
+
+}  // namespace
+
 GraphMgr::GraphMgr(const WorkerEnv* worker_env, DeviceMgr* device_mgr)
     : worker_env_(worker_env), device_mgr_(device_mgr), table_(5) {
   // The default value of sync_on_finish will be flipped soon and this
@@ -58,10 +67,16 @@ GraphMgr::GraphMgr(const WorkerEnv* worker_env, DeviceMgr* device_mgr)
   if (!status.ok()) {
     LOG(ERROR) << status.error_message();
   }
+  status = ReadInt64FromEnvVar("TF_GRAPH_MGR_SHARED_GRAPHS", 16,
+                               &max_shared_items_);
+  if (!status.ok()) {
+    LOG(ERROR) << status.error_message();
+  }
 }
 
 GraphMgr::~GraphMgr() {
   for (auto p : table_) p.second->Unref();
+  for (const SharedItem& shared : shared_items_) shared.item->Unref();
 }
 
 GraphMgr::Item::~Item() {
@@ -275,25 +290,71 @@ Status GraphMgr::Register(const string& session, const GraphDef& gdef,
                           const GraphOptions& graph_options,
                           const DebugOptions& debug_options,
                           DistributedFunctionLibraryRuntime* cluster_flr,
-                          string* handle) {
+                          bool share, string* handle) {
+  share = share && debug_options.debug_tensor_watch_opts().empty() &&
+          max_shared_items_ > 0;
+  Fprint128 fingerprint = {0, 0};
+  if (share) {
+    string key;
+    string options;
+    if (!SerializeToStringDeterministic(gdef, &key) ||
+        !SerializeToStringDeterministic(graph_options, &options)) {
+      return errors::InvalidArgument("Cannot serialize the graph to share it");
+    }
+    strings::StrAppend(&key, options);
+    fingerprint = Fingerprint128(key);
+    mutex_lock l(mu_);
+    for (auto it = shared_items_.begin(); it != shared_items_.end(); ++it) {
+      if (it->fingerprint == fingerprint) {
+        it->item->Ref();
+        AddToTableLocked(it->item, handle);
+        shared_items_.splice(shared_items_.begin(), shared_items_, it);
+        return Status::OK();
+      }
+    }
+  }
+
   Item* item = new Item;
-  Status s =
-      InitItem(session, gdef, graph_options, debug_options, cluster_flr, item);
+  Status s = InitItem(share ? kSharedGraphSession : session, gdef,
+                      graph_options, debug_options, cluster_flr, item);
   if (!s.ok()) {
     item->Unref();
     return s;
   }
 
   // Inserts one item into table_.
+  Item* evicted = nullptr;
   {
     mutex_lock l(mu_);
-    *handle = strings::Printf("%016llx", ++next_id_);
-    item->handle = *handle;
-    CHECK(table_.insert({*handle, item}).second);
+    AddToTableLocked(item, handle);
+    if (share) {
+      // If an identical graph was registered concurrently, this one is not
+      // kept for sharing.
+      bool found = false;
+      for (const SharedItem& shared : shared_items_) {
+        found = found || shared.fingerprint == fingerprint;
+      }
+      if (!found) {
+        item->Ref();
+        shared_items_.push_front({fingerprint, item});
+        if (shared_items_.size() > static_cast<size_t>(max_shared_items_)) {
+          evicted = shared_items_.back().item;
+          shared_items_.pop_back();
+        }
+      }
+    }
   }
+  if (evicted != nullptr) evicted->Unref();
   return Status::OK();
 }
 
+void GraphMgr::AddToTableLocked(Item* item, string* handle) {
+  *handle = strings::Printf("%016llx", ++next_id_);
+  // A shared item keeps the handle under which it was first registered.
+  if (item->handle.empty()) item->handle = *handle;
+  CHECK(table_.insert({*handle, item}).second);
+}
+
 Status GraphMgr::Deregister(const string& handle) {
   Item* item = nullptr;
   // Removes one item from table_.
@@ -320,6 +381,10 @@ Status GraphMgr::DeregisterAll() {
       items.push_back(entry.second);
     }
     table_.clear();
+    for (const SharedItem& shared : shared_items_) {
+      items.push_back(shared.item);
+    }
+    shared_items_.clear();
   }
   for (auto item : items) {
     item->Unref();
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_GRAPH_MGR_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_GRAPH_MGR_H_
 
+#include <list>
 #include <unordered_map>
 #include <vector>
 
@@ -28,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/framework/cost_graph.pb.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -73,10 +75,18 @@ class GraphMgr {
 
   // Registers a graph. Fills in "handle". The registered graph retains a
   // reference to cluster_flr to do cross process function calls.
+  //
+  // If "share" is true, the graph reuses the executors and kernels of an
+  // identical graph with the same options that was registered with "share"
+  // before, by any session, and is kept for reuse after it is deregistered,
+  // until it is one of the least recently registered among more than
+  // TF_GRAPH_MGR_SHARED_GRAPHS of them. The shared graphs hold their
+  // stateful kernels in the op segments as if they all belonged to one
+  // session. Graphs with debug watches are never shared.
   Status Register(const string& session, const GraphDef& gdef,
                   const GraphOptions& graph_options,
                   const DebugOptions& debug_options,
-                  DistributedFunctionLibraryRuntime* cluster_flr,
+                  DistributedFunctionLibraryRuntime* cluster_flr, bool share,
                   string* handle);
 
   // Executes one step of a registered graph "handle".
@@ -100,7 +110,7 @@ class GraphMgr {
   // Deregisters a graph.
   Status Deregister(const string& handle);
 
-  // Deregister all graphs.
+  // Deregister all graphs, including the ones kept for sharing.
   Status DeregisterAll();
 
  private:
@@ -159,6 +169,20 @@ class GraphMgr {
   // mechanism to gc these graphs.
   std::unordered_map<string, Item*> table_;
 
+  // The graphs registered with "share", most recently registered first.
+  // Each one holds a reference to its item, which keeps it alive after it
+  // is deregistered.
+  struct SharedItem {
+    Fprint128 fingerprint;
+    Item* item;
+  };
+  std::list<SharedItem> shared_items_ GUARDED_BY(mu_);
+  int64 max_shared_items_ = 16;
+
+  // Adds "item" to table_ under a new handle, which is stored in "handle".
+  void AddToTableLocked(Item* item, string* handle)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   void StartParallelExecutors(const string& handle, int64 step_id, Item* item,
                               Rendezvous* rendezvous,
                               StepStatsCollector* collector,
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/debug/debug_graph_utils.h"
 #include "tensorflow/core/distributed_runtime/scheduler.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
+#include "tensorflow/core/distributed_runtime/worker_cache_logger.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/cost_graph.pb.h"
@@ -55,6 +56,21 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// Moves the timestamps of `ss`, which were taken on a clock that is
+// `offset_micros` ahead of the local one, to the local clock.
+void AlignStepStats(int64 offset_micros, StepStats* ss) {
+  if (offset_micros == 0) return;
+  for (DeviceStepStats& ds : *ss->mutable_dev_stats()) {
+    for (NodeExecStats& ns : *ds.mutable_node_stats()) {
+      ns.set_all_start_micros(ns.all_start_micros() - offset_micros);
+    }
+  }
+}
+
+}  // namespace
+
 // MasterSession wraps ClientGraph in a reference counted object.
 // This way, MasterSession can clear up the cache mapping Run requests to
 // compiled graphs while the compiled graph is still being used.
@@ -122,7 +138,15 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   // Retrieve all RPC logs data accumulated for the current step, both
   // from the local WorkerCache in use by this master process and from
   // all the remote workers executing the remote partitions.
-  void RetrieveLogs(int64 step_id, StepStats* ss) {
+  //
+  // The round trip of the request to each worker also gives an estimate of
+  // the offset of its clock, which is stored in (*clock_offsets)[i] for
+  // partition i, and by which its logs are moved to the local clock. The
+  // offset is 0 when it is within the error of the estimate, as for the
+  // workers on the same host.
+  void RetrieveLogs(int64 step_id, StepStats* ss,
+                    std::vector<int64>* clock_offsets) {
+    clock_offsets->assign(partitions_.size(), 0);
     // Get the local data first, because it sets *ss without merging.
     worker_cache_->RetrieveLogs(step_id, ss);
 
@@ -133,20 +157,31 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
     if (waiting_for > 0) {
       mutex scoped_mu;
       BlockingCounter all_done(waiting_for);
-      for (auto& p : partitions_) {
+      for (size_t i = 0; i < partitions_.size(); ++i) {
         LoggingResponse* resp = new LoggingResponse;
-        p.worker->LoggingAsync(
+        const int64 sent_micros = Env::Default()->NowMicros();
+        partitions_[i].worker->LoggingAsync(
             &req, resp,
-            [step_id, ss, resp, &scoped_mu, &waiting_for,
-             &all_done](const Status& s) {
+            [step_id, ss, resp, &scoped_mu, &waiting_for, &all_done,
+             clock_offsets, i, sent_micros](const Status& s) {
               {
                 mutex_lock l(scoped_mu);
                 if (s.ok()) {
-                  for (auto& lss : resp->step()) {
+                  int64 offset = 0;
+                  if (resp->now_micros() > 0) {
+                    int64 delay;
+                    WorkerCacheLogger::EstimateClockOffset(
+                        sent_micros, resp->now_micros(), resp->now_micros(),
+                        Env::Default()->NowMicros(), &offset, &delay);
+                    if (std::abs(offset) <= delay / 2) offset = 0;
+                  }
+                  (*clock_offsets)[i] = offset;
+                  for (auto& lss : *resp->mutable_step()) {
                     if (step_id != lss.step_id()) {
                       LOG(ERROR) << "Wrong step_id in LoggingResponse";
                       continue;
                     }
+                    AlignStepStats(offset, lss.mutable_step_stats());
                     ss->MergeFrom(lss.step_stats());
                   }
                 }
@@ -406,6 +441,8 @@ Status MasterSession::ReffedClientGraph::DoRegisterPartitions(
     c->req.mutable_graph_def()->Swap(&graph_partitions[part.name]);
     *c->req.mutable_graph_options() = session_opts_.config.graph_options();
     *c->req.mutable_debug_options() = debug_opts_;
+    c->req.set_share_graph(
+        session_opts_.config.experimental().share_registered_graphs());
     VLOG(2) << "Register " << c->req.graph_def().DebugString();
     auto cb = [c, &done](const Status& s) {
       c->status = s;
@@ -727,7 +764,11 @@ void MasterSession::ReffedClientGraph::ProcessStats(int64 step_id,
   // Out-of-band logging data is collected now, during post-processing.
   if (pss->collect_timeline) {
     SetRPCLogging(false);
-    RetrieveLogs(step_id, &pss->rpc_stats);
+    std::vector<int64> clock_offsets;
+    RetrieveLogs(step_id, &pss->rpc_stats, &clock_offsets);
+    for (size_t i = 0; i < partitions_.size(); ++i) {
+      AlignStepStats(clock_offsets[i], &pss->step_stats[i]);
+    }
   }
   for (size_t i = 0; i < partitions_.size(); ++i) {
     const StepStats& ss = pss->step_stats[i];
@@ -1270,6 +1311,43 @@ Status MasterSession::PartialRunSetup(const PartialRunSetupRequest* req,
   return Status::OK();
 }
 
+struct MasterSession::PipelinedStep {
+  // The signature of the Run calls that the step can serve.
+  string signature;
+  MutableProtoRunStepRequest req;
+  InMemoryRunStepResponse resp;
+  CallOptions call_opts;
+  Status status;
+  Notification done;
+};
+
+namespace {
+
+// Whether the step of `req` can be repeated ahead of the client: it has no
+// feeds, which could change from one call to the next, and collects nothing
+// that is specific to one step.
+bool IsPipelinable(const RunStepRequestWrapper& req) {
+  const RunOptions& options = req.options();
+  return req.num_feeds() == 0 &&
+         options.trace_level() == RunOptions::NO_TRACE &&
+         options.debug_options().debug_tensor_watch_opts().empty() &&
+         !options.output_partition_graphs();
+}
+
+string PipelineSignature(const RunStepRequestWrapper& req) {
+  string signature;
+  for (size_t i = 0; i < req.num_fetches(); ++i) {
+    strings::StrAppend(&signature, "F", req.fetch_name(i), ";");
+  }
+  for (size_t i = 0; i < req.num_targets(); ++i) {
+    strings::StrAppend(&signature, "T", req.target_name(i), ";");
+  }
+  strings::StrAppend(&signature, req.options().SerializeAsString());
+  return signature;
+}
+
+}  // namespace
+
 Status MasterSession::Run(CallOptions* opts, const RunStepRequestWrapper& req,
                           MutableRunStepResponseWrapper* resp) {
   UpdateLastAccessTime();
@@ -1285,12 +1363,84 @@ Status MasterSession::Run(CallOptions* opts, const RunStepRequestWrapper& req,
   Status status;
   if (!req.partial_run_handle().empty()) {
     status = DoPartialRun(opts, req, resp);
+  } else if (session_opts_.config.experimental().step_pipeline_depth() > 0 &&
+             IsPipelinable(req)) {
+    status = DoRunPipelined(opts, req, resp);
   } else {
     status = DoRunWithLocalExecution(opts, req, resp);
   }
   return status;
 }
 
+Status MasterSession::DoRunPipelined(CallOptions* opts,
+                                     const RunStepRequestWrapper& req,
+                                     MutableRunStepResponseWrapper* resp) {
+  const int depth = session_opts_.config.experimental().step_pipeline_depth();
+  const string signature = PipelineSignature(req);
+  std::shared_ptr<PipelinedStep> step;
+  std::vector<std::shared_ptr<PipelinedStep>> to_start;
+  {
+    mutex_lock l(mu_);
+    // The steps started for a different call are left to run to completion,
+    // and their results are dropped.
+    while (!pipelined_steps_.empty() &&
+           pipelined_steps_.front()->signature != signature) {
+      pipelined_steps_.pop_front();
+    }
+    if (!pipelined_steps_.empty()) {
+      step = pipelined_steps_.front();
+      pipelined_steps_.pop_front();
+    }
+    // Only a call that repeats the previous one is expected to repeat again,
+    // which keeps one-off calls, e.g. of initializers, from being re-run.
+    const bool repeated = signature == last_run_signature_;
+    last_run_signature_ = signature;
+    while (repeated && !closed_ &&
+           pipelined_steps_.size() < static_cast<size_t>(depth)) {
+      std::shared_ptr<PipelinedStep> ahead(new PipelinedStep);
+      ahead->signature = signature;
+      ahead->req.set_session_handle(req.session_handle());
+      for (size_t i = 0; i < req.num_fetches(); ++i) {
+        ahead->req.add_fetch(req.fetch_name(i));
+      }
+      for (size_t i = 0; i < req.num_targets(); ++i) {
+        ahead->req.add_target(req.target_name(i));
+      }
+      *ahead->req.mutable_options() = req.options();
+      pipelined_steps_.push_back(ahead);
+      to_start.push_back(ahead);
+      // Balanced by MarkRunCompletion() in DoRunWithLocalExecution().
+      ++num_running_;
+    }
+  }
+  for (const std::shared_ptr<PipelinedStep>& ahead : to_start) {
+    Ref();
+    env_->env->SchedClosure([this, ahead]() {
+      ahead->status =
+          DoRunWithLocalExecution(&ahead->call_opts, ahead->req, &ahead->resp);
+      ahead->done.Notify();
+      Unref();
+    });
+  }
+
+  if (step == nullptr) {
+    return DoRunWithLocalExecution(opts, req, resp);
+  }
+  MarkRunCompletion();
+  step->done.WaitForNotification();
+  TF_RETURN_IF_ERROR(step->status);
+  for (size_t i = 0; i < step->resp.num_tensors(); ++i) {
+    const string& name = step->resp.tensor_name(i);
+    Tensor value;
+    TF_RETURN_IF_ERROR(step->resp.TensorValue(i, &value));
+    InMemoryRunGraphResponse values;
+    values.AddRecv(name, value);
+    TF_RETURN_IF_ERROR(resp->AddTensorFromRunGraphResponse(name, &values, 0));
+  }
+  resp->mutable_metadata()->Swap(step->resp.mutable_metadata());
+  return Status::OK();
+}
+
 // Decrements num_running_ and broadcasts if num_running_ is zero.
 void MasterSession::MarkRunCompletion() {
   mutex_lock l(mu_);
@@ -1596,6 +1746,7 @@ Status MasterSession::Close() {
     }
     ClearRunsTable(&to_unref, &run_graphs_);
     ClearRunsTable(&to_unref, &partial_run_graphs_);
+    pipelined_steps_.clear();
   }
   for (ReffedClientGraph* rcg : to_unref) rcg->Unref();
   return Status::OK();
@@ -17,6 +17,8 @@ limitations under the License.
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_MASTER_SESSION_H_
 
 #include <atomic>
+#include <deque>
+#include <memory>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/debugger_state_interface.h"
@@ -190,6 +192,13 @@ class MasterSession : public core::RefCounted {
   // Used to cancel running steps on Close().
   CancellationManager cancellation_manager_;
 
+  // The steps started ahead of the client, oldest first, all with the
+  // signature of the last Run call. See
+  // `ConfigProto.Experimental.step_pipeline_depth`.
+  struct PipelinedStep;
+  std::deque<std::shared_ptr<PipelinedStep>> pipelined_steps_ GUARDED_BY(mu_);
+  string last_run_signature_ GUARDED_BY(mu_);
+
   // Private dtor. The client must call Close().
   virtual ~MasterSession();
 
@@ -207,6 +216,10 @@ class MasterSession : public core::RefCounted {
   Status DoRunWithLocalExecution(CallOptions* opts,
                                  const RunStepRequestWrapper& req,
                                  MutableRunStepResponseWrapper* resp);
+  // Serves a Run call from the steps started ahead of the client, when the
+  // step pipeline is enabled and the call is eligible.
+  Status DoRunPipelined(CallOptions* opts, const RunStepRequestWrapper& req,
+                        MutableRunStepResponseWrapper* resp);
   Status DoPartialRun(CallOptions* opts, const RunStepRequestWrapper& req,
                       MutableRunStepResponseWrapper* resp);
   void MarkRunCompletion();
@@ -26,12 +26,14 @@ limitations under the License.
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/graph/testlib.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test.h"
@@ -61,10 +63,12 @@ class MasterTest : public ::testing::Test {
   // rpc calls.
 
   Status CreateSession(const GraphDef& def, string* handle,
-                            int64* initial_version) {
+                       int64* initial_version,
+                       const ConfigProto& config = ConfigProto()) {
     ::grpc::ClientContext ctx;
     CreateSessionRequest req;
     *(req.mutable_graph_def()) = def;
+    *(req.mutable_config()) = config;
     // Invokes placement frequently.
     req.mutable_config()->set_placement_period(1);
     CreateSessionResponse resp;
@@ -421,4 +425,90 @@ TEST_F(MasterTest, EigenProblem) {
   TF_EXPECT_OK(CloseSession(handle));
 }
 
+TEST_F(MasterTest, PipelinedSteps) {
+  Graph graph(OpRegistry::Global());
+  Tensor zero(DT_FLOAT, TensorShape({}));
+  zero.scalar<float>()() = 0;
+  Tensor one(DT_FLOAT, TensorShape({}));
+  one.scalar<float>()() = 1;
+  Node* var = test::graph::Var(&graph, DT_FLOAT, TensorShape({}));
+  Node* init = test::graph::Assign(
+      &graph, var, test::graph::Constant(&graph, zero, "zero"));
+  Node* incr;
+  TF_ASSERT_OK(NodeBuilder(graph.NewName("incr"), "AssignAdd")
+                   .Input(var)
+                   .Input(test::graph::Constant(&graph, one))
+                   .Attr("use_locking", true)
+                   .Finalize(&graph, &incr));
+  Node* read = test::graph::Identity(&graph, var);
+  GraphDef def;
+  test::graph::ToGraphDef(&graph, &def);
+
+  ConfigProto config;
+  config.mutable_experimental()->set_step_pipeline_depth(2);
+  string handle;
+  int64 initial_version;
+  TF_ASSERT_OK(CreateSession(def, &handle, &initial_version, config));
+
+  // The initializer is fed, so it is never run ahead.
+  Tensor value(DT_FLOAT, TensorShape({}));
+  TF_ASSERT_OK(RunStep(handle, {{"zero:0", &zero}},
+                       {{init->name() + ":0", &value}}));
+  // The first call runs on its own. The second one repeats it, so it starts
+  // two steps ahead, and the third one claims one of them and starts another.
+  for (int i = 0; i < 3; ++i) {
+    TF_ASSERT_OK(RunStep(handle, {}, {{incr->name() + ":0", &value}}));
+  }
+  // The two unclaimed steps still run to completion.
+  float count = 0;
+  for (int i = 0; i < 100 && count != 5; ++i) {
+    Env::Default()->SleepForMicroseconds(10000);
+    TF_ASSERT_OK(RunStep(handle, {}, {{read->name() + ":0", &value}}));
+    count = value.scalar<float>()();
+  }
+  EXPECT_EQ(5, count);
+  TF_EXPECT_OK(CloseSession(handle));
+}
+
+TEST_F(MasterTest, SharedRegisteredGraphs) {
+  Graph graph(OpRegistry::Global());
+  Node* random;
+  TF_ASSERT_OK(
+      NodeBuilder(graph.NewName("random"), "RandomUniform")
+          .Input(test::graph::Constant(&graph, test::AsTensor<int32>({4})))
+          .Attr("dtype", DT_FLOAT)
+          .Attr("seed", 1)
+          .Attr("seed2", 2)
+          .Finalize(&graph, &random));
+  GraphDef def;
+  test::graph::ToGraphDef(&graph, &def);
+
+  // Runs the random op once in a new session.
+  auto first_values = [this, &def, random](bool share, Tensor* values) {
+    ConfigProto config;
+    config.mutable_experimental()->set_share_registered_graphs(share);
+    string handle;
+    int64 initial_version;
+    TF_ASSERT_OK(CreateSession(def, &handle, &initial_version, config));
+    TF_ASSERT_OK(RunStep(handle, {}, {{random->name() + ":0", values}}));
+    TF_ASSERT_OK(CloseSession(handle));
+  };
+
+  // Each session creates the kernel again, which starts the same sequence.
+  Tensor first(DT_FLOAT, TensorShape({4}));
+  Tensor second(DT_FLOAT, TensorShape({4}));
+  first_values(false, &first);
+  first_values(false, &second);
+  test::ExpectTensorEqual<float>(first, second);
+
+  // The second sharing session reuses the kernel of the first one, which
+  // continues its sequence.
+  Tensor shared_first(DT_FLOAT, TensorShape({4}));
+  Tensor shared_second(DT_FLOAT, TensorShape({4}));
+  first_values(true, &shared_first);
+  first_values(true, &shared_second);
+  test::ExpectTensorEqual<float>(first, shared_first);
+  EXPECT_NE(shared_first.vec<float>()(0), shared_second.vec<float>()(0));
+}
+
 }  // namespace tensorflow
@@ -57,6 +57,11 @@ Status ValidateHostPortPair(const string& host_port) {
 
 Status NewHostPortGrpcChannel(const string& target,
                               SharedGrpcChannelPtr* channel_pointer) {
+  return NewHostPortGrpcChannel(target, 0, channel_pointer);
+}
+
+Status NewHostPortGrpcChannel(const string& target, int channel_index,
+                              SharedGrpcChannelPtr* channel_pointer) {
   // Minimally ensure that the target is valid
   TF_RETURN_IF_ERROR(ValidateHostPortPair(target));
 
@@ -66,6 +71,11 @@ Status NewHostPortGrpcChannel(const string& target,
   // NOTE(mrry): Some versions of gRPC use a 20-second minimum backoff
   // on connection failure, which makes our tests time out.
   args.SetInt("grpc.testing.fixed_reconnect_backoff_ms", 1000);
+  // Channels with the same arguments share their connection, so the index
+  // is what gives each additional channel a connection of its own.
+  if (channel_index > 0) {
+    args.SetInt("tensorflow.grpc_channel_index", channel_index);
+  }
   *channel_pointer = ::grpc::CreateCustomChannel(
       "dns:///" + target, ::grpc::InsecureChannelCredentials(), args);
   return Status::OK();
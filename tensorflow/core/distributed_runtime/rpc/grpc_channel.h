@@ -91,6 +91,11 @@ ChannelCreationFunction ConvertToChannelCreationFunction(
 Status NewHostPortGrpcChannel(const string& target,
                               SharedGrpcChannelPtr* channel_pointer);
 
+// Like above, but channels to the same target with different
+// `channel_index` values use separate connections.
+Status NewHostPortGrpcChannel(const string& target, int channel_index,
+                              SharedGrpcChannelPtr* channel_pointer);
+
 }  // namespace tensorflow
 
 #endif  // THIRD_PARTY_TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_CHANNEL_H_
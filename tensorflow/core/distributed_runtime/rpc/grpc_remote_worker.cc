@@ -15,7 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_remote_worker.h"
 
+#include <atomic>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include "grpc++/generic/generic_stub.h"
 #include "grpc++/grpc++.h"
@@ -27,6 +30,8 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker_cache_logger.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/strings/str_util.h"
@@ -36,6 +41,35 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// A TensorBuffer that holds a reference to the gRPC slice it points into.
+class SliceTensorBuffer : public TensorBuffer {
+ public:
+  SliceTensorBuffer(const ::grpc::Slice& slice, const char* data, size_t size)
+      : slice_(slice), data_(data), size_(size) {}
+
+  void* data() const override { return const_cast<char*>(data_); }
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("GrpcSlice");
+  }
+
+  // The slice may be shared with gRPC, so the memory must not be forwarded.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  ~SliceTensorBuffer() override {}
+
+  const ::grpc::Slice slice_;
+  const char* const data_;
+  const size_t size_;
+};
+
+}  // namespace
+
 // Overload of GrpcParseProto so we can decode a TensorResponse without
 // extra copying.
 bool GrpcParseProto(const ::grpc::ByteBuffer& src, TensorResponse* dst) {
@@ -48,6 +82,12 @@ bool GrpcParseProto(const ::grpc::ByteBuffer& src, TensorResponse* dst) {
       ok = src.Init(*buffer);
       return &src;
     }
+
+    TensorBuffer* ShareContents(const char* data, size_t size) override {
+      ::grpc::Slice slice;
+      if (!src.FindSlice(data, size, &slice)) return nullptr;
+      return new SliceTensorBuffer(slice, data, size);
+    }
   };
   ByteSource bs;
   bs.buffer = &src;
@@ -56,14 +96,14 @@ bool GrpcParseProto(const ::grpc::ByteBuffer& src, TensorResponse* dst) {
 
 class GrpcRemoteWorker : public WorkerInterface {
  public:
-  explicit GrpcRemoteWorker(GrpcCounter* live_rpc_counter,
-                            SharedGrpcChannelPtr channel,
-                            ::grpc::CompletionQueue* completion_queue,
-                            WorkerCacheLogger* logger)
+  explicit GrpcRemoteWorker(
+      GrpcCounter* live_rpc_counter, std::vector<SharedGrpcChannelPtr> channels,
+      std::vector<::grpc::CompletionQueue*> completion_queues,
+      WorkerCacheLogger* logger)
       : counter_(live_rpc_counter),
-        channel_(std::move(channel)),
-        stub_(channel_),
-        cq_(completion_queue),
+        channels_(std::move(channels)),
+        cqs_(std::move(completion_queues)),
+        next_tensor_rpc_(0),
         getstatus_(Method(GrpcWorkerMethod::kGetStatus)),
         createworkersession_(Method(GrpcWorkerMethod::kCreateWorkerSession)),
         registergraph_(Method(GrpcWorkerMethod::kRegisterGraph)),
@@ -72,9 +112,16 @@ class GrpcRemoteWorker : public WorkerInterface {
         cleanupgraph_(Method(GrpcWorkerMethod::kCleanupGraph)),
         cleanupall_(Method(GrpcWorkerMethod::kCleanupAll)),
         recvtensor_(Method(GrpcWorkerMethod::kRecvTensor)),
+        recvtensors_(Method(GrpcWorkerMethod::kRecvTensors)),
         logging_(Method(GrpcWorkerMethod::kLogging)),
         tracing_(Method(GrpcWorkerMethod::kTracing)),
-        logger_(logger) {}
+        logger_(logger) {
+    CHECK(!channels_.empty());
+    CHECK(!cqs_.empty());
+    for (const SharedGrpcChannelPtr& channel : channels_) {
+      stubs_.emplace_back(new ::grpc::GenericStub(channel));
+    }
+  }
 
   ~GrpcRemoteWorker() override {}
 
@@ -133,40 +180,33 @@ class GrpcRemoteWorker : public WorkerInterface {
     bool logging_active = logger_->LoggingActive() || VLOG_IS_ON(2);
     StatusCallback wrapper_done;
     const StatusCallback* cb_to_use;
+    // The time at which the response arrived, before it is parsed.
+    std::shared_ptr<int64> received_usec;
     if (!logging_active) {
       cb_to_use = &done;  // No additional work to do, so just use done directly
     } else {
-      wrapper_done = [this, request, response, done, start_usec](Status s) {
+      received_usec = std::make_shared<int64>(0);
+      wrapper_done = [this, request, response, done, start_usec,
+                      received_usec](Status s) {
         if (logger_->LoggingActive()) {
-          int64 end_usec = Env::Default()->NowMicros();
+          WorkerCacheLogger::RecvTensorTimes times;
+          times.request_sent_micros = start_usec;
+          times.recv_done_micros = Env::Default()->NowMicros();
+          times.response_received_micros =
+              *received_usec > 0 ? *received_usec : times.recv_done_micros;
+          // The timestamps reported by the other side are on its clock,
+          // which the logger aligns with ours.
+          times.request_received_micros =
+              response->metadata().request_received_micros();
+          times.send_start_micros = response->metadata().send_start_micros();
           int64 step_id = request->step_id();
           int64 bytes = response->tensor().TotalBytes();
-          int64 send_start_usec = start_usec;
-          // If a send start time was reported by the other side, use
-          // that instead.  Maybe we should mark the display if we're using
-          // our local time instead of the remote start time?
-          if (response->metadata().send_start_micros()) {
-            // send_start_micros is the timestamp taken when the
-            // remote machine began to send the RecvTensor response.
-            // Due to clock skew between source and dest machines, it
-            // is possible that send_start_micros can be larger than
-            // end_usec or less than start_usec.
-            //
-            // To respect causality, we enforce the invariants that
-            // the RecvTensor response can not have been sent before
-            // the RecvTensor request, and must have been sent before
-            // it was received.
-            send_start_usec = std::max(
-                start_usec,
-                static_cast<int64>(response->metadata().send_start_micros()));
-            send_start_usec = std::min(send_start_usec, end_usec - 1);
-          }
           const string& key = request->rendezvous_key();
           std::vector<string> key_parts = str_util::Split(key, ';');
           if (key_parts.size() != 5) {
             LOG(WARNING) << "Bad key: " << key;
           } else {
-            logger_->RecordRecvTensor(step_id, send_start_usec, end_usec,
+            logger_->RecordRecvTensor(step_id, times,
                                       key_parts[3],  // tensor name
                                       key_parts[0],  // src_device
                                       key_parts[2],  // dst_device
@@ -180,7 +220,16 @@ class GrpcRemoteWorker : public WorkerInterface {
       cb_to_use = &wrapper_done;
     }
 
-    IssueRequest(request, response, recvtensor_, *cb_to_use, call_opts);
+    IssueRequest(request, response, recvtensor_, *cb_to_use, call_opts,
+                 NextTensorRpc(), received_usec.get());
+  }
+
+  void RecvTensorsAsync(CallOptions* call_opts,
+                        const RecvTensorsRequest* request,
+                        RecvTensorsResponse* response,
+                        StatusCallback done) override {
+    IssueRequest(request, response, recvtensors_, std::move(done), call_opts,
+                 NextTensorRpc());
   }
 
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
@@ -201,8 +250,12 @@ class GrpcRemoteWorker : public WorkerInterface {
     RPCState(GrpcCounter* counter, ::grpc::GenericStub* stub,
              ::grpc::CompletionQueue* cq, const ::grpc::string& method,
              const protobuf::Message& request, ResponseMessage* response,
-             StatusCallback done, CallOptions* call_opts)
-        : counter_(counter), call_opts_(call_opts), done_(std::move(done)) {
+             StatusCallback done, CallOptions* call_opts,
+             int64* received_micros = nullptr)
+        : counter_(counter),
+          call_opts_(call_opts),
+          received_micros_(received_micros),
+          done_(std::move(done)) {
       // TODO(sanjay): The counter will no longer be needed once we
       // get a GenericStub API which allows us to manage an entire
       // RPC with a single completion event instead of four events.
@@ -211,6 +264,10 @@ class GrpcRemoteWorker : public WorkerInterface {
       // until we get a response.
       context_.set_fail_fast(false);
       if (call_opts) {
+        const int64 timeout_ms = call_opts->GetTimeout();
+        if (timeout_ms > 0) {
+          context_.set_deadline(gpr_time_from_millis(timeout_ms, GPR_TIMESPAN));
+        }
         call_opts->SetCancelCallback([this]() { context_.TryCancel(); });
       }
 
@@ -267,6 +324,9 @@ class GrpcRemoteWorker : public WorkerInterface {
         if (s.ok() && failure_.load()) {
           s.Update(errors::Internal("callback error"));
         }
+        if (received_micros_ != nullptr) {
+          *received_micros_ = Env::Default()->NowMicros();
+        }
         if (s.ok() && !GrpcParseProto(response_buf_, response_)) {
           s.Update(errors::Internal("could not parse rpc response"));
         }
@@ -282,6 +342,7 @@ class GrpcRemoteWorker : public WorkerInterface {
    private:
     GrpcCounter* const counter_;
     CallOptions* call_opts_;
+    int64* const received_micros_;  // Not owned; may be null.
     ::grpc::ClientContext context_;
     std::unique_ptr<::grpc::GenericClientAsyncReaderWriter> call_;
     ResponseMessage* response_;
@@ -294,29 +355,47 @@ class GrpcRemoteWorker : public WorkerInterface {
     Notification call_initialized_;
   };
 
+  // Returns a number that selects the channel and completion queue of the
+  // next tensor RPC. The tensor RPCs rotate over all the channels and queues,
+  // so that their transfers and callbacks proceed in parallel, while the
+  // other RPCs use the first ones.
+  int NextTensorRpc() {
+    return next_tensor_rpc_.fetch_add(1, std::memory_order_relaxed) &
+           0x7fffffff;
+  }
+
   // Utility method for issuing a generic asynchronous request. The
   // given callback, `done`, will be called when the RPC completes.
   void IssueRequest(const protobuf::Message* request,
                     protobuf::Message* response, const ::grpc::string& method,
-                    StatusCallback done, CallOptions* call_opts = nullptr) {
-    new RPCState<protobuf::Message>(counter_, &stub_, cq_, method, *request,
-                                    response, std::move(done), call_opts);
+                    StatusCallback done, CallOptions* call_opts = nullptr,
+                    int rpc_index = 0) {
+    new RPCState<protobuf::Message>(
+        counter_, stubs_[rpc_index % stubs_.size()].get(),
+        cqs_[rpc_index % cqs_.size()], method, *request, response,
+        std::move(done), call_opts);
   }
+  // If `received_micros` is not null, the time at which the response
+  // arrives is stored there before the response is parsed.
   void IssueRequest(const protobuf::Message* request, TensorResponse* response,
                     const ::grpc::string& method, StatusCallback done,
-                    CallOptions* call_opts = nullptr) {
-    new RPCState<TensorResponse>(counter_, &stub_, cq_, method, *request,
-                                 response, std::move(done), call_opts);
+                    CallOptions* call_opts = nullptr, int rpc_index = 0,
+                    int64* received_micros = nullptr) {
+    new RPCState<TensorResponse>(
+        counter_, stubs_[rpc_index % stubs_.size()].get(),
+        cqs_[rpc_index % cqs_.size()], method, *request, response,
+        std::move(done), call_opts, received_micros);
   }
 
   // Helper function for initializing the RpcMethod objects below.
   const char* Method(GrpcWorkerMethod id) { return GrpcWorkerMethodName(id); }
 
   GrpcCounter* const counter_;
-  SharedGrpcChannelPtr channel_;
-  ::grpc::GenericStub stub_;
+  const std::vector<SharedGrpcChannelPtr> channels_;
+  std::vector<std::unique_ptr<::grpc::GenericStub>> stubs_;
 
-  ::grpc::CompletionQueue* cq_;
+  const std::vector<::grpc::CompletionQueue*> cqs_;  // Not owned.
+  std::atomic<uint32> next_tensor_rpc_;
 
   const ::grpc::string getstatus_;
   const ::grpc::string createworkersession_;
@@ -326,6 +405,7 @@ class GrpcRemoteWorker : public WorkerInterface {
   const ::grpc::string cleanupgraph_;
   const ::grpc::string cleanupall_;
   const ::grpc::string recvtensor_;
+  const ::grpc::string recvtensors_;
   const ::grpc::string logging_;
   const ::grpc::string tracing_;
 
@@ -339,8 +419,16 @@ WorkerInterface* NewGrpcRemoteWorker(GrpcCounter* live_rpc_counter,
                                      SharedGrpcChannelPtr channel,
                                      ::grpc::CompletionQueue* completion_queue,
                                      WorkerCacheLogger* logger) {
-  return new GrpcRemoteWorker(live_rpc_counter, std::move(channel),
-                              completion_queue, logger);
+  return NewGrpcRemoteWorker(live_rpc_counter, {std::move(channel)},
+                             {completion_queue}, logger);
+}
+
+WorkerInterface* NewGrpcRemoteWorker(
+    GrpcCounter* live_rpc_counter, std::vector<SharedGrpcChannelPtr> channels,
+    std::vector<::grpc::CompletionQueue*> completion_queues,
+    WorkerCacheLogger* logger) {
+  return new GrpcRemoteWorker(live_rpc_counter, std::move(channels),
+                              std::move(completion_queues), logger);
 }
 
 }  // namespace tensorflow
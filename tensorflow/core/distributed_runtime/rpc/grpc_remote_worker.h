@@ -17,6 +17,7 @@ limitations under the License.
 #define THIRD_PARTY_TENSORFLOW_DISTRIBUTED_RUNTIME_RPC_GRPC_REMOTE_WORKER_H_
 
 #include <memory>
+#include <vector>
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 
@@ -35,6 +36,14 @@ WorkerInterface* NewGrpcRemoteWorker(GrpcCounter* live_rpc_counter,
                                      ::grpc::CompletionQueue* completion_queue,
                                      WorkerCacheLogger* logger);
 
+// Like above, but spreads the tensor RPCs over several channels to the same
+// worker, and over several completion queues. `channels` and
+// `completion_queues` must not be empty.
+WorkerInterface* NewGrpcRemoteWorker(
+    GrpcCounter* live_rpc_counter, std::vector<SharedGrpcChannelPtr> channels,
+    std::vector<::grpc::CompletionQueue*> completion_queues,
+    WorkerCacheLogger* logger);
+
 }  // namespace tensorflow
 
 #endif  // THIRD_PARTY_TENSORFLOW_DISTRIBUTED_RUNTIME_RPC_GRPC_REMOTE_WORKER_H_
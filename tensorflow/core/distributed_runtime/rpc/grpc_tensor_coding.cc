@@ -17,6 +17,8 @@ limitations under the License.
 #include "grpc++/support/byte_buffer.h"
 #include "grpc++/support/slice.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/distributed_runtime/shared_memory_ring.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_reference.h"
@@ -135,12 +137,37 @@ static void EncodeSkeleton(const Tensor& val, io::ProtoEncodeHelper* e) {
 
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
                               ::grpc::ByteBuffer* result) {
+  EncodeTensorToByteBuffer(is_dead, val, RECV_TENSOR_ENCODING_NONE, result);
+}
+
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
+                              RecvTensorEncoding encoding,
+                              ::grpc::ByteBuffer* result) {
+  EncodeTensorToByteBuffer(is_dead, val, encoding, 0, result);
+}
+
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
+                              RecvTensorEncoding encoding,
+                              int64 request_received_micros,
+                              ::grpc::ByteBuffer* result) {
   const int kLargeTensorBytes = 1024;
   RecvTensorResponse response;
   if (is_dead) {
     response.set_is_dead(is_dead);
   }
+  if (request_received_micros > 0) {
+    response.set_request_received_micros(request_received_micros);
+  }
   response.set_send_start_micros(Env::Default()->NowMicros());
+  // Small tensors are not worth encoding.
+  string encoded;
+  if (!is_dead && encoding != RECV_TENSOR_ENCODING_NONE &&
+      val.TotalBytes() > kLargeTensorBytes &&
+      EncodeTensorContent(encoding, val, &encoded)) {
+    response.set_encoding(encoding);
+  } else {
+    encoding = RECV_TENSOR_ENCODING_NONE;
+  }
   if (!DataTypeCanUseMemcpy(val.dtype())) {
     // Straightforward but slow path for complicated kinds of tensor data
     // TODO(jeff,sanjay): If this becomes an issue, we could
@@ -156,7 +183,9 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
     io::ProtoEncodeHelper e_skeleton(skeleton.data(), skeleton.size());
     EncodeSkeleton(val, &e_skeleton);
 
-    StringPiece tdata = val.tensor_data();
+    StringPiece tdata = encoding == RECV_TENSOR_ENCODING_NONE
+                            ? val.tensor_data()
+                            : StringPiece(encoded);
     uint32 overall_tensor_proto_bytesize =
         (e_skeleton.size() +
          VarLengthEncodingSize(TensorProto::kTensorContentFieldNumber,
@@ -176,7 +205,9 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
     // store of the data by creating a slice that also points to the
     // backing store, with appropriate reference counts to keep the
     // backing store alive as needed.
-    bool tensor_data_is_large = (tdata.size() > kLargeTensorBytes);
+    // The encoded content is copied, since it does not outlive this call.
+    bool tensor_data_is_large = (tdata.size() > kLargeTensorBytes &&
+                                 encoding == RECV_TENSOR_ENCODING_NONE);
     size_t encoder_size = expected_size - tdata.size();
 
     // Encode all but the actual "tdata", but including the tag and
@@ -243,5 +274,28 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
   }
 }
 
+bool EncodeTensorToSharedMemory(const Tensor& val,
+                                int64 request_received_micros,
+                                SharedMemoryRing* ring,
+                                ::grpc::ByteBuffer* result) {
+  RecvTensorResponse response;
+  response.set_send_start_micros(Env::Default()->NowMicros());
+  if (request_received_micros > 0) {
+    response.set_request_received_micros(request_received_micros);
+  }
+  const StringPiece content = val.tensor_data();
+  int64 offset;
+  if (!ring->Write(content, &offset)) return false;
+  SharedMemoryBlock* block = response.mutable_shared_memory();
+  block->set_ring(ring->name());
+  block->set_offset(offset);
+  block->set_size(content.size());
+  TensorProto* tensor = response.mutable_tensor();
+  tensor->set_dtype(val.dtype());
+  val.shape().AsProto(tensor->mutable_tensor_shape());
+  EncodeRecvTensorResponseToByteBuffer(response, result);
+  return true;
+}
+
 }  // namespace grpc
 }  // namespace tensorflow
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
 
+#include "tensorflow/core/protobuf/worker.pb.h"
+
 namespace grpc {
 class ByteBuffer;
 }  // namespace grpc
@@ -23,6 +25,7 @@ class ByteBuffer;
 namespace tensorflow {
 class Tensor;
 class RecvTensorResponse;
+class SharedMemoryRing;
 
 // TODO(jeff,sanjay): this should not be grpc specific.  Instead of
 // grpc::ByteBuffer*, it should accept an object of an interface type
@@ -51,6 +54,29 @@ void EncodeRecvTensorResponseToByteBuffer(const RecvTensorResponse& proto,
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
                               ::grpc::ByteBuffer* result);
 
+// Like the above, but encodes the content of "val" with "encoding" if it
+// applies to "val" and makes the content smaller.
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
+                              RecvTensorEncoding encoding,
+                              ::grpc::ByteBuffer* result);
+
+// Like the above, but also records "request_received_micros", the time at
+// which the worker received the RecvTensor request, in the response.
+void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val,
+                              RecvTensorEncoding encoding,
+                              int64 request_received_micros,
+                              ::grpc::ByteBuffer* result);
+
+// Like the above, but copies the content of "val" into a block of "ring",
+// which the response names instead of holding the content.  Returns false,
+// leaving "*result" unchanged, if "ring" has no room for the content.
+//
+// "val" must not be dead, and its dtype must support memcpy.
+bool EncodeTensorToSharedMemory(const Tensor& val,
+                                int64 request_received_micros,
+                                SharedMemoryRing* ring,
+                                ::grpc::ByteBuffer* result);
+
 }  // namespace grpc
 }  // namespace tensorflow
 
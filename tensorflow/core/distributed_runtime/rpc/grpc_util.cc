@@ -77,6 +77,18 @@ grpc::protobuf::int64 GrpcByteBufferSource::ByteCount() const {
   return byte_count_;
 }
 
+bool GrpcByteBufferSource::FindSlice(const char* data, size_t size,
+                                     ::grpc::Slice* slice) const {
+  for (const ::grpc::Slice& s : slices_) {
+    const char* begin = reinterpret_cast<const char*>(s.begin());
+    if (begin <= data && data + size <= begin + s.size()) {
+      *slice = s;
+      return true;
+    }
+  }
+  return false;
+}
+
 void GrpcUnparseProto(const protobuf::Message& src, grpc::ByteBuffer* dst) {
   // TODO(sanjay): For bigger protos, serialize into a ZeroCopyOutputStream.
   ::grpc::Slice s(src.ByteSizeLong());
@@ -65,6 +65,10 @@ class GrpcByteBufferSource : public ::grpc::protobuf::io::ZeroCopyInputStream {
   bool Skip(int count) override;
   ::grpc::protobuf::int64 ByteCount() const override;
 
+  // If the `size` bytes at `data` lie within one slice of the buffer given
+  // to the last call to Init(), sets *slice to that slice and returns true.
+  bool FindSlice(const char* data, size_t size, ::grpc::Slice* slice) const;
+
  private:
   std::vector<::grpc::Slice> slices_;
   int cur_;          // Current slice index.
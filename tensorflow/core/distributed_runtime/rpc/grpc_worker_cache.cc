@@ -15,6 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_cache.h"
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/distributed_runtime/rpc/grpc_channel.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_client_cq_tag.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_remote_worker.h"
@@ -22,12 +26,33 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/worker_cache_logger.h"
 #include "tensorflow/core/distributed_runtime/worker_cache_partial.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
 namespace {
 
+// The number of completion queues, each with its own polling thread, that
+// the cache spreads the RPCs over.
+int64 NumCompletionQueues() {
+  int64 num_queues;
+  TF_CHECK_OK(
+      ReadInt64FromEnvVar("TF_GRPC_WORKER_CACHE_THREADS", 4, &num_queues));
+  return std::max<int64>(num_queues, 1);
+}
+
+// The number of channels to each remote worker. The channels after the first
+// one are only used for tensor RPCs, so that a large transfer does not hold
+// up the others behind it on a single connection.
+int64 NumChannelsPerPeer() {
+  int64 num_channels;
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_GRPC_WORKER_CHANNELS_PER_PEER", 1,
+                                  &num_channels));
+  return std::max<int64>(num_channels, 1);
+}
+
 class GrpcWorkerCache : public WorkerCachePartial {
  public:
   explicit GrpcWorkerCache(GrpcChannelCache* channel_cache,
@@ -35,18 +60,23 @@ class GrpcWorkerCache : public WorkerCachePartial {
                            const string& local_target)
       : local_target_(local_target),
         local_worker_(local_worker),
-        channel_cache_(channel_cache) {
-    // TODO(mrry): Investigate possible performance improvements by
-    // replacing this thread with a threadpool.
-    polling_thread_ = Env::Default()->StartThread(
-        ThreadOptions(), "grpc_worker_cache", [this]() {
-          void* tag;
-          bool ok;
-          while (completion_queue_.Next(&tag, &ok)) {
-            GrpcClientCQTag* callback_tag = static_cast<GrpcClientCQTag*>(tag);
-            callback_tag->OnCompleted(ok);
-          }
-        });
+        channel_cache_(channel_cache),
+        channels_per_peer_(NumChannelsPerPeer()) {
+    const int64 num_queues = NumCompletionQueues();
+    for (int64 i = 0; i < num_queues; ++i) {
+      completion_queues_.emplace_back(new ::grpc::CompletionQueue);
+      ::grpc::CompletionQueue* cq = completion_queues_.back().get();
+      polling_threads_.emplace_back(Env::Default()->StartThread(
+          ThreadOptions(), strings::StrCat("grpc_worker_cache_", i), [cq]() {
+            void* tag;
+            bool ok;
+            while (cq->Next(&tag, &ok)) {
+              GrpcClientCQTag* callback_tag =
+                  static_cast<GrpcClientCQTag*>(tag);
+              callback_tag->OnCompleted(ok);
+            }
+          }));
+    }
   }
 
   // Explicit destructor to control destruction order.
@@ -54,8 +84,10 @@ class GrpcWorkerCache : public WorkerCachePartial {
     // Wait until all live rpcs are done since otherwise the completion
     // queue shutdown will interfere with rpc operation.
     live_rpc_counter_.WaitUntilUnused();
-    completion_queue_.Shutdown();
-    delete polling_thread_;  // Blocks until thread exits.
+    for (const auto& cq : completion_queues_) {
+      cq->Shutdown();
+    }
+    polling_threads_.clear();  // Blocks until the threads exit.
     delete channel_cache_;
   }
 
@@ -69,8 +101,24 @@ class GrpcWorkerCache : public WorkerCachePartial {
     } else {
       SharedGrpcChannelPtr channel = channel_cache_->FindWorkerChannel(target);
       if (!channel) return nullptr;
-      return NewGrpcRemoteWorker(&live_rpc_counter_, channel,
-                                 &completion_queue_, &logger_);
+      std::vector<SharedGrpcChannelPtr> channels = {channel};
+      // The additional channels are created directly from the host and port
+      // of the worker, bypassing any custom channel creation function of the
+      // cache, which is why there is only one by default.
+      if (channels_per_peer_ > 1) {
+        const string host_port = channel_cache_->TranslateTask(target);
+        for (int64 i = 1; i < channels_per_peer_; ++i) {
+          SharedGrpcChannelPtr extra;
+          if (!NewHostPortGrpcChannel(host_port, i, &extra).ok()) break;
+          channels.push_back(std::move(extra));
+        }
+      }
+      std::vector<::grpc::CompletionQueue*> cqs;
+      for (const auto& cq : completion_queues_) {
+        cqs.push_back(cq.get());
+      }
+      return NewGrpcRemoteWorker(&live_rpc_counter_, std::move(channels),
+                                 std::move(cqs), &logger_);
     }
   }
 
@@ -96,8 +144,9 @@ class GrpcWorkerCache : public WorkerCachePartial {
   WorkerInterface* const local_worker_;  // Not owned.
   GrpcCounter live_rpc_counter_;
   GrpcChannelCache* channel_cache_;  // Owned.
-  ::grpc::CompletionQueue completion_queue_;
-  Thread* polling_thread_;  // Owned.
+  const int64 channels_per_peer_;
+  std::vector<std::unique_ptr<::grpc::CompletionQueue>> completion_queues_;
+  std::vector<std::unique_ptr<Thread>> polling_threads_;
   WorkerCacheLogger logger_;
 };
 
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service.h"
 
 #include <deque>
+#include <vector>
 
 #include "grpc++/alarm.h"
 #include "grpc++/server_builder.h"
@@ -36,29 +37,71 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
+#include "tensorflow/core/distributed_runtime/shared_memory_ring.h"
 #include "tensorflow/core/distributed_runtime/worker.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_session.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
 namespace {
 
+// Tensors smaller than this are not worth a block of the shared memory ring.
+const int64 kMinSharedMemoryBytes = 1024;
+
+// Encodes the response to a RecvTensor request for "val". The content goes
+// through "ring" if it is not null and has room for it, and in the response
+// with "encoding" otherwise.
+void EncodeRecvTensorResponse(bool is_dead, const Tensor& val,
+                              RecvTensorEncoding encoding,
+                              int64 received_micros, SharedMemoryRing* ring,
+                              ::grpc::ByteBuffer* response) {
+  if (ring != nullptr && !is_dead && DataTypeCanUseMemcpy(val.dtype()) &&
+      static_cast<int64>(val.TotalBytes()) >= kMinSharedMemoryBytes &&
+      grpc::EncodeTensorToSharedMemory(val, received_micros, ring, response)) {
+    return;
+  }
+  grpc::EncodeTensorToByteBuffer(is_dead, val, encoding, received_micros,
+                                 response);
+}
+
+// Returns the number of completion queues of the worker service, each of which
+// is served by its own polling thread.
+int NumCompletionQueues() {
+  int64 num_queues;
+  Status s = ReadInt64FromEnvVar("TF_GRPC_WORKER_SERVICE_THREADS", 4,
+                                 &num_queues);
+  if (!s.ok() || num_queues < 1) {
+    LOG(ERROR) << "Invalid TF_GRPC_WORKER_SERVICE_THREADS: " << s;
+    return 1;
+  }
+  return num_queues;
+}
+
 class GrpcWorkerService : public AsyncServiceInterface {
  public:
   GrpcWorkerService(GrpcWorker* worker, ::grpc::ServerBuilder* builder)
       : worker_(worker), is_shutdown_(false) {
     builder->RegisterService(&worker_service_);
-    cq_ = builder->AddCompletionQueue();
+    const int num_queues = NumCompletionQueues();
+    for (int i = 0; i < num_queues; ++i) {
+      cqs_.push_back(builder->AddCompletionQueue());
+    }
   }
 
-  ~GrpcWorkerService() override { delete shutdown_alarm_; }
+  ~GrpcWorkerService() override {
+    for (::grpc::Alarm* alarm : shutdown_alarms_) {
+      delete alarm;
+    }
+  }
 
   void Shutdown() override {
     bool did_shutdown = false;
@@ -74,14 +117,16 @@ class GrpcWorkerService : public AsyncServiceInterface {
       // NOTE(mrry): This enqueues a special event (with a null tag)
       // that causes the completion queue to be shut down on the
       // polling thread.
-      shutdown_alarm_ =
-          new ::grpc::Alarm(cq_.get(), gpr_now(GPR_CLOCK_MONOTONIC), nullptr);
+      for (const auto& cq : cqs_) {
+        shutdown_alarms_.push_back(
+            new ::grpc::Alarm(cq.get(), gpr_now(GPR_CLOCK_MONOTONIC), nullptr));
+      }
     }
   }
 
 // This macro creates a new request for the given RPC method name
 // (e.g., `ENQUEUE_REQUEST(GetStatus, false);`), and enqueues it on
-// `this->cq_`.
+// the next of `this->cqs_`.
 //
 // This macro is invoked one or more times for each RPC method to
 // ensure that there are sufficient completion queue entries to
@@ -97,18 +142,16 @@ class GrpcWorkerService : public AsyncServiceInterface {
       Call<GrpcWorkerService, grpc::WorkerService::AsyncService,       \
            method##Request, method##Response>::                        \
           EnqueueRequestForMethod(                                     \
-              &worker_service_, cq_.get(),                             \
+              &worker_service_, NextCompletionQueue(),                 \
               static_cast<int>(GrpcWorkerMethod::k##method),           \
               &GrpcWorkerService::method##Handler, (supports_cancel)); \
     }                                                                  \
   } while (0)
 
-  // This method blocks forever handling requests from the completion queue.
+  // This method blocks forever handling requests from the completion queues.
+  // It polls the first queue itself, and starts one thread for each other.
   void HandleRPCsLoop() override {
-    // TODO(mrry): This may require performance engineering. We can
-    // add more threads to service the completion queue, and add more
-    // of various request types if they are short and frequent.
-    // Currently we allow unbounded numbers of pending calls for each
+    // NOTE(mrry): We allow unbounded numbers of pending calls for each
     // method, by re-enqueuing a request before the previous one
     // completes, and we may decide to bound some of the request
     // types.
@@ -129,14 +172,30 @@ class GrpcWorkerService : public AsyncServiceInterface {
     for (int i = 0; i < 100; ++i) {
       ENQUEUE_REQUEST(CleanupGraph, false);
     }
+    for (int i = 0; i < 100; ++i) {
+      ENQUEUE_REQUEST(RecvTensors, true);
+    }
 
     ENQUEUE_REQUEST(Logging, false);
     ENQUEUE_REQUEST(Tracing, false);
 
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int i = 1; i < cqs_.size(); ++i) {
+      ::grpc::ServerCompletionQueue* cq = cqs_[i].get();
+      threads.emplace_back(worker_->env()->env->StartThread(
+          ThreadOptions(), "grpc_worker_service",
+          [this, cq]() { PollCompletionQueue(cq); }));
+    }
+    PollCompletionQueue(cqs_[0].get());
+    // Destroying the threads waits for them to drain their queues.
+  }
+
+ private:
+  void PollCompletionQueue(::grpc::ServerCompletionQueue* cq) {
     void* tag;
     bool ok;
 
-    while (cq_->Next(&tag, &ok)) {
+    while (cq->Next(&tag, &ok)) {
       UntypedCall<GrpcWorkerService>::Tag* callback_tag =
           static_cast<UntypedCall<GrpcWorkerService>::Tag*>(tag);
       if (callback_tag) {
@@ -144,20 +203,28 @@ class GrpcWorkerService : public AsyncServiceInterface {
       } else {
         // NOTE(mrry): A null `callback_tag` indicates that this is
         // the shutdown alarm.
-        cq_->Shutdown();
+        cq->Shutdown();
       }
     }
   }
 
- private:
+  // Returns the queue on which to enqueue the next request, so that the
+  // requests of each method are spread over all the queues.
+  ::grpc::ServerCompletionQueue* NextCompletionQueue()
+      EXCLUSIVE_LOCKS_REQUIRED(shutdown_mu_) {
+    next_cq_ = (next_cq_ + 1) % cqs_.size();
+    return cqs_[next_cq_].get();
+  }
+
   GrpcWorker* worker_ = nullptr;  // Not owned.
-  std::unique_ptr<::grpc::ServerCompletionQueue> cq_;
+  std::vector<std::unique_ptr<::grpc::ServerCompletionQueue>> cqs_;
 
   grpc::WorkerService::AsyncService worker_service_;
 
   mutex shutdown_mu_;
   bool is_shutdown_ GUARDED_BY(shutdown_mu_);
-  ::grpc::Alarm* shutdown_alarm_ = nullptr;
+  int next_cq_ GUARDED_BY(shutdown_mu_) = 0;
+  std::vector<::grpc::Alarm*> shutdown_alarms_;
 
   void Schedule(std::function<void()> f) {
     worker_->env()->compute_pool->Schedule(std::move(f));
@@ -255,6 +322,21 @@ class GrpcWorkerService : public AsyncServiceInterface {
     EnqueueRecvTensorRequestRaw();
   }
 
+  void RecvTensorsHandler(
+      WorkerCall<RecvTensorsRequest, RecvTensorsResponse>* call) {
+    Schedule([this, call]() {
+      CallOptions* call_opts = new CallOptions;
+      call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
+      worker_->RecvTensorsAsync(call_opts, &call->request, &call->response,
+                                [call, call_opts](const Status& s) {
+                                  call->ClearCancelCallback();
+                                  delete call_opts;
+                                  call->SendResponse(ToGrpcStatus(s));
+                                });
+    });
+    ENQUEUE_REQUEST(RecvTensors, true);
+  }
+
   void CleanupGraphHandler(
       WorkerCall<CleanupGraphRequest, CleanupGraphResponse>* call) {
     Schedule([this, call]() {
@@ -287,7 +369,7 @@ class GrpcWorkerService : public AsyncServiceInterface {
       Call<GrpcWorkerService, grpc::WorkerService::AsyncService,
            RecvTensorRequest, ::grpc::ByteBuffer>::
           EnqueueRequestForMethod(
-              &worker_service_, cq_.get(),
+              &worker_service_, NextCompletionQueue(),
               static_cast<int>(GrpcWorkerMethod::kRecvTensor),
               &GrpcWorkerService::RecvTensorHandlerRaw,
               true /* supports cancel*/);
@@ -308,8 +390,16 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
                                      const RecvTensorRequest* request,
                                      ::grpc::ByteBuffer* response,
                                      StatusCallback done) {
+  const int64 received_micros = Env::Default()->NowMicros();
   const int64 step_id = request->step_id();
   const string& key = request->rendezvous_key();
+  const RecvTensorEncoding encoding = request->encoding();
+  // The content goes through shared memory if the client is on this host.
+  SharedMemoryRing* ring = nullptr;
+  if (!request->shared_memory_host().empty() &&
+      request->shared_memory_host() == SharedMemoryRing::HostId()) {
+    ring = SharedMemoryRing::Local();
+  }
   TRACEPRINTF("RecvTensor: %lld %s", step_id, key.c_str());
   Rendezvous::ParsedKey parsed;
   Status s = Rendezvous::ParseKey(key, &parsed);
@@ -325,14 +415,17 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
   // Request the tensor associated with the rendezvous key. Any time
   // while waiting for the tensor to be produced, up until the start
   // of execution of the callback lambda body below, an RPC
-  // cancellation should abort the rendezvous.
-  opts->SetCancelCallback([this, step_id]() { AbortStep(step_id); });
+  // cancellation should abort the rendezvous. The client cancels one of
+  // two hedged requests when the other completes, which must not abort it.
+  if (!request->hedged()) {
+    opts->SetCancelCallback([this, step_id]() { AbortStep(step_id); });
+  }
   env_->rendezvous_mgr->RecvLocalAsync(
       step_id, parsed,
-      [opts, response, done, src_dev](const Status& status,
-                                      const Rendezvous::Args& send_args,
-                                      const Rendezvous::Args& recv_args,
-                                      const Tensor& val, const bool is_dead) {
+      [opts, response, done, src_dev, encoding, received_micros, ring](
+          const Status& status, const Rendezvous::Args& send_args,
+          const Rendezvous::Args& recv_args, const Tensor& val,
+          const bool is_dead) {
         opts->ClearCancelCallback();
         if (status.ok()) {
           // DMA can only be used for Tensors that do not fall into
@@ -356,10 +449,12 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
                   << "send dev name: " << src_dev->name()
                   << " gpu_info: " << src_dev->tensorflow_gpu_device_info();
               // "val" is on a GPU. Uses GPUUtil to fill the copy on host.
-              StatusCallback copy_ready = [response, done, copy,
-                                           is_dead](const Status& s) {
+              StatusCallback copy_ready = [response, done, copy, is_dead,
+                                           encoding, received_micros,
+                                           ring](const Status& s) {
                 // The value is now ready to be returned on the wire.
-                grpc::EncodeTensorToByteBuffer(is_dead, *copy, response);
+                EncodeRecvTensorResponse(is_dead, *copy, encoding,
+                                         received_micros, ring, response);
                 done(s);
                 delete copy;
               };
@@ -370,7 +465,8 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
               done(errors::Internal("No GPU device in process"));
 #endif  // GOOGLE_CUDA
             } else {
-              grpc::EncodeTensorToByteBuffer(is_dead, val, response);
+              EncodeRecvTensorResponse(is_dead, val, encoding,
+                                       received_micros, ring, response);
               done(Status::OK());
             }
           }
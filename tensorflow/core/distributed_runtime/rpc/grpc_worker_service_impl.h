@@ -119,9 +119,10 @@ enum class GrpcWorkerMethod {
   kRecvTensor,
   kLogging,
   kTracing,
+  kRecvTensors,
 };
 static const int kGrpcNumWorkerMethods =
-    static_cast<int>(GrpcWorkerMethod::kTracing) + 1;
+    static_cast<int>(GrpcWorkerMethod::kRecvTensors) + 1;
 
 const char* GrpcWorkerMethodName(GrpcWorkerMethod id);
 
@@ -0,0 +1,142 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/recv_tensor_hedger.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The number of latencies kept per worker, and the number of new ones after
+// which the delay is computed again.
+const size_t kMaxSamples = 1000;
+const int64 kUpdateInterval = 50;
+
+}  // namespace
+
+RecvTensorHedger::RecvTensorHedger(Env* env, double percentile,
+                                   int min_samples)
+    : env_(env), percentile_(percentile), min_samples_(min_samples) {
+  CHECK_GT(percentile, 0);
+  CHECK_LT(percentile, 100);
+  thread_.reset(env_->StartThread(ThreadOptions(), "recv_tensor_hedger",
+                                  [this]() { RunTimers(); }));
+}
+
+RecvTensorHedger::~RecvTensorHedger() {
+  {
+    mutex_lock l(timers_mu_);
+    stop_ = true;
+  }
+  timers_cv_.notify_all();
+  thread_.reset();
+}
+
+RecvTensorHedger* RecvTensorHedger::Global() {
+  static RecvTensorHedger* hedger = []() -> RecvTensorHedger* {
+    int64 percentile;
+    Status s = ReadInt64FromEnvVar("TF_RPC_RECV_TENSOR_HEDGE_PERCENTILE", 0,
+                                   &percentile);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return nullptr;
+    }
+    if (percentile <= 0) return nullptr;
+    if (percentile >= 100) {
+      LOG(ERROR) << "TF_RPC_RECV_TENSOR_HEDGE_PERCENTILE must be below 100, "
+                 << "not " << percentile;
+      return nullptr;
+    }
+    return new RecvTensorHedger(Env::Default(), percentile,
+                                100 /* min_samples */);
+  }();
+  return hedger;
+}
+
+int64 RecvTensorHedger::DelayMicros(const string& worker) {
+  mutex_lock l(latencies_mu_);
+  auto it = latencies_.find(worker);
+  return it == latencies_.end() ? 0 : it->second.delay_micros;
+}
+
+void RecvTensorHedger::RecordLatency(const string& worker, int64 micros) {
+  std::vector<int64> samples;
+  {
+    mutex_lock l(latencies_mu_);
+    Latencies& latencies = latencies_[worker];
+    if (latencies.samples.size() < kMaxSamples) {
+      latencies.samples.push_back(micros);
+    } else {
+      latencies.samples[latencies.next] = micros;
+      latencies.next = (latencies.next + 1) % kMaxSamples;
+    }
+    if (latencies.samples.size() < static_cast<size_t>(min_samples_) ||
+        ++latencies.since_update < kUpdateInterval) {
+      return;
+    }
+    latencies.since_update = 0;
+    samples = latencies.samples;
+  }
+  // Computes the percentile outside the lock, and publishes it afterwards.
+  const size_t n = std::min(
+      samples.size() - 1, static_cast<size_t>(samples.size() * percentile_ /
+                                              100));
+  std::nth_element(samples.begin(), samples.begin() + n, samples.end());
+  mutex_lock l(latencies_mu_);
+  // A delay of 0 would disable hedging, rather than hedge every call.
+  latencies_[worker].delay_micros = std::max<int64>(samples[n], 1);
+}
+
+void RecvTensorHedger::Schedule(int64 micros, std::function<void()> fn) {
+  {
+    mutex_lock l(timers_mu_);
+    timers_.emplace(env_->NowMicros() + micros, std::move(fn));
+  }
+  timers_cv_.notify_one();
+}
+
+void RecvTensorHedger::RunTimers() {
+  while (true) {
+    std::vector<std::function<void()>> due;
+    {
+      mutex_lock l(timers_mu_);
+      while (!stop_) {
+        const uint64 now = env_->NowMicros();
+        while (!timers_.empty() && timers_.begin()->first <= now) {
+          due.push_back(std::move(timers_.begin()->second));
+          timers_.erase(timers_.begin());
+        }
+        if (!due.empty()) break;
+        if (timers_.empty()) {
+          timers_cv_.wait(l);
+        } else {
+          timers_cv_.wait_for(
+              l, std::chrono::microseconds(timers_.begin()->first - now));
+        }
+      }
+      if (stop_) return;
+    }
+    for (const auto& fn : due) fn();
+  }
+}
+
+}  // namespace tensorflow
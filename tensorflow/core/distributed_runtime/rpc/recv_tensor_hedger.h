@@ -0,0 +1,97 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_RECV_TENSOR_HEDGER_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_RECV_TENSOR_HEDGER_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// RecvTensorHedger decides when a RecvTensor call whose response is late is
+// duplicated ("hedged"): the duplicate goes to the same worker over another
+// channel after a delay, which is a percentile of the latencies of the recent
+// RecvTensor calls to that worker, and whichever response comes first wins.
+// This cuts the tail of the recvs that are late because of a lost packet or
+// a stalled connection, rather than because the tensor is produced late.
+//
+// RecvTensorHedger also runs the timers that send the duplicates, on a
+// single thread.
+//
+// RecvTensorHedger is thread-safe.
+class RecvTensorHedger {
+ public:
+  // Hedges a RecvTensor call after the `percentile` (in (0, 100)) of the
+  // latencies of the last calls to the same worker, once there are at
+  // least `min_samples` of them.
+  RecvTensorHedger(Env* env, double percentile, int min_samples);
+  ~RecvTensorHedger();
+
+  // Returns the hedger of this process, which the
+  // TF_RPC_RECV_TENSOR_HEDGE_PERCENTILE environment variable configures, or
+  // nullptr if the variable does not enable hedging.
+  static RecvTensorHedger* Global();
+
+  // Returns after how many microseconds a RecvTensor call to `worker` is
+  // hedged, or 0 if it is not hedged.
+  int64 DelayMicros(const string& worker);
+
+  // Records that a RecvTensor call to `worker` completed after `micros`.
+  void RecordLatency(const string& worker, int64 micros);
+
+  // Runs `fn` on the timer thread after `micros`. `fn` must not block.
+  void Schedule(int64 micros, std::function<void()> fn);
+
+ private:
+  // The latencies of the last calls to a worker.
+  struct Latencies {
+    std::vector<int64> samples;  // A ring of up to kMaxSamples.
+    size_t next = 0;
+    int64 since_update = 0;
+    int64 delay_micros = 0;
+  };
+
+  void RunTimers();
+
+  Env* const env_;
+  const double percentile_;
+  const int min_samples_;
+
+  mutex latencies_mu_;
+  std::unordered_map<string, Latencies> latencies_ GUARDED_BY(latencies_mu_);
+
+  mutex timers_mu_;
+  condition_variable timers_cv_;
+  std::multimap<uint64, std::function<void()>> timers_ GUARDED_BY(timers_mu_);
+  bool stop_ GUARDED_BY(timers_mu_) = false;
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RecvTensorHedger);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_RECV_TENSOR_HEDGER_H_
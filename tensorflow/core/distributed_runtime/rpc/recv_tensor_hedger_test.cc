@@ -0,0 +1,74 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/rpc/recv_tensor_hedger.h"
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(RecvTensorHedgerTest, DelayIsPercentileOfLatencies) {
+  RecvTensorHedger hedger(Env::Default(), 90, 100 /* min_samples */);
+  for (int i = 1; i < 100; ++i) {
+    hedger.RecordLatency("/job:ps/task:0", i);
+  }
+  EXPECT_EQ(0, hedger.DelayMicros("/job:ps/task:0"));
+
+  // The delay is computed again every 50 latencies.
+  for (int i = 100; i < 149; ++i) {
+    hedger.RecordLatency("/job:ps/task:0", i);
+  }
+  EXPECT_EQ(0, hedger.DelayMicros("/job:ps/task:0"));
+  hedger.RecordLatency("/job:ps/task:0", 149);
+  EXPECT_EQ(135, hedger.DelayMicros("/job:ps/task:0"));
+  EXPECT_EQ(0, hedger.DelayMicros("/job:ps/task:1"));
+}
+
+TEST(RecvTensorHedgerTest, DelayFollowsRecentLatencies) {
+  RecvTensorHedger hedger(Env::Default(), 50, 100 /* min_samples */);
+  for (int i = 0; i < 1000; ++i) {
+    hedger.RecordLatency("/job:ps/task:0", 10);
+  }
+  EXPECT_EQ(10, hedger.DelayMicros("/job:ps/task:0"));
+  for (int i = 0; i < 1000; ++i) {
+    hedger.RecordLatency("/job:ps/task:0", 500);
+  }
+  EXPECT_EQ(500, hedger.DelayMicros("/job:ps/task:0"));
+}
+
+TEST(RecvTensorHedgerTest, RunsTimersInOrder) {
+  RecvTensorHedger hedger(Env::Default(), 90, 100 /* min_samples */);
+  mutex mu;
+  std::vector<int> order;
+  BlockingCounter done(3);
+  for (int i : {3, 1, 2}) {
+    hedger.Schedule(i * 20000, [i, &mu, &order, &done]() {
+      {
+        mutex_lock l(mu);
+        order.push_back(i);
+      }
+      done.DecrementCount();
+    });
+  }
+  done.Wait();
+  EXPECT_EQ(std::vector<int>({1, 2, 3}), order);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -15,12 +15,16 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <memory>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/distributed_runtime/rpc/recv_tensor_hedger.h"
+#include "tensorflow/core/distributed_runtime/shared_memory_ring.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
@@ -28,14 +32,76 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
 namespace {
 
+// Returns how long the recvs of a step from the same remote worker are held
+// back, so that the ones issued together are coalesced into one RecvTensors
+// call, or 0 if each recv uses its own RecvTensor call.
+int64 RecvCoalescingWindowMicros() {
+  static const int64 window_us = []() {
+    int64 value;
+    Status s =
+        ReadInt64FromEnvVar("TF_RPC_RECV_COALESCING_WINDOW_US", 0, &value);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return static_cast<int64>(0);
+    }
+    return value;
+  }();
+  return window_us;
+}
+
+// Returns the deadline of each RecvTensor call in milliseconds, or 0 if the
+// calls wait for their tensors for as long as the steps run.
+int64 RecvTensorTimeoutMillis() {
+  static const int64 timeout_ms = []() {
+    int64 value;
+    Status s = ReadInt64FromEnvVar("TF_RPC_RECV_TENSOR_TIMEOUT_MS", 0, &value);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return static_cast<int64>(0);
+    }
+    return value;
+  }();
+  return timeout_ms;
+}
+
+// Returns the encoding in which RecvTensor calls ask for the tensor
+// content, e.g. "snappy" or "bfloat16" for RECV_TENSOR_ENCODING_SNAPPY or
+// RECV_TENSOR_ENCODING_BFLOAT16.
+RecvTensorEncoding RecvTensorEncodingFromEnv() {
+  static const RecvTensorEncoding encoding = []() {
+    const char* value = getenv("TF_RPC_RECV_TENSOR_ENCODING");
+    RecvTensorEncoding result = RECV_TENSOR_ENCODING_NONE;
+    if (value != nullptr && *value != '\0' &&
+        !RecvTensorEncoding_Parse(strings::StrCat("RECV_TENSOR_ENCODING_",
+                                                  str_util::Uppercase(value)),
+                                  &result)) {
+      LOG(ERROR) << "Unknown TF_RPC_RECV_TENSOR_ENCODING: " << value;
+    }
+    return result;
+  }();
+  return encoding;
+}
+
+// A recv of a tensor from a remote worker that has not been issued yet.
+struct PendingRecv {
+  Rendezvous::ParsedKey parsed;
+  Device* dst_device;
+  Rendezvous::Args recv_args;
+  Rendezvous::DoneCallback done;
+};
+
+class RpcRecvTensorsCall;
+
 class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  public:
   RpcRemoteRendezvous(const WorkerEnv* env, int64 step_id)
@@ -49,10 +115,31 @@ class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  private:
   ~RpcRemoteRendezvous() override {}
 
+  // Receives the tensor of `recv` from `src_worker` with a RecvTensor call.
+  void RecvTensorAsync(const string& src_worker, PendingRecv recv);
+
+  // Issues the recvs from `src_worker` that are pending in this step.
+  void FlushRecvs(const string& src_worker);
+
+  // Receives the tensors of `recvs` from `src_worker` with one RecvTensors
+  // call, and issues the recvs it did not complete again.
+  void RecvTensorsAsync(const string& src_worker,
+                        std::vector<PendingRecv> recvs);
+  void RecvTensorsDone(const string& src_worker, RpcRecvTensorsCall* call);
+
+  mutex pending_mu_;
+  std::unordered_map<string, std::vector<PendingRecv>> pending_recvs_
+      GUARDED_BY(pending_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRemoteRendezvous);
 };
 
 // Used only to retrieve tensors from remote processes.
+//
+// If RecvTensorHedger::Global() is enabled, the call sends a duplicate of its
+// RecvTensor request when the response is late, and the first response to
+// arrive wins. The other request is then cancelled, and the call completes
+// once both are done.
 class RpcRecvTensorCall : public BaseRecvTensorCall {
  public:
   RpcRecvTensorCall() : wi_(nullptr), dst_device_(nullptr) {}
@@ -67,6 +154,13 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     done_ = std::move(done);
     req_.set_step_id(step_id);
     req_.set_rendezvous_key(key.data(), key.size());
+    req_.set_encoding(RecvTensorEncodingFromEnv());
+    opts_.SetTimeout(RecvTensorTimeoutMillis());
+    hedge_opts_.SetTimeout(RecvTensorTimeoutMillis());
+    // A worker on the same host sends the content through shared memory.
+    if (SharedMemoryRing::Enabled()) {
+      req_.set_shared_memory_host(SharedMemoryRing::HostId());
+    }
   }
 
   void Reset(WorkerCacheInterface* wc) {
@@ -78,10 +172,15 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     // opts_ appropriately.
     req_.Clear();
     resp_.Clear();
+    hedge_resp_.Clear();
     {
       mutex_lock l(mu_);
       status_ = Status::OK();
+      winner_ = nullptr;
+      hedge_started_ = false;
     }
+    hedge_state_.reset();
+    recv_done_ = nullptr;
     done_ = nullptr;
   }
 
@@ -104,6 +203,7 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
       status_.Update(s);
     }
     opts_.StartCancel();
+    hedge_opts_.StartCancel();
   }
 
   Status status() const override {
@@ -111,9 +211,9 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     return status_;
   }
 
-  const Tensor& tensor() const { return resp_.tensor(); }
+  const Tensor& tensor() const { return winner()->tensor(); }
 
-  bool is_dead() const { return resp_.metadata().is_dead(); }
+  bool is_dead() const { return winner()->metadata().is_dead(); }
 
   Device* dst_device() const { return dst_device_; }
   const Rendezvous::Args& recv_args() const { return recv_args_; }
@@ -122,9 +222,31 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
  private:
   friend class RpcRemoteRendezvous;
 
+  // The state shared with the timer that sends the duplicate request, which
+  // may outlive the call.
+  struct HedgeState {
+    mutex mu;
+    // Null once the call is done.
+    RpcRecvTensorCall* call GUARDED_BY(mu);
+  };
+
+  const TensorResponse* winner() const {
+    mutex_lock l(mu_);
+    return winner_;
+  }
+
   // Start the main RecvTensor call, checking for an async abort.
   void StartRTCall(std::function<void()> recv_done) {
     resp_.InitAlloc(dst_device_, alloc_attrs_);
+    RecvTensorHedger* hedger = RecvTensorHedger::Global();
+    if (hedger != nullptr) {
+      StartHedgedRTCall(hedger, std::move(recv_done));
+      return;
+    }
+    {
+      mutex_lock l(mu_);
+      winner_ = &resp_;
+    }
     using namespace std::placeholders;
     StatusCallback cb = std::bind(
         [this](std::function<void()> recv_done,
@@ -140,8 +262,95 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     wi_->RecvTensorAsync(&opts_, &req_, &resp_, std::move(cb));
   }
 
+  // Starts the main RecvTensor call, and a timer that sends its duplicate if
+  // the latencies of the calls to src_worker_ tell when a response is late.
+  void StartHedgedRTCall(RecvTensorHedger* hedger,
+                         std::function<void()> recv_done) {
+    const int64 delay_micros = hedger->DelayMicros(src_worker_);
+    start_micros_ = Env::Default()->NowMicros();
+    recv_done_ = std::move(recv_done);
+    {
+      mutex_lock l(mu_);
+      pending_rpcs_ = 1;
+    }
+    std::shared_ptr<HedgeState> state;
+    if (delay_micros > 0) {
+      req_.set_hedged(true);
+      state = std::make_shared<HedgeState>();
+      state->call = this;
+      hedge_state_ = state;
+    }
+    wi_->RecvTensorAsync(&opts_, &req_, &resp_,
+                         [this](const Status& s) { RpcDone(&resp_, s); });
+    // The call may be done already, so only the state is used from here on.
+    if (state != nullptr) {
+      hedger->Schedule(delay_micros, [state]() {
+        mutex_lock l(state->mu);
+        if (state->call != nullptr) state->call->StartHedge();
+      });
+    }
+  }
+
+  // Sends the duplicate request, unless the call has a response already.
+  // The caller holds hedge_state_->mu, which keeps the call alive.
+  void StartHedge() {
+    {
+      mutex_lock l(mu_);
+      if (winner_ != nullptr || !status_.ok()) return;
+      ++pending_rpcs_;
+    }
+    hedge_resp_.InitAlloc(dst_device_, alloc_attrs_);
+    wi_->RecvTensorAsync(&hedge_opts_, &req_, &hedge_resp_,
+                         [this](const Status& s) { RpcDone(&hedge_resp_, s); });
+    // The duplicate can be cancelled only now that it has been issued.
+    bool cancel;
+    {
+      mutex_lock l(mu_);
+      hedge_started_ = true;
+      cancel = winner_ != nullptr || !status_.ok();
+    }
+    if (cancel) hedge_opts_.StartCancel();
+  }
+
+  // Called when the request whose response is `resp` is done.
+  void RpcDone(TensorResponse* resp, const Status& s) {
+    bool done;
+    {
+      // Until pending_rpcs_ drops to 0 under mu_, the call stays alive, so
+      // the other request is cancelled under mu_ too. The cancellation only
+      // asks gRPC to cancel, and does not call back synchronously.
+      mutex_lock l(mu_);
+      --pending_rpcs_;
+      if (winner_ == nullptr) {
+        winner_ = resp;
+        if (s.ok()) {
+          RecvTensorHedger::Global()->RecordLatency(
+              src_worker_, Env::Default()->NowMicros() - start_micros_);
+        } else {
+          status_.Update(s);
+        }
+        if (pending_rpcs_ > 0) {
+          if (resp != &resp_) {
+            opts_.StartCancel();
+          } else if (hedge_started_) {
+            hedge_opts_.StartCancel();
+          }
+        }
+      }
+      done = pending_rpcs_ == 0;
+    }
+    if (!done) return;
+    if (hedge_state_ != nullptr) {
+      // Waits for a pending StartHedge() to return.
+      mutex_lock l(hedge_state_->mu);
+      hedge_state_->call = nullptr;
+    }
+    // recv_done may release the call, which resets recv_done_.
+    std::function<void()> recv_done = std::move(recv_done_);
+    recv_done();
+  }
+
   string src_worker_;
-  string src_rel_device_;
   WorkerInterface* wi_;
   AllocatorAttributes alloc_attrs_;
   Device* dst_device_;
@@ -151,8 +360,19 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
   Rendezvous::Args recv_args_;
   Rendezvous::DoneCallback done_;
 
+  // For the duplicate request, which shares req_.
+  CallOptions hedge_opts_;
+  TensorResponse hedge_resp_;
+  std::shared_ptr<HedgeState> hedge_state_;
+  std::function<void()> recv_done_;
+  uint64 start_micros_ = 0;
+
   mutable mutex mu_;
   Status status_ GUARDED_BY(mu_);
+  // The response of the request that completed first.
+  const TensorResponse* winner_ GUARDED_BY(mu_) = nullptr;
+  int pending_rpcs_ GUARDED_BY(mu_) = 0;
+  bool hedge_started_ GUARDED_BY(mu_) = false;
 
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRecvTensorCall);
 };
@@ -202,42 +422,123 @@ static RpcRecvTensorFreeList* get_call_freelist() {
   return call_freelist;
 }
 
+// Used to retrieve several tensors from one remote process with a single
+// RecvTensors call.
+class RpcRecvTensorsCall : public BaseRecvTensorCall {
+ public:
+  RpcRecvTensorsCall(WorkerInterface* wi, int64 step_id,
+                     std::vector<PendingRecv> recvs)
+      : wi_(wi), recvs_(std::move(recvs)) {
+    req_.set_step_id(step_id);
+    for (const PendingRecv& recv : recvs_) {
+      const StringPiece key = recv.parsed.FullKey();
+      req_.add_rendezvous_keys(key.data(), key.size());
+    }
+  }
+
+  void Start(std::function<void()> recv_done) override {
+    wi_->RecvTensorsAsync(&opts_, &req_, &resp_,
+                          [this, recv_done](const Status& s) {
+                            if (!s.ok()) {
+                              mutex_lock l(mu_);
+                              status_.Update(s);
+                            }
+                            recv_done();
+                          });
+  }
+
+  void StartAbort(const Status& s) override {
+    {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+    opts_.StartCancel();
+  }
+
+  Status status() const override {
+    mutex_lock l(mu_);
+    return status_;
+  }
+
+  WorkerInterface* wi() const { return wi_; }
+  std::vector<PendingRecv>* recvs() { return &recvs_; }
+  RecvTensorsResponse* response() { return &resp_; }
+
+ private:
+  WorkerInterface* const wi_;
+  std::vector<PendingRecv> recvs_;
+  CallOptions opts_;
+  RecvTensorsRequest req_;
+  RecvTensorsResponse resp_;
+
+  mutable mutex mu_;
+  Status status_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RpcRecvTensorsCall);
+};
+
 void RpcRemoteRendezvous::RecvFromRemoteAsync(
     const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
     DoneCallback done) {
   CHECK(is_initialized());
   Status s;
 
-  // Prepare a RecvTensor call that can handle being aborted.
-  RpcRecvTensorCall* call = get_call_freelist()->New();
-
   // key.src_device identifies a remote device.
-  if (!DeviceNameUtils::SplitDeviceName(parsed.src_device, &call->src_worker_,
-                                        &call->src_rel_device_)) {
+  string src_worker;
+  string src_rel_device;
+  if (!DeviceNameUtils::SplitDeviceName(parsed.src_device, &src_worker,
+                                        &src_rel_device)) {
     s = errors::Internal(parsed.src_device,
                          " is invalid remote source device.");
   }
-  WorkerSession* sess = session();
-  WorkerInterface* rwi = sess->worker_cache->CreateWorker(call->src_worker_);
-  if (s.ok() && rwi == nullptr) {
-    s = errors::Internal("No worker known as ", call->src_worker_);
-  }
-
   Device* dst_device;
   if (s.ok()) {
-    s = sess->device_mgr->LookupDevice(parsed.dst_device, &dst_device);
+    s = session()->device_mgr->LookupDevice(parsed.dst_device, &dst_device);
   }
   if (!s.ok()) {
-    if (rwi != nullptr) {
-      sess->worker_cache->ReleaseWorker(call->src_worker_, rwi);
-    }
-    get_call_freelist()->Release(call, sess->worker_cache.get());
     done(s, Args(), recv_args, Tensor{}, false);
     return;
   }
 
-  call->Init(rwi, step_id_, parsed.FullKey(), recv_args.alloc_attrs, dst_device,
-             recv_args, std::move(done));
+  PendingRecv recv{parsed, dst_device, recv_args, std::move(done)};
+  const int64 window_us = RecvCoalescingWindowMicros();
+  if (window_us <= 0) {
+    RecvTensorAsync(src_worker, std::move(recv));
+    return;
+  }
+  bool first;
+  {
+    mutex_lock l(pending_mu_);
+    std::vector<PendingRecv>& pending = pending_recvs_[src_worker];
+    first = pending.empty();
+    pending.push_back(std::move(recv));
+  }
+  if (first) {
+    Ref();
+    SchedNonBlockingClosureAfter(window_us, [this, src_worker]() {
+      FlushRecvs(src_worker);
+      Unref();
+    });
+  }
+}
+
+void RpcRemoteRendezvous::RecvTensorAsync(const string& src_worker,
+                                          PendingRecv recv) {
+  // Prepare a RecvTensor call that can handle being aborted.
+  RpcRecvTensorCall* call = get_call_freelist()->New();
+  call->src_worker_ = src_worker;
+
+  WorkerSession* sess = session();
+  WorkerInterface* rwi = sess->worker_cache->CreateWorker(src_worker);
+  if (rwi == nullptr) {
+    get_call_freelist()->Release(call, sess->worker_cache.get());
+    recv.done(errors::Internal("No worker known as ", src_worker), Args(),
+              recv.recv_args, Tensor{}, false);
+    return;
+  }
+
+  call->Init(rwi, step_id_, recv.parsed.FullKey(), recv.recv_args.alloc_attrs,
+             recv.dst_device, recv.recv_args, std::move(recv.done));
 
   // Record "call" in active_ so that it can be aborted cleanly.
   RegisterCall(call);
@@ -258,6 +559,106 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
   });
 }
 
+void RpcRemoteRendezvous::FlushRecvs(const string& src_worker) {
+  std::vector<PendingRecv> recvs;
+  {
+    mutex_lock l(pending_mu_);
+    auto it = pending_recvs_.find(src_worker);
+    if (it == pending_recvs_.end()) return;
+    recvs.swap(it->second);
+    pending_recvs_.erase(it);
+  }
+  if (recvs.size() == 1) {
+    RecvTensorAsync(src_worker, std::move(recvs[0]));
+  } else {
+    RecvTensorsAsync(src_worker, std::move(recvs));
+  }
+}
+
+void RpcRemoteRendezvous::RecvTensorsAsync(const string& src_worker,
+                                           std::vector<PendingRecv> recvs) {
+  WorkerSession* sess = session();
+  WorkerInterface* rwi = sess->worker_cache->CreateWorker(src_worker);
+  if (rwi == nullptr) {
+    for (PendingRecv& recv : recvs) {
+      recv.done(errors::Internal("No worker known as ", src_worker), Args(),
+                recv.recv_args, Tensor{}, false);
+    }
+    return;
+  }
+  RpcRecvTensorsCall* call =
+      new RpcRecvTensorsCall(rwi, step_id_, std::move(recvs));
+  RegisterCall(call);
+  Ref();
+  call->Start([this, src_worker, call]() {
+    DeregisterCall(call);
+    session()->worker_cache->ReleaseWorker(src_worker, call->wi());
+    RecvTensorsDone(src_worker, call);
+    delete call;
+    Unref();
+  });
+}
+
+void RpcRemoteRendezvous::RecvTensorsDone(const string& src_worker,
+                                          RpcRecvTensorsCall* call) {
+  std::vector<PendingRecv>* recvs = call->recvs();
+  Status s = call->status();
+  if (errors::IsUnimplemented(s)) {
+    // The remote worker does not support RecvTensors.
+    for (PendingRecv& recv : *recvs) {
+      RecvTensorAsync(src_worker, std::move(recv));
+    }
+    return;
+  }
+  if (!s.ok()) {
+    for (PendingRecv& recv : *recvs) {
+      recv.done(s, Args(), recv.recv_args, Tensor{}, false);
+    }
+    return;
+  }
+
+  std::unordered_map<StringPiece, PendingRecv*, StringPiece::Hasher> by_key;
+  for (PendingRecv& recv : *recvs) {
+    by_key[recv.parsed.FullKey()] = &recv;
+  }
+  RecvTensorsResponse* resp = call->response();
+  const int num_ready =
+      std::min(resp->ready_keys_size(), resp->tensors_size());
+  for (int i = 0; i < num_ready; ++i) {
+    auto it = by_key.find(resp->ready_keys(i));
+    if (it == by_key.end()) continue;
+    PendingRecv* recv = it->second;
+    by_key.erase(it);
+    TensorResponse tensor;
+    tensor.InitAlloc(recv->dst_device, recv->recv_args.alloc_attrs);
+    Status ts = tensor.InitFrom(resp->mutable_tensors(i));
+    recv->done(ts, Args(), recv->recv_args, tensor.tensor(),
+               tensor.metadata().is_dead());
+  }
+  for (const string& key : resp->uncoalesced_keys()) {
+    auto it = by_key.find(key);
+    if (it == by_key.end()) continue;
+    PendingRecv* recv = it->second;
+    by_key.erase(it);
+    RecvTensorAsync(src_worker, std::move(*recv));
+  }
+
+  // Requests the tensors that were not ready again.
+  if (!by_key.empty()) {
+    std::vector<PendingRecv> rest;
+    for (PendingRecv& recv : *recvs) {
+      if (by_key.count(recv.parsed.FullKey()) > 0) {
+        rest.push_back(std::move(recv));
+      }
+    }
+    if (rest.size() == 1) {
+      RecvTensorAsync(src_worker, std::move(rest[0]));
+    } else {
+      RecvTensorsAsync(src_worker, std::move(rest));
+    }
+  }
+}
+
 }  // namespace
 
 RpcRendezvousMgr::RpcRendezvousMgr(const WorkerEnv* env)
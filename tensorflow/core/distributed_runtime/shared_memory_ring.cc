@@ -0,0 +1,298 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/shared_memory_ring.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/host_info.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/platform.h"
+#include "tensorflow/core/util/env_var.h"
+
+#if !defined(PLATFORM_WINDOWS)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tensorflow {
+
+namespace {
+
+// Blocks start at multiples of this many bytes, and their contents start
+// this many bytes after their headers, so that the copies in and out of the
+// ring are aligned. The ring header takes the same room before the blocks.
+const int64 kBlockAlignment = 64;
+const uint64 kRingMagic = 0x74667368726e6701ull;
+
+struct RingHeader {
+  uint64 magic;
+};
+
+struct BlockHeader {
+  // Set to 1 by the reader once it has copied the block out, and by the
+  // writer for the fillers that skip the end of the ring.
+  std::atomic<uint32> released;
+  uint32 filler;
+  // The bytes of the block, including this header.
+  int64 size;
+};
+
+int64 RoundUpToBlock(int64 bytes) {
+  return (bytes + kBlockAlignment - 1) / kBlockAlignment * kBlockAlignment;
+}
+
+string* local_ring_name = nullptr;
+
+void UnlinkLocalRing() {
+#if !defined(PLATFORM_WINDOWS)
+  shm_unlink(local_ring_name->c_str());
+#endif
+}
+
+}  // namespace
+
+SharedMemoryRing::SharedMemoryRing(const string& name, char* base,
+                                   int64 mapped_bytes, bool owner)
+    : name_(name),
+      base_(base),
+      mapped_bytes_(mapped_bytes),
+      capacity_((mapped_bytes - kBlockAlignment) / kBlockAlignment *
+                kBlockAlignment),
+      owner_(owner) {}
+
+SharedMemoryRing::~SharedMemoryRing() {
+#if !defined(PLATFORM_WINDOWS)
+  munmap(base_, mapped_bytes_);
+  if (owner_) shm_unlink(name_.c_str());
+#endif
+}
+
+Status SharedMemoryRing::Create(const string& name, int64 size,
+                                std::unique_ptr<SharedMemoryRing>* ring) {
+#if defined(PLATFORM_WINDOWS)
+  return errors::Unimplemented("Shared memory rings are not supported");
+#else
+  if (size < kBlockAlignment) {
+    return errors::InvalidArgument("Shared memory ring of ", size,
+                                   " bytes is too small");
+  }
+  const int64 mapped_bytes = kBlockAlignment + RoundUpToBlock(size);
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    return errors::Internal("Cannot create shared memory ", name, ": ",
+                            strerror(errno));
+  }
+  void* base = MAP_FAILED;
+  if (ftruncate(fd, mapped_bytes) == 0) {
+    base = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                0);
+  }
+  const int error = errno;
+  close(fd);
+  if (base == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    return errors::Internal("Cannot map shared memory ", name, ": ",
+                            strerror(error));
+  }
+  reinterpret_cast<RingHeader*>(base)->magic = kRingMagic;
+  ring->reset(new SharedMemoryRing(name, static_cast<char*>(base),
+                                   mapped_bytes, true /* owner */));
+  return Status::OK();
+#endif
+}
+
+Status SharedMemoryRing::Open(const string& name,
+                              std::unique_ptr<SharedMemoryRing>* ring) {
+#if defined(PLATFORM_WINDOWS)
+  return errors::Unimplemented("Shared memory rings are not supported");
+#else
+  const int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    return errors::Unavailable("Cannot open shared memory ", name, ": ",
+                               strerror(errno));
+  }
+  struct stat st;
+  void* base = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size >= 2 * kBlockAlignment) {
+    base = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                0);
+  }
+  close(fd);
+  if (base == MAP_FAILED) {
+    return errors::Unavailable("Cannot map shared memory ", name);
+  }
+  if (reinterpret_cast<RingHeader*>(base)->magic != kRingMagic) {
+    munmap(base, st.st_size);
+    return errors::InvalidArgument(name, " is not a shared memory ring");
+  }
+  ring->reset(new SharedMemoryRing(name, static_cast<char*>(base), st.st_size,
+                                   false /* owner */));
+  return Status::OK();
+#endif
+}
+
+bool SharedMemoryRing::Enabled() {
+  static const bool enabled = []() {
+    int64 bytes;
+    Status s =
+        ReadInt64FromEnvVar("TF_RPC_SHARED_MEMORY_RING_BYTES", 0, &bytes);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return false;
+    }
+    return bytes > 0;
+  }();
+  return enabled;
+}
+
+SharedMemoryRing* SharedMemoryRing::Local() {
+  static SharedMemoryRing* ring = []() -> SharedMemoryRing* {
+    if (!Enabled()) return nullptr;
+    int64 bytes;
+    TF_CHECK_OK(
+        ReadInt64FromEnvVar("TF_RPC_SHARED_MEMORY_RING_BYTES", 0, &bytes));
+    const string name = strings::Printf(
+        "/tf_rpc_%d_%016llx", static_cast<int>(getpid()),
+        static_cast<unsigned long long>(random::New64()));
+    std::unique_ptr<SharedMemoryRing> created;
+    Status s = Create(name, bytes, &created);
+    if (!s.ok()) {
+      LOG(WARNING) << "Sending tensors without shared memory: " << s;
+      return nullptr;
+    }
+    // The ring stays mapped for the readers until the process exits, when
+    // its name is removed.
+    local_ring_name = new string(name);
+    std::atexit(UnlinkLocalRing);
+    return created.release();
+  }();
+  return ring;
+}
+
+Status SharedMemoryRing::Attach(const string& name, SharedMemoryRing** ring) {
+  static mutex* mu = new mutex;
+  static auto* rings =
+      new std::unordered_map<string, std::unique_ptr<SharedMemoryRing>>;
+  mutex_lock l(*mu);
+  std::unique_ptr<SharedMemoryRing>& attached = (*rings)[name];
+  if (attached == nullptr) {
+    Status s = Open(name, &attached);
+    if (!s.ok()) {
+      rings->erase(name);
+      return s;
+    }
+  }
+  *ring = attached.get();
+  return Status::OK();
+}
+
+const string& SharedMemoryRing::HostId() {
+  static const string* host_id = []() {
+    // The boot id tells apart hosts that have the same name.
+    string boot_id;
+    ReadFileToString(Env::Default(), "/proc/sys/kernel/random/boot_id",
+                     &boot_id)
+        .IgnoreError();
+    str_util::StripTrailingWhitespace(&boot_id);
+    return new string(strings::StrCat(port::Hostname(), "/", boot_id));
+  }();
+  return *host_id;
+}
+
+void SharedMemoryRing::ReclaimLocked() {
+  while (used_ > 0) {
+    BlockHeader* block =
+        reinterpret_cast<BlockHeader*>(base_ + kBlockAlignment + head_);
+    if (block->released.load(std::memory_order_acquire) == 0) break;
+    used_ -= block->size;
+    head_ += block->size;
+    if (head_ == capacity_) head_ = 0;
+  }
+}
+
+bool SharedMemoryRing::Write(StringPiece data, int64* offset) {
+  const int64 size =
+      kBlockAlignment + RoundUpToBlock(static_cast<int64>(data.size()));
+  char* const blocks = base_ + kBlockAlignment;
+  int64 start;
+  {
+    mutex_lock l(mu_);
+    ReclaimLocked();
+    if (used_ == 0) head_ = tail_ = 0;
+    // Whether the free space is [tail_, head_), rather than the end of the
+    // ring after tail_ and its start before head_.
+    const bool wrapped = tail_ < head_ || (tail_ == head_ && used_ > 0);
+    if (wrapped) {
+      if (size > head_ - tail_) return false;
+      start = tail_;
+    } else if (size <= capacity_ - tail_) {
+      start = tail_;
+    } else if (size <= head_) {
+      // Skips the end of the ring with a filler block.
+      BlockHeader* filler = reinterpret_cast<BlockHeader*>(blocks + tail_);
+      filler->filler = 1;
+      filler->size = capacity_ - tail_;
+      filler->released.store(1, std::memory_order_relaxed);
+      used_ += filler->size;
+      start = 0;
+    } else {
+      return false;
+    }
+    BlockHeader* block = reinterpret_cast<BlockHeader*>(blocks + start);
+    block->filler = 0;
+    block->size = size;
+    block->released.store(0, std::memory_order_relaxed);
+    used_ += size;
+    tail_ = start + size;
+    if (tail_ == capacity_) tail_ = 0;
+  }
+  // The block is reserved, so the copy does not need to hold mu_.
+  memcpy(blocks + start + kBlockAlignment, data.data(), data.size());
+  *offset = start;
+  return true;
+}
+
+Status SharedMemoryRing::Read(int64 offset, int64 size, char* dst) {
+  if (offset < 0 || offset % kBlockAlignment != 0 ||
+      offset + kBlockAlignment > capacity_) {
+    return errors::InvalidArgument("Bad offset ", offset,
+                                   " in shared memory ring ", name_);
+  }
+  char* const blocks = base_ + kBlockAlignment;
+  BlockHeader* block = reinterpret_cast<BlockHeader*>(blocks + offset);
+  if (block->filler != 0 ||
+      block->size < kBlockAlignment + size ||
+      offset + block->size > capacity_) {
+    return errors::InvalidArgument("Bad block of ", size, " bytes at ", offset,
+                                   " in shared memory ring ", name_);
+  }
+  memcpy(dst, blocks + offset + kBlockAlignment, size);
+  block->released.store(1, std::memory_order_release);
+  return Status::OK();
+}
+
+}  // namespace tensorflow
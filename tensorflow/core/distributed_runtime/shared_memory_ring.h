@@ -0,0 +1,110 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_SHARED_MEMORY_RING_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_SHARED_MEMORY_RING_H_
+
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// SharedMemoryRing is a ring buffer in POSIX shared memory, through which a
+// worker passes the contents of the tensors that it sends to the workers on
+// the same host, so that they do not go through the loopback network.
+//
+// The process that creates a ring is its only writer. It copies the content
+// of a tensor into a block of the ring, and sends the offset of the block to
+// the reader in the RPC response. The reader maps the ring by name, copies the
+// block out and marks it as released in the shared memory, and the writer
+// reuses the released blocks in the order in which they were written. A block
+// that is never read, e.g. because its RPC failed, stops the reuse, after
+// which the writer has no room and the tensors are sent in the RPC responses
+// again.
+//
+// SharedMemoryRing is thread-safe.
+class SharedMemoryRing {
+ public:
+  ~SharedMemoryRing();
+
+  // Creates a ring of about `size` bytes under `name`, which must start with
+  // a "/" and contain no other "/".
+  static Status Create(const string& name, int64 size,
+                       std::unique_ptr<SharedMemoryRing>* ring);
+
+  // Maps the ring that another process created under `name`.
+  static Status Open(const string& name,
+                     std::unique_ptr<SharedMemoryRing>* ring);
+
+  // Returns true if the TF_RPC_SHARED_MEMORY_RING_BYTES environment variable
+  // enables the shared memory transport in this process.
+  static bool Enabled();
+
+  // Returns the ring through which this process sends tensors, which is
+  // created with TF_RPC_SHARED_MEMORY_RING_BYTES bytes on first use, or
+  // nullptr if the transport is disabled or the ring cannot be created.
+  static SharedMemoryRing* Local();
+
+  // Sets *ring to the ring of another process named `name`, which is
+  // mapped on first use and stays mapped for the life of this process.
+  static Status Attach(const string& name, SharedMemoryRing** ring);
+
+  // Returns an identifier of this host, with which a worker tells whether a
+  // client runs on the same host.
+  static const string& HostId();
+
+  const string& name() const { return name_; }
+
+  // Copies `data` into a block of the ring, and sets *offset to the offset
+  // of the block. Returns false if the ring has no room for `data`.
+  bool Write(StringPiece data, int64* offset);
+
+  // Copies the `size` bytes of the block at `offset` into `dst`, and then
+  // releases the block.
+  Status Read(int64 offset, int64 size, char* dst);
+
+ private:
+  SharedMemoryRing(const string& name, char* base, int64 mapped_bytes,
+                   bool owner);
+
+  // Advances head_ over the blocks that the readers have released.
+  void ReclaimLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const string name_;
+  char* const base_;
+  const int64 mapped_bytes_;
+  const int64 capacity_;
+  const bool owner_;
+
+  mutex mu_;
+  // The writer's view of the ring: the blocks in [head_, tail_), modulo the
+  // capacity, hold used_ bytes that have not been reclaimed.
+  int64 head_ GUARDED_BY(mu_) = 0;
+  int64 tail_ GUARDED_BY(mu_) = 0;
+  int64 used_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SharedMemoryRing);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_SHARED_MEMORY_RING_H_
@@ -0,0 +1,115 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/shared_memory_ring.h"
+
+#include <unistd.h>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+string RingName() {
+  return strings::Printf("/tf_shared_memory_ring_test_%d_%016llx",
+                         static_cast<int>(getpid()),
+                         static_cast<unsigned long long>(random::New64()));
+}
+
+// Reads the block at `offset` of `ring`, which holds `size` bytes.
+string ReadBlock(SharedMemoryRing* ring, int64 offset, int64 size) {
+  string data(size, '\0');
+  TF_EXPECT_OK(ring->Read(offset, size, &data[0]));
+  return data;
+}
+
+TEST(SharedMemoryRingTest, WritesAreReadByAnotherMapping) {
+  const string name = RingName();
+  std::unique_ptr<SharedMemoryRing> writer;
+  TF_ASSERT_OK(SharedMemoryRing::Create(name, 1 << 16, &writer));
+  std::unique_ptr<SharedMemoryRing> reader;
+  TF_ASSERT_OK(SharedMemoryRing::Open(name, &reader));
+  EXPECT_EQ(name, reader->name());
+
+  int64 first;
+  int64 second;
+  ASSERT_TRUE(writer->Write("hello", &first));
+  ASSERT_TRUE(writer->Write(string(1000, 'x'), &second));
+  EXPECT_NE(first, second);
+  EXPECT_EQ("hello", ReadBlock(reader.get(), first, 5));
+  EXPECT_EQ(string(1000, 'x'), ReadBlock(reader.get(), second, 1000));
+}
+
+TEST(SharedMemoryRingTest, ReusesReleasedBlocks) {
+  // Room for two blocks of 64 bytes, each with its 64-byte header.
+  std::unique_ptr<SharedMemoryRing> ring;
+  TF_ASSERT_OK(SharedMemoryRing::Create(RingName(), 256, &ring));
+  int64 a;
+  int64 b;
+  int64 c;
+  ASSERT_TRUE(ring->Write(string(64, 'a'), &a));
+  ASSERT_TRUE(ring->Write(string(10, 'b'), &b));
+  EXPECT_FALSE(ring->Write("c", &c));
+
+  EXPECT_EQ(string(64, 'a'), ReadBlock(ring.get(), a, 64));
+  ASSERT_TRUE(ring->Write("c", &c));
+  EXPECT_EQ(a, c);
+  EXPECT_EQ(string(10, 'b'), ReadBlock(ring.get(), b, 10));
+  EXPECT_EQ("c", ReadBlock(ring.get(), c, 1));
+}
+
+TEST(SharedMemoryRingTest, WrapsAroundTheEnd) {
+  std::unique_ptr<SharedMemoryRing> ring;
+  TF_ASSERT_OK(SharedMemoryRing::Create(RingName(), 384, &ring));
+  int64 a;
+  int64 b;
+  int64 c;
+  int64 d;
+  ASSERT_TRUE(ring->Write(string(128, 'a'), &a));  // [0, 192)
+  ASSERT_TRUE(ring->Write(string(64, 'b'), &b));   // [192, 320)
+  EXPECT_EQ(string(128, 'a'), ReadBlock(ring.get(), a, 128));
+  // The 64 bytes at the end are too few, so the block starts at 0.
+  ASSERT_TRUE(ring->Write(string(64, 'c'), &c));
+  EXPECT_EQ(0, c);
+  EXPECT_FALSE(ring->Write(string(64, 'd'), &d));
+
+  EXPECT_EQ(string(64, 'b'), ReadBlock(ring.get(), b, 64));
+  EXPECT_EQ(string(64, 'c'), ReadBlock(ring.get(), c, 64));
+  ASSERT_TRUE(ring->Write(string(256, 'd'), &d));
+  EXPECT_EQ(string(256, 'd'), ReadBlock(ring.get(), d, 256));
+}
+
+TEST(SharedMemoryRingTest, RejectsBadBlocks) {
+  std::unique_ptr<SharedMemoryRing> ring;
+  TF_ASSERT_OK(SharedMemoryRing::Create(RingName(), 1024, &ring));
+  int64 offset;
+  ASSERT_TRUE(ring->Write("abc", &offset));
+  char buf[128];
+  EXPECT_FALSE(ring->Read(offset + 1, 3, buf).ok());
+  EXPECT_FALSE(ring->Read(offset, 128, buf).ok());
+  EXPECT_FALSE(ring->Read(1 << 20, 3, buf).ok());
+  TF_EXPECT_OK(ring->Read(offset, 3, buf));
+}
+
+TEST(SharedMemoryRingTest, OpenFailsForMissingRing) {
+  std::unique_ptr<SharedMemoryRing> ring;
+  EXPECT_FALSE(SharedMemoryRing::Open(RingName(), &ring).ok());
+}
+
+}  // namespace
+}  // namespace tensorflow
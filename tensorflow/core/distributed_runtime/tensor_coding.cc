@@ -17,18 +17,30 @@ limitations under the License.
 
 #include "google/protobuf/any.pb.h"
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/distributed_runtime/shared_memory_ring.h"
+#include "tensorflow/core/framework/bfloat16.h"
+#include "tensorflow/core/framework/numeric_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/snappy.h"
 
 namespace tensorflow {
 
 TensorResponse::Source::~Source() {}
 
+TensorBuffer* TensorResponse::Source::ShareContents(const char* data,
+                                                    size_t size) {
+  return nullptr;
+}
+
 void TensorResponse::Clear() {
   on_host_ = false;
   device_ = nullptr;
   alloc_attrs_ = AllocatorAttributes();
   allocator_ = nullptr;
+  staging_allocator_ = nullptr;
   already_used_ = false;
   ClearTensor();
 }
@@ -47,12 +59,22 @@ void TensorResponse::InitAlloc(DeviceBase* d, const AllocatorAttributes& aa) {
     on_host_ = true;
   }
   allocator_ = device_->GetAllocator(alloc_attrs_);
+  const DeviceBase::GpuDeviceInfo* gpu_info = d->tensorflow_gpu_device_info();
+  if (!on_host_ && gpu_info != nullptr &&
+      gpu_info->default_context != nullptr) {
+    AllocatorAttributes staging_attrs;
+    staging_attrs.set_on_host(true);
+    staging_attrs.set_gpu_compatible(true);
+    staging_allocator_ = device_->GetAllocator(staging_attrs);
+  }
 }
 
 Status TensorResponse::InitFrom(RecvTensorResponse* response) {
   Status s;
   meta_.Swap(response);
-  if (on_host_) {
+  if (!DecodeTensorProto(meta_.mutable_tensor())) {
+    s = errors::InvalidArgument("Cannot decode tensor from response");
+  } else if (on_host_) {
     if (!tensor_.FromProto(allocator_, meta_.tensor())) {
       s = errors::InvalidArgument("Cannot parse tensor from response");
     }
@@ -78,12 +100,25 @@ void TensorResponse::InitPartial(const RecvTensorResponse& response) {
 }
 
 Status TensorResponse::ParseFrom(Source* source) {
+  if (already_used_) {
+    ClearTensor();
+  }
+  already_used_ = true;
   if (!on_host_) {
+    if (staging_allocator_ != nullptr &&
+        ParseFast(source, staging_allocator_)) {
+      return CopyToDevice();
+    }
+    meta_.Clear();
+    tensor_ = Tensor();
+
     protobuf::io::CodedInputStream input(source->contents());
     input.SetTotalBytesLimit(INT_MAX, INT_MAX);  // Unlimited
 
     // Pre-parse into local storage, then delegate to device.
-    if (!meta_.ParseFromCodedStream(&input) || !input.ConsumedEntireMessage()) {
+    if (!meta_.ParseFromCodedStream(&input) || !input.ConsumedEntireMessage() ||
+        !ReadSharedMemoryContent(meta_.mutable_tensor()) ||
+        !DecodeTensorProto(meta_.mutable_tensor())) {
       return errors::InvalidArgument("Cannot parse tensor from response");
     }
     Status s =
@@ -96,11 +131,7 @@ Status TensorResponse::ParseFrom(Source* source) {
     meta_.clear_tensor();
     return s;
   }
-  if (already_used_) {
-    ClearTensor();
-  }
-  already_used_ = true;
-  if (ParseFast(source)) return Status::OK();
+  if (ParseFast(source, allocator_)) return Status::OK();
   meta_.Clear();
   if (ParseSlow(source)) return Status::OK();
   return errors::InvalidArgument("Cannot parse tensor from response");
@@ -140,10 +171,43 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
   return input->DecrementRecursionDepthAndPopLimit(p.first);
 }
 
+// Copies the "size" bytes of "block" into "dst", and releases the block.
+bool ReadSharedMemoryBlock(const SharedMemoryBlock& block, char* dst,
+                           size_t size) {
+  if (block.size() != static_cast<int64>(size)) return false;
+  SharedMemoryRing* ring;
+  Status s = SharedMemoryRing::Attach(block.ring(), &ring);
+  if (s.ok()) s = ring->Read(block.offset(), block.size(), dst);
+  if (!s.ok()) {
+    LOG(ERROR) << "Cannot read tensor from shared memory: " << s;
+    return false;
+  }
+  return true;
+}
+
 }  // namespace
 
+bool TensorResponse::ReadSharedMemoryContent() {
+  if (!meta_.has_shared_memory()) return true;
+  StringPiece buf = tensor_.tensor_data();
+  return ReadSharedMemoryBlock(meta_.shared_memory(),
+                               const_cast<char*>(buf.data()), buf.size());
+}
+
+bool TensorResponse::ReadSharedMemoryContent(TensorProto* proto) {
+  if (!meta_.has_shared_memory()) return true;
+  string content(meta_.shared_memory().size(), '\0');
+  if (!ReadSharedMemoryBlock(meta_.shared_memory(), &content[0],
+                             content.size())) {
+    return false;
+  }
+  proto->mutable_tensor_content()->swap(content);
+  return true;
+}
+
 bool TensorResponse::ParseTensorSubmessage(
-    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta) {
+    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta,
+    Allocator* allocator, Source* source) {
   bool seen_tensor_content = false;
   while (true) {
     auto p = input->ReadTagWithCutoff(127);
@@ -154,7 +218,7 @@ bool TensorResponse::ParseTensorSubmessage(
       if (ok && !seen_tensor_content) {
         // No tensor content: could be because it's a zero-length tensor
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        Tensor t(allocator, tensor_meta->dtype(), shape);
         tensor_ = std::move(t);
       }
       return ok;
@@ -194,12 +258,45 @@ bool TensorResponse::ParseTensorSubmessage(
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        const DataType dtype = tensor_meta->dtype();
+        if (meta_.encoding() != RECV_TENSOR_ENCODING_NONE) {
+          // Decodes the content straight into the tensor.
+          string encoded;
+          if (!input->ReadString(&encoded, num_bytes)) return false;
+          Tensor t(allocator, dtype, shape);
+          StringPiece buf = t.tensor_data();
+          if (!DecodeTensorContent(meta_.encoding(), encoded, dtype,
+                                   const_cast<char*>(buf.data()),
+                                   buf.size())) {
+            return false;
+          }
+          tensor_ = std::move(t);
+          break;
+        }
+        if (static_cast<size_t>(num_bytes) !=
+            shape.num_elements() * DataTypeSize(dtype)) {
+          return false;
+        }
+        // Shares the content with the source if it is contiguous and
+        // aligned, and the memory does not need to be allocated by a
+        // particular allocator (e.g. pinned for copies to a GPU).
+        const void* data;
+        int size;
+        if (num_bytes > 0 && allocator == allocator_ &&
+            !alloc_attrs_.gpu_compatible() &&
+            input->GetDirectBufferPointer(&data, &size) && size >= num_bytes &&
+            reinterpret_cast<intptr_t>(data) % EIGEN_MAX_ALIGN_BYTES == 0) {
+          TensorBuffer* shared = source->ShareContents(
+              static_cast<const char*>(data), num_bytes);
+          if (shared != nullptr) {
+            tensor_ = Tensor(dtype, shape, shared);
+            shared->Unref();
+            if (!input->Skip(num_bytes)) return false;
+            break;
+          }
+        }
+        Tensor t(allocator, dtype, shape);
         StringPiece buf = t.tensor_data();
-        if (static_cast<size_t>(num_bytes) != buf.size()) return false;
-        // TODO(jeff,sanjay): Figure out a way to avoid this copy if
-        // the underlying ZeroCopyInputStream data is properly aligned
-        // and compatible with what allocator_ wants.
         if (!input->ReadRaw(const_cast<char*>(buf.data()), num_bytes))
           return false;
         tensor_ = std::move(t);
@@ -214,7 +311,7 @@ bool TensorResponse::ParseTensorSubmessage(
   }
 }
 
-bool TensorResponse::ParseFast(Source* source) {
+bool TensorResponse::ParseFast(Source* source, Allocator* allocator) {
   protobuf::io::CodedInputStream input(source->contents());
   input.SetTotalBytesLimit(INT_MAX, INT_MAX);  // Unlimited
   while (true) {
@@ -222,7 +319,7 @@ bool TensorResponse::ParseFast(Source* source) {
     int tag = GetTagFieldNumber(p.first);
     WireType wt = GetTagWireType(p.first);
     if (!p.second) {
-      return (tag == 0);
+      return (tag == 0) && ReadSharedMemoryContent();
     }
     switch (tag) {
       case RecvTensorResponse::kTensorFieldNumber: {
@@ -233,7 +330,8 @@ bool TensorResponse::ParseFast(Source* source) {
         std::pair<protobuf::io::CodedInputStream::Limit, int> p =
             input.IncrementRecursionDepthAndPushLimit(length);
         if (p.second < 0 ||
-            !ParseTensorSubmessage(&input, meta_.mutable_tensor())) {
+            !ParseTensorSubmessage(&input, meta_.mutable_tensor(), allocator,
+                                   source)) {
           return false;
         }
         if (!input.DecrementRecursionDepthAndPopLimit(p.first)) {
@@ -253,12 +351,33 @@ bool TensorResponse::ParseFast(Source* source) {
         meta_.set_send_start_micros(static_cast<int64>(v));
         break;
       }
+      case RecvTensorResponse::kRequestReceivedMicrosFieldNumber: {
+        protobuf_uint64 v;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint64(&v)) return false;
+        meta_.set_request_received_micros(static_cast<int64>(v));
+        break;
+      }
+      case RecvTensorResponse::kSharedMemoryFieldNumber: {
+        if ((wt != WIRETYPE_LENGTH_DELIMITED) ||
+            !ReadNestedMessage(&input, meta_.mutable_shared_memory()))
+          return false;
+        break;
+      }
       case RecvTensorResponse::kTransportOptionsFieldNumber: {
         if ((wt != WIRETYPE_LENGTH_DELIMITED) ||
             !ReadNestedMessage(&input, meta_.mutable_transport_options()))
           return false;
         break;
       }
+      case RecvTensorResponse::kEncodingFieldNumber: {
+        uint32 v;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint32(&v)) return false;
+        // The content can only be decoded as it is parsed if the encoding
+        // comes first.
+        if (meta_.has_tensor()) return false;
+        meta_.set_encoding(static_cast<RecvTensorEncoding>(v));
+        break;
+      }
       default: {
         // Unknown tag, so don't handle we can't handle on the fast path
         return false;
@@ -270,7 +389,9 @@ bool TensorResponse::ParseFast(Source* source) {
 }
 
 bool TensorResponse::ParseSlow(Source* source) {
-  if (!meta_.ParseFromZeroCopyStream(source->contents())) {
+  if (!meta_.ParseFromZeroCopyStream(source->contents()) ||
+      !ReadSharedMemoryContent(meta_.mutable_tensor()) ||
+      !DecodeTensorProto(meta_.mutable_tensor())) {
     return false;
   }
 
@@ -290,4 +411,112 @@ bool TensorResponse::ParseSlow(Source* source) {
   return true;
 }
 
+bool TensorResponse::DecodeTensorProto(TensorProto* proto) const {
+  if (meta_.encoding() == RECV_TENSOR_ENCODING_NONE) return true;
+  if (!TensorShape::IsValid(proto->tensor_shape()) ||
+      !DataTypeCanUseMemcpy(proto->dtype())) {
+    return false;
+  }
+  TensorShape shape(proto->tensor_shape());
+  string decoded(shape.num_elements() * DataTypeSize(proto->dtype()), '\0');
+  if (!DecodeTensorContent(meta_.encoding(), proto->tensor_content(),
+                           proto->dtype(), &decoded[0], decoded.size())) {
+    return false;
+  }
+  proto->mutable_tensor_content()->swap(decoded);
+  return true;
+}
+
+Status TensorResponse::CopyToDevice() {
+  // Only a Device has a GpuDeviceInfo; see InitAlloc().
+  Device* device = static_cast<Device*>(device_);
+  Tensor device_tensor(allocator_, tensor_.dtype(), tensor_.shape());
+  Notification n;
+  Status status;
+  DeviceContext* context =
+      device_->tensorflow_gpu_device_info()->default_context;
+  context->CopyCPUTensorToDevice(&tensor_, device, &device_tensor,
+                                 [&n, &status](const Status& s) {
+                                   status = s;
+                                   n.Notify();
+                                 });
+  n.WaitForNotification();
+  tensor_ = std::move(device_tensor);
+  return status;
+}
+
+bool EncodeTensorContent(RecvTensorEncoding encoding, const Tensor& val,
+                         string* encoded) {
+  if (!DataTypeCanUseMemcpy(val.dtype())) return false;
+  const StringPiece content = val.tensor_data();
+  const int64 n = val.NumElements();
+  switch (encoding) {
+    case RECV_TENSOR_ENCODING_SNAPPY: {
+      string compressed;
+      if (!port::Snappy_Compress(content.data(), content.size(),
+                                 &compressed) ||
+          compressed.size() >= content.size()) {
+        return false;
+      }
+      encoded->swap(compressed);
+      return true;
+    }
+    case RECV_TENSOR_ENCODING_BFLOAT16: {
+      if (val.dtype() != DT_FLOAT) return false;
+      encoded->resize(n * sizeof(bfloat16));
+      FloatToBFloat16(reinterpret_cast<const float*>(content.data()),
+                      reinterpret_cast<bfloat16*>(&(*encoded)[0]), n);
+      return true;
+    }
+    case RECV_TENSOR_ENCODING_HALF: {
+      if (val.dtype() != DT_FLOAT) return false;
+      encoded->resize(n * sizeof(Eigen::half));
+      FloatToHalf(reinterpret_cast<const float*>(content.data()),
+                  reinterpret_cast<Eigen::half*>(&(*encoded)[0]), n);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+bool DecodeTensorContent(RecvTensorEncoding encoding, StringPiece encoded,
+                         DataType dtype, char* dst, size_t num_bytes) {
+  const int64 n = num_bytes / sizeof(float);
+  switch (encoding) {
+    case RECV_TENSOR_ENCODING_NONE: {
+      if (encoded.size() != num_bytes) return false;
+      memcpy(dst, encoded.data(), num_bytes);
+      return true;
+    }
+    case RECV_TENSOR_ENCODING_SNAPPY: {
+      size_t uncompressed_size;
+      if (!port::Snappy_GetUncompressedLength(encoded.data(), encoded.size(),
+                                              &uncompressed_size) ||
+          uncompressed_size != num_bytes) {
+        return false;
+      }
+      return port::Snappy_Uncompress(encoded.data(), encoded.size(), dst);
+    }
+    case RECV_TENSOR_ENCODING_BFLOAT16: {
+      if (dtype != DT_FLOAT || encoded.size() != n * sizeof(bfloat16)) {
+        return false;
+      }
+      BFloat16ToFloat(reinterpret_cast<const bfloat16*>(encoded.data()),
+                      reinterpret_cast<float*>(dst), n);
+      return true;
+    }
+    case RECV_TENSOR_ENCODING_HALF: {
+      if (dtype != DT_FLOAT || encoded.size() != n * sizeof(Eigen::half)) {
+        return false;
+      }
+      HalfToFloat(reinterpret_cast<const Eigen::half*>(encoded.data()),
+                  reinterpret_cast<float*>(dst), n);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
 }  // namespace tensorflow
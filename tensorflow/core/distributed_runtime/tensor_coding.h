@@ -27,6 +27,7 @@ namespace tensorflow {
 
 class Allocator;
 class DeviceBase;
+class TensorBuffer;
 class TensorProto;
 
 // TensorResponse can be used as the destination of an RPC that returns
@@ -64,10 +65,24 @@ class TensorResponse {
     // Ownership of the returned stream is retained by the Source and
     // should not be deleted by the caller.
     virtual ::tensorflow::protobuf::io::ZeroCopyInputStream* contents() = 0;
+
+    // Returns a buffer that shares the `size` bytes at `data`, which were
+    // yielded by the last stream returned by contents(), and keeps them
+    // alive after the stream is gone. Returns nullptr if the bytes cannot
+    // be shared, in which case ParseFrom copies them.
+    //
+    // The default implementation never shares.
+    virtual TensorBuffer* ShareContents(const char* data, size_t size);
   };
 
   // Parse the RecvTensorResponse encoded in the data yielded by
   // source->contents() into *this.
+  //
+  // Where possible, the tensor content is written straight into a tensor
+  // allocated with the allocator given to InitAlloc(), or is shared with
+  // the source if it lies in one suitably aligned buffer.  For GPU
+  // devices, the content is written into pinned host memory and then
+  // copied to the device once.
   Status ParseFrom(Source* source);
 
   // Initialize tensor from *response.
@@ -89,19 +104,41 @@ class TensorResponse {
 
  private:
   bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
-                             TensorProto* tensor_meta);
-  bool ParseFast(Source* source);
+                             TensorProto* tensor_meta, Allocator* allocator,
+                             Source* source);
+  bool ParseFast(Source* source, Allocator* allocator);
   bool ParseSlow(Source* source);
+  bool DecodeTensorProto(TensorProto* proto) const;
+  // Copy the content of the tensor from the shared memory block named by
+  // the response, if any, into tensor_ or into "proto".
+  bool ReadSharedMemoryContent();
+  bool ReadSharedMemoryContent(TensorProto* proto);
+  Status CopyToDevice();
 
   bool on_host_ = false;
   DeviceBase* device_ = nullptr;
   AllocatorAttributes alloc_attrs_;
   Allocator* allocator_ = nullptr;
+  // Allocates the pinned host memory that the contents of tensors for a GPU
+  // device are parsed into, or nullptr if the device is not a GPU.
+  Allocator* staging_allocator_ = nullptr;
   bool already_used_ = false;
   Tensor tensor_;
   RecvTensorResponse meta_;
 };
 
+// Encodes the content of "val" with "encoding" into "*encoded".  Returns
+// false, leaving "*encoded" unchanged, if "encoding" does not apply to the
+// dtype of "val" or would not make its content smaller.
+bool EncodeTensorContent(RecvTensorEncoding encoding, const Tensor& val,
+                         string* encoded);
+
+// Decodes "encoded", the content of a tensor of "dtype" that was encoded
+// with "encoding", into the "num_bytes" bytes at "dst".  Returns false if
+// "encoded" is not a valid encoding of that many bytes.
+bool DecodeTensorContent(RecvTensorEncoding encoding, StringPiece encoded,
+                         DataType dtype, char* dst, size_t num_bytes);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_CODING_H_
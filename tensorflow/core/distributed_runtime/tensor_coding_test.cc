@@ -15,10 +15,18 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include <unistd.h>
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/distributed_runtime/shared_memory_ring.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
@@ -156,6 +164,237 @@ TEST_F(TensorResponseTest, Simple) {
 
 TEST_F(TensorResponseTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+// A TensorBuffer that points into memory owned by the test.
+class UnownedBuffer : public TensorBuffer {
+ public:
+  UnownedBuffer(const char* data, size_t size) : data_(data), size_(size) {}
+
+  void* data() const override { return const_cast<char*>(data_); }
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const char* const data_;
+  const size_t size_;
+};
+
+// A source that yields `size` bytes at `data` in blocks of `block_size`
+// bytes, and shares the contents when asked.
+class SharingSource : public TensorResponse::Source {
+ public:
+  SharingSource(const char* data, int size, int block_size)
+      : data_(data), size_(size), block_size_(block_size) {}
+
+  protobuf::io::ZeroCopyInputStream* contents() override {
+    stream_.reset(
+        new protobuf::io::ArrayInputStream(data_, size_, block_size_));
+    return stream_.get();
+  }
+
+  TensorBuffer* ShareContents(const char* data, size_t size) override {
+    ++num_shared_;
+    return new UnownedBuffer(data, size);
+  }
+
+  int num_shared() const { return num_shared_; }
+
+ private:
+  const char* const data_;
+  const int size_;
+  const int block_size_;
+  std::unique_ptr<protobuf::io::ArrayInputStream> stream_;
+  int num_shared_ = 0;
+};
+
+// Encodes `src` into `space`, so that its content starts `misalignment`
+// bytes past an aligned address, and returns the start of the encoding.
+char* EncodeAligned(const Tensor& src, int misalignment,
+                    std::vector<char>* space, int* size, const char** content) {
+  RecvTensorResponse proto;
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  string encoded;
+  proto.AppendToString(&encoded);
+  const StringPiece data = src.tensor_data();
+  const size_t offset = encoded.find(data.data(), 0, data.size());
+  CHECK_NE(string::npos, offset);
+
+  space->resize(encoded.size() + 3 * EIGEN_MAX_ALIGN_BYTES);
+  const intptr_t base = reinterpret_cast<intptr_t>(space->data());
+  const intptr_t aligned_content =
+      (base + offset + EIGEN_MAX_ALIGN_BYTES) / EIGEN_MAX_ALIGN_BYTES *
+          EIGEN_MAX_ALIGN_BYTES +
+      misalignment;
+  char* start = space->data() + (aligned_content - offset - base);
+  memcpy(start, encoded.data(), encoded.size());
+  *size = encoded.size();
+  *content = start + offset;
+  return start;
+}
+
+TEST_F(TensorResponseTest, SharesAlignedContents) {
+  Tensor src(DT_FLOAT, TensorShape({1000}));
+  test::FillIota<float>(&src, 0);
+  std::vector<char> space;
+  int size;
+  const char* content;
+  const char* data = EncodeAligned(src, 0, &space, &size, &content);
+
+  DummyDevice cpu_device(Env::Default());
+  {
+    // The content is in one block, so it is shared.
+    SharingSource source(data, size, -1);
+    TensorResponse response;
+    response.InitAlloc(&cpu_device, AllocatorAttributes());
+    TF_EXPECT_OK(response.ParseFrom(&source));
+    EXPECT_EQ(1, source.num_shared());
+    EXPECT_EQ(content, response.tensor().tensor_data().data());
+    test::ExpectTensorEqual<float>(src, response.tensor());
+  }
+  {
+    // The content spans several blocks, so it is copied.
+    SharingSource source(data, size, 100);
+    TensorResponse response;
+    response.InitAlloc(&cpu_device, AllocatorAttributes());
+    TF_EXPECT_OK(response.ParseFrom(&source));
+    EXPECT_EQ(0, source.num_shared());
+    test::ExpectTensorEqual<float>(src, response.tensor());
+  }
+}
+
+TEST_F(TensorResponseTest, CopiesMisalignedContents) {
+  Tensor src(DT_FLOAT, TensorShape({1000}));
+  test::FillIota<float>(&src, 0);
+  std::vector<char> space;
+  int size;
+  const char* content;
+  const char* data = EncodeAligned(src, 1, &space, &size, &content);
+
+  DummyDevice cpu_device(Env::Default());
+  SharingSource source(data, size, -1);
+  TensorResponse response;
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  TF_EXPECT_OK(response.ParseFrom(&source));
+  EXPECT_EQ(0, source.num_shared());
+  test::ExpectTensorEqual<float>(src, response.tensor());
+}
+
+// Returns a RecvTensorResponse for "src" with its content encoded with
+// "encoding".  If "encoding_first", the encoding field precedes the tensor
+// on the wire, as it does in the responses of the gRPC worker service.
+string EncodeWithEncoding(const Tensor& src, RecvTensorEncoding encoding,
+                          bool encoding_first) {
+  RecvTensorResponse header;
+  header.set_send_start_micros(123456);
+  header.set_request_received_micros(123000);
+  header.set_encoding(encoding);
+  RecvTensorResponse body;
+  src.AsProtoTensorContent(body.mutable_tensor());
+  string content;
+  EXPECT_TRUE(EncodeTensorContent(encoding, src, &content));
+  body.mutable_tensor()->set_tensor_content(content);
+  string encoded;
+  if (encoding_first) {
+    header.AppendToString(&encoded);
+    body.AppendToString(&encoded);
+  } else {
+    body.AppendToString(&encoded);
+    header.AppendToString(&encoded);
+  }
+  return encoded;
+}
+
+TEST_F(TensorResponseTest, DecodesEncodedContents) {
+  // Values that bfloat16 and half represent exactly.
+  Tensor src(DT_FLOAT, TensorShape({10, 100}));
+  test::FillFn<float>(&src, [](int i) { return (i % 256) - 128.0f; });
+  DummyDevice cpu_device(Env::Default());
+  for (RecvTensorEncoding encoding :
+       {RECV_TENSOR_ENCODING_SNAPPY, RECV_TENSOR_ENCODING_BFLOAT16,
+        RECV_TENSOR_ENCODING_HALF}) {
+    for (bool encoding_first : {false, true}) {
+      const string encoded =
+          EncodeWithEncoding(src, encoding, encoding_first);
+      StringSource source(&encoded, 1024);
+      TensorResponse response;
+      response.InitAlloc(&cpu_device, AllocatorAttributes());
+      TF_EXPECT_OK(response.ParseFrom(&source));
+      EXPECT_EQ(encoding, response.metadata().encoding());
+      EXPECT_EQ(123456, response.metadata().send_start_micros());
+      EXPECT_EQ(123000, response.metadata().request_received_micros());
+      test::ExpectTensorEqual<float>(src, response.tensor());
+    }
+  }
+}
+
+TEST_F(TensorResponseTest, RejectsCorruptEncodedContents) {
+  Tensor src(DT_FLOAT, TensorShape({100}));
+  test::FillIota<float>(&src, 0);
+  RecvTensorResponse proto;
+  proto.set_encoding(RECV_TENSOR_ENCODING_BFLOAT16);
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  // The content has the size of the float tensor, not of its bfloat16 form.
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  StringSource source(&encoded, 1024);
+  DummyDevice cpu_device(Env::Default());
+  TensorResponse response;
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  EXPECT_FALSE(response.ParseFrom(&source).ok());
+}
+
+TEST_F(TensorResponseTest, ReadsContentFromSharedMemory) {
+  Tensor src(DT_FLOAT, TensorShape({10, 100}));
+  test::FillIota<float>(&src, 0);
+  std::unique_ptr<SharedMemoryRing> ring;
+  TF_ASSERT_OK(SharedMemoryRing::Create(
+      strings::StrCat("/tf_tensor_coding_test_", getpid()), 1 << 16, &ring));
+  DummyDevice cpu_device(Env::Default());
+  for (bool block_first : {false, true}) {
+    int64 offset;
+    ASSERT_TRUE(ring->Write(src.tensor_data(), &offset));
+    RecvTensorResponse header;
+    header.mutable_shared_memory()->set_ring(ring->name());
+    header.mutable_shared_memory()->set_offset(offset);
+    header.mutable_shared_memory()->set_size(src.TotalBytes());
+    RecvTensorResponse body;
+    body.mutable_tensor()->set_dtype(DT_FLOAT);
+    src.shape().AsProto(body.mutable_tensor()->mutable_tensor_shape());
+    string encoded;
+    if (block_first) {
+      header.AppendToString(&encoded);
+      body.AppendToString(&encoded);
+    } else {
+      body.AppendToString(&encoded);
+      header.AppendToString(&encoded);
+    }
+
+    StringSource source(&encoded, 1024);
+    TensorResponse response;
+    response.InitAlloc(&cpu_device, AllocatorAttributes());
+    TF_EXPECT_OK(response.ParseFrom(&source));
+    test::ExpectTensorEqual<float>(src, response.tensor());
+  }
+}
+
+TEST(TensorContentEncodingTest, SkipsUnsupportedTypes) {
+  Tensor ints(DT_INT32, TensorShape({10}));
+  test::FillIota<int32>(&ints, 0);
+  string encoded;
+  // Only floating point content is narrowed.
+  EXPECT_FALSE(
+      EncodeTensorContent(RECV_TENSOR_ENCODING_BFLOAT16, ints, &encoded));
+  EXPECT_FALSE(EncodeTensorContent(RECV_TENSOR_ENCODING_HALF, ints, &encoded));
+
+  Tensor strings(DT_STRING, TensorShape({2}));
+  EXPECT_FALSE(
+      EncodeTensorContent(RECV_TENSOR_ENCODING_SNAPPY, strings, &encoded));
+}
+
 string MakeFloatTensorTestCase(int num_elems) {
   std::vector<int8> v(num_elems);
   for (int i = 0; i < num_elems; i++) {
@@ -0,0 +1,271 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks of the transfers of tensors between the workers of a local
+// cluster, through the RecvTensor path and through the collective ops.
+//
+// The transport of the workers is set by the TF_TRANSPORT_BENCH_PROTOCOL
+// environment variable: "grpc" (the default), "grpc+verbs", "grpc+gdr" or
+// "grpc+mpi", the latter three only in builds with the corresponding
+// support. TF_RPC_SHARED_MEMORY_RING_BYTES enables the shared memory
+// transport of grpc, and TF_TRANSPORT_BENCH_DEVICE=GPU places the tensors on
+// GPUs. Each benchmark reports the throughput of the transfers, and its label
+// the percentiles of the latencies of the steps, e.g.:
+//
+//   TF_TRANSPORT_BENCH_PROTOCOL=grpc+verbs \
+//     transport_bench_test --benchmarks=BM_RecvTensor
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_session.h"
+#include "tensorflow/core/distributed_runtime/server_lib.h"
+#include "tensorflow/core/distributed_runtime/shared_memory_ring.h"
+#include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/histogram/histogram.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/tensorflow_server.pb.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace {
+
+const int kTasks = 4;
+
+string EnvOrDefault(const char* name, const string& default_value) {
+  const char* value = getenv(name);
+  return value == nullptr || value[0] == '\0' ? default_value : value;
+}
+
+string Protocol() {
+  return EnvOrDefault("TF_TRANSPORT_BENCH_PROTOCOL", "grpc");
+}
+
+string DeviceType() { return EnvOrDefault("TF_TRANSPORT_BENCH_DEVICE", "CPU"); }
+
+// A cluster of kTasks workers of the benchmarked protocol, which run in this
+// process and each have one device of the benchmarked type.
+struct Cluster {
+  SessionOptions options;
+  // The device of each task, in the order of the tasks.
+  std::vector<string> devices;
+  thread::ThreadPool* threads;  // Runs the servers.
+
+  Cluster() {
+    const string protocol = Protocol();
+    const string device_type = DeviceType();
+    std::vector<int> ports(kTasks);
+    for (int i = 0; i < kTasks; ++i) {
+      ports[i] = testing::PickUnusedPortOrDie();
+    }
+    threads = new thread::ThreadPool(Env::Default(), "servers", kTasks);
+    for (int task = 0; task < kTasks; ++task) {
+      ServerDef server;
+      server.set_protocol(protocol);
+      server.set_job_name("localhost");
+      server.set_task_index(task);
+      auto job_def = server.mutable_cluster()->add_job();
+      job_def->set_name("localhost");
+      for (int i = 0; i < kTasks; ++i) {
+        (*job_def->mutable_tasks())[i] =
+            strings::StrCat("localhost:", ports[i]);
+      }
+      auto config = server.mutable_default_session_config();
+      (*config->mutable_device_count())["CPU"] = 1;
+      (*config->mutable_device_count())["GPU"] = device_type == "GPU" ? 1 : 0;
+      threads->Schedule([server] {
+        std::unique_ptr<ServerInterface> svr;
+        TF_CHECK_OK(NewServer(server, &svr));
+        TF_CHECK_OK(svr->Start());
+        TF_CHECK_OK(svr->Join());
+      });
+    }
+
+    // The client talks to the master over grpc, whatever the transport
+    // between the workers.
+    options.target = strings::StrCat("grpc://localhost:", ports[0]);
+    // Keeps the constants that are sent from being folded into the
+    // partitions that receive them.
+    options.config.mutable_graph_options()
+        ->mutable_optimizer_options()
+        ->set_opt_level(OptimizerOptions::L0);
+    std::unique_ptr<GrpcSession> session;
+    TF_CHECK_OK(GrpcSession::Create(options, &session));
+    std::vector<DeviceAttributes> attributes;
+    TF_CHECK_OK(session->ListDevices(&attributes));
+    devices.resize(kTasks);
+    for (const DeviceAttributes& device : attributes) {
+      DeviceNameUtils::ParsedName parsed;
+      CHECK(DeviceNameUtils::ParseFullName(device.name(), &parsed));
+      if (device.device_type() == device_type && parsed.id == 0) {
+        devices[parsed.task] = device.name();
+      }
+    }
+    for (int task = 0; task < kTasks; ++task) {
+      CHECK(!devices[task].empty()) << "No " << device_type << " on task "
+                                    << task;
+    }
+  }
+};
+
+const Cluster* GetCluster() {
+  static Cluster* cluster = new Cluster;
+  return cluster;
+}
+
+string TransportName() {
+  string name = Protocol();
+  if (SharedMemoryRing::Enabled()) strings::StrAppend(&name, "+shm");
+  return strings::StrCat(name, " ", DeviceType());
+}
+
+// Runs the steps of `def` that run `targets`, `iters` times in total and
+// `concurrency` at a time, and reports the throughput of the
+// `bytes_per_step` that each step transfers and the latencies of the steps.
+void RunSteps(int iters, int concurrency, int64 bytes_per_step,
+              const GraphDef& def, const std::vector<string>& targets) {
+  const Cluster* cluster = GetCluster();
+  std::unique_ptr<Session> session(NewSession(cluster->options));
+  TF_CHECK_OK(session->Create(def));
+  // Do a few warmup steps, which also set up the connections.
+  for (int i = 0; i < 3; ++i) {
+    std::vector<Tensor> outputs;
+    TF_CHECK_OK(session->Run({}, {}, targets, &outputs));
+  }
+
+  histogram::ThreadSafeHistogram latencies;
+  thread::ThreadPool clients(Env::Default(), "clients", concurrency);
+  BlockingCounter done(concurrency);
+  testing::StartTiming();
+  for (int i = 0; i < concurrency; ++i) {
+    const int steps = iters / concurrency + (i < iters % concurrency ? 1 : 0);
+    clients.Schedule([steps, &session, &targets, &latencies, &done] {
+      Env* env = Env::Default();
+      for (int step = 0; step < steps; ++step) {
+        std::vector<Tensor> outputs;
+        const uint64 start = env->NowMicros();
+        TF_CHECK_OK(session->Run({}, {}, targets, &outputs));
+        latencies.Add(env->NowMicros() - start);
+      }
+      done.DecrementCount();
+    });
+  }
+  done.Wait();
+  testing::StopTiming();
+  TF_CHECK_OK(session->Close());
+
+  testing::BytesProcessed(bytes_per_step * iters);
+  testing::SetLabel(strings::Printf(
+      "%s; %lld bytes/step; latency us p50 %.0f p90 %.0f p99 %.0f",
+      TransportName().c_str(), static_cast<long long>(bytes_per_step),
+      latencies.Percentile(50), latencies.Percentile(90),
+      latencies.Percentile(99)));
+}
+
+// Each step sends a tensor of `num_floats` from task 1 to task 0.
+void BM_RecvTensor(int iters, int num_floats, int concurrency) {
+  testing::StopTiming();
+  const Cluster* cluster = GetCluster();
+
+  using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+  Scope s = Scope::NewRootScope();
+  Output x = Const(s.WithOpName("x").WithDevice(cluster->devices[1]), 0.0f,
+                   {num_floats});
+  Identity(s.WithOpName("y").WithDevice(cluster->devices[0]), x);
+  GraphDef def;
+  TF_CHECK_OK(s.ToGraphDef(&def));
+
+  RunSteps(iters, concurrency, num_floats * sizeof(float), def, {"y"});
+}
+
+// Each step all-reduces a tensor of `num_floats` across the kTasks tasks.
+void BM_CollectiveAllReduce(int iters, int num_floats,
+                                   int concurrency) {
+  testing::StopTiming();
+  const Cluster* cluster = GetCluster();
+
+  using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+  Scope s = Scope::NewRootScope();
+  std::vector<string> targets;
+  for (int task = 0; task < kTasks; ++task) {
+    const string& device = cluster->devices[task];
+    Output x =
+        Const(s.WithOpName(strings::StrCat("x", task)).WithDevice(device),
+              1.0f, {num_floats});
+    const string name = strings::StrCat("all_reduce", task);
+    Node* node;
+    TF_CHECK_OK(NodeBuilder(name, "CollectiveAllReduce")
+                    .Input(x.node())
+                    .Attr("devices", cluster->devices)
+                    .Attr("instance_key", "transport_bench")
+                    .Device(device)
+                    .Finalize(s.graph(), &node));
+    targets.push_back(name);
+  }
+  GraphDef def;
+  TF_CHECK_OK(s.ToGraphDef(&def));
+
+  // Each device sends about twice its input around the ring.
+  RunSteps(iters, concurrency, 2 * kTasks * num_floats * sizeof(float), def,
+           targets);
+}
+
+// Tensors of 1KB, 64KB, 1MB and 16MB, with 1, 4 and 16 concurrent steps.
+BENCHMARK(BM_RecvTensor)
+    ->ArgPair(256, 1)
+    ->ArgPair(256, 4)
+    ->ArgPair(256, 16)
+    ->ArgPair(16 << 10, 1)
+    ->ArgPair(16 << 10, 4)
+    ->ArgPair(16 << 10, 16)
+    ->ArgPair(256 << 10, 1)
+    ->ArgPair(256 << 10, 4)
+    ->ArgPair(256 << 10, 16)
+    ->ArgPair(4 << 20, 1)
+    ->ArgPair(4 << 20, 4)
+    ->ArgPair(4 << 20, 16);
+
+BENCHMARK(BM_CollectiveAllReduce)
+    ->ArgPair(256, 1)
+    ->ArgPair(256, 4)
+    ->ArgPair(256, 16)
+    ->ArgPair(16 << 10, 1)
+    ->ArgPair(16 << 10, 4)
+    ->ArgPair(16 << 10, 16)
+    ->ArgPair(256 << 10, 1)
+    ->ArgPair(256 << 10, 4)
+    ->ArgPair(256 << 10, 16)
+    ->ArgPair(4 << 20, 1)
+    ->ArgPair(4 << 20, 4)
+    ->ArgPair(4 << 20, 16);
+
+}  // namespace
+}  // namespace tensorflow
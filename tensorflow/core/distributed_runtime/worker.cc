@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/worker.h"
 
+#include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
@@ -56,7 +57,7 @@ void Worker::RegisterGraphAsync(const RegisterGraphRequest* request,
   Status s = session->graph_mgr->Register(
       request->session_handle(), request->graph_def(), request->graph_options(),
       request->debug_options(), session->cluster_flr.get(),
-      response->mutable_graph_handle());
+      request->share_graph(), response->mutable_graph_handle());
   done(s);
 }
 
@@ -283,9 +284,33 @@ void Worker::CleanupAllAsync(const CleanupAllRequest* request,
   done(Status::OK());
 }
 
+// Only the RPC logs of the legacy session are reported, since the request
+// does not identify a session.
 void Worker::LoggingAsync(const LoggingRequest* request,
                           LoggingResponse* response, StatusCallback done) {
-  done(errors::Unimplemented("Logging"));
+  WorkerCacheInterface* worker_cache =
+      env_->session_mgr->LegacySession()->worker_cache.get();
+  if (worker_cache == nullptr) {
+    done(errors::Unimplemented("Logging"));
+    return;
+  }
+  if (request->rpc_logging()) {
+    worker_cache->SetLogging(true);
+  } else if (request->fetch_step_id_size() == 0 && !request->clear()) {
+    worker_cache->SetLogging(false);
+  }
+  if (request->clear()) {
+    worker_cache->ClearLogs();
+  }
+  for (int64 step_id : request->fetch_step_id()) {
+    LabeledStepStats step;
+    if (worker_cache->RetrieveLogs(step_id, step.mutable_step_stats())) {
+      step.set_step_id(step_id);
+      response->add_step()->Swap(&step);
+    }
+  }
+  response->set_now_micros(Env::Default()->NowMicros());
+  done(Status::OK());
 }
 
 void Worker::TracingAsync(const TracingRequest* request,
@@ -323,4 +348,173 @@ void Worker::RecvTensorAsync(CallOptions* opts,
   done(errors::Unimplemented("Worker::RecvTensorAsync()"));
 }
 
+namespace {
+
+// Tensors larger than this are not returned by RecvTensors, so that they
+// can use the transport's more efficient path for large tensors.
+const int64 kMaxCoalescedTensorBytes = 64 << 10;
+
+// How long RecvTensors waits for more tensors after the first is ready.
+const int64 kRecvTensorsWaitMicros = 1000;
+
+// The state of one RecvTensorsAsync() call, shared by its callbacks.
+struct RecvTensorsState {
+  RecvTensorsState(CallOptions* opts, RecvTensorsResponse* response,
+                   StatusCallback done, int num_pending)
+      : opts(opts),
+        response(response),
+        done(std::move(done)),
+        num_pending(num_pending) {}
+
+  CallOptions* const opts;
+  RecvTensorsResponse* const response;
+  const StatusCallback done;
+
+  mutex mu;
+  int num_pending GUARDED_BY(mu);
+  bool responded GUARDED_BY(mu) = false;
+
+  // Responds unless this has already responded.
+  void Respond(const Status& s) {
+    {
+      mutex_lock l(mu);
+      if (responded) return;
+      responded = true;
+    }
+    opts->ClearCancelCallback();
+    done(s);
+  }
+};
+
+}  // namespace
+
+void Worker::RecvTensorsAsync(CallOptions* opts,
+                              const RecvTensorsRequest* request,
+                              RecvTensorsResponse* response,
+                              StatusCallback done) {
+  const int64 step_id = request->step_id();
+  const int num_keys = request->rendezvous_keys_size();
+  std::vector<Rendezvous::ParsedKey> parsed(num_keys);
+  std::vector<Device*> src_devs(num_keys);
+  for (int i = 0; i < num_keys; ++i) {
+    Status s = Rendezvous::ParseKey(request->rendezvous_keys(i), &parsed[i]);
+    if (s.ok()) {
+      s = PrepareRecvTensor(parsed[i], &src_devs[i]);
+    }
+    if (!s.ok()) {
+      done(s);
+      return;
+    }
+  }
+  if (num_keys == 0) {
+    done(Status::OK());
+    return;
+  }
+
+  auto state = std::make_shared<RecvTensorsState>(opts, response,
+                                                  std::move(done), num_keys);
+  opts->SetCancelCallback([this, step_id]() { AbortStep(step_id); });
+
+  // Adds a tensor to the response, or gives it back to the rendezvous if
+  // the response has already been sent, so that it can be requested again.
+  // `val` is the tensor as it was sent, and `host_val` is its copy in host
+  // memory.
+  auto deliver = [this, state, step_id](
+      const Rendezvous::ParsedKey& key, const Rendezvous::Args& send_args,
+      const Tensor& val, const Tensor& host_val, bool is_dead,
+      bool coalesce) {
+    bool respond = false;
+    bool give_back = false;
+    {
+      mutex_lock l(state->mu);
+      if (state->responded) {
+        give_back = true;
+      } else {
+        if (coalesce) {
+          state->response->add_ready_keys(key.FullKey().ToString());
+          RecvTensorResponse* tensor = state->response->add_tensors();
+          tensor->set_is_dead(is_dead);
+          tensor->set_send_start_micros(Env::Default()->NowMicros());
+          if (!is_dead) {
+            if (DataTypeCanUseMemcpy(host_val.dtype())) {
+              host_val.AsProtoTensorContent(tensor->mutable_tensor());
+            } else {
+              host_val.AsProtoField(tensor->mutable_tensor());
+            }
+          }
+        } else {
+          // The client receives the tensor with RecvTensor.
+          give_back = true;
+          state->response->add_uncoalesced_keys(key.FullKey().ToString());
+        }
+        const bool first =
+            state->response->ready_keys_size() +
+                state->response->uncoalesced_keys_size() ==
+            1;
+        respond = --state->num_pending == 0;
+        if (first && !respond) {
+          SchedNonBlockingClosureAfter(kRecvTensorsWaitMicros, [state]() {
+            state->Respond(Status::OK());
+          });
+        }
+      }
+    }
+    if (give_back) {
+      Rendezvous* rendez = env_->rendezvous_mgr->Find(step_id);
+      Status s = rendez->Send(key, send_args, val, is_dead);
+      rendez->Unref();
+      if (!s.ok()) {
+        state->Respond(s);
+        return;
+      }
+    }
+    if (respond) {
+      state->Respond(Status::OK());
+    }
+  };
+
+  for (int i = 0; i < num_keys; ++i) {
+    const Rendezvous::ParsedKey& key = parsed[i];
+    Device* src_dev = src_devs[i];
+    env_->rendezvous_mgr->RecvLocalAsync(
+        step_id, key,
+        [state, deliver, key, src_dev](
+            const Status& status, const Rendezvous::Args& send_args,
+            const Rendezvous::Args& recv_args, const Tensor& val,
+            const bool is_dead) {
+          if (!status.ok()) {
+            state->Respond(status);
+            return;
+          }
+          const bool coalesce = val.TotalBytes() <= kMaxCoalescedTensorBytes;
+          const bool on_device = src_dev->tensorflow_gpu_device_info() &&
+                                 !send_args.alloc_attrs.on_host();
+          if (!coalesce || is_dead || !on_device) {
+            deliver(key, send_args, val, val, is_dead, coalesce);
+            return;
+          }
+          // Copies the tensor to host memory before adding it to the
+          // response.
+          AllocatorAttributes alloc_attrs;
+          alloc_attrs.set_gpu_compatible(true);
+          alloc_attrs.set_on_host(true);
+          Allocator* alloc = src_dev->GetAllocator(alloc_attrs);
+          Tensor* copy = new Tensor(alloc, val.dtype(), val.shape());
+          CHECK(send_args.device_context)
+              << "send dev name: " << src_dev->name();
+          send_args.device_context->CopyDeviceTensorToCPU(
+              &val, key.edge_name, src_dev, copy,
+              [state, deliver, key, send_args, val, copy,
+               is_dead](const Status& s) {
+                if (s.ok()) {
+                  deliver(key, send_args, val, *copy, is_dead, true);
+                } else {
+                  state->Respond(s);
+                }
+                delete copy;
+              });
+        });
+  }
+}
+
 }  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/worker_cache_logger.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/tensor_description.pb.h"
@@ -22,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/device_name_utils.h"
 
 namespace tensorflow {
 
@@ -29,6 +32,10 @@ namespace {
 // Maximum number of step_ids for which RPC logs can be maintained.
 // TODO(mrry): Make this configurable if necessary.
 const int32 kWorkerCacheLoggerLimit = 1 << 10;
+
+// Clocks drift apart slowly, so a clock sample with a short delay is replaced
+// by a noisier one only once it is this old.
+const int64 kClockSampleLifetimeMicros = 60 * 1000 * 1000;
 }  // namespace
 
 void WorkerCacheLogger::SetLogging(bool v) {
@@ -92,6 +99,89 @@ void WorkerCacheLogger::RecordRecvTensor(int64 step_id, int64 start_usecs,
                      dst_device, bytes, "", "RecvTensor");
 }
 
+void WorkerCacheLogger::RecordRecvTensor(int64 step_id,
+                                         const RecvTensorTimes& times,
+                                         const string& tensor_name,
+                                         const string& src_device,
+                                         const string& dst_device,
+                                         int64 bytes) {
+  string task;
+  string device;
+  int64 offset = 0;
+  const bool aligned =
+      times.request_received_micros > 0 && times.send_start_micros > 0 &&
+      DeviceNameUtils::SplitDeviceName(src_device, &task, &device);
+  if (aligned) {
+    AddClockSample(task, times.request_sent_micros,
+                   times.request_received_micros, times.send_start_micros,
+                   times.response_received_micros);
+    ClockOffset(task, &offset);
+  }
+  // To respect causality, the remote timestamps are kept between the
+  // sending of the request and the receipt of the response.
+  auto to_local = [&times, offset](int64 remote_micros) {
+    return std::min(std::max(remote_micros - offset, times.request_sent_micros),
+                    times.response_received_micros);
+  };
+  const int64 send_start = aligned ? to_local(times.send_start_micros)
+                                   : times.request_sent_micros;
+  RecordDataTransfer(step_id, send_start, times.recv_done_micros, tensor_name,
+                     src_device, dst_device, bytes, "", "RecvTensor");
+  if (!aligned) return;
+  RecordDataTransfer(step_id, to_local(times.request_received_micros),
+                     send_start, tensor_name, src_device, dst_device, bytes, "",
+                     "RecvTensor:wait");
+  RecordDataTransfer(step_id, send_start, times.response_received_micros,
+                     tensor_name, src_device, dst_device, bytes, "",
+                     "RecvTensor:wire");
+  RecordDataTransfer(step_id, times.response_received_micros,
+                     times.recv_done_micros, tensor_name, src_device,
+                     dst_device, bytes, "", "RecvTensor:decode");
+}
+
+void WorkerCacheLogger::EstimateClockOffset(int64 request_sent_micros,
+                                            int64 request_received_micros,
+                                            int64 response_sent_micros,
+                                            int64 response_received_micros,
+                                            int64* offset_micros,
+                                            int64* delay_micros) {
+  *offset_micros = ((request_received_micros - request_sent_micros) +
+                    (response_sent_micros - response_received_micros)) /
+                   2;
+  *delay_micros = std::max<int64>(
+      0, (response_received_micros - request_sent_micros) -
+             (response_sent_micros - request_received_micros));
+}
+
+void WorkerCacheLogger::AddClockSample(const string& task,
+                                       int64 request_sent_micros,
+                                       int64 request_received_micros,
+                                       int64 response_sent_micros,
+                                       int64 response_received_micros) {
+  ClockSample sample;
+  EstimateClockOffset(request_sent_micros, request_received_micros,
+                      response_sent_micros, response_received_micros,
+                      &sample.offset_micros, &sample.delay_micros);
+  sample.taken_micros = response_received_micros;
+  mutex_lock l(clock_mu_);
+  auto it = clock_samples_.find(task);
+  if (it == clock_samples_.end()) {
+    clock_samples_.emplace(task, sample);
+  } else if (sample.delay_micros <= it->second.delay_micros ||
+             sample.taken_micros - it->second.taken_micros >
+                 kClockSampleLifetimeMicros) {
+    it->second = sample;
+  }
+}
+
+bool WorkerCacheLogger::ClockOffset(const string& task, int64* offset_micros) {
+  mutex_lock l(clock_mu_);
+  auto it = clock_samples_.find(task);
+  if (it == clock_samples_.end()) return false;
+  *offset_micros = it->second.offset_micros;
+  return true;
+}
+
 void WorkerCacheLogger::RecordDataTransfer(int64 step_id, int64 start_usecs,
                                            int64 end_usecs,
                                            const string& tensor_name,
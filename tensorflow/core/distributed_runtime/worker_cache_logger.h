@@ -60,6 +60,50 @@ class WorkerCacheLogger {
                         const string& tensor_name, const string& src_device,
                         const string& dst_device, int64 bytes);
 
+  // The timestamps of one RecvTensor RPC. The client takes
+  // request_sent_micros, response_received_micros and recv_done_micros on
+  // the local clock. The worker that sends the tensor takes
+  // request_received_micros and send_start_micros on its own clock, or
+  // leaves them 0 if it does not report them.
+  struct RecvTensorTimes {
+    int64 request_sent_micros = 0;
+    int64 request_received_micros = 0;
+    int64 send_start_micros = 0;
+    int64 response_received_micros = 0;
+    int64 recv_done_micros = 0;
+  };
+
+  // Like above, but also records the phases of the RPC, converted to the
+  // local clock: "RecvTensor:wait" while the sender waits for the tensor to
+  // be produced, "RecvTensor:wire" while the response is transferred, and
+  // "RecvTensor:decode" while the client parses it. Updates the estimate of
+  // the clock offset of the sending task with the timestamps.
+  void RecordRecvTensor(int64 step_id, const RecvTensorTimes& times,
+                        const string& tensor_name, const string& src_device,
+                        const string& dst_device, int64 bytes);
+
+  // Updates the estimate of the offset between the clock of `task` and the
+  // local clock with the four timestamps of one round trip to it. Of the
+  // recent round trips, the one with the shortest network delay gives the
+  // most accurate estimate, so that is the one that is kept.
+  void AddClockSample(const string& task, int64 request_sent_micros,
+                      int64 request_received_micros, int64 response_sent_micros,
+                      int64 response_received_micros);
+
+  // Sets *offset_micros to the estimated time by which the clock of `task`
+  // is ahead of the local clock. Returns false if there is no estimate.
+  bool ClockOffset(const string& task, int64* offset_micros);
+
+  // Estimates the clock offset of a remote host from the timestamps of one
+  // round trip to it, assuming that the request and the response took the
+  // same time on the network. The error of the estimate is at most
+  // *delay_micros / 2, the one-way network delay.
+  static void EstimateClockOffset(int64 request_sent_micros,
+                                  int64 request_received_micros,
+                                  int64 response_sent_micros,
+                                  int64 response_received_micros,
+                                  int64* offset_micros, int64* delay_micros);
+
   // Generates a NodeExecStats record with the given data, and saves for
   // later retrieval by RetrieveLogs().
   void RecordDataTransfer(int64 step_id, int64 start_usecs, int64 end_usecs,
@@ -80,6 +124,14 @@ class WorkerCacheLogger {
   mutex mu_;
   LogMap log_map_ GUARDED_BY(mu_);
 
+  struct ClockSample {
+    int64 offset_micros;
+    int64 delay_micros;
+    int64 taken_micros;
+  };
+  mutex clock_mu_;
+  std::unordered_map<string, ClockSample> clock_samples_ GUARDED_BY(clock_mu_);
+
   // Records "ns" in log_map_ under the given device and step.
   void Save(const string& device, int64 step_id, NodeExecStats* ns);
 
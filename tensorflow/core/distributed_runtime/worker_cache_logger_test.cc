@@ -0,0 +1,104 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/worker_cache_logger.h"
+
+#include <map>
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+const char kSrcTask[] = "/job:worker/replica:0/task:1";
+const char kSrcDevice[] = "/job:worker/replica:0/task:1/device:CPU:0";
+const char kDstDevice[] = "/job:worker/replica:0/task:0/device:CPU:0";
+
+TEST(WorkerCacheLoggerTest, EstimateClockOffset) {
+  int64 offset;
+  int64 delay;
+  // The remote clock is 1000us ahead, and each direction takes 10us.
+  WorkerCacheLogger::EstimateClockOffset(100, 1110, 1150, 160, &offset,
+                                         &delay);
+  EXPECT_EQ(1000, offset);
+  EXPECT_EQ(20, delay);
+}
+
+TEST(WorkerCacheLoggerTest, KeepsShortestRoundTrip) {
+  WorkerCacheLogger logger;
+  int64 offset;
+  EXPECT_FALSE(logger.ClockOffset(kSrcTask, &offset));
+  // The request took 10us and the response 50us, so the estimate is off.
+  logger.AddClockSample(kSrcTask, 100, 610, 620, 170);
+  ASSERT_TRUE(logger.ClockOffset(kSrcTask, &offset));
+  EXPECT_EQ(480, offset);
+  // A shorter round trip gives a better estimate.
+  logger.AddClockSample(kSrcTask, 200, 710, 720, 240);
+  ASSERT_TRUE(logger.ClockOffset(kSrcTask, &offset));
+  EXPECT_EQ(495, offset);
+  // A longer one does not replace it.
+  logger.AddClockSample(kSrcTask, 300, 900, 910, 500);
+  ASSERT_TRUE(logger.ClockOffset(kSrcTask, &offset));
+  EXPECT_EQ(495, offset);
+}
+
+TEST(WorkerCacheLoggerTest, RecordsAlignedRecvTensorPhases) {
+  WorkerCacheLogger logger;
+  WorkerCacheLogger::RecvTensorTimes times;
+  // The sending worker's clock is 1000us ahead, and each direction takes
+  // 5us. The worker waits 50us for the tensor, which takes 5us to decode.
+  times.request_sent_micros = 100;
+  times.request_received_micros = 1105;
+  times.send_start_micros = 1155;
+  times.response_received_micros = 160;
+  times.recv_done_micros = 165;
+  logger.RecordRecvTensor(7, times, "t", kSrcDevice, kDstDevice, 16);
+
+  StepStats ss;
+  ASSERT_TRUE(logger.RetrieveLogs(7, &ss));
+  ASSERT_EQ(1, ss.dev_stats_size());
+  EXPECT_EQ(kDstDevice, ss.dev_stats(0).device());
+  std::map<string, std::pair<int64, int64>> phases;
+  for (const NodeExecStats& ns : ss.dev_stats(0).node_stats()) {
+    phases[ns.node_name()] = {ns.all_start_micros(), ns.all_end_rel_micros()};
+  }
+  ASSERT_EQ(4, phases.size());
+  EXPECT_EQ(std::make_pair(int64{155}, int64{10}), phases["RecvTensor"]);
+  EXPECT_EQ(std::make_pair(int64{105}, int64{50}), phases["RecvTensor:wait"]);
+  EXPECT_EQ(std::make_pair(int64{155}, int64{5}), phases["RecvTensor:wire"]);
+  EXPECT_EQ(std::make_pair(int64{160}, int64{5}), phases["RecvTensor:decode"]);
+}
+
+TEST(WorkerCacheLoggerTest, RecordsRecvTensorWithoutRemoteTimes) {
+  WorkerCacheLogger logger;
+  WorkerCacheLogger::RecvTensorTimes times;
+  times.request_sent_micros = 100;
+  times.response_received_micros = 160;
+  times.recv_done_micros = 165;
+  logger.RecordRecvTensor(7, times, "t", kSrcDevice, kDstDevice, 16);
+
+  StepStats ss;
+  ASSERT_TRUE(logger.RetrieveLogs(7, &ss));
+  ASSERT_EQ(1, ss.dev_stats_size());
+  ASSERT_EQ(1, ss.dev_stats(0).node_stats_size());
+  const NodeExecStats& ns = ss.dev_stats(0).node_stats(0);
+  EXPECT_EQ("RecvTensor", ns.node_name());
+  EXPECT_EQ(100, ns.all_start_micros());
+  EXPECT_EQ(65, ns.all_end_rel_micros());
+}
+
+}  // namespace
+}  // namespace tensorflow
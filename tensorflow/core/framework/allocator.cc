@@ -18,9 +18,11 @@ limitations under the License.
 #include "tensorflow/core/framework/allocator_registry.h"
 #include "tensorflow/core/framework/log_memory.h"
 #include "tensorflow/core/framework/tracking_allocator.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -31,10 +33,12 @@ void AllocatorStats::Clear() {
   this->max_bytes_in_use = 0;
   this->max_alloc_size = 0;
   this->bytes_limit = 0;
+  this->num_thread_cache_hits = 0;
+  this->num_thread_cache_misses = 0;
 }
 
 string AllocatorStats::DebugString() const {
-  return strings::Printf(
+  string result = strings::Printf(
       "Limit:        %20lld\n"
       "InUse:        %20lld\n"
       "MaxInUse:     %20lld\n"
@@ -42,6 +46,14 @@ string AllocatorStats::DebugString() const {
       "MaxAllocSize: %20lld\n",
       this->bytes_limit, this->bytes_in_use, this->max_bytes_in_use,
       this->num_allocs, this->max_alloc_size);
+  if (this->num_thread_cache_hits > 0 || this->num_thread_cache_misses > 0) {
+    strings::Appendf(&result,
+                     "CacheHits:    %20lld\n"
+                     "CacheMisses:  %20lld\n",
+                     this->num_thread_cache_hits,
+                     this->num_thread_cache_misses);
+  }
+  return result;
 }
 
 constexpr size_t Allocator::kAllocatorAlignment;
@@ -70,14 +82,22 @@ void EnableCPUAllocatorFullStats(bool enable) {
 
 class CPUAllocator : public Allocator {
  public:
-  CPUAllocator() {}
+  CPUAllocator() : numa_node_(port::kNUMANoAffinity) {}
+
+  // Allocates memory with a preference for pages on 'numa_node'.
+  explicit CPUAllocator(int numa_node) : numa_node_(numa_node) {}
 
   ~CPUAllocator() override {}
 
-  string Name() override { return "cpu"; }
+  string Name() override {
+    if (numa_node_ == port::kNUMANoAffinity) return "cpu";
+    return strings::StrCat("cpu_numa_", numa_node_);
+  }
 
   void* AllocateRaw(size_t alignment, size_t num_bytes) override {
-    void* p = port::AlignedMalloc(num_bytes, alignment);
+    void* p = numa_node_ == port::kNUMANoAffinity
+                  ? port::AlignedMalloc(num_bytes, alignment)
+                  : port::NUMAMalloc(numa_node_, num_bytes, alignment);
     if (cpu_allocator_collect_stats) {
       const std::size_t alloc_size = port::MallocExtension_GetAllocatedSize(p);
       mutex_lock l(mu_);
@@ -98,7 +118,11 @@ class CPUAllocator : public Allocator {
       mutex_lock l(mu_);
       stats_.bytes_in_use -= alloc_size;
     }
-    port::AlignedFree(ptr);
+    if (numa_node_ == port::kNUMANoAffinity) {
+      port::AlignedFree(ptr);
+    } else {
+      port::NUMAFree(ptr, 0);
+    }
   }
 
   void GetStats(AllocatorStats* stats) override {
@@ -111,6 +135,7 @@ class CPUAllocator : public Allocator {
   }
 
  private:
+  const int numa_node_;
   mutex mu_;
   AllocatorStats stats_ GUARDED_BY(mu_);
 
@@ -125,6 +150,49 @@ Allocator* cpu_allocator() {
   return cpu_alloc;
 }
 
+Allocator* cpu_allocator(int numa_node) {
+  if (numa_node == port::kNUMANoAffinity || !port::NUMAEnabled() ||
+      numa_node < 0 || numa_node >= port::NUMANumNodes()) {
+    return cpu_allocator();
+  }
+  static std::vector<Allocator*>* numa_allocators = [] {
+    auto* allocators = new std::vector<Allocator*>;
+    for (int node = 0; node < port::NUMANumNodes(); ++node) {
+      Allocator* a = new CPUAllocator(node);
+      if (cpu_allocator_collect_full_stats) {
+        a = new TrackingAllocator(a, true);
+      }
+      allocators->push_back(a);
+    }
+    return allocators;
+  }();
+  return (*numa_allocators)[numa_node];
+}
+
 REGISTER_MEM_ALLOCATOR("DefaultCPUAllocator", 100, CPUAllocator);
 
+namespace {
+
+size_t RoundUpToPage(size_t num_bytes, size_t page_size) {
+  return (num_bytes + page_size - 1) / page_size * page_size;
+}
+
+}  // namespace
+
+void* VirtualMemorySubAllocator::Alloc(size_t alignment, size_t num_bytes) {
+  const size_t bytes = RoundUpToPage(num_bytes, page_size());
+  void* ptr = Reserve(bytes);
+  if (ptr != nullptr && !Map(ptr, bytes)) {
+    Unreserve(ptr, bytes);
+    ptr = nullptr;
+  }
+  return ptr;
+}
+
+void VirtualMemorySubAllocator::Free(void* ptr, size_t num_bytes) {
+  const size_t bytes = RoundUpToPage(num_bytes, page_size());
+  Unmap(ptr, bytes);
+  Unreserve(ptr, bytes);
+}
+
 }  // namespace tensorflow
@@ -29,6 +29,8 @@ limitations under the License.
 
 namespace tensorflow {
 
+class AllocatorTimeline;
+
 // Attributes for a single allocation call. Different calls to the same
 // allocator could potentially have different allocation attributes.
 struct AllocationAttributes {
@@ -57,6 +59,11 @@ struct AllocatorStats {
   // unknown.
   int64 bytes_limit;
 
+  // Allocations served by, and that missed, per-thread caches of freed
+  // memory, for allocators that have them.
+  int64 num_thread_cache_hits;
+  int64 num_thread_cache_misses;
+
   AllocatorStats() { Clear(); }
 
   void Clear();
@@ -198,6 +205,10 @@ class Allocator {
   // Fills in 'stats' with statistics collected by this allocator.
   virtual void GetStats(AllocatorStats* stats) { stats->Clear(); }
 
+  // Moves the allocation events recorded since the previous call to
+  // 'timeline', and returns true, if this allocator records them.
+  virtual bool ExportTimeline(AllocatorTimeline* timeline) { return false; }
+
  private:
   // No constructors or destructors are run for simple types
   template <typename T>
@@ -354,7 +365,15 @@ struct AllocatorAttributes {
   bool nic_compatible() const { return value & (0x1 << 1); }
   void set_gpu_compatible(bool v) { value |= (static_cast<int>(v) << 2); }
   bool gpu_compatible() const { return value & (0x1 << 2); }
-  void Merge(AllocatorAttributes other) { value |= other.value; }
+  // The buffer is only used by the kernel that allocates it, and dies
+  // before the step ends, e.g. a scratch buffer from allocate_temp() that
+  // never becomes an output. Such buffers may come from a per-step arena.
+  void set_scratch(bool v) { value |= (static_cast<int>(v) << 3); }
+  bool scratch() const { return value & (0x1 << 3); }
+  void Merge(AllocatorAttributes other) {
+    value |= other.value;
+    if (scope_id == 0) scope_id = other.scope_id;
+  }
   // Returns true if the fields set in *this is a subset of or equal to
   // those set in other.
   bool IsEqualOrLessRestrictiveThan(const AllocatorAttributes& other) const {
@@ -366,12 +385,20 @@ struct AllocatorAttributes {
   // upper 8 bits in device-specific ways, and ops implemented for those
   // devices are responsible for setting those 8 bits appropriately.
   uint32 value = 0;
+  // If not 0, the allocation should come from the field of a
+  // ScopedAllocator with this scope id, if the step has one.
+  int32 scope_id = 0;
 };
 
 // Returns a trivial implementation of Allocator which uses the system
 // default malloc. The returned allocator is a process singleton.
 Allocator* cpu_allocator();
 
+// Returns a process singleton Allocator that prefers pages on 'numa_node'.
+// Returns cpu_allocator() if 'numa_node' is kNUMANoAffinity or NUMA is not
+// supported on this machine.
+Allocator* cpu_allocator(int numa_node);
+
 // If 'enable' is true, the process-wide cpu allocator collects
 // AllocatorStats. By default, it's disabled.
 void EnableCPUAllocatorStats(bool enable);
@@ -389,6 +416,32 @@ class SubAllocator {
   virtual void Free(void* ptr, size_t num_bytes) = 0;
 };
 
+// A SubAllocator that can reserve address space and back parts of it with
+// memory separately, e.g. through the virtual memory management APIs of a
+// device driver.  A higher-level allocator can then grow a single
+// contiguous region instead of adding disjoint ones.
+class VirtualMemorySubAllocator : public SubAllocator {
+ public:
+  // The granularity of Reserve(), Map() and Unmap().
+  virtual size_t page_size() const = 0;
+
+  // Reserves 'num_bytes' of address space without backing it with memory.
+  // Returns nullptr on failure.
+  virtual void* Reserve(size_t num_bytes) = 0;
+  virtual void Unreserve(void* ptr, size_t num_bytes) = 0;
+
+  // Backs the reserved range [ptr, ptr + num_bytes) with memory.  Returns
+  // false on failure.
+  virtual bool Map(void* ptr, size_t num_bytes) = 0;
+  // Returns the memory backing [ptr, ptr + num_bytes), which must have been
+  // mapped, to the system.
+  virtual void Unmap(void* ptr, size_t num_bytes) = 0;
+
+  // Reserves and maps whole pages at once.
+  void* Alloc(size_t alignment, size_t num_bytes) override;
+  void Free(void* ptr, size_t num_bytes) override;
+};
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_FRAMEWORK_ALLOCATOR_H_
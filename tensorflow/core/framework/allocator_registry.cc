@@ -77,4 +77,26 @@ Allocator* AllocatorRegistry::GetAllocator() {
   return CHECK_NOTNULL(m_curr_allocator_);
 }
 
+void AllocatorRegistry::RegisterFactory(const string& name,
+                                        AllocatorFactory* factory) {
+  CHECK(!name.empty()) << "Need a valid name for AllocatorFactory";
+  mutex_lock l(factories_mu_);
+  CHECK(factories_.emplace(name, factory).second)
+      << "AllocatorFactory with name: [" << name << "] already registered";
+}
+
+Allocator* AllocatorRegistry::GetAllocator(const string& name,
+                                           int numa_node) {
+  mutex_lock l(factories_mu_);
+  auto it = factory_allocators_.find(std::make_pair(name, numa_node));
+  if (it != factory_allocators_.end()) return it->second;
+  auto factory = factories_.find(name);
+  if (factory == factories_.end()) return nullptr;
+  Allocator* allocator = factory->second->CreateAllocator(numa_node);
+  if (allocator != nullptr) {
+    factory_allocators_.emplace(std::make_pair(name, numa_node), allocator);
+  }
+  return allocator;
+}
+
 }  // namespace tensorflow
@@ -17,13 +17,29 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_ALLOCATOR_REGISTRY_H_
 #define TENSORFLOW_CORE_FRAMEWORK_ALLOCATOR_REGISTRY_H_
 
+#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 
+// Creates allocators on demand, so that devices can select one by name and
+// have it bound to their NUMA node.
+class AllocatorFactory {
+ public:
+  virtual ~AllocatorFactory() {}
+
+  // Returns a new allocator that prefers memory on 'numa_node', or on no
+  // particular node if it is port::kNUMANoAffinity.  Returns nullptr if
+  // such an allocator cannot be created on this machine.
+  virtual Allocator* CreateAllocator(int numa_node) = 0;
+};
+
 // A global AllocatorRegistry is used to hold allocators for CPU backends
 class AllocatorRegistry {
  public:
@@ -35,6 +51,15 @@ class AllocatorRegistry {
   // If multiple allocators have the same high priority, return one of them
   Allocator* GetAllocator();
 
+  // Add a factory of allocators that can be selected by 'name'.  Caller
+  // releases ownership of 'factory'.
+  void RegisterFactory(const string& name, AllocatorFactory* factory);
+
+  // Returns the allocator for 'numa_node' of the factory registered as
+  // 'name', which is created on first use and shared by later callers.
+  // Returns nullptr if there is no such factory or it failed.
+  Allocator* GetAllocator(const string& name, int numa_node);
+
   // Returns the global registry of allocators.
   static AllocatorRegistry* Global();
 
@@ -51,6 +76,12 @@ class AllocatorRegistry {
 
   std::vector<AllocatorRegistryEntry> allocators_;
   Allocator* m_curr_allocator_;  // not owned
+
+  mutex factories_mu_;
+  std::map<string, AllocatorFactory*> factories_
+      GUARDED_BY(factories_mu_);  // not owned
+  std::map<std::pair<string, int>, Allocator*> factory_allocators_
+      GUARDED_BY(factories_mu_);  // not owned
 };
 
 namespace allocator_registration {
@@ -63,6 +94,13 @@ class AllocatorRegistration {
   }
 };
 
+class AllocatorFactoryRegistration {
+ public:
+  AllocatorFactoryRegistration(const string& name, AllocatorFactory* factory) {
+    AllocatorRegistry::Global()->RegisterFactory(name, factory);
+  }
+};
+
 }  // namespace allocator_registration
 
 #define REGISTER_MEM_ALLOCATOR(name, priority, allocator) \
@@ -75,6 +113,16 @@ class AllocatorRegistration {
   static allocator_registration::AllocatorRegistration              \
       register_allocator_##ctr(name, priority, new allocator)
 
+#define REGISTER_MEM_ALLOCATOR_FACTORY(name, factory) \
+  REGISTER_MEM_ALLOCATOR_FACTORY_UNIQ_HELPER(__COUNTER__, name, factory)
+
+#define REGISTER_MEM_ALLOCATOR_FACTORY_UNIQ_HELPER(ctr, name, factory) \
+  REGISTER_MEM_ALLOCATOR_FACTORY_UNIQ(ctr, name, factory)
+
+#define REGISTER_MEM_ALLOCATOR_FACTORY_UNIQ(ctr, name, factory)   \
+  static allocator_registration::AllocatorFactoryRegistration \
+      register_allocator_factory_##ctr(name, new factory)
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_FRAMEWORK_ALLOCATOR_REGISTRY_H_
@@ -15,6 +15,24 @@ limitations under the License.
 
 #include "tensorflow/core/framework/bfloat16.h"
 
+#include <algorithm>
+
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/platform.h"
+
+#if defined(PLATFORM_IS_X86) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// The F16C conversions are compiled with target attributes, so that the rest
+// of the binary does not require the instructions.
+#if defined(PLATFORM_IS_X86) && defined(__GNUC__) && \
+    ((defined(__clang__) && __clang_major__ >= 6) || \
+     (!defined(__clang__) && __GNUC__ >= 8))
+#define TENSORFLOW_USE_F16C_CONVERSIONS (1)
+#include <immintrin.h>
+#endif
+
 namespace tensorflow {
 
 void FloatToBFloat16(const float* src, bfloat16* dst, int64 size) {
@@ -25,6 +43,17 @@ void FloatToBFloat16(const float* src, bfloat16* dst, int64 size) {
       *q = p[0];  
     }  
 #else
+#if defined(PLATFORM_IS_X86) && defined(__SSE2__)
+  // The arithmetic shifts keep the upper halves within the range of int16,
+  // so that the saturating pack does not change them.
+  for (; size >= 8; p += 16, q += 8, size -= 8) {
+    const __m128i lo = _mm_srai_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), 16);
+    const __m128i hi = _mm_srai_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 8)), 16);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(q), _mm_packs_epi32(lo, hi));
+  }
+#endif
     for (; size != 0; p += 2, q++, size--) {  
      *q = p[1];  
     }  
@@ -40,6 +69,16 @@ void BFloat16ToFloat(const bfloat16* src, float* dst, int64 size) {
       q[1] = 0;  
     }
 #else  
+#if defined(PLATFORM_IS_X86) && defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  for (; size >= 8; p += 8, q += 16, size -= 8) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(q),
+                     _mm_unpacklo_epi16(zero, x));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(q + 8),
+                     _mm_unpackhi_epi16(zero, x));
+  }
+#endif
     for (; size != 0; p++, q += 2, size--) {  
       q[0] = 0;  
       q[1] = *p;  
@@ -47,4 +86,86 @@ void BFloat16ToFloat(const bfloat16* src, float* dst, int64 size) {
 #endif
 }
 
+namespace {
+
+#ifdef TENSORFLOW_USE_F16C_CONVERSIONS
+
+bool HasF16C() {
+  static const bool has_f16c = port::TestCPUFeature(port::F16C) &&
+                               port::TestCPUFeature(port::AVX);
+  return has_f16c;
+}
+
+// Converts the elements in groups of 8, up to the first group with a NaN,
+// which is left to the caller since F16C keeps the payloads of NaNs, unlike
+// Eigen::half. Returns the number of elements converted.
+__attribute__((target("avx,f16c"))) int64 FloatToHalfF16C(const float* src,
+                                                          uint16* dst,
+                                                          int64 size) {
+  int64 i = 0;
+  for (; i + 8 <= size; i += 8) {
+    const __m256 x = _mm256_loadu_ps(src + i);
+    if (_mm256_movemask_ps(_mm256_cmp_ps(x, x, _CMP_UNORD_Q)) != 0) break;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm256_cvtps_ph(x, _MM_FROUND_TO_NEAREST_INT));
+  }
+  return i;
+}
+
+// Same as FloatToHalfF16C() for the groups with a signaling NaN, which F16C
+// makes quiet.
+__attribute__((target("avx,f16c"))) int64 HalfToFloatF16C(const uint16* src,
+                                                          float* dst,
+                                                          int64 size) {
+  const __m128i abs_mask = _mm_set1_epi16(0x7fff);
+  const __m128i infinity = _mm_set1_epi16(0x7c00);
+  const __m128i quiet_nan = _mm_set1_epi16(0x7e00);
+  int64 i = 0;
+  for (; i + 8 <= size; i += 8) {
+    const __m128i x =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    const __m128i abs = _mm_and_si128(x, abs_mask);
+    const __m128i signaling = _mm_and_si128(_mm_cmpgt_epi16(abs, infinity),
+                                            _mm_cmplt_epi16(abs, quiet_nan));
+    if (_mm_movemask_epi8(signaling) != 0) break;
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(x));
+  }
+  return i;
+}
+
+#endif  // TENSORFLOW_USE_F16C_CONVERSIONS
+
+}  // namespace
+
+void FloatToHalf(const float* src, Eigen::half* dst, int64 size) {
+  int64 i = 0;
+#ifdef TENSORFLOW_USE_F16C_CONVERSIONS
+  if (HasF16C()) {
+    while (i + 8 <= size) {
+      i += FloatToHalfF16C(src + i, &dst[i].x, size - i);
+      // The group at "i", if any, has a NaN.
+      for (const int64 end = std::min(i + 8, size); i < end; ++i) {
+        dst[i] = Eigen::half(src[i]);
+      }
+    }
+  }
+#endif
+  for (; i < size; ++i) dst[i] = Eigen::half(src[i]);
+}
+
+void HalfToFloat(const Eigen::half* src, float* dst, int64 size) {
+  int64 i = 0;
+#ifdef TENSORFLOW_USE_F16C_CONVERSIONS
+  if (HasF16C()) {
+    while (i + 8 <= size) {
+      i += HalfToFloatF16C(&src[i].x, dst + i, size - i);
+      for (const int64 end = std::min(i + 8, size); i < end; ++i) {
+        dst[i] = static_cast<float>(src[i]);
+      }
+    }
+  }
+#endif
+  for (; i < size; ++i) dst[i] = static_cast<float>(src[i]);
+}
+
 }  // end namespace tensorflow
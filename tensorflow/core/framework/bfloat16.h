@@ -57,6 +57,12 @@ namespace tensorflow {
 void FloatToBFloat16(const float* src, bfloat16* dst, int64 size);
 void BFloat16ToFloat(const bfloat16* src, float* dst, int64 size);
 
+// Conversion routines between an array of float and Eigen::half of "size".
+// They give the same results as the conversions of Eigen::half, i.e. they
+// round to the nearest even value, but use F16C when the CPU has it.
+void FloatToHalf(const float* src, Eigen::half* dst, int64 size);
+void HalfToFloat(const Eigen::half* src, float* dst, int64 size);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_FRAMEWORK_BFLOAT16_H_
@@ -15,6 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/framework/bfloat16.h"
 
+#include <string.h>
+#include <cmath>
+#include <vector>
+
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -43,6 +47,51 @@ TEST(Bfloat16Test, Conversion) {
   }
 }
 
+TEST(Bfloat16Test, ConversionKeepsUpperBits) {
+  // An odd size, so that some elements are converted one by one.
+  const int kSize = 1003;
+  std::vector<uint32> bits(kSize);
+  for (int i = 0; i < kSize; ++i) bits[i] = 0x9E3779B9u * (i + 1);
+  std::vector<float> a(kSize);
+  memcpy(a.data(), bits.data(), kSize * sizeof(float));
+  std::vector<bfloat16> b(kSize);
+  FloatToBFloat16(a.data(), b.data(), kSize);
+  std::vector<float> c(kSize);
+  BFloat16ToFloat(b.data(), c.data(), kSize);
+  for (int i = 0; i < kSize; ++i) {
+    EXPECT_EQ(bits[i] >> 16, b[i].value);
+    uint32 c_bits;
+    memcpy(&c_bits, &c[i], sizeof(c_bits));
+    EXPECT_EQ(bits[i] & 0xffff0000u, c_bits);
+  }
+}
+
+TEST(HalfTest, ConversionMatchesEigen) {
+  // All the halves, including the NaNs and the infinities, and then some.
+  const int kSize = (1 << 16) + 5;
+  std::vector<Eigen::half> h(kSize);
+  for (int i = 0; i < kSize; ++i) h[i].x = static_cast<uint16>(i);
+  std::vector<float> f(kSize);
+  HalfToFloat(h.data(), f.data(), kSize);
+  for (int i = 0; i < kSize; ++i) {
+    const float expected = static_cast<float>(h[i]);
+    ASSERT_EQ(0, memcmp(&expected, &f[i], sizeof(float))) << i;
+  }
+
+  // The floats that halves round to, and their neighbours.
+  std::vector<float> a;
+  for (const float x : f) {
+    a.push_back(x);
+    a.push_back(std::nextafter(x, 0.0f));
+    a.push_back(std::nextafter(x, 1e30f));
+  }
+  std::vector<Eigen::half> b(a.size());
+  FloatToHalf(a.data(), b.data(), a.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    ASSERT_EQ(Eigen::half(a[i]).x, b[i].x) << a[i];
+  }
+}
+
 static void BM_FloatToBFloat16(int iters) {
   testing::StopTiming();
   static const int N = 32 << 20;
@@ -0,0 +1,80 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/memory_pressure.h"
+
+#include <vector>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+constexpr int MemoryPressureRegistry::kIdleMemoryPriority;
+constexpr int MemoryPressureRegistry::kRecomputablePriority;
+
+/* static */
+MemoryPressureRegistry* MemoryPressureRegistry::Global() {
+  static MemoryPressureRegistry* const registry = new MemoryPressureRegistry;
+  return registry;
+}
+
+MemoryPressureRegistry::MemoryPressureRegistry() {}
+
+int64 MemoryPressureRegistry::Register(int priority, Listener listener) {
+  mutex_lock l(mu_);
+  const int64 handle = next_handle_++;
+  listeners_.emplace(std::make_pair(priority, handle), std::move(listener));
+  return handle;
+}
+
+void MemoryPressureRegistry::Unregister(int64 handle) {
+  mutex_lock notify_lock(notify_mu_);
+  mutex_lock l(mu_);
+  for (auto it = listeners_.begin(); it != listeners_.end(); ++it) {
+    if (it->first.second == handle) {
+      listeners_.erase(it);
+      return;
+    }
+  }
+  LOG(WARNING) << "Unregistering unknown memory pressure listener " << handle;
+}
+
+int64 MemoryPressureRegistry::Notify(const string& allocator_name,
+                                     size_t num_bytes) {
+  // Listeners free memory, which could make an allocator retry and notify
+  // again from within a listener.
+  static thread_local bool notifying = false;
+  if (notifying) return 0;
+  notifying = true;
+  int64 released = 0;
+  {
+    mutex_lock notify_lock(notify_mu_);
+    std::vector<Listener> listeners;
+    {
+      mutex_lock l(mu_);
+      for (const auto& it : listeners_) listeners.push_back(it.second);
+    }
+    for (const Listener& listener : listeners) {
+      released += listener(allocator_name, num_bytes);
+      if (released >= static_cast<int64>(num_bytes)) break;
+    }
+  }
+  notifying = false;
+  VLOG(1) << "Memory pressure on " << allocator_name << " for " << num_bytes
+          << " bytes released " << released << " bytes";
+  return released;
+}
+
+}  // namespace tensorflow
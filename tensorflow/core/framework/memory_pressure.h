@@ -0,0 +1,83 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_FRAMEWORK_MEMORY_PRESSURE_H_
+#define TENSORFLOW_CORE_FRAMEWORK_MEMORY_PRESSURE_H_
+
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A registry of listeners that can give memory back when an allocator runs
+// out of it, e.g. by dropping caches that can be rebuilt.  Allocators call
+// Notify() before they wait for memory to be freed, or fail.
+//
+// Listeners are called in increasing order of priority, so that memory
+// that is cheap to give back goes first.
+class MemoryPressureRegistry {
+ public:
+  // Suggested priorities.
+  // Memory that is cached but unused, e.g. free buffers of a pool.
+  static constexpr int kIdleMemoryPriority = 0;
+  // Results that can be recomputed, e.g. caches of compiled programs.
+  static constexpr int kRecomputablePriority = 100;
+
+  // Called with the Name() of the allocator that could not allocate
+  // 'num_bytes' bytes.  Returns the number of bytes it released, which
+  // should be 0 if the listener's memory is not the allocator's, e.g. for
+  // host caches and a GPU allocator.  Must not allocate from that
+  // allocator.
+  typedef std::function<int64(const string& allocator_name, size_t num_bytes)>
+      Listener;
+
+  // Returns the process-wide registry.
+  static MemoryPressureRegistry* Global();
+
+  MemoryPressureRegistry();
+
+  // Adds 'listener' with 'priority', and returns a handle for Unregister().
+  int64 Register(int priority, Listener listener);
+
+  // Removes the listener 'handle'.  When this returns, the listener is not
+  // running and will not be called again.  Must not be called by listeners.
+  void Unregister(int64 handle);
+
+  // Calls the listeners in order of priority until they released at least
+  // 'num_bytes' bytes in total, and returns the number of bytes released.
+  // Calls from the listeners themselves return 0.
+  int64 Notify(const string& allocator_name, size_t num_bytes);
+
+ private:
+  // Held while listeners run, so that Unregister() waits for them.
+  mutex notify_mu_;
+  mutex mu_ ACQUIRED_AFTER(notify_mu_);
+  // By (priority, handle).
+  std::map<std::pair<int, int64>, Listener> listeners_ GUARDED_BY(mu_);
+  int64 next_handle_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryPressureRegistry);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_FRAMEWORK_MEMORY_PRESSURE_H_
@@ -0,0 +1,73 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/memory_pressure.h"
+
+#include <vector>
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(MemoryPressureRegistry, CallsListenersInPriorityOrder) {
+  MemoryPressureRegistry registry;
+  std::vector<int> calls;
+  auto listener = [&calls](int id, int64 released) {
+    return [&calls, id, released](const string& allocator_name,
+                                  size_t num_bytes) -> int64 {
+      EXPECT_EQ("cpu", allocator_name);
+      EXPECT_EQ(100, num_bytes);
+      calls.push_back(id);
+      return released;
+    };
+  };
+  registry.Register(MemoryPressureRegistry::kRecomputablePriority,
+                    listener(2, 60));
+  registry.Register(MemoryPressureRegistry::kIdleMemoryPriority,
+                    listener(1, 50));
+  registry.Register(MemoryPressureRegistry::kRecomputablePriority + 1,
+                    listener(3, 10));
+
+  // Stops once enough bytes are released.
+  EXPECT_EQ(110, registry.Notify("cpu", 100));
+  EXPECT_EQ(std::vector<int>({1, 2}), calls);
+}
+
+TEST(MemoryPressureRegistry, Unregister) {
+  MemoryPressureRegistry registry;
+  int calls = 0;
+  const int64 handle = registry.Register(
+      0, [&calls](const string&, size_t) -> int64 { return ++calls; });
+  EXPECT_EQ(1, registry.Notify("cpu", 100));
+  registry.Unregister(handle);
+  EXPECT_EQ(0, registry.Notify("cpu", 100));
+  EXPECT_EQ(1, calls);
+}
+
+TEST(MemoryPressureRegistry, NotifyFromListener) {
+  MemoryPressureRegistry registry;
+  int64 nested = -1;
+  registry.Register(0, [&registry, &nested](const string& allocator_name,
+                                            size_t num_bytes) -> int64 {
+    nested = registry.Notify(allocator_name, num_bytes);
+    return 7;
+  });
+  EXPECT_EQ(7, registry.Notify("cpu", 100));
+  EXPECT_EQ(0, nested);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op_def_util.h"
+#include "tensorflow/core/framework/scoped_allocator.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -476,6 +477,11 @@ std::unique_ptr<Tensor> OpKernelContext::forward_input(
   if (!output_attr.IsEqualOrLessRestrictiveThan(input_attr)) {
     return nullptr;
   }
+  // Check that the output is not meant to be in the field of a
+  // ScopedAllocator.
+  if (output_attr.scope_id != 0) {
+    return nullptr;
+  }
   // TODO(rmlarsen): Use MakeUnique here. There is already a copy in
   // tensorflow/compiler/xla/ptr_util.h. Perhaps this should be part of
   // general cleanup of ownership in this code.
@@ -614,9 +620,8 @@ Status OpKernelContext::allocate_output(StringPiece name,
 }
 
 Status OpKernelContext::allocate_tensor(
-    DataType type, const TensorShape& shape, Tensor* out_tensor,
-    AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
-  Allocator* a = get_allocator(attr);
+    Allocator* a, DataType type, const TensorShape& shape, Tensor* out_tensor,
+    const AllocationAttributes& allocation_attr) {
   AllocationAttributes logged_attr(allocation_attr);
   logged_attr.allocation_will_be_logged = true;
   Tensor new_tensor(a, type, shape, logged_attr);
@@ -643,7 +648,20 @@ Status OpKernelContext::allocate_output(int index, const TensorShape& shape,
   DCHECK(!IsRefType(type));
   DCHECK(mutable_output(index) == nullptr);
   Tensor* output_tensor = new Tensor();
-  Status s = allocate_tensor(type, shape, output_tensor, attr);
+  Allocator* planned_allocator = nullptr;
+  if (attr.scope_id > 0) {
+    planned_allocator = ScopedAllocator::FieldAllocator(
+        resource_manager(), step_container(), attr.scope_id,
+        get_allocator(attr));
+  } else if (params_->output_allocators != nullptr && attr.value == 0 &&
+             !track_allocations()) {
+    planned_allocator = params_->output_allocators[index];
+  }
+  Status s =
+      planned_allocator == nullptr
+          ? allocate_tensor(type, shape, output_tensor, attr)
+          : allocate_tensor(planned_allocator, type, shape, output_tensor,
+                            AllocationAttributes());
   if (s.ok()) {
     outputs_[index] = TensorValue(output_tensor);
     *output = outputs_[index].tensor;
@@ -655,6 +673,13 @@ Status OpKernelContext::allocate_temp(
     DataType type, const TensorShape& shape, Tensor* out_temp,
     AllocatorAttributes allocator_attr,
     const AllocationAttributes& allocation_attr) {
+  AllocatorAttributes scratch_attr;
+  scratch_attr.set_scratch(true);
+  if (params_->scratch_allocator != nullptr &&
+      allocator_attr.value == scratch_attr.value && !track_allocations()) {
+    return allocate_tensor(params_->scratch_allocator, type, shape, out_temp,
+                           allocation_attr);
+  }
   Status s =
       allocate_tensor(type, shape, out_temp, allocator_attr, allocation_attr);
   if (track_allocations() && out_temp->TotalBytes() > 0) {
@@ -508,6 +508,17 @@ class OpKernelContext {
     // Array indexed by output number for this node
     const AllocatorAttributes* output_attr_array = nullptr;
 
+    // If not null, array indexed by output number for this node. A
+    // non-null output_allocators[i] is used instead of the device's
+    // allocator by allocate_output(i) with default allocator attributes,
+    // unless allocations are tracked.
+    Allocator* const* output_allocators = nullptr;
+
+    // If not null, used instead of the device's allocator by
+    // allocate_temp() with only AllocatorAttributes::scratch() set, unless
+    // allocations are tracked.
+    Allocator* scratch_allocator = nullptr;
+
     // Shared resources accessible by this op kernel invocation.
     ResourceMgr* resource_manager = nullptr;
 
@@ -771,7 +782,9 @@ class OpKernelContext {
   //
   // 3) allocate_temp. This should be used to allocate any scratch
   // storage that is needed while the kernel is executing, and will
-  // not be retained by the Op.
+  // not be retained by the Op. Scratch storage that is never used as an
+  // output should set AllocatorAttributes::scratch(), so that it can be
+  // allocated from a per-step arena.
   //
   // In some cases a Tensor needs to be used as an output even though
   // it was previously allocated elsewhere. The Tensor may have been
@@ -1080,6 +1093,13 @@ class OpKernelContext {
 
   Status allocate_tensor(DataType type, const TensorShape& shape,
                          Tensor* out_tensor, AllocatorAttributes allocator_attr,
+                         const AllocationAttributes& allocation_attr) {
+    return allocate_tensor(get_allocator(allocator_attr), type, shape,
+                           out_tensor, allocation_attr);
+  }
+
+  Status allocate_tensor(Allocator* a, DataType type, const TensorShape& shape,
+                         Tensor* out_tensor,
                          const AllocationAttributes& allocation_attr);
 
   // This is called by PersistentTensor::AccessTensor whenever the
@@ -20,10 +20,12 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
@@ -63,6 +65,17 @@ TEST(RendezvousTest, Key) {
       Rendezvous::ParseKey(strings::StrCat(key, ";", key), &parsed).ok());
 }
 
+TEST(RendezvousTest, KeyHash) {
+  const string key = Rendezvous::CreateKey(
+      "/job:mnist/replica:1/task:2/CPU:0", 7890,
+      "/job:mnist/replica:1/task:2/device:GPU:0", "var0", FrameAndIter(0, 0));
+  Rendezvous::ParsedKey parsed;
+  TF_EXPECT_OK(Rendezvous::ParseKey(key, &parsed));
+  EXPECT_EQ(Hash64(key), parsed.Hash());
+  Rendezvous::ParsedKey copy(parsed);
+  EXPECT_EQ(parsed.Hash(), copy.Hash());
+}
+
 class LocalRendezvousTest : public ::testing::Test {
  public:
   LocalRendezvousTest() : threads_(Env::Default(), "test", 16) {
@@ -284,6 +297,29 @@ class DummyDeviceContext : public DeviceContext {
   const int stream_id_;
 };
 
+TEST_F(LocalRendezvousTest, AbortManyKeys) {
+  // Pending receives in every shard are aborted.
+  const int kNumKeys = 100;
+  BlockingCounter counter(kNumKeys);
+  std::vector<Rendezvous::ParsedKey> keys;
+  for (int i = 0; i < kNumKeys; ++i) {
+    keys.push_back(MakeKey(strings::StrCat("key", i)));
+  }
+  for (const auto& key : keys) {
+    rendez_->RecvAsync(key, Rendezvous::Args(),
+                       [&counter](const Status& s, const Rendezvous::Args&,
+                                  const Rendezvous::Args&, const Tensor&,
+                                  const bool) {
+                         EXPECT_TRUE(errors::IsAborted(s));
+                         counter.DecrementCount();
+                       });
+  }
+  rendez_->StartAbort(errors::Aborted(""));
+  counter.Wait();
+  EXPECT_TRUE(errors::IsAborted(
+      rendez_->Send(keys[0], Rendezvous::Args(), V("hello"), false)));
+}
+
 TEST_F(LocalRendezvousTest, TransferDummyDeviceContext) {
   Rendezvous::Args args;
   args.device_context = new DummyDeviceContext(123);
@@ -360,5 +396,45 @@ void BM_PingPong(int iters) {
 }
 BENCHMARK(BM_PingPong);
 
+// Each of "num_threads" threads sends and receives its own keys, so the
+// threads only contend on the rendezvous' locks.
+void BM_SendRecvContended(int iters, int num_threads) {
+  testing::StopTiming();
+  Rendezvous* rendez = NewLocalRendezvous();
+  std::vector<std::vector<Rendezvous::ParsedKey>> keys(num_threads);
+  for (int t = 0; t < num_threads; ++t) {
+    for (int i = 0; i < 16; ++i) {
+      keys[t].push_back(MakeKey(strings::StrCat("thread", t, "_key", i)));
+    }
+  }
+  const int iters_per_thread = std::max(1, iters / num_threads);
+  thread::ThreadPool* pool =
+      new thread::ThreadPool(Env::Default(), "test", num_threads);
+  BlockingCounter counter(num_threads);
+  testing::UseRealTime();
+  testing::StartTiming();
+  for (int t = 0; t < num_threads; ++t) {
+    const std::vector<Rendezvous::ParsedKey>* thread_keys = &keys[t];
+    pool->Schedule([rendez, thread_keys, iters_per_thread, &counter]() {
+      Tensor orig = V("val");
+      Tensor val(DT_STRING, TensorShape({}));
+      bool is_dead = false;
+      Rendezvous::Args args;
+      for (int i = 0; i < iters_per_thread; ++i) {
+        const auto& key = (*thread_keys)[i % thread_keys->size()];
+        TF_CHECK_OK(rendez->Send(key, args, orig, is_dead));
+        TF_CHECK_OK(rendez->Recv(key, args, &val, &is_dead));
+      }
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  testing::StopTiming();
+  testing::ItemsProcessed(static_cast<int64>(iters_per_thread) * num_threads);
+  delete pool;
+  rendez->Unref();
+}
+BENCHMARK(BM_SendRecvContended)->Arg(1)->Arg(4)->Arg(16);
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,156 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/core/framework/scoped_allocator.h"
+
+#include <atomic>
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+const char* const kScopedAllocatorAttrName = "_scoped_allocator";
+
+class ScopedAllocator::Field : public Allocator {
+ public:
+  Field(ScopedAllocator* owner, char* memory, size_t size)
+      : owner_(owner), memory_(memory), size_(size) {}
+
+  string Name() override { return "scoped_allocator"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    // Every allocation keeps the ScopedAllocator, and thus this field,
+    // alive.
+    owner_->Ref();
+    void* ptr;
+    if (CanUseField(alignment, num_bytes) &&
+        !used_.exchange(true, std::memory_order_relaxed)) {
+      ptr = memory_;
+    } else {
+      VLOG(2) << "Allocating " << num_bytes << " bytes of a field of "
+              << size_ << " bytes of " << owner_->DebugString()
+              << " from the base allocator";
+      ptr = owner_->base()->AllocateRaw(alignment, num_bytes);
+    }
+    // The step holds a reference, so this is not the last.
+    if (ptr == nullptr) owner_->Unref();
+    return ptr;
+  }
+
+  void DeallocateRaw(void* ptr) override {
+    // The memory of the field is released with the backing tensor.
+    if (ptr == nullptr || ptr != memory_) {
+      owner_->base()->DeallocateRaw(ptr);
+    }
+    // May delete this allocator.
+    owner_->Unref();
+  }
+
+  bool Contains(const Tensor& t) const {
+    const StringPiece data = t.tensor_data();
+    if (size_ == 0) return data.empty();
+    return data.data() == memory_ && data.size() == size_;
+  }
+
+ private:
+  bool CanUseField(size_t alignment, size_t num_bytes) const {
+    return size_ > 0 && num_bytes == size_ &&
+           reinterpret_cast<uintptr_t>(memory_) % alignment == 0;
+  }
+
+  ScopedAllocator* const owner_;
+  char* const memory_;
+  const size_t size_;
+  std::atomic<bool> used_{false};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(Field);
+};
+
+ScopedAllocator::ScopedAllocator(const Tensor& backing, int32 id,
+                                 const std::vector<TensorShape>& fields)
+    : backing_(backing), id_(id) {
+  char* memory = const_cast<char*>(backing_.tensor_data().data());
+  const size_t limit = backing_.tensor_data().size();
+  const size_t element_size = DataTypeSize(backing_.dtype());
+  size_t offset = 0;
+  fields_.reserve(fields.size());
+  for (const TensorShape& shape : fields) {
+    const size_t size = shape.num_elements() * element_size;
+    // A field past the end of the backing tensor is never used.
+    fields_.emplace_back(
+        new Field(this, offset + size <= limit ? memory + offset : nullptr,
+                  offset + size <= limit ? size : 0));
+    offset += size;
+  }
+}
+
+ScopedAllocator::~ScopedAllocator() {}
+
+Status ScopedAllocator::Register(ResourceMgr* rm,
+                                 ScopedStepContainer* step_container) {
+  core::ScopedUnref unref(this);
+  if (rm == nullptr || step_container == nullptr) {
+    return errors::Internal("No step container for ", DebugString());
+  }
+  for (int i = 0; i < num_fields(); ++i) {
+    Ref();
+    TF_RETURN_IF_ERROR(rm->Create(step_container->name(),
+                                  ResourceName(id_ + 1 + i), this));
+  }
+  return Status::OK();
+}
+
+Allocator* ScopedAllocator::FieldAllocator(ResourceMgr* rm,
+                                           ScopedStepContainer* step_container,
+                                           int32 scope_id, Allocator* base) {
+  ScopedAllocator* scoped_allocator;
+  if (rm == nullptr || step_container == nullptr ||
+      !rm->Lookup(step_container->name(), ResourceName(scope_id),
+                  &scoped_allocator)
+           .ok()) {
+    return nullptr;
+  }
+  // The step keeps its references until it ends.
+  core::ScopedUnref unref(scoped_allocator);
+  {
+    mutex_lock l(scoped_allocator->mu_);
+    if (scoped_allocator->base_ == nullptr) scoped_allocator->base_ = base;
+  }
+  return scoped_allocator->fields_[scope_id - scoped_allocator->id_ - 1].get();
+}
+
+bool ScopedAllocator::IsField(int i, const Tensor& t) const {
+  return fields_[i]->Contains(t);
+}
+
+string ScopedAllocator::DebugString() {
+  return strings::StrCat("ScopedAllocator ", id_, " of ", num_fields(),
+                         " fields in ", backing_.DebugString());
+}
+
+Allocator* ScopedAllocator::base() {
+  mutex_lock l(mu_);
+  return base_;
+}
+
+string ScopedAllocator::ResourceName(int32 scope_id) {
+  return strings::StrCat("_scoped_allocator_", scope_id);
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,99 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#ifndef TENSORFLOW_FRAMEWORK_SCOPED_ALLOCATOR_H_
+#define TENSORFLOW_FRAMEWORK_SCOPED_ALLOCATOR_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// The attr of the nodes whose outputs are allocated by a ScopedAllocator,
+// a list of (output index, scope id) pairs.
+extern const char* const kScopedAllocatorAttrName;
+
+// Allocates the outputs of several nodes as consecutive slices, or fields,
+// of a single backing tensor, so that the node concatenating them only has
+// to forward the backing tensor instead of copying them.
+//
+// A _ScopedAllocator node creates one ScopedAllocator for each step, and
+// registers it in the step container of the resource manager of its
+// device. Field i of the ScopedAllocator with id "id" has the scope id
+// id + 1 + i: an output whose AllocatorAttributes have that scope id is
+// allocated in the memory of field i. An allocation falls back to the base
+// allocator if its size is not that of the field, if the field is
+// misaligned for it, or if the field was already allocated in this step,
+// so the consumers of the fields must check that they were used, e.g. with
+// IsField(). The backing tensor is released once the step and all tensors
+// allocated from the ScopedAllocator are gone.
+class ScopedAllocator : public ResourceBase {
+ public:
+  ScopedAllocator(const Tensor& backing, int32 id,
+                  const std::vector<TensorShape>& fields);
+
+  // Registers this in "step_container" of "rm", under the scope ids of all
+  // of its fields. The caller transfers the ownership of one ref.
+  Status Register(ResourceMgr* rm, ScopedStepContainer* step_container);
+
+  // Returns the allocator of the field with "scope_id" in the current step,
+  // which falls back to "base", or nullptr if the step has no such field.
+  static Allocator* FieldAllocator(ResourceMgr* rm,
+                                   ScopedStepContainer* step_container,
+                                   int32 scope_id, Allocator* base);
+
+  const Tensor& backing() const { return backing_; }
+  int num_fields() const { return fields_.size(); }
+
+  // Returns true iff "t" is in the memory of field i.
+  bool IsField(int i, const Tensor& t) const;
+
+  string DebugString() override;
+
+ private:
+  class Field;
+
+  ~ScopedAllocator() override;
+
+  static string ResourceName(int32 scope_id);
+
+  // The allocator used by the fields for the allocations that do not fit
+  // them.
+  Allocator* base();
+
+  const Tensor backing_;
+  const int32 id_;
+  std::vector<std::unique_ptr<Field>> fields_;
+
+  mutex mu_;
+  Allocator* base_ GUARDED_BY(mu_) = nullptr;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_FRAMEWORK_SCOPED_ALLOCATOR_H_
@@ -0,0 +1,93 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/core/framework/scoped_allocator.h"
+
+#include <memory>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class ScopedAllocatorTest : public ::testing::Test {
+ protected:
+  ScopedAllocatorTest()
+      : step_container_(new ScopedStepContainer(1, [this](const string& name) {
+          rm_.Cleanup(name).IgnoreError();
+        })),
+        // Two fields of 16 floats, each aligned for any allocation.
+        backing_(cpu_allocator(), DT_FLOAT, TensorShape({32})) {
+    ScopedAllocator* scoped_allocator = new ScopedAllocator(
+        backing_, 10, {TensorShape({16}), TensorShape({4, 4})});
+    TF_CHECK_OK(scoped_allocator->Register(&rm_, step_container_.get()));
+  }
+
+  Allocator* Field(int32 scope_id) {
+    return ScopedAllocator::FieldAllocator(&rm_, step_container_.get(),
+                                           scope_id, cpu_allocator());
+  }
+
+  const float* BackingData(int offset) const {
+    return backing_.flat<float>().data() + offset;
+  }
+
+  ResourceMgr rm_;
+  std::unique_ptr<ScopedStepContainer> step_container_;
+  Tensor backing_;
+};
+
+TEST_F(ScopedAllocatorTest, AllocatesFieldsInBackingTensor) {
+  Allocator* first = Field(11);
+  Allocator* second = Field(12);
+  ASSERT_NE(nullptr, first);
+  ASSERT_NE(nullptr, second);
+  EXPECT_EQ(nullptr, Field(10));
+  EXPECT_EQ(nullptr, Field(13));
+
+  Tensor a(first, DT_FLOAT, TensorShape({4, 4}));
+  Tensor b(second, DT_FLOAT, TensorShape({16}));
+  EXPECT_EQ(BackingData(0), a.flat<float>().data());
+  EXPECT_EQ(BackingData(16), b.flat<float>().data());
+  a.flat<float>().setConstant(1);
+  b.flat<float>().setConstant(2);
+
+  // The tensors keep the backing tensor alive after the step.
+  step_container_.reset();
+  backing_ = Tensor();
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>(std::vector<float>(16, 2), {16}), b);
+  EXPECT_EQ(nullptr, Field(11));
+}
+
+TEST_F(ScopedAllocatorTest, FallsBackToBaseAllocator) {
+  // Not the size of the field.
+  Tensor small(Field(11), DT_FLOAT, TensorShape({8}));
+  EXPECT_NE(BackingData(0), small.flat<float>().data());
+  Tensor a(Field(11), DT_FLOAT, TensorShape({16}));
+  EXPECT_EQ(BackingData(0), a.flat<float>().data());
+  // Already allocated in this step.
+  Tensor b(Field(11), DT_FLOAT, TensorShape({16}));
+  EXPECT_NE(BackingData(0), b.flat<float>().data());
+}
+
+}  // namespace
+}  // namespace tensorflow
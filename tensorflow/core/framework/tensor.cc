@@ -115,6 +115,82 @@ class Buffer : public BufferBase {
   TF_DISALLOW_COPY_AND_ASSIGN(Buffer);
 };
 
+// Untyped ref-counted buffer for a small tensor of a simple type, that lives
+// in the same allocation as its data. Creating a small tensor then takes one
+// allocation instead of two. Allocated from a block of
+//   [InlineBuffer | Allocator* | padding | data]
+// where data is Allocator::kAllocatorAlignment aligned.
+class InlineBuffer : public BufferBase {
+ public:
+  // Tensors of at most this many bytes keep their data inline.
+  static constexpr size_t kMaxBytes = 16;
+
+  // Returns a new buffer of 'num_bytes' bytes from 'a', or nullptr if such
+  // a buffer should not or could not be inlined.
+  static InlineBuffer* New(Allocator* a, size_t num_bytes,
+                           const AllocationAttributes& allocation_attr) {
+    // Only the process-wide CPU allocator is known to return host memory.
+    // Allocators which track sizes must see the data pointer itself.
+    if (num_bytes == 0 || num_bytes > kMaxBytes || a != cpu_allocator() ||
+        a->TracksAllocationSizes()) {
+      return nullptr;
+    }
+    void* block = a->AllocateRaw(Allocator::kAllocatorAlignment,
+                                 DataOffset() + num_bytes, allocation_attr);
+    if (block == nullptr) return nullptr;
+    *AllocatorSlot(block) = a;
+    return new (block) InlineBuffer(a, num_bytes);
+  }
+
+  void* data() const override {
+    return const_cast<char*>(reinterpret_cast<const char*>(this)) +
+           DataOffset();
+  }
+  size_t size() const override { return size_; }
+
+  // The block is returned to the allocator stored behind the object, since
+  // alloc_ is gone by the time this runs.
+  static void operator delete(void* block) {
+    (*AllocatorSlot(block))->DeallocateRaw(block);
+  }
+
+ private:
+  static Allocator** AllocatorSlot(void* block) {
+    return reinterpret_cast<Allocator**>(static_cast<char*>(block) +
+                                         sizeof(InlineBuffer));
+  }
+
+  static constexpr size_t DataOffset() {
+    return (sizeof(InlineBuffer) + sizeof(Allocator*) +
+            Allocator::kAllocatorAlignment - 1) /
+           Allocator::kAllocatorAlignment * Allocator::kAllocatorAlignment;
+  }
+
+  InlineBuffer(Allocator* a, size_t num_bytes)
+      : BufferBase(a), size_(num_bytes) {}
+
+  ~InlineBuffer() override {
+    if (LogMemory::IsEnabled()) {
+      RecordDeallocation();
+    }
+  }
+
+  const size_t size_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(InlineBuffer);
+};
+
+// Returns a buffer for T[n] from 'a', inlining the data of small tensors.
+template <typename T>
+TensorBuffer* NewBuffer(Allocator* a, int64 n,
+                        const AllocationAttributes& allocation_attr) {
+  if (is_simple_type<T>::value) {
+    TensorBuffer* buf = InlineBuffer::New(a, sizeof(T) * n, allocation_attr);
+    if (buf != nullptr) return buf;
+  }
+  return new Buffer<T>(a, n, allocation_attr);
+}
+
 void LogUnexpectedSize(int64 actual, int64 expected) {
   LOG(ERROR) << "Input size was " << actual << " and expected " << expected;
 }
@@ -699,7 +775,8 @@ Tensor::Tensor(Allocator* a, DataType type, const TensorShape& shape)
   set_dtype(type);
   CHECK_NOTNULL(a);
   if (shape_.num_elements() > 0 || a->ShouldAllocateEmptyTensors()) {
-    CASES(type, buf_ = new Buffer<T>(a, shape.num_elements()));
+    CASES(type, buf_ = NewBuffer<T>(a, shape.num_elements(),
+                                    AllocationAttributes()));
   }
   if (buf_ != nullptr && buf_->data() != nullptr && LogMemory::IsEnabled()) {
     LogMemory::RecordTensorAllocation("Unknown", LogMemory::UNKNOWN_STEP_ID,
@@ -713,7 +790,7 @@ Tensor::Tensor(Allocator* a, DataType type, const TensorShape& shape,
   set_dtype(type);
   CHECK_NOTNULL(a);
   if (shape_.num_elements() > 0 || a->ShouldAllocateEmptyTensors()) {
-    CASES(type, buf_ = new Buffer<T>(a, shape.num_elements(), allocation_attr));
+    CASES(type, buf_ = NewBuffer<T>(a, shape.num_elements(), allocation_attr));
   }
   if (!allocation_attr.allocation_will_be_logged && buf_ != nullptr &&
       buf_->data() != nullptr && LogMemory::IsEnabled()) {
@@ -484,11 +484,16 @@ class Tensor {
   friend class OpKernelContext;       // For access to RefCountIsOne().
   template <typename Device, typename T>
   friend class AssignVariableOp;  // For access to RefCountIsOne().
+  friend class DeviceStageOp;     // For access to RefCountIsOne().
   template <typename Device, typename T>
   friend Status PrepareToUpdateVariable(
       OpKernelContext* ctx, Tensor* tensor);  // For access to RefCountIsOne().
   friend class NumpyTensorBuffer;  // For access to the private constructor
                                    // taking the buffer.
+  friend class BundleReader;       // For access to the private constructor
+                                   // taking the buffer.
+  friend class TensorResponse;     // For access to the private constructor
+                                   // taking the buffer.
 
   // Creates a tensor with the input datatype, shape and buf.
   //
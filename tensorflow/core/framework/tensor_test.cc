@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/framework/tensor.h"
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/variant_encode_decode.h"
@@ -1021,6 +1023,39 @@ TEST(Tensor, FailureToAllocate) {
   }
 }
 
+TEST(Tensor, SmallTensors) {
+  // Small enough to keep their data inline.
+  Tensor a(DT_INT64, TensorShape({}));
+  a.scalar<int64>()() = 17;
+  EXPECT_TRUE(a.IsAligned());
+  EXPECT_EQ(17, a.scalar<int64>()());
+
+  Tensor b(cpu_allocator(), DT_FLOAT, TensorShape({4}));
+  test::FillValues<float>(&b, {1, 2, 3, 4});
+  EXPECT_TRUE(b.IsAligned());
+  Tensor c = b;
+  EXPECT_TRUE(c.SharesBufferWith(b));
+  test::ExpectTensorEqual<float>(b.Slice(3, 4),
+                                 test::AsTensor<float>({4}, {1}));
+
+  TensorDescription tensor_description;
+  b.FillDescription(&tensor_description);
+  const AllocationDescription& description =
+      tensor_description.allocation_description();
+  EXPECT_EQ(cpu_allocator()->Name(), description.allocator_name());
+  EXPECT_EQ(16, description.requested_bytes());
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(b.tensor_data().data()),
+            description.ptr());
+
+  // Too large, or not a simple type.
+  Tensor d(DT_DOUBLE, TensorShape({3}));
+  test::FillValues<double>(&d, {1, 2, 3});
+  EXPECT_TRUE(d.IsAligned());
+  Tensor e(DT_STRING, TensorShape({}));
+  e.scalar<string>()() = "small";
+  EXPECT_EQ("small", e.scalar<string>()());
+}
+
 // On the alignment.
 //
 // As of 2015/8, tensorflow::Tensor allocates its buffer with 32-byte
@@ -1188,6 +1223,14 @@ static void BM_Assign(int iters) {
 }
 BENCHMARK(BM_Assign);
 
+static void BM_CreateAndDestroyScalar(int iters) {
+  TensorShape shape({});
+  while (--iters) {
+    Tensor t(DT_INT32, shape);
+  }
+}
+BENCHMARK(BM_CreateAndDestroyScalar);
+
 // Ensure tensor_data() works on empty tensors
 TEST(Tensor, EmptyTensorData) {
   Tensor empty;
@@ -988,6 +988,8 @@ Status GraphConstructor::MakeEdge(Node* src, int output_index, Node* dst,
 Status ConvertGraphDefToGraph(const GraphConstructorOptions& opts,
                               const GraphDef& gdef, Graph* g) {
   ShapeRefiner refiner(gdef.versions().producer(), g->op_registry());
+  // Large graphs often repeat the same subgraph many times.
+  refiner.set_cache_shape_inference(true);
   return GraphConstructor::Construct(
       opts, gdef.node(), &gdef.versions(), &gdef.library(), g, &refiner,
       /*return_tensors=*/nullptr, /*return_nodes=*/nullptr,
@@ -997,6 +999,7 @@ Status ConvertGraphDefToGraph(const GraphConstructorOptions& opts,
 Status ConvertNodeDefsToGraph(const GraphConstructorOptions& opts,
                               gtl::ArraySlice<NodeDef> nodes, Graph* g) {
   ShapeRefiner refiner(TF_GRAPH_DEF_VERSION, g->op_registry());
+  refiner.set_cache_shape_inference(true);
   // TODO(irving): Copy will go away once NodeInfo exists
   std::vector<const NodeDef*> node_defs;
   for (const auto& n : nodes) {
@@ -1041,6 +1044,7 @@ Status ImportGraphDef(const ImportGraphDefOptions& opts, const GraphDef& gdef,
   }
 
   ShapeRefiner default_refiner(gdef.versions().producer(), g->op_registry());
+  default_refiner.set_cache_shape_inference(true);
   if (refiner == nullptr) {
     refiner = &default_refiner;
   } else {
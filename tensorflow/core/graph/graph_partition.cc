@@ -899,10 +899,37 @@ Status AddControlEdges(const PartitionOptions& opts,
   return Status::OK();
 }
 
+// If 'ndef' is a collective, fills its attr device_incarnations with the
+// incarnations of the devices of its group.
+void SetCollectiveIncarnations(const PartitionOptions& opts, NodeDef* ndef) {
+  std::vector<string> devices;
+  if (!GetNodeAttr(*ndef, "devices", &devices).ok()) {
+    // The runtime will report the missing attr.
+    return;
+  }
+  std::vector<int64> incarnations;
+  if (GetNodeAttr(*ndef, "device_incarnations", &incarnations).ok() &&
+      incarnations.size() == devices.size()) {
+    return;
+  }
+  incarnations.clear();
+  for (const string& device : devices) {
+    incarnations.push_back(
+        opts.get_incarnation(DeviceNameUtils::CanonicalizeDeviceName(device)));
+  }
+  SetAttrValue(incarnations,
+               &((*ndef->mutable_attr())["device_incarnations"]));
+}
+
 // If 'ndef' is a Send or Recv, fills its attr send_device_incarnation
 // if possible.
 void SetIncarnation(const PartitionOptions& opts, NodeDef* ndef) {
   StringPiece op(ndef->op());
+  if (op == "CollectiveAllReduce" || op == "CollectiveAllGather" ||
+      op == "CollectiveBroadcast") {
+    SetCollectiveIncarnations(opts, ndef);
+    return;
+  }
   if (op != "_Send" && op != "_Recv") {
     // Not related to send/recv.
     return;
@@ -921,8 +948,8 @@ void SetIncarnation(const PartitionOptions& opts, NodeDef* ndef) {
   }
 }
 
-// Sets attribute send_device_incarnation of all Send/Recv nodes in
-// 'gdef', if possible.
+// Sets attribute send_device_incarnation of all Send/Recv nodes, and
+// device_incarnations of all collective nodes, in 'gdef', if possible.
 void SetIncarnation(const PartitionOptions& opts, GraphDef* gdef) {
   for (NodeDef& ndef : *gdef->mutable_node()) {
     SetIncarnation(opts, &ndef);
@@ -517,6 +517,38 @@ TEST_F(GraphPartitionTest, SetIncarnation) {
   }
 }
 
+TEST_F(GraphPartitionTest, SetCollectiveIncarnations) {
+  GraphDef gdef;
+  CHECK(protobuf::TextFormat::ParseFromString(
+      StrCat("node { name: 'A/Pi' op: 'Const' ",
+             "  attr { key: 'dtype' value { type: DT_FLOAT } } ",
+             "  attr { key: 'value' value { tensor { ",
+             "    dtype: DT_FLOAT tensor_shape {} float_val: 3.14 } } } }",
+             "node { name: 'A' op: 'CollectiveBroadcast' input: 'A/Pi' ",
+             "  attr { key: 'T' value { type: DT_FLOAT } } ",
+             "  attr { key: 'source_rank' value { i: 0 } } ",
+             "  attr { key: 'instance_key' value { s: 'pi' } } ",
+             "  attr { key: 'subdivs' value { i: 1 } } ",
+             "  attr { key: 'devices' value { list { ",
+             "    s: '/job:a/replica:0/task:0/cpu:0' ",
+             "    s: '/job:a/replica:0/task:0/cpu:1' } } } }"),
+      &gdef));
+  gdef.mutable_versions()->set_producer(TF_GRAPH_DEF_VERSION);
+  Partition(gdef, &partitions_);
+  EXPECT_EQ(1, partitions_.size());
+
+  for (const auto& kv : partitions_) {
+    for (const NodeDef& ndef : kv.second.node()) {
+      if (ndef.name() == "A") {
+        std::vector<int64> val;
+        TF_CHECK_OK(GetNodeAttr(ndef, "device_incarnations", &val));
+        // The incarnation of each of the (canonicalized) devices.
+        EXPECT_EQ(std::vector<int64>(2, ('/' - 'A') + 100), val);
+      }
+    }
+  }
+}
+
 TEST(TopologicalSortNodesWithTimePriorityTest, NoDependencies) {
   // Create placeholders, shuffle them so the order in the graph is not strictly
   // increasing.
@@ -0,0 +1,143 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/calibrated_op_level_cost_estimator.h"
+
+#include <math.h>
+#include <utility>
+
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Returns the measured execution time of `perf` in nanoseconds, or 0 if it
+// has none.
+double MeasuredTime(const OpPerformance& perf) {
+  if (perf.compute_cost() > 0) {
+    return perf.compute_cost();
+  }
+  if (perf.has_execution_time_normal()) {
+    return perf.execution_time_normal().mu();
+  }
+  if (perf.has_execution_time_log_normal()) {
+    const auto& distribution = perf.execution_time_log_normal();
+    return exp(distribution.mu() +
+               distribution.sigma() * distribution.sigma() / 2);
+  }
+  return 0;
+}
+
+string OpTypeKey(const OpInfo& op_info) {
+  return op_info.device().type() + ":" + op_info.op();
+}
+
+string OpKey(const OpInfo& op_info) {
+  return op_info.device().type() + ":" + GetOpDescription(op_info);
+}
+
+Costs::Duration Scale(Costs::Duration duration, double scale) {
+  return Costs::Duration(static_cast<int64>(round(duration.count() * scale)));
+}
+
+Costs MeasuredCosts(Costs::Duration time) {
+  Costs costs = Costs::ZeroCosts();
+  costs.execution_time = time;
+  costs.compute_time = time;
+  return costs;
+}
+
+}  // namespace
+
+CalibratedOpLevelCostEstimator::CalibratedOpLevelCostEstimator(
+    const OpPerformanceList& measurements) {
+  // The sums of the measured times, and their number.
+  std::unordered_map<string, std::pair<double, int>> node_sums;
+  std::unordered_map<string, std::pair<double, int>> op_sums;
+  // The sums of the measured and analytical times.
+  std::unordered_map<string, std::pair<double, double>> op_type_sums;
+  for (const OpPerformance& perf : measurements.op_performance()) {
+    const double time = MeasuredTime(perf);
+    if (time <= 0) {
+      continue;
+    }
+    if (!perf.node().empty()) {
+      auto& sum = node_sums[perf.node()];
+      sum.first += time;
+      ++sum.second;
+    }
+    auto& sum = op_sums[OpKey(perf.op())];
+    sum.first += time;
+    ++sum.second;
+
+    OpContext op_context;
+    op_context.name = perf.node();
+    op_context.op_info = perf.op();
+    const Costs analytical = OpLevelCostEstimator::PredictCosts(op_context);
+    if (analytical.execution_time.count() > 0) {
+      auto& type_sum = op_type_sums[OpTypeKey(perf.op())];
+      type_sum.first += time;
+      type_sum.second += analytical.execution_time.count();
+    }
+  }
+  for (const auto& node_and_sum : node_sums) {
+    node_times_[node_and_sum.first] = Costs::Duration(static_cast<int64>(
+        round(node_and_sum.second.first / node_and_sum.second.second)));
+  }
+  for (const auto& op_and_sum : op_sums) {
+    op_times_[op_and_sum.first] = Costs::Duration(static_cast<int64>(
+        round(op_and_sum.second.first / op_and_sum.second.second)));
+  }
+  for (const auto& type_and_sums : op_type_sums) {
+    op_type_scales_[type_and_sums.first] =
+        type_and_sums.second.first / type_and_sums.second.second;
+    VLOG(1) << "Scaling the analytical costs of " << type_and_sums.first
+            << " by " << op_type_scales_[type_and_sums.first];
+  }
+}
+
+Costs CalibratedOpLevelCostEstimator::PredictCosts(
+    const OpContext& op_context) const {
+  auto node_it = node_times_.find(op_context.name);
+  if (node_it != node_times_.end()) {
+    return MeasuredCosts(node_it->second);
+  }
+  auto op_it = op_times_.find(OpKey(op_context.op_info));
+  if (op_it != op_times_.end()) {
+    return MeasuredCosts(op_it->second);
+  }
+  Costs costs = OpLevelCostEstimator::PredictCosts(op_context);
+  auto scale_it = op_type_scales_.find(OpTypeKey(op_context.op_info));
+  if (scale_it != op_type_scales_.end()) {
+    costs.execution_time = Scale(costs.execution_time, scale_it->second);
+    costs.compute_time = Scale(costs.compute_time, scale_it->second);
+    costs.memory_time = Scale(costs.memory_time, scale_it->second);
+  }
+  return costs;
+}
+
+Status CalibratedOpLevelCostEstimator::ReadMeasurements(
+    Env* env, const string& path, OpPerformanceList* measurements) {
+  if (ReadBinaryProto(env, path, measurements).ok()) {
+    return Status::OK();
+  }
+  return ReadTextProto(env, path, measurements);
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
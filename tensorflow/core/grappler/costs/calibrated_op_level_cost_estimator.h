@@ -0,0 +1,62 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_CALIBRATED_OP_LEVEL_COST_ESTIMATOR_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_CALIBRATED_OP_LEVEL_COST_ESTIMATOR_H_
+
+#include <string>
+#include <unordered_map>
+
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// An OpLevelCostEstimator calibrated with the costs of the ops measured in
+// real runs, e.g. as converted from the RunMetadata of a step by
+// CostGraphToOpPerformanceData(). The ops that were measured, found by node
+// name or else by op, device type and input shapes, take their average
+// measured time. The analytical costs of the other ops are scaled by the
+// ratio of the measured to the analytical costs of the measured ops of the
+// same type, on the same type of device.
+class CalibratedOpLevelCostEstimator : public OpLevelCostEstimator {
+ public:
+  explicit CalibratedOpLevelCostEstimator(
+      const OpPerformanceList& measurements);
+  ~CalibratedOpLevelCostEstimator() override {}
+
+  Costs PredictCosts(const OpContext& op_context) const override;
+
+  // Reads the measurements from the binary or text OpPerformanceList at
+  // `path`.
+  static Status ReadMeasurements(Env* env, const string& path,
+                                 OpPerformanceList* measurements);
+
+ private:
+  // The average measured execution times, keyed by node name, and by op
+  // description.
+  std::unordered_map<string, Costs::Duration> node_times_;
+  std::unordered_map<string, Costs::Duration> op_times_;
+  // The ratio of the measured to the analytical costs, keyed by op type.
+  std::unordered_map<string, double> op_type_scales_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_CALIBRATED_OP_LEVEL_COST_ESTIMATOR_H_
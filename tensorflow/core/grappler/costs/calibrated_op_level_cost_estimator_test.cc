@@ -0,0 +1,109 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/calibrated_op_level_cost_estimator.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/device_properties.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Returns the OpContext of a MatMul of a [m, k] and a [k, n] matrix.
+OpContext DescribeMatMul(const string& name, int m, int k, int n) {
+  OpContext op_context;
+  op_context.name = name;
+  op_context.op_info.set_op("MatMul");
+  for (const auto& dims : {std::make_pair(m, k), std::make_pair(k, n)}) {
+    auto input = op_context.op_info.add_inputs();
+    input->set_dtype(DT_FLOAT);
+    input->mutable_shape()->add_dim()->set_size(dims.first);
+    input->mutable_shape()->add_dim()->set_size(dims.second);
+  }
+  auto device = op_context.op_info.mutable_device();
+  device->set_type("CPU");
+  device->set_num_cores(10);
+  device->set_bandwidth(10000000);  // 10000000 KB/s = 10 GB/s
+  device->set_frequency(1000);      // 1000 Mhz = 1 GHz
+  return op_context;
+}
+
+void AddMeasurement(const OpContext& op_context, int64 nanos,
+                    OpPerformanceList* measurements) {
+  OpPerformance* perf = measurements->add_op_performance();
+  perf->set_node(op_context.name);
+  *perf->mutable_op() = op_context.op_info;
+  perf->set_compute_cost(nanos);
+}
+
+TEST(CalibratedOpLevelCostEstimatorTest, UsesMeasuredCosts) {
+  OpPerformanceList measurements;
+  AddMeasurement(DescribeMatMul("a", 100, 100, 100), 1000, &measurements);
+  AddMeasurement(DescribeMatMul("a", 100, 100, 100), 3000, &measurements);
+  AddMeasurement(DescribeMatMul("b", 10, 10, 10), 500, &measurements);
+  CalibratedOpLevelCostEstimator estimator(measurements);
+
+  // By node name, and then by op.
+  Costs costs = estimator.PredictCosts(DescribeMatMul("b", 100, 100, 100));
+  EXPECT_EQ(Costs::Duration(500), costs.execution_time);
+  EXPECT_FALSE(costs.inaccurate);
+  EXPECT_EQ(Costs::Duration(2000),
+            estimator.PredictCosts(DescribeMatMul("c", 100, 100, 100))
+                .execution_time);
+  EXPECT_EQ(Costs::Duration(500),
+            estimator.PredictCosts(DescribeMatMul("c", 10, 10, 10))
+                .execution_time);
+}
+
+TEST(CalibratedOpLevelCostEstimatorTest, ScalesAnalyticalCosts) {
+  OpLevelCostEstimator analytical;
+  const OpContext measured = DescribeMatMul("a", 100, 100, 100);
+  const int64 analytical_time =
+      analytical.PredictCosts(measured).execution_time.count();
+  OpPerformanceList measurements;
+  // Three times slower than predicted.
+  AddMeasurement(measured, 3 * analytical_time, &measurements);
+  CalibratedOpLevelCostEstimator estimator(measurements);
+
+  const OpContext other = DescribeMatMul("b", 200, 100, 50);
+  EXPECT_EQ(3 * analytical.PredictCosts(other).execution_time.count(),
+            estimator.PredictCosts(other).execution_time.count());
+  // Other ops are not calibrated.
+  OpContext add = DescribeMatMul("c", 100, 100, 100);
+  add.op_info.set_op("Add");
+  EXPECT_EQ(analytical.PredictCosts(add).execution_time,
+            estimator.PredictCosts(add).execution_time);
+}
+
+TEST(CalibratedOpLevelCostEstimatorTest, ReadsMeasurements) {
+  OpPerformanceList measurements;
+  AddMeasurement(DescribeMatMul("a", 100, 100, 100), 1000, &measurements);
+  const string path =
+      io::JoinPath(testing::TmpDir(), "op_performance_list.pbtxt");
+  TF_ASSERT_OK(WriteTextProto(Env::Default(), path, measurements));
+
+  OpPerformanceList read;
+  TF_ASSERT_OK(CalibratedOpLevelCostEstimator::ReadMeasurements(
+      Env::Default(), path, &read));
+  EXPECT_EQ(measurements.DebugString(), read.DebugString());
+}
+
+}  // namespace
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -166,7 +166,7 @@ OpLevelCostEstimator::OpLevelCostEstimator() {
       {kNoOp, wrap(&OpLevelCostEstimator::PredictNoOp)},
       {kReshape, wrap(&OpLevelCostEstimator::PredictNoOp)},
       {kRecv, wrap(&OpLevelCostEstimator::PredictNoOp)},
-      {kSend, wrap(&OpLevelCostEstimator::PredictNoOp)},
+      {kSend, wrap(&OpLevelCostEstimator::PredictSend)},
       {kVariable, wrap(&OpLevelCostEstimator::PredictNoOp)},
       {kVariableV2, wrap(&OpLevelCostEstimator::PredictNoOp)},
       {kBatchMatMul, wrap(&OpLevelCostEstimator::PredictBatchMatMul)},
@@ -861,6 +861,23 @@ Costs OpLevelCostEstimator::PredictNoOp(const OpContext& op_context) const {
   return Costs::ZeroCosts();
 }
 
+Costs OpLevelCostEstimator::PredictSend(const OpContext& op_context) const {
+  const auto& op_features = op_context.op_info;
+  // The bandwidth of the channel between the two devices, if known.
+  const double gb_per_sec = op_features.device().bandwidth() / 1e6;
+  if (gb_per_sec <= 0) {
+    return PredictNoOp(op_context);
+  }
+  Costs costs = Costs::ZeroCosts();
+  const double input_size =
+      CalculateInputSize(op_features, &costs.inaccurate);
+  costs.memory_time = Costs::NanoSeconds(std::ceil(input_size / gb_per_sec));
+  costs.execution_time = costs.memory_time;
+  VLOG(1) << "Op:" << op_features.op() << " Size (KB):" << input_size / 1e3
+          << " Transfer Time (ns):" << costs.execution_time.count();
+  return costs;
+}
+
 Costs OpLevelCostEstimator::PredictBatchMatMul(
     const OpContext& op_context) const {
   const auto& op_features = op_context.op_info;
@@ -206,6 +206,22 @@ TEST_F(OpLevelCostEstimatorTest, ModExecutionTime) {
   EXPECT_FALSE(cost.inaccurate);
 }
 
+TEST_F(OpLevelCostEstimatorTest, SendExecutionTime) {
+  OpContext op_context;
+  op_context.op_info.set_op("_Send");
+  DescribeTensor4D(1000, 1, 1, 1, &op_context.op_info);
+  // A channel without a known bandwidth.
+  op_context.op_info.mutable_device()->set_type("Channel");
+  EXPECT_EQ(Costs::Duration(0), PredictCosts(op_context).execution_time);
+
+  op_context.op_info.mutable_device()->set_bandwidth(10000000);  // 10 GB/s
+  auto cost = PredictCosts(op_context);
+  EXPECT_EQ(Costs::Duration(400), cost.memory_time);
+  EXPECT_EQ(Costs::Duration(0), cost.compute_time);
+  EXPECT_EQ(Costs::Duration(400), cost.execution_time);
+  EXPECT_FALSE(cost.inaccurate);
+}
+
 TEST_F(OpLevelCostEstimatorTest, UnknownOrPartialShape) {
   EXPECT_FALSE(PredictCosts(DescribeMatMul(2, 4, 7, 7)).inaccurate);
   EXPECT_TRUE(PredictCosts(DescribeMatMul(-1, 4, 7, 7)).inaccurate);
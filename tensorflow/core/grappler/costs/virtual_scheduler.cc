@@ -36,6 +36,13 @@ namespace tensorflow {
 namespace grappler {
 namespace {
 
+// The bandwidths, in KB/s like DeviceProperties.bandwidth, of the links that
+// the channels between two devices model: the PCIe bus between the devices
+// of a task, e.g. for the host-to-device and device-to-host copies of a GPU,
+// and the network between tasks.
+const double kPcieBandwidth = 12e6;       // 12 GB/s.
+const double kNetworkBandwidth = 1.25e6;  // 10 Gb/s.
+
 Costs CombineCosts(const Costs& left, const Costs& right) {
   CHECK_NE(left.max_memory, kMemoryUnknown);
   CHECK_NE(left.max_per_op_buffers, kMemoryUnknown);
@@ -394,9 +401,15 @@ OpContext VirtualScheduler::GetCurrNode() const {
   DeviceProperties device;
   device = placer_.get_device(*node);
 
-  // Special case for _Send op.
+  // Special case for _Send op. Each pair of devices has its own channel,
+  // which runs the copies between them concurrently with the computations of
+  // both devices and with the copies in the other direction.
   if (IsSend(*node)) {
     device.set_type(kChannelDevice);
+    const bool same_task = DeviceNameUtils::IsSameAddressSpace(
+        node->attr().at(kAttrSrcDevice).s(),
+        node->attr().at(kAttrDstDevice).s());
+    device.set_bandwidth(same_task ? kPcieBandwidth : kNetworkBandwidth);
   }
 
   // Construct OpContext.
@@ -30,6 +30,7 @@ GrapplerItem::GrapplerItem(const GrapplerItem& other, GraphDef&& graphDef) {
   id = other.id;
   feed = other.feed;
   fetch = other.fetch;
+  static_feed_shapes = other.static_feed_shapes;
   init_ops = other.init_ops;
   expected_init_time = other.expected_init_time;
   save_op = other.save_op;
@@ -44,6 +44,10 @@ struct GrapplerItem {
   GraphDef graph;
   std::vector<std::pair<string, Tensor>> feed;
   std::vector<string> fetch;
+  // True if the tensors fed to the graph always have the shapes declared by
+  // the fed placeholders, e.g. because the graph is specialized to them, so
+  // that the optimizers can rely on the static shapes of the graph.
+  bool static_feed_shapes = false;
 
   // Initialization op(s).
   std::vector<string> init_ops;
@@ -90,6 +90,30 @@ bool Int32ValuesFromNode(const NodeDef& node, std::vector<int>* int32_values) {
   return false;
 }
 
+bool IsIdentityPermutation(gtl::ArraySlice<int32> perm) {
+  for (int i = 0; i < perm.size(); ++i) {
+    if (perm[i] != i) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns whether `perm` swaps the two innermost dimensions and keeps the
+// others, e.g. [0, 1, 3, 2].
+bool SwapsInnerDimensions(gtl::ArraySlice<int32> perm) {
+  const int rank = perm.size();
+  if (rank < 2 || perm[rank - 2] != rank - 1 || perm[rank - 1] != rank - 2) {
+    return false;
+  }
+  for (int i = 0; i < rank - 2; ++i) {
+    if (perm[i] != i) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool SimplyReordersData(const NodeDef& node) {
   return node.op() == "Transpose";
 }
@@ -160,6 +184,47 @@ bool IsNumberType(DataType dtype) {
          number_types.end();
 }
 
+// Returns the number of bits of the significand of the floating point type
+// `dtype`, or 0 if `dtype` is not one.
+int SignificandBits(DataType dtype) {
+  switch (dtype) {
+    case DT_BFLOAT16:
+      return 8;
+    case DT_HALF:
+      return 11;
+    case DT_FLOAT:
+      return 24;
+    case DT_DOUBLE:
+      return 53;
+    default:
+      return 0;
+  }
+}
+
+// Returns whether casting a tensor from `src` to `dst` preserves all of its
+// values, e.g. from int8 to float, so that casting it back or further gives
+// the same result as casting the original tensor.
+bool IsLosslessCast(DataType src, DataType dst) {
+  if (src == DT_BOOL) {
+    return dst == DT_BOOL || DataTypeIsInteger(dst) || SignificandBits(dst) > 0;
+  }
+  if (DataTypeIsInteger(src)) {
+    // The number of bits of the magnitude of the values.
+    const int src_bits = DataTypeSize(src) * 8 - !DataTypeIsUnsigned(src);
+    if (DataTypeIsInteger(dst)) {
+      if (!DataTypeIsUnsigned(src) && DataTypeIsUnsigned(dst)) {
+        return false;
+      }
+      return DataTypeSize(dst) * 8 - !DataTypeIsUnsigned(dst) >= src_bits;
+    }
+    return src_bits <= SignificandBits(dst);
+  }
+  // bfloat16 has a wider range of exponents than half.
+  return SignificandBits(src) > 0 &&
+         SignificandBits(dst) >= SignificandBits(src) &&
+         !(src == DT_BFLOAT16 && dst == DT_HALF);
+}
+
 const char kOutputShapesAttr[] = "_output_shapes";
 
 // Returns whether `reshape` is an identity op. The tensor that `reshape`
@@ -426,6 +491,108 @@ string ArithmeticOptimizer::TrySimplifyAndReplaceUses(
     }
   }
 
+  if (node->op() == "Transpose") {
+    const NodeDef* perm = node_map->GetNode(node->input(1));
+    std::vector<int> perm_values;
+    if (Int32ValuesFromNode(*perm, &perm_values)) {
+      // Remove transposes that keep the order of the dimensions.
+      if (IsIdentityPermutation(perm_values)) {
+        return node->input(0);
+      }
+      // Compose consecutive transposes:
+      //   Transpose(Transpose(x, perm1), perm2)
+      // becomes
+      //   Transpose(x, perm)
+      // with perm[i] = perm1[perm2[i]].
+      const NodeDef* input = node_map->GetNode(node->input(0));
+      std::vector<int> input_perm_values;
+      if (input->op() == "Transpose" &&
+          Int32ValuesFromNode(*node_map->GetNode(input->input(1)),
+                              &input_perm_values) &&
+          input_perm_values.size() == perm_values.size()) {
+        NodeDef* transpose = node_map->GetNode(node->name());
+        NodeDef* new_perm = graph_def->add_node();
+        *new_perm = *perm;
+        // The transpose may be composed again with its new input.
+        string perm_name = transpose->name() + "_perm";
+        while (node_map->GetNode(perm_name) != nullptr) {
+          perm_name += "_perm";
+        }
+        new_perm->set_name(perm_name);
+        TensorProto* tensor =
+            (*new_perm->mutable_attr())["value"].mutable_tensor();
+        tensor->clear_tensor_content();
+        tensor->clear_int_val();
+        tensor->mutable_tensor_shape()->clear_dim();
+        tensor->mutable_tensor_shape()->add_dim()->set_size(
+            perm_values.size());
+        for (int i = 0; i < perm_values.size(); ++i) {
+          tensor->add_int_val(input_perm_values[perm_values[i]]);
+        }
+        node_map->AddNode(new_perm->name(), new_perm);
+        // The new permutation keeps the control dependencies of the old one,
+        // e.g. to stay in the frame of a loop.
+        for (const string& perm_input : new_perm->input()) {
+          node_map->AddOutput(NodeName(perm_input), new_perm->name());
+        }
+
+        node_map->UpdateInput(transpose->name(), NodeName(transpose->input(0)),
+                              NodeName(input->input(0)));
+        node_map->UpdateInput(transpose->name(), perm->name(),
+                              new_perm->name());
+        transpose->set_input(0, input->input(0));
+        transpose->set_input(1, new_perm->name());
+        new_nodes->push_back(new_perm);
+        new_nodes->push_back(transpose);
+        return transpose->name();
+      }
+    }
+  }
+
+  // Fold transposes of the two innermost dimensions into the matrix
+  // multiplications that consume them:
+  //   MatMul(Transpose(a, [1, 0]), b)
+  // becomes
+  //   MatMul(a, b, transpose_a=true)
+  // and likewise for BatchMatMul, whose adj_x and adj_y attributes also
+  // conjugate complex matrices.
+  if (node->op() == "MatMul" || node->op() == "BatchMatMul") {
+    const bool is_batch = node->op() == "BatchMatMul";
+    const DataType type = GetDataTypeFromAttr(*node, "T");
+    const bool is_complex = type == DT_COMPLEX64 || type == DT_COMPLEX128;
+    for (int i = 0; i < 2; ++i) {
+      int output_pos = 0;
+      ParseNodeName(node->input(i), &output_pos);
+      const NodeDef* transpose = node_map->GetNode(node->input(i));
+      std::vector<int> perm_values;
+      if (output_pos != 0 ||
+          !(transpose->op() == "Transpose" ||
+            transpose->op() == "ConjugateTranspose") ||
+          !Int32ValuesFromNode(*node_map->GetNode(transpose->input(1)),
+                               &perm_values) ||
+          !SwapsInnerDimensions(perm_values) ||
+          (!is_batch && perm_values.size() != 2)) {
+        continue;
+      }
+      // MatMul only transposes and BatchMatMul also conjugates, which only
+      // matters for complex types.
+      const bool conjugates = transpose->op() == "ConjugateTranspose";
+      if (is_complex && conjugates != is_batch) {
+        continue;
+      }
+      const string attr = is_batch ? (i == 0 ? "adj_x" : "adj_y")
+                                   : (i == 0 ? "transpose_a" : "transpose_b");
+      NodeDef* matmul = node_map->GetNode(node->name());
+      auto& attr_value = (*matmul->mutable_attr())[attr];
+      attr_value.set_b(!attr_value.b());
+      node_map->UpdateInput(matmul->name(), transpose->name(),
+                            NodeName(transpose->input(0)));
+      matmul->set_input(i, transpose->input(0));
+      new_nodes->push_back(matmul);
+      return matmul->name();
+    }
+  }
+
   if (node->op() == "Reshape") {
     //   Reshape
     //      ^
@@ -549,6 +716,21 @@ string ArithmeticOptimizer::TrySimplifyAndReplaceUses(
     if (GetSourceDataType(*node) == GetDestinationDataType(*node)) {
       return node->input(0);
     }
+
+    // Cast(Cast(x, type1), type2) => Cast(x, type2) if the first cast keeps
+    // all the values of x, e.g. for round trips from int8 to float and back.
+    const NodeDef* operand = node_map->GetNode(node->input(0));
+    if (operand->op() == "Cast" &&
+        IsLosslessCast(GetSourceDataType(*operand),
+                       GetDestinationDataType(*operand))) {
+      NodeDef* cast = node_map->GetNode(node->name());
+      node_map->UpdateInput(cast->name(), operand->name(),
+                            NodeName(operand->input(0)));
+      cast->set_input(0, operand->input(0));
+      SetSourceDataType(GetSourceDataType(*operand), cast);
+      new_nodes->push_back(cast);
+      return cast->name();
+    }
   }
 
   // Fold a multiply of a scalar into the following convolution. This folding
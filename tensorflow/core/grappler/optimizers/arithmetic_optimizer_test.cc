@@ -407,7 +407,7 @@ TEST_F(ArithmeticOptimizerTest, RemoveTransposesWithControlDependency) {
   EXPECT_EQ(outputs_node->input(1), "^Placeholder");
 }
 
-TEST_F(ArithmeticOptimizerTest, NotRemoveTransposes) {
+TEST_F(ArithmeticOptimizerTest, ComposeTransposes) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   Output inputs_shape =
       ops::Const(s.WithOpName("inputs_shape"), {8, 3, 28, 28}, {4});
@@ -429,7 +429,113 @@ TEST_F(ArithmeticOptimizerTest, NotRemoveTransposes) {
   item.graph = output;
   TF_EXPECT_OK(ModelPruner().Optimize(nullptr, item, &output));
 
-  EXPECT_EQ(6, output.node_size());
+  // The transposes are not inverses of each other, but are composed into
+  // one.
+  EXPECT_EQ(5, output.node_size());
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "transpose2") {
+      EXPECT_EQ("inputs", node.input(0));
+      EXPECT_EQ("transpose2_perm", node.input(1));
+    } else if (node.name() == "transpose2_perm") {
+      const TensorProto& perm = node.attr().at("value").tensor();
+      EXPECT_EQ(std::vector<int>({2, 3, 0, 1}),
+                std::vector<int>(perm.int_val().begin(), perm.int_val().end()));
+    } else {
+      EXPECT_NE("Transpose", node.op());
+    }
+  }
+}
+
+TEST_F(ArithmeticOptimizerTest, RemoveIdentityTranspose) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output inputs = ops::Placeholder(s.WithOpName("inputs"), DT_FLOAT,
+                                   ops::Placeholder::Shape({2, 3}));
+  Output perm = ops::Const(s.WithOpName("perm"), {0, 1}, {2});
+  Output transpose = ops::Transpose(s.WithOpName("transpose"), inputs, perm);
+  Output outputs = ops::Identity(s.WithOpName("outputs"), transpose);
+
+  GrapplerItem item;
+  item.fetch = {"outputs"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  GraphDef output;
+  TF_EXPECT_OK(ArithmeticOptimizer().Optimize(nullptr, item, &output));
+  item.graph = output;
+  TF_EXPECT_OK(ModelPruner().Optimize(nullptr, item, &output));
+
+  std::set<string> nodes_after_optimization;
+  for (const NodeDef& node : output.node()) {
+    nodes_after_optimization.insert(node.name());
+  }
+  EXPECT_EQ(nodes_after_optimization,
+            std::set<string>({"inputs", "outputs"}));
+}
+
+TEST_F(ArithmeticOptimizerTest, FoldTransposeIntoMatMul) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT,
+                              ops::Placeholder::Shape({3, 2}));
+  Output b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT,
+                              ops::Placeholder::Shape({4, 3}));
+  Output perm = ops::Const(s.WithOpName("perm"), {1, 0}, {2});
+  Output trans_a = ops::Transpose(s.WithOpName("trans_a"), a, perm);
+  Output trans_b = ops::Transpose(s.WithOpName("trans_b"), b, perm);
+  Output matmul = ops::MatMul(s.WithOpName("matmul"), trans_a, trans_b);
+  Output outputs = ops::Identity(s.WithOpName("outputs"), matmul);
+
+  GrapplerItem item;
+  item.fetch = {"outputs"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  GraphDef output;
+  TF_EXPECT_OK(ArithmeticOptimizer().Optimize(nullptr, item, &output));
+  item.graph = output;
+  TF_EXPECT_OK(ModelPruner().Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(4, output.node_size());
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE("Transpose", node.op());
+    if (node.name() == "matmul") {
+      EXPECT_EQ("a", node.input(0));
+      EXPECT_EQ("b", node.input(1));
+      EXPECT_TRUE(node.attr().at("transpose_a").b());
+      EXPECT_TRUE(node.attr().at("transpose_b").b());
+    }
+  }
+}
+
+TEST_F(ArithmeticOptimizerTest, FoldConjugateTransposeIntoBatchMatMul) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_COMPLEX64,
+                              ops::Placeholder::Shape({5, 2, 3}));
+  Output b = ops::Placeholder(s.WithOpName("b"), DT_COMPLEX64,
+                              ops::Placeholder::Shape({5, 4, 3}));
+  Output perm = ops::Const(s.WithOpName("perm"), {0, 2, 1}, {3});
+  // The adjoint of a complex matrix is its conjugate transpose, so the plain
+  // transpose stays.
+  Output trans_a = ops::Transpose(s.WithOpName("trans_a"), a, perm);
+  Output adj_b = ops::ConjugateTranspose(s.WithOpName("adj_b"), b, perm);
+  Output matmul = ops::BatchMatMul(s.WithOpName("matmul"), trans_a, adj_b);
+  Output outputs = ops::Identity(s.WithOpName("outputs"), matmul);
+
+  GrapplerItem item;
+  item.fetch = {"outputs"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  GraphDef output;
+  TF_EXPECT_OK(ArithmeticOptimizer().Optimize(nullptr, item, &output));
+  item.graph = output;
+  TF_EXPECT_OK(ModelPruner().Optimize(nullptr, item, &output));
+
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE("adj_b", node.name());
+    if (node.name() == "matmul") {
+      EXPECT_EQ("trans_a", node.input(0));
+      EXPECT_EQ("b", node.input(1));
+      EXPECT_FALSE(node.attr().at("adj_x").b());
+      EXPECT_TRUE(node.attr().at("adj_y").b());
+    }
+  }
 }
 
 TEST_F(ArithmeticOptimizerTest, FoldMulToTransposeConv) {
@@ -652,6 +758,48 @@ TEST_F(ArithmeticOptimizerTest, RemoveRedundantCast) {
                    [](const NodeDef& node) { return node.op() == "Cast"; }));
 }
 
+TEST_F(ArithmeticOptimizerTest, RemoveRoundTripCast) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output inputs = ops::Placeholder(s.WithOpName("inputs"), DT_INT8,
+                                   ops::Placeholder::Shape({2, 3}));
+  Output cast1 = ops::Cast(s.WithOpName("cast1"), inputs, DT_FLOAT);
+  Output cast2 = ops::Cast(s.WithOpName("cast2"), cast1, DT_INT8);
+  Output outputs = ops::Identity(s.WithOpName("outputs"), cast2);
+
+  GrapplerItem item;
+  item.fetch = {"outputs"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  GraphDef output;
+  TF_EXPECT_OK(ArithmeticOptimizer().Optimize(nullptr, item, &output));
+  item.graph = output;
+  TF_EXPECT_OK(ModelPruner().Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(0, std::count_if(
+                   output.node().begin(), output.node().end(),
+                   [](const NodeDef& node) { return node.op() == "Cast"; }));
+}
+
+TEST_F(ArithmeticOptimizerTest, NotRemoveLossyRoundTripCast) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output inputs = ops::Placeholder(s.WithOpName("inputs"), DT_FLOAT,
+                                   ops::Placeholder::Shape({2, 3}));
+  Output cast1 = ops::Cast(s.WithOpName("cast1"), inputs, DT_INT32);
+  Output cast2 = ops::Cast(s.WithOpName("cast2"), cast1, DT_FLOAT);
+  Output outputs = ops::Identity(s.WithOpName("outputs"), cast2);
+
+  GrapplerItem item;
+  item.fetch = {"outputs"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  GraphDef output;
+  TF_EXPECT_OK(ArithmeticOptimizer().Optimize(nullptr, item, &output));
+  item.graph = output;
+  TF_EXPECT_OK(ModelPruner().Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(2, std::count_if(
+                   output.node().begin(), output.node().end(),
+                   [](const NodeDef& node) { return node.op() == "Cast"; }));
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
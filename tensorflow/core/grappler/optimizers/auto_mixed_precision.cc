@@ -0,0 +1,255 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
+
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+const char kCastToHalf[] = "AutoMixedPrecisionCastToHalf";
+const char kCastToFloat[] = "AutoMixedPrecisionCastToFloat";
+
+// The ops that are much faster in half precision on GPUs, and accumulate in
+// float internally.
+bool IsAllowed(const NodeDef& node) {
+  static const std::unordered_set<string>* allow_ops =
+      new std::unordered_set<string>({"BatchMatMul", "Conv2D",
+                                      "Conv2DBackpropFilter",
+                                      "Conv2DBackpropInput", "MatMul"});
+  return allow_ops->count(node.op()) > 0;
+}
+
+// The ops that are about as fast and as accurate in either precision, and
+// run in the precision of their inputs to avoid casts.
+bool IsInferred(const NodeDef& node) {
+  static const std::unordered_set<string>* infer_ops =
+      new std::unordered_set<string>(
+          {"Add",         "AddN",        "AvgPool",   "AvgPoolGrad",
+           "BiasAdd",     "BiasAddGrad", "ConcatV2",  "ExpandDims",
+           "Identity",    "MaxPool",     "MaxPoolGrad", "Mul",
+           "Neg",         "Pad",         "Relu",      "Relu6",
+           "Relu6Grad",   "ReluGrad",    "Reshape",   "Sigmoid",
+           "SigmoidGrad", "Squeeze",     "Sub",       "Tanh",
+           "TanhGrad",    "Transpose"});
+  return infer_ops->count(node.op()) > 0;
+}
+
+// The ops whose results need the range or the precision of float, e.g.
+// reductions, exponentials and the checks of dynamic loss scaling.
+bool IsDenied(const NodeDef& node) {
+  static const std::unordered_set<string>* deny_ops =
+      new std::unordered_set<string>(
+          {"Exp", "IsFinite", "IsInf", "IsNan", "L2Loss", "Log", "Log1p",
+           "LogSoftmax", "Mean", "Pow", "Prod", "Rsqrt", "Softmax",
+           "SoftmaxCrossEntropyWithLogits",
+           "SparseSoftmaxCrossEntropyWithLogits", "Sqrt", "Square",
+           "SquaredDifference", "Sum"});
+  return deny_ops->count(node.op()) > 0;
+}
+
+bool IsOnGpu(const NodeDef& node) {
+  DeviceNameUtils::ParsedName parsed_name;
+  return DeviceNameUtils::ParseFullName(node.device(), &parsed_name) &&
+         parsed_name.has_type && parsed_name.type == "GPU";
+}
+
+// The positions of the inputs and outputs of a node whose type is its "T"
+// attribute.
+struct FloatArgs {
+  std::vector<int> inputs;
+  std::vector<int> outputs;
+};
+
+// Returns false if the types of the arguments of `node` are unknown, e.g.
+// because some of them are lists of types.
+bool GetFloatArgs(const NodeDef& node, FloatArgs* args) {
+  const OpDef* op_def;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok()) {
+    return false;
+  }
+  const auto add_args = [&node](
+      const protobuf::RepeatedPtrField<OpDef::ArgDef>& arg_defs,
+      std::vector<int>* positions) {
+    int position = 0;
+    for (const auto& arg_def : arg_defs) {
+      if (!arg_def.type_list_attr().empty() || arg_def.is_ref()) {
+        return false;
+      }
+      int count = 1;
+      if (!arg_def.number_attr().empty()) {
+        auto it = node.attr().find(arg_def.number_attr());
+        if (it == node.attr().end()) {
+          return false;
+        }
+        count = it->second.i();
+      }
+      for (int i = 0; i < count; ++i, ++position) {
+        if (arg_def.type_attr() == "T") {
+          positions->push_back(position);
+        }
+      }
+    }
+    return true;
+  };
+  return add_args(op_def->input_arg(), &args->inputs) &&
+         add_args(op_def->output_arg(), &args->outputs);
+}
+
+bool Contains(const std::vector<int>& positions, int position) {
+  return std::find(positions.begin(), positions.end(), position) !=
+         positions.end();
+}
+
+}  // namespace
+
+Status AutoMixedPrecision::Optimize(Cluster* /*cluster*/,
+                                    const GrapplerItem& item,
+                                    GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  nodes_to_preserve_ = item.NodesToPreserve();
+  NodeMap node_map(optimized_graph);
+
+  // The float nodes on GPUs that may be converted.
+  std::unordered_map<string, FloatArgs> candidates;
+  for (const NodeDef& node : optimized_graph->node()) {
+    auto it = node.attr().find("T");
+    if (it == node.attr().end() || it->second.type() != DT_FLOAT ||
+        !(IsAllowed(node) || IsInferred(node)) || !IsOnGpu(node) ||
+        nodes_to_preserve_.count(node.name()) > 0) {
+      continue;
+    }
+    FloatArgs args;
+    if (GetFloatArgs(node, &args)) {
+      candidates[node.name()] = args;
+    }
+  }
+
+  // Returns whether `tensor` is a float output of a converted node.
+  std::unordered_set<string> half_nodes;
+  const auto is_half = [&half_nodes, &candidates](const string& tensor) {
+    int position;
+    const string name = ParseNodeName(tensor, &position);
+    return position >= 0 && half_nodes.count(name) > 0 &&
+           Contains(candidates[name].outputs, position);
+  };
+
+  std::deque<const NodeDef*> queue;
+  for (const NodeDef& node : optimized_graph->node()) {
+    if (candidates.count(node.name()) > 0 && IsAllowed(node)) {
+      half_nodes.insert(node.name());
+      queue.push_back(&node);
+    }
+  }
+  while (!queue.empty()) {
+    const NodeDef* node = queue.front();
+    queue.pop_front();
+    for (const NodeDef* consumer : node_map.GetOutputs(node->name())) {
+      if (half_nodes.count(consumer->name()) > 0 ||
+          candidates.count(consumer->name()) == 0 || !IsInferred(*consumer)) {
+        continue;
+      }
+      bool has_half_input = false;
+      bool has_denied_input = false;
+      for (int i : candidates[consumer->name()].inputs) {
+        if (i >= consumer->input_size()) {
+          continue;
+        }
+        const NodeDef* producer = node_map.GetNode(consumer->input(i));
+        has_half_input |= is_half(consumer->input(i));
+        has_denied_input |= producer != nullptr && IsDenied(*producer);
+      }
+      if (has_half_input && !has_denied_input) {
+        half_nodes.insert(consumer->name());
+        queue.push_back(consumer);
+      }
+    }
+  }
+  if (half_nodes.empty()) {
+    return Status::OK();
+  }
+
+  // The casts of each tensor, shared by its consumers.
+  std::unordered_map<string, string> casts;
+  const auto cast = [optimized_graph, &casts](const string& tensor,
+                                              DataType dst_type,
+                                              const string& device) {
+    int position;
+    const string name = ParseNodeName(tensor, &position);
+    const string cast_name = AddPrefixToNodeName(
+        strings::StrCat(name, "-", position),
+        dst_type == DT_HALF ? kCastToHalf : kCastToFloat);
+    if (casts.insert({cast_name, tensor}).second) {
+      NodeDef* cast_node = optimized_graph->add_node();
+      cast_node->set_name(cast_name);
+      cast_node->set_op("Cast");
+      cast_node->set_device(device);
+      cast_node->add_input(tensor);
+      (*cast_node->mutable_attr())["SrcT"].set_type(
+          dst_type == DT_HALF ? DT_FLOAT : DT_HALF);
+      (*cast_node->mutable_attr())["DstT"].set_type(dst_type);
+    }
+    return cast_name;
+  };
+
+  const int num_nodes = optimized_graph->node_size();
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* node = optimized_graph->mutable_node(i);
+    if (half_nodes.count(node->name()) > 0) {
+      VLOG(2) << "Converting " << node->name() << " to half precision";
+      (*node->mutable_attr())["T"].set_type(DT_HALF);
+      for (int j : candidates[node->name()].inputs) {
+        if (j < node->input_size() && !is_half(node->input(j))) {
+          *node->mutable_input(j) =
+              cast(node->input(j), DT_HALF, node->device());
+        }
+      }
+    } else {
+      for (int j = 0; j < node->input_size(); ++j) {
+        if (is_half(node->input(j))) {
+          const NodeDef* producer = node_map.GetNode(node->input(j));
+          *node->mutable_input(j) =
+              cast(node->input(j), DT_FLOAT, producer->device());
+        }
+      }
+    }
+  }
+  return Status::OK();
+}
+
+void AutoMixedPrecision::Feedback(Cluster* /*cluster*/,
+                                  const GrapplerItem& /*item*/,
+                                  const GraphDef& /*optimized_graph*/,
+                                  double /*result*/) {
+  // Nothing to do for AutoMixedPrecision.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
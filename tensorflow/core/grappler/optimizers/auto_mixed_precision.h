@@ -0,0 +1,60 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_AUTO_MIXED_PRECISION_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_AUTO_MIXED_PRECISION_H_
+
+#include <unordered_set>
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Convert the float computations that run on GPUs to half precision, so that
+// they can use the tensor cores: the ops of an allow list (matrix
+// multiplications and convolutions, and their gradients) always run in half
+// precision, and the ops of an infer list (e.g. element-wise ops and pooling)
+// follow the converted ops that feed them, unless they also consume the
+// result of an op of a deny list (e.g. reductions and exponentials). All the
+// other ops, including the variables and the ops that update them, stay in
+// float, and Cast nodes are inserted at the boundaries between the two
+// precisions, once per converted tensor.
+class AutoMixedPrecision : public GraphOptimizer {
+ public:
+  AutoMixedPrecision() : opt_level_(RewriterConfig::ON) {}
+  explicit AutoMixedPrecision(RewriterConfig::Toggle opt_level)
+      : opt_level_(opt_level) {}
+  ~AutoMixedPrecision() override {}
+
+  string name() const override { return "auto_mixed_precision"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+
+ private:
+  std::unordered_set<string> nodes_to_preserve_;
+
+  RewriterConfig::Toggle opt_level_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_AUTO_MIXED_PRECISION_H_
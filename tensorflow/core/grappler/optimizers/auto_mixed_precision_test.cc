@@ -0,0 +1,141 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+const char kGpu[] = "/job:localhost/replica:0/task:0/gpu:0";
+
+class AutoMixedPrecisionTest : public ::testing::Test {
+ protected:
+  static DataType TypeOf(const NodeMap& node_map, const string& name,
+                         const string& attr = "T") {
+    return node_map.GetNode(name)->attr().at(attr).type();
+  }
+};
+
+TEST_F(AutoMixedPrecisionTest, ConvertsMatMulsAndTheirNeighbours) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(kGpu);
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT);
+  Output b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT);
+  Output c = ops::Placeholder(s.WithOpName("c"), DT_FLOAT);
+  Output matmul1 = ops::MatMul(s.WithOpName("matmul1"), a, b);
+  Output relu = ops::Relu(s.WithOpName("relu"), matmul1);
+  Output matmul2 = ops::MatMul(s.WithOpName("matmul2"), relu, c);
+  Output softmax = ops::Softmax(s.WithOpName("softmax"), matmul2);
+  Output fetch = ops::Identity(s.WithOpName("fetch"), softmax);
+
+  GrapplerItem item;
+  item.fetch.push_back("fetch");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  AutoMixedPrecision optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // One cast for each of the placeholders, and one for the input of the
+  // softmax.
+  EXPECT_EQ(item.graph.node_size() + 4, output.node_size());
+  NodeMap node_map(&output);
+  EXPECT_EQ(DT_HALF, TypeOf(node_map, "matmul1"));
+  EXPECT_EQ(DT_HALF, TypeOf(node_map, "relu"));
+  EXPECT_EQ(DT_HALF, TypeOf(node_map, "matmul2"));
+  EXPECT_EQ(DT_FLOAT, TypeOf(node_map, "softmax"));
+  EXPECT_EQ(DT_FLOAT, TypeOf(node_map, "fetch"));
+
+  const NodeDef* matmul1_node = node_map.GetNode("matmul1");
+  EXPECT_EQ("AutoMixedPrecisionCastToHalf/a-0", matmul1_node->input(0));
+  EXPECT_EQ("AutoMixedPrecisionCastToHalf/b-0", matmul1_node->input(1));
+  EXPECT_EQ("matmul1", node_map.GetNode("relu")->input(0));
+  EXPECT_EQ("relu", node_map.GetNode("matmul2")->input(0));
+  EXPECT_EQ("AutoMixedPrecisionCastToHalf/c-0",
+            node_map.GetNode("matmul2")->input(1));
+  EXPECT_EQ("AutoMixedPrecisionCastToFloat/matmul2-0",
+            node_map.GetNode("softmax")->input(0));
+
+  const NodeDef* cast = node_map.GetNode("AutoMixedPrecisionCastToHalf/a-0");
+  EXPECT_EQ("Cast", cast->op());
+  EXPECT_EQ("a", cast->input(0));
+  EXPECT_EQ(kGpu, cast->device());
+  EXPECT_EQ(DT_FLOAT, TypeOf(node_map, cast->name(), "SrcT"));
+  EXPECT_EQ(DT_HALF, TypeOf(node_map, cast->name(), "DstT"));
+}
+
+TEST_F(AutoMixedPrecisionTest, KeepsDeniedOpsInFloat) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(kGpu);
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT);
+  Output b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT);
+  Output matmul = ops::MatMul(s.WithOpName("matmul"), a, b);
+  Output exp = ops::Exp(s.WithOpName("exp"), matmul);
+  // Consumes both a converted op and a denied op.
+  Output add = ops::Add(s.WithOpName("add"), matmul, exp);
+  Output fetch = ops::Identity(s.WithOpName("fetch"), add);
+
+  GrapplerItem item;
+  item.fetch.push_back("fetch");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  AutoMixedPrecision optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(DT_HALF, TypeOf(node_map, "matmul"));
+  EXPECT_EQ(DT_FLOAT, TypeOf(node_map, "exp"));
+  EXPECT_EQ(DT_FLOAT, TypeOf(node_map, "add"));
+  // The two consumers of the matmul share a cast.
+  EXPECT_EQ("AutoMixedPrecisionCastToFloat/matmul-0",
+            node_map.GetNode("exp")->input(0));
+  EXPECT_EQ("AutoMixedPrecisionCastToFloat/matmul-0",
+            node_map.GetNode("add")->input(0));
+  EXPECT_EQ(item.graph.node_size() + 3, output.node_size());
+}
+
+TEST_F(AutoMixedPrecisionTest, KeepsCpuAndFetchedNodes) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT);
+  Output b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT);
+  Output cpu_matmul =
+      ops::MatMul(s.WithOpName("cpu_matmul").WithDevice("/cpu:0"), a, b);
+  Output gpu_matmul =
+      ops::MatMul(s.WithOpName("gpu_matmul").WithDevice(kGpu), a, b);
+
+  GrapplerItem item;
+  item.fetch.push_back("cpu_matmul");
+  item.fetch.push_back("gpu_matmul");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  AutoMixedPrecision optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  NodeMap node_map(&output);
+  EXPECT_EQ(DT_FLOAT, TypeOf(node_map, "cpu_matmul"));
+  EXPECT_EQ(DT_FLOAT, TypeOf(node_map, "gpu_matmul"));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
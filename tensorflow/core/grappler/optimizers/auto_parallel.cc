@@ -15,16 +15,23 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/auto_parallel.h"
 
+#include <algorithm>
+#include <unordered_map>
+
 #include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/cost_graph.pb.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/analytical_cost_estimator.h"
 #include "tensorflow/core/grappler/devices.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 
 namespace tensorflow {
@@ -144,6 +151,8 @@ Status AutoParallel::Initialize(const GrapplerItem& item) {
     all_nodes_.insert(std::make_pair(div_node->name(), div_node));
     *apply_gradients_node->mutable_input(gradient_pos[apply_gradients_op]) =
         div_node->name();
+    gradient_inputs_[apply_gradient_node_name] =
+        gradient_pos[apply_gradients_op];
   }
   LOG(INFO) << "Graph size after adding div nodes: " << all_nodes_.size();
 
@@ -186,6 +195,13 @@ Status AutoParallel::Initialize(const GrapplerItem& item) {
       replica_nodes_.insert(node->name());
     }
   }
+  // The micro-batches of a pipeline share the apply gradients nodes, which
+  // apply the sum of their averaged gradients.
+  if (num_pipeline_stages_ > 1) {
+    for (const auto& apply_gradient_node_name : apply_gradients_nodes_) {
+      replica_nodes_.erase(apply_gradient_node_name);
+    }
+  }
   LOG(INFO) << "Number of replica nodes: " << replica_nodes_.size();
 
   for (const auto& node : all_nodes_) {
@@ -197,6 +213,128 @@ Status AutoParallel::Initialize(const GrapplerItem& item) {
   return Status::OK();
 }
 
+void AutoParallel::AssignPipelineStages(Cluster* cluster) {
+  if (cluster != nullptr) {
+    for (const auto& device : cluster->GetDevices()) {
+      if (device.second.type() == "GPU") {
+        stage_devices_.push_back(device.first);
+      }
+    }
+    std::sort(stage_devices_.begin(), stage_devices_.end());
+  } else {
+    for (int i = 0; i < num_gpus_; i++) {
+      stage_devices_.push_back(strings::StrCat("/gpu:", i));
+    }
+  }
+  if (stage_devices_.size() < static_cast<size_t>(num_pipeline_stages_)) {
+    LOG(WARNING) << "Only " << stage_devices_.size() << " GPUs for "
+                 << num_pipeline_stages_ << " pipeline stages";
+  }
+
+  // The estimated compute cost of each node, in microseconds.
+  std::unordered_map<string, int64> costs;
+  if (cluster != nullptr) {
+    AnalyticalCostEstimator estimator(cluster, true /* use_static_shapes */);
+    CostGraphDef cost_graph;
+    Costs graph_costs;
+    Status status = estimator.Initialize(*item_);
+    if (status.ok()) {
+      status = estimator.PredictCosts(graph_, &cost_graph, &graph_costs);
+    }
+    if (status.ok()) {
+      for (const auto& node : cost_graph.node()) {
+        costs[node.name()] = node.compute_cost();
+      }
+    } else {
+      LOG(WARNING) << "Failed to estimate the costs of the nodes: " << status;
+    }
+  }
+
+  // A gradient node belongs to the node whose gradient it computes, e.g.
+  // "gradients/layer/MatMul_grad/MatMul" to "layer/MatMul", so that each
+  // stage runs both passes of its nodes. The other nodes are cut into stages
+  // of equal costs in topological order.
+  GraphDef sorted_graph = graph_;
+  TopologicalSort(&sorted_graph);
+  std::vector<string> owners_in_order;
+  std::map<string, string> owners;
+  std::map<string, int64> owner_costs;
+  int64 total_cost = 0;
+  for (const auto& node : sorted_graph.node()) {
+    if (replica_nodes_.find(node.name()) == replica_nodes_.end()) {
+      continue;
+    }
+    string owner = node.name();
+    if (StringPiece(node.name()).starts_with("gradients/")) {
+      const string name = node.name().substr(strlen("gradients/"));
+      auto pos = name.find("_grad/");
+      if (pos != string::npos) {
+        string forward = name.substr(0, pos);
+        if (replica_nodes_.find(forward) != replica_nodes_.end()) {
+          owner = forward;
+        }
+      }
+    }
+    if (owner == node.name()) {
+      owners_in_order.push_back(owner);
+    }
+    owners[node.name()] = owner;
+    // Plus one, so that the nodes without an estimate count.
+    const int64 cost = costs[node.name()] + 1;
+    owner_costs[owner] += cost;
+    total_cost += cost;
+  }
+  const double stage_cost =
+      static_cast<double>(total_cost) / num_pipeline_stages_;
+  std::map<string, int> owner_stages;
+  int64 cost_before = 0;
+  for (const auto& owner : owners_in_order) {
+    const int stage = static_cast<int>(
+        (cost_before + owner_costs[owner] / 2.0) / stage_cost);
+    owner_stages[owner] = std::min(stage, num_pipeline_stages_ - 1);
+    cost_before += owner_costs[owner];
+  }
+  for (const auto& node_and_owner : owners) {
+    stages_[node_and_owner.first] = owner_stages[node_and_owner.second];
+    VLOG(2) << "Pipeline stage of " << node_and_owner.first << ": "
+            << stages_[node_and_owner.first];
+  }
+  if (stage_devices_.empty()) {
+    return;
+  }
+
+  // The variables are placed on the first stage that reads them, along with
+  // their shared consumers, e.g. their initializers and apply gradients nodes.
+  std::map<string, int> variable_stages;
+  for (const auto& var : item_->MainVariables()) {
+    variable_stages[var->name()] = num_pipeline_stages_;
+  }
+  for (const auto& node : replica_nodes_) {
+    for (const auto& input : all_nodes_[node]->input()) {
+      auto it = variable_stages.find(NodeName(input));
+      if (it != variable_stages.end()) {
+        it->second = std::min(it->second, stages_[node]);
+      }
+    }
+  }
+  for (const auto& variable_and_stage : variable_stages) {
+    if (variable_and_stage.second < num_pipeline_stages_) {
+      shared_devices_[variable_and_stage.first] =
+          stage_devices_[variable_and_stage.second % stage_devices_.size()];
+    }
+  }
+  for (const auto& node : shared_nodes_) {
+    for (const auto& input : all_nodes_[node]->input()) {
+      const string input_name = NodeName(input);
+      if (variable_stages.find(input_name) != variable_stages.end() &&
+          shared_devices_.find(input_name) != shared_devices_.end()) {
+        shared_devices_[node] = shared_devices_[input_name];
+        break;
+      }
+    }
+  }
+}
+
 bool AutoParallel::NotSharedNode(const string& name) {
   return shared_nodes_.find(name) == shared_nodes_.end();
 }
@@ -206,6 +344,10 @@ void AutoParallel::AddSharedNodes(GraphDef* graph) {
   for (const auto& node : shared_nodes_) {
     auto new_node = graph->add_node();
     *new_node = *all_nodes_[node];
+    auto it = shared_devices_.find(node);
+    if (it != shared_devices_.end()) {
+      new_node->set_device(it->second);
+    }
     for (int i = 0; i < new_node->input_size(); i++) {
       if (NotSharedNode(NodeName(new_node->input(i)))) {
         string new_name = AddPrefixToNodeName(new_node->input(i), prefix);
@@ -222,7 +364,12 @@ void AutoParallel::AddOneReplica(GraphDef* graph, int number) {
     *new_node = *all_nodes_[node];
     if (NotSharedNode(new_node->name())) {
       new_node->set_name(AddPrefixToNodeName(new_node->name(), prefix));
-      if (num_gpus_ > 0) {
+      if (num_pipeline_stages_ > 1) {
+        if (!stage_devices_.empty()) {
+          new_node->set_device(
+              stage_devices_[stages_[node] % stage_devices_.size()]);
+        }
+      } else if (num_gpus_ > 0) {
         new_node->set_device(strings::StrCat("/gpu:", number % num_gpus_));
       }
       for (int i = 0; i < new_node->input_size(); i++) {
@@ -235,13 +382,49 @@ void AutoParallel::AddOneReplica(GraphDef* graph, int number) {
   }
 }
 
+void AutoParallel::AddGradientAccumulation(GraphDef* graph) {
+  for (int i = 0; i < graph->node_size(); i++) {
+    auto apply_gradients_node = graph->mutable_node(i);
+    auto it = gradient_inputs_.find(apply_gradients_node->name());
+    if (it == gradient_inputs_.end()) {
+      continue;
+    }
+    const string gradient = all_nodes_[it->first]->input(it->second);
+    auto sum_node = graph->add_node();
+    sum_node->set_name(
+        strings::StrCat(kAutoParallelPrefix, "-Accumulate-", it->first));
+    sum_node->set_op("AddN");
+    sum_node->set_device(apply_gradients_node->device());
+    for (int j = 0; j < num_replicas_; j++) {
+      string prefix = strings::StrCat(kAutoParallelPrefix, "-Replica-", j);
+      sum_node->add_input(AddPrefixToNodeName(gradient, prefix));
+    }
+    AttrValue attr_num;
+    attr_num.set_i(num_replicas_);
+    sum_node->mutable_attr()->insert({"N", attr_num});
+    AttrValue attr_type;
+    attr_type.set_type(DT_FLOAT);
+    sum_node->mutable_attr()->insert({"T", attr_type});
+    *apply_gradients_node->mutable_input(it->second) = sum_node->name();
+  }
+}
+
 void AutoParallel::BuildGraph(GraphDef* graph) {
   AddSharedNodes(graph);
   for (int i = 0; i < num_replicas_; i++) {
     AddOneReplica(graph, i);
   }
+  if (num_pipeline_stages_ > 1) {
+    AddGradientAccumulation(graph);
+  }
   std::set<string> fetches;
   for (size_t i = 0; i < item_->fetch.size(); i++) {
+    // The shared fetch nodes, e.g. the apply gradients nodes of a pipeline,
+    // are fetched as they are.
+    if (!NotSharedNode(NodeName(item_->fetch[i]))) {
+      fetches.insert(NodeName(item_->fetch[i]));
+      continue;
+    }
     for (int j = 0; j < num_replicas_; j++) {
       string prefix = strings::StrCat(kAutoParallelPrefix, "-Replica-", j);
       string fetch = AddPrefixToNodeName(item_->fetch[i], prefix);
@@ -253,7 +436,9 @@ void AutoParallel::BuildGraph(GraphDef* graph) {
   auto control = AddNodeControl(name_control, fetches, graph);
 
   for (const auto& fetch : item_->fetch) {
-    AddNodeControl(fetch, {control->name()}, graph);
+    if (NotSharedNode(NodeName(fetch))) {
+      AddNodeControl(fetch, {control->name()}, graph);
+    }
   }
   *graph->mutable_library() = item_->graph.library();
   *graph->mutable_versions() = item_->graph.versions();
@@ -263,6 +448,9 @@ void AutoParallel::BuildGraph(GraphDef* graph) {
 Status AutoParallel::Optimize(Cluster* cluster, const GrapplerItem& item,
                               GraphDef* output) {
   TF_RETURN_IF_ERROR(Initialize(item));
+  if (num_pipeline_stages_ > 1) {
+    AssignPipelineStages(cluster);
+  }
   BuildGraph(output);
   return Status::OK();
 }
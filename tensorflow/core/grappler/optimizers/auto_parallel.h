@@ -16,6 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_AUTO_PARALLEL_H_
 #define TENSORFLOW_GRAPPLER_OPTIMIZERS_AUTO_PARALLEL_H_
 
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/framework/variable.pb.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -24,9 +29,18 @@ namespace tensorflow {
 namespace grappler {
 
 // Automatically parallelize a graph by splitting in the batch dimension.
+//
+// With more than one pipeline stage, the replicas are instead the
+// micro-batches of a pipeline: the training nodes are cut into stages of
+// balanced estimated costs, each placed on its own GPU, so that the stages of
+// successive micro-batches run concurrently. The gradients of the
+// micro-batches are averaged, and applied once to the variables.
 class AutoParallel : public GraphOptimizer {
  public:
-  AutoParallel(int num_replicas) : num_replicas_(num_replicas) {
+  AutoParallel(int num_replicas, int num_pipeline_stages = 1)
+      : num_replicas_(num_replicas),
+        // An unset option (0) means no pipeline.
+        num_pipeline_stages_(std::max(1, num_pipeline_stages)) {
     CHECK(num_replicas_ >= 2);
   }
   ~AutoParallel() override {}
@@ -45,10 +59,19 @@ class AutoParallel : public GraphOptimizer {
   std::set<string> apply_gradients_nodes_;
   std::set<string> replica_nodes_;
   std::set<string> shared_nodes_;
+  // The input of the gradient of each apply gradients node.
+  std::map<string, int> gradient_inputs_;
+  // The pipeline stage of each replica node, and the devices of the stages.
+  std::map<string, int> stages_;
+  std::vector<string> stage_devices_;
+  // The devices of the shared nodes that are assigned to a stage.
+  std::map<string, string> shared_devices_;
   const GrapplerItem* item_;
   int num_replicas_;
+  int num_pipeline_stages_;
   int num_gpus_;
   Status Initialize(const GrapplerItem& item);
+  void AssignPipelineStages(Cluster* cluster);
   NodeDef* AddNodeDivConst();
   NodeDef* AddNodeDiv(const string& name, const string& input_a,
                       const string& input_b);
@@ -57,6 +80,7 @@ class AutoParallel : public GraphOptimizer {
   bool NotSharedNode(const string& name);
   void AddSharedNodes(GraphDef* graph);
   void AddOneReplica(GraphDef* graph, int number);
+  void AddGradientAccumulation(GraphDef* graph);
   void BuildGraph(GraphDef* graph);
 };
 
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/auto_parallel.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -126,6 +127,95 @@ TEST_F(AutoParallelTest, SimpleParallel) {
   EXPECT_EQ("^AutoParallel-Control-Fetch", node_gradient.input(0));
 }
 
+TEST_F(AutoParallelTest, PipelineParallel) {
+  tensorflow::Scope s = tensorflow::Scope::DisabledShapeInferenceScope();
+  Output constant_a = ops::Const(s.WithOpName("constant_a"), 1.0f, {1});
+  Output constant_b = ops::Const(s.WithOpName("constant_b"), 1, {1});
+  Output var1 = ops::Variable(s.WithOpName("var1"), {1}, DT_FLOAT);
+  Output var2 = ops::Variable(s.WithOpName("var2"), {1}, DT_FLOAT);
+  Output assign1 = ops::Assign(s.WithOpName("assign1"), {var1}, {constant_a});
+  Output assign2 = ops::Assign(s.WithOpName("assign2"), {var2}, {constant_a});
+  Output fifo_queue = ops::FIFOQueue(s.WithOpName("fifo_queue"), {DT_FLOAT});
+  auto dequeue = ops::QueueDequeueMany(s.WithOpName("dequeue"), {fifo_queue},
+                                       {constant_b}, {DT_FLOAT});
+  Output layer1 = ops::Mul(s.WithOpName("layer1"), dequeue[0], var1);
+  Output layer2 = ops::Mul(s.WithOpName("layer2"), layer1, var2);
+  Output grad2 =
+      ops::Mul(s.WithOpName("gradients/layer2_grad/Mul"), layer2, layer1);
+  Output grad1 =
+      ops::Mul(s.WithOpName("gradients/layer1_grad/Mul"), grad2, var2);
+  Output learning_rate = ops::Const(s.WithOpName("learning_rate"), 0.01f, {1});
+  Output apply1 = ops::ApplyGradientDescent(s.WithOpName("apply1"), {var1},
+                                            {learning_rate}, {grad1});
+  Output apply2 = ops::ApplyGradientDescent(s.WithOpName("apply2"), {var2},
+                                            {learning_rate}, {grad2});
+
+  GrapplerItem item;
+  item.init_ops.push_back("assign1");
+  item.init_ops.push_back("assign2");
+  item.fetch.push_back("apply1");
+  item.fetch.push_back("apply2");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  DeviceProperties gpu_device;
+  gpu_device.set_type("GPU");
+  gpu_device.set_frequency(1000);
+  gpu_device.set_num_cores(24);
+  gpu_device.set_bandwidth(128);
+  (*gpu_device.mutable_environment())["architecture"] = "6";
+  std::unordered_map<string, DeviceProperties> devices;
+  devices["/job:localhost/replica:0/task:0/gpu:0"] = gpu_device;
+  devices["/job:localhost/replica:0/task:0/gpu:1"] = gpu_device;
+  VirtualCluster cluster(devices);
+
+  AutoParallel parallel(2, 2);
+  GraphDef output;
+  Status status = parallel.Optimize(&cluster, item, &output);
+  TF_EXPECT_OK(status);
+
+  std::map<string, const NodeDef*> nodes;
+  for (const auto& node : output.node()) {
+    nodes[node.name()] = &node;
+  }
+  const string gpu0 = "/job:localhost/replica:0/task:0/gpu:0";
+  const string gpu1 = "/job:localhost/replica:0/task:0/gpu:1";
+  for (int i = 0; i < 2; i++) {
+    const string prefix = strings::StrCat("AutoParallel-Replica-", i, "/");
+    ASSERT_EQ(1, nodes.count(prefix + "dequeue"));
+    EXPECT_EQ(gpu0, nodes[prefix + "dequeue"]->device());
+    // The backward nodes run on the stage of their forward nodes.
+    EXPECT_EQ(nodes[prefix + "layer1"]->device(),
+              nodes[prefix + "gradients/layer1_grad/Mul"]->device());
+    EXPECT_EQ(nodes[prefix + "layer2"]->device(),
+              nodes[prefix + "gradients/layer2_grad/Mul"]->device());
+    // The micro-batches share the apply gradients nodes.
+    EXPECT_EQ(0, nodes.count(prefix + "apply1"));
+  }
+  EXPECT_EQ(nodes["AutoParallel-Replica-0/layer1"]->device(),
+            nodes["AutoParallel-Replica-1/layer1"]->device());
+  EXPECT_EQ(gpu1, nodes["AutoParallel-Replica-0/layer2"]->device());
+
+  // The variables are placed with the first stage that reads them.
+  EXPECT_EQ(nodes["AutoParallel-Replica-0/layer1"]->device(),
+            nodes["var1"]->device());
+  EXPECT_EQ(nodes["var1"]->device(), nodes["apply1"]->device());
+  EXPECT_EQ(nodes["var1"]->device(), nodes["assign1"]->device());
+
+  ASSERT_EQ(1, nodes.count("AutoParallel-Accumulate-apply1"));
+  const NodeDef* sum = nodes["AutoParallel-Accumulate-apply1"];
+  EXPECT_EQ("AddN", sum->op());
+  ASSERT_EQ(2, sum->input_size());
+  EXPECT_EQ("AutoParallel-Replica-0/AutoParallel-Div-apply1", sum->input(0));
+  EXPECT_EQ("AutoParallel-Replica-1/AutoParallel-Div-apply1", sum->input(1));
+  EXPECT_EQ("AutoParallel-Accumulate-apply1", nodes["apply1"]->input(2));
+
+  // The shared fetch nodes are fetched as they are.
+  const NodeDef* fetch = nodes["AutoParallel-Control-Fetch"];
+  ASSERT_EQ(2, fetch->input_size());
+  EXPECT_EQ("^apply1", fetch->input(0));
+  EXPECT_EQ("^apply2", fetch->input(1));
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
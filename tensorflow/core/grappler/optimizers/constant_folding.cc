@@ -872,12 +872,13 @@ Status ConstantFolding::RunOptimizationPass(Cluster* cluster,
   }
 
   GraphProperties properties(item);
-  bool has_feed = !item.feed.empty();
+  bool has_feed = !item.feed.empty() && !item.static_feed_shapes;
   if (!has_feed) {
     // Only use static shape information when there is no feed in the
-    // graph. That's because it's possible to feed a placeholder with a tensor
-    // of any shape, which could make the static information inconsistent with
-    // the shapes actually fed.
+    // graph, unless the fed shapes are known to be static. That's because
+    // it's possible to feed a placeholder with a tensor of any shape, which
+    // could make the static information inconsistent with the shapes actually
+    // fed.
     Status s = properties.InferStatically();
     if (!s.ok()) {
       VLOG(1) << "Failed to infer graph shapes: " << s;
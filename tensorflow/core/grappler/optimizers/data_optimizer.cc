@@ -0,0 +1,441 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/core/grappler/optimizers/data_optimizer.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// The buffer size that makes a PrefetchDataset tune its buffer.
+const int64 kAutoTuneBufferSize = -1;
+
+bool IsMap(const NodeDef& node) {
+  return node.op() == "MapDataset" || node.op() == "ParallelMapDataset";
+}
+
+// The types of the captured arguments of the function of a map.
+AttrValue GetCapturedTypes(const NodeDef& map) {
+  auto it = map.attr().find("Targuments");
+  if (it != map.attr().end()) {
+    return it->second;
+  }
+  AttrValue types;
+  types.mutable_list();
+  return types;
+}
+
+int NumCapturedArguments(const NodeDef& map) {
+  return GetCapturedTypes(map).list().type_size();
+}
+
+// The control inputs of "node", which all follow its data inputs.
+std::vector<string> ControlInputs(const NodeDef& node) {
+  std::vector<string> inputs;
+  for (const string& input : node.input()) {
+    if (IsControlInput(input)) {
+      inputs.push_back(input);
+    }
+  }
+  return inputs;
+}
+
+// The function of a map, or nullptr if it is not in "library" or is
+// polymorphic.
+const FunctionDef* GetMapFunction(const FunctionLibraryDefinition& library,
+                                  const NodeDef& map) {
+  auto it = map.attr().find("f");
+  if (it == map.attr().end() || it->second.func().attr_size() > 0) {
+    return nullptr;
+  }
+  const FunctionDef* func = library.Find(it->second.func().name());
+  if (func == nullptr || func->signature().attr_size() > 0) {
+    return nullptr;
+  }
+  return func;
+}
+
+// Whether running "func" concurrently, or fewer times than it was called
+// for, cannot be observed: none of the ops it runs, including the ones of
+// the functions it calls, has side effects.
+bool IsStateless(const FunctionLibraryDefinition& library,
+                 const FunctionDef& func,
+                 std::unordered_set<string>* visited) {
+  if (!visited->insert(func.signature().name()).second) {
+    return true;
+  }
+  for (const NodeDef& node : func.node_def()) {
+    const OpRegistrationData* op_data;
+    if (!library.LookUp(node.op(), &op_data).ok() ||
+        op_data->op_def.is_stateful()) {
+      return false;
+    }
+    const FunctionDef* called = library.Find(node.op());
+    if (called != nullptr && !IsStateless(library, *called, visited)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IsStateless(const FunctionLibraryDefinition& library,
+                 const FunctionDef& func) {
+  std::unordered_set<string> visited;
+  return IsStateless(library, func, &visited);
+}
+
+// Whether the arguments and results of "func" all have a single fixed type.
+bool HasFixedTypes(const FunctionDef& func) {
+  for (const auto* args :
+       {&func.signature().input_arg(), &func.signature().output_arg()}) {
+    for (const OpDef::ArgDef& arg : *args) {
+      if (arg.type() == DT_INVALID || !arg.number_attr().empty() ||
+          !arg.type_list_attr().empty() || arg.is_ref()) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Builds the function of the map of the results of "first" by "second",
+// whose arguments are the arguments of "first" followed by the captured
+// arguments of "second".
+bool FuseFunctions(const FunctionLibraryDefinition& library,
+                   const FunctionDef& first, const FunctionDef& second,
+                   int num_second_captured, FunctionDef* fused) {
+  const OpDef& first_signature = first.signature();
+  const OpDef& second_signature = second.signature();
+  if (!HasFixedTypes(first) || !HasFixedTypes(second) ||
+      second_signature.input_arg_size() !=
+          first_signature.output_arg_size() + num_second_captured) {
+    return false;
+  }
+  for (int i = 0; i < first_signature.output_arg_size(); ++i) {
+    if (first_signature.output_arg(i).type() !=
+        second_signature.input_arg(i).type()) {
+      return false;
+    }
+  }
+
+  string name =
+      strings::StrCat(first_signature.name(), "_", second_signature.name());
+  for (int i = 1; library.Find(name) != nullptr; ++i) {
+    name = strings::StrCat(first_signature.name(), "_", second_signature.name(),
+                           "_", i);
+  }
+  OpDef* signature = fused->mutable_signature();
+  signature->set_name(name);
+  NodeDef* first_call = fused->add_node_def();
+  first_call->set_name("first");
+  first_call->set_op(first_signature.name());
+  NodeDef* second_call = fused->add_node_def();
+  second_call->set_name("second");
+  second_call->set_op(second_signature.name());
+
+  const auto add_arg = [signature](const OpDef::ArgDef& arg) {
+    OpDef::ArgDef* fused_arg = signature->add_input_arg();
+    fused_arg->set_name(
+        strings::StrCat("arg", signature->input_arg_size() - 1));
+    fused_arg->set_type(arg.type());
+    return fused_arg->name();
+  };
+  for (const OpDef::ArgDef& arg : first_signature.input_arg()) {
+    first_call->add_input(add_arg(arg));
+  }
+  for (const OpDef::ArgDef& arg : first_signature.output_arg()) {
+    second_call->add_input(strings::StrCat("first:", arg.name(), ":0"));
+  }
+  for (int i = first_signature.output_arg_size();
+       i < second_signature.input_arg_size(); ++i) {
+    second_call->add_input(add_arg(second_signature.input_arg(i)));
+  }
+  for (const OpDef::ArgDef& arg : second_signature.output_arg()) {
+    OpDef::ArgDef* fused_arg = signature->add_output_arg();
+    *fused_arg = arg;
+    (*fused->mutable_ret())[arg.name()] =
+        strings::StrCat("second:", arg.name(), ":0");
+  }
+  return true;
+}
+
+}  // namespace
+
+bool DataOptimizer::CanMerge(const NodeDef& input, const NodeDef& node) const {
+  const std::set<NodeDef*>& outputs = node_map_->GetOutputs(input.name());
+  return nodes_to_delete_.count(input.name()) == 0 &&
+         nodes_to_preserve_.count(input.name()) == 0 &&
+         input.device() == node.device() && outputs.size() == 1 &&
+         *outputs.begin() == &node;
+}
+
+void DataOptimizer::MergeInput(NodeDef* input, NodeDef* node) {
+  node_map_->RemoveOutput(input->name(), node->name());
+  for (const string& input_input : input->input()) {
+    node_map_->RemoveOutput(NodeName(input_input), input->name());
+    node_map_->AddOutput(NodeName(input_input), node->name());
+  }
+  nodes_to_delete_.insert(input->name());
+}
+
+NodeDef* DataOptimizer::AddScalarConst(const string& name, DataType dtype,
+                                       int64 value, const string& device) {
+  NodeDef* node = graph_->add_node();
+  node->set_name(name);
+  node->set_op("Const");
+  node->set_device(device);
+  (*node->mutable_attr())["dtype"].set_type(dtype);
+  Tensor tensor(dtype, TensorShape({}));
+  if (dtype == DT_INT32) {
+    tensor.scalar<int32>()() = value;
+  } else {
+    tensor.scalar<int64>()() = value;
+  }
+  tensor.AsProtoTensorContent(
+      (*node->mutable_attr())["value"].mutable_tensor());
+  node_map_->AddNode(name, node);
+  return node;
+}
+
+Status DataOptimizer::FuseMaps(FunctionLibraryDefinition* library) {
+  for (int i = 0; i < graph_->node_size(); ++i) {
+    NodeDef* map = graph_->mutable_node(i);
+    if (map->op() != "MapDataset" || nodes_to_delete_.count(map->name())) {
+      continue;
+    }
+    while (map->input_size() > 0) {
+      NodeDef* input = node_map_->GetNode(map->input(0));
+      if (input == nullptr || input->op() != "MapDataset" ||
+          !CanMerge(*input, *map)) {
+        break;
+      }
+      const FunctionDef* first = GetMapFunction(*library, *input);
+      const FunctionDef* second = GetMapFunction(*library, *map);
+      const int num_first_captured = NumCapturedArguments(*input);
+      const int num_second_captured = NumCapturedArguments(*map);
+      FunctionDef fused;
+      if (first == nullptr || second == nullptr ||
+          input->input_size() < 1 + num_first_captured ||
+          map->input_size() < 1 + num_second_captured ||
+          !FuseFunctions(*library, *first, *second, num_second_captured,
+                         &fused)) {
+        break;
+      }
+      VLOG(2) << "Fusing maps " << input->name() << " and " << map->name();
+      TF_RETURN_IF_ERROR(library->AddFunctionDef(fused));
+      *graph_->mutable_library()->add_function() = fused;
+
+      std::vector<string> inputs(input->input().begin(),
+                                 input->input().begin() + 1 +
+                                     num_first_captured);
+      inputs.insert(inputs.end(), map->input().begin() + 1,
+                    map->input().begin() + 1 + num_second_captured);
+      for (const NodeDef* node : std::vector<const NodeDef*>({input, map})) {
+        for (const string& control_input : ControlInputs(*node)) {
+          inputs.push_back(control_input);
+        }
+      }
+      map->clear_input();
+      for (const string& new_input : inputs) {
+        map->add_input(new_input);
+      }
+      (*map->mutable_attr())["f"].mutable_func()->set_name(
+          fused.signature().name());
+      AttrValue types = GetCapturedTypes(*input);
+      types.mutable_list()->MergeFrom(GetCapturedTypes(*map).list());
+      (*map->mutable_attr())["Targuments"] = types;
+      MergeInput(input, map);
+    }
+  }
+  return Status::OK();
+}
+
+void DataOptimizer::FuseMapsAndBatches(
+    const FunctionLibraryDefinition& library) {
+  const int num_nodes = graph_->node_size();
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* batch = graph_->mutable_node(i);
+    if (batch->op() != "BatchDataset" || batch->input_size() < 2 ||
+        nodes_to_delete_.count(batch->name()) > 0) {
+      continue;
+    }
+    NodeDef* map = node_map_->GetNode(batch->input(0));
+    if (map == nullptr || !IsMap(*map) || !CanMerge(*map, *batch)) {
+      continue;
+    }
+    const FunctionDef* func = GetMapFunction(library, *map);
+    const int num_captured = NumCapturedArguments(*map);
+    if (func == nullptr || !IsStateless(library, *func) ||
+        map->input_size() < 1 + num_captured) {
+      continue;
+    }
+    const string num_parallel_batches =
+        strings::StrCat(batch->name(), "/num_parallel_batches");
+    if (node_map_->GetNode(num_parallel_batches) != nullptr) {
+      continue;
+    }
+    VLOG(2) << "Fusing " << map->name() << " and " << batch->name();
+    AddScalarConst(num_parallel_batches, DT_INT64, 1, batch->device());
+
+    std::vector<string> inputs(map->input().begin(),
+                               map->input().begin() + 1 + num_captured);
+    inputs.push_back(batch->input(1));
+    inputs.push_back(num_parallel_batches);
+    for (const NodeDef* node : std::vector<const NodeDef*>({map, batch})) {
+      for (const string& control_input : ControlInputs(*node)) {
+        inputs.push_back(control_input);
+      }
+    }
+    batch->clear_input();
+    for (const string& input : inputs) {
+      batch->add_input(input);
+    }
+    batch->set_op("MapAndBatchDataset");
+    (*batch->mutable_attr())["f"] = map->attr().at("f");
+    (*batch->mutable_attr())["Targuments"] = GetCapturedTypes(*map);
+    node_map_->AddOutput(num_parallel_batches, batch->name());
+    MergeInput(map, batch);
+  }
+}
+
+void DataOptimizer::ParallelizeMaps(const FunctionLibraryDefinition& library) {
+  const int num_nodes = graph_->node_size();
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* map = graph_->mutable_node(i);
+    const int num_captured = NumCapturedArguments(*map);
+    if (map->op() != "MapDataset" || nodes_to_delete_.count(map->name()) > 0 ||
+        map->input_size() < 1 + num_captured) {
+      continue;
+    }
+    const FunctionDef* func = GetMapFunction(library, *map);
+    const string num_parallel_calls =
+        strings::StrCat(map->name(), "/num_parallel_calls");
+    if (func == nullptr || !IsStateless(library, *func) ||
+        node_map_->GetNode(num_parallel_calls) != nullptr) {
+      continue;
+    }
+    VLOG(2) << "Parallelizing " << map->name();
+    AddScalarConst(num_parallel_calls, DT_INT32, port::NumSchedulableCPUs(),
+                   map->device());
+    // The number of parallel calls follows the captured arguments.
+    map->add_input(num_parallel_calls);
+    for (int j = map->input_size() - 1; j > 1 + num_captured; --j) {
+      map->mutable_input()->SwapElements(j, j - 1);
+    }
+    map->set_op("ParallelMapDataset");
+    node_map_->AddOutput(num_parallel_calls, map->name());
+  }
+}
+
+void DataOptimizer::AddPrefetches() {
+  const int num_nodes = graph_->node_size();
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* make_iterator = graph_->mutable_node(i);
+    if (make_iterator->op() != "MakeIterator" ||
+        make_iterator->input_size() < 1) {
+      continue;
+    }
+    const NodeDef* dataset = node_map_->GetNode(make_iterator->input(0));
+    if (dataset == nullptr || dataset->op() == "PrefetchDataset" ||
+        dataset->attr().count("output_types") == 0 ||
+        dataset->attr().count("output_shapes") == 0) {
+      continue;
+    }
+    const string name = strings::StrCat(dataset->name(), "/prefetch");
+    const NodeDef* prefetch = node_map_->GetNode(name);
+    if (prefetch == nullptr) {
+      const string buffer_size = strings::StrCat(name, "/buffer_size");
+      if (node_map_->GetNode(buffer_size) != nullptr) {
+        continue;
+      }
+      VLOG(2) << "Prefetching " << dataset->name();
+      AddScalarConst(buffer_size, DT_INT64, kAutoTuneBufferSize,
+                     dataset->device());
+      NodeDef* new_prefetch = graph_->add_node();
+      new_prefetch->set_name(name);
+      new_prefetch->set_op("PrefetchDataset");
+      new_prefetch->set_device(dataset->device());
+      new_prefetch->add_input(make_iterator->input(0));
+      new_prefetch->add_input(buffer_size);
+      for (const string& attr : {"output_types", "output_shapes"}) {
+        (*new_prefetch->mutable_attr())[attr] = dataset->attr().at(attr);
+      }
+      node_map_->AddNode(name, new_prefetch);
+      node_map_->AddOutput(dataset->name(), name);
+      node_map_->AddOutput(buffer_size, name);
+      prefetch = new_prefetch;
+    } else if (prefetch->op() != "PrefetchDataset" ||
+               prefetch->input(0) != make_iterator->input(0)) {
+      continue;
+    }
+    node_map_->RemoveOutput(dataset->name(), make_iterator->name());
+    node_map_->AddOutput(name, make_iterator->name());
+    *make_iterator->mutable_input(0) = name;
+  }
+}
+
+Status DataOptimizer::Optimize(Cluster* /*cluster*/, const GrapplerItem& item,
+                               GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  graph_ = optimized_graph;
+  nodes_to_preserve_ = item.NodesToPreserve();
+  nodes_to_delete_.clear();
+  node_map_.reset(new NodeMap(optimized_graph));
+
+  FunctionLibraryDefinition library(OpRegistry::Global(),
+                                    optimized_graph->library());
+  TF_RETURN_IF_ERROR(FuseMaps(&library));
+  if (opt_level_ == RewriterConfig::AGGRESSIVE) {
+    FuseMapsAndBatches(library);
+  }
+  ParallelizeMaps(library);
+  AddPrefetches();
+
+  if (!nodes_to_delete_.empty()) {
+    int last = graph_->node_size() - 1;
+    for (int i = last; i >= 0; --i) {
+      if (nodes_to_delete_.count(graph_->node(i).name()) > 0) {
+        graph_->mutable_node()->SwapElements(i, last);
+        last--;
+      }
+    }
+    graph_->mutable_node()->DeleteSubrange(last + 1, nodes_to_delete_.size());
+  }
+  node_map_.reset();
+  return Status::OK();
+}
+
+void DataOptimizer::Feedback(Cluster* /*cluster*/, const GrapplerItem& /*item*/,
+                             const GraphDef& /*optimized_graph*/,
+                             double /*result*/) {
+  // Nothing to do for DataOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,79 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_DATA_OPTIMIZER_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_DATA_OPTIMIZER_H_
+
+#include <memory>
+#include <unordered_set>
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Rewrite the chains of dataset ops of the input pipelines into faster
+// equivalents:
+// - consecutive MapDatasets are fused into one, whose function calls the
+//   functions of both,
+// - MapDatasets whose functions are stateless become ParallelMapDatasets,
+// - the datasets that iterators are made from are prefetched, with a buffer
+//   that grows with the demand of their consumers.
+// In AGGRESSIVE mode, the maps with stateless functions that are followed by
+// a BatchDataset are also fused with it into a MapAndBatchDataset, which
+// drops the final batch if it is incomplete.
+class DataOptimizer : public GraphOptimizer {
+ public:
+  DataOptimizer() : opt_level_(RewriterConfig::ON) {}
+  explicit DataOptimizer(RewriterConfig::Toggle opt_level)
+      : opt_level_(opt_level) {}
+  ~DataOptimizer() override {}
+
+  string name() const override { return "data_optimizer"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+
+ private:
+  Status FuseMaps(FunctionLibraryDefinition* library);
+  void FuseMapsAndBatches(const FunctionLibraryDefinition& library);
+  void ParallelizeMaps(const FunctionLibraryDefinition& library);
+  void AddPrefetches();
+
+  // Whether "node" is the only consumer of "input", which can therefore be
+  // merged into it.
+  bool CanMerge(const NodeDef& input, const NodeDef& node) const;
+  // Moves the inputs of "input" to "node", and deletes it.
+  void MergeInput(NodeDef* input, NodeDef* node);
+  NodeDef* AddScalarConst(const string& name, DataType dtype, int64 value,
+                          const string& device);
+
+  RewriterConfig::Toggle opt_level_;
+  std::unordered_set<string> nodes_to_preserve_;
+  std::unordered_set<string> nodes_to_delete_;
+  GraphDef* graph_;
+  std::unique_ptr<NodeMap> node_map_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_DATA_OPTIMIZER_H_
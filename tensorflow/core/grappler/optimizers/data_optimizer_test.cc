@@ -0,0 +1,218 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/core/grappler/optimizers/data_optimizer.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using FDH = FunctionDefHelper;
+
+class DataOptimizerTest : public ::testing::Test {
+ protected:
+  static FunctionDef AddOne() {
+    const Tensor kOne = test::AsScalar<int64>(1);
+    return FDH::Define(
+        "AddOne", {"x: int64"}, {"y: int64"}, {},
+        {{{"one"}, "Const", {}, {{"value", kOne}, {"dtype", DT_INT64}}},
+         {{"y"}, "Add", {"x", "one"}, {{"T", DT_INT64}}}});
+  }
+
+  static FunctionDef TimesTwo() {
+    const Tensor kTwo = test::AsScalar<int64>(2);
+    return FDH::Define(
+        "TimesTwo", {"x: int64"}, {"y: int64"}, {},
+        {{{"two"}, "Const", {}, {{"value", kTwo}, {"dtype", DT_INT64}}},
+         {{"y"}, "Mul", {"x", "two"}, {{"T", DT_INT64}}}});
+  }
+
+  static FunctionDef AddNoise() {
+    const Tensor kShape = test::AsTensor<int32>({1});
+    return FDH::Define(
+        "AddNoise", {"x: int64"}, {"y: int64"}, {},
+        {{{"shape"}, "Const", {}, {{"value", kShape}, {"dtype", DT_INT32}}},
+         {{"noise"},
+          "RandomUniformInt",
+          {"shape", "x", "x"},
+          {{"T", DT_INT32}, {"Tout", DT_INT64}}},
+         {{"y"}, "Add", {"x", "noise"}, {{"T", DT_INT64}}}});
+  }
+
+  static NodeDef Scalar(const string& name, int64 value) {
+    return test::function::NDef(
+        name, "Const", {},
+        {{"value", test::AsScalar<int64>(value)}, {"dtype", DT_INT64}});
+  }
+
+  // Adds a dataset of scalar int64 elements.
+  static NodeDef* AddDataset(const string& name, const string& op,
+                             const std::vector<string>& inputs,
+                             GraphDef* graph) {
+    NodeDef* node = graph->add_node();
+    node->set_name(name);
+    node->set_op(op);
+    for (const string& input : inputs) {
+      node->add_input(input);
+    }
+    SetAttrValue(gtl::ArraySlice<DataType>({DT_INT64}),
+                 &(*node->mutable_attr())["output_types"]);
+    SetAttrValue(gtl::ArraySlice<TensorShape>({TensorShape({})}),
+                 &(*node->mutable_attr())["output_shapes"]);
+    return node;
+  }
+
+  static NodeDef* AddMap(const string& name, const string& input,
+                         const string& func, GraphDef* graph) {
+    NodeDef* node = AddDataset(name, "MapDataset", {input}, graph);
+    (*node->mutable_attr())["f"].mutable_func()->set_name(func);
+    (*node->mutable_attr())["Targuments"].mutable_list();
+    return node;
+  }
+
+  // A pipeline of the range [0, 10) that an iterator is made from.
+  static GrapplerItem Pipeline(
+      const std::vector<std::pair<string, string>>& maps,
+      bool batch = false) {
+    GrapplerItem item;
+    item.graph = test::function::GDef(
+        {Scalar("start", 0), Scalar("stop", 10), Scalar("step", 1)},
+        {AddOne(), TimesTwo(), AddNoise()});
+    AddDataset("range", "RangeDataset", {"start", "stop", "step"},
+               &item.graph);
+    string last = "range";
+    for (const auto& map : maps) {
+      AddMap(map.first, last, map.second, &item.graph);
+      last = map.first;
+    }
+    if (batch) {
+      *item.graph.add_node() = Scalar("batch_size", 4);
+      AddDataset("batch", "BatchDataset", {last, "batch_size"}, &item.graph);
+      last = "batch";
+    }
+    *item.graph.add_node() = test::function::NDef(
+        "iterator", "Iterator", {},
+        {{"shared_name", ""},
+         {"container", ""},
+         {"output_types", gtl::ArraySlice<DataType>({DT_INT64})},
+         {"output_shapes", gtl::ArraySlice<TensorShape>({TensorShape({})})}});
+    *item.graph.add_node() = test::function::NDef(
+        "make_iterator", "MakeIterator", {last, "iterator"}, {});
+    item.fetch = {"make_iterator"};
+    return item;
+  }
+
+  static const NodeDef* FindNode(const GraphDef& graph, const string& name) {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() == name) return &node;
+    }
+    return nullptr;
+  }
+
+  static std::vector<string> Inputs(const GraphDef& graph,
+                                    const string& name) {
+    const NodeDef* node = FindNode(graph, name);
+    if (node == nullptr) return {"not found"};
+    return std::vector<string>(node->input().begin(), node->input().end());
+  }
+};
+
+TEST_F(DataOptimizerTest, FusesAndParallelizesMaps) {
+  GrapplerItem item = Pipeline({{"map1", "AddOne"}, {"map2", "TimesTwo"}});
+  DataOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(nullptr, FindNode(output, "map1"));
+  const NodeDef* map = FindNode(output, "map2");
+  ASSERT_NE(nullptr, map);
+  EXPECT_EQ("ParallelMapDataset", map->op());
+  EXPECT_EQ(std::vector<string>({"range", "map2/num_parallel_calls"}),
+            Inputs(output, "map2"));
+  EXPECT_EQ("AddOne_TimesTwo", map->attr().at("f").func().name());
+
+  ASSERT_EQ(4, output.library().function_size());
+  const FunctionDef& fused = output.library().function(3);
+  EXPECT_EQ("AddOne_TimesTwo", fused.signature().name());
+  ASSERT_EQ(2, fused.node_def_size());
+  EXPECT_EQ("AddOne", fused.node_def(0).op());
+  EXPECT_EQ("TimesTwo", fused.node_def(1).op());
+  EXPECT_EQ("first:y:0", fused.node_def(1).input(0));
+  EXPECT_EQ("second:y:0", fused.ret().at("y"));
+
+  // The iterator is made from a prefetch of the pipeline.
+  EXPECT_EQ(std::vector<string>({"map2/prefetch", "iterator"}),
+            Inputs(output, "make_iterator"));
+  const NodeDef* prefetch = FindNode(output, "map2/prefetch");
+  ASSERT_NE(nullptr, prefetch);
+  EXPECT_EQ("PrefetchDataset", prefetch->op());
+  EXPECT_EQ(std::vector<string>({"map2", "map2/prefetch/buffer_size"}),
+            Inputs(output, "map2/prefetch"));
+  Tensor buffer_size;
+  ASSERT_TRUE(buffer_size.FromProto(FindNode(output,
+                                             "map2/prefetch/buffer_size")
+                                        ->attr()
+                                        .at("value")
+                                        .tensor()));
+  EXPECT_EQ(-1, buffer_size.scalar<int64>()());
+}
+
+TEST_F(DataOptimizerTest, KeepsStatefulMapsSequential) {
+  GrapplerItem item = Pipeline({{"map", "AddNoise"}});
+  DataOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ("MapDataset", FindNode(output, "map")->op());
+  EXPECT_EQ(std::vector<string>({"range"}), Inputs(output, "map"));
+  EXPECT_EQ(3, output.library().function_size());
+  EXPECT_EQ(std::vector<string>({"map/prefetch", "iterator"}),
+            Inputs(output, "make_iterator"));
+}
+
+TEST_F(DataOptimizerTest, FusesMapAndBatchWhenAggressive) {
+  GrapplerItem item = Pipeline({{"map", "AddOne"}}, true /* batch */);
+  DataOptimizer optimizer(RewriterConfig::AGGRESSIVE);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(nullptr, FindNode(output, "map"));
+  const NodeDef* batch = FindNode(output, "batch");
+  ASSERT_NE(nullptr, batch);
+  EXPECT_EQ("MapAndBatchDataset", batch->op());
+  EXPECT_EQ(std::vector<string>(
+                {"range", "batch_size", "batch/num_parallel_batches"}),
+            Inputs(output, "batch"));
+  EXPECT_EQ("AddOne", batch->attr().at("f").func().name());
+
+  // Not by default, since the fused dataset drops an incomplete last batch.
+  DataOptimizer default_optimizer;
+  TF_EXPECT_OK(default_optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ("BatchDataset", FindNode(output, "batch")->op());
+  EXPECT_EQ("ParallelMapDataset", FindNode(output, "map")->op());
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
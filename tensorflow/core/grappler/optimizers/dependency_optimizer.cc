@@ -0,0 +1,331 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/dependency_optimizer.h"
+
+#include <algorithm>
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Returns true if one of the inputs of `node`, data or control, comes from
+// the node named `name`.
+bool HasInputFrom(const NodeDef& node, const string& name) {
+  for (const string& input : node.input()) {
+    if (NodeName(input) == name) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void RemoveControlInput(NodeDef* node, const string& name) {
+  const string control_input = AsControlDependency(name);
+  for (int i = node->input_size() - 1; i >= 0; --i) {
+    if (node->input(i) == control_input) {
+      node->mutable_input()->SwapElements(i, node->input_size() - 1);
+      node->mutable_input()->RemoveLast();
+    }
+  }
+}
+
+}  // namespace
+
+void DependencyOptimizer::ConvertControlOnlyIdentities(
+    GraphDef* optimized_graph, NodeMap* node_map) const {
+  for (int i = 0; i < optimized_graph->node_size(); ++i) {
+    NodeDef* node = optimized_graph->mutable_node(i);
+    if (node->op() != "Identity" || node->input_size() == 0 ||
+        IsControlInput(node->input(0)) ||
+        nodes_to_preserve_.find(node->name()) != nodes_to_preserve_.end()) {
+      continue;
+    }
+    const NodeDef* input = node_map->GetNode(node->input(0));
+    // The outputs of a Switch may be dead while the Switch itself is not, so
+    // a control edge from the Switch would not carry the deadness of the
+    // output that the Identity reads.
+    if (input == nullptr || IsSwitch(*input)) {
+      continue;
+    }
+    const std::set<NodeDef*>& outputs = node_map->GetOutputs(node->name());
+    if (outputs.empty()) {
+      continue;
+    }
+    bool control_only = true;
+    for (const NodeDef* output : outputs) {
+      for (const string& output_input : output->input()) {
+        if (!IsControlInput(output_input) &&
+            NodeName(output_input) == node->name()) {
+          control_only = false;
+          break;
+        }
+      }
+      if (!control_only) {
+        break;
+      }
+    }
+    if (!control_only) {
+      continue;
+    }
+
+    VLOG(1) << "Converting " << node->name() << " to a NoOp";
+    node->set_op("NoOp");
+    const string control_input = AsControlDependency(input->name());
+    *node->mutable_input(0) = control_input;
+    for (int j = node->input_size() - 1; j > 0; --j) {
+      if (node->input(j) == control_input) {
+        node->mutable_input()->DeleteSubrange(j, 1);
+      }
+    }
+    std::vector<string> attrs;
+    for (const auto& attr : node->attr()) {
+      if (!StringPiece(attr.first).starts_with("_")) {
+        attrs.push_back(attr.first);
+      }
+    }
+    for (const string& attr : attrs) {
+      node->mutable_attr()->erase(attr);
+    }
+  }
+}
+
+void DependencyOptimizer::BypassNoOps(
+    GraphDef* optimized_graph, NodeMap* node_map,
+    std::unordered_set<string>* nodes_to_delete) const {
+  for (int i = 0; i < optimized_graph->node_size(); ++i) {
+    NodeDef* node = optimized_graph->mutable_node(i);
+    if (!IsNoOp(*node) ||
+        nodes_to_preserve_.find(node->name()) != nodes_to_preserve_.end()) {
+      continue;
+    }
+    std::vector<NodeDef*> inputs;
+    bool control_only = true;
+    for (const string& input : node->input()) {
+      NodeDef* input_node = node_map->GetNode(input);
+      if (!IsControlInput(input) || input_node == nullptr) {
+        control_only = false;
+        break;
+      }
+      inputs.push_back(input_node);
+    }
+    if (!control_only) {
+      continue;
+    }
+    const std::vector<NodeDef*> outputs(
+        node_map->GetOutputs(node->name()).begin(),
+        node_map->GetOutputs(node->name()).end());
+    // Only bypass the NoOp if that does not add edges, nor edges between
+    // devices, which each need a Send and a Recv.
+    const size_t num_fanins = inputs.size();
+    const size_t num_fanouts = outputs.size();
+    if (num_fanins * num_fanouts > num_fanins + num_fanouts) {
+      continue;
+    }
+    int num_cross_device_edges = 0;
+    int num_new_cross_device_edges = 0;
+    bool is_cycle = false;
+    for (const NodeDef* input : inputs) {
+      num_cross_device_edges += input->device() != node->device();
+      for (const NodeDef* output : outputs) {
+        num_new_cross_device_edges += input->device() != output->device();
+        is_cycle |= input == output;
+      }
+    }
+    for (const NodeDef* output : outputs) {
+      num_cross_device_edges += output->device() != node->device();
+    }
+    if (is_cycle || num_new_cross_device_edges > num_cross_device_edges) {
+      continue;
+    }
+
+    VLOG(1) << "Bypassing " << node->name() << " with " << num_fanins
+            << " inputs and " << num_fanouts << " outputs";
+    for (NodeDef* output : outputs) {
+      RemoveControlInput(output, node->name());
+      node_map->RemoveOutput(node->name(), output->name());
+      for (const NodeDef* input : inputs) {
+        if (!HasInputFrom(*output, input->name())) {
+          output->add_input(AsControlDependency(input->name()));
+          node_map->AddOutput(input->name(), output->name());
+        }
+      }
+    }
+    for (const NodeDef* input : inputs) {
+      node_map->RemoveOutput(input->name(), node->name());
+    }
+    node->clear_input();
+    nodes_to_delete->insert(node->name());
+  }
+}
+
+void DependencyOptimizer::TransitiveReduction(
+    GraphDef* optimized_graph) const {
+  const int num_nodes = optimized_graph->node_size();
+  std::unordered_map<string, int> indices;
+  for (int i = 0; i < num_nodes; ++i) {
+    indices[optimized_graph->node(i).name()] = i;
+  }
+  // The edges of the graph except the back edges of the loops, by their
+  // destination and by their source.
+  std::vector<std::vector<int>> fanins(num_nodes);
+  std::vector<std::vector<int>> fanouts(num_nodes);
+  // The nodes that have a control edge from each node.
+  std::vector<std::vector<int>> control_fanouts(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    const NodeDef& node = optimized_graph->node(i);
+    for (const string& input : node.input()) {
+      auto it = indices.find(NodeName(input));
+      if (it == indices.end()) {
+        return;
+      }
+      const int source = it->second;
+      if (IsNextIteration(optimized_graph->node(source))) {
+        continue;
+      }
+      fanins[i].push_back(source);
+      fanouts[source].push_back(i);
+      if (IsControlInput(input)) {
+        control_fanouts[source].push_back(i);
+      }
+    }
+  }
+
+  // Kahn's algorithm, which also checks that the graph is acyclic.
+  std::vector<int> num_ready_inputs(num_nodes, 0);
+  std::deque<int> ready;
+  std::vector<int> order;
+  order.reserve(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    if (fanins[i].empty()) {
+      ready.push_back(i);
+    }
+  }
+  while (!ready.empty()) {
+    const int node = ready.front();
+    ready.pop_front();
+    order.push_back(node);
+    for (int fanout : fanouts[node]) {
+      if (++num_ready_inputs[fanout] ==
+          static_cast<int>(fanins[fanout].size())) {
+        ready.push_back(fanout);
+      }
+    }
+  }
+  if (static_cast<int>(order.size()) != num_nodes) {
+    LOG(WARNING) << "The graph couldn't be sorted in topological order.";
+    return;
+  }
+  std::vector<int> positions(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    positions[order[i]] = i;
+  }
+
+  // For each source of control edges, computes the longest paths from it to
+  // the nodes up to its last control output, and removes the control edges
+  // that are not the only path to their destination. The paths do not go
+  // through Merge nodes, which are alive when some of their inputs are dead.
+  std::vector<int> distances(num_nodes, -1);
+  int num_removed = 0;
+  for (int source = 0; source < num_nodes; ++source) {
+    if (control_fanouts[source].empty()) {
+      continue;
+    }
+    int last = positions[source];
+    for (int target : control_fanouts[source]) {
+      last = std::max(last, positions[target]);
+    }
+    distances[source] = 0;
+    for (int p = positions[source] + 1; p <= last; ++p) {
+      const int node = order[p];
+      for (int fanin : fanins[node]) {
+        if (distances[fanin] >= 0 &&
+            (fanin == source || !IsMerge(optimized_graph->node(fanin)))) {
+          distances[node] = std::max(distances[node], distances[fanin] + 1);
+        }
+      }
+    }
+    const string& source_name = optimized_graph->node(source).name();
+    for (int target : control_fanouts[source]) {
+      NodeDef* node = optimized_graph->mutable_node(target);
+      bool has_data_input = false;
+      for (const string& input : node->input()) {
+        has_data_input |=
+            !IsControlInput(input) && NodeName(input) == source_name;
+      }
+      if (distances[target] > 1 || has_data_input) {
+        RemoveControlInput(node, source_name);
+        ++num_removed;
+      }
+    }
+    for (int p = positions[source]; p <= last; ++p) {
+      distances[order[p]] = -1;
+    }
+  }
+  VLOG(1) << "Removed " << num_removed << " redundant control edges";
+}
+
+Status DependencyOptimizer::Optimize(Cluster* /*cluster*/,
+                                     const GrapplerItem& item,
+                                     GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  nodes_to_preserve_ = item.NodesToPreserve();
+
+  {
+    NodeMap node_map(optimized_graph);
+    ConvertControlOnlyIdentities(optimized_graph, &node_map);
+    std::unordered_set<string> nodes_to_delete;
+    BypassNoOps(optimized_graph, &node_map, &nodes_to_delete);
+    if (!nodes_to_delete.empty()) {
+      int last = 0;
+      for (int i = 0; i < optimized_graph->node_size(); ++i) {
+        if (nodes_to_delete.find(optimized_graph->node(i).name()) !=
+            nodes_to_delete.end()) {
+          continue;
+        }
+        if (i != last) {
+          optimized_graph->mutable_node(last)->Swap(
+              optimized_graph->mutable_node(i));
+        }
+        ++last;
+      }
+      optimized_graph->mutable_node()->DeleteSubrange(
+          last, optimized_graph->node_size() - last);
+    }
+  }
+  TransitiveReduction(optimized_graph);
+  return Status::OK();
+}
+
+void DependencyOptimizer::Feedback(Cluster* /*cluster*/,
+                                   const GrapplerItem& /*item*/,
+                                   const GraphDef& /*optimized_graph*/,
+                                   double /*result*/) {
+  // Nothing to do for DependencyOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
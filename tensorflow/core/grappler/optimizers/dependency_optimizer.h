@@ -0,0 +1,67 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_DEPENDENCY_OPTIMIZER_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_DEPENDENCY_OPTIMIZER_H_
+
+#include <unordered_set>
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Simplify the control dependencies of a graph, so that executors have fewer
+// nodes and edges to track: Identity nodes only used as control dependencies
+// become NoOps, NoOps are bypassed when that does not add edges, and the
+// control edges implied by other paths are removed.
+class DependencyOptimizer : public GraphOptimizer {
+ public:
+  DependencyOptimizer() : opt_level_(RewriterConfig::ON) {}
+  explicit DependencyOptimizer(RewriterConfig::Toggle opt_level)
+      : opt_level_(opt_level) {}
+  ~DependencyOptimizer() override {}
+
+  string name() const override { return "dependency_optimizer"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+
+ private:
+  // Turns the Identity nodes whose consumers only depend on them through
+  // control edges into NoOps that depend on their input.
+  void ConvertControlOnlyIdentities(GraphDef* optimized_graph,
+                                    NodeMap* node_map) const;
+  // Connects the inputs of the NoOps directly to their consumers, and adds the
+  // NoOps to `nodes_to_delete`.
+  void BypassNoOps(GraphDef* optimized_graph, NodeMap* node_map,
+                   std::unordered_set<string>* nodes_to_delete) const;
+  // Removes the control edges from a node to another that are implied by a
+  // longer path between them.
+  void TransitiveReduction(GraphDef* optimized_graph) const;
+
+  std::unordered_set<string> nodes_to_preserve_;
+
+  RewriterConfig::Toggle opt_level_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_DEPENDENCY_OPTIMIZER_H_
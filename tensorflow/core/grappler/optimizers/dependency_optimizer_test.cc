@@ -0,0 +1,174 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/dependency_optimizer.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class DependencyOptimizerTest : public ::testing::Test {
+ protected:
+  static std::vector<string> Inputs(const GraphDef& graph,
+                                    const string& name) {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() == name) {
+        std::vector<string> inputs(node.input().begin(), node.input().end());
+        std::sort(inputs.begin(), inputs.end());
+        return inputs;
+      }
+    }
+    return {"not found"};
+  }
+
+  static const NodeDef* FindNode(const GraphDef& graph, const string& name) {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() == name) return &node;
+    }
+    return nullptr;
+  }
+};
+
+TEST_F(DependencyOptimizerTest, RemovesTransitiveControlEdges) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), {1.0f, 2.0f}, {2});
+  Output y = ops::Identity(s.WithOpName("y"), x);
+  // Implied by the path through "y".
+  Output z = ops::Identity(s.WithOpName("z").WithControlDependencies(x), y);
+  // Implied by the data edge.
+  ops::Identity(s.WithOpName("w").WithControlDependencies(z), z);
+  GrapplerItem item;
+  item.fetch = {"w"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  DependencyOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  EXPECT_EQ(std::vector<string>({"y"}), Inputs(output, "z"));
+  EXPECT_EQ(std::vector<string>({"z"}), Inputs(output, "w"));
+}
+
+TEST_F(DependencyOptimizerTest, KeepsControlEdgesAroundMerge) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), {1.0f, 2.0f}, {2});
+  Output y = ops::Const(s.WithOpName("y"), {1.0f, 2.0f}, {2});
+  ops::Merge merge(s.WithOpName("merge"), {x, y});
+  // The Merge may be alive when "x" is dead.
+  ops::Identity(s.WithOpName("z").WithControlDependencies(x), merge.output);
+  GrapplerItem item;
+  item.fetch = {"z"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  DependencyOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(std::vector<string>({"^x", "merge"}), Inputs(output, "z"));
+}
+
+TEST_F(DependencyOptimizerTest, BypassesNoOps) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Const(s.WithOpName("a"), {1.0f}, {1});
+  Output b = ops::Const(s.WithOpName("b"), {1.0f}, {1});
+  Output x = ops::Const(s.WithOpName("x"), {1.0f}, {1});
+  ops::NoOp inner(s.WithOpName("inner").WithControlDependencies(a));
+  ops::NoOp outer(s.WithOpName("outer").WithControlDependencies(
+      {inner.operation, b.op()}));
+  ops::Identity(s.WithOpName("c").WithControlDependencies({outer.operation}),
+                x);
+  ops::Identity(s.WithOpName("d").WithControlDependencies({outer.operation}),
+                x);
+  GrapplerItem item;
+  item.fetch = {"c", "d"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  DependencyOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.node_size() - 2, output.node_size());
+  EXPECT_EQ(nullptr, FindNode(output, "inner"));
+  EXPECT_EQ(nullptr, FindNode(output, "outer"));
+  EXPECT_EQ(std::vector<string>({"^a", "^b", "x"}), Inputs(output, "c"));
+  EXPECT_EQ(std::vector<string>({"^a", "^b", "x"}), Inputs(output, "d"));
+}
+
+TEST_F(DependencyOptimizerTest, KeepsNoOpsThatSaveEdges) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  std::vector<Operation> inputs;
+  for (const string& name : {"a", "b", "c"}) {
+    inputs.push_back(ops::Const(s.WithOpName(name), {1.0f}, {1}).op());
+  }
+  ops::NoOp group(s.WithOpName("group").WithControlDependencies(inputs));
+  ops::NoOp fetched(s.WithOpName("fetched").WithControlDependencies(
+      {inputs[0]}));
+  Output x = ops::Const(s.WithOpName("x"), {1.0f}, {1});
+  std::vector<string> fetch = {"fetched"};
+  for (const string& name : {"d", "e", "f"}) {
+    ops::Identity(s.WithOpName(name).WithControlDependencies(
+                      {group.operation}),
+                  x);
+    fetch.push_back(name);
+  }
+  GrapplerItem item;
+  item.fetch = fetch;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  DependencyOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // Bypassing "group" would take 9 edges instead of 6.
+  EXPECT_EQ(std::vector<string>({"^group", "x"}), Inputs(output, "d"));
+  EXPECT_NE(nullptr, FindNode(output, "fetched"));
+}
+
+TEST_F(DependencyOptimizerTest, ConvertsControlOnlyIdentities) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), {1.0f}, {1});
+  Output y = ops::Const(s.WithOpName("y"), {1.0f}, {1});
+  Output id = ops::Identity(s.WithOpName("id"), x);
+  ops::Identity(s.WithOpName("z").WithControlDependencies(id), y);
+  // The output of a Switch may be dead while the Switch is not.
+  Output pred = ops::Const(s.WithOpName("pred"), true);
+  ops::Switch sw(s.WithOpName("switch"), x, pred);
+  Output pivot = ops::Identity(s.WithOpName("pivot"), sw.output_true);
+  ops::Identity(s.WithOpName("w").WithControlDependencies(pivot), y);
+  GrapplerItem item;
+  item.fetch = {"z", "w"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  DependencyOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(nullptr, FindNode(output, "id"));
+  EXPECT_EQ(std::vector<string>({"^x", "y"}), Inputs(output, "z"));
+  ASSERT_NE(nullptr, FindNode(output, "pivot"));
+  EXPECT_EQ("Identity", FindNode(output, "pivot")->op());
+  EXPECT_EQ(std::vector<string>({"^pivot", "y"}), Inputs(output, "w"));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,248 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/function_optimizer.h"
+
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// The functions with at most this many nodes are inlined at every call,
+// larger ones only when they are called once.
+const int kMaxInlinedFunctionSize = 32;
+
+bool GetBoolAttr(const protobuf::Map<string, AttrValue>& attr,
+                 const string& name) {
+  auto it = attr.find(name);
+  return it != attr.end() && it->second.b();
+}
+
+}  // namespace
+
+bool FunctionOptimizer::ShouldInline(const NodeDef& node,
+                                     const FunctionDef& func,
+                                     int num_calls) const {
+  if (nodes_to_preserve_.count(node.name()) > 0) {
+    return false;
+  }
+  // The functions that are explicitly not inlined, and the ones that are
+  // compiled as a whole.
+  if (GetBoolAttr(func.attr(), "_noinline") ||
+      GetBoolAttr(func.attr(), "_XlaCompile") ||
+      GetBoolAttr(node.attr(), "_XlaCompile")) {
+    return false;
+  }
+  return num_calls == 1 || func.node_def_size() <= kMaxInlinedFunctionSize;
+}
+
+Status FunctionOptimizer::InlineFunction(
+    const FunctionLibraryDefinition& library, const FunctionDef& func,
+    NodeDef* node, GraphDef* optimized_graph, NodeMap* node_map,
+    std::unordered_set<string>* nodes_to_delete) const {
+  InstantiationResult result;
+  TF_RETURN_IF_ERROR(InstantiateFunction(
+      func, AttrSlice(*node),
+      [&library](const string& op, const OpDef** signature) {
+        return library.LookUpOpDef(op, signature);
+      },
+      &result));
+  std::vector<string> data_inputs;
+  std::vector<string> control_inputs;
+  for (const string& input : node->input()) {
+    if (IsControlInput(input)) {
+      control_inputs.push_back(input);
+    } else {
+      data_inputs.push_back(input);
+    }
+  }
+  if (data_inputs.size() != result.arg_types.size()) {
+    return errors::InvalidArgument(
+        "Function ", func.signature().name(), " takes ",
+        result.arg_types.size(), " inputs, but got ", data_inputs.size());
+  }
+  const string& prefix = node->name();
+  // The outputs of the call, and the nodes of the body that are used by other
+  // nodes of the body.
+  std::vector<string> outputs(result.ret_types.size());
+  std::unordered_set<string> used;
+  for (const NodeDef& body_node : result.nodes) {
+    if (body_node.op() == "_Retval") {
+      outputs[body_node.attr().at("index").i()] =
+          AddPrefixToNodeName(body_node.input(0), prefix);
+      continue;
+    }
+    const string name = AddPrefixToNodeName(body_node.name(), prefix);
+    if (node_map->GetNode(name) != nullptr) {
+      return errors::AlreadyExists("Node ", name, " already exists");
+    }
+    for (const string& input : body_node.input()) {
+      used.insert(NodeName(input));
+    }
+  }
+
+  std::vector<string> sinks;
+  for (const NodeDef& body_node : result.nodes) {
+    if (body_node.op() == "_Retval") {
+      continue;
+    }
+    NodeDef* inlined = optimized_graph->add_node();
+    *inlined = body_node;
+    inlined->set_name(AddPrefixToNodeName(body_node.name(), prefix));
+    for (int i = 0; i < inlined->input_size(); ++i) {
+      *inlined->mutable_input(i) =
+          AddPrefixToNodeName(inlined->input(i), prefix);
+    }
+    // The arguments read the inputs of the call, and together with the
+    // sources of the body, wait for its control dependencies.
+    if (body_node.op() == "_Arg") {
+      const int index = body_node.attr().at("index").i();
+      inlined->set_op("Identity");
+      inlined->mutable_attr()->erase("index");
+      inlined->add_input(data_inputs[index]);
+    }
+    if (inlined->input_size() == 0 || body_node.op() == "_Arg") {
+      for (const string& input : control_inputs) {
+        inlined->add_input(input);
+      }
+    }
+    if (inlined->device().empty()) {
+      inlined->set_device(node->device());
+    }
+    node_map->AddNode(inlined->name(), inlined);
+    for (const string& input : inlined->input()) {
+      node_map->AddOutput(NodeName(input), inlined->name());
+    }
+    if (used.count(body_node.name()) == 0) {
+      sinks.push_back(inlined->name());
+    }
+  }
+
+  bool has_control_outputs = false;
+  const std::set<NodeDef*> consumers = node_map->GetOutputs(node->name());
+  for (NodeDef* consumer : consumers) {
+    bool is_control_output = false;
+    for (int i = 0; i < consumer->input_size(); ++i) {
+      int position;
+      const string input = ParseNodeName(consumer->input(i), &position);
+      if (input != node->name()) {
+        continue;
+      }
+      if (position < 0) {
+        is_control_output = true;
+        continue;
+      }
+      *consumer->mutable_input(i) = outputs[position];
+      node_map->AddOutput(NodeName(outputs[position]), consumer->name());
+    }
+    if (is_control_output) {
+      has_control_outputs = true;
+    } else {
+      node_map->RemoveOutput(node->name(), consumer->name());
+    }
+  }
+  node_map->RemoveInputs(node->name());
+  node->clear_input();
+  if (!has_control_outputs) {
+    nodes_to_delete->insert(node->name());
+    return Status::OK();
+  }
+  // The call is done when all the nodes of its body are.
+  node->set_op("NoOp");
+  node->clear_attr();
+  for (const string& sink : sinks) {
+    node->add_input(AsControlDependency(sink));
+    node_map->AddOutput(sink, node->name());
+  }
+  return Status::OK();
+}
+
+Status FunctionOptimizer::Optimize(Cluster* /*cluster*/,
+                                   const GrapplerItem& item,
+                                   GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  nodes_to_preserve_ = item.NodesToPreserve();
+  if (optimized_graph->library().function_size() == 0) {
+    return Status::OK();
+  }
+
+  FunctionLibraryDefinition library(OpRegistry::Global(),
+                                    optimized_graph->library());
+  std::unordered_map<string, int> num_calls;
+  for (const NodeDef& node : optimized_graph->node()) {
+    if (library.Find(node.op()) != nullptr) {
+      ++num_calls[node.op()];
+    }
+  }
+  if (num_calls.empty()) {
+    return Status::OK();
+  }
+
+  NodeMap node_map(optimized_graph);
+  std::unordered_set<string> nodes_to_delete;
+  // The calls that the inlined bodies make are left for the next pass.
+  const int num_nodes = optimized_graph->node_size();
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* node = optimized_graph->mutable_node(i);
+    const FunctionDef* func = library.Find(node->op());
+    if (func == nullptr || !ShouldInline(*node, *func, num_calls[node->op()])) {
+      continue;
+    }
+    Status s = InlineFunction(library, *func, node, optimized_graph, &node_map,
+                              &nodes_to_delete);
+    if (!s.ok()) {
+      VLOG(1) << "Not inlining " << node->name() << ": " << s;
+    }
+  }
+
+  if (!nodes_to_delete.empty()) {
+    int last = 0;
+    for (int i = 0; i < optimized_graph->node_size(); ++i) {
+      if (nodes_to_delete.find(optimized_graph->node(i).name()) !=
+          nodes_to_delete.end()) {
+        continue;
+      }
+      if (i != last) {
+        optimized_graph->mutable_node(last)->Swap(
+            optimized_graph->mutable_node(i));
+      }
+      ++last;
+    }
+    optimized_graph->mutable_node()->DeleteSubrange(
+        last, optimized_graph->node_size() - last);
+  }
+  return Status::OK();
+}
+
+void FunctionOptimizer::Feedback(Cluster* /*cluster*/,
+                                 const GrapplerItem& /*item*/,
+                                 const GraphDef& /*optimized_graph*/,
+                                 double /*result*/) {
+  // Nothing to do for FunctionOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,69 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_FUNCTION_OPTIMIZER_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_FUNCTION_OPTIMIZER_H_
+
+#include <unordered_set>
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Inline the calls to the functions of the graph library that are small or
+// called only once, so that the other optimizers see through them, e.g. to
+// fold their constants or to share their computations with the rest of the
+// graph. The functions themselves stay in the library.
+class FunctionOptimizer : public GraphOptimizer {
+ public:
+  FunctionOptimizer() : opt_level_(RewriterConfig::ON) {}
+  explicit FunctionOptimizer(RewriterConfig::Toggle opt_level)
+      : opt_level_(opt_level) {}
+  ~FunctionOptimizer() override {}
+
+  string name() const override { return "function_optimizer"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+
+ private:
+  // Returns true if the call `node` to `func` should be inlined, given the
+  // number of calls to `func` in the graph.
+  bool ShouldInline(const NodeDef& node, const FunctionDef& func,
+                    int num_calls) const;
+  // Replaces the call `node` with the body of `func`, and adds `node` to
+  // `nodes_to_delete` unless it is kept as a NoOp for its control outputs.
+  // Returns an error, and leaves the graph unchanged, if the function can't
+  // be instantiated for the call.
+  Status InlineFunction(const FunctionLibraryDefinition& library,
+                        const FunctionDef& func, NodeDef* node,
+                        GraphDef* optimized_graph, NodeMap* node_map,
+                        std::unordered_set<string>* nodes_to_delete) const;
+
+  std::unordered_set<string> nodes_to_preserve_;
+
+  RewriterConfig::Toggle opt_level_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_FUNCTION_OPTIMIZER_H_
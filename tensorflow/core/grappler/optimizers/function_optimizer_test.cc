@@ -0,0 +1,132 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/function_optimizer.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using test::function::NDef;
+
+class FunctionOptimizerTest : public ::testing::Test {
+ protected:
+  static const NodeDef* FindNode(const GraphDef& graph, const string& name) {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() == name) return &node;
+    }
+    return nullptr;
+  }
+
+  static std::vector<string> Inputs(const GraphDef& graph,
+                                    const string& name) {
+    const NodeDef* node = FindNode(graph, name);
+    if (node == nullptr) return {"not found"};
+    return std::vector<string>(node->input().begin(), node->input().end());
+  }
+};
+
+TEST_F(FunctionOptimizerTest, InlinesFunctionCalls) {
+  const string device = "/job:localhost/replica:0/task:0/device:CPU:0";
+  GrapplerItem item;
+  item.fetch = {"z"};
+  item.graph = test::function::GDef(
+      {NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}, device),
+       NDef("c", "NoOp", {}, {}, device),
+       NDef("call", "XTimesTwo", {"x", "^c"}, {{"T", DT_FLOAT}}, device),
+       NDef("z", "Identity", {"call"}, {{"T", DT_FLOAT}}, device)},
+      {test::function::XTimesTwo()});
+
+  FunctionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(nullptr, FindNode(output, "call"));
+  const NodeDef* arg = FindNode(output, "call/x");
+  ASSERT_NE(nullptr, arg);
+  EXPECT_EQ("Identity", arg->op());
+  EXPECT_EQ(std::vector<string>({"x", "^c"}), Inputs(output, "call/x"));
+  // The sources of the body wait for the control dependencies of the call.
+  EXPECT_EQ(std::vector<string>({"^c"}), Inputs(output, "call/two"));
+  EXPECT_EQ(std::vector<string>({"call/two"}), Inputs(output, "call/scale"));
+  EXPECT_EQ(std::vector<string>({"call/x", "call/scale"}),
+            Inputs(output, "call/y"));
+  EXPECT_EQ(device, FindNode(output, "call/y")->device());
+  EXPECT_EQ(std::vector<string>({"call/y"}), Inputs(output, "z"));
+  // The library is unchanged.
+  EXPECT_EQ(1, output.library().function_size());
+}
+
+TEST_F(FunctionOptimizerTest, KeepsCallWithControlOutputs) {
+  GrapplerItem item;
+  item.fetch = {"z"};
+  item.graph = test::function::GDef(
+      {NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       NDef("call", "XTimesTwo", {"x"}, {{"T", DT_FLOAT}}),
+       NDef("z", "Identity", {"x", "^call"}, {{"T", DT_FLOAT}})},
+      {test::function::XTimesTwo()});
+
+  FunctionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  const NodeDef* call = FindNode(output, "call");
+  ASSERT_NE(nullptr, call);
+  EXPECT_EQ("NoOp", call->op());
+  EXPECT_EQ(std::vector<string>({"^call/y"}), Inputs(output, "call"));
+  EXPECT_EQ(std::vector<string>({"x", "^call"}), Inputs(output, "z"));
+}
+
+TEST_F(FunctionOptimizerTest, KeepsNoInlineFunctions) {
+  FunctionDef func = test::function::XTimesTwo();
+  (*func.mutable_attr())["_noinline"].set_b(true);
+  GrapplerItem item;
+  item.fetch = {"z"};
+  item.graph = test::function::GDef(
+      {NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       NDef("call", "XTimesTwo", {"x"}, {{"T", DT_FLOAT}}),
+       NDef("z", "Identity", {"call"}, {{"T", DT_FLOAT}})},
+      {func});
+
+  FunctionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.DebugString(), output.DebugString());
+}
+
+TEST_F(FunctionOptimizerTest, KeepsFetchedCalls) {
+  GrapplerItem item;
+  item.fetch = {"call"};
+  item.graph = test::function::GDef(
+      {NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}),
+       NDef("call", "XTimesTwo", {"x"}, {{"T", DT_FLOAT}})},
+      {test::function::XTimesTwo()});
+
+  FunctionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.DebugString(), output.DebugString());
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
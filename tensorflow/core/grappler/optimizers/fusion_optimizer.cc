@@ -0,0 +1,204 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/fusion_optimizer.h"
+
+#include <algorithm>
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+bool IsBiasAdd(const NodeDef& node) {
+  return node.op() == "BiasAdd" || node.op() == "BiasAddV1";
+}
+
+string DataFormat(const NodeDef& node) {
+  auto it = node.attr().find("data_format");
+  return it == node.attr().end() ? "NHWC" : it->second.s();
+}
+
+// Returns the node that produces the first input of "node" if it is the
+// output 0 of a node of the same type on the same device, and "node" is its
+// only consumer.
+NodeDef* FusableProducer(const NodeDef& node, const NodeMap& node_map,
+                         const std::unordered_set<string>& nodes_to_preserve) {
+  if (node.input_size() == 0 || IsControlInput(node.input(0))) return nullptr;
+  int position;
+  const string name = ParseNodeName(node.input(0), &position);
+  NodeDef* producer = node_map.GetNode(name);
+  if (producer == nullptr || position != 0 ||
+      producer->device() != node.device() ||
+      nodes_to_preserve.count(name) > 0 ||
+      node_map.GetOutputs(name).size() != 1) {
+    return nullptr;
+  }
+  auto node_type = node.attr().find("T");
+  auto producer_type = producer->attr().find("T");
+  if (node_type == node.attr().end() ||
+      producer_type == producer->attr().end() ||
+      node_type->second.type() != producer_type->second.type()) {
+    return nullptr;
+  }
+  return producer;
+}
+
+// Returns true if the device of "node" has a kernel for it.
+bool HasKernel(const NodeDef& node) {
+  DeviceNameUtils::ParsedName parsed;
+  string type = DEVICE_CPU;
+  if (!node.device().empty() &&
+      DeviceNameUtils::ParseFullName(node.device(), &parsed) &&
+      parsed.has_type) {
+    type = parsed.type;
+  }
+  return FindKernelDef(DeviceType(type), node, nullptr, nullptr).ok();
+}
+
+}  // namespace
+
+Status FusionOptimizer::Optimize(Cluster* /*cluster*/, const GrapplerItem& item,
+                                 GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  const std::unordered_set<string> nodes_to_preserve = item.NodesToPreserve();
+  NodeMap node_map(optimized_graph);
+  std::unordered_set<string> nodes_to_delete;
+
+  for (int i = 0; i < optimized_graph->node_size(); ++i) {
+    NodeDef* bias_add = optimized_graph->mutable_node(i);
+    if (!IsBiasAdd(*bias_add) || bias_add->input_size() < 2 ||
+        IsControlInput(bias_add->input(1)) ||
+        nodes_to_delete.count(bias_add->name()) > 0) {
+      continue;
+    }
+    NodeDef* producer =
+        FusableProducer(*bias_add, node_map, nodes_to_preserve);
+    if (producer == nullptr) continue;
+    string fused_op;
+    if (producer->op() == "Conv2D") {
+      if (DataFormat(*producer) != DataFormat(*bias_add)) continue;
+      fused_op = "_FusedConv2D";
+    } else if (producer->op() == "MatMul") {
+      if (DataFormat(*bias_add) != "NHWC") continue;
+      fused_op = "_FusedMatMul";
+    } else {
+      continue;
+    }
+
+    // The node the chain ends with, which is replaced by the fused node.
+    NodeDef* tail = bias_add;
+    string activation = "None";
+    const std::set<NodeDef*>& outputs = node_map.GetOutputs(bias_add->name());
+    if (outputs.size() == 1) {
+      NodeDef* consumer = *outputs.begin();
+      if ((consumer->op() == "Relu" || consumer->op() == "Relu6") &&
+          FusableProducer(*consumer, node_map, nodes_to_preserve) ==
+              bias_add) {
+        tail = consumer;
+        activation = consumer->op();
+      }
+    }
+
+    NodeDef fused;
+    fused.set_name(tail->name());
+    fused.set_op(fused_op);
+    fused.set_device(tail->device());
+    std::vector<const NodeDef*> removed = {producer};
+    if (tail != bias_add) removed.push_back(bias_add);
+    std::vector<string> inputs;
+    for (const string& input : producer->input()) {
+      if (!IsControlInput(input)) inputs.push_back(input);
+    }
+    if (inputs.size() != 2) continue;
+    inputs.push_back(bias_add->input(1));
+    // The fused node runs after the control inputs of all the nodes.
+    std::vector<const NodeDef*> chain = removed;
+    chain.push_back(tail);
+    for (const NodeDef* node : chain) {
+      for (const string& input : node->input()) {
+        if (IsControlInput(input) &&
+            std::find(inputs.begin(), inputs.end(), input) == inputs.end()) {
+          inputs.push_back(input);
+        }
+      }
+    }
+    for (const string& input : inputs) fused.add_input(input);
+    for (const auto& attr : producer->attr()) {
+      if (!StringPiece(attr.first).starts_with("_")) {
+        (*fused.mutable_attr())[attr.first] = attr.second;
+      }
+    }
+    for (const auto& attr : tail->attr()) {
+      if (StringPiece(attr.first).starts_with("_")) {
+        (*fused.mutable_attr())[attr.first] = attr.second;
+      }
+    }
+    (*fused.mutable_attr())["activation"].set_s(activation);
+    if (!HasKernel(fused)) {
+      VLOG(2) << "No kernel to fuse " << producer->name() << " into "
+              << tail->name() << " on " << tail->device();
+      continue;
+    }
+
+    VLOG(1) << "Fusing " << producer->name() << " into " << tail->name()
+            << " as " << fused_op << " with activation " << activation;
+    for (const NodeDef* node : chain) {
+      node_map.RemoveInputs(node->name());
+    }
+    for (const NodeDef* node : removed) {
+      node_map.RemoveOutputs(node->name());
+      nodes_to_delete.insert(node->name());
+    }
+    tail->Swap(&fused);
+    for (const string& input : tail->input()) {
+      node_map.AddOutput(NodeName(input), tail->name());
+    }
+  }
+
+  if (!nodes_to_delete.empty()) {
+    GraphDef* graph = optimized_graph;
+    int last = 0;
+    for (int i = 0; i < graph->node_size(); ++i) {
+      if (nodes_to_delete.count(graph->node(i).name()) > 0) continue;
+      if (i != last) graph->mutable_node(last)->Swap(graph->mutable_node(i));
+      ++last;
+    }
+    graph->mutable_node()->DeleteSubrange(last, graph->node_size() - last);
+  }
+  return Status::OK();
+}
+
+void FusionOptimizer::Feedback(Cluster* /*cluster*/,
+                               const GrapplerItem& /*item*/,
+                               const GraphDef& /*optimized_graph*/,
+                               double /*result*/) {
+  // Nothing to do for FusionOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
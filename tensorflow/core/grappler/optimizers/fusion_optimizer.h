@@ -0,0 +1,50 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_FUSION_OPTIMIZER_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_FUSION_OPTIMIZER_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Fuses the chains Conv2D -> BiasAdd [-> Relu|Relu6] and
+// MatMul -> BiasAdd [-> Relu|Relu6] into the single ops _FusedConv2D and
+// _FusedMatMul, which apply the bias and the activation in place instead of
+// reading and writing their output again in separate kernels.
+//
+// A chain is fused only if its nodes are placed on the same device, which
+// has a kernel for the fused op, and if the nodes before the last one have
+// no other consumer and are not preserved. The fused node takes the name of
+// the last node of the chain, so its consumers are left unchanged.
+class FusionOptimizer : public GraphOptimizer {
+ public:
+  FusionOptimizer() {}
+  ~FusionOptimizer() override {}
+
+  string name() const override { return "fusion_optimizer"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_FUSION_OPTIMIZER_H_
@@ -0,0 +1,178 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/fusion_optimizer.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class FusionOptimizerTest : public ::testing::Test {
+ protected:
+  static const NodeDef* FindNode(const GraphDef& graph, const string& name) {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() == name) return &node;
+    }
+    return nullptr;
+  }
+};
+
+TEST_F(FusionOptimizerTest, FusesConv2DBiasAddRelu) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output input = ops::Placeholder(s.WithOpName("input"), DT_FLOAT,
+                                  ops::Placeholder::Shape({8, 32, 32, 3}));
+  Output filter = ops::Placeholder(s.WithOpName("filter"), DT_FLOAT,
+                                   ops::Placeholder::Shape({3, 3, 3, 16}));
+  Output bias = ops::Placeholder(s.WithOpName("bias"), DT_FLOAT,
+                                 ops::Placeholder::Shape({16}));
+  Output conv =
+      ops::Conv2D(s.WithOpName("conv"), input, filter, {1, 2, 2, 1}, "SAME");
+  Output bias_add = ops::BiasAdd(
+      s.WithOpName("bias_add").WithControlDependencies(bias), conv, bias);
+  Output relu = ops::Relu(s.WithOpName("relu"), bias_add);
+  ops::Identity(s.WithOpName("output"), relu);
+  GrapplerItem item;
+  item.fetch = {"output"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  FusionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.node_size() - 2, output.node_size());
+  EXPECT_EQ(nullptr, FindNode(output, "conv"));
+  EXPECT_EQ(nullptr, FindNode(output, "bias_add"));
+  const NodeDef* fused = FindNode(output, "relu");
+  ASSERT_NE(nullptr, fused);
+  EXPECT_EQ("_FusedConv2D", fused->op());
+  ASSERT_EQ(4, fused->input_size());
+  EXPECT_EQ("input", fused->input(0));
+  EXPECT_EQ("filter", fused->input(1));
+  EXPECT_EQ("bias", fused->input(2));
+  EXPECT_EQ("^bias", fused->input(3));
+  EXPECT_EQ("Relu", fused->attr().at("activation").s());
+  EXPECT_EQ("SAME", fused->attr().at("padding").s());
+  EXPECT_EQ(2, fused->attr().at("strides").list().i(1));
+  EXPECT_EQ(DT_FLOAT, fused->attr().at("T").type());
+  EXPECT_EQ("relu", FindNode(output, "output")->input(0));
+}
+
+TEST_F(FusionOptimizerTest, FusesMatMulBiasAdd) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT,
+                              ops::Placeholder::Shape({64, 8}));
+  Output b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT,
+                              ops::Placeholder::Shape({64, 32}));
+  Output bias = ops::Placeholder(s.WithOpName("bias"), DT_FLOAT,
+                                 ops::Placeholder::Shape({32}));
+  Output matmul = ops::MatMul(s.WithOpName("matmul"), a, b,
+                              ops::MatMul::TransposeA(true));
+  Output bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+  // Sigmoid is not fused, so the chain ends with the BiasAdd.
+  ops::Sigmoid(s.WithOpName("sigmoid"), bias_add);
+  GrapplerItem item;
+  item.fetch = {"sigmoid"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  FusionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.node_size() - 1, output.node_size());
+  EXPECT_EQ(nullptr, FindNode(output, "matmul"));
+  const NodeDef* fused = FindNode(output, "bias_add");
+  ASSERT_NE(nullptr, fused);
+  EXPECT_EQ("_FusedMatMul", fused->op());
+  ASSERT_EQ(3, fused->input_size());
+  EXPECT_EQ("a", fused->input(0));
+  EXPECT_EQ("b", fused->input(1));
+  EXPECT_EQ("bias", fused->input(2));
+  EXPECT_EQ("None", fused->attr().at("activation").s());
+  EXPECT_TRUE(fused->attr().at("transpose_a").b());
+  EXPECT_FALSE(fused->attr().at("transpose_b").b());
+  EXPECT_EQ("Sigmoid", FindNode(output, "sigmoid")->op());
+}
+
+TEST_F(FusionOptimizerTest, KeepsSharedAndPreservedNodes) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT,
+                              ops::Placeholder::Shape({8, 8}));
+  Output bias = ops::Placeholder(s.WithOpName("bias"), DT_FLOAT,
+                                 ops::Placeholder::Shape({8}));
+  // The output of "shared" is used twice.
+  Output shared = ops::MatMul(s.WithOpName("shared"), a, a);
+  Output shared_bias_add =
+      ops::BiasAdd(s.WithOpName("shared_bias_add"), shared, bias);
+  ops::Identity(s.WithOpName("shared_output"), shared);
+  // "fetched" is fetched, so it must stay in the graph.
+  Output fetched = ops::MatMul(s.WithOpName("fetched"), a, a);
+  Output fetched_bias_add =
+      ops::BiasAdd(s.WithOpName("fetched_bias_add"), fetched, bias);
+  // The activation of "relu" would be fused, but not "bias_add" which is
+  // fetched.
+  Output matmul = ops::MatMul(s.WithOpName("matmul"), a, a);
+  Output bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+  ops::Relu(s.WithOpName("relu"), bias_add);
+  GrapplerItem item;
+  item.fetch = {"shared_bias_add", "shared_output", "fetched",
+                "fetched_bias_add", "bias_add", "relu"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  FusionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ("MatMul", FindNode(output, "shared")->op());
+  EXPECT_EQ("BiasAdd", FindNode(output, "shared_bias_add")->op());
+  EXPECT_EQ("MatMul", FindNode(output, "fetched")->op());
+  EXPECT_EQ("BiasAdd", FindNode(output, "fetched_bias_add")->op());
+  EXPECT_EQ(nullptr, FindNode(output, "matmul"));
+  EXPECT_EQ("_FusedMatMul", FindNode(output, "bias_add")->op());
+  EXPECT_EQ("None", FindNode(output, "bias_add")->attr().at("activation").s());
+  EXPECT_EQ("Relu", FindNode(output, "relu")->op());
+}
+
+TEST_F(FusionOptimizerTest, KeepsNodesOnDifferentDevices) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT,
+                              ops::Placeholder::Shape({8, 8}));
+  Output bias = ops::Placeholder(s.WithOpName("bias"), DT_FLOAT,
+                                 ops::Placeholder::Shape({8}));
+  Output matmul = ops::MatMul(
+      s.WithOpName("matmul").WithDevice("/job:localhost/task:0/cpu:0"), a, a);
+  ops::BiasAdd(s.WithOpName("bias_add").WithDevice(
+                   "/job:localhost/task:0/cpu:1"),
+               matmul, bias);
+  GrapplerItem item;
+  item.fetch = {"bias_add"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  FusionOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ("MatMul", FindNode(output, "matmul")->op());
+  EXPECT_EQ("BiasAdd", FindNode(output, "bias_add")->op());
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -13,10 +13,12 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <unordered_map>
 #include <unordered_set>
 
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
@@ -29,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/frame.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/device_name_utils.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -60,6 +63,23 @@ std::set<string> GetOpsFormatSupported() {
   return ops_format_supported;
 }
 
+// The ops that support NCHW on CPU, through the MKL kernels that the MKL
+// layout pass substitutes for them.
+std::set<string> GetOpsFormatSupportedOnCpu() {
+  std::set<string> ops_format_supported = {"AvgPool",
+                                           "AvgPoolGrad",
+                                           "Conv2D",
+                                           "Conv2DBackpropFilter",
+                                           "Conv2DBackpropInput",
+                                           "BiasAdd",
+                                           "BiasAddGrad",
+                                           "FusedBatchNorm",
+                                           "FusedBatchNormGrad",
+                                           "MaxPool",
+                                           "MaxPoolGrad"};
+  return ops_format_supported;
+}
+
 std::set<string> GetOpsFormatAgnostic() {
   std::set<string> ops_format_agnostic = {"Add",
                                           "AddN",
@@ -88,6 +108,15 @@ bool IsNodeNHWCToNCHW(const string& node_name) {
   return false;
 }
 
+bool IsNodeOnCpu(const NodeDef& node) {
+  if (node.device().empty()) {
+    return true;
+  }
+  DeviceNameUtils::ParsedName parsed_name;
+  return DeviceNameUtils::ParseFullName(node.device(), &parsed_name) &&
+         (!parsed_name.has_type || parsed_name.type == DEVICE_CPU);
+}
+
 bool IsNodeNCHWToNHWC(const string& node_name) {
   const string transpose_node_prefix = kTransposeNCHWToNHWC;
   string prefix = node_name.substr(0, transpose_node_prefix.length());
@@ -1186,8 +1215,18 @@ struct TuningConfig {
   // might result in more non-cancellable layout conversion nodes (implemented
   // by the Transpose op).
   bool no_gemm;
+  // If true, convert the CPU nodes rather than the GPU ones. The MKL kernels
+  // run faster on NCHW inputs, which they convert to their blocked layouts
+  // without a transpose, and keep their outputs in those layouts until a
+  // non-MKL op reads them. Only the connected regions of layout-sensitive and
+  // layout-agnostic nodes that contain at least kMinCpuRegionSize
+  // layout-sensitive nodes are converted, so that the conversions at their
+  // boundaries are amortized.
+  bool cpu;
 };
 
+const int kMinCpuRegionSize = 2;
+
 class DataLayoutOptimizer : GraphProcessor {
  public:
   explicit DataLayoutOptimizer(const string& default_device, GraphDef* graph,
@@ -1198,6 +1237,9 @@ class DataLayoutOptimizer : GraphProcessor {
 
   Status Optimize() {
     LOG(INFO) << "Number of nodes for original graph: " << graph_->node_size();
+    if (config_.cpu) {
+      IdentifyCpuRegions();
+    }
     TF_RETURN_IF_ERROR(Expand());
     LOG(INFO) << "Number of nodes after Expand: " << graph_->node_size();
     TF_RETURN_IF_ERROR(Collapse());
@@ -1227,6 +1269,81 @@ class DataLayoutOptimizer : GraphProcessor {
                                                  default_device_);
   }
 
+  bool IsCpuLayoutSensitive(const NodeDef& node,
+                             const std::set<string>& ops_format_supported) {
+    if (ops_format_supported.find(node.op()) == ops_format_supported.end()) {
+      return false;
+    }
+    auto data_format = node.attr().find("data_format");
+    auto type = node.attr().find("T");
+    // The MKL layout pass only substitutes MKL kernels for float ops.
+    return data_format != node.attr().end() &&
+           data_format->second.s() == "NHWC" && type != node.attr().end() &&
+           type->second.type() == DT_FLOAT;
+  }
+
+  // Finds the connected regions of CPU nodes which support NCHW or are layout
+  // agnostic, and selects the layout-sensitive nodes of the regions large
+  // enough to be converted.
+  void IdentifyCpuRegions() {
+    std::set<string> ops_format_supported = GetOpsFormatSupportedOnCpu();
+    std::set<string> ops_format_agnostic = GetOpsFormatAgnostic();
+    std::unordered_map<string, int> candidates;
+    std::vector<bool> sensitive;
+    for (int i = 0; i < graph_->node_size(); i++) {
+      const NodeDef& node = graph_->node(i);
+      if (!IsNodeOnCpu(node)) {
+        continue;
+      }
+      bool is_sensitive = IsCpuLayoutSensitive(node, ops_format_supported);
+      if (is_sensitive || ops_format_agnostic.find(node.op()) !=
+                              ops_format_agnostic.end()) {
+        candidates[node.name()] = sensitive.size();
+        sensitive.push_back(is_sensitive);
+      }
+    }
+    std::vector<int> parents(sensitive.size());
+    for (int i = 0; static_cast<size_t>(i) < parents.size(); i++) {
+      parents[i] = i;
+    }
+    auto find = [&parents](int i) {
+      while (parents[i] != i) {
+        parents[i] = parents[parents[i]];
+        i = parents[i];
+      }
+      return i;
+    };
+    for (const auto& node : graph_->node()) {
+      auto it = candidates.find(node.name());
+      if (it == candidates.end()) {
+        continue;
+      }
+      for (const auto& input : node.input()) {
+        if (IsControlInput(input)) {
+          continue;
+        }
+        auto input_it = candidates.find(NodeName(input));
+        if (input_it != candidates.end()) {
+          parents[find(input_it->second)] = find(it->second);
+        }
+      }
+    }
+    std::unordered_map<int, int> region_sizes;
+    for (int i = 0; static_cast<size_t>(i) < sensitive.size(); i++) {
+      if (sensitive[i]) {
+        region_sizes[find(i)]++;
+      }
+    }
+    for (const auto& candidate : candidates) {
+      if (sensitive[candidate.second] &&
+          region_sizes[find(candidate.second)] >= kMinCpuRegionSize) {
+        cpu_nodes_to_convert_.insert(candidate.first);
+      }
+    }
+    LOG(INFO) << "Number of CPU nodes to convert: "
+              << cpu_nodes_to_convert_.size();
+  }
+
   // Expand all nodes which is in NHWC, but supports NCHW or is layout agnostic.
   Status Expand() {
     int node_size_original = graph_->node_size();
@@ -1234,10 +1351,15 @@ class DataLayoutOptimizer : GraphProcessor {
     IdentifyFrames(*graph_, &frames);
 
     // This is the first pass where we expand the nodes which support NCHW.
-    std::set<string> ops_format_supported = GetOpsFormatSupported();
+    std::set<string> ops_format_supported =
+        config_.cpu ? GetOpsFormatSupportedOnCpu() : GetOpsFormatSupported();
     for (int i = 0; i < node_size_original; i++) {
       if (ops_format_supported.find(graph_->node(i).op()) !=
           ops_format_supported.end()) {
+        if (config_.cpu && cpu_nodes_to_convert_.find(graph_->node(i).name()) ==
+                               cpu_nodes_to_convert_.end()) {
+          continue;
+        }
         auto node = graph_->mutable_node(i);
         bool is_in_frame = !frames[node].empty();
         std::unique_ptr<NodeProcessor> node_processor;
@@ -1373,6 +1495,7 @@ class DataLayoutOptimizer : GraphProcessor {
 
   string default_device_;
   TuningConfig config_;
+  std::unordered_set<string> cpu_nodes_to_convert_;
 };
 
 int GetNumTranspose(const GraphDef& graph) {
@@ -1386,13 +1509,21 @@ int GetNumTranspose(const GraphDef& graph) {
   return number;
 }
 
+// Returns true if the MKL kernels, which support NCHW on CPU, are built in.
+bool MklKernelsRegistered() {
+  const OpDef* op_def;
+  return OpRegistry::Global()->LookUpOpDef("_MklConv2D", &op_def).ok();
+}
+
+LayoutOptimizer::LayoutOptimizer() : cpu_layout_(MklKernelsRegistered()) {}
+
 Status LayoutOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                  GraphDef* output) {
   if (num_gpus_ == 0) {
     num_gpus_ = GetNumAvailableGPUs();
   }
-  if (num_gpus_ < 1) {
-    // LayoutOptimizer is currently only tuned for GPU.
+  if (num_gpus_ < 1 && !cpu_layout_) {
+    // LayoutOptimizer is currently only tuned for GPU, and for CPU with MKL.
     *output = item.graph;
     return Status::OK();
   }
@@ -1410,7 +1541,9 @@ Status LayoutOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   }
 
   TuningConfig config;
-  config.no_gemm = false;
+  config.cpu = num_gpus_ < 1;
+  // The MKL kernels have no specialized NHWC implementation.
+  config.no_gemm = config.cpu;
   string default_device = "/job:localhost/replica:0/task:0/cpu:0";
   if (cluster) {
     if (!cluster->GetDevices().empty()) {
@@ -1424,7 +1557,7 @@ Status LayoutOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   // This is based on an empirical observation that if the introduced Transpose
   // nodes is more than 30, not using GEMM implementation would result in better
   // performance.
-  if (status.ok() && GetNumTranspose(*output) > 30) {
+  if (status.ok() && !config.no_gemm && GetNumTranspose(*output) > 30) {
     config.no_gemm = true;
     node_map.reset(new NodeMap(output));
     layout_optimizer.reset(new DataLayoutOptimizer(default_device, output,
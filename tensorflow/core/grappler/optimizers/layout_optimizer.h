@@ -21,16 +21,20 @@ limitations under the License.
 namespace tensorflow {
 namespace grappler {
 
-// Convert the NHWC layout to NCHW for Conv-related ops on GPUs.
+// Convert the NHWC layout to NCHW for Conv-related ops on GPUs. Without GPUs,
+// convert it for the regions of Conv-related ops on CPUs if the MKL kernels
+// are built in.
 class LayoutOptimizer : public GraphOptimizer {
  public:
-  LayoutOptimizer() {}
+  LayoutOptimizer();
   ~LayoutOptimizer() override {}
 
   string name() const override { return "layout"; };
 
   // This is for testing only.
   void set_num_gpus(int num_gpus) { num_gpus_ = num_gpus; };
+  // This is for testing only.
+  void set_cpu_layout(bool cpu_layout) { cpu_layout_ = cpu_layout; };
 
   Status Optimize(Cluster* cluster, const GrapplerItem& item,
                   GraphDef* output) override;
@@ -40,6 +44,7 @@ class LayoutOptimizer : public GraphOptimizer {
 
  private:
   int num_gpus_ = 0;
+  bool cpu_layout_;
 };
 
 }  // end namespace grappler
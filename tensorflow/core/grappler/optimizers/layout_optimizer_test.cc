@@ -200,6 +200,45 @@ TEST_F(LayoutOptimizerTest, NotEqualSizeWithValidPadding) {
       node_map.GetNode("LayoutOptimizerTransposeNHWCToNCHW-Conv2D-Input-0"));
 }
 
+TEST_F(LayoutOptimizerTest, CpuRegionIsConverted) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto conv = SimpleConv2D(&s, 4, 2, "SAME");
+  Output pool = ops::MaxPool(s.WithOpName("MaxPool"), conv, {1, 2, 2, 1},
+                             {1, 2, 2, 1}, "VALID");
+  Output fetch = ops::Identity(s.WithOpName("Fetch"), {pool});
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  LayoutOptimizer optimizer;
+  optimizer.set_cpu_layout(true);
+  GraphDef output;
+  Status status = optimizer.Optimize(nullptr, item, &output);
+  NodeMap node_map(&output);
+  EXPECT_EQ("NCHW", node_map.GetNode("Conv2D")->attr().at("data_format").s());
+  EXPECT_EQ("NCHW", node_map.GetNode("MaxPool")->attr().at("data_format").s());
+  // The conversions are only at the boundaries of the region.
+  EXPECT_TRUE(
+      node_map.GetNode("LayoutOptimizerTransposeNHWCToNCHW-Conv2D-Input-0"));
+  EXPECT_EQ("Conv2D", node_map.GetNode("MaxPool")->input(0));
+  EXPECT_TRUE(
+      node_map.GetNode("LayoutOptimizerTransposeNCHWToNHWC-MaxPool-Fetch"));
+}
+
+TEST_F(LayoutOptimizerTest, CpuSingleOpIsNotConverted) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto conv = SimpleConv2D(&s, 4, 2, "SAME");
+  Output fetch = ops::Identity(s.WithOpName("Fetch"), {conv});
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  LayoutOptimizer optimizer;
+  optimizer.set_cpu_layout(true);
+  GraphDef output;
+  Status status = optimizer.Optimize(nullptr, item, &output);
+  NodeMap node_map(&output);
+  EXPECT_EQ("NHWC", node_map.GetNode("Conv2D")->attr().at("data_format").s());
+  EXPECT_FALSE(
+      node_map.GetNode("LayoutOptimizerTransposeNHWCToNCHW-Conv2D-Input-0"));
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
@@ -0,0 +1,354 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils/frame.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+const char kLoopInvariantEnter[] = "LoopInvariantEnter";
+
+bool IsConstantEnter(const NodeDef& node) {
+  if (node.op() != "Enter") {
+    return false;
+  }
+  auto it = node.attr().find("is_constant");
+  return it != node.attr().end() && it->second.b();
+}
+
+bool IsControlFlow(const NodeDef& node) {
+  return IsEnter(node) || IsExit(node) || IsMerge(node) || IsSwitch(node) ||
+         IsNextIteration(node) || node.op() == "LoopCond" ||
+         node.op() == "ControlTrigger";
+}
+
+// Returns true if `node` is the Identity of the true output of a Switch of a
+// loop, i.e. a pivot of the loop body, which the nodes of the body without
+// inputs depend on. The pivot is dead in the last iteration of the loop.
+bool IsBodyPivot(const NodeDef& node, const NodeMap& node_map) {
+  if (!IsIdentity(node) || node.input_size() == 0) {
+    return false;
+  }
+  int position;
+  const NodeDef* switch_node =
+      node_map.GetNode(ParseNodeName(node.input(0), &position));
+  if (switch_node == nullptr || !IsSwitch(*switch_node) || position != 1 ||
+      switch_node->input_size() < 2) {
+    return false;
+  }
+  const NodeDef* pred = node_map.GetNode(switch_node->input(1));
+  return pred != nullptr && pred->op() == "LoopCond";
+}
+
+// Returns true if the value of `node` only depends on its inputs, and it has
+// no reference input or output.
+bool IsStateless(const NodeDef& node, DataTypeVector* output_types) {
+  const OpDef* op_def = nullptr;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+      op_def->is_stateful()) {
+    return false;
+  }
+  DataTypeVector input_types;
+  if (!InOutTypesForNode(node, *op_def, &input_types, output_types).ok()) {
+    return false;
+  }
+  for (DataType type : input_types) {
+    if (IsRefType(type)) {
+      return false;
+    }
+  }
+  for (DataType type : *output_types) {
+    if (IsRefType(type)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+Status LoopOptimizer::LoopInvariantNodeMotion(
+    GraphDef* optimized_graph) const {
+  bool has_frames = false;
+  for (const NodeDef& node : optimized_graph->node()) {
+    has_frames |= IsEnter(node);
+  }
+  if (!has_frames) {
+    return Status::OK();
+  }
+
+  std::unordered_map<const NodeDef*, std::vector<int>> frames;
+  const int num_frames = IdentifyFrames(*optimized_graph, &frames);
+  // The outermost frames are processed first, and the nodes that are hoisted
+  // out of a frame are not hoisted further in this pass.
+  std::map<std::vector<int>, std::vector<NodeDef*>> frame_nodes;
+  for (int i = 0; i < optimized_graph->node_size(); ++i) {
+    NodeDef* node = optimized_graph->mutable_node(i);
+    if (!frames[node].empty()) {
+      frame_nodes[frames[node]].push_back(node);
+    }
+  }
+  NodeMap node_map(optimized_graph);
+  std::unordered_set<const NodeDef*> hoisted;
+  int num_hoisted = 0;
+
+  for (const auto& frame_and_nodes : frame_nodes) {
+    const std::vector<int>& frame = frame_and_nodes.first;
+    const NodeDef* frame_enter = nullptr;
+    for (const NodeDef* node : frame_and_nodes.second) {
+      if (IsEnter(*node)) {
+        frame_enter = node;
+        break;
+      }
+    }
+    if (frame_enter == nullptr) {
+      continue;
+    }
+    const auto in_frame = [&frames, &frame, &hoisted](const NodeDef* node) {
+      return frames[node] == frame && hoisted.count(node) == 0;
+    };
+    const auto has_control_flow_output = [&node_map](const NodeDef& node) {
+      for (const NodeDef* output : node_map.GetOutputs(node.name())) {
+        if (IsMerge(*output) || IsNextIteration(*output) || IsExit(*output)) {
+          return true;
+        }
+      }
+      return false;
+    };
+
+    // The invariant nodes of the frame, with the name of the pivot whose
+    // deadness they carry, or an empty string if they are always alive.
+    std::unordered_map<const NodeDef*, string> invariants;
+    std::unordered_map<const NodeDef*, DataTypeVector> output_types;
+    std::deque<const NodeDef*> queue;
+    for (const NodeDef* node : frame_and_nodes.second) {
+      if (IsConstantEnter(*node)) {
+        invariants[node] = "";
+        queue.push_back(node);
+        continue;
+      }
+      // The constants of a loop body depend on a pivot only to be part of the
+      // loop. Only the loops of the root frame are handled, since a constant
+      // moved out of a nested loop would be in the root frame.
+      if (!IsConstant(*node) || frame.size() != 1 || node->input_size() == 0 ||
+          nodes_to_preserve_.count(node->name()) > 0 ||
+          has_control_flow_output(*node)) {
+        continue;
+      }
+      bool depends_on_pivot_only = true;
+      for (const string& input : node->input()) {
+        const NodeDef* input_node = node_map.GetNode(input);
+        depends_on_pivot_only &= IsControlInput(input) && input_node &&
+                                 IsBodyPivot(*input_node, node_map);
+      }
+      DataTypeVector types;
+      if (depends_on_pivot_only && IsStateless(*node, &types)) {
+        invariants[node] = NodeName(node->input(0));
+        output_types[node] = types;
+        queue.push_back(node);
+      }
+    }
+    while (!queue.empty()) {
+      const NodeDef* node = queue.front();
+      queue.pop_front();
+      for (const NodeDef* output : node_map.GetOutputs(node->name())) {
+        if (invariants.count(output) > 0 || !in_frame(output) ||
+            IsControlFlow(*output) ||
+            nodes_to_preserve_.count(output->name()) > 0) {
+          continue;
+        }
+        string pivot;
+        bool is_invariant = true;
+        for (const string& input : output->input()) {
+          auto it = invariants.find(node_map.GetNode(input));
+          if (it == invariants.end()) {
+            is_invariant = false;
+            break;
+          }
+          if (pivot.empty()) {
+            pivot = it->second;
+          }
+        }
+        DataTypeVector types;
+        if (!is_invariant || !IsStateless(*output, &types) ||
+            (!pivot.empty() && has_control_flow_output(*output))) {
+          continue;
+        }
+        invariants[output] = pivot;
+        output_types[output] = types;
+        queue.push_back(output);
+      }
+    }
+
+    std::vector<NodeDef*> moved;
+    for (NodeDef* node : frame_and_nodes.second) {
+      if (invariants.count(node) > 0 && !IsConstantEnter(*node)) {
+        moved.push_back(node);
+      }
+    }
+    if (moved.empty()) {
+      continue;
+    }
+    VLOG(1) << "Hoisting " << moved.size() << " nodes out of the frame "
+            << frame_enter->attr().at("frame_name").s();
+
+    // Moves the invariant nodes to the enclosing frame.
+    std::unordered_set<const NodeDef*> moved_set(moved.begin(), moved.end());
+    for (NodeDef* node : moved) {
+      std::vector<string> data_inputs;
+      std::vector<string> control_inputs;
+      for (const string& input : node->input()) {
+        const NodeDef* input_node = node_map.GetNode(input);
+        string new_input = input;
+        if (IsConstantEnter(*input_node)) {
+          new_input = IsControlInput(input)
+                          ? AsControlDependency(NodeName(input_node->input(0)))
+                          : input_node->input(0);
+        } else if (moved_set.count(input_node) == 0) {
+          // A body pivot, which the moved constants no longer depend on.
+          continue;
+        }
+        std::vector<string>* inputs =
+            IsControlInput(new_input) ? &control_inputs : &data_inputs;
+        if (!IsControlInput(new_input) ||
+            std::find(inputs->begin(), inputs->end(), new_input) ==
+                inputs->end()) {
+          inputs->push_back(new_input);
+        }
+      }
+      node_map.RemoveInputs(node->name());
+      node->clear_input();
+      for (const string& input : data_inputs) {
+        node->add_input(input);
+        node_map.AddOutput(NodeName(input), node->name());
+      }
+      for (const string& input : control_inputs) {
+        node->add_input(input);
+        node_map.AddOutput(NodeName(input), node->name());
+      }
+    }
+
+    // Feeds the moved nodes to the rest of the frame through constant Enter
+    // nodes, one per output.
+    std::map<std::pair<const NodeDef*, int>, string> enters;
+    const auto get_enter = [&](NodeDef* node, int position) -> string {
+      auto it = enters.find({node, position});
+      if (it != enters.end()) {
+        return it->second;
+      }
+      string name = AddPrefixToNodeName(
+          strings::StrCat(node->name(), "_", position), kLoopInvariantEnter);
+      while (node_map.GetNode(name) != nullptr) {
+        name = strings::StrCat(name, "_");
+      }
+      NodeDef* enter = optimized_graph->add_node();
+      enter->set_name(name);
+      enter->set_op("Enter");
+      enter->set_device(node->device());
+      enter->add_input(position == 0 ? node->name()
+                                     : strings::StrCat(node->name(), ":",
+                                                       position));
+      (*enter->mutable_attr())["T"].set_type(output_types[node][position]);
+      (*enter->mutable_attr())["frame_name"] =
+          frame_enter->attr().at("frame_name");
+      (*enter->mutable_attr())["is_constant"].set_b(true);
+      auto parallel_iterations =
+          frame_enter->attr().find("parallel_iterations");
+      if (parallel_iterations != frame_enter->attr().end()) {
+        (*enter->mutable_attr())["parallel_iterations"] =
+            parallel_iterations->second;
+      }
+      node_map.AddNode(name, enter);
+      node_map.AddOutput(node->name(), name);
+      enters[{node, position}] = name;
+      return name;
+    };
+    for (NodeDef* node : moved) {
+      const string& pivot = invariants[node];
+      const std::set<NodeDef*> outputs = node_map.GetOutputs(node->name());
+      for (NodeDef* output : outputs) {
+        if (moved_set.count(output) > 0) {
+          continue;
+        }
+        for (int i = 0; i < output->input_size(); ++i) {
+          int position;
+          const string input = ParseNodeName(output->input(i), &position);
+          if (input != node->name()) {
+            continue;
+          }
+          if (position < 0) {
+            *output->mutable_input(i) = AsControlDependency(get_enter(node, 0));
+          } else {
+            *output->mutable_input(i) = get_enter(node, position);
+          }
+          node_map.AddOutput(NodeName(output->input(i)), output->name());
+        }
+        node_map.RemoveOutput(node->name(), output->name());
+        // The output stays dead in the last iteration of the loop.
+        if (!pivot.empty()) {
+          bool has_pivot = false;
+          for (const string& input : output->input()) {
+            has_pivot |= NodeName(input) == pivot;
+          }
+          if (!has_pivot) {
+            output->add_input(AsControlDependency(pivot));
+            node_map.AddOutput(pivot, output->name());
+          }
+        }
+      }
+      hoisted.insert(node);
+    }
+    num_hoisted += moved.size();
+  }
+  VLOG(1) << "Hoisted " << num_hoisted << " nodes out of " << num_frames
+          << " frames";
+  return Status::OK();
+}
+
+Status LoopOptimizer::Optimize(Cluster* /*cluster*/, const GrapplerItem& item,
+                               GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  nodes_to_preserve_ = item.NodesToPreserve();
+  return LoopInvariantNodeMotion(optimized_graph);
+}
+
+void LoopOptimizer::Feedback(Cluster* /*cluster*/, const GrapplerItem& /*item*/,
+                             const GraphDef& /*optimized_graph*/,
+                             double /*result*/) {
+  // Nothing to do for LoopOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,182 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class LoopOptimizerTest : public ::testing::Test {
+ protected:
+  static NodeDef* AddNode(const string& name, const string& op,
+                          const std::vector<string>& inputs,
+                          GraphDef* graph) {
+    NodeDef* node = graph->add_node();
+    node->set_name(name);
+    node->set_op(op);
+    for (const string& input : inputs) {
+      node->add_input(input);
+    }
+    const string type_attr =
+        op == "Const" || op == "RandomUniform" ? "dtype" : "T";
+    (*node->mutable_attr())[type_attr].set_type(DT_FLOAT);
+    if (op == "Enter") {
+      (*node->mutable_attr())["frame_name"].set_s("loop");
+      (*node->mutable_attr())["is_constant"].set_b(false);
+      (*node->mutable_attr())["parallel_iterations"].set_i(10);
+    }
+    return node;
+  }
+
+  static NodeDef* AddConstantEnter(const string& name, const string& input,
+                                   GraphDef* graph) {
+    NodeDef* enter = AddNode(name, "Enter", {input}, graph);
+    (*enter->mutable_attr())["is_constant"].set_b(true);
+    return enter;
+  }
+
+  // Adds a loop that runs while "i < limit" and whose body is
+  // "i = pivot + <body>", where "one" is a constant of the body.
+  static void AddLoop(const string& body, GraphDef* graph) {
+    AddNode("i", "Const", {}, graph);
+    AddNode("limit", "Const", {}, graph);
+    AddNode("enter_i", "Enter", {"i"}, graph);
+    AddConstantEnter("enter_limit", "limit", graph);
+    AddNode("merge", "Merge", {"enter_i", "next"}, graph);
+    AddNode("less", "Less", {"merge", "enter_limit"}, graph);
+    AddNode("cond", "LoopCond", {"less"}, graph);
+    AddNode("switch", "Switch", {"merge", "cond"}, graph);
+    AddNode("pivot", "Identity", {"switch:1"}, graph);
+    AddNode("one", "Const", {"^pivot"}, graph);
+    AddNode("body", "Add", {"pivot", body}, graph);
+    AddNode("next", "NextIteration", {"body"}, graph);
+    AddNode("exit", "Exit", {"switch"}, graph);
+  }
+
+  static const NodeDef* FindNode(const GraphDef& graph, const string& name) {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() == name) return &node;
+    }
+    return nullptr;
+  }
+
+  static std::vector<string> Inputs(const GraphDef& graph,
+                                    const string& name) {
+    const NodeDef* node = FindNode(graph, name);
+    if (node == nullptr) return {"not found"};
+    return std::vector<string>(node->input().begin(), node->input().end());
+  }
+};
+
+TEST_F(LoopOptimizerTest, HoistsInvariantNodes) {
+  GrapplerItem item;
+  item.fetch = {"exit"};
+  AddNode("x", "Const", {}, &item.graph);
+  AddLoop("invariant2", &item.graph);
+  AddConstantEnter("enter_x", "x", &item.graph);
+  AddNode("invariant1", "Mul", {"enter_x", "enter_x"}, &item.graph);
+  AddNode("invariant2", "Add", {"invariant1", "one"}, &item.graph);
+
+  LoopOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(std::vector<string>({"x", "x"}), Inputs(output, "invariant1"));
+  EXPECT_EQ(std::vector<string>({"invariant1", "one"}),
+            Inputs(output, "invariant2"));
+  EXPECT_TRUE(Inputs(output, "one").empty());
+  const string enter_name =
+      AddPrefixToNodeName("invariant2_0", "LoopInvariantEnter");
+  EXPECT_EQ(std::vector<string>({"pivot", enter_name}),
+            Inputs(output, "body"));
+  const NodeDef* enter = FindNode(output, enter_name);
+  ASSERT_NE(nullptr, enter);
+  EXPECT_EQ("Enter", enter->op());
+  EXPECT_EQ(std::vector<string>({"invariant2"}), Inputs(output, enter_name));
+  EXPECT_EQ("loop", enter->attr().at("frame_name").s());
+  EXPECT_TRUE(enter->attr().at("is_constant").b());
+  EXPECT_EQ(10, enter->attr().at("parallel_iterations").i());
+  EXPECT_EQ(DT_FLOAT, enter->attr().at("T").type());
+  // The rest of the loop is unchanged.
+  EXPECT_EQ(item.graph.node_size() + 1, output.node_size());
+  EXPECT_EQ(std::vector<string>({"merge", "enter_limit"}),
+            Inputs(output, "less"));
+}
+
+TEST_F(LoopOptimizerTest, KeepsStatefulNodes) {
+  GrapplerItem item;
+  item.fetch = {"exit"};
+  AddNode("shape", "Const", {}, &item.graph);
+  AddLoop("random", &item.graph);
+  AddConstantEnter("enter_shape", "shape", &item.graph);
+  AddNode("random", "RandomUniform", {"enter_shape"}, &item.graph);
+
+  LoopOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  EXPECT_EQ(std::vector<string>({"enter_shape"}), Inputs(output, "random"));
+  EXPECT_EQ(std::vector<string>({"pivot", "random"}), Inputs(output, "body"));
+}
+
+TEST_F(LoopOptimizerTest, KeepsDeadnessOfBodyConstants) {
+  GrapplerItem item;
+  item.fetch = {"exit"};
+  AddLoop("one", &item.graph);
+  // Moved along with "one", but its consumer must stay dead in the last
+  // iteration of the loop.
+  AddNode("two", "Add", {"one", "one"}, &item.graph);
+  AddNode("consumer", "Add", {"two", "merge"}, &item.graph);
+
+  GraphDef output;
+  LoopOptimizer optimizer;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(std::vector<string>({"one", "one"}), Inputs(output, "two"));
+  const string enter_name = AddPrefixToNodeName("two_0", "LoopInvariantEnter");
+  EXPECT_EQ(std::vector<string>({enter_name, "merge", "^pivot"}),
+            Inputs(output, "consumer"));
+  // The body still reads "one" from the loop.
+  EXPECT_EQ(std::vector<string>({"pivot",
+                                 AddPrefixToNodeName("one_0",
+                                                     "LoopInvariantEnter")}),
+            Inputs(output, "body"));
+}
+
+TEST_F(LoopOptimizerTest, KeepsBodyConstantsFedToNextIteration) {
+  GrapplerItem item;
+  item.fetch = {"exit"};
+  AddLoop("one", &item.graph);
+  AddNode("next2", "NextIteration", {"one"}, &item.graph);
+
+  LoopOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  EXPECT_EQ(std::vector<string>({"^pivot"}), Inputs(output, "one"));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
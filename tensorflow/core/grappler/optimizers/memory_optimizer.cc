@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/grappler/costs/graph_memory.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
@@ -453,7 +454,8 @@ void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
                   node.attr().count(kRecomputeHint) > 0);
         },
         is_target);
-  } else if (optimization_level == RewriterConfig::MANUAL) {
+  } else if (optimization_level == RewriterConfig::MANUAL ||
+             optimization_level == RewriterConfig::SWAPPING_HEURISTICS) {
     recomputed_subgraphs = GetOpGroupsToRecompute(
         graph, node_map,
         [&feeds, &is_target](const NodeDef& node) {
@@ -478,6 +480,7 @@ void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
 }
 
 std::pair<NodeDef*, NodeDef*> BuildSwapPair(NodeDef* node, int input_to_swap,
+                                            DataType input_type,
                                             GraphDef* graph) {
   string tensor_to_swap = strings::StrCat(node->name(), "_", input_to_swap);
 
@@ -498,7 +501,6 @@ std::pair<NodeDef*, NodeDef*> BuildSwapPair(NodeDef* node, int input_to_swap,
   (*swap_in_node->mutable_attr())["_class"].mutable_list()->add_s(coloc_group);
   (*node->mutable_attr())["_class"].mutable_list()->add_s(coloc_group);
 
-  const DataType input_type = node->attr().at("T").type();
   (*swap_in_node->mutable_attr())["T"].set_type(input_type);
   (*swap_out_node->mutable_attr())["T"].set_type(input_type);
   return std::make_pair(swap_out_node, swap_in_node);
@@ -525,9 +527,153 @@ static int64 EstimateSize(const OpInfo::TensorProperties& t) {
 
 struct SwapInfo {
   std::vector<int> inputs_to_swap;
+  // The types of inputs_to_swap.
+  std::vector<DataType> input_types;
   Costs::NanoSeconds time_to_swap = 0;
 };
 
+// Let's assume we're going to swap over PCIe running at 16 GBps.
+static Costs::NanoSeconds EstimateSwapTime(int64 bytes_to_swap) {
+  return Costs::NanoSeconds(bytes_to_swap / 16);
+}
+
+// Adds input 'input_id' to the inputs of 'node' to swap.
+static void AddSwapToHost(int input_id, NodeDef* node) {
+  AttrValue& val = (*node->mutable_attr())["_swap_to_host"];
+  if (val.value_case() == AttrValue::kI) {
+    const int64 other_id = val.i();
+    val.mutable_list()->add_i(other_id);
+  }
+  for (int64 i : val.list().i()) {
+    if (i == input_id) return;
+  }
+  val.mutable_list()->add_i(input_id);
+}
+
+// Tensors smaller than this are not worth swapping.
+static const int64 kMinBytesToSwap = 1024;
+
+// Marks tensors to be swapped with the _swap_to_host attribute of their last
+// consumer in 'optimized_graph', for the GPUs of 'cluster' whose estimated
+// peak memory usage exceeds their memory size.  Tensors are picked from those
+// live at the peak, longest unused first, until the excess is made up.  A
+// tensor is unused from its previous use until all the other inputs of its
+// last consumer are ready, and it is only picked if that gives enough time to
+// copy it out and back in.
+static void IdentifySwappingCandidates(Cluster* cluster,
+                                       const GrapplerItem& item,
+                                       GraphDef* optimized_graph) {
+  GraphMemory memory(item);
+  const std::unordered_map<string, DeviceProperties>& devices =
+      cluster->GetDevices();
+  Status s = memory.InferStatically(devices);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer memory usage: " << s;
+    return;
+  }
+  std::unordered_map<const NodeDef*, Costs::NanoSeconds> execution_times;
+  s = EstimateEarliestExecutionTimes(item, cluster, &execution_times);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to estimate execution times: " << s;
+    return;
+  }
+  std::unordered_map<string, Costs::NanoSeconds> times;
+  for (const auto& time : execution_times) {
+    times[time.first->name()] = time.second;
+  }
+
+  // The consumers of each output, and the inputs they consume it as.
+  std::unordered_map<string, std::vector<std::pair<NodeDef*, int>>> fanouts;
+  for (NodeDef& node : *optimized_graph->mutable_node()) {
+    for (int i = 0; i < node.input_size(); ++i) {
+      if (IsControlInput(node.input(i))) continue;
+      int position;
+      const string input_node = ParseNodeName(node.input(i), &position);
+      fanouts[strings::StrCat(input_node, ":", position)].emplace_back(&node,
+                                                                       i);
+    }
+  }
+
+  struct Candidate {
+    Costs::NanoSeconds unused_time;
+    int64 bytes;
+    NodeDef* consumer;
+    int input_id;
+  };
+  for (const auto& device : devices) {
+    if (device.second.type() != "GPU" || device.second.memory_size() <= 0) {
+      continue;
+    }
+    const GraphMemory::MemoryUsage& usage =
+        memory.GetPeakMemoryUsage(device.first);
+    int64 required_savings = usage.used_memory - device.second.memory_size();
+    if (required_savings <= 0) continue;
+
+    std::vector<Candidate> candidates;
+    for (const GraphMemory::LiveTensor& live : usage.live_tensors) {
+      if (live.memory_used < kMinBytesToSwap) continue;
+      auto producer_time = times.find(live.node);
+      auto fanout = fanouts.find(strings::StrCat(live.node, ":",
+                                                 live.output_id));
+      if (producer_time == times.end() || fanout == fanouts.end()) continue;
+
+      // Find the last use, and the one before.
+      Costs::NanoSeconds previous_use = producer_time->second;
+      Costs::NanoSeconds last_use(-1);
+      const std::pair<NodeDef*, int>* last_consumer = nullptr;
+      bool known = true;
+      for (const auto& consumer : fanout->second) {
+        auto time = times.find(consumer.first->name());
+        if (time == times.end()) {
+          known = false;
+          break;
+        }
+        if (time->second > last_use) {
+          if (last_consumer) previous_use = std::max(previous_use, last_use);
+          last_use = time->second;
+          last_consumer = &consumer;
+        } else {
+          previous_use = std::max(previous_use, time->second);
+        }
+      }
+      if (!known || last_consumer == nullptr) continue;
+      NodeDef* consumer = last_consumer->first;
+      if (IsNextIteration(*consumer) || IsSwitch(*consumer) ||
+          IsMerge(*consumer)) {
+        continue;
+      }
+
+      // The consumer cannot run before its other inputs are ready.
+      Costs::NanoSeconds ready(-1);
+      for (int i = 0; i < consumer->input_size(); ++i) {
+        if (i == last_consumer->second) continue;
+        auto time = times.find(NodeName(consumer->input(i)));
+        if (time != times.end()) ready = std::max(ready, time->second);
+      }
+      const Costs::NanoSeconds unused_time = ready - previous_use;
+      if (unused_time.count() <
+          2 * EstimateSwapTime(live.memory_used).count()) {
+        continue;
+      }
+      candidates.push_back({unused_time, static_cast<int64>(live.memory_used),
+                            consumer, last_consumer->second});
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) {
+                return a.unused_time > b.unused_time;
+              });
+    for (const Candidate& candidate : candidates) {
+      if (required_savings <= 0) break;
+      VLOG(1) << "Swapping input " << candidate.input_id << " of "
+              << candidate.consumer->name() << " (" << candidate.bytes
+              << " bytes) on " << device.first;
+      AddSwapToHost(candidate.input_id, candidate.consumer);
+      required_savings -= candidate.bytes;
+    }
+  }
+}
+
 static const NodeDef* FindSwapTrigger(
     const NodeDef* node, const SwapInfo& swap_info,
     const std::unordered_map<string, const NodeDef*>& name_map,
@@ -610,6 +756,11 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                              recomputation_targets_name_prefix_,
                              optimized_graph, item);
 
+  if (optimization_level_ == RewriterConfig::SWAPPING_HEURISTICS &&
+      cluster != nullptr) {
+    IdentifySwappingCandidates(cluster, item, optimized_graph);
+  }
+
   // Figure out what needs to be swapped;
   std::unordered_map<NodeDef*, SwapInfo> nodes_to_swap;
   for (auto& node : *optimized_graph->mutable_node()) {
@@ -644,9 +795,9 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
       for (int64 input_id : swap_info.inputs_to_swap) {
         const OpInfo::TensorProperties& t = props[input_id];
         bytes_to_swap += EstimateSize(t);
+        swap_info.input_types.push_back(BaseType(t.dtype()));
       }
-      // Let's assume we're going to swap over PCIe running at 16 GBps.
-      swap_info.time_to_swap = bytes_to_swap / 16;
+      swap_info.time_to_swap = EstimateSwapTime(bytes_to_swap);
     }
   }
 
@@ -672,9 +823,10 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
       continue;
     }
     // Swap all the tensors that are marked with the 'swap_to_host' attribute.
-    for (int input_id : swap_info.inputs_to_swap) {
-      std::pair<NodeDef*, NodeDef*> swap_nodes =
-          BuildSwapPair(node, input_id, optimized_graph);
+    for (int i = 0; i < swap_info.inputs_to_swap.size(); ++i) {
+      const int input_id = swap_info.inputs_to_swap[i];
+      std::pair<NodeDef*, NodeDef*> swap_nodes = BuildSwapPair(
+          node, input_id, swap_info.input_types[i], optimized_graph);
       *swap_nodes.first->add_input() = node->input(input_id);
       *node->mutable_input(input_id) = swap_nodes.second->name();
 
@@ -252,6 +252,52 @@ TEST_F(MemoryOptimizerTest, SimpleSwapping) {
   EXPECT_EQ("^c", swap_in.input(1));
 }
 
+TEST_F(MemoryOptimizerTest, SwappingHeuristics) {
+  // 'b' is used by 'c', and not again until 'f', after two large matmuls.
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Variable(s.WithOpName("a"), {1024, 1024}, DT_FLOAT);
+  Output b = ops::AddN(s.WithOpName("b"), {a});
+  Output c = ops::MatMul(s.WithOpName("c"), b, b);
+  Output d = ops::MatMul(s.WithOpName("d"), c, c);
+  Output e = ops::MatMul(s.WithOpName("e"), d, d);
+  Output f = ops::AddN(s.WithOpName("f"), {b, e});
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"f"};
+
+  DeviceProperties gpu_device;
+  gpu_device.set_type("GPU");
+  gpu_device.set_frequency(1000);
+  gpu_device.set_num_cores(1);
+  gpu_device.set_bandwidth(32);
+  // Less than the peak usage of several 4MB tensors.
+  gpu_device.set_memory_size(8 * 1024 * 1024);
+  std::unordered_map<string, DeviceProperties> devices;
+  devices["/job:localhost/replica:0/task:0/gpu:0"] = gpu_device;
+  VirtualCluster cluster(devices);
+
+  MemoryOptimizer optimizer(RewriterConfig::SWAPPING_HEURISTICS);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(&cluster, item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* new_f = node_map.GetNode("f");
+  ASSERT_NE(nullptr, new_f);
+  EXPECT_EQ("swap_in_f_0", new_f->input(0));
+  const NodeDef* swap_out = node_map.GetNode("swap_out_f_0");
+  ASSERT_NE(nullptr, swap_out);
+  EXPECT_EQ("b", swap_out->input(0));
+  EXPECT_EQ(DT_FLOAT, swap_out->attr().at("T").type());
+  // Inputs used again right away are not swapped.
+  EXPECT_EQ(nullptr, node_map.GetNode("swap_out_d_0"));
+
+  // Only manual annotations are honored at the MANUAL level.
+  MemoryOptimizer manual_optimizer(RewriterConfig::MANUAL);
+  TF_EXPECT_OK(manual_optimizer.Optimize(&cluster, item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
@@ -0,0 +1,208 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/core/grappler/optimizers/memory_placement.h"
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/graph_memory.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// The number of nodes listed in the breakdown of the memory of a device.
+const int kMaxListedNodes = 10;
+
+struct NodeMemory {
+  string node;
+  int64 bytes;
+};
+
+// The memory of the tensors that are live at the peak of "usage", by
+// producer, largest first.
+std::vector<NodeMemory> MemoryByNode(const GraphMemory::MemoryUsage& usage) {
+  std::map<string, int64> bytes;
+  for (const GraphMemory::LiveTensor& live : usage.live_tensors) {
+    bytes[live.node] += live.memory_used;
+  }
+  std::vector<NodeMemory> nodes;
+  for (const auto& node_and_bytes : bytes) {
+    nodes.push_back({node_and_bytes.first, node_and_bytes.second});
+  }
+  std::stable_sort(nodes.begin(), nodes.end(),
+                   [](const NodeMemory& a, const NodeMemory& b) {
+                     return a.bytes > b.bytes;
+                   });
+  return nodes;
+}
+
+string Breakdown(const std::vector<NodeMemory>& nodes) {
+  string breakdown;
+  for (int i = 0; i < nodes.size() && i < kMaxListedNodes; ++i) {
+    strings::StrAppend(&breakdown, "\n  ", nodes[i].node, ": ",
+                       nodes[i].bytes, " bytes");
+  }
+  if (nodes.size() > kMaxListedNodes) {
+    strings::StrAppend(&breakdown, "\n  and ", nodes.size() - kMaxListedNodes,
+                       " more nodes");
+  }
+  return breakdown;
+}
+
+// Whether "node" can run on any device that has a kernel for it: it has no
+// state, references or resources that tie it to its device or to other
+// nodes, and does not take part in control flow.
+bool IsMovable(const NodeDef& node) {
+  const OpDef* op_def;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+      op_def->is_stateful() || node.attr().count("_class") > 0 ||
+      IsSwitch(node) || IsMerge(node) || IsEnter(node) || IsExit(node) ||
+      IsNextIteration(node)) {
+    return false;
+  }
+  for (const auto* args : {&op_def->input_arg(), &op_def->output_arg()}) {
+    for (const OpDef::ArgDef& arg : *args) {
+      if (arg.is_ref() || arg.type() == DT_RESOURCE) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+Status MemoryPlacement::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                 GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  if (cluster == nullptr) {
+    return Status::OK();
+  }
+  const std::unordered_map<string, DeviceProperties>& devices =
+      cluster->GetDevices();
+  GraphMemory memory(item);
+  Status s = memory.InferStatically(devices);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer memory usage: " << s;
+    return Status::OK();
+  }
+
+  // The estimated peak usage of each device, updated as nodes move.
+  std::map<string, int64> usage;
+  string cpu;
+  for (const auto& device : devices) {
+    usage[device.first] = memory.GetPeakMemoryUsage(device.first).used_memory;
+    if (device.second.type() == "CPU" && (cpu.empty() || device.first < cpu)) {
+      cpu = device.first;
+    }
+  }
+  const auto fits = [&devices, &usage](const string& device, int64 bytes) {
+    const int64 limit = devices.at(device).memory_size();
+    return limit <= 0 || usage[device] + bytes <= limit;
+  };
+
+  NodeMap node_map(optimized_graph);
+  string errors;
+  for (const auto& device_and_usage : usage) {
+    const string& device = device_and_usage.first;
+    const DeviceProperties& properties = devices.at(device);
+    if (properties.type() == "CPU" || fits(device, 0)) {
+      continue;
+    }
+    const std::vector<NodeMemory> nodes =
+        MemoryByNode(memory.GetPeakMemoryUsage(device));
+    LOG(WARNING) << "The estimated peak memory usage of " << device << " is "
+                 << usage[device] << " bytes, over its "
+                 << properties.memory_size() << " bytes:" << Breakdown(nodes);
+
+    for (const NodeMemory& node_memory : nodes) {
+      if (fits(device, 0)) {
+        break;
+      }
+      NodeDef* node = node_map.GetNode(node_memory.node);
+      if (node == nullptr || !IsMovable(*node)) {
+        continue;
+      }
+      // Prefers the device of the same type with the most room left.
+      string target;
+      for (const auto& other : devices) {
+        if (other.first == device ||
+            other.second.type() != properties.type() ||
+            !fits(other.first, node_memory.bytes)) {
+          continue;
+        }
+        if (target.empty() ||
+            other.second.memory_size() - usage[other.first] >
+                devices.at(target).memory_size() - usage[target]) {
+          target = other.first;
+        }
+      }
+      if (target.empty() && !cpu.empty() && fits(cpu, node_memory.bytes)) {
+        target = cpu;
+      }
+      if (target.empty() ||
+          !FindKernelDef(DeviceType(devices.at(target).type()), *node,
+                         nullptr, nullptr)
+               .ok()) {
+        continue;
+      }
+      LOG(WARNING) << "Moving " << node->name() << " from " << device
+                   << " to " << target << " to free " << node_memory.bytes
+                   << " bytes";
+      node->set_device(target);
+      usage[device] -= node_memory.bytes;
+      usage[target] += node_memory.bytes;
+    }
+    if (!fits(device, 0)) {
+      strings::StrAppend(&errors, "\n", device, " needs ", usage[device],
+                         " bytes, but has ", properties.memory_size(), ":",
+                         Breakdown(nodes));
+    }
+  }
+  if (!errors.empty()) {
+    return errors::ResourceExhausted(
+        "The estimated peak memory usage of the graph exceeds the memory of "
+        "its devices:",
+        errors);
+  }
+  return Status::OK();
+}
+
+void MemoryPlacement::Feedback(Cluster* /*cluster*/,
+                               const GrapplerItem& /*item*/,
+                               const GraphDef& /*optimized_graph*/,
+                               double /*result*/) {
+  // Nothing to do for MemoryPlacement.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,53 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_MEMORY_PLACEMENT_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_MEMORY_PLACEMENT_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Check the placement of a graph against the memory of its devices, before
+// running it: the peak memory usage of each device is estimated by
+// simulating a step of the graph on the cluster, and for the devices other
+// than CPUs whose estimate exceeds their memory, the largest tensors that
+// are live at the peak are listed in a warning. Their producers are then
+// moved to another device of the same type that has room for them, or else
+// to a CPU, as long as they are stateless and have a kernel there. If the
+// device still does not fit its tensors, the optimization fails with a
+// ResourceExhausted error, so that the session fails when it builds the
+// graph instead of when it runs out of memory during the step.
+class MemoryPlacement : public GraphOptimizer {
+ public:
+  MemoryPlacement() {}
+  ~MemoryPlacement() override {}
+
+  string name() const override { return "memory_placement"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_MEMORY_PLACEMENT_H_
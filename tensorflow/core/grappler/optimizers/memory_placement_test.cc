@@ -0,0 +1,131 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/core/grappler/optimizers/memory_placement.h"
+
+#include <memory>
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+const char kGpu[] = "/job:localhost/replica:0/task:0/gpu:0";
+const char kCpu[] = "/job:localhost/replica:0/task:0/cpu:0";
+
+class MemoryPlacementTest : public ::testing::Test {
+ protected:
+  static std::unique_ptr<VirtualCluster> CreateVirtualCluster(
+      int64 gpu_memory_size, bool with_cpu = true) {
+    DeviceProperties cpu_device;
+    cpu_device.set_type("CPU");
+    cpu_device.set_frequency(1000);
+    cpu_device.set_num_cores(4);
+    cpu_device.set_bandwidth(32);
+    DeviceProperties gpu_device;
+    gpu_device.set_type("GPU");
+    gpu_device.set_frequency(1000);
+    gpu_device.set_num_cores(1);
+    gpu_device.set_bandwidth(32);
+    gpu_device.set_memory_size(gpu_memory_size);
+    std::unordered_map<string, DeviceProperties> devices;
+    if (with_cpu) {
+      devices[kCpu] = cpu_device;
+    }
+    devices[kGpu] = gpu_device;
+    return std::unique_ptr<VirtualCluster>(new VirtualCluster(devices));
+  }
+
+  // A graph of several 4MB tensors, all placed on the GPU.
+  static GrapplerItem CreateItem() {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(kGpu);
+    Output a = ops::Variable(s.WithOpName("a"), {1024, 1024}, DT_FLOAT);
+    Output b = ops::AddN(s.WithOpName("b"), {a});
+    Output c = ops::MatMul(s.WithOpName("c"), b, b);
+    Output d = ops::MatMul(s.WithOpName("d"), c, c);
+    Output e = ops::MatMul(s.WithOpName("e"), d, d);
+    Output f = ops::AddN(s.WithOpName("f"), {b, e});
+
+    GrapplerItem item;
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    item.fetch = {"f"};
+    return item;
+  }
+};
+
+TEST_F(MemoryPlacementTest, KeepsPlacementThatFits) {
+  GrapplerItem item = CreateItem();
+  std::unique_ptr<VirtualCluster> cluster(
+      CreateVirtualCluster(1024 * 1024 * 1024));
+
+  MemoryPlacement optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  ASSERT_EQ(item.graph.node_size(), output.node_size());
+  for (const NodeDef& node : output.node()) {
+    EXPECT_EQ(kGpu, node.device()) << node.name();
+  }
+}
+
+TEST_F(MemoryPlacementTest, MovesLiveTensorsToCpu) {
+  GrapplerItem item = CreateItem();
+  // Less than the peak usage of several 4MB tensors.
+  std::unique_ptr<VirtualCluster> cluster(
+      CreateVirtualCluster(10 * 1024 * 1024));
+
+  MemoryPlacement optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  NodeMap node_map(&output);
+  // The variable is stateful, so it stays on its device.
+  EXPECT_EQ(kGpu, node_map.GetNode("a")->device());
+  int moved = 0;
+  for (const string& name : {"b", "c", "d", "e", "f"}) {
+    const string& device = node_map.GetNode(name)->device();
+    if (device == kCpu) {
+      ++moved;
+    } else {
+      EXPECT_EQ(kGpu, device) << name;
+    }
+  }
+  EXPECT_LT(0, moved);
+}
+
+TEST_F(MemoryPlacementTest, FailsWithoutRoomForTensors) {
+  GrapplerItem item = CreateItem();
+  // There is no other device to move the nodes to.
+  std::unique_ptr<VirtualCluster> cluster(
+      CreateVirtualCluster(10 * 1024 * 1024, false /* with_cpu */));
+
+  MemoryPlacement optimizer;
+  GraphDef output;
+  Status s = optimizer.Optimize(cluster.get(), item, &output);
+  EXPECT_TRUE(errors::IsResourceExhausted(s)) << s;
+  EXPECT_NE(string::npos, s.error_message().find(kGpu)) << s;
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
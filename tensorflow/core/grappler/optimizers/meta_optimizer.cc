@@ -14,21 +14,170 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
 #include "tensorflow/core/grappler/optimizers/auto_parallel.h"
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
+#include "tensorflow/core/grappler/optimizers/data_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/dependency_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/function_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/fusion_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/layout_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/memory_placement.h"
 #include "tensorflow/core/grappler/optimizers/model_pruner.h"
+#include "tensorflow/core/grappler/optimizers/quantization_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/scoped_allocator_optimizer.h"
+#include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
 namespace grappler {
 
+namespace {
+
+// The names in the optimizers field of the passes that only rewrite nodes
+// locally, by the names of their optimizers. These passes can run on the
+// connected components of a graph separately.
+const std::map<string, string>& LocalPasses() {
+  static const std::map<string, string>* local_passes =
+      new std::map<string, string>({{"function_optimizer", "function"},
+                                    {"auto_mixed_precision",
+                                     "auto_mixed_precision"},
+                                    {"quantization_optimizer", "quantization"},
+                                    {"constant folding", "constfold"},
+                                    {"arithmetic_optimizer", "arithmetic"},
+                                    {"loop_optimizer", "loop"},
+                                    {"dependency_optimizer", "dependency"},
+                                    {"fusion_optimizer", "fusion"}});
+  return *local_passes;
+}
+
+bool IsLocalPass(const GraphOptimizer& optimizer) {
+  return LocalPasses().count(optimizer.name()) > 0;
+}
+
+int FindRoot(std::vector<int>* parents, int id) {
+  while ((*parents)[id] != id) {
+    (*parents)[id] = (*parents)[(*parents)[id]];
+    id = (*parents)[id];
+  }
+  return id;
+}
+
+// Splits the nodes of "graph" into up to "num_parts" groups of weakly
+// connected components of similar sizes. Returns no groups if the graph is
+// connected.
+std::vector<std::vector<int>> PartitionGraph(const GraphDef& graph,
+                                             int num_parts) {
+  std::unordered_map<string, int> ids;
+  for (int i = 0; i < graph.node_size(); ++i) {
+    ids[graph.node(i).name()] = i;
+  }
+  std::vector<int> parents(graph.node_size());
+  std::iota(parents.begin(), parents.end(), 0);
+  for (int i = 0; i < graph.node_size(); ++i) {
+    for (const string& input : graph.node(i).input()) {
+      auto it = ids.find(NodeName(input));
+      if (it == ids.end()) {
+        continue;
+      }
+      const int a = FindRoot(&parents, i);
+      const int b = FindRoot(&parents, it->second);
+      parents[std::max(a, b)] = std::min(a, b);
+    }
+  }
+  std::map<int, std::vector<int>> components;
+  for (int i = 0; i < graph.node_size(); ++i) {
+    components[FindRoot(&parents, i)].push_back(i);
+  }
+  if (components.size() < 2) {
+    return {};
+  }
+
+  // Adds the components to the smallest group, starting with the largest.
+  std::vector<const std::vector<int>*> sorted_components;
+  for (const auto& root_and_nodes : components) {
+    sorted_components.push_back(&root_and_nodes.second);
+  }
+  std::stable_sort(sorted_components.begin(), sorted_components.end(),
+                   [](const std::vector<int>* a, const std::vector<int>* b) {
+                     return a->size() > b->size();
+                   });
+  std::vector<std::vector<int>> parts(
+      std::min<size_t>(num_parts, components.size()));
+  for (const std::vector<int>* component : sorted_components) {
+    auto smallest = std::min_element(
+        parts.begin(), parts.end(),
+        [](const std::vector<int>& a, const std::vector<int>& b) {
+          return a.size() < b.size();
+        });
+    smallest->insert(smallest->end(), component->begin(), component->end());
+  }
+  for (auto& part : parts) {
+    std::sort(part.begin(), part.end());
+  }
+  return parts;
+}
+
+// Returns the item made of the nodes "nodes" of "item".
+GrapplerItem PartialItem(const GrapplerItem& item,
+                         const std::vector<int>& nodes) {
+  GrapplerItem partial_item;
+  partial_item.id = item.id;
+  *partial_item.graph.mutable_versions() = item.graph.versions();
+  *partial_item.graph.mutable_library() = item.graph.library();
+  std::unordered_set<string> names;
+  for (int i : nodes) {
+    *partial_item.graph.add_node() = item.graph.node(i);
+    names.insert(item.graph.node(i).name());
+  }
+  const auto in_part = [&names](const string& name) {
+    return names.count(NodeName(name)) > 0;
+  };
+  for (const auto& feed : item.feed) {
+    if (in_part(feed.first)) {
+      partial_item.feed.push_back(feed);
+    }
+  }
+  for (const string& fetch : item.fetch) {
+    if (in_part(fetch)) {
+      partial_item.fetch.push_back(fetch);
+    }
+  }
+  partial_item.static_feed_shapes = item.static_feed_shapes;
+  for (const string& init_op : item.init_ops) {
+    if (in_part(init_op)) {
+      partial_item.init_ops.push_back(init_op);
+    }
+  }
+  if (in_part(item.save_op)) {
+    partial_item.save_op = item.save_op;
+  }
+  if (in_part(item.restore_op)) {
+    partial_item.restore_op = item.restore_op;
+  }
+  if (in_part(item.save_restore_loc_tensor)) {
+    partial_item.save_restore_loc_tensor = item.save_restore_loc_tensor;
+  }
+  return partial_item;
+}
+
+}  // namespace
+
 std::unique_ptr<GraphOptimizer> MetaOptimizer::NewOptimizer(
     const string& optimizer) {
   VLOG(1) << "Adding graph optimization pass: " << optimizer;
@@ -36,6 +185,19 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::NewOptimizer(
   if (optimizer == "pruning") {
     graph_optimizer.reset(new ModelPruner());
   }
+  if (optimizer == "data") {
+    graph_optimizer.reset(new DataOptimizer(cfg_.data_optimization()));
+  }
+  if (optimizer == "function") {
+    graph_optimizer.reset(
+        new FunctionOptimizer(cfg_.function_optimization()));
+  }
+  if (optimizer == "auto_mixed_precision") {
+    graph_optimizer.reset(new AutoMixedPrecision(cfg_.auto_mixed_precision()));
+  }
+  if (optimizer == "quantization") {
+    graph_optimizer.reset(new QuantizationOptimizer(cfg_.quantization()));
+  }
   if (optimizer == "constfold") {
     graph_optimizer.reset(new ConstantFolding(cpu_device_));
   }
@@ -49,9 +211,26 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::NewOptimizer(
     graph_optimizer.reset(
         new ArithmeticOptimizer(cfg_.arithmetic_optimization()));
   }
+  if (optimizer == "loop") {
+    graph_optimizer.reset(new LoopOptimizer(cfg_.loop_optimization()));
+  }
+  if (optimizer == "dependency") {
+    graph_optimizer.reset(
+        new DependencyOptimizer(cfg_.dependency_optimization()));
+  }
+  if (optimizer == "fusion") {
+    graph_optimizer.reset(new FusionOptimizer());
+  }
+  if (optimizer == "scoped_allocator") {
+    graph_optimizer.reset(new ScopedAllocatorOptimizer());
+  }
+  if (optimizer == "memory_placement") {
+    graph_optimizer.reset(new MemoryPlacement());
+  }
   if (optimizer == "autoparallel") {
     graph_optimizer.reset(
-        new AutoParallel(cfg_.auto_parallel().num_replicas()));
+        new AutoParallel(cfg_.auto_parallel().num_replicas(),
+                         cfg_.auto_parallel().num_pipeline_stages()));
   }
   return graph_optimizer;
 }
@@ -63,6 +242,22 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
     if (!cfg_.disable_model_pruning()) {
       optimizers.push_back(std::unique_ptr<GraphOptimizer>(new ModelPruner()));
     }
+    if (cfg_.data_optimization() != RewriterConfig::OFF) {
+      optimizers.push_back(std::unique_ptr<GraphOptimizer>(
+          new DataOptimizer(cfg_.data_optimization())));
+    }
+    if (cfg_.function_optimization() != RewriterConfig::OFF) {
+      optimizers.push_back(std::unique_ptr<GraphOptimizer>(
+          new FunctionOptimizer(cfg_.function_optimization())));
+    }
+    if (cfg_.auto_mixed_precision() == RewriterConfig::ON) {
+      optimizers.push_back(std::unique_ptr<GraphOptimizer>(
+          new AutoMixedPrecision(cfg_.auto_mixed_precision())));
+    }
+    if (cfg_.quantization().enable()) {
+      optimizers.push_back(std::unique_ptr<GraphOptimizer>(
+          new QuantizationOptimizer(cfg_.quantization())));
+    }
     if (cfg_.constant_folding() != RewriterConfig::OFF) {
       optimizers.push_back(
           std::unique_ptr<GraphOptimizer>(new ConstantFolding(cpu_device_)));
@@ -71,10 +266,22 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
       optimizers.push_back(std::unique_ptr<GraphOptimizer>(
           new ArithmeticOptimizer(cfg_.arithmetic_optimization())));
     }
+    if (cfg_.loop_optimization() != RewriterConfig::OFF) {
+      optimizers.push_back(std::unique_ptr<GraphOptimizer>(
+          new LoopOptimizer(cfg_.loop_optimization())));
+    }
+    if (cfg_.dependency_optimization() != RewriterConfig::OFF) {
+      optimizers.push_back(std::unique_ptr<GraphOptimizer>(
+          new DependencyOptimizer(cfg_.dependency_optimization())));
+    }
     if (cfg_.optimize_tensor_layout()) {
       optimizers.push_back(
           std::unique_ptr<GraphOptimizer>(new LayoutOptimizer()));
     }
+    if (cfg_.op_fusion() != RewriterConfig::OFF) {
+      optimizers.push_back(
+          std::unique_ptr<GraphOptimizer>(new FusionOptimizer()));
+    }
     if (cfg_.memory_optimization() > 1) {
       if (cfg_.memory_optimizer_target_node_name_prefix().empty()) {
         optimizers.push_back(std::unique_ptr<GraphOptimizer>(
@@ -87,14 +294,25 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                 cfg_.memory_optimizer_target_node_name_prefix())));
       }
     }
+    if (cfg_.scoped_allocator_optimization() == RewriterConfig::ON) {
+      optimizers.push_back(
+          std::unique_ptr<GraphOptimizer>(new ScopedAllocatorOptimizer()));
+    }
+    if (cfg_.memory_placement() == RewriterConfig::ON) {
+      optimizers.push_back(
+          std::unique_ptr<GraphOptimizer>(new MemoryPlacement()));
+    }
     if (cfg_.auto_parallel().enable()) {
       optimizers.push_back(std::unique_ptr<GraphOptimizer>(
-          new AutoParallel(cfg_.auto_parallel().num_replicas())));
+          new AutoParallel(cfg_.auto_parallel().num_replicas(),
+                           cfg_.auto_parallel().num_pipeline_stages())));
     }
   } else {
-    std::set<string> available_optimizers = {"pruning",      "constfold",
-                                             "layout",       "memory",
-                                             "autoparallel", "arithmetic"};
+    std::set<string> available_optimizers = {
+        "pruning",    "constfold",  "layout", "memory", "autoparallel",
+        "arithmetic", "dependency", "fusion", "loop",   "function",
+        "auto_mixed_precision", "quantization", "data", "memory_placement",
+        "scoped_allocator"};
     for (const auto& optimizer : cfg_.optimizers()) {
       if (available_optimizers.find(optimizer) != available_optimizers.end()) {
         optimizers.push_back(NewOptimizer(optimizer));
@@ -107,18 +325,44 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
     return Status::OK();
   }
 
+  start_us_ = Env::Default()->NowMicros();
+  out_of_time_ = false;
+  {
+    mutex_lock l(mu_);
+    pass_times_us_.clear();
+  }
   bool already_optimized = false;
-  for (const auto& optimizer : optimizers) {
+  for (size_t i = 0; i < optimizers.size();) {
+    // The consecutive local passes run together on each group of connected
+    // components.
+    std::vector<GraphOptimizer*> passes = {optimizers[i++].get()};
+    if (cfg_.meta_optimizer_num_threads() > 1 && IsLocalPass(*passes[0])) {
+      while (i < optimizers.size() && IsLocalPass(*optimizers[i])) {
+        passes.push_back(optimizers[i++].get());
+      }
+    }
     if (!already_optimized) {
-      TF_RETURN_IF_ERROR(optimizer->Optimize(cluster, item, optimized_graph));
+      TF_RETURN_IF_ERROR(RunPassGroup(cluster, item, passes, optimized_graph));
       already_optimized = true;
     } else {
       GrapplerItem optimized_item(item, std::move(*optimized_graph));
       TF_RETURN_IF_ERROR(
-          optimizer->Optimize(cluster, optimized_item, optimized_graph));
+          RunPassGroup(cluster, optimized_item, passes, optimized_graph));
+    }
+    if (OutOfTime()) {
+      break;
     }
   }
   TopologicalSort(optimized_graph);
+  if (VLOG_IS_ON(1)) {
+    mutex_lock l(mu_);
+    for (const auto& pass_and_time : pass_times_us_) {
+      VLOG(1) << "Time spent in " << pass_and_time.first << ": "
+              << pass_and_time.second / 1000.0 << " ms";
+    }
+    VLOG(1) << "Time spent in " << name() << ": "
+            << (Env::Default()->NowMicros() - start_us_) / 1000.0 << " ms";
+  }
 
   // Make sure that the optimizers preserved the graph version and library.
   DCHECK_GE(optimized_graph->library().function_size(),
@@ -131,6 +375,114 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   return Status::OK();
 }
 
+Status MetaOptimizer::RunPasses(Cluster* cluster, const GrapplerItem& item,
+                                const std::vector<GraphOptimizer*>& passes,
+                                GraphDef* optimized_graph) {
+  bool already_optimized = false;
+  for (GraphOptimizer* pass : passes) {
+    if (OutOfTime()) {
+      break;
+    }
+    const uint64 pass_start_us = Env::Default()->NowMicros();
+    if (!already_optimized) {
+      TF_RETURN_IF_ERROR(pass->Optimize(cluster, item, optimized_graph));
+      already_optimized = true;
+    } else {
+      GrapplerItem optimized_item(item, std::move(*optimized_graph));
+      TF_RETURN_IF_ERROR(
+          pass->Optimize(cluster, optimized_item, optimized_graph));
+    }
+    RecordPassTime(pass->name(), Env::Default()->NowMicros() - pass_start_us);
+  }
+  if (!already_optimized) {
+    *optimized_graph = item.graph;
+  }
+  return Status::OK();
+}
+
+Status MetaOptimizer::RunPassGroup(Cluster* cluster, const GrapplerItem& item,
+                                   const std::vector<GraphOptimizer*>& passes,
+                                   GraphDef* optimized_graph) {
+  std::vector<std::vector<int>> parts;
+  if (cfg_.meta_optimizer_num_threads() > 1 && IsLocalPass(*passes[0])) {
+    parts = PartitionGraph(item.graph, cfg_.meta_optimizer_num_threads());
+  }
+  if (parts.size() < 2) {
+    return RunPasses(cluster, item, passes, optimized_graph);
+  }
+  VLOG(1) << "Running " << passes.size() << " passes on " << parts.size()
+          << " groups of connected components concurrently";
+
+  std::vector<GraphDef> outputs(parts.size());
+  std::vector<Status> statuses(parts.size());
+  {
+    thread::ThreadPool pool(Env::Default(), "meta_optimizer", parts.size());
+    for (size_t i = 0; i < parts.size(); ++i) {
+      pool.Schedule([this, cluster, &item, &passes, &parts, &outputs,
+                     &statuses, i]() {
+        // The optimizers keep the state of the graph they optimize.
+        std::vector<std::unique_ptr<GraphOptimizer>> optimizers;
+        std::vector<GraphOptimizer*> part_passes;
+        for (GraphOptimizer* pass : passes) {
+          optimizers.push_back(
+              NewOptimizer(LocalPasses().at(pass->name())));
+          part_passes.push_back(optimizers.back().get());
+        }
+        statuses[i] = RunPasses(cluster, PartialItem(item, parts[i]),
+                                part_passes, &outputs[i]);
+      });
+    }
+  }
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+
+  optimized_graph->Clear();
+  *optimized_graph->mutable_versions() = item.graph.versions();
+  optimized_graph->mutable_library()->Swap(outputs[0].mutable_library());
+  for (GraphDef& output : outputs) {
+    for (int i = 0; i < output.node_size(); ++i) {
+      optimized_graph->add_node()->Swap(output.mutable_node(i));
+    }
+  }
+  return Status::OK();
+}
+
+bool MetaOptimizer::OutOfTime() {
+  if (out_of_time_) {
+    return true;
+  }
+  const int64 elapsed_us = Env::Default()->NowMicros() - start_us_;
+  if (cfg_.meta_optimizer_timeout_ms() > 0 &&
+      elapsed_us > cfg_.meta_optimizer_timeout_ms() * 1000) {
+    if (!out_of_time_.exchange(true)) {
+      LOG(WARNING) << "Skipping the remaining graph optimization passes after "
+                   << elapsed_us / 1000 << " ms, more than the budget of "
+                   << cfg_.meta_optimizer_timeout_ms() << " ms";
+    }
+    return true;
+  }
+  return false;
+}
+
+void MetaOptimizer::RecordPassTime(const string& pass, uint64 micros) {
+  VLOG(2) << "Graph optimization pass " << pass << " took " << micros / 1000.0
+          << " ms";
+  {
+    mutex_lock l(mu_);
+    pass_times_us_[pass] += micros;
+  }
+  if (cfg_.pass_timeout_ms() > 0 &&
+      static_cast<int64>(micros) > cfg_.pass_timeout_ms() * 1000) {
+    if (!out_of_time_.exchange(true)) {
+      LOG(WARNING) << "Skipping the remaining graph optimization passes, since "
+                   << pass << " took " << micros / 1000
+                   << " ms, more than the budget of " << cfg_.pass_timeout_ms()
+                   << " ms";
+    }
+  }
+}
+
 void MetaOptimizer::Feedback(Cluster* cluster, const GrapplerItem& item,
                              const GraphDef& pruned_graph, double result) {
   // Nothing to do for MetaOptimizer.
@@ -140,6 +492,15 @@ bool MetaOptimizerEnabled(const RewriterConfig& cfg) {
   return !cfg.disable_model_pruning() || cfg.optimize_tensor_layout() ||
          cfg.constant_folding() != RewriterConfig::OFF ||
          cfg.arithmetic_optimization() != RewriterConfig::OFF ||
+         cfg.op_fusion() != RewriterConfig::OFF ||
+         cfg.dependency_optimization() != RewriterConfig::OFF ||
+         cfg.loop_optimization() != RewriterConfig::OFF ||
+         cfg.function_optimization() != RewriterConfig::OFF ||
+         cfg.data_optimization() != RewriterConfig::OFF ||
+         cfg.auto_mixed_precision() == RewriterConfig::ON ||
+         cfg.quantization().enable() ||
+         cfg.memory_placement() == RewriterConfig::ON ||
+         cfg.scoped_allocator_optimization() == RewriterConfig::ON ||
          cfg.auto_parallel().enable() || cfg.memory_optimization() > 1 ||
          !cfg.optimizers().empty();
 }
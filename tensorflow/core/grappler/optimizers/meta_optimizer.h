@@ -16,16 +16,26 @@ limitations under the License.
 #ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_META_OPTIMIZER_H_
 #define TENSORFLOW_GRAPPLER_OPTIMIZERS_META_OPTIMIZER_H_
 
+#include <atomic>
+#include <map>
+#include <vector>
+
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 
 namespace tensorflow {
 namespace grappler {
 
 // Run the other grappler optimizers based on the specified rewriter config.
+//
+// The passes run one after another, within the time budgets of the config.
+// With several threads, the consecutive passes that only rewrite nodes
+// locally run concurrently on groups of connected components of the graph.
 class MetaOptimizer : public GraphOptimizer {
  public:
   MetaOptimizer(DeviceBase* cpu_device, const RewriterConfig& cfg)
@@ -42,8 +52,29 @@ class MetaOptimizer : public GraphOptimizer {
 
  private:
   std::unique_ptr<GraphOptimizer> NewOptimizer(const string& optimizer);
+
+  // Runs "passes" on "item" one after another, until the time budgets run
+  // out.
+  Status RunPasses(Cluster* cluster, const GrapplerItem& item,
+                   const std::vector<GraphOptimizer*>& passes,
+                   GraphDef* optimized_graph);
+  // Runs "passes" on "item". If they are local passes and the graph has
+  // several connected components, new instances of them run on each group of
+  // components concurrently instead.
+  Status RunPassGroup(Cluster* cluster, const GrapplerItem& item,
+                      const std::vector<GraphOptimizer*>& passes,
+                      GraphDef* optimized_graph);
+  // Returns true once the time budget of the meta-optimizer or of one of
+  // its passes ran out.
+  bool OutOfTime();
+  void RecordPassTime(const string& pass, uint64 micros);
+
   DeviceBase* const cpu_device_;  // may be NULL
   RewriterConfig cfg_;
+  uint64 start_us_ = 0;
+  std::atomic<bool> out_of_time_{false};
+  mutex mu_;
+  std::map<string, uint64> pass_times_us_ GUARDED_BY(mu_);
 };
 
 bool MetaOptimizerEnabled(const RewriterConfig& cfg);
@@ -0,0 +1,82 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class MetaOptimizerTest : public ::testing::Test {
+ protected:
+  // Two unconnected graphs that constant folding reduces to one node each.
+  static GrapplerItem TwoComponents() {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+    Output a1 = ops::Const(s.WithOpName("a1"), 1.0f, {1});
+    Output b1 = ops::Const(s.WithOpName("b1"), 2.0f, {1});
+    Output c1 = ops::AddN(s.WithOpName("c1"), {a1, b1});
+    Output a2 = ops::Const(s.WithOpName("a2"), 3.0f, {1});
+    Output b2 = ops::Const(s.WithOpName("b2"), 4.0f, {1});
+    Output c2 = ops::AddN(s.WithOpName("c2"), {a2, b2});
+
+    GrapplerItem item;
+    item.fetch.push_back("c1");
+    item.fetch.push_back("c2");
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    return item;
+  }
+};
+
+TEST_F(MetaOptimizerTest, ComponentsInParallel) {
+  GrapplerItem item = TwoComponents();
+  RewriterConfig cfg;
+  cfg.set_meta_optimizer_num_threads(2);
+  MetaOptimizer optimizer(nullptr, cfg);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(2, output.node_size());
+  for (const NodeDef& node : output.node()) {
+    EXPECT_TRUE(node.name() == "c1" || node.name() == "c2") << node.name();
+    EXPECT_EQ("Const", node.op());
+  }
+  EXPECT_EQ(item.graph.versions().producer(), output.versions().producer());
+}
+
+TEST_F(MetaOptimizerTest, SkipsPassesOutOfTime) {
+  GrapplerItem item = TwoComponents();
+  RewriterConfig cfg;
+  cfg.set_meta_optimizer_timeout_ms(1);
+  // Enough passes to run out of time before constant folding.
+  for (int i = 0; i < 1000; ++i) {
+    cfg.add_optimizers("pruning");
+  }
+  cfg.add_optimizers("constfold");
+  MetaOptimizer optimizer(nullptr, cfg);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // The nodes are not folded.
+  EXPECT_EQ(6, output.node_size());
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
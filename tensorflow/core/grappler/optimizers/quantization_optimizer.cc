@@ -0,0 +1,381 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/core/grappler/optimizers/quantization_optimizer.h"
+
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// The quantized equivalents of the float ops whose output range follows
+// from their input range, so that they can consume and produce eight-bit
+// tensors without a requantization.
+const std::unordered_map<string, string>& QuantizedOps() {
+  static const std::unordered_map<string, string>* quantized_ops =
+      new std::unordered_map<string, string>(
+          {{"AvgPool", "QuantizedAvgPool"},
+           {"MaxPool", "QuantizedMaxPool"},
+           {"Relu", "QuantizedRelu"},
+           {"Relu6", "QuantizedRelu6"},
+           {"Reshape", "QuantizedReshape"}});
+  return *quantized_ops;
+}
+
+// The ops of the conversions that may be left without outputs by the
+// rewrites, and can then be deleted.
+bool IsConversionOp(const NodeDef& node) {
+  static const std::unordered_set<string>* conversion_ops =
+      new std::unordered_set<string>({"Const", "Dequantize", "Max", "Min",
+                                      "QuantizeV2", "RequantizationRange",
+                                      "Reshape"});
+  return conversion_ops->count(node.op()) > 0;
+}
+
+string GetStringAttr(const NodeDef& node, const string& name,
+                     const string& default_value) {
+  auto it = node.attr().find(name);
+  return it == node.attr().end() ? default_value : it->second.s();
+}
+
+DataType GetTypeAttr(const NodeDef& node, const string& name) {
+  auto it = node.attr().find(name);
+  return it == node.attr().end() ? DT_INVALID : it->second.type();
+}
+
+// Whether "node" converts an eight-bit tensor to float in the representation
+// that the quantized kernels use.
+bool IsEightBitDequantize(const NodeDef& node) {
+  return node.op() == "Dequantize" && GetTypeAttr(node, "T") == DT_QUINT8 &&
+         GetStringAttr(node, "mode", "MIN_COMBINED") == "MIN_FIRST";
+}
+
+// The quantized kernels are only registered for CPUs.
+bool IsOnCpu(const NodeDef& node) {
+  if (node.device().empty()) {
+    return true;
+  }
+  DeviceNameUtils::ParsedName parsed_name;
+  return DeviceNameUtils::ParseFullName(node.device(), &parsed_name) &&
+         (!parsed_name.has_type || parsed_name.type == "CPU");
+}
+
+// Whether the results of "node" are only reduced to their range, e.g. to
+// quantize them, in which case it is not worth quantizing it.
+bool IsOnlyReducedToRange(const NodeMap& node_map, const NodeDef& node) {
+  const std::set<NodeDef*>& consumers = node_map.GetOutputs(node.name());
+  for (const NodeDef* consumer : consumers) {
+    if (consumer->op() != "Min" && consumer->op() != "Max") {
+      return false;
+    }
+  }
+  return !consumers.empty();
+}
+
+// Whether "input" is the first output of the node named "name".
+bool IsFirstOutputOf(const string& input, const string& name) {
+  return !IsControlInput(input) && NodePosition(input) == 0 &&
+         NodeName(input) == name;
+}
+
+}  // namespace
+
+void QuantizationOptimizer::ReplaceInput(const string& old_input,
+                                         const string& new_input) {
+  const string old_name = NodeName(old_input);
+  const string new_name = NodeName(new_input);
+  const std::set<NodeDef*> consumers = node_map_->GetOutputs(old_name);
+  for (NodeDef* consumer : consumers) {
+    bool replaced = false;
+    bool uses_old_name = false;
+    for (int i = 0; i < consumer->input_size(); ++i) {
+      if (IsSameInput(consumer->input(i), old_input)) {
+        *consumer->mutable_input(i) = new_input;
+        replaced = true;
+      } else if (NodeName(consumer->input(i)) == old_name) {
+        uses_old_name = true;
+      }
+    }
+    if (!replaced) {
+      continue;
+    }
+    if (!uses_old_name) {
+      node_map_->RemoveOutput(old_name, consumer->name());
+    }
+    node_map_->AddOutput(new_name, consumer->name());
+  }
+}
+
+void QuantizationOptimizer::QuantizeFloatOps(std::deque<string>* unused_nodes) {
+  std::deque<NodeDef*> dequantizes;
+  for (int i = 0; i < graph_->node_size(); ++i) {
+    if (IsEightBitDequantize(graph_->node(i))) {
+      dequantizes.push_back(graph_->mutable_node(i));
+    }
+  }
+  while (!dequantizes.empty()) {
+    const NodeDef* dequantize = dequantizes.front();
+    dequantizes.pop_front();
+    const std::set<NodeDef*> consumers =
+        node_map_->GetOutputs(dequantize->name());
+    for (NodeDef* node : consumers) {
+      auto it = QuantizedOps().find(node->op());
+      if (it == QuantizedOps().end() || node->input_size() == 0 ||
+          !IsFirstOutputOf(node->input(0), dequantize->name()) ||
+          GetTypeAttr(*node, "T") != DT_FLOAT ||
+          GetStringAttr(*node, "data_format", "NHWC") != "NHWC" ||
+          !IsOnCpu(*node) || nodes_to_preserve_.count(node->name()) > 0 ||
+          IsOnlyReducedToRange(*node_map_, *node)) {
+        continue;
+      }
+      const string quantized_name = strings::StrCat(node->name(), "_eightbit");
+      if (node_map_->GetNode(quantized_name) != nullptr) {
+        continue;
+      }
+      const bool is_reshape = node->op() == "Reshape";
+      if (is_reshape &&
+          (node->input_size() < 2 || IsControlInput(node->input(1)))) {
+        continue;
+      }
+
+      NodeDef* quantized = graph_->add_node();
+      quantized->set_name(quantized_name);
+      quantized->set_op(it->second);
+      quantized->set_device(node->device());
+      quantized->add_input(dequantize->input(0));
+      if (is_reshape) {
+        quantized->add_input(node->input(1));
+      }
+      quantized->add_input(dequantize->input(1));
+      quantized->add_input(dequantize->input(2));
+      // The quantized op bypasses the Dequantize, so it takes over the control
+      // dependencies of both.
+      for (const NodeDef* dependent :
+           std::vector<const NodeDef*>({dequantize, node})) {
+        for (const string& input : dependent->input()) {
+          if (IsControlInput(input)) {
+            quantized->add_input(input);
+          }
+        }
+      }
+      auto* attr = quantized->mutable_attr();
+      if (node->op() == "Relu" || node->op() == "Relu6") {
+        (*attr)["Tinput"].set_type(DT_QUINT8);
+        (*attr)["out_type"].set_type(DT_QUINT8);
+      } else {
+        (*attr)["T"].set_type(DT_QUINT8);
+      }
+      for (const string& name : {"ksize", "strides", "padding", "Tshape"}) {
+        auto attr_it = node->attr().find(name);
+        if (attr_it != node->attr().end()) {
+          (*attr)[name] = attr_it->second;
+        }
+      }
+      node_map_->AddNode(quantized_name, quantized);
+      for (const string& input : quantized->input()) {
+        node_map_->AddOutput(NodeName(input), quantized_name);
+      }
+
+      // The float op turns into the Dequantize of the result, so that its
+      // consumers are unchanged.
+      VLOG(2) << "Quantizing " << node->name();
+      for (const string& input : node->input()) {
+        node_map_->RemoveOutput(NodeName(input), node->name());
+      }
+      node->set_op("Dequantize");
+      node->clear_input();
+      node->add_input(quantized_name);
+      node->add_input(strings::StrCat(quantized_name, ":1"));
+      node->add_input(strings::StrCat(quantized_name, ":2"));
+      node->clear_attr();
+      (*node->mutable_attr())["T"].set_type(DT_QUINT8);
+      (*node->mutable_attr())["mode"].set_s("MIN_FIRST");
+      node_map_->AddOutput(quantized_name, node->name());
+      dequantizes.push_back(node);
+      unused_nodes->push_back(dequantize->name());
+    }
+  }
+}
+
+void QuantizationOptimizer::RemoveRedundantQuantizations(
+    std::deque<string>* unused_nodes) {
+  for (int i = 0; i < graph_->node_size(); ++i) {
+    const NodeDef& quantize = graph_->node(i);
+    if (quantize.op() != "QuantizeV2" || quantize.input_size() < 3 ||
+        GetStringAttr(quantize, "mode", "MIN_COMBINED") != "MIN_FIRST" ||
+        nodes_to_preserve_.count(quantize.name()) > 0) {
+      continue;
+    }
+    const NodeDef* dequantize = node_map_->GetNode(quantize.input(0));
+    if (dequantize == nullptr || !IsEightBitDequantize(*dequantize) ||
+        !IsFirstOutputOf(quantize.input(0), dequantize->name()) ||
+        GetTypeAttr(quantize, "T") != DT_QUINT8) {
+      continue;
+    }
+    // The range must be the range of the dequantized tensor, as computed by
+    // Min and Max reductions of it or of its reshape.
+    const auto is_range_of_dequantize = [this, dequantize](
+        const string& input, const string& op) {
+      const NodeDef* reduction = node_map_->GetNode(input);
+      if (reduction == nullptr || reduction->op() != op ||
+          !IsFirstOutputOf(input, reduction->name()) ||
+          reduction->input_size() < 1) {
+        return false;
+      }
+      const NodeDef* reduced = node_map_->GetNode(reduction->input(0));
+      if (reduced != nullptr && reduced->op() == "Reshape" &&
+          IsFirstOutputOf(reduction->input(0), reduced->name()) &&
+          reduced->input_size() > 0) {
+        return IsFirstOutputOf(reduced->input(0), dequantize->name());
+      }
+      return IsFirstOutputOf(reduction->input(0), dequantize->name());
+    };
+    if (!is_range_of_dequantize(quantize.input(1), "Min") ||
+        !is_range_of_dequantize(quantize.input(2), "Max")) {
+      continue;
+    }
+
+    VLOG(2) << "Bypassing " << dequantize->name() << " and "
+            << quantize.name();
+    const string quantize_name = quantize.name();
+    for (int port = 0; port < 3; ++port) {
+      ReplaceInput(strings::StrCat(quantize_name, ":", port),
+                   dequantize->input(port));
+    }
+    ReplaceInput(AsControlDependency(quantize_name),
+                 AsControlDependency(NodeName(dequantize->input(0))));
+    unused_nodes->push_back(quantize_name);
+  }
+}
+
+void QuantizationOptimizer::FreezeRequantizationRanges(
+    std::deque<string>* unused_nodes) {
+  if (options_.calibrated_ranges().empty()) {
+    return;
+  }
+  const int num_nodes = graph_->node_size();
+  for (int i = 0; i < num_nodes; ++i) {
+    const NodeDef& requantize = graph_->node(i);
+    if (requantize.op() != "Requantize" || requantize.input_size() < 5) {
+      continue;
+    }
+    const NodeDef* range = node_map_->GetNode(requantize.input(3));
+    if (range == nullptr || range->op() != "RequantizationRange" ||
+        range->input_size() < 1 ||
+        !IsSameInput(requantize.input(4),
+                     strings::StrCat(range->name(), ":1"))) {
+      continue;
+    }
+    auto it = options_.calibrated_ranges().find(range->name());
+    if (it == options_.calibrated_ranges().end()) {
+      continue;
+    }
+    const string range_name = range->name();
+    VLOG(2) << "Freezing the range of " << range_name << " to ["
+            << it->second.min() << ", " << it->second.max() << "]";
+    for (int port = 0; port < 2; ++port) {
+      const float value = port == 0 ? it->second.min() : it->second.max();
+      string name = AddPrefixToNodeName(
+          port == 0 ? "calibrated_min" : "calibrated_max", range_name);
+      if (node_map_->GetNode(name) == nullptr) {
+        NodeDef* constant = graph_->add_node();
+        constant->set_name(name);
+        constant->set_op("Const");
+        constant->set_device(range->device());
+        // Keeps the constant in the frame of the range it replaces.
+        constant->add_input(AsControlDependency(NodeName(range->input(0))));
+        (*constant->mutable_attr())["dtype"].set_type(DT_FLOAT);
+        Tensor tensor(DT_FLOAT, TensorShape({}));
+        tensor.scalar<float>()() = value;
+        tensor.AsProtoTensorContent(
+            (*constant->mutable_attr())["value"].mutable_tensor());
+        node_map_->AddNode(name, constant);
+        node_map_->AddOutput(NodeName(range->input(0)), name);
+      }
+      ReplaceInput(strings::StrCat(range_name, ":", port), name);
+    }
+    unused_nodes->push_back(range_name);
+  }
+}
+
+void QuantizationOptimizer::DeleteUnusedNodes(std::deque<string> unused_nodes) {
+  std::unordered_set<string> deleted;
+  while (!unused_nodes.empty()) {
+    const string name = unused_nodes.front();
+    unused_nodes.pop_front();
+    const NodeDef* node = node_map_->GetNode(name);
+    if (node == nullptr || deleted.count(name) > 0 || !IsConversionOp(*node) ||
+        !node_map_->GetOutputs(name).empty() ||
+        nodes_to_preserve_.count(name) > 0) {
+      continue;
+    }
+    deleted.insert(name);
+    for (const string& input : node->input()) {
+      node_map_->RemoveOutput(NodeName(input), name);
+      unused_nodes.push_back(NodeName(input));
+    }
+  }
+  if (deleted.empty()) {
+    return;
+  }
+  int last = graph_->node_size() - 1;
+  for (int i = last; i >= 0; --i) {
+    if (deleted.count(graph_->node(i).name()) > 0) {
+      graph_->mutable_node()->SwapElements(i, last);
+      last--;
+    }
+  }
+  graph_->mutable_node()->DeleteSubrange(last + 1, deleted.size());
+}
+
+Status QuantizationOptimizer::Optimize(Cluster* /*cluster*/,
+                                       const GrapplerItem& item,
+                                       GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  graph_ = optimized_graph;
+  nodes_to_preserve_ = item.NodesToPreserve();
+  node_map_.reset(new NodeMap(optimized_graph));
+
+  std::deque<string> unused_nodes;
+  QuantizeFloatOps(&unused_nodes);
+  RemoveRedundantQuantizations(&unused_nodes);
+  FreezeRequantizationRanges(&unused_nodes);
+  DeleteUnusedNodes(std::move(unused_nodes));
+  node_map_.reset();
+  return Status::OK();
+}
+
+void QuantizationOptimizer::Feedback(Cluster* /*cluster*/,
+                                     const GrapplerItem& /*item*/,
+                                     const GraphDef& /*optimized_graph*/,
+                                     double /*result*/) {
+  // Nothing to do for QuantizationOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,76 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_QUANTIZATION_OPTIMIZER_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_QUANTIZATION_OPTIMIZER_H_
+
+#include <deque>
+#include <memory>
+#include <unordered_set>
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Optimize the eight-bit regions of a quantized graph, e.g. as produced by the
+// quantize_nodes graph transform, so that less of its time is spent
+// converting tensors between precisions:
+// - the float ops that have quantized equivalents (activations, pooling and
+//   reshapes) and consume a Dequantize are replaced by their quantized
+//   equivalents followed by the Dequantize, which grows the quantized regions
+//   until they meet the next one,
+// - the Dequantize and QuantizeV2 pairs that convert a tensor to float and
+//   back to the same range are bypassed,
+// - the Requantize nodes whose output range was calibrated use constants
+//   instead of computing it at run time with a RequantizationRange.
+class QuantizationOptimizer : public GraphOptimizer {
+ public:
+  QuantizationOptimizer() {}
+  explicit QuantizationOptimizer(const QuantizationOptions& options)
+      : options_(options) {}
+  ~QuantizationOptimizer() override {}
+
+  string name() const override { return "quantization_optimizer"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+
+ private:
+  void QuantizeFloatOps(std::deque<string>* unused_nodes);
+  void RemoveRedundantQuantizations(std::deque<string>* unused_nodes);
+  void FreezeRequantizationRanges(std::deque<string>* unused_nodes);
+  // Deletes the nodes of "unused_nodes" that have no outputs anymore, and
+  // then their inputs that are left without outputs in turn.
+  void DeleteUnusedNodes(std::deque<string> unused_nodes);
+
+  // Points all the consumers of "old_input" to "new_input" instead.
+  void ReplaceInput(const string& old_input, const string& new_input);
+
+  QuantizationOptions options_;
+  std::unordered_set<string> nodes_to_preserve_;
+  GraphDef* graph_;
+  std::unique_ptr<NodeMap> node_map_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_QUANTIZATION_OPTIMIZER_H_
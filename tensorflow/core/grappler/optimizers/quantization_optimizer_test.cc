@@ -0,0 +1,166 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/core/grappler/optimizers/quantization_optimizer.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class QuantizationOptimizerTest : public ::testing::Test {};
+
+TEST_F(QuantizationOptimizerTest, QuantizesOpsBetweenQuantizedRegions) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_QUINT8);
+  Output x_min = ops::Const(s.WithOpName("x_min"), -1.0f, {});
+  Output x_max = ops::Const(s.WithOpName("x_max"), 1.0f, {});
+  Output dequantize =
+      ops::Dequantize(s.WithOpName("dequantize"), x, x_min, x_max,
+                      ops::Dequantize::Mode("MIN_FIRST"));
+  Output relu = ops::Relu(s.WithOpName("relu"), dequantize);
+  Output pool = ops::MaxPool(s.WithOpName("pool"), relu, {1, 2, 2, 1},
+                             {1, 2, 2, 1}, "VALID");
+  // The conversion of the result to the eight-bit input of the next region.
+  Output reshape_dims = ops::Const(s.WithOpName("reshape_dims"), {-1}, {1});
+  Output reshape = ops::Reshape(s.WithOpName("reshape"), pool, reshape_dims);
+  Output reduction_dims = ops::Const(s.WithOpName("reduction_dims"), {0}, {1});
+  Output min = ops::Min(s.WithOpName("min"), reshape, reduction_dims);
+  Output max = ops::Max(s.WithOpName("max"), reshape, reduction_dims);
+  ops::QuantizeV2 quantize(s.WithOpName("quantize"), pool, min, max,
+                           DT_QUINT8, ops::QuantizeV2::Mode("MIN_FIRST"));
+  Output y = ops::Identity(s.WithOpName("y"), quantize.output);
+  Output y_max = ops::Identity(s.WithOpName("y_max"), quantize.output_max);
+
+  GrapplerItem item;
+  item.fetch.push_back("y");
+  item.fetch.push_back("y_max");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  QuantizationOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* quantized_relu = node_map.GetNode("relu_eightbit");
+  ASSERT_NE(nullptr, quantized_relu);
+  EXPECT_EQ("QuantizedRelu", quantized_relu->op());
+  EXPECT_EQ("x", quantized_relu->input(0));
+  EXPECT_EQ("x_min", quantized_relu->input(1));
+  EXPECT_EQ("x_max", quantized_relu->input(2));
+  const NodeDef* quantized_pool = node_map.GetNode("pool_eightbit");
+  ASSERT_NE(nullptr, quantized_pool);
+  EXPECT_EQ("QuantizedMaxPool", quantized_pool->op());
+  EXPECT_EQ("relu_eightbit", quantized_pool->input(0));
+  EXPECT_EQ("relu_eightbit:1", quantized_pool->input(1));
+  EXPECT_EQ("relu_eightbit:2", quantized_pool->input(2));
+  EXPECT_EQ("VALID", quantized_pool->attr().at("padding").s());
+
+  // The region now reaches the quantized consumers directly.
+  EXPECT_EQ("pool_eightbit", node_map.GetNode("y")->input(0));
+  EXPECT_EQ("pool_eightbit:2", node_map.GetNode("y_max")->input(0));
+  for (const string& name : {"dequantize", "relu", "pool", "reshape", "min",
+                             "max", "quantize", "reshape_dims",
+                             "reduction_dims"}) {
+    EXPECT_EQ(nullptr, node_map.GetNode(name)) << name;
+  }
+  EXPECT_EQ(7, output.node_size());
+}
+
+TEST_F(QuantizationOptimizerTest, KeepsFetchedFloatResults) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_QUINT8);
+  Output x_min = ops::Const(s.WithOpName("x_min"), -1.0f, {});
+  Output x_max = ops::Const(s.WithOpName("x_max"), 1.0f, {});
+  Output dequantize =
+      ops::Dequantize(s.WithOpName("dequantize"), x, x_min, x_max,
+                      ops::Dequantize::Mode("MIN_FIRST"));
+  Output relu = ops::Relu(s.WithOpName("relu"), dequantize);
+  Output gpu_relu =
+      ops::Relu(s.WithOpName("gpu_relu").WithDevice("/gpu:0"), dequantize);
+
+  GrapplerItem item;
+  item.fetch.push_back("relu");
+  item.fetch.push_back("gpu_relu");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  QuantizationOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  NodeMap node_map(&output);
+  EXPECT_EQ("Relu", node_map.GetNode("relu")->op());
+  EXPECT_EQ("Relu", node_map.GetNode("gpu_relu")->op());
+}
+
+TEST_F(QuantizationOptimizerTest, FreezesCalibratedRanges) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output acc = ops::Placeholder(s.WithOpName("acc"), DT_QINT32);
+  Output acc_min = ops::Const(s.WithOpName("acc_min"), -100.0f, {});
+  Output acc_max = ops::Const(s.WithOpName("acc_max"), 100.0f, {});
+  ops::RequantizationRange range(s.WithOpName("range"), acc, acc_min,
+                                 acc_max);
+  ops::Requantize requantize(s.WithOpName("requantize"), acc, acc_min,
+                             acc_max, range.output_min, range.output_max,
+                             DT_QUINT8);
+  ops::RequantizationRange other_range(s.WithOpName("other_range"), acc,
+                                       acc_min, acc_max);
+  ops::Requantize other_requantize(
+      s.WithOpName("other_requantize"), acc, acc_min, acc_max,
+      other_range.output_min, other_range.output_max, DT_QUINT8);
+  Output y = ops::Identity(s.WithOpName("y"), requantize.output);
+  Output z = ops::Identity(s.WithOpName("z"), other_requantize.output);
+
+  GrapplerItem item;
+  item.fetch.push_back("y");
+  item.fetch.push_back("z");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  QuantizationOptions options;
+  (*options.mutable_calibrated_ranges())["range"].set_min(-2.0f);
+  (*options.mutable_calibrated_ranges())["range"].set_max(3.0f);
+  QuantizationOptimizer optimizer(options);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ(nullptr, node_map.GetNode("range"));
+  const NodeDef* requantize_node = node_map.GetNode("requantize");
+  EXPECT_EQ("range/calibrated_min", requantize_node->input(3));
+  EXPECT_EQ("range/calibrated_max", requantize_node->input(4));
+  const NodeDef* calibrated_min = node_map.GetNode("range/calibrated_min");
+  ASSERT_NE(nullptr, calibrated_min);
+  EXPECT_EQ("Const", calibrated_min->op());
+  EXPECT_EQ("^acc", calibrated_min->input(0));
+  Tensor value;
+  ASSERT_TRUE(value.FromProto(calibrated_min->attr().at("value").tensor()));
+  EXPECT_EQ(-2.0f, value.scalar<float>()());
+
+  // The range that was not calibrated is still computed at run time.
+  EXPECT_NE(nullptr, node_map.GetNode("other_range"));
+  EXPECT_EQ("other_range", node_map.GetNode("other_requantize")->input(3));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
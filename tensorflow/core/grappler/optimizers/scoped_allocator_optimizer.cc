@@ -0,0 +1,290 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/core/grappler/optimizers/scoped_allocator_optimizer.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/scoped_allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/frame.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// An input of a concat, to allocate in a field of a ScopedAllocator.
+struct Field {
+  NodeDef* producer;
+  int port;
+  TensorShape shape;
+};
+
+bool GetShape(const GraphProperties& properties, const string& node,
+              int port, TensorShape* shape) {
+  const std::vector<OpInfo::TensorProperties>& outputs =
+      properties.GetOutputProperties(node);
+  if (port >= static_cast<int>(outputs.size())) {
+    return false;
+  }
+  return PartialTensorShape(outputs[port].shape()).AsTensorShape(shape);
+}
+
+bool GetAxis(const NodeDef& node, int64* axis) {
+  if (!IsConstant(node) || node.attr().count("value") == 0) {
+    return false;
+  }
+  Tensor value;
+  if (!value.FromProto(node.attr().at("value").tensor()) ||
+      value.NumElements() != 1) {
+    return false;
+  }
+  if (value.dtype() == DT_INT32) {
+    *axis = value.flat<int32>()(0);
+  } else if (value.dtype() == DT_INT64) {
+    *axis = value.flat<int64>()(0);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Whether the kernel of "node" may allocate its outputs, rather than forward
+// tensors it already holds, and "consumer" is the only node reading them.
+bool CanAllocateInField(const NodeDef& node, const NodeDef& consumer,
+                        const NodeMap& node_map) {
+  if (IsConstant(node) || IsVariable(node) || IsPlaceholder(node) ||
+      IsIdentity(node) || IsReshape(node) || IsSwitch(node) || IsMerge(node) ||
+      IsEnter(node) || IsExit(node) || IsNextIteration(node) ||
+      IsRecv(node) || node.attr().count(kScopedAllocatorAttrName) > 0) {
+    return false;
+  }
+  for (const NodeDef* output : node_map.GetOutputs(node.name())) {
+    int inputs = 0;
+    for (const string& input : output->input()) {
+      if (!IsControlInput(input) && NodeName(input) == node.name()) {
+        ++inputs;
+      }
+    }
+    if (inputs > 0 && (output != &consumer || inputs > 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool HasKernel(const NodeDef& node) {
+  DeviceNameUtils::ParsedName parsed;
+  if (!DeviceNameUtils::ParseFullName(node.device(), &parsed) ||
+      !parsed.has_type) {
+    return false;
+  }
+  return FindKernelDef(DeviceType(parsed.type), node, nullptr, nullptr).ok();
+}
+
+// The ids already used by the ScopedAllocators of "graph".
+int32 MaxScopedAllocatorId(const GraphDef& graph) {
+  int32 max_id = 0;
+  for (const NodeDef& node : graph.node()) {
+    if (node.op() == "_ScopedAllocator" && node.attr().count("id") > 0 &&
+        node.attr().count("shapes") > 0) {
+      max_id = std::max<int32>(
+          max_id, node.attr().at("id").i() +
+                      node.attr().at("shapes").list().shape_size());
+    }
+    auto it = node.attr().find(kScopedAllocatorAttrName);
+    if (it != node.attr().end()) {
+      for (int64 id : it->second.list().i()) {
+        max_id = std::max<int32>(max_id, id);
+      }
+    }
+  }
+  return max_id;
+}
+
+}  // namespace
+
+Status ScopedAllocatorOptimizer::Optimize(Cluster* /*cluster*/,
+                                          const GrapplerItem& item,
+                                          GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  GraphProperties properties(item);
+  Status s = properties.InferStatically();
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer the shapes of the graph: " << s;
+    return Status::OK();
+  }
+  std::unordered_map<const NodeDef*, std::vector<int>> frames;
+  IdentifyFrames(*optimized_graph, &frames);
+  const auto in_loop = [&frames](const NodeDef* node) {
+    auto it = frames.find(node);
+    return it != frames.end() && !it->second.empty();
+  };
+  const std::unordered_set<string> nodes_to_preserve = item.NodesToPreserve();
+  NodeMap node_map(optimized_graph);
+  int32 next_id = MaxScopedAllocatorId(*optimized_graph) + 1;
+
+  std::vector<NodeDef*> concats;
+  for (int i = 0; i < optimized_graph->node_size(); ++i) {
+    NodeDef* node = optimized_graph->mutable_node(i);
+    if (node->op() == "ConcatV2" && !node->device().empty() &&
+        !in_loop(node)) {
+      concats.push_back(node);
+    }
+  }
+
+  for (NodeDef* concat : concats) {
+    if (concat->attr().count("T") == 0 || concat->attr().count("N") == 0) {
+      continue;
+    }
+    const DataType dtype = concat->attr().at("T").type();
+    const int n = concat->attr().at("N").i();
+    if (!DataTypeCanUseMemcpy(dtype) || n < 2 || concat->input_size() < n + 1 ||
+        IsControlInput(concat->input(n))) {
+      continue;
+    }
+    const NodeDef* axis_node = node_map.GetNode(NodeName(concat->input(n)));
+    TensorShape shape;
+    int64 axis;
+    if (axis_node == nullptr || !GetAxis(*axis_node, &axis) ||
+        !GetShape(properties, concat->name(), 0, &shape) || shape.dims() == 0) {
+      continue;
+    }
+    if (axis < 0) {
+      axis += shape.dims();
+    }
+    if (axis < 0 || axis >= shape.dims()) {
+      continue;
+    }
+    // The inputs are contiguous in the output only if the dimensions before
+    // the axis are all 1.
+    bool contiguous = true;
+    for (int d = 0; d < axis; ++d) {
+      contiguous &= shape.dim_size(d) == 1;
+    }
+    if (!contiguous) {
+      continue;
+    }
+
+    std::vector<Field> fields;
+    std::unordered_set<string> producers;
+    int64 offset = 0;
+    for (int i = 0; i < n; ++i) {
+      Field field;
+      const string producer = ParseNodeName(concat->input(i), &field.port);
+      field.producer = node_map.GetNode(producer);
+      if (field.producer == nullptr || field.port < 0 ||
+          !producers.insert(producer).second ||
+          field.producer->device() != concat->device() ||
+          nodes_to_preserve.count(producer) > 0 || in_loop(field.producer) ||
+          !CanAllocateInField(*field.producer, *concat, node_map) ||
+          !GetShape(properties, producer, field.port, &field.shape)) {
+        break;
+      }
+      // Each field must be aligned for the kernel of its producer.
+      if (offset % Allocator::kAllocatorAlignment != 0) {
+        break;
+      }
+      offset += field.shape.num_elements() * DataTypeSize(dtype);
+      fields.push_back(field);
+    }
+    if (static_cast<int>(fields.size()) != n ||
+        offset != shape.num_elements() * DataTypeSize(dtype)) {
+      continue;
+    }
+
+    NodeDef scoped_allocator;
+    scoped_allocator.set_name(
+        strings::StrCat(concat->name(), "/scoped_allocator"));
+    if (node_map.GetNode(scoped_allocator.name()) != nullptr) {
+      continue;
+    }
+    scoped_allocator.set_op("_ScopedAllocator");
+    scoped_allocator.set_device(concat->device());
+    (*scoped_allocator.mutable_attr())["T"].set_type(dtype);
+    shape.AsProto((*scoped_allocator.mutable_attr())["shape"].mutable_shape());
+    AttrValue::ListValue* shapes =
+        (*scoped_allocator.mutable_attr())["shapes"].mutable_list();
+    for (const Field& field : fields) {
+      field.shape.AsProto(shapes->add_shape());
+    }
+    (*scoped_allocator.mutable_attr())["id"].set_i(next_id);
+
+    NodeDef scoped_concat;
+    scoped_concat.set_name(concat->name());
+    scoped_concat.set_op("_ScopedAllocatorConcat");
+    scoped_concat.set_device(concat->device());
+    scoped_concat.add_input(scoped_allocator.name());
+    for (int i = 0; i < concat->input_size(); ++i) {
+      if (i != n) {
+        scoped_concat.add_input(concat->input(i));
+      }
+    }
+    (*scoped_concat.mutable_attr())["T"].set_type(dtype);
+    (*scoped_concat.mutable_attr())["N"].set_i(n);
+    if (!HasKernel(scoped_allocator) || !HasKernel(scoped_concat)) {
+      continue;
+    }
+
+    VLOG(1) << "Allocating the " << n << " inputs of " << concat->name()
+            << " in the fields of " << scoped_allocator.name();
+    NodeDef* new_node = optimized_graph->add_node();
+    *new_node = scoped_allocator;
+    node_map.AddNode(new_node->name(), new_node);
+    for (int i = 0; i < n; ++i) {
+      NodeDef* producer = fields[i].producer;
+      // The backing tensor must exist before the producer allocates its
+      // output.
+      producer->add_input(AsControlDependency(new_node->name()));
+      node_map.AddOutput(new_node->name(), producer->name());
+      AttrValue::ListValue* ids =
+          (*producer->mutable_attr())[kScopedAllocatorAttrName].mutable_list();
+      ids->add_i(fields[i].port);
+      ids->add_i(next_id + 1 + i);
+    }
+    node_map.RemoveOutput(axis_node->name(), concat->name());
+    node_map.AddOutput(new_node->name(), concat->name());
+    concat->Swap(&scoped_concat);
+    next_id += n + 1;
+  }
+  return Status::OK();
+}
+
+void ScopedAllocatorOptimizer::Feedback(Cluster* /*cluster*/,
+                                        const GrapplerItem& /*item*/,
+                                        const GraphDef& /*optimized_graph*/,
+                                        double /*result*/) {
+  // Nothing to do for ScopedAllocatorOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,56 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_SCOPED_ALLOCATOR_OPTIMIZER_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_SCOPED_ALLOCATOR_OPTIMIZER_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Elide the copies of the ConcatV2 nodes whose inputs are contiguous in their
+// output, i.e. whose dimensions before the concatenated one are all 1: the
+// outputs of the producers of their inputs are allocated as the consecutive
+// fields of the backing tensor of a ScopedAllocator, which the concat then
+// simply forwards.
+//
+// Each such concat becomes a _ScopedAllocatorConcat of the output of a new
+// _ScopedAllocator node, which runs before the producers and allocates the
+// backing tensor, and the producers get a _scoped_allocator attr that
+// assigns their outputs to its fields. The shapes of the inputs must be
+// known, and each producer must be on the device of the concat and feed
+// only its input. If a producer does not allocate its output in the field
+// after all, e.g. because it forwards its input, the concat copies it.
+class ScopedAllocatorOptimizer : public GraphOptimizer {
+ public:
+  ScopedAllocatorOptimizer() {}
+  ~ScopedAllocatorOptimizer() override {}
+
+  string name() const override { return "scoped_allocator_optimizer"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_SCOPED_ALLOCATOR_OPTIMIZER_H_
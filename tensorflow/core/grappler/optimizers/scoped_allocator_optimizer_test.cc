@@ -0,0 +1,118 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/core/grappler/optimizers/scoped_allocator_optimizer.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+const char kCpu[] = "/job:localhost/replica:0/task:0/device:CPU:0";
+
+// Concatenates two MatMuls of inputs of "batch_size" rows along their
+// columns. If "fetch_relu", the first MatMul also feeds a fetched Relu.
+GrapplerItem CreateItem(int batch_size, bool fetch_relu) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(kCpu);
+  Output x = ops::Placeholder(
+      s.WithOpName("x"), DT_FLOAT,
+      ops::Placeholder::Shape(PartialTensorShape({batch_size, 16})));
+  Output w = ops::Variable(s.WithOpName("w"), {16, 16}, DT_FLOAT);
+  Output a = ops::MatMul(s.WithOpName("a"), x, w);
+  Output b = ops::MatMul(s.WithOpName("b"), x, w);
+  Output concat = ops::Concat(s.WithOpName("concat"), {a, b}, 1);
+
+  GrapplerItem item;
+  item.fetch = {"concat"};
+  if (fetch_relu) {
+    ops::Relu(s.WithOpName("relu"), a);
+    item.fetch.push_back("relu");
+  }
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  return item;
+}
+
+void ExpectUnchanged(const GraphDef& expected, const GraphDef& actual) {
+  ASSERT_EQ(expected.node_size(), actual.node_size());
+  for (int i = 0; i < expected.node_size(); ++i) {
+    EXPECT_EQ(expected.node(i).DebugString(), actual.node(i).DebugString());
+  }
+}
+
+TEST(ScopedAllocatorOptimizerTest, AllocatesInputsInFields) {
+  GrapplerItem item = CreateItem(1, false);
+  ScopedAllocatorOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* scoped_allocator = node_map.GetNode("concat/scoped_allocator");
+  ASSERT_NE(nullptr, scoped_allocator);
+  EXPECT_EQ("_ScopedAllocator", scoped_allocator->op());
+  EXPECT_EQ(kCpu, scoped_allocator->device());
+  EXPECT_EQ(TensorShape({1, 32}),
+            TensorShape(scoped_allocator->attr().at("shape").shape()));
+  ASSERT_EQ(2, scoped_allocator->attr().at("shapes").list().shape_size());
+  const int id = scoped_allocator->attr().at("id").i();
+
+  const NodeDef* concat = node_map.GetNode("concat");
+  EXPECT_EQ("_ScopedAllocatorConcat", concat->op());
+  ASSERT_EQ(3, concat->input_size());
+  EXPECT_EQ("concat/scoped_allocator", concat->input(0));
+  EXPECT_EQ("a", concat->input(1));
+  EXPECT_EQ("b", concat->input(2));
+  EXPECT_EQ(0, concat->attr().count("Tidx"));
+
+  int field = 1;
+  for (const string& name : {"a", "b"}) {
+    const NodeDef* producer = node_map.GetNode(name);
+    EXPECT_EQ("^concat/scoped_allocator",
+              producer->input(producer->input_size() - 1));
+    const auto& ids = producer->attr().at("_scoped_allocator").list().i();
+    ASSERT_EQ(2, ids.size());
+    EXPECT_EQ(0, ids.Get(0));
+    EXPECT_EQ(id + field, ids.Get(1));
+    ++field;
+  }
+}
+
+TEST(ScopedAllocatorOptimizerTest, KeepsNonContiguousConcats) {
+  // The rows of the inputs are interleaved in the output.
+  GrapplerItem item = CreateItem(2, false);
+  ScopedAllocatorOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  ExpectUnchanged(item.graph, output);
+}
+
+TEST(ScopedAllocatorOptimizerTest, KeepsInputsWithOtherConsumers) {
+  GrapplerItem item = CreateItem(1, true);
+  ScopedAllocatorOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  ExpectUnchanged(item.graph, output);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -21,6 +21,7 @@ limitations under the License.
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 
@@ -75,6 +76,14 @@ class AssignOp : public OpKernel {
       // 2. If the lhs is initialized and has the same number of elements as the
       //    rhs we can avoid a memory allocation.
 
+      // 0. A read-only, memory-mapped rhs, e.g. a tensor restored from a
+      //    memory-mapped checkpoint, is shared rather than copied, so that
+      //    the pages are shared by every process that maps them.
+      if (IsMappedBundleTensor(rhs)) {
+        context->replace_ref_input(0, rhs, /* lock_held */ true);
+        return;
+      }
+
       // 1. Try to reuse the rhs.
       std::unique_ptr<Tensor> input_alias = context->forward_input(
           1, old_lhs.dtype(), old_lhs.shape(), DEVICE_MEMORY, attr);
@@ -85,9 +94,10 @@ class AssignOp : public OpKernel {
         return;
       }
 
-      // 2. Try to copy into an existing buffer.
+      // 2. Try to copy into an existing buffer, unless it is read-only.
       if (old_lhs.IsInitialized() &&
-          old_lhs.shape().num_elements() == rhs.shape().num_elements()) {
+          old_lhs.shape().num_elements() == rhs.shape().num_elements() &&
+          !IsMappedBundleTensor(old_lhs)) {
         // The existing lhs tensor has already been initialized and the right
         // hand side can fit in the underlying buffer.
         Tensor reshaped_old_lhs;
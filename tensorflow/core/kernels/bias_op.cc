@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/kernels/cpu_reduction.h"
 #include "tensorflow/core/util/tensor_format.h"
 
 #if GOOGLE_CUDA
@@ -241,11 +242,28 @@ class BiasGradOp : public OpKernel {
       // Eigen often crashes by design on empty tensors, but setZero is safe
       output->template flat<T>().setZero();
     } else {
-      // Added by intel_tf to support NCHW on CPU regardless of MKL used or not.
       if (data_format_ == FORMAT_NCHW) {
         OP_REQUIRES(context, output_backprop.dims() == 4,
                     errors::InvalidArgument(
                         "NCHW format supports only 4D input/output tensor."));
+      }
+      // Sums [batch * height * width, channel] over its rows for NHWC, and
+      // [batch, channel, height * width] over its outer and inner
+      // dimensions for NCHW.
+      const bool nchw = data_format_ == FORMAT_NCHW;
+      if (std::is_same<Device, CPUDevice>::value &&
+          functor::CpuReduce<Eigen::internal::SumReducer<T>>(
+              *context->device()->tensorflow_cpu_worker_threads(),
+              nchw ? functor::CpuReduceShape::kOuterInner
+                   : functor::CpuReduceShape::kMiddle,
+              output_backprop.flat<T>().data(), nchw ? batch : 1,
+              nchw ? channel : batch * height * width,
+              nchw ? height * width : channel,
+              output->template flat<T>().data())) {
+        return;
+      }
+      // Added by intel_tf to support NCHW on CPU regardless of MKL used or not.
+      if (data_format_ == FORMAT_NCHW) {
         Eigen::DSizes<int, 4> four_dims(batch, channel, height, width);
 #ifdef EIGEN_HAS_INDEX_LIST
         using idx0 = Eigen::type2index<0>;
@@ -14,8 +14,12 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/dataset.h"
 
+#include <deque>
+
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
@@ -30,7 +34,11 @@ namespace {
 class CacheDatasetOp : public UnaryDatasetOpKernel {
  public:
   explicit CacheDatasetOp(OpKernelConstruction* ctx)
-      : UnaryDatasetOpKernel(ctx) {}
+      : UnaryDatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr("memory_budget_bytes", &memory_budget_bytes_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("num_shards", &num_shards_));
+  }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                    DatasetBase** output) override {
@@ -41,12 +49,47 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
 
     if (filename.empty()) {
       *output = new MemoryDataset(input);
+    } else if (memory_budget_bytes_ > 0 || num_shards_ > 1) {
+      *output = new TieredDataset(input, filename, memory_budget_bytes_,
+                                  num_shards_, ctx->env());
     } else {
       *output = new FileDataset(input, filename, ctx->env());
     }
   }
 
  private:
+  static const size_t kMaxItems = 10000000;  // 10 million
+
+  static size_t StringPaddingSize(size_t num_tensors) {
+    return strings::Printf("%zu", num_tensors - 1).size();
+  }
+
+  // Creates `lockfile`, to help catch concurrent writes to the same cache
+  // files. Fails if the lockfile already exists.
+  static Status CreateLockFile(Env* env, const string& lockfile) {
+    if (env->FileExists(lockfile).ok()) {
+      // Attempt to read the contents of the lockfile.
+      char contents_scratch[151] = {0};  // Initialize all to 0.
+      StringPiece contents;
+      std::unique_ptr<RandomAccessFile> file;
+      if (env->NewRandomAccessFile(lockfile, &file).ok()) {
+        file->Read(0, 150, &contents, contents_scratch).IgnoreError();
+      }
+      return errors::AlreadyExists(
+          "There appears to be a concurrent caching iterator running - "
+          "cache lockfile already exists ('",
+          lockfile,
+          "'). If you are sure no other running TF computations are using "
+          "this cache prefix, delete the lockfile and re-initialize the "
+          "iterator. Lockfile contents: ",
+          contents);
+    }
+    // Create the file, and write some basic contents.
+    std::unique_ptr<WritableFile> file;
+    TF_RETURN_IF_ERROR(env->NewWritableFile(lockfile, &file));
+    return file->Append(strings::StrCat("Created at: ", env->NowSeconds()));
+  }
+
   class FileDataset : public DatasetBase {
    public:
     explicit FileDataset(const DatasetBase* input, string filename, Env* env)
@@ -87,10 +130,6 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
     string DebugString() override { return "CacheDatasetOp::FileDataset"; }
 
    private:
-    static size_t StringPaddingSize(size_t num_tensors) {
-      return strings::Printf("%zu", num_tensors - 1).size();
-    }
-
     string FormatName(size_t item_index, size_t tensor_index) const {
       return strings::Printf(tensor_format_string_.c_str(), item_index,
                              tensor_index);
@@ -164,32 +203,9 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
         if (lockfile_created_ && !iteration_completed_) return Status::OK();
         // Perform rudimentary locking to help catch concurrent writes to the
         // same cache files.
-        if (dataset()->env_->FileExists(lockfile_).ok()) {
-          // Attempt to read the contents of the lockfile.
-          char contents_scratch[151] = {0};  // Initialize all to 0.
-          StringPiece contents;
-          std::unique_ptr<RandomAccessFile> file;
-          if (dataset()->env_->NewRandomAccessFile(lockfile_, &file).ok()) {
-            file->Read(0, 150, &contents, contents_scratch).IgnoreError();
-          }
-          return errors::AlreadyExists(
-              "There appears to be a concurrent caching iterator running - "
-              "cache lockfile already exists ('",
-              lockfile_,
-              "'). If you are sure no other running TF computations are using "
-              "this cache prefix, delete the lockfile and re-initialize the "
-              "iterator. Lockfile contents: ",
-              contents);
-        } else {
-          // Create the file, and write some basic contents.
-          std::unique_ptr<WritableFile> lockfile;
-          TF_RETURN_IF_ERROR(
-              dataset()->env_->NewWritableFile(lockfile_, &lockfile));
-          TF_RETURN_IF_ERROR(lockfile->Append(
-              strings::StrCat("Created at: ", dataset()->env_->NowSeconds())));
-          lockfile_created_ = true;
-          return Status::OK();
-        }
+        TF_RETURN_IF_ERROR(CreateLockFile(dataset()->env_, lockfile_));
+        lockfile_created_ = true;
+        return Status::OK();
       }
 
       Status Finish() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -256,11 +272,474 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
     Env* const env_;
     const size_t num_tensors_;
     const size_t tensor_index_padding_size_;
-    static const size_t kMaxItems = 10000000;  // 10 million
     const size_t item_index_padding_size_;
     const string tensor_format_string_;
   };  // FileDataset
 
+  // TieredDataset keeps the first elements of its input in memory, for as
+  // long as they fit in `memory_budget_bytes`, and spills the remaining
+  // elements round-robin to `num_shards` bundle files. Each shard is written,
+  // and on later epochs read back, by a thread of its own.
+  //
+  // A manifest file is written once all shards are complete. The shards on
+  // their own only form a complete cache if no element was kept in memory,
+  // so when the memory tier was filled by another dataset (e.g. in another
+  // process), the cache is written again.
+  class TieredDataset : public DatasetBase {
+   public:
+    explicit TieredDataset(const DatasetBase* input, string filename,
+                           int64 memory_budget_bytes, int64 num_shards,
+                           Env* env)
+        : input_(input),
+          filename_(std::move(filename)),
+          memory_budget_bytes_(memory_budget_bytes),
+          num_shards_(num_shards),
+          env_(env),
+          num_tensors_(input->output_dtypes().size()),
+          tensor_format_string_(
+              strings::Printf("%%%zuzu_%%%zuzu", StringPaddingSize(kMaxItems),
+                              StringPaddingSize(num_tensors_))) {
+      input_->Ref();
+    }
+
+    ~TieredDataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIterator(
+        const string& prefix) const override {
+      mutex_lock l(mu_);
+      int64 num_spilled;
+      if (CacheIsComplete(&num_spilled)) {
+        return std::unique_ptr<IteratorBase>(new TieredReaderIterator(
+            {this, strings::StrCat(prefix, "::TieredReader")}, memory_tier_,
+            num_spilled));
+      }
+      return std::unique_ptr<IteratorBase>(new TieredWriterIterator(
+          {this, strings::StrCat(prefix, "::TieredWriter")}));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return input_->output_dtypes();
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return input_->output_shapes();
+    }
+
+    string DebugString() override { return "CacheDatasetOp::TieredDataset"; }
+
+   private:
+    // The number of elements that a shard writer may have queued, and that a
+    // shard reader may read ahead of its consumer.
+    static const size_t kMaxPendingElements = 8;
+
+    using MemoryTier = std::vector<std::vector<Tensor>>;
+
+    struct BufferElement {
+      Status status;
+      std::vector<Tensor> value;
+    };
+
+    string FormatName(size_t item_index, size_t tensor_index) const {
+      return strings::Printf(tensor_format_string_.c_str(), item_index,
+                             tensor_index);
+    }
+
+    string ShardPrefix(int64 shard_index) const {
+      return strings::StrCat(filename_, "_", shard_index, "-of-", num_shards_);
+    }
+
+    string ManifestFilename() const {
+      return strings::StrCat(filename_, ".tiers");
+    }
+
+    // Returns true if the manifest describes a cache that this dataset can
+    // read, and sets `*num_spilled` to the number of elements in its shards.
+    bool CacheIsComplete(int64* num_spilled) const
+        EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      string contents;
+      if (!ReadFileToString(env_, ManifestFilename(), &contents).ok()) {
+        return false;
+      }
+      // The manifest holds the number of elements in memory, the number of
+      // shards and the number of elements in those shards.
+      std::vector<string> fields = str_util::Split(contents, ' ');
+      int64 num_in_memory;
+      int64 num_shards;
+      if (fields.size() != 3 ||
+          !strings::safe_strto64(fields[0], &num_in_memory) ||
+          !strings::safe_strto64(fields[1], &num_shards) ||
+          !strings::safe_strto64(fields[2], num_spilled)) {
+        LOG(WARNING) << "Ignoring malformed cache manifest "
+                     << ManifestFilename();
+        return false;
+      }
+      const int64 memory_tier_size = memory_tier_ ? memory_tier_->size() : 0;
+      return num_shards == num_shards_ && num_in_memory == memory_tier_size;
+    }
+
+    // ShardWriter writes the elements of one shard to a bundle on a thread
+    // of its own, so that the shards are serialized and written in parallel.
+    class ShardWriter {
+     public:
+      ShardWriter(const TieredDataset* dataset, int64 shard_index)
+          : dataset_(dataset),
+            writer_(dataset->env_, dataset->ShardPrefix(shard_index)) {
+        thread_.reset(dataset->env_->StartThread(
+            {}, "tiered_cache_writer", [this]() { WriterThread(); }));
+      }
+
+      // Writes any elements that are still queued, but does not finish the
+      // bundle.
+      ~ShardWriter() {
+        {
+          mutex_lock l(mu_);
+          finished_ = true;
+          cond_var_.notify_all();
+        }
+        thread_.reset();
+      }
+
+      // Queues `element` to be written, blocking while the queue is full.
+      // Returns the error from writing an earlier element, if any.
+      Status Add(const std::vector<Tensor>& element) {
+        mutex_lock l(mu_);
+        while (status_.ok() && pending_.size() >= kMaxPendingElements) {
+          cond_var_.wait(l);
+        }
+        TF_RETURN_IF_ERROR(status_);
+        pending_.push_back(element);
+        cond_var_.notify_all();
+        return Status::OK();
+      }
+
+      // Writes all queued elements and finishes the bundle.
+      Status Finish() {
+        {
+          mutex_lock l(mu_);
+          finished_ = true;
+          cond_var_.notify_all();
+        }
+        // Joins the writer thread.
+        thread_.reset();
+        {
+          mutex_lock l(mu_);
+          TF_RETURN_IF_ERROR(status_);
+        }
+        return writer_.Finish();
+      }
+
+     private:
+      void WriterThread() {
+        size_t item_index = 0;
+        while (true) {
+          std::vector<Tensor> element;
+          {
+            mutex_lock l(mu_);
+            while (!finished_ && pending_.empty()) {
+              cond_var_.wait(l);
+            }
+            if (pending_.empty()) {
+              return;
+            }
+            element = std::move(pending_.front());
+            pending_.pop_front();
+            cond_var_.notify_all();
+          }
+          Status s;
+          for (size_t i = 0; i < element.size() && s.ok(); ++i) {
+            s = writer_.Add(dataset_->FormatName(item_index, i), element[i]);
+          }
+          ++item_index;
+          if (!s.ok()) {
+            mutex_lock l(mu_);
+            status_.Update(s);
+            cond_var_.notify_all();
+            return;
+          }
+        }
+      }
+
+      const TieredDataset* const dataset_;
+      mutex mu_;
+      condition_variable cond_var_;
+      std::deque<std::vector<Tensor>> pending_ GUARDED_BY(mu_);
+      bool finished_ GUARDED_BY(mu_) = false;
+      Status status_ GUARDED_BY(mu_);
+      // Only accessed by the writer thread, and by `Finish()` once that
+      // thread has been joined.
+      BundleWriter writer_;
+      std::unique_ptr<Thread> thread_;
+    };  // ShardWriter
+
+    // ShardReader reads the elements of one shard on a thread of its own,
+    // up to `kMaxPendingElements` ahead of its consumer.
+    class ShardReader {
+     public:
+      ShardReader(const TieredDataset* dataset, int64 shard_index)
+          : dataset_(dataset),
+            reader_(dataset->env_, dataset->ShardPrefix(shard_index)) {
+        thread_.reset(dataset->env_->StartThread(
+            {}, "tiered_cache_reader", [this]() { ReaderThread(); }));
+      }
+
+      ~ShardReader() {
+        {
+          mutex_lock l(mu_);
+          cancelled_ = true;
+          cond_var_.notify_all();
+        }
+        thread_.reset();
+      }
+
+      // Returns the next element of the shard, blocking until it has been
+      // read.
+      Status GetNext(std::vector<Tensor>* out_tensors, bool* end_of_shard) {
+        mutex_lock l(mu_);
+        while (buffer_.empty() && !end_of_shard_) {
+          cond_var_.wait(l);
+        }
+        if (buffer_.empty()) {
+          *end_of_shard = true;
+          return Status::OK();
+        }
+        *end_of_shard = false;
+        Status s = buffer_.front().status;
+        if (s.ok()) {
+          *out_tensors = std::move(buffer_.front().value);
+        }
+        buffer_.pop_front();
+        cond_var_.notify_all();
+        return s;
+      }
+
+     private:
+      void ReaderThread() {
+        Status s = reader_.status();
+        size_t item_index = 0;
+        bool end_of_shard = false;
+        while (s.ok() && !end_of_shard) {
+          {
+            mutex_lock l(mu_);
+            while (!cancelled_ && buffer_.size() >= kMaxPendingElements) {
+              cond_var_.wait(l);
+            }
+            if (cancelled_) {
+              return;
+            }
+          }
+          BufferElement element;
+          element.value.resize(dataset_->num_tensors_);
+          for (size_t i = 0; i < dataset_->num_tensors_ && s.ok(); ++i) {
+            reader_.Next();  // The first entry in the table is a header entry.
+            if (!reader_.Valid()) {
+              end_of_shard = true;
+              break;
+            }
+            DCHECK_EQ(reader_.key(), dataset_->FormatName(item_index, i));
+            s = reader_.ReadCurrent(&element.value[i]);
+          }
+          if (s.ok() && !end_of_shard) {
+            mutex_lock l(mu_);
+            buffer_.push_back(std::move(element));
+            cond_var_.notify_all();
+          }
+          ++item_index;
+        }
+        mutex_lock l(mu_);
+        if (!s.ok()) {
+          BufferElement element;
+          element.status = s;
+          buffer_.push_back(std::move(element));
+        }
+        end_of_shard_ = true;
+        cond_var_.notify_all();
+      }
+
+      const TieredDataset* const dataset_;
+      mutex mu_;
+      condition_variable cond_var_;
+      std::deque<BufferElement> buffer_ GUARDED_BY(mu_);
+      bool cancelled_ GUARDED_BY(mu_) = false;
+      bool end_of_shard_ GUARDED_BY(mu_) = false;
+      // Only accessed by the reader thread.
+      BundleReader reader_;
+      std::unique_ptr<Thread> thread_;
+    };  // ShardReader
+
+    // TieredWriterIterator passes through the elements of the input dataset,
+    // keeping them in memory until the budget is exhausted and handing the
+    // rest to the shard writers.
+    //
+    // Once the input is exhausted and all shards are finished, the memory
+    // tier is installed in the parent dataset and the manifest is written.
+    class TieredWriterIterator : public DatasetIterator<TieredDataset> {
+     public:
+      explicit TieredWriterIterator(const Params& params)
+          : DatasetIterator<TieredDataset>(params),
+            input_impl_(params.dataset->input_->MakeIterator(params.prefix)),
+            memory_tier_(new MemoryTier),
+            lockfile_(
+                strings::StrCat(params.dataset->filename_, ".lockfile")) {}
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        if (iteration_completed_) {
+          return errors::OutOfRange(
+              "Attempting to call get_next after iteration should have "
+              "finished.");
+        }
+        if (!lockfile_created_) {
+          TF_RETURN_IF_ERROR(CreateLockFile(dataset()->env_, lockfile_));
+          lockfile_created_ = true;
+          // Remove the manifest of a stale cache, whose shards are about to
+          // be overwritten.
+          dataset()->env_->DeleteFile(dataset()->ManifestFilename())
+              .IgnoreError();
+        }
+        const size_t max_spilled = kMaxItems * dataset()->num_shards_;
+        if (num_spilled_ >= max_spilled) {
+          return errors::InvalidArgument(
+              "Upstream iterator is spilling more than ", max_spilled,
+              " items, which is more than the cache limit.");
+        }
+
+        TF_RETURN_IF_ERROR(
+            input_impl_->GetNext(ctx, out_tensors, end_of_sequence));
+        if (*end_of_sequence) {
+          return Finish();
+        }
+        if (out_tensors->size() != dataset()->num_tensors_) {
+          return errors::Internal(
+              "Upstream iterator returned invalid number of tensors. Expected ",
+              dataset()->num_tensors_, " got: ", out_tensors->size());
+        }
+
+        if (!spilling_) {
+          int64 element_bytes = 0;
+          for (const Tensor& t : *out_tensors) {
+            element_bytes += t.TotalBytes();
+          }
+          if (memory_bytes_ + element_bytes <=
+              dataset()->memory_budget_bytes_) {
+            memory_bytes_ += element_bytes;
+            memory_tier_->push_back(*out_tensors);
+            return Status::OK();
+          }
+          // Keep the memory tier a prefix of the input, so that the element
+          // order does not depend on the element sizes.
+          spilling_ = true;
+          for (int64 i = 0; i < dataset()->num_shards_; ++i) {
+            shards_.emplace_back(new ShardWriter(dataset(), i));
+          }
+        }
+        ShardWriter* shard = shards_[num_spilled_ % shards_.size()].get();
+        ++num_spilled_;
+        return shard->Add(*out_tensors);
+      }
+
+     private:
+      Status Finish() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        iteration_completed_ = true;
+        Status s;
+        for (auto& shard : shards_) {
+          s.Update(shard->Finish());
+        }
+        TF_RETURN_IF_ERROR(s);
+        const int64 num_in_memory = memory_tier_->size();
+        {
+          mutex_lock l(dataset()->mu_);
+          dataset()->memory_tier_.reset(memory_tier_.release());
+        }
+        TF_RETURN_IF_ERROR(WriteStringToFile(
+            dataset()->env_, dataset()->ManifestFilename(),
+            strings::StrCat(num_in_memory, " ", dataset()->num_shards_, " ",
+                            num_spilled_)));
+        return dataset()->env_->DeleteFile(lockfile_);
+      }
+
+      mutex mu_;
+      std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      std::unique_ptr<MemoryTier> memory_tier_ GUARDED_BY(mu_);
+      int64 memory_bytes_ GUARDED_BY(mu_) = 0;
+      bool spilling_ GUARDED_BY(mu_) = false;
+      size_t num_spilled_ GUARDED_BY(mu_) = 0;
+      std::vector<std::unique_ptr<ShardWriter>> shards_ GUARDED_BY(mu_);
+      const string lockfile_;
+      bool lockfile_created_ GUARDED_BY(mu_) = false;
+      bool iteration_completed_ GUARDED_BY(mu_) = false;
+    };  // TieredWriterIterator
+
+    // TieredReaderIterator produces the elements of the memory tier, and
+    // then the spilled elements in their original order, taking them
+    // round-robin from the shard readers.
+    class TieredReaderIterator : public DatasetIterator<TieredDataset> {
+     public:
+      explicit TieredReaderIterator(
+          const Params& params, std::shared_ptr<const MemoryTier> memory_tier,
+          int64 num_spilled)
+          : DatasetIterator<TieredDataset>(params),
+            memory_tier_(std::move(memory_tier)),
+            num_in_memory_(memory_tier_ ? memory_tier_->size() : 0),
+            num_spilled_(num_spilled) {}
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        // Start reading the shards while the memory tier is consumed.
+        if (shards_.empty() && num_spilled_ > 0) {
+          for (int64 i = 0; i < dataset()->num_shards_; ++i) {
+            shards_.emplace_back(new ShardReader(dataset(), i));
+          }
+        }
+        *end_of_sequence = false;
+        if (index_ < num_in_memory_) {
+          const std::vector<Tensor>& cache_tensors = (*memory_tier_)[index_];
+          out_tensors->insert(out_tensors->begin(), cache_tensors.begin(),
+                              cache_tensors.end());
+          ++index_;
+          return Status::OK();
+        }
+        const int64 spilled_index = index_ - num_in_memory_;
+        if (spilled_index >= num_spilled_) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        ++index_;
+        ShardReader* shard = shards_[spilled_index % shards_.size()].get();
+        bool end_of_shard;
+        TF_RETURN_IF_ERROR(shard->GetNext(out_tensors, &end_of_shard));
+        if (end_of_shard) {
+          return errors::DataLoss("Cache shard ",
+                                  dataset()->ShardPrefix(spilled_index %
+                                                         shards_.size()),
+                                  " has fewer elements than its manifest.");
+        }
+        return Status::OK();
+      }
+
+     private:
+      mutex mu_;
+      const std::shared_ptr<const MemoryTier> memory_tier_;
+      const int64 num_in_memory_;
+      const int64 num_spilled_;
+      int64 index_ GUARDED_BY(mu_) = 0;
+      std::vector<std::unique_ptr<ShardReader>> shards_ GUARDED_BY(mu_);
+    };  // TieredReaderIterator
+
+    const DatasetBase* const input_;
+    const string filename_;
+    const int64 memory_budget_bytes_;
+    const int64 num_shards_;
+    Env* const env_;
+    const size_t num_tensors_;
+    const string tensor_format_string_;
+    mutable mutex mu_;
+    mutable std::shared_ptr<const MemoryTier> memory_tier_ GUARDED_BY(mu_);
+  };  // TieredDataset
+
   class MemoryDataset : public DatasetBase {
    public:
     explicit MemoryDataset(const DatasetBase* input) : input_(input) {
@@ -386,7 +865,10 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
         GUARDED_BY(mu_);
     mutable bool writer_iterator_created_ GUARDED_BY(mu_) = false;
   };  // MemoryDataset
-};    // CacheDatasetOp
+
+  int64 memory_budget_bytes_;
+  int64 num_shards_;
+};  // CacheDatasetOp
 
 REGISTER_KERNEL_BUILDER(Name("CacheDataset").Device(DEVICE_CPU),
                         CacheDatasetOp);
@@ -0,0 +1,627 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/collective_ops.cc.
+//
+// The collectives exchange chunks of their tensors with the other members of
+// the group through the rendezvous of the step, like _Send and _Recv do, so
+// they work across devices of one process as well as across workers.
+
+#include <string.h>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/rendezvous.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+
+namespace {
+
+// A ring over some of the members of a group.
+struct Ring {
+  // The indices of the members in the group, in ring order.
+  std::vector<int> members;
+  // The position of this member in `members`.
+  int pos = 0;
+
+  int size() const { return members.size(); }
+  int next() const { return members[(pos + 1) % members.size()]; }
+  int prev() const {
+    return members[(pos + members.size() - 1) % members.size()];
+  }
+};
+
+// Returns `i` modulo `n`, in [0, n).
+int Mod(int i, int n) { return ((i % n) + n) % n; }
+
+// Returns the `n` parts of the one-dimensional `t`, which differ in size by at
+// most one element.
+std::vector<Tensor> Split(const Tensor& t, int n) {
+  const int64 size = t.NumElements();
+  std::vector<Tensor> parts;
+  parts.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    parts.push_back(t.Slice(size * i / n, size * (i + 1) / n));
+  }
+  return parts;
+}
+
+void CopyContents(const Tensor& src, Tensor* dst) {
+  const StringPiece from = src.tensor_data();
+  memcpy(const_cast<char*>(dst->tensor_data().data()), from.data(),
+         from.size());
+}
+
+// The members of a collective, and the position of this device among them.
+class CollectiveGroup {
+ public:
+  Status Init(OpKernelConstruction* ctx) {
+    std::vector<string> devices;
+    TF_RETURN_IF_ERROR(ctx->GetAttr("devices", &devices));
+    std::vector<int64> incarnations;
+    TF_RETURN_IF_ERROR(ctx->GetAttr("device_incarnations", &incarnations));
+    if (incarnations.size() != devices.size()) {
+      return errors::InvalidArgument(
+          "Expected one incarnation for each of the ", devices.size(),
+          " devices, but got ", incarnations.size(),
+          ". The incarnations are set when the graph is partitioned.");
+    }
+    TF_RETURN_IF_ERROR(ctx->GetAttr("instance_key", &instance_key_));
+    if (instance_key_.empty() || instance_key_.find(';') != string::npos) {
+      return errors::InvalidArgument("Invalid instance_key: \"", instance_key_,
+                                     "\"");
+    }
+    const string self =
+        DeviceNameUtils::CanonicalizeDeviceName(ctx->device()->name());
+    rank_ = -1;
+    for (int i = 0; i < devices.size(); ++i) {
+      const string device = DeviceNameUtils::CanonicalizeDeviceName(devices[i]);
+      DeviceNameUtils::ParsedName parsed;
+      if (!DeviceNameUtils::ParseFullName(device, &parsed) ||
+          !parsed.has_job || !parsed.has_task || !parsed.has_type ||
+          !parsed.has_id) {
+        return errors::InvalidArgument("Expected a full device name, got: \"",
+                                       devices[i], "\"");
+      }
+      for (const string& other : devices_) {
+        if (other == device) {
+          return errors::InvalidArgument("Duplicate device: ", devices[i]);
+        }
+      }
+      if (device == self) rank_ = i;
+      devices_.push_back(device);
+      incarnations_.push_back(static_cast<uint64>(incarnations[i]));
+    }
+    if (rank_ < 0) {
+      return errors::InvalidArgument("Device ", ctx->device()->name(),
+                                     " is not one of the devices of ",
+                                     instance_key_);
+    }
+    return Status::OK();
+  }
+
+  int size() const { return devices_.size(); }
+  int rank() const { return rank_; }
+  const string& device(int i) const { return devices_[i]; }
+  uint64 incarnation(int i) const { return incarnations_[i]; }
+  const string& instance_key() const { return instance_key_; }
+
+  // Returns the ring over all the members.
+  Ring FlatRing() const {
+    Ring ring;
+    for (int i = 0; i < size(); ++i) ring.members.push_back(i);
+    ring.pos = rank_;
+    return ring;
+  }
+
+  // Sets `*local` to the ring over the members in the same task as this one,
+  // and `*cross` to the ring over the members at the same position as this one
+  // in the other tasks.
+  Status HierarchicalRings(Ring* local, Ring* cross) const {
+    std::vector<string> tasks;
+    std::unordered_map<string, std::vector<int>> members;
+    for (int i = 0; i < size(); ++i) {
+      string task, device;
+      DeviceNameUtils::SplitDeviceName(devices_[i], &task, &device);
+      if (members.count(task) == 0) tasks.push_back(task);
+      members[task].push_back(i);
+    }
+    string my_task, my_device;
+    DeviceNameUtils::SplitDeviceName(devices_[rank_], &my_task, &my_device);
+    local->members = members[my_task];
+    for (int i = 0; i < local->size(); ++i) {
+      if (local->members[i] == rank_) local->pos = i;
+    }
+    cross->members.clear();
+    for (const string& task : tasks) {
+      if (members[task].size() != local->members.size()) {
+        return errors::InvalidArgument(
+            "Hierarchical collectives need the same number of devices in each "
+            "task, but ",
+            task, " has ", members[task].size(), " and ", my_task, " has ",
+            local->members.size());
+      }
+      if (task == my_task) cross->pos = cross->members.size();
+      cross->members.push_back(members[task][local->pos]);
+    }
+    return Status::OK();
+  }
+
+ private:
+  std::vector<string> devices_;
+  std::vector<uint64> incarnations_;
+  string instance_key_;
+  int rank_;
+};
+
+// One execution of a collective on one member. It is reference counted by the
+// transfers in flight, and completes the kernel when the last one finishes.
+class CollectiveRun : public core::RefCounted {
+ public:
+  CollectiveRun(OpKernelContext* ctx, const CollectiveGroup* group,
+                AsyncOpKernel::DoneCallback done)
+      : ctx_(ctx), group_(group), done_(std::move(done)) {
+    send_args_.device_context = ctx->op_device_context();
+    send_args_.alloc_attrs.set_on_host(true);
+    recv_args_ = send_args_;
+  }
+
+  ~CollectiveRun() override {
+    if (status_.ok() && finish_) finish_();
+    ctx_->SetStatus(status_);
+    done_();
+  }
+
+  OpKernelContext* context() const { return ctx_; }
+
+  // Sets a function that runs once all the transfers succeeded.
+  void set_finish(std::function<void()> finish) { finish_ = std::move(finish); }
+
+  bool ok() {
+    mutex_lock l(mu_);
+    return status_.ok();
+  }
+
+  void Fail(const Status& s) {
+    mutex_lock l(mu_);
+    status_.Update(s);
+  }
+
+  // Sends `value` to member `to` under `name`. The value must not be modified
+  // afterwards, as the recipient may share its buffer.
+  void Send(const string& name, int to, const Tensor& value) {
+    Rendezvous::ParsedKey parsed;
+    Status s = ParseKey(group_->rank(), to, name, &parsed);
+    if (s.ok()) {
+      s = ctx_->rendezvous()->Send(parsed, send_args_, value, false);
+    }
+    if (!s.ok()) Fail(s);
+  }
+
+  // Receives the tensor that member `from` sends under `name`, and passes it
+  // to `consumer` on a thread of the device, unless the collective failed.
+  void Recv(const string& name, int from, int64 expected_elements,
+            std::function<void(const Tensor&)> consumer) {
+    Rendezvous::ParsedKey parsed;
+    const Status s = ParseKey(from, group_->rank(), name, &parsed);
+    if (!s.ok()) {
+      Fail(s);
+      return;
+    }
+    Ref();
+    ctx_->rendezvous()->RecvAsync(
+        parsed, recv_args_,
+        [this, name, expected_elements, consumer](
+            const Status& s, const Rendezvous::Args& send_args,
+            const Rendezvous::Args& recv_args, const Tensor& val,
+            bool is_dead) {
+          if (!s.ok()) {
+            Fail(s);
+          } else if (val.NumElements() != expected_elements) {
+            Fail(errors::InvalidArgument(
+                "Received ", val.NumElements(), " elements for ", name,
+                " instead of ", expected_elements,
+                ". The inputs of a collective must have the same shape on all "
+                "the devices."));
+          }
+          if (!ok()) {
+            Unref();
+            return;
+          }
+          // The consumer may send the next chunk, and the local rendezvous
+          // runs the recipient's callback inline, so the continuation runs on
+          // a separate thread to bound the depth of the stack.
+          ctx_->device()->tensorflow_cpu_worker_threads()->workers->Schedule(
+              [this, consumer, val]() {
+                consumer(val);
+                Unref();
+              });
+        });
+  }
+
+ private:
+  Status ParseKey(int src, int dst, const string& name,
+                  Rendezvous::ParsedKey* parsed) {
+    const string key = Rendezvous::CreateKey(
+        group_->device(src), group_->incarnation(src), group_->device(dst),
+        strings::StrCat("collective/", group_->instance_key(), "/", name),
+        ctx_->frame_iter());
+    return Rendezvous::ParseKey(key, parsed);
+  }
+
+  OpKernelContext* const ctx_;
+  const CollectiveGroup* const group_;
+  AsyncOpKernel::DoneCallback done_;
+  Rendezvous::Args send_args_;
+  Rendezvous::Args recv_args_;
+  std::function<void()> finish_;
+
+  mutex mu_;
+  Status status_ GUARDED_BY(mu_);
+};
+
+// Merges a received chunk into the local one.
+typedef void (*ReduceFn)(const Tensor& received, Tensor* local);
+
+template <typename T>
+void ReduceSum(const Tensor& received, Tensor* local) {
+  local->flat<T>() += received.flat<T>();
+}
+
+template <typename T>
+void ReduceMin(const Tensor& received, Tensor* local) {
+  local->flat<T>() = local->flat<T>().cwiseMin(received.flat<T>());
+}
+
+template <typename T>
+void ReduceMax(const Tensor& received, Tensor* local) {
+  local->flat<T>() = local->flat<T>().cwiseMax(received.flat<T>());
+}
+
+// Runs the `ring.size() - 1` steps of a pass around `ring` over `chunks`, one
+// per member of the ring, then calls `next`. At step `s`, each member sends
+// its chunk `first - s` to the next member, and receives chunk `first - s - 1`
+// from the previous member, which it merges with `reduce` or, if `reduce` is
+// null, copies into its own.
+//
+// A reduce-scatter, with `first` the position of the member, leaves each member
+// with the reduction of chunk `pos + 1`, and an all-gather with `first` the
+// chunk that each member owns passes the owned chunks to all the members.
+void RingPass(CollectiveRun* run, const Ring* ring, const string& name,
+              std::shared_ptr<std::vector<Tensor>> chunks, int first,
+              ReduceFn reduce, int step, std::function<void()> next) {
+  const int n = ring->size();
+  if (step >= n - 1) {
+    next();
+    return;
+  }
+  if (!run->ok()) return;
+  const string step_name = strings::StrCat(name, "/", step);
+  const Tensor& send_chunk = (*chunks)[Mod(first - step, n)];
+  if (reduce != nullptr) {
+    // The chunk is reduced into again later in the collective, so the
+    // recipient gets a copy of it.
+    Tensor copy;
+    AllocatorAttributes attr;
+    attr.set_on_host(true);
+    const Status s = run->context()->allocate_temp(
+        send_chunk.dtype(), send_chunk.shape(), &copy, attr);
+    if (!s.ok()) {
+      run->Fail(s);
+      return;
+    }
+    CopyContents(send_chunk, &copy);
+    run->Send(step_name, ring->next(), copy);
+  } else {
+    run->Send(step_name, ring->next(), send_chunk);
+  }
+  const int recv_index = Mod(first - step - 1, n);
+  run->Recv(step_name, ring->prev(), (*chunks)[recv_index].NumElements(),
+            [run, ring, name, chunks, first, reduce, step, next,
+             recv_index](const Tensor& received) {
+              Tensor* local = &(*chunks)[recv_index];
+              if (reduce != nullptr) {
+                reduce(received, local);
+              } else {
+                CopyContents(received, local);
+              }
+              RingPass(run, ring, name, chunks, first, reduce, step + 1, next);
+            });
+}
+
+// Reduces `region` across `ring` with a reduce-scatter followed by an
+// all-gather, then calls `next`.
+void RingAllReduce(CollectiveRun* run, const Ring* ring, const string& name,
+                   const Tensor& region, ReduceFn reduce,
+                   std::function<void()> next) {
+  auto chunks =
+      std::make_shared<std::vector<Tensor>>(Split(region, ring->size()));
+  RingPass(run, ring, strings::StrCat(name, "/rs"), chunks, ring->pos, reduce,
+           0, [run, ring, name, chunks, next]() {
+             RingPass(run, ring, strings::StrCat(name, "/ag"), chunks,
+                      ring->pos + 1, nullptr, 0, next);
+           });
+}
+
+template <typename T>
+class CollectiveAllReduceOp : public AsyncOpKernel {
+ public:
+  explicit CollectiveAllReduceOp(OpKernelConstruction* ctx)
+      : AsyncOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, group_.Init(ctx));
+    string reduction;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("reduction", &reduction));
+    mean_ = reduction == "mean";
+    if (reduction == "min") {
+      reduce_ = ReduceMin<T>;
+    } else if (reduction == "max") {
+      reduce_ = ReduceMax<T>;
+    } else {
+      reduce_ = ReduceSum<T>;
+    }
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("subdivs", &subdivs_));
+    bool hierarchical;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("hierarchical", &hierarchical));
+    if (hierarchical) {
+      OP_REQUIRES_OK(ctx, group_.HierarchicalRings(&local_, &cross_));
+    } else {
+      local_ = group_.FlatRing();
+    }
+    hierarchical_ = hierarchical && cross_.size() > 1;
+  }
+
+  void ComputeAsync(OpKernelContext* ctx, DoneCallback done) override {
+    OP_REQUIRES_ASYNC(
+        ctx, ctx->rendezvous() != nullptr,
+        errors::Internal("Op kernel context needs to provide a rendezvous."),
+        done);
+    const Tensor& input = ctx->input(0);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK_ASYNC(ctx,
+                         ctx->forward_input_or_allocate_output(
+                             {0}, 0, input.shape(), &output),
+                         done);
+    if (!output->SharesBufferWith(input)) CopyContents(input, output);
+    Tensor flat;
+    CHECK(flat.CopyFrom(*output, TensorShape({output->NumElements()})));
+
+    CollectiveRun* run = new CollectiveRun(ctx, &group_, std::move(done));
+    if (mean_) {
+      const T n = static_cast<T>(group_.size());
+      run->set_finish(
+          [output, n]() { output->flat<T>() = output->flat<T>() / n; });
+    }
+    std::vector<Tensor> regions = Split(flat, subdivs_);
+    for (int d = 0; d < subdivs_; ++d) {
+      const string name = strings::StrCat(d);
+      if (!hierarchical_) {
+        RingAllReduce(run, &local_, name, regions[d], reduce_, []() {});
+        continue;
+      }
+      // Reduces within the task, so that each member holds the local
+      // reduction of one chunk, then reduces that chunk across the tasks, and
+      // finally gathers the chunks within the task.
+      auto chunks = std::make_shared<std::vector<Tensor>>(
+          Split(regions[d], local_.size()));
+      const Ring* local = &local_;
+      const Ring* cross = &cross_;
+      const ReduceFn reduce = reduce_;
+      RingPass(
+          run, local, strings::StrCat(name, "/lrs"), chunks, local->pos, reduce,
+          0, [run, local, cross, name, chunks, reduce]() {
+            const Tensor owned = (*chunks)[Mod(local->pos + 1, local->size())];
+            RingAllReduce(
+                run, cross, strings::StrCat(name, "/x"), owned, reduce,
+                [run, local, name, chunks]() {
+                  RingPass(run, local, strings::StrCat(name, "/lag"), chunks,
+                           local->pos + 1, nullptr, 0, []() {});
+                });
+          });
+    }
+    run->Unref();
+  }
+
+ private:
+  CollectiveGroup group_;
+  ReduceFn reduce_;
+  bool mean_;
+  int subdivs_;
+  bool hierarchical_;
+  Ring local_;
+  Ring cross_;
+};
+
+#define REGISTER_ALL_REDUCE(T)                                               \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("CollectiveAllReduce").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      CollectiveAllReduceOp<T>);                                             \
+  REGISTER_KERNEL_BUILDER(Name("CollectiveAllReduce")                        \
+                              .Device(DEVICE_GPU)                            \
+                              .HostMemory("input")                           \
+                              .HostMemory("data")                            \
+                              .TypeConstraint<T>("T"),                       \
+                          CollectiveAllReduceOp<T>);
+
+TF_CALL_half(REGISTER_ALL_REDUCE);
+TF_CALL_float(REGISTER_ALL_REDUCE);
+TF_CALL_double(REGISTER_ALL_REDUCE);
+TF_CALL_int32(REGISTER_ALL_REDUCE);
+TF_CALL_int64(REGISTER_ALL_REDUCE);
+#undef REGISTER_ALL_REDUCE
+
+class CollectiveAllGatherOp : public AsyncOpKernel {
+ public:
+  explicit CollectiveAllGatherOp(OpKernelConstruction* ctx)
+      : AsyncOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, group_.Init(ctx));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("subdivs", &subdivs_));
+    DataType dtype;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("T", &dtype));
+    OP_REQUIRES(ctx, DataTypeCanUseMemcpy(dtype),
+                errors::Unimplemented("CollectiveAllGather of ",
+                                      DataTypeString(dtype)));
+    ring_ = group_.FlatRing();
+  }
+
+  void ComputeAsync(OpKernelContext* ctx, DoneCallback done) override {
+    OP_REQUIRES_ASYNC(
+        ctx, ctx->rendezvous() != nullptr,
+        errors::Internal("Op kernel context needs to provide a rendezvous."),
+        done);
+    const Tensor& input = ctx->input(0);
+    OP_REQUIRES_ASYNC(
+        ctx, TensorShapeUtils::IsVectorOrHigher(input.shape()),
+        errors::InvalidArgument("input must be at least 1-D, got shape ",
+                                input.shape().DebugString()),
+        done);
+    TensorShape output_shape = input.shape();
+    output_shape.set_dim(0, output_shape.dim_size(0) * group_.size());
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK_ASYNC(ctx, ctx->allocate_output(0, output_shape, &output),
+                         done);
+    Tensor flat;
+    CHECK(flat.CopyFrom(*output, TensorShape({output->NumElements()})));
+    // The slot of each member holds its input.
+    std::vector<Tensor> slots = Split(flat, group_.size());
+    CopyContents(input, &slots[group_.rank()]);
+
+    CollectiveRun* run = new CollectiveRun(ctx, &group_, std::move(done));
+    for (int d = 0; d < subdivs_; ++d) {
+      auto chunks = std::make_shared<std::vector<Tensor>>();
+      for (const Tensor& slot : slots) {
+        chunks->push_back(Split(slot, subdivs_)[d]);
+      }
+      RingPass(run, &ring_, strings::StrCat(d), chunks, ring_.pos, nullptr, 0,
+               []() {});
+    }
+    run->Unref();
+  }
+
+ private:
+  CollectiveGroup group_;
+  int subdivs_;
+  Ring ring_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("CollectiveAllGather").Device(DEVICE_CPU),
+                        CollectiveAllGatherOp);
+REGISTER_KERNEL_BUILDER(Name("CollectiveAllGather")
+                            .Device(DEVICE_GPU)
+                            .HostMemory("input")
+                            .HostMemory("data"),
+                        CollectiveAllGatherOp);
+
+class CollectiveBroadcastOp : public AsyncOpKernel {
+ public:
+  explicit CollectiveBroadcastOp(OpKernelConstruction* ctx)
+      : AsyncOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, group_.Init(ctx));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("subdivs", &subdivs_));
+    int source_rank;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("source_rank", &source_rank));
+    OP_REQUIRES(ctx, source_rank < group_.size(),
+                errors::InvalidArgument("source_rank ", source_rank,
+                                        " is not less than the number of "
+                                        "devices ",
+                                        group_.size()));
+    DataType dtype;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("T", &dtype));
+    OP_REQUIRES(ctx, DataTypeCanUseMemcpy(dtype),
+                errors::Unimplemented("CollectiveBroadcast of ",
+                                      DataTypeString(dtype)));
+    // The members form a binary tree in the order of their rank relative to
+    // the source.
+    const int n = group_.size();
+    const int relative = Mod(group_.rank() - source_rank, n);
+    parent_ = relative == 0 ? -1 : Mod((relative - 1) / 2 + source_rank, n);
+    for (int child = 2 * relative + 1; child <= 2 * relative + 2; ++child) {
+      if (child < n) children_.push_back(Mod(child + source_rank, n));
+    }
+  }
+
+  void ComputeAsync(OpKernelContext* ctx, DoneCallback done) override {
+    OP_REQUIRES_ASYNC(
+        ctx, ctx->rendezvous() != nullptr,
+        errors::Internal("Op kernel context needs to provide a rendezvous."),
+        done);
+    const Tensor& input = ctx->input(0);
+    CollectiveRun* run = new CollectiveRun(ctx, &group_, std::move(done));
+    if (parent_ < 0) {
+      // The output is never modified, so the children share its buffer.
+      ctx->set_output(0, input);
+      Tensor flat;
+      CHECK(flat.CopyFrom(input, TensorShape({input.NumElements()})));
+      std::vector<Tensor> parts = Split(flat, subdivs_);
+      for (int d = 0; d < subdivs_; ++d) {
+        const string name = strings::StrCat(d);
+        for (int child : children_) run->Send(name, child, parts[d]);
+      }
+      run->Unref();
+      return;
+    }
+    Tensor* output = nullptr;
+    Status s = ctx->allocate_output(0, input.shape(), &output);
+    if (!s.ok()) {
+      run->Fail(s);
+      run->Unref();
+      return;
+    }
+    Tensor flat;
+    CHECK(flat.CopyFrom(*output, TensorShape({output->NumElements()})));
+    std::vector<Tensor> parts = Split(flat, subdivs_);
+    for (int d = 0; d < subdivs_; ++d) {
+      const string name = strings::StrCat(d);
+      Tensor part = parts[d];
+      const std::vector<int>* children = &children_;
+      run->Recv(name, parent_, part.NumElements(),
+                [run, name, part, children](const Tensor& received) {
+                  Tensor local = part;
+                  CopyContents(received, &local);
+                  for (int child : *children) run->Send(name, child, local);
+                });
+    }
+    run->Unref();
+  }
+
+ private:
+  CollectiveGroup group_;
+  int subdivs_;
+  int parent_;
+  std::vector<int> children_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("CollectiveBroadcast").Device(DEVICE_CPU),
+                        CollectiveBroadcastOp);
+REGISTER_KERNEL_BUILDER(Name("CollectiveBroadcast")
+                            .Device(DEVICE_GPU)
+                            .HostMemory("input")
+                            .HostMemory("data"),
+                        CollectiveBroadcastOp);
+
+}  // namespace
+
+}  // namespace tensorflow
@@ -21,6 +21,7 @@ limitations under the License.
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/scoped_allocator.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/framework/types.h"
@@ -255,6 +256,131 @@ REGISTER_KERNEL_BUILDER(Name("ConcatV2")
 #undef REGISTER_SYCL
 #endif // TENSORFLOW_USE_SYCL
 
+// Allocates the backing tensor of a ScopedAllocator for the step.
+class ScopedAllocatorOp : public OpKernel {
+ public:
+  explicit ScopedAllocatorOp(OpKernelConstruction* c) : OpKernel(c) {
+    OP_REQUIRES_OK(c, c->GetAttr("shapes", &shapes_));
+    OP_REQUIRES_OK(c, c->GetAttr("shape", &shape_));
+    OP_REQUIRES_OK(c, c->GetAttr("id", &id_));
+    int64 num_elements = 0;
+    for (const TensorShape& shape : shapes_) {
+      num_elements += shape.num_elements();
+    }
+    OP_REQUIRES(c, num_elements == shape_.num_elements(),
+                errors::InvalidArgument(
+                    "The fields of ScopedAllocator ", id_, " have ",
+                    num_elements, " elements, but its shape ",
+                    shape_.DebugString(), " has ", shape_.num_elements()));
+  }
+
+  void Compute(OpKernelContext* c) override {
+    Tensor* backing = nullptr;
+    OP_REQUIRES_OK(c, c->allocate_output(0, shape_, &backing));
+    // Without a step container, the fields are allocated like any other
+    // output, and copied by _ScopedAllocatorConcat.
+    if (c->resource_manager() == nullptr || c->step_container() == nullptr) {
+      return;
+    }
+    ScopedAllocator* scoped_allocator =
+        new ScopedAllocator(*backing, id_, shapes_);
+    OP_REQUIRES_OK(c, scoped_allocator->Register(c->resource_manager(),
+                                                 c->step_container()));
+  }
+
+ private:
+  std::vector<TensorShape> shapes_;
+  TensorShape shape_;
+  int32 id_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("_ScopedAllocator").Device(DEVICE_CPU),
+                        ScopedAllocatorOp);
+#if GOOGLE_CUDA
+REGISTER_KERNEL_BUILDER(Name("_ScopedAllocator").Device(DEVICE_GPU),
+                        ScopedAllocatorOp);
+#endif  // GOOGLE_CUDA
+
+// Forwards the backing tensor of a ScopedAllocator if its fields hold the
+// values, or else concatenates them like ConcatV2 along the first axis.
+template <typename Device, typename T>
+class ScopedAllocatorConcatOp : public OpKernel {
+ public:
+  typedef std::vector<std::unique_ptr<typename TTypes<T, 2>::ConstMatrix>>
+      ConstMatrixVector;
+
+  explicit ScopedAllocatorConcatOp(OpKernelConstruction* c) : OpKernel(c) {}
+
+  void Compute(OpKernelContext* c) override {
+    const Tensor& backing = c->input(0);
+    OpInputList values;
+    OP_REQUIRES_OK(c, c->input_list("values", &values));
+    const char* const backing_data = backing.tensor_data().data();
+    int64 num_elements = 0;
+    bool in_fields = true;
+    for (int i = 0; i < values.size(); ++i) {
+      const StringPiece data = values[i].tensor_data();
+      if (!data.empty() &&
+          data.data() != backing_data + num_elements * sizeof(T)) {
+        in_fields = false;
+      }
+      num_elements += values[i].NumElements();
+    }
+    OP_REQUIRES(c, num_elements == backing.NumElements(),
+                errors::InvalidArgument(
+                    "The values have ", num_elements,
+                    " elements, but the backing tensor has shape ",
+                    backing.shape().DebugString()));
+    if (in_fields) {
+      c->set_output(0, backing);
+      return;
+    }
+
+    VLOG(2) << "Copying the values of " << name()
+            << " that are not in their fields";
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(c, c->allocate_output(0, backing.shape(), &output));
+    if (num_elements == 0) return;
+    ConstMatrixVector inputs_flat;
+    inputs_flat.reserve(values.size());
+    for (int i = 0; i < values.size(); ++i) {
+      if (values[i].NumElements() > 0) {
+        inputs_flat.emplace_back(new typename TTypes<T, 2>::ConstMatrix(
+            values[i].shaped<T, 2>({1, values[i].NumElements()})));
+      }
+    }
+    auto output_flat = output->shaped<T, 2>({1, num_elements});
+#if GOOGLE_CUDA
+    if (std::is_same<Device, GPUDevice>::value) {
+      ConcatGPU<T>(c, inputs_flat, output, &output_flat);
+      return;
+    }
+#endif  // GOOGLE_CUDA
+    ConcatCPU<T>(c->device(), inputs_flat, &output_flat);
+  }
+};
+
+#define REGISTER_SCOPED_ALLOCATOR_CONCAT(type)               \
+  REGISTER_KERNEL_BUILDER(Name("_ScopedAllocatorConcat")     \
+                              .Device(DEVICE_CPU)            \
+                              .TypeConstraint<type>("T"),    \
+                          ScopedAllocatorConcatOp<CPUDevice, type>)
+
+TF_CALL_POD_TYPES(REGISTER_SCOPED_ALLOCATOR_CONCAT);
+#undef REGISTER_SCOPED_ALLOCATOR_CONCAT
+
+#if GOOGLE_CUDA
+#define REGISTER_SCOPED_ALLOCATOR_CONCAT(type)               \
+  REGISTER_KERNEL_BUILDER(Name("_ScopedAllocatorConcat")     \
+                              .Device(DEVICE_GPU)            \
+                              .TypeConstraint<type>("T"),    \
+                          ScopedAllocatorConcatOp<GPUDevice, type>)
+
+TF_CALL_GPU_NUMBER_TYPES(REGISTER_SCOPED_ALLOCATOR_CONCAT);
+TF_CALL_int64(REGISTER_SCOPED_ALLOCATOR_CONCAT);
+#undef REGISTER_SCOPED_ALLOCATOR_CONCAT
+#endif  // GOOGLE_CUDA
+
 class ConcatOffsetOp : public OpKernel {
  public:
   explicit ConcatOffsetOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
@@ -19,8 +19,11 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/graph/node_builder.h"
@@ -250,5 +253,50 @@ BENCHMARK(MemcpyManyAlternative2)
     ->Arg(64)
     ->Arg(65);
 
+class ScopedAllocatorConcatOpTest : public OpsTestBase {
+ protected:
+  void MakeOp() {
+    TF_ASSERT_OK(NodeDefBuilder("concat", "_ScopedAllocatorConcat")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(2, DT_FLOAT))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(ScopedAllocatorConcatOpTest, ForwardsBackingTensor) {
+  MakeOp();
+  AddInputFromArray<float>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  // The values are the fields of the backing tensor.
+  const Tensor* backing = mutable_input(0).tensor;
+  for (int i = 0; i < 2; ++i) {
+    tensors_.push_back(new Tensor(backing->Slice(i, i + 1)));
+    inputs_.push_back({nullptr, tensors_.back()});
+  }
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(backing->tensor_data().data(),
+            GetOutput(0)->tensor_data().data());
+  test::ExpectTensorEqual<float>(*backing, *GetOutput(0));
+}
+
+TEST_F(ScopedAllocatorConcatOpTest, CopiesValuesOutsideFields) {
+  MakeOp();
+  AddInputFromArray<float>(TensorShape({2, 3}), {0, 0, 0, 0, 0, 0});
+  AddInputFromArray<float>(TensorShape({1, 3}), {1, 2, 3});
+  AddInputFromArray<float>(TensorShape({1, 3}), {4, 5, 6});
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 3}));
+  test::FillValues<float>(&expected, {1, 2, 3, 4, 5, 6});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(ScopedAllocatorConcatOpTest, RejectsWrongNumberOfElements) {
+  MakeOp();
+  AddInputFromArray<float>(TensorShape({2, 3}), {0, 0, 0, 0, 0, 0});
+  AddInputFromArray<float>(TensorShape({1, 3}), {1, 2, 3});
+  AddInputFromArray<float>(TensorShape({1, 2}), {4, 5});
+  EXPECT_TRUE(errors::IsInvalidArgument(RunOpKernel()));
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -383,13 +383,15 @@ class Conv2DCustomBackpropFilterOp : public OpKernel {
         (target_working_set_size + work_unit_size - 1) / work_unit_size;
 
     Tensor col_buffer;
+    AllocatorAttributes col_buffer_attr;
+    col_buffer_attr.set_scratch(true);
     OP_REQUIRES_OK(context,
                    context->allocate_temp(
                        DataTypeToEnum<T>::value,
                        TensorShape({static_cast<int64>(shard_size),
                                     static_cast<int64>(output_image_size),
                                     static_cast<int64>(filter_total_size)}),
-                       &col_buffer));
+                       &col_buffer, col_buffer_attr));
 
     // The input offset corresponding to a single input image.
     const int input_offset = dims.spatial_dims[0].input_size *
@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/conv_2d.h"
 #include "tensorflow/core/kernels/deep_conv2d.h"
+#include "tensorflow/core/kernels/fused_bias_activation_functor.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #ifdef TENSORFLOW_USE_LIBXSMM
 #include "tensorflow/core/kernels/xsmm_conv2d.h"
@@ -248,9 +249,9 @@ class LaunchXsmmConvOp<CPUDevice, float> {
 #endif
 
 template <typename Device, typename T>
-class Conv2DOp : public BinaryOp<T> {
+class Conv2DOp : public OpKernel {
  public:
-  explicit Conv2DOp(OpKernelConstruction* context) : BinaryOp<T>(context) {
+  explicit Conv2DOp(OpKernelConstruction* context) : OpKernel(context) {
     OP_REQUIRES_OK(context, context->GetAttr("strides", &strides_));
     string data_format;
     OP_REQUIRES_OK(context, context->GetAttr("data_format", &data_format));
@@ -399,6 +400,75 @@ class Conv2DOp : public BinaryOp<T> {
   TF_DISALLOW_COPY_AND_ASSIGN(Conv2DOp);
 };
 
+#if GOOGLE_CUDA
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                             \
+  template <>                                                           \
+  void BiasActivation<GPUDevice, T>::operator()(                        \
+      const GPUDevice& d, typename TTypes<T, 3>::Tensor output,         \
+      typename TTypes<T>::ConstVec bias, FusedActivation activation);   \
+  extern template struct BiasActivation<GPUDevice, T>;
+
+DECLARE_GPU_SPEC(Eigen::half);
+DECLARE_GPU_SPEC(float);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+#endif  // GOOGLE_CUDA
+
+// Conv2D followed by BiasAdd and an activation, which grappler fuses. The
+// bias and the activation are applied in place, in a single pass over the
+// output of the convolution.
+template <typename Device, typename T>
+class FusedConv2DOp : public Conv2DOp<Device, T> {
+ public:
+  explicit FusedConv2DOp(OpKernelConstruction* context)
+      : Conv2DOp<Device, T>(context) {
+    string data_format;
+    OP_REQUIRES_OK(context, context->GetAttr("data_format", &data_format));
+    OP_REQUIRES(context, FormatFromString(data_format, &data_format_),
+                errors::InvalidArgument("Invalid data format"));
+    string activation;
+    OP_REQUIRES_OK(context, context->GetAttr("activation", &activation));
+    OP_REQUIRES_OK(context,
+                   FusedActivationFromString(activation, &activation_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& filter = context->input(1);
+    const Tensor& bias = context->input(2);
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(bias.shape()),
+                errors::InvalidArgument("bias must be 1-dimensional: ",
+                                        bias.shape().DebugString()));
+    OP_REQUIRES(
+        context, filter.dims() != 4 || bias.dim_size(0) == filter.dim_size(3),
+        errors::InvalidArgument("bias and filter must have the same depth: ",
+                                bias.dim_size(0), " vs ", filter.dim_size(3)));
+
+    Conv2DOp<Device, T>::Compute(context);
+    if (!context->status().ok()) return;
+    Tensor* output = context->mutable_output(0);
+    if (output->NumElements() == 0) return;
+
+    const int64 batch = GetTensorDim(*output, data_format_, 'N');
+    const int64 depth = GetTensorDim(*output, data_format_, 'C');
+    const int64 spatial = GetTensorDim(*output, data_format_, 'H') *
+                          GetTensorDim(*output, data_format_, 'W');
+    const int64 outer = data_format_ == FORMAT_NHWC ? batch * spatial : batch;
+    const int64 inner = data_format_ == FORMAT_NHWC ? 1 : spatial;
+    functor::BiasActivation<Device, T>()(
+        context->eigen_device<Device>(),
+        output->shaped<T, 3>({outer, depth, inner}), bias.vec<T>(),
+        activation_);
+  }
+
+ private:
+  TensorFormat data_format_;
+  FusedActivation activation_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FusedConv2DOp);
+};
+
 #define REGISTER_CPU(T)                                         \
   REGISTER_KERNEL_BUILDER(                                      \
       Name("Conv2D").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
@@ -411,6 +481,17 @@ TF_CALL_half(REGISTER_CPU);
 TF_CALL_float(REGISTER_CPU);
 #endif  // USE_GEMM_FOR_CONV
 
+// With MKL, the graph rewrite pass fuses Conv2D and BiasAdd into MKL kernels
+// instead.
+#if !defined(USE_GEMM_FOR_CONV) && !defined(INTEL_MKL)
+#define REGISTER_FUSED_CPU(T)                                         \
+  REGISTER_KERNEL_BUILDER(                                            \
+      Name("_FusedConv2D").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedConv2DOp<CPUDevice, T>);
+TF_CALL_half(REGISTER_FUSED_CPU);
+TF_CALL_float(REGISTER_FUSED_CPU);
+#endif  // !USE_GEMM_FOR_CONV && !INTEL_MKL
+
 // To be used inside depthwise_conv_op.cc.
 template class LaunchConv2DOp<CPUDevice, float>;
 
@@ -776,6 +857,12 @@ REGISTER_KERNEL_BUILDER(
 REGISTER_KERNEL_BUILDER(
     Name("Conv2D").Device(DEVICE_GPU).TypeConstraint<float>("T"),
     Conv2DOp<GPUDevice, float>);
+REGISTER_KERNEL_BUILDER(
+    Name("_FusedConv2D").Device(DEVICE_GPU).TypeConstraint<Eigen::half>("T"),
+    FusedConv2DOp<GPUDevice, Eigen::half>);
+REGISTER_KERNEL_BUILDER(
+    Name("_FusedConv2D").Device(DEVICE_GPU).TypeConstraint<float>("T"),
+    FusedConv2DOp<GPUDevice, float>);
 
 // To be used inside depthwise_conv_op.cc.
 template class LaunchConv2DOp<GPUDevice, float>;
@@ -120,8 +120,13 @@ class ConvParameters {
     return !(*this == other);
   }
   uint64 hash() const { return hash_code_; }
+  int device_id() const { return device_id_; }
 
   string ToString() const {
+    return strings::StrCat(ToStringWithoutDevice(), ", ", device_id_);
+  }
+
+  string ToStringWithoutDevice() const {
     // clang-format off
     return strings::StrCat(
         batch_, ", ", in_depths_, ", ",
@@ -130,8 +135,7 @@ class ConvParameters {
         "(", str_util::Join(filter_, ", "), "), ",
         "(", str_util::Join(stride_, ", "), "), ",
         "(", str_util::Join(padding_, ", "), "), ",
-        dtype_, ", ",
-        device_id_);
+        dtype_);
     // clang-format on
   }
 
@@ -0,0 +1,368 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#ifndef TENSORFLOW_KERNELS_CPU_REDUCTION_H_
+#define TENSORFLOW_KERNELS_CPU_REDUCTION_H_
+
+// Vectorized CPU kernels for the reductions of contiguous tensors over their
+// inner dimension, their middle dimension, or their outer and inner
+// dimensions, which cover the reductions that ReductionOp and BiasGradOp
+// perform without transposing their input.
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace functor {
+
+// The dimensions that CpuReduce reduces of a row-major [d0, d1, d2] tensor.
+enum class CpuReduceShape {
+  kInner,       // Reduces d2 into [d0, d1].
+  kMiddle,      // Reduces d1 into [d0, d2].
+  kOuterInner,  // Reduces d0 and d2 into [d1].
+};
+
+namespace cpu_reduction {
+
+template <typename T>
+struct Sum {
+  static T Apply(const T& a, const T& b) { return a + b; }
+  template <typename Packet>
+  static Packet ApplyPacket(const Packet& a, const Packet& b) {
+    return Eigen::internal::padd(a, b);
+  }
+  template <typename Packet>
+  static T Redux(const Packet& p) {
+    return Eigen::internal::predux(p);
+  }
+};
+
+template <typename T>
+struct Prod {
+  static T Apply(const T& a, const T& b) { return a * b; }
+  template <typename Packet>
+  static Packet ApplyPacket(const Packet& a, const Packet& b) {
+    return Eigen::internal::pmul(a, b);
+  }
+  template <typename Packet>
+  static T Redux(const Packet& p) {
+    return Eigen::internal::predux_mul(p);
+  }
+};
+
+template <typename T>
+struct Max {
+  static T Apply(const T& a, const T& b) { return Eigen::numext::maxi(a, b); }
+  template <typename Packet>
+  static Packet ApplyPacket(const Packet& a, const Packet& b) {
+    return Eigen::internal::pmax(a, b);
+  }
+  template <typename Packet>
+  static T Redux(const Packet& p) {
+    return Eigen::internal::predux_max(p);
+  }
+};
+
+template <typename T>
+struct Min {
+  static T Apply(const T& a, const T& b) { return Eigen::numext::mini(a, b); }
+  template <typename Packet>
+  static Packet ApplyPacket(const Packet& a, const Packet& b) {
+    return Eigen::internal::pmin(a, b);
+  }
+  template <typename Packet>
+  static T Redux(const Packet& p) {
+    return Eigen::internal::predux_min(p);
+  }
+};
+
+// The reduction of an Eigen reducer, for the reducers and the types that the
+// kernels below support. A mean is computed as a sum, which is then divided.
+template <typename T>
+struct IsSupportedType {
+  static const bool value =
+      std::is_same<T, float>::value || std::is_same<T, double>::value;
+};
+
+template <typename Reducer>
+struct Reduction {
+  static const bool kSupported = false;
+};
+
+template <typename T>
+struct Reduction<Eigen::internal::SumReducer<T>> {
+  static const bool kSupported = IsSupportedType<T>::value;
+  static const bool kMean = false;
+  typedef Sum<T> Op;
+};
+
+template <typename T>
+struct Reduction<Eigen::internal::MeanReducer<T>> {
+  static const bool kSupported = IsSupportedType<T>::value;
+  static const bool kMean = true;
+  typedef Sum<T> Op;
+};
+
+template <typename T>
+struct Reduction<Eigen::internal::ProdReducer<T>> {
+  static const bool kSupported = IsSupportedType<T>::value;
+  static const bool kMean = false;
+  typedef Prod<T> Op;
+};
+
+template <typename T>
+struct Reduction<Eigen::internal::MaxReducer<T>> {
+  static const bool kSupported = IsSupportedType<T>::value;
+  static const bool kMean = false;
+  typedef Max<T> Op;
+};
+
+template <typename T>
+struct Reduction<Eigen::internal::MinReducer<T>> {
+  static const bool kSupported = IsSupportedType<T>::value;
+  static const bool kMean = false;
+  typedef Min<T> Op;
+};
+
+// The elements below which a row is not split across threads, and the
+// number of rows below which the rows of a column reduction are not.
+const int64 kMinRowChunk = 16 * 1024;
+const int64 kMinRowsPerShard = 256;
+
+// The columns of a column reduction that are reduced together, so that the
+// partial results stay in the L1 cache while the rows stream through.
+const int64 kColumnBlock = 1024;
+
+// Returns the reduction of the "n" > 0 elements of "data", with independent
+// accumulators so that consecutive packets do not depend on each other.
+template <typename Op, typename T>
+T ReduceContiguous(const T* data, int64 n) {
+  typedef typename Eigen::internal::packet_traits<T>::type Packet;
+  const int64 kPacketSize = Eigen::internal::unpacket_traits<Packet>::size;
+  using Eigen::internal::ploadu;
+  int64 i = 0;
+  T result;
+  if (n >= 4 * kPacketSize) {
+    Packet acc0 = ploadu<Packet>(data);
+    Packet acc1 = ploadu<Packet>(data + kPacketSize);
+    Packet acc2 = ploadu<Packet>(data + 2 * kPacketSize);
+    Packet acc3 = ploadu<Packet>(data + 3 * kPacketSize);
+    for (i = 4 * kPacketSize; i + 4 * kPacketSize <= n; i += 4 * kPacketSize) {
+      acc0 = Op::ApplyPacket(acc0, ploadu<Packet>(data + i));
+      acc1 = Op::ApplyPacket(acc1, ploadu<Packet>(data + i + kPacketSize));
+      acc2 = Op::ApplyPacket(acc2, ploadu<Packet>(data + i + 2 * kPacketSize));
+      acc3 = Op::ApplyPacket(acc3, ploadu<Packet>(data + i + 3 * kPacketSize));
+    }
+    acc0 = Op::ApplyPacket(Op::ApplyPacket(acc0, acc1),
+                           Op::ApplyPacket(acc2, acc3));
+    for (; i + kPacketSize <= n; i += kPacketSize) {
+      acc0 = Op::ApplyPacket(acc0, ploadu<Packet>(data + i));
+    }
+    result = Op::template Redux<Packet>(acc0);
+  } else {
+    result = data[0];
+    i = 1;
+  }
+  for (; i < n; ++i) {
+    result = Op::Apply(result, data[i]);
+  }
+  return result;
+}
+
+// Sets "out[c]" for c in [0, n) to the reduction of "in[r * stride + c]" for
+// r in [0, rows), where rows > 0. The rows are reduced four at a time, with
+// the columns vectorized.
+template <typename Op, typename T>
+void ReduceRows(const T* in, int64 rows, int64 stride, int64 n, T* out) {
+  typedef typename Eigen::internal::packet_traits<T>::type Packet;
+  const int64 kPacketSize = Eigen::internal::unpacket_traits<Packet>::size;
+  using Eigen::internal::ploadu;
+  using Eigen::internal::pstoreu;
+  const int64 vectors_end = n / kPacketSize * kPacketSize;
+  std::copy(in, in + n, out);
+  int64 r = 1;
+  for (; r + 4 <= rows; r += 4) {
+    const T* in0 = in + r * stride;
+    const T* in1 = in0 + stride;
+    const T* in2 = in1 + stride;
+    const T* in3 = in2 + stride;
+    for (int64 c = 0; c < vectors_end; c += kPacketSize) {
+      const Packet a = Op::ApplyPacket(ploadu<Packet>(in0 + c),
+                                       ploadu<Packet>(in1 + c));
+      const Packet b = Op::ApplyPacket(ploadu<Packet>(in2 + c),
+                                       ploadu<Packet>(in3 + c));
+      pstoreu(out + c, Op::ApplyPacket(ploadu<Packet>(out + c),
+                                       Op::ApplyPacket(a, b)));
+    }
+    for (int64 c = vectors_end; c < n; ++c) {
+      out[c] = Op::Apply(out[c], Op::Apply(Op::Apply(in0[c], in1[c]),
+                                           Op::Apply(in2[c], in3[c])));
+    }
+  }
+  for (; r < rows; ++r) {
+    const T* in0 = in + r * stride;
+    for (int64 c = 0; c < vectors_end; c += kPacketSize) {
+      pstoreu(out + c, Op::ApplyPacket(ploadu<Packet>(out + c),
+                                       ploadu<Packet>(in0 + c)));
+    }
+    for (int64 c = vectors_end; c < n; ++c) {
+      out[c] = Op::Apply(out[c], in0[c]);
+    }
+  }
+}
+
+// Reduces each of the "rows" rows of "cols" > 0 elements of "in" into
+// "out[r]", splitting the rows across the threads when there are fewer rows
+// than threads.
+template <typename Op, typename T>
+void InnerReduce(const DeviceBase::CpuWorkerThreads& workers, const T* in,
+                 int64 rows, int64 cols, T* out) {
+  const int64 chunks_per_row = std::max<int64>(
+      1, std::min<int64>(workers.num_threads / rows, cols / kMinRowChunk));
+  if (chunks_per_row == 1) {
+    Shard(workers.num_threads, workers.workers, rows, cols,
+          [in, cols, out](int64 start, int64 limit) {
+            for (int64 r = start; r < limit; ++r) {
+              out[r] = ReduceContiguous<Op>(in + r * cols, cols);
+            }
+          });
+    return;
+  }
+  const int64 chunk = (cols + chunks_per_row - 1) / chunks_per_row;
+  std::vector<T> partials(rows * chunks_per_row);
+  Shard(workers.num_threads, workers.workers, rows * chunks_per_row, chunk,
+        [in, cols, chunk, chunks_per_row, &partials](int64 start,
+                                                     int64 limit) {
+          for (int64 i = start; i < limit; ++i) {
+            const int64 begin = (i % chunks_per_row) * chunk;
+            const int64 end = std::min(cols, begin + chunk);
+            partials[i] = ReduceContiguous<Op>(
+                in + (i / chunks_per_row) * cols + begin, end - begin);
+          }
+        });
+  for (int64 r = 0; r < rows; ++r) {
+    out[r] = ReduceContiguous<Op>(&partials[r * chunks_per_row],
+                                  chunks_per_row);
+  }
+}
+
+// Reduces each of the "batch" row-major [rows, cols] matrices of "in", with
+// rows > 0, along its rows into "out[b, c]". The columns are reduced in
+// blocks, which are split across the threads along with the batch, and the
+// rows as well when there are fewer blocks than threads.
+template <typename Op, typename T>
+void MiddleReduce(const DeviceBase::CpuWorkerThreads& workers, const T* in,
+                  int64 batch, int64 rows, int64 cols, T* out) {
+  const int64 col_blocks = (cols + kColumnBlock - 1) / kColumnBlock;
+  const int64 block = (cols + col_blocks - 1) / col_blocks;
+  const int64 units = batch * col_blocks;
+  const int64 row_chunks = std::max<int64>(
+      1, std::min<int64>(workers.num_threads / units, rows / kMinRowsPerShard));
+  const int64 rows_per_chunk = (rows + row_chunks - 1) / row_chunks;
+  // The partial results of the chunks of rows, or "out" itself.
+  std::vector<T> partials(row_chunks > 1 ? row_chunks * batch * cols : 0);
+  T* dest = row_chunks > 1 ? partials.data() : out;
+  Shard(workers.num_threads, workers.workers, units * row_chunks,
+        rows_per_chunk * block,
+        [=](int64 start, int64 limit) {
+          for (int64 i = start; i < limit; ++i) {
+            const int64 chunk = i / units;
+            const int64 b = (i % units) / col_blocks;
+            const int64 begin = (i % col_blocks) * block;
+            const int64 end = std::min(cols, begin + block);
+            const int64 first_row = chunk * rows_per_chunk;
+            const int64 num_rows =
+                std::min(rows, first_row + rows_per_chunk) - first_row;
+            ReduceRows<Op>(in + (b * rows + first_row) * cols + begin,
+                           num_rows, cols, end - begin,
+                           dest + (chunk * batch + b) * cols + begin);
+          }
+        });
+  if (row_chunks > 1) {
+    ReduceRows<Op>(partials.data(), row_chunks, batch * cols, batch * cols,
+                   out);
+  }
+}
+
+template <typename Reducer, typename T>
+bool Reduce(std::false_type, const DeviceBase::CpuWorkerThreads& workers,
+            CpuReduceShape shape, const T* in, int64 d0, int64 d1, int64 d2,
+            T* out) {
+  return false;
+}
+
+template <typename Reducer, typename T>
+bool Reduce(std::true_type, const DeviceBase::CpuWorkerThreads& workers,
+            CpuReduceShape shape, const T* in, int64 d0, int64 d1, int64 d2,
+            T* out) {
+  typedef typename Reduction<Reducer>::Op Op;
+  int64 outputs;
+  switch (shape) {
+    case CpuReduceShape::kInner:
+      InnerReduce<Op>(workers, in, d0 * d1, d2, out);
+      outputs = d0 * d1;
+      break;
+    case CpuReduceShape::kMiddle:
+      MiddleReduce<Op>(workers, in, d0, d1, d2, out);
+      outputs = d0 * d2;
+      break;
+    case CpuReduceShape::kOuterInner: {
+      std::vector<T> inner(d0 * d1);
+      InnerReduce<Op>(workers, in, d0 * d1, d2, inner.data());
+      MiddleReduce<Op>(workers, inner.data(), 1, d0, d1, out);
+      outputs = d1;
+      break;
+    }
+  }
+  if (Reduction<Reducer>::kMean) {
+    const T count = static_cast<T>(d0 * d1 * d2 / outputs);
+    for (int64 i = 0; i < outputs; ++i) {
+      out[i] /= count;
+    }
+  }
+  return true;
+}
+
+}  // namespace cpu_reduction
+
+// Reduces the row-major ["d0", "d1", "d2"] "in", which is not empty, by
+// "Reducer" over the dimensions of "shape" into "out" on the threads of
+// "workers". Returns false, without doing anything, if there are no kernels
+// for Reducer and T, which are implemented for the sum, mean, product,
+// maximum and minimum of float and double.
+//
+// The results may differ from those of the Eigen reductions by rounding, as
+// the elements are reduced in a different order.
+template <typename Reducer, typename T>
+bool CpuReduce(const DeviceBase::CpuWorkerThreads& workers,
+               CpuReduceShape shape, const T* in, int64 d0, int64 d1,
+               int64 d2, T* out) {
+  typedef cpu_reduction::Reduction<Reducer> Reduction;
+  return cpu_reduction::Reduce<Reducer>(
+      std::integral_constant<bool, Reduction::kSupported>(), workers, shape,
+      in, d0, d1, d2, out);
+}
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_CPU_REDUCTION_H_
@@ -0,0 +1,295 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#ifndef TENSORFLOW_KERNELS_CPU_XENT_H_
+#define TENSORFLOW_KERNELS_CPU_XENT_H_
+
+// Fused CPU kernels for SoftmaxCrossEntropyWithLogits and
+// SparseSoftmaxCrossEntropyWithLogits, which read each row of the logits
+// twice: once to compute the maximum, the sum of the exponentials and the
+// loss with an online softmax, and once to write the backprop.
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace functor {
+namespace cpu_xent {
+
+template <typename T>
+struct IsSupportedType {
+  static const bool value =
+      std::is_same<T, float>::value || std::is_same<T, double>::value;
+};
+
+// The logits of a row that the first pass reduces at once: their maximum
+// first, and then the sums relative to the running maximum, while they are
+// in the L1 cache.
+const int64 kChunkSize = 1024;
+
+template <typename T>
+struct Vectorized {
+  static const bool value =
+      Eigen::internal::packet_traits<T>::Vectorizable &&
+      Eigen::internal::packet_traits<T>::HasExp &&
+      Eigen::internal::packet_traits<T>::HasMax;
+};
+
+// The operations on the logits "x" of a chunk of "n" elements, vectorized
+// over the packets of T and finished with scalars.
+template <typename T, bool vectorized = Vectorized<T>::value>
+struct ChunkOps {
+  typedef typename Eigen::internal::packet_traits<T>::type Packet;
+  static const int64 kPacketSize =
+      Eigen::internal::unpacket_traits<Packet>::size;
+
+  // Returns the maximum of the "n" > 0 elements of "x".
+  static T Max(const T* x, int64 n) {
+    using Eigen::internal::ploadu;
+    using Eigen::internal::pmax;
+    int64 i = 0;
+    T result = x[0];
+    if (n >= kPacketSize) {
+      Packet acc = ploadu<Packet>(x);
+      for (i = kPacketSize; i + kPacketSize <= n; i += kPacketSize) {
+        acc = pmax(acc, ploadu<Packet>(x + i));
+      }
+      result = Eigen::internal::predux_max(acc);
+    }
+    for (; i < n; ++i) result = std::max(result, x[i]);
+    return result;
+  }
+
+  // Returns the sum of exp(x - max).
+  static T SumExp(const T* x, int64 n, T max) {
+    using Eigen::internal::padd;
+    using Eigen::internal::pexp;
+    using Eigen::internal::ploadu;
+    using Eigen::internal::psub;
+    const Packet max_packet = Eigen::internal::pset1<Packet>(max);
+    Packet acc = Eigen::internal::pset1<Packet>(T(0));
+    int64 i = 0;
+    for (; i + kPacketSize <= n; i += kPacketSize) {
+      acc = padd(acc, pexp(psub(ploadu<Packet>(x + i), max_packet)));
+    }
+    T result = Eigen::internal::predux(acc);
+    for (; i < n; ++i) result += Eigen::numext::exp(x[i] - max);
+    return result;
+  }
+
+  // Adds the sum of "labels" to "label_sum", and the sum of
+  // labels * (x - max) to "dot".
+  static void LabelSums(const T* x, const T* labels, int64 n, T max,
+                        T* label_sum, T* dot) {
+    using Eigen::internal::padd;
+    using Eigen::internal::ploadu;
+    const Packet max_packet = Eigen::internal::pset1<Packet>(max);
+    Packet sum_acc = Eigen::internal::pset1<Packet>(T(0));
+    Packet dot_acc = Eigen::internal::pset1<Packet>(T(0));
+    int64 i = 0;
+    for (; i + kPacketSize <= n; i += kPacketSize) {
+      const Packet l = ploadu<Packet>(labels + i);
+      sum_acc = padd(sum_acc, l);
+      dot_acc = padd(dot_acc,
+                     Eigen::internal::pmul(
+                         l, Eigen::internal::psub(ploadu<Packet>(x + i),
+                                                  max_packet)));
+    }
+    T s = Eigen::internal::predux(sum_acc);
+    T d = Eigen::internal::predux(dot_acc);
+    for (; i < n; ++i) {
+      s += labels[i];
+      d += labels[i] * (x[i] - max);
+    }
+    *label_sum += s;
+    *dot += d;
+  }
+
+  // Sets "out" to exp(x - max) * scale, minus "labels" if it is not null.
+  // "out" may be "x".
+  static void ScaledExp(const T* x, const T* labels, int64 n, T max, T scale,
+                        T* out) {
+    using Eigen::internal::pexp;
+    using Eigen::internal::ploadu;
+    using Eigen::internal::pmul;
+    using Eigen::internal::pstoreu;
+    using Eigen::internal::psub;
+    const Packet max_packet = Eigen::internal::pset1<Packet>(max);
+    const Packet scale_packet = Eigen::internal::pset1<Packet>(scale);
+    int64 i = 0;
+    for (; i + kPacketSize <= n; i += kPacketSize) {
+      Packet p =
+          pmul(pexp(psub(ploadu<Packet>(x + i), max_packet)), scale_packet);
+      if (labels != nullptr) p = psub(p, ploadu<Packet>(labels + i));
+      pstoreu(out + i, p);
+    }
+    for (; i < n; ++i) {
+      out[i] = Eigen::numext::exp(x[i] - max) * scale -
+               (labels != nullptr ? labels[i] : T(0));
+    }
+  }
+};
+
+template <typename T>
+struct ChunkOps<T, false> {
+  static T Max(const T* x, int64 n) { return *std::max_element(x, x + n); }
+
+  static T SumExp(const T* x, int64 n, T max) {
+    T result = T(0);
+    for (int64 i = 0; i < n; ++i) result += Eigen::numext::exp(x[i] - max);
+    return result;
+  }
+
+  static void LabelSums(const T* x, const T* labels, int64 n, T max,
+                        T* label_sum, T* dot) {
+    for (int64 i = 0; i < n; ++i) {
+      *label_sum += labels[i];
+      *dot += labels[i] * (x[i] - max);
+    }
+  }
+
+  static void ScaledExp(const T* x, const T* labels, int64 n, T max, T scale,
+                        T* out) {
+    for (int64 i = 0; i < n; ++i) {
+      out[i] = Eigen::numext::exp(x[i] - max) * scale -
+               (labels != nullptr ? labels[i] : T(0));
+    }
+  }
+};
+
+// The result of the first pass over a row of logits.
+template <typename T>
+struct RowStats {
+  T max;      // The maximum of the logits.
+  T sum_exp;  // The sum of exp(logits - max).
+  T loss;     // The loss of the dense labels, if any.
+};
+
+// Computes the statistics of the "n" > 0 "logits" of a row in one pass, with
+// the loss of the dense "labels" of the row if they are not null. When the
+// maximum increases from m to m', the sum of the exponentials is scaled by
+// exp(m - m') and the sum of labels * (logits - max) is shifted by
+// (m - m') * sum(labels), so that the loss
+//
+//   sum(labels * (log(sum_exp) - (logits - max)))
+//
+// keeps the precision of the logits relative to the maximum.
+template <typename T>
+RowStats<T> FirstPass(const T* logits, const T* labels, int64 n) {
+  typedef ChunkOps<T> Ops;
+  T max = -std::numeric_limits<T>::infinity();
+  T sum_exp = T(0);
+  T label_sum = T(0);
+  T dot = T(0);
+  for (int64 begin = 0; begin < n; begin += kChunkSize) {
+    const int64 size = std::min(kChunkSize, n - begin);
+    const T* x = logits + begin;
+    const T chunk_max = Ops::Max(x, size);
+    if (chunk_max > max) {
+      sum_exp *= Eigen::numext::exp(max - chunk_max);
+      if (label_sum != T(0)) dot += (max - chunk_max) * label_sum;
+      max = chunk_max;
+    }
+    sum_exp += Ops::SumExp(x, size, max);
+    if (labels != nullptr) {
+      Ops::LabelSums(x, labels + begin, size, max, &label_sum, &dot);
+    }
+  }
+  RowStats<T> stats;
+  stats.max = max;
+  stats.sum_exp = sum_exp;
+  stats.loss = label_sum * Eigen::numext::log(sum_exp) - dot;
+  return stats;
+}
+
+// The cost of a row of "n" logits, for sharding the rows.
+template <typename T>
+Eigen::TensorOpCost RowCost(int64 n, bool dense_labels) {
+  const double loaded = (dense_labels ? 3 : 2) * n * sizeof(T);
+  const double stored = n * sizeof(T);
+  // Two exponentials per logit, at about 20 cycles each.
+  return Eigen::TensorOpCost(loaded, stored, 40 * n);
+}
+
+// Computes the loss and the backprop of SoftmaxCrossEntropyWithLogits.
+// "backprop" may alias "logits".
+template <typename T>
+void Xent(const Eigen::ThreadPoolDevice& d,
+          typename TTypes<T>::ConstMatrix logits,
+          typename TTypes<T>::ConstMatrix labels, typename TTypes<T>::Vec loss,
+          typename TTypes<T>::Matrix backprop) {
+  const int64 num_rows = logits.dimension(0);
+  const int64 num_classes = logits.dimension(1);
+  if (num_classes == 0) {
+    for (int64 r = 0; r < num_rows; ++r) loss(r) = T(0);
+    return;
+  }
+  auto work = [&](int64 begin, int64 end) {
+    for (int64 r = begin; r < end; ++r) {
+      const T* x = logits.data() + r * num_classes;
+      const T* l = labels.data() + r * num_classes;
+      const RowStats<T> stats = FirstPass(x, l, num_classes);
+      loss(r) = stats.loss;
+      ChunkOps<T>::ScaledExp(x, l, num_classes, stats.max,
+                             T(1) / stats.sum_exp,
+                             backprop.data() + r * num_classes);
+    }
+  };
+  d.parallelFor(num_rows, RowCost<T>(num_classes, true), work);
+}
+
+// Computes the loss and the backprop of SparseSoftmaxCrossEntropyWithLogits,
+// where the labels are in [0, num_classes), or the loss and the backprop of
+// the row are NaN. "backprop" may alias "logits".
+template <typename T, typename Index>
+void SparseXent(const Eigen::ThreadPoolDevice& d,
+                typename TTypes<T>::ConstMatrix logits,
+                typename TTypes<Index>::ConstVec labels,
+                typename TTypes<T>::Vec loss,
+                typename TTypes<T>::Matrix backprop) {
+  const int64 num_rows = logits.dimension(0);
+  const int64 num_classes = logits.dimension(1);
+  auto work = [&](int64 begin, int64 end) {
+    for (int64 r = begin; r < end; ++r) {
+      const T* x = logits.data() + r * num_classes;
+      T* out = backprop.data() + r * num_classes;
+      const Index label = labels(r);
+      if (label < 0 || label >= num_classes) {
+        loss(r) = Eigen::NumTraits<T>::quiet_NaN();
+        std::fill(out, out + num_classes, Eigen::NumTraits<T>::quiet_NaN());
+        continue;
+      }
+      const RowStats<T> stats = FirstPass<T>(x, nullptr, num_classes);
+      // Reads the logit of the label before the backprop may overwrite it.
+      loss(r) = Eigen::numext::log(stats.sum_exp) - (x[label] - stats.max);
+      ChunkOps<T>::ScaledExp(x, nullptr, num_classes, stats.max,
+                             T(1) / stats.sum_exp, out);
+      out[label] -= T(1);
+    }
+  };
+  d.parallelFor(num_rows, RowCost<T>(num_classes, false), work);
+}
+
+}  // namespace cpu_xent
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_CPU_XENT_H_
@@ -19,8 +19,10 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/crop_and_resize_op.h"
 
+#include <algorithm>
 #include <functional>
 #include <string>
+#include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/register_types.h"
@@ -196,6 +198,18 @@ class CropAndResizeOp : public AsyncOpKernel {
   float extrapolation_value_;
 };
 
+namespace {
+
+// The pixels of the image that a column of a crop interpolates between, as
+// offsets in the rows of the image, and the weight of the right one.
+struct CachedInterpolation {
+  int64 lower;
+  int64 upper;
+  float lerp;
+};
+
+}  // namespace
+
 // Partial specialization of CropAndResize functor for a CPUDevice.
 namespace functor {
 template <typename T>
@@ -217,6 +231,10 @@ struct CropAndResize<CPUDevice, T> {
 
     // Sharding across boxes.
     auto CropAndResizePerBox = [&](int start_box, int limit_box) {
+      // The columns of the image that each column of a crop interpolates
+      // between, which are the same for all of its rows. The columns of the
+      // crop outside of the image have a negative lower index.
+      std::vector<CachedInterpolation> xs(crop_width);
       for (int b = start_box; b < limit_box; ++b) {
         const float y1 = boxes(b, 0);
         const float x1 = boxes(b, 1);
@@ -236,49 +254,59 @@ struct CropAndResize<CPUDevice, T> {
             (crop_width > 1) ? (x2 - x1) * (image_width - 1) / (crop_width - 1)
                              : 0;
 
+        for (int x = 0; x < crop_width; ++x) {
+          const float in_x = (crop_width > 1)
+                                 ? x1 * (image_width - 1) + x * width_scale
+                                 : 0.5 * (x1 + x2) * (image_width - 1);
+          if (in_x < 0 || in_x > image_width - 1) {
+            xs[x].lower = -1;
+            continue;
+          }
+          const int left_x_index = floorf(in_x);
+          const int right_x_index = ceilf(in_x);
+          xs[x].lower = left_x_index * depth;
+          xs[x].upper = right_x_index * depth;
+          xs[x].lerp = in_x - left_x_index;
+        }
+
         for (int y = 0; y < crop_height; ++y) {
+          float* crops_row = &crops(b, y, 0, 0);
           const float in_y = (crop_height > 1)
                                  ? y1 * (image_height - 1) + y * height_scale
                                  : 0.5 * (y1 + y2) * (image_height - 1);
           if (in_y < 0 || in_y > image_height - 1) {
-            for (int x = 0; x < crop_width; ++x) {
-              for (int d = 0; d < depth; ++d) {
-                crops(b, y, x, d) = extrapolation_value;
-              }
-            }
+            std::fill(crops_row, crops_row + crop_width * depth,
+                      extrapolation_value);
             continue;
           }
           const int top_y_index = floorf(in_y);
           const int bottom_y_index = ceilf(in_y);
           const float y_lerp = in_y - top_y_index;
+          const T* top_row = &image(b_in, top_y_index, 0, 0);
+          const T* bottom_row = &image(b_in, bottom_y_index, 0, 0);
 
           for (int x = 0; x < crop_width; ++x) {
-            const float in_x = (crop_width > 1)
-                                   ? x1 * (image_width - 1) + x * width_scale
-                                   : 0.5 * (x1 + x2) * (image_width - 1);
-            if (in_x < 0 || in_x > image_width - 1) {
-              for (int d = 0; d < depth; ++d) {
-                crops(b, y, x, d) = extrapolation_value;
-              }
+            float* crops_pixel = crops_row + x * depth;
+            if (xs[x].lower < 0) {
+              std::fill(crops_pixel, crops_pixel + depth, extrapolation_value);
               continue;
             }
-            const int left_x_index = floorf(in_x);
-            const int right_x_index = ceilf(in_x);
-            const float x_lerp = in_x - left_x_index;
-
+            const T* top_left_pixel = top_row + xs[x].lower;
+            const T* top_right_pixel = top_row + xs[x].upper;
+            const T* bottom_left_pixel = bottom_row + xs[x].lower;
+            const T* bottom_right_pixel = bottom_row + xs[x].upper;
+            const float x_lerp = xs[x].lerp;
+            // The channels are contiguous, so that this loop is vectorized.
             for (int d = 0; d < depth; ++d) {
-              const float top_left(static_cast<float>(
-                  image(b_in, top_y_index, left_x_index, d)));
-              const float top_right(static_cast<float>(
-                  image(b_in, top_y_index, right_x_index, d)));
-              const float bottom_left(static_cast<float>(
-                  image(b_in, bottom_y_index, left_x_index, d)));
-              const float bottom_right(static_cast<float>(
-                  image(b_in, bottom_y_index, right_x_index, d)));
+              const float top_left(static_cast<float>(top_left_pixel[d]));
+              const float top_right(static_cast<float>(top_right_pixel[d]));
+              const float bottom_left(static_cast<float>(bottom_left_pixel[d]));
+              const float bottom_right(
+                  static_cast<float>(bottom_right_pixel[d]));
               const float top = top_left + (top_right - top_left) * x_lerp;
               const float bottom =
                   bottom_left + (bottom_right - bottom_left) * x_lerp;
-              crops(b, y, x, d) = top + (bottom - top) * y_lerp;
+              crops_pixel[d] = top + (bottom - top) * y_lerp;
             }
           }
         }
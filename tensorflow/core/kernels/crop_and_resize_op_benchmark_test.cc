@@ -0,0 +1,78 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+
+static Graph* BM_CropAndResize(int batches, int width, int height, int depth,
+                               int num_boxes, int crop_size) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor image(DT_FLOAT, TensorShape({batches, height, width, depth}));
+  image.flat<float>().setRandom();
+
+  // Boxes of random corners, some of which are outside of the image.
+  Tensor boxes(DT_FLOAT, TensorShape({num_boxes, 4}));
+  boxes.flat<float>().setRandom();
+  auto boxes_matrix = boxes.matrix<float>();
+  for (int b = 0; b < num_boxes; ++b) {
+    boxes_matrix(b, 2) += 0.2f;
+    boxes_matrix(b, 3) += 0.2f;
+  }
+
+  Tensor box_ind(DT_INT32, TensorShape({num_boxes}));
+  auto box_ind_flat = box_ind.flat<int32>();
+  for (int b = 0; b < num_boxes; ++b) {
+    box_ind_flat(b) = b % batches;
+  }
+
+  Tensor crop_size_tensor(DT_INT32, TensorShape({2}));
+  auto crop_size_flat = crop_size_tensor.flat<int32>();
+  crop_size_flat(0) = crop_size;
+  crop_size_flat(1) = crop_size;
+
+  Node* ret;
+  Status s = NodeBuilder(g->NewName("n"), "CropAndResize")
+                 .Input(test::graph::Constant(g, image))
+                 .Input(test::graph::Constant(g, boxes))
+                 .Input(test::graph::Constant(g, box_ind))
+                 .Input(test::graph::Constant(g, crop_size_tensor))
+                 .Finalize(g, &ret);
+  assert(s.ok());
+  return g;
+}
+
+#define BM_CropAndResizeDev(DEVICE, B, W, H, D, N, C)                        \
+  static void BM_CropAndResize_##DEVICE##_##B##_##W##_##H##_##D##_##N##_##C( \
+      int iters) {                                                           \
+    testing::ItemsProcessed(iters* N* C* C* D);                              \
+    test::Benchmark(#DEVICE, BM_CropAndResize(B, W, H, D, N, C)).Run(iters); \
+  }                                                                          \
+  BENCHMARK(BM_CropAndResize_##DEVICE##_##B##_##W##_##H##_##D##_##N##_##C)
+
+// Crops of an image, as in the second stage of a detection model.
+BM_CropAndResizeDev(cpu, 1, 640, 640, 3, 300, 14);
+BM_CropAndResizeDev(gpu, 1, 640, 640, 3, 300, 14);
+
+// Crops of a feature map of many channels.
+BM_CropAndResizeDev(cpu, 1, 64, 64, 256, 300, 7);
+BM_CropAndResizeDev(gpu, 1, 64, 64, 256, 300, 7);
+
+}  // namespace tensorflow
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
+#include "tensorflow/core/kernels/dataset_stats.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/tracing.h"
@@ -245,6 +246,9 @@ class IteratorContext {
 
     // Function call support.
     std::function<void(std::function<void()>)> runner = nullptr;
+
+    // If set, the iterators record their statistics here.
+    std::shared_ptr<dataset::StatsCollector> stats_collector;
   };
 
   explicit IteratorContext(Params params) : params_(std::move(params)) {}
@@ -259,6 +263,10 @@ class IteratorContext {
 
   ResourceMgr* resource_manager() const { return params_.resource_manager; }
 
+  dataset::StatsCollector* stats_collector() const {
+    return params_.stats_collector.get();
+  }
+
  private:
   Params params_;
 };
@@ -488,7 +496,22 @@ class DatasetIterator : public IteratorBase {
       *end_of_sequence = true;
       return Status::OK();
     }
-    return GetNextInternal(ctx, out_tensors, end_of_sequence);
+    dataset::StatsCollector* const stats = ctx->stats_collector();
+    if (stats == nullptr || !stats->enabled()) {
+      return GetNextInternal(ctx, out_tensors, end_of_sequence);
+    }
+    dataset::ScopedGetNextTimer timer;
+    Status s = GetNextInternal(ctx, out_tensors, end_of_sequence);
+    const bool produced = s.ok() && !*end_of_sequence;
+    int64 bytes = 0;
+    if (produced) {
+      for (const Tensor& t : *out_tensors) {
+        bytes += t.TotalBytes();
+      }
+    }
+    stats->RecordGetNext(params_.prefix, timer.SelfTimeMicros(), produced,
+                         bytes);
+    return s;
   }
 
   Status Save(IteratorStateWriter* writer) final {
@@ -0,0 +1,123 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/dataset_autotune.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+namespace dataset {
+
+constexpr int64 AutoTuner::kWindowSize;
+
+/* static */
+AutoTuneBudget* AutoTuneBudget::Global() {
+  static AutoTuneBudget* global = [] {
+    int64 cpu;
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_DATA_AUTOTUNE_CPU_BUDGET",
+                                    port::NumSchedulableCPUs(), &cpu));
+    int64 ram_mb;
+    TF_CHECK_OK(
+        ReadInt64FromEnvVar("TF_DATA_AUTOTUNE_RAM_BUDGET_MB", 1024, &ram_mb));
+    return new AutoTuneBudget(cpu, ram_mb << 20);
+  }();
+  return global;
+}
+
+AutoTuneBudget::AutoTuneBudget(int64 cpu, int64 ram_bytes)
+    : cpu_available_(cpu), ram_available_(ram_bytes) {}
+
+bool AutoTuneBudget::TryAcquire(int64 cpu, int64 ram_bytes) {
+  mutex_lock l(mu_);
+  if (cpu > cpu_available_ || ram_bytes > ram_available_) {
+    return false;
+  }
+  cpu_available_ -= cpu;
+  ram_available_ -= ram_bytes;
+  return true;
+}
+
+void AutoTuneBudget::Release(int64 cpu, int64 ram_bytes) {
+  mutex_lock l(mu_);
+  cpu_available_ += cpu;
+  ram_available_ += ram_bytes;
+}
+
+AutoTuner::AutoTuner(Resource resource, int64 max_value,
+                     AutoTuneBudget* budget)
+    : resource_(resource),
+      max_value_(std::max<int64>(1, max_value)),
+      budget_(budget != nullptr ? budget : AutoTuneBudget::Global()) {}
+
+AutoTuner::~AutoTuner() { budget_->Release(cpu_acquired_, ram_acquired_); }
+
+bool AutoTuner::RecordConsumer(bool waited, int64 element_bytes) {
+  ++window_requests_;
+  if (waited) ++window_consumer_waits_;
+  window_bytes_ += element_bytes;
+  if (window_requests_ < kWindowSize) {
+    return false;
+  }
+  const bool grew = MaybeGrow();
+  window_requests_ = 0;
+  window_consumer_waits_ = 0;
+  window_producer_waits_ = 0;
+  window_bytes_ = 0;
+  return grew;
+}
+
+bool AutoTuner::MaybeGrow() {
+  if (window_consumer_waits_ == 0 || value_ >= max_value_) {
+    return false;
+  }
+  if (resource_ == Resource::kRam && window_producer_waits_ == 0) {
+    return false;
+  }
+
+  // Try to double the value, and fall back to the largest increment that
+  // still fits in the budget.
+  int64 delta = std::min(value_, max_value_ - value_);
+  for (; delta > 0; delta /= 2) {
+    int64 cpu = 0;
+    int64 ram_bytes = 0;
+    if (resource_ == Resource::kCpu) {
+      cpu = delta;
+    } else {
+      ram_bytes = delta * (window_bytes_ / window_requests_);
+    }
+    if (budget_->TryAcquire(cpu, ram_bytes)) {
+      cpu_acquired_ += cpu;
+      ram_acquired_ += ram_bytes;
+      break;
+    }
+  }
+  if (delta == 0) {
+    return false;
+  }
+  value_ += delta;
+  VLOG(1) << "Autotuned " << (resource_ == Resource::kCpu ? "parallelism"
+                                                           : "buffer size")
+          << " to " << value_ << " after " << window_consumer_waits_ << " of "
+          << window_requests_ << " consumer requests waited.";
+  return true;
+}
+
+}  // namespace dataset
+
+}  // namespace tensorflow
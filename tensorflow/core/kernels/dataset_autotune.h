@@ -0,0 +1,124 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DATASET_AUTOTUNE_H_
+#define THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DATASET_AUTOTUNE_H_
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+namespace dataset {
+
+// Passing this value as the `num_parallel_calls` of a "ParallelMapDataset"
+// or the `buffer_size` of a "PrefetchDataset" asks each iterator over that
+// dataset to choose the value itself, using an `AutoTuner`.
+constexpr int64 kAutoTune = -1;
+
+// Process-wide budget shared by all autotuned iterators. The CPU budget is
+// counted in concurrent function invocations and defaults to the number of
+// schedulable CPUs; the RAM budget is counted in bytes of buffered elements.
+// Both can be overridden with the TF_DATA_AUTOTUNE_CPU_BUDGET and
+// TF_DATA_AUTOTUNE_RAM_BUDGET_MB environment variables.
+class AutoTuneBudget {
+ public:
+  static AutoTuneBudget* Global();
+
+  AutoTuneBudget(int64 cpu, int64 ram_bytes);
+
+  // Takes `cpu` and `ram_bytes` from the budget if both are available, and
+  // returns true. Otherwise leaves the budget unchanged and returns false.
+  bool TryAcquire(int64 cpu, int64 ram_bytes);
+
+  // Returns resources previously taken by `TryAcquire()`.
+  void Release(int64 cpu, int64 ram_bytes);
+
+ private:
+  mutex mu_;
+  int64 cpu_available_ GUARDED_BY(mu_);
+  int64 ram_available_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AutoTuneBudget);
+};
+
+// Tunes the parallelism or buffer size of a single iterator.
+//
+// The iterator reports every request from its consumer, noting whether the
+// consumer had to wait for the element, and every time its producer blocked
+// because `value()` elements were already outstanding. At the end of each
+// window of requests, if the consumer was starved the tuner doubles `value()`,
+// provided that the extra units fit in the budget. A buffer is only grown when
+// the producer was also blocked, because a larger buffer cannot help a
+// producer that is simply slower than its consumer.
+//
+// The tuner is not thread-safe: callers serialize access with the lock that
+// guards the iterator's state.
+class AutoTuner {
+ public:
+  enum class Resource {
+    // Each unit of `value()` is a concurrent invocation, which costs one CPU.
+    kCpu,
+    // Each unit of `value()` is a buffered element, which costs the average
+    // element size in RAM.
+    kRam,
+  };
+
+  // Creates a tuner whose value starts at 1 and never exceeds `max_value`.
+  // A null `budget` means `AutoTuneBudget::Global()`.
+  AutoTuner(Resource resource, int64 max_value,
+            AutoTuneBudget* budget = nullptr);
+
+  // Returns all resources acquired by this tuner to the budget.
+  ~AutoTuner();
+
+  int64 value() const { return value_; }
+
+  // Records one request by the consumer. `waited` is true if the requested
+  // element was not ready, and `element_bytes` is the size of the element
+  // that was returned. Returns true if `value()` has grown.
+  bool RecordConsumer(bool waited, int64 element_bytes);
+
+  // Records that the producer blocked because the buffer was full.
+  void RecordProducerWait() { ++window_producer_waits_; }
+
+ private:
+  // Number of consumer requests over which rates are measured.
+  static constexpr int64 kWindowSize = 16;
+
+  bool MaybeGrow();
+
+  const Resource resource_;
+  const int64 max_value_;
+  AutoTuneBudget* const budget_;
+
+  int64 value_ = 1;
+  int64 cpu_acquired_ = 0;
+  int64 ram_acquired_ = 0;
+
+  int64 window_requests_ = 0;
+  int64 window_consumer_waits_ = 0;
+  int64 window_producer_waits_ = 0;
+  int64 window_bytes_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AutoTuner);
+};
+
+}  // namespace dataset
+
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DATASET_AUTOTUNE_H_
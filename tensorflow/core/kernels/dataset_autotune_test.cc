@@ -0,0 +1,90 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/dataset_autotune.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace dataset {
+namespace {
+
+// Feeds one window of consumer requests to `tuner`, `waits` of which waited.
+bool RecordWindow(AutoTuner* tuner, int waits, int64 element_bytes) {
+  bool grew = false;
+  for (int i = 0; i < 16; ++i) {
+    grew = tuner->RecordConsumer(i < waits, element_bytes);
+  }
+  return grew;
+}
+
+TEST(AutoTunerTest, GrowsParallelismWhileStarved) {
+  AutoTuneBudget budget(8, 0);
+  AutoTuner tuner(AutoTuner::Resource::kCpu, 6, &budget);
+  EXPECT_EQ(1, tuner.value());
+
+  EXPECT_FALSE(RecordWindow(&tuner, 0, 0));
+  EXPECT_EQ(1, tuner.value());
+
+  EXPECT_TRUE(RecordWindow(&tuner, 4, 0));
+  EXPECT_EQ(2, tuner.value());
+  EXPECT_TRUE(RecordWindow(&tuner, 1, 0));
+  EXPECT_EQ(4, tuner.value());
+
+  // The value is capped at `max_value`.
+  EXPECT_TRUE(RecordWindow(&tuner, 1, 0));
+  EXPECT_EQ(6, tuner.value());
+  EXPECT_FALSE(RecordWindow(&tuner, 16, 0));
+  EXPECT_EQ(6, tuner.value());
+}
+
+TEST(AutoTunerTest, SharesCpuBudget) {
+  AutoTuneBudget budget(3, 0);
+  {
+    AutoTuner first(AutoTuner::Resource::kCpu, 16, &budget);
+    AutoTuner second(AutoTuner::Resource::kCpu, 16, &budget);
+    EXPECT_TRUE(RecordWindow(&first, 1, 0));
+    EXPECT_TRUE(RecordWindow(&first, 1, 0));
+    EXPECT_EQ(4, first.value());
+    EXPECT_FALSE(RecordWindow(&second, 1, 0));
+    EXPECT_EQ(1, second.value());
+  }
+  // Destroying the tuners returns their share of the budget.
+  EXPECT_TRUE(budget.TryAcquire(3, 0));
+}
+
+TEST(AutoTunerTest, GrowsBufferOnlyWhenProducerBlocks) {
+  AutoTuneBudget budget(0, 1000);
+  AutoTuner tuner(AutoTuner::Resource::kRam, 100, &budget);
+
+  // The producer never filled the buffer, so a larger one would not help.
+  EXPECT_FALSE(RecordWindow(&tuner, 8, 100));
+  EXPECT_EQ(1, tuner.value());
+
+  tuner.RecordProducerWait();
+  EXPECT_TRUE(RecordWindow(&tuner, 8, 100));
+  EXPECT_EQ(2, tuner.value());
+
+  // Each extra slot costs 100 bytes, so at most 10 slots fit.
+  for (int i = 0; i < 8; ++i) {
+    tuner.RecordProducerWait();
+    RecordWindow(&tuner, 8, 100);
+  }
+  EXPECT_EQ(11, tuner.value());
+  EXPECT_FALSE(budget.TryAcquire(0, 1));
+}
+
+}  // namespace
+}  // namespace dataset
+}  // namespace tensorflow
@@ -0,0 +1,95 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/dataset_stats.h"
+
+#include "tensorflow/core/framework/summary.pb.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+
+namespace dataset {
+
+namespace {
+
+// The innermost timer on this thread.
+thread_local ScopedGetNextTimer* current_timer = nullptr;
+
+void AddValue(const string& prefix, const char* name, double value,
+              Summary* summary) {
+  Summary::Value* summary_value = summary->add_value();
+  summary_value->set_tag(strings::StrCat(prefix, "/", name));
+  summary_value->set_simple_value(static_cast<float>(value));
+}
+
+}  // namespace
+
+void StatsCollector::RecordGetNext(const string& prefix, int64 self_time_us,
+                                   bool produced, int64 bytes) {
+  mutex_lock l(mu_);
+  IteratorStats& stats = stats_[prefix];
+  stats.self_time_us += self_time_us;
+  if (produced) {
+    ++stats.elements;
+    stats.bytes += bytes;
+  }
+}
+
+void StatsCollector::RecordBufferOccupancy(const string& prefix, int64 size,
+                                           int64 capacity) {
+  mutex_lock l(mu_);
+  IteratorStats& stats = stats_[prefix];
+  ++stats.occupancy_samples;
+  stats.occupancy_total += size;
+  stats.capacity = capacity;
+}
+
+void StatsCollector::AddToSummary(Summary* summary) {
+  mutex_lock l(mu_);
+  for (const auto& entry : stats_) {
+    const string& prefix = entry.first;
+    const IteratorStats& stats = entry.second;
+    AddValue(prefix, "elements", stats.elements, summary);
+    AddValue(prefix, "bytes", stats.bytes, summary);
+    AddValue(prefix, "self_time_us", stats.self_time_us, summary);
+    if (stats.occupancy_samples > 0) {
+      AddValue(prefix, "buffer_occupancy",
+               static_cast<double>(stats.occupancy_total) /
+                   stats.occupancy_samples,
+               summary);
+      AddValue(prefix, "buffer_capacity", stats.capacity, summary);
+    }
+  }
+}
+
+ScopedGetNextTimer::ScopedGetNextTimer()
+    : start_us_(Env::Default()->NowMicros()), parent_(current_timer) {
+  current_timer = this;
+}
+
+ScopedGetNextTimer::~ScopedGetNextTimer() {
+  if (parent_ != nullptr) {
+    parent_->nested_us_ += Env::Default()->NowMicros() - start_us_;
+  }
+  current_timer = parent_;
+}
+
+int64 ScopedGetNextTimer::SelfTimeMicros() const {
+  return Env::Default()->NowMicros() - start_us_ - nested_us_;
+}
+
+}  // namespace dataset
+
+}  // namespace tensorflow
@@ -0,0 +1,114 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DATASET_STATS_H_
+#define THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DATASET_STATS_H_
+
+#include <atomic>
+#include <map>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+class Summary;
+
+namespace dataset {
+
+// Accumulates per-stage statistics for the iterators of one input pipeline.
+//
+// Each iterator is identified by its prefix (e.g. "Iterator::Prefetch::Map"),
+// and the statistics are cumulative from the time that `Enable()` was called.
+// Until then, the iterators skip the measurements, so that a pipeline that
+// nobody inspects pays only for checking `enabled()`. This class is
+// thread-safe.
+class StatsCollector {
+ public:
+  StatsCollector() : enabled_(false) {}
+
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  void Enable() { enabled_.store(true, std::memory_order_relaxed); }
+
+  // Records one call to `GetNext()` on the iterator `prefix`, which took
+  // `self_time_us` microseconds excluding the time spent in the `GetNext()`
+  // calls of its inputs, and produced an element of `bytes` bytes unless
+  // `produced` is false.
+  void RecordGetNext(const string& prefix, int64 self_time_us, bool produced,
+                     int64 bytes);
+
+  // Records that the buffer of the iterator `prefix` held `size` elements
+  // ready for its consumer, out of at most `capacity`, when an element was
+  // requested.
+  void RecordBufferOccupancy(const string& prefix, int64 size,
+                             int64 capacity);
+
+  // Appends the statistics to `summary` as simple values tagged
+  // "<prefix>/<statistic>", where the statistic is one of:
+  //
+  // * "elements": the number of elements produced.
+  // * "bytes": the total size of the elements produced.
+  // * "self_time_us": the total time spent in `GetNext()`, excluding the time
+  //   spent in the `GetNext()` calls of inputs on the same thread. For an
+  //   iterator that reads its input on a background thread, this is the time
+  //   its consumer waited for elements.
+  // * "buffer_occupancy" and "buffer_capacity": the average number of ready
+  //   and maximum number of elements in the buffer, for iterators that buffer
+  //   elements.
+  void AddToSummary(Summary* summary);
+
+ private:
+  struct IteratorStats {
+    int64 elements = 0;
+    int64 bytes = 0;
+    int64 self_time_us = 0;
+    int64 occupancy_samples = 0;
+    int64 occupancy_total = 0;
+    int64 capacity = 0;
+  };
+
+  std::atomic<bool> enabled_;
+  mutex mu_;
+  std::map<string, IteratorStats> stats_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StatsCollector);
+};
+
+// Measures one call to `GetNext()`, and the time of any calls nested within it
+// on the same thread, so that the time of the inputs can be excluded.
+class ScopedGetNextTimer {
+ public:
+  ScopedGetNextTimer();
+  ~ScopedGetNextTimer();
+
+  // Returns the time since construction, excluding the time spent in the nested
+  // timers that have been destroyed.
+  int64 SelfTimeMicros() const;
+
+ private:
+  const int64 start_us_;
+  int64 nested_us_ = 0;
+  ScopedGetNextTimer* const parent_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedGetNextTimer);
+};
+
+}  // namespace dataset
+
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DATASET_STATS_H_
@@ -0,0 +1,83 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/dataset_stats.h"
+
+#include "tensorflow/core/framework/summary.pb.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace dataset {
+namespace {
+
+std::map<string, float> SummaryValues(StatsCollector* stats) {
+  Summary summary;
+  stats->AddToSummary(&summary);
+  std::map<string, float> values;
+  for (const Summary::Value& value : summary.value()) {
+    values[value.tag()] = value.simple_value();
+  }
+  return values;
+}
+
+TEST(StatsCollectorTest, IsDisabledByDefault) {
+  StatsCollector stats;
+  EXPECT_FALSE(stats.enabled());
+  stats.Enable();
+  EXPECT_TRUE(stats.enabled());
+}
+
+TEST(StatsCollectorTest, AccumulatesPerIterator) {
+  StatsCollector stats;
+  stats.RecordGetNext("Iterator::Map", 10, true, 100);
+  stats.RecordGetNext("Iterator::Map", 20, true, 50);
+  stats.RecordGetNext("Iterator::Map", 5, false, 0);
+  stats.RecordGetNext("Iterator::Map::Range", 1, true, 8);
+
+  std::map<string, float> values = SummaryValues(&stats);
+  EXPECT_EQ(6, values.size());
+  EXPECT_EQ(2, values["Iterator::Map/elements"]);
+  EXPECT_EQ(150, values["Iterator::Map/bytes"]);
+  EXPECT_EQ(35, values["Iterator::Map/self_time_us"]);
+  EXPECT_EQ(1, values["Iterator::Map::Range/elements"]);
+  EXPECT_EQ(8, values["Iterator::Map::Range/bytes"]);
+  EXPECT_EQ(1, values["Iterator::Map::Range/self_time_us"]);
+}
+
+TEST(StatsCollectorTest, AveragesBufferOccupancy) {
+  StatsCollector stats;
+  stats.RecordGetNext("Iterator::Prefetch", 0, true, 0);
+  stats.RecordBufferOccupancy("Iterator::Prefetch", 1, 4);
+  stats.RecordBufferOccupancy("Iterator::Prefetch", 4, 4);
+
+  std::map<string, float> values = SummaryValues(&stats);
+  EXPECT_EQ(2.5, values["Iterator::Prefetch/buffer_occupancy"]);
+  EXPECT_EQ(4, values["Iterator::Prefetch/buffer_capacity"]);
+}
+
+TEST(ScopedGetNextTimerTest, ExcludesNestedTime) {
+  ScopedGetNextTimer outer;
+  {
+    ScopedGetNextTimer inner;
+    Env::Default()->SleepForMicroseconds(20000);
+    EXPECT_GE(inner.SelfTimeMicros(), 20000);
+  }
+  // Only the time outside of the nested timer is counted.
+  EXPECT_LT(outer.SelfTimeMicros(), 20000);
+}
+
+}  // namespace
+}  // namespace dataset
+}  // namespace tensorflow
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 
 // See docs in ../ops/parsing_ops.cc.
+#include <string.h>
+#include <deque>
 #include <vector>
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -21,6 +23,8 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -60,191 +64,238 @@ class DecodeCSVOp : public OpKernel {
     OpOutputList output;
     OP_REQUIRES_OK(ctx, ctx->output_list("output", &output));
 
+    std::vector<Tensor*> outputs(out_type_.size());
     for (int i = 0; i < static_cast<int>(out_type_.size()); ++i) {
-      Tensor* out = nullptr;
-      OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &out));
+      OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &outputs[i]));
     }
 
-    for (int64 i = 0; i < records_size; ++i) {
-      const StringPiece record(records_t(i));
-      std::vector<string> fields;
-      ExtractFields(ctx, record, &fields);
-      OP_REQUIRES(ctx, fields.size() == out_type_.size(),
-                  errors::InvalidArgument("Expect ", out_type_.size(),
-                                          " fields but have ", fields.size(),
-                                          " in record ", i));
+    // The records are parsed independently, so they are sharded over the
+    // intra-op threads. If several records are invalid, the error for the
+    // first of them is reported, as if they had been parsed in order.
+    mutex mu;
+    int64 error_record = records_size;
+    Status error_status;
+    auto parse_records = [&](int64 start, int64 limit) {
+      ParseScratch scratch;
+      for (int64 i = start; i < limit; ++i) {
+        Status s = ParseRecord(i, records_t(i), record_defaults, outputs,
+                               &scratch);
+        if (!s.ok()) {
+          mutex_lock l(mu);
+          if (i < error_record) {
+            error_record = i;
+            error_status = s;
+          }
+          return;
+        }
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, records_size,
+          kCostPerField * std::max<int64>(1, out_type_.size()), parse_records);
+    OP_REQUIRES_OK(ctx, error_status);
+  }
 
-      // Check each field in the record
-      for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
-        const DataType& dtype = out_type_[f];
-        switch (dtype) {
-          case DT_INT32: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
+ private:
+  // A rough estimate of the cycles needed to split and convert one field.
+  static constexpr int64 kCostPerField = 250;
 
-              output[f]->flat<int32>()(i) = record_defaults[f].flat<int32>()(0);
-            } else {
-              int32 value;
-              OP_REQUIRES(ctx, strings::safe_strto32(fields[f], &value),
-                          errors::InvalidArgument("Field ", f, " in record ", i,
-                                                  " is not a valid int32: ",
-                                                  fields[f]));
-              output[f]->flat<int32>()(i) = value;
-            }
-            break;
-          }
-          case DT_INT64: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
+  // Buffers reused across the records parsed by one thread.
+  struct ParseScratch {
+    std::vector<StringPiece> fields;
+    // Backing store for the quoted fields that contain escaped quotes, which
+    // are the only fields that cannot point into the record itself. The
+    // elements of a deque are not moved when more are appended.
+    std::deque<string> unescaped;
+    // A NUL-terminated copy of a field, for the floating-point parsers.
+    string number;
+  };
 
-              output[f]->flat<int64>()(i) = record_defaults[f].flat<int64>()(0);
-            } else {
-              int64 value;
-              OP_REQUIRES(ctx, strings::safe_strto64(fields[f], &value),
-                          errors::InvalidArgument("Field ", f, " in record ", i,
-                                                  " is not a valid int64: ",
-                                                  fields[f]));
-              output[f]->flat<int64>()(i) = value;
-            }
+  std::vector<DataType> out_type_;
+  char delim_;
+  bool use_quote_delim_;
+  string na_value_;
+
+  Status ParseRecord(int64 i, StringPiece record,
+                     const OpInputList& record_defaults,
+                     const std::vector<Tensor*>& output,
+                     ParseScratch* scratch) const {
+    std::vector<StringPiece>& fields = scratch->fields;
+    TF_RETURN_IF_ERROR(ExtractFields(record, scratch));
+    if (fields.size() != out_type_.size()) {
+      return errors::InvalidArgument("Expect ", out_type_.size(),
+                                     " fields but have ", fields.size(),
+                                     " in record ", i);
+    }
+
+    // Check each field in the record
+    for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
+      const DataType& dtype = out_type_[f];
+      // If this field is empty or NA value, check if default is given:
+      // If yes, use default value; Otherwise report error.
+      if (fields[f].empty() || fields[f] == na_value_) {
+        if (record_defaults[f].NumElements() != 1) {
+          return errors::InvalidArgument(
+              "Field ", f, " is required but missing in record ", i, "!");
+        }
+        switch (dtype) {
+          case DT_INT32:
+            output[f]->flat<int32>()(i) = record_defaults[f].flat<int32>()(0);
             break;
-          }
-          case DT_FLOAT: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<float>()(i) = record_defaults[f].flat<float>()(0);
-            } else {
-              float value;
-              OP_REQUIRES(ctx, strings::safe_strtof(fields[f].c_str(), &value),
-                          errors::InvalidArgument("Field ", f, " in record ", i,
-                                                  " is not a valid float: ",
-                                                  fields[f]));
-              output[f]->flat<float>()(i) = value;
-            }
+          case DT_INT64:
+            output[f]->flat<int64>()(i) = record_defaults[f].flat<int64>()(0);
             break;
-          }
-          case DT_DOUBLE: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<double>()(i) =
-                  record_defaults[f].flat<double>()(0);
-            } else {
-              double value;
-              OP_REQUIRES(ctx, strings::safe_strtod(fields[f].c_str(), &value),
-                          errors::InvalidArgument("Field ", f, " in record ", i,
-                                                  " is not a valid double: ",
-                                                  fields[f]));
-              output[f]->flat<double>()(i) = value;
-            }
+          case DT_FLOAT:
+            output[f]->flat<float>()(i) = record_defaults[f].flat<float>()(0);
             break;
-          }
-          case DT_STRING: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<string>()(i) =
-                  record_defaults[f].flat<string>()(0);
-            } else {
-              output[f]->flat<string>()(i) = fields[f];
-            }
+          case DT_DOUBLE:
+            output[f]->flat<double>()(i) =
+                record_defaults[f].flat<double>()(0);
+            break;
+          case DT_STRING:
+            output[f]->flat<string>()(i) =
+                record_defaults[f].flat<string>()(0);
             break;
-          }
           default:
-            OP_REQUIRES(ctx, false,
-                        errors::InvalidArgument("csv: data type ", dtype,
-                                                " not supported in field ", f));
+            return errors::InvalidArgument("csv: data type ", dtype,
+                                           " not supported in field ", f);
+        }
+        continue;
+      }
+      switch (dtype) {
+        case DT_INT32: {
+          int32 value;
+          if (!strings::safe_strto32(fields[f], &value)) {
+            return errors::InvalidArgument("Field ", f, " in record ", i,
+                                           " is not a valid int32: ",
+                                           fields[f]);
+          }
+          output[f]->flat<int32>()(i) = value;
+          break;
+        }
+        case DT_INT64: {
+          int64 value;
+          if (!strings::safe_strto64(fields[f], &value)) {
+            return errors::InvalidArgument("Field ", f, " in record ", i,
+                                           " is not a valid int64: ",
+                                           fields[f]);
+          }
+          output[f]->flat<int64>()(i) = value;
+          break;
+        }
+        case DT_FLOAT: {
+          float value;
+          scratch->number.assign(fields[f].data(), fields[f].size());
+          if (!strings::safe_strtof(scratch->number.c_str(), &value)) {
+            return errors::InvalidArgument("Field ", f, " in record ", i,
+                                           " is not a valid float: ",
+                                           fields[f]);
+          }
+          output[f]->flat<float>()(i) = value;
+          break;
+        }
+        case DT_DOUBLE: {
+          double value;
+          scratch->number.assign(fields[f].data(), fields[f].size());
+          if (!strings::safe_strtod(scratch->number.c_str(), &value)) {
+            return errors::InvalidArgument("Field ", f, " in record ", i,
+                                           " is not a valid double: ",
+                                           fields[f]);
+          }
+          output[f]->flat<double>()(i) = value;
+          break;
         }
+        case DT_STRING:
+          output[f]->flat<string>()(i).assign(fields[f].data(),
+                                              fields[f].size());
+          break;
+        default:
+          return errors::InvalidArgument("csv: data type ", dtype,
+                                         " not supported in field ", f);
       }
     }
+    return Status::OK();
   }
 
- private:
-  std::vector<DataType> out_type_;
-  char delim_;
-  bool use_quote_delim_;
-  string na_value_;
-
-  void ExtractFields(OpKernelContext* ctx, StringPiece input,
-                     std::vector<string>* result) {
-    int64 current_idx = 0;
+  // Splits `input` into `scratch->fields`. Unquoted fields, and quoted fields
+  // without escaped quotes, point into `input`; the delimiters and quotes are
+  // located with memchr() so that the bytes in between are not visited one at
+  // a time.
+  Status ExtractFields(StringPiece input, ParseScratch* scratch) const {
+    std::vector<StringPiece>* result = &scratch->fields;
+    result->clear();
+    scratch->unescaped.clear();
+    const char* data = input.data();
+    const size_t size = input.size();
+    size_t current_idx = 0;
     if (!input.empty()) {
-      while (static_cast<size_t>(current_idx) < input.size()) {
-        if (input[current_idx] == '\n' || input[current_idx] == '\r') {
+      while (current_idx < size) {
+        if (data[current_idx] == '\n' || data[current_idx] == '\r') {
           current_idx++;
           continue;
         }
 
         bool quoted = false;
-        if (use_quote_delim_ && input[current_idx] == '"') {
+        if (use_quote_delim_ && data[current_idx] == '"') {
           quoted = true;
           current_idx++;
         }
 
         // This is the body of the field;
-        string field;
+        StringPiece field;
         if (!quoted) {
-          while (static_cast<size_t>(current_idx) < input.size() &&
-                 input[current_idx] != delim_) {
-            OP_REQUIRES(ctx, (!use_quote_delim_ || input[current_idx] != '"') &&
-                                 input[current_idx] != '\n' &&
-                                 input[current_idx] != '\r',
-                        errors::InvalidArgument(
-                            "Unquoted fields cannot have quotes/CRLFs inside"));
-            field += input[current_idx];
-            current_idx++;
+          const char* end = static_cast<const char*>(
+              memchr(data + current_idx, delim_, size - current_idx));
+          const size_t end_idx = end == nullptr ? size : end - data;
+          for (size_t j = current_idx; j < end_idx; ++j) {
+            if ((use_quote_delim_ && data[j] == '"') || data[j] == '\n' ||
+                data[j] == '\r') {
+              return errors::InvalidArgument(
+                  "Unquoted fields cannot have quotes/CRLFs inside");
+            }
           }
+          field = StringPiece(data + current_idx, end_idx - current_idx);
 
           // Go to next field or the end
-          current_idx++;
-        } else if (use_quote_delim_) {
+          current_idx = end_idx + 1;
+        } else {
           // Quoted field needs to be ended with '"' and delim or end
-          while (
-              (static_cast<size_t>(current_idx) < input.size() - 1) &&
-              (input[current_idx] != '"' || input[current_idx + 1] != delim_)) {
-            if (input[current_idx] != '"') {
-              field += input[current_idx];
-              current_idx++;
-            } else {
-              OP_REQUIRES(
-                  ctx, input[current_idx + 1] == '"',
-                  errors::InvalidArgument("Quote inside a string has to be "
-                                          "escaped by another quote"));
-              field += '"';
-              current_idx += 2;
+          const size_t body_idx = current_idx;
+          string* unescaped = nullptr;
+          while (current_idx < size - 1) {
+            const char* quote = static_cast<const char*>(
+                memchr(data + current_idx, '"', size - 1 - current_idx));
+            const size_t quote_idx = quote == nullptr ? size - 1 : quote - data;
+            if (unescaped != nullptr) {
+              unescaped->append(data + current_idx, quote_idx - current_idx);
+            }
+            current_idx = quote_idx;
+            if (quote == nullptr || data[current_idx + 1] == delim_) break;
+            if (data[current_idx + 1] != '"') {
+              return errors::InvalidArgument(
+                  "Quote inside a string has to be escaped by another quote");
             }
+            if (unescaped == nullptr) {
+              scratch->unescaped.emplace_back(data + body_idx,
+                                              current_idx - body_idx);
+              unescaped = &scratch->unescaped.back();
+            }
+            unescaped->push_back('"');
+            current_idx += 2;
           }
 
-          OP_REQUIRES(
-              ctx, (static_cast<size_t>(current_idx) < input.size() &&
-                    input[current_idx] == '"' &&
-                    (static_cast<size_t>(current_idx) == input.size() - 1 ||
-                     input[current_idx + 1] == delim_)),
-              errors::InvalidArgument("Quoted field has to end with quote "
-                                      "followed by delim or end"));
+          if (!(current_idx < size && data[current_idx] == '"' &&
+                (current_idx == size - 1 || data[current_idx + 1] == delim_))) {
+            return errors::InvalidArgument(
+                "Quoted field has to end with quote followed by delim or end");
+          }
 
+          if (unescaped != nullptr) {
+            field = *unescaped;
+          } else {
+            field = StringPiece(data + body_idx, current_idx - body_idx);
+          }
           current_idx += 2;
         }
 
@@ -252,8 +303,9 @@ class DecodeCSVOp : public OpKernel {
       }
 
       // Check if the last field is missing
-      if (input[input.size() - 1] == delim_) result->push_back(string());
+      if (data[size - 1] == delim_) result->push_back(StringPiece());
     }
+    return Status::OK();
   }
 };
 
@@ -15,12 +15,15 @@ limitations under the License.
 
 // See docs in ../ops/image_ops.cc
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/image_resizer_state.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gif/gif_io.h"
 #include "tensorflow/core/lib/jpeg/jpeg_mem.h"
@@ -74,6 +77,12 @@ class DecodeImageOp : public OpKernel {
     } else if (type_string() == "DecodeAndCropJpeg") {
       format_ = kJpgFormat;
       flags_.crop = true;
+    } else if (type_string() == "DecodeCropAndResizeJpeg") {
+      format_ = kJpgFormat;
+      flags_.crop = true;
+      resize_ = true;
+      OP_REQUIRES_OK(context,
+                     context->GetAttr("align_corners", &align_corners_));
     } else if (type_string() == "DecodePng") {
       format_ = kPngFormat;
     } else if (type_string() == "DecodeGif") {
@@ -114,12 +123,16 @@ class DecodeImageOp : public OpKernel {
     flags_.dct_method = JDCT_IFAST;
 
     if (format_ == kJpgFormat) {
-      OP_REQUIRES_OK(context, context->GetAttr("ratio", &flags_.ratio));
-      OP_REQUIRES(context,
-                  flags_.ratio == 1 || flags_.ratio == 2 || flags_.ratio == 4 ||
-                      flags_.ratio == 8,
-                  errors::InvalidArgument("ratio must be 1, 2, 4, or 8, got ",
-                                          flags_.ratio));
+      // The fused resize picks the ratio according to the output size.
+      if (!resize_) {
+        OP_REQUIRES_OK(context, context->GetAttr("ratio", &flags_.ratio));
+        OP_REQUIRES(
+            context,
+            flags_.ratio == 1 || flags_.ratio == 2 || flags_.ratio == 4 ||
+                flags_.ratio == 8,
+            errors::InvalidArgument("ratio must be 1, 2, 4, or 8, got ",
+                                    flags_.ratio));
+      }
       OP_REQUIRES_OK(context, context->GetAttr("fancy_upscaling",
                                                &flags_.fancy_upscaling));
       OP_REQUIRES_OK(context,
@@ -206,6 +219,10 @@ class DecodeImageOp : public OpKernel {
       flags.crop_height = crop_window_vec(2);
       flags.crop_width = crop_window_vec(3);
     }
+    if (resize_) {
+      DecodeCropAndResizeJpeg(context, input, flags);
+      return;
+    }
 
     // Decode jpeg, allocating tensor once the size is known.
     Tensor* output = nullptr;
@@ -231,6 +248,128 @@ class DecodeImageOp : public OpKernel {
                                 input.size()));
   }
 
+  // Decodes the crop window of `flags` and resizes it to the size given by
+  // input 2. Only the scanlines that intersect the crop window are decoded,
+  // and those are downscaled by the IDCT (by a ratio of up to 8) as far as
+  // possible without dropping below the output size, so that the bilinear
+  // resize that follows only touches a small decoded image.
+  void DecodeCropAndResizeJpeg(OpKernelContext* context, StringPiece input,
+                               jpeg::UncompressFlags flags) {
+    const Tensor& size = context->input(2);
+    OP_REQUIRES(context, size.dims() == 1 && size.dim_size(0) == 2,
+                errors::InvalidArgument("size must be 1-D with two elements, ",
+                                        "got shape ",
+                                        size.shape().DebugString()));
+    const int64 out_height = size.vec<int32>()(0);
+    const int64 out_width = size.vec<int32>()(1);
+    OP_REQUIRES(context, out_height > 0 && out_width > 0,
+                errors::InvalidArgument("size must be positive, got [",
+                                        out_height, ", ", out_width, "]"));
+    int width;
+    int height;
+    OP_REQUIRES(context,
+                jpeg::GetImageInfo(input.data(), input.size(), &width, &height,
+                                   nullptr /* components */),
+                errors::InvalidArgument("Invalid JPEG data, data size ",
+                                        input.size()));
+    OP_REQUIRES(context,
+                flags.crop_width > 0 && flags.crop_height > 0 &&
+                    flags.crop_x >= 0 && flags.crop_y >= 0 &&
+                    flags.crop_y + flags.crop_height <= height &&
+                    flags.crop_x + flags.crop_width <= width,
+                errors::InvalidArgument("Invalid JPEG data or crop window, ",
+                                        "data size ", input.size()));
+
+    const int crop_y = flags.crop_y;
+    const int crop_x = flags.crop_x;
+    const int crop_height = flags.crop_height;
+    const int crop_width = flags.crop_width;
+    int ratio = 1;
+    while (ratio < 8 && crop_height >= 2 * ratio * out_height &&
+           crop_width >= 2 * ratio * out_width) {
+      ratio *= 2;
+    }
+
+    // The crop window in the coordinates of the downscaled image, which is
+    // rounded outwards. libjpeg rounds the downscaled image size up.
+    flags.ratio = ratio;
+    flags.crop_y = crop_y / ratio;
+    flags.crop_x = crop_x / ratio;
+    flags.crop_height =
+        std::min((height + ratio - 1) / ratio,
+                 (crop_y + crop_height + ratio - 1) / ratio) -
+        flags.crop_y;
+    flags.crop_width = std::min((width + ratio - 1) / ratio,
+                                (crop_x + crop_width + ratio - 1) / ratio) -
+                       flags.crop_x;
+
+    Tensor decoded;
+    OP_REQUIRES(
+        context,
+        jpeg::Uncompress(
+            input.data(), input.size(), flags, nullptr /* nwarn */,
+            [=, &decoded](int width, int height, int channels) -> uint8* {
+              Status status(context->allocate_temp(
+                  DT_UINT8, TensorShape({height, width, channels}), &decoded));
+              if (!status.ok()) {
+                VLOG(1) << status;
+                context->SetStatus(status);
+                return nullptr;
+              }
+              return decoded.flat<uint8>().data();
+            }),
+        errors::InvalidArgument("Invalid JPEG data or crop window, data size ",
+                                input.size()));
+    const int64 in_height = decoded.dim_size(0);
+    const int64 in_width = decoded.dim_size(1);
+    const int64 channels = decoded.dim_size(2);
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0, TensorShape({out_height, out_width, channels}),
+                       &output));
+
+    // The interpolation is the one of ResizeBilinear applied to the crop
+    // window of the full-size image, with source coordinates mapped into the
+    // decoded window. A downscaled pixel `k` is the average of the full-size
+    // pixels `[k * ratio, (k + 1) * ratio)`, so like ResizeArea, the
+    // full-size coordinate `u` maps to `u / ratio`. For a ratio of 1 the
+    // results are identical to those of ResizeBilinear.
+    std::vector<CachedInterpolation> ys(out_height);
+    ComputeInterpolation(
+        CalculateResizeScale(crop_height, out_height, align_corners_), ratio,
+        static_cast<float>(crop_y) / ratio - flags.crop_y, in_height, &ys);
+    std::vector<CachedInterpolation> xs(out_width);
+    ComputeInterpolation(
+        CalculateResizeScale(crop_width, out_width, align_corners_), ratio,
+        static_cast<float>(crop_x) / ratio - flags.crop_x, in_width, &xs);
+
+    const uint8* in_data = decoded.flat<uint8>().data();
+    float* out_data = output->flat<float>().data();
+    const int64 in_row_size = in_width * channels;
+    for (int64 y = 0; y < out_height; ++y) {
+      const uint8* lower_row = in_data + ys[y].lower * in_row_size;
+      const uint8* upper_row = in_data + ys[y].upper * in_row_size;
+      const float y_lerp = ys[y].lerp;
+      for (int64 x = 0; x < out_width; ++x) {
+        const int64 left = xs[x].lower * channels;
+        const int64 right = xs[x].upper * channels;
+        const float x_lerp = xs[x].lerp;
+        for (int64 c = 0; c < channels; ++c) {
+          const float top_left(lower_row[left + c]);
+          const float top_right(lower_row[right + c]);
+          const float bottom_left(upper_row[left + c]);
+          const float bottom_right(upper_row[right + c]);
+          const float top = top_left + (top_right - top_left) * x_lerp;
+          const float bottom =
+              bottom_left + (bottom_right - bottom_left) * x_lerp;
+          *out_data++ = top + (bottom - top) * y_lerp;
+        }
+      }
+    }
+  }
+
   void DecodePng(OpKernelContext* context, StringPiece input) {
     // Start decoding png to get shape details
     png::DecodeContext decode;
@@ -325,10 +464,32 @@ class DecodeImageOp : public OpKernel {
   }
 
  private:
+  struct CachedInterpolation {
+    int64 lower;  // Lower source index used in the interpolation
+    int64 upper;  // Upper source index used in the interpolation
+    float lerp;
+  };
+
+  // Output index `i` is taken from `i * scale / ratio + offset` in an input
+  // of `in_size` elements.
+  static void ComputeInterpolation(float scale, int ratio, float offset,
+                                   int64 in_size,
+                                   std::vector<CachedInterpolation>* out) {
+    for (size_t i = 0; i < out->size(); ++i) {
+      const float in = std::max(0.0f, i * scale / ratio + offset);
+      CachedInterpolation& interpolation = (*out)[i];
+      interpolation.lower = std::min(static_cast<int64>(in), in_size - 1);
+      interpolation.upper = std::min(interpolation.lower + 1, in_size - 1);
+      interpolation.lerp = in - interpolation.lower;
+    }
+  }
+
   FileFormat format_;
   int channels_;
   int channel_bits_ = 8;
   jpeg::UncompressFlags flags_;
+  bool resize_ = false;
+  bool align_corners_ = false;
 };
 
 REGISTER_KERNEL_BUILDER(Name("DecodeJpeg").Device(DEVICE_CPU), DecodeImageOp);
@@ -336,6 +497,8 @@ REGISTER_KERNEL_BUILDER(Name("DecodePng").Device(DEVICE_CPU), DecodeImageOp);
 REGISTER_KERNEL_BUILDER(Name("DecodeGif").Device(DEVICE_CPU), DecodeImageOp);
 REGISTER_KERNEL_BUILDER(Name("DecodeAndCropJpeg").Device(DEVICE_CPU),
                         DecodeImageOp);
+REGISTER_KERNEL_BUILDER(Name("DecodeCropAndResizeJpeg").Device(DEVICE_CPU),
+                        DecodeImageOp);
 
 }  // namespace
 }  // namespace tensorflow
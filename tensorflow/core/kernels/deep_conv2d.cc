@@ -20,6 +20,8 @@ limitations under the License.
 
 #include <stdlib.h>
 
+#include <memory>
+
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/kernels/winograd_transform.h"
 #include "tensorflow/core/util/work_sharder.h"
@@ -90,6 +92,36 @@ static bool ReadBoolFromEnvVar(const char* env_var_name, bool default_val) {
   return default_val;
 }
 
+// Returns the cost of the convolution by DeepConv2D with 'transform'.
+template <typename T>
+static int64 GetDeepConvCost(const DeepConv2DTransform<T>& transform,
+                             int in_depth, int out_depth, int out_rows,
+                             int out_cols) {
+  return GetDeepConvCost(transform.input_shape().rows,
+                         transform.input_shape().cols,
+                         transform.output_shape().rows,
+                         transform.output_shape().cols, in_depth, out_depth,
+                         out_rows, out_cols);
+}
+
+// Returns the Winograd transform for 3x3 filters with the smallest cost for
+// the convolution. The 4x4 output tiles of Winograd4x4Transform need fewer
+// products per output, but waste more of them at the boundaries of small
+// outputs, and have larger tile transforms.
+template <typename T>
+static std::unique_ptr<DeepConv2DTransform<T>> NewWinogradTransform(
+    int in_depth, int out_depth, int out_rows, int out_cols) {
+  std::unique_ptr<DeepConv2DTransform<T>> transform(new WinogradTransform<T>);
+  std::unique_ptr<DeepConv2DTransform<T>> transform_4x4(
+      new Winograd4x4Transform<T>);
+  if (GetDeepConvCost(*transform_4x4, in_depth, out_depth, out_rows,
+                      out_cols) <
+      GetDeepConvCost(*transform, in_depth, out_depth, out_rows, out_cols)) {
+    return transform_4x4;
+  }
+  return transform;
+}
+
 // Returns true if convolution can be computed efficiently by DeepConv2D,
 // returns false otherwise.
 // TODO(andydavis) Add support for other filter sizes and strides.
@@ -111,10 +143,10 @@ bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
   }
 
   // Check if flop cost of deep convolution is less than direct convolution.
-  WinogradTransform<float> t;
-  const int64 deep_conv_cost = GetDeepConvCost(
-      t.input_shape().rows, t.input_shape().cols, t.output_shape().rows,
-      t.output_shape().cols, in_depth, out_depth, out_rows, out_cols);
+  std::unique_ptr<DeepConv2DTransform<float>> t =
+      NewWinogradTransform<float>(in_depth, out_depth, out_rows, out_cols);
+  const int64 deep_conv_cost =
+      GetDeepConvCost(*t, in_depth, out_depth, out_rows, out_cols);
   const int64 direct_conv_cost = GetDirectConvCost(
       filter_rows, filter_cols, in_depth, out_depth, out_rows, out_cols);
 
@@ -123,6 +155,7 @@ bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
           << " direct_conv_cost: " << direct_conv_cost
           << " deep_direct_ratio: " << (static_cast<float>(deep_conv_cost) /
                                         static_cast<float>(direct_conv_cost))
+          << " output_tile_rows: " << t->output_shape().rows
           << " use_deep_conv: " << (deep_conv_cost < direct_conv_cost);
   return deep_conv_cost < direct_conv_cost;
 }
@@ -936,8 +969,9 @@ template <typename T>
 struct DeepConv2D<CPUDevice, T> {
   void operator()(OpKernelContext* ctx, const Conv2DArgs& args, const T* input,
                   const T* filter, T* output) {
-    // TODO(andydavis) Add function to select transform based on conv params.
-    std::unique_ptr<DeepConv2DTransform<T>> transform(new WinogradTransform<T>);
+    std::unique_ptr<DeepConv2DTransform<T>> transform =
+        NewWinogradTransform<T>(args.in_depth, args.out_depth, args.out_rows,
+                                args.out_cols);
 
     const int64 in_depth = args.in_depth;
     const int64 out_depth = args.out_depth;
@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/kernels/winograd_transform.h"
+
+#include <vector>
+
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -155,5 +158,73 @@ TEST(DeepConv2DTransformTest, WingradOutputTransformMatrix) {
   }
 }
 
+// Computes the 3x3 correlation of one input tile with a filter through the
+// transform matrices of 'transform', and compares it with the direct one.
+static void TestTileCorrelation(const DeepConv2DTransform<float>& transform) {
+  const int filter_rows = transform.filter_shape().rows;
+  const int filter_cols = transform.filter_shape().cols;
+  const int tile_rows = transform.input_shape().rows;
+  const int tile_cols = transform.input_shape().cols;
+  const int out_tile_rows = transform.output_shape().rows;
+  const int out_tile_cols = transform.output_shape().cols;
+  const int filter_size = filter_rows * filter_cols;
+  const int tile_size = tile_rows * tile_cols;
+  const int out_tile_size = out_tile_rows * out_tile_cols;
+
+  std::vector<float> filter(filter_size);
+  for (int i = 0; i < filter_size; ++i) filter[i] = (i % 5) - 2.0f;
+  std::vector<float> tile(tile_size);
+  for (int i = 0; i < tile_size; ++i) tile[i] = ((i * 7) % 11) * 0.25f;
+
+  std::vector<float> filter_matrix(tile_size * filter_size);
+  std::vector<float> input_matrix(tile_size * tile_size);
+  std::vector<float> output_matrix(out_tile_size * tile_size);
+  transform.GetFilterTransformMatrix(tile_size, filter_size,
+                                     filter_matrix.data());
+  transform.GetInputTransformMatrix(tile_size, tile_size, input_matrix.data());
+  transform.GetOutputTransformMatrix(out_tile_size, tile_size,
+                                     output_matrix.data());
+
+  // Element-wise product of the transformed filter and tile.
+  std::vector<float> product(tile_size);
+  for (int i = 0; i < tile_size; ++i) {
+    float f = 0;
+    for (int j = 0; j < filter_size; ++j) {
+      f += filter_matrix[i * filter_size + j] * filter[j];
+    }
+    float d = 0;
+    for (int j = 0; j < tile_size; ++j) {
+      d += input_matrix[i * tile_size + j] * tile[j];
+    }
+    product[i] = f * d;
+  }
+
+  for (int r = 0; r < out_tile_rows; ++r) {
+    for (int c = 0; c < out_tile_cols; ++c) {
+      float out = 0;
+      for (int j = 0; j < tile_size; ++j) {
+        out += output_matrix[(r * out_tile_cols + c) * tile_size + j] *
+               product[j];
+      }
+      float expected = 0;
+      for (int fr = 0; fr < filter_rows; ++fr) {
+        for (int fc = 0; fc < filter_cols; ++fc) {
+          expected += tile[(r + fr) * tile_cols + c + fc] *
+                      filter[fr * filter_cols + fc];
+        }
+      }
+      EXPECT_NEAR(expected, out, 1e-4) << "at (" << r << ", " << c << ")";
+    }
+  }
+}
+
+TEST(DeepConv2DTransformTest, WinogradTileCorrelation) {
+  TestTileCorrelation(WinogradTransform<float>());
+}
+
+TEST(DeepConv2DTransformTest, Winograd4x4TileCorrelation) {
+  TestTileCorrelation(Winograd4x4Transform<float>());
+}
+
 }  // namespace
 }  // namespace tensorflow
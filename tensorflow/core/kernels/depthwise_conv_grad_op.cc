@@ -377,6 +377,12 @@ struct LaunchDepthwiseConvBackpropInputOp<CPUDevice, T> {
 
     static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
 
+    if (args.stride == 1 &&
+        functor::DepthwiseConv2DDirectKernel<T>::CanRun(args)) {
+      LaunchDirect(ctx, args, out_backprop, depthwise_filter, in_backprop);
+      return;
+    }
+
     // Pad 'depthwise_filter' to vector register width (if needed).
     const bool pad_filter = (args.out_depth % kPacketSize) == 0 ? false : true;
     Tensor padded_filter;
@@ -450,6 +456,62 @@ struct LaunchDepthwiseConvBackpropInputOp<CPUDevice, T> {
     Shard(worker_threads.num_threads, worker_threads.workers, args.batch,
           shard_cost, shard);
   }
+
+ private:
+  // With a stride of one and a 'depth_multiplier' of one, the backprop input
+  // is the depthwise conv2d of 'out_backprop' by the spatially reversed
+  // filter, which pads 'out_backprop' by the filter size minus one minus the
+  // forward padding. Computes it with DepthwiseConv2DDirectKernel.
+  void LaunchDirect(OpKernelContext* ctx, const DepthwiseArgs& args,
+                    const T* out_backprop, const T* depthwise_filter,
+                    T* in_backprop) {
+    const int64 depth = args.in_depth;
+    Tensor reversed_filter;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(
+                            DataTypeToEnum<T>::value,
+                            TensorShape({args.filter_rows, args.filter_cols,
+                                         depth}),
+                            &reversed_filter));
+    T* reversed = reversed_filter.template flat<T>().data();
+    for (int64 f_r = 0; f_r < args.filter_rows; ++f_r) {
+      for (int64 f_c = 0; f_c < args.filter_cols; ++f_c) {
+        const int64 from = ((args.filter_rows - 1 - f_r) * args.filter_cols +
+                            args.filter_cols - 1 - f_c) *
+                           depth;
+        std::copy_n(depthwise_filter + from, depth,
+                    reversed + (f_r * args.filter_cols + f_c) * depth);
+      }
+    }
+
+    DepthwiseArgs bprop_args = args;
+    bprop_args.in_rows = args.out_rows;
+    bprop_args.in_cols = args.out_cols;
+    bprop_args.pad_rows = args.filter_rows - 1 - args.pad_rows;
+    bprop_args.pad_cols = args.filter_cols - 1 - args.pad_cols;
+    bprop_args.out_rows = args.in_rows;
+    bprop_args.out_cols = args.in_cols;
+
+    auto shard = [&bprop_args, out_backprop, reversed, in_backprop](
+        int64 start, int64 limit) {
+      const int64 out_bprop_image_size =
+          bprop_args.in_rows * bprop_args.in_cols * bprop_args.in_depth;
+      const int64 in_bprop_image_size =
+          bprop_args.out_rows * bprop_args.out_cols * bprop_args.out_depth;
+      for (int64 i = start; i < limit; ++i) {
+        const int64 b = i / bprop_args.out_rows;
+        functor::DepthwiseConv2DDirectKernel<T>::Run(
+            bprop_args, i % bprop_args.out_rows,
+            out_backprop + b * out_bprop_image_size, reversed,
+            in_backprop + b * in_bprop_image_size);
+      }
+    };
+
+    const int64 shard_cost =
+        args.in_cols * args.filter_rows * args.filter_cols * depth;
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          args.batch * args.in_rows, shard_cost, shard);
+  }
 };
 
 template <typename T>
@@ -142,12 +142,11 @@ struct DepthwiseConv2DKernel {
 // the result in 'output'. This implementation trades off copying small patches
 // of the input to achieve better data alignment, which enables vectorized
 // load/store and multiply-add operations (see comments at InputBufferCopyOp and
-// DepthwiseConv2DKernel for details).
+// DepthwiseConv2DKernel for details). When 'depth_multiplier' is one, the
+// input is instead read in place by DepthwiseConv2DDirectKernel.
 //
 // TODO(andydavis) Evaluate the performance of processing multiple input
 // patches in the inner loop.
-// TODO(andydavis) Consider a zero-copy implementation for the case when
-// 'in_depth' is a multiple of register width, and 'depth_multipler' is one.
 // TODO(andydavis) Evaluate the performance of alternative implementations.
 template <typename T>
 struct LaunchDepthwiseConvOp<CPUDevice, T> {
@@ -162,6 +161,37 @@ struct LaunchDepthwiseConvOp<CPUDevice, T> {
             "Depthwise convolution on CPU is only supported for NHWC format"));
     static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
 
+    const int64 total_shards = args.batch * args.out_rows;
+
+    // Empirically tested to give reasonable performance boosts at batch size 1
+    // without reducing throughput at batch size 32.
+    const float kCostMultiplier = 2.5f;
+
+    // TODO(andydavis): Estimate shard cost (in cycles) based on the number of
+    // flops/loads/stores required to compute one shard.
+    const int64 shard_cost = kCostMultiplier * args.out_cols * args.out_depth;
+
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+
+    if (functor::DepthwiseConv2DDirectKernel<T>::CanRun(args)) {
+      auto shard = [&args, input, depthwise_filter, output](int64 start,
+                                                            int64 limit) {
+        const int64 input_image_size =
+            args.in_rows * args.in_cols * args.in_depth;
+        const int64 output_image_size =
+            args.out_rows * args.out_cols * args.out_depth;
+        for (int64 i = start; i < limit; ++i) {
+          const int64 b = i / args.out_rows;
+          functor::DepthwiseConv2DDirectKernel<T>::Run(
+              args, i % args.out_rows, input + b * input_image_size,
+              depthwise_filter, output + b * output_image_size);
+        }
+      };
+      Shard(worker_threads.num_threads, worker_threads.workers, total_shards,
+            shard_cost, shard);
+      return;
+    }
+
     // Pad 'depthwise_filter' to vector register width (if needed).
     const bool pad_filter = (args.out_depth % kPacketSize) == 0 ? false : true;
     Tensor padded_filter;
@@ -224,17 +254,6 @@ struct LaunchDepthwiseConvOp<CPUDevice, T> {
       }
     };
 
-    const int64 total_shards = args.batch * args.out_rows;
-
-    // Empirically tested to give reasonable performance boosts at batch size 1
-    // without reducing throughput at batch size 32.
-    const float kCostMultiplier = 2.5f;
-
-    // TODO(andydavis): Estimate shard cost (in cycles) based on the number of
-    // flops/loads/stores required to compute one shard.
-    const int64 shard_cost = kCostMultiplier * args.out_cols * args.out_depth;
-
-    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
     Shard(worker_threads.num_threads, worker_threads.workers, total_shards,
           shard_cost, shard);
   }
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DEPTHWISE_CONV_OP_H_
 #define THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DEPTHWISE_CONV_OP_H_
 
+#include <algorithm>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/util/tensor_format.h"
@@ -280,6 +282,105 @@ struct DepthwiseInputCopyOp {
   }
 };
 
+// Computes the row 'out_r' of the depthwise conv2d of the image 'input' by
+// 'filter' directly, for 'depth_multiplier' == 1, and stores it in the image
+// 'output'. Unlike DepthwiseInputCopyOp and DepthwiseConv2DKernel, the input
+// is read in place instead of being copied to an aligned buffer, and
+// kOutColTile output columns are computed together so that each filter packet
+// loaded is multiplied with the inputs of all of them.
+//
+// 'filter' is the unpadded filter [filter_rows, filter_cols, in_depth, 1].
+template <typename T>
+struct DepthwiseConv2DDirectKernel {
+  typedef typename Eigen::internal::packet_traits<T>::type Packet;
+  static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
+  static const int64 kOutColTile = 4;
+
+  static bool CanRun(const DepthwiseArgs& args) {
+    return args.depth_multiplier == 1 && args.in_depth >= kPacketSize;
+  }
+
+  static void Run(const DepthwiseArgs& args, const int64 out_r,
+                  const T* input, const T* filter, T* output) {
+    const int64 in_r_start = out_r * args.stride - args.pad_rows;
+    const int64 f_r_begin = std::max<int64>(0, -in_r_start);
+    const int64 f_r_end =
+        std::min<int64>(args.filter_rows, args.in_rows - in_r_start);
+    // The inputs of the output columns [out_c_begin, out_c_end) are all in
+    // the image.
+    const int64 out_c_begin =
+        std::min<int64>(args.out_cols, (args.pad_cols + args.stride - 1) /
+                                           args.stride);
+    const int64 last_in_c = args.in_cols + args.pad_cols - args.filter_cols;
+    const int64 out_c_end =
+        last_in_c < 0 ? out_c_begin
+                      : std::max<int64>(
+                            out_c_begin,
+                            std::min<int64>(args.out_cols,
+                                            last_in_c / args.stride + 1));
+    T* out_row = output + out_r * args.out_cols * args.out_depth;
+
+    int64 out_c = 0;
+    for (; out_c < out_c_begin; ++out_c) {
+      ComputeColumns<1, true>(args, in_r_start, f_r_begin, f_r_end, out_c,
+                              input, filter, out_row);
+    }
+    for (; out_c + kOutColTile <= out_c_end; out_c += kOutColTile) {
+      ComputeColumns<kOutColTile, false>(args, in_r_start, f_r_begin, f_r_end,
+                                         out_c, input, filter, out_row);
+    }
+    for (; out_c < out_c_end; ++out_c) {
+      ComputeColumns<1, false>(args, in_r_start, f_r_begin, f_r_end, out_c,
+                               input, filter, out_row);
+    }
+    for (; out_c < args.out_cols; ++out_c) {
+      ComputeColumns<1, true>(args, in_r_start, f_r_begin, f_r_end, out_c,
+                              input, filter, out_row);
+    }
+  }
+
+ private:
+  // Computes the output columns [out_c, out_c + kCols) of 'out_row', only
+  // reading the input columns within the image if 'kCheckCols'.
+  template <int kCols, bool kCheckCols>
+  static void ComputeColumns(const DepthwiseArgs& args, const int64 in_r_start,
+                             const int64 f_r_begin, const int64 f_r_end,
+                             const int64 out_c, const T* input, const T* filter,
+                             T* out_row) {
+    const int64 depth = args.in_depth;
+    const int64 in_c_start = out_c * args.stride - args.pad_cols;
+
+    for (int64 d = 0; d < depth; d += kPacketSize) {
+      // As 'in_depth' >= kPacketSize, the last packet of channels can
+      // overlap the previous one instead of being computed by scalars.
+      const int64 c = std::min<int64>(d, depth - kPacketSize);
+      Packet acc[kCols];
+      for (int t = 0; t < kCols; ++t) {
+        acc[t] = Eigen::internal::pset1<Packet>(T(0));
+      }
+      for (int64 f_r = f_r_begin; f_r < f_r_end; ++f_r) {
+        const T* in_row = input + (in_r_start + f_r) * args.in_cols * depth;
+        const T* filter_row = filter + f_r * args.filter_cols * depth;
+        for (int64 f_c = 0; f_c < args.filter_cols; ++f_c) {
+          const auto filter_block =
+              Eigen::internal::ploadu<Packet>(filter_row + f_c * depth + c);
+          for (int t = 0; t < kCols; ++t) {
+            const int64 in_c = in_c_start + t * args.stride + f_c;
+            if (kCheckCols && (in_c < 0 || in_c >= args.in_cols)) continue;
+            const auto data_block =
+                Eigen::internal::ploadu<Packet>(in_row + in_c * depth + c);
+            acc[t] = Eigen::internal::pmadd<Packet>(filter_block, data_block,
+                                                    acc[t]);
+          }
+        }
+      }
+      for (int t = 0; t < kCols; ++t) {
+        Eigen::internal::pstoreu<T>(out_row + (out_c + t) * depth + c, acc[t]);
+      }
+    }
+  }
+};
+
 }  // namespace functor
 }  // namespace tensorflow
 
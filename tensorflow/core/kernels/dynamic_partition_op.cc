@@ -15,6 +15,7 @@ limitations under the License.
 
 // See docs in ../ops/data_flow_ops.cc.
 
+#include <algorithm>
 #include <vector>
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -23,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -95,6 +97,13 @@ class DynamicPartitionOp : public DynamicPartitionOp_Shared {
     if (!c->status().ok()) return;
     if (num_partitions_ == 0 || data->NumElements() == 0) return;
 
+    auto worker_threads = c->device()->tensorflow_cpu_worker_threads();
+    if (worker_threads->num_threads > 1 &&
+        data->NumElements() >= kParallelMinElements) {
+      PartitionInParallel(c, *data, *partitions, &outputs);
+      return;
+    }
+
     auto e_partitions = partitions->flat<int32>();
     const int64 N = e_partitions.dimension(0);
     gtl::InlinedVector<int, 32> output_index(num_partitions_);
@@ -154,6 +163,98 @@ class DynamicPartitionOp : public DynamicPartitionOp_Shared {
       }
     }
   }
+
+ private:
+  // The number of elements of data above which it is partitioned in
+  // parallel.
+  static const int64 kParallelMinElements = 1 << 17;
+
+  // Copies the rows of "data" to "outputs" in two parallel passes over
+  // blocks of rows. The first one counts the rows of each partition in each
+  // block, so that after a prefix sum over the blocks the second one copies
+  // each block to its own rows of the outputs. Consecutive rows of the same
+  // partition are copied together.
+  void PartitionInParallel(OpKernelContext* c, const Tensor& data,
+                           const Tensor& partitions, OpOutputList* outputs) {
+    auto e_partitions = partitions.flat<int32>();
+    const int64 N = e_partitions.dimension(0);
+    const int64 slice_size = data.NumElements() / N;
+    auto worker_threads = c->device()->tensorflow_cpu_worker_threads();
+    const int64 num_blocks =
+        std::min<int64>(N, 4 * worker_threads->num_threads);
+    const int num_partitions = num_partitions_;
+    auto block_start = [N, num_blocks](int64 b) { return N * b / num_blocks; };
+
+    // The partitions of the rows, read once so that both passes agree, and
+    // the first row of each block with a partition out of range, if any.
+    std::vector<int32> row_partitions(N);
+    std::vector<int64> bad_rows(num_blocks, N);
+    // counts[b * num_partitions + p] is the number of rows of partition p in
+    // block b, and then the offset of the first of them in outputs[p].
+    std::vector<int64> counts(num_blocks * num_partitions, 0);
+    auto count = [&](int64 first_block, int64 last_block) {
+      for (int64 b = first_block; b < last_block; ++b) {
+        int64* block_counts = &counts[b * num_partitions];
+        for (int64 i = block_start(b); i < block_start(b + 1); ++i) {
+          const int32 p = internal::SubtleMustCopy(e_partitions(i));
+          if (!FastBoundsCheck(p, num_partitions)) {
+            bad_rows[b] = i;
+            break;
+          }
+          row_partitions[i] = p;
+          ++block_counts[p];
+        }
+      }
+    };
+    Shard(worker_threads->num_threads, worker_threads->workers, num_blocks,
+          5 * N / num_blocks, count);
+    const int64 bad_row = *std::min_element(bad_rows.begin(), bad_rows.end());
+    OP_REQUIRES(c, bad_row == N,
+                errors::InvalidArgument("indices[", bad_row,
+                                        "] has been asynchronously overwitten "
+                                        "and is no longer in range!"));
+
+    for (int p = 0; p < num_partitions; ++p) {
+      int64 offset = 0;
+      for (int64 b = 0; b < num_blocks; ++b) {
+        const int64 block_count = counts[b * num_partitions + p];
+        counts[b * num_partitions + p] = offset;
+        offset += block_count;
+      }
+      OP_REQUIRES(c, offset == (*outputs)[p]->dim_size(0),
+                  errors::InvalidArgument("Size of output_index: ", offset,
+                                          " is no longer in range."));
+    }
+
+    const T* data_base = data.flat<T>().data();
+    std::vector<T*> output_bases(num_partitions);
+    for (int p = 0; p < num_partitions; ++p) {
+      output_bases[p] = (*outputs)[p]->flat<T>().data();
+    }
+    auto copy = [&](int64 first_block, int64 last_block) {
+      for (int64 b = first_block; b < last_block; ++b) {
+        int64* offsets = &counts[b * num_partitions];
+        const int64 end = block_start(b + 1);
+        for (int64 i = block_start(b); i < end;) {
+          const int32 p = row_partitions[i];
+          int64 run_end = i + 1;
+          while (run_end < end && row_partitions[run_end] == p) ++run_end;
+          const T* src = data_base + i * slice_size;
+          T* dst = output_bases[p] + offsets[p] * slice_size;
+          const int64 run_size = (run_end - i) * slice_size;
+          if (DataTypeCanUseMemcpy(DataTypeToEnum<T>::v())) {
+            memcpy(dst, src, run_size * sizeof(T));
+          } else {
+            std::copy(src, src + run_size, dst);
+          }
+          offsets[p] += run_end - i;
+          i = run_end;
+        }
+      }
+    };
+    Shard(worker_threads->num_threads, worker_threads->workers, num_blocks,
+          (slice_size + 5) * N / num_blocks, copy);
+  }
 };
 
 #define REGISTER_DYNAMIC_PARTITION(T)                                     \
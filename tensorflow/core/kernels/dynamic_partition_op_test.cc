@@ -15,6 +15,7 @@ limitations under the License.
 
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/fake_input.h"
@@ -140,6 +141,39 @@ TEST_F(DynamicPartitionOpTest, SomeOutputsEmpty) {
   }
 }
 
+TEST_F(DynamicPartitionOpTest, Large_TwoD) {
+  MakeOp();
+
+  // Large enough to be partitioned in parallel, with runs of rows of the
+  // same partition.
+  const int kRows = 20000;
+  const int kCols = 8;
+  std::vector<float> data(kRows * kCols);
+  std::vector<int32> partitions(kRows);
+  for (int i = 0; i < kRows; ++i) {
+    for (int j = 0; j < kCols; ++j) data[i * kCols + j] = i * kCols + j;
+    partitions[i] = (i / 3) % 4;
+  }
+  AddInputFromArray<float>(TensorShape({kRows, kCols}), data);
+  AddInputFromArray<int32>(TensorShape({kRows}), partitions);
+  TF_ASSERT_OK(RunOpKernel());
+
+  for (int p = 0; p < 4; ++p) {
+    std::vector<float> expected_values;
+    for (int i = 0; i < kRows; ++i) {
+      if (partitions[i] != p) continue;
+      expected_values.insert(expected_values.end(), &data[i * kCols],
+                             &data[(i + 1) * kCols]);
+    }
+    Tensor expected(allocator(), DT_FLOAT,
+                    TensorShape({static_cast<int64>(expected_values.size()) /
+                                     kCols,
+                                 kCols}));
+    test::FillValues<float>(&expected, expected_values);
+    test::ExpectTensorEqual<float>(expected, *GetOutput(p));
+  }
+}
+
 TEST_F(DynamicPartitionOpTest, Error_IndexOutOfRange) {
   MakeOp();
 
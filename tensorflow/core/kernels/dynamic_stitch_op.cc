@@ -15,11 +15,15 @@ limitations under the License.
 
 // See docs in ../ops/data_flow_ops.cc.
 
+#include <algorithm>
+#include <vector>
+
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #ifdef GOOGLE_CUDA
 #include "tensorflow/core/kernels/cuda_device_array.h"
@@ -239,6 +243,16 @@ class DynamicStitchOpImplCPU : public DynamicStitchOpImplBase<T> {
       auto merged_flat = merged->flat_outer_dims<T>();
       const int slice_size = merged_flat.dimension(1);
       const size_t slice_bytes = slice_size * sizeof(T);
+      int64 num_indices = 0;
+      for (const Tensor& indices : indices_inputs) {
+        num_indices += indices.NumElements();
+      }
+      auto worker_threads = c->device()->tensorflow_cpu_worker_threads();
+      if (worker_threads->num_threads > 1 &&
+          num_indices * slice_size >= kParallelMinElements) {
+        StitchInParallel(c, indices_inputs, data_inputs, merged);
+        return;
+      }
       auto OnInputNumber = [&](int input_num) {
         const Tensor& indices = indices_inputs[input_num];
         auto indices_vec = indices.flat<int32>();
@@ -298,6 +312,62 @@ class DynamicStitchOpImplCPU : public DynamicStitchOpImplBase<T> {
       }
     }
   }
+
+ private:
+  // The number of elements of data above which they are stitched in
+  // parallel.
+  static const int64 kParallelMinElements = 1 << 17;
+
+  // Finds the row of data that each row of "merged" is copied from, which
+  // is the last one with its index as in the serial loop above, and then
+  // copies the rows of "merged" in parallel. Consecutive rows of "merged"
+  // that come from consecutive rows of the same data are copied together.
+  void StitchInParallel(OpKernelContext* c, const OpInputList& indices_inputs,
+                        const OpInputList& data_inputs, Tensor* merged) {
+    auto merged_flat = merged->flat_outer_dims<T>();
+    const int64 first_dim_size = merged_flat.dimension(0);
+    const int64 slice_size = merged_flat.dimension(1);
+    std::vector<const T*> sources(first_dim_size, nullptr);
+    for (int input_num = 0; input_num < indices_inputs.size(); ++input_num) {
+      auto indices_vec = indices_inputs[input_num].flat<int32>();
+      const T* data_base = data_inputs[input_num].flat<T>().data();
+      for (int i = 0; i < indices_vec.size(); i++) {
+        const int32 index = internal::SubtleMustCopy(indices_vec(i));
+        OP_REQUIRES(
+            c, FastBoundsCheck(index, first_dim_size),
+            errors::InvalidArgument("indices[", i, "] is out of range"));
+        sources[index] = data_base + i * slice_size;
+      }
+    }
+
+    T* merged_base = merged_flat.data();
+    auto copy = [&sources, merged_base, slice_size](int64 start,
+                                                    int64 limit) {
+      for (int64 r = start; r < limit;) {
+        const T* src = sources[r];
+        int64 run_end = r + 1;
+        if (src == nullptr) {
+          r = run_end;
+          continue;
+        }
+        while (run_end < limit &&
+               sources[run_end] == src + (run_end - r) * slice_size) {
+          ++run_end;
+        }
+        const int64 run_size = (run_end - r) * slice_size;
+        T* dst = merged_base + r * slice_size;
+        if (DataTypeCanUseMemcpy(DataTypeToEnum<T>::v())) {
+          memcpy(dst, src, run_size * sizeof(T));
+        } else {
+          std::copy(src, src + run_size, dst);
+        }
+        r = run_end;
+      }
+    };
+    auto worker_threads = c->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, first_dim_size,
+          slice_size + 5, copy);
+  }
 };
 
 // Using inheritance rather than a typedef so that these classes might have more
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/fake_input.h"
@@ -79,6 +80,42 @@ TEST_F(DynamicStitchOpTest, Simple_TwoD) {
   test::ExpectTensorEqual<float>(expected, *GetOutput(0));
 }
 
+TEST_F(DynamicStitchOpTest, Large_RepeatedIndices) {
+  MakeOp(2, DT_FLOAT);
+
+  // Large enough to be stitched in parallel. The second input overwrites the
+  // even rows of the first one.
+  const int kRows = 20000;
+  const int kCols = 8;
+  std::vector<int32> indices0(kRows);
+  std::vector<float> data0(kRows * kCols);
+  std::vector<int32> indices1(kRows / 2);
+  std::vector<float> data1(kRows / 2 * kCols);
+  std::vector<float> expected_values(kRows * kCols);
+  for (int i = 0; i < kRows; ++i) {
+    indices0[i] = i;
+    for (int j = 0; j < kCols; ++j) data0[i * kCols + j] = i;
+  }
+  for (int i = 0; i < kRows / 2; ++i) {
+    indices1[i] = 2 * i;
+    for (int j = 0; j < kCols; ++j) data1[i * kCols + j] = -1 - i;
+  }
+  for (int i = 0; i < kRows; ++i) {
+    for (int j = 0; j < kCols; ++j) {
+      expected_values[i * kCols + j] = i % 2 == 0 ? -1 - i / 2 : i;
+    }
+  }
+  AddInputFromArray<int32>(TensorShape({kRows}), indices0);
+  AddInputFromArray<int32>(TensorShape({kRows / 2}), indices1);
+  AddInputFromArray<float>(TensorShape({kRows, kCols}), data0);
+  AddInputFromArray<float>(TensorShape({kRows / 2, kCols}), data1);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({kRows, kCols}));
+  test::FillValues<float>(&expected, expected_values);
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
 TEST_F(DynamicStitchOpTest, Error_IndicesMultiDimensional) {
   MakeOp(2, DT_FLOAT);
 
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/fifo_queue.h"
+#include "tensorflow/core/kernels/lock_free_fifo_queue.h"
 #include "tensorflow/core/kernels/queue_base.h"
 #include "tensorflow/core/kernels/queue_op.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -36,9 +37,10 @@ limitations under the License.
 namespace tensorflow {
 
 // Defines a FIFOQueueOp, which produces a Queue (specifically, one
-// backed by FIFOQueue) that persists across different graph
-// executions, and sessions. Running this op produces a single-element
-// tensor of handles to Queues in the corresponding device.
+// backed by FIFOQueue, or by LockFreeFIFOQueue if the capacity is small
+// enough) that persists across different graph executions, and
+// sessions. Running this op produces a single-element tensor of handles
+// to Queues in the corresponding device.
 class FIFOQueueOp : public TypedQueueOp {
  public:
   explicit FIFOQueueOp(OpKernelConstruction* context) : TypedQueueOp(context) {
@@ -48,6 +50,12 @@ class FIFOQueueOp : public TypedQueueOp {
  private:
   Status CreateResource(QueueInterface** ret) override
       EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (capacity_ > 0 && capacity_ <= LockFreeFIFOQueue::kMaxCapacity) {
+      LockFreeFIFOQueue* queue = new LockFreeFIFOQueue(
+          capacity_, component_types_, component_shapes_, cinfo_.name());
+      *ret = queue;
+      return queue->Initialize();
+    }
     FIFOQueue* queue = new FIFOQueue(capacity_, component_types_,
                                      component_shapes_, cinfo_.name());
     return CreateTypedQueue(queue, ret);
@@ -22,6 +22,10 @@ limitations under the License.
 #include "tensorflow/core/util/stream_executor_util.h"
 #endif
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -29,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/kernels/fused_batch_norm_op.h"
 #include "tensorflow/core/util/tensor_format.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 using CPUDevice = Eigen::ThreadPoolDevice;
@@ -36,6 +41,12 @@ using GPUDevice = Eigen::GpuDevice;
 
 namespace functor {
 
+// The number of elements in each of the blocks of rows whose statistics the
+// CPU implementation of FusedBatchNorm computes separately, which fit in the
+// L2 cache, and the smallest number of rows of a block.
+static const int64 kStatisticsBlockElements = 1 << 14;
+static const int64 kMinStatisticsBlockRows = 16;
+
 // Functor used by FusedBatchNormOp to do the computations.
 template <typename Device, typename T, typename U>
 struct FusedBatchNorm;
@@ -62,74 +73,123 @@ struct FusedBatchNorm<CPUDevice, T, U> {
     OP_REQUIRES(context, tensor_format == FORMAT_NHWC,
                 errors::Internal("The CPU implementation of FusedBatchNorm "
                                  "only supports NHWC tensor format for now."));
-    typename TTypes<T, 4>::ConstTensor x(x_input.tensor<T, 4>());
-    typename TTypes<T>::ConstVec scale(scale_input.vec<T>());
-    typename TTypes<T>::ConstVec offset(offset_input.vec<T>());
-    typename TTypes<T>::ConstVec estimated_mean(estimated_mean_input.vec<T>());
-    typename TTypes<T>::ConstVec estimated_variance(
-        estimated_variance_input.vec<T>());
-    typename TTypes<T, 4>::Tensor y(y_output->tensor<T, 4>());
-    typename TTypes<T>::Vec batch_mean(batch_mean_output->vec<T>());
-    typename TTypes<T>::Vec batch_var(batch_var_output->vec<T>());
-    typename TTypes<T>::Vec saved_mean(saved_mean_output->vec<T>());
-    typename TTypes<T>::Vec saved_var(saved_var_output->vec<T>());
-
-    const CPUDevice& d = context->eigen_device<CPUDevice>();
-
-    const int depth = x.dimension(3);
-    const int size = x.size();
-    const int rest_size = size / depth;
-    Eigen::DSizes<Eigen::Index, 2> rest_by_depth(rest_size, depth);
-
-#if !defined(EIGEN_HAS_INDEX_LIST)
-    Eigen::DSizes<Eigen::Index, 2> one_by_depth(1, depth);
-    Eigen::array<int, 1> reduce_dims({0});
-    Eigen::array<int, 2> bcast_spec({rest_size, 1});
-#else
-    Eigen::IndexList<Eigen::type2index<1>, Eigen::Index> one_by_depth;
-    one_by_depth.set(1, depth);
-    Eigen::IndexList<Eigen::type2index<0> > reduce_dims;
-    Eigen::IndexList<Eigen::Index, Eigen::type2index<1> > bcast_spec;
-    bcast_spec.set(0, rest_size);
-#endif
-
-    auto x_rest_by_depth = x.reshape(rest_by_depth);
-    const int rest_size_minus_one = (rest_size > 1) ? (rest_size - 1) : 1;
-    T rest_size_inv = static_cast<T>(1.0f / static_cast<T>(rest_size));
+    const T* x = x_input.flat<T>().data();
+    const T* scale = scale_input.vec<T>().data();
+    const T* offset = offset_input.vec<T>().data();
+    T* y = y_output->flat<T>().data();
+
+    const int64 depth = x_input.dim_size(3);
+    const int64 rest_size = x_input.NumElements() / depth;
+    const double rest_size_inv = 1.0 / static_cast<double>(rest_size);
+    const int64 rest_size_minus_one = (rest_size > 1) ? (rest_size - 1) : 1;
     // This adjustment is for Bessel's correction
-    T rest_size_adjust =
-        static_cast<T>(rest_size) / static_cast<T>(rest_size_minus_one);
-
-    Eigen::Tensor<T, 1, Eigen::RowMajor> mean(depth);
-    Eigen::Tensor<T, 1, Eigen::RowMajor> variance(depth);
-    if (is_training) {
-      mean.device(d) = (x_rest_by_depth.sum(reduce_dims) * rest_size_inv);
-      batch_mean.device(d) = mean;
-      saved_mean.device(d) = mean;
-    } else {
-      mean.device(d) = estimated_mean;
-    }
+    const double rest_size_adjust = static_cast<double>(rest_size) /
+                                    static_cast<double>(rest_size_minus_one);
 
-    auto x_centered =
-        x_rest_by_depth - mean.reshape(one_by_depth).broadcast(bcast_spec);
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *(context->device()->tensorflow_cpu_worker_threads());
 
+    std::vector<T> mean(depth);
+    std::vector<T> variance(depth);
     if (is_training) {
-      variance.device(d) = x_centered.square().sum(reduce_dims) * rest_size_inv;
-      batch_var.device(d) = variance * rest_size_adjust;
-      saved_var.device(d) = variance;
+      // The mean and the sum of the squared deviations from it of each block
+      // of rows are computed in two passes over the block while it is in
+      // cache, and then merged, so that each element is read from memory
+      // once and the variance does not lose precision as the difference of
+      // two large sums would.
+      const int64 block_rows =
+          std::max<int64>(kMinStatisticsBlockRows,
+                          kStatisticsBlockElements / std::max<int64>(depth, 1));
+      const int64 num_blocks = (rest_size + block_rows - 1) / block_rows;
+      std::vector<T> block_mean(num_blocks * depth);
+      std::vector<T> block_m2(num_blocks * depth);
+      auto compute_block_statistics = [&](int64 start, int64 limit) {
+        for (int64 block = start; block < limit; ++block) {
+          const int64 begin_row = block * block_rows;
+          const int64 end_row = std::min(begin_row + block_rows, rest_size);
+          T* m = block_mean.data() + block * depth;
+          T* m2 = block_m2.data() + block * depth;
+          for (int64 row = begin_row; row < end_row; ++row) {
+            const T* x_row = x + row * depth;
+            for (int64 c = 0; c < depth; ++c) {
+              m[c] += x_row[c];
+            }
+          }
+          const T block_size_inv = T(1) / static_cast<T>(end_row - begin_row);
+          for (int64 c = 0; c < depth; ++c) {
+            m[c] *= block_size_inv;
+          }
+          for (int64 row = begin_row; row < end_row; ++row) {
+            const T* x_row = x + row * depth;
+            for (int64 c = 0; c < depth; ++c) {
+              const T deviation = x_row[c] - m[c];
+              m2[c] += deviation * deviation;
+            }
+          }
+        }
+      };
+      Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+            4 * block_rows * depth, compute_block_statistics);
+
+      auto merge_block_statistics = [&](int64 start, int64 limit) {
+        for (int64 c = start; c < limit; ++c) {
+          double count = 0;
+          double channel_mean = 0;
+          double channel_m2 = 0;
+          for (int64 block = 0; block < num_blocks; ++block) {
+            const double block_count =
+                std::min(block_rows, rest_size - block * block_rows);
+            const double delta = block_mean[block * depth + c] - channel_mean;
+            const double merged_count = count + block_count;
+            channel_mean += delta * block_count / merged_count;
+            channel_m2 += block_m2[block * depth + c] +
+                          delta * delta * count * block_count / merged_count;
+            count = merged_count;
+          }
+          mean[c] = static_cast<T>(channel_mean);
+          variance[c] = static_cast<T>(channel_m2 * rest_size_inv);
+        }
+      };
+      Shard(worker_threads.num_threads, worker_threads.workers, depth,
+            10 * num_blocks, merge_block_statistics);
+
+      typename TTypes<T>::Vec batch_mean(batch_mean_output->vec<T>());
+      typename TTypes<T>::Vec batch_var(batch_var_output->vec<T>());
+      typename TTypes<T>::Vec saved_mean(saved_mean_output->vec<T>());
+      typename TTypes<T>::Vec saved_var(saved_var_output->vec<T>());
+      for (int64 c = 0; c < depth; ++c) {
+        batch_mean(c) = mean[c];
+        saved_mean(c) = mean[c];
+        batch_var(c) = static_cast<T>(variance[c] * rest_size_adjust);
+        saved_var(c) = variance[c];
+      }
     } else {
-      variance.device(d) = estimated_variance;
+      typename TTypes<T>::ConstVec estimated_mean(
+          estimated_mean_input.vec<T>());
+      typename TTypes<T>::ConstVec estimated_variance(
+          estimated_variance_input.vec<T>());
+      for (int64 c = 0; c < depth; ++c) {
+        mean[c] = estimated_mean(c);
+        variance[c] = estimated_variance(c);
+      }
     }
 
-    auto scaling_factor = ((variance + epsilon).rsqrt() * scale)
-                              .eval()
-                              .reshape(one_by_depth)
-                              .broadcast(bcast_spec);
-    auto x_scaled = x_centered * scaling_factor;
-    auto x_shifted =
-        x_scaled + offset.reshape(one_by_depth).broadcast(bcast_spec);
-
-    y.reshape(rest_by_depth).device(d) = x_shifted;
+    std::vector<T> scaling_factor(depth);
+    for (int64 c = 0; c < depth; ++c) {
+      scaling_factor[c] = scale[c] / std::sqrt(variance[c] + epsilon);
+    }
+    // The channels are contiguous, so that the loop over them is vectorized.
+    auto normalize = [&](int64 start, int64 limit) {
+      for (int64 row = start; row < limit; ++row) {
+        const T* x_row = x + row * depth;
+        T* y_row = y + row * depth;
+        for (int64 c = 0; c < depth; ++c) {
+          y_row[c] = (x_row[c] - mean[c]) * scaling_factor[c] + offset[c];
+        }
+      }
+    };
+    Shard(worker_threads.num_threads, worker_threads.workers, rest_size,
+          4 * depth, normalize);
   }
 };
 
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cmath>
 #include <vector>
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/fake_input.h"
@@ -89,6 +90,67 @@ TEST_F(FusedBatchNormOpTest, Inference) {
   test::ExpectTensorNear<float>(expected, *GetOutput(0), 0.01);
 }
 
+TEST_F(FusedBatchNormOpTest, TrainingManyBlocks) {
+  TF_EXPECT_OK(NodeDefBuilder("batch_norm_op", "FusedBatchNorm")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("epsilon", 0.001)
+                   .Attr("is_training", true)
+                   .Finalize(node_def()));
+  TF_EXPECT_OK(InitOp());
+  // Enough rows for the statistics to be computed in several blocks, with a
+  // mean much larger than the deviations from it.
+  const int rows = 2 * 30 * 30;
+  const int depth = 64;
+  std::vector<float> x(rows * depth);
+  std::vector<double> mean(depth, 0);
+  for (int i = 0; i < rows; ++i) {
+    for (int c = 0; c < depth; ++c) {
+      x[i * depth + c] = 1000 * c + (i * 7 + c) % 11;
+      mean[c] += x[i * depth + c];
+    }
+  }
+  std::vector<double> variance(depth, 0);
+  for (int c = 0; c < depth; ++c) {
+    mean[c] /= rows;
+    for (int i = 0; i < rows; ++i) {
+      const double deviation = x[i * depth + c] - mean[c];
+      variance[c] += deviation * deviation;
+    }
+    variance[c] /= rows;
+  }
+  AddInputFromArray<float>(TensorShape({2, 30, 30, depth}), x);
+  AddInputFromArray<float>(TensorShape({depth}), std::vector<float>(depth, 2));
+  AddInputFromArray<float>(TensorShape({depth}), std::vector<float>(depth, 1));
+  AddInputFromArray<float>(TensorShape({0}), {});
+  AddInputFromArray<float>(TensorShape({0}), {});
+
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 30, 30, depth}));
+  auto expected_flat = expected.flat<float>();
+  for (int i = 0; i < rows; ++i) {
+    for (int c = 0; c < depth; ++c) {
+      expected_flat(i * depth + c) =
+          (x[i * depth + c] - mean[c]) * 2 / std::sqrt(variance[c] + 0.001) +
+          1;
+    }
+  }
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 0.01);
+
+  Tensor expected_mean(allocator(), DT_FLOAT, TensorShape({depth}));
+  Tensor expected_variance(allocator(), DT_FLOAT, TensorShape({depth}));
+  for (int c = 0; c < depth; ++c) {
+    expected_mean.flat<float>()(c) = mean[c];
+    expected_variance.flat<float>()(c) = variance[c] * rows / (rows - 1);
+  }
+  test::ExpectTensorNear<float>(expected_mean, *GetOutput(1), 1e-3);
+  test::ExpectTensorNear<float>(expected_variance, *GetOutput(2), 1e-3);
+}
+
 class FusedBatchNormGradOpTest : public OpsTestBase {};
 
 TEST_F(FusedBatchNormGradOpTest, Simple) {
@@ -0,0 +1,80 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_FUSED_BIAS_ACTIVATION_FUNCTOR_H_
+#define TENSORFLOW_KERNELS_FUSED_BIAS_ACTIVATION_FUNCTOR_H_
+// Functor definition for the bias and activation of _FusedConv2D and
+// _FusedMatMul, must be compilable by nvcc.
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+
+// The activations that the fused ops apply after their bias.
+enum class FusedActivation { kNone, kRelu, kRelu6 };
+
+// Parses the "activation" attr of the fused ops.
+inline Status FusedActivationFromString(const string& name,
+                                        FusedActivation* activation) {
+  if (name == "None") {
+    *activation = FusedActivation::kNone;
+  } else if (name == "Relu") {
+    *activation = FusedActivation::kRelu;
+  } else if (name == "Relu6") {
+    *activation = FusedActivation::kRelu6;
+  } else {
+    return errors::InvalidArgument("Unknown fused activation: ", name);
+  }
+  return Status::OK();
+}
+
+namespace functor {
+
+// Functor used by the fused ops to add their bias and apply their activation
+// in place, in a single pass over their output.
+template <typename Device, typename T>
+struct BiasActivation {
+  // output: [outer, channels, inner], e.g. [batch * rows * cols, channels, 1]
+  //         for NHWC and [batch, channels, rows * cols] for NCHW.
+  // bias: [channels].
+  void operator()(const Device& d, typename TTypes<T, 3>::Tensor output,
+                  typename TTypes<T>::ConstVec bias,
+                  FusedActivation activation) {
+    Eigen::DSizes<Eigen::DenseIndex, 3> bias_shape(1, output.dimension(1), 1);
+    Eigen::DSizes<Eigen::DenseIndex, 3> broadcast(output.dimension(0), 1,
+                                                  output.dimension(2));
+    auto biased = output + bias.reshape(bias_shape).broadcast(broadcast);
+    switch (activation) {
+      case FusedActivation::kNone:
+        output.device(d) = biased;
+        break;
+      case FusedActivation::kRelu:
+        output.device(d) = biased.cwiseMax(static_cast<T>(0));
+        break;
+      case FusedActivation::kRelu6:
+        output.device(d) = biased.cwiseMax(static_cast<T>(0))
+                               .cwiseMin(static_cast<T>(6));
+        break;
+    }
+  }
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_FUSED_BIAS_ACTIVATION_FUNCTOR_H_
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_KERNELS_GATHER_FUNCTOR_H_
 #define TENSORFLOW_KERNELS_GATHER_FUNCTOR_H_
 
+#include <algorithm>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 
 #include "tensorflow/core/framework/tensor_types.h"
@@ -24,6 +26,8 @@ limitations under the License.
 #include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
@@ -31,6 +35,22 @@ typedef Eigen::ThreadPoolDevice CPUDevice;
 
 namespace functor {
 
+// Returns the number of slices ahead of the one being copied whose params the
+// CPU gather prefetches, from TF_GATHER_PREFETCH_DISTANCE. 0 disables the
+// prefetches.
+inline int64 GatherPrefetchDistance() {
+  static const int64 distance = []() -> int64 {
+    int64 value;
+    Status s = ReadInt64FromEnvVar("TF_GATHER_PREFETCH_DISTANCE", 16, &value);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      return 16;
+    }
+    return std::max<int64>(value, 0);
+  }();
+  return distance;
+}
+
 // Helper method to copy using memcpy.
 template <typename T, typename Index, typename SliceIndex,
           SliceIndex static_slice_elems>
@@ -54,25 +74,42 @@ SliceIndex HandleCopies(OpKernelContext* ctx,
   mutex mu;
   // Store the value of invalidate index for printing error information, it's a shared variable.
   SliceIndex result = -1;
+  // Prefetches the cache lines of a slice of params, up to a few of them, so
+  // that the rows of a large table are fetched while earlier ones are copied.
+  const size_t prefetch_bytes = std::min<size_t>(slice_bytes, 256);
+  auto prefetch_slice = [&](SliceIndex b, SliceIndex i) {
+    const Index index = indices(i);
+    if (!FastBoundsCheck(index, limit)) return;
+    const char* slice = reinterpret_cast<const char*>(
+        params_base +
+        (b * static_cast<SliceIndex>(limit) + static_cast<SliceIndex>(index)) *
+            slice_elems);
+    for (size_t offset = 0; offset < prefetch_bytes; offset += 64) {
+      port::prefetch<port::PREFETCH_HINT_T0>(slice + offset);
+    }
+  };
+  const int64 prefetch_distance = GatherPrefetchDistance();
   auto work = [&] (int64 start, int64 end) {
     SliceIndex batch_idx = static_cast<SliceIndex>(start / indices_size);
     SliceIndex indices_idx = static_cast<SliceIndex>(start % indices_size);
-    SliceIndex batch_idx_end = static_cast<SliceIndex>(end / indices_size);
-    SliceIndex indices_idx_end = static_cast<SliceIndex>(end % indices_size);
-
-    while ((batch_idx < batch_idx_end) ||
-            (batch_idx == batch_idx_end && indices_idx < indices_idx_end)) {
-      SliceIndex i_next = indices_idx + 1;
-      SliceIndex b_next = batch_idx + 1;
-      if ((batch_idx == batch_idx_end && i_next < indices_idx_end) ||
-              (i_next < indices_size)) {
-        port::prefetch<port::PREFETCH_HINT_T0>(&params(batch_idx, indices(i_next), 0));
-        port::prefetch<port::PREFETCH_HINT_T0>(&out(batch_idx, i_next, 0));
-        b_next = batch_idx;
-      } else if (b_next <= batch_idx_end) {
-        port::prefetch<port::PREFETCH_HINT_T0>(&params(b_next, indices(0), 0));
-        port::prefetch<port::PREFETCH_HINT_T0>(&out(b_next, 0, 0));
-        i_next = 0;
+    // The slice "prefetch_distance" slices ahead, whose params are prefetched
+    // before the current one is copied.
+    const int64 ahead = std::min(start + prefetch_distance, end);
+    SliceIndex ahead_batch_idx = static_cast<SliceIndex>(ahead / indices_size);
+    SliceIndex ahead_indices_idx =
+        static_cast<SliceIndex>(ahead % indices_size);
+    for (int64 i = start; i < ahead; ++i) {
+      prefetch_slice(static_cast<SliceIndex>(i / indices_size),
+                     static_cast<SliceIndex>(i % indices_size));
+    }
+
+    for (int64 i = start; i < end; ++i) {
+      if (i + prefetch_distance < end) {
+        prefetch_slice(ahead_batch_idx, ahead_indices_idx);
+        if (++ahead_indices_idx == indices_size) {
+          ahead_indices_idx = 0;
+          ++ahead_batch_idx;
+        }
       }
       const Index index = internal::SubtleMustCopy(indices(indices_idx));
       if (!FastBoundsCheck(index, limit)) {
@@ -94,8 +131,10 @@ SliceIndex HandleCopies(OpKernelContext* ctx,
         // For non-"simple" types (e.g. strings).
         out.template chip<1>(indices_idx) = params.template chip<1>(index);
       }
-      indices_idx = i_next;
-      batch_idx = b_next;
+      if (++indices_idx == indices_size) {
+        indices_idx = 0;
+        ++batch_idx;
+      }
     }
   };
 
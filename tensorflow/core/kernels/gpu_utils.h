@@ -19,12 +19,14 @@ limitations under the License.
 #if GOOGLE_CUDA
 
 #include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/util/autotune_cache.h"
 
 namespace tensorflow {
 
@@ -47,21 +49,56 @@ inline perftools::gputools::DeviceMemory<T> AsDeviceMemory(const T* cuda_memory,
 // back and forth randomly, the expected number of experiments before autotune
 // settles is O(threshold ^ 2). So we recommend that number of warmup runs
 // for any benchmarks.
+//
+// If the environment variable TF_AUTOTUNE_CACHE_FILE names a file, the
+// accepted configs are also stored in it by AutotuneCache, and a params seen
+// for the first time takes its config from there, if another process on the
+// same kind of device has accepted one for it.
 template <typename Parameters, typename Config>
 class AutoTuneMap {
  public:
-  bool Find(const Parameters& params, Config* config) const {
-    mutex_lock lock(mu_);
-    auto iter = params_config_map_.find(params);
-    if (iter == params_config_map_.end() ||
-        (iter->second.score < min_score_threshold_ &&
-         iter->second.count <= max_autotune_count_)) {
+  bool Find(const Parameters& params, Config* config) {
+    {
+      mutex_lock lock(mu_);
+      auto iter = params_config_map_.find(params);
+      if (iter != params_config_map_.end()) {
+        if (iter->second.score < min_score_threshold_ &&
+            iter->second.count <= max_autotune_count_) {
+          return false;
+        }
+        *config = iter->second.config;
+        return true;
+      }
+    }
+    AutotuneCache* cache = AutotuneCache::Global();
+    std::vector<int64> values;
+    if (cache == nullptr || !cache->Find(PersistentKey(params), &values) ||
+        !AutotuneConfigFromValues(values, config)) {
       return false;
     }
-    *config = iter->second.config;
+    VLOG(1) << GetActionSummary("loads", params, *config);
+    mutex_lock lock(mu_);
+    params_config_map_.insert(std::make_pair(
+        params, ValueType{*config, min_score_threshold_, 1}));
     return true;
   }
   void Insert(const Parameters& params, const Config& config) {
+    if (InsertInMap(params, config)) {
+      AutotuneCache* cache = AutotuneCache::Global();
+      if (cache != nullptr) {
+        Status s = cache->Insert(PersistentKey(params),
+                                 AutotuneConfigToValues(config));
+        if (!s.ok()) {
+          LOG(WARNING) << "Failed to store the autotune result of " << name_
+                       << ": " << s;
+        }
+      }
+    }
+  }
+
+ private:
+  // Returns true if the map accepts "config" for "params".
+  bool InsertInMap(const Parameters& params, const Config& config) {
     mutex_lock lock(mu_);
     auto iter = params_config_map_.find(params);
     int new_score = 0;
@@ -92,10 +129,11 @@ class AutoTuneMap {
     }
     if (new_score >= min_score_threshold_) {
       VLOG(1) << GetActionSummary("accepts", params, config);
+      return true;
     }
+    return false;
   }
 
- private:
   AutoTuneMap(const string& name) : name_(name) {
     min_score_threshold_ = 1;
     int min_warmup_iterations = 10;
@@ -122,6 +160,21 @@ class AutoTuneMap {
     }
   };
 
+  // The key of "params" in AutotuneCache, which identifies the model of its
+  // device rather than its id.
+  string PersistentKey(const Parameters& params) {
+    string device = strings::StrCat("gpu_", params.device_id());
+    auto platform =
+        perftools::gputools::MultiPlatformManager::PlatformWithName("CUDA");
+    if (platform.ok()) {
+      auto executor =
+          platform.ValueOrDie()->ExecutorForDevice(params.device_id());
+      if (executor.ok()) device = AutotuneDeviceKey(executor.ValueOrDie());
+    }
+    return strings::StrCat(device, "/", name_, "/",
+                           params.ToStringWithoutDevice());
+  }
+
   string GetActionSummary(StringPiece action, const Parameters& params,
                           const Config& config) {
     return strings::Printf("autotune_map %s %s: %s -> (%s)", name_.c_str(),
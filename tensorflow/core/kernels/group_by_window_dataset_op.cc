@@ -39,6 +39,11 @@ class GroupByWindowDatasetOp : public UnaryDatasetOpKernel {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("window_size_func", &window_size_func_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr("max_buffered_bytes", &max_buffered_bytes_));
+    OP_REQUIRES(ctx, max_buffered_bytes_ >= 0,
+                errors::InvalidArgument(
+                    "max_buffered_bytes must be greater than or equal to 0."));
   }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
@@ -91,7 +96,8 @@ class GroupByWindowDatasetOp : public UnaryDatasetOpKernel {
 
     *output = new Dataset(
         input, std::move(captured_key_func), std::move(captured_reduce_func),
-        std::move(captured_window_size_func), output_types_, output_shapes_);
+        std::move(captured_window_size_func), max_buffered_bytes_,
+        output_types_, output_shapes_);
   }
 
  private:
@@ -101,12 +107,13 @@ class GroupByWindowDatasetOp : public UnaryDatasetOpKernel {
             std::unique_ptr<CapturedFunction> captured_key_func,
             std::unique_ptr<CapturedFunction> captured_reduce_func,
             std::unique_ptr<CapturedFunction> captured_window_size_func,
-            const DataTypeVector& output_types,
+            int64 max_buffered_bytes, const DataTypeVector& output_types,
             const std::vector<PartialTensorShape>& output_shapes)
         : input_(input),
           captured_key_func_(std::move(captured_key_func)),
           captured_reduce_func_(std::move(captured_reduce_func)),
           captured_window_size_func_(std::move(captured_window_size_func)),
+          max_buffered_bytes_(max_buffered_bytes),
           output_types_(output_types),
           output_shapes_(output_shapes) {
       input_->Ref();
@@ -226,6 +233,13 @@ class GroupByWindowDatasetOp : public UnaryDatasetOpKernel {
 
               const int64 window_size = window_sizes_[key];
 
+              int64 element_bytes = 0;
+              for (const Tensor& t : next_input_element) {
+                element_bytes += t.TotalBytes();
+              }
+              group_bytes_[key] += element_bytes;
+              buffered_bytes_ += element_bytes;
+
               std::vector<std::vector<Tensor>>& group = groups_[key];
               group.push_back(std::move(next_input_element));
 
@@ -233,6 +247,23 @@ class GroupByWindowDatasetOp : public UnaryDatasetOpKernel {
                 TF_RETURN_IF_ERROR(StartFlushingGroup(ctx, key));
                 break;
               }
+
+              if (dataset()->max_buffered_bytes_ > 0 &&
+                  buffered_bytes_ > dataset()->max_buffered_bytes_) {
+                // The open windows hold more than the budget allows, so
+                // flush the window that holds the most bytes before it is
+                // full, because that frees the most memory.
+                int64 fullest_key = key;
+                int64 fullest_bytes = group_bytes_[key];
+                for (const auto& entry : group_bytes_) {
+                  if (entry.second > fullest_bytes) {
+                    fullest_key = entry.first;
+                    fullest_bytes = entry.second;
+                  }
+                }
+                TF_RETURN_IF_ERROR(StartFlushingGroup(ctx, fullest_key));
+                break;
+              }
             }
           }
 
@@ -270,6 +301,8 @@ class GroupByWindowDatasetOp : public UnaryDatasetOpKernel {
             std::move(groups_[key]), dataset()->input_->output_dtypes(),
             dataset()->input_->output_shapes(), &group_dataset));
         groups_.erase(key);
+        buffered_bytes_ -= group_bytes_[key];
+        group_bytes_.erase(key);
 
         Tensor key_arg(DT_INT64, TensorShape({}));
         key_arg.scalar<int64>()() = key;
@@ -311,6 +344,10 @@ class GroupByWindowDatasetOp : public UnaryDatasetOpKernel {
       std::map<int64, std::vector<std::vector<Tensor>>> groups_ GUARDED_BY(mu_);
       std::unique_ptr<IteratorBase> current_group_iterator_ GUARDED_BY(mu_);
       std::map<int64, int64> window_sizes_ GUARDED_BY(mu_);
+      // The total size of the elements in each group in `groups_`, and in all
+      // groups.
+      std::map<int64, int64> group_bytes_ GUARDED_BY(mu_);
+      int64 buffered_bytes_ GUARDED_BY(mu_) = 0;
     };
 
     // A resource name for the temporary window dataset that is
@@ -321,6 +358,7 @@ class GroupByWindowDatasetOp : public UnaryDatasetOpKernel {
     const std::unique_ptr<CapturedFunction> captured_key_func_;
     const std::unique_ptr<CapturedFunction> captured_reduce_func_;
     const std::unique_ptr<CapturedFunction> captured_window_size_func_;
+    const int64 max_buffered_bytes_;
     const DataTypeVector output_types_;
     const std::vector<PartialTensorShape> output_shapes_;
   };
@@ -331,6 +369,7 @@ class GroupByWindowDatasetOp : public UnaryDatasetOpKernel {
   NameAttrList key_func_;
   NameAttrList reduce_func_;
   NameAttrList window_size_func_;
+  int64 max_buffered_bytes_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("GroupByWindowDataset").Device(DEVICE_CPU),
@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/framework/iterator.pb.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_op_kernel.h"
+#include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/variant_op_registry.h"
 #include "tensorflow/core/graph/graph_constructor.h"
@@ -82,7 +83,8 @@ class IteratorResource : public ResourceBase {
                    const std::vector<PartialTensorShape>& output_shapes)
       : iterator_(nullptr),
         output_dtypes_(output_dtypes),
-        output_shapes_(output_shapes) {}
+        output_shapes_(output_shapes),
+        stats_collector_(std::make_shared<dataset::StatsCollector>()) {}
 
   Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
                  bool* end_of_sequence) {
@@ -162,10 +164,17 @@ class IteratorResource : public ResourceBase {
     return output_shapes_;
   }
 
+  // The collector for the statistics of this iterator's pipeline. It is
+  // shared with the iterator contexts, which may outlive this resource.
+  const std::shared_ptr<dataset::StatsCollector>& stats_collector() const {
+    return stats_collector_;
+  }
+
  private:
   std::shared_ptr<IteratorBase> iterator_;
   const DataTypeVector output_dtypes_;
   const std::vector<PartialTensorShape> output_shapes_;
+  const std::shared_ptr<dataset::StatsCollector> stats_collector_;
 };
 
 // Helper class for reading data from a VariantTensorData object.
@@ -647,6 +656,7 @@ class IteratorGetNextOp : public AsyncOpKernel {
       params.step_id = ctx->step_id();
       params.resource_manager = ctx->resource_manager();
       params.runner = *(ctx->runner());
+      params.stats_collector = iterator->stats_collector();
       IteratorContext iter_ctx(std::move(params));
 
       OP_REQUIRES_OK_ASYNC(
@@ -797,6 +807,27 @@ class DeserializeIteratorOp : public OpKernel {
   }
 };
 
+class IteratorGetStatsOp : public OpKernel {
+ public:
+  explicit IteratorGetStatsOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    IteratorResource* iterator_resource;
+    OP_REQUIRES_OK(
+        ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &iterator_resource));
+    core::ScopedUnref unref_iterator(iterator_resource);
+
+    dataset::StatsCollector* stats = iterator_resource->stats_collector().get();
+    stats->Enable();
+    Summary summary;
+    stats->AddToSummary(&summary);
+    Tensor* summary_t;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &summary_t));
+    OP_REQUIRES(ctx, summary.SerializeToString(&summary_t->scalar<string>()()),
+                errors::Internal("Unable to serialize the iterator stats."));
+  }
+};
+
 REGISTER_KERNEL_BUILDER(Name("Iterator").Device(DEVICE_CPU), IteratorHandleOp);
 REGISTER_KERNEL_BUILDER(Name("MakeIterator").Device(DEVICE_CPU),
                         MakeIteratorOp);
@@ -814,6 +845,8 @@ REGISTER_KERNEL_BUILDER(Name("SerializeIterator").Device(DEVICE_CPU),
                         SerializeIteratorOp);
 REGISTER_KERNEL_BUILDER(Name("DeserializeIterator").Device(DEVICE_CPU),
                         DeserializeIteratorOp);
+REGISTER_KERNEL_BUILDER(Name("IteratorGetStats").Device(DEVICE_CPU),
+                        IteratorGetStatsOp);
 
 }  // namespace
 
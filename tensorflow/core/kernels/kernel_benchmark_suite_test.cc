@@ -0,0 +1,482 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks of the kernels that dominate the step time of common models,
+// swept over shapes taken from those models and over intra-op thread counts.
+//
+// Every benchmark takes a (shape index, thread count) argument pair and
+// labels its result with the shape it ran, so that results stay comparable
+// across versions.  Like all benchmarks, each result is written as a
+// BenchmarkEntries proto (see tensorflow/core/util/test_log.proto) when
+// TEST_REPORT_FILE_PREFIX is set, with the label and the measured bytes and
+// items per second in its extras:
+//
+//   TEST_REPORT_FILE_PREFIX=/tmp/kernels_ bazel run --config opt \
+//     //tensorflow/core/kernels:kernel_benchmark_suite_test -- \
+//     --benchmarks=all
+//
+// Items are floating point operations for MatMul and convolutions, output
+// elements for the memory bound kernels, and examples for parsing.
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+const int kThreadCounts[] = {1, 4, 16};
+
+// Registers every shape of a table of kNumShapes with every thread count.
+template <int kNumShapes>
+void ShapesAndThreads(testing::Benchmark* b) {
+  for (int shape = 0; shape < kNumShapes; ++shape) {
+    for (int threads : kThreadCounts) {
+      b->ArgPair(shape, threads);
+    }
+  }
+}
+
+#define SHAPES_AND_THREADS(shapes) ShapesAndThreads<TF_ARRAYSIZE(shapes)>
+
+// Runs 'g' 'iters' times on the CPU with 'threads' intra-op threads.
+void RunGraph(Graph* g, int iters, int threads) {
+  SessionOptions options;
+  options.config.set_intra_op_parallelism_threads(threads);
+  options.config.set_inter_op_parallelism_threads(1);
+  test::Benchmark("cpu", g, &options).Run(iters);
+}
+
+Node* RandomFloatConstant(Graph* g, const TensorShape& shape) {
+  Tensor t(DT_FLOAT, shape);
+  t.flat<float>().setRandom();
+  return test::graph::Constant(g, t);
+}
+
+Node* Int32Constant(Graph* g, const std::vector<int32>& values) {
+  return test::graph::Constant(g, test::AsTensor<int32>(values));
+}
+
+// MATMUL *********************************************************************
+
+struct MatMulShape {
+  int m;
+  int k;
+  int n;
+};
+
+// Fully connected layers and RNN cells, at inference and training batch
+// sizes.
+const MatMulShape kMatMulShapes[] = {
+    {1, 1024, 1024},   {32, 1024, 1024},  {128, 1024, 4096},
+    {128, 4096, 1024}, {256, 2048, 2048}, {2048, 512, 512},
+};
+
+void BM_MatMul(int iters, int shape_index, int threads) {
+  testing::StopTiming();
+  const MatMulShape& shape = kMatMulShapes[shape_index];
+  testing::ItemsProcessed(static_cast<int64>(iters) * 2 * shape.m * shape.k *
+                          shape.n);
+  testing::SetLabel(strings::StrCat("m=", shape.m, " k=", shape.k,
+                                    " n=", shape.n, " threads=", threads));
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Matmul(g, RandomFloatConstant(g, {shape.m, shape.k}),
+                      RandomFloatConstant(g, {shape.k, shape.n}), false,
+                      false);
+  RunGraph(g, iters, threads);
+}
+BENCHMARK(BM_MatMul)->Apply(SHAPES_AND_THREADS(kMatMulShapes));
+
+// CONV2D AND DEPTHWISE CONV2D ************************************************
+
+struct ConvShape {
+  int batch;
+  int rows;
+  int cols;
+  int depth;
+  int filter_rows;
+  int filter_cols;
+  // The output depth for Conv2D, the depth multiplier for depthwise
+  // convolutions.
+  int filter_count;
+  int stride;
+};
+
+// Layers of ResNet-50 and Inception.
+const ConvShape kConv2DShapes[] = {
+    {32, 224, 224, 3, 7, 7, 64, 2},   {32, 56, 56, 64, 1, 1, 256, 1},
+    {32, 56, 56, 64, 3, 3, 64, 1},    {32, 28, 28, 128, 3, 3, 128, 1},
+    {32, 14, 14, 256, 3, 3, 256, 1},  {32, 14, 14, 1024, 1, 1, 256, 1},
+    {32, 7, 7, 512, 3, 3, 512, 1},    {1, 56, 56, 64, 3, 3, 64, 1},
+};
+
+// Layers of MobileNet.
+const ConvShape kDepthwiseConv2DShapes[] = {
+    {32, 112, 112, 32, 3, 3, 1, 1}, {32, 112, 112, 64, 3, 3, 1, 2},
+    {32, 56, 56, 128, 3, 3, 1, 1},  {32, 28, 28, 256, 3, 3, 1, 1},
+    {32, 14, 14, 512, 3, 3, 1, 1},  {32, 7, 7, 1024, 3, 3, 1, 1},
+    {1, 112, 112, 32, 3, 3, 1, 1},
+};
+
+// Sets the label and the operation count of a convolution with SAME padding
+// whose output has 'out_depth' channels, each summing 'depth_per_output'
+// input channels.
+void SetConvLabelAndItems(const ConvShape& shape, int iters, int threads,
+                          int out_depth, int depth_per_output) {
+  const int64 out_rows = (shape.rows + shape.stride - 1) / shape.stride;
+  const int64 out_cols = (shape.cols + shape.stride - 1) / shape.stride;
+  testing::ItemsProcessed(static_cast<int64>(iters) * 2 * shape.batch *
+                          out_rows * out_cols * out_depth * shape.filter_rows *
+                          shape.filter_cols * depth_per_output);
+  testing::SetLabel(strings::StrCat(
+      "input=", shape.batch, "x", shape.rows, "x", shape.cols, "x",
+      shape.depth, " filter=", shape.filter_rows, "x", shape.filter_cols, "x",
+      shape.filter_count, " stride=", shape.stride, " threads=", threads));
+}
+
+void BM_Conv2D(int iters, int shape_index, int threads) {
+  testing::StopTiming();
+  const ConvShape& shape = kConv2DShapes[shape_index];
+  SetConvLabelAndItems(shape, iters, threads, shape.filter_count,
+                       shape.depth);
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* input = RandomFloatConstant(
+      g, {shape.batch, shape.rows, shape.cols, shape.depth});
+  Node* filter = RandomFloatConstant(g, {shape.filter_rows, shape.filter_cols,
+                                         shape.depth, shape.filter_count});
+  Node* conv;
+  TF_CHECK_OK(NodeBuilder(g->NewName("conv"), "Conv2D")
+                  .Input(input)
+                  .Input(filter)
+                  .Attr("T", DT_FLOAT)
+                  .Attr("strides", {1, shape.stride, shape.stride, 1})
+                  .Attr("padding", "SAME")
+                  .Finalize(g, &conv));
+  RunGraph(g, iters, threads);
+}
+BENCHMARK(BM_Conv2D)->Apply(SHAPES_AND_THREADS(kConv2DShapes));
+
+void BM_DepthwiseConv2D(int iters, int shape_index, int threads) {
+  testing::StopTiming();
+  const ConvShape& shape = kDepthwiseConv2DShapes[shape_index];
+  SetConvLabelAndItems(shape, iters, threads,
+                       shape.depth * shape.filter_count, 1);
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* input = RandomFloatConstant(
+      g, {shape.batch, shape.rows, shape.cols, shape.depth});
+  Node* filter = RandomFloatConstant(g, {shape.filter_rows, shape.filter_cols,
+                                         shape.depth, shape.filter_count});
+  Node* conv;
+  TF_CHECK_OK(NodeBuilder(g->NewName("depthwise"), "DepthwiseConv2dNative")
+                  .Input(input)
+                  .Input(filter)
+                  .Attr("T", DT_FLOAT)
+                  .Attr("strides", {1, shape.stride, shape.stride, 1})
+                  .Attr("padding", "SAME")
+                  .Finalize(g, &conv));
+  RunGraph(g, iters, threads);
+}
+BENCHMARK(BM_DepthwiseConv2D)
+    ->Apply(SHAPES_AND_THREADS(kDepthwiseConv2DShapes));
+
+// REDUCTIONS *****************************************************************
+
+struct ReductionShape {
+  int rows;
+  int cols;
+  // The axis to reduce, or -1 to reduce both.
+  int axis;
+};
+
+// Row and column reductions of activations, and losses over whole batches.
+const ReductionShape kReductionShapes[] = {
+    {1024, 1024, 1}, {1024, 1024, 0}, {128, 65536, 1}, {65536, 128, 0},
+    {8192, 32, 1},   {32, 8192, 0},   {1024, 1024, -1},
+};
+
+void Reduction(const string& op, int iters, int shape_index, int threads) {
+  testing::StopTiming();
+  const ReductionShape& shape = kReductionShapes[shape_index];
+  const int64 num_elements = static_cast<int64>(shape.rows) * shape.cols;
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_elements);
+  testing::BytesProcessed(static_cast<int64>(iters) * num_elements *
+                          sizeof(float));
+  testing::SetLabel(strings::StrCat("input=", shape.rows, "x", shape.cols,
+                                    " axis=", shape.axis,
+                                    " threads=", threads));
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* axes = shape.axis < 0 ? Int32Constant(g, {0, 1})
+                              : Int32Constant(g, {shape.axis});
+  test::graph::Reduce(g, op, RandomFloatConstant(g, {shape.rows, shape.cols}),
+                      axes);
+  RunGraph(g, iters, threads);
+}
+
+void BM_Sum(int iters, int shape_index, int threads) {
+  Reduction("Sum", iters, shape_index, threads);
+}
+BENCHMARK(BM_Sum)->Apply(SHAPES_AND_THREADS(kReductionShapes));
+
+void BM_Max(int iters, int shape_index, int threads) {
+  Reduction("Max", iters, shape_index, threads);
+}
+BENCHMARK(BM_Max)->Apply(SHAPES_AND_THREADS(kReductionShapes));
+
+// GATHER *********************************************************************
+
+struct GatherShape {
+  int params_rows;
+  int params_cols;
+  int num_indices;
+};
+
+// Embedding lookups.
+const GatherShape kGatherShapes[] = {
+    {100000, 64, 4096},  {100000, 512, 1024}, {1000000, 32, 32768},
+    {10000, 1024, 256},  {50000, 128, 65536},
+};
+
+void BM_Gather(int iters, int shape_index, int threads) {
+  testing::StopTiming();
+  const GatherShape& shape = kGatherShapes[shape_index];
+  const int64 num_elements =
+      static_cast<int64>(shape.num_indices) * shape.params_cols;
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_elements);
+  testing::BytesProcessed(static_cast<int64>(iters) * num_elements *
+                          sizeof(float));
+  testing::SetLabel(strings::StrCat("params=", shape.params_rows, "x",
+                                    shape.params_cols,
+                                    " indices=", shape.num_indices,
+                                    " threads=", threads));
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  std::vector<int32> indices(shape.num_indices);
+  for (int32& index : indices) index = rnd.Uniform(shape.params_rows);
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Gather(
+      g, RandomFloatConstant(g, {shape.params_rows, shape.params_cols}),
+      Int32Constant(g, indices), Int32Constant(g, {0}));
+  RunGraph(g, iters, threads);
+}
+BENCHMARK(BM_Gather)->Apply(SHAPES_AND_THREADS(kGatherShapes));
+
+// TRANSPOSE ******************************************************************
+
+struct TransposeShape {
+  int rank;
+  int64 dims[4];
+  int32 perm[4];
+};
+
+// Layout changes between NHWC and NCHW, matrix transposes, and swapping the
+// batch and time dimensions of sequences.
+const TransposeShape kTransposeShapes[] = {
+    {4, {32, 56, 56, 64}, {0, 3, 1, 2}}, {4, {32, 64, 56, 56}, {0, 2, 3, 1}},
+    {4, {32, 7, 7, 512}, {0, 3, 1, 2}},  {2, {1024, 1024}, {1, 0}},
+    {2, {128, 4096}, {1, 0}},            {3, {64, 128, 256}, {1, 0, 2}},
+    {3, {64, 128, 256}, {0, 2, 1}},
+};
+
+void BM_Transpose(int iters, int shape_index, int threads) {
+  testing::StopTiming();
+  const TransposeShape& shape = kTransposeShapes[shape_index];
+  const TensorShape input_shape(
+      gtl::ArraySlice<int64>(shape.dims, shape.rank));
+  const std::vector<int32> perm(shape.perm, shape.perm + shape.rank);
+  testing::ItemsProcessed(static_cast<int64>(iters) *
+                          input_shape.num_elements());
+  testing::BytesProcessed(static_cast<int64>(iters) *
+                          input_shape.num_elements() * sizeof(float));
+  testing::SetLabel(strings::StrCat("input=", input_shape.DebugString(),
+                                    " perm=[", str_util::Join(perm, ","),
+                                    "] threads=", threads));
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* transpose;
+  TF_CHECK_OK(NodeBuilder(g->NewName("transpose"), "Transpose")
+                  .Input(RandomFloatConstant(g, input_shape))
+                  .Input(Int32Constant(g, perm))
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &transpose));
+  RunGraph(g, iters, threads);
+}
+BENCHMARK(BM_Transpose)->Apply(SHAPES_AND_THREADS(kTransposeShapes));
+
+// CAST ***********************************************************************
+
+struct CastShape {
+  DataType src;
+  DataType dst;
+  int num_elements;
+};
+
+// Mixed precision training, and decoded images and ids fed to models.
+const CastShape kCastShapes[] = {
+    {DT_FLOAT, DT_HALF, 1 << 20},     {DT_HALF, DT_FLOAT, 1 << 20},
+    {DT_FLOAT, DT_BFLOAT16, 1 << 20}, {DT_UINT8, DT_FLOAT, 1 << 20},
+    {DT_INT32, DT_FLOAT, 1 << 20},    {DT_INT64, DT_INT32, 1 << 20},
+    {DT_FLOAT, DT_HALF, 1 << 12},
+};
+
+void BM_Cast(int iters, int shape_index, int threads) {
+  testing::StopTiming();
+  const CastShape& shape = kCastShapes[shape_index];
+  testing::ItemsProcessed(static_cast<int64>(iters) * shape.num_elements);
+  testing::BytesProcessed(static_cast<int64>(iters) * shape.num_elements *
+                          (DataTypeSize(shape.src) + DataTypeSize(shape.dst)));
+  testing::SetLabel(strings::StrCat(
+      DataTypeString(shape.src), "->", DataTypeString(shape.dst),
+      " elements=", shape.num_elements, " threads=", threads));
+  Tensor input(shape.src, TensorShape({shape.num_elements}));
+  memset(const_cast<char*>(input.tensor_data().data()), 0,
+         input.TotalBytes());
+  Graph* g = new Graph(OpRegistry::Global());
+  test::graph::Cast(g, test::graph::Constant(g, input), shape.dst);
+  RunGraph(g, iters, threads);
+}
+BENCHMARK(BM_Cast)->Apply(SHAPES_AND_THREADS(kCastShapes));
+
+// SOFTMAX ********************************************************************
+
+struct SoftmaxShape {
+  int batch;
+  int classes;
+};
+
+// Classifiers over ImageNet and language model vocabularies, and attention
+// over short sequences.
+const SoftmaxShape kSoftmaxShapes[] = {
+    {32, 1000}, {128, 1000}, {256, 10000}, {64, 50000}, {8192, 32},
+};
+
+void BM_Softmax(int iters, int shape_index, int threads) {
+  testing::StopTiming();
+  const SoftmaxShape& shape = kSoftmaxShapes[shape_index];
+  const int64 num_elements = static_cast<int64>(shape.batch) * shape.classes;
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_elements);
+  testing::BytesProcessed(static_cast<int64>(iters) * num_elements *
+                          sizeof(float));
+  testing::SetLabel(strings::StrCat("logits=", shape.batch, "x",
+                                    shape.classes, " threads=", threads));
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* softmax;
+  TF_CHECK_OK(NodeBuilder(g->NewName("softmax"), "Softmax")
+                  .Input(RandomFloatConstant(g, {shape.batch, shape.classes}))
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &softmax));
+  RunGraph(g, iters, threads);
+}
+BENCHMARK(BM_Softmax)->Apply(SHAPES_AND_THREADS(kSoftmaxShapes));
+
+// PARSE EXAMPLE **************************************************************
+
+struct ParseExampleShape {
+  int batch_size;
+  // Fixed length float features.
+  int num_dense;
+  int dense_size;
+  // Variable length int64 features, such as ids to look up embeddings for.
+  int num_sparse;
+  int sparse_size;
+};
+
+// Input pipelines of ranking and recommendation models.
+const ParseExampleShape kParseExampleShapes[] = {
+    {128, 10, 1, 0, 0},   {128, 100, 1, 0, 0}, {512, 10, 16, 0, 0},
+    {128, 0, 0, 10, 10},  {256, 20, 1, 20, 5}, {1024, 4, 4, 4, 4},
+};
+
+void BM_ParseExample(int iters, int shape_index, int threads) {
+  testing::StopTiming();
+  const ParseExampleShape& shape = kParseExampleShapes[shape_index];
+
+  Example example;
+  auto& features = *example.mutable_features()->mutable_feature();
+  for (int i = 0; i < shape.num_dense; ++i) {
+    auto* values =
+        features[strings::StrCat("dense_", i)].mutable_float_list();
+    for (int j = 0; j < shape.dense_size; ++j) values->add_value(j * 0.5f);
+  }
+  for (int i = 0; i < shape.num_sparse; ++i) {
+    auto* values =
+        features[strings::StrCat("sparse_", i)].mutable_int64_list();
+    for (int j = 0; j < shape.sparse_size; ++j) values->add_value(j * 1009);
+  }
+  Tensor serialized(DT_STRING, TensorShape({shape.batch_size}));
+  int64 serialized_bytes = 0;
+  for (int b = 0; b < shape.batch_size; ++b) {
+    CHECK(example.SerializeToString(&serialized.vec<string>()(b)));
+    serialized_bytes += serialized.vec<string>()(b).size();
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * shape.batch_size);
+  testing::BytesProcessed(static_cast<int64>(iters) * serialized_bytes);
+  testing::SetLabel(strings::StrCat(
+      "batch=", shape.batch_size, " dense=", shape.num_dense, "x",
+      shape.dense_size, " sparse=", shape.num_sparse, "x", shape.sparse_size,
+      " threads=", threads));
+
+  Graph* g = new Graph(OpRegistry::Global());
+  std::vector<NodeBuilder::NodeOut> sparse_keys;
+  std::vector<NodeBuilder::NodeOut> dense_keys;
+  std::vector<NodeBuilder::NodeOut> dense_defaults;
+  std::vector<DataType> sparse_types;
+  std::vector<PartialTensorShape> dense_shapes;
+  for (int i = 0; i < shape.num_dense; ++i) {
+    dense_keys.emplace_back(test::graph::Constant(
+        g, test::AsScalar<string>(strings::StrCat("dense_", i))));
+    Tensor dense_default(DT_FLOAT, TensorShape({shape.dense_size}));
+    dense_default.flat<float>().setZero();
+    dense_defaults.emplace_back(test::graph::Constant(g, dense_default));
+    dense_shapes.push_back(PartialTensorShape({shape.dense_size}));
+  }
+  for (int i = 0; i < shape.num_sparse; ++i) {
+    sparse_keys.emplace_back(test::graph::Constant(
+        g, test::AsScalar<string>(strings::StrCat("sparse_", i))));
+    sparse_types.push_back(DT_INT64);
+  }
+  Node* parse;
+  TF_CHECK_OK(NodeBuilder(g->NewName("parse"), "ParseExample")
+                  .Input(test::graph::Constant(g, serialized))
+                  .Input(test::graph::Constant(
+                      g, Tensor(DT_STRING, TensorShape({0}))))
+                  .Input(sparse_keys)
+                  .Input(dense_keys)
+                  .Input(dense_defaults)
+                  .Attr("sparse_types", sparse_types)
+                  .Attr("dense_shapes", dense_shapes)
+                  .Finalize(g, &parse));
+  RunGraph(g, iters, threads);
+}
+BENCHMARK(BM_ParseExample)->Apply(SHAPES_AND_THREADS(kParseExampleShapes));
+
+#undef SHAPES_AND_THREADS
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,426 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/data_flow_ops.cc.
+
+#include "tensorflow/core/kernels/lock_free_fifo_queue.h"
+
+#include <iterator>
+#include <utility>
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Counts an attempt that is about to be added to an attempt list.
+//
+// The fence pairs with the one in LockFreeFIFOQueue::NotifyWaiters(): either
+// the attempt, once added, sees the change that a fast-path operation made to
+// the ring buffer, or that operation sees the count and flushes the attempt.
+void AddWaiter(std::atomic<int64>* waiters) {
+  waiters->fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void RemoveWaiter(std::atomic<int64>* waiters) { waiters->fetch_sub(1); }
+
+}  // namespace
+
+LockFreeFIFOQueue::LockFreeFIFOQueue(
+    int32 capacity, const DataTypeVector& component_dtypes,
+    const std::vector<TensorShape>& component_shapes, const string& name)
+    : QueueBase(capacity, component_dtypes, component_shapes, name),
+      ring_(capacity),
+      enqueue_waiters_(0),
+      dequeue_waiters_(0) {
+  DCHECK(capacity <= kMaxCapacity);
+}
+
+Status LockFreeFIFOQueue::Initialize() {
+  if (component_dtypes_.empty()) {
+    return errors::InvalidArgument("Empty component types for queue ", name_);
+  }
+  if (!component_shapes_.empty() &&
+      component_dtypes_.size() != component_shapes_.size()) {
+    return errors::InvalidArgument(
+        "Different number of component types.  ", "Types: ",
+        DataTypeSliceString(component_dtypes_), ", Shapes: ",
+        ShapeListString(component_shapes_));
+  }
+  return Status::OK();
+}
+
+void LockFreeFIFOQueue::NotifyWaiters(const std::atomic<int64>& waiters) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiters.load(std::memory_order_relaxed) > 0) {
+    FlushUnlocked();
+  }
+}
+
+bool LockFreeFIFOQueue::TryEnqueueFast(std::vector<Tuple>* elements,
+                                       bool* closed) {
+  if (enqueue_waiters_.load(std::memory_order_relaxed) > 0) return false;
+  const size_t count = elements->size();
+  if (ring_.TryPushMany(elements->data(), count, count, closed) < count) {
+    return false;
+  }
+  NotifyWaiters(dequeue_waiters_);
+  return true;
+}
+
+bool LockFreeFIFOQueue::TryDequeueFast(std::vector<Tuple>* elements) {
+  // Once the queue is closed every dequeue takes the slow path, which also
+  // looks at restored_.
+  if (dequeue_waiters_.load(std::memory_order_relaxed) > 0 || ring_.closed()) {
+    return false;
+  }
+  const size_t count = elements->size();
+  if (ring_.TryPopMany(count, count, elements->data()) < count) {
+    return false;
+  }
+  NotifyWaiters(enqueue_waiters_);
+  return true;
+}
+
+/* static */
+Status LockFreeFIFOQueue::SplitBatch(const Tuple& tuple, OpKernelContext* ctx,
+                                     std::vector<Tuple>* elements) {
+  const int64 batch_size = tuple[0].dim_size(0);
+  elements->resize(batch_size);
+  for (int64 index = 0; index < batch_size; ++index) {
+    (*elements)[index].reserve(tuple.size());
+  }
+  for (size_t i = 0; i < tuple.size(); ++i) {
+    TensorShape element_shape(tuple[i].shape());
+    element_shape.RemoveDim(0);
+    for (int64 index = 0; index < batch_size; ++index) {
+      Tensor element;
+      TF_RETURN_IF_ERROR(
+          ctx->allocate_temp(tuple[i].dtype(), element_shape, &element));
+      TF_RETURN_IF_ERROR(CopySliceToElement(tuple[i], &element, index));
+      (*elements)[index].push_back(std::move(element));
+    }
+  }
+  return Status::OK();
+}
+
+Status LockFreeFIFOQueue::StackElements(const std::vector<Tuple>& elements,
+                                        OpKernelContext* ctx, Tuple* batch) {
+  const int64 batch_size = elements.size();
+  batch->clear();
+  batch->reserve(num_components());
+  for (int i = 0; i < num_components(); ++i) {
+    Tensor component;
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        component_dtypes_[i], ManyOutShape(i, batch_size), &component));
+    for (int64 index = 0; index < batch_size; ++index) {
+      TF_RETURN_IF_ERROR(
+          CopyElementToSlice(elements[index][i], &component, index));
+    }
+    batch->push_back(std::move(component));
+  }
+  return Status::OK();
+}
+
+void LockFreeFIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
+                                   DoneCallback callback) {
+  std::vector<Tuple> elements(1, tuple);
+  bool closed = false;
+  if (TryEnqueueFast(&elements, &closed)) {
+    callback();
+  } else if (closed) {
+    ctx->SetStatus(errors::Cancelled("FIFOQueue '", name_, "' is closed."));
+    callback();
+  } else {
+    EnqueueSlow(std::move(elements), ctx, std::move(callback));
+  }
+}
+
+void LockFreeFIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
+                                       DoneCallback callback) {
+  const int64 batch_size = tuple[0].dim_size(0);
+  if (batch_size == 0) {
+    callback();
+    return;
+  }
+  std::vector<Tuple> elements;
+  Status s = SplitBatch(tuple, ctx, &elements);
+  if (!s.ok()) {
+    ctx->SetStatus(s);
+    callback();
+    return;
+  }
+  bool closed = false;
+  if (TryEnqueueFast(&elements, &closed)) {
+    callback();
+  } else if (closed) {
+    ctx->SetStatus(errors::Cancelled("FIFOQueue '", name_, "' is closed."));
+    callback();
+  } else {
+    EnqueueSlow(std::move(elements), ctx, std::move(callback));
+  }
+}
+
+void LockFreeFIFOQueue::EnqueueSlow(std::vector<Tuple> elements,
+                                    OpKernelContext* ctx,
+                                    DoneCallback callback) {
+  CancellationManager* cm = ctx->cancellation_manager();
+  CancellationToken token = cm->get_cancellation_token();
+  bool already_cancelled;
+  AddWaiter(&enqueue_waiters_);
+  {
+    mutex_lock l(mu_);
+    already_cancelled = !cm->RegisterCallback(
+        token, [this, cm, token]() { Cancel(kEnqueue, cm, token); });
+    if (!already_cancelled) {
+      const int32 num_elements = elements.size();
+      enqueue_attempts_.emplace_back(
+          num_elements,
+          [this, callback]() {
+            RemoveWaiter(&enqueue_waiters_);
+            callback();
+          },
+          ctx, cm, token,
+          [this](Attempt* attempt) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+            bool closed = closed_;
+            size_t pushed = 0;
+            if (!closed) {
+              std::vector<Tuple>& elements = attempt->tuples;
+              const size_t begin =
+                  elements.size() - attempt->elements_requested;
+              pushed = ring_.TryPushMany(&elements[begin],
+                                         attempt->elements_requested, 1,
+                                         &closed);
+            }
+            if (closed) {
+              attempt->context->SetStatus(
+                  errors::Cancelled("FIFOQueue '", name_, "' is closed."));
+              return kComplete;
+            }
+            if (pushed == 0) return kNoProgress;
+            attempt->elements_requested -= pushed;
+            return attempt->elements_requested == 0 ? kComplete : kProgress;
+          });
+      enqueue_attempts_.back().tuples = std::move(elements);
+    }
+  }
+  if (!already_cancelled) {
+    FlushUnlocked();
+  } else {
+    RemoveWaiter(&enqueue_waiters_);
+    ctx->SetStatus(errors::Cancelled("Enqueue operation was cancelled"));
+    callback();
+  }
+}
+
+void LockFreeFIFOQueue::TryDequeue(OpKernelContext* ctx,
+                                   CallbackWithTuple callback) {
+  std::vector<Tuple> elements(1);
+  if (TryDequeueFast(&elements)) {
+    callback(elements[0]);
+  } else {
+    DequeueSlow(1, false /* allow_small_batch */, false /* stack */, ctx,
+                std::move(callback));
+  }
+}
+
+void LockFreeFIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
+                                       bool allow_small_batch,
+                                       CallbackWithTuple callback) {
+  if (!specified_shapes()) {
+    ctx->SetStatus(errors::InvalidArgument(
+        "FIFOQueue's DequeueMany and DequeueUpTo require the "
+        "components to have specified shapes."));
+    callback(Tuple());
+    return;
+  }
+  if (num_elements == 0) {
+    // See FIFOQueue::TryDequeueMany() on why the outputs are temporaries.
+    Tuple tuple;
+    Status s = StackElements({}, ctx, &tuple);
+    if (!s.ok()) {
+      ctx->SetStatus(s);
+      callback(Tuple());
+      return;
+    }
+    callback(tuple);
+    return;
+  }
+
+  std::vector<Tuple> elements(num_elements);
+  if (TryDequeueFast(&elements)) {
+    Tuple tuple;
+    Status s = StackElements(elements, ctx, &tuple);
+    if (!s.ok()) {
+      ctx->SetStatus(s);
+      callback(Tuple());
+      return;
+    }
+    callback(tuple);
+  } else {
+    DequeueSlow(num_elements, allow_small_batch, true /* stack */, ctx,
+                std::move(callback));
+  }
+}
+
+void LockFreeFIFOQueue::DequeueSlow(int num_elements, bool allow_small_batch,
+                                    bool stack, OpKernelContext* ctx,
+                                    CallbackWithTuple callback) {
+  CancellationManager* cm = ctx->cancellation_manager();
+  CancellationToken token = cm->get_cancellation_token();
+  bool already_cancelled;
+  AddWaiter(&dequeue_waiters_);
+  {
+    mutex_lock l(mu_);
+    already_cancelled = !cm->RegisterCallback(
+        token, [this, cm, token]() { Cancel(kDequeue, cm, token); });
+    if (!already_cancelled) {
+      dequeue_attempts_.emplace_back(
+          num_elements,
+          [this, callback]() {
+            RemoveWaiter(&dequeue_waiters_);
+            callback(Tuple());
+          },
+          ctx, cm, token,
+          [this, callback, allow_small_batch,
+           stack](Attempt* attempt) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+            std::vector<Tuple>& elements = attempt->tuples;
+            // Includes pushes in flight, which will complete.
+            const int64 queue_size = restored_.size() + ring_.size();
+            if (closed_ && queue_size < attempt->elements_requested) {
+              if (allow_small_batch && elements.size() + queue_size > 0) {
+                // Take whatever is left.
+                attempt->elements_requested = queue_size;
+              } else {
+                if (allow_small_batch) {
+                  // There may be some other attempts containing values. If
+                  // so, we'll yield and wait for them to add elements to the
+                  // queue.
+                  if (!enqueue_attempts_.empty()) return kProgress;
+                }
+                // Put the elements taken so far back at the front of the
+                // queue.
+                restored_.insert(restored_.begin(),
+                                 std::make_move_iterator(elements.begin()),
+                                 std::make_move_iterator(elements.end()));
+                elements.clear();
+                attempt->context->SetStatus(errors::OutOfRange(
+                    "FIFOQueue '", name_, "' is closed and has ",
+                    "insufficient elements (requested ",
+                    attempt->elements_requested, ", current size ",
+                    queue_size, ")"));
+                return kComplete;
+              }
+            }
+
+            RunResult result = kNoProgress;
+            while (attempt->elements_requested > 0 && !restored_.empty()) {
+              elements.push_back(std::move(restored_.front()));
+              restored_.pop_front();
+              --attempt->elements_requested;
+              result = kProgress;
+            }
+            if (attempt->elements_requested > 0) {
+              const size_t popped =
+                  ring_.TryPopMany(attempt->elements_requested, 1, &elements);
+              if (popped > 0) {
+                attempt->elements_requested -= popped;
+                result = kProgress;
+              }
+            }
+            if (attempt->elements_requested > 0) return result;
+
+            // Assemble the output once mu_ has been released.
+            OpKernelContext* ctx = attempt->context;
+            std::vector<Tuple> dequeued;
+            dequeued.swap(elements);
+            attempt->done_callback = [this, callback, ctx, stack, dequeued]() {
+              RemoveWaiter(&dequeue_waiters_);
+              if (!stack) {
+                callback(dequeued[0]);
+                return;
+              }
+              Tuple tuple;
+              Status s = StackElements(dequeued, ctx, &tuple);
+              if (!s.ok()) {
+                ctx->SetStatus(s);
+                callback(Tuple());
+                return;
+              }
+              callback(tuple);
+            };
+            return kComplete;
+          });
+    }
+  }
+  if (!already_cancelled) {
+    FlushUnlocked();
+  } else {
+    RemoveWaiter(&dequeue_waiters_);
+    ctx->SetStatus(errors::Cancelled("Dequeue operation was cancelled"));
+    callback(Tuple());
+  }
+}
+
+void LockFreeFIFOQueue::Close(OpKernelContext* ctx,
+                              bool cancel_pending_enqueues,
+                              DoneCallback callback) {
+  // As QueueBase::Close(), but also closes the ring buffer so that fast-path
+  // enqueues fail from then on.
+  if (cancel_pending_enqueues) {
+    ring_.Close();
+    CloseAndCancel();
+    callback();
+    return;
+  }
+  {
+    mutex_lock lock(mu_);
+    enqueue_attempts_.emplace_back(
+        0, callback, ctx, nullptr, CancellationManager::kInvalidToken,
+        [this](Attempt* attempt) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+          if (closed_) {
+            attempt->context->SetStatus(
+                errors::Cancelled("Queue '", name_, "' is already closed."));
+          } else {
+            ring_.Close();
+            closed_ = true;
+          }
+          return kComplete;
+        });
+  }
+  FlushUnlocked();
+}
+
+int32 LockFreeFIFOQueue::size() {
+  mutex_lock lock(mu_);
+  return restored_.size() + ring_.size();
+}
+
+Status LockFreeFIFOQueue::MatchesNodeDef(const NodeDef& node_def) {
+  if (!MatchesNodeDefOp(node_def, "FIFOQueue").ok() &&
+      !MatchesNodeDefOp(node_def, "FIFOQueueV2").ok()) {
+    return errors::InvalidArgument("Expected FIFOQueue, found ", node_def.op());
+  }
+  TF_RETURN_IF_ERROR(MatchesNodeDefCapacity(node_def, capacity_));
+  TF_RETURN_IF_ERROR(MatchesNodeDefTypes(node_def));
+  TF_RETURN_IF_ERROR(MatchesNodeDefShapes(node_def));
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,130 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_LOCK_FREE_FIFO_QUEUE_H_
+#define TENSORFLOW_CORE_KERNELS_LOCK_FREE_FIFO_QUEUE_H_
+
+#include <atomic>
+#include <deque>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/mpmc_ring_buffer.h"
+#include "tensorflow/core/kernels/queue_base.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A bounded FIFO queue with the same semantics as FIFOQueue, whose elements
+// live in a lock-free ring buffer.
+//
+// An enqueue or dequeue that can complete immediately, and that is not
+// overtaking a blocked operation of the same kind, runs without taking mu_:
+// it claims its slots in the ring buffer with a compare-and-swap. Only
+// operations that have to block, as well as Close() and cancellation, go
+// through the attempt lists of QueueBase under mu_. DequeueMany() and
+// EnqueueMany() move all of their elements in and out of the ring buffer in
+// bulk, and DequeueMany() assembles its output batch once, outside of mu_.
+class LockFreeFIFOQueue : public QueueBase {
+ public:
+  // The largest capacity for which a LockFreeFIFOQueue is used; its ring
+  // buffer is allocated up front.
+  static const int32 kMaxCapacity = 1 << 14;
+
+  // REQUIRES: 0 < capacity <= kMaxCapacity.
+  LockFreeFIFOQueue(int32 capacity, const DataTypeVector& component_dtypes,
+                    const std::vector<TensorShape>& component_shapes,
+                    const string& name);
+
+  // Validates the component types and shapes.
+  Status Initialize();
+
+  // Implementations of QueueInterface methods --------------------------------
+
+  void TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
+                  DoneCallback callback) override;
+  void TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
+                      DoneCallback callback) override;
+  void TryDequeue(OpKernelContext* ctx, CallbackWithTuple callback) override;
+  void TryDequeueMany(int num_elements, OpKernelContext* ctx,
+                      bool allow_small_batch,
+                      CallbackWithTuple callback) override;
+  void Close(OpKernelContext* ctx, bool cancel_pending_enqueues,
+             DoneCallback callback) override;
+  Status MatchesNodeDef(const NodeDef& node_def) override;
+
+  int32 size() override;
+
+ private:
+  ~LockFreeFIFOQueue() override {}
+
+  // Splits the batch 'tuple' into its elements.
+  static Status SplitBatch(const Tuple& tuple, OpKernelContext* ctx,
+                           std::vector<Tuple>* elements);
+
+  // Stacks 'elements' into a batch.
+  Status StackElements(const std::vector<Tuple>& elements, OpKernelContext* ctx,
+                       Tuple* batch);
+
+  // Appends 'elements' to the ring buffer as a whole without taking mu_.
+  // Returns false if the operation has to block behind other enqueues or until
+  // there is room, and sets *closed if it failed because the queue is closed.
+  bool TryEnqueueFast(std::vector<Tuple>* elements, bool* closed);
+
+  // Pops exactly elements->size() elements without taking mu_. Returns false
+  // if the operation has to wait behind other dequeues, for more elements, or
+  // for the queue to close.
+  bool TryDequeueFast(std::vector<Tuple>* elements);
+
+  // Adds an attempt to enqueue 'elements' to enqueue_attempts_.
+  void EnqueueSlow(std::vector<Tuple> elements, OpKernelContext* ctx,
+                   DoneCallback callback);
+
+  // Adds an attempt to dequeue 'num_elements' elements to dequeue_attempts_.
+  // If 'stack' is true, they are passed to 'callback' as a batch; otherwise
+  // num_elements must be 1 and the element is passed as is.
+  void DequeueSlow(int num_elements, bool allow_small_batch, bool stack,
+                   OpKernelContext* ctx, CallbackWithTuple callback);
+
+  // Wakes up blocked attempts of the other kind after a fast-path operation.
+  void NotifyWaiters(const std::atomic<int64>& waiters);
+
+  // Elements, in order.
+  MPMCRingBuffer<Tuple> ring_;
+
+  // The number of attempts that have been (or are about to be) added to
+  // enqueue_attempts_ and dequeue_attempts_ and whose callbacks have not run.
+  // While there are any, operations of that kind take the slow path so that
+  // they do not overtake a blocked operation.
+  std::atomic<int64> enqueue_waiters_;
+  std::atomic<int64> dequeue_waiters_;
+
+  // Elements that a DequeueMany() took out of the ring buffer before it failed
+  // because the queue was closed, to be dequeued before those still in the
+  // ring buffer. Only used once the queue is closed, when every dequeue takes
+  // the slow path.
+  std::deque<Tuple> restored_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(LockFreeFIFOQueue);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_LOCK_FREE_FIFO_QUEUE_H_
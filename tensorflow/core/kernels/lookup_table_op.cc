@@ -19,21 +19,202 @@ limitations under the License.
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/hash/hash.h"
 
 namespace tensorflow {
 namespace lookup {
 
-// Lookup table that wraps an unordered_map, where the key and value data type
+namespace {
+
+template <typename T>
+inline uint64 HashScalar(const T& key) {
+  return static_cast<uint64>(key);
+}
+
+inline uint64 HashScalar(const string& key) { return Hash64(key); }
+
+// If the given shape is a scalar return {1} instead. Otherwise leave it alone.
+TensorShape MaybeVectorizeShape(const TensorShape& shape) {
+  if (shape.dims() == 0) {
+    return TensorShape({1});
+  }
+  return shape;
+}
+
+// Hash of the keys of StripedHashMap. HashScalar is the identity for integer
+// keys, whose bits are mixed here so that the keys of each stripe are spread
+// over its buckets.
+template <class K>
+struct StripedHash {
+  size_t operator()(const K& key) const {
+    uint64 h = HashScalar(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return static_cast<size_t>(h);
+  }
+};
+
+// A hash map split into stripes by the hash of the keys. Each stripe is an
+// open addressing gtl::FlatMap behind its own reader/writer lock, so that
+// lookups do not wait for each other, and inserts only wait for the
+// operations on the keys of the same stripes.
+//
+// The batched operations take the lock of each stripe once for all of its
+// keys, and prefetch the buckets of the keys ahead of the one they probe.
+template <class K, class V>
+class StripedHashMap {
+ public:
+  typedef typename TTypes<K>::ConstFlat Keys;
+
+  size_t size() const {
+    size_t size = 0;
+    for (const Stripe& stripe : stripes_) {
+      tf_shared_lock l(stripe.mu);
+      size += stripe.map.size();
+    }
+    return size;
+  }
+
+  // Calls 'found(i, value)' for each of 'keys' in the map, and 'missing(i)'
+  // for the others.
+  template <typename Found, typename Missing>
+  void Find(Keys keys, Found found, Missing missing) const {
+    std::vector<int64> order;
+    std::vector<int64> starts;
+    GroupByStripe(keys, &order, &starts);
+    for (int s = 0; s < kNumStripes; ++s) {
+      if (starts[s] == starts[s + 1]) continue;
+      const Stripe& stripe = stripes_[s];
+      tf_shared_lock l(stripe.mu);
+      for (int64 j = starts[s]; j < starts[s + 1]; ++j) {
+        if (j + kPrefetchDistance < starts[s + 1]) {
+          stripe.map.prefetch_value(keys(order[j + kPrefetchDistance]));
+        }
+        const int64 i = order[j];
+        auto it = stripe.map.find(SubtleMustCopyUnlessStringOrFloat(keys(i)));
+        if (it != stripe.map.end()) {
+          found(i, it->second);
+        } else {
+          missing(i);
+        }
+      }
+    }
+  }
+
+  // Sets the value of each of 'keys(i)' to 'value(i)'.
+  template <typename Value>
+  void InsertOrUpdate(Keys keys, Value value) {
+    std::vector<int64> order;
+    std::vector<int64> starts;
+    GroupByStripe(keys, &order, &starts);
+    for (int s = 0; s < kNumStripes; ++s) {
+      if (starts[s] == starts[s + 1]) continue;
+      Stripe& stripe = stripes_[s];
+      mutex_lock l(stripe.mu);
+      for (int64 j = starts[s]; j < starts[s + 1]; ++j) {
+        if (j + kPrefetchDistance < starts[s + 1]) {
+          stripe.map.prefetch_value(keys(order[j + kPrefetchDistance]));
+        }
+        const int64 i = order[j];
+        stripe.map[SubtleMustCopyUnlessStringOrFloat(keys(i))] = value(i);
+      }
+    }
+  }
+
+  void Clear() {
+    for (Stripe& stripe : stripes_) {
+      mutex_lock l(stripe.mu);
+      stripe.map.clear();
+    }
+  }
+
+  // Calls 'begin(size)' and then 'fn(i, key, value)' for each of the 'size'
+  // entries of the map, while holding the locks of all stripes.
+  template <typename Begin, typename Fn>
+  Status ForEach(Begin begin, Fn fn) const {
+    std::vector<tf_shared_lock> locks;
+    locks.reserve(kNumStripes);
+    int64 size = 0;
+    for (const Stripe& stripe : stripes_) {
+      locks.emplace_back(stripe.mu);
+      size += stripe.map.size();
+    }
+    TF_RETURN_IF_ERROR(begin(size));
+    int64 i = 0;
+    for (const Stripe& stripe : stripes_) {
+      for (auto it = stripe.map.begin(); it != stripe.map.end(); ++it, ++i) {
+        fn(i, it->first, it->second);
+      }
+    }
+    return Status::OK();
+  }
+
+  int64 MemoryUsed() const {
+    int64 ret = 0;
+    for (const Stripe& stripe : stripes_) {
+      tf_shared_lock l(stripe.mu);
+      ret += stripe.map.bucket_count() * (1 + sizeof(K) + sizeof(V));
+    }
+    return sizeof(StripedHashMap) + ret;
+  }
+
+ private:
+  static const int kNumStripeBits = 6;
+  static const int kNumStripes = 1 << kNumStripeBits;
+  static const int64 kPrefetchDistance = 4;
+
+  struct Stripe {
+    mutable mutex mu;
+    gtl::FlatMap<K, V, StripedHash<K>> map GUARDED_BY(mu);
+  };
+
+  // Returns the positions of 'keys' ordered by stripe in '*order', such that
+  // the keys of stripe 's' are at the positions [(*starts)[s],
+  // (*starts)[s + 1]) of it.
+  void GroupByStripe(Keys keys, std::vector<int64>* order,
+                     std::vector<int64>* starts) const {
+    const int64 num_keys = keys.size();
+    // The stripe is taken from the high bits of the hash, as the FlatMap of
+    // the stripe uses its low bits.
+    const StripedHash<K> hash;
+    std::vector<uint8> stripes(num_keys);
+    starts->assign(kNumStripes + 1, 0);
+    for (int64 i = 0; i < num_keys; ++i) {
+      stripes[i] = static_cast<uint64>(hash(keys(i))) >> (64 - kNumStripeBits);
+      ++(*starts)[stripes[i] + 1];
+    }
+    for (int s = 0; s < kNumStripes; ++s) {
+      (*starts)[s + 1] += (*starts)[s];
+    }
+    std::vector<int64> next(starts->begin(), starts->end() - 1);
+    order->resize(num_keys);
+    for (int64 i = 0; i < num_keys; ++i) {
+      (*order)[next[stripes[i]]++] = i;
+    }
+  }
+
+  Stripe stripes_[kNumStripes];
+};
+
+}  // namespace
+
+// Lookup table that wraps a StripedHashMap, where the key and value data type
 // is specified. Each individual value must be a scalar. If vector values are
 // required, use MutableHashTableOfTensors.
 //
 // This table is mutable and thread safe - Insert can be called at any time.
+// Lookups and inserts of keys in different stripes of the map run
+// concurrently.
 //
 // Sample use case:
 //
@@ -48,10 +229,7 @@ class MutableHashTableOfScalars final : public LookupInterface {
  public:
   MutableHashTableOfScalars(OpKernelContext* ctx, OpKernel* kernel) {}
 
-  size_t size() const override {
-    mutex_lock l(mu_);
-    return table_.size();
-  }
+  size_t size() const override { return table_.size(); }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
               const Tensor& default_value) override {
@@ -59,13 +237,13 @@ class MutableHashTableOfScalars final : public LookupInterface {
     const auto key_values = key.flat<K>();
     auto value_values = value->flat<V>();
 
-    mutex_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      value_values(i) = gtl::FindWithDefault(
-          table_, SubtleMustCopyUnlessStringOrFloat(key_values(i)),
-          default_val);
-    }
-
+    table_.Find(key_values,
+                [&value_values](int64 i, const V& value) {
+                  value_values(i) = value;
+                },
+                [&value_values, &default_val](int64 i) {
+                  value_values(i) = default_val;
+                });
     return Status::OK();
   }
 
@@ -73,15 +251,14 @@ class MutableHashTableOfScalars final : public LookupInterface {
     const auto key_values = keys.flat<K>();
     const auto value_values = values.flat<V>();
 
-    mutex_lock l(mu_);
+    // Import only runs when restoring the table, so the table need not be
+    // cleared and filled atomically.
     if (clear) {
-      table_.clear();
-    }
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      gtl::InsertOrUpdate(&table_,
-                          SubtleMustCopyUnlessStringOrFloat(key_values(i)),
-                          SubtleMustCopyUnlessStringOrFloat(value_values(i)));
+      table_.Clear();
     }
+    table_.InsertOrUpdate(key_values, [&value_values](int64 i) {
+      return SubtleMustCopyUnlessStringOrFloat(value_values(i));
+    });
     return Status::OK();
   }
 
@@ -96,24 +273,18 @@ class MutableHashTableOfScalars final : public LookupInterface {
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    mutex_lock l(mu_);
-    int64 size = table_.size();
-
     Tensor* keys;
     Tensor* values;
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("keys", TensorShape({size}), &keys));
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("values", TensorShape({size}), &values));
-
-    auto keys_data = keys->flat<K>();
-    auto values_data = values->flat<V>();
-    int64 i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      keys_data(i) = it->first;
-      values_data(i) = it->second;
-    }
-    return Status::OK();
+    return table_.ForEach(
+        [ctx, &keys, &values](int64 size) {
+          TF_RETURN_IF_ERROR(
+              ctx->allocate_output("keys", TensorShape({size}), &keys));
+          return ctx->allocate_output("values", TensorShape({size}), &values);
+        },
+        [&keys, &values](int64 i, const K& key, const V& value) {
+          keys->flat<K>()(i) = key;
+          values->flat<V>()(i) = value;
+        });
   }
 
   DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
@@ -125,26 +296,14 @@ class MutableHashTableOfScalars final : public LookupInterface {
   TensorShape value_shape() const override { return TensorShape(); }
 
   int64 MemoryUsed() const override {
-    int64 ret = 0;
-    mutex_lock l(mu_);
-    for (unsigned i = 0; i < table_.bucket_count(); ++i) {
-      size_t bucket_size = table_.bucket_size(i);
-      if (bucket_size == 0) {
-        ret++;
-      } else {
-        ret += bucket_size;
-      }
-    }
-    return sizeof(MutableHashTableOfScalars) + ret;
+    return sizeof(MutableHashTableOfScalars) + table_.MemoryUsed();
   }
 
  private:
-  // TODO(andreasst): consider using a read/write lock or a concurrent map
-  mutable mutex mu_;
-  std::unordered_map<K, V> table_ GUARDED_BY(mu_);
+  StripedHashMap<K, V> table_;
 };
 
-// Lookup table that wraps an unordered_map. Behaves identical to
+// Lookup table that wraps a StripedHashMap. Behaves identical to
 // MutableHashTableOfScalars except that each value must be a vector.
 template <class K, class V>
 class MutableHashTableOfTensors final : public LookupInterface {
@@ -158,10 +317,7 @@ class MutableHashTableOfTensors final : public LookupInterface {
                                 value_shape_.DebugString()));
   }
 
-  size_t size() const override {
-    mutex_lock l(mu_);
-    return table_.size();
-  }
+  size_t size() const override { return table_.size(); }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
               const Tensor& default_value) override {
@@ -170,21 +326,17 @@ class MutableHashTableOfTensors final : public LookupInterface {
     auto value_values = value->flat_inner_dims<V, 2>();
     int64 value_dim = value_shape_.dim_size(0);
 
-    mutex_lock l(mu_);
-    for (int64 i = 0; i < key_values.size(); ++i) {
-      ValueArray* value_vec = gtl::FindOrNull(
-          table_, SubtleMustCopyUnlessStringOrFloat(key_values(i)));
-      if (value_vec != nullptr) {
-        for (int64 j = 0; j < value_dim; j++) {
-          value_values(i, j) = value_vec->at(j);
-        }
-      } else {
-        for (int64 j = 0; j < value_dim; j++) {
-          value_values(i, j) = default_flat(j);
-        }
-      }
-    }
-
+    table_.Find(key_values,
+                [&value_values, value_dim](int64 i, const ValueArray& value) {
+                  for (int64 j = 0; j < value_dim; j++) {
+                    value_values(i, j) = value.at(j);
+                  }
+                },
+                [&value_values, &default_flat, value_dim](int64 i) {
+                  for (int64 j = 0; j < value_dim; j++) {
+                    value_values(i, j) = default_flat(j);
+                  }
+                });
     return Status::OK();
   }
 
@@ -193,19 +345,19 @@ class MutableHashTableOfTensors final : public LookupInterface {
     const auto value_values = values.flat_inner_dims<V, 2>();
     int64 value_dim = value_shape_.dim_size(0);
 
-    mutex_lock l(mu_);
+    // Import only runs when restoring the table, so the table need not be
+    // cleared and filled atomically.
     if (clear) {
-      table_.clear();
+      table_.Clear();
     }
-    for (int64 i = 0; i < key_values.size(); ++i) {
+    table_.InsertOrUpdate(key_values, [&value_values, value_dim](int64 i) {
       ValueArray value_vec;
       for (int64 j = 0; j < value_dim; j++) {
         V value = value_values(i, j);
         value_vec.push_back(value);
       }
-      gtl::InsertOrUpdate(
-          &table_, SubtleMustCopyUnlessStringOrFloat(key_values(i)), value_vec);
-    }
+      return value_vec;
+    });
     return Status::OK();
   }
 
@@ -220,29 +372,24 @@ class MutableHashTableOfTensors final : public LookupInterface {
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    mutex_lock l(mu_);
-    int64 size = table_.size();
     int64 value_dim = value_shape_.dim_size(0);
-
     Tensor* keys;
     Tensor* values;
-    TF_RETURN_IF_ERROR(
-        ctx->allocate_output("keys", TensorShape({size}), &keys));
-    TF_RETURN_IF_ERROR(ctx->allocate_output(
-        "values", TensorShape({size, value_dim}), &values));
-
-    auto keys_data = keys->flat<K>();
-    auto values_data = values->matrix<V>();
-    int64 i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      K key = it->first;
-      ValueArray value = it->second;
-      keys_data(i) = key;
-      for (int64 j = 0; j < value_dim; j++) {
-        values_data(i, j) = value[j];
-      }
-    }
-    return Status::OK();
+    return table_.ForEach(
+        [ctx, &keys, &values, value_dim](int64 size) {
+          TF_RETURN_IF_ERROR(
+              ctx->allocate_output("keys", TensorShape({size}), &keys));
+          return ctx->allocate_output(
+              "values", TensorShape({size, value_dim}), &values);
+        },
+        [&keys, &values, value_dim](int64 i, const K& key,
+                                    const ValueArray& value) {
+          keys->flat<K>()(i) = key;
+          auto values_data = values->matrix<V>();
+          for (int64 j = 0; j < value_dim; j++) {
+            values_data(i, j) = value[j];
+          }
+        });
   }
 
   DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
@@ -254,46 +401,15 @@ class MutableHashTableOfTensors final : public LookupInterface {
   TensorShape value_shape() const override { return value_shape_; }
 
   int64 MemoryUsed() const override {
-    int64 ret = 0;
-    mutex_lock l(mu_);
-    for (unsigned i = 0; i < table_.bucket_count(); ++i) {
-      size_t bucket_size = table_.bucket_size(i);
-      if (bucket_size == 0) {
-        ret++;
-      } else {
-        ret += bucket_size;
-      }
-    }
-    return sizeof(MutableHashTableOfTensors) + ret;
+    return sizeof(MutableHashTableOfTensors) + table_.MemoryUsed();
   }
 
  private:
   TensorShape value_shape_;
-  // TODO(andreasst): consider using a read/write lock or a concurrent map
-  mutable mutex mu_;
   typedef gtl::InlinedVector<V, 4> ValueArray;
-  std::unordered_map<K, ValueArray> table_ GUARDED_BY(mu_);
+  StripedHashMap<K, ValueArray> table_;
 };
 
-namespace {
-
-template <typename T>
-inline uint64 HashScalar(const T& key) {
-  return static_cast<uint64>(key);
-}
-
-inline uint64 HashScalar(const string& key) { return Hash64(key); }
-
-// If the given shape is a scalar return {1} instead. Otherwise leave it alone.
-TensorShape MaybeVectorizeShape(const TensorShape& shape) {
-  if (shape.dims() == 0) {
-    return TensorShape({1});
-  }
-  return shape;
-}
-
-}  // namespace
-
 // Modeled after densehashtable in https://github.com/sparsehash/sparsehash
 template <class K, class V>
 class MutableDenseHashTable final : public LookupInterface {
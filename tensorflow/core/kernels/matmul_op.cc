@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/kernels/fused_bias_activation_functor.h"
 #include "tensorflow/core/util/matmul_autotune.h"
 #if GOOGLE_CUDA
 #include "cuda/include/cuda.h"
@@ -505,6 +506,60 @@ class MatMulOp : public OpKernel {
   bool transpose_b_;
 };
 
+#if GOOGLE_CUDA
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                           \
+  template <>                                                         \
+  void BiasActivation<GPUDevice, T>::operator()(                      \
+      const GPUDevice& d, typename TTypes<T, 3>::Tensor output,       \
+      typename TTypes<T>::ConstVec bias, FusedActivation activation); \
+  extern template struct BiasActivation<GPUDevice, T>;
+
+TF_CALL_GPU_NUMBER_TYPES(DECLARE_GPU_SPEC);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+#endif  // GOOGLE_CUDA
+
+// MatMul followed by BiasAdd and an activation, which grappler fuses. The
+// bias and the activation are applied in place, in a single pass over the
+// product.
+template <typename Device, typename T, bool USE_CUBLAS>
+class FusedMatMulOp : public MatMulOp<Device, T, USE_CUBLAS> {
+ public:
+  explicit FusedMatMulOp(OpKernelConstruction* ctx)
+      : MatMulOp<Device, T, USE_CUBLAS>(ctx) {
+    string activation;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("activation", &activation));
+    OP_REQUIRES_OK(ctx, FusedActivationFromString(activation, &activation_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& b = ctx->input(1);
+    const Tensor& bias = ctx->input(2);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(bias.shape()),
+                errors::InvalidArgument("bias must be 1-dimensional: ",
+                                        bias.shape().DebugString()));
+
+    MatMulOp<Device, T, USE_CUBLAS>::Compute(ctx);
+    if (!ctx->status().ok()) return;
+    Tensor* out = ctx->mutable_output(0);
+    OP_REQUIRES(ctx, bias.dim_size(0) == out->dim_size(1),
+                errors::InvalidArgument(
+                    "bias must have the size of the columns of the product: ",
+                    bias.dim_size(0), " vs ", out->dim_size(1), " for In[1]: ",
+                    b.shape().DebugString()));
+    if (out->NumElements() == 0) return;
+    functor::BiasActivation<Device, T>()(
+        ctx->eigen_device<Device>(),
+        out->shaped<T, 3>({out->dim_size(0), out->dim_size(1), 1}),
+        bias.vec<T>(), activation_);
+  }
+
+ private:
+  FusedActivation activation_;
+};
+
 namespace functor {
 
 // Partial specialization MatMulFunctor<Device=CPUDevice, T>.
@@ -553,16 +608,30 @@ struct MatMulFunctor<SYCLDevice, T> {
                               .Label("cublas"),                    \
                           MatMulOp<GPUDevice, T, true /* cublas */>)
 
+#define REGISTER_FUSED_CPU(T)                                              \
+  REGISTER_KERNEL_BUILDER(                                                 \
+      Name("_FusedMatMul").Device(DEVICE_CPU).TypeConstraint<T>("T"),      \
+      FusedMatMulOp<CPUDevice, T, false /* cublas, ignored for CPU */>);
+
+#define REGISTER_FUSED_GPU(T)                                          \
+  REGISTER_KERNEL_BUILDER(                                             \
+      Name("_FusedMatMul").Device(DEVICE_GPU).TypeConstraint<T>("T"),  \
+      FusedMatMulOp<GPUDevice, T, true /* cublas, true by default */>);
+
 #if defined(INTEL_MKL)
 // MKL does not support half and int32 types for matrix-multiplication, so
 // register the kernel to use default Eigen based implementations for these
 // types
 TF_CALL_half(REGISTER_CPU);
 TF_CALL_int32(REGISTER_CPU);
+TF_CALL_half(REGISTER_FUSED_CPU);
 #else
 TF_CALL_float(REGISTER_CPU);
 TF_CALL_double(REGISTER_CPU);
 TF_CALL_half(REGISTER_CPU);
+TF_CALL_float(REGISTER_FUSED_CPU);
+TF_CALL_double(REGISTER_FUSED_CPU);
+TF_CALL_half(REGISTER_FUSED_CPU);
 
 TF_CALL_int32(REGISTER_CPU);
 TF_CALL_complex64(REGISTER_CPU);
@@ -574,8 +643,11 @@ TF_CALL_float(REGISTER_GPU);
 TF_CALL_double(REGISTER_GPU);
 TF_CALL_complex64(REGISTER_GPU);
 TF_CALL_complex128(REGISTER_GPU);
+TF_CALL_float(REGISTER_FUSED_GPU);
+TF_CALL_double(REGISTER_FUSED_GPU);
 #if CUDA_VERSION >= 7050
 TF_CALL_half(REGISTER_GPU);
+TF_CALL_half(REGISTER_FUSED_GPU);
 #endif
 #endif  // GOOGLE_CUDA
 
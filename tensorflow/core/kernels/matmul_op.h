@@ -82,13 +82,18 @@ class MatmulParameters {
     return !(*this == other);
   }
   uint64 hash() const { return hash_code_; }
+  int device_id() const { return device_id_; }
 
   string ToString() const {
+    return strings::StrCat(ToStringWithoutDevice(), ", ", device_id_);
+  }
+
+  string ToStringWithoutDevice() const {
     // clang-format off
     return strings::StrCat(
         transa_, ", ", transb_, ", ",
-        m_, ", ", n_, ", ", k_,
-        dtype_, ", ", device_id_);
+        m_, ", ", n_, ", ", k_, ", ",
+        dtype_);
     // clang-format on
   }
 
@@ -0,0 +1,207 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_MPMC_RING_BUFFER_H_
+#define TENSORFLOW_CORE_KERNELS_MPMC_RING_BUFFER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A bounded, lock-free, multi-producer multi-consumer FIFO ring buffer.
+//
+// Each slot carries a sequence number that says whether it is ready to be
+// written or read at a given position (D. Vyukov's bounded MPMC queue).
+// Producers and consumers claim positions with a single compare-and-swap on
+// the enqueue or dequeue position, and may claim a run of consecutive
+// positions at once, so that batches of values move in and out with one
+// atomic operation.
+//
+// The buffer can be closed, after which no more values can be pushed. Values
+// already pushed (including pushes in flight when Close() is called) can still
+// be popped.
+template <typename T>
+class MPMCRingBuffer {
+ public:
+  enum PushResult { kPushed, kFull, kClosed };
+
+  // REQUIRES: capacity > 0.
+  explicit MPMCRingBuffer(size_t capacity)
+      : capacity_(capacity), slots_(new Slot[capacity]) {
+    CHECK_GT(capacity, 0);
+    for (size_t i = 0; i < capacity_; ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueue_pos_.store(0, std::memory_order_relaxed);
+    dequeue_pos_.store(0, std::memory_order_relaxed);
+  }
+
+  // Appends *value, moving from it, if there is room.
+  PushResult TryPush(T* value) {
+    bool closed = false;
+    if (TryPushMany(value, 1, 1, &closed) == 1) return kPushed;
+    return closed ? kClosed : kFull;
+  }
+
+  // Appends values[0, n), moving from them, for the largest n <= count that
+  // there is room for, provided that n >= min_count; otherwise appends
+  // nothing. Returns n. Sets *closed if nothing was appended because the buffer
+  // is closed.
+  //
+  // REQUIRES: 1 <= min_count <= count.
+  size_t TryPushMany(T* values, size_t count, size_t min_count, bool* closed) {
+    DCHECK_GE(min_count, 1);
+    DCHECK_LE(min_count, count);
+    uint64 pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      if (pos & kClosedBit) {
+        *closed = true;
+        return 0;
+      }
+      // A slot is free at position p once its sequence number reaches p.
+      size_t n = 0;
+      while (n < count &&
+             slots_[Index(pos + n)].sequence.load(std::memory_order_acquire) ==
+                 pos + n) {
+        ++n;
+      }
+      if (n < min_count) {
+        // Either the buffer is too full, or 'pos' is stale because another
+        // producer claimed it.
+        const uint64 current = enqueue_pos_.load(std::memory_order_relaxed);
+        if (current == pos) return 0;
+        pos = current;
+        continue;
+      }
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + n,
+                                             std::memory_order_relaxed)) {
+        for (size_t i = 0; i < n; ++i) {
+          Slot& slot = slots_[Index(pos + i)];
+          slot.value = std::move(values[i]);
+          slot.sequence.store(pos + i + 1, std::memory_order_release);
+        }
+        return n;
+      }
+    }
+  }
+
+  // Pops the oldest value into *value, if there is one.
+  bool TryPop(T* value) { return TryPopMany(1, 1, value) == 1; }
+
+  // Pops the oldest n values into values[0, n), for the largest n <= max_count
+  // that are available, provided that n >= min_count; otherwise pops nothing.
+  // Returns n.
+  //
+  // REQUIRES: 1 <= min_count <= max_count, and 'values' has room for
+  // max_count values.
+  size_t TryPopMany(size_t max_count, size_t min_count, T* values) {
+    DCHECK_GE(min_count, 1);
+    DCHECK_LE(min_count, max_count);
+    uint64 pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      // A slot holds a value for position p once its sequence number reaches
+      // p + 1.
+      size_t n = 0;
+      while (n < max_count &&
+             slots_[Index(pos + n)].sequence.load(std::memory_order_acquire) ==
+                 pos + n + 1) {
+        ++n;
+      }
+      if (n < min_count) {
+        const uint64 current = dequeue_pos_.load(std::memory_order_relaxed);
+        if (current == pos) return 0;
+        pos = current;
+        continue;
+      }
+      if (dequeue_pos_.compare_exchange_weak(pos, pos + n,
+                                             std::memory_order_relaxed)) {
+        for (size_t i = 0; i < n; ++i) {
+          Slot& slot = slots_[Index(pos + i)];
+          values[i] = std::move(slot.value);
+          // Drop whatever the moved-from value still references.
+          slot.value = T();
+          slot.sequence.store(pos + i + capacity_, std::memory_order_release);
+        }
+        return n;
+      }
+    }
+  }
+
+  // As above, but appends the popped values to *values.
+  size_t TryPopMany(size_t max_count, size_t min_count,
+                    std::vector<T>* values) {
+    const size_t old_size = values->size();
+    values->resize(old_size + max_count);
+    const size_t n =
+        TryPopMany(max_count, min_count, values->data() + old_size);
+    values->resize(old_size + n);
+    return n;
+  }
+
+  // Returns the number of values pushed and not yet popped, including pushes
+  // that have claimed a position but not yet stored their value.
+  size_t size() const {
+    // Load the dequeue position first so that the difference is never negative.
+    const uint64 dequeue_pos = dequeue_pos_.load(std::memory_order_acquire);
+    const uint64 enqueue_pos =
+        enqueue_pos_.load(std::memory_order_acquire) & ~kClosedBit;
+    return std::min<uint64>(enqueue_pos - dequeue_pos, capacity_);
+  }
+
+  size_t capacity() const { return capacity_; }
+
+  // Makes all subsequent pushes fail with kClosed.
+  void Close() { enqueue_pos_.fetch_or(kClosedBit, std::memory_order_acq_rel); }
+
+  bool closed() const {
+    return enqueue_pos_.load(std::memory_order_acquire) & kClosedBit;
+  }
+
+ private:
+  static constexpr uint64 kClosedBit = 1ULL << 63;
+
+  struct Slot {
+    std::atomic<uint64> sequence;
+    T value;
+  };
+
+  size_t Index(uint64 pos) const { return pos % capacity_; }
+
+  const size_t capacity_;
+  const std::unique_ptr<Slot[]> slots_;
+
+  // Padded so that producers and consumers do not contend for a cache line.
+  char pad0_[64];
+  std::atomic<uint64> enqueue_pos_;
+  char pad1_[64];
+  std::atomic<uint64> dequeue_pos_;
+  char pad2_[64];
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MPMCRingBuffer);
+};
+
+template <typename T>
+constexpr uint64 MPMCRingBuffer<T>::kClosedBit;
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_MPMC_RING_BUFFER_H_
@@ -0,0 +1,174 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/mpmc_ring_buffer.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(MPMCRingBufferTest, PushAndPopInOrder) {
+  MPMCRingBuffer<int> buffer(3);
+  EXPECT_EQ(3, buffer.capacity());
+  // Go around the ring a few times.
+  for (int round = 0; round < 4; ++round) {
+    for (int i = 0; i < 3; ++i) {
+      int value = 10 * round + i;
+      EXPECT_EQ(MPMCRingBuffer<int>::kPushed, buffer.TryPush(&value));
+    }
+    int extra = -1;
+    EXPECT_EQ(MPMCRingBuffer<int>::kFull, buffer.TryPush(&extra));
+    EXPECT_EQ(3, buffer.size());
+    for (int i = 0; i < 3; ++i) {
+      int value = -1;
+      EXPECT_TRUE(buffer.TryPop(&value));
+      EXPECT_EQ(10 * round + i, value);
+    }
+    int value = -1;
+    EXPECT_FALSE(buffer.TryPop(&value));
+    EXPECT_EQ(0, buffer.size());
+  }
+}
+
+TEST(MPMCRingBufferTest, PushMany) {
+  MPMCRingBuffer<int> buffer(5);
+  std::vector<int> values = {0, 1, 2, 3};
+  bool closed = false;
+  EXPECT_EQ(4, buffer.TryPushMany(values.data(), 4, 4, &closed));
+  // All-or-nothing pushes fail when there is not enough room...
+  EXPECT_EQ(0, buffer.TryPushMany(values.data(), 2, 2, &closed));
+  // ...while partial pushes take what fits.
+  values = {4, 5};
+  EXPECT_EQ(1, buffer.TryPushMany(values.data(), 2, 1, &closed));
+  EXPECT_FALSE(closed);
+  std::vector<int> popped;
+  EXPECT_EQ(5, buffer.TryPopMany(10, 1, &popped));
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4}), popped);
+}
+
+TEST(MPMCRingBufferTest, PopMany) {
+  MPMCRingBuffer<int> buffer(8);
+  for (int i = 0; i < 5; ++i) {
+    int value = i;
+    ASSERT_EQ(MPMCRingBuffer<int>::kPushed, buffer.TryPush(&value));
+  }
+  std::vector<int> popped = {-1};
+  EXPECT_EQ(0, buffer.TryPopMany(6, 6, &popped));
+  EXPECT_EQ(std::vector<int>({-1}), popped);
+  EXPECT_EQ(3, buffer.TryPopMany(3, 3, &popped));
+  EXPECT_EQ(2, buffer.TryPopMany(6, 1, &popped));
+  EXPECT_EQ(std::vector<int>({-1, 0, 1, 2, 3, 4}), popped);
+  EXPECT_EQ(0, buffer.TryPopMany(1, 1, &popped));
+}
+
+TEST(MPMCRingBufferTest, Close) {
+  MPMCRingBuffer<int> buffer(2);
+  int value = 7;
+  ASSERT_EQ(MPMCRingBuffer<int>::kPushed, buffer.TryPush(&value));
+  EXPECT_FALSE(buffer.closed());
+  buffer.Close();
+  EXPECT_TRUE(buffer.closed());
+  value = 8;
+  EXPECT_EQ(MPMCRingBuffer<int>::kClosed, buffer.TryPush(&value));
+  bool closed = false;
+  EXPECT_EQ(0, buffer.TryPushMany(&value, 1, 1, &closed));
+  EXPECT_TRUE(closed);
+  // Values pushed before closing can still be popped.
+  EXPECT_EQ(1, buffer.size());
+  EXPECT_TRUE(buffer.TryPop(&value));
+  EXPECT_EQ(7, value);
+}
+
+TEST(MPMCRingBufferTest, MovesValues) {
+  MPMCRingBuffer<std::unique_ptr<int>> buffer(2);
+  std::unique_ptr<int> value(new int(3));
+  ASSERT_EQ(MPMCRingBuffer<std::unique_ptr<int>>::kPushed,
+            buffer.TryPush(&value));
+  EXPECT_EQ(nullptr, value);
+  ASSERT_TRUE(buffer.TryPop(&value));
+  EXPECT_EQ(3, *value);
+}
+
+TEST(MPMCRingBufferTest, ConcurrentProducersAndConsumers) {
+  const int kNumProducers = 4;
+  const int kNumConsumers = 4;
+  const int kValuesPerProducer = 10000;
+  MPMCRingBuffer<int> buffer(16);
+  mutex mu;
+  std::vector<int> seen(kNumProducers * kValuesPerProducer, 0);
+  // The last value each consumer saw from each producer.
+  std::vector<std::vector<int>> last_seen(
+      kNumConsumers, std::vector<int>(kNumProducers, -1));
+  bool out_of_order = false;
+  {
+    thread::ThreadPool pool(Env::Default(), "test",
+                            kNumProducers + kNumConsumers);
+    for (int p = 0; p < kNumProducers; ++p) {
+      pool.Schedule([&buffer, p, kValuesPerProducer]() {
+        int i = 0;
+        while (i < kValuesPerProducer) {
+          // Alternate between single and bulk pushes.
+          int values[3];
+          const int count = std::min(1 + i % 3, kValuesPerProducer - i);
+          for (int j = 0; j < count; ++j) {
+            values[j] = p * kValuesPerProducer + i + j;
+          }
+          bool closed = false;
+          const int pushed = buffer.TryPushMany(values, count, 1, &closed);
+          if (pushed == 0) std::this_thread::yield();
+          i += pushed;
+        }
+      });
+    }
+    for (int c = 0; c < kNumConsumers; ++c) {
+      pool.Schedule([&, c]() {
+        const int total = kNumProducers * kValuesPerProducer / kNumConsumers;
+        int received = 0;
+        std::vector<int> popped;
+        while (received < total) {
+          popped.clear();
+          const int n = buffer.TryPopMany(
+              std::min(1 + received % 4, total - received), 1, &popped);
+          if (n == 0) std::this_thread::yield();
+          received += n;
+          mutex_lock l(mu);
+          for (int value : popped) {
+            ++seen[value];
+            const int producer = value / kValuesPerProducer;
+            if (value <= last_seen[c][producer]) out_of_order = true;
+            last_seen[c][producer] = value;
+          }
+        }
+      });
+    }
+  }
+  EXPECT_FALSE(out_of_order);
+  for (int count : seen) {
+    ASSERT_EQ(1, count);
+  }
+  EXPECT_EQ(0, buffer.size());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -118,9 +118,11 @@ struct NthElementFunctor<CPUDevice, T> {
     auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
     // The average time complexity of partition-based nth_element (BFPRT) is O(n),
     // althought the worst time complexity could be O(n^2).
-    // Here, 20 is a empirical factor of cost_per_unit.
-    Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
-          20 * last_dim, SubNthElement);
+    // Here, 20 is a empirical factor of cost_per_unit, until the cost is
+    // measured.
+    static AdaptiveSharder* sharder = new AdaptiveSharder("NthElement", 20);
+    sharder->Shard(worker_threads.num_threads, worker_threads.workers,
+                   num_rows, last_dim, SubNthElement);
   }
 };
 
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/dataset.h"
 
+#include <deque>
+
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -37,6 +39,11 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("f", &func_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("buffer_output_elements",
+                                     &buffer_output_elements_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("max_cycle_length", &max_cycle_length_));
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr("max_buffered_bytes", &max_buffered_bytes_));
   }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
@@ -64,13 +71,20 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
     bool sloppy;
     OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, "sloppy", &sloppy));
 
+    OP_REQUIRES(ctx,
+                max_cycle_length_ == 0 || max_cycle_length_ >= cycle_length,
+                errors::InvalidArgument(
+                    "`max_cycle_length` must be 0 or >= `cycle_length`"));
+
     std::unique_ptr<CapturedFunction> captured_func;
     OP_REQUIRES_OK(ctx, CapturedFunction::Create(ctx, func_, graph_def_version_,
                                                  std::move(other_arguments),
                                                  &captured_func));
 
     *output = new Dataset(input, std::move(captured_func), cycle_length,
-                          block_length, sloppy, output_types_, output_shapes_);
+                          block_length, sloppy, buffer_output_elements_,
+                          max_cycle_length_, max_buffered_bytes_,
+                          output_types_, output_shapes_);
   }
 
  private:
@@ -78,13 +92,20 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
    public:
     Dataset(const DatasetBase* input,
             std::unique_ptr<CapturedFunction> captured_func, int64 cycle_length,
-            int64 block_length, bool sloppy, const DataTypeVector& output_types,
+            int64 block_length, bool sloppy, int64 buffer_output_elements,
+            int64 max_cycle_length, int64 max_buffered_bytes,
+            const DataTypeVector& output_types,
             const std::vector<PartialTensorShape>& output_shapes)
         : input_(input),
           captured_func_(std::move(captured_func)),
           cycle_length_(cycle_length),
           block_length_(block_length),
           sloppy_(sloppy),
+          buffer_output_elements_(buffer_output_elements),
+          // The cycle only widens if the order is allowed to change.
+          max_cycle_length_(sloppy ? std::max(cycle_length, max_cycle_length)
+                                   : cycle_length),
+          max_buffered_bytes_(max_buffered_bytes),
           output_types_(output_types),
           output_shapes_(output_shapes) {
       input_->Ref();
@@ -115,14 +136,14 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
       explicit Iterator(const Params& params)
           : DatasetIterator<Dataset>(params),
             input_impl_(params.dataset->input_->MakeIterator(params.prefix)),
-            output_elements_(params.dataset->cycle_length_) {}
+            output_buffers_(params.dataset->max_cycle_length_) {}
 
       ~Iterator() override {
         mutex_lock l(mu_);
         cancelled_ = true;
         // Notify all workers in case they are blocked.
-        for (int64 i = 0; i < dataset()->cycle_length_; ++i) {
-          output_elements_[i].cond_var.notify_all();
+        for (OutputBuffer& buffer : output_buffers_) {
+          buffer.cond_var.notify_all();
         }
       }
 
@@ -134,19 +155,22 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
         TF_RETURN_IF_ERROR(EnsureWorkerThreadsStarted(ctx));
-        const int64 num_workers = worker_threads_.size();
-        if (num_workers == 0) {
-          *end_of_sequence = true;
-          return Status::OK();
-        }
         while (!cancelled_) {
+          // The cycle may have been widened since the last iteration.
+          const int64 num_workers = worker_threads_.size();
+          if (num_workers == 0) {
+            *end_of_sequence = true;
+            return Status::OK();
+          }
           // Wait for an item to become available, blocking if necessary. If we
           // are allowed to be sloppy, we can skip over input datasets that do
           // not have an item readily available.
           const int64 n = dataset()->sloppy_ ? num_workers : 1LL;
           for (int64 i = 0; i < n; ++i) {
             int64 index = (next_index_ + i) % num_workers;
-            if (output_elements_[index].is_produced) {
+            OutputBuffer& buffer = output_buffers_[index];
+            if (!buffer.elements.empty()) {
+              OutputBufferElement& element = buffer.elements.front();
               next_index_ = index;
               if (i == 0) {
                 block_count_++;
@@ -158,21 +182,20 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
                 block_count_ = 0;
               }
               // If we encounter an EoF, advance to the next iterator
-              if (output_elements_[index].end_of_sequence) {
-                output_elements_[index].is_produced = false;
-                output_elements_[index].cond_var.notify_one();
+              if (element.end_of_sequence) {
+                PopOutputElement(index);
                 next_index_ = (index + 1) % num_workers;
                 block_count_ = 0;
                 i = -1;  // Restart the inner loop
                 continue;
               }
               *end_of_sequence = false;
-              if (output_elements_[index].output_status.ok()) {
-                output_elements_[index].output_value.swap(*out_tensors);
+              Status s = element.output_status;
+              if (s.ok()) {
+                element.output_value.swap(*out_tensors);
               }
-              output_elements_[index].is_produced = false;
-              output_elements_[index].cond_var.notify_one();
-              return output_elements_[index].output_status;
+              PopOutputElement(index);
+              return s;
             }
           }
 
@@ -193,6 +216,12 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
             continue;
           }
 
+          // All of the inputs in the cycle are slower than the consumer, so
+          // widen the cycle by one input, if allowed, before waiting.
+          if (num_workers < dataset()->max_cycle_length_ && !end_of_input_) {
+            TF_RETURN_IF_ERROR(StartWorkerThread(ctx));
+          }
+
           // No values available; wait until woken up.
           // TODO(jsimsa): Use slot-specific condition variable for
           // coordination of elements consumption.
@@ -203,12 +232,9 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
       }
 
      private:
-      // Internal structure to manage thread coordination. All values are
+      // Internal structures to manage thread coordination. All values are
       // guarded by the enclosing Iterator's mu_.
       struct OutputBufferElement {
-        // The producer must set `is_produced` to `true` after
-        // `output_status` or `output_value` has been written.
-        bool is_produced = false;
         // The producer sets `output_status` if either getting the input element
         // or applying the function to it fails.
         Status output_status;
@@ -216,9 +242,17 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
         bool end_of_sequence = false;
         // The output data element.
         std::vector<Tensor> output_value;
-        // The producer thread waits on this condition variable after having
-        // produced an element. The reader thread notifies this condition
-        // variable after reading the value.
+        // The total size of the tensors in `output_value`.
+        int64 bytes = 0;
+      };
+
+      struct OutputBuffer {
+        // The elements produced by one worker thread, in order. The producer
+        // appends at most `dataset()->buffer_output_elements_` of them.
+        std::deque<OutputBufferElement> elements;
+        // The producer thread waits on this condition variable while the
+        // buffer is full. The reader thread notifies this condition variable
+        // after reading a value.
         condition_variable cond_var;
       };
 
@@ -235,32 +269,77 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
       Status EnsureWorkerThreadsStarted(IteratorContext* ctx)
           EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         if (worker_threads_.empty()) {
+          worker_threads_.reserve(dataset()->max_cycle_length_);
           for (int64 i = 0; i < dataset()->cycle_length_; ++i) {
             // Serialize the creation of the workers and their corresponding
             // input elements to ensure we match the standard interleave when
             // the underlying iterators induce no delay.
-            std::vector<Tensor> args;
-            TF_RETURN_IF_ERROR(
-                input_impl_->GetNext(ctx, &args, &end_of_input_));
+            TF_RETURN_IF_ERROR(StartWorkerThread(ctx));
             if (end_of_input_) {
               LOG(WARNING) << "Input iterator exhausted after " << i
                            << " elements; cannot start all "
                            << dataset()->cycle_length_ << " worker threads.";
               return Status::OK();
             }
-            std::unique_ptr<IteratorBase> itr;
-            TF_RETURN_IF_ERROR(dataset::MakeIteratorFromInputElement(
-                ctx, args, i, dataset()->captured_func_.get(), prefix(), &itr));
-            worker_threads_.emplace_back(ctx->env()->StartThread(
-                {}, "worker_thread",
-                std::bind(&Iterator::WorkerThread, this,
-                          new IteratorContext(*ctx), i, itr.release())));
-            num_active_threads_ = i + 1;
           }
         }
         return Status::OK();
       }
 
+      // Starts a worker thread on the next input element, unless the input
+      // is exhausted.
+      Status StartWorkerThread(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const int64 thread_index = worker_threads_.size();
+        std::vector<Tensor> args;
+        TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &args, &end_of_input_));
+        if (end_of_input_) {
+          return Status::OK();
+        }
+        std::unique_ptr<IteratorBase> itr;
+        TF_RETURN_IF_ERROR(dataset::MakeIteratorFromInputElement(
+            ctx, args, thread_index, dataset()->captured_func_.get(), prefix(),
+            &itr));
+        worker_threads_.emplace_back(ctx->env()->StartThread(
+            {}, "worker_thread",
+            std::bind(&Iterator::WorkerThread, this, new IteratorContext(*ctx),
+                      thread_index, itr.release())));
+        num_active_threads_++;
+        return Status::OK();
+      }
+
+      // Removes the oldest element from the buffer of `thread_index`, and
+      // wakes up the producers that may now have space for another one.
+      void PopOutputElement(int64 thread_index) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        OutputBuffer& buffer = output_buffers_[thread_index];
+        buffered_bytes_ -= buffer.elements.front().bytes;
+        buffer.elements.pop_front();
+        if (dataset()->max_buffered_bytes_ > 0) {
+          // The memory budget is shared, so any producer may be waiting.
+          for (OutputBuffer& other : output_buffers_) {
+            other.cond_var.notify_one();
+          }
+        } else {
+          buffer.cond_var.notify_one();
+        }
+      }
+
+      // Returns true if the producer for `thread_index` must wait before
+      // appending an element of `bytes` bytes to its buffer.
+      bool IsOutputBufferFull(int64 thread_index, int64 bytes)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const OutputBuffer& buffer = output_buffers_[thread_index];
+        if (static_cast<int64>(buffer.elements.size()) >=
+            dataset()->buffer_output_elements_) {
+          return true;
+        }
+        // Every input may buffer one element regardless of the memory budget,
+        // so that an input with large elements cannot be starved.
+        return dataset()->max_buffered_bytes_ > 0 &&
+               !buffer.elements.empty() &&
+               buffered_bytes_ + bytes > dataset()->max_buffered_bytes_;
+      }
+
       void BlockAndUpdateOutputBuffer(mutex_lock* l, const int64 thread_index,
                                       const Status& status,
                                       bool end_of_sequence,
@@ -268,19 +347,27 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
           EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         // We have produced an element; push it into the output buffer
         // when space is available.
-        while (!cancelled_ && output_elements_[thread_index].is_produced) {
-          output_elements_[thread_index].cond_var.wait(*l);
+        int64 bytes = 0;
+        if (status.ok()) {
+          for (const Tensor& t : *out_tensors) {
+            bytes += t.TotalBytes();
+          }
+        }
+        OutputBuffer& buffer = output_buffers_[thread_index];
+        while (!cancelled_ && IsOutputBufferFull(thread_index, bytes)) {
+          buffer.cond_var.wait(*l);
         }
         if (cancelled_) {
           return;
         }
-        output_elements_[thread_index].is_produced = true;
-        output_elements_[thread_index].output_status = status;
-        output_elements_[thread_index].end_of_sequence = end_of_sequence;
+        buffer.elements.emplace_back();
+        OutputBufferElement& element = buffer.elements.back();
+        element.output_status = status;
+        element.end_of_sequence = end_of_sequence;
         if (status.ok()) {
-          output_elements_[thread_index].output_value.swap(*out_tensors);
-        } else {
-          output_elements_[thread_index].output_value.clear();
+          element.output_value.swap(*out_tensors);
+          element.bytes = bytes;
+          buffered_bytes_ += bytes;
         }
         cond_var_.notify_one();
       }
@@ -362,9 +449,12 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
       const std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
       // Whether the input_impl_ can produce future elements.
       bool end_of_input_ GUARDED_BY(mu_) = false;
-      // The buffer of elements to be produced. Each worker thread operates
-      // on a single OutputBufferElement.
-      std::vector<OutputBufferElement> output_elements_ GUARDED_BY(mu_);
+      // The buffers of elements to be produced. Each worker thread operates
+      // on a single OutputBuffer, and the cycle can widen up to the number of
+      // buffers.
+      std::vector<OutputBuffer> output_buffers_ GUARDED_BY(mu_);
+      // The total size of the elements in `output_buffers_`.
+      int64 buffered_bytes_ GUARDED_BY(mu_) = 0;
       // The index into output_elements_ for next element to produce.
       size_t next_index_ GUARDED_BY(mu_) = 0;
       // The number of items produced so far within the block
@@ -384,11 +474,17 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
     const int64 cycle_length_;
     const int64 block_length_;
     const bool sloppy_;
+    const int64 buffer_output_elements_;
+    const int64 max_cycle_length_;
+    const int64 max_buffered_bytes_;
     const DataTypeVector output_types_;
     const std::vector<PartialTensorShape> output_shapes_;
   };
 
   const int graph_def_version_;
+  int64 buffer_output_elements_;
+  int64 max_cycle_length_;
+  int64 max_buffered_bytes_;
   DataTypeVector output_types_;
   std::vector<PartialTensorShape> output_shapes_;
   NameAttrList func_;
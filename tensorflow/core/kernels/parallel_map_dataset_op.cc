@@ -22,6 +22,8 @@ limitations under the License.
 #include "tensorflow/core/lib/random/random.h"
 
 #include "tensorflow/core/kernels/captured_function.h"
+#include "tensorflow/core/kernels/dataset_autotune.h"
+#include "tensorflow/core/platform/cpu_info.h"
 
 namespace tensorflow {
 
@@ -54,9 +56,12 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
     int32 num_parallel_calls;
     OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, "num_parallel_calls",
                                             &num_parallel_calls));
-    OP_REQUIRES(ctx, num_parallel_calls > 0,
+    OP_REQUIRES(ctx,
+                num_parallel_calls > 0 ||
+                    num_parallel_calls == dataset::kAutoTune,
                 errors::InvalidArgument(
-                    "num_parallel_calls must be greater than zero."));
+                    "num_parallel_calls must be greater than zero, or ",
+                    dataset::kAutoTune, " to tune it automatically."));
 
     std::unique_ptr<CapturedFunction> captured_func;
     OP_REQUIRES_OK(ctx, CapturedFunction::Create(ctx, func_, graph_def_version_,
@@ -105,8 +110,12 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
      public:
       explicit Iterator(const Params& params)
           : DatasetIterator<Dataset>(params),
-            input_impl_(params.dataset->input_->MakeIterator(params.prefix)),
-            invocation_results_(params.dataset->num_parallel_calls_) {}
+            input_impl_(params.dataset->input_->MakeIterator(params.prefix)) {
+        if (dataset()->num_parallel_calls_ == dataset::kAutoTune) {
+          auto_tuner_.reset(new dataset::AutoTuner(
+              dataset::AutoTuner::Resource::kCpu, port::NumSchedulableCPUs()));
+        }
+      }
 
       ~Iterator() override {
         // TODO(mrry): Replace this cancellation logic with a
@@ -116,9 +125,9 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
         // potentially-blocking iterators, when we add these.
         {
           mutex_lock l(mu_);
-          for (size_t i = 0; i < dataset()->num_parallel_calls_; ++i) {
-            if (invocation_results_[i].notification) {
-              invocation_results_[i].notification->WaitForNotification();
+          for (const auto& result : invocation_results_) {
+            if (result->notification) {
+              result->notification->WaitForNotification();
             }
           }
         }
@@ -129,31 +138,47 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
 
-        // Ensure that there are `dataset()->num_parallel_calls_`
-        // invocations of `func_` outstanding at once.
-        while (!end_of_input_ && (num_inputs_consumed_ - num_outputs_consumed_ <
-                                  dataset()->num_parallel_calls_)) {
+        // Ensure that there are `num_parallel_calls()` invocations of
+        // `func_` outstanding at once.
+        while (!end_of_input_ &&
+               invocation_results_.size() < num_parallel_calls()) {
           InvokeFunctionLocked(ctx);
         }
 
-        if (end_of_input_ && num_inputs_consumed_ == num_outputs_consumed_) {
+        if (invocation_results_.empty()) {
           *end_of_sequence = true;
           return Status::OK();
         }
 
-        // Read the next result out of `invocation_results_`, which
-        // acts as a circular buffer.
-        const size_t result_index =
-            num_outputs_consumed_ % dataset()->num_parallel_calls_;
-        InvocationResult* result = &invocation_results_[result_index];
+        dataset::StatsCollector* stats = ctx->stats_collector();
+        if (stats != nullptr && stats->enabled()) {
+          int64 num_ready = 0;
+          for (const auto& result : invocation_results_) {
+            if (!result->notification ||
+                result->notification->HasBeenNotified()) {
+              ++num_ready;
+            }
+          }
+          stats->RecordBufferOccupancy(prefix(), num_ready,
+                                       num_parallel_calls());
+        }
+
+        // Read the oldest result out of `invocation_results_`.
+        std::unique_ptr<InvocationResult> result =
+            std::move(invocation_results_.front());
+        invocation_results_.pop_front();
         *end_of_sequence = false;
+        bool waited = false;
         if (result->notification) {
+          waited = !result->notification->HasBeenNotified();
           result->notification->WaitForNotification();
           if (result->status.ok()) {
             std::swap(*out_tensors, result->return_values);
           }
         }
-        ++num_outputs_consumed_;
+        if (auto_tuner_) {
+          auto_tuner_->RecordConsumer(waited, 0);
+        }
         return result->status;
       }
 
@@ -164,29 +189,32 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
         std::vector<Tensor> return_values;
       };
 
+      // Returns the number of invocations of `func_` that may be
+      // outstanding at once.
+      size_t num_parallel_calls() const EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return auto_tuner_ ? auto_tuner_->value()
+                           : dataset()->num_parallel_calls_;
+      }
+
       void InvokeFunctionLocked(IteratorContext* ctx)
           EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         DCHECK(!end_of_input_);
-        DCHECK(num_inputs_consumed_ - num_outputs_consumed_ <
-               dataset()->num_parallel_calls_);
-
-        // The result of invoking the function will be written into the next
-        // slot in `invocation_results_`, which acts as a circular buffer.
-        const size_t result_index =
-            num_inputs_consumed_ % dataset()->num_parallel_calls_;
-        InvocationResult* result = &invocation_results_[result_index];
-        *result = InvocationResult();
+        DCHECK(invocation_results_.size() < num_parallel_calls());
 
         // Get the next input element.
+        std::unique_ptr<InvocationResult> owned_result(new InvocationResult);
+        InvocationResult* result = owned_result.get();
         std::vector<Tensor> input_element;
         result->status =
             input_impl_->GetNext(ctx, &input_element, &end_of_input_);
         if (end_of_input_) {
-          result->status = errors::OutOfRange("");
-        } else {
-          ++num_inputs_consumed_;
+          return;
         }
 
+        // The result of invoking the function will be written into the
+        // newest entry of `invocation_results_`, which is consumed in order.
+        invocation_results_.push_back(std::move(owned_result));
+
         if (result->status.ok()) {
           // Call `func_(input_element)`, store the result in
           // `result->return_values`, and notify `result->notification`
@@ -206,7 +234,7 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
           opts.runner = ctx->runner();
           dataset()->captured_func_->RunAsync(
               opts, input_element, &result->return_values,
-              [result, step_container, result_index](Status ret_status) {
+              [result, step_container](Status ret_status) {
                 delete step_container;
                 result->status.Update(ret_status);
                 result->notification->Notify();
@@ -216,10 +244,13 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
 
       mutex mu_;
       const std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
-      std::vector<InvocationResult> invocation_results_ GUARDED_BY(mu_);
+      std::deque<std::unique_ptr<InvocationResult>> invocation_results_
+          GUARDED_BY(mu_);
       bool end_of_input_ GUARDED_BY(mu_) = false;
-      int64 num_inputs_consumed_ GUARDED_BY(mu_) = 0;
-      int64 num_outputs_consumed_ GUARDED_BY(mu_) = 0;
+      // Set if the dataset was created with `num_parallel_calls ==
+      // kAutoTune`, in which case it raises the number of outstanding
+      // invocations while the consumer is starved.
+      std::unique_ptr<dataset::AutoTuner> auto_tuner_ GUARDED_BY(mu_);
     };
 
     const DatasetBase* const input_;
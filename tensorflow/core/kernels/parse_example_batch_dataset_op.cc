@@ -0,0 +1,221 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/dataset.h"
+
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/example_proto_fast_parsing.h"
+#include "tensorflow/core/util/example_proto_helper.h"
+
+namespace tensorflow {
+
+namespace {
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class ParseExampleBatchDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit ParseExampleBatchDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, attrs_.Init(ctx));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+  }
+
+ protected:
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    OP_REQUIRES(
+        ctx,
+        input->output_dtypes() == DataTypeVector({DT_STRING}) &&
+            input->output_shapes()[0].IsCompatibleWith(TensorShape({})),
+        errors::InvalidArgument(
+            "`input_dataset` must produce scalar strings, but produces ",
+            DataTypeVectorString(input->output_dtypes())));
+
+    int64 batch_size = 0;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<int64>(ctx, "batch_size", &batch_size));
+    OP_REQUIRES(
+        ctx, batch_size > 0,
+        errors::InvalidArgument("Batch size must be greater than zero."));
+
+    OpInputList sparse_keys;
+    OpInputList dense_keys;
+    OpInputList dense_defaults;
+    OP_REQUIRES_OK(ctx, ctx->input_list("sparse_keys", &sparse_keys));
+    OP_REQUIRES_OK(ctx, ctx->input_list("dense_keys", &dense_keys));
+    OP_REQUIRES_OK(ctx, ctx->input_list("dense_defaults", &dense_defaults));
+
+    example::FastParseExampleConfig config;
+    for (int d = 0; d < attrs_.num_dense; ++d) {
+      const Tensor& def_value = dense_defaults[d];
+      if (attrs_.variable_length[d]) {
+        OP_REQUIRES(ctx, def_value.NumElements() == 1,
+                    errors::InvalidArgument(
+                        "dense_shape[", d, "] is a variable length shape: ",
+                        attrs_.dense_shapes[d].DebugString(),
+                        ", therefore def_value[", d,
+                        "] must contain a single element (the padding "
+                        "element). But its shape is: ",
+                        def_value.shape().DebugString()));
+      } else if (def_value.NumElements() > 0) {
+        OP_REQUIRES(ctx,
+                    attrs_.dense_shapes[d].IsCompatibleWith(def_value.shape()),
+                    errors::InvalidArgument(
+                        "def_value[", d,
+                        "].shape() == ", def_value.shape().DebugString(),
+                        " is not compatible with dense_shapes_[", d,
+                        "] == ", attrs_.dense_shapes[d].DebugString()));
+      }
+      config.dense.push_back({dense_keys[d].scalar<string>()(),
+                              attrs_.dense_types[d], attrs_.dense_shapes[d],
+                              def_value, attrs_.variable_length[d],
+                              attrs_.elements_per_stride[d]});
+    }
+    for (int d = 0; d < attrs_.num_sparse; ++d) {
+      config.sparse.push_back(
+          {sparse_keys[d].scalar<string>()(), attrs_.sparse_types[d]});
+    }
+
+    *output = new Dataset(input, batch_size, std::move(config), output_types_,
+                          output_shapes_,
+                          ctx->device()->tensorflow_cpu_worker_threads());
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(const DatasetBase* input, int64 batch_size,
+            example::FastParseExampleConfig config,
+            const DataTypeVector& output_types,
+            const std::vector<PartialTensorShape>& output_shapes,
+            const DeviceBase::CpuWorkerThreads* worker_threads)
+        : input_(input),
+          batch_size_(batch_size),
+          config_(std::move(config)),
+          output_types_(output_types),
+          output_shapes_(output_shapes),
+          worker_threads_(worker_threads) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIterator(
+        const string& prefix) const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(
+          {this, strings::StrCat(prefix, "::ParseExampleBatch")}));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return output_types_;
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() override {
+      return strings::StrCat("ParseExampleBatchDatasetOp(", batch_size_,
+                             ")::Dataset");
+    }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params),
+            input_impl_(params.dataset->input_->MakeIterator(params.prefix)) {}
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        // The records are gathered into contiguous storage, which is what
+        // `FastParseExample()` consumes. This is the only copy of the
+        // serialized bytes: the parsed values are written directly into the
+        // batched output tensors.
+        std::vector<string> serialized;
+        serialized.reserve(dataset()->batch_size_);
+        {
+          mutex_lock l(mu_);
+          *end_of_sequence = false;
+          for (int i = 0; i < dataset()->batch_size_ && !*end_of_sequence;
+               ++i) {
+            std::vector<Tensor> record;
+            TF_RETURN_IF_ERROR(
+                input_impl_->GetNext(ctx, &record, end_of_sequence));
+            if (!*end_of_sequence) {
+              serialized.push_back(record[0].scalar<string>()());
+            }
+          }
+        }
+
+        if (serialized.empty()) {
+          DCHECK(*end_of_sequence);
+          return Status::OK();
+        }
+
+        example::Result result;
+        TF_RETURN_IF_ERROR(example::FastParseExample(
+            dataset()->config_, serialized, gtl::ArraySlice<string>(),
+            dataset()->worker_threads_->workers, &result));
+
+        // The components are in the order of the outputs of "ParseExample".
+        const size_t num_sparse = dataset()->config_.sparse.size();
+        out_tensors->reserve(3 * num_sparse + result.dense_values.size());
+        for (size_t d = 0; d < num_sparse; ++d) {
+          out_tensors->push_back(std::move(result.sparse_indices[d]));
+        }
+        for (size_t d = 0; d < num_sparse; ++d) {
+          out_tensors->push_back(std::move(result.sparse_values[d]));
+        }
+        for (size_t d = 0; d < num_sparse; ++d) {
+          out_tensors->push_back(std::move(result.sparse_shapes[d]));
+        }
+        for (Tensor& dense_value : result.dense_values) {
+          out_tensors->push_back(std::move(dense_value));
+        }
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
+     private:
+      mutex mu_;
+      std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+    };
+
+    const DatasetBase* const input_;
+    const int64 batch_size_;
+    const example::FastParseExampleConfig config_;
+    const DataTypeVector output_types_;
+    const std::vector<PartialTensorShape> output_shapes_;
+    const DeviceBase::CpuWorkerThreads* const worker_threads_;
+  };
+
+  ParseSingleExampleAttrs attrs_;
+  DataTypeVector output_types_;
+  std::vector<PartialTensorShape> output_shapes_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("ParseExampleBatchDataset").Device(DEVICE_CPU),
+                        ParseExampleBatchDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
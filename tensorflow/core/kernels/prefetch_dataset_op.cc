@@ -17,6 +17,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/dataset.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/dataset_autotune.h"
 
 namespace tensorflow {
 
@@ -86,7 +87,15 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
      public:
       explicit Iterator(const Params& params)
           : DatasetIterator<Dataset>(params),
-            input_impl_(params.dataset->input_->MakeIterator(params.prefix)) {}
+            input_impl_(params.dataset->input_->MakeIterator(params.prefix)) {
+        if (dataset()->buffer_size_ == dataset::kAutoTune) {
+          auto_tuner_.reset(new dataset::AutoTuner(
+              dataset::AutoTuner::Resource::kRam, kint64max));
+          buffer_limit_ = auto_tuner_->value();
+        } else {
+          buffer_limit_ = dataset()->buffer_size_;
+        }
+      }
 
       ~Iterator() override {
         // Signal the prefetch thread to terminate it. We will then
@@ -109,11 +118,18 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
         TF_RETURN_IF_ERROR(EnsurePrefetchThreadStarted(ctx));
+        dataset::StatsCollector* stats = ctx->stats_collector();
+        if (stats != nullptr && stats->enabled()) {
+          stats->RecordBufferOccupancy(prefix(), buffer_.size(),
+                                       buffer_limit_);
+        }
 
+        bool waited = false;
         while (true) {
           // Wait until the next element in the buffer has been
           // produced, or we are shutting down.
           while (!cancelled_ && !prefetch_thread_finished_ && buffer_.empty()) {
+            waited = true;
             cond_var_.wait(l);
           }
 
@@ -133,6 +149,16 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
             buffer_.pop_front();
             *end_of_sequence = false;
 
+            if (auto_tuner_) {
+              int64 element_bytes = 0;
+              for (const Tensor& t : *out_tensors) {
+                element_bytes += t.TotalBytes();
+              }
+              if (auto_tuner_->RecordConsumer(waited, element_bytes)) {
+                buffer_limit_ = auto_tuner_->value();
+              }
+            }
+
             // Wake the prefetch thread, in case it has been waiting
             // for space in the buffer.
             cond_var_.notify_one();
@@ -177,7 +203,8 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
           // 1. Wait for a slot in the buffer.
           {
             mutex_lock l(mu_);
-            while (!cancelled_ && buffer_.size() == dataset()->buffer_size_) {
+            while (!cancelled_ && buffer_.size() == buffer_limit_) {
+              if (auto_tuner_) auto_tuner_->RecordProducerWait();
               cond_var_.wait(l);
             }
 
@@ -214,6 +241,11 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
       std::unique_ptr<Thread> prefetch_thread_ GUARDED_BY(mu_);
       bool cancelled_ GUARDED_BY(mu_) = false;
       bool prefetch_thread_finished_ GUARDED_BY(mu_) = false;
+      // The number of elements that the prefetch thread may buffer. If the
+      // dataset was created with `buffer_size == kAutoTune`, `auto_tuner_`
+      // grows this limit while the consumer is starved.
+      int64 buffer_limit_ GUARDED_BY(mu_);
+      std::unique_ptr<dataset::AutoTuner> auto_tuner_ GUARDED_BY(mu_);
     };
 
     const DatasetBase* const input_;
@@ -22,12 +22,14 @@ limitations under the License.
 #include <algorithm>
 #include <cmath>
 #include <memory>
+#include <type_traits>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/random/philox_batch.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/logging.h"
@@ -72,6 +74,55 @@ struct FillPhiloxRandom {
 template <class Distribution, bool VariableSamplesPerOutput>
 struct FillPhiloxRandomTask;
 
+// The distributions that convert each sample of PhiloxRandom into one group
+// by themselves, i.e. without calling the generator again. They get their
+// samples from FillPhiloxSamples(), which computes several at once.
+template <class Distribution>
+struct BatchedSamples {
+  static const bool kSupported = false;
+};
+
+template <>
+struct BatchedSamples<random::UniformDistribution<PhiloxRandom, float>> {
+  static const bool kSupported = true;
+  static void Convert(const uint32* samples, int64 num_groups, float* data) {
+    random::Uint32ToFloats(samples, 4 * num_groups, data);
+  }
+};
+
+template <>
+struct BatchedSamples<random::UniformDistribution<PhiloxRandom, double>> {
+  static const bool kSupported = true;
+  static void Convert(const uint32* samples, int64 num_groups, double* data) {
+    for (int64 i = 0; i < 2 * num_groups; ++i) {
+      data[i] = random::Uint64ToDouble(samples[2 * i], samples[2 * i + 1]);
+    }
+  }
+};
+
+template <>
+struct BatchedSamples<random::NormalDistribution<PhiloxRandom, float>> {
+  static const bool kSupported = true;
+  static void Convert(const uint32* samples, int64 num_groups, float* data) {
+    for (int64 i = 0; i < 4 * num_groups; i += 2) {
+      random::BoxMullerFloat(samples[i], samples[i + 1], &data[i],
+                             &data[i + 1]);
+    }
+  }
+};
+
+template <>
+struct BatchedSamples<random::NormalDistribution<PhiloxRandom, double>> {
+  static const bool kSupported = true;
+  static void Convert(const uint32* samples, int64 num_groups, double* data) {
+    for (int64 i = 0; i < 2 * num_groups; i += 2) {
+      const int64 i2 = 2 * i;
+      random::BoxMullerDouble(samples[i2], samples[i2 + 1], samples[i2 + 2],
+                              samples[i2 + 3], &data[i], &data[i + 1]);
+    }
+  }
+};
+
 // Specialization for distribution that takes a fixed number of samples for
 // each output.
 template <class Distribution>
@@ -86,11 +137,12 @@ struct FillPhiloxRandomTask<Distribution, false> {
 
     // First fill all the full-size groups
     int64 limit_group_full = std::min(limit_group, size / kGroupSize);
-    for (int64 index = start_group; index < limit_group_full; ++index) {
-      auto samples = dist(&gen);
-      std::copy(&samples[0], &samples[0] + kGroupSize, data + offset);
-      offset += kGroupSize;
-    }
+    typedef std::integral_constant<bool,
+                                   BatchedSamples<Distribution>::kSupported>
+        Batched;
+    FillGroups(Batched(), &gen, data + offset, limit_group_full - start_group,
+               &dist);
+    offset = limit_group_full * kGroupSize;
 
     // If there are any remaining elements that need to be filled, process them
     if (limit_group_full < limit_group) {
@@ -99,6 +151,32 @@ struct FillPhiloxRandomTask<Distribution, false> {
       std::copy(&samples[0], &samples[0] + remaining_size, data + offset);
     }
   }
+
+ private:
+  static void FillGroups(std::false_type, PhiloxRandom* gen, T* data,
+                         int64 num_groups, Distribution* dist) {
+    const int kGroupSize = Distribution::kResultElementCount;
+    for (int64 index = 0; index < num_groups; ++index) {
+      auto samples = (*dist)(gen);
+      std::copy(&samples[0], &samples[0] + kGroupSize, data);
+      data += kGroupSize;
+    }
+  }
+
+  static void FillGroups(std::true_type, PhiloxRandom* gen, T* data,
+                         int64 num_groups, Distribution*) {
+    const int kGroupSize = Distribution::kResultElementCount;
+    // The samples of 256 groups take 4KB.
+    const int64 kBatchGroups = 256;
+    uint32 samples[kBatchGroups * PhiloxRandom::kResultElementCount];
+    while (num_groups > 0) {
+      const int64 batch = std::min(num_groups, kBatchGroups);
+      random::FillPhiloxSamples(gen, batch, samples);
+      BatchedSamples<Distribution>::Convert(samples, batch, data);
+      data += batch * kGroupSize;
+      num_groups -= batch;
+    }
+  }
 };
 
 // Specialization for distribution that takes a variable number of samples for
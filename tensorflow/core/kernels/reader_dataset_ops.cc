@@ -22,6 +22,9 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/random/random_distributions.h"
 
 namespace tensorflow {
 
@@ -486,7 +489,13 @@ REGISTER_KERNEL_BUILDER(Name("FixedLengthRecordDataset").Device(DEVICE_CPU),
 
 class TFRecordDatasetOp : public DatasetOpKernel {
  public:
-  using DatasetOpKernel::DatasetOpKernel;
+  explicit TFRecordDatasetOp(OpKernelConstruction* ctx)
+      : DatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(
+        ctx, ctx->GetAttr("num_readahead_chunks", &num_readahead_chunks_));
+    OP_REQUIRES_OK(
+        ctx, ctx->GetAttr("use_memory_mapping", &use_memory_mapping_));
+  }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
     const Tensor* filenames_tensor;
@@ -512,20 +521,28 @@ class TFRecordDatasetOp : public DatasetOpKernel {
                 errors::InvalidArgument(
                     "`buffer_size` must be >= 0 (0 == no buffering)"));
 
-    *output = new Dataset(std::move(filenames), compression_type, buffer_size);
+    *output = new Dataset(std::move(filenames), compression_type, buffer_size,
+                          num_readahead_chunks_, use_memory_mapping_);
   }
 
  private:
   class Dataset : public DatasetBase {
    public:
     explicit Dataset(std::vector<string> filenames,
-                     const string& compression_type, int64 buffer_size)
+                     const string& compression_type, int64 buffer_size,
+                     int num_readahead_chunks, bool use_memory_mapping)
         : filenames_(std::move(filenames)),
           options_(io::RecordReaderOptions::CreateRecordReaderOptions(
-              compression_type)) {
+              compression_type)),
+          // Compressed records must be inflated into a separate buffer, so
+          // mapping the file would not save a copy.
+          use_memory_mapping_(use_memory_mapping &&
+                              options_.compression_type ==
+                                  io::RecordReaderOptions::NONE) {
       if (buffer_size > 0) {
         options_.buffer_size = buffer_size;
       }
+      options_.num_readahead_chunks = num_readahead_chunks;
     }
 
     std::unique_ptr<IteratorBase> MakeIterator(
@@ -558,6 +575,27 @@ class TFRecordDatasetOp : public DatasetOpKernel {
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
         do {
+          // We are currently processing a mapped file, so try to read the
+          // next record directly from the mapping.
+          if (mapped_reader_) {
+            StringPiece record;
+            Status s = mapped_reader_->ReadRecord(&mapped_offset_, &record);
+            if (s.ok()) {
+              Tensor result_tensor(cpu_allocator(), DT_STRING, {});
+              result_tensor.scalar<string>()().assign(record.data(),
+                                                      record.size());
+              out_tensors->emplace_back(std::move(result_tensor));
+              *end_of_sequence = false;
+              return Status::OK();
+            } else if (!errors::IsOutOfRange(s)) {
+              return s;
+            }
+
+            mapped_reader_.reset();
+            region_.reset();
+            ++current_file_index_;
+          }
+
           // We are currently processing a file, so try to read the next record.
           if (reader_) {
             Tensor result_tensor(cpu_allocator(), DT_STRING, {});
@@ -586,6 +624,28 @@ class TFRecordDatasetOp : public DatasetOpKernel {
           // Actually move on to next file.
           const string& next_filename =
               dataset()->filenames_[current_file_index_];
+          if (dataset()->use_memory_mapping_) {
+            uint64 file_size;
+            TF_RETURN_IF_ERROR(
+                ctx->env()->GetFileSize(next_filename, &file_size));
+            if (file_size == 0) {
+              // An empty file cannot be mapped, but it holds no records.
+              ++current_file_index_;
+              continue;
+            }
+            Status s = ctx->env()->NewReadOnlyMemoryRegionFromFile(
+                next_filename, &region_);
+            if (s.ok()) {
+              mapped_offset_ = 0;
+              mapped_reader_.reset(
+                  new io::MemoryMappedRecordReader(region_.get()));
+              continue;
+            } else if (!errors::IsUnimplemented(s)) {
+              return s;
+            }
+            // The file system cannot map files, so read this one through a
+            // RandomAccessFile instead.
+          }
           TF_RETURN_IF_ERROR(
               ctx->env()->NewRandomAccessFile(next_filename, &file_));
           reader_.reset(
@@ -601,16 +661,220 @@ class TFRecordDatasetOp : public DatasetOpKernel {
       // we must destroy `reader_` before `file_`.
       std::unique_ptr<RandomAccessFile> file_ GUARDED_BY(mu_);
       std::unique_ptr<io::SequentialRecordReader> reader_ GUARDED_BY(mu_);
+
+      // Likewise, `mapped_reader_` borrows the mapping in `region_`.
+      std::unique_ptr<ReadOnlyMemoryRegion> region_ GUARDED_BY(mu_);
+      std::unique_ptr<io::MemoryMappedRecordReader> mapped_reader_
+          GUARDED_BY(mu_);
+      uint64 mapped_offset_ GUARDED_BY(mu_) = 0;
     };
 
     const std::vector<string> filenames_;
     io::RecordReaderOptions options_;
+    const bool use_memory_mapping_;
   };
+
+  int num_readahead_chunks_;
+  bool use_memory_mapping_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("TFRecordDataset").Device(DEVICE_CPU),
                         TFRecordDatasetOp);
 
+class ShuffledTFRecordDatasetOp : public DatasetOpKernel {
+ public:
+  explicit ShuffledTFRecordDatasetOp(OpKernelConstruction* ctx)
+      : DatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("reshuffle_each_iteration",
+                                     &reshuffle_each_iteration_));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
+    const Tensor* filenames_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("filenames", &filenames_tensor));
+    OP_REQUIRES(
+        ctx, filenames_tensor->dims() <= 1,
+        errors::InvalidArgument("`filenames` must be a scalar or a vector."));
+
+    std::vector<string> filenames;
+    filenames.reserve(filenames_tensor->NumElements());
+    for (int i = 0; i < filenames_tensor->NumElements(); ++i) {
+      filenames.push_back(filenames_tensor->flat<string>()(i));
+    }
+
+    int64 buffer_size = -1;
+    OP_REQUIRES_OK(
+        ctx, ParseScalarArgument<int64>(ctx, "buffer_size", &buffer_size));
+    OP_REQUIRES(ctx, buffer_size >= 0,
+                errors::InvalidArgument("`buffer_size` must be >= 0"));
+    if (buffer_size == 0) {
+      buffer_size = 256 << 10;  // 256 kB as default.
+    }
+
+    int64 seed;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "seed", &seed));
+
+    int64 seed2;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "seed2", &seed2));
+
+    // By TensorFlow convention, passing 0 for both seeds indicates
+    // that the shuffling should be seeded non-deterministically.
+    if (seed == 0 && seed2 == 0) {
+      seed = random::New64();
+      seed2 = random::New64();
+    }
+
+    *output = new Dataset(std::move(filenames), buffer_size, seed, seed2,
+                          reshuffle_each_iteration_);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(std::vector<string> filenames, int64 buffer_size, int64 seed,
+            int64 seed2, bool reshuffle_each_iteration)
+        : filenames_(std::move(filenames)),
+          buffer_size_(buffer_size),
+          seed_(seed),
+          seed2_(seed2),
+          reshuffle_each_iteration_(reshuffle_each_iteration),
+          parent_generator_(seed, seed2),
+          generator_(&parent_generator_) {}
+
+    std::unique_ptr<IteratorBase> MakeIterator(
+        const string& prefix) const override {
+      int64 iterator_seed = seed_;
+      int64 iterator_seed2 = seed2_;
+      if (reshuffle_each_iteration_) {
+        mutex_lock l(mu_);
+        iterator_seed = generator_();
+        iterator_seed2 = generator_();
+      }
+      return std::unique_ptr<IteratorBase>(
+          new Iterator({this, strings::StrCat(prefix, "::ShuffledTFRecord")},
+                       iterator_seed, iterator_seed2));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      static DataTypeVector* dtypes = new DataTypeVector({DT_STRING});
+      return *dtypes;
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      static std::vector<PartialTensorShape>* shapes =
+          new std::vector<PartialTensorShape>({{}});
+      return *shapes;
+    }
+
+    string DebugString() override {
+      return strings::StrCat("ShuffledTFRecordDatasetOp(", seed_, ", ", seed2_,
+                             ")::Dataset");
+    }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      Iterator(const Params& params, int64 seed, int64 seed2)
+          : DatasetIterator<Dataset>(params),
+            parent_generator_(seed, seed2),
+            generator_(&parent_generator_) {}
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        if (!index_built_) {
+          TF_RETURN_IF_ERROR(BuildIndex(ctx->env()));
+          index_built_ = true;
+        }
+        if (next_ == index_.size()) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+
+        // Draw the next record uniformly from the ones not yet produced,
+        // i.e. run one step of a Fisher-Yates shuffle over the index.
+        const uint64 sample =
+            (static_cast<uint64>(generator_()) << 32) | generator_();
+        std::swap(index_[next_],
+                  index_[next_ + sample % (index_.size() - next_)]);
+        const RecordLocation& location = index_[next_++];
+
+        uint64 offset = location.offset;
+        Tensor result_tensor(cpu_allocator(), DT_STRING, {});
+        TF_RETURN_IF_ERROR(readers_[location.file_index]->ReadRecord(
+            &offset, &result_tensor.scalar<string>()()));
+        out_tensors->emplace_back(std::move(result_tensor));
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
+     private:
+      // Where one record starts in `dataset()->filenames_`.
+      struct RecordLocation {
+        uint64 offset;
+        size_t file_index;
+      };
+
+      // Records the location of every record by reading each file
+      // sequentially, skipping over the record data, and opens the files
+      // for random access.
+      Status BuildIndex(Env* env) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        io::RecordReaderOptions scan_options;
+        scan_options.buffer_size = dataset()->buffer_size_;
+        for (size_t i = 0; i < dataset()->filenames_.size(); ++i) {
+          std::unique_ptr<RandomAccessFile> file;
+          TF_RETURN_IF_ERROR(
+              env->NewRandomAccessFile(dataset()->filenames_[i], &file));
+          io::RecordReader scanner(file.get(), scan_options);
+          uint64 offset = 0;
+          while (true) {
+            const uint64 record_offset = offset;
+            Status s = scanner.SkipRecord(&offset);
+            if (errors::IsOutOfRange(s)) break;
+            TF_RETURN_IF_ERROR(s);
+            index_.push_back({record_offset, i});
+          }
+          readers_.emplace_back(new io::RecordReader(file.get()));
+          files_.push_back(std::move(file));
+        }
+        VLOG(1) << "Indexed " << index_.size() << " records in "
+                << dataset()->filenames_.size() << " files.";
+        return Status::OK();
+      }
+
+      mutex mu_;
+      bool index_built_ GUARDED_BY(mu_) = false;
+      // The first `next_` entries of `index_` have been produced.
+      std::vector<RecordLocation> index_ GUARDED_BY(mu_);
+      size_t next_ GUARDED_BY(mu_) = 0;
+      // `readers_` borrow the objects that `files_` point to, so
+      // they must be destroyed first.
+      std::vector<std::unique_ptr<RandomAccessFile>> files_ GUARDED_BY(mu_);
+      std::vector<std::unique_ptr<io::RecordReader>> readers_
+          GUARDED_BY(mu_);
+      random::PhiloxRandom parent_generator_ GUARDED_BY(mu_);
+      random::SingleSampleAdapter<random::PhiloxRandom> generator_
+          GUARDED_BY(mu_);
+    };
+
+    const std::vector<string> filenames_;
+    const int64 buffer_size_;
+    const int64 seed_;
+    const int64 seed2_;
+    const bool reshuffle_each_iteration_;
+    mutable mutex mu_;
+    mutable random::PhiloxRandom parent_generator_ GUARDED_BY(mu_);
+    mutable random::SingleSampleAdapter<random::PhiloxRandom> generator_
+        GUARDED_BY(mu_);
+  };
+
+  bool reshuffle_each_iteration_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("ShuffledTFRecordDataset").Device(DEVICE_CPU),
+                        ShuffledTFRecordDatasetOp);
+
 }  // namespace
 
 }  // namespace tensorflow
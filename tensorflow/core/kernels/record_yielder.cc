@@ -18,17 +18,56 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/numa.h"
 
 namespace tensorflow {
 
+struct RecordYielder::SubBuffer {
+  mutex mu;
+  // Notified when a record is removed from `buf`.
+  condition_variable not_full;
+  // PRG used to shuffle the records into `buf`.
+  std::mt19937_64 rnd GUARDED_BY(mu);
+  std::vector<string> buf GUARDED_BY(mu);
+  // The size of `buf`, which can be read without holding `mu`.
+  std::atomic<int64> size;
+
+  explicit SubBuffer(int64 seed) : rnd(seed), size(0) {}
+};
+
 RecordYielder::RecordYielder(OpKernelConstruction* context,
                              const RecordYielder::Options& opts)
     : opts_(opts),
-      thread_(new thread::ThreadPool(context->env(), ThreadOptions(),
-                                     "record_yielder", 1 + opts.parallelism,
-                                     /* low_latency_hint */ false)),
       epoch_(0),
-      rnd_(opts.seed) {
+      stop_(false),
+      rnd_(opts.seed),
+      num_buffered_(0),
+      num_unblocked_readers_(0) {
+  const int num_nodes =
+      opts.numa_aware && port::NUMAEnabled() ? port::NUMANumNodes() : 1;
+  if (num_nodes > 1) {
+    // The readers are assigned to the nodes in turn; see MainLoop().
+    thread_ = new thread::ThreadPool(context->env(), ThreadOptions(),
+                                     "record_yielder", 1,
+                                     /* low_latency_hint */ false);
+    for (int node = 0; node < num_nodes && node < opts.parallelism; ++node) {
+      ThreadOptions thread_options;
+      thread_options.numa_node = node;
+      const int num_readers = (opts.parallelism - node + num_nodes - 1) /
+                              num_nodes;
+      numa_threads_.emplace_back(new thread::ThreadPool(
+          context->env(), thread_options,
+          strings::StrCat("record_yielder_numa_", node), num_readers,
+          /* low_latency_hint */ false));
+    }
+  } else {
+    thread_ = new thread::ThreadPool(context->env(), ThreadOptions(),
+                                     "record_yielder", 1 + opts.parallelism,
+                                     /* low_latency_hint */ false);
+  }
+  for (int i = 0; i < opts.parallelism; ++i) {
+    bufs_.emplace_back(new SubBuffer(opts.seed + i + 1));
+  }
   thread_->Schedule([this]() { MainLoop(); });
 }
 
@@ -38,9 +77,13 @@ RecordYielder::~RecordYielder() {
     stop_ = true;
     buf_empty_.notify_all();
     buf_enough_.notify_all();
-    buf_not_full_.notify_all();
+  }
+  for (auto& sub : bufs_) {
+    mutex_lock l(sub->mu);
+    sub->not_full.notify_all();
   }
   main_loop_done_.WaitForNotification();
+  numa_threads_.clear();
   delete thread_;
 }
 
@@ -50,20 +93,33 @@ Status RecordYielder::YieldOne(string* value) {
     buf_enough_.wait(l);
   }
   if (status_.ok()) {
-    bool notify_no_longer_full = !BufNotFull();
-    CHECK(!stop_ && !buf_.empty());
-    *value = std::move(buf_.back());
-    buf_.pop_back();
+    CHECK(!stop_ && num_buffered_ > 0);
+    // Chooses the sub-buffer with probability proportional to its size. The
+    // sizes can grow while they are summed, but not shrink, so the chosen
+    // sub-buffer is never empty.
+    int64 index = rnd_() % num_buffered_;
+    SubBuffer* sub = nullptr;
+    for (auto& candidate : bufs_) {
+      sub = candidate.get();
+      index -= sub->size;
+      if (index < 0) break;
+    }
+    {
+      mutex_lock sub_l(sub->mu);
+      CHECK(!sub->buf.empty());
+      *value = std::move(sub->buf.back());
+      sub->buf.pop_back();
+      --sub->size;
+      sub->not_full.notify_one();
+    }
+    --num_buffered_;
     ++num_records_yielded_in_epoch_;
     // Assumption is that an epoch always has something in the buffer
     // until it ends.  If the input pipeline was slower than the consumers
     // by a lot this might not be true.  Not sure how to handle.
-    if (buf_.empty()) {
+    if (num_buffered_ == 0) {
       buf_empty_.notify_all();
     }
-    if (notify_no_longer_full) {
-      buf_not_full_.notify_all();
-    }
   }
   return status_;
 }
@@ -73,6 +129,7 @@ struct RecordYielder::Shard {
   std::vector<string> filenames;  // File names given to this shard.
   Notification done;              // Notified when this shard is done.
   Status status;                  // Shard status.
+  int64 num_records_added = 0;    // Records added in this epoch.
 };
 
 bool RecordYielder::ShouldFinish(const Status& s) {
@@ -81,6 +138,11 @@ bool RecordYielder::ShouldFinish(const Status& s) {
   return stop_ || !status_.ok();
 }
 
+void RecordYielder::NotifyBufEnough() {
+  mutex_lock l(mu_);
+  buf_enough_.notify_all();
+}
+
 static Status MatchFiles(const string& patterns,
                          std::vector<string>* filenames) {
   for (const auto& file_pattern : str_util::Split(patterns, ',')) {
@@ -98,7 +160,6 @@ void RecordYielder::MainLoop() {
   while (true) {
     ++epoch_;
     num_records_yielded_in_epoch_ = 0;
-    num_records_added_in_epoch_ = 0;
 
     // Finds all files.
     std::vector<string> filenames;
@@ -129,8 +190,13 @@ void RecordYielder::MainLoop() {
                   filenames.end());
     }
 
-    // Shards files and use one thread to go through each shard.
+    // Shards files and use one thread to go through each shard. Only the
+    // shards with files share the randomization buffer.
     const int N = opts_.parallelism;
+    const int num_readers = std::min<int64>(N, filenames.size());
+    sub_bufsize_ = std::max<uint64>(
+        1, (opts_.bufsize + num_readers - 1) / num_readers);
+    num_unblocked_readers_ = num_readers;
     std::vector<Shard> shards(N);
     for (int i = 0; i < N; ++i) {
       Shard* shard = &shards[i];
@@ -138,16 +204,26 @@ void RecordYielder::MainLoop() {
       for (std::vector<string>::size_type j = i; j < filenames.size(); j += N) {
         shard->filenames.push_back(filenames[j]);
       }
-      thread_->Schedule([this, shard]() { ShardLoop(shard); });
+      if (shard->filenames.empty()) {
+        shard->done.Notify();
+        continue;
+      }
+      thread::ThreadPool* pool =
+          numa_threads_.empty()
+              ? thread_
+              : numa_threads_[i % numa_threads_.size()].get();
+      pool->Schedule([this, shard]() { ShardLoop(shard); });
     }
+    int64 num_records_added_in_epoch = 0;
     for (int i = 0; i < N; ++i) {
       shards[i].done.WaitForNotification();
       s.Update(shards[i].status);
+      num_records_added_in_epoch += shards[i].num_records_added;
     }
 
-    if (num_records_added_in_epoch_ < opts_.bufsize) {
+    if (num_records_added_in_epoch < opts_.bufsize) {
       mutex_lock l(mu_);
-      opts_.bufsize = num_records_added_in_epoch_;
+      opts_.bufsize = num_records_added_in_epoch;
     }
 
     if (ShouldFinish(s)) {
@@ -171,26 +247,51 @@ void RecordYielder::MainLoop() {
   main_loop_done_.Notify();
 }
 
-bool RecordYielder::Add(std::vector<string>* values) {
-  mutex_lock l(mu_);
-  while (!BufNotFull()) {
-    buf_not_full_.wait(l);
-  }
-  while (BufNotFull() && !values->empty()) {
-    // Adds values->back(). Swaps its position with another random
-    // element.
-    auto index = rnd_() % (buf_.size() + 1);
-    if (index == buf_.size()) {
-      buf_.push_back(std::move(values->back()));
-    } else {
-      buf_.push_back(std::move(buf_[index]));
-      buf_[index] = std::move(values->back());
-    }
-    values->pop_back();
-    num_records_added_in_epoch_++;
+bool RecordYielder::Add(Shard* shard, std::vector<string>* values) {
+  SubBuffer* sub = bufs_[shard->index].get();
+  int64 num_added = 0;
+  bool blocked = false;
+  {
+    mutex_lock l(sub->mu);
+    while (!stop_ && sub->buf.size() >= sub_bufsize_) {
+      if (!blocked) {
+        blocked = true;
+        // The consumers may be waiting for the last reader to block.
+        if (--num_unblocked_readers_ == 0) {
+          sub->mu.unlock();
+          NotifyBufEnough();
+          sub->mu.lock();
+          continue;
+        }
+      }
+      sub->not_full.wait(l);
+    }
+    if (blocked) {
+      ++num_unblocked_readers_;
+    }
+    while (sub->buf.size() < sub_bufsize_ && !values->empty()) {
+      // Adds values->back(). Swaps its position with another random
+      // element.
+      auto index = sub->rnd() % (sub->buf.size() + 1);
+      if (index == sub->buf.size()) {
+        sub->buf.push_back(std::move(values->back()));
+      } else {
+        sub->buf.push_back(std::move(sub->buf[index]));
+        sub->buf[index] = std::move(values->back());
+      }
+      values->pop_back();
+      ++num_added;
+    }
+    sub->size += num_added;
   }
-  if (BufEnough()) {
-    buf_enough_.notify_all();
+  shard->num_records_added += num_added;
+  // Only the reader that makes the buffers cross the threshold of
+  // BufEnough() has to wake up the consumers.
+  const uint64 threshold = std::max<uint64>(1, opts_.bufsize / 2);
+  const uint64 new_num_buffered = num_buffered_ += num_added;
+  if (new_num_buffered >= threshold &&
+      new_num_buffered - num_added < threshold) {
+    NotifyBufEnough();
   }
   return stop_;
 }
@@ -213,7 +314,7 @@ void RecordYielder::ShardLoop(Shard* shard) {
       Status s = rdr.ReadRecord(&offset, &record);
       if (s.ok()) {
         values.emplace_back(std::move(record));
-        if (values.size() >= kRecords && Add(&values)) {
+        if (values.size() >= kRecords && Add(shard, &values)) {
           shard->status = errors::Aborted("stopped");
           break;
         }
@@ -225,9 +326,13 @@ void RecordYielder::ShardLoop(Shard* shard) {
       }
     }
   }
-  // Adds the remaining values of this shard to buf_.
+  // Adds the remaining values of this shard to its sub-buffer.
   while (!values.empty()) {
-    Add(&values);
+    if (Add(shard, &values)) break;
+  }
+  // The consumers may be waiting for the last reader to finish.
+  if (--num_unblocked_readers_ == 0) {
+    NotifyBufEnough();
   }
   shard->done.Notify();
 }
@@ -40,6 +40,12 @@ namespace tensorflow {
 //   4) the peak memory usage is roughly avg record size *
 //      (opts.bufsize + opts.parellelism * 16).
 //
+// The randomization buffer is split into one sub-buffer per reader thread,
+// so that the readers never contend with each other. Each reader shuffles
+// the records of its own files into its sub-buffer, and each yielded record
+// is taken from a sub-buffer chosen with probability proportional to its
+// size.
+//
 // Usage example:
 //   RecordYielder::Options opts;
 //   opts.file_pattern = "input-*";
@@ -78,6 +84,11 @@ class RecordYielder {
     // Uses these many concurrent tfrecord iterators to iterate through
     // tfrecords.
     int32 parallelism = 1;
+
+    // If true, and the machine has more than one NUMA node, the reader
+    // threads are spread over the nodes and pinned to them, so that the
+    // records of each thread are allocated on its node.
+    bool numa_aware = false;
   };
 
   explicit RecordYielder(OpKernelConstruction* context,
@@ -101,25 +112,39 @@ class RecordYielder {
   // Backgrounds threads. Owned.
   thread::ThreadPool* thread_;
 
+  // The threads of the readers on each NUMA node, if `opts_.numa_aware`.
+  std::vector<std::unique_ptr<thread::ThreadPool>> numa_threads_;
+
   // Epoch number.
   std::atomic<int64> epoch_;
 
   mutex mu_;
 
   // Turned to true when this is deleted.
-  bool stop_ GUARDED_BY(mu_) = false;
+  std::atomic<bool> stop_;
   Status status_ GUARDED_BY(mu_);
 
-  // PRG used for randomization.
+  // PRG used to choose the sub-buffer of each yielded record.
   std::mt19937_64 rnd_ GUARDED_BY(mu_);
 
-  // Randomization buffer.
-  std::vector<string> buf_ GUARDED_BY(mu_);
+  // Randomization buffers, one per reader. Records are only removed while
+  // holding mu_, so the sizes can only grow while it is held.
+  struct SubBuffer;
+  std::vector<std::unique_ptr<SubBuffer>> bufs_;
+
+  // The number of records in `bufs_`.
+  std::atomic<int64> num_buffered_;
+
+  // The number of readers in the current epoch that have neither finished
+  // their files nor blocked on a full sub-buffer.
+  std::atomic<int> num_unblocked_readers_;
+
+  // The capacity of each sub-buffer in the current epoch.
+  uint64 sub_bufsize_ = 1;
 
   // True iff we are draining an epoch.
   bool epoch_end_ = false;
 
-  int64 num_records_added_in_epoch_ = 0;
   int64 num_records_yielded_in_epoch_ = 0;
 
   // Trigger when the main loop has exited.
@@ -128,29 +153,31 @@ class RecordYielder {
   // condition_variables.
   condition_variable buf_empty_;
   bool BufEmpty() const SHARED_LOCKS_REQUIRED(mu_) {
-    return stop_ || buf_.empty();
-  }
-
-  condition_variable buf_not_full_;
-  bool BufNotFull() const SHARED_LOCKS_REQUIRED(mu_) {
-    return stop_ || buf_.size() < opts_.bufsize;
+    return stop_ || num_buffered_ == 0;
   }
 
   condition_variable buf_enough_;
   bool BufEnough() const SHARED_LOCKS_REQUIRED(mu_) {
     // NOTE: Unless we are finishing an epoch, we want to make sure
-    // the buf_ contains enough randomized elements before yielding
-    // any.
-    return stop_ || !status_.ok() || (epoch_end_ && !buf_.empty()) ||
-           (!epoch_end_ &&
-            buf_.size() >= std::max<uint64>(1, opts_.bufsize / 2));
+    // the buffers contain enough randomized elements before yielding
+    // any. If no reader can add more, the buffered elements are as
+    // randomized as they will get.
+    return stop_ || !status_.ok() ||
+           ((epoch_end_ || num_unblocked_readers_ == 0) &&
+            num_buffered_ > 0) ||
+           (!epoch_end_ && static_cast<uint64>(num_buffered_) >=
+                               std::max<uint64>(1, opts_.bufsize / 2));
   }
 
+  // Wakes up the consumers after a reader has changed `num_buffered_` or
+  // `num_unblocked_readers_` in a way that may have made BufEnough() true.
+  void NotifyBufEnough();
+
   void MainLoop();
   struct Shard;
   void ShardLoop(Shard* shard);
   bool ShouldFinish(const Status& s);
-  bool Add(std::vector<string>* values);
+  bool Add(Shard* shard, std::vector<string>* values);
 };
 
 }  // namespace tensorflow
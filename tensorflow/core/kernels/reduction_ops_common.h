@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/cpu_reduction.h"
 #include "tensorflow/core/kernels/reduction_ops.h"
 #include "tensorflow/core/kernels/transpose_functor.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -219,9 +220,11 @@ class ReductionOp : public OpKernel {
       Tensor data_reshaped;
       CHECK(data_reshaped.CopyFrom(data, helper.data_reshape()));
       Tensor shuffled;
+      AllocatorAttributes shuffled_attr = alloc_attr;
+      shuffled_attr.set_scratch(true);
       OP_REQUIRES_OK(ctx, ctx->allocate_temp(DataTypeToEnum<T>::value,
                                              helper.shuffled_shape(), &shuffled,
-                                             alloc_attr));
+                                             shuffled_attr));
       OP_REQUIRES_OK(
           ctx, DoTranspose(d, data_reshaped, helper.permutation(), &shuffled));
       const int64 unreduced = tmp_out.NumElements();
@@ -277,7 +280,47 @@ struct ReduceFunctorBase {
 
 template <typename Reducer>
 struct ReduceFunctor<CPUDevice, Reducer>
-    : ReduceFunctorBase<CPUDevice, Reducer> {};
+    : ReduceFunctorBase<CPUDevice, Reducer> {
+  template <typename OUT_T, typename IN_T, typename ReductionAxes>
+  static void Reduce(OpKernelContext* ctx, OUT_T out, IN_T in,
+                     const ReductionAxes& reduction_axes,
+                     const Reducer& reducer) {
+    // Maps the reductions that ReductionOp performs to those of CpuReduce,
+    // and falls back to Eigen for the other ones and the other types.
+    const int num_dims = IN_T::NumDimensions;
+    const int num_axes = Eigen::internal::array_size<ReductionAxes>::value;
+    const auto& dims = in.dimensions();
+    CpuReduceShape shape = CpuReduceShape::kInner;
+    int64 d0 = 1, d1 = 1, d2 = 1;
+    bool matched = true;
+    if (num_dims == 1 && num_axes == 1) {
+      d2 = dims[0];
+    } else if (num_dims == 2 && num_axes == 1) {
+      d1 = dims[0];
+      d2 = dims[num_dims - 1];
+      if (reduction_axes[0] == 0) shape = CpuReduceShape::kMiddle;
+    } else if (num_dims == 3 && num_axes == 1 && reduction_axes[0] == 1) {
+      shape = CpuReduceShape::kMiddle;
+      d0 = dims[0];
+      d1 = dims[1];
+      d2 = dims[num_dims - 1];
+    } else if (num_dims == 3 && num_axes == 2) {
+      shape = CpuReduceShape::kOuterInner;
+      d0 = dims[0];
+      d1 = dims[1];
+      d2 = dims[num_dims - 1];
+    } else {
+      matched = false;
+    }
+    if (matched && CpuReduce<Reducer>(
+                       *ctx->device()->tensorflow_cpu_worker_threads(), shape,
+                       in.data(), d0, d1, d2, out.data())) {
+      return;
+    }
+    ReduceFunctorBase<CPUDevice, Reducer>::Reduce(ctx, out, in, reduction_axes,
+                                                  reducer);
+  }
+};
 #if TENSORFLOW_USE_SYCL
 template <typename Reducer>
 struct ReduceFunctor<SYCLDevice, Reducer>
@@ -179,4 +179,29 @@ static void BM_Bool2DToScalarGPU(int iters, int num_x, int num_y) {
 }
 BENCHMARK(BM_Bool2DToScalarGPU)->RangePair(2048, 8192, 2048, 8192);
 
+static void BM_Sum2DRowReduceCPU(int iters, int num_x, int num_y) {
+  DoRowReduce(iters, "cpu", "Sum", num_x, num_y);
+}
+BENCHMARK(BM_Sum2DRowReduceCPU)->RangePair(1, 8192, 1, 8192);
+
+static void BM_Sum2DColumnReduceCPU(int iters, int num_x, int num_y) {
+  DoColReduce(iters, "cpu", "Sum", num_x, num_y);
+}
+BENCHMARK(BM_Sum2DColumnReduceCPU)->RangePair(1, 8192, 1, 8192);
+
+static void BM_Sum3DYReduceCPU(int iters, int num_x, int num_y) {
+  Do3DYReduce(iters, "cpu", "Sum", num_x, num_y);
+}
+BENCHMARK(BM_Sum3DYReduceCPU)->RangePair(64, 4096, 64, 4096);
+
+static void BM_Sum3DXZReduceCPU(int iters, int num_x, int num_y) {
+  Do3DXZReduce(iters, "cpu", "Sum", num_x, num_y);
+}
+BENCHMARK(BM_Sum3DXZReduceCPU)->RangePair(64, 4096, 64, 4096);
+
+static void BM_Mean2DToScalarCPU(int iters, int num_x, int num_y) {
+  ReduceToScalar<float>(iters, "cpu", "Mean", num_x, num_y);
+}
+BENCHMARK(BM_Mean2DToScalarCPU)->RangePair(2048, 8192, 2048, 8192);
+
 }  // end namespace tensorflow
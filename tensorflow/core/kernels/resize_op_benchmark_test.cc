@@ -22,9 +22,9 @@ limitations under the License.
 namespace tensorflow {
 
 static Graph* BM_Resize(const char* algorithm, int batches, int width,
-                        int height) {
+                        int height, int channels = 3) {
   Graph* g = new Graph(OpRegistry::Global());
-  Tensor in(DT_FLOAT, TensorShape({batches, width, height, 3}));
+  Tensor in(DT_FLOAT, TensorShape({batches, width, height, channels}));
   in.flat<float>().setRandom();
 
   Tensor out_size(DT_INT32, TensorShape({2}));
@@ -53,5 +53,17 @@ BM_ResizeDev(gpu, ResizeNearestNeighbor, 10, 499, 499);
 
 BM_ResizeDev(cpu, ResizeBilinear, 10, 499, 499);
 BM_ResizeDev(gpu, ResizeBilinear, 10, 499, 499);
+BM_ResizeDev(cpu, ResizeBilinear, 1, 499, 499);
+
+#define BM_ResizeChannelsDev(DEVICE, ALGORITHM, B, W, H, C)                   \
+  static void BM_Resize_##ALGORITHM##_##DEVICE##_##B##_##W##_##H##_##C(       \
+      int iters) {                                                            \
+    testing::ItemsProcessed(iters* B* W* H* C);                               \
+    test::Benchmark(#DEVICE, BM_Resize(#ALGORITHM, B, W, H, C)).Run(iters);   \
+  }                                                                           \
+  BENCHMARK(BM_Resize_##ALGORITHM##_##DEVICE##_##B##_##W##_##H##_##C)
+
+BM_ResizeChannelsDev(cpu, ResizeBilinear, 4, 64, 64, 64);
+BM_ResizeChannelsDev(gpu, ResizeBilinear, 4, 64, 64, 64);
 
 }  // namespace tensorflow
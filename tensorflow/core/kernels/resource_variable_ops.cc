@@ -51,6 +51,10 @@ limitations under the License.
 #define EIGEN_USE_GPU
 #endif
 
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/resource_mgr.h"
@@ -62,9 +66,11 @@ limitations under the License.
 #include "tensorflow/core/kernels/training_op_helpers.h"
 #include "tensorflow/core/kernels/variable_ops.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/util.h"
 
 namespace tensorflow {
@@ -512,7 +518,9 @@ class ResourceScatterUpdateOp : public OpKernel {
  public:
   explicit ResourceScatterUpdateOp(OpKernelConstruction* c) : OpKernel(c) {}
 
-  void Compute(OpKernelContext* c) override {
+  void Compute(OpKernelContext* c) override { ComputeScatter(c); }
+
+  static void ComputeScatter(OpKernelContext* c) {
     Var* v = nullptr;
     OP_REQUIRES_OK(c, LookupResource(c, HandleFromInput(c, 0), &v));
     core::ScopedUnref unref_v(v);
@@ -555,6 +563,208 @@ class ResourceScatterUpdateOp : public OpKernel {
   }
 };
 
+// Merges the ResourceScatterAdd updates that arrive at a variable within a
+// short window, typically from many workers updating the same embedding on a
+// parameter server, and applies them at once. The updates of the batch are
+// summed per distinct index first, so that a hot row is written once per batch
+// instead of once per update, and the variable's mutex is taken once.
+template <typename T, typename Index>
+class ScatterAddAggregator {
+ public:
+  static ScatterAddAggregator* Global() {
+    static ScatterAddAggregator* aggregator = new ScatterAddAggregator;
+    return aggregator;
+  }
+
+  // Adds an update of v, which takes ownership of a reference on v. `done` is
+  // called once the batch that contains the update has been applied, at most
+  // `window_micros` later, or as soon as the batch has `max_updates` updates.
+  void Add(Var* v, OpKernelContext* c, int64 window_micros, int64 max_updates,
+           AsyncOpKernel::DoneCallback done) {
+    std::shared_ptr<Batch> full;
+    {
+      mutex_lock l(mu_);
+      std::shared_ptr<Batch>& batch = batches_[v];
+      if (batch == nullptr) {
+        batch = std::make_shared<Batch>();
+        std::shared_ptr<Batch> pending = batch;
+        Env::Default()->SchedClosureAfter(window_micros, [this, v, pending]() {
+          {
+            mutex_lock l(mu_);
+            auto it = batches_.find(v);
+            if (it == batches_.end() || it->second != pending) return;
+            batches_.erase(it);
+          }
+          Apply(v, pending.get());
+        });
+      }
+      batch->updates.push_back({c, c->input(1), c->input(2), std::move(done)});
+      if (static_cast<int64>(batch->updates.size()) >= max_updates) {
+        full = std::move(batch);
+        batches_.erase(v);
+      }
+    }
+    if (full != nullptr) Apply(v, full.get());
+  }
+
+ private:
+  struct Update {
+    OpKernelContext* ctx;
+    Tensor indices;
+    Tensor updates;
+    AsyncOpKernel::DoneCallback done;
+  };
+  struct Batch {
+    std::vector<Update> updates;
+  };
+
+  void Apply(Var* v, Batch* batch) {
+    {
+      mutex_lock ml(*v->mu());
+      Tensor* params = v->tensor();
+      Status s = PrepareToUpdateVariable<CPUDevice, T>(batch->updates[0].ctx,
+                                                       params);
+      if (s.ok() && params->dims() == 0) {
+        s = errors::InvalidArgument("params must be at least 1-D, got shape ",
+                                    params->shape().DebugString());
+      }
+      if (s.ok()) {
+        MergeAndApply(params, batch);
+      } else {
+        for (Update& update : batch->updates) update.ctx->SetStatus(s);
+      }
+    }
+    for (Update& update : batch->updates) {
+      update.done();
+      v->Unref();
+    }
+  }
+
+  // Sums the rows of all the valid updates of `batch` per index, then adds the
+  // sums to `params`. An update with an out-of-range index fails its own op,
+  // and none of its rows is applied, as with the unaggregated kernel.
+  void MergeAndApply(Tensor* params, Batch* batch) {
+    const int64 num_rows = params->dim_size(0);
+    const int64 row_size = num_rows > 0 ? params->NumElements() / num_rows : 0;
+    std::unordered_map<Index, int64> slots;
+    std::vector<Index> slot_indices;
+    for (Update& update : batch->updates) {
+      auto indices_flat = update.indices.template flat<Index>();
+      for (int64 i = 0; i < indices_flat.size(); ++i) {
+        const Index index = indices_flat(i);
+        if (!FastBoundsCheck(index, num_rows)) {
+          update.ctx->SetStatus(errors::InvalidArgument(
+              "indices", SliceDebugString(update.indices.shape(), i), " = ",
+              index, " is not in [0, ", num_rows, ")"));
+          break;
+        }
+      }
+      if (!update.ctx->status().ok()) continue;
+      for (int64 i = 0; i < indices_flat.size(); ++i) {
+        if (slots.emplace(indices_flat(i), slot_indices.size()).second) {
+          slot_indices.push_back(indices_flat(i));
+        }
+      }
+    }
+    if (slot_indices.empty()) return;
+
+    Tensor sums(DataTypeToEnum<T>::v(),
+                TensorShape({static_cast<int64>(slot_indices.size()),
+                             row_size}));
+    auto sums_flat = sums.template matrix<T>();
+    sums_flat.setZero();
+    for (Update& update : batch->updates) {
+      if (!update.ctx->status().ok()) continue;
+      const int64 n = update.indices.NumElements();
+      if (n == 0) continue;
+      auto indices_flat = update.indices.template flat<Index>();
+      auto updates_flat = update.updates.template shaped<T, 2>({n, row_size});
+      for (int64 i = 0; i < n; ++i) {
+        sums_flat.template chip<0>(slots[indices_flat(i)]) +=
+            updates_flat.template chip<0>(i);
+      }
+    }
+    auto params_flat = params->flat_outer_dims<T>();
+    for (int64 j = 0; j < slot_indices.size(); ++j) {
+      params_flat.template chip<0>(slot_indices[j]) +=
+          sums_flat.template chip<0>(j);
+    }
+  }
+
+  mutex mu_;
+  std::unordered_map<Var*, std::shared_ptr<Batch>> batches_ GUARDED_BY(mu_);
+};
+
+// The CPU kernel of ResourceScatterAdd. Unless the
+// TF_SCATTER_ADD_AGGREGATION_WINDOW_MICROS environment variable enables the
+// aggregation of concurrent updates, each op applies its own update like
+// ResourceScatterUpdateOp. Aggregation delays the completion of each op by up
+// to the window, and sums the updates of a row in a different order, so it is
+// meant for variables that are updated by many asynchronous workers.
+template <typename T, typename Index>
+class AggregatingResourceScatterAddOp : public AsyncOpKernel {
+ public:
+  explicit AggregatingResourceScatterAddOp(OpKernelConstruction* c)
+      : AsyncOpKernel(c) {
+    OP_REQUIRES_OK(c, ReadInt64FromEnvVar(
+                          "TF_SCATTER_ADD_AGGREGATION_WINDOW_MICROS", 0,
+                          &window_micros_));
+    OP_REQUIRES_OK(c, ReadInt64FromEnvVar("TF_SCATTER_ADD_AGGREGATION_COUNT",
+                                          32, &max_updates_));
+  }
+
+  void ComputeAsync(OpKernelContext* c, DoneCallback done) override {
+    if (window_micros_ <= 0 || max_updates_ <= 1) {
+      ResourceScatterUpdateOp<CPUDevice, T, Index,
+                              scatter_op::UpdateOp::ADD>::ComputeScatter(c);
+      done();
+      return;
+    }
+    Var* v = nullptr;
+    OP_REQUIRES_OK_ASYNC(c, LookupResource(c, HandleFromInput(c, 0), &v),
+                         done);
+    const Tensor& indices = c->input(1);
+    const Tensor& updates = c->input(2);
+    Status s;
+    if (indices.NumElements() > std::numeric_limits<Index>::max()) {
+      s = errors::InvalidArgument("indices has too many elements for ",
+                                  DataTypeString(DataTypeToEnum<Index>::v()),
+                                  " indexing: ", indices.NumElements(), " > ",
+                                  std::numeric_limits<Index>::max());
+    } else {
+      tf_shared_lock ml(*v->mu());
+      const Tensor* params = v->tensor();
+      if (params->dims() > 0 &&
+          params->dim_size(0) > std::numeric_limits<Index>::max()) {
+        s = errors::InvalidArgument("params.shape[0] too large for ",
+                                    DataTypeString(DataTypeToEnum<Index>::v()),
+                                    " indexing: ", params->dim_size(0), " > ",
+                                    std::numeric_limits<Index>::max());
+      } else if (params->dims() > 0 && indices.NumElements() > 0 &&
+                 updates.NumElements() !=
+                     indices.NumElements() *
+                         (params->NumElements() / params->dim_size(0))) {
+        s = errors::InvalidArgument(
+            "updates has ", updates.NumElements(),
+            " elements, expected one row of params for each of the ",
+            indices.NumElements(), " indices");
+      }
+    }
+    if (!s.ok()) {
+      v->Unref();
+      c->SetStatus(s);
+      done();
+      return;
+    }
+    ScatterAddAggregator<T, Index>::Global()->Add(
+        v, c, window_micros_, max_updates_, std::move(done));
+  }
+
+ private:
+  int64 window_micros_;
+  int64 max_updates_;
+};
+
 #define REGISTER_SCATTER_KERNEL_INDEX(type, index_type, dev, name, op) \
   REGISTER_KERNEL_BUILDER(                                             \
       Name(name)                                                       \
@@ -575,9 +785,21 @@ class ResourceScatterUpdateOp : public OpKernel {
   REGISTER_SCATTER_KERNEL(type, dev, "ResourceScatterUpdate", \
                           scatter_op::UpdateOp::ASSIGN);
 
+#define REGISTER_SCATTER_ADD_CPU_INDEX(type, index_type) \
+  REGISTER_KERNEL_BUILDER(                               \
+      Name("ResourceScatterAdd")                         \
+          .Device(DEVICE_CPU)                            \
+          .HostMemory("resource")                        \
+          .TypeConstraint<type>("dtype")                 \
+          .TypeConstraint<index_type>("Tindices"),       \
+      AggregatingResourceScatterAddOp<type, index_type>)
+
 // Registers CPU kernels.
-#define REGISTER_SCATTER_ARITHEMTIC_CPU(type) \
-  REGISTER_SCATTER_ARITHEMTIC(type, CPU);
+#define REGISTER_SCATTER_ARITHEMTIC_CPU(type)                 \
+  REGISTER_SCATTER_ADD_CPU_INDEX(type, int32);                \
+  REGISTER_SCATTER_ADD_CPU_INDEX(type, int64);                \
+  REGISTER_SCATTER_KERNEL(type, CPU, "ResourceScatterUpdate", \
+                          scatter_op::UpdateOp::ASSIGN);
 
 TF_CALL_NUMBER_TYPES(REGISTER_SCATTER_ARITHEMTIC_CPU);
 
@@ -594,6 +816,7 @@ TF_CALL_GPU_NUMBER_TYPES_NO_HALF(REGISTER_SCATTER_ARITHEMTIC_GPU);
 
 #undef REGISTER_SCATTER_ARITHEMTIC
 #undef REGISTER_SCATTER_ARITHEMTIC_CPU
+#undef REGISTER_SCATTER_ADD_CPU_INDEX
 #undef REGISTER_SCATTER_KERNEL
 #undef REGISTER_SCATTER_KERNEL_INDEX
 
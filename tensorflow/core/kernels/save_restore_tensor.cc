@@ -13,7 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <utility>
 #include <vector>
@@ -27,11 +29,13 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
 #include "tensorflow/core/util/tensor_slice_writer.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -234,63 +238,136 @@ void RestoreTensor(OpKernelContext* context,
 #undef READER_COPY
 }
 
+namespace {
+
+// Restores the tensor "i" of RestoreTensorsV2 from "reader" into output "i"
+// of "context".  "mu" guards the outputs of "context".
+Status RestoreTensor(OpKernelContext* context, BundleReader* reader,
+                     const string& tensor_name, const string& shape_and_slice,
+                     int i, DataType dtype, bool memory_map, bool warm_up,
+                     mutex* mu) {
+  TensorShape restored_full_shape;
+  Tensor* restored_tensor = nullptr;
+  TF_RETURN_IF_ERROR(
+      reader->LookupTensorShape(tensor_name, &restored_full_shape));
+
+  Tensor mapped_tensor;
+  if (shape_and_slice.empty() && memory_map &&
+      reader->LookupMapped(tensor_name, &mapped_tensor).ok() &&
+      mapped_tensor.dtype() == dtype) {
+    // Share the mapped pages of the full tensor.
+    if (warm_up) WarmUpMappedBundleTensor(mapped_tensor);
+    mutex_lock l(*mu);
+    context->set_output(i, mapped_tensor);
+    restored_tensor = &mapped_tensor;
+  } else if (shape_and_slice.empty()) {
+    // Lookup the full tensor.
+    {
+      mutex_lock l(*mu);
+      TF_RETURN_IF_ERROR(
+          context->allocate_output(i, restored_full_shape, &restored_tensor));
+    }
+    TF_RETURN_IF_ERROR(reader->Lookup(tensor_name, restored_tensor));
+  } else {
+    // Lookup the slice.
+    TensorShape parsed_full_shape;
+    TensorSlice parsed_slice;
+    TensorShape parsed_slice_shape;
+
+    TF_RETURN_IF_ERROR(
+        checkpoint::ParseShapeAndSlice(shape_and_slice, &parsed_full_shape,
+                                       &parsed_slice, &parsed_slice_shape));
+    if (!restored_full_shape.IsSameSize(parsed_full_shape)) {
+      return errors::InvalidArgument(
+          "tensor_name = ", tensor_name, "; shape in shape_and_slice spec ",
+          parsed_full_shape.DebugString(),
+          " does not match the shape stored in checkpoint: ",
+          restored_full_shape.DebugString());
+    }
+
+    if (memory_map &&
+        reader->LookupMappedSlice(tensor_name, parsed_slice, &mapped_tensor)
+            .ok() &&
+        mapped_tensor.dtype() == dtype) {
+      // Share the mapped pages of the rows of the slice.
+      if (warm_up) WarmUpMappedBundleTensor(mapped_tensor);
+      mutex_lock l(*mu);
+      context->set_output(i, mapped_tensor);
+      restored_tensor = &mapped_tensor;
+    } else {
+      {
+        mutex_lock l(*mu);
+        TF_RETURN_IF_ERROR(
+            context->allocate_output(i, parsed_slice_shape, &restored_tensor));
+      }
+      TF_RETURN_IF_ERROR(
+          reader->LookupSlice(tensor_name, parsed_slice, restored_tensor));
+    }
+  }
+  if (dtype != restored_tensor->dtype()) {
+    return errors::InvalidArgument(
+        "tensor_name = ", tensor_name, "; expected dtype ",
+        DataTypeString(dtype), " does not equal restored dtype ",
+        DataTypeString(restored_tensor->dtype()));
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& tensor_names,
                         const Tensor& shape_and_slices,
-                        gtl::ArraySlice<DataType> dtypes) {
+                        gtl::ArraySlice<DataType> dtypes, bool memory_map,
+                        gtl::ArraySlice<string> warm_up_tensors,
+                        int max_parallel_reads) {
   const string& prefix_string = prefix.scalar<string>()();
   const auto& tensor_names_flat = tensor_names.flat<string>();
   const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
+  const int64 num_tensors = tensor_names_flat.size();
+  const std::unordered_set<string> warm_up(warm_up_tensors.begin(),
+                                           warm_up_tensors.end());
 
   BundleReader reader(Env::Default(), prefix_string);
   TF_RETURN_IF_ERROR(reader.status());
 
   // TODO(zongheng): potential optimization: one Seek() in first lookup.
-  // TODO(zongheng): consider measuring speed and issuing concurrent lookups
-  // within a fixed memory budget.
-  TensorShape restored_full_shape;
-  Tensor* restored_tensor = nullptr;
-  for (size_t i = 0; i < tensor_names_flat.size(); ++i) {
-    const string& tensor_name = tensor_names_flat(i);
-    const string& shape_and_slice = shape_and_slices_flat(i);
-    TF_RETURN_IF_ERROR(
-        reader.LookupTensorShape(tensor_name, &restored_full_shape));
-
-    if (shape_and_slice.empty()) {
-      // Lookup the full tensor.
-      TF_RETURN_IF_ERROR(
-          context->allocate_output(i, restored_full_shape, &restored_tensor));
-      TF_RETURN_IF_ERROR(reader.Lookup(tensor_name, restored_tensor));
-    } else {
-      // Lookup the slice.
-      TensorShape parsed_full_shape;
-      TensorSlice parsed_slice;
-      TensorShape parsed_slice_shape;
-
-      TF_RETURN_IF_ERROR(
-          checkpoint::ParseShapeAndSlice(shape_and_slice, &parsed_full_shape,
-                                         &parsed_slice, &parsed_slice_shape));
-      if (!restored_full_shape.IsSameSize(parsed_full_shape)) {
-        return errors::InvalidArgument(
-            "tensor_name = ", tensor_name, "; shape in shape_and_slice spec ",
-            parsed_full_shape.DebugString(),
-            " does not match the shape stored in checkpoint: ",
-            restored_full_shape.DebugString());
-      }
-
-      TF_RETURN_IF_ERROR(
-          context->allocate_output(i, parsed_slice_shape, &restored_tensor));
-      TF_RETURN_IF_ERROR(
-          reader.LookupSlice(tensor_name, parsed_slice, restored_tensor));
-    }
-    if (dtypes[i] != restored_tensor->dtype()) {
-      return errors::InvalidArgument(
-          "tensor_name = ", tensor_name, "; expected dtype ",
-          DataTypeString(dtypes[i]), " does not equal restored dtype ",
-          DataTypeString(restored_tensor->dtype()));
+  mutex mu;
+  const DeviceBase::CpuWorkerThreads* worker_threads =
+      context->device()->tensorflow_cpu_worker_threads();
+  const int parallel_reads =
+      max_parallel_reads > 0 ? max_parallel_reads : reader.num_shards();
+  if (parallel_reads <= 1 || num_tensors <= 1 || worker_threads == nullptr) {
+    for (int64 i = 0; i < num_tensors; ++i) {
+      TF_RETURN_IF_ERROR(RestoreTensor(
+          context, &reader, tensor_names_flat(i), shape_and_slices_flat(i), i,
+          dtypes[i], memory_map, warm_up.count(tensor_names_flat(i)) > 0,
+          &mu));
     }
+    return Status::OK();
   }
-  return Status::OK();
+
+  // Reads the tensors in parallel.  A BundleReader is not thread-safe, so
+  // each range of tensors gets its own.
+  Status status;
+  const int max_parallelism =
+      std::min(parallel_reads, worker_threads->num_threads);
+  // Reading a tensor is dominated by the file accesses.
+  const int64 kCostPerTensor = 1 << 20;
+  Shard(max_parallelism, worker_threads->workers, num_tensors, kCostPerTensor,
+        [&](int64 begin, int64 end) {
+          BundleReader range_reader(Env::Default(), prefix_string);
+          Status s = range_reader.status();
+          for (int64 i = begin; s.ok() && i < end; ++i) {
+            s = RestoreTensor(context, &range_reader, tensor_names_flat(i),
+                              shape_and_slices_flat(i), i, dtypes[i],
+                              memory_map,
+                              warm_up.count(tensor_names_flat(i)) > 0, &mu);
+          }
+          mutex_lock l(mu);
+          status.Update(s);
+        });
+  return status;
 }
 
 }  // namespace tensorflow
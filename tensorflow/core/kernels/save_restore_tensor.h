@@ -56,6 +56,17 @@ void RestoreTensor(OpKernelContext* context,
 //
 // "context" is only used for allocating outputs.  In particular, the inputs are
 // explicitly provided and not accessed via the "input(i)" methods.
+//
+// If "memory_map" is true, full tensors whose data is suitably aligned, and
+// slices of them that cover all but the first dimension, are returned as
+// read-only tensors backed by the memory-mapped data file; see
+// BundleReader::LookupMapped().  Other tensors are read as usual.  The pages
+// of the mapped tensors named in "warm_up_tensors" are read before
+// returning; see WarmUpMappedBundleTensor().
+//
+// The tensors are read in parallel on the CPU worker threads of the device of
+// "context", one reader per thread, with up to "max_parallel_reads" reads at
+// once, or if it is 0, as many as the data files of the bundle.
 // REQUIRES:
 //   * "prefix" has 1 element, DT_STRING.
 //   * "tensor_names" and "shape_and_slices" shaped {N}, both DT_STRING.
@@ -63,7 +74,9 @@ void RestoreTensor(OpKernelContext* context,
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& tensor_names,
                         const Tensor& shape_and_slices,
-                        gtl::ArraySlice<DataType> dtypes);
+                        gtl::ArraySlice<DataType> dtypes, bool memory_map,
+                        gtl::ArraySlice<string> warm_up_tensors,
+                        int max_parallel_reads);
 
 }  // namespace tensorflow
 
@@ -15,11 +15,13 @@ limitations under the License.
 
 // See docs in ../ops/io_ops.cc.
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/bounds_check.h"
@@ -28,7 +30,9 @@ limitations under the License.
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
@@ -85,12 +89,153 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
   }
 }
 
+// A tensor to save, and where it goes in the bundle.
+struct TensorToSave {
+  string name;
+  Tensor tensor;
+  // Whether "tensor" is the slice "slice" of a tensor of shape "full_shape".
+  bool is_slice = false;
+  TensorShape full_shape;
+  TensorSlice slice;
+};
+
+// Collects the tensors of a SaveV2 or SaveV2Async op.  If "copy" is true, the
+// tensors are deep copies of the inputs, which later steps cannot modify.
+Status GetTensorsToSave(OpKernelContext* context, bool copy,
+                        std::vector<TensorToSave>* tensors) {
+  const int kFixedInputs = 3;  // Prefix, tensor names, shape_and_slices.
+  const Tensor& tensor_names = context->input(1);
+  const Tensor& shape_and_slices = context->input(2);
+  const int num_tensors = static_cast<int>(tensor_names.NumElements());
+  const auto& tensor_names_flat = tensor_names.flat<string>();
+  const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
+
+  tensors->resize(num_tensors);
+  for (int i = 0; i < num_tensors; ++i) {
+    TensorToSave* to_save = &(*tensors)[i];
+    const Tensor& tensor = context->input(i + kFixedInputs);
+    to_save->name = tensor_names_flat(i);
+    to_save->tensor = copy ? tensor::DeepCopy(tensor) : tensor;
+
+    if (!shape_and_slices_flat(i).empty()) {
+      const string& shape_spec = shape_and_slices_flat(i);
+      TensorShape slice_shape;
+      TF_RETURN_IF_ERROR(checkpoint::ParseShapeAndSlice(
+          shape_spec, &to_save->full_shape, &to_save->slice, &slice_shape));
+      if (!slice_shape.IsSameSize(tensor.shape())) {
+        return errors::InvalidArgument(
+            "Slice in shape_and_slice "
+            "specification does not match the "
+            "shape of the tensor to  save: ",
+            shape_spec, ", tensor: ", tensor.shape().DebugString());
+      }
+      to_save->is_slice = true;
+    }
+  }
+  return Status::OK();
+}
+
+// Writes "tensors" into a tensor bundle at "prefix".
+Status WriteTensors(const string& prefix,
+                    const std::vector<TensorToSave>& tensors,
+                    const BundleWriter::Options& options) {
+  BundleWriter writer(Env::Default(), prefix, options);
+  TF_RETURN_IF_ERROR(writer.status());
+  VLOG(1) << "BundleWriter, prefix_string: " << prefix;
+
+  for (const TensorToSave& to_save : tensors) {
+    if (to_save.is_slice) {
+      TF_RETURN_IF_ERROR(writer.AddSlice(to_save.name, to_save.full_shape,
+                                         to_save.slice, to_save.tensor));
+    } else {
+      TF_RETURN_IF_ERROR(writer.Add(to_save.name, to_save.tensor));
+    }
+  }
+  return writer.Finish();
+}
+
+// Reads the number of data files of the bundles that SaveV2 and SaveV2Async
+// write.
+Status GetWriterOptions(BundleWriter::Options* options) {
+  // The number of data files the tensors are written to in parallel.
+  int64 num_shards;
+  TF_RETURN_IF_ERROR(
+      ReadInt64FromEnvVar("TF_CHECKPOINT_WRITE_SHARDS", 1, &num_shards));
+  options->num_shards = static_cast<int>(num_shards);
+  return Status::OK();
+}
+
+// The saves of the SaveV2Async ops of the process that have not completed,
+// and the results of those that have.
+class AsyncSaves {
+ public:
+  static AsyncSaves* Global() {
+    static AsyncSaves* saves = new AsyncSaves;
+    return saves;
+  }
+
+  // Runs "save", which writes the checkpoint "prefix", in the background,
+  // after waiting until fewer than "max_pending" saves are in progress.
+  void Schedule(int max_pending, const string& prefix,
+                std::function<Status()> save) {
+    {
+      mutex_lock l(mu_);
+      while (num_pending_ >= max_pending) {
+        cond_.wait(l);
+      }
+      ++num_pending_;
+    }
+    Env::Default()->SchedClosure([this, prefix, save]() {
+      const Status s = save();
+      if (!s.ok()) {
+        LOG(WARNING) << "Asynchronous save of " << prefix << " failed: " << s;
+      }
+      mutex_lock l(mu_);
+      --num_pending_;
+      if (s.ok()) {
+        completed_.push_back(prefix);
+      } else {
+        status_.Update(s);
+      }
+      cond_.notify_all();
+    });
+  }
+
+  // Waits until no save is in progress, and returns the prefixes of the
+  // checkpoints written since the last call in "completed", in the order in
+  // which they were completed, and the first error since the last call.
+  Status WaitForAll(std::vector<string>* completed) {
+    mutex_lock l(mu_);
+    while (num_pending_ > 0) {
+      cond_.wait(l);
+    }
+    completed->swap(completed_);
+    completed_.clear();
+    Status s = status_;
+    status_ = Status::OK();
+    return s;
+  }
+
+ private:
+  AsyncSaves() {}
+
+  mutex mu_;
+  condition_variable cond_;
+  int num_pending_ GUARDED_BY(mu_) = 0;
+  std::vector<string> completed_ GUARDED_BY(mu_);
+  Status status_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AsyncSaves);
+};
+
 }  // namespace
 
 // Saves a list of named tensors using the tensor bundle library.
 class SaveV2 : public OpKernel {
  public:
-  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {}
+  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, GetWriterOptions(&options_));
+  }
 
   void Compute(OpKernelContext* context) override {
     const Tensor& prefix = context->input(0);
@@ -98,52 +243,90 @@ class SaveV2 : public OpKernel {
     const Tensor& shape_and_slices = context->input(2);
     ValidateInputs(true /* is save op */, context, prefix, tensor_names,
                    shape_and_slices);
+    if (!context->status().ok()) return;
 
-    const int kFixedInputs = 3;  // Prefix, tensor names, shape_and_slices.
-    const int num_tensors = static_cast<int>(tensor_names.NumElements());
-    const string& prefix_string = prefix.scalar<string>()();
-    const auto& tensor_names_flat = tensor_names.flat<string>();
-    const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
-
-    BundleWriter writer(Env::Default(), prefix_string);
-    OP_REQUIRES_OK(context, writer.status());
-    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
-
-    for (int i = 0; i < num_tensors; ++i) {
-      const string& tensor_name = tensor_names_flat(i);
-      const Tensor& tensor = context->input(i + kFixedInputs);
-
-      if (!shape_and_slices_flat(i).empty()) {
-        const string& shape_spec = shape_and_slices_flat(i);
-        TensorShape shape;
-        TensorSlice slice(tensor.dims());
-        TensorShape slice_shape;
-
-        OP_REQUIRES_OK(context, checkpoint::ParseShapeAndSlice(
-                                    shape_spec, &shape, &slice, &slice_shape));
-        OP_REQUIRES(context, slice_shape.IsSameSize(tensor.shape()),
-                    errors::InvalidArgument("Slice in shape_and_slice "
-                                            "specification does not match the "
-                                            "shape of the tensor to  save: ",
-                                            shape_spec, ", tensor: ",
-                                            tensor.shape().DebugString()));
-
-        OP_REQUIRES_OK(context,
-                       writer.AddSlice(tensor_name, shape, slice, tensor));
-      } else {
-        OP_REQUIRES_OK(context, writer.Add(tensor_name, tensor));
-      }
-    }
-    OP_REQUIRES_OK(context, writer.Finish());
+    std::vector<TensorToSave> tensors;
+    OP_REQUIRES_OK(context,
+                   GetTensorsToSave(context, false /* copy */, &tensors));
+    OP_REQUIRES_OK(context, WriteTensors(prefix.scalar<string>()(), tensors,
+                                         options_));
   }
+
+ private:
+  BundleWriter::Options options_;
 };
 REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
 
+// Snapshots a list of named tensors, and saves them with the tensor bundle
+// library in the background.
+class SaveV2Async : public OpKernel {
+ public:
+  explicit SaveV2Async(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, GetWriterOptions(&options_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("max_pending_saves", &max_pending_saves_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& prefix = context->input(0);
+    const Tensor& tensor_names = context->input(1);
+    const Tensor& shape_and_slices = context->input(2);
+    ValidateInputs(true /* is save op */, context, prefix, tensor_names,
+                   shape_and_slices);
+    if (!context->status().ok()) return;
+
+    // The inputs may share their buffers with variables that the next steps
+    // update in place, so the write uses copies of them.
+    auto tensors = std::make_shared<std::vector<TensorToSave>>();
+    OP_REQUIRES_OK(context,
+                   GetTensorsToSave(context, true /* copy */, tensors.get()));
+    const string prefix_string = prefix.scalar<string>()();
+    const BundleWriter::Options options = options_;
+    AsyncSaves::Global()->Schedule(
+        max_pending_saves_, prefix_string, [prefix_string, tensors, options]() {
+          return WriteTensors(prefix_string, *tensors, options);
+        });
+  }
+
+ private:
+  BundleWriter::Options options_;
+  int max_pending_saves_;
+};
+REGISTER_KERNEL_BUILDER(Name("SaveV2Async").Device(DEVICE_CPU), SaveV2Async);
+
+// Waits for the saves of the SaveV2Async ops of the process.
+class WaitForAsyncSaves : public OpKernel {
+ public:
+  explicit WaitForAsyncSaves(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    std::vector<string> completed;
+    OP_REQUIRES_OK(context, AsyncSaves::Global()->WaitForAll(&completed));
+    Tensor* prefixes = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({static_cast<int64>(
+                                       completed.size())}),
+                                &prefixes));
+    auto prefixes_flat = prefixes->flat<string>();
+    for (size_t i = 0; i < completed.size(); ++i) {
+      prefixes_flat(i) = completed[i];
+    }
+  }
+};
+REGISTER_KERNEL_BUILDER(Name("WaitForAsyncSaves").Device(DEVICE_CPU),
+                        WaitForAsyncSaves);
+
 // Restores a list of named tensors from a tensor bundle (V2 checkpoint format).
 class RestoreV2 : public OpKernel {
  public:
   explicit RestoreV2(OpKernelConstruction* context) : OpKernel(context) {
     OP_REQUIRES_OK(context, context->GetAttr("dtypes", &dtypes_));
+    OP_REQUIRES_OK(context, context->GetAttr("memory_map", &memory_map_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("warm_up_tensors", &warm_up_tensors_));
+    OP_REQUIRES_OK(context, context->GetAttr("max_parallel_reads",
+                                             &max_parallel_reads_));
   }
 
   void Compute(OpKernelContext* context) override {
@@ -174,13 +357,21 @@ class RestoreV2 : public OpKernel {
       return;
     }
     // If found, invokes the V2 reader.
-    OP_REQUIRES_OK(context, RestoreTensorsV2(context, prefix, tensor_names,
-                                             shape_and_slices, dtypes_));
+    OP_REQUIRES_OK(context,
+                   RestoreTensorsV2(context, prefix, tensor_names,
+                                    shape_and_slices, dtypes_, memory_map_,
+                                    warm_up_tensors_, max_parallel_reads_));
   }
 
  private:
   // Expected dtypes of the to-restore tensors.
   std::vector<DataType> dtypes_;
+  // Whether to return tensors backed by the memory-mapped data file.
+  bool memory_map_;
+  // The mapped tensors whose pages are read during the restore.
+  std::vector<string> warm_up_tensors_;
+  // The maximum number of tensors read at once, or 0 for one per data file.
+  int max_parallel_reads_;
 };
 REGISTER_KERNEL_BUILDER(Name("RestoreV2").Device(DEVICE_CPU), RestoreV2);
 
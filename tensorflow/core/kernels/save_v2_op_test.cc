@@ -20,6 +20,8 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_slice.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
@@ -339,5 +341,72 @@ TEST_F(SaveV2OpTest, Simple) {
   }
 }
 
+class SaveV2AsyncOpTest : public OpsTestBase {
+ protected:
+  void MakeSaveOp() {
+    TF_ASSERT_OK(NodeDefBuilder("save", "SaveV2Async")
+                     .Input(FakeInput())                    // prefix
+                     .Input(FakeInput())                    // tensor_names
+                     .Input(FakeInput())                    // shape_and_slices
+                     .Input(FakeInput({DT_FLOAT, DT_INT32}))  // tensors
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  void MakeWaitOp() {
+    inputs_.clear();
+    TF_ASSERT_OK(
+        NodeDefBuilder("wait", "WaitForAsyncSaves").Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(SaveV2AsyncOpTest, SavesSnapshot) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "tensor_async");
+  MakeSaveOp();
+  AddInputFromArray<string>(TensorShape({}), {prefix});
+  AddInputFromArray<string>(TensorShape({2}), {"floats", "ints"});
+  AddInputFromArray<string>(TensorShape({2}), {"", "4 0,2"});
+  AddInputFromArray<float>(TensorShape({3}), {1, 2, 3});
+  AddInputFromArray<int32>(TensorShape({2}), {4, 5});
+  TF_ASSERT_OK(RunOpKernel());
+  // The updates after the op do not change the checkpoint.
+  mutable_input(3).tensor->flat<float>().setZero();
+
+  MakeWaitOp();
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<string>(*GetOutput(0),
+                                  test::AsTensor<string>({prefix}));
+
+  BundleReader reader(Env::Default(), prefix);
+  TF_ASSERT_OK(reader.status());
+  Tensor floats;
+  TF_ASSERT_OK(reader.Lookup("floats", &floats));
+  test::ExpectTensorEqual<float>(floats, test::AsTensor<float>({1, 2, 3}));
+  Tensor ints(DT_INT32, TensorShape({2}));
+  TF_ASSERT_OK(
+      reader.LookupSlice("ints", TensorSlice::ParseOrDie("0,2"), &ints));
+  test::ExpectTensorEqual<int32>(ints, test::AsTensor<int32>({4, 5}));
+}
+
+TEST_F(SaveV2AsyncOpTest, WaitReportsErrors) {
+  // A prefix in a directory that is a file cannot be written.
+  const string file = io::JoinPath(testing::TmpDir(), "async_file");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), file, "x"));
+  MakeSaveOp();
+  AddInputFromArray<string>(TensorShape({}), {io::JoinPath(file, "ckpt")});
+  AddInputFromArray<string>(TensorShape({2}), {"floats", "ints"});
+  AddInputFromArray<string>(TensorShape({2}), {"", ""});
+  AddInputFromArray<float>(TensorShape({1}), {1});
+  AddInputFromArray<int32>(TensorShape({1}), {2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  MakeWaitOp();
+  EXPECT_FALSE(RunOpKernel().ok());
+  // The error is reported once.
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(0, GetOutput(0)->NumElements());
+}
+
 }  // namespace
 }  // namespace tensorflow
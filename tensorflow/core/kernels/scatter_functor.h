@@ -16,11 +16,15 @@ limitations under the License.
 #ifndef TENSORFLOW_KERNELS_SCATTER_FUNCTOR_H_
 #define TENSORFLOW_KERNELS_SCATTER_FUNCTOR_H_
 
+#include <algorithm>
 #include <type_traits>
+#include <vector>
 
+#include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -215,9 +219,85 @@ struct ScatterFunctorBase<CPUDevice, T, Index, scatter_op::UpdateOp::ASSIGN> {
   }
 };
 
+// Applies the updates in parallel when they are large enough, with each
+// thread applying, in their order, the updates of a range of rows of
+// "params". The results are then the same as those of ScatterFunctorBase,
+// even for repeated indices.
 template <typename T, typename Index, scatter_op::UpdateOp op>
-struct ScatterFunctor<CPUDevice, T, Index, op>
-        : ScatterFunctorBase<CPUDevice, T, Index, op>{};
+struct ScatterFunctor<CPUDevice, T, Index, op> {
+  // The minimum number of elements of the updates to split across threads.
+  static const int64 kMinParallelSize = 1 << 17;
+  // The number of ranges of rows per thread, to balance uneven indices.
+  static const int64 kRangesPerThread = 4;
+
+  Index operator()(OpKernelContext* c, const CPUDevice& d,
+                   typename TTypes<T>::Matrix params,
+                   typename TTypes<T>::ConstMatrix updates,
+                   typename TTypes<Index>::ConstFlat indices) {
+    ScatterFunctorBase<CPUDevice, T, Index, op> serial;
+    // indices and params sizes were validated in DoCompute().
+    const Index N = static_cast<Index>(indices.size());
+    const Index limit = static_cast<Index>(params.dimension(0));
+    const int64 cols = params.dimension(1);
+    auto worker_threads = c->device()->tensorflow_cpu_worker_threads();
+    if (worker_threads->num_threads <= 1 || limit <= 1 ||
+        static_cast<int64>(N) * cols < kMinParallelSize) {
+      return serial(c, d, params, updates, indices);
+    }
+
+    // Grab the indices once, so that they cannot change between the check
+    // and the update. If any of them is invalid, the serial version applies
+    // the updates before it and reports it.
+    std::vector<Index> rows(N);
+    for (Index i = 0; i < N; i++) {
+      rows[i] = ::tensorflow::internal::SubtleMustCopy(indices(i));
+      if (!FastBoundsCheck(rows[i], limit)) {
+        return serial(c, d, params, updates, indices);
+      }
+    }
+
+    // Sorts the updates by range of rows, keeping their order within each.
+    const int64 num_ranges = std::min<int64>(
+        limit, worker_threads->num_threads * kRangesPerThread);
+    const int64 rows_per_range = (limit + num_ranges - 1) / num_ranges;
+    std::vector<Index> starts(num_ranges + 1, 0);
+    for (Index i = 0; i < N; i++) ++starts[rows[i] / rows_per_range + 1];
+    for (int64 r = 0; r < num_ranges; ++r) starts[r + 1] += starts[r];
+    std::vector<Index> order(N);
+    {
+      std::vector<Index> next(starts.begin(), starts.end() - 1);
+      for (Index i = 0; i < N; i++) order[next[rows[i] / rows_per_range]++] = i;
+    }
+
+    auto work = [&](int64 start, int64 end) {
+      for (int64 r = start; r < end; ++r) {
+        for (Index k = starts[r]; k < starts[r + 1]; ++k) {
+          const Index i = order[k];
+          Update(params, updates, i, rows[i]);
+        }
+      }
+    };
+    const int64 cost = static_cast<int64>(N) / num_ranges * cols * 2;
+    Shard(worker_threads->num_threads, worker_threads->workers, num_ranges,
+          cost, work);
+    return -1;
+  }
+
+ private:
+  // Applies updates[i] to params[index].
+  static void Update(typename TTypes<T>::Matrix params,
+                     typename TTypes<T>::ConstMatrix updates, Index i,
+                     Index index) {
+    if (op == scatter_op::UpdateOp::ASSIGN && !std::is_same<T, string>::value) {
+      memmove(params.data() + index * params.dimension(1),
+              updates.data() + i * updates.dimension(1),
+              updates.dimension(1) * sizeof(T));
+    } else {
+      scatter_op::internal::Assign<op>::Run(params.template chip<0>(index),
+                                            updates.template chip<0>(i));
+    }
+  }
+};
 
 #ifdef TENSORFLOW_USE_SYCL
 template <typename T, typename Index, scatter_op::UpdateOp op>
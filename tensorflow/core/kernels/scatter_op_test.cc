@@ -223,6 +223,70 @@ TEST_F(ScatterUpdateOpTest, Error_MismatchedIndicesAndUpdateDimensions) {
       << s;
 }
 
+class ScatterAddOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(DataType variable_ref_type, DataType index_type) {
+    TF_ASSERT_OK(NodeDefBuilder("myop", "ScatterAdd")
+                     .Input(FakeInput(variable_ref_type))
+                     .Input(FakeInput(index_type))
+                     .Input(FakeInput(RemoveRefType(variable_ref_type)))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+// Large enough updates to be applied by several threads.
+TEST_F(ScatterAddOpTest, Large_RepeatedIndices) {
+  MakeOp(DT_FLOAT_REF, DT_INT32);
+  const int kRows = 100;
+  const int kCols = 512;
+  const int kUpdates = 1000;
+
+  std::vector<float> params(kRows * kCols);
+  for (int i = 0; i < kRows * kCols; ++i) params[i] = i % 13;
+  std::vector<int32> indices(kUpdates);
+  std::vector<float> updates(kUpdates * kCols);
+  std::vector<float> expected = params;
+  for (int i = 0; i < kUpdates; ++i) {
+    // Most updates go to the first rows.
+    indices[i] = (i % 3 == 0) ? (i * 7) % kRows : i % 5;
+    for (int j = 0; j < kCols; ++j) {
+      updates[i * kCols + j] = 0.1f * ((i + j) % 17);
+      expected[indices[i] * kCols + j] += updates[i * kCols + j];
+    }
+  }
+  AddInputFromArray<float>(TensorShape({kRows, kCols}), params);
+  AddInputFromArray<int32>(TensorShape({kUpdates}), indices);
+  AddInputFromArray<float>(TensorShape({kUpdates, kCols}), updates);
+  TF_ASSERT_OK(RunOpKernel());
+
+  // The updates of each row are applied in order, so the sums are exact.
+  Tensor params_tensor = *mutable_input(0).tensor;
+  Tensor expected_tensor(allocator(), DT_FLOAT, TensorShape({kRows, kCols}));
+  test::FillValues<float>(&expected_tensor, expected);
+  test::ExpectTensorEqual<float>(expected_tensor, params_tensor);
+}
+
+TEST_F(ScatterAddOpTest, Large_Error_IndexOutOfRange) {
+  MakeOp(DT_FLOAT_REF, DT_INT64);
+  const int kRows = 10;
+  const int kCols = 1024;
+  const int kUpdates = 200;
+
+  std::vector<int64> indices(kUpdates);
+  for (int i = 0; i < kUpdates; ++i) indices[i] = i % kRows;
+  indices[150] = 99;
+  AddInputFromArray<float>(TensorShape({kRows, kCols}),
+                           std::vector<float>(kRows * kCols, 0));
+  AddInputFromArray<int64>(TensorShape({kUpdates}), indices);
+  AddInputFromArray<float>(TensorShape({kUpdates, kCols}),
+                           std::vector<float>(kUpdates * kCols, 1));
+  Status s = RunOpKernel();
+  EXPECT_TRUE(
+      StringPiece(s.ToString()).contains("indices[150] = 99 is not in [0, 10)"))
+      << s;
+}
+
 class ScatterUpdateBM : public ScatterUpdateOpTest {
  public:
   void TestBody() override {}
@@ -21,6 +21,8 @@ limitations under the License.
 #endif  // GOOGLE_CUDA
 
 #include "tensorflow/core/kernels/segment_reduction_ops.h"
+#include <algorithm>
+#include <functional>
 #include <vector>
 #include "third_party/eigen3/Eigen/Core"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -33,7 +35,9 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #if GOOGLE_CUDA
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
@@ -68,6 +72,61 @@ static bool SegmentReductionDoValidation(OpKernelContext* c,
   return c->status().ok();
 }
 
+// The number of elements of the input of a sorted segment reduction above
+// which its segments are reduced in parallel.
+static const int64 kParallelSegmentReductionMinElements = 1 << 17;
+
+// Splits the positions of "segment_ids", which must be sorted, into at most
+// "num_ranges" ranges of about the same size that start and end at segment
+// boundaries. Returns the starts of the ranges followed by the number of ids.
+template <typename Index>
+std::vector<int64> SegmentRangeStarts(const Index* segment_ids,
+                                      int64 num_ids, int64 num_ranges) {
+  std::vector<int64> starts = {0};
+  for (int64 r = 1; r < num_ranges; ++r) {
+    const int64 nominal_start = num_ids * r / num_ranges;
+    if (nominal_start <= starts.back()) continue;
+    // Moves the start past the rest of the segment it is in.
+    const int64 start =
+        std::upper_bound(segment_ids + nominal_start, segment_ids + num_ids,
+                         segment_ids[nominal_start - 1]) -
+        segment_ids;
+    if (start >= num_ids) break;
+    starts.push_back(start);
+  }
+  starts.push_back(num_ids);
+  return starts;
+}
+
+// Calls "reduce(begin, end, uninitialized_index)" for ranges of positions of
+// the sorted "segment_ids" that start and end at segment boundaries, in
+// parallel, where "uninitialized_index" is the first output row after the
+// segments before "begin". Returns the first error of the ranges, in order.
+template <typename Index>
+Status ReduceSegmentRangesInParallel(
+    OpKernelContext* context, const Index* segment_ids, int64 num_ids,
+    int64 cost_per_id,
+    const std::function<Status(int64, int64, Index)>& reduce) {
+  auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+  const std::vector<int64> starts = SegmentRangeStarts(
+      segment_ids, num_ids, 4 * worker_threads->num_threads);
+  const int64 num_ranges = starts.size() - 1;
+  std::vector<Status> statuses(num_ranges);
+  auto work = [&](int64 first_range, int64 last_range) {
+    for (int64 r = first_range; r < last_range; ++r) {
+      const Index uninitialized_index =
+          starts[r] == 0 ? 0 : segment_ids[starts[r] - 1] + 1;
+      statuses[r] = reduce(starts[r], starts[r + 1], uninitialized_index);
+    }
+  };
+  Shard(worker_threads->num_threads, worker_threads->workers, num_ranges,
+        cost_per_id * num_ids / num_ranges, work);
+  for (const Status& s : statuses) {
+    TF_RETURN_IF_ERROR(s);
+  }
+  return Status::OK();
+}
+
 // This operator handles reducing segments along the first dimension.
 // See core/ops/math_ops.cc for more details.
 template <typename Device, class T, class Index, typename Reducer,
@@ -111,47 +170,79 @@ class SegmentReductionOp : public OpKernel {
                 errors::InvalidArgument("segment ids must be >= 0"));
     auto output_flat = output->flat_outer_dims<T>();
 
+    // The ids must be sorted for the ranges of segments to be found by
+    // binary search. If they are not, the serial loop reports the error.
+    const Index* segment_ids_data = segment_vec.data();
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    if (worker_threads->num_threads > 1 &&
+        num_indices * num_col >= kParallelSegmentReductionMinElements &&
+        std::is_sorted(segment_ids_data, segment_ids_data + num_indices)) {
+      OP_REQUIRES_OK(
+          context,
+          ReduceSegmentRangesInParallel<Index>(
+              context, segment_ids_data, num_indices, 2 * num_col,
+              [&](int64 begin, int64 end, Index uninitialized_index) {
+                return ReduceSegments(input_flat, segment_vec, output_rows,
+                                      begin, end, uninitialized_index,
+                                      output_flat);
+              }));
+      return;
+    }
+    OP_REQUIRES_OK(context,
+                   ReduceSegments(input_flat, segment_vec, output_rows, 0,
+                                  num_indices, 0, output_flat));
+  }
+
+ private:
+  // Reduces the segments of the rows [begin, end) of "input_flat", which
+  // start and end at segment boundaries, into "output_flat". Also sets the
+  // rows of "output_flat" from "uninitialized_index" up to their segments
+  // that no id refers to to the default value.
+  static Status ReduceSegments(typename TTypes<T>::ConstMatrix input_flat,
+                               typename TTypes<Index>::ConstVec segment_vec,
+                               const Index output_rows, const int64 begin,
+                               const int64 end, Index uninitialized_index,
+                               typename TTypes<T>::Matrix output_flat) {
+    const int64 num_col = input_flat.dimension(1);
 #if !defined(EIGEN_HAS_INDEX_LIST)
     Eigen::DSizes<Eigen::DenseIndex, 1> dims_to_reduce;
     dims_to_reduce[0] = 0;
 #else
     Eigen::IndexList<Eigen::type2index<0>> dims_to_reduce;
 #endif
-    Index start = 0, end = 1;
+    int64 start = begin, next = begin + 1;
 
-    Index uninitialized_index = 0;  // Index from which the output is not set.
     Index out_index = internal::SubtleMustCopy(segment_vec(start));
 
-    // TODO(agarwal): if this loop becomes a bottleneck, consider sharding it
-    // across threads.
     Eigen::DSizes<Eigen::DenseIndex, 1> out_slice_shape(num_col);
-    while (end <= num_indices) {
+    while (next <= end) {
       // We initialize next_index to 0 to avoid "warning: 'next_index' may be
       // used uninitialized in this function" in the Mac build (since the
       // compiler isn't smart enough to realize the code is safe).
       Index next_index = 0;
-      if (end < num_indices) {
-        next_index = internal::SubtleMustCopy(segment_vec(end));
+      if (next < end) {
+        next_index = internal::SubtleMustCopy(segment_vec(next));
         if (out_index == next_index) {
-          ++end;
+          ++next;
           continue;
         }
         // We have a new segment here.  Verify that the segment ids are growing.
-        OP_REQUIRES(context, out_index < next_index,
-                    errors::InvalidArgument("segment ids are not increasing"));
+        if (out_index > next_index) {
+          return errors::InvalidArgument("segment ids are not increasing");
+        }
       }
 
-      // Process segment [start, end)
+      // Process segment [start, next)
       const T* in_slice_ptr = &input_flat(start, 0);
       typedef Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>,
                                Eigen::Unaligned>
           OutT;
 
-      OP_REQUIRES(
-          context, FastBoundsCheck(out_index, output_rows),
-          errors::InvalidArgument(
-              "Segment id ", out_index, " out of range [0, ", output_rows,
-              "), possibly because 'segment_ids' input is not sorted."));
+      if (!FastBoundsCheck(out_index, output_rows)) {
+        return errors::InvalidArgument(
+            "Segment id ", out_index, " out of range [0, ", output_rows,
+            "), possibly because 'segment_ids' input is not sorted.");
+      }
 
       // If there is a gap between two indices, we need to set that gap to the
       // default value.
@@ -169,14 +260,14 @@ class SegmentReductionOp : public OpKernel {
       // because these pieces of work are likely to be very small and
       // the context switching overhead dwarfs any benefit we get from
       // using another thread to do this work.
-      if (start == end - 1) {
+      if (start == next - 1) {
         typedef Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>,
                                  Eigen::Unaligned>
             InT;
         InT in_slice(in_slice_ptr, out_slice_shape);
         out_slice = in_slice;
       } else {
-        Eigen::DSizes<Eigen::DenseIndex, 2> in_slice_shape(end - start,
+        Eigen::DSizes<Eigen::DenseIndex, 2> in_slice_shape(next - start,
                                                            num_col);
         typedef Eigen::TensorMap<Eigen::Tensor<const T, 2, Eigen::RowMajor>,
                                  Eigen::Unaligned>
@@ -185,12 +276,13 @@ class SegmentReductionOp : public OpKernel {
 
         out_slice = in_slice.reduce(dims_to_reduce, Reducer());
       }
-      if (end >= num_indices) break;
-      start = end;
-      ++end;
+      if (next >= end) break;
+      start = next;
+      ++next;
       uninitialized_index = out_index + 1;
       out_index = next_index;
     }
+    return Status::OK();
   }
 };
 
@@ -545,7 +637,7 @@ TF_CALL_complex128(REGISTER_GPU_UNSORTED_KERNELS_ALL);
 // Same as SegmentReductionOp but takes as input a "sparse" tensor, represented
 // by two dense tensors, one containing the data, and the other containing
 // indices into the data.
-template <typename Device, class T>
+template <typename Device, class T, typename Index>
 class SparseSegmentReductionOpBase : public OpKernel {
  public:
   explicit SparseSegmentReductionOpBase(OpKernelConstruction* context,
@@ -574,7 +666,6 @@ class SparseSegmentReductionOpBase : public OpKernel {
     auto input_flat = input.flat_outer_dims<T>();
     const int64 num_col = input_flat.dimension(1);
     const auto indices_vec = indices.vec<Index>();
-    typedef int32 OutputRow;
     const auto segment_vec = segment_ids.vec<OutputRow>();
     // Note that the current implementation assumes that segment_vec values are
     // sorted.
@@ -597,32 +688,68 @@ class SparseSegmentReductionOpBase : public OpKernel {
                 errors::InvalidArgument("segment ids must be >= 0"));
     auto output_flat = output->flat_outer_dims<T>();
 
-    int64 start = 0, end = 1;
-    // Index from which the output is not initialized.
-    OutputRow uninitialized_index = 0;
-    OutputRow out_index = internal::SubtleMustCopy(segment_vec(start));
+    const OutputRow* segment_ids_data = segment_vec.data();
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    if (worker_threads->num_threads > 1 &&
+        num_indices * num_col >= kParallelSegmentReductionMinElements &&
+        std::is_sorted(segment_ids_data, segment_ids_data + num_indices)) {
+      OP_REQUIRES_OK(
+          context,
+          ReduceSegmentRangesInParallel<OutputRow>(
+              context, segment_ids_data, num_indices, 2 * num_col,
+              [&](int64 begin, int64 end, OutputRow uninitialized_index) {
+                return ReduceSegments(input_flat, indices_vec, segment_vec,
+                                      output_rows, begin, end,
+                                      uninitialized_index, output_flat);
+              }));
+      return;
+    }
+    OP_REQUIRES_OK(context,
+                   ReduceSegments(input_flat, indices_vec, segment_vec,
+                                  output_rows, 0, num_indices, 0, output_flat));
+  }
 
+ private:
+  static const int64 kPrefetchRows = 8;
+
+  typedef int32 OutputRow;
+
+  // Reduces the segments of the positions [begin, end) of "indices_vec" and
+  // "segment_vec", which start and end at segment boundaries, into
+  // "output_flat". Also sets the rows of "output_flat" from
+  // "uninitialized_index" up to their segments that no id refers to to the
+  // default value.
+  Status ReduceSegments(typename TTypes<T>::ConstMatrix input_flat,
+                        typename TTypes<Index>::ConstVec indices_vec,
+                        typename TTypes<OutputRow>::ConstVec segment_vec,
+                        const OutputRow output_rows, const int64 begin,
+                        const int64 end, OutputRow uninitialized_index,
+                        typename TTypes<T>::Matrix output_flat) {
+    const int64 num_col = input_flat.dimension(1);
+    int64 start = begin, next = begin + 1;
+    OutputRow out_index = internal::SubtleMustCopy(segment_vec(start));
     while (true) {
       // We initialize next_index to 0 to avoid "warning: 'next_index' may be
       // used uninitialized in this function" in the Mac build (since the
       // compiler isn't smart enough to realize the code is safe).
       OutputRow next_index = 0;
-      if (end < num_indices) {
-        next_index = internal::SubtleMustCopy(segment_vec(end));
+      if (next < end) {
+        next_index = internal::SubtleMustCopy(segment_vec(next));
         if (out_index == next_index) {
-          ++end;
+          ++next;
           continue;
         }
         // We have a new segment here.  Verify that the segment ids are growing.
-        OP_REQUIRES(context, out_index < next_index,
-                    errors::InvalidArgument("segment ids are not increasing"));
+        if (out_index > next_index) {
+          return errors::InvalidArgument("segment ids are not increasing");
+        }
       }
 
-      OP_REQUIRES(
-          context, FastBoundsCheck(out_index, output_rows),
-          errors::InvalidArgument(
-              "Segment id ", out_index, " out of range [0, ", output_rows,
-              "), possibly because 'segment_ids' input is not sorted."));
+      if (!FastBoundsCheck(out_index, output_rows)) {
+        return errors::InvalidArgument(
+            "Segment id ", out_index, " out of range [0, ", output_rows,
+            "), possibly because 'segment_ids' input is not sorted.");
+      }
 
       // If there is a gap between two indices, we need to set that gap to the
       // default value.
@@ -634,26 +761,35 @@ class SparseSegmentReductionOpBase : public OpKernel {
         gap_slice.setConstant(default_value_);
       }
 
+      // Prefetches the first rows of the next segment while this one is
+      // reduced, as the rows of 'input' are usually read in a random order.
+      const int64 prefetch_end = std::min(next + kPrefetchRows, end);
+      for (int64 i = next; i < prefetch_end; ++i) {
+        const Index index = internal::SubtleMustCopy(indices_vec(i));
+        if (FastBoundsCheck(index, input_flat.dimension(0))) {
+          port::prefetch<port::PREFETCH_HINT_T0>(&input_flat(index, 0));
+        }
+      }
+
       auto out = output_flat.template chip<0>(out_index);
       const int bad_offset =
-          Reduce(input_flat, indices_vec, start, end - start, out);
-      OP_REQUIRES(context, bad_offset < 0,
-                  errors::InvalidArgument(
-                      "Bad: indices[", start + bad_offset, "] == ",
-                      indices_vec(start + bad_offset), " out of range [0, ",
-                      input_flat.dimension(0), ")"));
+          Reduce(input_flat, indices_vec, start, next - start, out);
+      if (bad_offset >= 0) {
+        return errors::InvalidArgument(
+            "Bad: indices[", start + bad_offset, "] == ",
+            indices_vec(start + bad_offset), " out of range [0, ",
+            input_flat.dimension(0), ")");
+      }
 
-      if (end >= num_indices) break;
-      start = end;
-      ++end;
+      if (next >= end) break;
+      start = next;
+      ++next;
       uninitialized_index = out_index + 1;
       out_index = next_index;
     }
+    return Status::OK();
   }
 
- private:
-  typedef int32 Index;
-
   int64 Reduce(const typename TTypes<T>::ConstMatrix& input_flat,
                const typename TTypes<Index>::ConstVec& indices_vec, int64 start,
                int64 num,
@@ -786,65 +922,223 @@ class SparseSegmentReductionOpBase : public OpKernel {
   const T default_value_;
 };
 
-template <typename Device, class T>
+template <typename Device, class T, typename Index>
 class SparseSegmentReductionMeanOp
-    : public SparseSegmentReductionOpBase<Device, T> {
+    : public SparseSegmentReductionOpBase<Device, T, Index> {
  public:
   explicit SparseSegmentReductionMeanOp(OpKernelConstruction* context)
-      : SparseSegmentReductionOpBase<Device, T>(context, true /*is_mean*/,
-                                                false /*is_sqrtn*/,
-                                                T(0) /* default_value */) {}
+      : SparseSegmentReductionOpBase<Device, T, Index>(
+            context, true /*is_mean*/, false /*is_sqrtn*/,
+            T(0) /* default_value */) {}
 };
 
-template <typename Device, class T>
+template <typename Device, class T, typename Index>
 class SparseSegmentReductionSqrtNOp
-    : public SparseSegmentReductionOpBase<Device, T> {
+    : public SparseSegmentReductionOpBase<Device, T, Index> {
  public:
   explicit SparseSegmentReductionSqrtNOp(OpKernelConstruction* context)
-      : SparseSegmentReductionOpBase<Device, T>(context, false /*is_mean*/,
-                                                true /*is_sqrtn*/,
-                                                T(0) /* default_value */) {}
+      : SparseSegmentReductionOpBase<Device, T, Index>(
+            context, false /*is_mean*/, true /*is_sqrtn*/,
+            T(0) /* default_value */) {}
 };
 
-template <typename Device, class T>
+template <typename Device, class T, typename Index>
 class SparseSegmentReductionSumOp
-    : public SparseSegmentReductionOpBase<Device, T> {
+    : public SparseSegmentReductionOpBase<Device, T, Index> {
  public:
   explicit SparseSegmentReductionSumOp(OpKernelConstruction* context)
-      : SparseSegmentReductionOpBase<Device, T>(context, false /*is_mean*/,
-                                                false /*is_sqrtn*/,
-                                                T(0) /* default_value */) {}
+      : SparseSegmentReductionOpBase<Device, T, Index>(
+            context, false /*is_mean*/, false /*is_sqrtn*/,
+            T(0) /* default_value */) {}
 };
 
-#define REGISTER_CPU_SPARSE_KERNELS(type)                     \
-  REGISTER_KERNEL_BUILDER(Name("SparseSegmentSum")            \
-                              .Device(DEVICE_CPU)             \
-                              .TypeConstraint<type>("T")      \
-                              .TypeConstraint<int32>("Tidx"), \
-                          SparseSegmentReductionSumOp<CPUDevice, type>);
-
-TF_CALL_REAL_NUMBER_TYPES(REGISTER_CPU_SPARSE_KERNELS);
+#define REGISTER_CPU_SPARSE_KERNELS(type, index_type)                  \
+  REGISTER_KERNEL_BUILDER(Name("SparseSegmentSum")                     \
+                              .Device(DEVICE_CPU)                      \
+                              .TypeConstraint<type>("T")               \
+                              .TypeConstraint<index_type>("Tidx"),     \
+                          SparseSegmentReductionSumOp<CPUDevice, type, \
+                                                      index_type>);
+#define REGISTER_CPU_SPARSE_KERNELS_ALL(type) \
+  REGISTER_CPU_SPARSE_KERNELS(type, int32);   \
+  REGISTER_CPU_SPARSE_KERNELS(type, int64)
+
+TF_CALL_REAL_NUMBER_TYPES(REGISTER_CPU_SPARSE_KERNELS_ALL);
 #undef REGISTER_CPU_SPARSE_KERNELS
 
-#define REGISTER_CPU_SPARSE_KERNELS(type)                     \
-  REGISTER_KERNEL_BUILDER(Name("SparseSegmentMean")           \
-                              .Device(DEVICE_CPU)             \
-                              .TypeConstraint<type>("T")      \
-                              .TypeConstraint<int32>("Tidx"), \
-                          SparseSegmentReductionMeanOp<CPUDevice, type>);
-REGISTER_CPU_SPARSE_KERNELS(float);
-REGISTER_CPU_SPARSE_KERNELS(double);
+#define REGISTER_CPU_SPARSE_KERNELS(type, index_type)                   \
+  REGISTER_KERNEL_BUILDER(Name("SparseSegmentMean")                     \
+                              .Device(DEVICE_CPU)                       \
+                              .TypeConstraint<type>("T")                \
+                              .TypeConstraint<index_type>("Tidx"),      \
+                          SparseSegmentReductionMeanOp<CPUDevice, type, \
+                                                       index_type>);
+REGISTER_CPU_SPARSE_KERNELS_ALL(float);
+REGISTER_CPU_SPARSE_KERNELS_ALL(double);
 #undef REGISTER_CPU_SPARSE_KERNELS
 
-#define REGISTER_CPU_SPARSE_KERNELS(type)                     \
-  REGISTER_KERNEL_BUILDER(Name("SparseSegmentSqrtN")          \
-                              .Device(DEVICE_CPU)             \
-                              .TypeConstraint<type>("T")      \
-                              .TypeConstraint<int32>("Tidx"), \
-                          SparseSegmentReductionSqrtNOp<CPUDevice, type>);
-REGISTER_CPU_SPARSE_KERNELS(float);
-REGISTER_CPU_SPARSE_KERNELS(double);
+#define REGISTER_CPU_SPARSE_KERNELS(type, index_type)                    \
+  REGISTER_KERNEL_BUILDER(Name("SparseSegmentSqrtN")                     \
+                              .Device(DEVICE_CPU)                        \
+                              .TypeConstraint<type>("T")                 \
+                              .TypeConstraint<index_type>("Tidx"),       \
+                          SparseSegmentReductionSqrtNOp<CPUDevice, type, \
+                                                        index_type>);
+REGISTER_CPU_SPARSE_KERNELS_ALL(float);
+REGISTER_CPU_SPARSE_KERNELS_ALL(double);
 #undef REGISTER_CPU_SPARSE_KERNELS
+#undef REGISTER_CPU_SPARSE_KERNELS_ALL
+
+#if GOOGLE_CUDA
+// GPU version of SparseSegmentReductionOpBase. The number of output rows is
+// the last segment id plus one, which is copied to the host before the output
+// is allocated, as in SegmentSumGPUOp. Unlike the CPU version, it does not
+// check that 'segment_ids' are sorted or that 'indices' are in range, and
+// skips the rows of 'indices' that are out of range.
+template <class T, class Index>
+class SparseSegmentReductionGPUOp : public AsyncOpKernel {
+ public:
+  explicit SparseSegmentReductionGPUOp(OpKernelConstruction* context,
+                                       bool is_mean, bool is_sqrtn)
+      : AsyncOpKernel(context), is_mean_(is_mean), is_sqrtn_(is_sqrtn) {}
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    const Tensor& input = context->input(0);
+    const Tensor& indices = context->input(1);
+    const Tensor& segment_ids = context->input(2);
+
+    OP_REQUIRES_ASYNC(
+        context, TensorShapeUtils::IsVector(indices.shape()),
+        errors::InvalidArgument("indices should be a vector."), done);
+    OP_REQUIRES_ASYNC(
+        context, TensorShapeUtils::IsVector(segment_ids.shape()),
+        errors::InvalidArgument("segment_ids should be a vector."), done);
+
+    const int64 num_indices = indices.NumElements();
+    OP_REQUIRES_ASYNC(
+        context, num_indices == segment_ids.NumElements(),
+        errors::InvalidArgument(
+            "segment_ids and indices should have same size."),
+        done);
+
+    if (num_indices == 0) {
+      TensorShape output_shape = input.shape();
+      output_shape.set_dim(0, 0);
+
+      Tensor* output = nullptr;
+      OP_REQUIRES_OK_ASYNC(
+          context, context->allocate_output(0, output_shape, &output), done);
+      done();
+      return;
+    }
+
+    perftools::gputools::DeviceMemoryBase output_rows_device(
+        const_cast<Tensor&>(segment_ids).template flat<int32>().data() +
+        (num_indices - 1));
+    ScratchSpace<int32> output_rows_host(context, 1, /* on_host */ true);
+
+    auto stream = context->op_device_context()->stream();
+    OP_REQUIRES_ASYNC(
+        context,
+        stream
+            ->ThenMemcpy(output_rows_host.mutable_data(), output_rows_device,
+                         sizeof(int32))
+            .ok(),
+        errors::Internal("SparseSegmentReductionGPUOp: failed to copy "
+                         "output_rows from device"),
+        done);
+
+    const bool is_mean = is_mean_;
+    const bool is_sqrtn = is_sqrtn_;
+    auto create_and_check_output = [context, output_rows_host, &input,
+                                    &indices, &segment_ids, is_mean, is_sqrtn,
+                                    done]() {
+      // Ensure that within the callback, the proper GPU settings are
+      // configured.
+      auto stream = context->op_device_context()->stream();
+      ScopedActivateExecutorContext scoped_activation{stream->parent()};
+
+      const int32 output_rows = *output_rows_host.data() + 1;
+      OP_REQUIRES_ASYNC(context, output_rows > 0,
+                        errors::InvalidArgument("segment ids must be >= 0"),
+                        done);
+
+      TensorShape output_shape = input.shape();
+      output_shape.set_dim(0, output_rows);
+
+      Tensor* output = nullptr;
+      OP_REQUIRES_OK_ASYNC(
+          context, context->allocate_output(0, output_shape, &output), done);
+
+      functor::SparseSegmentReductionFunctor<T, Index>()(
+          context, context->eigen_device<GPUDevice>(), output_rows,
+          input.dim_size(0), input.template flat<T>().data(),
+          indices.vec<Index>(), segment_ids.vec<int32>(), is_mean, is_sqrtn,
+          output->flat_outer_dims<T>());
+      done();
+    };
+
+    context->device()->tensorflow_gpu_device_info()->event_mgr->ThenExecute(
+        stream, create_and_check_output);
+  }
+
+ private:
+  const bool is_mean_;
+  const bool is_sqrtn_;
+};
+
+template <class T, class Index>
+class SparseSegmentReductionSumGPUOp
+    : public SparseSegmentReductionGPUOp<T, Index> {
+ public:
+  explicit SparseSegmentReductionSumGPUOp(OpKernelConstruction* context)
+      : SparseSegmentReductionGPUOp<T, Index>(context, false /*is_mean*/,
+                                              false /*is_sqrtn*/) {}
+};
+
+template <class T, class Index>
+class SparseSegmentReductionMeanGPUOp
+    : public SparseSegmentReductionGPUOp<T, Index> {
+ public:
+  explicit SparseSegmentReductionMeanGPUOp(OpKernelConstruction* context)
+      : SparseSegmentReductionGPUOp<T, Index>(context, true /*is_mean*/,
+                                              false /*is_sqrtn*/) {}
+};
+
+template <class T, class Index>
+class SparseSegmentReductionSqrtNGPUOp
+    : public SparseSegmentReductionGPUOp<T, Index> {
+ public:
+  explicit SparseSegmentReductionSqrtNGPUOp(OpKernelConstruction* context)
+      : SparseSegmentReductionGPUOp<T, Index>(context, false /*is_mean*/,
+                                              true /*is_sqrtn*/) {}
+};
+
+#define REGISTER_GPU_SPARSE_KERNELS(type, index_type)                         \
+  REGISTER_KERNEL_BUILDER(Name("SparseSegmentSum")                            \
+                              .Device(DEVICE_GPU)                             \
+                              .TypeConstraint<type>("T")                      \
+                              .TypeConstraint<index_type>("Tidx"),            \
+                          SparseSegmentReductionSumGPUOp<type, index_type>);  \
+  REGISTER_KERNEL_BUILDER(Name("SparseSegmentMean")                           \
+                              .Device(DEVICE_GPU)                             \
+                              .TypeConstraint<type>("T")                      \
+                              .TypeConstraint<index_type>("Tidx"),            \
+                          SparseSegmentReductionMeanGPUOp<type, index_type>); \
+  REGISTER_KERNEL_BUILDER(Name("SparseSegmentSqrtN")                          \
+                              .Device(DEVICE_GPU)                             \
+                              .TypeConstraint<type>("T")                      \
+                              .TypeConstraint<index_type>("Tidx"),            \
+                          SparseSegmentReductionSqrtNGPUOp<type, index_type>);
+#define REGISTER_GPU_SPARSE_KERNELS_ALL(type) \
+  REGISTER_GPU_SPARSE_KERNELS(type, int32);   \
+  REGISTER_GPU_SPARSE_KERNELS(type, int64)
+
+REGISTER_GPU_SPARSE_KERNELS_ALL(float);
+REGISTER_GPU_SPARSE_KERNELS_ALL(double);
+#undef REGISTER_GPU_SPARSE_KERNELS
+#undef REGISTER_GPU_SPARSE_KERNELS_ALL
+#endif  // GOOGLE_CUDA
 
 template <class T>
 class SparseSegmentGradOpBase : public OpKernel {
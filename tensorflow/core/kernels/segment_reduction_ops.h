@@ -46,6 +46,25 @@ struct SegmentSumFunctor {
                   const Index data_size, const T* data,
                   typename TTypes<T, 2>::Tensor output);
 };
+
+// Functor for SparseSegmentReductionGPUOp, which reduces the rows
+// 'data[indices[i]]' of each run of equal 'segment_ids', without gathering
+// them first.
+// 'output_rows': the number of output segments (the last segment id + 1).
+// 'data': input data tensor, reshaped to {data_rows, output.dimension(1)}.
+// 'indices': rows of 'data' to reduce. Out-of-range rows are skipped.
+// 'segment_ids': sorted output segment of each of 'indices'.
+// 'is_mean' / 'is_sqrtn': whether to divide each sum by the number of its
+//                         rows, or by the square root of it.
+// 'output': output reshaped to {output_rows, output.size/output_rows}
+template <typename T, typename Index>
+struct SparseSegmentReductionFunctor {
+  void operator()(OpKernelContext* ctx, const GPUDevice& d,
+                  const int32 output_rows, const Index data_rows,
+                  const T* data, typename TTypes<Index>::ConstVec indices,
+                  typename TTypes<int32>::ConstVec segment_ids, bool is_mean,
+                  bool is_sqrtn, typename TTypes<T, 2>::Tensor output);
+};
 #endif
 
 // BaseFunctor for definition of UnsorteSegmentReductionOp
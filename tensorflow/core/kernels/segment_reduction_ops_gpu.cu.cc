@@ -149,6 +149,44 @@ __global__ void UnsortedSegmentSumCustomKernel(
   }
 }
 
+// SparseSegmentReductionFunctor kernel reduces the rows 'input[indices[i]]'
+// of each run of equal 'segment_ids' straight from 'input'. Every element of
+// the inner dimension of each run is reduced by the thread of the first
+// index of the run, so that no atomic operations are needed for the output
+// and the result does not depend on the order of the threads.
+template <typename T, typename Index>
+__global__ void SparseSegmentReductionCustomKernel(
+    const Index num_indices, const Index inner_dim_size,
+    const int32 output_outer_dim_size, const Index input_outer_dim_size,
+    const Index* indices, const int32* segment_ids, const T* input,
+    const bool is_mean, const bool is_sqrtn, T* output) {
+  CUDA_1D_KERNEL_LOOP(thread_index, num_indices * inner_dim_size) {
+    const Index start = thread_index / inner_dim_size;
+    const Index segment_offset = thread_index % inner_dim_size;
+    const int32 segment_id = ldg(segment_ids + start);
+    if (start > 0 && ldg(segment_ids + start - 1) == segment_id) {
+      continue;
+    }
+    if (segment_id < 0 || segment_id >= output_outer_dim_size) {
+      continue;
+    }
+    T sum = T(0);
+    Index end = start;
+    for (; end < num_indices && ldg(segment_ids + end) == segment_id; ++end) {
+      const Index row = ldg(indices + end);
+      if (row >= 0 && row < input_outer_dim_size) {
+        sum += ldg(input + row * inner_dim_size + segment_offset);
+      }
+    }
+    if (is_mean) {
+      sum /= T(end - start);
+    } else if (is_sqrtn) {
+      sum /= sqrt(T(end - start));
+    }
+    output[segment_id * inner_dim_size + segment_offset] = sum;
+  }
+}
+
 namespace functor {
 
 template <typename T, typename Index>
@@ -229,6 +267,42 @@ struct UnsortedSegmentSumFunctor<GPUDevice, T, Index>: UnsortedSegmentBaseFuncto
   }
 };
 
+template <typename T, typename Index>
+void SparseSegmentReductionFunctor<T, Index>::operator()(
+    OpKernelContext* ctx, const GPUDevice& d, const int32 output_rows,
+    const Index data_rows, const T* data,
+    typename TTypes<Index>::ConstVec indices,
+    typename TTypes<int32>::ConstVec segment_ids, bool is_mean, bool is_sqrtn,
+    typename TTypes<T, 2>::Tensor output) {
+  if (output.size() == 0) {
+    return;
+  }
+  // Set 'output' to zeros, which is the value of the empty segments.
+  CudaLaunchConfig config = GetCudaLaunchConfig(output.size(), d);
+  SetZero<<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+      output.size(), output.data());
+
+  const Index num_indices = indices.dimension(0);
+  const Index inner_dim_size = output.dimension(1);
+  if (num_indices == 0 || inner_dim_size == 0) {
+    return;
+  }
+  config = GetCudaLaunchConfig(num_indices * inner_dim_size, d);
+  SparseSegmentReductionCustomKernel<T, Index>
+      <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+          num_indices, inner_dim_size, output_rows, data_rows, indices.data(),
+          segment_ids.data(), data, is_mean, is_sqrtn, output.data());
+}
+
+#define DEFINE_SPARSE_GPU_SPECS(T)                         \
+  template struct SparseSegmentReductionFunctor<T, int32>; \
+  template struct SparseSegmentReductionFunctor<T, int64>;
+
+TF_CALL_float(DEFINE_SPARSE_GPU_SPECS);
+TF_CALL_double(DEFINE_SPARSE_GPU_SPECS);
+
+#undef DEFINE_SPARSE_GPU_SPECS
+
 #define DEFINE_SORTED_GPU_SPECS_INDEX(T, Index) \
   template struct SegmentSumFunctor<T, Index>
 
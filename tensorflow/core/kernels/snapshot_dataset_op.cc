@@ -0,0 +1,566 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/dataset.h"
+
+#include <deque>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/graph/graph_def_builder.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+
+namespace {
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class SnapshotDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit SnapshotDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {}
+
+ protected:
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    string path;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<string>(ctx, "path", &path));
+    OP_REQUIRES(ctx, !path.empty(),
+                errors::InvalidArgument("`path` must not be empty."));
+
+    string compression_type;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<string>(ctx, "compression_type",
+                                                    &compression_type));
+    OP_REQUIRES(ctx,
+                compression_type.empty() || compression_type == "ZLIB" ||
+                    compression_type == "GZIP" || compression_type == "SNAPPY",
+                errors::InvalidArgument("Unsupported compression_type: ",
+                                        compression_type));
+
+    int64 num_shards;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<int64>(ctx, "num_shards", &num_shards));
+    OP_REQUIRES(
+        ctx, num_shards > 0,
+        errors::InvalidArgument("`num_shards` must be greater than zero."));
+
+    string fingerprint;
+    OP_REQUIRES_OK(ctx, Dataset::Fingerprint(input, &fingerprint));
+
+    *output = new Dataset(ctx, input, path, compression_type, num_shards,
+                          io::JoinPath(path, fingerprint));
+  }
+
+ private:
+  // Snapshot files are written under `<path>/<fingerprint>`, where the
+  // fingerprint is a hash of the graph that defines the input dataset:
+  //
+  //   <run>/shard_<i>-of-<n>: the `i`th of `n` shards of a snapshot, which
+  //       holds every `n`th element of the input. Each element is a sequence
+  //       of records, one per component, holding a serialized TensorProto.
+  //   snapshot.metadata: names the run directory of the last complete
+  //       snapshot, and the number of shards and compression it used. This
+  //       file is only written once all shards are complete, so an
+  //       interrupted run or concurrent writers never leave a partial
+  //       snapshot behind.
+  class Dataset : public GraphDatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, const DatasetBase* input, string path,
+            string compression_type, int64 num_shards, string directory)
+        : GraphDatasetBase(ctx),
+          input_(input),
+          path_(std::move(path)),
+          compression_type_(std::move(compression_type)),
+          num_shards_(num_shards),
+          directory_(std::move(directory)),
+          env_(ctx->env()) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    // Sets `*fingerprint` to a hash of the graph that defines `input`.
+    static Status Fingerprint(const DatasetBase* input, string* fingerprint) {
+      GraphDefBuilder b;
+      DatasetGraphDefBuilder db(&b);
+      Node* node = nullptr;
+      Status s = db.AddParentDataset(input, &node);
+      if (errors::IsUnimplemented(s)) {
+        return errors::Unimplemented(
+            "A snapshot can only be taken of a dataset whose graph can be "
+            "serialized, but its input is not serializable: ",
+            s.error_message());
+      }
+      TF_RETURN_IF_ERROR(s);
+      GraphDef graph_def;
+      TF_RETURN_IF_ERROR(b.ToGraphDef(&graph_def));
+      string serialized;
+      SerializeToStringDeterministic(graph_def, &serialized);
+      *fingerprint = strings::Printf(
+          "%016llx", static_cast<unsigned long long>(Hash64(serialized)));
+      return Status::OK();
+    }
+
+    std::unique_ptr<IteratorBase> MakeIterator(
+        const string& prefix) const override {
+      string run;
+      int64 num_shards;
+      string compression_type;
+      if (ReadMetadata(&run, &num_shards, &compression_type)) {
+        return std::unique_ptr<IteratorBase>(new ReaderIterator(
+            {this, strings::StrCat(prefix, "::SnapshotReader")}, run,
+            num_shards, compression_type));
+      }
+      return std::unique_ptr<IteratorBase>(
+          new WriterIterator({this, strings::StrCat(prefix, "::Snapshot")}));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return input_->output_dtypes();
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return input_->output_shapes();
+    }
+
+    string DebugString() override { return "SnapshotDatasetOp::Dataset"; }
+
+   protected:
+    Status AsGraphDefInternal(DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* input_graph_node = nullptr;
+      TF_RETURN_IF_ERROR(b->AddParentDataset(input_, &input_graph_node));
+      Node* path = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(path_, &path));
+      Node* compression_type = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(compression_type_, &compression_type));
+      Node* num_shards = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(num_shards_, &num_shards));
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this, {input_graph_node, path, compression_type, num_shards},
+          output));
+      return Status::OK();
+    }
+
+   private:
+    // The number of elements that a shard writer may have queued, and that a
+    // shard reader may read ahead of its consumer.
+    static const size_t kMaxPendingElements = 16;
+
+    // Shards are read with large sequential reads, several of which are
+    // kept outstanding.
+    static const int64 kReadBufferSize = 1 << 20;  // 1MB
+    static const int kNumReadaheadChunks = 4;
+
+    string MetadataFilename() const {
+      return io::JoinPath(directory_, "snapshot.metadata");
+    }
+
+    string ShardFilename(const string& run, int64 shard_index,
+                         int64 num_shards) const {
+      return io::JoinPath(directory_, run,
+                          strings::StrCat("shard_", shard_index, "-of-",
+                                          num_shards));
+    }
+
+    // Returns true if a complete snapshot exists, and sets the arguments to
+    // the run directory, number of shards and compression that it was written
+    // with.
+    bool ReadMetadata(string* run, int64* num_shards,
+                      string* compression_type) const {
+      string contents;
+      if (!ReadFileToString(env_, MetadataFilename(), &contents).ok()) {
+        return false;
+      }
+      // The compression type is the last field, and is empty if the shards
+      // are not compressed.
+      std::vector<string> fields = str_util::Split(contents, ' ');
+      if (fields.size() != 3 ||
+          !strings::safe_strto64(fields[1], num_shards) || *num_shards <= 0) {
+        LOG(WARNING) << "Ignoring malformed snapshot metadata "
+                     << MetadataFilename();
+        return false;
+      }
+      *run = fields[0];
+      *compression_type = fields[2];
+      return true;
+    }
+
+    // ShardWriter writes the elements of one shard on a thread of its own,
+    // so that the elements are serialized, compressed and written in
+    // parallel.
+    class ShardWriter {
+     public:
+      ShardWriter(const Dataset* dataset, const string& filename)
+          : dataset_(dataset), filename_(filename) {
+        thread_.reset(dataset->env_->StartThread(
+            {}, "snapshot_writer", [this]() { WriterThread(); }));
+      }
+
+      // Writes any elements that are still queued, and closes the shard.
+      ~ShardWriter() {
+        {
+          mutex_lock l(mu_);
+          finished_ = true;
+          cond_var_.notify_all();
+        }
+        thread_.reset();
+      }
+
+      // Queues `element` to be written, blocking while the queue is full.
+      // Returns the error from writing an earlier element, if any.
+      Status Add(const std::vector<Tensor>& element) {
+        mutex_lock l(mu_);
+        while (status_.ok() && pending_.size() >= kMaxPendingElements) {
+          cond_var_.wait(l);
+        }
+        TF_RETURN_IF_ERROR(status_);
+        pending_.push_back(element);
+        cond_var_.notify_all();
+        return Status::OK();
+      }
+
+      // Writes all queued elements and closes the shard.
+      Status Finish() {
+        {
+          mutex_lock l(mu_);
+          finished_ = true;
+          cond_var_.notify_all();
+        }
+        // Joins the writer thread.
+        thread_.reset();
+        mutex_lock l(mu_);
+        return status_;
+      }
+
+     private:
+      void WriterThread() {
+        Status s = WriteShard();
+        mutex_lock l(mu_);
+        status_.Update(s);
+        cond_var_.notify_all();
+      }
+
+      Status WriteShard() {
+        std::unique_ptr<WritableFile> file;
+        TF_RETURN_IF_ERROR(
+            dataset_->env_->NewWritableFile(filename_, &file));
+        io::RecordWriter writer(
+            file.get(), io::RecordWriterOptions::CreateRecordWriterOptions(
+                            dataset_->compression_type_));
+        string record;
+        while (true) {
+          std::vector<Tensor> element;
+          {
+            mutex_lock l(mu_);
+            while (!finished_ && pending_.empty()) {
+              cond_var_.wait(l);
+            }
+            if (pending_.empty()) {
+              break;
+            }
+            element = std::move(pending_.front());
+            pending_.pop_front();
+            cond_var_.notify_all();
+          }
+          for (const Tensor& t : element) {
+            TensorProto proto;
+            // Numeric tensors are stored as their raw bytes, which are
+            // copied straight into the tensor buffer when read back.
+            t.AsProtoTensorContent(&proto);
+            proto.SerializeToString(&record);
+            TF_RETURN_IF_ERROR(writer.WriteRecord(record));
+          }
+        }
+        TF_RETURN_IF_ERROR(writer.Close());
+        return file->Close();
+      }
+
+      const Dataset* const dataset_;
+      const string filename_;
+      mutex mu_;
+      condition_variable cond_var_;
+      std::deque<std::vector<Tensor>> pending_ GUARDED_BY(mu_);
+      bool finished_ GUARDED_BY(mu_) = false;
+      Status status_ GUARDED_BY(mu_);
+      std::unique_ptr<Thread> thread_;
+    };  // ShardWriter
+
+    // ShardReader reads the elements of one shard on a thread of its own, up
+    // to `kMaxPendingElements` ahead of its consumer.
+    class ShardReader {
+     public:
+      ShardReader(const Dataset* dataset, const string& filename,
+                  const string& compression_type)
+          : dataset_(dataset),
+            filename_(filename),
+            compression_type_(compression_type) {
+        thread_.reset(dataset->env_->StartThread(
+            {}, "snapshot_reader", [this]() { ReaderThread(); }));
+      }
+
+      ~ShardReader() {
+        {
+          mutex_lock l(mu_);
+          cancelled_ = true;
+          cond_var_.notify_all();
+        }
+        thread_.reset();
+      }
+
+      // Returns the next element of the shard, blocking until it has been
+      // read.
+      Status GetNext(std::vector<Tensor>* out_tensors, bool* end_of_shard) {
+        mutex_lock l(mu_);
+        while (buffer_.empty() && !end_of_shard_) {
+          cond_var_.wait(l);
+        }
+        if (buffer_.empty()) {
+          *end_of_shard = true;
+          return Status::OK();
+        }
+        *end_of_shard = false;
+        Status s = buffer_.front().status;
+        if (s.ok()) {
+          *out_tensors = std::move(buffer_.front().value);
+        }
+        buffer_.pop_front();
+        cond_var_.notify_all();
+        return s;
+      }
+
+     private:
+      struct BufferElement {
+        Status status;
+        std::vector<Tensor> value;
+      };
+
+      void ReaderThread() {
+        Status s = ReadShard();
+        mutex_lock l(mu_);
+        if (!s.ok()) {
+          BufferElement element;
+          element.status = s;
+          buffer_.push_back(std::move(element));
+        }
+        end_of_shard_ = true;
+        cond_var_.notify_all();
+      }
+
+      Status ReadShard() {
+        std::unique_ptr<RandomAccessFile> file;
+        TF_RETURN_IF_ERROR(
+            dataset_->env_->NewRandomAccessFile(filename_, &file));
+        io::RecordReaderOptions options =
+            io::RecordReaderOptions::CreateRecordReaderOptions(
+                compression_type_);
+        options.buffer_size = kReadBufferSize;
+        options.num_readahead_chunks = kNumReadaheadChunks;
+        io::SequentialRecordReader reader(file.get(), options);
+
+        const DataTypeVector& dtypes = dataset_->output_dtypes();
+        string record;
+        while (true) {
+          {
+            mutex_lock l(mu_);
+            while (!cancelled_ && buffer_.size() >= kMaxPendingElements) {
+              cond_var_.wait(l);
+            }
+            if (cancelled_) {
+              return Status::OK();
+            }
+          }
+          BufferElement element;
+          element.value.reserve(dtypes.size());
+          for (size_t i = 0; i < dtypes.size(); ++i) {
+            Status s = reader.ReadRecord(&record);
+            if (errors::IsOutOfRange(s)) {
+              if (i == 0) {
+                return Status::OK();
+              }
+              return errors::DataLoss("Snapshot shard ", filename_,
+                                      " ends in the middle of an element.");
+            }
+            TF_RETURN_IF_ERROR(s);
+            TensorProto proto;
+            Tensor t;
+            if (!proto.ParseFromString(record) ||
+                !t.FromProto(cpu_allocator(), proto)) {
+              return errors::DataLoss("Malformed tensor in snapshot shard ",
+                                      filename_);
+            }
+            if (t.dtype() != dtypes[i]) {
+              return errors::InvalidArgument(
+                  "Snapshot shard ", filename_, " holds a tensor of type ",
+                  DataTypeString(t.dtype()), " for component ", i,
+                  ", but the dataset produces ", DataTypeString(dtypes[i]));
+            }
+            element.value.push_back(std::move(t));
+          }
+          mutex_lock l(mu_);
+          buffer_.push_back(std::move(element));
+          cond_var_.notify_all();
+        }
+      }
+
+      const Dataset* const dataset_;
+      const string filename_;
+      const string compression_type_;
+      mutex mu_;
+      condition_variable cond_var_;
+      std::deque<BufferElement> buffer_ GUARDED_BY(mu_);
+      bool cancelled_ GUARDED_BY(mu_) = false;
+      bool end_of_shard_ GUARDED_BY(mu_) = false;
+      std::unique_ptr<Thread> thread_;
+    };  // ShardReader
+
+    // WriterIterator passes through the elements of the input dataset, and
+    // hands them round-robin to the shard writers. Once the input is
+    // exhausted and all shards are complete, the metadata file is replaced
+    // to point at the new snapshot.
+    class WriterIterator : public DatasetIterator<Dataset> {
+     public:
+      explicit WriterIterator(const Params& params)
+          : DatasetIterator<Dataset>(params),
+            input_impl_(params.dataset->input_->MakeIterator(params.prefix)),
+            run_(strings::Printf("run_%016llx",
+                                 static_cast<unsigned long long>(
+                                     random::New64()))) {}
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        if (iteration_completed_) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        if (shards_.empty()) {
+          TF_RETURN_IF_ERROR(dataset()->env_->RecursivelyCreateDir(
+              io::JoinPath(dataset()->directory_, run_)));
+          for (int64 i = 0; i < dataset()->num_shards_; ++i) {
+            shards_.emplace_back(new ShardWriter(
+                dataset(),
+                dataset()->ShardFilename(run_, i, dataset()->num_shards_)));
+          }
+        }
+
+        TF_RETURN_IF_ERROR(
+            input_impl_->GetNext(ctx, out_tensors, end_of_sequence));
+        if (*end_of_sequence) {
+          return Finish();
+        }
+        ShardWriter* shard = shards_[num_elements_ % shards_.size()].get();
+        ++num_elements_;
+        return shard->Add(*out_tensors);
+      }
+
+     private:
+      Status Finish() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        iteration_completed_ = true;
+        Status s;
+        for (auto& shard : shards_) {
+          s.Update(shard->Finish());
+        }
+        TF_RETURN_IF_ERROR(s);
+        // The metadata is written to a temporary file and renamed, so that
+        // readers never see a partially written file.
+        const string metadata = dataset()->MetadataFilename();
+        const string tmp_metadata = strings::StrCat(metadata, ".", run_);
+        TF_RETURN_IF_ERROR(WriteStringToFile(
+            dataset()->env_, tmp_metadata,
+            strings::StrCat(run_, " ", dataset()->num_shards_, " ",
+                            dataset()->compression_type_)));
+        return dataset()->env_->RenameFile(tmp_metadata, metadata);
+      }
+
+      mutex mu_;
+      std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      const string run_;
+      std::vector<std::unique_ptr<ShardWriter>> shards_ GUARDED_BY(mu_);
+      size_t num_elements_ GUARDED_BY(mu_) = 0;
+      bool iteration_completed_ GUARDED_BY(mu_) = false;
+    };  // WriterIterator
+
+    // ReaderIterator produces the elements of a complete snapshot in their
+    // original order, taking them round-robin from the shard readers.
+    class ReaderIterator : public DatasetIterator<Dataset> {
+     public:
+      explicit ReaderIterator(const Params& params, const string& run,
+                              int64 num_shards, const string& compression_type)
+          : DatasetIterator<Dataset>(params) {
+        for (int64 i = 0; i < num_shards; ++i) {
+          shards_.emplace_back(new ShardReader(
+              params.dataset, params.dataset->ShardFilename(run, i, num_shards),
+              compression_type));
+        }
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        if (end_of_snapshot_) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        // Element `i` is in shard `i % num_shards`, so the first shard that
+        // runs out marks the end of the snapshot.
+        ShardReader* shard = shards_[index_ % shards_.size()].get();
+        bool end_of_shard;
+        TF_RETURN_IF_ERROR(shard->GetNext(out_tensors, &end_of_shard));
+        if (end_of_shard) {
+          end_of_snapshot_ = true;
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        ++index_;
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
+     private:
+      mutex mu_;
+      std::vector<std::unique_ptr<ShardReader>> shards_ GUARDED_BY(mu_);
+      size_t index_ GUARDED_BY(mu_) = 0;
+      bool end_of_snapshot_ GUARDED_BY(mu_) = false;
+    };  // ReaderIterator
+
+    const DatasetBase* const input_;
+    const string path_;
+    const string compression_type_;
+    const int64 num_shards_;
+    const string directory_;
+    Env* const env_;
+  };
+};
+
+REGISTER_KERNEL_BUILDER(Name("SnapshotDataset").Device(DEVICE_CPU),
+                        SnapshotDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
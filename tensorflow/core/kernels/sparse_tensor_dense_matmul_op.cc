@@ -19,6 +19,10 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sparse_tensor_dense_matmul_op.h"
 
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/kernels/bounds_check.h"
@@ -241,8 +245,11 @@ Status MOutOfBoundsError(int64 m, std::size_t i, int lhs_index_a,
 
 template <typename T, typename Tindices, bool ADJ_A, bool ADJ_B>
 struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
-  // Vectorize certain operations above this size.
-  static const std::size_t kNumVectorize = 32;
+  typedef Eigen::Map<Eigen::Array<T, 1, Eigen::Dynamic>> RowMap;
+  typedef Eigen::Map<const Eigen::Array<T, 1, Eigen::Dynamic>> ConstRowMap;
+  typedef Eigen::Map<const Eigen::Array<T, 1, Eigen::Dynamic>, Eigen::Unaligned,
+                     Eigen::InnerStride<>>
+      ConstStridedRowMap;
 
   static Status Compute(const CPUDevice& d, typename TTypes<T>::Matrix out,
                         typename TTypes<Tindices>::ConstMatrix a_indices,
@@ -254,62 +261,107 @@ struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
     const int lhs_index_a = ADJ_A ? 1 : 0;
     const int rhs_index_a = ADJ_A ? 0 : 1;
 
-    out.setZero();
-
-    // TODO(ebrevdo): After many failed experiments, can't find a multi-threaded
-    // approach that achieves the performance of the single threaded
-    // one.  Perhaps Eigen threadpool implementation is just too slow?
+    // Reads the indices once, checking them.
+    std::vector<Tindices> rows(nnz);
+    std::vector<Tindices> cols(nnz);
+    bool sorted = true;
+    for (std::size_t i = 0; i < nnz; ++i) {
+      const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
+      const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
+      if (!FastBoundsCheck(k, lhs_right)) {
+        return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);
+      }
+      if (!FastBoundsCheck(m, out.dimension(0))) {
+        return MOutOfBoundsError(m, i, lhs_index_a, out.dimension(0));
+      }
+      rows[i] = m;
+      cols[i] = k;
+      if (i > 0 && m < rows[i - 1]) sorted = false;
+    }
 
-    if (rhs_right < kNumVectorize) {
-      // Disable vectorization if the RHS of output is too small
-      auto maybe_adjoint_b = MaybeAdjoint<decltype(b), ADJ_B>(b);
+    // The rows of B, or of its adjoint, are read contiguously.  The adjoint
+    // is only computed if the nonzeros read all of it on average, and its
+    // rows are read as strided columns of B otherwise.
+    Eigen::Tensor<T, 2, Eigen::RowMajor> adjoint_b;
+    const T* b_data = b.data();
+    if (ADJ_B) {
+      if (nnz >= lhs_right) {
+        Eigen::array<int, 2> shuffle(1, 0);
+        adjoint_b = b.shuffle(shuffle).conjugate();
+        b_data = adjoint_b.data();
+      } else {
+        b_data = nullptr;
+      }
+    }
 
-      for (std::size_t i = 0; i < nnz; ++i) {
-        const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
-        const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
-        if (!FastBoundsCheck(k, lhs_right)) {
-          return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);
-        }
-        if (!FastBoundsCheck(m, out.dimension(0))) {
-          return MOutOfBoundsError(m, i, lhs_index_a, out.dimension(0));
-        }
+    // The order of the nonzeros, empty if it is the order of the input.
+    std::vector<std::size_t> order;
+    // Adds the scaled rows of B of the nonzeros [begin, end) in 'order' to
+    // the rows of the output.
+    auto accumulate = [&](std::size_t begin, std::size_t end) {
+      for (std::size_t j = begin; j < end; ++j) {
+        const std::size_t i = order.empty() ? j : order[j];
         const T a_value = ADJ_A ? MaybeConj(a_values(i)) : a_values(i);
-        for (std::size_t n = 0; n < rhs_right; ++n) {
-          const T b_value = maybe_adjoint_b(k, n);
-          out(m, n) += a_value * b_value;
+        RowMap out_row(out.data() + rows[i] * rhs_right, rhs_right);
+        if (b_data != nullptr) {
+          out_row +=
+              ConstRowMap(b_data + cols[i] * rhs_right, rhs_right) * a_value;
+        } else {
+          out_row += ConstStridedRowMap(b.data() + cols[i], rhs_right,
+                                        Eigen::InnerStride<>(lhs_right))
+                         .conjugate() *
+                     a_value;
         }
       }
-    } else {
-      // Vectorization via Eigen.
-      const int b_chip_index = ADJ_B ? 1 : 0;
-
-#define LOOP_NNZ(b_passed)                                                  \
-  for (std::size_t i = 0; i < nnz; ++i) {                                   \
-    const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a)); \
-    const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a)); \
-    const T a_value = (ADJ_A) ? MaybeConj(a_values(i)) : a_values(i);       \
-    if (!FastBoundsCheck(k, lhs_right)) {                                   \
-      return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);               \
-    }                                                                       \
-    if (!FastBoundsCheck(m, out.dimension(0))) {                            \
-      return MOutOfBoundsError(m, i, lhs_index_a, out.dimension(0));        \
-    }                                                                       \
-    out.template chip<0>(m) +=                                              \
-        b_passed.template chip<b_chip_index>(k) * a_value;                  \
-  }
+    };
 
-      if (ADJ_B) {
-        // Perform transpose and conjugation on B once, since we chip out B's
-        // columns in the nnz loop.
-        Eigen::array<int, 2> shuffle(1, 0);  // preserve dimension order
-        Eigen::Tensor<T, 2, Eigen::ColMajor> col_major_conj_b =
-            b.swap_layout().shuffle(shuffle).conjugate();
-        LOOP_NNZ(col_major_conj_b);
+    out.setZero();
+    if (d.numThreads() <= 1) {
+      accumulate(0, nnz);
+      return Status::OK();
+    }
+
+    // Orders the nonzeros by output row (CSR), so that each output row is
+    // owned by one shard.  The order is stable, so that each output is
+    // accumulated in the order of the nonzeros as in the serial case.  The
+    // indices of a canonically ordered SparseTensor are already sorted
+    // unless A is adjoint.
+    if (!sorted) {
+      order.resize(nnz);
+      const std::size_t out_rows = out.dimension(0);
+      if (out_rows <= nnz) {
+        // Counting sort.
+        std::vector<std::size_t> offsets(out_rows + 1, 0);
+        for (std::size_t i = 0; i < nnz; ++i) ++offsets[rows[i] + 1];
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        for (std::size_t i = 0; i < nnz; ++i) order[offsets[rows[i]]++] = i;
       } else {
-        LOOP_NNZ(b);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [&rows](std::size_t x, std::size_t y) {
+                           return rows[x] < rows[y];
+                         });
       }
-#undef LOOP_NNZ
     }
+    // The starts of the runs of nonzeros of the same output row.
+    std::vector<std::size_t> row_starts;
+    for (std::size_t j = 0; j < nnz; ++j) {
+      const std::size_t i = order.empty() ? j : order[j];
+      const std::size_t prev = order.empty() ? j - 1 : order[j - 1];
+      if (j == 0 || rows[i] != rows[prev]) row_starts.push_back(j);
+    }
+    const std::size_t num_rows = row_starts.size();
+    row_starts.push_back(nnz);
+
+    const double nnz_per_row = static_cast<double>(nnz) / num_rows;
+    const Eigen::TensorOpCost cost(
+        nnz_per_row * rhs_right * sizeof(T), rhs_right * sizeof(T),
+        nnz_per_row * rhs_right *
+            (Eigen::TensorOpCost::AddCost<T>() +
+             Eigen::TensorOpCost::MulCost<T>()));
+    d.parallelFor(num_rows, cost, [&](int64 start, int64 limit) {
+      accumulate(row_starts[start], row_starts[limit]);
+    });
     return Status::OK();
   }
 };
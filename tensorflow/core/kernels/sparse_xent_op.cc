@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/kernels/cpu_xent.h"
 
 namespace tensorflow {
 
@@ -97,8 +98,9 @@ class SparseSoftmaxXentWithLogitsOp : public OpKernel {
   }
 };
 
-// Partial specialization for a CPUDevice, that uses the Eigen implementation
-// from XentEigenImpl.
+// Partial specialization for a CPUDevice, that uses the fused kernels of
+// cpu_xent.h for the types that they support, and the Eigen implementation
+// from SparseXentEigenImpl otherwise.
 namespace functor {
 template <typename T, typename Index>
 struct SparseXentFunctor<CPUDevice, T, Index> {
@@ -106,8 +108,12 @@ struct SparseXentFunctor<CPUDevice, T, Index> {
                   typename TTypes<Index>::ConstVec labels,
                   typename TTypes<T>::Vec scratch, typename TTypes<T>::Vec loss,
                   typename TTypes<T>::Matrix backprop) {
-    SparseXentEigenImpl<CPUDevice, T, Index>::Compute(d, logits, labels,
-                                                      scratch, loss, backprop);
+    if (cpu_xent::IsSupportedType<T>::value) {
+      cpu_xent::SparseXent<T, Index>(d, logits, labels, loss, backprop);
+    } else {
+      SparseXentEigenImpl<CPUDevice, T, Index>::Compute(
+          d, logits, labels, scratch, loss, backprop);
+    }
   }
 };
 }  // namespace functor
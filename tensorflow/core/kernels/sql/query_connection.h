@@ -58,6 +58,20 @@ class QueryConnection {
   // undefined.
   virtual Status GetNext(std::vector<Tensor>* out_tensors,
                          bool* end_of_sequence) = 0;
+  // Retrieves up to `batch_size` of the next rows of the result set of the
+  // query from the most recent call to `Open()`.
+  //
+  // If at least one such row exists, then `*out_tensors` will hold one vector
+  // per column, whose elements are the values of that column in the rows,
+  // and `false` will be stored in `*end_of_sequence`. Only the last batch
+  // may have fewer than `batch_size` rows.
+  //
+  // If there are no more rows in the result set, then instead `true` will be
+  // stored in `*end_of_sequence`, and the content of `*out_tensors` will be
+  // undefined.
+  virtual Status GetNextBatch(int64 batch_size,
+                              std::vector<Tensor>* out_tensors,
+                              bool* end_of_sequence) = 0;
 };
 
 }  // namespace sql
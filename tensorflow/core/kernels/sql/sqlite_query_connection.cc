@@ -54,18 +54,66 @@ Status SqliteQueryConnection::GetNext(std::vector<Tensor>* out_tensors,
       return s;
     }
   }
+  if (done_) {
+    *end_of_sequence = true;
+    return Status::OK();
+  }
   Status s = stmt_.Step(end_of_sequence);
+  done_ = *end_of_sequence;
   if (!*end_of_sequence) {
     for (int i = 0; i < column_count_; i++) {
       DataType dt = output_types_[i];
       Tensor tensor(cpu_allocator(), dt, {});
-      FillTensorWithResultSetEntry(dt, i, &tensor);
+      FillTensorWithResultSetEntry(dt, i, 0, &tensor);
       out_tensors->emplace_back(std::move(tensor));
     }
   }
   return s;
 }
 
+Status SqliteQueryConnection::GetNextBatch(int64 batch_size,
+                                           std::vector<Tensor>* out_tensors,
+                                           bool* end_of_sequence) {
+  if (!stmt_) {
+    Status s = PrepareQuery();
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  // The rows are decoded straight into the batch tensors, rather than into
+  // per-row scalars that would have to be copied together.
+  std::vector<Tensor> batch;
+  batch.reserve(column_count_);
+  for (int i = 0; i < column_count_; i++) {
+    batch.emplace_back(cpu_allocator(), output_types_[i],
+                       TensorShape({batch_size}));
+  }
+  int64 num_rows = 0;
+  while (!done_ && num_rows < batch_size) {
+    Status s = stmt_.Step(&done_);
+    if (!s.ok()) {
+      return s;
+    }
+    if (!done_) {
+      for (int i = 0; i < column_count_; i++) {
+        FillTensorWithResultSetEntry(output_types_[i], i, num_rows, &batch[i]);
+      }
+      ++num_rows;
+    }
+  }
+  *end_of_sequence = num_rows == 0;
+  if (!*end_of_sequence) {
+    for (Tensor& tensor : batch) {
+      if (num_rows < batch_size) {
+        out_tensors->push_back(tensor.Slice(0, num_rows));
+      } else {
+        out_tensors->push_back(std::move(tensor));
+      }
+    }
+  }
+  return Status::OK();
+}
+
 Status SqliteQueryConnection::PrepareQuery() {
   stmt_ = db_->Prepare(query_);
   Status s = stmt_.status();
@@ -83,43 +131,51 @@ Status SqliteQueryConnection::PrepareQuery() {
 }
 
 void SqliteQueryConnection::FillTensorWithResultSetEntry(
-    const DataType& data_type, int column_index, Tensor* tensor) {
+    const DataType& data_type, int column_index, int64 index, Tensor* tensor) {
   switch (data_type) {
-    case DT_STRING:
-      tensor->scalar<string>()() = stmt_.ColumnString(column_index);
+    case DT_STRING: {
+      // NULL values, and empty BLOBs, are returned as empty strings.
+      const char* data = stmt_.ColumnStringUnsafe(column_index);
+      if (data == nullptr) {
+        tensor->flat<string>()(index).clear();
+      } else {
+        tensor->flat<string>()(index).assign(data,
+                                             stmt_.ColumnSize(column_index));
+      }
       break;
+    }
     case DT_INT8:
-      tensor->scalar<int8>()() =
+      tensor->flat<int8>()(index) =
           static_cast<int8>(stmt_.ColumnInt(column_index));
       break;
     case DT_INT16:
-      tensor->scalar<int16>()() =
+      tensor->flat<int16>()(index) =
           static_cast<int16>(stmt_.ColumnInt(column_index));
       break;
     case DT_INT32:
-      tensor->scalar<int32>()() =
+      tensor->flat<int32>()(index) =
           static_cast<int32>(stmt_.ColumnInt(column_index));
       break;
     case DT_INT64:
-      tensor->scalar<int64>()() = stmt_.ColumnInt(column_index);
+      tensor->flat<int64>()(index) = stmt_.ColumnInt(column_index);
       break;
     case DT_UINT8:
-      tensor->scalar<uint8>()() =
+      tensor->flat<uint8>()(index) =
           static_cast<uint8>(stmt_.ColumnInt(column_index));
       break;
     case DT_UINT16:
-      tensor->scalar<uint16>()() =
+      tensor->flat<uint16>()(index) =
           static_cast<uint16>(stmt_.ColumnInt(column_index));
       break;
     case DT_BOOL:
-      tensor->scalar<bool>()() = stmt_.ColumnInt(column_index) != 0;
+      tensor->flat<bool>()(index) = stmt_.ColumnInt(column_index) != 0;
       break;
     case DT_FLOAT:
-      tensor->scalar<float>()() =
+      tensor->flat<float>()(index) =
           static_cast<float>(stmt_.ColumnDouble(column_index));
       break;
     case DT_DOUBLE:
-      tensor->scalar<double>()() = stmt_.ColumnDouble(column_index);
+      tensor->flat<double>()(index) = stmt_.ColumnDouble(column_index);
       break;
       // Error preemptively thrown by SqlDatasetOp::MakeDataset in this case.
     default: {
@@ -34,16 +34,21 @@ class SqliteQueryConnection : public QueryConnection {
   Status Close() override;
   Status GetNext(std::vector<Tensor>* out_tensors,
                  bool* end_of_sequence) override;
+  Status GetNextBatch(int64 batch_size, std::vector<Tensor>* out_tensors,
+                      bool* end_of_sequence) override;
 
  private:
   // Prepares the query string `query_`.
   Status PrepareQuery();
-  // Fills `tensor` with the column_index_th element of the current row of
-  // `stmt_`.
+  // Fills the `index`th element of `tensor` with the column_index_th element
+  // of the current row of `stmt_`.
   void FillTensorWithResultSetEntry(const DataType& data_type, int column_index,
-                                    Tensor* tensor);
+                                    int64 index, Tensor* tensor);
   std::shared_ptr<Sqlite> db_ = nullptr;
   SqliteStatement stmt_;
+  // True once `stmt_` has returned every row. Stepping it again would
+  // execute the query from the start.
+  bool done_ = false;
   int column_count_ = 0;
   string query_;
   DataTypeVector output_types_;
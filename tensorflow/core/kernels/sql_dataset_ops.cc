@@ -34,6 +34,7 @@ class SqlDatasetOp : public DatasetOpKernel {
   explicit SqlDatasetOp(OpKernelConstruction* ctx) : DatasetOpKernel(ctx) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("batch_size", &batch_size_));
     for (const DataType& dt : output_types_) {
       OP_REQUIRES(ctx,
                   dt == DT_STRING || dt == DT_INT8 || dt == DT_INT16 ||
@@ -45,9 +46,16 @@ class SqlDatasetOp : public DatasetOpKernel {
                       "DT_UINT8, DT_UINT16, DT_BOOL, DT_DOUBLE "));
     }
     for (const PartialTensorShape& pts : output_shapes_) {
-      OP_REQUIRES(ctx, pts.dims() == 0,
-                  errors::InvalidArgument(
-                      "Each element of `output_shapes_` must be a scalar."));
+      if (batch_size_ > 0) {
+        OP_REQUIRES(ctx, pts.dims() == 1,
+                    errors::InvalidArgument(
+                        "Each element of `output_shapes_` must be a vector "
+                        "when `batch_size` is set."));
+      } else {
+        OP_REQUIRES(ctx, pts.dims() == 0,
+                    errors::InvalidArgument(
+                        "Each element of `output_shapes_` must be a scalar."));
+      }
     }
   }
   void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
@@ -70,19 +78,21 @@ class SqlDatasetOp : public DatasetOpKernel {
                     "The set of supported databases is: {'sqlite'}.",
                     driver_name.c_str())));
 
-    *output = new Dataset(driver_name, data_source_name, query, output_types_,
-                          output_shapes_);
+    *output = new Dataset(driver_name, data_source_name, query, batch_size_,
+                          output_types_, output_shapes_);
   }
 
  private:
   class Dataset : public DatasetBase {
    public:
     Dataset(const string& driver_name, const string& data_source_name,
-            const string& query, const DataTypeVector& output_types,
+            const string& query, int64 batch_size,
+            const DataTypeVector& output_types,
             const std::vector<PartialTensorShape>& output_shapes)
         : driver_name_(driver_name),
           data_source_name_(data_source_name),
           query_(query),
+          batch_size_(batch_size),
           output_types_(output_types),
           output_shapes_(output_shapes) {}
 
@@ -132,6 +142,10 @@ class SqlDatasetOp : public DatasetOpKernel {
             return s;
           }
         }
+        if (dataset()->batch_size_ > 0) {
+          return query_connection_->GetNextBatch(dataset()->batch_size_,
+                                                 out_tensors, end_of_sequence);
+        }
         return query_connection_->GetNext(out_tensors, end_of_sequence);
       }
 
@@ -143,9 +157,11 @@ class SqlDatasetOp : public DatasetOpKernel {
     const string driver_name_;
     const string data_source_name_;
     const string query_;
+    const int64 batch_size_;
     const DataTypeVector output_types_;
     const std::vector<PartialTensorShape> output_shapes_;
   };
+  int64 batch_size_;
   DataTypeVector output_types_;
   std::vector<PartialTensorShape> output_shapes_;
 };
@@ -19,6 +19,8 @@ limitations under the License.
 #include <numeric>
 #include <vector>
 
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -26,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 namespace {
@@ -40,6 +43,10 @@ class Buffer : public ResourceBase {
   std::size_t capacity_;
   std::size_t memory_limit_;
   std::size_t current_bytes_;
+  // Room set aside by Reserve() for tuples not yet inserted. The reserved
+  // bytes are included in current_bytes_.
+  std::size_t reserved_tuples_;
+  std::size_t reserved_bytes_;
   std::mutex mu_;
   std::condition_variable non_empty_cond_var_;
   std::condition_variable full_cond_var_;
@@ -64,13 +71,24 @@ class Buffer : public ResourceBase {
   // configued on this buffer?
   bool IsBounded() const { return capacity_ > 0 || memory_limit_ > 0; }
 
-  bool IsCapacityFull() const { return buf_.size() >= capacity_; }
+  bool IsCapacityFull() const {
+    return buf_.size() + reserved_tuples_ >= capacity_;
+  }
 
   bool WouldExceedMemoryLimit(std::size_t bytes) const {
     return bytes + current_bytes_ > memory_limit_;
   }
 
-  std::size_t GetTupleBytes(const Tuple & tuple)
+ public:
+  // public methods
+  explicit Buffer(std::size_t capacity, std::size_t memory_limit)
+      : capacity_(capacity),
+        memory_limit_(memory_limit),
+        current_bytes_(0),
+        reserved_tuples_(0),
+        reserved_bytes_(0) {}
+
+  static std::size_t GetTupleBytes(const Tuple & tuple)
   {
     return std::accumulate(tuple.begin(), tuple.end(), 0,
       [](const std::size_t & lhs, const Tensor & rhs) {
@@ -78,16 +96,18 @@ class Buffer : public ResourceBase {
     });
   }
 
- public:
-  // public methods
-  explicit Buffer(std::size_t capacity, std::size_t memory_limit)
-      : capacity_(capacity), memory_limit_(memory_limit), current_bytes_(0) {}
-
   // the Buffer takes ownership of the Tuple
   Status Put(Tuple* tuple) {
-    std::unique_lock<std::mutex> lock(mu_);
+    TF_RETURN_IF_ERROR(Reserve(GetTupleBytes(*tuple)));
+    PutReserved(tuple);
+    return Status::OK();
+  }
 
-    std::size_t tuple_bytes = GetTupleBytes(*tuple);
+  // Blocks until there is room for a tuple of 'tuple_bytes' bytes and sets
+  // it aside, so that the tuple can later be inserted by PutReserved()
+  // without blocking.
+  Status Reserve(std::size_t tuple_bytes) {
+    std::unique_lock<std::mutex> lock(mu_);
 
     // Sanity check so that we don't block for ever below
     if(memory_limit_ > 0 && tuple_bytes > memory_limit_) {
@@ -113,6 +133,20 @@ class Buffer : public ResourceBase {
 
     // Update bytes in the Staging Area
     current_bytes_ += tuple_bytes;
+    reserved_bytes_ += tuple_bytes;
+    ++reserved_tuples_;
+
+    return Status::OK();
+  }
+
+  // Inserts a tuple for which room was set aside by Reserve(). The Buffer
+  // takes ownership of the Tuple.
+  void PutReserved(Tuple* tuple) {
+    std::unique_lock<std::mutex> lock(mu_);
+
+    DCHECK_GT(reserved_tuples_, 0);
+    --reserved_tuples_;
+    reserved_bytes_ -= GetTupleBytes(*tuple);
 
     // Store tuple
     buf_.push_back(std::move(*tuple));
@@ -124,8 +158,19 @@ class Buffer : public ResourceBase {
     // As we don't know the appropriate one to wake up
     // we should wake them all.
     non_empty_cond_var_.notify_all();
+  }
 
-    return Status::OK();
+  // Gives back room set aside by Reserve() for a tuple that will not be
+  // inserted after all.
+  void CancelReservation(std::size_t tuple_bytes) {
+    std::unique_lock<std::mutex> lock(mu_);
+
+    DCHECK_GT(reserved_tuples_, 0);
+    --reserved_tuples_;
+    reserved_bytes_ -= tuple_bytes;
+    current_bytes_ -= tuple_bytes;
+
+    notify_inserters_if_bounded(&lock);
   }
 
   // Get tuple at front of the buffer
@@ -170,7 +215,7 @@ class Buffer : public ResourceBase {
   void Clear() {
     std::unique_lock<std::mutex> lock(mu_);
     buf_.clear();
-    current_bytes_ = 0;
+    current_bytes_ = reserved_bytes_;
 
     notify_inserters_if_bounded(&lock);
   }
@@ -230,6 +275,178 @@ REGISTER_KERNEL_BUILDER(Name("Stage").Device(DEVICE_GPU), StageOp);
 REGISTER_KERNEL_BUILDER(Name("Stage").Device(DEVICE_SYCL), StageOp);
 #endif // TENSORFLOW_USE_SYCL
 
+// Like StageOp, but for inputs in host memory that are to be staged in device
+// memory. The inputs are copied asynchronously into device buffers owned by
+// the op, and only inserted into the Staging Area once the copies are done.
+class DeviceStageOp : public AsyncOpKernel {
+ public:
+  explicit DeviceStageOp(OpKernelConstruction* ctx) : AsyncOpKernel(ctx) {
+    int64 capacity;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("capacity", &capacity));
+    // One set of buffers per staged element, plus one for the element most
+    // recently unstaged, which may still be in use. With unbounded capacity,
+    // this is double buffering.
+    max_device_buffers_ = capacity > 0 ? capacity + 1 : 2;
+  }
+
+  void ComputeAsync(OpKernelContext* ctx, DoneCallback done) override {
+    Buffer* buf = nullptr;
+    OP_REQUIRES_OK_ASYNC(ctx, GetBuffer(ctx, def(), &buf), done);
+    core::ScopedUnref scope(buf);
+    Buffer::Tuple tuple;
+    tuple.reserve(ctx->num_inputs());
+    for (int i = 0; i < ctx->num_inputs(); ++i) {
+      tuple.push_back(ctx->input(i));
+    }
+
+    DeviceContext* device_context = ctx->op_device_context();
+    if (device_context == nullptr) {
+      // The device has no separate memory space.
+      OP_REQUIRES_OK_ASYNC(ctx, buf->Put(&tuple), done);
+      done();
+      return;
+    }
+    for (const Tensor& tensor : tuple) {
+      OP_REQUIRES_ASYNC(
+          ctx, DataTypeCanUseMemcpy(tensor.dtype()),
+          errors::InvalidArgument("DeviceStage cannot copy tensors of type ",
+                                  DataTypeString(tensor.dtype()),
+                                  " to the device."),
+          done);
+    }
+
+    // Wait for room before starting the copies, so that their callback never
+    // blocks.
+    const std::size_t tuple_bytes = Buffer::GetTupleBytes(tuple);
+    OP_REQUIRES_OK_ASYNC(ctx, buf->Reserve(tuple_bytes), done);
+    Buffer::Tuple device_tuple;
+    Status s = AcquireDeviceBuffers(ctx, tuple, &device_tuple);
+    if (!s.ok()) {
+      buf->CancelReservation(tuple_bytes);
+      ctx->SetStatus(s);
+      done();
+      return;
+    }
+    if (tuple.empty()) {
+      buf->PutReserved(&device_tuple);
+      done();
+      return;
+    }
+
+    // Owns everything the copies refer to until the last one is done.
+    struct CopyState {
+      Buffer::Tuple host_tuple;
+      Buffer::Tuple device_tuple;
+      mutex mu;
+      int pending GUARDED_BY(mu);
+      Status status GUARDED_BY(mu);
+    };
+    CopyState* state = new CopyState;
+    state->host_tuple = std::move(tuple);
+    state->device_tuple = std::move(device_tuple);
+    state->pending = state->host_tuple.size();
+    buf->Ref();
+    Device* device = static_cast<Device*>(ctx->device());
+    // Copy the size first: the last callback may delete 'state'.
+    const std::size_t num_components = state->host_tuple.size();
+    for (std::size_t i = 0; i < num_components; ++i) {
+      device_context->CopyCPUTensorToDevice(
+          &state->host_tuple[i], device, &state->device_tuple[i],
+          [state, buf, tuple_bytes, ctx, done](const Status& s) {
+            {
+              mutex_lock l(state->mu);
+              state->status.Update(s);
+              if (--state->pending > 0) return;
+            }
+            // This is the last copy, and no other callback refers to
+            // 'state' any more.
+            if (state->status.ok()) {
+              buf->PutReserved(&state->device_tuple);
+            } else {
+              buf->CancelReservation(tuple_bytes);
+              ctx->SetStatus(state->status);
+            }
+            buf->Unref();
+            delete state;
+            done();
+          });
+    }
+  }
+
+ private:
+  // Returns device tensors of the same types and shapes as 'tuple'. Reuses
+  // a set of buffers that nothing else refers to any more if there is one of
+  // the right shapes, and otherwise allocates one, keeping up to
+  // max_device_buffers_ sets for reuse.
+  Status AcquireDeviceBuffers(OpKernelContext* ctx,
+                              const Buffer::Tuple& tuple,
+                              Buffer::Tuple* device_tuple) {
+    mutex_lock l(mu_);
+    Buffer::Tuple* reusable = nullptr;
+    for (Buffer::Tuple& buffers : device_buffers_) {
+      if (!IsUnused(buffers)) continue;
+      if (HasSameShapes(buffers, tuple)) {
+        *device_tuple = buffers;
+        return Status::OK();
+      }
+      reusable = &buffers;
+    }
+    if (reusable == nullptr &&
+        device_buffers_.size() < static_cast<size_t>(max_device_buffers_)) {
+      device_buffers_.emplace_back();
+      reusable = &device_buffers_.back();
+    }
+
+    Buffer::Tuple buffers;
+    buffers.reserve(tuple.size());
+    for (const Tensor& tensor : tuple) {
+      PersistentTensor persistent;
+      Tensor* allocated = nullptr;
+      TF_RETURN_IF_ERROR(ctx->allocate_persistent(
+          tensor.dtype(), tensor.shape(), &persistent, &allocated));
+      buffers.push_back(*allocated);
+    }
+    // If all the buffers are in use, for example because the consumers of
+    // several unstaged elements are still running, 'buffers' is only used
+    // once.
+    if (reusable != nullptr) *reusable = buffers;
+    *device_tuple = std::move(buffers);
+    return Status::OK();
+  }
+
+  // Returns true if only device_buffers_ refers to 'buffers'.
+  static bool IsUnused(const Buffer::Tuple& buffers) {
+    for (const Tensor& tensor : buffers) {
+      if (tensor.TotalBytes() > 0 && !tensor.RefCountIsOne()) return false;
+    }
+    return true;
+  }
+
+  static bool HasSameShapes(const Buffer::Tuple& a, const Buffer::Tuple& b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+      if (a[i].dtype() != b[i].dtype() || a[i].shape() != b[i].shape()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  int64 max_device_buffers_;
+  mutex mu_;
+  std::vector<Buffer::Tuple> device_buffers_ GUARDED_BY(mu_);
+};
+
+REGISTER_KERNEL_BUILDER(Name("DeviceStage").Device(DEVICE_CPU), StageOp);
+#if GOOGLE_CUDA
+REGISTER_KERNEL_BUILDER(Name("DeviceStage").HostMemory("values")
+                        .Device(DEVICE_GPU), DeviceStageOp);
+#endif
+#ifdef TENSORFLOW_USE_SYCL
+REGISTER_KERNEL_BUILDER(Name("DeviceStage").HostMemory("values")
+                        .Device(DEVICE_SYCL), DeviceStageOp);
+#endif // TENSORFLOW_USE_SYCL
+
 class UnstageOp : public OpKernel {
  public:
   explicit UnstageOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
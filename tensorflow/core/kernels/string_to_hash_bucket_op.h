@@ -23,9 +23,36 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
+// Sets "output_flat(i)" to the bucket of "hash(input_flat(i))" among
+// "num_buckets" for each string of "input_flat", sharding the strings over
+// the intra-op threads of the device of "context".
+template <typename Hash>
+void HashStringsToBuckets(OpKernelContext* context,
+                          TTypes<string>::ConstFlat input_flat,
+                          int64 num_buckets, const Hash& hash,
+                          TTypes<int64>::Flat output_flat) {
+  auto work = [&input_flat, num_buckets, &hash, &output_flat](int64 start,
+                                                              int64 limit) {
+    for (int64 i = start; i < limit; ++i) {
+      const uint64 input_hash = hash(input_flat(i));
+      const uint64 bucket_id = input_hash % num_buckets;
+      // The number of buckets is always in the positive range of int64 so is
+      // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
+      // safe.
+      output_flat(i) = static_cast<int64>(bucket_id);
+    }
+  };
+  // Hashing a short string, and the division, take a few hundred cycles.
+  const int64 kCostPerString = 200;
+  auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers,
+        input_flat.size(), kCostPerString, work);
+}
+
 template <uint64 hash(const string&)>
 class StringToHashBucketOp : public OpKernel {
  public:
@@ -44,15 +71,7 @@ class StringToHashBucketOp : public OpKernel {
                                             &output_tensor));
     auto output_flat = output_tensor->flat<int64>();
 
-    typedef decltype(input_flat.size()) Index;
-    for (Index i = 0; i < input_flat.size(); ++i) {
-      const uint64 input_hash = hash(input_flat(i));
-      const uint64 bucket_id = input_hash % num_buckets_;
-      // The number of buckets is always in the positive range of int64 so is
-      // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
-      // safe.
-      output_flat(i) = static_cast<int64>(bucket_id);
-    }
+    HashStringsToBuckets(context, input_flat, num_buckets_, hash, output_flat);
   }
 
  private:
@@ -86,15 +105,9 @@ class StringToKeyedHashBucketOp : public OpKernel {
                                             &output_tensor));
     auto output_flat = output_tensor->flat<int64>();
 
-    typedef decltype(input_flat.size()) Index;
-    for (Index i = 0; i < input_flat.size(); ++i) {
-      const uint64 input_hash = hash(key_, input_flat(i));
-      const uint64 bucket_id = input_hash % num_buckets_;
-      // The number of buckets is always in the positive range of int64 so is
-      // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
-      // safe.
-      output_flat(i) = static_cast<int64>(bucket_id);
-    }
+    HashStringsToBuckets(
+        context, input_flat, num_buckets_,
+        [this](const string& s) { return hash(key_, s); }, output_flat);
   }
 
  private:
@@ -227,12 +227,16 @@ class SummaryWriterImpl : public SummaryWriterInterface {
       TF_RETURN_IF_ERROR(env_->CreateDir(logdir));
     }
     mutex_lock ml(mu_);
+    // The events are written and flushed by the background thread of the
+    // EventsWriter, so that the summary ops do not wait for the file.
+    EventsWriter::AsyncOptions options;
+    options.max_queue_size = max_queue_;
+    options.flush_millis = flush_millis_;
     events_writer_ =
-        xla::MakeUnique<EventsWriter>(io::JoinPath(logdir, "events"));
+        xla::MakeUnique<EventsWriter>(io::JoinPath(logdir, "events"), options);
     if (!events_writer_->InitWithSuffix(filename_suffix)) {
       return errors::Unknown("Could not initialize events writer.");
     }
-    last_flush_ = env_->NowMicros();
     is_initialized_ = true;
     return Status::OK();
   }
@@ -242,7 +246,10 @@ class SummaryWriterImpl : public SummaryWriterInterface {
     if (!is_initialized_) {
       return errors::FailedPrecondition("Class was not properly initialized.");
     }
-    return InternalFlush();
+    if (!events_writer_->Flush()) {
+      return errors::InvalidArgument("Could not flush events file.");
+    }
+    return Status::OK();
   }
 
   ~SummaryWriterImpl() override {
@@ -393,11 +400,7 @@ class SummaryWriterImpl : public SummaryWriterInterface {
 
   Status WriteEvent(std::unique_ptr<Event> event) override {
     mutex_lock ml(mu_);
-    queue_.emplace_back(std::move(event));
-    if (queue_.size() >= max_queue_ ||
-        env_->NowMicros() - last_flush_ > 1000 * flush_millis_) {
-      return InternalFlush();
-    }
+    events_writer_->WriteEvent(*event);
     return Status::OK();
   }
 
@@ -408,25 +411,11 @@ class SummaryWriterImpl : public SummaryWriterInterface {
     return static_cast<double>(env_->NowMicros()) / 1.0e6;
   }
 
-  Status InternalFlush() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    for (const std::unique_ptr<Event>& e : queue_) {
-      events_writer_->WriteEvent(*e);
-    }
-    queue_.clear();
-    if (!events_writer_->Flush()) {
-      return errors::InvalidArgument("Could not flush events file.");
-    }
-    last_flush_ = env_->NowMicros();
-    return Status::OK();
-  }
-
   bool is_initialized_;
   const int max_queue_;
   const int flush_millis_;
-  uint64 last_flush_;
   Env* env_;
   mutex mu_;
-  std::vector<std::unique_ptr<Event>> queue_ GUARDED_BY(mu_);
   // A pointer to allow deferred construction.
   std::unique_ptr<EventsWriter> events_writer_ GUARDED_BY(mu_);
   std::vector<std::pair<string, SummaryMetadata>> registered_summaries_
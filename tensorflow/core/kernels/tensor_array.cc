@@ -108,4 +108,72 @@ Status TensorArray::CopyShapesFrom(TensorArray* rhs) {
   return Status::OK();
 }
 
+Status TensorArray::LockedCopyToContiguousStorage(OpKernelContext* ctx,
+                                                  const int32 index) {
+  if (!use_contiguous_storage_ || dynamic_size_ || multiple_writes_aggregate_ ||
+      !DataTypeCanUseMemcpy(dtype_)) {
+    return Status::OK();
+  }
+  TensorAndState& t = tensors_[index];
+  const Tensor* value_t = t.tensor.AccessTensor(ctx);
+  if (!contiguous_storage_.IsInitialized() ||
+      contiguous_storage_.NumElements() == 0) {
+    // Lay the storage out for the shape of the first element written, the
+    // only one a pack or gather of all elements can succeed with.
+    const size_t element_bytes = value_t->TotalBytes();
+    if (element_bytes == 0 || element_bytes % EIGEN_MAX_ALIGN_BYTES != 0) {
+      use_contiguous_storage_ = false;
+      return Status::OK();
+    }
+    TensorShape storage_shape = value_t->shape();
+    storage_shape.InsertDim(0, tensors_.size());
+    Tensor* unused;
+    TF_RETURN_IF_ERROR(ctx->allocate_persistent(
+        dtype_, storage_shape, &contiguous_storage_, &unused));
+  }
+  Tensor* storage_t = contiguous_storage_.AccessTensor(ctx);
+  TensorShape element_shape = storage_t->shape();
+  element_shape.RemoveDim(0);
+  if (value_t->shape() != element_shape) return Status::OK();
+
+  Tensor element;
+  CHECK(element.CopyFrom(storage_t->Slice(index, index + 1), element_shape));
+  memcpy(const_cast<char*>(element.tensor_data().data()),
+         value_t->tensor_data().data(), value_t->TotalBytes());
+  t.tensor = PersistentTensor(element);
+  t.in_contiguous_storage = true;
+  return Status::OK();
+}
+
+bool TensorArray::TryReadContiguous(const std::vector<int32>& indices,
+                                    PersistentTensor* value) {
+  mutex_lock l(mu_);
+  if (closed_ || !contiguous_storage_.IsInitialized() ||
+      contiguous_storage_.NumElements() == 0 ||
+      indices.size() != tensors_.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < indices.size(); ++i) {
+    const TensorAndState& t = tensors_[i];
+    if (indices[i] != static_cast<int32>(i) || !t.in_contiguous_storage ||
+        t.cleared) {
+      return false;
+    }
+  }
+  for (TensorAndState& t : tensors_) {
+    if (clear_after_read_) {
+      t.tensor = PersistentTensor();
+      t.cleared = true;
+    }
+    t.read = true;
+  }
+  *value = contiguous_storage_;
+  if (clear_after_read_) {
+    // No element can be read or written again, so the caller holds the only
+    // reference the storage needs.
+    contiguous_storage_ = PersistentTensor();
+  }
+  return true;
+}
+
 }  // namespace tensorflow
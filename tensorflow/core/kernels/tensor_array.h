@@ -151,6 +151,7 @@ class TensorArray : public ResourceBase {
         is_grad_(is_grad),
         marked_size_(marked_size),
         element_shape_(element_shape),
+        use_contiguous_storage_(false),
         tensors_(N) {}
 
   // Write PersistentTensor 'value' to index 'index'.
@@ -179,6 +180,9 @@ class TensorArray : public ResourceBase {
   //    - Index 'index' is also marked as local_copy.
   //    - The gradients_disallowed flag is set true (GradientsAllowed()
   //      will now return false).
+  //  * If contiguous storage is enabled, the value is instead copied into
+  //    its slice of the storage and the reference to 'value' is released
+  //    (see EnableContiguousStorage()).
   //
   // Note, value is passed as a pointer because we its underlying
   // Tensor's shape is accessed.  Otherwise it is not modified.
@@ -186,7 +190,8 @@ class TensorArray : public ResourceBase {
   Status WriteOrAggregate(OpKernelContext* ctx, const int32 index,
                           PersistentTensor* value) {
     mutex_lock l(mu_);
-    return LockedWriteOrAggregate<Device, T>(ctx, index, value);
+    TF_RETURN_IF_ERROR((LockedWriteOrAggregate<Device, T>(ctx, index, value)));
+    return LockedCopyToContiguousStorage(ctx, index);
   }
 
   template <typename Device, typename T>
@@ -240,6 +245,27 @@ class TensorArray : public ResourceBase {
     return Status::OK();
   }
 
+  // If 'indices' is [0, N) and every element of the TensorArray lives in
+  // its contiguous storage, marks all elements as read (as ReadMany would)
+  // and sets '*value' to the storage, whose shape is [N] + element shape.
+  // Otherwise returns false and leaves the TensorArray unchanged, and the
+  // elements have to be read (and copied) one by one.
+  bool TryReadContiguous(const std::vector<int32>& indices,
+                         PersistentTensor* value);
+
+  // Opts this TensorArray in to keeping the elements written with
+  // WriteOrAggregate in one preallocated [N] + element shape Tensor,
+  // allocated on the first such write, so that packing or gathering all of
+  // them in order (see TryReadContiguous) costs no copy and no allocation.
+  // Storage is only used for fixed size, non-aggregating TensorArrays of
+  // memcpy-able types on the CPU, whose element size in bytes is a multiple
+  // of EIGEN_MAX_ALIGN_BYTES so that every element stays aligned.  Elements
+  // whose shape differs from that of the first one are stored as usual.
+  void EnableContiguousStorage() {
+    mutex_lock l(mu_);
+    use_contiguous_storage_ = true;
+  }
+
   DataType ElemType() const { return dtype_; }
 
   PartialTensorShape ElemShape() {
@@ -333,6 +359,7 @@ class TensorArray : public ResourceBase {
   void ClearAndMarkClosed() {
     mutex_lock l(mu_);
     tensors_.clear();
+    contiguous_storage_ = PersistentTensor();
     closed_ = true;
   }
 
@@ -356,6 +383,11 @@ class TensorArray : public ResourceBase {
   Status LockedRead(OpKernelContext* ctx, const int32 index,
                     PersistentTensor* value) EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Moves the value just written to 'index' into contiguous_storage_, if
+  // contiguous storage is in use.
+  Status LockedCopyToContiguousStorage(OpKernelContext* ctx, const int32 index)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   Status LockedReturnIfClosed() const EXCLUSIVE_LOCKS_REQUIRED(mu_) {
     if (closed_) {
       return errors::InvalidArgument("TensorArray ", handle_.vec<string>()(1),
@@ -400,12 +432,23 @@ class TensorArray : public ResourceBase {
   // known at all.
   PartialTensorShape element_shape_ GUARDED_BY(mu_);
 
+  // True if written elements are copied into contiguous_storage_.
+  bool use_contiguous_storage_ GUARDED_BY(mu_);
+
+  // The [N] + element shape Tensor whose slices hold the elements written
+  // while use_contiguous_storage_ is true.  Allocated on the first such write.
+  PersistentTensor contiguous_storage_ GUARDED_BY(mu_);
+
   // TensorAndState is used to keep track of the PersistentTensors
   // stored in the TensorArray, along with their shapes, and a boolean
   // that determines whether they have already been read or not.
   struct TensorAndState {
     TensorAndState()
-        : written(false), read(false), cleared(false), local_copy(false) {}
+        : written(false),
+          read(false),
+          cleared(false),
+          local_copy(false),
+          in_contiguous_storage(false) {}
     PersistentTensor tensor;
     TensorShape shape;
     bool written;  // True if a Tensor has been written to the index.
@@ -420,6 +463,9 @@ class TensorArray : public ResourceBase {
     // aggregated value.  This flag marks that such a Tensor is being
     // used.  All future writes will aggregate to the existing local Tensor.
     bool local_copy;
+
+    // True if 'tensor' is a slice of contiguous_storage_.
+    bool in_contiguous_storage;
   };
   // The list of underlying PersistentTensors and states.
   std::vector<TensorAndState> tensors_ GUARDED_BY(mu_);
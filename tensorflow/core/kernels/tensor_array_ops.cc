@@ -158,7 +158,8 @@ class TensorArrayCreationOp : public OpKernel {
 class TensorArrayOp : public TensorArrayCreationOp {
  public:
   explicit TensorArrayOp(OpKernelConstruction* context)
-      : TensorArrayCreationOp(context) {
+      : TensorArrayCreationOp(context),
+        use_contiguous_storage_(context->device_type() == DEVICE_CPU) {
     OP_REQUIRES_OK(context, context->GetAttr("dtype", &dtype_));
     OP_REQUIRES_OK(context, context->GetAttr("element_shape", &element_shape_));
     OP_REQUIRES_OK(context, context->GetAttr("dynamic_size", &dynamic_size_));
@@ -198,6 +199,7 @@ class TensorArrayOp : public TensorArrayCreationOp {
         key, dtype_, *tensor_array_output_handle, size, element_shape_,
         dynamic_size_, false /* multiple_writes_aggregate */,
         false /* is_grad */, -1 /* marked_size */, clear_after_read_);
+    if (use_contiguous_storage_) tensor_array->EnableContiguousStorage();
 
     TF_RETURN_IF_ERROR(
         rm->Create(ctx->step_container()->name(), key, tensor_array));
@@ -213,6 +215,9 @@ class TensorArrayOp : public TensorArrayCreationOp {
   bool dynamic_size_;
   bool clear_after_read_;
   string tensor_array_name_;  // The name used to create the TensorArray.
+  // Written elements are copied into one contiguous Tensor, so that packing
+  // them at the end of a loop is free.  Only done for arrays on the CPU.
+  const bool use_contiguous_storage_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(TensorArrayOp);
 };
@@ -612,6 +617,23 @@ class TensorArrayPackOrGatherOp : public OpKernel {
       return;
     }
 
+    // If all elements already live, in order, in the TensorArray's
+    // contiguous storage, that storage is the output.
+    PersistentTensor contiguous;
+    if (tensor_array->TryReadContiguous(indices, &contiguous)) {
+      const Tensor* contiguous_t = contiguous.AccessTensor(ctx);
+      TensorShape value_shape(contiguous_t->shape());
+      value_shape.RemoveDim(0);
+      OP_REQUIRES(ctx, element_shape_.IsCompatibleWith(value_shape),
+                  errors::InvalidArgument(
+                      "TensorArray was passed element_shape ",
+                      element_shape_.DebugString(),
+                      " which does not match the Tensor at index 0: ",
+                      value_shape.DebugString()));
+      ctx->set_output(0, *contiguous_t);
+      return;
+    }
+
     // Read all the PersistentTensors into a vector to keep track of
     // their memory.
     Status s = tensor_array->ReadMany<Device, T>(ctx, indices, &values);
@@ -823,6 +845,40 @@ class TensorArrayConcatOp : public OpKernel {
     std::vector<PersistentTensor> values;
     std::vector<int32> indices(array_size);
     std::iota(indices.begin(), indices.end(), 0);
+
+    // If all elements live in the TensorArray's contiguous storage, the
+    // output is that storage with its first two dimensions merged.
+    PersistentTensor contiguous;
+    if (tensor_array->TryReadContiguous(indices, &contiguous)) {
+      const Tensor* contiguous_t = contiguous.AccessTensor(ctx);
+      OP_REQUIRES(
+          ctx, contiguous_t->dims() > 1,
+          errors::InvalidArgument(
+              "Concat saw a scalar shape at index 0"
+              " but requires at least vectors.  Did you mean to call pack?"));
+      TensorShape output_shape(contiguous_t->shape());
+      const int64 length = output_shape.dim_size(1);
+      output_shape.RemoveDim(0);
+      TensorShape output_shape_except0(output_shape);
+      output_shape_except0.RemoveDim(0);
+      OP_REQUIRES(
+          ctx, element_shape_except0_.IsCompatibleWith(output_shape_except0),
+          errors::InvalidArgument(
+              "TensorArray was passed element_shape_except0 ",
+              element_shape_except0_.DebugString(),
+              " but index 0 has (excepting dimension 0) shape: ",
+              output_shape_except0.DebugString(), " which does not match."));
+      output_shape.set_dim(0, length * array_size);
+      Tensor output;
+      CHECK(output.CopyFrom(*contiguous_t, output_shape));
+      ctx->set_output(0, output);
+      Tensor* lengths_tensor = nullptr;
+      OP_REQUIRES_OK(ctx, ctx->allocate_output(1, TensorShape({array_size}),
+                                               &lengths_tensor));
+      lengths_tensor->vec<int64>().setConstant(length);
+      return;
+    }
+
     Status s = tensor_array->ReadMany<Device, T>(ctx, indices, &values);
     OP_REQUIRES_OK(ctx, s);
 
@@ -21,14 +21,15 @@ limitations under the License.
 
 #include <algorithm>
 #include <numeric>
+#include <type_traits>
 #include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
-#include "tensorflow/core/lib/gtl/top_n.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
@@ -97,6 +98,68 @@ class TopK : public OpKernel {
 
 namespace functor {
 
+namespace {
+
+// The number of elements whose maximum SelectTopK compares to the smallest
+// of the k largest elements so far, to skip them all at once.
+const int kTopKBlockSize = 64;
+
+// The columns a shard of a row must at least have for the rows to be split
+// across threads.
+const int64 kMinColsPerShard = 1 << 15;
+
+// Returns the maximum of data[0, kTopKBlockSize), with the packet
+// instructions of T when there are some.
+template <typename T>
+EIGEN_ALWAYS_INLINE T BlockMax(const T* data) {
+  typedef Eigen::internal::packet_traits<T> Traits;
+  typedef typename std::conditional<Traits::Vectorizable && Traits::HasMax,
+                                    typename Traits::type, T>::type Packet;
+  const int kPacketSize = Eigen::internal::unpacket_traits<Packet>::size;
+  static_assert(kTopKBlockSize % kPacketSize == 0,
+                "kTopKBlockSize must be a multiple of the packet size");
+  Packet max = Eigen::internal::ploadu<Packet>(data);
+  for (int i = kPacketSize; i < kTopKBlockSize; i += kPacketSize) {
+    max = Eigen::internal::pmax(max, Eigen::internal::ploadu<Packet>(data + i));
+  }
+  return Eigen::internal::predux_max(max);
+}
+
+// Selects the indices of the min(k, end - begin) largest of data[begin, end),
+// with ties going to the smaller indices. "*heap" is a heap by "comp", which
+// orders the larger values first, so its front is the smallest of them.
+//
+// Once k values are selected, a value only enters if it is larger than the
+// front, so the blocks of values whose maximum is not are skipped without
+// looking at them one by one.
+template <typename T, typename Comp>
+void SelectTopK(const T* data, int32 begin, int32 end, int k, Comp comp,
+                std::vector<int32>* heap) {
+  const int32 num_first = std::min<int32>(k, end - begin);
+  heap->resize(num_first);
+  std::iota(heap->begin(), heap->end(), begin);
+  std::make_heap(heap->begin(), heap->end(), comp);
+  int32 c = begin + num_first;
+  while (c < end) {
+    const int32 block_end = std::min<int32>(c + kTopKBlockSize, end);
+    if (block_end - c == kTopKBlockSize &&
+        !(data[heap->front()] < BlockMax(data + c))) {
+      c = block_end;
+      continue;
+    }
+    for (; c < block_end; ++c) {
+      // A value equal to the front does not enter, as its index is larger.
+      if (data[heap->front()] < data[c]) {
+        std::pop_heap(heap->begin(), heap->end(), comp);
+        heap->back() = c;
+        std::push_heap(heap->begin(), heap->end(), comp);
+      }
+    }
+  }
+}
+
+}  // namespace
+
 template <typename T>
 struct TopKFunctor<CPUDevice, T> {
   static EIGEN_ALWAYS_INLINE Status
@@ -148,7 +211,7 @@ struct TopKFunctor<CPUDevice, T> {
           return input_data[b] < input_data[a];
         };
         // TODO(ebrevdo): For large k < num_cols, instead of using
-        // TopN, it may be faster to create a temporary vector of
+        // SelectTopK, it may be faster to create a temporary vector of
         // values 0..num_cols - 1 and then use std::partial_sort_copy
         // of this into indices. Choosing the appropriate minimum k or
         // ratio of k/num_cols will require some experimentation.
@@ -175,26 +238,12 @@ struct TopKFunctor<CPUDevice, T> {
             run_begin = run_end;
           }
         } else {
-          // Use the TopN heap object to sort.
-          gtl::TopN<int32, decltype(stable_comp)> filter(k, stable_comp);
-          filter.reserve(num_cols);
-          for (int32 c = 0; c < num_cols; ++c) {
-            filter.push(c);
-          }
-
-          int32 i = 0;
+          std::vector<int32> top_k;
+          SelectTopK(input_data, 0, num_cols, k, stable_comp, &top_k);
           if (sorted) {
-            std::unique_ptr<std::vector<int32>> top_k(filter.Extract());
-            for (auto top_k_it = top_k->begin(); top_k_it != top_k->end();
-                 ++top_k_it, ++i) {
-              indices(b, i) = *top_k_it;
-            }
-          } else {
-            for (auto top_k_it = filter.unsorted_begin();
-                 top_k_it != filter.unsorted_end(); ++top_k_it, ++i) {
-              indices(b, i) = *top_k_it;
-            }
+            std::sort_heap(top_k.begin(), top_k.end(), stable_comp);
           }
+          std::copy(top_k.begin(), top_k.end(), &indices(b, 0));
         }
         // Now that the indices are sorted, copy the values over in
         // sorted order.
@@ -218,11 +267,85 @@ struct TopKFunctor<CPUDevice, T> {
                                  ? kint64max
                                  : static_cast<int64>(total_cost);
     auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+
+    // Splits the rows across the threads when there are fewer rows than
+    // threads, e.g. for a single row over a large vocabulary.
+    const int64 shards_per_row =
+        std::min<int64>(worker_threads.num_threads / num_rows,
+                        num_cols / std::max<int64>(kMinColsPerShard, 4 * k));
+    if (k < num_cols && shards_per_row > 1) {
+      return ComputeSplitRows(context, k, input, num_rows, num_cols,
+                              shards_per_row, values, indices);
+    }
+
     Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
           final_cost, SortIndices);
 
     return Status::OK();
   }
+
+  // Selects the top k of each of "shards_per_row" shards of the columns of
+  // each row in parallel, and then merges the candidates of the shards of
+  // each row. The output is sorted, whether or not "sorted" is set.
+  static Status ComputeSplitRows(
+      OpKernelContext* context, int k,
+      const typename TTypes<T, 2>::ConstTensor& input, const int64 num_rows,
+      const int64 num_cols, const int64 shards_per_row,
+      typename TTypes<T, 2>::Tensor values,
+      typename TTypes<int, 2>::Tensor indices) {
+    const auto stable_comp = [](const T* input_data) {
+      return [input_data](const int32 a, const int32 b) {
+        if (input_data[b] < input_data[a]) {
+          return true;
+        } else if (input_data[b] > input_data[a]) {
+          return false;
+        } else {
+          return a < b;
+        }
+      };
+    };
+    const int64 cols_per_shard =
+        (num_cols + shards_per_row - 1) / shards_per_row;
+    std::vector<std::vector<int32>> candidates(num_rows * shards_per_row);
+    auto SelectShards = [&](int64 start, int64 limit) {
+      for (int64 i = start; i < limit; ++i) {
+        const int64 b = i / shards_per_row;
+        const int64 begin = (i % shards_per_row) * cols_per_shard;
+        const int64 end = std::min(num_cols, begin + cols_per_shard);
+        const T* input_data = &input(b, 0);
+        SelectTopK(input_data, begin, end, k, stable_comp(input_data),
+                   &candidates[i]);
+      }
+    };
+    auto MergeShards = [&](int64 start, int64 limit) {
+      std::vector<int32> row_candidates;
+      for (int64 b = start; b < limit; ++b) {
+        row_candidates.clear();
+        for (int64 i = b * shards_per_row; i < (b + 1) * shards_per_row; ++i) {
+          row_candidates.insert(row_candidates.end(), candidates[i].begin(),
+                                candidates[i].end());
+        }
+        const T* input_data = &input(b, 0);
+        std::partial_sort(row_candidates.begin(), row_candidates.begin() + k,
+                          row_candidates.end(), stable_comp(input_data));
+        for (int i = 0; i < k; ++i) {
+          indices(b, i) = row_candidates[i];
+          values(b, i) = input_data[row_candidates[i]];
+        }
+      }
+    };
+
+    const double cmp_cost = Eigen::TensorOpCost::AddCost<T>();
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          num_rows * shards_per_row,
+          static_cast<int64>(cmp_cost * cols_per_shard), SelectShards);
+    Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
+          static_cast<int64>(cmp_cost * shards_per_row * k *
+                             Eigen::numext::log2(static_cast<float>(k + 1))),
+          MergeShards);
+    return Status::OK();
+  }
 };
 
 }  // namespace functor
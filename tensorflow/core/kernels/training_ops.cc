@@ -17,11 +17,15 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/training_ops.h"
 #include <algorithm>
+#include <functional>
+#include <numeric>
+#include <vector>
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/training_op_helpers.h"
 #include "tensorflow/core/kernels/variable_ops.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #ifdef TENSORFLOW_USE_SYCL
 #include "tensorflow/core/common_runtime/sycl/sycl_util.h"
@@ -40,6 +44,74 @@ inline T sgn(const T x) {
   T one(1);
   return (x == zero ? zero : (x < zero ? -one : one));
 }
+
+// The number of elements that the updates of a SparseApply* op must touch
+// before they are applied in parallel.
+const int64 kParallelSparseApplyMinElements = 1 << 17;
+
+// Calls "fn(i, index)" for each update "i" of a SparseApply* op, where
+// "index" is the row of the variable (of "first_dim_size" rows) it applies
+// to and "update_size" is the number of elements of a row.
+//
+// Large updates are sharded over disjoint ranges of rows, and the updates of
+// each range are applied in their order in "indices", so repeated indices
+// give the same result as applying the updates serially. The lock of the
+// variable, if any, is held by the caller for the whole op; the ranges do not
+// need one of their own since no two of them touch the same row.
+//
+// Returns an error, before applying any update, if an index is out of range.
+template <typename Tindex, typename Fn>
+Status ForEachSparseUpdate(OpKernelContext* ctx,
+                           typename TTypes<Tindex>::ConstVec indices,
+                           Tindex first_dim_size, int64 update_size,
+                           const Fn& fn) {
+  const Tindex N = indices.dimension(0);
+  std::vector<Tindex> rows(N);
+  for (Tindex i = 0; i < N; i++) {
+    rows[i] = internal::SubtleMustCopy(indices(i));
+    if (!FastBoundsCheck(rows[i], first_dim_size)) {
+      return errors::InvalidArgument(
+          strings::StrCat("Index ", rows[i], " at offset ", i,
+                          " in indices is out of range"));
+    }
+  }
+
+  auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+  const int64 num_elements = static_cast<int64>(N) * update_size;
+  if (worker_threads->num_threads <= 1 || first_dim_size <= 1 ||
+      num_elements < kParallelSparseApplyMinElements) {
+    for (Tindex i = 0; i < N; i++) {
+      fn(i, rows[i]);
+    }
+    return Status::OK();
+  }
+
+  // Sorts the updates by their range of rows, keeping their order within each
+  // range.
+  const int64 num_ranges =
+      std::min<int64>(4 * worker_threads->num_threads, first_dim_size);
+  const int64 rows_per_range = (first_dim_size + num_ranges - 1) / num_ranges;
+  std::vector<int64> starts(num_ranges + 1, 0);
+  for (Tindex i = 0; i < N; i++) {
+    ++starts[rows[i] / rows_per_range + 1];
+  }
+  std::partial_sum(starts.begin(), starts.end(), starts.begin());
+  std::vector<int64> next(starts.begin(), starts.end() - 1);
+  std::vector<Tindex> order(N);
+  for (Tindex i = 0; i < N; i++) {
+    order[next[rows[i] / rows_per_range]++] = i;
+  }
+
+  auto work = [&starts, &order, &rows, &fn](int64 start, int64 limit) {
+    for (int64 j = starts[start]; j < starts[limit]; ++j) {
+      fn(order[j], rows[order[j]]);
+    }
+  };
+  // Each element costs a few reads, writes and arithmetic operations.
+  Shard(worker_threads->num_threads, worker_threads->workers, num_ranges,
+        10 * num_elements / num_ranges, work);
+  return Status::OK();
+}
 }  // namespace
 
 namespace functor {
@@ -263,9 +335,9 @@ struct ApplyFtrl<CPUDevice, T> {
   }
 };
 
-template <typename T>
-struct ApplyMomentum<CPUDevice, T> {
-  void operator()(const CPUDevice& d, typename TTypes<T>::Flat var,
+template <typename Device, typename T>
+struct ApplyMomentumNonCuda {
+  void operator()(const Device& d, typename TTypes<T>::Flat var,
                   typename TTypes<T>::Flat accum,
                   typename TTypes<T>::ConstScalar lr,
                   typename TTypes<T>::ConstFlat grad,
@@ -279,6 +351,9 @@ struct ApplyMomentum<CPUDevice, T> {
   }
 };
 
+template <typename T>
+struct ApplyMomentum<CPUDevice, T> : ApplyMomentumNonCuda<CPUDevice, T> {};
+
 template <typename Device, typename T>
 struct ApplyAdamNonCuda {
   void operator()(const Device& d, typename TTypes<T>::Flat var,
@@ -723,16 +798,7 @@ class SparseApplyAdadeltaOp : public OpKernel {
 
     if (N > 0) {
       const Tindex first_dim_size = var.dim_size(0);
-      // Validate all the indices are in range
       auto indices_vec = indices.vec<Tindex>();
-      for (Tindex i = 0; i < N; i++) {
-        const Tindex index = indices_vec(i);
-        OP_REQUIRES(ctx, index >= 0 && index < first_dim_size,
-                    errors::InvalidArgument(
-                        strings::StrCat("Index ", index, " at offset ", i,
-                                        " in indices is out of range")));
-      }
-
       auto var_flat = var.flat_outer_dims<T>();
       auto accum_grad_flat = accum_grad.flat_outer_dims<T>();
       auto accum_update_flat = accum_update.flat_outer_dims<T>();
@@ -741,8 +807,7 @@ class SparseApplyAdadeltaOp : public OpKernel {
       const T rho_scalar = rho.scalar<T>()();
       const T epsilon_scalar = epsilon.scalar<T>()();
 
-      for (Tindex i = 0; i < N; i++) {
-        const Tindex index = indices_vec(i);
+      auto apply_update = [&](Tindex i, Tindex index) {
         auto accum_ = accum_grad_flat.template chip<0>(index);
         auto accum_update_ = accum_update_flat.template chip<0>(index);
         auto grad_ = grad_flat.template chip<0>(i);
@@ -757,7 +822,11 @@ class SparseApplyAdadeltaOp : public OpKernel {
             update.square() * update.constant(static_cast<T>(1) - rho_scalar);
         auto v = var_flat.template chip<0>(index);
         v -= update * update.constant(lr_scalar);
-      }
+      };
+      OP_REQUIRES_OK(
+          ctx, ForEachSparseUpdate<Tindex>(ctx, indices_vec, first_dim_size,
+                                           var_flat.dimension(1),
+                                           apply_update));
     }
     if (use_exclusive_lock_) {
       mu_var->unlock();
@@ -926,12 +995,7 @@ class SparseApplyProximalGradientDescentOp : public OpKernel {
         T l2_scalar = l2.scalar<T>()();
 
         // TODO(xbing): extract the common logic for the Fobos update.
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto apply_update = [&](Tindex i, Tindex index) {
           auto g = grad_flat.template chip<0>(i);
           auto v = var_flat.template chip<0>(index);
           // compute learning_rate for current step.
@@ -949,7 +1013,10 @@ class SparseApplyProximalGradientDescentOp : public OpKernel {
             v = prox_v /
                 (v.constant(1.0) + v.constant(l2_scalar) * learning_rate);
           }
-        }
+        };
+        OP_REQUIRES_OK(
+            ctx, ForEachSparseUpdate<Tindex>(ctx, indices_vec, first_dim_size,
+                                             inner_dim, apply_update));
       } else {
         auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat<T>();
@@ -959,12 +1026,7 @@ class SparseApplyProximalGradientDescentOp : public OpKernel {
         T l2_scalar = l2.scalar<T>()();
         const Tindex first_dim_size = var_flat.size();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto apply_update = [&](Tindex i, Tindex index) {
           const T& g = grad_flat(i);
           auto learning_rate = lr_scalar;
           auto prox_v = var_flat(index);
@@ -978,7 +1040,10 @@ class SparseApplyProximalGradientDescentOp : public OpKernel {
           } else {
             var_flat(index) = prox_v / (1.0 + l2_scalar * learning_rate);
           }
-        }
+        };
+        OP_REQUIRES_OK(
+            ctx, ForEachSparseUpdate<Tindex>(ctx, indices_vec, first_dim_size,
+                                             1, apply_update));
       }
     }
 
@@ -1270,18 +1335,16 @@ class SparseApplyAdagradOp : public OpKernel {
 
         // Note(yonghui): It might be worth multi-threading square() and
         // rsqrt().
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto apply_update = [&](Tindex i, Tindex index) {
           auto a = accum_flat.template chip<0>(index);
           auto g = grad_flat.template chip<0>(i);
           auto v = var_flat.template chip<0>(index);
           a += g.square();
           v -= g.constant(lr_scalar) * g * a.rsqrt();
-        }
+        };
+        OP_REQUIRES_OK(
+            ctx, ForEachSparseUpdate<Tindex>(ctx, indices_vec, first_dim_size,
+                                             inner_dim, apply_update));
       } else {
         auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat<T>();
@@ -1290,17 +1353,15 @@ class SparseApplyAdagradOp : public OpKernel {
         T lr_scalar = lr.scalar<T>()();
         const Tindex first_dim_size = accum_flat.size();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto apply_update = [&](Tindex i, Tindex index) {
           T& a = accum_flat(index);
           const T& g = grad_flat(i);
           a += g * g;
           var_flat(index) -= lr_scalar * g / Eigen::numext::sqrt(a);
-        }
+        };
+        OP_REQUIRES_OK(
+            ctx, ForEachSparseUpdate<Tindex>(ctx, indices_vec, first_dim_size,
+                                             1, apply_update));
       }
     }
 
@@ -1421,12 +1482,7 @@ class SparseApplyProximalAdagradOp : public OpKernel {
         T l1_scalar = l1.scalar<T>()();
         T l2_scalar = l2.scalar<T>()();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto apply_update = [&](Tindex i, Tindex index) {
           auto a = accum_flat.template chip<0>(index);
           auto g = grad_flat.template chip<0>(i);
           auto v = var_flat.template chip<0>(index);
@@ -1446,7 +1502,10 @@ class SparseApplyProximalAdagradOp : public OpKernel {
             v = prox_v /
                 (v.constant(1.0) + v.constant(l2_scalar) * learning_rate);
           }
-        }
+        };
+        OP_REQUIRES_OK(
+            ctx, ForEachSparseUpdate<Tindex>(ctx, indices_vec, first_dim_size,
+                                             inner_dim, apply_update));
       } else {
         auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat<T>();
@@ -1457,12 +1516,7 @@ class SparseApplyProximalAdagradOp : public OpKernel {
         T l2_scalar = l2.scalar<T>()();
         const Tindex first_dim_size = accum_flat.size();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto apply_update = [&](Tindex i, Tindex index) {
           T& a = accum_flat(index);
           const T& g = grad_flat(i);
           a += g * g;
@@ -1478,7 +1532,10 @@ class SparseApplyProximalAdagradOp : public OpKernel {
           } else {
             var_flat(index) = prox_v / (1.0 + l2_scalar * learning_rate);
           }
-        }
+        };
+        OP_REQUIRES_OK(
+            ctx, ForEachSparseUpdate<Tindex>(ctx, indices_vec, first_dim_size,
+                                             1, apply_update));
       }
     }
 
@@ -1719,12 +1776,7 @@ class SparseApplyAdagradDAOp : public OpKernel {
         T l2_scalar = l2.scalar<T>()();
         const double gs_lr = global_step_scalar * lr_scalar;
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto apply_update = [&](Tindex i, Tindex index) {
           auto ga = gradient_accum_flat.template chip<0>(index);
           auto da = gradient_squared_accum_flat.template chip<0>(index);
           auto g = grad_flat.template chip<0>(i);
@@ -1741,7 +1793,10 @@ class SparseApplyAdagradDAOp : public OpKernel {
             v = ga.constant(-1.0) * (ga / ga.constant(global_step_scalar)) /
                 (v.constant(l2_scalar) + da.sqrt() / v.constant(gs_lr));
           }
-        }
+        };
+        OP_REQUIRES_OK(
+            ctx, ForEachSparseUpdate<Tindex>(ctx, indices_vec, first_dim_size,
+                                             inner_dim, apply_update));
       } else {
         auto indices_vec = indices.vec<Tindex>();
         auto var_flat = var.flat<T>();
@@ -1756,12 +1811,7 @@ class SparseApplyAdagradDAOp : public OpKernel {
         const double gs_l1 = global_step_scalar * l1_scalar;
         const double gs_l2_lr = global_step_scalar * l2_scalar * lr_scalar;
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto apply_update = [&](Tindex i, Tindex index) {
           T& ga = gradient_accum_flat(index);
           T& da = gradient_squared_accum_flat(index);
           const double g = grad_flat(i);
@@ -1774,7 +1824,10 @@ class SparseApplyAdagradDAOp : public OpKernel {
           } else {
             var_flat(index) = (-ga * lr_scalar) / (gs_l2_lr + std::sqrt(da));
           }
-        }
+        };
+        OP_REQUIRES_OK(
+            ctx, ForEachSparseUpdate<Tindex>(ctx, indices_vec, first_dim_size,
+                                             1, apply_update));
       }
     }
 
@@ -2080,12 +2133,7 @@ class SparseApplyFtrlOp : public OpKernel {
         }
         T lr_power_scalar = lr_power.scalar<T>()();
 
-        for (Tindex i = 0; i < N; i++) {
-          const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-          OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                      errors::InvalidArgument(
-                          strings::StrCat("Index ", index, " at offset ", i,
-                                          " in indices is out of range")));
+        auto apply_update = [&](Tindex i, Tindex index) {
           auto accum = accum_flat.template chip<0>(index);
           auto linear = linear_flat.template chip<0>(index);
           auto grad = grad_flat.template chip<0>(i);
@@ -2123,7 +2171,10 @@ class SparseApplyFtrlOp : public OpKernel {
           } else {
             COMPUTE_FTRL(grad);
           }
-        }
+        };
+        OP_REQUIRES_OK(
+            ctx, ForEachSparseUpdate<Tindex>(ctx, indices_vec, first_dim_size,
+                                             inner_dim, apply_update));
 #undef COMPUTE_FTRL
       } else {
         T lr_scalar = lr.scalar<T>()();
@@ -2142,6 +2193,8 @@ class SparseApplyFtrlOp : public OpKernel {
         auto grad_flat = grad.flat<T>();
         const Tindex first_dim_size = accum_flat.size();
 
+        // Applied serially, since the shrinkage of update i reads var_flat(i)
+        // rather than the row it updates.
         for (Tindex i = 0; i < N; i++) {
           const Tindex index = internal::SubtleMustCopy(indices_vec(i));
           OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
@@ -2395,12 +2448,7 @@ class SparseApplyMomentumOp : public OpKernel {
       T lr_scalar = lr.scalar<T>()();
       T momentum_scalar = momentum.scalar<T>()();
 
-      for (Tindex i = 0; i < N; i++) {
-        const Tindex index = internal::SubtleMustCopy(indices_vec(i));
-        OP_REQUIRES(ctx, FastBoundsCheck(index, first_dim_size),
-                    errors::InvalidArgument(
-                        strings::StrCat("Index ", index, " at offset ", i,
-                                        " in indices is out of range")));
+      auto apply_update = [&](Tindex i, Tindex index) {
         auto a = accum_flat.template chip<0>(index);
         auto g = grad_flat.template chip<0>(i);
         auto v = var_flat.template chip<0>(index);
@@ -2411,7 +2459,11 @@ class SparseApplyMomentumOp : public OpKernel {
         } else {
           v -= a.constant(lr_scalar) * a;
         }
-      }
+      };
+      OP_REQUIRES_OK(
+          ctx, ForEachSparseUpdate<Tindex>(ctx, indices_vec, first_dim_size,
+                                           var_flat.dimension(1),
+                                           apply_update));
     }
 
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
@@ -2704,6 +2756,221 @@ REGISTER_KERNELS(GPU, double);
 #undef REGISTER_CPU_KERNELS
 #undef REGISTER_KERNELS
 
+namespace {
+
+// Runs fn(i, begin, end) on the ranges [begin, end) of the elements of the
+// tensors i of "sizes", in parallel. The threads get ranges of the same
+// number of elements across the tensors, so that they share the large
+// tensors, and each of them updates many small ones.
+void ForEachTensorRange(
+    OpKernelContext* ctx, const std::vector<int64>& sizes,
+    int64 cost_per_element,
+    const std::function<void(int i, int64 begin, int64 end)>& fn) {
+  // The offsets of the tensors among all the elements.
+  std::vector<int64> offsets(sizes.size() + 1, 0);
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    offsets[i + 1] = offsets[i] + sizes[i];
+  }
+  auto work = [&offsets, &fn](int64 start, int64 limit) {
+    int i = std::upper_bound(offsets.begin(), offsets.end(), start) -
+            offsets.begin() - 1;
+    for (; start < limit; ++i) {
+      const int64 end = std::min(limit, offsets[i + 1]);
+      if (start < end) fn(i, start - offsets[i], end - offsets[i]);
+      start = end;
+    }
+  };
+  auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers, offsets.back(),
+        cost_per_element, work);
+}
+
+// Gets the variables of the inputs [first, first + n) of "ctx" into "out",
+// as ApplyAdamOp does for each of them.
+template <typename T>
+Status GetInputTensorsFromVariables(OpKernel* op, OpKernelContext* ctx,
+                                    int first, int n, bool lock_held,
+                                    std::vector<Tensor>* out) {
+  out->resize(n);
+  for (int i = 0; i < n; ++i) {
+    TF_RETURN_IF_ERROR(GetInputTensorFromVariable<CPUDevice, T>(
+        ctx, first + i, lock_held, false, &(*out)[i]));
+    if (!(*out)[i].IsInitialized()) {
+      return errors::FailedPrecondition(
+          "Attempting to use uninitialized variables: ",
+          op->requested_input(first + i));
+    }
+  }
+  return Status::OK();
+}
+
+Status CheckSameShape(const char* name, const Tensor& var, const char* other,
+                      const Tensor& tensor) {
+  if (!var.shape().IsSameSize(tensor.shape())) {
+    return errors::InvalidArgument(name, " and ", other,
+                                   " do not have the same shape",
+                                   var.shape().DebugString(), " ",
+                                   tensor.shape().DebugString());
+  }
+  return Status::OK();
+}
+
+Status CheckScalar(const char* name, const Tensor& tensor) {
+  if (!TensorShapeUtils::IsScalar(tensor.shape())) {
+    return errors::InvalidArgument(name, " is not a scalar: ",
+                                   tensor.shape().DebugString());
+  }
+  return Status::OK();
+}
+
+// The range [begin, end) of the elements of "tensor".
+template <typename T>
+typename TTypes<T>::Flat Range(Tensor* tensor, int64 begin, int64 end) {
+  return typename TTypes<T>::Flat(tensor->flat<T>().data() + begin,
+                                  end - begin);
+}
+
+template <typename T>
+typename TTypes<T>::ConstFlat ConstRange(const Tensor& tensor, int64 begin,
+                                         int64 end) {
+  return typename TTypes<T>::ConstFlat(tensor.flat<T>().data() + begin,
+                                       end - begin);
+}
+
+}  // namespace
+
+// Applies ApplyMomentumOp to N variables, with the functor of the CPU run on
+// ranges of their elements by one thread each.
+template <typename T>
+class MultiApplyMomentumOp : public OpKernel {
+ public:
+  explicit MultiApplyMomentumOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &n_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_nesterov", &use_nesterov_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    std::vector<int> variable_inputs(2 * n_);
+    std::iota(variable_inputs.begin(), variable_inputs.end(), 0);
+    auto locks = MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_,
+                                                      variable_inputs);
+
+    std::vector<Tensor> vars;
+    OP_REQUIRES_OK(ctx, GetInputTensorsFromVariables<T>(
+                            this, ctx, 0, n_, use_exclusive_lock_, &vars));
+    std::vector<Tensor> accums;
+    OP_REQUIRES_OK(ctx, GetInputTensorsFromVariables<T>(
+                            this, ctx, n_, n_, use_exclusive_lock_, &accums));
+    const Tensor& lr = ctx->input(2 * n_);
+    OP_REQUIRES_OK(ctx, CheckScalar("lr", lr));
+    const Tensor& momentum = ctx->input(3 * n_ + 1);
+    OP_REQUIRES_OK(ctx, CheckScalar("momentum", momentum));
+    std::vector<int64> sizes(n_);
+    for (int i = 0; i < n_; ++i) {
+      OP_REQUIRES_OK(ctx, CheckSameShape("var", vars[i], "accum", accums[i]));
+      OP_REQUIRES_OK(ctx, CheckSameShape("var", vars[i], "grad",
+                                         ctx->input(2 * n_ + 1 + i)));
+      sizes[i] = vars[i].NumElements();
+    }
+
+    auto fn = [&](int i, int64 begin, int64 end) {
+      functor::ApplyMomentumNonCuda<Eigen::DefaultDevice, T>()(
+          Eigen::DefaultDevice(), Range<T>(&vars[i], begin, end),
+          Range<T>(&accums[i], begin, end), lr.scalar<T>(),
+          ConstRange<T>(ctx->input(2 * n_ + 1 + i), begin, end),
+          momentum.scalar<T>(), use_nesterov_);
+    };
+    ForEachTensorRange(ctx, sizes, 10 /* cost_per_element */, fn);
+  }
+
+ private:
+  int n_;
+  bool use_exclusive_lock_;
+  bool use_nesterov_;
+};
+
+// Applies ApplyAdamOp to N variables, with the functor of the CPU run on
+// ranges of their elements by one thread each.
+template <typename T>
+class MultiApplyAdamOp : public OpKernel {
+ public:
+  explicit MultiApplyAdamOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &n_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_nesterov", &use_nesterov_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    std::vector<int> variable_inputs(3 * n_);
+    std::iota(variable_inputs.begin(), variable_inputs.end(), 0);
+    auto locks = MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_,
+                                                      variable_inputs);
+
+    std::vector<Tensor> vars;
+    OP_REQUIRES_OK(ctx, GetInputTensorsFromVariables<T>(
+                            this, ctx, 0, n_, use_exclusive_lock_, &vars));
+    std::vector<Tensor> ms;
+    OP_REQUIRES_OK(ctx, GetInputTensorsFromVariables<T>(
+                            this, ctx, n_, n_, use_exclusive_lock_, &ms));
+    std::vector<Tensor> vs;
+    OP_REQUIRES_OK(ctx, GetInputTensorsFromVariables<T>(
+                            this, ctx, 2 * n_, n_, use_exclusive_lock_, &vs));
+
+    const Tensor& beta1_power = ctx->input(3 * n_);
+    const Tensor& beta2_power = ctx->input(3 * n_ + 1);
+    const Tensor& lr = ctx->input(3 * n_ + 2);
+    const Tensor& beta1 = ctx->input(3 * n_ + 3);
+    const Tensor& beta2 = ctx->input(3 * n_ + 4);
+    const Tensor& epsilon = ctx->input(3 * n_ + 5);
+    OP_REQUIRES_OK(ctx, CheckScalar("beta1_power", beta1_power));
+    OP_REQUIRES_OK(ctx, CheckScalar("beta2_power", beta2_power));
+    OP_REQUIRES_OK(ctx, CheckScalar("lr", lr));
+    OP_REQUIRES_OK(ctx, CheckScalar("beta1", beta1));
+    OP_REQUIRES_OK(ctx, CheckScalar("beta2", beta2));
+    OP_REQUIRES_OK(ctx, CheckScalar("epsilon", epsilon));
+    std::vector<int64> sizes(n_);
+    for (int i = 0; i < n_; ++i) {
+      OP_REQUIRES_OK(ctx, CheckSameShape("var", vars[i], "m", ms[i]));
+      OP_REQUIRES_OK(ctx, CheckSameShape("var", vars[i], "v", vs[i]));
+      OP_REQUIRES_OK(ctx, CheckSameShape("var", vars[i], "grad",
+                                         ctx->input(3 * n_ + 6 + i)));
+      sizes[i] = vars[i].NumElements();
+    }
+
+    auto fn = [&](int i, int64 begin, int64 end) {
+      functor::ApplyAdamNonCuda<Eigen::DefaultDevice, T>()(
+          Eigen::DefaultDevice(), Range<T>(&vars[i], begin, end),
+          Range<T>(&ms[i], begin, end), Range<T>(&vs[i], begin, end),
+          beta1_power.scalar<T>(), beta2_power.scalar<T>(), lr.scalar<T>(),
+          beta1.scalar<T>(), beta2.scalar<T>(), epsilon.scalar<T>(),
+          ConstRange<T>(ctx->input(3 * n_ + 6 + i), begin, end),
+          use_nesterov_);
+    };
+    ForEachTensorRange(ctx, sizes, 50 /* cost_per_element */, fn);
+  }
+
+ private:
+  int n_;
+  bool use_exclusive_lock_;
+  bool use_nesterov_;
+};
+
+#define REGISTER_CPU_KERNELS(T)                                 \
+  REGISTER_KERNEL_BUILDER(Name("ResourceMultiApplyMomentum")    \
+                              .Device(DEVICE_CPU)               \
+                              .TypeConstraint<T>("T"),          \
+                          MultiApplyMomentumOp<T>);             \
+  REGISTER_KERNEL_BUILDER(Name("ResourceMultiApplyAdam")        \
+                              .Device(DEVICE_CPU)               \
+                              .TypeConstraint<T>("T"),          \
+                          MultiApplyAdamOp<T>);
+
+TF_CALL_half(REGISTER_CPU_KERNELS);
+TF_CALL_float(REGISTER_CPU_KERNELS);
+TF_CALL_double(REGISTER_CPU_KERNELS);
+#undef REGISTER_CPU_KERNELS
+
 template <typename Device, typename T>
 class ApplyRMSPropOp : public OpKernel {
  public:
@@ -3027,16 +3294,7 @@ class SparseApplyRMSPropOp : public OpKernel {
 
     if (N > 0) {
       const Tindex first_dim_size = var.dim_size(0);
-      // Validate all the indices are in range
       auto indices_vec = indices.vec<Tindex>();
-      for (Tindex i = 0; i < N; i++) {
-        const Tindex index = indices_vec(i);
-        OP_REQUIRES(ctx, index >= 0 && index < first_dim_size,
-                    errors::InvalidArgument(
-                        strings::StrCat("Index ", index, " at offset ", i,
-                                        " in indices is out of range")));
-      }
-
       auto var_flat = var.flat_outer_dims<T>();
       auto ms_flat = ms.flat_outer_dims<T>();
       auto mom_flat = mom.flat_outer_dims<T>();
@@ -3046,9 +3304,7 @@ class SparseApplyRMSPropOp : public OpKernel {
       const T epsilon_scalar = epsilon.scalar<T>()();
       const T momentum_scalar = momentum.scalar<T>()();
 
-      for (Tindex i = 0; i < N; i++) {
-        const Tindex index = indices_vec(i);
-
+      auto apply_update = [&](Tindex i, Tindex index) {
         auto ms_ = ms_flat.template chip<0>(index);
         auto mom_ = mom_flat.template chip<0>(index);
         auto grad_ = grad_flat.template chip<0>(i);
@@ -3061,7 +3317,11 @@ class SparseApplyRMSPropOp : public OpKernel {
 
         auto v = var_flat.template chip<0>(index);
         v -= mom_;
-      }
+      };
+      OP_REQUIRES_OK(
+          ctx, ForEachSparseUpdate<Tindex>(ctx, indices_vec, first_dim_size,
+                                           var_flat.dimension(1),
+                                           apply_update));
     }
 
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
@@ -3164,16 +3424,7 @@ class SparseApplyCenteredRMSPropOp : public OpKernel {
 
     if (N > 0) {
       const Tindex first_dim_size = var.dim_size(0);
-      // Validate all the indices are in range
       auto indices_vec = indices.vec<Tindex>();
-      for (Tindex i = 0; i < N; i++) {
-        const Tindex index = indices_vec(i);
-        OP_REQUIRES(ctx, index >= 0 && index < first_dim_size,
-                    errors::InvalidArgument(
-                        strings::StrCat("Index ", index, " at offset ", i,
-                                        " in indices is out of range")));
-      }
-
       auto var_flat = var.flat_outer_dims<T>();
       auto ms_flat = ms.flat_outer_dims<T>();
       auto mg_flat = mg.flat_outer_dims<T>();
@@ -3184,9 +3435,7 @@ class SparseApplyCenteredRMSPropOp : public OpKernel {
       const T epsilon_scalar = epsilon.scalar<T>()();
       const T momentum_scalar = momentum.scalar<T>()();
 
-      for (Tindex i = 0; i < N; i++) {
-        const Tindex index = indices_vec(i);
-
+      auto apply_update = [&](Tindex i, Tindex index) {
         auto ms_ = ms_flat.template chip<0>(index);
         auto mom_ = mom_flat.template chip<0>(index);
         auto grad_ = grad_flat.template chip<0>(i);
@@ -3202,7 +3451,11 @@ class SparseApplyCenteredRMSPropOp : public OpKernel {
                denom_.rsqrt() * ms_.constant(lr_scalar) * grad_;
         auto v = var_flat.template chip<0>(index);
         v -= mom_;
-      }
+      };
+      OP_REQUIRES_OK(
+          ctx, ForEachSparseUpdate<Tindex>(ctx, indices_vec, first_dim_size,
+                                           var_flat.dimension(1),
+                                           apply_update));
     }
 
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
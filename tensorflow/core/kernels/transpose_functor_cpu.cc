@@ -15,6 +15,7 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
 #include <complex>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -31,6 +32,9 @@ typedef Eigen::ThreadPoolDevice CPUDevice;
 namespace tensorflow {
 namespace {
 
+using internal::TransposeDimsVec;
+using internal::TransposePermsVec;
+
 template <typename T, bool conjugate>
 void TransposeSimple(const CPUDevice& device, const Tensor& in,
                      const gtl::ArraySlice<int32> perm, Tensor* out) {
@@ -65,12 +69,208 @@ void TransposeSimple(const CPUDevice& device, const Tensor& in,
   device.parallelFor(in.NumElements(), cost, std::move(transpose_fn));
 }
 
+// The scalar type whose packets transpose the bits of T in registers, for the
+// types whose packets Eigen can transpose.
+template <typename T>
+struct TransposePacket {
+  static const bool kVectorized = false;
+  typedef T Scalar;
+};
+
+template <>
+struct TransposePacket<uint32> {
+  static const bool kVectorized =
+      Eigen::internal::packet_traits<float>::Vectorizable;
+  typedef float Scalar;
+};
+
+template <>
+struct TransposePacket<uint64> {
+  static const bool kVectorized =
+      Eigen::internal::packet_traits<double>::Vectorizable;
+  typedef double Scalar;
+};
+
+// Transposes the [rows, cols] block of "in", whose rows are "in_stride"
+// elements apart, into the [cols, rows] block of "out", whose rows are
+// "out_stride" elements apart. The N x N tiles of the block, where N is the
+// packet size of T, are transposed in registers.
+template <typename T, bool vectorized = TransposePacket<T>::kVectorized>
+struct TransposeBlock {
+  static void Run(const T* in, int64 in_stride, int64 rows, int64 cols,
+                  T* out, int64 out_stride) {
+    for (int64 c = 0; c < cols; ++c) {
+      for (int64 r = 0; r < rows; ++r) {
+        out[c * out_stride + r] = in[r * in_stride + c];
+      }
+    }
+  }
+};
+
+template <typename T>
+struct TransposeBlock<T, true> {
+  static void Run(const T* in, int64 in_stride, int64 rows, int64 cols,
+                  T* out, int64 out_stride) {
+    typedef typename TransposePacket<T>::Scalar Scalar;
+    typedef typename Eigen::internal::packet_traits<Scalar>::type Packet;
+    static const int kSize = Eigen::internal::unpacket_traits<Packet>::size;
+    const Scalar* src = reinterpret_cast<const Scalar*>(in);
+    Scalar* dst = reinterpret_cast<Scalar*>(out);
+    // Walks the tiles down the columns of "in", so that each row of "out" is
+    // written contiguously.
+    int64 c = 0;
+    for (; c + kSize <= cols; c += kSize) {
+      int64 r = 0;
+      for (; r + kSize <= rows; r += kSize) {
+        Eigen::internal::PacketBlock<Packet, kSize> tile;
+        for (int i = 0; i < kSize; ++i) {
+          tile.packet[i] = Eigen::internal::ploadu<Packet>(
+              src + (r + i) * in_stride + c);
+        }
+        Eigen::internal::ptranspose(tile);
+        for (int i = 0; i < kSize; ++i) {
+          Eigen::internal::pstoreu(dst + (c + i) * out_stride + r,
+                                   tile.packet[i]);
+        }
+      }
+      TransposeBlock<T, false>::Run(in + r * in_stride + c, in_stride,
+                                    rows - r, kSize, out + c * out_stride + r,
+                                    out_stride);
+    }
+    TransposeBlock<T, false>::Run(in + c, in_stride, rows, cols - c,
+                                  out + c * out_stride, out_stride);
+  }
+};
+
+// Transposes the "batch" consecutive [rows, cols] matrices of "in" into the
+// [cols, rows] matrices of "out", by blocks that fit in the L1 cache.
+template <typename T>
+void TransposeMatrices(const CPUDevice& device, const T* in, int64 batch,
+                       int64 rows, int64 cols, T* out) {
+  // The blocks are square unless the matrices have few columns, in which
+  // case they have as many more rows.
+  const int64 kBlock = sizeof(T) <= 2 ? 64 : 32;
+  const int64 block_cols = std::min(cols, kBlock);
+  const int64 block_rows =
+      std::max<int64>(kBlock, kBlock * kBlock / block_cols / kBlock * kBlock);
+  const int64 row_blocks = (rows + block_rows - 1) / block_rows;
+  const int64 col_blocks = (cols + block_cols - 1) / block_cols;
+  auto transpose_fn = [=](int64 begin, int64 end) {
+    for (int64 i = begin; i < end; ++i) {
+      const int64 b = i / (row_blocks * col_blocks);
+      const int64 r = (i / col_blocks) % row_blocks * block_rows;
+      const int64 c = i % col_blocks * block_cols;
+      TransposeBlock<T>::Run(in + (b * rows + r) * cols + c, cols,
+                             std::min(block_rows, rows - r),
+                             std::min(block_cols, cols - c),
+                             out + (b * cols + c) * rows + r, rows);
+    }
+  };
+  Eigen::TensorOpCost cost(/*bytes_loaded=*/block_rows * block_cols * sizeof(T),
+                           /*bytes_stored=*/block_rows * block_cols * sizeof(T),
+                           /*compute_cycles=*/block_rows * block_cols);
+  device.parallelFor(batch * row_blocks * col_blocks, cost,
+                     std::move(transpose_fn));
+}
+
+// Transposes "in", whose dimensions are "dims", by "perm", which keeps the
+// last dimension, by copying its contiguous rows.
+template <typename T>
+void TransposeRows(const CPUDevice& device, const T* in,
+                   const TransposeDimsVec& dims, const TransposePermsVec& perm,
+                   T* out) {
+  const int ndims = dims.size();
+  const int64 row_size = dims[ndims - 1];
+  TransposeDimsVec in_strides(ndims, 1);
+  for (int i = ndims - 2; i >= 0; --i) {
+    in_strides[i] = in_strides[i + 1] * dims[i + 1];
+  }
+  TransposeDimsVec out_dims(ndims);
+  for (int i = 0; i < ndims; ++i) out_dims[i] = dims[perm[i]];
+  int64 num_rows = 1;
+  for (int i = 0; i < ndims - 1; ++i) num_rows *= out_dims[i];
+  auto transpose_fn = [=, &in_strides, &out_dims, &perm](int64 begin,
+                                                         int64 end) {
+    for (int64 row = begin; row < end; ++row) {
+      int64 in_offset = 0;
+      int64 t = row;
+      for (int i = ndims - 2; i >= 0; --i) {
+        in_offset += t % out_dims[i] * in_strides[perm[i]];
+        t /= out_dims[i];
+      }
+      std::copy(in + in_offset, in + in_offset + row_size,
+                out + row * row_size);
+    }
+  };
+  Eigen::TensorOpCost cost(/*bytes_loaded=*/row_size * sizeof(T),
+                           /*bytes_stored=*/row_size * sizeof(T),
+                           /*compute_cycles=*/ndims * 2 +
+                               row_size * sizeof(T) / 16);
+  device.parallelFor(num_rows, cost, std::move(transpose_fn));
+}
+
+// Transposes "in" without Eigen when, after the dimensions of size 1 are
+// dropped and the dimensions that stay next to each other are merged, the
+// transpose is a batch of matrix transposes or a permutation of contiguous
+// rows of at least kMinRowBytes. Returns false otherwise.
+template <typename T>
+bool TransposeBlocked(const CPUDevice& device, const Tensor& in,
+                      const gtl::ArraySlice<int32> perm, Tensor* out) {
+  const int64 kMinRowBytes = 32;
+  TensorShape shape;
+  TransposePermsVec new_positions(in.dims(), -1);
+  for (int i = 0; i < in.dims(); ++i) {
+    if (in.dim_size(i) != 1) {
+      new_positions[i] = shape.dims();
+      shape.AddDim(in.dim_size(i));
+    }
+  }
+  TransposePermsVec squeezed_perm;
+  for (int i = 0; i < in.dims(); ++i) {
+    if (new_positions[perm[i]] >= 0) {
+      squeezed_perm.push_back(new_positions[perm[i]]);
+    }
+  }
+  if (in.NumElements() == 0) return true;
+  const T* p = reinterpret_cast<const T*>(in.tensor_data().data());
+  T* q = reinterpret_cast<T*>(const_cast<char*>(out->tensor_data().data()));
+  if (shape.dims() <= 1) {
+    std::copy(p, p + in.NumElements(), q);
+    return true;
+  }
+  TransposePermsVec new_perm;
+  TransposeDimsVec new_dims;
+  internal::ReduceTransposeDimensions(shape, squeezed_perm, &new_perm,
+                                      &new_dims);
+  const int ndims = new_perm.size();
+  if (ndims == 1) {
+    std::copy(p, p + in.NumElements(), q);
+    return true;
+  }
+  if (ndims == 2) {
+    // new_perm is {1, 0}.
+    TransposeMatrices(device, p, 1, new_dims[0], new_dims[1], q);
+    return true;
+  }
+  if (ndims == 3 && new_perm[0] == 0 && new_perm[1] == 2 && new_perm[2] == 1) {
+    TransposeMatrices(device, p, new_dims[0], new_dims[1], new_dims[2], q);
+    return true;
+  }
+  if (new_perm[ndims - 1] == ndims - 1 &&
+      new_dims[ndims - 1] * static_cast<int64>(sizeof(T)) >= kMinRowBytes) {
+    TransposeRows(device, p, new_dims, new_perm, q);
+    return true;
+  }
+  return false;
+}
+
 }  // namespace
 
 template <typename T, bool conjugate>
 struct Transpose<CPUDevice, T, conjugate> {
   static void run(const CPUDevice& d, const Tensor& in,
                   const gtl::ArraySlice<int32> perm, Tensor* out) {
+    if (!conjugate && TransposeBlocked<T>(d, in, perm, out)) return;
     switch (in.dims()) {
       case 2:
         internal::TransposeUsingEigen<CPUDevice, T, 2>(d, in, perm, conjugate,
@@ -13,19 +13,43 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
-#include <unordered_map>
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
+namespace {
+
+// The hash of the elements. hash<T> is the identity for integers, whose bits
+// are mixed here, as gtl::FlatMap probes the buckets from the low bits of the
+// hash and small integers would all start in the same bucket.
+template <typename T>
+struct UniqueHash {
+  size_t operator()(const T& value) const {
+    uint64 h = hash<T>()(value);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return static_cast<size_t>(h);
+  }
+};
+
+}  // namespace
+
 template <typename T, typename TIndex>
 class UniqueOp : public OpKernel {
  public:
@@ -50,8 +74,28 @@ class UniqueOp : public OpKernel {
                                 {0}, 1, input.shape(), &idx));
     auto idx_vec = idx->template vec<TIndex>();
 
-    std::unordered_map<T, TIndex> uniq;
-    uniq.reserve(2 * N);
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *context->device()->tensorflow_cpu_worker_threads();
+    if (N < kMinParallelSize || worker_threads.num_threads <= 1) {
+      ComputeSerial(context, Tin, idx_vec);
+    } else {
+      ComputeParallel(context, worker_threads, Tin, idx_vec);
+    }
+  }
+
+ private:
+  typedef gtl::FlatMap<T, TIndex, UniqueHash<T>> UniqueMap;
+
+  // The inputs below this size are not worth partitioning.
+  static const int64 kMinParallelSize = 1 << 17;
+  // The partitions must fit in the bytes of "partitions" below.
+  static const int kMaxPartitions = 256;
+
+  void ComputeSerial(OpKernelContext* context,
+                     typename TTypes<T>::ConstVec Tin,
+                     typename TTypes<TIndex>::Vec idx_vec) {
+    const int64 N = static_cast<int64>(Tin.size());
+    UniqueMap uniq(N);
     for (int64 i = 0, j = 0; i < N; ++i) {
       auto it = uniq.insert(std::make_pair(Tin(i), j));
       idx_vec(i) = it.first->second;
@@ -65,7 +109,7 @@ class UniqueOp : public OpKernel {
                                 0, TensorShape({uniq_size}), &output));
     auto output_vec = output->template vec<T>();
 
-    for (auto it : uniq) {
+    for (const auto& it : uniq) {
       output_vec(it.second) = it.first;
     }
 
@@ -79,6 +123,123 @@ class UniqueOp : public OpKernel {
       }
     }
   }
+
+  // The unique elements of one partition of the input, in the order of
+  // their first occurrences.
+  struct Partition {
+    std::vector<int64> firsts;   // The positions of their first occurrences.
+    std::vector<TIndex> counts;  // Their numbers of occurrences.
+    std::vector<TIndex> ids;     // Their indices in the output.
+  };
+
+  // Splits the elements into partitions by their hashes, and finds the
+  // unique elements of each partition in parallel, with the indices of the
+  // elements in their partitions. The output indices of the unique elements
+  // are then the ranks of their first occurrences among those of all
+  // partitions, so that the output is in the same order as the serial one.
+  void ComputeParallel(OpKernelContext* context,
+                       const DeviceBase::CpuWorkerThreads& worker_threads,
+                       typename TTypes<T>::ConstVec Tin,
+                       typename TTypes<TIndex>::Vec idx_vec) {
+    const int64 N = static_cast<int64>(Tin.size());
+    const int num_threads = worker_threads.num_threads;
+    thread::ThreadPool* workers = worker_threads.workers;
+    const int num_partitions = std::min(num_threads, kMaxPartitions);
+    const bool with_counts = num_outputs() > 2;
+
+    std::vector<uint8> partitions(N);
+    Shard(num_threads, workers, N, 20 /* cost_per_unit */,
+          [&Tin, &partitions, num_partitions](int64 start, int64 limit) {
+            const UniqueHash<T> hasher;
+            for (int64 i = start; i < limit; ++i) {
+              // Maps the high bits of the hash to the partitions, which
+              // leaves the low ones to the buckets of the maps.
+              const uint64 h = hasher(Tin(i));
+              partitions[i] = ((h >> 32) * num_partitions) >> 32;
+            }
+          });
+
+    std::vector<uint8> is_first(N, 0);
+    std::vector<Partition> uniques(num_partitions);
+    Shard(num_threads, workers, num_partitions, 50 * N /* cost_per_unit */,
+          [&](int64 start, int64 limit) {
+            for (int64 p = start; p < limit; ++p) {
+              Partition& partition = uniques[p];
+              UniqueMap uniq;
+              for (int64 i = 0; i < N; ++i) {
+                if (partitions[i] != p) continue;
+                auto it = uniq.insert(
+                    std::make_pair(Tin(i), partition.firsts.size()));
+                idx_vec(i) = it.first->second;
+                if (it.second) {
+                  partition.firsts.push_back(i);
+                  if (with_counts) partition.counts.push_back(0);
+                  is_first[i] = 1;
+                }
+                if (with_counts) ++partition.counts[idx_vec(i)];
+              }
+              partition.ids.resize(partition.firsts.size());
+            }
+          });
+
+    int64 uniq_size = 0;
+    for (const Partition& partition : uniques) {
+      uniq_size += partition.firsts.size();
+    }
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({uniq_size}), &output));
+    auto output_vec = output->template vec<T>();
+    TIndex* count_output = nullptr;
+    if (with_counts) {
+      OP_REQUIRES_OK(context, context->allocate_output(
+                                  2, TensorShape({uniq_size}), &output));
+      count_output = output->template vec<TIndex>().data();
+    }
+
+    // Ranks the first occurrences with a parallel prefix sum over blocks of
+    // the input.
+    const int64 num_blocks = std::min<int64>(4 * num_threads, N);
+    const int64 block_size = (N + num_blocks - 1) / num_blocks;
+    std::vector<int64> block_offsets(num_blocks + 1, 0);
+    Shard(num_threads, workers, num_blocks, block_size /* cost_per_unit */,
+          [&is_first, &block_offsets, block_size, N](int64 start,
+                                                     int64 limit) {
+            for (int64 b = start; b < limit; ++b) {
+              const int64 end = std::min(N, (b + 1) * block_size);
+              for (int64 i = b * block_size; i < end; ++i) {
+                block_offsets[b + 1] += is_first[i];
+              }
+            }
+          });
+    for (int64 b = 0; b < num_blocks; ++b) {
+      block_offsets[b + 1] += block_offsets[b];
+    }
+    Shard(num_threads, workers, num_blocks, block_size /* cost_per_unit */,
+          [&](int64 start, int64 limit) {
+            for (int64 b = start; b < limit; ++b) {
+              int64 id = block_offsets[b];
+              const int64 end = std::min(N, (b + 1) * block_size);
+              for (int64 i = b * block_size; i < end; ++i) {
+                if (!is_first[i]) continue;
+                Partition& partition = uniques[partitions[i]];
+                partition.ids[idx_vec(i)] = id;
+                output_vec(id) = Tin(i);
+                if (with_counts) {
+                  count_output[id] = partition.counts[idx_vec(i)];
+                }
+                ++id;
+              }
+            }
+          });
+
+    Shard(num_threads, workers, N, 5 /* cost_per_unit */,
+          [&uniques, &partitions, &idx_vec](int64 start, int64 limit) {
+            for (int64 i = start; i < limit; ++i) {
+              idx_vec(i) = uniques[partitions[i]].ids[idx_vec(i)];
+            }
+          });
+  }
 };
 
 #define REGISTER_UNIQUE(type)                                    \
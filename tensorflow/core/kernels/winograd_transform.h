@@ -372,6 +372,124 @@ void WinogradTransform<T>::GetOutputTransformMatrix(const int64 rows,
   transform_matrix[3 * cols + 15] = T(1.0);
 };
 
+// Winograd DeepConv2DTransform implementation F(4x4, 3x3) for 3x3 filters,
+// which computes 4x4 output tiles from 6x6 input tiles. It needs 36 products
+// per 16 outputs, where WinogradTransform needs 16 per 4, so it is cheaper
+// for deep convolutions, at the cost of larger input and output transforms.
+// Details:
+// *) Fast Algorithms for Convolutional Neural Networks: Lavin, Gray
+//
+// Each transform matrix is the kronecker product 'M * M' of a matrix 'M'
+// given below.
+template <typename T>
+class Winograd4x4Transform : public DeepConv2DTransform<T> {
+ public:
+  typedef typename DeepConv2DTransform<T>::Shape Shape;
+
+  Winograd4x4Transform()
+      : filter_shape_(3, 3), input_shape_(6, 6), output_shape_(4, 4) {}
+
+  // 'M':
+  //
+  //   [  1/4     0     0   ]
+  //   [ -1/6  -1/6  -1/6   ]
+  //   [ -1/6   1/6  -1/6   ]
+  //   [ 1/24  1/12   1/6   ]
+  //   [ 1/24 -1/12   1/6   ]
+  //   [  0     0     1     ]
+  //
+  // The data layout of 'transform_matrix':
+  //   [input_tile_spatial_size, filter_spatial_size]
+  virtual void GetFilterTransformMatrix(const int64 rows, const int64 cols,
+                                        T* transform_matrix) const {
+    // clang-format off
+    static const T kMatrix[6 * 3] = {
+        T(1.0 / 4), T(0), T(0),
+        T(-1.0 / 6), T(-1.0 / 6), T(-1.0 / 6),
+        T(-1.0 / 6), T(1.0 / 6), T(-1.0 / 6),
+        T(1.0 / 24), T(1.0 / 12), T(1.0 / 6),
+        T(1.0 / 24), T(-1.0 / 12), T(1.0 / 6),
+        T(0), T(0), T(1)};
+    // clang-format on
+    ComputeKroneckerProduct(6, 3, kMatrix, rows, cols, transform_matrix);
+  }
+
+  // 'M':
+  //
+  //   [ 4   0  -5   0   1   0 ]
+  //   [ 0  -4  -4   1   1   0 ]
+  //   [ 0   4  -4  -1   1   0 ]
+  //   [ 0  -2  -1   2   1   0 ]
+  //   [ 0   2  -1  -2   1   0 ]
+  //   [ 0   4   0  -5   0   1 ]
+  //
+  // Data layout of 'transform_matrix':
+  //   [tile_spatial_size, tile_spatial_size]
+  virtual void GetInputTransformMatrix(const int64 rows, const int64 cols,
+                                       T* transform_matrix) const {
+    // clang-format off
+    static const T kMatrix[6 * 6] = {
+        T(4), T(0), T(-5), T(0), T(1), T(0),
+        T(0), T(-4), T(-4), T(1), T(1), T(0),
+        T(0), T(4), T(-4), T(-1), T(1), T(0),
+        T(0), T(-2), T(-1), T(2), T(1), T(0),
+        T(0), T(2), T(-1), T(-2), T(1), T(0),
+        T(0), T(4), T(0), T(-5), T(0), T(1)};
+    // clang-format on
+    ComputeKroneckerProduct(6, 6, kMatrix, rows, cols, transform_matrix);
+  }
+
+  // 'M':
+  //
+  //   [ 1  1  1  1  1  0 ]
+  //   [ 0  1 -1  2 -2  0 ]
+  //   [ 0  1  1  4  4  0 ]
+  //   [ 0  1 -1  8 -8  1 ]
+  //
+  // Data layout of 'transform_matrix':
+  //   [out_tile_spatial_size, tile_spatial_size]
+  virtual void GetOutputTransformMatrix(const int64 rows, const int64 cols,
+                                        T* transform_matrix) const {
+    // clang-format off
+    static const T kMatrix[4 * 6] = {
+        T(1), T(1), T(1), T(1), T(1), T(0),
+        T(0), T(1), T(-1), T(2), T(-2), T(0),
+        T(0), T(1), T(1), T(4), T(4), T(0),
+        T(0), T(1), T(-1), T(8), T(-8), T(1)};
+    // clang-format on
+    ComputeKroneckerProduct(4, 6, kMatrix, rows, cols, transform_matrix);
+  }
+
+  virtual const Shape& filter_shape() const { return filter_shape_; }
+  virtual const Shape& input_shape() const { return input_shape_; }
+  virtual const Shape& output_shape() const { return output_shape_; }
+
+ private:
+  // Stores the kronecker product of the 'm_rows' x 'm_cols' matrix 'm' with
+  // itself in the 'rows' x 'cols' matrix 'transform_matrix'.
+  static void ComputeKroneckerProduct(const int64 m_rows, const int64 m_cols,
+                                      const T* m, const int64 rows,
+                                      const int64 cols, T* transform_matrix) {
+    CHECK_EQ(rows, m_rows * m_rows);
+    CHECK_EQ(cols, m_cols * m_cols);
+    for (int64 i = 0; i < m_rows; ++i) {
+      for (int64 j = 0; j < m_cols; ++j) {
+        const T v = m[i * m_cols + j];
+        for (int64 k = 0; k < m_rows; ++k) {
+          for (int64 l = 0; l < m_cols; ++l) {
+            transform_matrix[(i * m_rows + k) * cols + j * m_cols + l] =
+                v * m[k * m_cols + l];
+          }
+        }
+      }
+    }
+  }
+
+  const Shape filter_shape_;
+  const Shape input_shape_;
+  const Shape output_shape_;
+};
+
 }  // namespace tensorflow
 
 #endif  // THIRD_PARTY_TENSORFLOW_CORE_KERNELS_WINOGRAD_TRANSFORM_H_
@@ -0,0 +1,356 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/core/kernels/x86_quantized_gemm.h"
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/platform.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+// The kernels are compiled for their instruction sets with target attributes,
+// so that the rest of the binary does not require them.
+#if defined(PLATFORM_IS_X86) && defined(__GNUC__) &&  \
+    ((defined(__clang__) && __clang_major__ >= 6) ||  \
+     (!defined(__clang__) && __GNUC__ >= 8)) &&       \
+    !defined(TENSORFLOW_DISABLE_X86_QUANTIZED_GEMM)
+#define TENSORFLOW_USE_X86_QUANTIZED_GEMM (1)
+#include <immintrin.h>
+#endif
+
+namespace tensorflow {
+namespace x86 {
+
+#ifdef TENSORFLOW_USE_X86_QUANTIZED_GEMM
+
+namespace {
+
+struct GemmArgs {
+  bool transpose_a;
+  bool transpose_b;
+  const uint8* a;
+  const uint8* b;
+  int32* c;
+  int64 m;
+  int64 n;
+  int64 k;
+  int32 offset_a;
+  int32 offset_b;
+  int64 lda;
+  int64 ldb;
+  int64 ldc;
+
+  uint8 A(int64 i, int64 l) const {
+    return transpose_a ? a[l * lda + i] : a[i * lda + l];
+  }
+  uint8 B(int64 l, int64 j) const {
+    return transpose_b ? b[j * ldb + l] : b[l * ldb + j];
+  }
+};
+
+// The kernels multiply a panel of kRows rows of the lhs by a panel of kCols
+// columns of the rhs, over the whole depth. The panels are packed so that the
+// kDepth consecutive values of a row of the lhs, or of a column of the rhs,
+// that one instruction multiplies and adds are next to each other:
+// [depth / kDepth][kRows or kCols][kDepth].
+
+// vpdpbusd multiplies unsigned bytes by signed bytes, so the rhs is packed as
+// b - 128, and the lost 128 * sum(a) is added back with the offsets:
+//
+//   sum((a + offset_a) * (b + offset_b)) = sum(a * (b - 128)) +
+//       (128 + offset_b) * sum(a) + offset_a * sum(b) + k * offset_a * offset_b
+struct Avx512VnniKernel {
+  static const int kRows = 8;
+  static const int kCols = 32;
+  static const int kDepth = 4;
+  typedef uint8 LhsScalar;
+  typedef int8 RhsScalar;
+
+  static LhsScalar Lhs(const GemmArgs& args, uint8 a) { return a; }
+  static RhsScalar Rhs(const GemmArgs& args, uint8 b) {
+    return static_cast<int8>(b ^ 0x80);
+  }
+  static int32 Correction(const GemmArgs& args, int32 row_sum,
+                          int32 col_sum) {
+    return (128 + args.offset_b) * row_sum + args.offset_a * col_sum +
+           static_cast<int32>(args.k) * args.offset_a * args.offset_b;
+  }
+
+  __attribute__((target("avx512f,avx512vnni"))) static void Multiply(
+      const LhsScalar* lhs, const RhsScalar* rhs, int64 depth, int32* out) {
+    __m512i acc[kRows][2];
+    for (int r = 0; r < kRows; ++r) {
+      acc[r][0] = _mm512_setzero_si512();
+      acc[r][1] = _mm512_setzero_si512();
+    }
+    for (int64 d = 0; d < depth; d += kDepth) {
+      const __m512i b0 = _mm512_loadu_si512(rhs);
+      const __m512i b1 = _mm512_loadu_si512(rhs + 64);
+      for (int r = 0; r < kRows; ++r) {
+        int32 a;
+        memcpy(&a, lhs + r * kDepth, sizeof(a));
+        const __m512i va = _mm512_set1_epi32(a);
+        acc[r][0] = _mm512_dpbusd_epi32(acc[r][0], va, b0);
+        acc[r][1] = _mm512_dpbusd_epi32(acc[r][1], va, b1);
+      }
+      lhs += kRows * kDepth;
+      rhs += kCols * kDepth;
+    }
+    for (int r = 0; r < kRows; ++r) {
+      _mm512_storeu_si512(out + r * kCols, acc[r][0]);
+      _mm512_storeu_si512(out + r * kCols + 16, acc[r][1]);
+    }
+  }
+};
+
+// vpmaddwd multiplies pairs of 16 bit values exactly, so the offsets are
+// added to the values as they are packed.
+struct Avx2Kernel {
+  static const int kRows = 4;
+  static const int kCols = 16;
+  static const int kDepth = 2;
+  typedef int16 LhsScalar;
+  typedef int16 RhsScalar;
+
+  static LhsScalar Lhs(const GemmArgs& args, uint8 a) {
+    return static_cast<int16>(a + args.offset_a);
+  }
+  static RhsScalar Rhs(const GemmArgs& args, uint8 b) {
+    return static_cast<int16>(b + args.offset_b);
+  }
+  static int32 Correction(const GemmArgs& args, int32 row_sum,
+                          int32 col_sum) {
+    return 0;
+  }
+
+  __attribute__((target("avx2"))) static void Multiply(const LhsScalar* lhs,
+                                                       const RhsScalar* rhs,
+                                                       int64 depth,
+                                                       int32* out) {
+    __m256i acc[kRows][2];
+    for (int r = 0; r < kRows; ++r) {
+      acc[r][0] = _mm256_setzero_si256();
+      acc[r][1] = _mm256_setzero_si256();
+    }
+    for (int64 d = 0; d < depth; d += kDepth) {
+      const __m256i b0 =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs));
+      const __m256i b1 =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + 16));
+      for (int r = 0; r < kRows; ++r) {
+        int32 a;
+        memcpy(&a, lhs + r * kDepth, sizeof(a));
+        const __m256i va = _mm256_set1_epi32(a);
+        acc[r][0] = _mm256_add_epi32(acc[r][0], _mm256_madd_epi16(va, b0));
+        acc[r][1] = _mm256_add_epi32(acc[r][1], _mm256_madd_epi16(va, b1));
+      }
+      lhs += kRows * kDepth;
+      rhs += kCols * kDepth;
+    }
+    for (int r = 0; r < kRows; ++r) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + r * kCols),
+                          acc[r][0]);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + r * kCols + 8),
+                          acc[r][1]);
+    }
+  }
+};
+
+// The number of rows of the lhs that a shard packs at once, and multiplies by
+// each panel of the rhs while it is in cache.
+const int kRowPanelsPerBlock = 4;
+
+int64 PaddedDepth(int64 k, int depth) {
+  return (k + depth - 1) / depth * depth;
+}
+
+// Packs the rows [row_begin, row_begin + Kernel::kRows) of the lhs, with zeros
+// past its end, and sets "row_sums" to the sums of their values.
+template <typename Kernel>
+void PackLhs(const GemmArgs& args, int64 row_begin,
+             typename Kernel::LhsScalar* packed, int32* row_sums) {
+  const int64 depth = PaddedDepth(args.k, Kernel::kDepth);
+  for (int r = 0; r < Kernel::kRows; ++r) {
+    const int64 i = row_begin + r;
+    int32 sum = 0;
+    for (int64 l = 0; l < depth; ++l) {
+      typename Kernel::LhsScalar value = 0;
+      if (i < args.m && l < args.k) {
+        const uint8 a = args.A(i, l);
+        sum += a;
+        value = Kernel::Lhs(args, a);
+      }
+      packed[(l / Kernel::kDepth * Kernel::kRows + r) * Kernel::kDepth +
+             l % Kernel::kDepth] = value;
+    }
+    row_sums[r] = sum;
+  }
+}
+
+// Packs the columns [col_begin, col_begin + Kernel::kCols) of the rhs, with
+// zeros past its end, and sets "col_sums" to the sums of their values.
+template <typename Kernel>
+void PackRhs(const GemmArgs& args, int64 col_begin,
+             typename Kernel::RhsScalar* packed, int32* col_sums) {
+  const int64 depth = PaddedDepth(args.k, Kernel::kDepth);
+  for (int c = 0; c < Kernel::kCols; ++c) {
+    const int64 j = col_begin + c;
+    int32 sum = 0;
+    for (int64 l = 0; l < depth; ++l) {
+      typename Kernel::RhsScalar value = 0;
+      if (j < args.n && l < args.k) {
+        const uint8 b = args.B(l, j);
+        sum += b;
+        value = Kernel::Rhs(args, b);
+      }
+      packed[(l / Kernel::kDepth * Kernel::kCols + c) * Kernel::kDepth +
+             l % Kernel::kDepth] = value;
+    }
+    col_sums[c] = sum;
+  }
+}
+
+template <typename Kernel>
+void Gemm(const DeviceBase::CpuWorkerThreads& workers, const GemmArgs& args) {
+  typedef typename Kernel::LhsScalar LhsScalar;
+  typedef typename Kernel::RhsScalar RhsScalar;
+  const int kRows = Kernel::kRows;
+  const int kCols = Kernel::kCols;
+  const int64 depth = PaddedDepth(args.k, Kernel::kDepth);
+
+  const int64 num_col_panels = (args.n + kCols - 1) / kCols;
+  const int64 rhs_panel_size = depth * kCols;
+  std::vector<RhsScalar> packed_rhs(num_col_panels * rhs_panel_size);
+  std::vector<int32> col_sums(num_col_panels * kCols);
+  Shard(workers.num_threads, workers.workers, num_col_panels,
+        rhs_panel_size * 4, [&](int64 begin, int64 end) {
+          for (int64 p = begin; p < end; ++p) {
+            PackRhs<Kernel>(args, p * kCols,
+                            packed_rhs.data() + p * rhs_panel_size,
+                            col_sums.data() + p * kCols);
+          }
+        });
+
+  const int64 block_rows = kRows * kRowPanelsPerBlock;
+  const int64 num_row_blocks = (args.m + block_rows - 1) / block_rows;
+  const int64 lhs_panel_size = depth * kRows;
+  Shard(workers.num_threads, workers.workers, num_row_blocks,
+        block_rows * args.n * std::max<int64>(args.k, 1) / 16,
+        [&](int64 begin, int64 end) {
+          std::vector<LhsScalar> packed_lhs(kRowPanelsPerBlock *
+                                            lhs_panel_size);
+          std::vector<int32> row_sums(block_rows);
+          std::vector<int32> tile(kRows * kCols);
+          for (int64 block = begin; block < end; ++block) {
+            const int64 row_begin = block * block_rows;
+            const int num_row_panels = static_cast<int>(std::min<int64>(
+                kRowPanelsPerBlock, (args.m - row_begin + kRows - 1) / kRows));
+            for (int p = 0; p < num_row_panels; ++p) {
+              PackLhs<Kernel>(args, row_begin + p * kRows,
+                              packed_lhs.data() + p * lhs_panel_size,
+                              row_sums.data() + p * kRows);
+            }
+            for (int64 q = 0; q < num_col_panels; ++q) {
+              const int64 col_begin = q * kCols;
+              const int cols = static_cast<int>(
+                  std::min<int64>(kCols, args.n - col_begin));
+              for (int p = 0; p < num_row_panels; ++p) {
+                Kernel::Multiply(packed_lhs.data() + p * lhs_panel_size,
+                                 packed_rhs.data() + q * rhs_panel_size, depth,
+                                 tile.data());
+                const int64 panel_begin = row_begin + p * kRows;
+                const int rows = static_cast<int>(
+                    std::min<int64>(kRows, args.m - panel_begin));
+                for (int r = 0; r < rows; ++r) {
+                  int32* out =
+                      args.c + (panel_begin + r) * args.ldc + col_begin;
+                  const int32 row_sum = row_sums[p * kRows + r];
+                  for (int c = 0; c < cols; ++c) {
+                    out[c] = tile[r * kCols + c] +
+                             Kernel::Correction(args, row_sum,
+                                                col_sums[col_begin + c]);
+                  }
+                }
+              }
+            }
+          }
+        });
+}
+
+bool HasAvx512Vnni() {
+  static const bool has_vnni =
+      port::TestCPUFeature(port::CPUFeature::AVX512F) &&
+      port::TestCPUFeature(port::CPUFeature::AVX512_VNNI);
+  return has_vnni;
+}
+
+bool HasAvx2() {
+  static const bool has_avx2 = port::TestCPUFeature(port::CPUFeature::AVX2);
+  return has_avx2;
+}
+
+}  // namespace
+
+bool IsSupported() { return HasAvx512Vnni() || HasAvx2(); }
+
+void QuantizedGemm(const DeviceBase::CpuWorkerThreads& workers,
+                   bool transpose_a, bool transpose_b, const quint8* a_data,
+                   const quint8* b_data, qint32* c_data, int m, int n, int k,
+                   int offset_a, int offset_b, int lda, int ldb, int ldc) {
+  GemmArgs args;
+  args.transpose_a = transpose_a;
+  args.transpose_b = transpose_b;
+  args.a = &(a_data->value);
+  args.b = &(b_data->value);
+  args.c = &(c_data->value);
+  args.m = m;
+  args.n = n;
+  args.k = k;
+  args.offset_a = offset_a;
+  args.offset_b = offset_b;
+  args.lda = lda;
+  args.ldb = ldb;
+  args.ldc = ldc;
+  if (m == 0 || n == 0) return;
+  if (HasAvx512Vnni()) {
+    Gemm<Avx512VnniKernel>(workers, args);
+  } else if (HasAvx2()) {
+    Gemm<Avx2Kernel>(workers, args);
+  } else {
+    LOG(FATAL) << "x86::QuantizedGemm() called on an unsupported processor.";
+  }
+}
+
+#else
+
+bool IsSupported() { return false; }
+
+void QuantizedGemm(const DeviceBase::CpuWorkerThreads& workers,
+                   bool transpose_a, bool transpose_b, const quint8* a_data,
+                   const quint8* b_data, qint32* c_data, int m, int n, int k,
+                   int offset_a, int offset_b, int lda, int ldb, int ldc) {
+  LOG(FATAL) << "x86::QuantizedGemm() called but the binary was built "
+             << "without it.";
+}
+
+#endif  // TENSORFLOW_USE_X86_QUANTIZED_GEMM
+
+}  // namespace x86
+}  // namespace tensorflow
@@ -0,0 +1,53 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#ifndef TENSORFLOW_KERNELS_X86_QUANTIZED_GEMM_H_
+#define TENSORFLOW_KERNELS_X86_QUANTIZED_GEMM_H_
+
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/numeric_types.h"
+
+namespace tensorflow {
+namespace x86 {
+
+// Eight bit matrix multiplication for x86 processors. It uses the AVX-512 VNNI
+// dot product instructions where the processor has them, and 16 bit
+// multiply-adds with AVX2 otherwise.
+
+// Returns true if the processor supports one of the code paths, and the
+// binary was built with a compiler that can generate it. If it returns false,
+// QuantizedGemm must not be called.
+bool IsSupported();
+
+// Calculates the quantized matrix multiplication:
+//
+// for (i, j) in [0, m) x [0, n) do
+//   c_data[i, j] :=
+//     sum((a_data[i, l] + offset_a) * (b_data[l, j] + offset_b)) : l in [0, k)
+//
+// with the same conventions as meta::QuantizedGemm: if transpose_a is false
+// the lhs operand has row major layout, otherwise column major, and similarly
+// for transpose_b. lda, ldb, and ldc are the strides of the lhs operand, rhs
+// operand and the result arrays. The work is sharded over "workers".
+void QuantizedGemm(const DeviceBase::CpuWorkerThreads& workers,
+                   bool transpose_a, bool transpose_b, const quint8* a_data,
+                   const quint8* b_data, qint32* c_data, int m, int n, int k,
+                   int offset_a, int offset_b, int lda, int ldb, int ldc);
+
+}  // namespace x86
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_X86_QUANTIZED_GEMM_H_
@@ -0,0 +1,84 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/core/kernels/x86_quantized_gemm.h"
+
+#include <vector>
+
+#include "tensorflow/core/kernels/reference_gemm.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Compares x86::QuantizedGemm with ReferenceGemm on random matrices of the
+// given shape, with padded strides.
+void TestGemm(const DeviceBase::CpuWorkerThreads& workers, int m, int n,
+              int k, bool transpose_a, bool transpose_b,
+              random::SimplePhilox* rnd) {
+  const int offset_a = rnd->Uniform(256);
+  const int offset_b = rnd->Uniform(256);
+  const int lda = (transpose_a ? m : k) + 3;
+  const int ldb = (transpose_b ? k : n) + 1;
+  const int ldc = n + 2;
+  std::vector<quint8> a((transpose_a ? k : m) * lda);
+  std::vector<quint8> b((transpose_b ? n : k) * ldb);
+  for (quint8& value : a) value = rnd->Uniform(256);
+  for (quint8& value : b) value = rnd->Uniform(256);
+  std::vector<qint32> expected(m * ldc, -1);
+  std::vector<qint32> c(m * ldc, -1);
+  ReferenceGemm<quint8, quint8, qint32>(
+      transpose_a, transpose_b, false, m, n, k, a.data(), offset_a, lda,
+      b.data(), offset_b, ldb, expected.data(), 0, 0, 1, ldc);
+  x86::QuantizedGemm(workers, transpose_a, transpose_b, a.data(), b.data(),
+                     c.data(), m, n, k, -offset_a, -offset_b, lda, ldb, ldc);
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      ASSERT_EQ(expected[i * ldc + j], c[i * ldc + j])
+          << "(" << i << ", " << j << ") of " << m << "x" << k << " * " << k
+          << "x" << n << " transpose_a=" << transpose_a
+          << " transpose_b=" << transpose_b;
+    }
+  }
+}
+
+TEST(X86QuantizedGemmTest, MatchesReferenceGemm) {
+  if (!x86::IsSupported()) return;
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  DeviceBase::CpuWorkerThreads workers;
+  workers.num_threads = 4;
+  workers.workers = &pool;
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  for (bool transpose_a : {false, true}) {
+    for (bool transpose_b : {false, true}) {
+      // Sizes around the panels of the kernels, and the depths that they do
+      // not divide.
+      TestGemm(workers, 1, 1, 1, transpose_a, transpose_b, &rnd);
+      TestGemm(workers, 3, 5, 0, transpose_a, transpose_b, &rnd);
+      TestGemm(workers, 8, 32, 4, transpose_a, transpose_b, &rnd);
+      TestGemm(workers, 9, 33, 7, transpose_a, transpose_b, &rnd);
+      TestGemm(workers, 37, 17, 130, transpose_a, transpose_b, &rnd);
+      TestGemm(workers, 100, 70, 301, transpose_a, transpose_b, &rnd);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
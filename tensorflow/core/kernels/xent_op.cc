@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/cpu_xent.h"
 
 namespace tensorflow {
 
@@ -74,8 +75,8 @@ class SoftmaxXentWithLogitsOp : public OpKernel {
   }
 };
 
-// Partial specialization for a CPUDevice, that uses the Eigen implementation
-// from XentEigenImpl.
+// The Eigen implementation from XentEigenImpl, for the devices that do not
+// have kernels of their own.
 namespace functor {
 template <typename Device, typename T>
 struct XentFunctorBase {
@@ -89,8 +90,22 @@ struct XentFunctorBase {
   }
 };
 
+// Uses the fused kernels of cpu_xent.h for the types that they support.
 template <typename T>
-struct XentFunctor<CPUDevice, T> : XentFunctorBase<CPUDevice, T> {};
+struct XentFunctor<CPUDevice, T> {
+  void operator()(const CPUDevice& d, typename TTypes<T>::ConstMatrix logits,
+                  typename TTypes<T>::ConstMatrix labels,
+                  typename TTypes<T>::Matrix scratch,
+                  typename TTypes<T>::Vec loss,
+                  typename TTypes<T>::Matrix backprop) {
+    if (cpu_xent::IsSupportedType<T>::value) {
+      cpu_xent::Xent<T>(d, logits, labels, loss, backprop);
+    } else {
+      XentEigenImpl<CPUDevice, T>::Compute(d, logits, labels, scratch, loss,
+                                           backprop);
+    }
+  }
+};
 
 #ifdef TENSORFLOW_USE_SYCL
 template <typename T>
@@ -15,8 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/threadpool.h"
 
+#include <atomic>
+#include <deque>
+#include <thread>
+
 #define EIGEN_USE_THREADS
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/denormal.h"
 #include "tensorflow/core/platform/logging.h"
@@ -28,12 +34,65 @@ limitations under the License.
 namespace tensorflow {
 namespace thread {
 
+namespace {
+
+auto* queue_micros_sampler = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/thread_pool/queue_micros",
+     "Microseconds from scheduling closures to running them.", "pool"},
+    // Powers of 2 up to 2^30 microseconds.
+    monitoring::Buckets::Exponential(1, 2, 31));
+
+auto* run_micros_sampler = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/thread_pool/run_micros",
+     "Microseconds of running closures.", "pool"},
+    monitoring::Buckets::Exponential(1, 2, 31));
+
+auto* queue_depth_sampler = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/thread_pool/queue_depth",
+     "Closures scheduled but not started, when closures are scheduled.",
+     "pool"},
+    monitoring::Buckets::Exponential(1, 2, 20));
+
+auto* steals_counter = monitoring::Counter<1>::New(
+    "/tensorflow/core/thread_pool/steals",
+    "Closures scheduled by a thread of the pool and run by another one.",
+    "pool");
+
+}  // namespace
+
+// The statistics of a pool, shared by the copies of its EigenEnvironment.
+struct ThreadPoolStats {
+  explicit ThreadPoolStats(const string& name)
+      : enabled(false),
+        queued(0),
+        queue_micros(queue_micros_sampler->GetCell(name)),
+        run_micros(run_micros_sampler->GetCell(name)),
+        queue_depth(queue_depth_sampler->GetCell(name)),
+        steals(steals_counter->GetCell(name)) {}
+
+  std::atomic<bool> enabled;
+  // Tasks created but not yet executed.
+  std::atomic<int64> queued;
+  monitoring::SamplerCell* const queue_micros;
+  monitoring::SamplerCell* const run_micros;
+  monitoring::SamplerCell* const queue_depth;
+  monitoring::CounterCell* const steals;
+};
+
+// The statistics of the pool of the current thread, if any.
+static thread_local const ThreadPoolStats* current_pool_stats = nullptr;
+
 struct EigenEnvironment {
   typedef Thread EnvThread;
   struct TaskImpl {
     std::function<void()> f;
     Context context;
     uint64 trace_id;
+    // With stats: when the task was created, and whether by a thread of the
+    // pool, and which one.
+    uint64 create_micros;
+    bool created_in_pool;
+    std::thread::id creator;
   };
   struct Task {
     std::unique_ptr<TaskImpl> f;
@@ -42,17 +101,23 @@ struct EigenEnvironment {
   Env* const env_;
   const ThreadOptions thread_options_;
   const string name_;
+  const std::shared_ptr<ThreadPoolStats> stats_;
 
   EigenEnvironment(Env* env, const ThreadOptions& thread_options,
-                   const string& name)
-      : env_(env), thread_options_(thread_options), name_(name) {}
+                   const string& name, std::shared_ptr<ThreadPoolStats> stats)
+      : env_(env),
+        thread_options_(thread_options),
+        name_(name),
+        stats_(std::move(stats)) {}
 
   EnvThread* CreateThread(std::function<void()> f) {
+    const ThreadPoolStats* stats = stats_.get();
     return env_->StartThread(thread_options_, name_, [=]() {
       // Set the processor flag to flush denormals to zero.
       port::ScopedFlushDenormal flush;
       // Set the processor rounding mode to ROUND TO NEAREST.
       port::ScopedSetRound round(FE_TONEAREST);
+      current_pool_stats = stats;
       f();
     });
   }
@@ -64,14 +129,32 @@ struct EigenEnvironment {
       port::Tracing::RecordEvent(port::Tracing::EventCategory::kScheduleClosure,
                                  id);
     }
-    return Task{
+    Task task{
         std::unique_ptr<TaskImpl>(new TaskImpl{
-            std::move(f), Context(ContextKind::kThread), id,
+            std::move(f), Context(ContextKind::kThread), id, 0, false,
+            std::thread::id(),
         }),
     };
+    if (stats_->enabled) {
+      task.f->create_micros = env_->NowMicros();
+      task.f->created_in_pool = current_pool_stats == stats_.get();
+      task.f->creator = std::this_thread::get_id();
+      stats_->queue_depth->Add(stats_->queued++);
+    }
+    return task;
   }
 
   void ExecuteTask(const Task& t) {
+    uint64 start_micros = 0;
+    if (t.f->create_micros != 0) {
+      start_micros = env_->NowMicros();
+      --stats_->queued;
+      stats_->queue_micros->Add(start_micros - t.f->create_micros);
+      if (t.f->created_in_pool &&
+          t.f->creator != std::this_thread::get_id()) {
+        stats_->steals->IncrementBy(1);
+      }
+    }
     WithContext wc(t.f->context);
     if (t.f->trace_id != 0) {
       port::Tracing::ScopedActivity region(
@@ -80,15 +163,72 @@ struct EigenEnvironment {
     } else {
       t.f->f();
     }
+    if (start_micros != 0) {
+      stats_->run_micros->Add(env_->NowMicros() - start_micros);
+    }
   }
 };
 
 struct ThreadPool::Impl : Eigen::ThreadPoolTempl<EigenEnvironment> {
   Impl(Env* env, const ThreadOptions& thread_options, const string& name,
        int num_threads, bool low_latency_hint)
+      : Impl(env, thread_options, name, num_threads, low_latency_hint,
+             std::make_shared<ThreadPoolStats>(name)) {}
+
+  Impl(Env* env, const ThreadOptions& thread_options, const string& name,
+       int num_threads, bool low_latency_hint,
+       std::shared_ptr<ThreadPoolStats> stats)
       : Eigen::ThreadPoolTempl<EigenEnvironment>(
             num_threads, low_latency_hint,
-            EigenEnvironment(env, thread_options, name)) {}
+            EigenEnvironment(env, thread_options, name, stats)),
+        spin_env(env, thread_options, name, stats),
+        spin_wait_micros(0) {}
+
+  // Hands "fn" to a spinning thread, if one is waiting for work.
+  bool HandOff(std::function<void()>* fn) {
+    mutex_lock l(spin_mu);
+    if (num_spinning <= handed_off.size()) return false;
+    handed_off.push_back(spin_env.CreateTask(std::move(*fn)));
+    ++num_handed_off;
+    return true;
+  }
+
+  // Runs the functions handed off until none was within spin_wait_micros.
+  void SpinForWork() {
+    const int64 spin_micros = spin_wait_micros;
+    if (spin_micros <= 0) return;
+    Env* env = spin_env.env_;
+    {
+      mutex_lock l(spin_mu);
+      ++num_spinning;
+    }
+    uint64 deadline = env->NowMicros() + spin_micros;
+    while (true) {
+      if (num_handed_off > 0 || env->NowMicros() >= deadline) {
+        EigenEnvironment::Task task;
+        {
+          mutex_lock l(spin_mu);
+          if (handed_off.empty()) {
+            if (env->NowMicros() < deadline) continue;
+            --num_spinning;
+            return;
+          }
+          task = std::move(handed_off.front());
+          handed_off.pop_front();
+          --num_handed_off;
+          --num_spinning;
+        }
+        spin_env.ExecuteTask(task);
+        {
+          mutex_lock l(spin_mu);
+          ++num_spinning;
+        }
+        deadline = env->NowMicros() + spin_micros;
+        continue;
+      }
+      std::this_thread::yield();
+    }
+  }
 
   void ParallelFor(int64 total, int64 cost_per_unit,
                    std::function<void(int64, int64)> fn) {
@@ -99,6 +239,15 @@ struct ThreadPool::Impl : Eigen::ThreadPoolTempl<EigenEnvironment> {
         total, Eigen::TensorOpCost(0, 0, cost_per_unit),
         [&fn](Eigen::Index first, Eigen::Index last) { fn(first, last); });
   }
+
+  EigenEnvironment spin_env;
+  std::atomic<int64> spin_wait_micros;
+  mutex spin_mu;
+  // Threads spinning in SpinForWork() without a function to run.
+  size_t num_spinning GUARDED_BY(spin_mu) = 0;
+  std::deque<EigenEnvironment::Task> handed_off GUARDED_BY(spin_mu);
+  // handed_off.size(), for spinning threads to poll without the lock.
+  std::atomic<int> num_handed_off{0};
 };
 
 ThreadPool::ThreadPool(Env* env, const string& name, int num_threads)
@@ -120,9 +269,26 @@ ThreadPool::~ThreadPool() {}
 
 void ThreadPool::Schedule(std::function<void()> fn) {
   CHECK(fn != nullptr);
+  if (impl_->spin_wait_micros > 0) {
+    if (impl_->HandOff(&fn)) return;
+    Impl* impl = impl_.get();
+    impl_->Schedule([impl, fn]() {
+      fn();
+      impl->SpinForWork();
+    });
+    return;
+  }
   impl_->Schedule(std::move(fn));
 }
 
+void ThreadPool::SetSpinWaitMicros(int64 micros) {
+  impl_->spin_wait_micros = micros;
+}
+
+void ThreadPool::SetCollectStats(bool collect_stats) {
+  impl_->spin_env.stats_->enabled = collect_stats;
+}
+
 void ThreadPool::ParallelFor(int64 total, int64 cost_per_unit,
                              std::function<void(int64, int64)> fn) {
   impl_->ParallelFor(total, cost_per_unit, std::move(fn));
@@ -59,6 +59,22 @@ class ThreadPool {
   // Schedules fn() for execution in the pool of threads.
   void Schedule(std::function<void()> fn);
 
+  // If "micros" > 0, a thread that finishes a function passed to Schedule()
+  // spins, yielding the CPU, for up to "micros" microseconds, and runs the
+  // next function scheduled meanwhile, instead of going back to the pool
+  // where an idle thread must be woken up to run it.  This lowers the
+  // latency of sequences of short functions at the cost of CPU usage.
+  // Defaults to 0.
+  void SetSpinWaitMicros(int64 micros);
+
+  // If true, the closures scheduled later, including those of ParallelFor(),
+  // are measured and reported with the pool's name to the
+  // /tensorflow/core/thread_pool/{queue_micros,run_micros,queue_depth}
+  // samplers and the /tensorflow/core/thread_pool/steals counter.  Steals are
+  // closures scheduled by a thread of the pool and run by another one.
+  // Defaults to false.
+  void SetCollectStats(bool collect_stats);
+
   // ParallelFor shards the "total" units of work assuming each unit of work
   // having roughly "cost_per_unit" cost, in cycles. Each unit of work is
   // indexed 0, 1, ..., total - 1. Each shard contains 1 or more units of work
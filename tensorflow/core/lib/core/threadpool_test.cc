@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <atomic>
 
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test.h"
@@ -57,6 +58,55 @@ TEST(ThreadPool, DoWork) {
   }
 }
 
+TEST(ThreadPool, SpinWait) {
+  for (int num_threads = 1; num_threads < 5; num_threads++) {
+    fprintf(stderr, "Testing with %d threads\n", num_threads);
+    std::atomic<int> done(0);
+    // Chains of functions, each scheduling the next one, run on the
+    // spinning threads.
+    ThreadPool* pool_ptr = nullptr;
+    std::function<void(int)> chain = [&pool_ptr, &done, &chain](int n) {
+      ++done;
+      if (n > 0) pool_ptr->Schedule([&chain, n]() { chain(n - 1); });
+    };
+    {
+      ThreadPool pool(Env::Default(), "test", num_threads);
+      pool.SetSpinWaitMicros(100000);
+      pool_ptr = &pool;
+      for (int i = 0; i < 10; i++) {
+        pool.Schedule([&chain]() { chain(99); });
+      }
+      while (done < 1000) Env::Default()->SleepForMicroseconds(1000);
+    }
+    EXPECT_EQ(1000, done);
+  }
+}
+
+TEST(ThreadPool, CollectStats) {
+  {
+    // Waits for the closures when deleted.
+    ThreadPool pool(Env::Default(), "stats_test", 4);
+    pool.SetCollectStats(true);
+    for (int i = 0; i < 100; i++) {
+      pool.Schedule([]() {});
+    }
+    pool.ParallelFor(1000, 100000, [](int64 start, int64 limit) {});
+  }
+
+  std::unique_ptr<monitoring::CollectedMetrics> metrics =
+      monitoring::CollectionRegistry::Default()->CollectMetrics({});
+  const monitoring::PointSet& run_micros =
+      *metrics->point_set_map.at("/tensorflow/core/thread_pool/run_micros");
+  bool found = false;
+  for (const auto& point : run_micros.points) {
+    if (point->labels[0].value == "tf_stats_test") {
+      found = true;
+      EXPECT_LE(100, point->histogram_value.num());
+    }
+  }
+  EXPECT_TRUE(found);
+}
+
 TEST(ThreadPool, ParallelFor) {
   // Make ParallelFor use as many threads as possible.
   int64 kHugeCost = 1 << 30;
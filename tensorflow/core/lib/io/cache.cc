@@ -0,0 +1,258 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/cache.h"
+
+#include <unordered_map>
+
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace table {
+
+Cache::~Cache() {}
+
+namespace {
+
+// An entry is a variable length heap-allocated structure.  Entries
+// are kept in a circular doubly linked list ordered by access time.
+struct LRUHandle {
+  void* value;
+  void (*deleter)(const StringPiece&, void* value);
+  LRUHandle* next;
+  LRUHandle* prev;
+  size_t charge;
+  bool in_cache;  // Whether the entry is in the cache.
+  int refs;       // References, including the cache's one if in_cache.
+  string key;
+};
+
+// A single shard of sharded cache.
+class LRUCache {
+ public:
+  LRUCache() : capacity_(0), usage_(0) {
+    // Make empty circular linked list.
+    lru_.next = &lru_;
+    lru_.prev = &lru_;
+  }
+
+  ~LRUCache() {
+    for (LRUHandle* e = lru_.next; e != &lru_;) {
+      LRUHandle* next = e->next;
+      CHECK_EQ(e->refs, 1) << "Cache entry is still in use";
+      e->in_cache = false;
+      Unref(e);
+      e = next;
+    }
+  }
+
+  // Separate from constructor so caller can easily make an array of LRUCache.
+  void SetCapacity(size_t capacity) { capacity_ = capacity; }
+
+  Cache::Handle* Insert(const StringPiece& key, void* value, size_t charge,
+                        void (*deleter)(const StringPiece& key, void* value)) {
+    LRUHandle* e = new LRUHandle;
+    e->value = value;
+    e->deleter = deleter;
+    e->charge = charge;
+    e->key = key.ToString();
+    e->in_cache = true;
+    e->refs = 2;  // One from the cache, one for the returned handle.
+
+    mutex_lock l(mu_);
+    auto it = table_.find(StringPiece(e->key));
+    if (it != table_.end()) {
+      LRUHandle* old = it->second;
+      table_.erase(it);
+      FinishErase(old);
+    }
+    LRU_Append(e);
+    usage_ += charge;
+    table_.emplace(StringPiece(e->key), e);
+
+    while (usage_ > capacity_ && lru_.next != &lru_) {
+      LRUHandle* old = lru_.next;
+      table_.erase(StringPiece(old->key));
+      FinishErase(old);
+    }
+    return reinterpret_cast<Cache::Handle*>(e);
+  }
+
+  Cache::Handle* Lookup(const StringPiece& key) {
+    mutex_lock l(mu_);
+    ++lookups_;
+    auto it = table_.find(key);
+    if (it == table_.end()) return nullptr;
+    ++hits_;
+    LRUHandle* e = it->second;
+    e->refs++;
+    LRU_Remove(e);
+    LRU_Append(e);
+    return reinterpret_cast<Cache::Handle*>(e);
+  }
+
+  void Release(Cache::Handle* handle) {
+    mutex_lock l(mu_);
+    Unref(reinterpret_cast<LRUHandle*>(handle));
+  }
+
+  void Erase(const StringPiece& key) {
+    mutex_lock l(mu_);
+    auto it = table_.find(key);
+    if (it == table_.end()) return;
+    LRUHandle* e = it->second;
+    table_.erase(it);
+    FinishErase(e);
+  }
+
+  size_t TotalCharge() const {
+    mutex_lock l(mu_);
+    return usage_;
+  }
+
+  void AddStats(Cache::Stats* stats) const {
+    mutex_lock l(mu_);
+    stats->lookups += lookups_;
+    stats->hits += hits_;
+  }
+
+ private:
+  void LRU_Remove(LRUHandle* e) {
+    e->next->prev = e->prev;
+    e->prev->next = e->next;
+  }
+
+  // Makes "e" the newest entry.
+  void LRU_Append(LRUHandle* e) {
+    e->next = &lru_;
+    e->prev = lru_.prev;
+    e->prev->next = e;
+    e->next->prev = e;
+  }
+
+  void Unref(LRUHandle* e) {
+    DCHECK_GT(e->refs, 0);
+    e->refs--;
+    if (e->refs == 0) {
+      DCHECK(!e->in_cache);
+      (*e->deleter)(e->key, e->value);
+      delete e;
+    }
+  }
+
+  // Removes "e", which was just removed from table_, from the cache.
+  void FinishErase(LRUHandle* e) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    DCHECK(e->in_cache);
+    LRU_Remove(e);
+    e->in_cache = false;
+    usage_ -= e->charge;
+    Unref(e);
+  }
+
+  // Initialized before use.
+  size_t capacity_;
+
+  mutable mutex mu_;
+  size_t usage_ GUARDED_BY(mu_);
+
+  // Dummy head of LRU list.
+  // lru.prev is newest entry, lru.next is oldest entry.
+  LRUHandle lru_ GUARDED_BY(mu_);
+
+  // The entries of the cache, keyed by their own key.
+  std::unordered_map<StringPiece, LRUHandle*, StringPiece::Hasher> table_
+      GUARDED_BY(mu_);
+
+  int64 lookups_ GUARDED_BY(mu_) = 0;
+  int64 hits_ GUARDED_BY(mu_) = 0;
+};
+
+static const int kNumShardBits = 4;
+static const int kNumShards = 1 << kNumShardBits;
+
+class ShardedLRUCache : public Cache {
+ public:
+  explicit ShardedLRUCache(size_t capacity) : last_id_(0) {
+    const size_t per_shard = (capacity + (kNumShards - 1)) / kNumShards;
+    for (int s = 0; s < kNumShards; s++) {
+      shard_[s].SetCapacity(per_shard);
+    }
+  }
+
+  ~ShardedLRUCache() override {}
+
+  Handle* Insert(const StringPiece& key, void* value, size_t charge,
+                 void (*deleter)(const StringPiece& key,
+                                 void* value)) override {
+    return shard_[Shard(key)].Insert(key, value, charge, deleter);
+  }
+
+  Handle* Lookup(const StringPiece& key) override {
+    return shard_[Shard(key)].Lookup(key);
+  }
+
+  void Release(Handle* handle) override {
+    LRUHandle* h = reinterpret_cast<LRUHandle*>(handle);
+    shard_[Shard(h->key)].Release(handle);
+  }
+
+  void Erase(const StringPiece& key) override {
+    shard_[Shard(key)].Erase(key);
+  }
+
+  void* Value(Handle* handle) override {
+    return reinterpret_cast<LRUHandle*>(handle)->value;
+  }
+
+  uint64 NewId() override {
+    mutex_lock l(id_mutex_);
+    return ++(last_id_);
+  }
+
+  size_t TotalCharge() const override {
+    size_t total = 0;
+    for (int s = 0; s < kNumShards; s++) {
+      total += shard_[s].TotalCharge();
+    }
+    return total;
+  }
+
+  Stats GetStats() const override {
+    Stats stats;
+    for (int s = 0; s < kNumShards; s++) {
+      shard_[s].AddStats(&stats);
+    }
+    return stats;
+  }
+
+ private:
+  static uint32 Shard(const StringPiece& key) {
+    return Hash32(key.data(), key.size(), 0) >> (32 - kNumShardBits);
+  }
+
+  LRUCache shard_[kNumShards];
+  mutex id_mutex_;
+  uint64 last_id_ GUARDED_BY(id_mutex_);
+};
+
+}  // namespace
+
+Cache* NewLRUCache(size_t capacity) { return new ShardedLRUCache(capacity); }
+
+}  // namespace table
+}  // namespace tensorflow
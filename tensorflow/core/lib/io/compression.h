@@ -22,6 +22,7 @@ namespace compression {
 
 extern const char kNone[];
 extern const char kGzip[];
+extern const char kSnappy[];
 
 }
 }
@@ -0,0 +1,158 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/readahead_inputstream.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace io {
+
+namespace {
+
+// The reads block on storage rather than on a CPU, so the pool is sized for
+// the number of concurrent requests, not for the number of cores.
+constexpr int kNumReadaheadThreads = 32;
+
+thread::ThreadPool* ReadaheadThreadPool() {
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "readahead", kNumReadaheadThreads);
+  return pool;
+}
+
+}  // namespace
+
+ReadaheadInputStream::ReadaheadInputStream(RandomAccessFile* file,
+                                           size_t chunk_size, int num_chunks)
+    : file_(file),
+      chunk_size_(std::max<size_t>(1, chunk_size)),
+      num_chunks_(std::max(1, num_chunks)) {}
+
+ReadaheadInputStream::~ReadaheadInputStream() {
+  mutex_lock l(mu_);
+  WaitForOutstandingReadsLocked(&l);
+}
+
+void ReadaheadInputStream::WaitForOutstandingReadsLocked(mutex_lock* l) {
+  while (num_outstanding_ > 0) {
+    cond_var_.wait(*l);
+  }
+}
+
+void ReadaheadInputStream::ScheduleReadsLocked() {
+  while (!end_of_file_seen_ &&
+         chunks_.size() < static_cast<size_t>(num_chunks_)) {
+    std::shared_ptr<Chunk> chunk(new Chunk);
+    if (!free_buffers_.empty()) {
+      chunk->data.swap(free_buffers_.back());
+      free_buffers_.pop_back();
+    }
+    const uint64 offset = next_read_offset_;
+    next_read_offset_ += chunk_size_;
+    chunks_.push_back(chunk);
+    ++num_outstanding_;
+    ReadaheadThreadPool()->Schedule([this, chunk, offset]() {
+      // Only this closure touches `chunk->data` until `chunk->done` is set.
+      chunk->data.resize(chunk_size_);
+      StringPiece result;
+      Status s = file_->Read(offset, chunk_size_, &result, &chunk->data[0]);
+      if (result.data() != chunk->data.data()) {
+        // The file placed the data in some other location.
+        memmove(&chunk->data[0], result.data(), result.size());
+      }
+      chunk->data.resize(result.size());
+      if (errors::IsOutOfRange(s)) {
+        s = Status::OK();
+      }
+
+      mutex_lock l(mu_);
+      chunk->status = s;
+      chunk->done = true;
+      if (result.size() < chunk_size_) {
+        end_of_file_seen_ = true;
+      }
+      --num_outstanding_;
+      cond_var_.notify_all();
+    });
+  }
+}
+
+Status ReadaheadInputStream::ReadNBytes(int64 bytes_to_read, string* result) {
+  if (bytes_to_read < 0) {
+    return errors::InvalidArgument("Can't read a negative number of bytes: ",
+                                   bytes_to_read);
+  }
+  mutex_lock l(mu_);
+  result->clear();
+  result->reserve(bytes_to_read);
+  while (result->size() < static_cast<size_t>(bytes_to_read)) {
+    ScheduleReadsLocked();
+    if (chunks_.empty()) {
+      // All chunks up to the end of the file have been consumed.
+      break;
+    }
+    Chunk* front = chunks_.front().get();
+    while (!front->done) {
+      cond_var_.wait(l);
+    }
+    // The failed chunk stays at the front, so later reads fail too.
+    TF_RETURN_IF_ERROR(front->status);
+
+    const size_t bytes_to_copy =
+        std::min<size_t>(front->data.size() - pos_in_front_,
+                         bytes_to_read - result->size());
+    result->append(front->data, pos_in_front_, bytes_to_copy);
+    pos_in_front_ += bytes_to_copy;
+    position_ += bytes_to_copy;
+    if (pos_in_front_ == front->data.size()) {
+      free_buffers_.emplace_back();
+      free_buffers_.back().swap(front->data);
+      chunks_.pop_front();
+      pos_in_front_ = 0;
+    }
+  }
+  if (result->size() < static_cast<size_t>(bytes_to_read)) {
+    return errors::OutOfRange("reached end of file");
+  }
+  return Status::OK();
+}
+
+int64 ReadaheadInputStream::Tell() const {
+  mutex_lock l(mu_);
+  return position_;
+}
+
+Status ReadaheadInputStream::Reset() {
+  mutex_lock l(mu_);
+  WaitForOutstandingReadsLocked(&l);
+  for (const auto& chunk : chunks_) {
+    free_buffers_.emplace_back();
+    free_buffers_.back().swap(chunk->data);
+  }
+  chunks_.clear();
+  pos_in_front_ = 0;
+  next_read_offset_ = 0;
+  position_ = 0;
+  end_of_file_seen_ = false;
+  return Status::OK();
+}
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,101 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LIB_IO_READAHEAD_INPUTSTREAM_H_
+#define TENSORFLOW_LIB_IO_READAHEAD_INPUTSTREAM_H_
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace io {
+
+// Reads a file sequentially while keeping up to `num_chunks` reads of
+// `chunk_size` bytes outstanding ahead of the consumer.
+//
+// The reads are issued concurrently on a process-wide thread pool and land
+// in a ring of chunk buffers, so a consumer only waits for storage when it
+// catches up with the oldest outstanding read. This hides the latency of
+// file systems whose RandomAccessFile::Read is a remote request (e.g. a
+// range request on GCS), as long as concurrent reads of the same file are
+// supported, which RandomAccessFile requires.
+//
+// Note: this class is not thread safe; external synchronization required.
+class ReadaheadInputStream : public InputStreamInterface {
+ public:
+  // Does not take ownership of `file`, which must outlive this stream.
+  ReadaheadInputStream(RandomAccessFile* file, size_t chunk_size,
+                       int num_chunks);
+
+  // Waits for all outstanding reads.
+  ~ReadaheadInputStream() override;
+
+  Status ReadNBytes(int64 bytes_to_read, string* result) override;
+
+  int64 Tell() const override;
+
+  Status Reset() override;
+
+ private:
+  struct Chunk {
+    // Set by the read once it has completed. OUT_OF_RANGE is reported as OK
+    // with a short `data`.
+    Status status;
+    string data;
+    bool done = false;
+  };
+
+  // Issues reads until `num_chunks_` chunks are outstanding or buffered, or
+  // the end of the file has been seen.
+  void ScheduleReadsLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  void WaitForOutstandingReadsLocked(mutex_lock* l)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  RandomAccessFile* const file_;
+  const size_t chunk_size_;
+  const int num_chunks_;
+
+  mutable mutex mu_;
+  condition_variable cond_var_;
+  // Chunks in file order. The front chunk is the one being consumed.
+  std::deque<std::shared_ptr<Chunk>> chunks_ GUARDED_BY(mu_);
+  // Buffers of consumed chunks, reused by later reads.
+  std::vector<string> free_buffers_ GUARDED_BY(mu_);
+  // The number of bytes of the front chunk that have been consumed.
+  size_t pos_in_front_ GUARDED_BY(mu_) = 0;
+  // The file offset of the next chunk to read.
+  uint64 next_read_offset_ GUARDED_BY(mu_) = 0;
+  // The file offset of the next byte to be returned.
+  int64 position_ GUARDED_BY(mu_) = 0;
+  // True once a read came back short, so that nothing is read past the end
+  // of the file.
+  bool end_of_file_seen_ GUARDED_BY(mu_) = false;
+  int num_outstanding_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ReadaheadInputStream);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_LIB_IO_READAHEAD_INPUTSTREAM_H_
@@ -0,0 +1,119 @@
+/* Copyright 2016 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/readahead_inputstream.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+TEST(ReadaheadInputStream, ReadNBytes) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/readahead_inputstream_test";
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789"));
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+  for (int chunk_size : {1, 3, 4, 10, 100}) {
+    for (int num_chunks : {1, 2, 8}) {
+      string read;
+      ReadaheadInputStream in(file.get(), chunk_size, num_chunks);
+      TF_ASSERT_OK(in.ReadNBytes(3, &read));
+      EXPECT_EQ(read, "012");
+      EXPECT_EQ(3, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(0, &read));
+      EXPECT_EQ(read, "");
+      EXPECT_EQ(3, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(5, &read));
+      EXPECT_EQ(read, "34567");
+      EXPECT_EQ(8, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(20, &read)));
+      EXPECT_EQ(read, "89");
+      EXPECT_EQ(10, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+      EXPECT_EQ(read, "");
+      EXPECT_EQ(10, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(0, &read));
+      EXPECT_EQ(read, "");
+    }
+  }
+}
+
+TEST(ReadaheadInputStream, SkipNBytes) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/readahead_inputstream_test";
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789"));
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+  string read;
+  ReadaheadInputStream in(file.get(), 4, 2);
+  TF_ASSERT_OK(in.SkipNBytes(3));
+  EXPECT_EQ(3, in.Tell());
+  TF_ASSERT_OK(in.ReadNBytes(4, &read));
+  EXPECT_EQ(read, "3456");
+  EXPECT_EQ(7, in.Tell());
+  EXPECT_TRUE(errors::IsOutOfRange(in.SkipNBytes(20)));
+  EXPECT_EQ(10, in.Tell());
+}
+
+TEST(ReadaheadInputStream, Reset) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/readahead_inputstream_reset_test";
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789"));
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+  string read;
+  ReadaheadInputStream in(file.get(), 3, 4);
+  TF_ASSERT_OK(in.ReadNBytes(5, &read));
+  EXPECT_EQ(read, "01234");
+  TF_ASSERT_OK(in.Reset());
+  EXPECT_EQ(0, in.Tell());
+  TF_ASSERT_OK(in.ReadNBytes(10, &read));
+  EXPECT_EQ(read, "0123456789");
+}
+
+TEST(ReadaheadInputStream, LargeFile) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/readahead_inputstream_large_test";
+  string contents;
+  for (int i = 0; i < 100000; ++i) {
+    contents.push_back(static_cast<char>('a' + i % 26));
+  }
+  TF_ASSERT_OK(WriteStringToFile(env, fname, contents));
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+  ReadaheadInputStream in(file.get(), 1000, 16);
+  string read;
+  string all;
+  Status s = in.ReadNBytes(777, &read);
+  while (s.ok()) {
+    all.append(read);
+    s = in.ReadNBytes(777, &read);
+  }
+  EXPECT_TRUE(errors::IsOutOfRange(s));
+  all.append(read);
+  EXPECT_EQ(contents, all);
+}
+
+}  // anonymous namespace
+}  // namespace io
+}  // namespace tensorflow
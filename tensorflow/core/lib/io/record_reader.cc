@@ -17,17 +17,33 @@ limitations under the License.
 
 #include <limits.h>
 
+#include <algorithm>
+
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/lib/io/readahead_inputstream.h"
+#if !defined(IS_SLIM_BUILD)
+#include "tensorflow/core/lib/io/snappy/snappy_inputbuffer.h"
+#endif  // IS_SLIM_BUILD
 #include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
 namespace io {
 
+namespace {
+
+// The size of each read when readahead is enabled without a buffer size.
+constexpr int64 kDefaultReadaheadChunkSize = 256 << 10;
+
+const size_t kHeaderSize = sizeof(uint64) + sizeof(uint32);
+const size_t kFooterSize = sizeof(uint32);
+
+}  // namespace
+
 RecordReaderOptions RecordReaderOptions::CreateRecordReaderOptions(
     const string& compression_type) {
   RecordReaderOptions options;
@@ -46,6 +62,13 @@ RecordReaderOptions RecordReaderOptions::CreateRecordReaderOptions(
                << " No compression will be used.";
 #else
     options.zlib_options = io::ZlibCompressionOptions::GZIP();
+#endif  // IS_SLIM_BUILD
+  } else if (compression_type == compression::kSnappy) {
+#if defined(IS_SLIM_BUILD)
+    LOG(ERROR) << "Compression is not supported but compression_type is set."
+               << " No compression will be used.";
+#else
+    options.compression_type = io::RecordReaderOptions::SNAPPY_COMPRESSION;
 #endif  // IS_SLIM_BUILD
   } else if (compression_type != compression::kNone) {
     LOG(ERROR) << "Unsupported compression_type:" << compression_type
@@ -57,7 +80,13 @@ RecordReaderOptions RecordReaderOptions::CreateRecordReaderOptions(
 RecordReader::RecordReader(RandomAccessFile* file,
                            const RecordReaderOptions& options)
     : src_(file), options_(options) {
-  if (options.buffer_size > 0) {
+  if (options.num_readahead_chunks > 0) {
+    input_stream_.reset(new ReadaheadInputStream(
+        file,
+        options.buffer_size > 0 ? options.buffer_size
+                                : kDefaultReadaheadChunkSize,
+        options.num_readahead_chunks));
+  } else if (options.buffer_size > 0) {
     input_stream_.reset(new BufferedInputStream(file, options.buffer_size));
   } else {
     input_stream_.reset(new RandomAccessInputStream(file));
@@ -67,9 +96,23 @@ RecordReader::RecordReader(RandomAccessFile* file,
 #if defined(IS_SLIM_BUILD)
     LOG(FATAL) << "Zlib compression is unsupported on mobile platforms.";
 #else   // IS_SLIM_BUILD
-    zlib_input_stream_.reset(new ZlibInputStream(
+    uncompressed_input_stream_.reset(new ZlibInputStream(
         input_stream_.get(), options.zlib_options.input_buffer_size,
         options.zlib_options.output_buffer_size, options.zlib_options));
+#endif  // IS_SLIM_BUILD
+  } else if (options.compression_type ==
+             RecordReaderOptions::SNAPPY_COMPRESSION) {
+#if defined(IS_SLIM_BUILD)
+    LOG(FATAL) << "Snappy compression is unsupported on mobile platforms.";
+#else   // IS_SLIM_BUILD
+    // A block of n bytes compresses to at most 32 + n + n / 6 bytes, which
+    // follow its 4 byte length.
+    const int64 max_block_size = options.snappy_options.output_buffer_size;
+    uncompressed_input_stream_.reset(new SnappyInputBuffer(
+        file,
+        std::max(options.snappy_options.input_buffer_size,
+                 4 + 32 + max_block_size + max_block_size / 6),
+        max_block_size));
 #endif  // IS_SLIM_BUILD
   } else if (options.compression_type == RecordReaderOptions::NONE) {
     // Nothing to do.
@@ -91,15 +134,16 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n,
   storage->resize(expected);
 
 #if !defined(IS_SLIM_BUILD)
-  if (zlib_input_stream_) {
-    // If we have a zlib compressed buffer, we assume that the
+  if (uncompressed_input_stream_) {
+    // If we have a compressed buffer, we assume that the
     // file is being read sequentially, and we use the underlying
     // implementation to read the data.
     //
     // No checks are done to validate that the file is being read
-    // sequentially.  At some point the zlib input buffer may support
+    // sequentially.  At some point the compressed input buffers may support
     // seeking, possibly inefficiently.
-    TF_RETURN_IF_ERROR(zlib_input_stream_->ReadNBytes(expected, storage));
+    TF_RETURN_IF_ERROR(
+        uncompressed_input_stream_->ReadNBytes(expected, storage));
 
     if (storage->size() != expected) {
       if (storage->empty()) {
@@ -116,7 +160,7 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n,
     *result = StringPiece(storage->data(), n);
   } else {
 #endif  // IS_SLIM_BUILD
-    if (options_.buffer_size > 0) {
+    if (options_.buffer_size > 0 || options_.num_readahead_chunks > 0) {
       // If we have a buffer, we assume that the file is being read
       // sequentially, and we use the underlying implementation to read the
       // data.
@@ -164,8 +208,6 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n,
 }
 
 Status RecordReader::ReadRecord(uint64* offset, string* record) {
-  static const size_t kHeaderSize = sizeof(uint64) + sizeof(uint32);
-  static const size_t kFooterSize = sizeof(uint32);
 
   // Read header data.
   StringPiece lbuf;
@@ -196,6 +238,80 @@ Status RecordReader::ReadRecord(uint64* offset, string* record) {
   return Status::OK();
 }
 
+Status RecordReader::SkipRecord(uint64* offset) {
+  string storage;
+  StringPiece lbuf;
+  TF_RETURN_IF_ERROR(ReadChecksummed(*offset, sizeof(uint64), &lbuf, &storage));
+  const uint64 length = core::DecodeFixed64(lbuf.data());
+
+  // Advance a sequential stream past the data and its checksum. The
+  // unbuffered path reads from arbitrary offsets, so it has nothing to skip.
+  Status s;
+#if !defined(IS_SLIM_BUILD)
+  if (uncompressed_input_stream_) {
+    s = uncompressed_input_stream_->SkipNBytes(length + kFooterSize);
+  } else {
+#endif  // IS_SLIM_BUILD
+    if (options_.buffer_size > 0 || options_.num_readahead_chunks > 0) {
+      s = input_stream_->SkipNBytes(length + kFooterSize);
+    }
+#if !defined(IS_SLIM_BUILD)
+  }
+#endif  // IS_SLIM_BUILD
+  if (!s.ok()) {
+    if (errors::IsOutOfRange(s)) {
+      s = errors::DataLoss("truncated record at ", *offset);
+    }
+    return s;
+  }
+
+  *offset += kHeaderSize + length + kFooterSize;
+  return Status::OK();
+}
+
+MemoryMappedRecordReader::MemoryMappedRecordReader(
+    ReadOnlyMemoryRegion* region)
+    : data_(static_cast<const char*>(region->data())),
+      size_(region->length()) {}
+
+// Verify that the checksum of the n bytes at offset is stored in the 4 bytes
+// that follow them, and point *result at the n bytes.
+Status MemoryMappedRecordReader::ReadChecksummed(uint64 offset, uint64 n,
+                                                 StringPiece* result) {
+  if (offset >= size_) {
+    return errors::OutOfRange("eof");
+  }
+  const uint64 available = size_ - offset;
+  if (available < sizeof(uint32) || n > available - sizeof(uint32)) {
+    return errors::DataLoss("truncated record at ", offset);
+  }
+  const char* data = data_ + offset;
+  const uint32 masked_crc = core::DecodeFixed32(data + n);
+  if (crc32c::Unmask(masked_crc) != crc32c::Value(data, n)) {
+    return errors::DataLoss("corrupted record at ", offset);
+  }
+  *result = StringPiece(data, n);
+  return Status::OK();
+}
+
+Status MemoryMappedRecordReader::ReadRecord(uint64* offset,
+                                            StringPiece* record) {
+  StringPiece lbuf;
+  TF_RETURN_IF_ERROR(ReadChecksummed(*offset, sizeof(uint64), &lbuf));
+  const uint64 length = core::DecodeFixed64(lbuf.data());
+
+  Status s = ReadChecksummed(*offset + kHeaderSize, length, record);
+  if (!s.ok()) {
+    if (errors::IsOutOfRange(s)) {
+      s = errors::DataLoss("truncated record at ", *offset);
+    }
+    return s;
+  }
+
+  *offset += kHeaderSize + length + kFooterSize;
+  return Status::OK();
+}
+
 SequentialRecordReader::SequentialRecordReader(
     RandomAccessFile* file, const RecordReaderOptions& options)
     : underlying_(file, options), offset_(0) {}
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/stringpiece.h"
 #if !defined(IS_SLIM_BUILD)
 #include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/lib/io/snappy/snappy_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
 #endif  // IS_SLIM_BUILD
@@ -29,12 +30,17 @@ limitations under the License.
 namespace tensorflow {
 
 class RandomAccessFile;
+class ReadOnlyMemoryRegion;
 
 namespace io {
 
 class RecordReaderOptions {
  public:
-  enum CompressionType { NONE = 0, ZLIB_COMPRESSION = 1 };
+  enum CompressionType {
+    NONE = 0,
+    ZLIB_COMPRESSION = 1,
+    SNAPPY_COMPRESSION = 2
+  };
   CompressionType compression_type = NONE;
 
   // If buffer_size is non-zero, then all reads must be sequential, and no
@@ -42,12 +48,22 @@ class RecordReaderOptions {
   // compressed files.) Consider using SequentialRecordReader.
   int64 buffer_size = 0;
 
+  // If non-zero, the file is read sequentially by up to this many concurrent
+  // reads of `buffer_size` bytes (or 256KB if `buffer_size` is zero), which
+  // are issued ahead of the records being parsed. The same restrictions as
+  // for `buffer_size` apply.
+  int num_readahead_chunks = 0;
+
   static RecordReaderOptions CreateRecordReaderOptions(
       const string& compression_type);
 
 #if !defined(IS_SLIM_BUILD)
   // Options specific to zlib compression.
   ZlibCompressionOptions zlib_options;
+
+  // Options specific to snappy compression. The compressed file is read
+  // directly, without the buffering and readahead set above.
+  SnappyCompressionOptions snappy_options;
 #endif  // IS_SLIM_BUILD
 };
 
@@ -74,6 +90,16 @@ class RecordReader {
   // sequential.
   Status ReadRecord(uint64* offset, string* record);
 
+  // Skip the record at "*offset" and update *offset to point to the offset
+  // of the next record. Only the header of the record is read and verified,
+  // so this is much cheaper than ReadRecord() when building an index of the
+  // record offsets in a file. Returns OK on success, OUT_OF_RANGE for end of
+  // file, or something else for an error.
+  //
+  // Note: if buffering is used (with or without compression), access must be
+  // sequential.
+  Status SkipRecord(uint64* offset);
+
  private:
   Status ReadChecksummed(uint64 offset, size_t n, StringPiece* result,
                          string* storage);
@@ -82,12 +108,40 @@ class RecordReader {
   RecordReaderOptions options_;
   std::unique_ptr<InputStreamInterface> input_stream_;
 #if !defined(IS_SLIM_BUILD)
-  std::unique_ptr<ZlibInputStream> zlib_input_stream_;
+  // The uncompressed contents of a compressed file.
+  std::unique_ptr<InputStreamInterface> uncompressed_input_stream_;
 #endif  // IS_SLIM_BUILD
 
   TF_DISALLOW_COPY_AND_ASSIGN(RecordReader);
 };
 
+// Interface to read uncompressed TFRecord files that are mapped into memory.
+//
+// The records are returned as pieces of the mapping, so reading a record
+// copies nothing, and its checksum is verified on the mapped bytes.
+//
+// Note: this class is not thread safe; external synchronization required.
+class MemoryMappedRecordReader {
+ public:
+  // Create a reader that will return log records from "*region".
+  // "*region" must remain live while this Reader, or any record that it
+  // returned, is in use.
+  explicit MemoryMappedRecordReader(ReadOnlyMemoryRegion* region);
+
+  // Point *record at the record at "*offset" and update *offset to point to
+  // the offset of the next record. Returns OK on success, OUT_OF_RANGE for
+  // end of file, or something else for an error.
+  Status ReadRecord(uint64* offset, StringPiece* record);
+
+ private:
+  Status ReadChecksummed(uint64 offset, uint64 n, StringPiece* result);
+
+  const char* const data_;
+  const uint64 size_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryMappedRecordReader);
+};
+
 // High-level interface to read TFRecord files.
 //
 // Note: this class is not thread safe; external synchronization required.
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -105,4 +106,166 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestSnappy) {
+  string compressed;
+  if (!port::Snappy_Compress("abc", 3, &compressed)) {
+    fprintf(stderr, "Snappy disabled. Skipping test\n");
+    return;
+  }
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_snappy_test";
+  // Larger than most of the buffers, so that it is split into blocks.
+  const string long_record(100, 'x');
+
+  for (auto buf_size : BufferSizes()) {
+    {
+      std::unique_ptr<WritableFile> file;
+      TF_CHECK_OK(env->NewWritableFile(fname, &file));
+
+      io::RecordWriterOptions options =
+          io::RecordWriterOptions::CreateRecordWriterOptions("SNAPPY");
+      EXPECT_EQ(io::RecordWriterOptions::SNAPPY_COMPRESSION,
+                options.compression_type);
+      options.snappy_options.input_buffer_size = buf_size;
+      options.snappy_options.output_buffer_size = buf_size;
+      io::RecordWriter writer(file.get(), options);
+      TF_EXPECT_OK(writer.WriteRecord("abc"));
+      TF_EXPECT_OK(writer.WriteRecord(long_record));
+      TF_EXPECT_OK(writer.WriteRecord("defg"));
+      TF_CHECK_OK(writer.Flush());
+    }
+
+    {
+      std::unique_ptr<RandomAccessFile> read_file;
+      // Read it back with the RecordReader.
+      TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+      io::RecordReaderOptions options =
+          io::RecordReaderOptions::CreateRecordReaderOptions("SNAPPY");
+      EXPECT_EQ(io::RecordReaderOptions::SNAPPY_COMPRESSION,
+                options.compression_type);
+      options.snappy_options.input_buffer_size = buf_size;
+      options.snappy_options.output_buffer_size = buf_size;
+      io::RecordReader reader(read_file.get(), options);
+      uint64 offset = 0;
+      string record;
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ("abc", record);
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ(long_record, record);
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ("defg", record);
+      EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+    }
+  }
+}
+
+TEST(RecordReaderWriterTest, TestSkipRecord) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_skip_test";
+
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_EXPECT_OK(writer.WriteRecord("defg"));
+    TF_EXPECT_OK(writer.WriteRecord("hi"));
+    TF_CHECK_OK(writer.Flush());
+  }
+
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+
+  // Index the file sequentially with a buffered reader...
+  std::vector<uint64> offsets;
+  {
+    io::RecordReaderOptions options;
+    options.buffer_size = 5;
+    io::RecordReader reader(read_file.get(), options);
+    uint64 offset = 0;
+    Status s;
+    while (true) {
+      const uint64 record_offset = offset;
+      s = reader.SkipRecord(&offset);
+      if (!s.ok()) break;
+      offsets.push_back(record_offset);
+    }
+    EXPECT_TRUE(errors::IsOutOfRange(s)) << s;
+  }
+  ASSERT_EQ(3, offsets.size());
+
+  // ...then read the records in any order with an unbuffered one.
+  io::RecordReader reader(read_file.get());
+  string record;
+  uint64 offset = offsets[2];
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("hi", record);
+  offset = offsets[0];
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("abc", record);
+  EXPECT_EQ(offsets[1], offset);
+  TF_CHECK_OK(reader.SkipRecord(&offset));
+  EXPECT_EQ(offsets[2], offset);
+}
+
+TEST(RecordReaderWriterTest, TestMemoryMapped) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_mmap_test";
+
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_EXPECT_OK(writer.WriteRecord(""));
+    TF_EXPECT_OK(writer.WriteRecord("defg"));
+    TF_CHECK_OK(writer.Flush());
+  }
+
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  TF_CHECK_OK(env->NewReadOnlyMemoryRegionFromFile(fname, &region));
+  io::MemoryMappedRecordReader reader(region.get());
+  uint64 offset = 0;
+  StringPiece record;
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("abc", record);
+  // The record points into the mapping rather than at a copy.
+  EXPECT_GE(record.data(), static_cast<const char*>(region->data()));
+  EXPECT_LT(record.data(),
+            static_cast<const char*>(region->data()) + region->length());
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("", record);
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("defg", record);
+  EXPECT_EQ(region->length(), offset);
+  EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+}
+
+TEST(RecordReaderWriterTest, TestMemoryMappedTruncated) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_mmap_trunc_test";
+
+  string contents;
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_EXPECT_OK(writer.WriteRecord("defg"));
+    TF_CHECK_OK(writer.Flush());
+  }
+  TF_CHECK_OK(ReadFileToString(env, fname, &contents));
+  TF_CHECK_OK(WriteStringToFile(env, fname,
+                                contents.substr(0, contents.size() - 2)));
+
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  TF_CHECK_OK(env->NewReadOnlyMemoryRegionFromFile(fname, &region));
+  io::MemoryMappedRecordReader reader(region.get());
+  uint64 offset = 0;
+  StringPiece record;
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("abc", record);
+  EXPECT_TRUE(errors::IsDataLoss(reader.ReadRecord(&offset, &record)));
+}
+
 }  // namespace tensorflow
@@ -0,0 +1,42 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LIB_IO_SNAPPY_SNAPPY_COMPRESSION_OPTIONS_H_
+#define TENSORFLOW_LIB_IO_SNAPPY_SNAPPY_COMPRESSION_OPTIONS_H_
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+class SnappyCompressionOptions {
+ public:
+  // Size of the buffer used for caching the data read from source file.
+  //
+  // When compressing, this is the largest uncompressed size of a block.
+  int64 input_buffer_size = 256 << 10;
+
+  // Size of the sink buffer where the compressed/uncompressed data produced by
+  // snappy is cached.
+  //
+  // When uncompressing, this must be at least the largest uncompressed size
+  // of a block, i.e. the `input_buffer_size` used to compress the data.
+  int64 output_buffer_size = 256 << 10;
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_LIB_IO_SNAPPY_SNAPPY_COMPRESSION_OPTIONS_H_
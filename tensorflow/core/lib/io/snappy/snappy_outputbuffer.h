@@ -19,6 +19,7 @@ limitations under the License.
 #include <string>
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/types.h"
@@ -42,8 +43,9 @@ namespace io {
 // starts with a 4 byte header which stores the length (in bytes) of the
 // _compressed_ block _excluding_ this header. The compressed
 // block (excluding the 4 byte header) is a valid snappy block and can directly
-// be uncompressed using Snappy_Uncompress.
-class SnappyOutputBuffer {
+// be uncompressed using Snappy_Uncompress. The uncompressed size of a block is
+// at most `input_buffer_bytes`.
+class SnappyOutputBuffer : public WritableFile {
  public:
   // Create an SnappyOutputBuffer for `file` with two buffers that cache the
   // 1. input data to be deflated
@@ -63,9 +65,18 @@ class SnappyOutputBuffer {
   // To immediately write contents to file call `Flush()`.
   Status Write(StringPiece data);
 
+  // Same as `Write()`.
+  Status Append(const StringPiece& data) override;
+
   // Compresses any cached input and writes all output to file. This must be
   // called before the destructor to avoid any data loss.
-  Status Flush();
+  Status Flush() override;
+
+  // Same as `Flush()`. Does *not* close `file`.
+  Status Close() override;
+
+  // Flushes and then syncs `file`.
+  Status Sync() override;
 
  private:
   // Appends `data` to `input_buffer_`.
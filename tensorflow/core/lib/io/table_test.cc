@@ -17,16 +17,20 @@ limitations under the License.
 
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/block.h"
 #include "tensorflow/core/lib/io/block_builder.h"
+#include "tensorflow/core/lib/io/cache.h"
 #include "tensorflow/core/lib/io/format.h"
 #include "tensorflow/core/lib/io/iterator.h"
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/test.h"
@@ -224,6 +228,7 @@ class TableConstructor : public Constructor {
     // Open the table
     source_ = new StringSource(sink.contents());
     Options table_options;
+    table_options.block_cache = options.block_cache;
     return Table::Open(table_options, source_, sink.contents().size(), &table_);
   }
 
@@ -621,5 +626,42 @@ TEST(TableTest, SeekToFirstKeyDoesNotReadTooMuch) {
   EXPECT_LT(c.BytesRead(), 200);
 }
 
+TEST(TableTest, BlockCache) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  string tmp;
+  TableConstructor c;
+  for (int i = 0; i < 10; ++i) {
+    c.Add(strings::Printf("k%02d", i),
+          test::CompressibleString(&rnd, 0.25, 1000, &tmp));
+  }
+  std::vector<string> keys;
+  KVMap kvmap;
+  std::unique_ptr<Cache> cache(NewLRUCache(1 << 20));
+  Options options;
+  options.block_size = 100;
+  options.block_cache = cache.get();
+  c.Finish(options, &keys, &kvmap);
+
+  // The first scan reads the blocks, and the second finds them in the cache.
+  for (int scan = 0; scan < 2; ++scan) {
+    const uint64 bytes_read = c.BytesRead();
+    std::unique_ptr<Iterator> iter(c.NewIterator());
+    int num_entries = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) ++num_entries;
+    TF_EXPECT_OK(iter->status());
+    EXPECT_EQ(10, num_entries);
+    if (scan == 0) {
+      EXPECT_GT(c.BytesRead(), bytes_read);
+    } else {
+      EXPECT_EQ(bytes_read, c.BytesRead());
+    }
+  }
+  const Cache::Stats stats = cache->GetStats();
+  EXPECT_EQ(20, stats.lookups);
+  EXPECT_EQ(10, stats.hits);
+  EXPECT_GT(cache->TotalCharge(), 0);
+}
+
 }  // namespace table
 }  // namespace tensorflow
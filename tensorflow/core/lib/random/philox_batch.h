@@ -0,0 +1,243 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#ifndef TENSORFLOW_LIB_RANDOM_PHILOX_BATCH_H_
+#define TENSORFLOW_LIB_RANDOM_PHILOX_BATCH_H_
+
+// CPU-only helpers that compute the outputs of PhiloxRandom and of the
+// uniform distribution for several samples at once, with the vector
+// instructions the translation unit is compiled for. They produce exactly
+// the same bits as the scalar code.
+
+#include <string.h>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace random {
+namespace philox_batch {
+
+#if defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__)
+
+#if defined(__AVX512F__)
+struct Ops {
+  typedef __m512i V;
+  static const int kLanes = 16;
+  static V Set1(uint32 x) { return _mm512_set1_epi32(x); }
+  static V Iota() {
+    return _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1,
+                            0);
+  }
+  static V Add(V a, V b) { return _mm512_add_epi32(a, b); }
+  static V Xor(V a, V b) { return _mm512_xor_si512(a, b); }
+  static V Or(V a, V b) { return _mm512_or_si512(a, b); }
+  static V And(V a, V b) { return _mm512_and_si512(a, b); }
+  static V MulEven(V a, V b) { return _mm512_mul_epu32(a, b); }
+  static V Srl64(V a) { return _mm512_srli_epi64(a, 32); }
+  static V Sll64(V a) { return _mm512_slli_epi64(a, 32); }
+  static V Set1_64(uint64 x) { return _mm512_set1_epi64(x); }
+  static V UnpackLo32(V a, V b) { return _mm512_unpacklo_epi32(a, b); }
+  static V UnpackHi32(V a, V b) { return _mm512_unpackhi_epi32(a, b); }
+  static V UnpackLo64(V a, V b) { return _mm512_unpacklo_epi64(a, b); }
+  static V UnpackHi64(V a, V b) { return _mm512_unpackhi_epi64(a, b); }
+  // r[j] holds the samples j, j + 4, j + 8 and j + 12 in its 128-bit lanes,
+  // which are transposed across the four vectors.
+  static void Store(const V* r, uint32* output) {
+    const V u0 = _mm512_shuffle_i32x4(r[0], r[1], 0x44);
+    const V u1 = _mm512_shuffle_i32x4(r[2], r[3], 0x44);
+    const V u2 = _mm512_shuffle_i32x4(r[0], r[1], 0xee);
+    const V u3 = _mm512_shuffle_i32x4(r[2], r[3], 0xee);
+    _mm512_storeu_si512(output, _mm512_shuffle_i32x4(u0, u1, 0x88));
+    _mm512_storeu_si512(output + 16, _mm512_shuffle_i32x4(u0, u1, 0xdd));
+    _mm512_storeu_si512(output + 32, _mm512_shuffle_i32x4(u2, u3, 0x88));
+    _mm512_storeu_si512(output + 48, _mm512_shuffle_i32x4(u2, u3, 0xdd));
+  }
+  static void UniformFloats(const uint32* input, float* output) {
+    const V x = _mm512_loadu_si512(input);
+    const V bits = Or(And(x, Set1(0x7fffffu)), Set1(127u << 23));
+    _mm512_storeu_ps(output, _mm512_sub_ps(_mm512_castsi512_ps(bits),
+                                           _mm512_set1_ps(1.0f)));
+  }
+};
+#elif defined(__AVX2__)
+struct Ops {
+  typedef __m256i V;
+  static const int kLanes = 8;
+  static V Set1(uint32 x) { return _mm256_set1_epi32(x); }
+  static V Iota() { return _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0); }
+  static V Add(V a, V b) { return _mm256_add_epi32(a, b); }
+  static V Xor(V a, V b) { return _mm256_xor_si256(a, b); }
+  static V Or(V a, V b) { return _mm256_or_si256(a, b); }
+  static V And(V a, V b) { return _mm256_and_si256(a, b); }
+  static V MulEven(V a, V b) { return _mm256_mul_epu32(a, b); }
+  static V Srl64(V a) { return _mm256_srli_epi64(a, 32); }
+  static V Sll64(V a) { return _mm256_slli_epi64(a, 32); }
+  static V Set1_64(uint64 x) { return _mm256_set1_epi64x(x); }
+  static V UnpackLo32(V a, V b) { return _mm256_unpacklo_epi32(a, b); }
+  static V UnpackHi32(V a, V b) { return _mm256_unpackhi_epi32(a, b); }
+  static V UnpackLo64(V a, V b) { return _mm256_unpacklo_epi64(a, b); }
+  static V UnpackHi64(V a, V b) { return _mm256_unpackhi_epi64(a, b); }
+  // r[j] holds the samples j and j + 4.
+  static void Store(const V* r, uint32* output) {
+    V* out = reinterpret_cast<V*>(output);
+    _mm256_storeu_si256(out, _mm256_permute2x128_si256(r[0], r[1], 0x20));
+    _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(r[2], r[3], 0x20));
+    _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(r[0], r[1], 0x31));
+    _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(r[2], r[3], 0x31));
+  }
+  static void UniformFloats(const uint32* input, float* output) {
+    const V x = _mm256_loadu_si256(reinterpret_cast<const V*>(input));
+    const V bits = Or(And(x, Set1(0x7fffffu)), Set1(127u << 23));
+    _mm256_storeu_ps(output, _mm256_sub_ps(_mm256_castsi256_ps(bits),
+                                           _mm256_set1_ps(1.0f)));
+  }
+};
+#else
+struct Ops {
+  typedef __m128i V;
+  static const int kLanes = 4;
+  static V Set1(uint32 x) { return _mm_set1_epi32(x); }
+  static V Iota() { return _mm_set_epi32(3, 2, 1, 0); }
+  static V Add(V a, V b) { return _mm_add_epi32(a, b); }
+  static V Xor(V a, V b) { return _mm_xor_si128(a, b); }
+  static V Or(V a, V b) { return _mm_or_si128(a, b); }
+  static V And(V a, V b) { return _mm_and_si128(a, b); }
+  static V MulEven(V a, V b) { return _mm_mul_epu32(a, b); }
+  static V Srl64(V a) { return _mm_srli_epi64(a, 32); }
+  static V Sll64(V a) { return _mm_slli_epi64(a, 32); }
+  static V Set1_64(uint64 x) { return _mm_set1_epi64x(x); }
+  static V UnpackLo32(V a, V b) { return _mm_unpacklo_epi32(a, b); }
+  static V UnpackHi32(V a, V b) { return _mm_unpackhi_epi32(a, b); }
+  static V UnpackLo64(V a, V b) { return _mm_unpacklo_epi64(a, b); }
+  static V UnpackHi64(V a, V b) { return _mm_unpackhi_epi64(a, b); }
+  // r[j] holds the sample j.
+  static void Store(const V* r, uint32* output) {
+    V* out = reinterpret_cast<V*>(output);
+    for (int j = 0; j < 4; ++j) _mm_storeu_si128(out + j, r[j]);
+  }
+  static void UniformFloats(const uint32* input, float* output) {
+    const V x = _mm_loadu_si128(reinterpret_cast<const V*>(input));
+    const V bits = Or(And(x, Set1(0x7fffffu)), Set1(127u << 23));
+    _mm_storeu_ps(output,
+                  _mm_sub_ps(_mm_castsi128_ps(bits), _mm_set1_ps(1.0f)));
+  }
+};
+#endif
+
+// Computes the low and high 32 bits of the products of "m" with the lanes
+// of "x", with the even and the odd lanes in separate multiplications.
+inline void MultiplyHighLow(Ops::V m, Ops::V x, Ops::V* low, Ops::V* high) {
+  const Ops::V even = Ops::MulEven(x, m);
+  const Ops::V odd = Ops::MulEven(Ops::Srl64(x), m);
+  const Ops::V low_mask = Ops::Set1_64(0xffffffffull);
+  *low = Ops::Or(Ops::And(even, low_mask), Ops::Sll64(odd));
+  *high = Ops::Or(Ops::Srl64(even), Ops::And(odd, Ops::Sll64(low_mask)));
+}
+
+// Computes Ops::kLanes consecutive samples of "gen", which must not carry
+// out of the first word of the counter, into "output".
+inline void ComputeSamples(const PhiloxRandom& gen, uint32* output) {
+  const PhiloxRandom::ResultType& counter = gen.counter();
+  const Ops::V m0 = Ops::Set1(PhiloxRandom::kPhiloxM4x32A);
+  const Ops::V m1 = Ops::Set1(PhiloxRandom::kPhiloxM4x32B);
+  // The counters of the samples, one word per vector.
+  Ops::V c0 = Ops::Add(Ops::Set1(counter[0]), Ops::Iota());
+  Ops::V c1 = Ops::Set1(counter[1]);
+  Ops::V c2 = Ops::Set1(counter[2]);
+  Ops::V c3 = Ops::Set1(counter[3]);
+  uint32 key0 = gen.key()[0];
+  uint32 key1 = gen.key()[1];
+  for (int round = 0; round < 10; ++round) {
+    Ops::V lo0, hi0, lo1, hi1;
+    MultiplyHighLow(m0, c0, &lo0, &hi0);
+    MultiplyHighLow(m1, c2, &lo1, &hi1);
+    c0 = Ops::Xor(Ops::Xor(hi1, c1), Ops::Set1(key0));
+    c1 = lo1;
+    c2 = Ops::Xor(Ops::Xor(hi0, c3), Ops::Set1(key1));
+    c3 = lo0;
+    key0 += PhiloxRandom::kPhiloxW32A;
+    key1 += PhiloxRandom::kPhiloxW32B;
+  }
+  // Transposes the words of the samples within each 128-bit lane.
+  const Ops::V t0 = Ops::UnpackLo32(c0, c1);
+  const Ops::V t1 = Ops::UnpackLo32(c2, c3);
+  const Ops::V t2 = Ops::UnpackHi32(c0, c1);
+  const Ops::V t3 = Ops::UnpackHi32(c2, c3);
+  const Ops::V r[4] = {Ops::UnpackLo64(t0, t1), Ops::UnpackHi64(t0, t1),
+                       Ops::UnpackLo64(t2, t3), Ops::UnpackHi64(t2, t3)};
+  Ops::Store(r, output);
+}
+
+#endif  // defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__)
+
+}  // namespace philox_batch
+
+// Writes the next "num_samples" samples of "gen", i.e. the results of as
+// many calls of (*gen)(), to "output", which has room for 4 * num_samples
+// words, and advances "gen" past them.
+inline void FillPhiloxSamples(PhiloxRandom* gen, int64 num_samples,
+                              uint32* output) {
+#if defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__)
+  using philox_batch::Ops;
+  while (num_samples >= Ops::kLanes) {
+    // The samples whose counters carry out of the first word, once in 2^32
+    // samples, are computed by the scalar code.
+    if (gen->counter()[0] <= 0xffffffffu - (Ops::kLanes - 1)) {
+      philox_batch::ComputeSamples(*gen, output);
+      gen->Skip(Ops::kLanes);
+      output += 4 * Ops::kLanes;
+      num_samples -= Ops::kLanes;
+      continue;
+    }
+    for (int i = 0; i < Ops::kLanes; ++i) {
+      const PhiloxRandom::ResultType sample = (*gen)();
+      memcpy(output, &sample[0], sizeof(sample));
+      output += 4;
+    }
+    num_samples -= Ops::kLanes;
+  }
+#endif
+  for (; num_samples > 0; --num_samples) {
+    const PhiloxRandom::ResultType sample = (*gen)();
+    memcpy(output, &sample[0], sizeof(sample));
+    output += 4;
+  }
+}
+
+// Sets output[i] to Uint32ToFloat(input[i]) for the "size" elements.
+inline void Uint32ToFloats(const uint32* input, int64 size, float* output) {
+  int64 i = 0;
+#if defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__)
+  using philox_batch::Ops;
+  for (; i + Ops::kLanes <= size; i += Ops::kLanes) {
+    Ops::UniformFloats(input + i, output + i);
+  }
+#endif
+  for (; i < size; ++i) output[i] = Uint32ToFloat(input[i]);
+}
+
+}  // namespace random
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_LIB_RANDOM_PHILOX_BATCH_H_
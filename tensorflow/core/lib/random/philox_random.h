@@ -183,13 +183,19 @@ class PhiloxRandom {
     return counter;
   }
 
- private:
-  // We use the same constants as recommended by the original paper.
+  // The counter of the next sample, and the key of the stream.
+  PHILOX_DEVICE_INLINE const ResultType& counter() const { return counter_; }
+  PHILOX_DEVICE_INLINE const Key& key() const { return key_; }
+
+  // The constants of the rounds, the same as recommended by the original
+  // paper. They are public for FillPhiloxSamples(), which computes several
+  // samples at once.
   static const uint32 kPhiloxW32A = 0x9E3779B9;
   static const uint32 kPhiloxW32B = 0xBB67AE85;
   static const uint32 kPhiloxM4x32A = 0xD2511F53;
   static const uint32 kPhiloxM4x32B = 0xCD9E8D57;
 
+ private:
   // Helper function to skip the next sample of 128-bits in the current stream.
   PHILOX_DEVICE_INLINE void SkipOne() {
     if (++counter_[0] == 0) {
@@ -21,6 +21,7 @@ limitations under the License.
 #include <unordered_map>
 #include <vector>
 
+#include "tensorflow/core/lib/random/philox_batch.h"
 #include "tensorflow/core/lib/random/philox_random_test_utils.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
@@ -68,6 +69,43 @@ TEST(PhiloxRandomTest, SkipMatchTest) {
   }
 }
 
+// This test checks that FillPhiloxSamples() computes the same samples as the
+// generator, including those whose counters carry out of the first word.
+TEST(PhiloxRandomTest, FillSamplesMatchTest) {
+  const uint64 test_seed = GetTestSeed();
+  for (const uint32 counter_lo : {0u, 0xffffffe0u, 0xfffffff9u, 0xffffffffu}) {
+    for (const int count : {0, 1, 5, 16, 17, 100}) {
+      PhiloxRandom::ResultType counter;
+      counter[0] = counter_lo;
+      counter[1] = 0xffffffffu;
+      counter[2] = static_cast<uint32>(test_seed);
+      counter[3] = 0;
+      PhiloxRandom::Key key;
+      key[0] = static_cast<uint32>(test_seed >> 32);
+      key[1] = 12345;
+      PhiloxRandom gen1(counter, key);
+      PhiloxRandom gen2(counter, key);
+
+      std::vector<uint32> v1(4 * count);
+      FillPhiloxSamples(&gen1, count, v1.data());
+      std::vector<uint32> v2(4 * count);
+      FillRandoms<TrivialPhiloxDistribution>(gen2, v2.data(), v2.size());
+      EXPECT_EQ(v1, v2);
+      // Both generators are past the samples.
+      gen2.Skip(count);
+      const PhiloxRandom::ResultType next1 = gen1();
+      const PhiloxRandom::ResultType next2 = gen2();
+      for (int i = 0; i < 4; ++i) EXPECT_EQ(next1[i], next2[i]);
+
+      std::vector<float> f(v1.size());
+      Uint32ToFloats(v1.data(), v1.size(), f.data());
+      for (size_t i = 0; i < v1.size(); ++i) {
+        ASSERT_EQ(Uint32ToFloat(v1[i]), f[i]);
+      }
+    }
+  }
+}
+
 }  // namespace
 }  // namespace random
 }  // namespace tensorflow
@@ -1394,6 +1394,54 @@ update: A `Tensor` of rank one less than `value` if `loc` is a scalar,
 output: `value` that has been updated accordingly.
 )doc");
 
+// --------------------------------------------------------------------------
+REGISTER_OP("_ScopedAllocator")
+    .Output("output: T")
+    .Attr("shapes: list(shape)")
+    .Attr("shape: shape")
+    .Attr("T: type")
+    .Attr("id: int")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::ExplicitShape)
+    .Doc(R"doc(
+Allocates a tensor whose consecutive slices are the outputs of other nodes.
+
+The output is the backing tensor of a ScopedAllocator for the current step,
+whose fields have the shapes `shapes`. The output of another node whose
+`_scoped_allocator` attr gives it the scope id `id + 1 + i` is allocated in
+field i, if it has the size of the field.
+
+NOTE Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+
+shapes: The shapes of the fields, in the order of their offsets.
+shape: The shape of the backing tensor, with as many elements as the fields.
+id: The id of the ScopedAllocator.
+output: The backing tensor.
+)doc");
+
+REGISTER_OP("_ScopedAllocatorConcat")
+    .Input("backing: T")
+    .Input("values: N * T")
+    .Output("output: T")
+    .Attr("T: type")
+    .Attr("N: int >= 2")
+    .SetShapeFn(shape_inference::UnchangedShape)
+    .Doc(R"doc(
+Concatenates the fields of the backing tensor of a ScopedAllocator.
+
+The output is the backing tensor itself if each of `values` was allocated in
+the corresponding field of `backing`, and otherwise a copy of `values`,
+concatenated in the order of the fields.
+
+NOTE Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+
+backing: The output of a _ScopedAllocator node.
+values: The tensors allocated in the fields of `backing`.
+output: The concatenation of `values`, with the shape of `backing`.
+)doc");
+
 // --------------------------------------------------------------------------
 REGISTER_OP("Gather")
     .Input("params: Tparams")
@@ -0,0 +1,144 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+namespace tensorflow {
+
+using shape_inference::DimensionHandle;
+using shape_inference::InferenceContext;
+using shape_inference::ShapeHandle;
+
+REGISTER_OP("CollectiveAllReduce")
+    .Input("input: T")
+    .Output("data: T")
+    .Attr("T: {half, float, double, int32, int64}")
+    .Attr("reduction: {'sum', 'mean', 'min', 'max'} = 'sum'")
+    .Attr("devices: list(string) >= 1")
+    .Attr("instance_key: string")
+    .Attr("hierarchical: bool = false")
+    .Attr("subdivs: int >= 1 = 1")
+    .Attr("device_incarnations: list(int) = []")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::UnchangedShape)
+    .Doc(R"doc(
+Reduces `input` element-wise across a group of devices.
+
+One CollectiveAllReduce op runs on each of the `devices`, and each one outputs
+the reduction of the inputs of all of them. The inputs must have the same
+shape. The tensors are exchanged over the rendezvous of the step in a ring: the
+data is split into one chunk per device, and each device sends one chunk to the
+next device while it receives another chunk from the previous one, so that every
+device sends and receives about twice the size of `input` in total.
+
+input: The contribution of this device.
+data: The reduction of the inputs of all the devices.
+reduction: The reduction to apply. 'mean' divides the sum by the number of
+  devices.
+devices: The full names of the devices in the group, in ring order. They must be
+  the same for all the ops in the group.
+instance_key: A name that identifies this collective. It must be the same for
+  all the ops in the group, and different from that of any other collective
+  that runs in the same step.
+hierarchical: If true, the data is first reduced among the devices of each
+  task, then across the tasks, and then copied back to the devices of each
+  task, so that only one chunk per device crosses the network. Every task must
+  have the same number of devices in the group.
+subdivs: The number of parts of `input` that are reduced concurrently, each one
+  with its own ring, so that the transfers of one part overlap with the
+  reduction of another.
+device_incarnations: The incarnations of `devices`, which are set when the graph
+  is partitioned.
+)doc");
+
+REGISTER_OP("CollectiveAllGather")
+    .Input("input: T")
+    .Output("data: T")
+    .Attr("T: type")
+    .Attr("devices: list(string) >= 1")
+    .Attr("instance_key: string")
+    .Attr("subdivs: int >= 1 = 1")
+    .Attr("device_incarnations: list(int) = []")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle input;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &input));
+      std::vector<string> devices;
+      TF_RETURN_IF_ERROR(c->GetAttr("devices", &devices));
+      DimensionHandle dim0;
+      TF_RETURN_IF_ERROR(
+          c->Multiply(c->Dim(input, 0), static_cast<int64>(devices.size()),
+                      &dim0));
+      ShapeHandle output;
+      TF_RETURN_IF_ERROR(c->ReplaceDim(input, 0, dim0, &output));
+      c->set_output(0, output);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Concatenates `input` across a group of devices.
+
+One CollectiveAllGather op runs on each of the `devices`, and each one outputs
+the inputs of all of them, concatenated along the first dimension in the order
+of `devices`. The inputs must have the same shape. The tensors are passed around
+a ring over the rendezvous of the step.
+
+input: The contribution of this device.
+data: The inputs of all the devices.
+devices: The full names of the devices in the group, in ring order. They must be
+  the same for all the ops in the group.
+instance_key: A name that identifies this collective. It must be the same for
+  all the ops in the group, and different from that of any other collective
+  that runs in the same step.
+subdivs: The number of parts of each input that are passed around concurrently.
+device_incarnations: The incarnations of `devices`, which are set when the graph
+  is partitioned.
+)doc");
+
+REGISTER_OP("CollectiveBroadcast")
+    .Input("input: T")
+    .Output("data: T")
+    .Attr("T: type")
+    .Attr("source_rank: int >= 0")
+    .Attr("devices: list(string) >= 1")
+    .Attr("instance_key: string")
+    .Attr("subdivs: int >= 1 = 1")
+    .Attr("device_incarnations: list(int) = []")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::UnchangedShape)
+    .Doc(R"doc(
+Copies `input` from one device to a group of devices.
+
+One CollectiveBroadcast op runs on each of the `devices`, and each one outputs
+the input of the device at `source_rank`. The tensor is forwarded down a binary
+tree rooted at the source over the rendezvous of the step.
+
+input: On the source, the tensor to broadcast. On the other devices, a tensor
+  of the same shape and type, whose value is ignored.
+data: The input of the source.
+source_rank: The index of the source in `devices`.
+devices: The full names of the devices in the group. They must be the same for
+  all the ops in the group.
+instance_key: A name that identifies this collective. It must be the same for
+  all the ops in the group, and different from that of any other collective
+  that runs in the same step.
+subdivs: The number of parts of `input` that are forwarded separately, so that
+  a device can forward one part while it receives the next.
+device_incarnations: The incarnations of `devices`, which are set when the graph
+  is partitioned.
+)doc");
+
+}  // namespace tensorflow
@@ -2192,6 +2192,40 @@ container: If non-empty, this queue is placed in the given container. Otherwise,
 shared_name: It is necessary to match this name to the matching Unstage Op.
 )doc");
 
+REGISTER_OP("DeviceStage")
+    .Input("values: dtypes")
+    .Attr("capacity: int >= 0 = 0")
+    .Attr("memory_limit: int >= 0 = 0")
+    .Attr("dtypes: list(type)")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .SetShapeFn(shape_inference::UnknownShape)
+    .SetIsStateful()
+    .Doc(R"doc(
+Stage host values into device memory, similar to a lightweight Enqueue.
+
+Like Stage, but takes its inputs in host memory and copies them into a ring
+of device buffers that the op allocates once and then reuses. The copies are
+made asynchronously on the device's host-to-device stream, and values are only
+inserted once they are resident on the device, so that Unstage on the device
+can return them without waiting for a transfer. On devices without a separate
+memory space, this is the same as Stage.
+
+Values inserted by this op can be retrieved by Unstage, StagePeek, StageSize
+and StageClear ops with the same container and shared_name.
+
+values: a list of tensors
+dtypes A list of data types that inserted values should adhere to.
+capacity: Maximum number of elements in the Staging Area. If > 0, inserts
+  on the container will block when the capacity is reached. The op keeps
+  capacity + 1 device buffers, or 2 if the capacity is unbounded.
+memory_limit: The maximum number of bytes allowed for Tensors in the Staging Area.
+  If > 0, inserts will block until sufficient space is available.
+container: If non-empty, this queue is placed in the given container. Otherwise,
+  a default container is used.
+shared_name: It is necessary to match this name to the matching Unstage Op.
+)doc");
+
 REGISTER_OP("Unstage")
     .Output("values: dtypes")
     .Attr("capacity: int >= 0 = 0")
@@ -2490,6 +2524,7 @@ REGISTER_OP("RecordInput")
     .Attr("file_buffer_size: int = 10000")
     .Attr("file_parallelism: int = 16")
     .Attr("batch_size: int = 32")
+    .Attr("numa_aware: bool = false")
     .SetIsStateful()
     .SetShapeFn(shape_inference::UnknownShape)
     .Doc(R"doc(
@@ -2503,6 +2538,8 @@ file_shuffle_shift_ratio: Shifts the list of files after the list is randomly
 file_buffer_size: The randomization shuffling buffer.
 file_parallelism: How many sstables are opened and concurrently iterated over.
 batch_size: The batch size.
+numa_aware: If true, and the machine has more than one NUMA node, the reader
+    threads are spread over the nodes and pinned to them.
 )doc");
 
 }  // namespace tensorflow
@@ -181,7 +181,9 @@ Unlike a "MapDataset", which applies `f` sequentially, this dataset invokes up
 to `num_parallel_calls` copies of `f` in parallel.
 
 num_parallel_calls: The number of concurrent invocations of `f` that process
-  elements from `input_dataset` in parallel.
+  elements from `input_dataset` in parallel. If -1, each iterator starts with
+  one invocation and adds more while its consumer waits for elements, within a
+  process-wide CPU budget.
 )doc");
 
 REGISTER_OP("MapAndBatchDataset")
@@ -210,6 +212,44 @@ num_parallel_batches: A scalar representing the number of batches to create in
   stragglers.
 )doc");
 
+REGISTER_OP("ParseExampleBatchDataset")
+    .Input("input_dataset: variant")
+    .Input("batch_size: int64")
+    .Input("sparse_keys: Nsparse * string")
+    .Input("dense_keys: Ndense * string")
+    .Input("dense_defaults: Tdense")
+    .Output("handle: variant")
+    .Attr("Nsparse: int >= 0")
+    .Attr("Ndense: int >= 0")
+    .Attr("sparse_types: list({float,int64,string}) >= 0")
+    .Attr("Tdense: list({float,int64,string}) >= 0")
+    .Attr("dense_shapes: list(shape) >= 0")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that batches serialized Example protos from `input_dataset`
+and parses each batch.
+
+This is equivalent to batching `input_dataset` and applying "ParseExample" to
+each batch, but it parses the records in place, with the parallelism of the
+device's thread pool, and does not invoke a function. Each element of the
+dataset has the outputs of "ParseExample" as its components.
+
+input_dataset: A dataset whose elements are scalar strings.
+batch_size: A scalar representing the number of records to parse in each
+  batch. The last batch may be smaller.
+sparse_keys: A list of Nsparse string Tensors (scalars). The keys of the
+  sparse features.
+dense_keys: A list of Ndense string Tensors (scalars). The keys of the dense
+  features.
+dense_defaults: See the argument of the same name to "ParseExample".
+sparse_types: A list of Nsparse types; the data types of data in each
+  sparse feature.
+dense_shapes: A list of Ndense shapes; the shapes of data in each dense
+  feature. See "ParseExample".
+)doc");
+
 REGISTER_OP("PrefetchDataset")
     .Input("input_dataset: variant")
     .Input("buffer_size: int64")
@@ -221,7 +261,9 @@ REGISTER_OP("PrefetchDataset")
 Creates a dataset that asynchronously prefetches elements from `input_dataset`.
 
 buffer_size: The maximum number of elements to buffer in an iterator over
-  this dataset.
+  this dataset. If -1, each iterator starts with a buffer of one element and
+  grows it while its consumer waits for elements, within a process-wide RAM
+  budget.
 )doc");
 
 REGISTER_OP("ScanDataset")
@@ -296,6 +338,9 @@ REGISTER_OP("ParallelInterleaveDataset")
     .Attr("Targuments: list(type) >= 0")
     .Attr("output_types: list(type) >= 1")
     .Attr("output_shapes: list(shape) >= 1")
+    .Attr("buffer_output_elements: int >= 1 = 1")
+    .Attr("max_cycle_length: int >= 0 = 0")
+    .Attr("max_buffered_bytes: int >= 0 = 0")
     .SetShapeFn(shape_inference::ScalarShape)
     .Doc(R"doc(
 Creates a dataset that applies `f` to the outputs of `input_dataset`.
@@ -311,6 +356,14 @@ allows the training step to proceed so long as some data is available.
 f: A function mapping elements of `input_dataset`, concatenated with
    `other_arguments`, to a Dataset variant that contains elements matching
    `output_types` and `output_shapes`.
+buffer_output_elements: The number of elements that each input dataset may
+  produce ahead of the consumer.
+max_cycle_length: If greater than `cycle_length` and `sloppy` is true, the
+  cycle is widened by one input dataset, up to this many, whenever none of the
+  input datasets has an element ready.
+max_buffered_bytes: If non-zero, the input datasets stop producing ahead of
+  the consumer when the elements that they have produced total this many
+  bytes. Each input dataset may always buffer one element.
 )doc");
 
 REGISTER_OP("GroupByWindowDataset")
@@ -328,6 +381,7 @@ REGISTER_OP("GroupByWindowDataset")
     .Attr("Twindow_size_func_other_arguments: list(type) >= 0")
     .Attr("output_types: list(type) >= 1")
     .Attr("output_shapes: list(shape) >= 1")
+    .Attr("max_buffered_bytes: int = 0")
     .SetShapeFn(shape_inference::ScalarShape)
     .Doc(R"doc(
 Creates a dataset that computes a windowed group-by on `input_dataset`.
@@ -336,6 +390,10 @@ Creates a dataset that computes a windowed group-by on `input_dataset`.
 
 key_func: A function mapping an element of `input_dataset`, concatenated
   with `key_func_other_arguments` to a scalar value of type DT_INT64.
+max_buffered_bytes: If greater than zero, the maximum total size of the
+  elements in all open windows. When an element takes the total over this
+  limit, the window with the largest total size is passed to `reduce_func`
+  before it is full.
 )doc");
 
 REGISTER_OP("FilterDataset")
@@ -480,6 +538,8 @@ REGISTER_OP("CacheDataset")
     .Output("handle: variant")
     .Attr("output_types: list(type) >= 1")
     .Attr("output_shapes: list(shape) >= 1")
+    .Attr("memory_budget_bytes: int >= 0 = 0")
+    .Attr("num_shards: int >= 1 = 1")
     .SetShapeFn(shape_inference::ScalarShape)
     .Doc(R"doc(
 Creates a dataset that caches elements from `input_dataset`.
@@ -491,6 +551,37 @@ will the returned when used.
 
 filename: A path on the filesystem where we should cache the dataset. Note: this
   will be a directory.
+memory_budget_bytes: If `filename` is not empty, the number of bytes of
+  elements to keep in memory. Elements after the first that does not fit are
+  written to `filename`.
+num_shards: If `filename` is not empty, the number of files that elements are
+  written to, which are written and read back in parallel.
+)doc");
+
+REGISTER_OP("SnapshotDataset")
+    .Input("input_dataset: variant")
+    .Input("path: string")
+    .Input("compression_type: string")
+    .Input("num_shards: int64")
+    .Output("handle: variant")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that materializes the elements of `input_dataset` on disk.
+
+The snapshot is identified by a fingerprint of the graph that defines
+`input_dataset`. If `path` holds a complete snapshot with that fingerprint,
+its elements are read back from disk, and `input_dataset` is not evaluated.
+Otherwise the elements of `input_dataset` are produced and, once it has been
+exhausted, a new snapshot has been written. The input dataset must support
+serialization.
+
+path: A directory on the filesystem under which snapshots are written.
+compression_type: One of `""` (no compression), `"ZLIB"`, `"GZIP"`, or
+  `"SNAPPY"`.
+num_shards: The number of files that elements are written to, which are
+  written and read back in parallel.
 )doc");
 
 REGISTER_OP("TextLineDataset")
@@ -521,6 +612,7 @@ REGISTER_OP("SqlDataset")
     .Output("handle: variant")
     .Attr("output_types: list(type) >= 1")
     .Attr("output_shapes: list(shape) >= 1")
+    .Attr("batch_size: int >= 0 = 0")
     .SetIsStateful()  // TODO(b/65524810): Source dataset ops must be marked
                       // stateful to inhibit constant folding.
     .SetShapeFn(shape_inference::ScalarShape)
@@ -530,6 +622,8 @@ Creates a dataset that executes a SQL query and emits rows of the result set.
 driver_name: The database type. Currently, the only supported type is 'sqlite'.
 data_source_name: A connection string to connect to the database.
 query: A SQL query to execute.
+batch_size: If non-zero, each element holds this many consecutive rows of the
+  result set (fewer in the last element), with one vector per column.
 )doc");
 
 REGISTER_OP("FixedLengthRecordDataset")
@@ -560,6 +654,8 @@ REGISTER_OP("TFRecordDataset")
     .Input("compression_type: string")
     .Input("buffer_size: int64")
     .Output("handle: variant")
+    .Attr("num_readahead_chunks: int >= 0 = 0")
+    .Attr("use_memory_mapping: bool = false")
     .SetIsStateful()  // TODO(b/65524810): Source dataset ops must be marked
                       // stateful to inhibit constant folding.
     .SetShapeFn(shape_inference::ScalarShape)
@@ -569,9 +665,51 @@ Creates a dataset that emits the records from one or more TFRecord files.
 filenames: A scalar or vector containing the name(s) of the file(s) to be
   read.
 compression_type: A scalar containing either (i) the empty string (no
-  compression), (ii) "ZLIB", or (iii) "GZIP".
+  compression), (ii) "ZLIB", (iii) "GZIP", or (iv) "SNAPPY".
 buffer_size: A scalar representing the number of bytes to buffer. A value of
   0 means no buffering will be performed.
+num_readahead_chunks: If non-zero, each file is read by this many concurrent
+  reads of `buffer_size` bytes (or 256KB if `buffer_size` is 0), issued ahead
+  of the records being returned. This hides the latency of remote file
+  systems.
+use_memory_mapping: If true, and the files are not compressed, each file is
+  mapped into memory and the records are read from the mapping, rather than
+  copied through an intermediate buffer. Files on file systems that do not
+  support mapping are read as usual.
+)doc");
+
+REGISTER_OP("ShuffledTFRecordDataset")
+    .Input("filenames: string")
+    .Input("buffer_size: int64")
+    .Input("seed: int64")
+    .Input("seed2: int64")
+    .Output("handle: variant")
+    .Attr("reshuffle_each_iteration: bool = true")
+    .SetIsStateful()  // TODO(b/65524810): Source dataset ops must be marked
+                      // stateful to inhibit constant folding.
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that emits all records from one or more TFRecord files in a
+uniformly random order.
+
+Each iterator first indexes the files by reading only the record headers, and
+then reads each record from its offset when it is produced. Only the offsets
+are held in memory, so the shuffle spans every record in every file, at a cost
+of 16 bytes per record. The files must not be compressed.
+
+filenames: A scalar or vector containing the name(s) of the file(s) to be
+  read.
+buffer_size: A scalar representing the number of bytes to buffer while
+  indexing the files. A value of 0 means the default of 256KB.
+seed: A scalar seed for the random number generator. If either seed or
+  seed2 is set to be non-zero, the random number generator is seeded
+  by the given seed.  Otherwise, a random seed is used.
+seed2: A second scalar seed to avoid seed collision.
+reshuffle_each_iteration: If true, each iterator over this dataset will be given
+  a different pseudorandomly generated seed, based on a sequence seeded by the
+  `seed` and `seed2` inputs. If false, each iterator will be given the same
+  seed, and repeated iteration over this dataset will yield the exact same
+  sequence of results.
 )doc");
 
 REGISTER_OP("Iterator")
@@ -744,4 +882,24 @@ serialized: A variant tensor storing the state of the iterator contained in the
   resource.
 )doc");
 
+REGISTER_OP("IteratorGetStats")
+    .Input("iterator: resource")
+    .Output("summary: string")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Returns the statistics of the stages of the input pipeline of `iterator`.
+
+The first call starts collecting the statistics, so the returned values cover
+the elements produced since then. Each stage of the pipeline is identified by
+its prefix, e.g. "Iterator::Prefetch::Map", and reports "elements", "bytes",
+"self_time_us", the time spent in the stage excluding the time spent in its
+inputs on the same thread, and, for stages that buffer their elements,
+"buffer_occupancy" and "buffer_capacity".
+
+iterator: A handle to an iterator resource.
+summary: A scalar string containing a serialized `Summary` protocol buffer,
+  with one simple value tagged "<prefix>/<statistic>" for each statistic.
+)doc");
+
 }  // namespace tensorflow
@@ -495,6 +495,91 @@ crop_window: 1-D.  The crop window: [crop_y, crop_x, crop_height, crop_width].
 )doc",
                          kDecodeJpegCommonParamsDocStr));
 
+// --------------------------------------------------------------------------
+REGISTER_OP("DecodeCropAndResizeJpeg")
+    .Input("contents: string")
+    .Input("crop_window: int32")
+    .Input("size: int32")
+    .Attr("channels: int = 0")
+    .Attr("fancy_upscaling: bool = true")
+    .Attr("try_recover_truncated: bool = false")
+    .Attr("acceptable_fraction: float = 1.0")
+    .Attr("dct_method: string = ''")
+    .Attr("align_corners: bool = false")
+    .Output("image: float")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithValue(c->Dim(unused, 0), 4, &unused_dim));
+
+      int32 channels;
+      TF_RETURN_IF_ERROR(c->GetAttr("channels", &channels));
+      if (channels < 0) {
+        return errors::InvalidArgument("channels must be non-negative, got ",
+                                       channels);
+      }
+      DimensionHandle channels_dim =
+          channels == 0 ? c->UnknownDim() : c->MakeDim(channels);
+
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithValue(c->Dim(unused, 0), 2, &unused_dim));
+      DimensionHandle h = c->UnknownDim();
+      DimensionHandle w = c->UnknownDim();
+      const Tensor* size = c->input_tensor(2);
+      if (size != nullptr) {
+        auto size_vec = size->vec<int32>();
+        h = c->MakeDim(size_vec(0));
+        w = c->MakeDim(size_vec(1));
+      }
+      c->set_output(0, c->MakeShape({h, w, channels_dim}));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Decode, crop and resize a JPEG-encoded image to a float tensor.
+
+It is equivalent to a combination of `DecodeJpeg`, cropping to `crop_window`
+and `ResizeBilinear`, but much faster: only the scanlines that intersect the
+crop window are decoded, and the IDCT downscales them by a ratio of up to 8 as
+long as the result is at least as large as `size`. The bilinear resize then
+runs on this smaller image, with its sample positions mapped so that the
+result approximates resizing the full-resolution crop. If the crop window is
+less than twice `size` in either dimension, no downscaling is done during
+decoding and the result is identical to that of the separate ops.
+
+The attr `channels` indicates the desired number of color channels for the
+decoded image.
+
+Accepted values are:
+
+*   0: Use the number of channels in the JPEG-encoded image.
+*   1: output a grayscale image.
+*   3: output an RGB image.
+
+contents: 0-D.  The JPEG-encoded image.
+crop_window: 1-D.  The crop window: [crop_y, crop_x, crop_height, crop_width].
+size: A 1-D int32 Tensor of 2 elements: `new_height, new_width`.  The size of
+  the output image.
+channels: Number of color channels for the decoded image.
+fancy_upscaling: If true use a slower but nicer upscaling of the
+  chroma planes (yuv420/422 only).
+try_recover_truncated:  If true try to recover an image from truncated input.
+acceptable_fraction: The minimum required fraction of lines before a truncated
+  input is accepted.
+dct_method: string specifying a hint about the algorithm used for
+  decompression.  Defaults to "" which maps to a system-specific
+  default.  Currently valid values are ["INTEGER_FAST",
+  "INTEGER_ACCURATE"].  The hint may be ignored (e.g., the internal
+  jpeg library changes to a version that does not have that specific
+  option.)
+align_corners: If true, rescale the crop window by
+  (new_height - 1) / (crop_height - 1), which exactly aligns its 4 corners
+  with those of the output. If false, rescale by new_height / crop_height.
+  Treat similarly the width dimension.
+image: 3-D with shape `[new_height, new_width, channels]`.
+)doc");
+
 // --------------------------------------------------------------------------
 REGISTER_OP("EncodeJpeg")
     .Input("image: uint8")
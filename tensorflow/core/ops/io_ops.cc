@@ -97,12 +97,73 @@ shape_and_slices: shape {N}.  The slice specs of the tensors to be saved.
 tensors: `N` tensors to save.
 )doc");
 
+REGISTER_OP("SaveV2Async")
+    .Input("prefix: string")
+    .Input("tensor_names: string")
+    .Input("shape_and_slices: string")
+    .Input("tensors: dtypes")
+    .Attr("dtypes: list(type)")
+    .Attr("max_pending_saves: int >= 1 = 1")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      ShapeHandle s;
+      DimensionHandle unused_dim;
+
+      // Validate prefix.
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+
+      // Validate tensor_names and shapes_and_slices.
+      for (int i = 1; i <= 2; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 1, &s));
+        TF_RETURN_IF_ERROR(
+            c->WithValue(c->Dim(s, 0), c->num_inputs() - 3, &unused_dim));
+      }
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Saves tensors in V2 checkpoint format in the background.
+
+Like `SaveV2`, except that the op only copies the tensors, and a background
+thread writes the checkpoint from the copies, so the step does not wait for
+the file system.  `WaitForAsyncSaves` returns the prefixes of the completed
+checkpoints and the errors of the failed ones.
+
+prefix: Must have a single element. The prefix of the V2 checkpoint to which we
+  write the tensors.
+tensor_names: shape {N}. The names of the tensors to be saved.
+shape_and_slices: shape {N}.  The slice specs of the tensors to be saved.
+  Empty strings indicate that they are non-partitioned tensors.
+tensors: `N` tensors to save.
+max_pending_saves: The op waits until fewer than this many asynchronous saves
+  of the process are in progress, which bounds the memory of their copies.
+)doc");
+
+REGISTER_OP("WaitForAsyncSaves")
+    .Output("prefixes: string")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      c->set_output(0, c->Vector(InferenceContext::kUnknownDim));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Waits until the saves started by `SaveV2Async` ops of the process complete.
+
+Fails with the first error of the saves that failed since the last call.
+
+prefixes: The prefixes of the checkpoints written since the last call, in the
+  order in which they were completed.
+)doc");
+
 REGISTER_OP("RestoreV2")
     .Input("prefix: string")
     .Input("tensor_names: string")
     .Input("shape_and_slices: string")
     .Output("tensors: dtypes")
     .Attr("dtypes: list(type)")
+    .Attr("memory_map: bool = false")
+    .Attr("warm_up_tensors: list(string) = []")
+    .Attr("max_parallel_reads: int >= 0 = 0")
     .SetIsStateful()
     .SetShapeFn([](InferenceContext* c) {
       ShapeHandle shape0, shape1, shape2;
@@ -165,6 +226,21 @@ shape_and_slices: shape {N}.  The slice specs of the tensors to be restored.
   Empty strings indicate that they are non-partitioned tensors.
 dtypes: shape {N}.  The list of expected dtype for the tensors.  Must match
   those stored in the checkpoint.
+memory_map: If true, full tensors whose data is suitably aligned in the V2
+  checkpoint are not read, but point at the pages of the memory-mapped data
+  file, so that all readers share them through the page cache.  So are the
+  slices of full tensors that cover all but their first dimension, e.g. the
+  rows of a partitioned embedding.  Such tensors are read-only, and so are
+  variables assigned from them.  Their pages are read from the file system
+  when first accessed, so the restore is quick and the resident memory
+  follows the accessed rows.
+warm_up_tensors: The names of the memory-mapped tensors whose pages are all
+  read during the restore, so that their first accesses do not wait for the
+  file system.
+max_parallel_reads: The maximum number of tensors that are read at once, each
+  range of them with its own reader.  If 0, as many as the data files of the
+  checkpoint.  More reads than data files help on file systems with a high
+  latency per request.
 tensors: shape {N}.  The restored tensors, whose shapes are read from the
   checkpoint directly.
 )doc");
@@ -1308,6 +1308,29 @@ transpose_a: If true, "a" is transposed before multiplication.
 transpose_b: If true, "b" is transposed before multiplication.
 )doc");
 
+REGISTER_OP("_FusedMatMul")
+    .Input("a: T")
+    .Input("b: T")
+    .Input("bias: T")
+    .Output("product: T")
+    .Attr("transpose_a: bool = false")
+    .Attr("transpose_b: bool = false")
+    .Attr("T: {half, float, double}")
+    .Attr("activation: {'None', 'Relu', 'Relu6'} = 'None'")
+    .SetShapeFn(shape_inference::MatMulShape)
+    .Doc(R"doc(
+Computes MatMul followed by BiasAdd and an optional activation.
+
+The bias is added to the columns of the product, and the activation is
+applied to the result, in a single pass over the product.
+
+NOTE Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+
+bias: 1-D with the size of the columns of the product.
+activation: The activation applied after the bias.
+)doc");
+
 REGISTER_OP("SparseMatMul")
     .Input("a: Ta")
     .Input("b: Tb")
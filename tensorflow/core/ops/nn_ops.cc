@@ -556,6 +556,31 @@ data_format: Specify the data format of the input and output data. With the
         [batch, channels, height, width].
 )doc");
 
+REGISTER_OP("_FusedConv2D")
+    .Input("input: T")
+    .Input("filter: T")
+    .Input("bias: T")
+    .Output("output: T")
+    .Attr("T: {half, float}")
+    .Attr("strides: list(int)")
+    .Attr("use_cudnn_on_gpu: bool = true")
+    .Attr(GetPaddingAttrString())
+    .Attr(GetConvnetDataFormatAttrString())
+    .Attr("activation: {'None', 'Relu', 'Relu6'} = 'None'")
+    .SetShapeFn(shape_inference::Conv2DShape)
+    .Doc(R"doc(
+Computes Conv2D followed by BiasAdd and an optional activation.
+
+The bias is added to the channels of the output of the convolution, and the
+activation is applied to the result, in a single pass over the output.
+
+NOTE Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+
+bias: 1-D with the size of the channels of the output.
+activation: The activation applied after the bias.
+)doc");
+
 REGISTER_OP("Conv2DBackpropInput")
     .Input("input_sizes: int32")
     .Input("filter: T")
@@ -1253,6 +1253,52 @@ var - lr * momentum * accum, so in the end, the var you get is actually
 var - lr * momentum * accum.
 )doc");
 
+REGISTER_OP("ResourceMultiApplyMomentum")
+    .Input("var: N * resource")
+    .Input("accum: N * resource")
+    .Input("lr: T")
+    .Input("grad: N * T")
+    .Input("momentum: T")
+    .Attr("N: int >= 1")
+    .Attr("T: numbertype")
+    .Attr("use_locking: bool = false")
+    .Attr("use_nesterov: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      int n;
+      TF_RETURN_IF_ERROR(c->GetAttr("N", &n));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2 * n), 0, &unused));  // lr
+      TF_RETURN_IF_ERROR(
+          c->WithRank(c->input(3 * n + 1), 0, &unused));  // momentum
+      for (int i = 0; i < n; ++i) {
+        ShapeHandle s = ShapeOrHandleShape(c, i);  // var
+        TF_RETURN_IF_ERROR(c->Merge(s, ShapeOrHandleShape(c, n + i), &s));
+        TF_RETURN_IF_ERROR(HandleGradAndIndicesInputs(
+            c, false /* sparse */, 2 * n + 1 + i /* grad_idx */, &s));
+      }
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Update the '*var's according to the momentum scheme, like N
+ResourceApplyMomentum ops with the same lr and momentum, but in one kernel
+whose threads share the updates of all the variables.
+
+accum = accum * momentum + grad
+var -= lr * accum
+
+var: Should be from Variables.
+accum: Should be from Variables, one for each var.
+lr: Scaling factor. Must be a scalar.
+grad: The gradients, one for each var.
+momentum: Momentum. Must be a scalar.
+use_locking: If `True`, updating of the var and accum tensors will be protected
+  by a lock; otherwise the behavior is undefined, but may exhibit less
+  contention.
+use_nesterov: If `True`, the tensor passed to compute grad will be
+var - lr * momentum * accum, so in the end, the var you get is actually
+var - lr * momentum * accum.
+)doc");
+
 REGISTER_OP("ResourceSparseApplyMomentum")
     .Input("var: resource")
     .Input("accum: resource")
@@ -1428,6 +1474,64 @@ static Status ApplyCenteredRMSPropShapeFn(InferenceContext* c, bool sparse) {
   return Status::OK();
 }
 
+REGISTER_OP("ResourceMultiApplyAdam")
+    .Input("var: N * resource")
+    .Input("m: N * resource")
+    .Input("v: N * resource")
+    .Input("beta1_power: T")
+    .Input("beta2_power: T")
+    .Input("lr: T")
+    .Input("beta1: T")
+    .Input("beta2: T")
+    .Input("epsilon: T")
+    .Input("grad: N * T")
+    .Attr("N: int >= 1")
+    .Attr("T: numbertype")
+    .Attr("use_locking: bool = false")
+    .Attr("use_nesterov: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      int n;
+      TF_RETURN_IF_ERROR(c->GetAttr("N", &n));
+      ShapeHandle unused;
+      // beta1_power, beta2_power, lr, beta1, beta2 and epsilon.
+      for (int i = 3 * n; i < 3 * n + 6; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+      }
+      for (int i = 0; i < n; ++i) {
+        ShapeHandle s = ShapeOrHandleShape(c, i);  // var
+        TF_RETURN_IF_ERROR(c->Merge(s, ShapeOrHandleShape(c, n + i), &s));
+        TF_RETURN_IF_ERROR(c->Merge(s, ShapeOrHandleShape(c, 2 * n + i), &s));
+        TF_RETURN_IF_ERROR(HandleGradAndIndicesInputs(
+            c, false /* sparse */, 3 * n + 6 + i /* grad_idx */, &s));
+      }
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Update the '*var's according to the Adam algorithm, like N ResourceApplyAdam
+ops with the same scalar inputs, but in one kernel whose threads share the
+updates of all the variables.
+
+lr_t <- learning_rate * sqrt(1 - beta2^t) / (1 - beta1^t)
+m_t <- beta1 * m_{t-1} + (1 - beta1) * g_t
+v_t <- beta2 * v_{t-1} + (1 - beta2) * g_t * g_t
+variable <- variable - lr_t * m_t / (sqrt(v_t) + epsilon)
+
+var: Should be from Variables.
+m: Should be from Variables, one for each var.
+v: Should be from Variables, one for each var.
+beta1_power: Must be a scalar.
+beta2_power: Must be a scalar.
+lr: Scaling factor. Must be a scalar.
+beta1: Momentum factor. Must be a scalar.
+beta2: Momentum factor. Must be a scalar.
+epsilon: Ridge term. Must be a scalar.
+grad: The gradients, one for each var.
+use_locking: If `True`, updating of the var, m, and v tensors will be protected
+  by a lock; otherwise the behavior is undefined, but may exhibit less
+  contention.
+use_nesterov: If `True`, uses the nesterov update.
+)doc");
+
 REGISTER_OP("ApplyRMSProp")
     .Input("var: Ref(T)")
     .Input("ms: Ref(T)")
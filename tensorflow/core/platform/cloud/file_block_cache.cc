@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/platform/cloud/file_block_cache.h"
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include "tensorflow/core/platform/env.h"
@@ -108,12 +109,19 @@ Status FileBlockCache::Read(const string& filename, size_t offset, size_t n,
   if (finish < offset + n) {
     finish += block_size_;
   }
+  if (readahead_threads_) {
+    Readahead(filename, start, finish);
+  }
   // Now iterate through the blocks, reading them one at a time.
   for (size_t pos = start; pos < finish; pos += block_size_) {
     Key key = std::make_pair(filename, pos);
     // Look up the block, fetching and inserting it if necessary, and update the
     // LRU iterator for the key and block.
     std::shared_ptr<Block> block = Lookup(key);
+    if (!block && readahead_threads_) {
+      WaitForFetchAhead(key);
+      block = Lookup(key);
+    }
     if (!block) {
       Trim();
       auto fetch = std::make_shared<Block>();
@@ -152,6 +160,76 @@ Status FileBlockCache::Read(const string& filename, size_t offset, size_t n,
   return Status::OK();
 }
 
+void FileBlockCache::Readahead(const string& filename, size_t start,
+                               size_t finish) {
+  std::vector<Key> keys;
+  {
+    mutex_lock lock(mu_);
+    auto emplaced = read_states_.emplace(filename, ReadState());
+    ReadState& state = emplaced.first->second;
+    // A read is sequential if it starts in the last block of the previous
+    // read, or in the block after it.
+    const bool sequential = !emplaced.second &&
+                            start + block_size_ >= state.last_read_end &&
+                            start <= state.last_read_end;
+    state.last_read_end = finish;
+    if (!sequential) {
+      state.readahead_end = finish;
+      return;
+    }
+    const size_t end =
+        std::min(finish + readahead_blocks_ * block_size_, state.file_size);
+    for (size_t pos = std::max(finish, state.readahead_end); pos < end;
+         pos += block_size_) {
+      Key key = std::make_pair(filename, pos);
+      if (block_map_.count(key) > 0 || fetches_ahead_.count(key) > 0) {
+        continue;
+      }
+      fetches_ahead_.emplace(key, std::make_shared<Notification>());
+      keys.push_back(key);
+    }
+    state.readahead_end = std::max(state.readahead_end, end);
+  }
+  for (const Key& key : keys) {
+    readahead_threads_->Schedule([this, key]() { FetchAhead(key); });
+  }
+}
+
+void FileBlockCache::FetchAhead(const Key& key) {
+  Trim();
+  auto fetch = std::make_shared<Block>();
+  const Status status =
+      block_fetcher_(key.first, key.second, block_size_, &fetch->data);
+  // Failed and empty fetches are left to the readers, which report them.
+  if (status.ok() && !fetch->data.empty()) {
+    Insert(key, fetch);
+  }
+  mutex_lock lock(mu_);
+  if (status.ok() && fetch->data.size() < block_size_) {
+    auto state = read_states_.find(key.first);
+    if (state != read_states_.end()) {
+      state->second.file_size = std::min(state->second.file_size,
+                                         key.second + fetch->data.size());
+    }
+  }
+  auto pending = fetches_ahead_.find(key);
+  pending->second->Notify();
+  fetches_ahead_.erase(pending);
+}
+
+void FileBlockCache::WaitForFetchAhead(const Key& key) {
+  std::shared_ptr<Notification> pending;
+  {
+    mutex_lock lock(mu_);
+    auto it = fetches_ahead_.find(key);
+    if (it == fetches_ahead_.end()) {
+      return;
+    }
+    pending = it->second;
+  }
+  pending->WaitForNotification();
+}
+
 size_t FileBlockCache::CacheSize() const {
   mutex_lock lock(mu_);
   return cache_size_;
@@ -180,6 +258,7 @@ void FileBlockCache::RemoveFile(const string& filename) {
 }
 
 void FileBlockCache::RemoveFile_Locked(const string& filename) {
+  read_states_.erase(filename);
   Key begin = std::make_pair(filename, 0);
   auto it = block_map_.lower_bound(begin);
   while (it != block_map_.end() && it->first.first == filename) {
@@ -16,7 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_FILE_BLOCK_CACHE_H_
 #define TENSORFLOW_CORE_PLATFORM_CLOUD_FILE_BLOCK_CACHE_H_
 
+#include <algorithm>
 #include <functional>
+#include <limits>
 #include <list>
 #include <map>
 #include <memory>
@@ -24,6 +26,7 @@ limitations under the License.
 #include <vector>
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/notification.h"
@@ -36,6 +39,12 @@ namespace tensorflow {
 ///
 /// This class should be shared by read-only random access files on a remote
 /// filesystem (e.g. GCS).
+///
+/// If `readahead_blocks` is positive, reads that continue where the previous
+/// read of the same file ended are sequential, and the cache fetches the
+/// `readahead_blocks` blocks that follow such reads in parallel, on as many
+/// threads, so that sequential scans are not bound by the latency of each
+/// fetch.
 class FileBlockCache {
  public:
   /// The callback executed when a block is not found in the cache, and needs to
@@ -48,19 +57,31 @@ class FileBlockCache {
       BlockFetcher;
 
   FileBlockCache(size_t block_size, size_t max_bytes, uint64 max_staleness,
-                 BlockFetcher block_fetcher, Env* env = Env::Default())
+                 BlockFetcher block_fetcher, Env* env = Env::Default(),
+                 size_t readahead_blocks = 0)
       : block_size_(block_size),
         max_bytes_(max_bytes),
         max_staleness_(max_staleness),
         block_fetcher_(block_fetcher),
-        env_(env) {
+        env_(env),
+        // Leaves at least half of the cache to the blocks being read.
+        readahead_blocks_(
+            block_size == 0
+                ? 0
+                : std::min(readahead_blocks, max_bytes / 2 / block_size)) {
     if (max_staleness_ > 0) {
       pruning_thread_.reset(env_->StartThread(ThreadOptions(), "TF_prune_FBC",
                                               [this] { Prune(); }));
     }
+    if (readahead_blocks_ > 0) {
+      readahead_threads_.reset(new thread::ThreadPool(
+          env_, "TF_readahead_FBC", static_cast<int>(readahead_blocks_)));
+    }
   }
 
   ~FileBlockCache() {
+    // Destroying readahead_threads_ waits for the pending fetches.
+    readahead_threads_.reset();
     if (pruning_thread_) {
       stop_pruning_thread_.Notify();
       // Destroying pruning_thread_ will block until Prune() receives the above
@@ -93,6 +114,7 @@ class FileBlockCache {
   size_t block_size() const { return block_size_; }
   size_t max_bytes() const { return max_bytes_; }
   uint64 max_staleness() const { return max_staleness_; }
+  size_t readahead_blocks() const { return readahead_blocks_; }
 
   /// The current size (in bytes) of the cache.
   size_t CacheSize() const LOCKS_EXCLUDED(mu_);
@@ -109,6 +131,8 @@ class FileBlockCache {
   const BlockFetcher block_fetcher_;
   /// The Env from which we read timestamps.
   Env* const env_;  // not owned
+  /// The number of blocks fetched ahead of sequential reads.
+  const size_t readahead_blocks_;
 
   /// \brief The key type for the file block cache.
   ///
@@ -136,9 +160,30 @@ class FileBlockCache {
   /// The block map is an ordered map from Key to Block.
   typedef std::map<Key, std::shared_ptr<Block>> BlockMap;
 
+  /// \brief The sequential reads of a file.
+  struct ReadState {
+    /// The block-aligned end of the last read.
+    size_t last_read_end = 0;
+    /// The end of the blocks fetched or being fetched ahead of the reads.
+    size_t readahead_end = 0;
+    /// The size of the file, once a fetch has returned a partial block.
+    size_t file_size = std::numeric_limits<size_t>::max();
+  };
+
   /// Prune the cache by removing files with expired blocks.
   void Prune() LOCKS_EXCLUDED(mu_);
 
+  /// Record the read of the blocks in [`start`, `finish`) of `filename`, and
+  /// if it is sequential, fetch the blocks that follow it in the background.
+  void Readahead(const string& filename, size_t start, size_t finish)
+      LOCKS_EXCLUDED(mu_);
+
+  /// Fetch the block at `key` and insert it in the block cache.
+  void FetchAhead(const Key& key) LOCKS_EXCLUDED(mu_);
+
+  /// Wait for the readahead fetch of the block at `key`, if there is one.
+  void WaitForFetchAhead(const Key& key) LOCKS_EXCLUDED(mu_);
+
   /// Look up a Key in the block cache.
   std::shared_ptr<Block> Lookup(const Key& key) LOCKS_EXCLUDED(mu_);
 
@@ -183,6 +228,15 @@ class FileBlockCache {
 
   /// The combined number of bytes in all of the cached blocks.
   size_t cache_size_ GUARDED_BY(mu_) = 0;
+
+  /// The sequential reads of the files, if readahead is enabled.
+  std::map<string, ReadState> read_states_ GUARDED_BY(mu_);
+
+  /// The readahead fetches in progress, which notify when they finish.
+  std::map<Key, std::shared_ptr<Notification>> fetches_ahead_ GUARDED_BY(mu_);
+
+  /// Run the readahead fetches.  Null if readahead is disabled.
+  std::unique_ptr<thread::ThreadPool> readahead_threads_;
 };
 
 }  // namespace tensorflow
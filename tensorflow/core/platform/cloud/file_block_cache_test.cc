@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/platform/cloud/file_block_cache.h"
 #include <cstring>
+#include <map>
+#include <utility>
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/cloud/now_seconds_env.h"
@@ -401,6 +403,59 @@ TEST(FileBlockCacheTest, Prune) {
   EXPECT_EQ(cache.CacheSize(), 0);
 }
 
+TEST(FileBlockCacheTest, Readahead) {
+  const size_t block_size = 4;
+  const size_t file_size = 10 * block_size;
+  mutex mu;
+  std::map<std::pair<string, size_t>, int> fetches;
+  auto fetcher = [&mu, &fetches, file_size](const string& filename,
+                                             size_t offset, size_t n,
+                                             std::vector<char>* out) {
+    {
+      mutex_lock lock(mu);
+      ++fetches[std::make_pair(filename, offset)];
+    }
+    for (size_t i = offset; i < std::min(offset + n, file_size); ++i) {
+      out->push_back(static_cast<char>(i));
+    }
+    return Status::OK();
+  };
+  {
+    // Readahead is limited to half of the cache, i.e. 3 blocks.
+    FileBlockCache cache(block_size, 7 * block_size, 0, fetcher,
+                         Env::Default(), 5 /* readahead_blocks */);
+    EXPECT_EQ(3, cache.readahead_blocks());
+
+    // A sequential scan of the file fetches each block once.
+    std::vector<char> out;
+    for (size_t offset = 0; offset < file_size; offset += 2) {
+      TF_EXPECT_OK(cache.Read("a", offset, 2, &out));
+      EXPECT_EQ(std::vector<char>({static_cast<char>(offset),
+                                   static_cast<char>(offset + 1)}),
+                out);
+    }
+    EXPECT_TRUE(errors::IsOutOfRange(cache.Read("a", file_size, 2, &out)));
+
+    // Random reads are not followed by readahead.
+    TF_EXPECT_OK(cache.Read("b", 0, 2, &out));
+    TF_EXPECT_OK(cache.Read("b", 5 * block_size, 2, &out));
+  }
+  // The cache waits for the fetches in progress when it is destroyed.
+  mutex_lock lock(mu);
+  for (size_t offset = 0; offset < file_size; offset += block_size) {
+    EXPECT_EQ(1, (fetches[std::make_pair(string("a"), offset)])) << offset;
+  }
+  EXPECT_EQ(1, (fetches[std::make_pair(string("b"), 0)]));
+  EXPECT_EQ(1, (fetches[std::make_pair(string("b"), 5 * block_size)]));
+  for (const auto& fetch : fetches) {
+    if (fetch.first.first == "b") {
+      EXPECT_TRUE(fetch.first.second == 0 ||
+                  fetch.first.second == 5 * block_size)
+          << fetch.first.second;
+    }
+  }
+}
+
 TEST(FileBlockCacheTest, ParallelReads) {
   // This fetcher won't respond until either `callers` threads are calling it
   // concurrently (at which point it will respond with success to all callers),
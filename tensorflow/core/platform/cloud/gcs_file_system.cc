@@ -70,6 +70,11 @@ constexpr size_t kDefaultMaxCacheSize = 2 * kDefaultBlockSize;
 // will be evicted on the next read.
 constexpr char kMaxStaleness[] = "GCS_READ_CACHE_MAX_STALENESS";
 constexpr uint64 kDefaultMaxStaleness = 0;
+// The environment variable that overrides the number of blocks that are
+// fetched in parallel ahead of sequential reads. A value of 0 (the default)
+// disables the readahead.
+constexpr char kReadaheadBlocks[] = "GCS_READ_CACHE_READAHEAD_BLOCKS";
+constexpr size_t kDefaultReadaheadBlocks = 0;
 // The environment variable that overrides the maximum age of entries in the
 // Stat cache. A value of 0 (the default) means nothing is cached.
 constexpr char kStatCacheMaxAge[] = "GCS_STAT_CACHE_MAX_AGE";
@@ -583,6 +588,7 @@ GcsFileSystem::GcsFileSystem()
   size_t block_size = kDefaultBlockSize;
   size_t max_bytes = kDefaultMaxCacheSize;
   uint64 max_staleness = kDefaultMaxStaleness;
+  size_t readahead_blocks = kDefaultReadaheadBlocks;
   // Apply the sys env override for the readahead buffer size if it's provided.
   if (GetEnvVar(kReadaheadBufferSize, strings::safe_strtou64, &value)) {
     block_size = value;
@@ -598,7 +604,11 @@ GcsFileSystem::GcsFileSystem()
   if (GetEnvVar(kMaxStaleness, strings::safe_strtou64, &value)) {
     max_staleness = value;
   }
-  file_block_cache_ = MakeFileBlockCache(block_size, max_bytes, max_staleness);
+  if (GetEnvVar(kReadaheadBlocks, strings::safe_strtou64, &value)) {
+    readahead_blocks = value;
+  }
+  file_block_cache_ = MakeFileBlockCache(block_size, max_bytes, max_staleness,
+                                         readahead_blocks);
   // Apply overrides for the stat cache max age and max entries, if provided.
   uint64 stat_cache_max_age = kStatCacheDefaultMaxAge;
   size_t stat_cache_max_entries = kStatCacheDefaultMaxEntries;
@@ -636,7 +646,7 @@ GcsFileSystem::GcsFileSystem(
     : auth_provider_(std::move(auth_provider)),
       http_request_factory_(std::move(http_request_factory)),
       file_block_cache_(
-          MakeFileBlockCache(block_size, max_bytes, max_staleness)),
+          MakeFileBlockCache(block_size, max_bytes, max_staleness, 0)),
       stat_cache_(new StatCache(stat_cache_max_age, stat_cache_max_entries)),
       matching_paths_cache_(new MatchingPathsCache(
           matching_paths_cache_max_age, matching_paths_cache_max_entries)),
@@ -652,13 +662,15 @@ Status GcsFileSystem::NewRandomAccessFile(
 
 // A helper function to build a FileBlockCache for GcsFileSystem.
 std::unique_ptr<FileBlockCache> GcsFileSystem::MakeFileBlockCache(
-    size_t block_size, size_t max_bytes, uint64 max_staleness) {
-  std::unique_ptr<FileBlockCache> file_block_cache(
-      new FileBlockCache(block_size, max_bytes, max_staleness,
-                         [this](const string& filename, size_t offset, size_t n,
-                                std::vector<char>* out) {
-                           return LoadBufferFromGCS(filename, offset, n, out);
-                         }));
+    size_t block_size, size_t max_bytes, uint64 max_staleness,
+    size_t readahead_blocks) {
+  std::unique_ptr<FileBlockCache> file_block_cache(new FileBlockCache(
+      block_size, max_bytes, max_staleness,
+      [this](const string& filename, size_t offset, size_t n,
+             std::vector<char>* out) {
+        return LoadBufferFromGCS(filename, offset, n, out);
+      },
+      Env::Default(), readahead_blocks));
   return file_block_cache;
 }
 
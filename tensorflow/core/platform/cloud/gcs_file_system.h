@@ -132,7 +132,8 @@ class GcsFileSystem : public FileSystem {
 
   std::unique_ptr<FileBlockCache> MakeFileBlockCache(size_t block_size,
                                                      size_t max_bytes,
-                                                     uint64 max_staleness);
+                                                     uint64 max_staleness,
+                                                     size_t readahead_blocks);
 
   /// Loads file contents from GCS for a given filename, offset, and length.
   Status LoadBufferFromGCS(const string& filename, size_t offset, size_t n,
@@ -88,6 +88,7 @@ enum CPUFeature {
   AVX512IFMA = 35,     // Integer multiply-add
   AVX512_4VNNIW = 36,  // Integer neural network
   AVX512_4FMAPS = 37,  // Floating point neural network
+  AVX512_VNNI = 38,    // Integer dot products (vpdpbusd, etc.)
 };
 
 // Checks whether the current processor supports one of the features above.
@@ -19,6 +19,8 @@ limitations under the License.
 
 #include <stdlib.h>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
@@ -114,8 +116,11 @@ class CUPTIClient {
  public:
   virtual ~CUPTIClient() {}
 
-  // Invoked for each CUPTI activity reported.
-  virtual void ActivityCallback(const CUpti_Activity &activity) = 0;
+  // Invoked with the activities of each buffer completed by CUPTI, on the
+  // thread CUPTI delivers the buffer on.  The records are only valid for the
+  // duration of the call.
+  virtual void ActivityCallback(
+      const std::vector<const CUpti_Activity *> &activities) = 0;
 };
 
 #define CUPTI_CALL(call)                                            \
@@ -136,8 +141,9 @@ class CUPTIManager {
 
   // Enables tracing and delivers event callbacks to 'client'.
   // Does not take ownership of client.  Client's lifetime must persist
-  // until tracing is disabled.
-  Status EnableTrace(CUPTIClient *client);
+  // until tracing is disabled.  If 'kernels_only', memcpy and memset
+  // activities are not recorded.
+  Status EnableTrace(CUPTIClient *client, bool kernels_only);
 
   // Disable tracing.  No further events will be delivered to 'client'.
   Status DisableTrace();
@@ -159,19 +165,37 @@ class CUPTIManager {
   void InternalBufferCompleted(CUcontext ctx, uint32_t streamId,
                                uint8_t *buffer, size_t size, size_t validSize);
 
-  // Size of buffers used for CUPTI tracing.
-  static constexpr size_t kBufferSize = 32 * 1024;
+  // Size of buffers used for CUPTI tracing.  Larger buffers mean fewer
+  // BufferRequested/BufferCompleted round trips while tracing.
+  static constexpr size_t kBufferSize = 1024 * 1024;
   // Required alignment of CUPTI buffers.
   static constexpr size_t kBufferAlignment = 8;
+  // Number of buffers allocated up front when tracing is enabled, and the
+  // most that are kept for reuse once CUPTI hands them back.
+  static constexpr size_t kNumPreallocatedBuffers = 4;
+  static constexpr size_t kMaxFreeBuffers = 16;
 
   mutex mu_;
   CUPTIClient *client_ GUARDED_BY(mu_);
+
+  // Buffers that CUPTI has handed back, to be reused by BufferRequested.
+  // Separate from mu_ since CUPTI may request a buffer while another one is
+  // being processed by BufferCompleted.
+  mutex buffers_mu_;
+  std::vector<uint8_t *> free_buffers_ GUARDED_BY(buffers_mu_);
   std::unique_ptr<perftools::gputools::profiler::CuptiWrapper> cupti_wrapper_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(CUPTIManager);
 };
 
-Status CUPTIManager::EnableTrace(CUPTIClient *client) {
+Status CUPTIManager::EnableTrace(CUPTIClient *client, bool kernels_only) {
+  {
+    mutex_lock l(buffers_mu_);
+    while (free_buffers_.size() < kNumPreallocatedBuffers) {
+      free_buffers_.push_back(reinterpret_cast<uint8_t *>(
+          port::AlignedMalloc(kBufferSize, kBufferAlignment)));
+    }
+  }
   mutex_lock l(mu_);
   // TODO(pbar) Work out the minimal set to trace.
   // We can currently manage without driver/runtime tracing.
@@ -184,9 +208,11 @@ Status CUPTIManager::EnableTrace(CUPTIClient *client) {
 
   CUPTI_CALL(ActivityEnable(CUPTI_ACTIVITY_KIND_DEVICE));
   CUPTI_CALL(ActivityEnable(CUPTI_ACTIVITY_KIND_KERNEL));
-  CUPTI_CALL(ActivityEnable(CUPTI_ACTIVITY_KIND_MEMCPY));
-  CUPTI_CALL(ActivityEnable(CUPTI_ACTIVITY_KIND_MEMCPY2));
-  CUPTI_CALL(ActivityEnable(CUPTI_ACTIVITY_KIND_MEMSET));
+  if (!kernels_only) {
+    CUPTI_CALL(ActivityEnable(CUPTI_ACTIVITY_KIND_MEMCPY));
+    CUPTI_CALL(ActivityEnable(CUPTI_ACTIVITY_KIND_MEMCPY2));
+    CUPTI_CALL(ActivityEnable(CUPTI_ACTIVITY_KIND_MEMSET));
+  }
   CUPTI_CALL(ActivityEnable(CUPTI_ACTIVITY_KIND_OVERHEAD));
   client_ = client;
   return Status::OK();
@@ -218,9 +244,20 @@ Status CUPTIManager::DisableTrace() {
 void CUPTIManager::InternalBufferRequested(uint8_t **buffer, size_t *size,
                                            size_t *maxNumRecords) {
   VLOG(2) << "BufferRequested";
-  void *p = port::AlignedMalloc(kBufferSize, kBufferAlignment);
+  uint8_t *p = nullptr;
+  {
+    mutex_lock l(buffers_mu_);
+    if (!free_buffers_.empty()) {
+      p = free_buffers_.back();
+      free_buffers_.pop_back();
+    }
+  }
+  if (p == nullptr) {
+    p = reinterpret_cast<uint8_t *>(
+        port::AlignedMalloc(kBufferSize, kBufferAlignment));
+  }
   *size = kBufferSize;
-  *buffer = reinterpret_cast<uint8_t *>(p);
+  *buffer = p;
   *maxNumRecords = 0;
 }
 
@@ -228,19 +265,15 @@ void CUPTIManager::InternalBufferCompleted(CUcontext ctx, uint32_t streamId,
                                            uint8_t *buffer, size_t size,
                                            size_t validSize) {
   VLOG(2) << "BufferCompleted";
-  CUptiResult status;
   CUpti_Activity *record = nullptr;
   mutex_lock l(mu_);  // Hold mu_ while using client_.
   if (client_ && validSize > 0) {
-    do {
-      status =
-          cupti_wrapper_->ActivityGetNextRecord(buffer, validSize, &record);
-      if (status == CUPTI_SUCCESS) {
-        client_->ActivityCallback(*record);
-      } else {
-        break;
-      }
-    } while (1);
+    std::vector<const CUpti_Activity *> activities;
+    while (cupti_wrapper_->ActivityGetNextRecord(buffer, validSize, &record) ==
+           CUPTI_SUCCESS) {
+      activities.push_back(record);
+    }
+    client_->ActivityCallback(activities);
 
     // report any records dropped from the queue
     size_t dropped;
@@ -249,6 +282,13 @@ void CUPTIManager::InternalBufferCompleted(CUcontext ctx, uint32_t streamId,
       LOG(WARNING) << "Dropped " << dropped << " activity records";
     }
   }
+  {
+    mutex_lock l2(buffers_mu_);
+    if (free_buffers_.size() < kMaxFreeBuffers) {
+      free_buffers_.push_back(buffer);
+      return;
+    }
+  }
   port::AlignedFree(buffer);
 }
 
@@ -290,7 +330,7 @@ class GPUTracerImpl : public GPUTracer,
                       public CUPTIClient,
                       public port::Tracing::Engine {
  public:
-  GPUTracerImpl();
+  explicit GPUTracerImpl(const GPUTracerOptions &options);
   ~GPUTracerImpl() override;
 
   // GPUTracer interface:
@@ -326,7 +366,8 @@ class GPUTracerImpl : public GPUTracer,
  protected:
   // This callback is used exclusively by CUPTIManager.
   friend class CUPTIManager;
-  void ActivityCallback(const CUpti_Activity &activity) override;
+  void ActivityCallback(
+      const std::vector<const CUpti_Activity *> &activities) override;
 
  private:
   // Internal struct to record kernel launches.
@@ -356,18 +397,31 @@ class GPUTracerImpl : public GPUTracer,
                                    CUpti_CallbackId cbid, const void *cbdata);
 
   // Records the mapping between correlation ID and kernel name.
-  void AddCorrelationId(uint32 correlation_id, const string &name);
+  void AddCorrelationId(uint32 correlation_id, const char *name);
+
+  // Records one activity.
+  void AddActivity(const CUpti_Activity &record)
+      EXCLUSIVE_LOCKS_REQUIRED(trace_mu_);
 
   // Returns the current system time in microseconds.
   inline int64 NowInUsec() { return Env::Default()->NowMicros(); }
 
+  const GPUTracerOptions options_;
   CUPTIManager *cupti_manager_;
   std::unique_ptr<perftools::gputools::profiler::CuptiWrapper> cupti_wrapper_;
   CUpti_SubscriberHandle subscriber_;
 
-  mutex trace_mu_;
   static constexpr size_t kMaxRecords = 1024 * 1024;
-  std::map<uint32, string> correlations_ GUARDED_BY(trace_mu_);
+  // Number of records the containers below are sized for up front, so that
+  // a typical step does not reallocate them while tracing.
+  static constexpr size_t kInitialRecords = 16 * 1024;
+
+  // Written on the threads launching kernels, so kept apart from the
+  // activity records that CUPTI delivers on its own thread.
+  mutex correlation_mu_;
+  std::unordered_map<uint32, string> correlations_ GUARDED_BY(correlation_mu_);
+
+  mutex trace_mu_;
   std::vector<KernelRecord> kernel_records_ GUARDED_BY(trace_mu_);
   std::vector<MemcpyRecord> memcpy_records_ GUARDED_BY(trace_mu_);
 
@@ -381,7 +435,8 @@ class GPUTracerImpl : public GPUTracer,
   TF_DISALLOW_COPY_AND_ASSIGN(GPUTracerImpl);
 };
 
-GPUTracerImpl::GPUTracerImpl() {
+GPUTracerImpl::GPUTracerImpl(const GPUTracerOptions &options)
+    : options_(options) {
   VLOG(1) << "GPUTracer created.";
   cupti_manager_ = GetCUPTIManager();
   CHECK(cupti_manager_);
@@ -415,38 +470,52 @@ Status GPUTracerImpl::Start() {
   // Register as a TraceEngine to receive ScopedAnnotations.
   port::Tracing::RegisterEngine(this);
 
+  {
+    mutex_lock l2(correlation_mu_);
+    correlations_.reserve(kInitialRecords);
+  }
+  {
+    mutex_lock l2(trace_mu_);
+    kernel_records_.reserve(kInitialRecords);
+    if (!options_.kernels_only) {
+      memcpy_records_.reserve(kInitialRecords);
+    }
+  }
+
   // Intercept launch and memcpy calls to capture the Op name annotation.
   // TODO(pbar) Add callbacks for memcpy variants.
   CUPTI_CALL(EnableCallback(/*enable=*/1, subscriber_,
                             CUPTI_CB_DOMAIN_DRIVER_API,
                             CUPTI_DRIVER_TRACE_CBID_cuLaunchKernel));
-  CUPTI_CALL(EnableCallback(/*enable=*/1, subscriber_,
-                            CUPTI_CB_DOMAIN_RUNTIME_API,
-                            CUPTI_RUNTIME_TRACE_CBID_cudaMemcpy_v3020));
-  CUPTI_CALL(EnableCallback(
-      /*enable=*/1, subscriber_, CUPTI_CB_DOMAIN_RUNTIME_API,
-      CUPTI_RUNTIME_TRACE_CBID_cudaMemcpyAsync_v3020));
-
-  CUPTI_CALL(EnableCallback(/*enable=*/1, subscriber_,
-                            CUPTI_CB_DOMAIN_DRIVER_API,
-                            CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoH_v2));
-  CUPTI_CALL(EnableCallback(/*enable=*/1, subscriber_,
-                            CUPTI_CB_DOMAIN_DRIVER_API,
-                            CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoHAsync_v2));
-  CUPTI_CALL(EnableCallback(/*enable=*/1, subscriber_,
-                            CUPTI_CB_DOMAIN_DRIVER_API,
-                            CUPTI_DRIVER_TRACE_CBID_cuMemcpyHtoD_v2));
-  CUPTI_CALL(EnableCallback(/*enable=*/1, subscriber_,
-                            CUPTI_CB_DOMAIN_DRIVER_API,
-                            CUPTI_DRIVER_TRACE_CBID_cuMemcpyHtoDAsync_v2));
-  CUPTI_CALL(EnableCallback(/*enable=*/1, subscriber_,
-                            CUPTI_CB_DOMAIN_DRIVER_API,
-                            CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoD_v2));
-  CUPTI_CALL(EnableCallback(/*enable=*/1, subscriber_,
-                            CUPTI_CB_DOMAIN_DRIVER_API,
-                            CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoDAsync_v2));
+  if (!options_.kernels_only) {
+    CUPTI_CALL(EnableCallback(/*enable=*/1, subscriber_,
+                              CUPTI_CB_DOMAIN_RUNTIME_API,
+                              CUPTI_RUNTIME_TRACE_CBID_cudaMemcpy_v3020));
+    CUPTI_CALL(EnableCallback(
+        /*enable=*/1, subscriber_, CUPTI_CB_DOMAIN_RUNTIME_API,
+        CUPTI_RUNTIME_TRACE_CBID_cudaMemcpyAsync_v3020));
+
+    CUPTI_CALL(EnableCallback(/*enable=*/1, subscriber_,
+                              CUPTI_CB_DOMAIN_DRIVER_API,
+                              CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoH_v2));
+    CUPTI_CALL(EnableCallback(/*enable=*/1, subscriber_,
+                              CUPTI_CB_DOMAIN_DRIVER_API,
+                              CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoHAsync_v2));
+    CUPTI_CALL(EnableCallback(/*enable=*/1, subscriber_,
+                              CUPTI_CB_DOMAIN_DRIVER_API,
+                              CUPTI_DRIVER_TRACE_CBID_cuMemcpyHtoD_v2));
+    CUPTI_CALL(EnableCallback(/*enable=*/1, subscriber_,
+                              CUPTI_CB_DOMAIN_DRIVER_API,
+                              CUPTI_DRIVER_TRACE_CBID_cuMemcpyHtoDAsync_v2));
+    CUPTI_CALL(EnableCallback(/*enable=*/1, subscriber_,
+                              CUPTI_CB_DOMAIN_DRIVER_API,
+                              CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoD_v2));
+    CUPTI_CALL(EnableCallback(/*enable=*/1, subscriber_,
+                              CUPTI_CB_DOMAIN_DRIVER_API,
+                              CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoDAsync_v2));
+  }
 
-  TF_RETURN_IF_ERROR(cupti_manager_->EnableTrace(this));
+  TF_RETURN_IF_ERROR(cupti_manager_->EnableTrace(this, options_.kernels_only));
 
   CUPTI_CALL(GetTimestamp(&start_timestamp_));
   start_walltime_us_ = NowInUsec();
@@ -470,9 +539,9 @@ Status GPUTracerImpl::Stop() {
 }
 
 void GPUTracerImpl::AddCorrelationId(uint32 correlation_id,
-                                     const string &name) {
+                                     const char *name) {
   VLOG(2) << correlation_id << " : " << name;
-  mutex_lock l(trace_mu_);
+  mutex_lock l(correlation_mu_);
   if (correlations_.size() >= kMaxRecords) return;
   correlations_.emplace(correlation_id, name);
 }
@@ -500,9 +569,9 @@ void GPUTracerImpl::AddCorrelationId(uint32 correlation_id,
         VLOG(2) << "LAUNCH stream " << params->hStream << " correllation "
                 << cbInfo->correlationId << " kernel " << cbInfo->symbolName;
       }
-      const string annotation =
-          tls_annotation ? tls_annotation : cbInfo->symbolName;
-      tracer->AddCorrelationId(cbInfo->correlationId, annotation);
+      tracer->AddCorrelationId(
+          cbInfo->correlationId,
+          tls_annotation ? tls_annotation : cbInfo->symbolName);
     }
   } else if ((domain == CUPTI_CB_DOMAIN_RUNTIME_API) &&
              (cbid == CUPTI_RUNTIME_TRACE_CBID_cudaMemcpy_v3020 ||
@@ -516,8 +585,7 @@ void GPUTracerImpl::AddCorrelationId(uint32 correlation_id,
         VLOG(2) << "MEMCPY count " << count << " kind " << kind;
       }
       if (tls_annotation) {
-        const string annotation = tls_annotation;
-        tracer->AddCorrelationId(cbInfo->correlationId, annotation);
+        tracer->AddCorrelationId(cbInfo->correlationId, tls_annotation);
       }
     }
   } else if ((domain == CUPTI_CB_DOMAIN_DRIVER_API) &&
@@ -528,17 +596,23 @@ void GPUTracerImpl::AddCorrelationId(uint32 correlation_id,
               cbid == CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoHAsync_v2 ||
               cbid == CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoDAsync_v2)) {
     if (cbInfo->callbackSite == CUPTI_API_EXIT && tls_annotation) {
-      const string annotation = tls_annotation;
-      tracer->AddCorrelationId(cbInfo->correlationId, annotation);
+      tracer->AddCorrelationId(cbInfo->correlationId, tls_annotation);
     }
   } else {
     VLOG(1) << "Unhandled API Callback for " << domain << " " << cbid;
   }
 }
 
-void GPUTracerImpl::ActivityCallback(const CUpti_Activity &record) {
-  VLOG(2) << "ActivityCallback " << record.kind;
+void GPUTracerImpl::ActivityCallback(
+    const std::vector<const CUpti_Activity *> &activities) {
+  VLOG(2) << "ActivityCallback " << activities.size() << " records";
   mutex_lock l(trace_mu_);
+  for (const CUpti_Activity *record : activities) {
+    AddActivity(*record);
+  }
+}
+
+void GPUTracerImpl::AddActivity(const CUpti_Activity &record) {
   switch (record.kind) {
     case CUPTI_ACTIVITY_KIND_MEMCPY: {
       if (memcpy_records_.size() >= kMaxRecords) return;
@@ -586,6 +660,7 @@ Status GPUTracerImpl::Collect(StepStatsCollector *collector) {
   const string memcpy_device = strings::StrCat(prefix, "/device:GPU:", id, "/memcpy");
 
   mutex_lock l2(trace_mu_);
+  mutex_lock l3(correlation_mu_);
   for (const auto &rec : kernel_records_) {
     auto it = correlations_.find(rec.correlation_id);
     const string name = (it != correlations_.cend()) ? it->second : "unknown";
@@ -636,7 +711,11 @@ Status GPUTracerImpl::Collect(StepStatsCollector *collector) {
 }  // namespace gputracer
 
 std::unique_ptr<GPUTracer> CreateGPUTracer() {
-  std::unique_ptr<GPUTracer> tracer(new gputracer::GPUTracerImpl());
+  return CreateGPUTracer(GPUTracerOptions());
+}
+
+std::unique_ptr<GPUTracer> CreateGPUTracer(const GPUTracerOptions &options) {
+  std::unique_ptr<GPUTracer> tracer(new gputracer::GPUTracerImpl(options));
   return tracer;
 }
 
@@ -648,6 +727,10 @@ namespace tensorflow {
 
 std::unique_ptr<GPUTracer> CreateGPUTracer() { return nullptr; }
 
+std::unique_ptr<GPUTracer> CreateGPUTracer(const GPUTracerOptions &options) {
+  return nullptr;
+}
+
 }  // namespace tensorflow
 
 #endif  // GOOGLE_CUDA
@@ -186,6 +186,17 @@ void Benchmark::Run(const char* pattern) {
       }
       s = reporter.Benchmark(iters, 0.0, seconds,
                              items_processed * 1e-6 / seconds);
+      if (s.ok() && !label.empty()) {
+        s = reporter.SetProperty("label", label);
+      }
+      if (s.ok() && bytes_processed > 0) {
+        s = reporter.SetProperty("bytes_per_second",
+                                 bytes_processed / seconds);
+      }
+      if (s.ok() && items_processed > 0) {
+        s = reporter.SetProperty("items_per_second",
+                                 items_processed / seconds);
+      }
       if (!s.ok()) {
         LOG(ERROR) << s.ToString();
         exit(EXIT_FAILURE);
@@ -199,6 +210,11 @@ void Benchmark::Run(const char* pattern) {
   }
 }
 
+Benchmark* Benchmark::Apply(void (*apply_fn)(Benchmark*)) {
+  apply_fn(this);
+  return this;
+}
+
 void Benchmark::Register() {
   if (!all_benchmarks) all_benchmarks = new std::vector<Benchmark*>;
   all_benchmarks->push_back(this);
@@ -70,9 +70,16 @@ class GPUTracer {
   virtual Status Collect(StepStatsCollector* collector) = 0;
 };
 
+struct GPUTracerOptions {
+  // Only trace kernels, not memcpys. This skips the CUPTI callbacks on every
+  // memcpy API call, which makes tracing cheaper for copy-heavy models.
+  bool kernels_only = false;
+};
+
 // Creates a platform-specific GPUTracer.
 // Returns 'nullptr' on platforms where tracing is not supported.
 std::unique_ptr<GPUTracer> CreateGPUTracer();
+std::unique_ptr<GPUTracer> CreateGPUTracer(const GPUTracerOptions& options);
 
 }  // namespace tensorflow
 
@@ -201,6 +201,34 @@ TEST_F(GPUTracerTest, TraceToStepStatsCollector) {
   EXPECT_GE(stats.dev_stats_size(), 1);
 }
 
+TEST_F(GPUTracerTest, TraceKernelsOnly) {
+  GPUTracerOptions options;
+  options.kernels_only = true;
+  std::unique_ptr<GPUTracer> tracer(CreateGPUTracer(options));
+  if (!tracer) return;
+
+  Initialize({3, 2, -1, 0});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_names = {y_ + ":0"};
+  std::vector<string> target_nodes = {y_neg_};
+  std::vector<Tensor> outputs;
+
+  TF_ASSERT_OK(tracer->Start());
+  TF_ASSERT_OK(session->Run(inputs, output_names, target_nodes, &outputs));
+  TF_ASSERT_OK(tracer->Stop());
+  StepStats stats;
+  StepStatsCollector collector(&stats);
+  TF_ASSERT_OK(tracer->Collect(&collector));
+  collector.Finalize();
+  for (const DeviceStepStats& dev_stats : stats.dev_stats()) {
+    EXPECT_FALSE(StringPiece(dev_stats.device()).ends_with("/memcpy"))
+        << dev_stats.device();
+  }
+}
+
 TEST_F(GPUTracerTest, RunWithTraceOption) {
   Initialize({3, 2, -1, 0});
   auto session = CreateSession();
@@ -0,0 +1,71 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_PLATFORM_NUMA_H_
+#define TENSORFLOW_PLATFORM_NUMA_H_
+
+#include "tensorflow/core/platform/platform.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace port {
+
+// Returns true iff NUMA functions are supported on this platform and the
+// machine has more than one NUMA node.
+bool NUMAEnabled();
+
+// Returns the number of NUMA nodes present with respect to CPU operations.
+// Typically this will be the number of sockets where some RAM has greater
+// affinity with one socket than another.  Returns 1 if NUMA is not
+// supported.
+int NUMANumNodes();
+
+// Returns the number of CPUs on 'node' that this process may schedule on,
+// or NumSchedulableCPUs() if NUMA is not supported.
+int NUMANumNodeCPUs(int node);
+
+static const int kNUMANoAffinity = -1;
+
+// If possible, sets the affinity of the current thread to the CPUs of the
+// specified NUMA node.  If 'node' is kNUMANoAffinity, clears the affinity.
+void NUMASetThreadNodeAffinity(int node);
+
+// Returns the NUMA node affinity of the current thread, or kNUMANoAffinity
+// if none has been set.
+int NUMAGetThreadNodeAffinity();
+
+// Like AlignedMalloc(), but allocates memory with a preference for pages
+// on the specified NUMA node.  Memory must be released with NUMAFree().
+void* NUMAMalloc(int node, size_t size, int minimum_alignment);
+
+// Releases memory allocated by NUMAMalloc().
+void NUMAFree(void* ptr, size_t size);
+
+// Allocates 'size' bytes, a multiple of 'huge_page_size', aligned to
+// 'huge_page_size' and backed by huge pages where possible, with a
+// preference for pages on the specified NUMA node (or none if 'node' is
+// kNUMANoAffinity).  Pages larger than 2MB, e.g. 1GB ones, come from the
+// pool reserved by the administrator for hugetlbfs; otherwise, or if the
+// pool is exhausted, transparent huge pages are requested.  Returns
+// nullptr on failure.  Memory must be released with NUMAHugePageFree().
+void* NUMAHugePageMalloc(int node, size_t size, size_t huge_page_size);
+
+// Releases memory allocated by NUMAHugePageMalloc().
+void NUMAHugePageFree(void* ptr, size_t size);
+
+}  // namespace port
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_PLATFORM_NUMA_H_
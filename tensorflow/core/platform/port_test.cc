@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -33,6 +34,52 @@ TEST(Port, AlignedMalloc) {
   }
 }
 
+TEST(Port, NUMAMalloc) {
+  // We don't know the topology of this machine, so allocate on every node
+  // and check alignment and that the memory is writable.
+  const int num_nodes = NUMANumNodes();
+  EXPECT_GE(num_nodes, 1);
+  for (int node = 0; node < num_nodes; ++node) {
+    EXPECT_GE(NUMANumNodeCPUs(node), 1);
+    for (size_t size : {size_t{1}, size_t{1} << 20}) {
+      void* p = NUMAMalloc(node, size, 64);
+      ASSERT_TRUE(p != nullptr);
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 64, 0);
+      memset(p, 0, size);
+      NUMAFree(p, size);
+    }
+  }
+}
+
+TEST(Port, NUMAHugePageMalloc) {
+  const size_t huge_page_size = 2 << 20;
+  for (int node : {kNUMANoAffinity, NUMANumNodes() - 1}) {
+    const size_t size = 2 * huge_page_size;
+    void* p = NUMAHugePageMalloc(node, size, huge_page_size);
+    ASSERT_TRUE(p != nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % huge_page_size, 0);
+    memset(p, 0, size);
+    NUMAHugePageFree(p, size);
+  }
+  // Not a multiple of the page size.
+  EXPECT_EQ(nullptr, NUMAHugePageMalloc(kNUMANoAffinity, 1, huge_page_size));
+}
+
+TEST(Port, NUMAThreadNodeAffinity) {
+  EXPECT_EQ(kNUMANoAffinity, NUMAGetThreadNodeAffinity());
+  if (!NUMAEnabled()) return;
+  const int last_node = NUMANumNodes() - 1;
+  ThreadOptions thread_options;
+  thread_options.numa_node = last_node;
+  int observed_node = kNUMANoAffinity;
+  {
+    std::unique_ptr<Thread> thread(Env::Default()->StartThread(
+        thread_options, "numa_test",
+        [&observed_node]() { observed_node = NUMAGetThreadNodeAffinity(); }));
+  }
+  EXPECT_EQ(last_node, observed_node);
+}
+
 TEST(ConditionVariable, WaitForMilliseconds_Timeout) {
   mutex m;
   mutex_lock l(m);
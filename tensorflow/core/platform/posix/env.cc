@@ -40,13 +40,20 @@ namespace {
 
 class StdThread : public Thread {
  public:
-  // name and thread_options are both ignored.
+  // name, stack_size and guard_size are ignored.
   StdThread(const ThreadOptions& thread_options, const string& name,
             std::function<void()> fn)
-      : thread_(fn) {}
+      : thread_(&StdThread::ThreadFn, thread_options.numa_node, fn) {}
   ~StdThread() override { thread_.join(); }
 
  private:
+  static void ThreadFn(int numa_node, const std::function<void()>& fn) {
+    if (numa_node != port::kNUMANoAffinity) {
+      port::NUMASetThreadNodeAffinity(numa_node);
+    }
+    fn();
+  }
+
   std::thread thread_;
 };
 
@@ -20,10 +20,13 @@ limitations under the License.
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/types.h"
 #if defined(__linux__) && !defined(__ANDROID__)
 #include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #endif
 #include <stdio.h>
 #include <stdlib.h>
@@ -35,6 +38,8 @@ limitations under the License.
 #if (defined(__APPLE__) && defined(__MACH__)) || defined(__FreeBSD__)
 #include <thread>
 #endif
+#include <algorithm>
+#include <vector>
 
 namespace tensorflow {
 namespace port {
@@ -99,6 +104,196 @@ void* Malloc(size_t size) {
 #endif
 }
 
+#if defined(__linux__) && !defined(__ANDROID__)
+namespace {
+
+// The NUMA topology of the machine, read once from sysfs.
+struct NUMATopology {
+  // The CPUs this process could schedule on at startup.
+  cpu_set_t process_cpus;
+  // The schedulable CPUs of each node. Empty if the machine has fewer than
+  // two nodes or the topology cannot be read.
+  std::vector<cpu_set_t> node_cpus;
+};
+
+// Parses a sysfs cpulist such as "0-7,16-23" into 'cpus'.
+void ParseCPUList(FILE* f, cpu_set_t* cpus) {
+  int first;
+  while (fscanf(f, "%d", &first) == 1) {
+    int last = first;
+    int c = fgetc(f);
+    if (c == '-') {
+      if (fscanf(f, "%d", &last) != 1) return;
+      c = fgetc(f);
+    }
+    for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+      CPU_SET(cpu, cpus);
+    }
+    if (c != ',') return;
+  }
+}
+
+const NUMATopology& GetNUMATopology() {
+  static const NUMATopology* topology = [] {
+    NUMATopology* t = new NUMATopology;
+    CPU_ZERO(&t->process_cpus);
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &t->process_cpus) != 0) {
+      return t;
+    }
+    for (int node = 0;; ++node) {
+      char path[64];
+      snprintf(path, sizeof path, "/sys/devices/system/node/node%d/cpulist",
+               node);
+      FILE* f = fopen(path, "r");
+      if (f == nullptr) break;
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      ParseCPUList(f, &cpus);
+      fclose(f);
+      CPU_AND(&cpus, &cpus, &t->process_cpus);
+      t->node_cpus.push_back(cpus);
+    }
+    if (t->node_cpus.size() < 2) t->node_cpus.clear();
+    return t;
+  }();
+  return *topology;
+}
+
+thread_local int numa_thread_node = kNUMANoAffinity;
+
+// The "preferred" memory policy from <numaif.h>, which is not part of libc.
+constexpr int kMPolPreferred = 1;
+
+// The size of transparent huge pages on x86-64, and the shift of the
+// log2 of the page size in the flags of a hugetlbfs mmap().
+constexpr size_t kTransparentHugePageSize = 2 << 20;
+constexpr int kMapHugeShift = 26;
+
+// Prefers 'node' for the pages of [ptr, ptr + size) that are not touched
+// yet.  A preferred (rather than strict) policy lets the kernel fall back
+// to other nodes instead of failing when 'node' runs out of memory.
+void PreferNUMANode(void* ptr, size_t size, int node) {
+#ifdef SYS_mbind
+  const unsigned long node_mask = 1UL << node;
+  syscall(SYS_mbind, ptr, size, kMPolPreferred, &node_mask,
+          sizeof(node_mask) * 8 + 1, 0);
+#endif
+}
+
+}  // namespace
+
+bool NUMAEnabled() { return !GetNUMATopology().node_cpus.empty(); }
+
+int NUMANumNodes() {
+  return std::max<int>(1, GetNUMATopology().node_cpus.size());
+}
+
+int NUMANumNodeCPUs(int node) {
+  const NUMATopology& topology = GetNUMATopology();
+  if (node < 0 || node >= topology.node_cpus.size()) {
+    return NumSchedulableCPUs();
+  }
+  return std::max(1, CPU_COUNT(&topology.node_cpus[node]));
+}
+
+void NUMASetThreadNodeAffinity(int node) {
+  const NUMATopology& topology = GetNUMATopology();
+  if (topology.node_cpus.empty()) return;
+  const cpu_set_t* cpus = &topology.process_cpus;
+  if (node >= 0 && node < topology.node_cpus.size() &&
+      CPU_COUNT(&topology.node_cpus[node]) > 0) {
+    cpus = &topology.node_cpus[node];
+  } else {
+    node = kNUMANoAffinity;
+  }
+  if (sched_setaffinity(0, sizeof(cpu_set_t), cpus) != 0) {
+    perror("sched_setaffinity");
+    return;
+  }
+  numa_thread_node = node;
+}
+
+int NUMAGetThreadNodeAffinity() { return numa_thread_node; }
+
+void* NUMAMalloc(int node, size_t size, int minimum_alignment) {
+#ifdef SYS_mbind
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  if (NUMAEnabled() && node >= 0 && node < NUMANumNodes() && node < 64 &&
+      size >= page_size) {
+    void* ptr = AlignedMalloc(
+        size, std::max<int>(minimum_alignment, static_cast<int>(page_size)));
+    if (ptr == nullptr) return nullptr;
+    PreferNUMANode(ptr, size, node);
+    return ptr;
+  }
+#endif
+  return AlignedMalloc(size, minimum_alignment);
+}
+
+void NUMAFree(void* ptr, size_t size) { AlignedFree(ptr); }
+
+void* NUMAHugePageMalloc(int node, size_t size, size_t huge_page_size) {
+  if (size == 0 || huge_page_size == 0 || size % huge_page_size != 0) {
+    return nullptr;
+  }
+  void* ptr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  if (huge_page_size > kTransparentHugePageSize) {
+    int log2_page_size = 0;
+    while ((size_t{1} << log2_page_size) < huge_page_size) ++log2_page_size;
+    ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                   (log2_page_size << kMapHugeShift),
+               -1, 0);
+  }
+#endif
+  if (ptr == MAP_FAILED) {
+    // Over-allocate so that the mapping can be trimmed to an aligned one.
+    void* mapped = mmap(nullptr, size + huge_page_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) return nullptr;
+    char* begin = static_cast<char*>(mapped);
+    char* aligned = reinterpret_cast<char*>(
+        (reinterpret_cast<uintptr_t>(begin) + huge_page_size - 1) /
+        huge_page_size * huge_page_size);
+    if (aligned > begin) munmap(begin, aligned - begin);
+    munmap(aligned + size, begin + huge_page_size - aligned);
+    ptr = aligned;
+#ifdef MADV_HUGEPAGE
+    madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+  }
+  if (NUMAEnabled() && node >= 0 && node < NUMANumNodes() && node < 64) {
+    PreferNUMANode(ptr, size, node);
+  }
+  return ptr;
+}
+
+void NUMAHugePageFree(void* ptr, size_t size) { munmap(ptr, size); }
+#else
+bool NUMAEnabled() { return false; }
+
+int NUMANumNodes() { return 1; }
+
+int NUMANumNodeCPUs(int node) { return NumSchedulableCPUs(); }
+
+void NUMASetThreadNodeAffinity(int node) {}
+
+int NUMAGetThreadNodeAffinity() { return kNUMANoAffinity; }
+
+void* NUMAMalloc(int node, size_t size, int minimum_alignment) {
+  return AlignedMalloc(size, minimum_alignment);
+}
+
+void NUMAFree(void* ptr, size_t size) { AlignedFree(ptr); }
+
+void* NUMAHugePageMalloc(int node, size_t size, size_t huge_page_size) {
+  return AlignedMalloc(size, static_cast<int>(huge_page_size));
+}
+
+void NUMAHugePageFree(void* ptr, size_t size) { AlignedFree(ptr); }
+#endif  // defined(__linux__) && !defined(__ANDROID__)
+
 void* Realloc(void* ptr, size_t size) {
 #ifdef TENSORFLOW_USE_JEMALLOC
   return jemalloc_realloc(ptr, size);
@@ -12,7 +12,10 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/s3/s3_file_system.h"
 #include "tensorflow/core/platform/s3/s3_crypto.h"
@@ -21,21 +24,68 @@ limitations under the License.
 #include <aws/core/utils/FileSystemUtils.h>
 #include <aws/s3/S3Client.h>
 #include <aws/s3/S3Errors.h>
+#include <aws/s3/model/AbortMultipartUploadRequest.h>
+#include <aws/s3/model/CompleteMultipartUploadRequest.h>
+#include <aws/s3/model/CompletedMultipartUpload.h>
+#include <aws/s3/model/CompletedPart.h>
 #include <aws/s3/model/CopyObjectRequest.h>
+#include <aws/s3/model/CreateMultipartUploadRequest.h>
 #include <aws/s3/model/DeleteObjectRequest.h>
 #include <aws/s3/model/GetObjectRequest.h>
 #include <aws/s3/model/HeadBucketRequest.h>
 #include <aws/s3/model/HeadObjectRequest.h>
 #include <aws/s3/model/ListObjectsRequest.h>
 #include <aws/s3/model/PutObjectRequest.h>
+#include <aws/s3/model/UploadPartRequest.h>
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 
 namespace tensorflow {
 
 static const char* kS3FileSystemAllocationTag = "S3FileSystemAllocation";
 static const size_t kS3ReadAppendableFileBufferSize = 1024 * 1024;
 static const int kS3GetChildrenMaxKeys = 100;
+// The environment variables that override the size of the parts of a
+// multipart upload, the size of the ranges that a large read is split into,
+// and the size of the readahead of sequential reads, in MB, and the number of
+// requests that are sent in parallel.
+static const char* kS3MultipartUploadPartSize =
+    "S3_MULTIPART_UPLOAD_PART_SIZE_MB";
+static const char* kS3ReadChunkSize = "S3_READ_CHUNK_SIZE_MB";
+static const char* kS3ReadaheadSize = "S3_READAHEAD_SIZE_MB";
+static const char* kS3ParallelRequests = "S3_PARALLEL_REQUESTS";
+static const uint64 kS3DefaultMultipartUploadPartSizeMB = 16;
+// S3 rejects the multipart uploads with a part other than the last one that
+// is smaller than 5 MB.
+static const uint64 kS3MinMultipartUploadPartSizeMB = 5;
+static const uint64 kS3DefaultReadChunkSizeMB = 4;
+static const uint64 kS3DefaultReadaheadSizeMB = 16;
+static const uint64 kS3DefaultParallelRequests = 8;
+
+uint64 GetEnvUint64(const char* name, uint64 default_value) {
+  const char* value = getenv(name);
+  uint64 result;
+  if (value == nullptr || !strings::safe_strtou64(value, &result)) {
+    return default_value;
+  }
+  return result;
+}
+
+size_t GetEnvBytes(const char* name, uint64 default_mb) {
+  return GetEnvUint64(name, default_mb) * 1024 * 1024;
+}
+
+// The threads that send the parts of the multipart uploads and the ranged
+// requests of the large reads.
+thread::ThreadPool* GetParallelRequestThreads() {
+  static thread::ThreadPool* threads = new thread::ThreadPool(
+      Env::Default(), "s3_parallel_requests",
+      std::max<uint64>(
+          GetEnvUint64(kS3ParallelRequests, kS3DefaultParallelRequests), 1));
+  return threads;
+}
 
 Aws::Client::ClientConfiguration& GetDefaultClientConfig() {
   static mutex cfg_lock;
@@ -101,14 +151,121 @@ Status ParseS3Path(const string& fname, bool empty_object_ok, string* bucket,
   return Status::OK();
 }
 
+string GetErrorMessage(const Aws::Client::AWSError<Aws::S3::S3Errors>& error) {
+  return strings::StrCat(error.GetExceptionName().c_str(), ": ",
+                         error.GetMessage().c_str());
+}
+
 class S3RandomAccessFile : public RandomAccessFile {
  public:
   S3RandomAccessFile(const string& bucket, const string& object)
-      : bucket_(bucket), object_(object) {}
-
+      : bucket_(bucket),
+        object_(object),
+        s3_client_(
+            Aws::MakeShared<Aws::S3::S3Client>(kS3FileSystemAllocationTag,
+                                               GetDefaultClientConfig())),
+        chunk_size_(std::max<size_t>(
+            GetEnvBytes(kS3ReadChunkSize, kS3DefaultReadChunkSizeMB), 1)),
+        readahead_size_(
+            GetEnvBytes(kS3ReadaheadSize, kS3DefaultReadaheadSizeMB)) {}
+
+  // Serves the sequential reads that are smaller than the readahead from a
+  // buffer, which is refilled with a single large read, and splits the large
+  // reads into ranges of chunk_size_ bytes that are fetched in parallel.
   Status Read(uint64 offset, size_t n, StringPiece* result,
               char* scratch) const override {
-    Aws::S3::S3Client s3Client(GetDefaultClientConfig());
+    {
+      mutex_lock l(mu_);
+      const bool sequential =
+          offset == last_read_end_ ||
+          (offset >= buffer_start_ &&
+           offset <= buffer_start_ + buffer_.size() && !buffer_.empty());
+      last_read_end_ = offset + n;
+      Status status;
+      if (ReadFromBuffer(offset, n, result, scratch, &status)) {
+        return status;
+      }
+      if (sequential && offset > 0 && n < readahead_size_) {
+        buffer_.resize(readahead_size_);
+        size_t bytes_read = 0;
+        status = ReadParallel(offset, readahead_size_, &buffer_[0],
+                              &bytes_read);
+        buffer_.resize(bytes_read);
+        buffer_start_ = offset;
+        buffer_at_eof_ = bytes_read < readahead_size_;
+        if (!status.ok() && status.code() != error::OUT_OF_RANGE) {
+          buffer_.clear();
+          return status;
+        }
+        ReadFromBuffer(offset, n, result, scratch, &status);
+        return status;
+      }
+    }
+    size_t bytes_read = 0;
+    Status status = ReadParallel(offset, n, scratch, &bytes_read);
+    *result = StringPiece(scratch, bytes_read);
+    return status;
+  }
+
+ private:
+  // Copies [offset, offset + n) from the readahead buffer to "scratch", and
+  // returns false if the buffer does not hold these bytes.
+  bool ReadFromBuffer(uint64 offset, size_t n, StringPiece* result,
+                      char* scratch, Status* status) const
+      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const uint64 buffer_end = buffer_start_ + buffer_.size();
+    if (offset < buffer_start_ || offset > buffer_end ||
+        (offset + n > buffer_end && !buffer_at_eof_)) {
+      return false;
+    }
+    const size_t bytes_read = std::min<uint64>(n, buffer_end - offset);
+    memcpy(scratch, buffer_.data() + (offset - buffer_start_), bytes_read);
+    *result = StringPiece(scratch, bytes_read);
+    *status = bytes_read < n ? Status(error::OUT_OF_RANGE,
+                                      "Read less bytes than requested")
+                             : Status::OK();
+    return true;
+  }
+
+  // Reads [offset, offset + n) with one ranged request per chunk_size_
+  // bytes, which are sent in parallel. Returns OUT_OF_RANGE if the file ends
+  // before offset + n.
+  Status ReadParallel(uint64 offset, size_t n, char* scratch,
+                      size_t* bytes_read) const {
+    const size_t num_chunks = (n + chunk_size_ - 1) / chunk_size_;
+    if (num_chunks <= 1) {
+      return ReadRange(offset, n, scratch, bytes_read);
+    }
+    std::vector<Status> statuses(num_chunks);
+    std::vector<size_t> chunk_bytes_read(num_chunks, 0);
+    BlockingCounter counter(num_chunks);
+    for (size_t i = 0; i < num_chunks; ++i) {
+      const size_t start = i * chunk_size_;
+      const size_t length = std::min(chunk_size_, n - start);
+      GetParallelRequestThreads()->Schedule([this, offset, scratch, start,
+                                             length, i, &statuses,
+                                             &chunk_bytes_read, &counter]() {
+        statuses[i] = ReadRange(offset + start, length, scratch + start,
+                                &chunk_bytes_read[i]);
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+    *bytes_read = 0;
+    for (size_t i = 0; i < num_chunks; ++i) {
+      *bytes_read += chunk_bytes_read[i];
+      // The chunks after the end of the file are not read.
+      if (!statuses[i].ok()) return statuses[i];
+    }
+    return Status::OK();
+  }
+
+  Status ReadRange(uint64 offset, size_t n, char* scratch,
+                   size_t* bytes_read) const {
+    *bytes_read = 0;
+    if (n == 0) {
+      return Status::OK();
+    }
     Aws::S3::Model::GetObjectRequest getObjectRequest;
     getObjectRequest.WithBucket(bucket_.c_str()).WithKey(object_.c_str());
     string bytes = strings::StrCat("bytes=", offset, "-", offset + n - 1);
@@ -116,96 +273,257 @@ class S3RandomAccessFile : public RandomAccessFile {
     getObjectRequest.SetResponseStreamFactory([]() {
       return Aws::New<Aws::StringStream>(kS3FileSystemAllocationTag);
     });
-    auto getObjectOutcome = s3Client.GetObject(getObjectRequest);
+    auto getObjectOutcome = s3_client_->GetObject(getObjectRequest);
     if (!getObjectOutcome.IsSuccess()) {
-      n = 0;
-      *result = StringPiece(scratch, n);
       return Status(error::OUT_OF_RANGE, "Read less bytes than requested");
     }
-    n = getObjectOutcome.GetResult().GetContentLength();
-    std::stringstream ss;
-    ss << getObjectOutcome.GetResult().GetBody().rdbuf();
-    ss.read(scratch, n);
-
-    *result = StringPiece(scratch, n);
+    *bytes_read = std::min<uint64>(
+        n, getObjectOutcome.GetResult().GetContentLength());
+    getObjectOutcome.GetResult().GetBody().read(scratch, *bytes_read);
+    if (*bytes_read < n) {
+      return Status(error::OUT_OF_RANGE, "Read less bytes than requested");
+    }
     return Status::OK();
   }
 
- private:
   string bucket_;
   string object_;
+  std::shared_ptr<Aws::S3::S3Client> s3_client_;
+  const size_t chunk_size_;
+  const size_t readahead_size_;
+
+  mutable mutex mu_;
+  // The bytes of the file from buffer_start_ that were read ahead.
+  mutable string buffer_ GUARDED_BY(mu_);
+  mutable uint64 buffer_start_ GUARDED_BY(mu_) = 0;
+  // Whether the file ends at the end of buffer_.
+  mutable bool buffer_at_eof_ GUARDED_BY(mu_) = false;
+  mutable uint64 last_read_end_ GUARDED_BY(mu_) = 0;
 };
 
+// Buffers the appended data in memory, and uploads it with a single request
+// on Sync() as long as it is smaller than a part of a multipart upload. Once
+// it grows larger, the file switches to a multipart upload whose parts are
+// sent in parallel while the writes continue, and the object is only
+// created by Close().
 class S3WritableFile : public WritableFile {
  public:
   S3WritableFile(const string& bucket, const string& object)
       : bucket_(bucket),
         object_(object),
         sync_needed_(true),
-        outfile_(Aws::MakeShared<Aws::Utils::TempFile>(
-            kS3FileSystemAllocationTag, "/tmp/s3_filesystem_XXXXXX",
-            std::ios_base::binary | std::ios_base::trunc | std::ios_base::in |
-                std::ios_base::out)) {}
+        part_size_(std::max(GetEnvUint64(kS3MultipartUploadPartSize,
+                                         kS3DefaultMultipartUploadPartSizeMB),
+                            kS3MinMultipartUploadPartSizeMB) *
+                   1024 * 1024),
+        max_pending_parts_(std::max<uint64>(
+            GetEnvUint64(kS3ParallelRequests, kS3DefaultParallelRequests),
+            1)) {
+    Aws::Client::ClientConfiguration clientConfig = GetDefaultClientConfig();
+    clientConfig.connectTimeoutMs = 300000;
+    clientConfig.requestTimeoutMs = 600000;
+    s3_client_ = Aws::MakeShared<Aws::S3::S3Client>(
+        kS3FileSystemAllocationTag, clientConfig);
+  }
+
+  ~S3WritableFile() override {
+    // Discards the multipart upload of a file that was not closed.
+    if (!upload_id_.empty()) {
+      WaitForParts().IgnoreError();
+      AbortMultipartUpload();
+    }
+  }
 
   Status Append(const StringPiece& data) override {
-    if (!outfile_) {
-      return errors::FailedPrecondition(
-          "The internal temporary file is not writable.");
+    if (closed_) {
+      return errors::FailedPrecondition("The file is closed.");
     }
     sync_needed_ = true;
-    outfile_->write(data.data(), data.size());
-    if (!outfile_->good()) {
-      return errors::Internal(
-          "Could not append to the internal temporary file.");
+    buffer_.append(data.data(), data.size());
+    size_t start = 0;
+    while (buffer_.size() - start >= part_size_) {
+      TF_RETURN_IF_ERROR(UploadPart(buffer_.substr(start, part_size_)));
+      start += part_size_;
     }
+    buffer_.erase(0, start);
     return Status::OK();
   }
 
   Status Close() override {
-    if (outfile_) {
+    if (closed_) {
+      return Status::OK();
+    }
+    if (upload_id_.empty()) {
       TF_RETURN_IF_ERROR(Sync());
-      outfile_.reset();
+    } else {
+      Status status;
+      if (!buffer_.empty()) {
+        status = UploadPart(std::move(buffer_));
+      }
+      status.Update(WaitForParts());
+      if (status.ok()) {
+        status = CompleteMultipartUpload();
+      }
+      if (!status.ok()) {
+        AbortMultipartUpload();
+      }
+      upload_id_.clear();
+      TF_RETURN_IF_ERROR(status);
     }
+    buffer_.clear();
+    closed_ = true;
     return Status::OK();
   }
 
   Status Flush() override { return Sync(); }
 
+  // Creates the object from the data appended so far, or once the multipart
+  // upload has started, waits for the parts being uploaded.
   Status Sync() override {
-    if (!outfile_) {
-      return errors::FailedPrecondition(
-          "The internal temporary file is not writable.");
+    if (closed_) {
+      return errors::FailedPrecondition("The file is closed.");
+    }
+    if (!upload_id_.empty()) {
+      return WaitForParts();
     }
     if (!sync_needed_) {
       return Status::OK();
     }
-    Aws::Client::ClientConfiguration clientConfig = GetDefaultClientConfig();
-    clientConfig.connectTimeoutMs = 300000;
-    clientConfig.requestTimeoutMs = 600000;
-    Aws::S3::S3Client s3Client(clientConfig);
     Aws::S3::Model::PutObjectRequest putObjectRequest;
     putObjectRequest.WithBucket(bucket_.c_str()).WithKey(object_.c_str());
-    long offset = outfile_->tellp();
-    outfile_->seekg(0);
-    putObjectRequest.SetBody(outfile_);
-    putObjectRequest.SetContentLength(offset);
-    auto putObjectOutcome = s3Client.PutObject(putObjectRequest);
-    outfile_->clear();
-    outfile_->seekp(offset);
+    auto body = Aws::MakeShared<Aws::StringStream>(kS3FileSystemAllocationTag);
+    body->write(buffer_.data(), buffer_.size());
+    putObjectRequest.SetBody(body);
+    putObjectRequest.SetContentLength(buffer_.size());
+    auto putObjectOutcome = s3_client_->PutObject(putObjectRequest);
     if (!putObjectOutcome.IsSuccess()) {
-      string error = strings::StrCat(
-          putObjectOutcome.GetError().GetExceptionName().c_str(), ": ",
-          putObjectOutcome.GetError().GetMessage().c_str());
-      return errors::Internal(error);
+      return errors::Internal(GetErrorMessage(putObjectOutcome.GetError()));
     }
+    sync_needed_ = false;
     return Status::OK();
   }
 
  private:
+  // Schedules the upload of the next part, once fewer than
+  // max_pending_parts_ parts are being uploaded.
+  Status UploadPart(string data) {
+    if (upload_id_.empty()) {
+      TF_RETURN_IF_ERROR(CreateMultipartUpload());
+    }
+    int part_number;
+    {
+      mutex_lock l(mu_);
+      while (pending_parts_ >= max_pending_parts_) {
+        parts_done_.wait(l);
+      }
+      TF_RETURN_IF_ERROR(upload_status_);
+      parts_.emplace_back();
+      part_number = static_cast<int>(parts_.size());
+      ++pending_parts_;
+    }
+    auto body = Aws::MakeShared<Aws::StringStream>(kS3FileSystemAllocationTag);
+    body->write(data.data(), data.size());
+    const size_t length = data.size();
+    GetParallelRequestThreads()->Schedule([this, body, length, part_number]() {
+      Aws::S3::Model::UploadPartRequest uploadPartRequest;
+      uploadPartRequest.WithBucket(bucket_.c_str())
+          .WithKey(object_.c_str())
+          .WithUploadId(upload_id_.c_str())
+          .WithPartNumber(part_number);
+      uploadPartRequest.SetBody(body);
+      uploadPartRequest.SetContentLength(length);
+      auto uploadPartOutcome = s3_client_->UploadPart(uploadPartRequest);
+      mutex_lock l(mu_);
+      if (uploadPartOutcome.IsSuccess()) {
+        parts_[part_number - 1]
+            .WithETag(uploadPartOutcome.GetResult().GetETag())
+            .WithPartNumber(part_number);
+      } else {
+        upload_status_.Update(
+            errors::Internal(GetErrorMessage(uploadPartOutcome.GetError())));
+      }
+      --pending_parts_;
+      parts_done_.notify_all();
+    });
+    return Status::OK();
+  }
+
+  // Waits for the parts being uploaded, and returns the first error of an
+  // upload.
+  Status WaitForParts() {
+    mutex_lock l(mu_);
+    while (pending_parts_ > 0) {
+      parts_done_.wait(l);
+    }
+    return upload_status_;
+  }
+
+  Status CreateMultipartUpload() {
+    Aws::S3::Model::CreateMultipartUploadRequest createMultipartUploadRequest;
+    createMultipartUploadRequest.WithBucket(bucket_.c_str())
+        .WithKey(object_.c_str());
+    auto createMultipartUploadOutcome =
+        s3_client_->CreateMultipartUpload(createMultipartUploadRequest);
+    if (!createMultipartUploadOutcome.IsSuccess()) {
+      return errors::Internal(
+          GetErrorMessage(createMultipartUploadOutcome.GetError()));
+    }
+    upload_id_ = createMultipartUploadOutcome.GetResult().GetUploadId().c_str();
+    return Status::OK();
+  }
+
+  Status CompleteMultipartUpload() {
+    Aws::S3::Model::CompletedMultipartUpload completedMultipartUpload;
+    {
+      mutex_lock l(mu_);
+      completedMultipartUpload.SetParts(parts_);
+    }
+    Aws::S3::Model::CompleteMultipartUploadRequest
+        completeMultipartUploadRequest;
+    completeMultipartUploadRequest.WithBucket(bucket_.c_str())
+        .WithKey(object_.c_str())
+        .WithUploadId(upload_id_.c_str())
+        .WithMultipartUpload(completedMultipartUpload);
+    auto completeMultipartUploadOutcome =
+        s3_client_->CompleteMultipartUpload(completeMultipartUploadRequest);
+    if (!completeMultipartUploadOutcome.IsSuccess()) {
+      return errors::Internal(
+          GetErrorMessage(completeMultipartUploadOutcome.GetError()));
+    }
+    return Status::OK();
+  }
+
+  void AbortMultipartUpload() {
+    Aws::S3::Model::AbortMultipartUploadRequest abortMultipartUploadRequest;
+    abortMultipartUploadRequest.WithBucket(bucket_.c_str())
+        .WithKey(object_.c_str())
+        .WithUploadId(upload_id_.c_str());
+    auto abortMultipartUploadOutcome =
+        s3_client_->AbortMultipartUpload(abortMultipartUploadRequest);
+    if (!abortMultipartUploadOutcome.IsSuccess()) {
+      LOG(WARNING) << "Could not abort the multipart upload of " << object_
+                   << ": "
+                   << GetErrorMessage(abortMultipartUploadOutcome.GetError());
+    }
+  }
+
   string bucket_;
   string object_;
   bool sync_needed_;
-  std::shared_ptr<Aws::Utils::TempFile> outfile_;
+  bool closed_ = false;
+  const size_t part_size_;
+  const int max_pending_parts_;
+  std::shared_ptr<Aws::S3::S3Client> s3_client_;
+  // The appended data that is not part of a scheduled upload.
+  string buffer_;
+  // The id of the multipart upload, once it has started.
+  string upload_id_;
+
+  mutex mu_;
+  condition_variable parts_done_;
+  int pending_parts_ GUARDED_BY(mu_) = 0;
+  Aws::Vector<Aws::S3::Model::CompletedPart> parts_ GUARDED_BY(mu_);
+  Status upload_status_ GUARDED_BY(mu_);
 };
 
 class S3ReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
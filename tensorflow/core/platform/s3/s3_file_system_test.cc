@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -106,6 +107,47 @@ TEST_F(S3FileSystemTest, NewWritableFile) {
   EXPECT_EQ("content1,content2", content);
 }
 
+TEST_F(S3FileSystemTest, MultipartUploadAndParallelRead) {
+  // Uploads the file in parts of 5 MB, and reads it in ranges of 1 MB.
+  setenv("S3_MULTIPART_UPLOAD_PART_SIZE_MB", "5", 1);
+  setenv("S3_READ_CHUNK_SIZE_MB", "1", 1);
+  const string fname = TmpDir("MultipartFile");
+  string content;
+  for (int i = 0; content.size() < 12 * 1024 * 1024; ++i) {
+    strings::StrAppend(&content, i, ",");
+  }
+  std::unique_ptr<WritableFile> writer;
+  TF_ASSERT_OK(s3fs.NewWritableFile(fname, &writer));
+  for (size_t start = 0; start < content.size(); start += 100000) {
+    TF_ASSERT_OK(writer->Append(StringPiece(content).substr(start, 100000)));
+  }
+  TF_EXPECT_OK(writer->Sync());
+  TF_ASSERT_OK(writer->Close());
+
+  string got;
+  TF_EXPECT_OK(ReadAll(fname, &got));
+  EXPECT_EQ(content, got);
+
+  // Sequential reads are served from the readahead buffer.
+  std::unique_ptr<RandomAccessFile> reader;
+  TF_ASSERT_OK(s3fs.NewRandomAccessFile(fname, &reader));
+  string scratch(256 * 1024, 0);
+  StringPiece result;
+  uint64 offset = 0;
+  Status status;
+  got.clear();
+  do {
+    status = reader->Read(offset, scratch.size(), &result,
+                          gtl::string_as_array(&scratch));
+    got.append(result.data(), result.size());
+    offset += result.size();
+  } while (status.ok());
+  EXPECT_EQ(error::OUT_OF_RANGE, status.code());
+  EXPECT_EQ(content, got);
+  unsetenv("S3_MULTIPART_UPLOAD_PART_SIZE_MB");
+  unsetenv("S3_READ_CHUNK_SIZE_MB");
+}
+
 TEST_F(S3FileSystemTest, NewAppendableFile) {
   std::unique_ptr<WritableFile> writer;
 
@@ -55,6 +55,7 @@ class Benchmark {
   Benchmark* ArgPair(int x, int y);
   Benchmark* Range(int lo, int hi);
   Benchmark* RangePair(int lo1, int hi1, int lo2, int hi2);
+  Benchmark* Apply(void (*apply_fn)(Benchmark*));
   static void Run(const char* pattern);
 
  private:
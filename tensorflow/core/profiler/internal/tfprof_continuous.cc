@@ -0,0 +1,92 @@
+/* Copyright 2017 The TensorFlow Authors All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/internal/tfprof_continuous.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/profiler/tfprof_output.pb.h"
+
+namespace tensorflow {
+namespace tfprof {
+
+ContinuousProfiler::ContinuousProfiler(std::unique_ptr<GraphDef> graph,
+                                       std::unique_ptr<OpLogProto> op_log,
+                                       const ContinuousProfilerOptions& options)
+    : options_(options),
+      stats_(std::move(graph), nullptr, std::move(op_log), nullptr) {}
+
+bool ContinuousProfiler::ShouldTrace(int64 step) const {
+  return options_.trace_every_n_steps > 0 &&
+         step % options_.trace_every_n_steps == 0;
+}
+
+bool ContinuousProfiler::MaybeEnableTracing(int64 step,
+                                            RunOptions* run_options) const {
+  if (!ShouldTrace(step)) {
+    return false;
+  }
+  run_options->set_trace_level(RunOptions::FULL_TRACE);
+  return true;
+}
+
+void ContinuousProfiler::AddStep(int64 step,
+                                 std::unique_ptr<RunMetadata> run_meta) {
+  mutex_lock l(mu_);
+  if (stats_.steps().count(step) > 0) {
+    // Re-adding a step would double its stats.
+    stats_.RemoveRunMeta(step);
+  } else {
+    traced_steps_.push_back(step);
+  }
+  stats_.AddRunMeta(step, std::move(run_meta));
+  while (traced_steps_.size() > std::max<int64>(options_.max_traced_steps, 1)) {
+    stats_.RemoveRunMeta(traced_steps_.front());
+    traced_steps_.pop_front();
+  }
+
+  ++num_traces_;
+  if (!options_.dump_path.empty() && options_.dump_every_n_traces > 0 &&
+      num_traces_ % options_.dump_every_n_traces == 0) {
+    stats_.WriteProfile(options_.dump_path);
+  }
+}
+
+string ContinuousProfiler::Profile(const string& command,
+                                   const Options& opts) {
+  mutex_lock l(mu_);
+  stats_.BuildView(command);
+  if (command == kCmds[0] || command == kCmds[1]) {
+    return stats_.ShowGraphNode(command, opts).SerializeAsString();
+  } else if (command == kCmds[2] || command == kCmds[3]) {
+    return stats_.ShowMultiGraphNode(command, opts).SerializeAsString();
+  }
+  fprintf(stderr, "Unknown command: %s\n", command.c_str());
+  return "";
+}
+
+void ContinuousProfiler::WriteProfile(const string& filename) {
+  mutex_lock l(mu_);
+  stats_.WriteProfile(filename);
+}
+
+std::vector<int64> ContinuousProfiler::traced_steps() const {
+  mutex_lock l(mu_);
+  return std::vector<int64>(traced_steps_.begin(), traced_steps_.end());
+}
+
+}  // namespace tfprof
+}  // namespace tensorflow
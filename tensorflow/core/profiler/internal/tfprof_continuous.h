@@ -0,0 +1,97 @@
+/* Copyright 2017 The TensorFlow Authors All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Continuous profiling of a running model. Every so many steps, the caller
+// runs a step with full tracing and hands its RunMetadata to the profiler,
+// which keeps the most recent traced steps in a TFStats. The aggregated
+// per-op time and memory of those steps can then be queried, or dumped for
+// the tfprof command line tool, at any time while the job keeps running.
+
+#ifndef THIRD_PARTY_TENSORFLOW_CORE_PROFILER_INTERNAL_TFPROF_CONTINUOUS_H_
+#define THIRD_PARTY_TENSORFLOW_CORE_PROFILER_INTERNAL_TFPROF_CONTINUOUS_H_
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/internal/tfprof_options.h"
+#include "tensorflow/core/profiler/internal/tfprof_stats.h"
+#include "tensorflow/core/profiler/tfprof_log.pb.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace tfprof {
+
+struct ContinuousProfilerOptions {
+  // Trace one step out of every trace_every_n_steps.
+  int64 trace_every_n_steps = 100;
+  // Number of most recent traced steps that the profile aggregates over.
+  int64 max_traced_steps = 10;
+  // If not empty, the profile is written to this file as a ProfileProto
+  // every dump_every_n_traces traced steps. It can be inspected with
+  // `tfprof --profile_path=<dump_path>`.
+  string dump_path;
+  int64 dump_every_n_traces = 10;
+};
+
+class ContinuousProfiler {
+ public:
+  ContinuousProfiler(std::unique_ptr<GraphDef> graph,
+                     std::unique_ptr<OpLogProto> op_log,
+                     const ContinuousProfilerOptions& options);
+
+  // Returns whether "step" is sampled, i.e. should run with
+  // RunOptions::FULL_TRACE and have its RunMetadata passed to AddStep.
+  bool ShouldTrace(int64 step) const;
+
+  // Sets the trace level of "run_options" to FULL_TRACE if "step" is sampled
+  // and returns whether it did.
+  bool MaybeEnableTracing(int64 step, RunOptions* run_options) const;
+
+  // Adds the run time stats of a traced step. Once more than
+  // max_traced_steps steps have been added, the oldest one is dropped.
+  void AddStep(int64 step, std::unique_ptr<RunMetadata> run_meta);
+
+  // Returns the serialized GraphNodeProto ("scope" and "graph" commands) or
+  // MultiGraphNodeProto ("code" and "op" commands) of the current profile.
+  // Returns an empty string if "command" is unknown.
+  string Profile(const string& command, const Options& opts);
+
+  // Writes the current profile to "filename" as a ProfileProto.
+  void WriteProfile(const string& filename);
+
+  // The traced steps that the current profile aggregates over.
+  std::vector<int64> traced_steps() const;
+
+ private:
+  const ContinuousProfilerOptions options_;
+
+  mutable mutex mu_;
+  TFStats stats_ GUARDED_BY(mu_);
+  std::deque<int64> traced_steps_ GUARDED_BY(mu_);
+  int64 num_traces_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ContinuousProfiler);
+};
+
+}  // namespace tfprof
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CORE_PROFILER_INTERNAL_TFPROF_CONTINUOUS_H_
@@ -0,0 +1,136 @@
+/* Copyright 2017 The TensorFlow Authors All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/profiler/internal/tfprof_continuous.h"
+
+#include <utility>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/profiler/internal/tfprof_options.h"
+#include "tensorflow/core/profiler/internal/tfprof_stats.h"
+#include "tensorflow/core/profiler/internal/tfprof_utils.h"
+#include "tensorflow/core/profiler/tfprof_output.pb.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace tfprof {
+class ContinuousProfilerTest : public ::testing::Test {
+ protected:
+  ContinuousProfilerTest() {
+    string run_meta_path =
+        io::JoinPath(testing::TensorFlowSrcRoot(),
+                     "core/profiler/internal/testdata/run_meta");
+    TF_CHECK_OK(
+        ReadProtoFile(Env::Default(), run_meta_path, &run_meta_pb_, true));
+  }
+
+  std::unique_ptr<ContinuousProfiler> NewProfiler(
+      const ContinuousProfilerOptions& options) {
+    string graph_path =
+        io::JoinPath(testing::TensorFlowSrcRoot(),
+                     "core/profiler/internal/testdata/graph.pbtxt");
+    std::unique_ptr<tensorflow::GraphDef> graph_pb(new tensorflow::GraphDef());
+    TF_CHECK_OK(
+        ReadProtoFile(Env::Default(), graph_path, graph_pb.get(), false));
+    return std::unique_ptr<ContinuousProfiler>(
+        new ContinuousProfiler(std::move(graph_pb), nullptr, options));
+  }
+
+  std::unique_ptr<RunMetadata> TracedStep() const {
+    return std::unique_ptr<RunMetadata>(new RunMetadata(run_meta_pb_));
+  }
+
+  // A traced step in which no node ran.
+  std::unique_ptr<RunMetadata> EmptyStep() const {
+    std::unique_ptr<RunMetadata> run_meta(new RunMetadata());
+    run_meta->mutable_step_stats();
+    return run_meta;
+  }
+
+  int64 TotalExecMicros(ContinuousProfiler* profiler) {
+    Options opts(3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, "name", {".*"}, {".*"},
+                 {""}, {".*"}, {""}, false, {"micros"}, kOutput[4], {});
+    GraphNodeProto root;
+    CHECK(root.ParseFromString(profiler->Profile("scope", opts)));
+    return root.total_exec_micros();
+  }
+
+  RunMetadata run_meta_pb_;
+};
+
+TEST_F(ContinuousProfilerTest, SampledSteps) {
+  ContinuousProfilerOptions options;
+  options.trace_every_n_steps = 10;
+  std::unique_ptr<ContinuousProfiler> profiler = NewProfiler(options);
+
+  EXPECT_TRUE(profiler->ShouldTrace(0));
+  EXPECT_FALSE(profiler->ShouldTrace(5));
+  EXPECT_TRUE(profiler->ShouldTrace(20));
+
+  RunOptions run_options;
+  EXPECT_FALSE(profiler->MaybeEnableTracing(11, &run_options));
+  EXPECT_EQ(RunOptions::NO_TRACE, run_options.trace_level());
+  EXPECT_TRUE(profiler->MaybeEnableTracing(30, &run_options));
+  EXPECT_EQ(RunOptions::FULL_TRACE, run_options.trace_level());
+}
+
+TEST_F(ContinuousProfilerTest, RollingWindow) {
+  ContinuousProfilerOptions options;
+  options.max_traced_steps = 2;
+  std::unique_ptr<ContinuousProfiler> profiler = NewProfiler(options);
+
+  profiler->AddStep(0, TracedStep());
+  const int64 exec_micros = TotalExecMicros(profiler.get());
+  EXPECT_GT(exec_micros, 0);
+
+  // Per-op stats are averaged over the steps in which the ops ran.
+  profiler->AddStep(100, EmptyStep());
+  EXPECT_EQ(std::vector<int64>({0, 100}), profiler->traced_steps());
+  EXPECT_EQ(exec_micros, TotalExecMicros(profiler.get()));
+
+  // Step 0 falls out of the window.
+  profiler->AddStep(200, EmptyStep());
+  EXPECT_EQ(std::vector<int64>({100, 200}), profiler->traced_steps());
+  EXPECT_EQ(0, TotalExecMicros(profiler.get()));
+
+  // Adding a step again replaces its stats.
+  profiler->AddStep(200, TracedStep());
+  profiler->AddStep(200, TracedStep());
+  EXPECT_EQ(std::vector<int64>({100, 200}), profiler->traced_steps());
+  EXPECT_EQ(exec_micros, TotalExecMicros(profiler.get()));
+}
+
+TEST_F(ContinuousProfilerTest, DumpProfile) {
+  ContinuousProfilerOptions options;
+  options.dump_path = io::JoinPath(testing::TmpDir(), "continuous_profile");
+  options.dump_every_n_traces = 2;
+  Env::Default()->DeleteFile(options.dump_path).IgnoreError();
+  std::unique_ptr<ContinuousProfiler> profiler = NewProfiler(options);
+
+  profiler->AddStep(0, TracedStep());
+  EXPECT_FALSE(Env::Default()->FileExists(options.dump_path).ok());
+  profiler->AddStep(100, TracedStep());
+  TF_ASSERT_OK(Env::Default()->FileExists(options.dump_path));
+
+  TFStats dumped(options.dump_path, nullptr);
+  EXPECT_EQ(std::set<int64>({0, 100}), dumped.steps());
+}
+
+}  // namespace tfprof
+}  // namespace tensorflow
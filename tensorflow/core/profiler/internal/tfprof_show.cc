@@ -28,6 +28,12 @@ namespace tfprof {
 const GraphNodeProto& TFShow::Show(const Options& opts) {
   if (opts.output_type == kOutput[0]) {
     Timeline timeline(opts.step, opts.output_options.at(kTimelineOpts[0]));
+    if (allocator_timelines_ != nullptr) {
+      auto it = allocator_timelines_->find(opts.step);
+      if (it != allocator_timelines_->end()) {
+        timeline.SetAllocatorTimelines(&it->second);
+      }
+    }
     return ShowInternal(opts, &timeline)->proto();
   } else {
     const ShowNode* ret = ShowInternal(opts, nullptr);
@@ -46,6 +46,13 @@ class TFShow {
   virtual void Build() = 0;
   const GraphNodeProto& Show(const Options& opts);
 
+  // The allocator timelines of each step, to be included in timeline
+  // outputs.
+  void set_allocator_timelines(
+      const std::map<int64, std::vector<AllocatorTimeline>>* timelines) {
+    allocator_timelines_ = timelines;
+  }
+
  protected:
   virtual const ShowNode* ShowInternal(const Options& opts,
                                        Timeline* timeline) = 0;
@@ -115,6 +122,8 @@ class TFShow {
   }
 
   checkpoint::CheckpointReader* ckpt_reader_;
+  const std::map<int64, std::vector<AllocatorTimeline>>* allocator_timelines_ =
+      nullptr;
 };
 
 template <typename T>
@@ -108,6 +108,7 @@ void TFStats::BuildView(const string& cmd) {
   }
   if (cmd == kCmds[1] && !graph_view_) {
     graph_view_.reset(new TFGraph(ckpt_reader_.get()));
+    graph_view_->set_allocator_timelines(&allocator_timelines_);
     for (auto it = nodes_map_.begin(); it != nodes_map_.end(); it++) {
       graph_view_->AddNode(it->second.get());
     }
@@ -258,6 +259,10 @@ void TFStats::AddRunMeta(int64 step, std::unique_ptr<RunMetadata> run_meta) {
   }
   steps_.insert(step);
 
+  for (const AllocatorTimeline& timeline :
+       run_meta->step_stats().allocator_timelines()) {
+    allocator_timelines_[step].push_back(timeline);
+  }
   for (const auto& dev_stat : run_meta->step_stats().dev_stats()) {
     for (const NodeExecStats& node_stat : dev_stat.node_stats()) {
       string name = node_stat.node_name();
@@ -282,6 +287,16 @@ void TFStats::AddRunMeta(int64 step, std::unique_ptr<RunMetadata> run_meta) {
   }
 }
 
+void TFStats::RemoveRunMeta(int64 step) {
+  if (steps_.erase(step) == 0) {
+    return;
+  }
+  allocator_timelines_.erase(step);
+  for (auto& node : nodes_map_) {
+    node.second->RemoveStepStat(step);
+  }
+}
+
 void TFStats::WriteProfile(const string& filename) {
   ProfileProto profile;
   for (const auto& entry : id_to_string_) {
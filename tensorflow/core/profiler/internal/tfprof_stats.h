@@ -88,6 +88,9 @@ class TFStats {
 
   // Add a step of run time meta data.
   void AddRunMeta(int64 step, std::unique_ptr<RunMetadata> run_meta);
+  // Drop the run time stats of a step previously added by AddRunMeta, so
+  // that aggregates over all steps no longer include it.
+  void RemoveRunMeta(int64 step);
   // Add tfprof operation meta data, such as customized op type, float_ops,
   // and code traces.
   void AddOpLogProto(std::unique_ptr<OpLogProto> op_log);
@@ -115,6 +118,8 @@ class TFStats {
   MultiGraphNodeProto empty_multi_graph_node_;
 
   std::map<int64, string> id_to_string_;
+  // The allocator timelines of each step.
+  std::map<int64, std::vector<AllocatorTimeline>> allocator_timelines_;
   // Graph nodes covered by RunMetdata, that is traced with run time stats.
   std::set<int64> covered_nodes_;
 };
@@ -15,9 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/profiler/internal/tfprof_timeline.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/profiler/internal/tfprof_utils.h"
@@ -124,6 +126,23 @@ void ChromeTraceFormatter::EmitCounter(
   events_.push_back(event2);
 }
 
+void ChromeTraceFormatter::EmitCounters(const string& category,
+                                        const string& name, int64 pid,
+                                        int64 ts, Json::Value args) {
+  Json::Value event = CreateEvent("C", category, name, pid, 0, ts);
+  event["args"] = std::move(args);
+  events_.push_back(event);
+}
+
+void ChromeTraceFormatter::EmitInstant(int64 ts, int64 pid, int64 tid,
+                                       const string& category,
+                                       const string& name, Json::Value args) {
+  Json::Value event = CreateEvent("i", category, name, pid, tid, ts);
+  event["s"] = Json::Value("t");
+  event["args"] = std::move(args);
+  events_.push_back(event);
+}
+
 string ChromeTraceFormatter::Format() {
   Json::Value trace;
   trace["traceEvents"] = Json::Value(Json::arrayValue);
@@ -303,9 +322,63 @@ void Timeline::GenerateGraphTimeline(const std::vector<GraphNode*>& gnodes) {
               max_bytes_in_use / 1000000.0);
     }
   }
+  EmitAllocatorTimelines();
   OutputTimeline();
 }
 
+void Timeline::EmitAllocatorTimelines() {
+  if (!allocator_timelines_) return;
+  for (const AllocatorTimeline& allocator : *allocator_timelines_) {
+    int64 pid = AllocatePID();
+    chrome_formatter_.EmitPID(
+        strings::StrCat("allocator: ", allocator.allocator_name()), pid);
+
+    int64 last_micros = 0;
+    for (const AllocatorEvent& event : allocator.events()) {
+      Json::Value args(Json::objectValue);
+      args["bytes"] = Json::Value(event.bytes());
+      args["bin"] = Json::Value(event.bin());
+      args["op"] = Json::Value(event.op_name());
+      args["step_id"] = Json::Value(event.step_id());
+      chrome_formatter_.EmitInstant(event.micros(), pid, 0, "Allocator",
+                                    event.bytes() >= 0 ? "alloc" : "free",
+                                    args);
+      Json::Value counter(Json::objectValue);
+      counter["Allocator Bytes in Use"] = Json::Value(event.bytes_in_use());
+      chrome_formatter_.EmitCounters("Allocator", "Allocated Bytes", pid,
+                                     event.micros(), counter);
+      last_micros = std::max<int64>(last_micros, event.micros());
+    }
+
+    // The bins as of the end of the step.
+    Json::Value in_use(Json::objectValue);
+    Json::Value wasted(Json::objectValue);
+    Json::Value free_bytes(Json::objectValue);
+    for (const AllocatorBinStats& bin : allocator.bins()) {
+      const string label = strings::Printf(
+          "Bin %02d (%s)", bin.bin(),
+          strings::HumanReadableNumBytes(bin.bin_size()).c_str());
+      in_use[label] = Json::Value(bin.bytes_in_use());
+      wasted[label] =
+          Json::Value(bin.bytes_in_use() - bin.requested_bytes_in_use());
+      free_bytes[label] = Json::Value(bin.free_bytes());
+    }
+    if (allocator.bins_size() > 0) {
+      chrome_formatter_.EmitCounters("Allocator", "Bytes in Use by Bin", pid,
+                                     last_micros, in_use);
+      chrome_formatter_.EmitCounters("Allocator", "Wasted Bytes by Bin", pid,
+                                     last_micros, wasted);
+      chrome_formatter_.EmitCounters("Allocator", "Free Bytes by Bin", pid,
+                                     last_micros, free_bytes);
+    }
+    if (allocator.num_dropped_events() > 0) {
+      fprintf(stdout, "%s: %lld allocator events were dropped.\n",
+              allocator.allocator_name().c_str(),
+              allocator.num_dropped_events());
+    }
+  }
+}
+
 void Timeline::GenerateScopeTimeline(const ScopeNode* node) {
   std::set<int64> visited_depth;
   EmitTreeNode(node, 0, node->proto().total_exec_micros(), 0, &visited_depth);
@@ -52,6 +52,13 @@ class ChromeTraceFormatter {
                    int64 ts, const string& device, int64 bytes,
                    const std::map<int64, std::vector<string>>& tensor_mem);
 
+  // A counter event with a series for each member of 'args'.
+  void EmitCounters(const string& category, const string& name, int64 pid,
+                    int64 ts, Json::Value args);
+
+  void EmitInstant(int64 ts, int64 pid, int64 tid, const string& category,
+                   const string& name, Json::Value args);
+
   string Format();
 
  private:
@@ -134,11 +141,19 @@ class Timeline {
 
   void GenerateCodeTimeline(const CodeNode* node);
 
+  // The allocator timelines of step(), drawn by GenerateGraphTimeline() as
+  // one process per allocator.  Not owned.
+  void SetAllocatorTimelines(const std::vector<AllocatorTimeline>* timelines) {
+    allocator_timelines_ = timelines;
+  }
+
  private:
   void TrackNode(const GraphNode* node) { mem_tracker_.TrackNode(step_, node); }
 
   void OutputTimeline();
 
+  void EmitAllocatorTimelines();
+
   template <typename Node>
   void EmitTreeNode(const Node* node, int64 start_time, int64 duration,
                     int64 depth, std::set<int64>* visited_depth) {
@@ -186,6 +201,7 @@ class Timeline {
   std::map<string, std::unique_ptr<Process>> process_;
   std::map<int64, std::map<int64, std::map<int64, TimeNode*>>> alloc_nodes_;
   std::map<string, std::map<int64, std::unique_ptr<TimeNode>>> tnodes_;
+  const std::vector<AllocatorTimeline>* allocator_timelines_ = nullptr;
 };
 
 }  // namespace tfprof
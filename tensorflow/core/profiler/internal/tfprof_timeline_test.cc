@@ -88,6 +88,44 @@ TEST_F(TFProfTimelineTest, ScopeView) {
   EXPECT_EQ(17545174915963890413ull, Hash64(dump_str));
 }
 
+TEST_F(TFProfTimelineTest, AllocatorTimeline) {
+  std::unique_ptr<RunMetadata> run_meta(new RunMetadata());
+  AllocatorTimeline* allocator =
+      run_meta->mutable_step_stats()->add_allocator_timelines();
+  allocator->set_allocator_name("GPU_0_bfc");
+  AllocatorEvent* event = allocator->add_events();
+  event->set_micros(100);
+  event->set_bytes(1024);
+  event->set_bytes_in_use(1024);
+  event->set_bin(2);
+  event->set_op_name("conv2d/Conv2D");
+  event->set_step_id(7);
+  event = allocator->add_events();
+  event->set_micros(200);
+  event->set_bytes(-1024);
+  event->set_bin(2);
+  AllocatorBinStats* bin = allocator->add_bins();
+  bin->set_bin(2);
+  bin->set_bin_size(1024);
+  bin->set_free_chunks(1);
+  bin->set_free_bytes(4096);
+  tf_stats_->AddRunMeta(1, std::move(run_meta));
+
+  string dump_file = io::JoinPath(testing::TmpDir(), "dump");
+  Options opts(10000, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, "name",
+               {".*"},  // accout_type_regexes
+               {".*"}, {""}, {".*"}, {""}, false,
+               {"params", "bytes", "micros", "float_ops"}, "timeline",
+               {{"outfile", dump_file}});
+  tf_stats_->ShowGraphNode("graph", opts);
+
+  string dump_str;
+  TF_CHECK_OK(ReadFileToString(Env::Default(), dump_file + "_1", &dump_str));
+  EXPECT_NE(dump_str.npos, dump_str.find("allocator: GPU_0_bfc"));
+  EXPECT_NE(dump_str.npos, dump_str.find("\"op\":\"conv2d/Conv2D\""));
+  EXPECT_NE(dump_str.npos, dump_str.find("Free Bytes by Bin"));
+}
+
 // TODO(xpan): tfprof_log is too large to include in testdata when adding
 // code traces.
 
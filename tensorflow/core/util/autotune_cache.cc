@@ -0,0 +1,153 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/core/util/autotune_cache.h"
+
+#include <cstdlib>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/protobuf/autotune_results.pb.h"
+
+namespace tensorflow {
+
+/* static */
+AutotuneCache* AutotuneCache::Global() {
+  static AutotuneCache* const cache = []() -> AutotuneCache* {
+    const char* filename = getenv("TF_AUTOTUNE_CACHE_FILE");
+    if (filename == nullptr || *filename == '\0') return nullptr;
+    AutotuneCache* cache = new AutotuneCache(Env::Default(), filename);
+    Status s = cache->Load();
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to load the autotune results from " << filename
+                   << ": " << s;
+    }
+    return cache;
+  }();
+  return cache;
+}
+
+AutotuneCache::AutotuneCache(Env* env, const string& filename)
+    : env_(env), filename_(filename) {}
+
+Status AutotuneCache::Load() {
+  mutex_lock l(mu_);
+  return LoadLocked();
+}
+
+Status AutotuneCache::LoadLocked() {
+  Status s = env_->FileExists(filename_);
+  if (errors::IsNotFound(s)) return Status::OK();
+  TF_RETURN_IF_ERROR(s);
+  AutotuneResults results;
+  TF_RETURN_IF_ERROR(ReadBinaryProto(env_, filename_, &results));
+  for (const AutotuneResults::Entry& entry : results.entries()) {
+    entries_.emplace(entry.key(), std::vector<int64>(entry.config().begin(),
+                                                     entry.config().end()));
+  }
+  VLOG(1) << "Loaded " << results.entries_size() << " autotune results from "
+          << filename_;
+  return Status::OK();
+}
+
+Status AutotuneCache::SaveLocked() {
+  // Keeps the entries that other processes have written since the file was
+  // loaded, unless this process has its own entries for their keys.
+  Status s = LoadLocked();
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to merge the autotune results in " << filename_
+                 << ", overwriting them: " << s;
+  }
+  AutotuneResults results;
+  for (const auto& key_and_config : entries_) {
+    AutotuneResults::Entry* entry = results.add_entries();
+    entry->set_key(key_and_config.first);
+    for (int64 value : key_and_config.second) entry->add_config(value);
+  }
+  const string tmpname = strings::StrCat(filename_, ".tmp", random::New64());
+  TF_RETURN_IF_ERROR(WriteBinaryProto(env_, tmpname, results));
+  s = env_->RenameFile(tmpname, filename_);
+  if (!s.ok()) {
+    env_->DeleteFile(tmpname).IgnoreError();
+  }
+  return s;
+}
+
+bool AutotuneCache::Find(const string& key, std::vector<int64>* config) const {
+  mutex_lock l(mu_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) return false;
+  *config = it->second;
+  return true;
+}
+
+Status AutotuneCache::Insert(const string& key,
+                             const std::vector<int64>& config) {
+  mutex_lock l(mu_);
+  std::vector<int64>& entry = entries_[key];
+  if (entry == config) return Status::OK();
+  entry = config;
+  return SaveLocked();
+}
+
+string AutotuneDeviceKey(perftools::gputools::StreamExecutor* executor) {
+  const perftools::gputools::DeviceDescription& description =
+      executor->GetDeviceDescription();
+  string key = description.name();
+  int major, minor;
+  if (description.cuda_compute_capability(&major, &minor)) {
+    strings::StrAppend(&key, "/sm_", major, ".", minor);
+  }
+  perftools::gputools::dnn::DnnSupport* dnn = executor->AsDnn();
+  strings::StrAppend(&key, "/dnn_", dnn == nullptr ? 0 : dnn->GetVersion());
+  return key;
+}
+
+std::vector<int64> AutotuneConfigToValues(
+    const perftools::gputools::dnn::AlgorithmConfig& config) {
+  return {config.algorithm().algo_id(),
+          config.algorithm().tensor_ops_enabled(),
+          config.algorithm_no_scratch().algo_id(),
+          config.algorithm_no_scratch().tensor_ops_enabled()};
+}
+
+bool AutotuneConfigFromValues(
+    const std::vector<int64>& values,
+    perftools::gputools::dnn::AlgorithmConfig* config) {
+  using perftools::gputools::dnn::AlgorithmDesc;
+  if (values.size() != 4) return false;
+  *config = perftools::gputools::dnn::AlgorithmConfig(
+      AlgorithmDesc(values[0], values[1] != 0),
+      AlgorithmDesc(values[2], values[3] != 0));
+  return true;
+}
+
+std::vector<int64> AutotuneConfigToValues(
+    const perftools::gputools::blas::AlgorithmConfig& config) {
+  return {config.algorithm()};
+}
+
+bool AutotuneConfigFromValues(
+    const std::vector<int64>& values,
+    perftools::gputools::blas::AlgorithmConfig* config) {
+  if (values.size() != 1) return false;
+  config->set_algorithm(values[0]);
+  return true;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,99 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#ifndef TENSORFLOW_UTIL_AUTOTUNE_CACHE_H_
+#define TENSORFLOW_UTIL_AUTOTUNE_CACHE_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Persists the algorithms that autotuning chooses for operations like
+// convolutions and matrix multiplications, so that later processes on the
+// same kind of device can reuse them instead of profiling the algorithms
+// again.
+//
+// The entries map a key, which identifies the device, the kind of operation
+// and its parameters, to a configuration in a form that is specific to the
+// kind of operation. They are stored in a file as an AutotuneResults proto.
+// Several processes may share the file: each write merges the entries that
+// the others have written to it in the meantime, and replaces the file
+// atomically.
+//
+// This class is thread-safe.
+class AutotuneCache {
+ public:
+  // Returns the process-wide cache, which is stored in the file named by the
+  // environment variable TF_AUTOTUNE_CACHE_FILE and loaded on the first
+  // call, or nullptr if the variable is not set.
+  static AutotuneCache* Global();
+
+  AutotuneCache(Env* env, const string& filename);
+
+  // Adds the entries of the file, if it exists, to those of the cache.
+  Status Load();
+
+  // Returns true and sets "config" if the cache has an entry for "key".
+  bool Find(const string& key, std::vector<int64>* config) const;
+
+  // Sets the entry for "key" to "config", and writes the entries to the file
+  // if that changed them.
+  Status Insert(const string& key, const std::vector<int64>& config);
+
+ private:
+  Status LoadLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  Status SaveLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Env* const env_;
+  const string filename_;
+
+  mutable mutex mu_;
+  std::unordered_map<string, std::vector<int64>> entries_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AutotuneCache);
+};
+
+// Returns the prefix of the keys of the entries for "executor", which
+// identifies the model of its device, its compute capability and the version
+// of its DNN library, since the best algorithms depend on all of them.
+string AutotuneDeviceKey(perftools::gputools::StreamExecutor* executor);
+
+// Converts the autotuned algorithms of convolutions and matrix
+// multiplications to and from the configurations of their entries. The
+// conversions from a configuration return false if it is malformed.
+std::vector<int64> AutotuneConfigToValues(
+    const perftools::gputools::dnn::AlgorithmConfig& config);
+bool AutotuneConfigFromValues(
+    const std::vector<int64>& values,
+    perftools::gputools::dnn::AlgorithmConfig* config);
+std::vector<int64> AutotuneConfigToValues(
+    const perftools::gputools::blas::AlgorithmConfig& config);
+bool AutotuneConfigFromValues(
+    const std::vector<int64>& values,
+    perftools::gputools::blas::AlgorithmConfig* config);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_UTIL_AUTOTUNE_CACHE_H_
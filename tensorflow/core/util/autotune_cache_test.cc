@@ -0,0 +1,82 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "tensorflow/core/util/autotune_cache.h"
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+string CacheFile(const string& name) {
+  const string filename = io::JoinPath(testing::TmpDir(), name);
+  Env::Default()->DeleteFile(filename).IgnoreError();
+  return filename;
+}
+
+TEST(AutotuneCacheTest, PersistsEntries) {
+  const string filename = CacheFile("persists_entries");
+  {
+    AutotuneCache cache(Env::Default(), filename);
+    TF_ASSERT_OK(cache.Load());
+    std::vector<int64> config;
+    EXPECT_FALSE(cache.Find("a", &config));
+    TF_ASSERT_OK(cache.Insert("a", {1, 0, -1, 0}));
+    TF_ASSERT_OK(cache.Insert("b", {3}));
+    TF_ASSERT_OK(cache.Insert("b", {4}));
+    ASSERT_TRUE(cache.Find("b", &config));
+    EXPECT_EQ(std::vector<int64>({4}), config);
+  }
+
+  AutotuneCache cache(Env::Default(), filename);
+  TF_ASSERT_OK(cache.Load());
+  std::vector<int64> config;
+  ASSERT_TRUE(cache.Find("a", &config));
+  EXPECT_EQ(std::vector<int64>({1, 0, -1, 0}), config);
+  ASSERT_TRUE(cache.Find("b", &config));
+  EXPECT_EQ(std::vector<int64>({4}), config);
+}
+
+TEST(AutotuneCacheTest, MergesEntriesOfOtherWriters) {
+  const string filename = CacheFile("merges_entries");
+  AutotuneCache first(Env::Default(), filename);
+  AutotuneCache second(Env::Default(), filename);
+  TF_ASSERT_OK(first.Load());
+  TF_ASSERT_OK(second.Load());
+  TF_ASSERT_OK(first.Insert("a", {1}));
+  TF_ASSERT_OK(first.Insert("c", {5}));
+  // Replaces the entry of "first" for "c", and keeps the one for "a".
+  TF_ASSERT_OK(second.Insert("b", {2}));
+  TF_ASSERT_OK(second.Insert("c", {6}));
+
+  AutotuneCache cache(Env::Default(), filename);
+  TF_ASSERT_OK(cache.Load());
+  std::vector<int64> config;
+  ASSERT_TRUE(cache.Find("a", &config));
+  EXPECT_EQ(std::vector<int64>({1}), config);
+  ASSERT_TRUE(cache.Find("b", &config));
+  EXPECT_EQ(std::vector<int64>({2}), config);
+  ASSERT_TRUE(cache.Find("c", &config));
+  EXPECT_EQ(std::vector<int64>({6}), config);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -52,26 +52,30 @@ struct BeamProbability {
   float label;
 };
 
+template <class CTCBeamState>
+class BeamArena;
+
 template <class CTCBeamState = EmptyBeamState>
 struct BeamEntry {
   // Default constructor does not create a vector of children.
   BeamEntry() : parent(nullptr), label(-1) {}
-  // Constructor giving parent, label, and number of children does
-  // create a vector of children.  The object pointed to by p
+  // Constructor giving parent, label, and the arena that allocates the
+  // children of the entry.  The object pointed to by p
   // cannot be copied and should not be moved, otherwise parent will
   // become invalid.
-  BeamEntry(BeamEntry* p, int l) : parent(p), label(l) {}
+  BeamEntry(BeamEntry* p, int l, BeamArena<CTCBeamState>* arena)
+      : parent(p), label(l), arena_(arena) {}
   inline bool Active() const { return newp.total != kLogZero; }
-  // Return the child at the given index, or construct a new one in-place if
-  // none was found.
+  // Return the child at the given index, or allocate a new one from the
+  // arena if none was found.
   BeamEntry& GetChild(int ind) {
     auto entry = children.emplace(ind, nullptr);
     auto& child_entry = entry.first->second;
-    // If this is a new child, populate the uniqe_ptr.
+    // If this is a new child, allocate it.
     if (entry.second) {
-      child_entry.reset(new BeamEntry(this, ind));
+      child_entry = CHECK_NOTNULL(arena_)->New(this, ind);
     }
-    return *(child_entry.get());
+    return *child_entry;
   }
   std::vector<int> LabelSeq(bool merge_repeated) const {
     std::vector<int> labels;
@@ -90,15 +94,59 @@ struct BeamEntry {
 
   BeamEntry<CTCBeamState>* parent;
   int label;
-  gtl::FlatMap<int, std::unique_ptr<BeamEntry<CTCBeamState>>> children;
+  // The children are owned by the arena.
+  gtl::FlatMap<int, BeamEntry<CTCBeamState>*> children;
   BeamProbability oldp;
   BeamProbability newp;
   CTCBeamState state;
 
  private:
+  friend class BeamArena<CTCBeamState>;
+
+  BeamArena<CTCBeamState>* arena_ = nullptr;
+
   TF_DISALLOW_COPY_AND_ASSIGN(BeamEntry);
 };
 
+// BeamArena owns the entries of a beam search.  Clear() only marks them as
+// free, and New() reinitializes the entries in place, so a decoder stops
+// allocating entries once it has decoded its largest sequence.  It is not
+// thread-safe: each decoder has its own arena.
+template <class CTCBeamState = EmptyBeamState>
+class BeamArena {
+ public:
+  BeamArena() {}
+
+  // Returns an entry with no children and zero probability, which is valid
+  // until the next call of Clear().
+  BeamEntry<CTCBeamState>* New(BeamEntry<CTCBeamState>* parent, int label) {
+    if (size_ == entries_.size()) {
+      entries_.emplace_back(new BeamEntry<CTCBeamState>(parent, label, this));
+      return entries_[size_++].get();
+    }
+    BeamEntry<CTCBeamState>* entry = entries_[size_++].get();
+    entry->parent = parent;
+    entry->label = label;
+    entry->children.clear_no_resize();
+    entry->oldp.Reset();
+    entry->newp.Reset();
+    entry->state = CTCBeamState();
+    return entry;
+  }
+
+  // Frees all the entries returned by New().
+  void Clear() { size_ = 0; }
+
+  // The number of entries in use.
+  size_t size() const { return size_; }
+
+ private:
+  std::vector<std::unique_ptr<BeamEntry<CTCBeamState>>> entries_;
+  size_t size_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BeamArena);
+};
+
 // BeamComparer is the default beam comparer provided in CTCBeamSearch.
 template <class CTCBeamState = EmptyBeamState>
 class BeamComparer {
@@ -142,7 +142,8 @@ class CTCBeamSearchDecoder : public CTCDecoder {
   float label_selection_margin_ = -1;  // -1 means unlimited.
 
   gtl::TopN<BeamEntry*, CTCBeamComparer> leaves_;
-  std::unique_ptr<BeamEntry> beam_root_;
+  ctc_beam_search::BeamArena<CTCBeamState> arena_;
+  BeamEntry* beam_root_ = nullptr;
   BaseBeamScorer<CTCBeamState>* beam_scorer_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(CTCBeamSearchDecoder);
@@ -365,14 +366,15 @@ template <typename CTCBeamState, typename CTCBeamComparer>
 void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Reset() {
   leaves_.Reset();
 
-  // This beam root, and all of its children, will be in memory until
-  // the next reset.
-  beam_root_.reset(new BeamEntry(nullptr, -1));
+  // This beam root, and all of its children, will be valid until the next
+  // reset, which reuses their memory.
+  arena_.Clear();
+  beam_root_ = arena_.New(nullptr, -1);
   beam_root_->newp.total = 0.0;  // ln(1)
   beam_root_->newp.blank = 0.0;  // ln(1)
 
   // Add the root as the initial leaf.
-  leaves_.push(beam_root_.get());
+  leaves_.push(beam_root_);
 
   // Call initialize state on the root object.
   beam_scorer_->InitializeState(&beam_root_->state);
@@ -221,6 +221,77 @@ TEST(CtcBeamSearch, AllBeamElementsHaveFiniteScores) {
   }
 }
 
+TEST(CtcBeamSearch, ReusedBeamEntriesMatchFreshDecoder) {
+  const int batch_size = 2;
+  const int timesteps = 5;
+  const int top_paths = 3;
+  const int num_classes = 6;
+
+  // The second batch entry reuses the beam entries of the first one, which
+  // must not leak their children or states into its search.
+  DictionaryBeamScorer dictionary_scorer;
+  CTCBeamSearchDecoder<HistoryBeamState> decoder(
+      num_classes, top_paths, &dictionary_scorer, batch_size);
+
+  int sequence_lengths[batch_size] = {timesteps, timesteps - 1};
+  float input_data_mat[timesteps][batch_size][num_classes] = {
+      {{0, 0.6, 0, 0.4, 0, 0}, {0.1, 0.2, 0.3, 0.1, 0.2, 0.1}},
+      {{0, 0.5, 0, 0.5, 0, 0}, {0.3, 0.1, 0.1, 0.2, 0.2, 0.1}},
+      {{0, 0.4, 0, 0.6, 0, 0}, {0.2, 0.2, 0.1, 0.3, 0.1, 0.1}},
+      {{0, 0.4, 0, 0.6, 0, 0}, {0.1, 0.4, 0.1, 0.1, 0.1, 0.2}},
+      {{0, 0.4, 0, 0.6, 0, 0}, {0.2, 0.2, 0.2, 0.2, 0.1, 0.1}}};
+  for (int t = 0; t < timesteps; ++t) {
+    for (int b = 0; b < batch_size; ++b) {
+      for (int c = 0; c < num_classes; ++c) {
+        input_data_mat[t][b][c] = std::log(input_data_mat[t][b][c]);
+      }
+    }
+  }
+
+  Eigen::Map<const Eigen::ArrayXi> seq_len(&sequence_lengths[0], batch_size);
+  std::vector<Eigen::Map<const Eigen::MatrixXf>> inputs;
+  inputs.reserve(timesteps);
+  for (int t = 0; t < timesteps; ++t) {
+    inputs.emplace_back(&input_data_mat[t][0][0], batch_size, num_classes);
+  }
+  std::vector<CTCDecoder::Output> outputs(top_paths);
+  for (CTCDecoder::Output& output : outputs) {
+    output.resize(batch_size);
+  }
+  float score[batch_size][top_paths] = {{0.0}};
+  Eigen::Map<Eigen::MatrixXf> scores(&score[0][0], batch_size, top_paths);
+  EXPECT_TRUE(decoder.Decode(seq_len, inputs, &outputs, &scores).ok());
+
+  // Decodes the second batch entry alone.
+  CTCBeamSearchDecoder<HistoryBeamState> fresh_decoder(num_classes, top_paths,
+                                                       &dictionary_scorer);
+  float single_input_data_mat[timesteps][num_classes];
+  std::vector<Eigen::Map<const Eigen::MatrixXf>> single_inputs;
+  single_inputs.reserve(timesteps);
+  for (int t = 0; t < timesteps; ++t) {
+    for (int c = 0; c < num_classes; ++c) {
+      single_input_data_mat[t][c] = inputs[t](1, c);
+    }
+    single_inputs.emplace_back(&single_input_data_mat[t][0], 1, num_classes);
+  }
+  Eigen::Map<const Eigen::ArrayXi> single_seq_len(&sequence_lengths[1], 1);
+  std::vector<CTCDecoder::Output> single_outputs(top_paths);
+  for (CTCDecoder::Output& output : single_outputs) {
+    output.resize(1);
+  }
+  float single_score[1][top_paths] = {{0.0}};
+  Eigen::Map<Eigen::MatrixXf> single_scores(&single_score[0][0], 1, top_paths);
+  EXPECT_TRUE(fresh_decoder
+                  .Decode(single_seq_len, single_inputs, &single_outputs,
+                          &single_scores)
+                  .ok());
+
+  for (int path = 0; path < top_paths; ++path) {
+    EXPECT_EQ(single_outputs[path][0], outputs[path][1]);
+    EXPECT_EQ(single_scores(0, path), scores(1, path));
+  }
+}
+
 // A beam decoder to test label selection. It simply models N labels with
 // rapidly dropping off log-probability.
 
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/util/events_writer.h"
 
 #include <stddef.h>  // for NULL
+#include <algorithm>
 
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/path.h"
@@ -33,7 +34,30 @@ EventsWriter::EventsWriter(const string& file_prefix)
     // TODO(jeff,sanjay): Pass in env and use that here instead of Env::Default
     : env_(Env::Default()),
       file_prefix_(file_prefix),
-      num_outstanding_events_(0) {}
+      num_outstanding_events_(0),
+      async_(false) {}
+
+EventsWriter::EventsWriter(const string& file_prefix,
+                           const AsyncOptions& async_options)
+    : env_(Env::Default()),
+      file_prefix_(file_prefix),
+      num_outstanding_events_(0),
+      async_(true),
+      async_options_(async_options) {
+  thread_.reset(env_->StartThread(ThreadOptions(), "events_writer",
+                                  [this]() { WriteQueuedEvents(); }));
+}
+
+int64 EventsWriter::num_dropped_events() {
+  mutex_lock l(mu_);
+  return num_dropped_events_;
+}
+
+bool EventsWriter::InitWithSuffix(const string& suffix) {
+  mutex_lock l(file_mu_);
+  file_suffix_ = suffix;
+  return InitIfNeeded();
+}
 
 bool EventsWriter::InitIfNeeded() {
   if (recordio_writer_ != nullptr) {
@@ -76,13 +100,16 @@ bool EventsWriter::InitIfNeeded() {
     Event event;
     event.set_wall_time(time_in_seconds);
     event.set_file_version(strings::StrCat(kVersionPrefix, kCurrentVersion));
-    WriteEvent(event);
-    Flush();
+    string record;
+    event.AppendToString(&record);
+    WriteRecord(record);
+    FlushFile();
   }
   return true;
 }
 
 string EventsWriter::FileName() {
+  mutex_lock l(file_mu_);
   if (filename_.empty()) {
     InitIfNeeded();
   }
@@ -90,6 +117,32 @@ string EventsWriter::FileName() {
 }
 
 void EventsWriter::WriteSerializedEvent(StringPiece event_str) {
+  if (async_) {
+    mutex_lock l(mu_);
+    const size_t max_queue_size =
+        std::max(async_options_.max_queue_size, 1);
+    while (!stopping_ && queue_.size() >= max_queue_size) {
+      if (async_options_.drop_when_full) {
+        if (num_dropped_events_++ == 0) {
+          LOG(WARNING) << "Dropping events because the queue of the events "
+                       << "writer of " << file_prefix_ << " is full.";
+        }
+        return;
+      }
+      done_cv_.wait(l);
+    }
+    if (!stopping_) {
+      queue_.push_back(event_str.ToString());
+      queue_cv_.notify_one();
+      return;
+    }
+  }
+  // Once closed, an asynchronous EventsWriter writes synchronously.
+  mutex_lock l(file_mu_);
+  WriteRecord(event_str);
+}
+
+void EventsWriter::WriteRecord(StringPiece event_str) {
   if (recordio_writer_ == nullptr) {
     if (!InitIfNeeded()) {
       LOG(ERROR) << "Write failed because file could not be opened.";
@@ -109,6 +162,20 @@ void EventsWriter::WriteEvent(const Event& event) {
 }
 
 bool EventsWriter::Flush() {
+  if (async_) {
+    mutex_lock l(mu_);
+    if (!stopping_) {
+      const int64 request = ++flush_requests_;
+      queue_cv_.notify_one();
+      while (flushes_done_ < request) done_cv_.wait(l);
+      return last_flush_ok_;
+    }
+  }
+  mutex_lock l(file_mu_);
+  return FlushFile();
+}
+
+bool EventsWriter::FlushFile() {
   if (num_outstanding_events_ == 0) return true;
   CHECK(recordio_file_ != nullptr) << "Unexpected NULL file";
 
@@ -137,8 +204,79 @@ bool EventsWriter::Flush() {
   return true;
 }
 
+void EventsWriter::WriteQueuedEvents() {
+  // The bytes written since the last flush, and when the first of them was.
+  int64 unflushed_bytes = 0;
+  uint64 unflushed_since_micros = 0;
+  int64 flushes_done = 0;
+  const int64 flush_micros = async_options_.flush_millis * 1000;
+  bool stopping = false;
+  while (!stopping) {
+    std::deque<string> batch;
+    int64 flush_request;
+    {
+      mutex_lock l(mu_);
+      while (queue_.empty() && flush_requests_ == flushes_done && !stopping_) {
+        if (unflushed_bytes == 0) {
+          queue_cv_.wait(l);
+          continue;
+        }
+        const int64 wait_micros =
+            static_cast<int64>(unflushed_since_micros + flush_micros) -
+            static_cast<int64>(env_->NowMicros());
+        if (wait_micros <= 0) break;
+        queue_cv_.wait_for(l, std::chrono::microseconds(wait_micros));
+      }
+      batch.swap(queue_);
+      flush_request = flush_requests_;
+      stopping = stopping_;
+      done_cv_.notify_all();
+    }
+
+    bool flush = false;
+    bool flush_ok = true;
+    {
+      mutex_lock l(file_mu_);
+      for (const string& event_str : batch) {
+        if (unflushed_bytes == 0) unflushed_since_micros = env_->NowMicros();
+        WriteRecord(event_str);
+        unflushed_bytes += event_str.size();
+      }
+      flush = stopping || flush_request > flushes_done ||
+              unflushed_bytes >= async_options_.flush_bytes ||
+              (unflushed_bytes > 0 &&
+               env_->NowMicros() >= unflushed_since_micros + flush_micros);
+      if (flush) {
+        flush_ok = FlushFile();
+        unflushed_bytes = 0;
+      }
+    }
+    if (flush) {
+      flushes_done = flush_request;
+      mutex_lock l(mu_);
+      flushes_done_ = flush_request;
+      last_flush_ok_ = flush_ok;
+      done_cv_.notify_all();
+    }
+  }
+}
+
 bool EventsWriter::Close() {
-  bool return_value = Flush();
+  bool return_value = true;
+  if (thread_ != nullptr) {
+    {
+      mutex_lock l(mu_);
+      stopping_ = true;
+      queue_cv_.notify_one();
+      done_cv_.notify_all();
+    }
+    // The background thread flushes the remaining events before it exits.
+    thread_.reset();
+    mutex_lock l(mu_);
+    return_value = last_flush_ok_;
+  }
+  mutex_lock l(file_mu_);
+  if (!FlushFile()) return_value = false;
   if (recordio_file_ != nullptr) {
     Status s = recordio_file_->Close();
     if (!s.ok()) {
@@ -16,11 +16,14 @@ limitations under the License.
 #ifndef TENSORFLOW_UTIL_EVENTS_WRITER_H_
 #define TENSORFLOW_UTIL_EVENTS_WRITER_H_
 
+#include <deque>
 #include <memory>
 #include <string>
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/event.pb.h"
 
@@ -45,6 +48,37 @@ class EventsWriter {
   explicit EventsWriter(const string& file_prefix);
   ~EventsWriter() { Close(); }  // Autoclose in destructor.
 
+#ifndef SWIG
+  // Options of an EventsWriter that writes its events asynchronously.
+  struct AsyncOptions {
+    // The maximum number of events that wait to be written.
+    int max_queue_size = 1024;
+
+    // If true, WriteEvent() drops the events that do not fit in the queue.
+    // Otherwise it blocks until the queue has room for them.
+    bool drop_when_full = false;
+
+    // The file is flushed once this many bytes of events have been written
+    // since the last flush, or once the oldest of them was written this many
+    // milliseconds ago.
+    int64 flush_bytes = 1 << 20;
+    int64 flush_millis = 2000;
+  };
+
+  // Creates an EventsWriter whose WriteEvent() only queues the events. A
+  // background thread writes the queued events in batches, and flushes the
+  // file as set by "async_options". Flush() and Close() wait until the events
+  // written before them are flushed.
+  //
+  // Unlike with the synchronous EventsWriter, WriteEvent() and Flush() may be
+  // called concurrently.
+  EventsWriter(const string& file_prefix, const AsyncOptions& async_options);
+
+  // Returns the number of events that were dropped because the queue was
+  // full.
+  int64 num_dropped_events();
+#endif
+
   // Sets the event file filename and opens file for writing.  If not called by
   // user, will be invoked automatically by a call to FileName() or Write*().
   // Returns false if the file could not be opened.  Idempotent: if file exists
@@ -52,10 +86,7 @@ class EventsWriter {
   // but has since disappeared (e.g. deleted by another process), this will open
   // a new file with a new timestamp in its filename.
   bool Init() { return InitWithSuffix(""); }
-  bool InitWithSuffix(const string& suffix) {
-    file_suffix_ = suffix;
-    return InitIfNeeded();
-  }
+  bool InitWithSuffix(const string& suffix);
 
   // Returns the filename for the current events file:
   // filename_ = [file_prefix_].out.events.[timestamp].[hostname][suffix]
@@ -81,8 +112,15 @@ class EventsWriter {
   bool Close();
 
  private:
+#ifndef SWIG
   bool FileHasDisappeared();  // True if event_file_path_ does not exist.
-  bool InitIfNeeded();
+  bool InitIfNeeded() EXCLUSIVE_LOCKS_REQUIRED(file_mu_);
+  // Writes "event_str" to the file, opening it if needed.
+  void WriteRecord(StringPiece event_str) EXCLUSIVE_LOCKS_REQUIRED(file_mu_);
+  // Flushes the events written to the file.
+  bool FlushFile() EXCLUSIVE_LOCKS_REQUIRED(file_mu_);
+  // The loop of the background thread of an asynchronous EventsWriter.
+  void WriteQueuedEvents();
 
   Env* env_;
   const string file_prefix_;
@@ -91,6 +129,33 @@ class EventsWriter {
   std::unique_ptr<WritableFile> recordio_file_;
   std::unique_ptr<io::RecordWriter> recordio_writer_;
   int num_outstanding_events_;
+
+  // Serializes the writes to the file of the background thread with the
+  // calls that open or close it.
+  mutex file_mu_;
+
+  // The state of an asynchronous EventsWriter.
+  const bool async_;
+  const AsyncOptions async_options_;
+  mutex mu_;
+  // Notified when events are queued, a flush is requested, or the writer is
+  // closed.
+  condition_variable queue_cv_;
+  // Notified when queued events are taken for writing, or a flush completes.
+  condition_variable done_cv_;
+  // The serialized events that wait to be written.
+  std::deque<string> queue_ GUARDED_BY(mu_);
+  int64 num_dropped_events_ GUARDED_BY(mu_) = 0;
+  // The number of calls to Flush(), and the number of them that the
+  // background thread has completed, with the result of the last one.
+  int64 flush_requests_ GUARDED_BY(mu_) = 0;
+  int64 flushes_done_ GUARDED_BY(mu_) = 0;
+  bool last_flush_ok_ GUARDED_BY(mu_) = true;
+  // Set once the background thread is asked to exit by Close(), after which
+  // the events are written synchronously.
+  bool stopping_ GUARDED_BY(mu_) = false;
+  std::unique_ptr<Thread> thread_;
+#endif
   TF_DISALLOW_COPY_AND_ASSIGN(EventsWriter);
 };
 
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
@@ -207,5 +208,72 @@ TEST(EventWriter, FileDeletionBeforeWriting) {
   VerifyFile(filename1);
 }
 
+TEST(EventWriter, AsyncWriteFlush) {
+  string file_prefix = GetDirName("/async_writeflush_test");
+  EventsWriter writer(file_prefix, EventsWriter::AsyncOptions());
+  WriteFile(&writer);
+  EXPECT_TRUE(writer.Flush());
+  string filename = writer.FileName();
+  VerifyFile(filename);
+}
+
+TEST(EventWriter, AsyncWriteClose) {
+  string file_prefix = GetDirName("/async_writeclose_test");
+  EventsWriter::AsyncOptions options;
+  options.max_queue_size = 1;
+  EventsWriter writer(file_prefix, options);
+  WriteFile(&writer);
+  EXPECT_TRUE(writer.Close());
+  string filename = writer.FileName();
+  VerifyFile(filename);
+}
+
+// Counts the events of "filename", after the one with the file version.
+int CountEvents(const string& filename) {
+  std::unique_ptr<RandomAccessFile> event_file;
+  TF_CHECK_OK(env()->NewRandomAccessFile(filename, &event_file));
+  io::RecordReader reader(event_file.get());
+  uint64 offset = 0;
+  Event event;
+  int count = -1;
+  while (ReadEventProto(&reader, &offset, &event)) ++count;
+  return count;
+}
+
+TEST(EventWriter, AsyncConcurrentWrites) {
+  string file_prefix = GetDirName("/async_concurrent_test");
+  EventsWriter::AsyncOptions options;
+  options.max_queue_size = 4;
+  options.flush_bytes = 100;
+  EventsWriter writer(file_prefix, options);
+  {
+    thread::ThreadPool pool(env(), "writers", 4);
+    for (int i = 0; i < 4; ++i) {
+      pool.Schedule([&writer, i]() {
+        for (int step = 0; step < 100; ++step) {
+          WriteSimpleValue(&writer, 1234, step, strings::StrCat("tag", i), 1);
+        }
+      });
+    }
+  }
+  EXPECT_TRUE(writer.Close());
+  EXPECT_EQ(0, writer.num_dropped_events());
+  EXPECT_EQ(400, CountEvents(writer.FileName()));
+}
+
+TEST(EventWriter, AsyncDropWhenFull) {
+  string file_prefix = GetDirName("/async_drop_test");
+  EventsWriter::AsyncOptions options;
+  options.max_queue_size = 1;
+  options.drop_when_full = true;
+  EventsWriter writer(file_prefix, options);
+  for (int step = 0; step < 1000; ++step) {
+    WriteSimpleValue(&writer, 1234, step, "foo", 1);
+  }
+  EXPECT_TRUE(writer.Close());
+  // Every event is either written or dropped.
+  EXPECT_EQ(1000, writer.num_dropped_events() + CountEvents(writer.FileName()));
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
+#include <string.h>
+#include <algorithm>
 #include <vector>
 
 #include "tensorflow/core/example/example.pb.h"
@@ -23,10 +25,12 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/casts.h"
+#include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/util/presized_cuckoo_map.h"
@@ -60,6 +64,75 @@ constexpr uint8 kVarintTag(uint32 tag) { return (tag << 3) | 0; }
 constexpr uint8 kDelimitedTag(uint32 tag) { return (tag << 3) | 2; }
 constexpr uint8 kFixed32Tag(uint32 tag) { return (tag << 3) | 5; }
 
+template <typename T>
+class LimitedArraySlice {
+ public:
+  LimitedArraySlice(T* begin, size_t num_elements)
+      : current_(begin), end_(begin + num_elements) {}
+
+  // May return negative if there were push_back calls after slice was filled.
+  int64 EndDistance() const { return end_ - current_; }
+
+  // Attempts to push value to the back of this. If the slice has
+  // already been filled, this method has no effect on the underlying data, but
+  // it changes the number returned by EndDistance into negative values.
+  void push_back(T&& value) {
+    if (EndDistance() > 0) *current_ = std::move(value);
+    ++current_;
+  }
+
+  // Same as `n` calls to push_back() with the values that `src`, which need
+  // not be aligned, holds in host byte order.
+  void AppendUnaligned(const char* src, size_t n) {
+    const int64 fits = std::min<int64>(std::max<int64>(EndDistance(), 0), n);
+    memcpy(current_, src, fits * sizeof(T));
+    current_ += n;
+  }
+
+ private:
+  T* current_;
+  T* end_;
+};
+
+template <typename T>
+void AppendUnaligned(const char* src, size_t n, LimitedArraySlice<T>* out) {
+  out->AppendUnaligned(src, n);
+}
+
+template <typename T>
+void AppendUnaligned(const char* src, size_t n, SmallVector<T>* out) {
+  const size_t old_size = out->size();
+  out->resize(old_size + n);
+  memcpy(out->data() + old_size, src, n * sizeof(T));
+}
+
+// Decodes the packed varints in [p, end) and appends them to `out`. Runs of
+// single-byte varints, which dominate typical id and label features, are
+// recognized eight at a time by testing their continuation bits together.
+template <typename Result>
+bool ParsePackedVarints(const char* p, const char* end, Result* out) {
+  constexpr uint64 kContinuationBits = 0x8080808080808080ULL;
+  while (p < end) {
+    if (end - p >= 8) {
+      uint64 word;
+      memcpy(&word, p, sizeof(word));
+      if ((word & kContinuationBits) == 0) {
+        const uint8* bytes = reinterpret_cast<const uint8*>(p);
+        for (int i = 0; i < 8; ++i) {
+          out->push_back(static_cast<int64>(bytes[i]));
+        }
+        p += 8;
+        continue;
+      }
+    }
+    uint64 n;
+    p = core::GetVarint64Ptr(p, end, &n);
+    if (p == nullptr) return false;
+    out->push_back(static_cast<int64>(n));
+  }
+  return true;
+}
+
 namespace parsed {
 
 // ParseDataType has to be called first, then appropriate ParseZzzzList.
@@ -139,15 +212,26 @@ class Feature {
         if (!stream.ExpectTag(kDelimitedTag(1))) return false;  // packed tag
         uint32 packed_length;
         if (!stream.ReadVarint32(&packed_length)) return false;
-        auto packed_limit = stream.PushLimit(packed_length);
+        const void* packed_data;
+        int available;
+        if (port::kLittleEndian && packed_length % sizeof(float) == 0 &&
+            stream.GetDirectBufferPointer(&packed_data, &available) &&
+            static_cast<uint32>(available) >= packed_length) {
+          // The wire format matches the host layout, so copy in bulk.
+          AppendUnaligned(static_cast<const char*>(packed_data),
+                          packed_length / sizeof(float), float_list);
+          if (!stream.Skip(packed_length)) return false;
+        } else {
+          auto packed_limit = stream.PushLimit(packed_length);
+
+          while (!stream.ExpectAtEnd()) {
+            uint32 buffer32;
+            if (!stream.ReadLittleEndian32(&buffer32)) return false;
+            float_list->push_back(bit_cast<float>(buffer32));
+          }
 
-        while (!stream.ExpectAtEnd()) {
-          uint32 buffer32;
-          if (!stream.ReadLittleEndian32(&buffer32)) return false;
-          float_list->push_back(bit_cast<float>(buffer32));
+          stream.PopLimit(packed_limit);
         }
-
-        stream.PopLimit(packed_limit);
       } else {  // non-packed
         while (!stream.ExpectAtEnd()) {
           if (!stream.ExpectTag(kFixed32Tag(1))) return false;
@@ -181,15 +265,21 @@ class Feature {
         if (!stream.ExpectTag(kDelimitedTag(1))) return false;  // packed tag
         uint32 packed_length;
         if (!stream.ReadVarint32(&packed_length)) return false;
-        auto packed_limit = stream.PushLimit(packed_length);
-
-        while (!stream.ExpectAtEnd()) {
-          protobuf_uint64 n;  // There is no API for int64
-          if (!stream.ReadVarint64(&n)) return false;
-          int64_list->push_back(static_cast<int64>(n));
+        if (packed_length > 0) {
+          // Decode straight from the buffer rather than through `stream`,
+          // which bounds-checks every byte.
+          const void* packed_data;
+          int available;
+          if (!stream.GetDirectBufferPointer(&packed_data, &available) ||
+              static_cast<uint32>(available) < packed_length) {
+            return false;
+          }
+          const char* begin = static_cast<const char*>(packed_data);
+          if (!ParsePackedVarints(begin, begin + packed_length, int64_list)) {
+            return false;
+          }
+          if (!stream.Skip(packed_length)) return false;
         }
-
-        stream.PopLimit(packed_limit);
       } else {  // non-packed
         while (!stream.ExpectAtEnd()) {
           if (!stream.ExpectTag(kVarintTag(1))) return false;
@@ -425,28 +515,6 @@ struct SeededHasher {
   uint64 seed{0xDECAFCAFFE};
 };
 
-template <typename T>
-class LimitedArraySlice {
- public:
-  LimitedArraySlice(T* begin, size_t num_elements)
-      : current_(begin), end_(begin + num_elements) {}
-
-  // May return negative if there were push_back calls after slice was filled.
-  int64 EndDistance() const { return end_ - current_; }
-
-  // Attempts to push value to the back of this. If the slice has
-  // already been filled, this method has no effect on the underlying data, but
-  // it changes the number returned by EndDistance into negative values.
-  void push_back(T&& value) {
-    if (EndDistance() > 0) *current_ = std::move(value);
-    ++current_;
-  }
-
- private:
-  T* current_;
-  T* end_;
-};
-
 Status FastParseSerializedExample(
     const string& serialized_example, const string& example_name,
     const size_t example_index, const Config& config,
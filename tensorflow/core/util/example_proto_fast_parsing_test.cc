@@ -16,6 +16,7 @@ limitations under the License.
 
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/protobuf.h"
@@ -166,6 +167,20 @@ TEST(FastParse, Packed) {
       "\x0a\x0d\x0a\x0b\x0a\x03\x61\x67\x65\x12\x04\x1a\x02\x08\x0d");
 }
 
+TEST(FastParse, LongPackedLists) {
+  Example example;
+  auto& fmap = *example.mutable_features()->mutable_feature();
+  auto* int64_list = fmap["int64"].mutable_int64_list();
+  auto* float_list = fmap["float"].mutable_float_list();
+  // Runs of single-byte varints interleaved with multi-byte and negative
+  // values, so both the bulk and the per-value paths are exercised.
+  for (int i = 0; i < 100; ++i) {
+    int64_list->add_value(i % 17 == 0 ? -i * 1000003LL : i % 100);
+    float_list->add_value(i * 0.25f);
+  }
+  TestCorrectness(Serialize(example));
+}
+
 TEST(FastParse, EmptyFeatures) {
   Example example;
   example.mutable_features();
@@ -372,6 +387,53 @@ TEST(TestFastParseExample, Empty) {
   EXPECT_TRUE(status.ok()) << status;
 }
 
+TEST(TestFastParseExample, DensePackedLists) {
+  const int kNumValues = 19;
+  std::vector<string> serialized;
+  for (int e = 0; e < 2; ++e) {
+    Example example;
+    auto& fmap = *example.mutable_features()->mutable_feature();
+    for (int i = 0; i < kNumValues; ++i) {
+      fmap[kDenseInt64Key].mutable_int64_list()->add_value(
+          i == 9 ? 1LL << 40 : e * 100 + i);
+      fmap[kDenseFloatKey].mutable_float_list()->add_value(e + i * 0.5f);
+    }
+    serialized.push_back(Serialize(example));
+  }
+
+  FastParseExampleConfig config;
+  config.dense.push_back({kDenseInt64Key, DT_INT64,
+                          PartialTensorShape({kNumValues}),
+                          Tensor(DT_INT64, TensorShape({0})), false,
+                          kNumValues});
+  config.dense.push_back({kDenseFloatKey, DT_FLOAT,
+                          PartialTensorShape({kNumValues}),
+                          Tensor(DT_FLOAT, TensorShape({0})), false,
+                          kNumValues});
+  Result result;
+  TF_EXPECT_OK(FastParseExample(config, serialized, {}, nullptr, &result));
+  ASSERT_EQ(2, result.dense_values.size());
+  auto int64_values = result.dense_values[0].matrix<int64>();
+  auto float_values = result.dense_values[1].matrix<float>();
+  for (int e = 0; e < 2; ++e) {
+    for (int i = 0; i < kNumValues; ++i) {
+      EXPECT_EQ(i == 9 ? 1LL << 40 : e * 100 + i, int64_values(e, i));
+      EXPECT_EQ(e + i * 0.5f, float_values(e, i));
+    }
+  }
+
+  // One value too many is still detected.
+  Example example;
+  auto& fmap = *example.mutable_features()->mutable_feature();
+  for (int i = 0; i <= kNumValues; ++i) {
+    fmap[kDenseInt64Key].mutable_int64_list()->add_value(i);
+    fmap[kDenseFloatKey].mutable_float_list()->add_value(i);
+  }
+  serialized = {Serialize(example)};
+  EXPECT_FALSE(
+      FastParseExample(config, serialized, {}, nullptr, &result).ok());
+}
+
 }  // namespace
 
 }  // namespace example
@@ -0,0 +1,67 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/parallelism_governor.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+/* static */
+ParallelismGovernor* ParallelismGovernor::Global() {
+  static ParallelismGovernor* const governor = new ParallelismGovernor;
+  return governor;
+}
+
+ParallelismGovernor::ParallelismGovernor()
+    : max_threads_(0), busy_threads_(0) {}
+
+void ParallelismGovernor::Enable(int max_threads) {
+  CHECK_GE(max_threads, 1);
+  max_threads_ = max_threads;
+}
+
+ParallelismGovernor::BusyScope::BusyScope(ParallelismGovernor* governor)
+    : governor_(governor) {
+  ++governor_->busy_threads_;
+}
+
+ParallelismGovernor::BusyScope::~BusyScope() { --governor_->busy_threads_; }
+
+ParallelismGovernor::Reservation::Reservation(ParallelismGovernor* governor,
+                                              int max_parallelism)
+    : governor_(governor), reserved_(0) {
+  const int wanted = max_parallelism - 1;
+  int busy = governor_->busy_threads_.load(std::memory_order_relaxed);
+  while (wanted > 0) {
+    reserved_ = std::min(wanted, governor_->max_threads_ - busy);
+    if (reserved_ <= 0) {
+      reserved_ = 0;
+      break;
+    }
+    if (governor_->busy_threads_.compare_exchange_weak(busy,
+                                                       busy + reserved_)) {
+      break;
+    }
+  }
+}
+
+ParallelismGovernor::Reservation::~Reservation() {
+  governor_->busy_threads_ -= reserved_;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,89 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_UTIL_PARALLELISM_GOVERNOR_H_
+#define TENSORFLOW_UTIL_PARALLELISM_GOVERNOR_H_
+
+#include <atomic>
+
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+
+// Bounds the number of threads that run CPU ops and their shards at once, so
+// that ops running concurrently on the inter-op threads do not oversubscribe
+// the machine when each of them shards its work on the intra-op threads.
+//
+// When enabled, ThreadPoolDevice counts each op it runs as one busy thread,
+// and Shard() reserves threads for its shards beyond the calling thread, at
+// most as many as are not busy.  A Shard() call without free threads runs
+// its work in the calling thread.
+//
+// This class is thread-safe.
+class ParallelismGovernor {
+ public:
+  // Returns the process-wide governor, which is disabled until Enable().
+  static ParallelismGovernor* Global();
+
+  ParallelismGovernor();
+
+  // Enables the governor, with at most "max_threads" busy threads.
+  // REQUIRES: max_threads >= 1
+  void Enable(int max_threads);
+
+  bool enabled() const { return max_threads_ > 0; }
+
+  // Counts the calling thread as busy while in scope, e.g. to run an op.
+  class BusyScope {
+   public:
+    explicit BusyScope(ParallelismGovernor* governor);
+    ~BusyScope();
+
+   private:
+    ParallelismGovernor* const governor_;
+
+    TF_DISALLOW_COPY_AND_ASSIGN(BusyScope);
+  };
+
+  // Reserves up to "max_parallelism" - 1 threads in addition to the calling
+  // thread while in scope.
+  class Reservation {
+   public:
+    Reservation(ParallelismGovernor* governor, int max_parallelism);
+    ~Reservation();
+
+    // The number of threads reserved, plus 1 for the calling thread.
+    int parallelism() const { return 1 + reserved_; }
+
+   private:
+    ParallelismGovernor* const governor_;
+    int reserved_;
+
+    TF_DISALLOW_COPY_AND_ASSIGN(Reservation);
+  };
+
+  // The number of busy and reserved threads.
+  int busy_threads() const { return busy_threads_; }
+
+ private:
+  std::atomic<int> max_threads_;
+  std::atomic<int> busy_threads_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ParallelismGovernor);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_UTIL_PARALLELISM_GOVERNOR_H_
@@ -0,0 +1,51 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/parallelism_governor.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(ParallelismGovernor, ReservesFreeThreads) {
+  ParallelismGovernor governor;
+  EXPECT_FALSE(governor.enabled());
+  governor.Enable(4);
+  EXPECT_TRUE(governor.enabled());
+  {
+    // Two ops are running.
+    ParallelismGovernor::BusyScope op1(&governor);
+    ParallelismGovernor::BusyScope op2(&governor);
+    EXPECT_EQ(2, governor.busy_threads());
+
+    ParallelismGovernor::Reservation shards1(&governor, 8);
+    EXPECT_EQ(3, shards1.parallelism());
+    EXPECT_EQ(4, governor.busy_threads());
+    {
+      // No threads are left, so the work runs in the calling thread.
+      ParallelismGovernor::Reservation shards2(&governor, 8);
+      EXPECT_EQ(1, shards2.parallelism());
+      EXPECT_EQ(4, governor.busy_threads());
+    }
+  }
+  EXPECT_EQ(0, governor.busy_threads());
+
+  ParallelismGovernor::Reservation shards(&governor, 2);
+  EXPECT_EQ(2, shards.parallelism());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -75,6 +75,11 @@ class TestReporter {
   Status Benchmark(int64 iters, double cpu_time, double wall_time,
                    double throughput);
 
+  // Record an additional named value with the benchmark, in its 'extras'.
+  // Only does something if the reporting env flag is set.
+  Status SetProperty(const string& name, const string& value);
+  Status SetProperty(const string& name, double value);
+
   // TODO(b/32704451): Don't just ignore the ::tensorflow::Status object!
   ~TestReporter() { Close().IgnoreError(); }  // Autoclose in destructor.
 
@@ -16,13 +16,18 @@ limitations under the License.
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb_text.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/types.h"
@@ -34,9 +39,11 @@ limitations under the License.
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/cache.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/random/random.h"
@@ -379,10 +386,78 @@ table::Options TableBuilderOptions() {
   return o;
 }
 
+// The allocator name reported by tensors returned by LookupMapped().
+constexpr char kMappedAllocatorName[] = "mapped_bundle";
+
+// Number of live MappedDataFiles, so that IsMappedBundleTensor() is cheap
+// when no bundle is mapped.
+std::atomic<int64> num_mapped_data_files(0);
+
+// A memory-mapped data file, shared by the reader and the tensors backed by
+// it.
+class MappedDataFile : public core::RefCounted {
+ public:
+  explicit MappedDataFile(std::unique_ptr<ReadOnlyMemoryRegion> region)
+      : region_(std::move(region)) {
+    num_mapped_data_files.fetch_add(1, std::memory_order_relaxed);
+  }
+  ~MappedDataFile() override {
+    num_mapped_data_files.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  const char* data() const { return static_cast<const char*>(region_->data()); }
+  uint64 length() const { return region_->length(); }
+
+ private:
+  std::unique_ptr<ReadOnlyMemoryRegion> region_;
+};
+
+// A tensor buffer pointing into a MappedDataFile.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(MappedDataFile* file, const char* data, size_t size)
+      : file_(file), data_(data), size_(size) {
+    file_->Ref();
+  }
+
+  void* data() const override { return const_cast<char*>(data_); }
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name(kMappedAllocatorName);
+  }
+
+  // The mapped pages are read-only, so they must not be forwarded.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  ~MappedTensorBuffer() override { file_->Unref(); }
+
+  MappedDataFile* const file_;
+  const char* const data_;
+  const size_t size_;
+};
+
 }  // namespace
 
-BundleWriter::BundleWriter(Env* env, StringPiece prefix)
+// A data file of a BundleWriter with several of them.
+struct BundleWriter::DataShard {
+  string tmp_path;
+  std::unique_ptr<FileOutputBuffer> out;
+  int64 size = 0;  // Number of bytes written into out.
+  // Number of bytes of the tensors added to this shard so far, written or
+  // not.
+  int64 added_bytes = 0;
+  Status status;  // The first error of the writes.
+  // Writes the tensors in the order in which they were added.  Declared
+  // last, so that its writes finish before the other fields are destroyed.
+  std::unique_ptr<thread::ThreadPool> thread;
+};
+
+BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
     : env_(env),
+      options_(options),
       prefix_(prefix.ToString()),
       tmp_metadata_path_(strings::StrCat(MetaFilename(prefix_), ".tempstate",
                                          random::New64())),
@@ -390,10 +465,37 @@ BundleWriter::BundleWriter(Env* env, StringPiece prefix)
                                      random::New64())),
       out_(nullptr),
       size_(0) {
+  if (options_.data_alignment < 1) {
+    status_ = errors::InvalidArgument("Invalid data alignment: ",
+                                      options_.data_alignment);
+    return;
+  }
+  if (options_.num_shards < 1) {
+    status_ = errors::InvalidArgument("Invalid number of data shards: ",
+                                      options_.num_shards);
+    return;
+  }
   status_ = env_->CreateDir(io::Dirname(prefix_).ToString());
   if (!status_.ok() && !errors::IsAlreadyExists(status_)) {
     return;
   }
+  if (options_.num_shards > 1) {
+    for (int i = 0; i < options_.num_shards; ++i) {
+      std::unique_ptr<DataShard> shard(new DataShard);
+      shard->tmp_path =
+          strings::StrCat(DataFilename(prefix_, i, options_.num_shards),
+                          ".tempstate", random::New64());
+      std::unique_ptr<WritableFile> wrapper;
+      status_ = env_->NewWritableFile(shard->tmp_path, &wrapper);
+      if (!status_.ok()) return;
+      shard->out.reset(new FileOutputBuffer(wrapper.release(), 8 << 20));
+      shard->thread.reset(
+          new thread::ThreadPool(env_, "bundle_writer", 1 /* num_threads */));
+      VLOG(1) << "Writing to file " << shard->tmp_path;
+      shards_.push_back(std::move(shard));
+    }
+    return;
+  }
   const string filename = DataFilename(prefix_, 0, 1);
   std::unique_ptr<WritableFile> wrapper;
   status_ = env_->NewWritableFile(tmp_data_path_, &wrapper);
@@ -404,6 +506,17 @@ BundleWriter::BundleWriter(Env* env, StringPiece prefix)
   VLOG(1) << "Writing to file " << tmp_data_path_;
 }
 
+BundleWriter::~BundleWriter() {
+  // Waits for the pending writes, which refer to "entries_".
+  for (auto& shard : shards_) shard->thread.reset();
+  for (auto& shard : shards_) {
+    if (shard->out != nullptr) {
+      shard->out->Close().IgnoreError();
+      env_->DeleteFile(shard->tmp_path).IgnoreError();
+    }
+  }
+}
+
 Status BundleWriter::Add(StringPiece key, const Tensor& val) {
   if (!status_.ok()) return status_;
   CHECK_NE(key, kHeaderEntryKey);
@@ -416,28 +529,63 @@ Status BundleWriter::Add(StringPiece key, const Tensor& val) {
   BundleEntryProto* entry = &entries_[key_string];
   entry->set_dtype(val.dtype());
   val.shape().AsProto(entry->mutable_shape());
-  entry->set_shard_id(0);
-  entry->set_offset(size_);
+  if (shards_.empty()) {
+    entry->set_shard_id(0);
+    status_ = WriteEntry(val, out_.get(), &size_, entry);
+    return status_;
+  }
+
+  int shard_id = 0;
+  for (int i = 1; i < shards_.size(); ++i) {
+    if (shards_[i]->added_bytes < shards_[shard_id]->added_bytes) {
+      shard_id = i;
+    }
+  }
+  entry->set_shard_id(shard_id);
+  DataShard* shard = shards_[shard_id].get();
+  shard->added_bytes += val.TotalBytes();
+  shard->thread->Schedule([this, shard, val, entry]() {
+    if (!shard->status.ok()) return;
+    shard->status = WriteEntry(val, shard->out.get(), &shard->size, entry);
+  });
+  return status_;
+}
+
+Status BundleWriter::WriteEntry(const Tensor& val, FileOutputBuffer* out,
+                                int64* size, BundleEntryProto* entry) {
+  TF_RETURN_IF_ERROR(PadAlignment(out, size));
+  entry->set_offset(*size);
 
   // Updates the data file.
   size_t data_bytes_written = 0;
   uint32 crc32c = 0;
-  out_->clear_crc32c();
+  out->clear_crc32c();
   if (val.dtype() == DT_STRING) {
-    status_ = WriteStringTensor(val, out_.get(), &data_bytes_written, &crc32c);
+    TF_RETURN_IF_ERROR(
+        WriteStringTensor(val, out, &data_bytes_written, &crc32c));
   } else if (val.dtype() == DT_VARIANT) {
-    status_ = WriteVariantTensor(val, out_.get(), &data_bytes_written, &crc32c);
+    TF_RETURN_IF_ERROR(
+        WriteVariantTensor(val, out, &data_bytes_written, &crc32c));
   } else {
-    status_ = WriteTensor(val, out_.get(), &data_bytes_written);
-    crc32c = out_->crc32c();
+    TF_RETURN_IF_ERROR(WriteTensor(val, out, &data_bytes_written));
+    crc32c = out->crc32c();
   }
 
-  if (status_.ok()) {
-    entry->set_size(data_bytes_written);
-    entry->set_crc32c(crc32c::Mask(crc32c));
-    size_ += data_bytes_written;
-  }
-  return status_;
+  entry->set_size(data_bytes_written);
+  entry->set_crc32c(crc32c::Mask(crc32c));
+  *size += data_bytes_written;
+  return Status::OK();
+}
+
+Status BundleWriter::PadAlignment(FileOutputBuffer* out, int64* size) {
+  const int64 padding =
+      (options_.data_alignment - *size % options_.data_alignment) %
+      options_.data_alignment;
+  if (padding == 0) return Status::OK();
+  const string zeros(padding, '\0');
+  TF_RETURN_IF_ERROR(out->Append(zeros));
+  *size += padding;
+  return Status::OK();
 }
 
 Status BundleWriter::AddSlice(StringPiece full_tensor_key,
@@ -484,6 +632,23 @@ Status BundleWriter::AddSlice(StringPiece full_tensor_key,
 // TODO(zongheng): on metadata write failure or !status_.ok(), consider removing
 // the orphaned data file.
 Status BundleWriter::Finish() {
+  if (!shards_.empty()) {
+    for (int i = 0; i < shards_.size(); ++i) {
+      DataShard* shard = shards_[i].get();
+      shard->thread.reset();
+      status_.Update(shard->status);
+      status_.Update(shard->out->Close());
+      shard->out = nullptr;
+    }
+    for (int i = 0; i < shards_.size(); ++i) {
+      if (status_.ok()) {
+        status_ = Env::Default()->RenameFile(
+            shards_[i]->tmp_path, DataFilename(prefix_, i, shards_.size()));
+      } else {
+        Env::Default()->DeleteFile(shards_[i]->tmp_path).IgnoreError();
+      }
+    }
+  }
   if (out_) {
     status_.Update(out_->Close());
     out_ = nullptr;
@@ -507,7 +672,7 @@ Status BundleWriter::Finish() {
     table::TableBuilder builder(options, file.get());
     // Header entry.
     BundleHeaderProto header;
-    header.set_num_shards(1);
+    header.set_num_shards(std::max<int>(shards_.size(), 1));
     header.set_endianness(BundleHeaderProto::LITTLE);
     if (!port::kLittleEndian) header.set_endianness(BundleHeaderProto::BIG);
     VersionDef* version = header.mutable_version();
@@ -705,6 +870,74 @@ Status MergeBundles(Env* env, gtl::ArraySlice<string> prefixes,
   return status;
 }
 
+bool IsMappedBundleTensor(const Tensor& tensor) {
+  if (num_mapped_data_files.load(std::memory_order_relaxed) == 0) {
+    return false;
+  }
+  TensorDescription description;
+  tensor.FillDescription(&description);
+  return description.allocation_description().allocator_name() ==
+         kMappedAllocatorName;
+}
+
+void WarmUpMappedBundleTensor(const Tensor& tensor) {
+  // The smallest page size of the supported platforms.  Larger pages are
+  // only read several times.
+  const size_t kPageSize = 4096;
+  const StringPiece data = tensor.tensor_data();
+  volatile char sink = 0;
+  for (size_t i = 0; i < data.size(); i += kPageSize) {
+    sink += data[i];
+  }
+  (void)sink;
+}
+
+Status RewriteBundle(Env* env, StringPiece prefix, StringPiece new_prefix,
+                     const BundleWriter::Options& options) {
+  BundleReader reader(env, prefix);
+  TF_RETURN_IF_ERROR(reader.status());
+
+  // Collects the entries first, since lookups move the reader.  The entries
+  // of slices are rewritten along with their full tensors.
+  std::vector<std::pair<string, BundleEntryProto>> entries;
+  std::unordered_set<string> slice_keys;
+  reader.Seek(kHeaderEntryKey);
+  for (reader.Next(); reader.Valid(); reader.Next()) {
+    const string key = reader.key().ToString();
+    BundleEntryProto entry;
+    TF_RETURN_IF_ERROR(ParseEntryProto(key, reader.value(), &entry));
+    for (const TensorSliceProto& slice : entry.slices()) {
+      slice_keys.insert(
+          checkpoint::EncodeTensorNameSlice(key, TensorSlice(slice)));
+    }
+    entries.emplace_back(key, entry);
+  }
+
+  BundleWriter writer(env, new_prefix, options);
+  TF_RETURN_IF_ERROR(writer.status());
+  for (const auto& key_and_entry : entries) {
+    const string& key = key_and_entry.first;
+    const BundleEntryProto& entry = key_and_entry.second;
+    if (slice_keys.count(key) > 0) continue;
+    const TensorShape shape(entry.shape());
+    if (entry.slices().empty()) {
+      Tensor val(entry.dtype(), shape);
+      TF_RETURN_IF_ERROR(reader.Lookup(key, &val));
+      TF_RETURN_IF_ERROR(writer.Add(key, val));
+      continue;
+    }
+    for (const TensorSliceProto& slice_proto : entry.slices()) {
+      const TensorSlice slice(slice_proto);
+      TensorShape slice_shape;
+      TF_RETURN_IF_ERROR(slice.SliceTensorShape(shape, &slice_shape));
+      Tensor val(entry.dtype(), slice_shape);
+      TF_RETURN_IF_ERROR(reader.LookupSlice(key, slice, &val));
+      TF_RETURN_IF_ERROR(writer.AddSlice(key, shape, slice, val));
+    }
+  }
+  return writer.Finish();
+}
+
 // TODO(b/64763924): Remove after Jan 1st 2018.
 bool GetLenientNames() {
   const char* lenient_names_str = std::getenv("TF_SAVER_LENIENT_NAMES");
@@ -714,6 +947,18 @@ bool GetLenientNames() {
 
 // Interface for reading a tensor bundle.
 
+namespace {
+
+// The cache of the blocks of the metadata tables of all the BundleReaders of
+// the process.  It saves reading a block again for every slice of a
+// partitioned tensor, and every tensor looked up out of order.
+table::Cache* MetadataBlockCache() {
+  static table::Cache* cache = table::NewLRUCache(16 << 20);
+  return cache;
+}
+
+}  // namespace
+
 BundleReader::BundleReader(Env* env, StringPiece prefix)
     : env_(env),
       prefix_(prefix.ToString()),
@@ -730,7 +975,9 @@ BundleReader::BundleReader(Env* env, StringPiece prefix)
   status_ = env_->NewRandomAccessFile(filename, &wrapper);
   if (!status_.ok()) return;
   metadata_ = wrapper.release();
-  status_ = table::Table::Open(table::Options(), metadata_, file_size, &table_);
+  table::Options options;
+  options.block_cache = MetadataBlockCache();
+  status_ = table::Table::Open(options, metadata_, file_size, &table_);
   if (!status_.ok()) return;
   iter_ = table_->NewIterator();
 
@@ -772,6 +1019,9 @@ BundleReader::~BundleReader() {
   }
   gtl::STLDeleteValues(&data_);
   gtl::STLDeleteValues(&tensor_slices_);
+  for (auto pair : mapped_data_) {
+    pair.second->Unref();
+  }
 }
 
 Status BundleReader::GetBundleEntryProto(StringPiece key,
@@ -903,6 +1153,96 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   }
 }
 
+Status BundleReader::LookupMapped(StringPiece key, Tensor* val) {
+  CHECK(val != nullptr);
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  return LookupMappedSlice(
+      key, /* a full slice */ TensorSlice(TensorShape(entry.shape()).dims()),
+      val);
+}
+
+Status BundleReader::LookupMappedSlice(StringPiece key,
+                                       const TensorSlice& slice_spec,
+                                       Tensor* val) {
+  CHECK(val != nullptr);
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  if (!entry.slices().empty()) {
+    return errors::FailedPrecondition("Cannot map partitioned tensor ", key);
+  }
+  if (!DataTypeCanUseMemcpy(entry.dtype())) {
+    return errors::FailedPrecondition("Cannot map tensor ", key, " of type ",
+                                      DataTypeString(entry.dtype()));
+  }
+  const TensorShape stored_shape(entry.shape());
+  const int64 expected_bytes =
+      stored_shape.num_elements() * DataTypeSize(entry.dtype());
+  if (entry.size() != expected_bytes) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key,
+                            "; stored size ", entry.size(),
+                            "; expected size ", expected_bytes);
+  }
+  if (slice_spec.dims() != stored_shape.dims()) {
+    return errors::InvalidArgument("Slice ", slice_spec.DebugString(),
+                                   " does not match the shape of tensor ",
+                                   key, ": ", stored_shape.DebugString());
+  }
+  for (int d = 1; d < slice_spec.dims(); ++d) {
+    if (!slice_spec.IsFullAt(d)) {
+      return errors::FailedPrecondition(
+          "Cannot map slice ", slice_spec.DebugString(), " of tensor ", key,
+          ", which does not cover all but the first dimension");
+    }
+  }
+  TensorShape slice_shape;
+  TF_RETURN_IF_ERROR(slice_spec.SliceTensorShape(stored_shape, &slice_shape));
+  int64 offset = entry.offset();
+  if (slice_spec.dims() > 0 && !slice_spec.IsFullAt(0) &&
+      stored_shape.dim_size(0) > 0) {
+    const int64 row_bytes = stored_shape.num_elements() /
+                            stored_shape.dim_size(0) *
+                            DataTypeSize(entry.dtype());
+    offset += slice_spec.start(0) * row_bytes;
+  }
+  if (offset % EIGEN_MAX_ALIGN_BYTES != 0) {
+    return errors::FailedPrecondition("Cannot map tensor ", key,
+                                      " at unaligned offset ", offset);
+  }
+  const int64 size = slice_shape.num_elements() * DataTypeSize(entry.dtype());
+
+  // Map the data file if it has not been mapped.
+  core::RefCounted*& mapped = mapped_data_[entry.shard_id()];
+  if (mapped == nullptr) {
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    Status s = env_->NewReadOnlyMemoryRegionFromFile(
+        DataFilename(prefix_, entry.shard_id(), num_shards_), &region);
+    if (!s.ok()) {
+      mapped_data_.erase(entry.shard_id());
+      return s;
+    }
+    mapped = new MappedDataFile(std::move(region));
+  }
+  MappedDataFile* file = static_cast<MappedDataFile*>(mapped);
+  if (entry.offset() + entry.size() > file->length()) {
+    return errors::DataLoss("Tensor ", key, " extends past the end of ",
+                            DataFilename(prefix_, entry.shard_id(),
+                                         num_shards_));
+  }
+  if (reinterpret_cast<uintptr_t>(file->data()) % EIGEN_MAX_ALIGN_BYTES != 0) {
+    return errors::FailedPrecondition("Mapped data file ",
+                                      DataFilename(prefix_, entry.shard_id(),
+                                                   num_shards_),
+                                      " is not aligned");
+  }
+
+  MappedTensorBuffer* buf =
+      new MappedTensorBuffer(file, file->data() + offset, size);
+  *val = Tensor(entry.dtype(), slice_shape, buf);
+  buf->Unref();
+  return Status::OK();
+}
+
 Status BundleReader::ReadCurrent(Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
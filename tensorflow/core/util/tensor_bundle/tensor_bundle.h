@@ -64,12 +64,15 @@ limitations under the License.
 #include "tensorflow/core/protobuf/tensor_bundle.pb.h"
 
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_slice.h"
+#include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/io/inputbuffer.h"
@@ -107,7 +110,24 @@ extern const char* const kHeaderEntryKey;
 // All threads accessing the same BundleWriter must synchronize.
 class BundleWriter {
  public:
-  BundleWriter(Env* env, StringPiece prefix);
+  struct Options {
+    Options() {}
+    // Alignment, in bytes, for tensor data.  Must be >= 1.  With an
+    // alignment of at least EIGEN_MAX_ALIGN_BYTES, e.g. the page size, the
+    // data file can be memory mapped by BundleReader::LookupMapped().
+    int64 data_alignment = 1;
+
+    // Number of data files.  Must be >= 1.  With more than one, each data
+    // file is written, and its checksums computed, by a thread of its own,
+    // and each tensor goes to the file with the fewest bytes so far.  The
+    // tensors are then written after Add() returns, so they must not be
+    // modified until Finish() returns, and the errors of their writes are
+    // returned by Finish().
+    int num_shards = 1;
+  };
+  BundleWriter(Env* env, StringPiece prefix,
+               const Options& options = Options());
+  ~BundleWriter();
 
   // Adds the tensor "val" under key "key".
   // Across calls "key" must be unique but can be added in any order.
@@ -139,7 +159,20 @@ class BundleWriter {
   Status status() const { return status_; }
 
  private:
+  struct DataShard;
+
+  // Appends "val" to "out", which holds "*size" bytes, after padding it to
+  // the data alignment, and fills in the offset, size and checksum of
+  // "entry".
+  Status WriteEntry(const Tensor& val, FileOutputBuffer* out, int64* size,
+                    BundleEntryProto* entry);
+
+  // Pads "out", which holds "*size" bytes, so that its size is a multiple
+  // of the data alignment.
+  Status PadAlignment(FileOutputBuffer* out, int64* size);
+
   Env* const env_;  // Not owned.
+  const Options options_;
   const string prefix_;
   const string tmp_metadata_path_;
   const string tmp_data_path_;
@@ -147,6 +180,10 @@ class BundleWriter {
   int64 size_;  // Number of bytes written into out_.
   std::map<string, BundleEntryProto> entries_;
   Status status_;
+  // The data files if options_.num_shards > 1, in which case "out_" is
+  // unused.  The threads that write them fill in the entries that Add()
+  // created, which std::map does not move.
+  std::vector<std::unique_ptr<DataShard>> shards_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(BundleWriter);
 };
@@ -180,6 +217,10 @@ class BundleReader {
   // the metadata).
   Status status() const { return status_; }
 
+  // The number of data files of the bundle.
+  // REQUIRES: status().ok()
+  int num_shards() const { return num_shards_; }
+
   // Queries whether the bundle contains an entry keyed by "key".  Calls Seek()
   // internally, so this call invalidates the reader's current position.
   // REQUIRES: status().ok()
@@ -210,6 +251,28 @@ class BundleReader {
   // REQUIRES: status().ok()
   Status Lookup(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
 
+  // Like Lookup(), but "val" is set to a new tensor whose buffer points
+  // straight at the pages of the memory-mapped data file, so that all
+  // readers of the bundle share one physical copy through the page cache.
+  // The buffer is read-only and keeps the mapping alive.  Does not
+  // validate the stored checksum, since that would read every page.
+  //
+  // Returns a FailedPrecondition error if the tensor cannot be mapped:
+  // it is partitioned, is a string or variant tensor, or its data is not
+  // aligned (see BundleWriter::Options::data_alignment).  Returns the
+  // error of the file system if it cannot map the data file.  Callers
+  // can fall back to Lookup() on such errors.
+  // REQUIRES: status().ok()
+  Status LookupMapped(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
+
+  // Like LookupMapped(), but "val" is set to the slice "slice_spec" of the
+  // full tensor keyed by "key", e.g. the rows of one partition of an
+  // embedding.  The slice must cover all but the first dimension, so that
+  // its data is contiguous in the data file, and its data must be aligned.
+  // REQUIRES: status().ok()
+  Status LookupMappedSlice(StringPiece key, const TensorSlice& slice_spec,
+                           Tensor* val) TF_MUST_USE_RESULT;
+
   // Looks up the tensor pointed to by the internal iterator.
   //
   // On error, "val" may contain nonsense data.
@@ -284,6 +347,10 @@ class BundleReader {
   // Owned the InputBuffer objects and their underlying RandomAccessFile's.
   std::unordered_map<int32, io::InputBuffer*> data_;
 
+  // Memory-mapped data files, keyed by shard id.  Each holds a reference
+  // to a MappedDataFile, which tensors returned by LookupMapped() share.
+  std::unordered_map<int32, core::RefCounted*> mapped_data_;
+
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
   std::unordered_map<string, checkpoint::TensorSliceSet*> tensor_slices_;
@@ -300,6 +367,21 @@ class BundleReader {
   TF_DISALLOW_COPY_AND_ASSIGN(BundleReader);
 };
 
+// Returns true iff "tensor" was returned by BundleReader::LookupMapped(), so
+// that its buffer is read-only.
+bool IsMappedBundleTensor(const Tensor& tensor);
+
+// Reads one byte of each page of the tensor "tensor" returned by
+// BundleReader::LookupMapped(), so that its first accesses do not wait for
+// the file system.
+void WarmUpMappedBundleTensor(const Tensor& tensor);
+
+// Rewrites the bundle at "prefix" to "new_prefix" with the options of
+// "options", e.g. to align the tensor data so that it can be memory
+// mapped.  Partitioned tensors are rewritten slice by slice.
+Status RewriteBundle(Env* env, StringPiece prefix, StringPiece new_prefix,
+                     const BundleWriter::Options& options);
+
 // A buffering wrapper for a WritableFile.  Useful if the caller wishes to issue
 // small writes to a file (e.g. writing out a list of small varints).
 // External synchronization must be used in the presence of concurrent callers.
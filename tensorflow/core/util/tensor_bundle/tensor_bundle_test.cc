@@ -440,6 +440,138 @@ TEST(TensorBundleTest, EquivalentSliceTest) {
   }
 }
 
+TEST(TensorBundleTest, MemoryMappedTensors) {
+  {
+    BundleWriter::Options options;
+    options.data_alignment = 4096;
+    BundleWriter writer(Env::Default(), Prefix("mapped"), options);
+    TF_EXPECT_OK(writer.Add("a", Constant<float>(1., TensorShape({3}))));
+    TF_EXPECT_OK(writer.Add("b", Constant<int64>(2, TensorShape({2, 2}))));
+    TF_EXPECT_OK(writer.Add("c", Constant<string>("s", TensorShape({1}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  Tensor a, b;
+  {
+    BundleReader reader(Env::Default(), Prefix("mapped"));
+    TF_ASSERT_OK(reader.status());
+    Expect<float>(&reader, "a", Constant<float>(1., TensorShape({3})));
+
+    TF_ASSERT_OK(reader.LookupMapped("a", &a));
+    TF_ASSERT_OK(reader.LookupMapped("b", &b));
+    EXPECT_TRUE(errors::IsFailedPrecondition(reader.LookupMapped("c", &a)));
+    EXPECT_TRUE(errors::IsNotFound(reader.LookupMapped("d", &a)));
+  }
+  // The tensors outlive the reader.
+  test::ExpectTensorEqual<float>(a, Constant<float>(1., TensorShape({3})));
+  test::ExpectTensorEqual<int64>(b, Constant<int64>(2, TensorShape({2, 2})));
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(b.tensor_data().data()) % 4096);
+  EXPECT_TRUE(IsMappedBundleTensor(a));
+  EXPECT_FALSE(IsMappedBundleTensor(Constant<float>(1., TensorShape({3}))));
+
+  // Unaligned data cannot be mapped.
+  {
+    BundleWriter writer(Env::Default(), Prefix("unaligned"));
+    TF_EXPECT_OK(writer.Add("a", Constant<int8>(1, TensorShape({3}))));
+    TF_EXPECT_OK(writer.Add("b", Constant<int8>(2, TensorShape({3}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader reader(Env::Default(), Prefix("unaligned"));
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  EXPECT_TRUE(errors::IsFailedPrecondition(reader.LookupMapped("b", &val)));
+}
+
+TEST(TensorBundleTest, MemoryMappedSlices) {
+  {
+    BundleWriter::Options options;
+    options.data_alignment = 4096;
+    BundleWriter writer(Env::Default(), Prefix("mapped_slices"), options);
+    Tensor rows(DT_FLOAT, TensorShape({64, 33}));
+    test::FillIota<float>(&rows, 0);
+    TF_EXPECT_OK(writer.Add("rows", rows));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader reader(Env::Default(), Prefix("mapped_slices"));
+  TF_ASSERT_OK(reader.status());
+
+  // Rows 16 to 47, which start 16 * 33 * 4 = 2112 bytes, a multiple of 64,
+  // into the aligned data.
+  Tensor val;
+  TF_ASSERT_OK(reader.LookupMappedSlice(
+      "rows", TensorSlice::ParseOrDie("16,32:-"), &val));
+  EXPECT_TRUE(IsMappedBundleTensor(val));
+  Tensor expected(DT_FLOAT, TensorShape({32, 33}));
+  test::FillIota<float>(&expected, 16 * 33);
+  test::ExpectTensorEqual<float>(expected, val);
+  WarmUpMappedBundleTensor(val);
+
+  // Row 1 starts 132 bytes into the data, which is not aligned.
+  EXPECT_TRUE(errors::IsFailedPrecondition(reader.LookupMappedSlice(
+      "rows", TensorSlice::ParseOrDie("1,2:-"), &val)));
+  // The rows of a slice of the second dimension are not contiguous.
+  EXPECT_TRUE(errors::IsFailedPrecondition(reader.LookupMappedSlice(
+      "rows", TensorSlice::ParseOrDie("-:0,16"), &val)));
+}
+
+TEST(TensorBundleTest, MultipleDataFiles) {
+  {
+    BundleWriter::Options options;
+    options.num_shards = 3;
+    BundleWriter writer(Env::Default(), Prefix("multi"), options);
+    for (int i = 0; i < 8; ++i) {
+      TF_EXPECT_OK(writer.Add(strings::StrCat("float", i),
+                              Constant<float>(i, TensorShape({i + 1, 100}))));
+    }
+    TF_EXPECT_OK(writer.Add("strs", test::AsTensor<string>({"a", "", "bc"})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  for (int i = 0; i < 3; ++i) {
+    TF_EXPECT_OK(
+        Env::Default()->FileExists(DataFilename(Prefix("multi"), i, 3)));
+  }
+  BundleReader reader(Env::Default(), Prefix("multi"));
+  TF_ASSERT_OK(reader.status());
+  EXPECT_EQ(3, reader.num_shards());
+  for (int i = 0; i < 8; ++i) {
+    Expect<float>(&reader, strings::StrCat("float", i),
+                  Constant<float>(i, TensorShape({i + 1, 100})));
+  }
+  Expect<string>(&reader, "strs", test::AsTensor<string>({"a", "", "bc"}));
+}
+
+TEST(TensorBundleTest, RewriteBundle) {
+  const TensorShape kFullShape({5, 10});
+  {
+    BundleWriter writer(Env::Default(), Prefix("to_rewrite"));
+    TF_EXPECT_OK(writer.Add("a", Constant<int8>(1, TensorShape({3}))));
+    TF_EXPECT_OK(writer.Add("b", Constant<float>(2., TensorShape({2}))));
+    TF_EXPECT_OK(writer.AddSlice("c", kFullShape,
+                                 TensorSlice::ParseOrDie("-:0,1"),
+                                 Constant<float>(0., TensorShape({5, 1}))));
+    TF_EXPECT_OK(writer.AddSlice("c", kFullShape,
+                                 TensorSlice::ParseOrDie("-:1,9"),
+                                 Constant<float>(0., TensorShape({5, 9}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleWriter::Options options;
+  options.data_alignment = 64;
+  TF_ASSERT_OK(RewriteBundle(Env::Default(), Prefix("to_rewrite"),
+                             Prefix("rewritten"), options));
+
+  BundleReader reader(Env::Default(), Prefix("rewritten"));
+  TF_ASSERT_OK(reader.status());
+  Expect<int8>(&reader, "a", Constant<int8>(1, TensorShape({3})));
+  Expect<float>(&reader, "b", Constant<float>(2., TensorShape({2})));
+  Expect<float>(&reader, "c", Constant<float>(0., kFullShape));
+  std::vector<TensorSlice> slices;
+  TF_ASSERT_OK(reader.LookupTensorSlices("c", &slices));
+  EXPECT_EQ(2, slices.size());
+
+  Tensor b;
+  TF_ASSERT_OK(reader.LookupMapped("b", &b));
+  test::ExpectTensorEqual<float>(b, Constant<float>(2., TensorShape({2})));
+}
+
 TEST(TensorBundleTest, NonStandardShapes) {
   TestNonStandardShapes<float>();
   TestNonStandardShapes<double>();
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/framework/versions.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
+#include "tensorflow/core/lib/io/cache.h"
 #include "tensorflow/core/lib/io/iterator.h"
 #include "tensorflow/core/lib/io/table.h"
 #include "tensorflow/core/lib/io/table_options.h"
@@ -65,6 +66,14 @@ class TensorSliceReaderTable : public TensorSliceReader::Table {
   RandomAccessFile* file_;  // Owns.
   table::Table* table_;
 };
+
+// The cache of the blocks of all the tables opened by
+// OpenTableTensorSliceReader(), which are read again for every slice that a
+// reader copies out of them.
+table::Cache* TableBlockCache() {
+  static table::Cache* cache = table::NewLRUCache(16 << 20);
+  return cache;
+}
 }  // namespace
 
 Status OpenTableTensorSliceReader(const string& fname,
@@ -78,6 +87,7 @@ Status OpenTableTensorSliceReader(const string& fname,
     s = env->GetFileSize(fname, &file_size);
     if (s.ok()) {
       table::Options options;
+      options.block_cache = TableBlockCache();
       table::Table* table;
       s = table::Table::Open(options, f.get(), file_size, &table);
       if (s.ok()) {
@@ -15,17 +15,22 @@ limitations under the License.
 
 #include "tensorflow/core/util/work_sharder.h"
 
+#include <cmath>
+
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/parallelism_governor.h"
 
 namespace tensorflow {
 
-void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
-           int64 cost_per_unit, std::function<void(int64, int64)> work) {
-  CHECK_GE(total, 0);
-  if (total == 0) {
-    return;
-  }
+namespace {
+
+void ShardLimited(int max_parallelism, thread::ThreadPool* workers,
+                  int64 total, int64 cost_per_unit,
+                  const std::function<void(int64, int64)>& work) {
   if (max_parallelism <= 1) {
     // Just inline the whole work since we only have 1 thread (core).
     work(0, total);
@@ -74,4 +79,99 @@ void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
   counter.Wait();
 }
 
+}  // namespace
+
+void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
+           int64 cost_per_unit, std::function<void(int64, int64)> work) {
+  CHECK_GE(total, 0);
+  if (total == 0) {
+    return;
+  }
+  ParallelismGovernor* governor = ParallelismGovernor::Global();
+  if (max_parallelism > 1 && governor->enabled()) {
+    // Use only the threads that are not busy with other ops or shards.
+    ParallelismGovernor::Reservation reservation(governor, max_parallelism);
+    ShardLimited(reservation.parallelism(), workers, total, cost_per_unit,
+                 work);
+    return;
+  }
+  ShardLimited(max_parallelism, workers, total, cost_per_unit, work);
+}
+
+namespace {
+
+auto* shard_size_sampler = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/util/work_sharder/shard_size",
+     "Units of work per shard of AdaptiveSharder calls.", "name"},
+    // Powers of 2 up to 2^30.
+    monitoring::Buckets::Exponential(1, 2, 31));
+
+}  // namespace
+
+constexpr int AdaptiveSharder::kCalibrationCalls;
+
+AdaptiveSharder::AdaptiveSharder(const string& name,
+                                 int64 initial_cost_per_element)
+    : name_(name), initial_cost_per_element_(initial_cost_per_element) {}
+
+AdaptiveSharder::Bucket* AdaptiveSharder::GetBucket(int64 unit_size) {
+  return &buckets_[Log2Floor64(std::max<int64>(1, unit_size))];
+}
+
+const AdaptiveSharder::Bucket* AdaptiveSharder::GetBucket(
+    int64 unit_size) const {
+  return &buckets_[Log2Floor64(std::max<int64>(1, unit_size))];
+}
+
+int64 AdaptiveSharder::CostPerUnit(int64 unit_size) const {
+  const double cost_per_element = GetBucket(unit_size)->cost_per_element;
+  if (cost_per_element < 0) return initial_cost_per_element_ * unit_size;
+  return static_cast<int64>(std::ceil(cost_per_element * unit_size));
+}
+
+void AdaptiveSharder::Shard(int max_parallelism, thread::ThreadPool* workers,
+                            int64 total, int64 unit_size,
+                            std::function<void(int64, int64)> work) {
+  CHECK_GE(unit_size, 0);
+  if (total == 0) return;
+  Bucket* bucket = GetBucket(unit_size);
+  const int64 cost_per_unit = CostPerUnit(unit_size);
+  const bool calibrated = bucket->cost_per_element >= 0;
+  const bool measure =
+      !calibrated && bucket->calls.fetch_add(1) < kCalibrationCalls;
+  // Also report the shards of the first call with the measured cost.
+  const bool report =
+      measure || (calibrated && !bucket->reported &&
+                  !bucket->reported.exchange(true));
+  if (!report) {
+    ::tensorflow::Shard(max_parallelism, workers, total, cost_per_unit, work);
+    return;
+  }
+
+  Env* env = Env::Default();
+  std::atomic<int> num_shards(0);
+  std::atomic<int64> micros(0);
+  ::tensorflow::Shard(max_parallelism, workers, total, cost_per_unit,
+                      [&work, env, &num_shards, &micros](int64 start,
+                                                         int64 limit) {
+                        const uint64 start_micros = env->NowMicros();
+                        work(start, limit);
+                        micros += env->NowMicros() - start_micros;
+                        ++num_shards;
+                      });
+  shard_size_sampler->GetCell(name_)->Add(static_cast<double>(total) /
+                                          num_shards);
+  if (!measure) return;
+
+  bucket->elements += total * std::max<int64>(1, unit_size);
+  bucket->micros += micros;
+  if (++bucket->measured_calls == kCalibrationCalls) {
+    const double cost_per_element =
+        1000.0 * bucket->micros / std::max<int64>(1, bucket->elements);
+    VLOG(1) << name_ << " costs " << cost_per_element
+            << "ns per element of units of " << unit_size << " elements";
+    bucket->cost_per_element = cost_per_element;
+  }
+}
+
 }  // end namespace tensorflow
@@ -16,9 +16,12 @@ limitations under the License.
 #ifndef TENSORFLOW_UTIL_WORK_SHARDER_H_
 #define TENSORFLOW_UTIL_WORK_SHARDER_H_
 
+#include <atomic>
 #include <functional>
+#include <string>
 
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -41,6 +44,9 @@ namespace tensorflow {
 // work(start, limit) computes the work units from [start,
 // limit), i.e., [start, limit) is a shard.
 //
+// If the ParallelismGovernor is enabled, at most as many threads as it
+// allows are used, including the calling thread.
+//
 // REQUIRES: max_parallelism >= 0
 // REQUIRES: workers != nullptr
 // REQUIRES: total >= 0
@@ -48,6 +54,57 @@ namespace tensorflow {
 void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
            int64 cost_per_unit, std::function<void(int64, int64)> work);
 
+// Shards work like Shard(), with a cost per unit that is measured at runtime
+// instead of guessed.  Kernels keep one AdaptiveSharder per call site, e.g.
+// as a function-level static.
+//
+// The cost of a unit of work is assumed to be proportional to its
+// "unit_size", e.g. the number of elements it reads.  Calls are bucketed by
+// the log2 of "unit_size".  The first kCalibrationCalls calls of each bucket
+// shard with "initial_cost_per_element", while measuring the time spent in
+// "work", and later calls shard with the measured cost.  The sizes of the
+// shards used are exported, per "name", to the
+// /tensorflow/core/util/work_sharder/shard_size sampler.
+//
+// This class is thread-safe.
+class AdaptiveSharder {
+ public:
+  static constexpr int kCalibrationCalls = 8;
+
+  // "name" identifies the call site, e.g. the kernel's op.
+  AdaptiveSharder(const string& name, int64 initial_cost_per_element);
+
+  // REQUIRES: As for Shard(), and unit_size >= 0
+  void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
+             int64 unit_size, std::function<void(int64, int64)> work);
+
+  // The estimated cost per unit of "unit_size".
+  int64 CostPerUnit(int64 unit_size) const;
+
+ private:
+  struct Bucket {
+    // Calls started, and finished, with measurements.
+    std::atomic<int> calls{0};
+    std::atomic<int> measured_calls{0};
+    // Sums over the measured calls.
+    std::atomic<int64> elements{0};
+    std::atomic<int64> micros{0};
+    // Nanoseconds per element, or < 0 until calibrated.
+    std::atomic<double> cost_per_element{-1.0};
+    // Whether the shards of a call with the measured cost were reported.
+    std::atomic<bool> reported{false};
+  };
+
+  Bucket* GetBucket(int64 unit_size);
+  const Bucket* GetBucket(int64 unit_size) const;
+
+  const string name_;
+  const int64 initial_cost_per_element_;
+  Bucket buckets_[64];
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AdaptiveSharder);
+};
+
 }  // end namespace tensorflow
 
 #endif  // TENSORFLOW_UTIL_WORK_SHARDER_H_
@@ -76,6 +76,33 @@ TEST(Shard, OverflowTest) {
   }
 }
 
+TEST(AdaptiveSharder, Calibrates) {
+  thread::ThreadPool threads(Env::Default(), "test", 4);
+  AdaptiveSharder sharder("test", 1000000);
+  EXPECT_EQ(1000000 * 10, sharder.CostPerUnit(10));
+  for (int i = 0; i < AdaptiveSharder::kCalibrationCalls + 2; ++i) {
+    std::atomic<int64> num_elements(0);
+    int64 max_shard_units = 0;
+    mutex mu;
+    sharder.Shard(4, &threads, 1000, 10,
+                  [&num_elements, &max_shard_units, &mu](int64 start,
+                                                         int64 limit) {
+                    num_elements += limit - start;
+                    mutex_lock l(mu);
+                    max_shard_units = std::max(max_shard_units, limit - start);
+                  });
+    EXPECT_EQ(1000, num_elements.load());
+    if (i >= AdaptiveSharder::kCalibrationCalls) {
+      // Counting is much cheaper than the initial estimate, so the work is
+      // not split any more.
+      EXPECT_EQ(1000, max_shard_units);
+    }
+  }
+  EXPECT_LT(sharder.CostPerUnit(10), 1000000 * 10);
+  // Other unit sizes are calibrated separately.
+  EXPECT_EQ(1000000 * 1000, sharder.CostPerUnit(1000));
+}
+
 void BM_Sharding(int iters, int arg) {
   thread::ThreadPool threads(Env::Default(), "test", 16);
   const int64 total = 1LL << 30;
@@ -208,6 +208,92 @@ func (s *Session) NewPartialRun(feeds, fetches []Output, targets []*Operation) (
 	return pr, nil
 }
 
+// PreparedRun runs a graph with a fixed set of feeds, fetches and targets.
+//
+// Unlike Session.Run, PreparedRun.Run reuses the arguments it passes to the
+// TensorFlow C library from one call to the next, so that a program that runs
+// the same computation repeatedly (e.g., to serve requests) does not need to
+// build them anew. A PreparedRun may not be used concurrently; create one per
+// goroutine instead.
+type PreparedRun struct {
+	session *Session
+	// Keep the Outputs and Operations, and thus their Graph, alive.
+	feeds   []Output
+	fetches []Output
+	targets []*Operation
+	c       *cRunArgs
+}
+
+// NewPreparedRun sets up a PreparedRun that feeds the given outputs and
+// fetches the given outputs, and runs the given targets.
+func (s *Session) NewPreparedRun(feeds, fetches []Output, targets []*Operation) (*PreparedRun, error) {
+	pr := &PreparedRun{
+		session: s,
+		feeds:   feeds,
+		fetches: fetches,
+		targets: targets,
+		c: &cRunArgs{
+			feeds:        make([]C.TF_Output, len(feeds)),
+			feedTensors:  make([]*C.TF_Tensor, len(feeds)),
+			fetches:      make([]C.TF_Output, len(fetches)),
+			fetchTensors: make([]*C.TF_Tensor, len(fetches)),
+			targets:      make([]*C.TF_Operation, len(targets)),
+		},
+	}
+	for i, o := range feeds {
+		pr.c.feeds[i] = o.c()
+	}
+	for i, o := range fetches {
+		pr.c.fetches[i] = o.c()
+	}
+	for i, o := range targets {
+		pr.c.targets[i] = o.c
+	}
+	return pr, nil
+}
+
+// Run runs the graph, feeding feeds[i] to the i-th output that pr was set up
+// to feed, and returns the fetched Tensors in the order pr was set up with.
+func (pr *PreparedRun) Run(feeds []*Tensor) ([]*Tensor, error) {
+	if len(feeds) != len(pr.feeds) {
+		return nil, fmt.Errorf("got %d tensors to feed, want %d", len(feeds), len(pr.feeds))
+	}
+	s := pr.session
+	s.mu.Lock()
+	if s.c == nil {
+		s.mu.Unlock()
+		return nil, errors.New("session is closed")
+	}
+	s.wg.Add(1)
+	s.mu.Unlock()
+	defer s.wg.Done()
+
+	c := pr.c
+	for i, t := range feeds {
+		c.feedTensors[i] = t.c
+	}
+	for i := range c.fetchTensors {
+		c.fetchTensors[i] = nil
+	}
+	status := newStatus()
+	C.TF_SessionRun(s.c, nil,
+		ptrOutput(c.feeds), ptrTensor(c.feedTensors), C.int(len(c.feeds)),
+		ptrOutput(c.fetches), ptrTensor(c.fetchTensors), C.int(len(c.fetches)),
+		ptrOperation(c.targets), C.int(len(c.targets)),
+		nil, status.c)
+
+	// Make sure GC won't harvest input tensors until SessionRun() is finished
+	runtime.KeepAlive(feeds)
+	for i := range c.feedTensors {
+		c.feedTensors[i] = nil
+	}
+
+	if err := status.Err(); err != nil {
+		return nil, err
+	}
+	return c.toGo(), nil
+}
+
 // Close a session. This contacts any other processes associated with this
 // session, if applicable. Blocks until all previous calls to Run have returned.
 func (s *Session) Close() error {
@@ -184,6 +184,42 @@ func TestConcurrency(t *testing.T) {
 	}
 }
 
+func TestPreparedRun(t *testing.T) {
+	graph, inp, out := createTestGraph(t, Float)
+	s, err := NewSession(graph, &SessionOptions{})
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer s.Close()
+	pr, err := s.NewPreparedRun([]Output{inp}, []Output{out}, nil)
+	if err != nil {
+		t.Fatal(err)
+	}
+	feed, err := NewTensor([]float32{0, 0})
+	if err != nil {
+		t.Fatal(err)
+	}
+	for i := 0; i < 3; i++ {
+		if err := feed.Reset([]float32{float32(i), -1}); err != nil {
+			t.Fatal(err)
+		}
+		output, err := pr.Run([]*Tensor{feed})
+		if err != nil {
+			t.Fatal(err)
+		}
+		if len(output) != 1 {
+			t.Fatalf("got %d outputs, want 1", len(output))
+		}
+		want := []float32{-float32(i), 1}
+		if got := output[0].Value(); !reflect.DeepEqual(got, want) {
+			t.Errorf("Got %v, want %v", got, want)
+		}
+	}
+	if _, err := pr.Run(nil); err == nil {
+		t.Error("Run should have failed without feeds")
+	}
+}
+
 func ExamplePartialRun() {
 	var (
 		// Create a graph: a + 2 + 3 + b.
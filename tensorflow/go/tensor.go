@@ -112,6 +112,45 @@ func NewTensor(value interface{}) (*Tensor, error) {
 	return t, nil
 }
 
+// Reset overwrites the contents of t with value, without allocating a new
+// Tensor. value must have the same data type and shape as t, and t must not
+// be a String tensor.
+//
+// Reset must not be called while a Session.Run that t is fed to is in
+// progress. Since TensorFlow may return fed tensors as outputs without
+// copying them (e.g., when fetching the output of an Identity operation),
+// Reset also overwrites the contents of any such output.
+func (t *Tensor) Reset(value interface{}) error {
+	val := reflect.ValueOf(value)
+	shape, dataType, err := shapeAndDataTypeOf(val)
+	if err != nil {
+		return err
+	}
+	if dataType == String {
+		return fmt.Errorf("cannot reset a String tensor")
+	}
+	if dataType != t.DataType() {
+		return fmt.Errorf("cannot reset a tensor of type %v with a value of type %v", t.DataType(), dataType)
+	}
+	if len(shape) != len(t.shape) {
+		return fmt.Errorf("cannot reset a tensor with shape %v with a value of shape %v", t.shape, shape)
+	}
+	for i := range shape {
+		if shape[i] != t.shape[i] {
+			return fmt.Errorf("cannot reset a tensor with shape %v with a value of shape %v", t.shape, shape)
+		}
+	}
+	raw := tensorData(t.c)
+	buf := bytes.NewBuffer(raw[:0:len(raw)])
+	if err := encodeTensor(buf, val, shape); err != nil {
+		return err
+	}
+	if buf.Len() != len(raw) {
+		return bug("Reset wrote %v bytes instead of %v to a tensor with type %v and shape %v", buf.Len(), len(raw), dataType, shape)
+	}
+	return nil
+}
+
 // ReadTensor constructs a Tensor with the provided type and shape from the
 // serialized tensor contents in r.
 //
@@ -325,6 +364,14 @@ func encodeTensor(w *bytes.Buffer, v reflect.Value, shape []int64) error {
 			}
 		}
 
+		// Slices of numbers have the same memory layout as the tensor, so
+		// copy them as a whole.
+		if v.Kind() == reflect.Slice && v.Len() > 0 && isNumericKind(v.Type().Elem().Kind()) {
+			n := v.Len() * int(v.Type().Elem().Size())
+			_, err := w.Write((*[1 << 30]byte)(unsafe.Pointer(v.Pointer()))[:n:n])
+			return err
+		}
+
 		subShape := shape[1:]
 		for i := 0; i < v.Len(); i++ {
 			err := encodeTensor(w, v.Index(i), subShape)
@@ -339,6 +386,16 @@ func encodeTensor(w *bytes.Buffer, v reflect.Value, shape []int64) error {
 	return nil
 }
 
+// isNumericKind returns true for the kinds of Go values that encodeTensor
+// writes in their in-memory representation.
+func isNumericKind(k reflect.Kind) bool {
+	switch k {
+	case reflect.Int8, reflect.Int16, reflect.Int32, reflect.Int64, reflect.Uint8, reflect.Uint16, reflect.Float32, reflect.Float64, reflect.Complex64, reflect.Complex128:
+		return true
+	}
+	return false
+}
+
 // decodeTensor decodes the Tensor from the buffer to ptr using the format
 // specified in c_api.h. Use stringDecoder for String tensors.
 func decodeTensor(r *bytes.Reader, shape []int64, typ reflect.Type, ptr reflect.Value) error {
@@ -227,6 +227,49 @@ func TestTensorSerializationErrors(t *testing.T) {
 	}
 }
 
+func TestTensorReset(t *testing.T) {
+	t1, err := NewTensor([][]float32{{1, 2}, {3, 4}})
+	if err != nil {
+		t.Fatal(err)
+	}
+	want := [][]float32{{5, 6}, {7, 8}}
+	if err := t1.Reset(want); err != nil {
+		t.Fatal(err)
+	}
+	if got := t1.Value(); !reflect.DeepEqual(got, want) {
+		t.Errorf("Got %v, want %v", got, want)
+	}
+	// Scalars
+	t2, err := NewTensor(int64(1))
+	if err != nil {
+		t.Fatal(err)
+	}
+	if err := t2.Reset(int64(2)); err != nil {
+		t.Fatal(err)
+	}
+	if got := t2.Value(); got != int64(2) {
+		t.Errorf("Got %v, want 2", got)
+	}
+	// Values that do not match the tensor are rejected.
+	for _, v := range []interface{}{
+		[][]float64{{5, 6}, {7, 8}},
+		[][]float32{{5, 6}},
+		[]float32{5, 6, 7, 8},
+		[][]float32{{5, 6}, {7}},
+	} {
+		if err := t1.Reset(v); err == nil {
+			t.Errorf("Reset(%v) should have failed", v)
+		}
+	}
+	t3, err := NewTensor("abcd")
+	if err != nil {
+		t.Fatal(err)
+	}
+	if err := t3.Reset("efgh"); err == nil {
+		t.Error("Reset should have failed on a String tensor")
+	}
+}
+
 func benchmarkNewTensor(b *testing.B, v interface{}) {
 	for i := 0; i < b.N; i++ {
 		if t, err := NewTensor(v); err != nil || t == nil {
@@ -244,3 +287,17 @@ func BenchmarkNewTensor(b *testing.B) {
 	)
 	b.Run("[150528]", func(b *testing.B) { benchmarkNewTensor(b, vector) })
 }
+
+func BenchmarkTensorReset(b *testing.B) {
+	vector := make([]int32, 224*224*3)
+	t, err := NewTensor(vector)
+	if err != nil {
+		b.Fatal(err)
+	}
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		if err := t.Reset(vector); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
@@ -245,6 +245,47 @@ public final class Tensor<T> implements AutoCloseable {
     return ret;
   }
 
+  /**
+   * Creates a Tensor that uses the memory of the given direct buffer, without copying it.
+   *
+   * <p>The tensor spans the remaining bytes of {@code data}, which must be encoded as per {@link
+   * #create(Class, long[], ByteBuffer)}, in native byte order. The memory is pinned: it is handed
+   * to TensorFlow as is, and TensorFlow holds a reference to {@code data} until it no longer uses
+   * the memory, which may be after {@link #close()} if the tensor was fed to a {@link Session} that
+   * still refers to it. The contents must not be modified until then.
+   *
+   * <p>Depending on the build, TensorFlow requires tensor memory to be aligned to up to 64 bytes.
+   * If the memory of {@code data} is not aligned enough, it is copied after all.
+   *
+   * @param <T> the tensor element type
+   * @param type the tensor element type, represented as a class object. Must not be {@code
+   *     String}.
+   * @param shape the tensor shape.
+   * @param data a direct buffer containing the tensor data.
+   * @throws IllegalArgumentException If {@code data} is not a direct buffer, or if the tensor
+   *     datatype or shape is not compatible with the buffer
+   */
+  public static <T> Tensor<T> wrap(Class<T> type, long[] shape, ByteBuffer data) {
+    DataType dtype = DataType.fromClass(type);
+    if (!data.isDirect()) {
+      throw new IllegalArgumentException("cannot wrap a ByteBuffer that is not direct");
+    }
+    if (dtype == DataType.STRING) {
+      throw new IllegalArgumentException("cannot wrap a ByteBuffer in a STRING Tensor");
+    }
+    final int nbytes = numElements(shape) * elemByteSize(dtype);
+    if (data.remaining() != nbytes) {
+      throw new IllegalArgumentException(
+          String.format(
+              "ByteBuffer with %d bytes is not compatible with a %s Tensor with shape %s",
+              data.remaining(), dtype.toString(), Arrays.toString(shape)));
+    }
+    Tensor<T> t = new Tensor<T>(dtype);
+    t.shapeCopy = Arrays.copyOf(shape, shape.length);
+    t.nativeHandle = allocateWrapping(t.dtype.c(), t.shapeCopy, data, data.position(), nbytes);
+    return t;
+  }
+
   /**
    * Creates a Tensor of any type with data from the given buffer.
    *
@@ -538,6 +579,17 @@ public final class Tensor<T> implements AutoCloseable {
     dst.put(src);
   }
 
+  /**
+   * Returns a read-only view of the tensor data, without copying it.
+   *
+   * <p>The view is in native byte order and holds the same {@code numBytes()} bytes that {@link
+   * #writeTo(ByteBuffer)} would write. It is backed by the memory of the underlying native tensor
+   * and must not be used after {@link #close()}.
+   */
+  public ByteBuffer asReadOnlyBuffer() {
+    return buffer().asReadOnlyBuffer().order(ByteOrder.nativeOrder());
+  }
+
   /** Returns a string describing the type and shape of the Tensor. */
   @Override
   public String toString() {
@@ -759,6 +811,9 @@ public final class Tensor<T> implements AutoCloseable {
 
   private static native long allocate(int dtype, long[] shape, long byteSize);
 
+  private static native long allocateWrapping(
+      int dtype, long[] shape, ByteBuffer data, int offset, long byteSize);
+
   private static native long allocateScalarBytes(byte[] value);
 
   private static native long allocateNonScalarBytes(long[] shape, Object[] value);
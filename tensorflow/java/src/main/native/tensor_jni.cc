@@ -20,6 +20,7 @@ limitations under the License.
 #include <string.h>
 #include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "tensorflow/c/c_api.h"
 #include "tensorflow/java/src/main/native/exception_jni.h"
@@ -65,6 +66,58 @@ size_t elemByteSize(TF_DataType dtype) {
   }
 }
 
+// Copies the dimensions in 'shape' to 'dims'.
+void getDims(JNIEnv* env, jlongArray shape, std::vector<int64_t>* dims) {
+  const int num_dims = static_cast<int>(env->GetArrayLength(shape));
+  dims->resize(num_dims);
+  if (num_dims == 0) return;
+  static_assert(sizeof(jlong) == sizeof(int64_t),
+                "Java long is not compatible with the TensorFlow C API");
+  // On some platforms "jlong" is a "long" while "int64_t" is a "long long".
+  //
+  // Thus, static_cast<int64_t*>(dims) will trigger a compiler error:
+  // static_cast from 'jlong *' (aka 'long *') to 'int64_t *' (aka 'long long
+  // *') is not allowed
+  //
+  // Since this array is typically very small, use the guaranteed safe scheme of
+  // creating a copy.
+  jboolean is_copy;
+  jlong* values = env->GetLongArrayElements(shape, &is_copy);
+  for (int i = 0; i < num_dims; ++i) {
+    (*dims)[i] = static_cast<int64_t>(values[i]);
+  }
+  env->ReleaseLongArrayElements(shape, values, JNI_ABORT);
+}
+
+// A direct java.nio.ByteBuffer whose memory backs a TF_Tensor.
+struct WrappedBuffer {
+  JavaVM* vm;
+  jobject buffer;  // A global reference, which keeps the memory alive.
+};
+
+// The TF_Tensor deallocator for memory of a WrappedBuffer. TensorFlow may
+// release the last reference to a tensor from any thread, so this attaches to
+// the JVM if necessary.
+void releaseWrappedBuffer(void* data, size_t len, void* arg) {
+  WrappedBuffer* wrapped = static_cast<WrappedBuffer*>(arg);
+  JNIEnv* env = nullptr;
+  bool attached = false;
+  jint ret = wrapped->vm->GetEnv(reinterpret_cast<void**>(&env),
+                                 JNI_VERSION_1_6);
+  if (ret == JNI_EDETACHED) {
+    ret = wrapped->vm->AttachCurrentThreadAsDaemon(
+        reinterpret_cast<void**>(&env), nullptr);
+    attached = true;
+  }
+  // If the JVM cannot be reached (e.g. it is shutting down), leak the
+  // reference rather than crash.
+  if (ret == JNI_OK) {
+    env->DeleteGlobalRef(wrapped->buffer);
+    if (attached) wrapped->vm->DetachCurrentThread();
+  }
+  delete wrapped;
+}
+
 // Write a Java scalar object (java.lang.Integer etc.) to a TF_Tensor.
 void writeScalar(JNIEnv* env, jobject src, TF_DataType dtype, void* dst,
                  size_t dst_size) {
@@ -328,32 +381,43 @@ JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocate(JNIEnv* env,
                                                             jint dtype,
                                                             jlongArray shape,
                                                             jlong sizeInBytes) {
-  int num_dims = static_cast<int>(env->GetArrayLength(shape));
-  jlong* dims = nullptr;
-  if (num_dims > 0) {
-    jboolean is_copy;
-    dims = env->GetLongArrayElements(shape, &is_copy);
+  std::vector<int64_t> dims;
+  getDims(env, shape, &dims);
+  TF_Tensor* t =
+      TF_AllocateTensor(static_cast<TF_DataType>(dtype), dims.data(),
+                        static_cast<int>(dims.size()),
+                        static_cast<size_t>(sizeInBytes));
+  if (t == nullptr) {
+    throwException(env, kNullPointerException,
+                   "unable to allocate memory for the Tensor");
+    return 0;
   }
-  static_assert(sizeof(jlong) == sizeof(int64_t),
-                "Java long is not compatible with the TensorFlow C API");
-  // On some platforms "jlong" is a "long" while "int64_t" is a "long long".
-  //
-  // Thus, static_cast<int64_t*>(dims) will trigger a compiler error:
-  // static_cast from 'jlong *' (aka 'long *') to 'int64_t *' (aka 'long long
-  // *') is not allowed
-  //
-  // Since this array is typically very small, use the guaranteed safe scheme of
-  // creating a copy.
-  int64_t* dims_copy = new int64_t[num_dims];
-  for (int i = 0; i < num_dims; ++i) {
-    dims_copy[i] = static_cast<int64_t>(dims[i]);
+  return reinterpret_cast<jlong>(t);
+}
+
+JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocateWrapping(
+    JNIEnv* env, jclass clazz, jint dtype, jlongArray shape, jobject data,
+    jint offset, jlong sizeInBytes) {
+  char* address = static_cast<char*>(env->GetDirectBufferAddress(data));
+  if (address == nullptr) {
+    throwException(env, kIllegalArgumentException,
+                   "unable to access the memory of the ByteBuffer");
+    return 0;
   }
-  TF_Tensor* t = TF_AllocateTensor(static_cast<TF_DataType>(dtype), dims_copy,
-                                   num_dims, static_cast<size_t>(sizeInBytes));
-  delete[] dims_copy;
-  if (dims != nullptr) {
-    env->ReleaseLongArrayElements(shape, dims, JNI_ABORT);
+  JavaVM* vm = nullptr;
+  if (env->GetJavaVM(&vm) != JNI_OK) {
+    throwException(env, kIllegalStateException, "unable to access the JVM");
+    return 0;
   }
+  WrappedBuffer* wrapped = new WrappedBuffer;
+  wrapped->vm = vm;
+  wrapped->buffer = env->NewGlobalRef(data);
+  std::vector<int64_t> dims;
+  getDims(env, shape, &dims);
+  TF_Tensor* t = TF_NewTensor(static_cast<TF_DataType>(dtype), dims.data(),
+                              static_cast<int>(dims.size()), address + offset,
+                              static_cast<size_t>(sizeInBytes),
+                              releaseWrappedBuffer, wrapped);
   if (t == nullptr) {
     throwException(env, kNullPointerException,
                    "unable to allocate memory for the Tensor");
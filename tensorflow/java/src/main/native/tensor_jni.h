@@ -31,6 +31,17 @@ JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocate(JNIEnv *, jclass,
                                                             jint, jlongArray,
                                                             jlong);
 
+/*
+ * Class:     org_tensorflow_Tensor
+ * Method:    allocateWrapping
+ * Signature: (I[JLjava/nio/ByteBuffer;IJ)J
+ *
+ * REQUIRES: The ByteBuffer is direct, and holds at least offset + byteSize
+ * bytes.
+ */
+JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocateWrapping(
+    JNIEnv *, jclass, jint, jlongArray, jobject, jint, jlong);
+
 /*
  * Class:     org_tensorflow_Tensor
  * Method:    allocateScalarBytes
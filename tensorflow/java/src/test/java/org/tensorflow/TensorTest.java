@@ -107,6 +107,52 @@ public class TensorTest {
     }
   }
 
+  @Test
+  public void wrapDirectBuffer() {
+    float[] floats = {1f, 2f, 3f, 4f, 5f, 6f};
+    long[] shape = {2, 3};
+    ByteBuffer buf = ByteBuffer.allocateDirect(4 * floats.length).order(ByteOrder.nativeOrder());
+    buf.asFloatBuffer().put(floats);
+    try (Tensor<Float> t = Tensor.wrap(Float.class, shape, buf)) {
+      assertEquals(DataType.FLOAT, t.dataType());
+      assertArrayEquals(shape, t.shape());
+      float[][] actual = t.copyTo(new float[2][3]);
+      assertArrayEquals(new float[] {1f, 2f, 3f}, actual[0], EPSILON_F);
+      assertArrayEquals(new float[] {4f, 5f, 6f}, actual[1], EPSILON_F);
+    }
+
+    // validate that only the remaining bytes are wrapped
+    buf.position(8);
+    try (Tensor<Float> t = Tensor.wrap(Float.class, new long[] {4}, buf)) {
+      assertArrayEquals(new float[] {3f, 4f, 5f, 6f}, t.copyTo(new float[4]), EPSILON_F);
+    }
+
+    // validate that incompatible buffers are rejected
+    try (Tensor<Float> t = Tensor.wrap(Float.class, shape, ByteBuffer.allocate(4 * 6))) {
+      fail("should have failed on a buffer that is not direct");
+    } catch (IllegalArgumentException e) {
+      // expected
+    }
+    try (Tensor<Float> t = Tensor.wrap(Float.class, shape, buf)) {
+      fail("should have failed on incompatible buffer");
+    } catch (IllegalArgumentException e) {
+      // expected
+    }
+  }
+
+  @Test
+  public void asReadOnlyBuffer() {
+    long[] longs = {1L, 2L, 3L};
+    try (Tensor<Long> t = Tensors.create(longs)) {
+      ByteBuffer view = t.asReadOnlyBuffer();
+      assertTrue(view.isReadOnly());
+      assertTrue(view.isDirect());
+      assertEquals(ByteOrder.nativeOrder(), view.order());
+      assertEquals(t.numBytes(), view.remaining());
+      assertEquals(3L, view.asLongBuffer().get(2));
+    }
+  }
+
   @Test
   public void createWithTypedBuffer() {
     int[] ints = {1, 2, 3, 4};
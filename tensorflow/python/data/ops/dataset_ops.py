@@ -485,7 +485,8 @@ class Dataset(object):
 
     Args:
       buffer_size: A `tf.int64` scalar `tf.Tensor`, representing the
-        maximum number elements that will be buffered when prefetching.
+        maximum number elements that will be buffered when prefetching. If
+        -1, the buffer size is tuned automatically.
 
     Returns:
       A `Dataset`.
@@ -553,18 +554,24 @@ class Dataset(object):
     """
     return ShuffleDataset(self, buffer_size, seed, reshuffle_each_iteration)
 
-  def cache(self, filename=""):
+  def cache(self, filename="", memory_budget_bytes=0, num_shards=1):
     """Caches the elements in this dataset.
 
     Args:
       filename: A `tf.string` scalar `tf.Tensor`, representing the name of a
         directory on the filesystem to use for caching tensors in this Dataset.
         If a filename is not provided, the dataset will be cached in memory.
+      memory_budget_bytes: (Optional.) If `filename` is provided, the number
+        of bytes of elements to keep in memory. Elements after the first that
+        does not fit are written to `filename`.
+      num_shards: (Optional.) If `filename` is provided, the number of files
+        that elements are written to. The files are written, and read back on
+        later iterations, in parallel.
 
     Returns:
       A `Dataset`.
     """
-    return CacheDataset(self, filename)
+    return CacheDataset(self, filename, memory_budget_bytes, num_shards)
 
   def take(self, count):
     """Creates a `Dataset` with at most `count` elements from this dataset.
@@ -718,7 +725,8 @@ class Dataset(object):
        `self.output_types`) to another nested structure of tensors.
       num_parallel_calls: (Optional.) A `tf.int32` scalar `tf.Tensor`,
         representing the number elements to process in parallel. If not
-        specified, elements will be processed sequentially.
+        specified, elements will be processed sequentially. If -1, the
+        number is tuned automatically.
 
     Returns:
       A `Dataset`.
@@ -1108,17 +1116,22 @@ class RangeDataset(Dataset):
 class CacheDataset(Dataset):
   """A `Dataset` that caches elements of its input."""
 
-  def __init__(self, input_dataset, filename):
+  def __init__(self, input_dataset, filename, memory_budget_bytes=0,
+               num_shards=1):
     """See `Dataset.cache()` for details."""
     super(CacheDataset, self).__init__()
     self._input_dataset = input_dataset
     self._filename = ops.convert_to_tensor(
         filename, dtype=dtypes.string, name="filename")
+    self._memory_budget_bytes = memory_budget_bytes
+    self._num_shards = num_shards
 
   def _as_variant_tensor(self):
     return gen_dataset_ops.cache_dataset(
         self._input_dataset._as_variant_tensor(),  # pylint: disable=protected-access
         filename=self._filename,
+        memory_budget_bytes=self._memory_budget_bytes,
+        num_shards=self._num_shards,
         output_shapes=nest.flatten(self.output_shapes),
         output_types=nest.flatten(self.output_types))
 
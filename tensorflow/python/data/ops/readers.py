@@ -82,15 +82,31 @@ class TextLineDataset(Dataset):
 class TFRecordDataset(Dataset):
   """A `Dataset` comprising records from one or more TFRecord files."""
 
-  def __init__(self, filenames, compression_type=None, buffer_size=None):
+  def __init__(self,
+               filenames,
+               compression_type=None,
+               buffer_size=None,
+               num_readahead_chunks=None,
+               use_memory_mapping=None):
     """Creates a `TFRecordDataset`.
 
     Args:
       filenames: A `tf.string` tensor containing one or more filenames.
       compression_type: (Optional.) A `tf.string` scalar evaluating to one of
-        `""` (no compression), `"ZLIB"`, or `"GZIP"`.
+        `""` (no compression), `"ZLIB"`, `"GZIP"`, or `"SNAPPY"`. Snappy is
+        much faster to uncompress than zlib, at the cost of larger files.
       buffer_size: (Optional.) A `tf.int64` scalar representing the number of
         bytes in the read buffer. 0 means no buffering.
+      num_readahead_chunks: (Optional.) A Python integer. If non-zero, each
+        file is read by this many concurrent reads of `buffer_size` bytes,
+        issued ahead of the records being returned. This hides the latency of
+        remote file systems such as GCS. Defaults to 0, which disables
+        readahead.
+      use_memory_mapping: (Optional.) A Python boolean. If true, and the files
+        are not compressed, each file is mapped into memory and its records
+        are read from the mapping, which avoids copying them through a read
+        buffer. Files on file systems that do not support mapping are read as
+        usual. Defaults to false.
     """
     super(TFRecordDataset, self).__init__()
     # Force the type to string even if filenames is an empty list.
@@ -105,10 +121,18 @@ class TFRecordDataset(Dataset):
         "buffer_size",
         buffer_size,
         argument_default=_DEFAULT_READER_BUFFER_SIZE_BYTES)
+    self._num_readahead_chunks = (
+        0 if num_readahead_chunks is None else num_readahead_chunks)
+    self._use_memory_mapping = (
+        False if use_memory_mapping is None else use_memory_mapping)
 
   def _as_variant_tensor(self):
     return gen_dataset_ops.tf_record_dataset(
-        self._filenames, self._compression_type, self._buffer_size)
+        self._filenames,
+        self._compression_type,
+        self._buffer_size,
+        num_readahead_chunks=self._num_readahead_chunks,
+        use_memory_mapping=self._use_memory_mapping)
 
   @property
   def output_shapes(self):
@@ -223,7 +223,7 @@ def _get_kind_name(item):
   return kind
 
 
-SAVE_AND_RESTORE_OPS = ["SaveV2",
+SAVE_AND_RESTORE_OPS = ["SaveV2", "SaveV2Async",
                         "Save", "SaveSlice",
                         "LegacySave", "LegacySaveSlice",
                         "RestoreV2",
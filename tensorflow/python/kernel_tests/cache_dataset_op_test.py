@@ -198,6 +198,50 @@ class FilesystemCacheDatasetTest(test.TestCase):
       self.assertAllEqual(elements, elements_itr1)
       self.assertAllEqual(elements, elements_itr2)
 
+  def testTieredCacheSpillsToShards(self):
+    # Each element is 8 bytes, so 50 elements fit in memory and the other 50
+    # are spilled to 3 shards.
+    cache_dataset = (dataset_ops.Dataset.range(100)
+                     .cache(self.cache_prefix, memory_budget_bytes=400,
+                            num_shards=3)
+                     .repeat(3))
+    get_next = cache_dataset.make_one_shot_iterator().get_next()
+
+    with self.test_session() as sess:
+      for _ in range(3):
+        for i in range(100):
+          self.assertEqual(i, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+    for i in range(3):
+      self.assertTrue(
+          path.exists("%s_%d-of-3.index" % (self.cache_prefix, i)))
+    self.assertTrue(path.exists(self.cache_prefix + ".tiers"))
+
+  def testTieredCacheReplaysFromShards(self):
+    count_placeholder = array_ops.placeholder_with_default(
+        constant_op.constant(20, dtypes.int64), shape=[])
+    cache_dataset = (dataset_ops.Dataset.range(count_placeholder)
+                     .cache(self.cache_prefix, num_shards=4))
+    iterator = cache_dataset.make_initializable_iterator()
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(iterator.initializer)
+      for i in range(20):
+        self.assertEqual(i, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+      # Re-initialize with an empty upstream, so that all elements must come
+      # from the shards written above.
+      sess.run(iterator.initializer, feed_dict={count_placeholder: 0})
+      for i in range(20):
+        self.assertEqual(i, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
 
 class MemoryCacheDatasetTest(test.TestCase):
 
@@ -0,0 +1,157 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the collective ops."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import numpy as np
+
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.client import session
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
+from tensorflow.python.framework import ops
+from tensorflow.python.framework import test_util
+from tensorflow.python.ops import collective_ops
+from tensorflow.python.platform import test
+
+
+def _local_devices(n):
+  return ["/job:localhost/replica:0/task:0/device:CPU:%d" % i
+          for i in range(n)]
+
+
+def _config(num_cpus):
+  return config_pb2.ConfigProto(device_count={"CPU": num_cpus})
+
+
+class CollectiveOpsTest(test.TestCase):
+
+  def _inputs(self, devices, shape, dtype=np.float32):
+    values = [np.random.randint(-100, 100, size=shape).astype(dtype)
+              for _ in devices]
+    inputs = []
+    for value, device in zip(values, devices):
+      with ops.device(device):
+        inputs.append(constant_op.constant(value))
+    return values, inputs
+
+  def testAllReduce(self):
+    devices = _local_devices(4)
+    for shape in [[], [3], [10, 7], [1000]]:
+      for subdivs in [1, 3]:
+        with ops.Graph().as_default():
+          values, inputs = self._inputs(devices, shape)
+          outputs = collective_ops.all_reduce_n(inputs, devices,
+                                                subdivs=subdivs)
+          with session.Session(config=_config(4)) as sess:
+            for result in sess.run(outputs):
+              self.assertAllEqual(sum(values), result)
+
+  def testAllReduceReductions(self):
+    devices = _local_devices(3)
+    with ops.Graph().as_default():
+      values, inputs = self._inputs(devices, [20], np.int32)
+      mins = collective_ops.all_reduce_n(inputs, devices, reduction="min")
+      maxs = collective_ops.all_reduce_n(inputs, devices, reduction="max")
+      means = collective_ops.all_reduce_n(
+          [t * 3 for t in inputs], devices, reduction="mean")
+      with session.Session(config=_config(3)) as sess:
+        mins, maxs, means = sess.run([mins, maxs, means])
+      for result in mins:
+        self.assertAllEqual(np.minimum.reduce(values), result)
+      for result in maxs:
+        self.assertAllEqual(np.maximum.reduce(values), result)
+      for result in means:
+        self.assertAllEqual(sum(values), result)
+
+  def testAllReduceRepeated(self):
+    devices = _local_devices(2)
+    with ops.Graph().as_default():
+      values, inputs = self._inputs(devices, [100])
+      outputs = collective_ops.all_reduce_n(inputs, devices)
+      with session.Session(config=_config(2)) as sess:
+        for _ in range(10):
+          for result in sess.run(outputs):
+            self.assertAllEqual(sum(values), result)
+
+  def testAllGather(self):
+    devices = _local_devices(3)
+    for subdivs in [1, 2]:
+      with ops.Graph().as_default():
+        values, inputs = self._inputs(devices, [5, 2])
+        outputs = collective_ops.all_gather_n(inputs, devices,
+                                              subdivs=subdivs)
+        with session.Session(config=_config(3)) as sess:
+          for result in sess.run(outputs):
+            self.assertAllEqual(np.concatenate(values), result)
+
+  def testBroadcast(self):
+    devices = _local_devices(5)
+    for source_rank in [0, 3]:
+      with ops.Graph().as_default():
+        values, inputs = self._inputs(devices, [33])
+        outputs = collective_ops.broadcast_n(inputs, devices, source_rank,
+                                             subdivs=2)
+        with session.Session(config=_config(5)) as sess:
+          for result in sess.run(outputs):
+            self.assertAllEqual(values[source_rank], result)
+
+  def testMismatchedShapes(self):
+    devices = _local_devices(2)
+    with ops.Graph().as_default():
+      inputs = []
+      for size, device in zip([3, 4], devices):
+        with ops.device(device):
+          inputs.append(constant_op.constant(0.0, shape=[size]))
+      outputs = collective_ops.all_gather_n(inputs, devices)
+      with session.Session(config=_config(2)) as sess:
+        with self.assertRaisesOpError("must have the same shape"):
+          sess.run(outputs)
+
+  def testDeviceNotInGroup(self):
+    devices = _local_devices(2)
+    with ops.Graph().as_default():
+      with ops.device(devices[0]):
+        t = constant_op.constant(1.0)
+      with ops.device("/job:localhost/replica:0/task:0/device:CPU:2"):
+        output = collective_ops.all_reduce(t, devices, instance_key="x")
+      with session.Session(config=_config(3)) as sess:
+        with self.assertRaises(errors.InvalidArgumentError):
+          sess.run(output)
+
+  def testHierarchicalAllReduceAcrossWorkers(self):
+    worker_config = config_pb2.ConfigProto()
+    worker_config.device_count["CPU"] = 2
+    workers, _ = test_util.create_local_cluster(
+        2, 1, worker_config=worker_config)
+    devices = ["/job:worker/replica:0/task:%d/device:CPU:%d" % (task, cpu)
+               for task in range(2) for cpu in range(2)]
+    for hierarchical in [False, True]:
+      with ops.Graph().as_default():
+        values, inputs = self._inputs(devices, [17], np.float64)
+        outputs = collective_ops.all_reduce_n(
+            inputs, devices, hierarchical=hierarchical, subdivs=2)
+        with session.Session(workers[0].target) as sess:
+          for result in sess.run(outputs):
+            self.assertAllEqual(sum(values), result)
+        self.assertEqual(dtypes.float64, outputs[0].dtype)
+
+
+if __name__ == "__main__":
+  test.main()
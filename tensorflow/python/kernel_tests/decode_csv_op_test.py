@@ -229,6 +229,29 @@ class DecodeCSVOpTest(test.TestCase):
     self._test(
         args, expected_err_re="Quoted field has to end with quote followed.*")
 
+  def testManyRecords(self):
+    records = ['%d,"a""%d",%d.5' % (i, i, i) for i in range(10000)]
+    args = {
+        "records": records,
+        "record_defaults": [[0], [""], [0.0]],
+    }
+
+    expected_out = [
+        list(range(10000)), ['a"%d' % i for i in range(10000)],
+        [i + 0.5 for i in range(10000)]
+    ]
+
+    self._test(args, expected_out)
+
+  def testManyRecordsReportsFirstError(self):
+    records = ["%d" % i for i in range(10000)]
+    records[7000] = "x"
+    records[3000] = "y"
+    args = {"records": records, "record_defaults": [[0]]}
+
+    self._test(
+        args, expected_err_re="Field 0 in record 3000 is not a valid int32: y")
+
 
 if __name__ == "__main__":
   test.main()
@@ -31,6 +31,7 @@ from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import data_flow_ops
 from tensorflow.python.ops import embedding_ops
 from tensorflow.python.ops import gradient_checker
+from tensorflow.python.ops import gradients_impl
 from tensorflow.python.ops import linalg_ops
 from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import partitioned_variables
@@ -719,6 +720,33 @@ class EmbeddingLookupSparseTest(test.TestCase):
             x, x_shape, y, y_shape, x_init_value=x_init_value)
       self.assertLess(err, 1e-5 if dtype == dtypes.float64 else 2e-3)
 
+  def testUnweightedLookupHasSparseGradient(self):
+    vocab_size = 12
+    batch_size = 4
+    sp_ids, _, ids, _, vals_per_batch_entry = self._RandomIdsAndWeights(
+        batch_size, vocab_size)
+    for combiner in ["sum", "mean", "sqrtn"]:
+      with self.test_session():
+        x, params, feed_dict = _EmbeddingParams(
+            1, vocab_size, shape=[3], dtype=dtypes.float32)
+        y = embedding_ops.embedding_lookup_sparse(
+            x, sp_ids, None, combiner=combiner)
+        grad, = gradients_impl.gradients(math_ops.reduce_sum(y), x)
+        self.assertTrue(isinstance(grad, ops.IndexedSlices))
+        # The rows of the ids, with their number of occurrences.
+        grouped_ids = self._GroupByBatchEntry(ids, vals_per_batch_entry)
+        expected = np.zeros([vocab_size, 3])
+        for row_ids in grouped_ids:
+          scale = {"sum": 1.0, "mean": 1.0 / len(row_ids),
+                   "sqrtn": 1.0 / np.sqrt(len(row_ids))}[combiner]
+          for i in row_ids:
+            expected[i] += scale
+        dense_grad = math_ops.unsorted_segment_sum(grad.values, grad.indices,
+                                                   vocab_size)
+        self.assertAllClose(expected, dense_grad.eval(feed_dict=feed_dict))
+        self.assertAllEqual(params[_PName(0) + ":0"].shape,
+                            grad.dense_shape.eval(feed_dict=feed_dict))
+
   def testIncompatibleShapes(self):
     with self.test_session():
       x, _, _ = _EmbeddingParams(1, 10, dtype=dtypes.float32)
@@ -235,6 +235,32 @@ class MapDatasetTest(test.TestCase):
       with self.assertRaises(errors.OutOfRangeError):
         sess.run(get_next)
 
+  def testAutoTunedParallelMapAndPrefetch(self):
+    iterator = (dataset_ops.Dataset.range(1000)
+                .map(lambda x: x * x, num_parallel_calls=-1)
+                .prefetch(-1)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      for i in range(1000):
+        self.assertEqual(i * i, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testParallelMapInvalidNumParallelCalls(self):
+    num_parallel_calls = array_ops.placeholder(dtypes.int32, shape=[])
+    iterator = (dataset_ops.Dataset.range(10)
+                .map(lambda x: x, num_parallel_calls=num_parallel_calls)
+                .make_initializable_iterator())
+
+    with self.test_session() as sess:
+      with self.assertRaisesRegexp(errors.InvalidArgumentError,
+                                   "num_parallel_calls"):
+        sess.run(iterator.initializer, feed_dict={num_parallel_calls: 0})
+
   def testPrefetchError(self):
     components = np.array([1., 2., 3., np.nan, 5.]).astype(np.float32)
 
@@ -725,6 +725,44 @@ class TFRecordDatasetTest(test.TestCase):
       with self.assertRaises(errors.OutOfRangeError):
         sess.run(iterator.get_next())
 
+  def testReadWithReadahead(self):
+    d = readers.TFRecordDataset(
+        self.test_filenames, buffer_size=16, num_readahead_chunks=4)
+    iterator = d.make_one_shot_iterator()
+    with self.test_session() as sess:
+      for j in range(self._num_files):
+        for i in range(self._num_records):
+          self.assertAllEqual(self._record(j, i), sess.run(iterator.get_next()))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(iterator.get_next())
+
+  def testReadWithMemoryMapping(self):
+    empty_file = os.path.join(self.get_temp_dir(), "empty.tfrecord")
+    open(empty_file, "wb").close()
+    d = readers.TFRecordDataset(
+        [empty_file] + self.test_filenames, use_memory_mapping=True)
+    iterator = d.make_one_shot_iterator()
+    with self.test_session() as sess:
+      for j in range(self._num_files):
+        for i in range(self._num_records):
+          self.assertAllEqual(self._record(j, i), sess.run(iterator.get_next()))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(iterator.get_next())
+
+  def testReadTruncatedWithMemoryMapping(self):
+    with open(self.test_filenames[0], "rb") as f:
+      contents = f.read()
+    truncated_file = os.path.join(self.get_temp_dir(), "truncated.tfrecord")
+    with open(truncated_file, "wb") as f:
+      f.write(contents[:-1])
+    d = readers.TFRecordDataset(truncated_file, use_memory_mapping=True)
+    iterator = d.make_one_shot_iterator()
+    with self.test_session() as sess:
+      for i in range(self._num_records - 1):
+        self.assertAllEqual(self._record(0, i), sess.run(iterator.get_next()))
+      with self.assertRaises(errors.DataLossError):
+        sess.run(iterator.get_next())
+
 
 if __name__ == "__main__":
   test.main()
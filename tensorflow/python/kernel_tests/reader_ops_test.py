@@ -930,6 +930,20 @@ class TFRecordIteratorTest(test.TestCase):
       actual.append(r)
     self.assertEqual(actual, original)
 
+  def testWriteSnappyRead(self):
+    # Make one record larger than a compressed block.
+    original = [b"foo", _TEXT * 1024, b"bar"]
+    fn = self._WriteCompressedRecordsToFile(
+        original,
+        "write_snappy_read.tfrecord.snappy",
+        compression_type=TFRecordCompressionType.SNAPPY)
+    options = tf_record.TFRecordOptions(
+        compression_type=TFRecordCompressionType.SNAPPY)
+    actual = []
+    for r in tf_record.tf_record_iterator(fn, options):
+      actual.append(r)
+    self.assertEqual(actual, original)
+
   def testBadFile(self):
     """Verify that tf_record_iterator throws an exception on bad TFRecords."""
     fn = os.path.join(self.get_temp_dir(), "bad_file")
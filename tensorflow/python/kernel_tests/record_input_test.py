@@ -135,5 +135,32 @@ class RecordInputOpTest(test.TestCase):
             self.assertTrue(r[0] not in epoch_set)
             epoch_set.add(r[0])
 
+  def testMoreReadersThanFiles(self):
+    files = 3
+    records_per_file = 50
+    with self.test_session() as sess:
+      self.generateTestData("basic", files, records_per_file)
+
+      records = data_flow_ops.RecordInput(
+          file_pattern=os.path.join(self.get_temp_dir(), "basic.*"),
+          parallelism=8,
+          buffer_size=1000,
+          batch_size=1,
+          seed=10,
+          name="record_input",
+          numa_aware=True)
+
+      yield_op = records.get_yield_op()
+
+      # Each epoch yields every record once, although only some of the
+      # readers have files and none of them fills its buffer.
+      for _ in range(3):
+        epoch_set = set()
+        for _ in range(files * records_per_file):
+          r = sess.run(yield_op)
+          self.assertTrue(r[0] not in epoch_set)
+          epoch_set.add(r[0])
+        self.assertEqual(files * records_per_file, len(epoch_set))
+
 if __name__ == "__main__":
   test.main()
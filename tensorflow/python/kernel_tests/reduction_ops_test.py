@@ -708,6 +708,16 @@ class MaxReductionTest(test.TestCase):
     self._compareAll(np_arr, [0, 2])
     self._compareAll(np_arr, [0, 1, 2])
 
+  def testLargeRandomReduce(self):
+    # Tall, wide and short shapes, whose rows and columns are split across
+    # threads and into blocks.
+    for shape in [(100000, 3), (3, 100000), (300, 2500), (2, 5000, 17)]:
+      np_arr = np.random.randn(*shape).astype(np.float32)
+      for axes in [None, [0], [1], [0, 2], [1, 2]]:
+        if axes is not None and max(axes) >= len(shape):
+          continue
+        self._compare(np_arr, axes, False)
+
   def testDoubleReduce3D(self):
     # Create a 3D array of doubles and reduce across all possible
     # dimensions
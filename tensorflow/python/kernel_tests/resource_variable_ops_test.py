@@ -18,6 +18,7 @@ from __future__ import division
 from __future__ import print_function
 
 import gc
+import os
 
 import numpy as np
 
@@ -169,6 +170,35 @@ class ResourceVariableOpsTest(test_util.TensorFlowTestCase):
     read = resource_variable_ops.read_variable_op(handle, dtype=dtypes.int32)
     self.assertEqual(self.evaluate(read), [[3]])
 
+  def testAggregatedScatterAdd(self):
+    os.environ["TF_SCATTER_ADD_AGGREGATION_WINDOW_MICROS"] = "100000"
+    os.environ["TF_SCATTER_ADD_AGGREGATION_COUNT"] = "4"
+    try:
+      with self.test_session():
+        handle = resource_variable_ops.var_handle_op(
+            dtype=dtypes.float32, shape=[3, 2])
+        resource_variable_ops.assign_variable_op(
+            handle, array_ops.zeros([3, 2])).run()
+        adds = [resource_variable_ops.resource_scatter_add(
+            handle, [0, 2, 0], array_ops.ones([3, 2]) * (i + 1))
+                for i in range(4)]
+        control_flow_ops.group(*adds).run()
+        read = resource_variable_ops.read_variable_op(
+            handle, dtype=dtypes.float32)
+        self.assertAllEqual([[20, 20], [0, 0], [10, 10]], read.eval())
+
+        # A batch smaller than the count is applied when the window ends.
+        resource_variable_ops.resource_scatter_add(
+            handle, [1], [[1.0, 2.0]]).run()
+        self.assertAllEqual([[20, 20], [1, 2], [10, 10]], read.eval())
+
+        with self.assertRaisesOpError(r"indices\[0\] = 3 is not in \[0, 3\)"):
+          resource_variable_ops.resource_scatter_add(
+              handle, [3], [[1.0, 1.0]]).run()
+    finally:
+      del os.environ["TF_SCATTER_ADD_AGGREGATION_WINDOW_MICROS"]
+      del os.environ["TF_SCATTER_ADD_AGGREGATION_COUNT"]
+
   # TODO(alive): get this to work in Eager mode.
   def testGPU(self):
     with self.test_session(use_gpu=True):
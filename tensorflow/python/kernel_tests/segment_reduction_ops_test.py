@@ -125,6 +125,17 @@ class SegmentReductionOpTest(SegmentReductionHelper):
             # and may therefore vary dynamically.
             self.assertAllEqual(np_ans.shape[1:], tf_ans.shape[1:])
 
+  def testLargeSegmentSumWithHoles(self):
+    # Large enough for the segments to be reduced in parallel.
+    np.random.seed(0)
+    segment_ids = np.sort(np.random.randint(0, 5000, size=10000)) * 3
+    np_x = np.random.rand(10000, 32).astype(np.float32)
+    np_ans = np.zeros([segment_ids[-1] + 1, 32], dtype=np.float32)
+    np.add.at(np_ans, segment_ids, np_x)
+    with self.test_session(use_gpu=False):
+      s = math_ops.segment_sum(data=np_x, segment_ids=segment_ids)
+      self.assertAllClose(np_ans, s.eval())
+
   def testSegmentIdsShape(self):
     shape = [4, 4]
     tf_x, _ = self._input(shape)
@@ -413,6 +424,25 @@ class SparseSegmentReductionOpTest(SparseSegmentReductionHelper):
           # and may therefore vary dynamically.
           self.assertAllEqual(np_ans.shape[1:], tf_ans.shape[1:])
 
+  def testLargeWithHoles(self):
+    # Large enough for the segments to be reduced in parallel.
+    np.random.seed(0)
+    indices = np.random.randint(0, 1000, size=10000).astype(np.int32)
+    segment_ids = (np.sort(np.random.randint(0, 5000, size=10000)) * 3).astype(
+        np.int32)
+    np_x = np.random.rand(1000, 32).astype(np.float32)
+    np_sum = np.zeros([segment_ids[-1] + 1, 32], dtype=np.float32)
+    np.add.at(np_sum, segment_ids, np_x[indices])
+    counts = np.bincount(segment_ids).reshape([-1, 1]).astype(np.float32)
+    np_mean = np_sum / np.maximum(counts, 1)
+    with self.test_session(use_gpu=False):
+      s = math_ops.sparse_segment_sum(
+          data=np_x, indices=indices, segment_ids=segment_ids)
+      self.assertAllClose(np_sum, s.eval())
+      s = math_ops.sparse_segment_mean(
+          data=np_x, indices=indices, segment_ids=segment_ids)
+      self.assertAllClose(np_mean, s.eval())
+
   def testSegmentIdsHole(self):
     tf_x, np_x = self._input([10, 4], dtype=dtypes_lib.float32)
     ops_list = [(np.add, None, math_ops.sparse_segment_sum), (
@@ -427,6 +457,23 @@ class SparseSegmentReductionOpTest(SparseSegmentReductionHelper):
         tf_ans = s.eval()
         self.assertAllClose(np_ans, tf_ans)
 
+  def testInt64IndicesAndGpu(self):
+    tf_x, np_x = self._input([10, 4], dtype=dtypes_lib.float32)
+    ops_list = [(np.add, None, math_ops.sparse_segment_sum), (
+        self._mean_cum_op, self._mean_reduce_op, math_ops.sparse_segment_mean)]
+    segment_indices = [0, 2, 2, 2, 5]
+    indices = [8, 3, 0, 9, 3]
+    for use_gpu in [False, True]:
+      with self.test_session(use_gpu=use_gpu):
+        for np_op1, np_op2, tf_op in ops_list:
+          np_ans = self._sparseSegmentReduce(np_x, indices, segment_indices,
+                                             np_op1, np_op2)
+          s = tf_op(
+              data=tf_x,
+              indices=constant_op.constant(indices, dtypes_lib.int64),
+              segment_ids=segment_indices)
+          self.assertAllClose(np_ans, s.eval())
+
   def testSegmentIdsGreaterThanZero(self):
     tf_x, np_x = self._input([10, 4], dtype=dtypes_lib.float32)
     ops_list = [(np.add, None, math_ops.sparse_segment_sum), (
@@ -186,6 +186,15 @@ class SparseXentTest(test.TestCase):
   def testEmpty(self):
     self._testXent(np.zeros((0, 3)), np.zeros((0,), dtype=np.int32))
 
+  def testManyClasses(self):
+    # The rows span several chunks of the CPU kernel, and their maximum
+    # increases from one chunk to the next.
+    np.random.seed(1)
+    for dtype in [np.float32, np.float64]:
+      features = (np.random.randn(3, 5000) +
+                  np.linspace(0., 20., 5000)).astype(dtype)
+      self._testXent(features, np.array([0, 2500, 4999]).astype(np.int64))
+
   def testGradient(self):
     with self.test_session(use_gpu=True):
       l = constant_op.constant([3, 0, 1], name="l")
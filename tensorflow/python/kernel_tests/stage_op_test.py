@@ -67,6 +67,31 @@ class StageTest(test.TestCase):
         self.assertAllClose(
             4 * (i - 1) * (i - 1) * (i - 1) * 128, yval, rtol=1e-4)
 
+  def testPrefetchToDevice(self):
+    with ops.Graph().as_default() as G:
+      with ops.device('/cpu:0'):
+        x = array_ops.placeholder(dtypes.float32)
+        v = 2. * (array_ops.zeros([128, 128]) + x)
+      with ops.device(test.gpu_device_name()):
+        stager = data_flow_ops.StagingArea([dtypes.float32, dtypes.float32],
+                                           capacity=2,
+                                           prefetch_to_device=True)
+        stage = stager.put([x, v])
+        z, y = stager.get()
+        y = math_ops.reduce_max(z * math_ops.matmul(y, y))
+
+    G.finalize()
+
+    with self.test_session(use_gpu=True, graph=G) as sess:
+      # Keep two elements staged, so that the device buffers are cycled
+      # through while earlier values are still waiting to be read.
+      sess.run(stage, feed_dict={x: -1})
+      sess.run(stage, feed_dict={x: 0})
+      for i in range(10):
+        _, yval = sess.run([stage, y], feed_dict={x: i + 1})
+        self.assertAllClose(
+            4 * (i - 1) * (i - 1) * (i - 1) * 128, yval, rtol=1e-4)
+
   def testDictionary(self):
     with ops.Graph().as_default() as G:
       with ops.device('/cpu:0'):
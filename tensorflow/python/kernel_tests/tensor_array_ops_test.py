@@ -182,6 +182,49 @@ class TensorArrayTest(test.TestCase):
   def testTensorArrayPackNotAllValuesAvailableFails(self):
     self._testTensorArrayPackNotAllValuesAvailableFails()
 
+  @test_util.run_in_graph_and_eager_modes()
+  def testTensorArrayWriteStackGatherConcatContiguous(self):
+    # 16 float32 values per element, so that on the CPU the elements are
+    # written into contiguous storage which stack, gather and concat return.
+    with self.test_session(use_gpu=True):
+      values = np.arange(48, dtype=np.float32).reshape(3, 1, 16)
+
+      def write_all(**kwargs):
+        ta = tensor_array_ops.TensorArray(
+            dtype=dtypes.float32, size=3, **kwargs)
+        for i in range(3):
+          ta = ta.write(i, values[i])
+        return ta
+
+      self.assertAllEqual(values, self.evaluate(write_all().stack()))
+      self.assertAllEqual(values,
+                          self.evaluate(write_all().gather([0, 1, 2])))
+      self.assertAllEqual(values[[2, 0]],
+                          self.evaluate(write_all().gather([2, 0])))
+      self.assertAllEqual(values.reshape(3, 16),
+                          self.evaluate(write_all().concat()))
+
+      # Reading an element first keeps it readable after a stack.
+      ta = write_all(clear_after_read=False)
+      r1 = ta.read(1)
+      with ops.control_dependencies([r1]):
+        c0 = ta.stack()
+      with ops.control_dependencies([c0]):
+        r0 = ta.read(0)
+      d1, d_stack, d0 = self.evaluate([r1, c0, r0])
+      self.assertAllEqual(values[1], d1)
+      self.assertAllEqual(values, d_stack)
+      self.assertAllEqual(values[0], d0)
+
+      # Elements whose shape differs from the first one stay separate, and
+      # stacking them still fails.
+      ta = tensor_array_ops.TensorArray(
+          dtype=dtypes.float32, size=2, infer_shape=False)
+      ta = ta.write(0, values[0]).write(1, values[1, :, :8])
+      self.assertAllEqual(values[1, :, :8], self.evaluate(ta.read(1)))
+      with self.assertRaisesOpError("inconsistent shapes"):
+        self.evaluate(ta.stack())
+
   def _testTensorArrayUnpackRead(self, tf_dtype):
     with self.test_session(use_gpu=True):
       convert = _make_converter(tf_dtype)
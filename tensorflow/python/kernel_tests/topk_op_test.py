@@ -160,6 +160,18 @@ class TopKTest(test.TestCase):
       values = -np.sort(-inputs, axis=1)[:, :k]
       self._validateTopK(inputs, k, values, indices)
 
+  def testLargeVocabularyTopK(self):
+    # A single long row, whose columns are split across threads.
+    n = 1000000
+    k = 100
+    for dtype in [np.float32, np.int32]:
+      # Repeated values, so that the ties span the splits of the row.
+      inputs = np.random.randint(0, 5000, size=(1, n)).astype(dtype)
+      indices = np.argsort(-inputs, axis=1, kind="mergesort")[:, :k]
+      values = -np.sort(-inputs, axis=1)[:, :k]
+      self._validateTopK(inputs, k, values, indices)
+      self._validateTopK(inputs, k, values, indices, sorted=False)
+
   def testTopAll(self):
     inputs = [[0.1, 0.3, 0.2, 0.4], [0.1, 0.3, 0.3, 0.2]]
     self._validateTopK(inputs, 4, [[0.4, 0.3, 0.2, 0.1], [0.3, 0.3, 0.2, 0.1]],
@@ -396,6 +396,19 @@ class TransposeTest(test.TestCase):
     self._testBoth(
         np.arange(0, 1260).reshape([2, 3, 5, 7, 2, 3]).astype(np.int64))
 
+  def testLargeCpu(self):
+    # Exercises the batched matrix transposes and the permutations of rows,
+    # with sizes that are not multiples of the blocks.
+    shapes_and_perms = [([67, 131], [1, 0]), ([3, 131, 67], [0, 2, 1]),
+                        ([1000, 3], [1, 0]), ([5, 1, 67, 33], [3, 1, 0, 2]),
+                        ([7, 9, 11, 40], [2, 0, 1, 3])]
+    for dtype in [np.int8, np.int16, np.float32, np.int64]:
+      for shape, perm in shapes_and_perms:
+        x = np.random.randint(100, size=shape).astype(dtype)
+        with self.test_session(use_gpu=False):
+          y = array_ops.transpose(x, perm).eval()
+        self.assertAllEqual(self._np_transpose(x, perm), y)
+
   def testTranspose2DAuto(self):
     x_np = [[1, 2, 3], [4, 5, 6]]
     for use_gpu in [False, True]:
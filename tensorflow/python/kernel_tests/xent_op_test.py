@@ -156,6 +156,17 @@ class XentTest(test.TestCase):
         np.array([[1., 1., 1., 1.], [1., 2., 3., 4.]]).astype(np.float64),
         np.array([[0., 0., 0., 1.], [0., .5, .5, 0.]]).astype(np.float64))
 
+  def testManyClasses(self):
+    # The rows span several chunks of the CPU kernel, and their maximum
+    # increases from one chunk to the next.
+    np.random.seed(1)
+    for dtype in [np.float32, np.float64]:
+      features = (np.random.randn(3, 5000) +
+                  np.linspace(0., 20., 5000)).astype(dtype)
+      labels = np.random.rand(3, 5000).astype(dtype)
+      labels /= np.sum(labels, axis=1, keepdims=True)
+      self._testAll(features, labels)
+
   def testGradient(self):
     with self.test_session() as sess:
       l = constant_op.constant(
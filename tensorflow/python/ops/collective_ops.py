@@ -0,0 +1,149 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Collective operations across a group of devices.
+
+Each member of the group runs one op of the collective, and the members
+exchange their tensors directly over the distributed runtime. For
+in-graph replication, the `*_n` functions build the op of every member;
+for between-graph replication, each worker builds the ops of its own
+devices with the same `devices` and `instance_key`.
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.python.framework import device as pydev
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import gen_collective_ops
+
+
+def _canonical_devices(devices):
+  return [pydev.canonical_name(d) for d in devices]
+
+
+def all_reduce(t, devices, instance_key, reduction="sum", hierarchical=False,
+               subdivs=1, name=None):
+  """Reduces `t` across `devices`, on the device where it is placed.
+
+  Args:
+    t: The contribution of this device.
+    devices: The full names of the devices of the group, in ring order.
+    instance_key: A string that identifies this collective, which must be the
+      same on all the devices of the group.
+    reduction: One of "sum", "mean", "min" or "max".
+    hierarchical: Whether to reduce within each task before reducing across
+      tasks.
+    subdivs: The number of parts of `t` that are reduced concurrently.
+    name: A name for the operation (optional).
+
+  Returns:
+    The reduction of the contributions of all the devices.
+  """
+  return gen_collective_ops.collective_all_reduce(
+      t, reduction=reduction, devices=_canonical_devices(devices),
+      instance_key=instance_key, hierarchical=hierarchical, subdivs=subdivs,
+      name=name)
+
+
+def all_gather(t, devices, instance_key, subdivs=1, name=None):
+  """Concatenates `t` across `devices` along the first dimension.
+
+  Args:
+    t: The contribution of this device.
+    devices: The full names of the devices of the group, in ring order.
+    instance_key: A string that identifies this collective, which must be the
+      same on all the devices of the group.
+    subdivs: The number of parts of `t` that are passed around concurrently.
+    name: A name for the operation (optional).
+
+  Returns:
+    The contributions of all the devices, in the order of `devices`.
+  """
+  return gen_collective_ops.collective_all_gather(
+      t, devices=_canonical_devices(devices), instance_key=instance_key,
+      subdivs=subdivs, name=name)
+
+
+def broadcast(t, devices, source_rank, instance_key, subdivs=1, name=None):
+  """Copies `t` from `devices[source_rank]` to all of `devices`.
+
+  Args:
+    t: On the source, the tensor to broadcast. On the other devices, a tensor of
+      the same shape and type, whose value is ignored.
+    devices: The full names of the devices of the group.
+    source_rank: The index of the source in `devices`.
+    instance_key: A string that identifies this collective, which must be the
+      same on all the devices of the group.
+    subdivs: The number of parts of `t` that are forwarded separately.
+    name: A name for the operation (optional).
+
+  Returns:
+    The tensor of the source.
+  """
+  return gen_collective_ops.collective_broadcast(
+      t, source_rank=source_rank, devices=_canonical_devices(devices),
+      instance_key=instance_key, subdivs=subdivs, name=name)
+
+
+def _build_n(fn, inputs, devices, name, default_name, **kwargs):
+  if len(inputs) != len(devices):
+    raise ValueError("Expected one input for each of the %d devices, got %d" %
+                     (len(devices), len(inputs)))
+  with ops.name_scope(name, default_name, inputs) as scope:
+    # The name scope is unique in the graph, so it identifies the collective.
+    instance_key = scope.rstrip("/")
+    outputs = []
+    for t, device in zip(inputs, devices):
+      with ops.device(device):
+        outputs.append(fn(t, devices, instance_key=instance_key, **kwargs))
+    return outputs
+
+
+def all_reduce_n(inputs, devices, reduction="sum", hierarchical=False,
+                 subdivs=1, name=None):
+  """Builds an `all_reduce` of `inputs[i]` on each of `devices[i]`.
+
+  Returns:
+    The list of the reductions on each of `devices`.
+  """
+  return _build_n(all_reduce, inputs, devices, name, "CollectiveAllReduce",
+                  reduction=reduction, hierarchical=hierarchical,
+                  subdivs=subdivs)
+
+
+def all_gather_n(inputs, devices, subdivs=1, name=None):
+  """Builds an `all_gather` of `inputs[i]` on each of `devices[i]`.
+
+  Returns:
+    The list of the concatenations on each of `devices`.
+  """
+  return _build_n(all_gather, inputs, devices, name, "CollectiveAllGather",
+                  subdivs=subdivs)
+
+
+def broadcast_n(inputs, devices, source_rank, subdivs=1, name=None):
+  """Builds a `broadcast` from `devices[source_rank]` on each of `devices`.
+
+  Returns:
+    The list of the copies on each of `devices`.
+  """
+  return _build_n(broadcast, inputs, devices, name, "CollectiveBroadcast",
+                  source_rank=source_rank, subdivs=subdivs)
+
+
+ops.NotDifferentiable("CollectiveAllReduce")
+ops.NotDifferentiable("CollectiveAllGather")
+ops.NotDifferentiable("CollectiveBroadcast")
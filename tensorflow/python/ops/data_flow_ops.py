@@ -1657,7 +1657,7 @@ class StagingArea(BaseStagingArea):
   """
 
   def __init__(self, dtypes, shapes=None, names=None, shared_name=None,
-                  capacity=0, memory_limit=0):
+                  capacity=0, memory_limit=0, prefetch_to_device=False):
     """Constructs a staging area object.
 
     The two optional lists, `shapes` and `names`, must be of the same length
@@ -1687,6 +1687,12 @@ class StagingArea(BaseStagingArea):
       shared_name: (Optional.) A name to be used for the shared object. By
         passing the same name to two different python objects they will share
         the underlying staging area. Must be a string.
+      prefetch_to_device: (Optional.) If True, `put` takes its values in host
+        memory and copies them asynchronously into device buffers that are
+        allocated once and reused, and values only become available to `get`
+        once they are on the device. This avoids separate copy ops, and
+        allocations, between `put` and `get` on devices such as GPUs. The
+        values must have types that can be copied with memcpy.
 
     Raises:
       ValueError: If one of the arguments is invalid.
@@ -1695,6 +1701,7 @@ class StagingArea(BaseStagingArea):
     super(StagingArea, self).__init__(dtypes, shapes,
                                           names, shared_name,
                                           capacity, memory_limit)
+    self._prefetch_to_device = prefetch_to_device
 
   def put(self, values, name=None):
     """Create an op that places a value into the staging area.
@@ -1720,10 +1727,12 @@ class StagingArea(BaseStagingArea):
                   if isinstance(values, (list, tuple)) else None)
       vals, _ = self._check_put_dtypes(values, indices)
 
+      stage_fn = (gen_data_flow_ops.device_stage if self._prefetch_to_device
+                  else gen_data_flow_ops.stage)
       with ops.colocate_with(self._coloc_op):
-        op = gen_data_flow_ops.stage(values=vals, shared_name=self._name,
-                                     name=scope, capacity=self._capacity,
-                                     memory_limit=self._memory_limit)
+        op = stage_fn(values=vals, shared_name=self._name,
+                      name=scope, capacity=self._capacity,
+                      memory_limit=self._memory_limit)
 
       return op
 
@@ -2225,7 +2234,8 @@ class RecordInput(object):
                shift_ratio=0,
                seed=0,
                name=None,
-               batches=None):
+               batches=None,
+               numa_aware=False):
     """Constructs a RecordInput Op.
 
     Args:
@@ -2243,6 +2253,8 @@ class RecordInput(object):
         how many batches to create, which are returned as a list when
         `get_yield_op()` is called. An example use case is to split processing
         between devices on one computer.
+      numa_aware: If True, and the machine has more than one NUMA node, the
+        reader threads are spread over the nodes and pinned to them.
 
     Raises:
       ValueError: If one of the arguments is invalid.
@@ -2257,6 +2269,7 @@ class RecordInput(object):
     self._shift_ratio = shift_ratio
     self._seed = seed
     self._name = name
+    self._numa_aware = numa_aware
 
   def get_yield_op(self):
     """Adds a node that yields a group of records every time it is executed.
@@ -2270,6 +2283,7 @@ class RecordInput(object):
         file_shuffle_shift_ratio=self._shift_ratio,
         batch_size=self._batch_size,
         file_random_seed=self._seed,
+        numa_aware=self._numa_aware,
         name=self._name)
     if self._batches is None:
       return records
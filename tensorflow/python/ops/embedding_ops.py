@@ -328,6 +328,74 @@ def embedding_lookup(
       transform_fn=None)
 
 
+# The gradients of the sparse segment reductions of _sparse_segment_lookup,
+# which are IndexedSlices of the rows of `params` that they read.
+@ops.RegisterGradient("EmbeddingSparseSegmentSum")
+def _EmbeddingSparseSegmentSumGrad(op, grad):
+  values = array_ops.gather(grad, op.inputs[2])
+  return _sparse_segment_params_grad(op, values), None, None
+
+
+@ops.RegisterGradient("EmbeddingSparseSegmentMean")
+def _EmbeddingSparseSegmentMeanGrad(op, grad):
+  num_ids = array_ops.size(op.inputs[1])
+  values = math_ops.sparse_segment_mean_grad(grad, math_ops.range(num_ids),
+                                             op.inputs[2], num_ids)
+  return _sparse_segment_params_grad(op, values), None, None
+
+
+@ops.RegisterGradient("EmbeddingSparseSegmentSqrtN")
+def _EmbeddingSparseSegmentSqrtNGrad(op, grad):
+  num_ids = array_ops.size(op.inputs[1])
+  values = math_ops.sparse_segment_sqrt_n_grad(grad, math_ops.range(num_ids),
+                                               op.inputs[2], num_ids)
+  return _sparse_segment_params_grad(op, values), None, None
+
+
+def _sparse_segment_params_grad(op, values):
+  return ops.IndexedSlices(values, op.inputs[1],
+                           array_ops.shape(op.inputs[0]))
+
+
+def _sparse_segment_lookup(params, ids, segment_ids, combiner, name):
+  """Combines the embeddings `params[ids]` by `segment_ids`.
+
+  The sparse segment reduction reads the rows of `params` directly, instead of
+  gathering them into a tensor of all the embeddings of `ids` first. Its
+  gradient with respect to `params` is an `IndexedSlices`, like the gradient of
+  the gather.
+
+  Args:
+    params: A single embedding `Tensor` or `Variable`.
+    ids: A 1-D `Tensor` of the ids to look up.
+    segment_ids: A 1-D `int32` `Tensor` of the sorted rows of the result that
+      the ids are combined into.
+    combiner: One of "mean", "sqrtn" and "sum".
+    name: A name for the operation.
+
+  Returns:
+    The combined embeddings.
+  """
+  params = ops.convert_to_tensor(params, name="params")
+  with ops.colocate_with(params):
+    with ops.get_default_graph().gradient_override_map({
+        "SparseSegmentSum": "EmbeddingSparseSegmentSum",
+        "SparseSegmentMean": "EmbeddingSparseSegmentMean",
+        "SparseSegmentSqrtN": "EmbeddingSparseSegmentSqrtN"
+    }):
+      if combiner == "sum":
+        return math_ops.sparse_segment_sum(
+            params, ids, segment_ids, name=name)
+      elif combiner == "mean":
+        return math_ops.sparse_segment_mean(
+            params, ids, segment_ids, name=name)
+      elif combiner == "sqrtn":
+        return math_ops.sparse_segment_sqrt_n(
+            params, ids, segment_ids, name=name)
+      else:
+        assert False, "Unrecognized combiner"
+
+
 def embedding_lookup_sparse(params,
                             sp_ids,
                             sp_weights,
@@ -436,6 +504,10 @@ def embedding_lookup_sparse(params,
       segment_ids = math_ops.cast(segment_ids, dtypes.int32)
 
     ids = sp_ids.values
+    if (ignore_weights and max_norm is None and len(params) == 1 and
+        not isinstance(params[0], resource_variable_ops.ResourceVariable)):
+      return _sparse_segment_lookup(params[0], ids, segment_ids, combiner,
+                                    name)
     if ignore_weights:
       ids, idx = array_ops.unique(ids)
     else:
@@ -2482,6 +2482,71 @@ class JpegTest(test_util.TensorFlowTestCase):
             lambda e: "Invalid JPEG data or crop window" in str(e)):
           sess.run(result)
 
+  def testDecodeCropAndResizeJpeg(self):
+    with self.test_session() as sess:
+      base = "tensorflow/core/lib/jpeg/testdata"
+      jpeg0 = io_ops.read_file(os.path.join(base, "jpeg_merge_test1.jpg"))
+      image = image_ops.decode_jpeg(jpeg0)
+
+      h, w = 256, 128
+      # None of these is downscaled while decoding, so the fused op matches
+      # the separate ops exactly.
+      cases = [([0, 0, h, w], [200, 100]), ([6, 5, 15, 10], [20, 30]),
+               ([h - 6, w - 5, 6, 5], [4, 7]), ([10, 20, 100, 40], [60, 30])]
+      for crop_window, size in cases:
+        for align_corners in [False, True]:
+          y, x, crop_h, crop_w = crop_window
+          image1 = image_ops.resize_bilinear(
+              array_ops.expand_dims(
+                  image_ops.crop_to_bounding_box(image, y, x, crop_h, crop_w),
+                  0),
+              size,
+              align_corners=align_corners)[0]
+          image2 = image_ops.decode_crop_and_resize_jpeg(
+              jpeg0, crop_window, size, align_corners=align_corners)
+          self.assertAllEqual(image1.get_shape().as_list(),
+                              image2.get_shape().as_list())
+          image1, image2 = sess.run([image1, image2])
+          self.assertAllEqual(image1, image2)
+
+  def testDecodeCropAndResizeJpegDownscalesWhileDecoding(self):
+    with self.test_session() as sess:
+      base = "tensorflow/core/lib/jpeg/testdata"
+      jpeg0 = io_ops.read_file(os.path.join(base, "jpeg_merge_test1.jpg"))
+      image = image_ops.decode_jpeg(jpeg0)
+
+      for crop_window, size in [([0, 0, 256, 128], [32, 16]),
+                                ([16, 8, 200, 96], [48, 24])]:
+        y, x, crop_h, crop_w = crop_window
+        image1 = image_ops.resize_area(
+            array_ops.expand_dims(
+                image_ops.crop_to_bounding_box(image, y, x, crop_h, crop_w), 0),
+            size)[0]
+        image2 = image_ops.decode_crop_and_resize_jpeg(jpeg0, crop_window,
+                                                       size)
+        image1, image2 = sess.run([image1, image2])
+        self.assertAllEqual(size + [3], image2.shape)
+        # The IDCT downscaling is close to an area resize of the full image.
+        self.assertLess(self.averageError(image1, image2), 3.0)
+
+  def testDecodeCropAndResizeJpegWithInvalidArguments(self):
+    with self.test_session() as sess:
+      base = "tensorflow/core/lib/jpeg/testdata"
+      jpeg0 = io_ops.read_file(os.path.join(base, "jpeg_merge_test1.jpg"))
+
+      h, w = 256, 128
+      for crop_window in [[-1, 11, 11, 11], [11, 11, 0, 11], [0, 0, h + 1, w]]:
+        result = image_ops.decode_crop_and_resize_jpeg(jpeg0, crop_window,
+                                                       [8, 8])
+        with self.assertRaisesWithPredicateMatch(
+            errors.InvalidArgumentError,
+            lambda e: "Invalid JPEG data or crop window" in str(e)):
+          sess.run(result)
+      size = array_ops.placeholder(dtypes.int32, shape=[2])
+      result = image_ops.decode_crop_and_resize_jpeg(jpeg0, [0, 0, h, w], size)
+      with self.assertRaisesOpError("size must be positive"):
+        sess.run(result, feed_dict={size: [0, 8]})
+
   def testSynthetic(self):
     with self.test_session(use_gpu=True) as sess:
       # Encode it, then decode it, then encode it
@@ -230,6 +230,28 @@ class TrainingOpsTest(TensorFlowTestCase):
       indices = np.array([0, 2]).astype(index_type)
       self._testTypesForSparseAdagrad(x, y, lr, grad, indices)
 
+  def testSparseApplyAdagradLargeRepeatedIndices(self):
+    # Large enough for the updates to be applied in parallel by row ranges.
+    np.random.seed(0)
+    x = np.random.rand(1000, 256).astype(np.float32)
+    y = np.random.rand(1000, 256).astype(np.float32) + 1.0
+    lr = np.array(0.5).astype(np.float32)
+    indices = np.random.randint(0, 1000, size=2048).astype(np.int32)
+    grad = np.random.rand(2048, 256).astype(np.float32)
+    with self.test_session(use_gpu=False):
+      var = variables.Variable(x)
+      accum = variables.Variable(y)
+      variables.global_variables_initializer().run()
+      training_ops.sparse_apply_adagrad(var, accum, lr, grad,
+                                        constant_op.constant(indices)).eval()
+
+      # The updates of repeated indices are applied in order.
+      for (i, index) in enumerate(indices):
+        y[index] += grad[i] * grad[i]
+        x[index] -= lr * grad[i] / np.sqrt(y[index])
+      self.assertAllClose(x, var.eval())
+      self.assertAllClose(y, accum.eval())
+
   def testSparseApplyFtrlDim1(self):
     for (dtype, index_type) in itertools.product(
         [np.float16, np.float32, np.float64], [np.int32, np.int64]):
@@ -286,6 +308,66 @@ class TrainingOpsTest(TensorFlowTestCase):
       self.assertShapeEqual(out, apply_adam)
       self.assertAllCloseAccordingToType(new_var, out)
 
+  def testMultiApplyAdam(self):
+    for dtype in [np.float16, np.float32, np.float64]:
+      # Tensors of different sizes, one of them large enough to be split
+      # across threads.
+      shapes = [[3], [100, 300], [1], [7, 5]]
+      values = [
+          np.linspace(0, 10, np.prod(shape)).reshape(shape) for shape in shapes
+      ]
+      var = [x.astype(dtype) for x in values]
+      m = [(0.2 * x + 1).astype(dtype) for x in values]
+      v = [(0.3 * x + 2).astype(dtype) for x in values]
+      grad = [(0.4 * x - 3).astype(dtype) for x in values]
+      beta1 = np.array(0.9, dtype=dtype)
+      beta2 = np.array(0.999, dtype=dtype)
+      lr = np.array(0.001, dtype=dtype)
+      epsilon = np.array(1e-8, dtype=dtype)
+      with self.test_session(use_gpu=False):
+        var_t = [resource_variable_ops.ResourceVariable(x) for x in var]
+        m_t = [resource_variable_ops.ResourceVariable(x) for x in m]
+        v_t = [resource_variable_ops.ResourceVariable(x) for x in v]
+        variables.global_variables_initializer().run()
+        training_ops.resource_multi_apply_adam(
+            [x.handle for x in var_t], [x.handle for x in m_t],
+            [x.handle for x in v_t], beta1, beta2, lr, beta1, beta2, epsilon,
+            grad).run()
+        for i in range(len(shapes)):
+          new_var, new_m, new_v = self._adamUpdateNumpy(
+              var[i], grad[i], 1, m[i], v[i], lr, beta1, beta2, epsilon)
+          self.assertAllCloseAccordingToType(new_var, var_t[i].eval())
+          self.assertAllCloseAccordingToType(new_m, m_t[i].eval())
+          self.assertAllCloseAccordingToType(new_v, v_t[i].eval())
+
+  def testMultiApplyMomentum(self):
+    for dtype, use_nesterov in itertools.product(
+        [np.float16, np.float32, np.float64], [False, True]):
+      shapes = [[100, 300], [4], [2, 3]]
+      values = [
+          np.linspace(0, 10, np.prod(shape)).reshape(shape) for shape in shapes
+      ]
+      var = [x.astype(dtype) for x in values]
+      accum = [(0.2 * x + 1).astype(dtype) for x in values]
+      grad = [(0.3 * x - 2).astype(dtype) for x in values]
+      lr = np.array(0.1, dtype=dtype)
+      momentum = np.array(0.9, dtype=dtype)
+      with self.test_session(use_gpu=False):
+        var_t = [resource_variable_ops.ResourceVariable(x) for x in var]
+        accum_t = [resource_variable_ops.ResourceVariable(x) for x in accum]
+        variables.global_variables_initializer().run()
+        training_ops.resource_multi_apply_momentum(
+            [x.handle for x in var_t], [x.handle for x in accum_t], lr, grad,
+            momentum, use_nesterov=use_nesterov).run()
+        for i in range(len(shapes)):
+          new_accum = accum[i] * momentum + grad[i]
+          if use_nesterov:
+            new_var = var[i] - (grad[i] * lr + new_accum * momentum * lr)
+          else:
+            new_var = var[i] - new_accum * lr
+          self.assertAllCloseAccordingToType(new_accum, accum_t[i].eval())
+          self.assertAllCloseAccordingToType(new_var, var_t[i].eval())
+
   def _adamUpdateNumpy(self, param, g_t, t, m, v, alpha, beta1, beta2, epsilon):
     alpha_t = alpha * np.sqrt(1 - beta2**t) / (1 - beta1**t)
 
@@ -407,6 +407,8 @@ port::Status CudnnSupport::Init() {
                                    ToString(status))};
 }
 
+int64 CudnnSupport::GetVersion() { return ::cudnnGetVersion(); }
+
 // Turns a BatchDescriptor structure into a cudnn tensor handle within a scope.
 class ScopedTensorDescriptor {
  public:
@@ -892,6 +894,20 @@ cudnnRNNMode_t ToCudnnRnnMode(dnn::RnnMode rnn_mode) {
   }
 }
 
+#if CUDNN_VERSION >= 6000
+cudnnRNNAlgo_t ToCudnnRnnAlgo(dnn::RnnAlgorithm rnn_algorithm) {
+  switch (rnn_algorithm) {
+    case dnn::RnnAlgorithm::kRnnAlgoStandard:
+      return CUDNN_RNN_ALGO_STANDARD;
+    case dnn::RnnAlgorithm::kRnnAlgoPersistStatic:
+      return CUDNN_RNN_ALGO_PERSIST_STATIC;
+    default:
+      LOG(FATAL) << "Invalid RNN algorithm: "
+                 << static_cast<int>(rnn_algorithm);
+  }
+}
+#endif  // CUDNN_VERSION >= 6000
+
 int CudnnDataTypeToByteSize(cudnnDataType_t data_type) {
   switch (data_type) {
     case CUDNN_DATA_FLOAT:
@@ -1035,8 +1051,8 @@ class CudnnRnnDescriptor : public CudnnDescriptorCommon<dnn::RnnDescriptor> {
                      int num_layers, int hidden_size, int input_size,
                      cudnnRNNInputMode_t input_mode,
                      cudnnDirectionMode_t direction_mode,
-                     cudnnRNNMode_t rnn_mode, cudnnDataType_t data_type,
-                     float dropout, uint64 seed,
+                     cudnnRNNMode_t rnn_mode, dnn::RnnAlgorithm rnn_algorithm,
+                     cudnnDataType_t data_type, float dropout, uint64 seed,
                      ScratchAllocator* state_allocator)
       : parent_(parent),
         rnn_desc_(nullptr),
@@ -1059,14 +1075,20 @@ class CudnnRnnDescriptor : public CudnnDescriptorCommon<dnn::RnnDescriptor> {
     cudnnStatus_t status = wrap::cudnnCreateRNNDescriptor(parent_, &rnn_desc_);
     CUDNN_RETURN_IF_FAIL(status, "Unable to create RNN descriptor");
 #if CUDNN_VERSION >= 6000
-    // TODO: allow the user to choose an algorithm.
-    cudnnRNNAlgo_t rnn_algo = CUDNN_RNN_ALGO_STANDARD;
+    cudnnRNNAlgo_t rnn_algo = ToCudnnRnnAlgo(rnn_algorithm);
     status = wrap::cudnnSetRNNDescriptor_v6(
         parent, cudnn_handle, rnn_desc_ /*rnnDesc*/, hidden_size /*hiddenSize*/,
         num_layers /*numLayers*/, dropout_handle() /*dropoutDesc*/,
         input_mode /*inputMode*/, direction_mode /*direction*/,
         rnn_mode /*mode*/, rnn_algo /*algo*/, data_type /*dataType*/);
 #else
+    if (rnn_algorithm != dnn::RnnAlgorithm::kRnnAlgoStandard) {
+      SetFailure(port::Status(
+          port::error::UNIMPLEMENTED,
+          port::StrCat("Persistent RNN kernels need at least Cudnn 6.0. ",
+                       "Current Cudnn version: ", CUDNN_VERSION, ". ")));
+      return;
+    }
     status = wrap::cudnnSetRNNDescriptor(
         parent, rnn_desc_ /*rnnDesc*/, hidden_size /*hiddenSize*/,
         num_layers /*numLayers*/, dropout_handle() /*dropoutDesc*/,
@@ -1712,6 +1734,7 @@ CudnnSupport::createRnnDescriptor(int num_layers, int hidden_size,
                                   int input_size, dnn::RnnInputMode input_mode,
                                   dnn::RnnDirectionMode direction_mode,
                                   dnn::RnnMode rnn_mode,
+                                  dnn::RnnAlgorithm rnn_algorithm,
                                   dnn::DataType data_type, float dropout,
                                   uint64 seed,
                                   ScratchAllocator* state_allocator) {
@@ -1720,8 +1743,8 @@ CudnnSupport::createRnnDescriptor(int num_layers, int hidden_size,
   std::unique_ptr<CudnnRnnDescriptor> rnn_desc(new CudnnRnnDescriptor(
       parent_, ToHandle(dnn_handle_), num_layers, hidden_size, input_size,
       ToCudnnRnnInputMode(input_mode), ToCudnnRnnDirectionMode(direction_mode),
-      ToCudnnRnnMode(rnn_mode), ToCudnnDataType(data_type), dropout, seed,
-      state_allocator));
+      ToCudnnRnnMode(rnn_mode), rnn_algorithm, ToCudnnDataType(data_type),
+      dropout, seed, state_allocator));
   if (!rnn_desc->ok()) {
     return rnn_desc->Status();
   }
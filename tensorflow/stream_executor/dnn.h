@@ -136,6 +136,14 @@ enum class RnnDirectionMode {
   kRnnBidirectional = 1,
 };
 
+// Specifies the algorithm used by the kernels of a RNN model. The persistent
+// kernels keep the recurrent weights on chip across the time steps, which is
+// faster for small batches, but support fewer models and need Cudnn 6.0.
+enum class RnnAlgorithm {
+  kRnnAlgoStandard = 0,
+  kRnnAlgoPersistStatic = 1,
+};
+
 // Relevant to DepthToSpace and SpaceToDepth. This is the write layout when
 // performing depth to space and the read layout when performing space to depth.
 // It's specified with most-major dimension first and most-minor dimension last.
@@ -885,6 +893,10 @@ class DnnSupport {
 
   virtual port::Status Init() = 0;
 
+  // Returns the version of the loaded DNN library, e.g. 6021 for cuDNN 6.0.21,
+  // or 0 if it is unknown.
+  virtual int64 GetVersion() { return 0; }
+
   // Performs a single-precision forward batch normalization operation onto
   // the stream.
   //
@@ -1962,6 +1974,7 @@ class DnnSupport {
   //  direction_mode: an enum to specify whether this model is unidirectional or
   //    bidirectional.
   //  rnn_mode: an enum to specify the type of model to build.
+  //  rnn_algorithm: an enum to specify the algorithm of the kernels.
   //  data_type: an enum to specify the data types used in this model.
   //  dropout: the dropout threshold between layers. When it is 0., no dropout
   //    is added.
@@ -1973,8 +1986,8 @@ class DnnSupport {
   createRnnDescriptor(int num_layers, int hidden_size, int input_size,
                       dnn::RnnInputMode input_mode,
                       dnn::RnnDirectionMode direction_mode,
-                      dnn::RnnMode rnn_mode, dnn::DataType data_type,
-                      float dropout, uint64 seed,
+                      dnn::RnnMode rnn_mode, dnn::RnnAlgorithm rnn_algorithm,
+                      dnn::DataType data_type, float dropout, uint64 seed,
                       ScratchAllocator* state_allocator) {
     return port::Status{port::error::UNIMPLEMENTED,
                         "createRnnDescriptor is unimplemented"};
@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "tensorflow/tools/benchmark/benchmark_model.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <memory>
 #include <string>
@@ -38,6 +39,7 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/init_main.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/platform.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session.h"
@@ -343,6 +345,170 @@ Status TimeMultipleRuns(double sleep_seconds, int num_runs, double max_time_s,
   return Status::OK();
 }
 
+Status TimeConcurrentRuns(int num_clients, double target_qps, int num_runs,
+                          double max_time_s,
+                          const std::vector<InputLayerInfo>& inputs,
+                          const std::vector<string>& outputs, Session* session,
+                          StatSummarizer* stats, ConcurrentRunStats* result) {
+  LOG(INFO) << "Running benchmark for max " << num_runs << " iterations, max "
+            << max_time_s << " seconds "
+            << (stats != nullptr ? "with" : "without")
+            << " detailed stat logging, from " << num_clients << " clients "
+            << (target_qps > 0.0 ? strings::StrCat("at ", target_qps, " qps")
+                                 : string("back to back"));
+
+  // The inputs are only read, so every client can feed the same tensors.
+  std::vector<std::pair<string, tensorflow::Tensor> > input_tensors;
+  CreateTensorsFromInputInfo(inputs, &input_tensors);
+
+  RunOptions run_options;
+  if (stats != nullptr) {
+    run_options.set_trace_level(RunOptions::FULL_TRACE);
+  }
+
+  Env* env = Env::Default();
+  const int64 start_us = env->NowMicros();
+  const int64 end_us = max_time_s > 0.0
+                           ? start_us + static_cast<int64>(max_time_s * 1e6)
+                           : kint64max;
+
+  mutex mu;
+  int64 num_issued = 0;  // Guarded by mu.
+  Status status;         // Guarded by mu.
+  auto client = [&]() {
+    std::vector<int64> latencies_us;
+    while (true) {
+      int64 scheduled_us;
+      {
+        mutex_lock l(mu);
+        if (!status.ok() || (num_runs > 0 && num_issued >= num_runs)) break;
+        scheduled_us = target_qps > 0.0
+                           ? start_us + static_cast<int64>(num_issued * 1e6 /
+                                                           target_qps)
+                           : env->NowMicros();
+        if (scheduled_us >= end_us || env->NowMicros() >= end_us) break;
+        ++num_issued;
+      }
+      const int64 now_us = env->NowMicros();
+      if (scheduled_us > now_us) {
+        env->SleepForMicroseconds(scheduled_us - now_us);
+      }
+
+      std::vector<tensorflow::Tensor> output_tensors;
+      RunMetadata run_metadata;
+      Status s = session->Run(run_options, input_tensors, outputs, {},
+                              &output_tensors, &run_metadata);
+      latencies_us.push_back(env->NowMicros() - scheduled_us);
+
+      mutex_lock l(mu);
+      if (!s.ok()) {
+        LOG(ERROR) << "Error during inference: " << s;
+        status.Update(s);
+        break;
+      }
+      // StatSummarizer is not thread-safe.
+      if (stats != nullptr) {
+        stats->ProcessStepStats(run_metadata.step_stats());
+      }
+    }
+    mutex_lock l(mu);
+    for (int64 latency_us : latencies_us) {
+      result->latency_us.Add(latency_us);
+    }
+    result->num_runs += latencies_us.size();
+  };
+
+  {
+    std::vector<std::unique_ptr<Thread> > threads;
+    for (int i = 0; i < num_clients; ++i) {
+      threads.emplace_back(env->StartThread(
+          ThreadOptions(), strings::StrCat("benchmark_client_", i), client));
+    }
+    // Destroying the threads waits for the clients to finish.
+  }
+  result->wall_time_us = env->NowMicros() - start_us;
+  return status;
+}
+
+void LogConcurrentRunStats(const string& label,
+                           const ConcurrentRunStats& run_stats) {
+  const histogram::Histogram& latency = run_stats.latency_us;
+  LOG(INFO) << label << ": " << run_stats.num_runs << " runs in "
+            << run_stats.wall_time_us / 1000000.0 << "s, "
+            << run_stats.throughput_qps() << " qps, latency in us: "
+            << "p50=" << latency.Percentile(50.0) << " "
+            << "p90=" << latency.Percentile(90.0) << " "
+            << "p99=" << latency.Percentile(99.0) << " "
+            << "p999=" << latency.Percentile(99.9);
+  LOG(INFO) << label << " latency histogram (us):\n" << latency.ToString();
+}
+
+// Benchmarks the model under concurrent load: warm-up runs and steady-state
+// runs are timed separately, and then a traced pass fills in the per-op
+// stats. Returns the exit code for Main.
+int RunConcurrentBenchmarks(int num_clients, double target_qps,
+                            int warmup_runs, int max_num_runs,
+                            double max_time_s, double inter_benchmark_sleep_s,
+                            const std::vector<InputLayerInfo>& inputs,
+                            const std::vector<string>& outputs,
+                            Session* session, StatSummarizer* stats,
+                            bool show_sizes, const string& benchmark_name,
+                            const string& output_prefix) {
+  if (warmup_runs > 0) {
+    ConcurrentRunStats warmup;
+    Status warmup_status =
+        TimeConcurrentRuns(num_clients, target_qps, warmup_runs, -1.0, inputs,
+                           outputs, session, nullptr, &warmup);
+    if (!warmup_status.ok()) {
+      LOG(ERROR) << "Timing failed with " << warmup_status;
+      return -1;
+    }
+    LogConcurrentRunStats("Warm-up", warmup);
+  }
+
+  SleepSeconds(inter_benchmark_sleep_s);
+  ConcurrentRunStats steady;
+  Status steady_status =
+      TimeConcurrentRuns(num_clients, target_qps, max_num_runs, max_time_s,
+                         inputs, outputs, session, nullptr, &steady);
+  if (!steady_status.ok()) {
+    LOG(ERROR) << "Timing failed with " << steady_status;
+    return -1;
+  }
+  LogConcurrentRunStats("Steady state", steady);
+
+  SleepSeconds(inter_benchmark_sleep_s);
+  ConcurrentRunStats traced;
+  Status traced_status =
+      TimeConcurrentRuns(num_clients, target_qps, max_num_runs, max_time_s,
+                         inputs, outputs, session, stats, &traced);
+  if (!traced_status.ok()) {
+    LOG(ERROR) << "Timing failed with " << traced_status;
+    return -1;
+  }
+  LogConcurrentRunStats("With stats", traced);
+
+  stats->PrintStepStats();
+  if (show_sizes) {
+    stats->PrintOutputs();
+  }
+
+  if (!benchmark_name.empty() && !output_prefix.empty()) {
+    RecordBenchmarkEntry(output_prefix, benchmark_name, "concurrent",
+                         steady.num_runs, steady.wall_time_us / 1000000.0,
+                         steady.throughput_qps());
+    const std::pair<const char*, double> percentiles[] = {
+        {"p50", 50.0}, {"p90", 90.0}, {"p99", 99.0}, {"p999", 99.9}};
+    for (const auto& percentile : percentiles) {
+      RecordBenchmarkEntry(
+          output_prefix, benchmark_name,
+          strings::StrCat("meta-latency-", percentile.first), 1,
+          steady.latency_us.Percentile(percentile.second) / 1000000.0);
+    }
+  }
+  return 0;
+}
+
 int Main(int argc, char** argv) {
   string graph = "/data/local/tmp/tensorflow_inception_graph.pb";
   string input_layer_string = "input:0";
@@ -368,6 +534,8 @@ int Main(int argc, char** argv) {
   bool show_summary = true;
   bool show_flops = false;
   int warmup_runs = 1;
+  int num_clients = 1;
+  string target_qps = "-1.0";
 
   std::vector<Flag> flag_list = {
       Flag("graph", &graph, "graph file name"),
@@ -401,6 +569,10 @@ int Main(int argc, char** argv) {
            "whether to show a summary of the stats"),
       Flag("show_flops", &show_flops, "whether to estimate the model's FLOPs"),
       Flag("warmup_runs", &warmup_runs, "how many runs to initialize model"),
+      Flag("num_clients", &num_clients,
+           "number of threads issuing runs at the same time"),
+      Flag("target_qps", &target_qps,
+           "if positive, issue runs open-loop at this rate across all clients"),
   };
   string usage = Flags::Usage(argv[0], flag_list);
   const bool parse_result = Flags::Parse(&argc, argv, flag_list);
@@ -454,6 +626,8 @@ int Main(int argc, char** argv) {
   LOG(INFO) << "Output prefix: [" << output_prefix << "]";
   LOG(INFO) << "Show sizes: [" << show_sizes << "]";
   LOG(INFO) << "Warmup runs: [" << warmup_runs << "]";
+  LOG(INFO) << "Num clients: [" << num_clients << "]";
+  LOG(INFO) << "Target qps: [" << target_qps << "]";
 
   std::unique_ptr<Session> session;
   std::unique_ptr<StatSummarizer> stats;
@@ -515,6 +689,16 @@ int Main(int argc, char** argv) {
     inputs.push_back(input);
   }
 
+  const double target_runs_per_second =
+      std::strtod(target_qps.c_str(), nullptr);
+  if (num_clients > 1 || target_runs_per_second > 0.0) {
+    return RunConcurrentBenchmarks(
+        std::max(num_clients, 1), target_runs_per_second, warmup_runs,
+        max_num_runs, max_benchmark_time_seconds,
+        inter_benchmark_sleep_seconds, inputs, output_layers, session.get(),
+        stats.get(), show_sizes, benchmark_name, output_prefix);
+  }
+
   // If requested, run through the graph first to preinitialize everything
   // before the benchmarking runs.
   int64 warmup_time_us = 0;
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_TOOLS_BENCHMARK_BENCHMARK_MODEL_H_
 #define TENSORFLOW_TOOLS_BENCHMARK_BENCHMARK_MODEL_H_
 
+#include "tensorflow/core/lib/histogram/histogram.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/util/stat_summarizer.h"
 
@@ -47,6 +48,32 @@ Status TimeMultipleRuns(double sleep_seconds, int num_runs, double max_time_s,
                         StatSummarizer* stats, int64* total_time_us,
                         int64* actual_num_runs);
 
+// Latency and throughput of a set of runs issued by several clients at once.
+struct ConcurrentRunStats {
+  int64 num_runs = 0;
+  int64 wall_time_us = 0;
+  // Per-run latencies in microseconds. In open-loop mode these are measured
+  // from when the run was scheduled to start, so that a backed-up session is
+  // charged for the time runs spent waiting.
+  histogram::Histogram latency_us;
+
+  double throughput_qps() const {
+    return wall_time_us > 0 ? num_runs * 1000000.0 / wall_time_us : 0.0;
+  }
+};
+
+// Runs the model from num_clients threads at once, until num_runs runs have
+// been issued or max_time_s has passed, whichever is first (<= 0 disables
+// either limit). If target_qps is positive, runs are issued open-loop at that
+// rate and shared among the clients; otherwise each client starts its next
+// run as soon as its last one finishes. If stats is non-null, the step stats
+// of every run are added to it.
+Status TimeConcurrentRuns(int num_clients, double target_qps, int num_runs,
+                          double max_time_s,
+                          const std::vector<InputLayerInfo>& inputs,
+                          const std::vector<string>& outputs, Session* session,
+                          StatSummarizer* stats, ConcurrentRunStats* result);
+
 // Handles all setup and argument parsing.
 int Main(int argc, char** argv);
 
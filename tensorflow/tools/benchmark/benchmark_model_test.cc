@@ -26,16 +26,14 @@ limitations under the License.
 namespace tensorflow {
 namespace {
 
-TEST(BenchmarkModelTest, InitializeAndRun) {
-  const string dir = testing::TmpDir();
-  const string filename_pb = io::JoinPath(dir, "graphdef.pb");
-
-  // Create a simple graph and write it to filename_pb.
+// Creates a simple graph and writes it to filename_pb.
+void CreateTestGraph(const string& filename_pb,
+                     benchmark_model::InputLayerInfo* input,
+                     string* output_name) {
   const int input_width = 400;
   const int input_height = 10;
-  benchmark_model::InputLayerInfo input;
-  input.shape = TensorShape({input_width, input_height});
-  input.data_type = DT_FLOAT;
+  input->shape = TensorShape({input_width, input_height});
+  input->data_type = DT_FLOAT;
   const TensorShape constant_shape({input_height, input_width});
 
   Tensor constant_tensor(DT_FLOAT, constant_shape);
@@ -43,10 +41,10 @@ TEST(BenchmarkModelTest, InitializeAndRun) {
 
   auto root = Scope::NewRootScope().ExitOnError();
   auto placeholder =
-      ops::Placeholder(root, DT_FLOAT, ops::Placeholder::Shape(input.shape));
-  input.name = placeholder.node()->name();
+      ops::Placeholder(root, DT_FLOAT, ops::Placeholder::Shape(input->shape));
+  input->name = placeholder.node()->name();
   auto m = ops::MatMul(root, placeholder, constant_tensor);
-  const string output_name = m.node()->name();
+  *output_name = m.node()->name();
 
   GraphDef graph_def;
   TF_ASSERT_OK(root.ToGraphDef(&graph_def));
@@ -54,6 +52,14 @@ TEST(BenchmarkModelTest, InitializeAndRun) {
   graph_def.SerializeToString(&graph_def_serialized);
   TF_ASSERT_OK(
       WriteStringToFile(Env::Default(), filename_pb, graph_def_serialized));
+}
+
+TEST(BenchmarkModelTest, InitializeAndRun) {
+  const string dir = testing::TmpDir();
+  const string filename_pb = io::JoinPath(dir, "graphdef.pb");
+  benchmark_model::InputLayerInfo input;
+  string output_name;
+  CreateTestGraph(filename_pb, &input, &output_name);
 
   std::unique_ptr<Session> session;
   std::unique_ptr<GraphDef> loaded_graph_def;
@@ -69,5 +75,39 @@ TEST(BenchmarkModelTest, InitializeAndRun) {
   ASSERT_EQ(num_runs, 10);
 }
 
+TEST(BenchmarkModelTest, ConcurrentRuns) {
+  const string dir = testing::TmpDir();
+  const string filename_pb = io::JoinPath(dir, "graphdef_concurrent.pb");
+  benchmark_model::InputLayerInfo input;
+  string output_name;
+  CreateTestGraph(filename_pb, &input, &output_name);
+
+  std::unique_ptr<Session> session;
+  std::unique_ptr<GraphDef> loaded_graph_def;
+  TF_ASSERT_OK(benchmark_model::InitializeSession(1, filename_pb, &session,
+                                                  &loaded_graph_def));
+  std::unique_ptr<StatSummarizer> stats;
+  stats.reset(new tensorflow::StatSummarizer(*(loaded_graph_def.get())));
+
+  // Closed loop: the clients share the run budget.
+  benchmark_model::ConcurrentRunStats closed_loop;
+  TF_ASSERT_OK(benchmark_model::TimeConcurrentRuns(
+      4, -1.0, 20, 0.0, {input}, {output_name}, session.get(), stats.get(),
+      &closed_loop));
+  EXPECT_EQ(20, closed_loop.num_runs);
+  EXPECT_GT(closed_loop.wall_time_us, 0);
+  EXPECT_GT(closed_loop.throughput_qps(), 0.0);
+  EXPECT_GE(closed_loop.latency_us.Percentile(99.0),
+            closed_loop.latency_us.Percentile(50.0));
+
+  // Open loop: 10 runs at 100 qps are spread over at least 90ms.
+  benchmark_model::ConcurrentRunStats open_loop;
+  TF_ASSERT_OK(benchmark_model::TimeConcurrentRuns(
+      2, 100.0, 10, 0.0, {input}, {output_name}, session.get(), nullptr,
+      &open_loop));
+  EXPECT_EQ(10, open_loop.num_runs);
+  EXPECT_GE(open_loop.wall_time_us, 90000);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -30,7 +30,9 @@ limitations under the License.
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/graph/subgraph.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/init_main.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/util/command_line_flags.h"
@@ -283,6 +285,19 @@ Status FoldConstants(const GraphDef& input_graph_def,
     };
   }
 
+  // Evaluate the independent constant subgraphs on several threads.
+  int32 num_threads;
+  TF_RETURN_IF_ERROR(context.GetOneInt32Parameter(
+      "num_threads", port::NumSchedulableCPUs(), &num_threads));
+  std::unique_ptr<thread::ThreadPool> pool;
+  if (num_threads > 1) {
+    pool.reset(
+        new thread::ThreadPool(Env::Default(), "fold_constants", num_threads));
+    cf_opts.runner = [&pool](std::function<void()> closure) {
+      pool->Schedule(std::move(closure));
+    };
+  }
+
   // Constant folding.
   bool was_mutated;
   TF_RETURN_IF_ERROR(ConstantFold(cf_opts, nullptr, Env::Default(), nullptr,
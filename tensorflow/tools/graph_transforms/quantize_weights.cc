@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/graph/subgraph.h"
 #include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/init_main.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/util/command_line_flags.h"
@@ -38,6 +39,11 @@ Status QuantizeWeights(const GraphDef& input_graph_def,
   int32 minimum_size;
   TF_RETURN_IF_ERROR(
       context.GetOneInt32Parameter("minimum_size", 1024, &minimum_size));
+  // Each large constant is quantized on its own, so spread them over threads.
+  ReplaceMatchingOpTypesOptions options;
+  options.allow_inconsistencies = false;
+  TF_RETURN_IF_ERROR(context.GetOneInt32Parameter(
+      "num_threads", port::NumSchedulableCPUs(), &options.num_threads));
   TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
       input_graph_def, {"Const"},
       [minimum_size](const NodeMatch& match,
@@ -136,7 +142,7 @@ Status QuantizeWeights(const GraphDef& input_graph_def,
 
         return Status::OK();
       },
-      {}, output_graph_def));
+      options, output_graph_def));
 
   return Status::OK();
 }
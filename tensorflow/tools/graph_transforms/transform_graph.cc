@@ -278,16 +278,18 @@ Status TransformGraph(const std::vector<string>& inputs,
       if (ignore_errors) {
         LOG(ERROR) << transform_name << ": Ignoring error "
                    << transform_result.error_message();
-        transformed_graph_def = *graph_def;
+        // Leave the graph as it was before this transform.
+        TF_RETURN_IF_ERROR(IsGraphValid(*graph_def));
+        continue;
       } else {
         return transform_result;
       }
     }
-    // Copy over the library from the original input graph.
-    *transformed_graph_def.mutable_library() = graph_def->library();
     TF_RETURN_IF_ERROR(IsGraphValid(transformed_graph_def));
-
-    *graph_def = transformed_graph_def;
+    // Move over the library from the original input graph. Large graphs are
+    // moved rather than copied from one transform to the next.
+    transformed_graph_def.mutable_library()->Swap(graph_def->mutable_library());
+    graph_def->Swap(&transformed_graph_def);
   }
   return Status::OK();
 }
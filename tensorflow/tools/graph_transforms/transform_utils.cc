@@ -17,8 +17,11 @@ limitations under the License.
 
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
 namespace graph_transforms {
@@ -352,6 +355,79 @@ bool GraphMatcher::DoesOpTypeMatch(
   return true;
 }
 
+namespace {
+// Calls the generator function for a single match, and returns the nodes that
+// replace it in *new_nodes.
+Status GenerateMatchReplacement(
+    const NodeMatch& match,
+    const std::map<string, std::vector<const NodeDef*>>& outputs_map,
+    const std::function<Status(const NodeMatch&, const std::set<string>&,
+                               const std::set<string>&, std::vector<NodeDef>*)>&
+        node_generator,
+    const ReplaceMatchingOpTypesOptions& options,
+    std::vector<NodeDef>* new_nodes) {
+  std::vector<NodeDef> matched_nodes_array;
+  MatchedNodesAsArray(match, &matched_nodes_array);
+  // This tells us whether a node is part of the current match.
+  std::set<string> matched_nodes_lookup;
+  for (const NodeDef& matched_node : matched_nodes_array) {
+    matched_nodes_lookup.insert(matched_node.name());
+  }
+  // These are helper arrays that the replacement function can use to tell
+  // whether it can safely remove an internal node (because nothing outside
+  // of the match uses it) or whether external nodes depend on it.
+  std::set<string> input_nodes;
+  std::set<string> output_nodes;
+  for (const NodeDef& matched_node : matched_nodes_array) {
+    // Look through all of this node's inputs, and if any of them come from
+    // outside the match, then this should be noted as one of the external
+    // inputs of the subgraph.
+    for (const string& input_name : matched_node.input()) {
+      string input_node_name = NodeNameFromInput(input_name);
+      if (!matched_nodes_lookup.count(input_node_name)) {
+        input_nodes.insert(matched_node.name());
+      }
+    }
+    // Do a reverse input lookup, to see which other nodes use the current
+    // one as an input. If any of those nodes are outside the match
+    // subgraph, then the current node is marked as an output node that
+    // shouldn't be removed.
+    auto outputs = outputs_map.find(matched_node.name());
+    if (outputs != outputs_map.end()) {
+      for (const NodeDef* dependent_node : outputs->second) {
+        if (!matched_nodes_lookup.count(dependent_node->name())) {
+          output_nodes.insert(matched_node.name());
+        }
+      }
+    }
+  }
+  // Call the generator function to get the new nodes.
+  TF_RETURN_IF_ERROR(
+      node_generator(match, input_nodes, output_nodes, new_nodes));
+  std::set<string> new_node_names;
+  for (const NodeDef& new_node : *new_nodes) {
+    new_node_names.insert(new_node.name());
+  }
+  // Check to make sure the generator function preserved all of the nodes
+  // that are used elsewhere in the graph, and add them back in if not.
+  bool abort_replacement = false;
+  if (!options.allow_inconsistencies) {
+    for (const string& expected_output : output_nodes) {
+      if (!new_node_names.count(expected_output)) {
+        LOG(WARNING) << "Expected " << expected_output << " to be preserved.";
+        abort_replacement = true;
+      }
+    }
+  }
+  if (abort_replacement) {
+    LOG(WARNING) << "Generator function didn't preserve needed nodes, "
+                 << "copying old replacements back in instead.";
+    new_nodes->swap(matched_nodes_array);
+  }
+  return Status::OK();
+}
+}  // namespace
+
 Status ReplaceMatchingOpTypes(
     const GraphDef& input_graph_def, const OpTypePattern& pattern,
     const std::function<Status(const NodeMatch&, const std::set<string>&,
@@ -366,92 +442,56 @@ Status ReplaceMatchingOpTypes(
   // Do some housekeeping so we can easily look up the resulting matches given
   // a node name.
   std::set<string> matched_nodes;
-  std::map<string, const NodeMatch*> matches_by_head_name;
-  for (const NodeMatch& match : matches) {
-    matches_by_head_name[match.node.name()] = &match;
-    RecordMatchedNodes(match, &matched_nodes);
+  std::map<string, size_t> matches_by_head_name;
+  for (size_t i = 0; i < matches.size(); ++i) {
+    matches_by_head_name[matches[i].node.name()] = i;
+    RecordMatchedNodes(matches[i], &matched_nodes);
   }
   std::map<string, std::vector<const NodeDef*>> outputs_map;
   MapNodesToOutputs(input_graph_def, &outputs_map);
 
+  // Generate the replacements of all the matches up front. The matches don't
+  // overlap, so the calls into the generator function are independent and can
+  // run on several threads.
+  std::vector<std::vector<NodeDef>> replacements(matches.size());
+  std::vector<Status> statuses(matches.size());
+  const auto generate = [&](size_t i) {
+    statuses[i] = GenerateMatchReplacement(matches[i], outputs_map,
+                                           node_generator, options,
+                                           &replacements[i]);
+  };
+  if (options.num_threads > 1 && matches.size() > 1) {
+    thread::ThreadPool pool(Env::Default(), "replace_matching_op_types",
+                            options.num_threads);
+    BlockingCounter counter(matches.size());
+    for (size_t i = 0; i < matches.size(); ++i) {
+      pool.Schedule([&generate, &counter, i]() {
+        generate(i);
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  } else {
+    // Keep calling the generator function in graph order.
+    for (const NodeDef& input_node : input_graph_def.node()) {
+      auto match_index = matches_by_head_name.find(input_node.name());
+      if (match_index != matches_by_head_name.end()) {
+        generate(match_index->second);
+        TF_RETURN_IF_ERROR(statuses[match_index->second]);
+      }
+    }
+  }
+
   // Go through all the nodes in the input graph, see if they are part of a
   // match or if they can be left untouched.
   output_graph_def->Clear();
   for (const NodeDef& input_node : input_graph_def.node()) {
-    if (matches_by_head_name.count(input_node.name())) {
-      // This node is the beginning of a match, so call the replacement function
-      // after setting up some information it will need.
-      const NodeMatch* match = matches_by_head_name[input_node.name()];
-      std::vector<NodeDef> matched_nodes_array;
-      MatchedNodesAsArray(*match, &matched_nodes_array);
-      // This tells us whether a node is part of the current match.
-      std::set<string> matched_nodes_lookup;
-      for (const NodeDef& matched_node : matched_nodes_array) {
-        matched_nodes_lookup.insert(matched_node.name());
-      }
-      // These are helper arrays that the replacement function can use to tell
-      // whether it can safely remove an internal node (because nothing outside
-      // of the match uses it) or whether external nodes depend on it.
-      std::set<string> input_nodes;
-      std::set<string> output_nodes;
-      for (const NodeDef& matched_node : matched_nodes_array) {
-        // Look through all of this node's inputs, and if any of them come from
-        // outside the match, then this should be noted as one of the external
-        // inputs of the subgraph.
-        for (const string& input_name : matched_node.input()) {
-          string input_node_name = NodeNameFromInput(input_name);
-          if (!matched_nodes_lookup.count(input_node_name)) {
-            input_nodes.insert(matched_node.name());
-          }
-        }
-        // Do a reverse input lookup, to see which other nodes use the current
-        // one as an input. If any of those nodes are outside the match
-        // subgraph, then the current node is marked as an output node that
-        // shouldn't be removed.
-        if (outputs_map.count(matched_node.name())) {
-          for (const NodeDef* dependent_node :
-               outputs_map[matched_node.name()]) {
-            if (!matched_nodes_lookup.count(dependent_node->name())) {
-              output_nodes.insert(matched_node.name());
-            }
-          }
-        }
-      }
-      // Call the generator function and add all the returned nodes to the
-      // graph.
-      std::vector<NodeDef> new_nodes;
-      TF_RETURN_IF_ERROR(
-          node_generator(*match, input_nodes, output_nodes, &new_nodes));
-      std::set<string> new_node_names;
-      for (const NodeDef& new_node : new_nodes) {
-        new_node_names.insert(new_node.name());
-      }
-      // Check to make sure the generator function preserved all of the nodes
-      // that are used elsewhere in the graph, and add them back in if not.
-      bool abort_replacement = false;
-      if (!options.allow_inconsistencies) {
-        for (const string& expected_output : output_nodes) {
-          if (!new_node_names.count(expected_output)) {
-            LOG(WARNING) << "Expected " << expected_output
-                         << " to be preserved.";
-            abort_replacement = true;
-          }
-        }
-      }
-      if (abort_replacement) {
-        LOG(WARNING) << "Generator function didn't preserve needed nodes, "
-                     << "copying old replacements back in instead.";
-        std::vector<NodeDef> old_nodes;
-        MatchedNodesAsArray(*match, &old_nodes);
-        for (const NodeDef& old_node : old_nodes) {
-          NodeDef* added_node = output_graph_def->mutable_node()->Add();
-          *added_node = old_node;
-        }
-      } else {
-        for (const NodeDef& new_node : new_nodes) {
-          NodeDef* added_node = output_graph_def->mutable_node()->Add();
-          *added_node = new_node;
-        }
+    auto match_index = matches_by_head_name.find(input_node.name());
+    if (match_index != matches_by_head_name.end()) {
+      // This node is the beginning of a match, so add its replacement.
+      TF_RETURN_IF_ERROR(statuses[match_index->second]);
+      for (NodeDef& new_node : replacements[match_index->second]) {
+        output_graph_def->mutable_node()->Add()->Swap(&new_node);
       }
     } else if (!matched_nodes.count(input_node.name())) {
       // This node isn't part of any match, so just copy it over.
@@ -183,6 +183,10 @@ struct ReplaceMatchingOpTypesOptions {
   // Whether to raise an error if the graph is left with dangling inputs. If you
   // enable this option, you must fix inconsistencies in a later pass.
   bool allow_inconsistencies;
+  // If greater than one, the generator function is called for this many matches
+  // at a time, on separate threads. It must then be safe to call concurrently.
+  // The resulting graph is the same as with a single thread.
+  int num_threads;
 };
 
 // Replaces all of the matching sub-graphs with new ops. This calls into the
@@ -195,6 +199,8 @@ struct ReplaceMatchingOpTypesOptions {
 // by setting allow_inconsistencies to true in the options, but then it's the
 // caller's responsibility to patch up any problems before passing on the graph
 // to others. There's more comprehensive usage documentation in the README.
+// The generator function is called for every match before the resulting graph
+// is assembled, and the first error it returns, in graph order, is returned.
 Status ReplaceMatchingOpTypes(
     const GraphDef& input_graph_def, const OpTypePattern& pattern,
     const std::function<Status(const NodeMatch&, const std::set<string>&,
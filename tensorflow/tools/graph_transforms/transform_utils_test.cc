@@ -488,6 +488,65 @@ class TransformUtilsTest : public ::testing::Test {
     }
   }
 
+  void TestReplaceMatchingOpTypesMultiThreaded() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    std::vector<Input> consts;
+    for (int i = 0; i < 20; ++i) {
+      Tensor data(DT_FLOAT, TensorShape({4}));
+      test::FillIota<float>(&data, i);
+      consts.push_back(Const(root.WithOpName(strings::StrCat("const_", i)),
+                             Input::Initializer(data)));
+    }
+    Output add_n = AddN(root.WithOpName("output"), InputList(consts));
+
+    GraphDef graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&graph_def));
+
+    const auto add_identity = [](const NodeMatch& match,
+                                 const std::set<string>& input_nodes,
+                                 const std::set<string>& output_nodes,
+                                 std::vector<NodeDef>* new_nodes) {
+      NodeDef original_copy = match.node;
+      original_copy.set_name(match.node.name() + "_before_identity");
+      new_nodes->push_back(original_copy);
+      NodeDef identity_node;
+      identity_node.set_op("Identity");
+      identity_node.set_name(match.node.name());
+      AddNodeInput(original_copy.name(), &identity_node);
+      new_nodes->push_back(identity_node);
+      return Status::OK();
+    };
+
+    GraphDef serial_graph_def;
+    TF_ASSERT_OK(ReplaceMatchingOpTypes(graph_def, {"Const"}, add_identity,
+                                        {false, 1}, &serial_graph_def));
+    GraphDef threaded_graph_def;
+    TF_ASSERT_OK(ReplaceMatchingOpTypes(graph_def, {"Const"}, add_identity,
+                                        {false, 4}, &threaded_graph_def));
+    EXPECT_EQ(41, threaded_graph_def.node_size());
+    EXPECT_EQ(serial_graph_def.DebugString(), threaded_graph_def.DebugString());
+
+    // Errors of the generator function are returned as with a single thread.
+    const auto fail_on_one = [&add_identity](
+                                 const NodeMatch& match,
+                                 const std::set<string>& input_nodes,
+                                 const std::set<string>& output_nodes,
+                                 std::vector<NodeDef>* new_nodes) {
+      if (match.node.name() == "const_13") {
+        return errors::InvalidArgument("Failing at ", match.node.name());
+      }
+      return add_identity(match, input_nodes, output_nodes, new_nodes);
+    };
+    const Status serial_status = ReplaceMatchingOpTypes(
+        graph_def, {"Const"}, fail_on_one, {false, 1}, &serial_graph_def);
+    const Status threaded_status = ReplaceMatchingOpTypes(
+        graph_def, {"Const"}, fail_on_one, {false, 4}, &threaded_graph_def);
+    EXPECT_EQ(error::INVALID_ARGUMENT, threaded_status.code());
+    EXPECT_EQ(serial_status, threaded_status);
+  }
+
   void TestMatchedNodesAsArray() {
     NodeMatch fourth;
     fourth.node.set_name("fourth");
@@ -1106,6 +1165,10 @@ TEST_F(TransformUtilsTest, TestReplaceMatchingOpTypes) {
   TestReplaceMatchingOpTypes();
 }
 
+TEST_F(TransformUtilsTest, TestReplaceMatchingOpTypesMultiThreaded) {
+  TestReplaceMatchingOpTypesMultiThreaded();
+}
+
 TEST_F(TransformUtilsTest, TestMatchedNodesAsArray) {
   TestMatchedNodesAsArray();
 }